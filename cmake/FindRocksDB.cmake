@@ -0,0 +1,20 @@
+# Find RocksDB
+
+find_path(
+	ROCKSDB_INCLUDE_DIR
+	NAMES rocksdb/db.h
+    DOC "RocksDB include directory"
+)
+
+find_library(
+	ROCKSDB_LIBRARY
+	NAMES rocksdb
+    DOC "RocksDB library"
+)
+
+set(ROCKSDB_INCLUDE_DIRS ${ROCKSDB_INCLUDE_DIR})
+set(ROCKSDB_LIBRARIES ${ROCKSDB_LIBRARY})
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(rocksdb DEFAULT_MSG
+	ROCKSDB_LIBRARY ROCKSDB_INCLUDE_DIR)
@@ -20,7 +20,7 @@ set(CMAKE_ARGS -DCMAKE_INSTALL_PREFIX=<INSTALL_DIR>
                -DBUILD_STATIC_LIBS=On
                -DBUILD_SHARED_LIBS=Off
                -DUNIX_DOMAIN_SOCKET_SERVER=Off
-               -DUNIX_DOMAIN_SOCKET_CLIENT=Off
+               -DUNIX_DOMAIN_SOCKET_CLIENT=On
                -DHTTP_SERVER=On
                -DHTTP_CLIENT=On
                -DCOMPILE_TESTS=Off
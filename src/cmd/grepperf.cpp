@@ -19,6 +19,7 @@
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <sstream>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -142,20 +143,140 @@ void printResult(const std::string& strFileName) {
   fs.close();
 }
 
+/// Totals of one message name as dumped by MessageStats
+struct MessageStatsRow {
+  uint64_t countIn = 0;
+  uint64_t bytesIn = 0;
+  uint64_t countOut = 0;
+  uint64_t bytesOut = 0;
+  uint64_t processed = 0;
+  uint64_t queueWaitUs = 0;
+  uint64_t handlerUs = 0;
+  std::vector<uint64_t> queueWaitHist;
+  std::vector<uint64_t> handlerHist;
+};
+
+static std::map<std::string, MessageStatsRow> resultMessageStats;
+
+std::vector<uint64_t> parseHistogram(const std::string& strHist) {
+  std::vector<uint64_t> hist;
+  std::istringstream ss(strHist);
+  std::string strBucket;
+  while (std::getline(ss, strBucket, ';')) {
+    hist.push_back(std::stoull(strBucket));
+  }
+  return hist;
+}
+
+/// Upper bound in us of the bucket holding the given percentile
+uint64_t histogramPercentile(const std::vector<uint64_t>& hist,
+                             unsigned int percentile) {
+  uint64_t total = 0;
+  for (const auto& count : hist) {
+    total += count;
+  }
+  if (total == 0) {
+    return 0;
+  }
+
+  uint64_t seen = 0;
+  for (unsigned int i = 0; i < hist.size(); i++) {
+    seen += hist[i];
+    if (seen * 100 >= total * percentile) {
+      return (uint64_t)1 << i;
+    }
+  }
+  return (uint64_t)1 << (hist.size() - 1);
+}
+
+bool readStatsFile(const std::string& strFileName) {
+  std::ifstream fs(strFileName, std::ifstream::in);
+  if (!fs.is_open()) {
+    std::cout << "Failed to open file " + strFileName;
+    return false;
+  }
+
+  // timestamp,name,type,instruction,count_in,bytes_in,count_out,bytes_out,
+  // processed,queue_wait_us,handler_us,queue_wait_hist,handler_hist
+  const unsigned int NUM_COLUMNS = 13;
+
+  std::string strLine;
+  while (std::getline(fs, strLine, '\n')) {
+    std::vector<std::string> columns;
+    std::istringstream ss(strLine);
+    std::string strColumn;
+    while (std::getline(ss, strColumn, ',')) {
+      columns.push_back(strColumn);
+    }
+
+    if (columns.size() != NUM_COLUMNS || columns[0] == "timestamp") {
+      continue;
+    }
+
+    try {
+      // Counters are cumulative, so the last row of a message is its total
+      MessageStatsRow& row = resultMessageStats[columns[1]];
+      row.countIn = std::stoull(columns[4]);
+      row.bytesIn = std::stoull(columns[5]);
+      row.countOut = std::stoull(columns[6]);
+      row.bytesOut = std::stoull(columns[7]);
+      row.processed = std::stoull(columns[8]);
+      row.queueWaitUs = std::stoull(columns[9]);
+      row.handlerUs = std::stoull(columns[10]);
+      row.queueWaitHist = parseHistogram(columns[11]);
+      row.handlerHist = parseHistogram(columns[12]);
+    } catch (const std::exception&) {
+      std::cout << "Skipping malformed line: " << strLine << std::endl;
+    }
+  }
+
+  fs.close();
+  return true;
+}
+
+void printStatsResult(const std::string& strFileName) {
+  std::ofstream fs(strFileName, std::ofstream::out);
+  if (!fs.is_open()) {
+    std::cout << "Failed to open file " + strFileName;
+    return;
+  }
+
+  fs << "Message Name\tCount In\tAvg Size In\tCount Out\tAvg Size Out\t"
+        "Avg Wait(us)\tP99 Wait(us)\tAvg Process Time(us)\t"
+        "P50 Process Time(us)\tP99 Process Time(us)"
+     << std::endl;
+  for (const auto& entry : resultMessageStats) {
+    const MessageStatsRow& row = entry.second;
+    fs << entry.first << "\t" << row.countIn << "\t"
+       << (row.countIn > 0 ? row.bytesIn / row.countIn : 0) << "\t"
+       << row.countOut << "\t"
+       << (row.countOut > 0 ? row.bytesOut / row.countOut : 0) << "\t"
+       << (row.processed > 0 ? row.queueWaitUs / row.processed : 0) << "\t"
+       << histogramPercentile(row.queueWaitHist, 99) << "\t"
+       << (row.processed > 0 ? row.handlerUs / row.processed : 0) << "\t"
+       << histogramPercentile(row.handlerHist, 50) << "\t"
+       << histogramPercentile(row.handlerHist, 99) << std::endl;
+  }
+  fs.close();
+}
+
 using namespace std;
 
 int main(int argc, const char* argv[]) {
   try {
     std::string strFileName;
+    std::string strStatsFileName;
     std::string strResultName;
 
     po::options_description desc("Options");
 
     desc.add_options()("help,h", "Print help messages")(
-        "l,log-file-name", po::value<string>(&strFileName)->required(),
-        "zilliqa log file name")("r,result-file-name",
-                                 po::value<string>(&strResultName)->required(),
-                                 "grep result file name");
+        "l,log-file-name", po::value<string>(&strFileName),
+        "zilliqa log file name")(
+        "s,stats-file-name", po::value<string>(&strStatsFileName),
+        "message stats file dumped when ENABLE_MESSAGE_STATS is set")(
+        "r,result-file-name", po::value<string>(&strResultName)->required(),
+        "grep result file name");
 
     po::variables_map vm;
     try {
@@ -169,6 +290,16 @@ int main(int argc, const char* argv[]) {
         return SUCCESS;
       }
       po::notify(vm);
+
+      if (strFileName.empty() == strStatsFileName.empty()) {
+        SWInfo::LogBrandBugReport();
+        cerr << "ERROR: exactly one of --log-file-name and --stats-file-name "
+                "is required"
+             << endl
+             << endl;
+        cout << desc;
+        return ERROR_IN_COMMAND_LINE;
+      }
     } catch (boost::program_options::required_option& e) {
       SWInfo::LogBrandBugReport();
       cerr << "ERROR: " << e.what() << endl << endl;
@@ -180,7 +311,13 @@ int main(int argc, const char* argv[]) {
       return ERROR_IN_COMMAND_LINE;
     }
 
-    if (grepFile(strFileName)) {
+    if (!strStatsFileName.empty()) {
+      if (readStatsFile(strStatsFileName)) {
+        printStatsResult(strResultName);
+        std::cout << "Message stats result successfully write into "
+                  << strResultName << std::endl;
+      }
+    } else if (grepFile(strFileName)) {
       printResult(strResultName);
       std::cout << "Grep performance result successfully write into "
                 << strResultName << std::endl;
@@ -0,0 +1,645 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Open-loop load generator: submits signed transactions to the JSON-RPC
+// servers of the lookups at a fixed target rate, whether or not the earlier
+// ones have been answered, and polls for each to be confirmed. Latencies are
+// counted from the time a transaction was due to be sent, so a saturated
+// network shows up as growing latency rather than as a lower send rate.
+//
+// The transactions are signed before the run starts, from the genesis keys
+// of constants.xml or the private keys in --keys, one hex key per line. Each
+// second is printed as a CSV line; the totals go to stderr at the end.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "jsonrpccpp/client.h"
+#include "jsonrpccpp/client/connectors/httpclient.h"
+
+#include "libCrypto/Schnorr.h"
+#include "libData/AccountData/Account.h"
+#include "libData/AccountData/Transaction.h"
+#include "libServer/AddressChecksum.h"
+#include "libUtils/DataConversion.h"
+#include "libUtils/Logger.h"
+#include "libUtils/SWInfo.h"
+
+using namespace std;
+namespace po = boost::program_options;
+
+#define SUCCESS 0
+#define ERROR_IN_COMMAND_LINE -1
+#define ERROR_UNHANDLED_EXCEPTION -2
+#define ERROR_UNEXPECTED -3
+
+namespace {
+
+using Clock = chrono::steady_clock;
+
+enum class NoncePattern {
+  SEQUENTIAL,  // each sender sends its nonces in order
+  SWAP,        // every other pair of nonces is sent in reverse order
+  DUPLICATE    // every --every txn is sent again with the same nonce
+};
+
+struct LoadConfig {
+  vector<string> m_urls{"http://127.0.0.1:4201"};
+  double m_rate = 100;
+  unsigned int m_duration = 60;
+  unsigned int m_senders = 0;
+  string m_keyFile;
+  double m_contractRatio = 0;
+  string m_contractAddr;
+  string m_contractData;
+  uint64_t m_contractGas = 10000;
+  NoncePattern m_noncePattern = NoncePattern::SEQUENTIAL;
+  unsigned int m_every = 100;
+  unsigned int m_threads = 16;
+  unsigned int m_pollMs = 1000;
+  unsigned int m_timeout = 300;
+};
+
+/// One transaction of the schedule, and what became of it
+struct Submission {
+  Json::Value m_json;
+  string m_hash;
+  Clock::time_point m_due;
+  double m_submitMs = 0;
+  bool m_accepted = false;
+  bool m_confirmed = false;
+  bool m_timedOut = false;
+};
+
+/// Counts and latencies of what happened in one second of the run
+struct Second {
+  uint64_t m_sent = 0;
+  uint64_t m_accepted = 0;
+  uint64_t m_rejected = 0;
+  uint64_t m_confirmed = 0;
+  uint64_t m_timedOut = 0;
+  vector<double> m_submitMs;
+  vector<double> m_confirmMs;
+};
+
+double Percentile(vector<double>& values, double p) {
+  if (values.empty()) {
+    return 0;
+  }
+  const size_t rank = static_cast<size_t>(p * values.size());
+  const size_t index = min(values.size() - 1, rank);
+  nth_element(values.begin(), values.begin() + index, values.end());
+  return values[index];
+}
+
+double MillisBetween(const Clock::time_point& from,
+                     const Clock::time_point& to) {
+  return chrono::duration<double, milli>(to - from).count();
+}
+
+class LoadGenerator {
+  const LoadConfig& m_config;
+  vector<Submission> m_submissions;
+  Clock::time_point m_start;
+
+  mutex m_mutex;
+  vector<Second> m_seconds;
+  /// Accepted and not yet confirmed nor timed out, by index
+  deque<size_t> m_pending;
+  atomic<bool> m_sending{true};
+
+  condition_variable m_queueCv;
+  deque<size_t> m_queue;
+
+  Second& SecondOf(const Clock::time_point& t) {
+    const size_t second =
+        max<int64_t>(chrono::duration_cast<chrono::seconds>(t - m_start)
+                         .count(),
+                     0);
+    if (second >= m_seconds.size()) {
+      m_seconds.resize(second + 1);
+    }
+    return m_seconds[second];
+  }
+
+  /// Round-robin over the lookups
+  static jsonrpc::HttpClient& GetConnector(
+      vector<unique_ptr<jsonrpc::HttpClient>>& connectors, size_t index) {
+    return *connectors[index % connectors.size()];
+  }
+
+  void Submit(vector<unique_ptr<jsonrpc::HttpClient>>& connectors,
+              size_t index) {
+    Submission& submission = m_submissions[index];
+    Json::Value params = Json::arrayValue;
+    params.append(submission.m_json);
+
+    bool accepted = false;
+    try {
+      jsonrpc::Client client(GetConnector(connectors, index));
+      const Json::Value ret = client.CallMethod("CreateTransaction", params);
+      accepted = ret.isMember("TranID");
+    } catch (const exception& e) {
+      LOG_GENERAL(INFO, "CreateTransaction failed: " << e.what());
+    }
+
+    const auto now = Clock::now();
+    lock_guard<mutex> g(m_mutex);
+    submission.m_submitMs = MillisBetween(submission.m_due, now);
+    submission.m_accepted = accepted;
+    Second& second = SecondOf(now);
+    second.m_sent++;
+    second.m_submitMs.emplace_back(submission.m_submitMs);
+    if (accepted) {
+      second.m_accepted++;
+      m_pending.emplace_back(index);
+    } else {
+      second.m_rejected++;
+    }
+  }
+
+  void SubmitLoop() {
+    vector<unique_ptr<jsonrpc::HttpClient>> connectors;
+    for (const auto& url : m_config.m_urls) {
+      connectors.emplace_back(make_unique<jsonrpc::HttpClient>(url));
+    }
+
+    while (true) {
+      size_t index;
+      {
+        unique_lock<mutex> g(m_mutex);
+        m_queueCv.wait(g, [this]() { return !m_queue.empty() || !m_sending; });
+        if (m_queue.empty()) {
+          return;
+        }
+        index = m_queue.front();
+        m_queue.pop_front();
+      }
+      Submit(connectors, index);
+    }
+  }
+
+  /// Releases each transaction at its due time, without waiting for the
+  /// earlier ones to be answered
+  void Dispatch() {
+    for (size_t i = 0; i < m_submissions.size(); i++) {
+      this_thread::sleep_until(m_submissions[i].m_due);
+      {
+        lock_guard<mutex> g(m_mutex);
+        m_queue.emplace_back(i);
+      }
+      m_queueCv.notify_one();
+    }
+
+    {
+      lock_guard<mutex> g(m_mutex);
+      m_sending = false;
+    }
+    m_queueCv.notify_all();
+  }
+
+  /// Checks each of indexes once, on numThreads threads
+  void Poll(const vector<size_t>& indexes) {
+    const unsigned int numThreads =
+        max(1u, min<unsigned int>(m_config.m_threads, indexes.size()));
+    vector<thread> pollers;
+    for (unsigned int t = 0; t < numThreads; t++) {
+      pollers.emplace_back([this, t, numThreads, &indexes]() {
+        vector<unique_ptr<jsonrpc::HttpClient>> connectors;
+        for (const auto& url : m_config.m_urls) {
+          connectors.emplace_back(make_unique<jsonrpc::HttpClient>(url));
+        }
+
+        for (size_t i = t; i < indexes.size(); i += numThreads) {
+          Submission& submission = m_submissions[indexes[i]];
+          Json::Value params = Json::arrayValue;
+          params.append(submission.m_hash);
+
+          bool confirmed = false;
+          try {
+            jsonrpc::Client client(GetConnector(connectors, indexes[i]));
+            const Json::Value ret = client.CallMethod("GetTransaction", params);
+            confirmed = ret.isMember("receipt");
+          } catch (const exception&) {
+            // Not yet in a final block
+          }
+
+          const auto now = Clock::now();
+          const double latencyMs = MillisBetween(submission.m_due, now);
+          lock_guard<mutex> g(m_mutex);
+          if (confirmed) {
+            submission.m_confirmed = true;
+            Second& second = SecondOf(now);
+            second.m_confirmed++;
+            second.m_confirmMs.emplace_back(latencyMs);
+          } else if (latencyMs > m_config.m_timeout * 1000.0) {
+            submission.m_timedOut = true;
+            SecondOf(now).m_timedOut++;
+          }
+        }
+      });
+    }
+    for (auto& poller : pollers) {
+      poller.join();
+    }
+  }
+
+  void PollLoop() {
+    while (true) {
+      this_thread::sleep_for(chrono::milliseconds(m_config.m_pollMs));
+
+      vector<size_t> indexes;
+      bool done;
+      {
+        lock_guard<mutex> g(m_mutex);
+        indexes.assign(m_pending.begin(), m_pending.end());
+        done = !m_sending && m_queue.empty();
+      }
+
+      Poll(indexes);
+
+      {
+        lock_guard<mutex> g(m_mutex);
+        m_pending.erase(remove_if(m_pending.begin(), m_pending.end(),
+                                  [this](size_t index) {
+                                    const auto& s = m_submissions[index];
+                                    return s.m_confirmed || s.m_timedOut;
+                                  }),
+                        m_pending.end());
+        PrintSeconds(false);
+        if (done && m_pending.empty()) {
+          return;
+        }
+      }
+    }
+  }
+
+  size_t m_printed = 0;
+
+  /// Prints the seconds that can no longer change, or all of them at the end
+  void PrintSeconds(bool all) {
+    const size_t current = static_cast<size_t>(
+        chrono::duration_cast<chrono::seconds>(Clock::now() - m_start)
+            .count());
+    for (; m_printed < m_seconds.size() && (all || m_printed < current);
+         m_printed++) {
+      Second& second = m_seconds[m_printed];
+      cout << m_printed << "," << second.m_sent << "," << second.m_accepted
+           << "," << second.m_rejected << "," << second.m_confirmed << ","
+           << second.m_timedOut << "," << m_pending.size() << "," << fixed
+           << setprecision(1) << Percentile(second.m_submitMs, 0.5) << ","
+           << Percentile(second.m_submitMs, 0.99) << ","
+           << Percentile(second.m_confirmMs, 0.5) << ","
+           << Percentile(second.m_confirmMs, 0.99) << endl;
+    }
+  }
+
+ public:
+  explicit LoadGenerator(const LoadConfig& config) : m_config(config) {}
+
+  bool Prepare(const vector<PairOfKey>& senders);
+
+  void Run() {
+    m_start = Clock::now() + chrono::seconds(1);
+    for (size_t i = 0; i < m_submissions.size(); i++) {
+      m_submissions[i].m_due =
+          m_start + chrono::duration_cast<Clock::duration>(
+                        chrono::duration<double>(i / m_config.m_rate));
+    }
+
+    cout << "second,sent,accepted,rejected,confirmed,timed_out,pending,"
+            "submit_p50_ms,submit_p99_ms,confirm_p50_ms,confirm_p99_ms"
+         << endl;
+
+    vector<thread> submitters;
+    for (unsigned int i = 0; i < m_config.m_threads; i++) {
+      submitters.emplace_back([this]() { SubmitLoop(); });
+    }
+    thread dispatcher([this]() { Dispatch(); });
+
+    PollLoop();
+
+    dispatcher.join();
+    for (auto& submitter : submitters) {
+      submitter.join();
+    }
+
+    lock_guard<mutex> g(m_mutex);
+    PrintSeconds(true);
+    PrintSummary();
+  }
+
+  void PrintSummary() {
+    uint64_t accepted = 0, confirmed = 0, timedOut = 0;
+    vector<double> submitMs, confirmMs;
+    for (const auto& submission : m_submissions) {
+      submitMs.emplace_back(submission.m_submitMs);
+      if (submission.m_accepted) {
+        accepted++;
+      }
+      if (submission.m_confirmed) {
+        confirmed++;
+      }
+      if (submission.m_timedOut) {
+        timedOut++;
+      }
+    }
+    for (auto& second : m_seconds) {
+      confirmMs.insert(confirmMs.end(), second.m_confirmMs.begin(),
+                       second.m_confirmMs.end());
+    }
+
+    cerr << fixed << setprecision(1) << "Sent " << m_submissions.size()
+         << " txns at " << m_config.m_rate << "/s: " << accepted
+         << " accepted, " << confirmed << " confirmed, " << timedOut
+         << " timed out; submit p50 " << Percentile(submitMs, 0.5)
+         << " ms p99 " << Percentile(submitMs, 0.99) << " ms; confirm p50 "
+         << Percentile(confirmMs, 0.5) << " ms p90 "
+         << Percentile(confirmMs, 0.9) << " ms p99 "
+         << Percentile(confirmMs, 0.99) << " ms max "
+         << Percentile(confirmMs, 1.0) << " ms" << endl;
+  }
+};
+
+/// The nonce of the account as the lookup knows it
+bool GetNonce(const string& url, const Address& address, uint64_t& nonce) {
+  try {
+    jsonrpc::HttpClient connector(url);
+    jsonrpc::Client client(connector);
+    Json::Value params = Json::arrayValue;
+    params.append(address.hex());
+    const Json::Value ret = client.CallMethod("GetBalance", params);
+    nonce = ret["nonce"].asUInt64();
+    return true;
+  } catch (const exception& e) {
+    cerr << "GetBalance of " << address.hex() << " failed: " << e.what()
+         << endl;
+    return false;
+  }
+}
+
+Json::Value ToJson(const Transaction& txn) {
+  Json::Value json;
+  string pubKey, signature;
+  DataConversion::SerializableToHexStr(txn.GetSenderPubKey(), pubKey);
+  DataConversion::SerializableToHexStr(txn.GetSignature(), signature);
+
+  json["version"] = txn.GetVersion();
+  json["nonce"] = static_cast<Json::UInt64>(txn.GetNonce());
+  json["toAddr"] = AddressChecksum::GetCheckSumedAddress(txn.GetToAddr().hex());
+  json["amount"] = txn.GetAmount().str();
+  json["pubKey"] = pubKey;
+  json["gasPrice"] = txn.GetGasPrice().str();
+  json["gasLimit"] = to_string(txn.GetGasLimit());
+  json["code"] = DataConversion::CharArrayToString(txn.GetCode());
+  json["data"] = DataConversion::CharArrayToString(txn.GetData());
+  json["signature"] = signature;
+  return json;
+}
+
+bool LoadGenerator::Prepare(const vector<PairOfKey>& senders) {
+  vector<uint64_t> nonces(senders.size());
+  for (size_t i = 0; i < senders.size(); i++) {
+    const Address address =
+        Account::GetAddressFromPublicKey(senders[i].second);
+    if (!GetNonce(m_config.m_urls.front(), address, nonces[i])) {
+      return false;
+    }
+  }
+
+  Address contractAddr;
+  if (m_config.m_contractRatio > 0) {
+    bytes addrBytes;
+    if (!DataConversion::HexStrToUint8Vec(m_config.m_contractAddr,
+                                          addrBytes) ||
+        addrBytes.size() != ACC_ADDR_SIZE) {
+      cerr << "Invalid contract address " << m_config.m_contractAddr << endl;
+      return false;
+    }
+    contractAddr = Address(addrBytes);
+  }
+  const bytes contractData(m_config.m_contractData.begin(),
+                           m_config.m_contractData.end());
+
+  // Which sender, nonce and kind each transaction has, decided up front so
+  // that the signing can be spread over threads
+  struct Plan {
+    size_t m_sender;
+    uint64_t m_nonce;
+    bool m_contract;
+  };
+  const size_t total =
+      static_cast<size_t>(m_config.m_rate * m_config.m_duration);
+  vector<Plan> plans;
+  plans.reserve(total);
+  double contracts = 0;
+  vector<uint64_t> sent(senders.size(), 0);
+  while (plans.size() < total) {
+    const size_t sender = plans.size() % senders.size();
+    const uint64_t count = sent[sender]++;
+    uint64_t nonce = nonces[sender] + count + 1;
+
+    if (m_config.m_noncePattern == NoncePattern::SWAP && count % 4 >= 2) {
+      nonce += (count % 4 == 2) ? 1 : -1;
+    }
+
+    contracts += m_config.m_contractRatio;
+    const bool contract = contracts >= 1;
+    if (contract) {
+      contracts -= 1;
+    }
+    plans.push_back({sender, nonce, contract});
+
+    if (m_config.m_noncePattern == NoncePattern::DUPLICATE &&
+        count % m_config.m_every == m_config.m_every - 1 &&
+        plans.size() < total) {
+      plans.push_back({sender, nonce, contract});
+    }
+  }
+
+  m_submissions.resize(plans.size());
+  const unsigned int numThreads = max(thread::hardware_concurrency(), 1u);
+  vector<thread> signers;
+  for (unsigned int t = 0; t < numThreads; t++) {
+    signers.emplace_back([&, t]() {
+      for (size_t i = t; i < plans.size(); i += numThreads) {
+        const Plan& plan = plans[i];
+        // A different recipient and amount each, so that a duplicated nonce
+        // is a different txn
+        const Address toAddr = plan.m_contract
+                                   ? contractAddr
+                                   : Address(static_cast<unsigned int>(i + 1));
+        Transaction txn(
+            DataConversion::Pack(CHAIN_ID, 1), plan.m_nonce, toAddr,
+            senders[plan.m_sender], plan.m_contract ? 0 : i + 1,
+            GAS_PRICE_MIN_VALUE,
+            plan.m_contract ? m_config.m_contractGas : NORMAL_TRAN_GAS, {},
+            plan.m_contract ? contractData : bytes());
+        m_submissions[i].m_json = ToJson(txn);
+        m_submissions[i].m_hash = txn.GetTranID().hex();
+      }
+    });
+  }
+  for (auto& signer : signers) {
+    signer.join();
+  }
+
+  return true;
+}
+
+bool LoadKeys(const LoadConfig& config, vector<PairOfKey>& senders) {
+  vector<string> privKeys;
+  if (config.m_keyFile.empty()) {
+    privKeys = GENESIS_KEYS;
+  } else {
+    ifstream keyFile(config.m_keyFile);
+    if (!keyFile) {
+      cerr << "Cannot open " << config.m_keyFile << endl;
+      return false;
+    }
+    string line;
+    while (getline(keyFile, line)) {
+      if (!line.empty()) {
+        privKeys.emplace_back(line);
+      }
+    }
+  }
+
+  for (const auto& privKeyStr : privKeys) {
+    if (config.m_senders > 0 && senders.size() >= config.m_senders) {
+      break;
+    }
+    bytes privKeyBytes;
+    if (!DataConversion::HexStrToUint8Vec(privKeyStr, privKeyBytes)) {
+      cerr << "Invalid private key " << privKeyStr << endl;
+      return false;
+    }
+    PrivKey privKey(privKeyBytes, 0);
+    senders.emplace_back(privKey, PubKey(privKey));
+  }
+
+  if (senders.empty()) {
+    cerr << "No sender keys" << endl;
+    return false;
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  try {
+    LoadConfig config;
+    string noncePattern = "sequential";
+
+    po::options_description desc("Options");
+    desc.add_options()("help,h", "Print help messages")(
+        "url,u", po::value<vector<string>>(&config.m_urls)->multitoken(),
+        "JSON-RPC URLs of the lookups, used in turn")(
+        "rate,r", po::value<double>(&config.m_rate),
+        "Transactions per second")(
+        "duration,d", po::value<unsigned int>(&config.m_duration),
+        "Seconds to send for")(
+        "senders,s", po::value<unsigned int>(&config.m_senders),
+        "Sender accounts to use (default all the keys)")(
+        "keys,k", po::value<string>(&config.m_keyFile),
+        "File of sender private keys (default GENESIS_KEYS)")(
+        "contract-ratio", po::value<double>(&config.m_contractRatio),
+        "Fraction of the transactions that call --contract")(
+        "contract", po::value<string>(&config.m_contractAddr),
+        "Address of the contract to call")(
+        "contract-data", po::value<string>(&config.m_contractData),
+        "Message JSON of the contract calls")(
+        "contract-gas", po::value<uint64_t>(&config.m_contractGas),
+        "Gas limit of the contract calls")(
+        "nonces,n", po::value<string>(&noncePattern),
+        "Nonce pattern: sequential, swap or duplicate")(
+        "every,e", po::value<unsigned int>(&config.m_every),
+        "Send every this many txns again with the duplicate pattern")(
+        "threads,t", po::value<unsigned int>(&config.m_threads),
+        "Connections to submit and poll on")(
+        "poll,p", po::value<unsigned int>(&config.m_pollMs),
+        "Milliseconds between polls for confirmations")(
+        "timeout", po::value<unsigned int>(&config.m_timeout),
+        "Seconds after which an unconfirmed txn is given up on");
+
+    po::variables_map vm;
+    try {
+      po::store(po::parse_command_line(argc, argv, desc), vm);
+      if (vm.count("help")) {
+        SWInfo::LogBrandBugReport();
+        cout << desc << endl;
+        return SUCCESS;
+      }
+      po::notify(vm);
+    } catch (boost::program_options::error& e) {
+      SWInfo::LogBrandBugReport();
+      cerr << "ERROR: " << e.what() << endl << endl;
+      return ERROR_IN_COMMAND_LINE;
+    }
+
+    if (noncePattern == "sequential") {
+      config.m_noncePattern = NoncePattern::SEQUENTIAL;
+    } else if (noncePattern == "swap") {
+      config.m_noncePattern = NoncePattern::SWAP;
+    } else if (noncePattern == "duplicate") {
+      config.m_noncePattern = NoncePattern::DUPLICATE;
+    } else {
+      cerr << "ERROR: unknown nonce pattern " << noncePattern << endl;
+      return ERROR_IN_COMMAND_LINE;
+    }
+
+    if (config.m_rate <= 0 || config.m_urls.empty() ||
+        config.m_threads == 0 || config.m_every == 0 ||
+        config.m_contractRatio < 0 || config.m_contractRatio > 1 ||
+        (config.m_contractRatio > 0 && config.m_contractAddr.empty())) {
+      cerr << "ERROR: invalid options" << endl << endl << desc << endl;
+      return ERROR_IN_COMMAND_LINE;
+    }
+
+    INIT_FILE_LOGGER("loadgen");
+
+    vector<PairOfKey> senders;
+    if (!LoadKeys(config, senders)) {
+      return ERROR_UNEXPECTED;
+    }
+
+    LoadGenerator generator(config);
+    if (!generator.Prepare(senders)) {
+      return ERROR_UNEXPECTED;
+    }
+    generator.Run();
+  } catch (std::exception& e) {
+    std::cerr << "Unhandled Exception reached the top of main: " << e.what()
+              << ", application will now exit" << std::endl;
+    return ERROR_UNHANDLED_EXCEPTION;
+  }
+
+  return SUCCESS;
+}
@@ -0,0 +1,312 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Replays a range of Tx epochs from the persistence directory of a node,
+// offline: the transactions of each microblock are run again through the
+// account store, and the state root reached is checked against that of the
+// Tx block. Prints the time spent loading, executing and committing each
+// epoch as CSV lines, then a summary.
+//
+// Run it where the node ran, so that constants.xml and its persistence
+// directory are found. Nothing is written to the databases. The account state
+// starts from the root of the Tx block before the range, which must still be
+// in the state database; contract states are only kept for the persisted
+// head, so contract transactions are exact only when the range starts right
+// after it, e.g. on a copy of the blocks onto an older snapshot.
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "libData/AccountData/AccountStore.h"
+#include "libPersistence/BlockStorage.h"
+#include "libUtils/Logger.h"
+#include "libUtils/SWInfo.h"
+
+using namespace std;
+namespace po = boost::program_options;
+
+#define SUCCESS 0
+#define ERROR_IN_COMMAND_LINE -1
+#define ERROR_UNHANDLED_EXCEPTION -2
+#define ERROR_UNEXPECTED -3
+
+namespace {
+
+struct EpochResult {
+  unsigned int m_microBlocks = 0;
+  uint64_t m_txns = 0;
+  uint64_t m_receiptMismatches = 0;
+  double m_loadMs = 0;
+  double m_executeMs = 0;
+  double m_commitMs = 0;
+  bool m_rootMatches = false;
+};
+
+using Clock = chrono::steady_clock;
+
+double MillisSince(const Clock::time_point& start) {
+  return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+/// As Mediator::GetIsVacuousEpoch, where only the rewards are applied
+bool IsVacuousEpoch(uint64_t epochNum) {
+  return ((epochNum + NUM_VACUOUS_EPOCHS) % NUM_FINAL_BLOCK_PER_POW) == 0;
+}
+
+struct MicroBlockTxns {
+  uint32_t m_shardId;
+  vector<Transaction> m_txns;
+  vector<bool> m_succeeded;
+};
+
+bool LoadEpoch(const TxBlock& txBlock, vector<MicroBlockTxns>& microBlocks) {
+  BlockStorage& storage = BlockStorage::GetBlockStorage();
+
+  for (const auto& info : txBlock.GetMicroBlockInfos()) {
+    MicroBlockSharedPtr microBlock;
+    if (!storage.GetMicroBlock(info.m_microBlockHash, microBlock)) {
+      cerr << "Microblock " << info.m_microBlockHash << " not found" << endl;
+      return false;
+    }
+
+    microBlocks.emplace_back();
+    MicroBlockTxns& txns = microBlocks.back();
+    txns.m_shardId = info.m_shardId;
+    for (const auto& txnHash : microBlock->GetTranHashes()) {
+      TxBodySharedPtr body;
+      if (!storage.GetTxBody(txnHash, body)) {
+        cerr << "Transaction " << txnHash << " not found" << endl;
+        return false;
+      }
+      txns.m_txns.emplace_back(body->GetTransaction());
+      txns.m_succeeded.emplace_back(
+          body->GetTransactionReceipt().GetJsonValue()["success"].asBool());
+    }
+  }
+
+  return true;
+}
+
+bool ReplayEpoch(uint64_t epochNum, unsigned int numThreads,
+                 EpochResult& result) {
+  AccountStore& accountStore = AccountStore::GetInstance();
+
+  auto start = Clock::now();
+  TxBlockSharedPtr txBlock;
+  if (!BlockStorage::GetBlockStorage().GetTxBlock(epochNum, txBlock)) {
+    cerr << "Tx block " << epochNum << " not found" << endl;
+    return false;
+  }
+
+  vector<MicroBlockTxns> microBlocks;
+  bytes stateDelta;
+  if (IsVacuousEpoch(epochNum)) {
+    // The rewards are not transactions, take them from the stored delta
+    if (!BlockStorage::GetBlockStorage().GetStateDelta(epochNum,
+                                                       stateDelta)) {
+      cerr << "State delta of vacuous epoch " << epochNum << " not found"
+           << endl;
+      return false;
+    }
+  } else if (!LoadEpoch(*txBlock, microBlocks)) {
+    return false;
+  }
+  result.m_loadMs = MillisSince(start);
+
+  // The DS microblock comes last, with the number of shards as its id
+  uint32_t numShards = 0;
+  for (const auto& microBlock : microBlocks) {
+    numShards = max(numShards, microBlock.m_shardId);
+  }
+
+  start = Clock::now();
+  accountStore.InitTemp();
+  for (const auto& microBlock : microBlocks) {
+    const bool isDS = microBlock.m_shardId == numShards;
+    vector<TransactionReceipt> receipts;
+    vector<bool> results;
+    if (numThreads > 1) {
+      accountStore.UpdateAccountsTempBatch(epochNum, numShards, isDS,
+                                           microBlock.m_txns, receipts,
+                                           results, numThreads);
+    } else {
+      receipts.resize(microBlock.m_txns.size());
+      for (size_t i = 0; i < microBlock.m_txns.size(); i++) {
+        results.emplace_back(accountStore.UpdateAccountsTemp(
+            epochNum, numShards, isDS, microBlock.m_txns[i], receipts[i]));
+      }
+    }
+
+    for (size_t i = 0; i < results.size(); i++) {
+      if (results[i] != microBlock.m_succeeded[i]) {
+        result.m_receiptMismatches++;
+      }
+    }
+    result.m_microBlocks++;
+    result.m_txns += microBlock.m_txns.size();
+  }
+  result.m_executeMs = MillisSince(start);
+
+  start = Clock::now();
+  if (stateDelta.empty()) {
+    if (!accountStore.SerializeDelta()) {
+      cerr << "SerializeDelta failed at epoch " << epochNum << endl;
+      return false;
+    }
+    accountStore.CommitTemp();
+  } else if (!accountStore.DeserializeDelta(stateDelta, 0)) {
+    cerr << "DeserializeDelta failed at epoch " << epochNum << endl;
+    return false;
+  }
+  result.m_rootMatches = accountStore.GetStateRootHash() ==
+                         txBlock->GetHeader().GetStateRootHash();
+  result.m_commitMs = MillisSince(start);
+
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  try {
+    uint64_t from = 0, to = 0;
+    unsigned int numThreads = 1;
+    bool stopOnMismatch = false;
+
+    po::options_description desc("Options");
+    desc.add_options()("help,h", "Print help messages")(
+        "from,f", po::value<uint64_t>(&from)->required(),
+        "First Tx epoch to replay")(
+        "to,t", po::value<uint64_t>(&to),
+        "Last Tx epoch to replay (default to --from)")(
+        "threads,n", po::value<unsigned int>(&numThreads),
+        "Threads to execute the transactions of a microblock on (default 1)")(
+        "stop-on-mismatch,s", po::bool_switch(&stopOnMismatch),
+        "Stop at the first epoch whose state root differs");
+
+    po::variables_map vm;
+    try {
+      po::store(po::parse_command_line(argc, argv, desc), vm);
+      if (vm.count("help")) {
+        SWInfo::LogBrandBugReport();
+        cout << desc << endl;
+        return SUCCESS;
+      }
+      po::notify(vm);
+    } catch (boost::program_options::required_option& e) {
+      SWInfo::LogBrandBugReport();
+      cerr << "ERROR: " << e.what() << endl << endl;
+      cout << desc;
+      return ERROR_IN_COMMAND_LINE;
+    } catch (boost::program_options::error& e) {
+      SWInfo::LogBrandBugReport();
+      cerr << "ERROR: " << e.what() << endl << endl;
+      return ERROR_IN_COMMAND_LINE;
+    }
+
+    if (!vm.count("to")) {
+      to = from;
+    }
+    if (from == 0 || to < from) {
+      cerr << "ERROR: the range must start after the genesis epoch and "
+              "not end before it starts"
+           << endl;
+      return ERROR_IN_COMMAND_LINE;
+    }
+
+    INIT_FILE_LOGGER("replayepochs");
+
+    TxBlockSharedPtr baseBlock;
+    if (!BlockStorage::GetBlockStorage().GetTxBlock(from - 1, baseBlock)) {
+      cerr << "Tx block " << from - 1 << " not found" << endl;
+      return ERROR_UNEXPECTED;
+    }
+
+    AccountStore& accountStore = AccountStore::GetInstance();
+    bytes headRoot;
+    BlockStorage::GetBlockStorage().GetStateRoot(headRoot);
+    const StateHash& baseRoot = baseBlock->GetHeader().GetStateRootHash();
+    if (StateHash(headRoot) != baseRoot) {
+      cerr << "The state is rolled back from the persisted head, contract "
+              "states are those of the head"
+           << endl;
+    }
+    if (!accountStore.RetrieveFromDisk(baseRoot)) {
+      cerr << "The state of epoch " << from - 1
+           << " is no longer in the state database" << endl;
+      return ERROR_UNEXPECTED;
+    }
+
+    cout << "epoch,microblocks,txns,load_ms,execute_ms,commit_ms,"
+            "receipt_mismatches,root_matches"
+         << endl;
+
+    EpochResult total;
+    uint64_t epochs = 0, rootMismatches = 0;
+    for (uint64_t epochNum = from; epochNum <= to; epochNum++) {
+      EpochResult result;
+      if (!ReplayEpoch(epochNum, numThreads, result)) {
+        return ERROR_UNEXPECTED;
+      }
+
+      cout << epochNum << "," << result.m_microBlocks << "," << result.m_txns
+           << fixed << setprecision(3) << "," << result.m_loadMs << ","
+           << result.m_executeMs << "," << result.m_commitMs << ","
+           << result.m_receiptMismatches << ","
+           << (result.m_rootMatches ? "true" : "false") << endl;
+
+      epochs++;
+      total.m_microBlocks += result.m_microBlocks;
+      total.m_txns += result.m_txns;
+      total.m_receiptMismatches += result.m_receiptMismatches;
+      total.m_loadMs += result.m_loadMs;
+      total.m_executeMs += result.m_executeMs;
+      total.m_commitMs += result.m_commitMs;
+      if (!result.m_rootMatches) {
+        rootMismatches++;
+        if (stopOnMismatch) {
+          break;
+        }
+      }
+    }
+
+    const double totalMs =
+        total.m_loadMs + total.m_executeMs + total.m_commitMs;
+    cerr << fixed << setprecision(1) << "Replayed " << epochs << " epochs, "
+         << total.m_txns << " txns in " << totalMs << " ms: "
+         << (total.m_executeMs > 0 ? total.m_txns * 1e3 / total.m_executeMs
+                                   : 0)
+         << " txns/s executed, " << (totalMs > 0 ? epochs * 1e3 / totalMs : 0)
+         << " epochs/s; load " << total.m_loadMs << " ms, execute "
+         << total.m_executeMs << " ms, commit " << total.m_commitMs
+         << " ms; " << rootMismatches << " state root and "
+         << total.m_receiptMismatches << " receipt mismatches" << endl;
+
+    return rootMismatches == 0 ? SUCCESS : ERROR_UNEXPECTED;
+  } catch (std::exception& e) {
+    std::cerr << "Unhandled Exception reached the top of main: " << e.what()
+              << ", application will now exit" << std::endl;
+    return ERROR_UNHANDLED_EXCEPTION;
+  }
+
+  return SUCCESS;
+}
@@ -19,8 +19,13 @@
 #define __BASETYPE_H__
 
 #include <stdint.h>
+#include <memory>
 #include <vector>
 
 using bytes = std::vector<uint8_t>;
 
+/// Immutable, reference counted message buffer that can be queued for many
+/// peers without copying the payload
+using SharedBytes = std::shared_ptr<const bytes>;
+
 #endif  // __BASETYPE_H__
@@ -77,6 +77,21 @@ const string GENESIS_PUBKEY{
     ReadConstantString("GENESIS_PUBKEY", "node.general.")};
 const unsigned int UPGRADE_TARGET_DS_NUM{
     ReadConstantNumeric("UPGRADE_TARGET_DS_NUM")};
+const unsigned int PUBKEY_INTERN_CACHE_SIZE{
+    ReadConstantNumeric("PUBKEY_INTERN_CACHE_SIZE")};
+const unsigned int STATE_NODE_CACHE_SIZE{
+    ReadConstantNumeric("STATE_NODE_CACHE_SIZE")};
+const unsigned int TXBODY_CACHE_SIZE{ReadConstantNumeric("TXBODY_CACHE_SIZE")};
+const unsigned int MICROBLOCK_CACHE_SIZE{
+    ReadConstantNumeric("MICROBLOCK_CACHE_SIZE")};
+const unsigned int CONTRACT_CODE_CACHE_SIZE{
+    ReadConstantNumeric("CONTRACT_CODE_CACHE_SIZE")};
+const unsigned int SCHEDULER_NUM_THREADS{
+    ReadConstantNumeric("SCHEDULER_NUM_THREADS")};
+const unsigned int DETACHED_FUNCTION_MAX_THREADS{
+    ReadConstantNumeric("DETACHED_FUNCTION_MAX_THREADS")};
+const unsigned int DETACHED_FUNCTION_IDLE_TIMEOUT_IN_SECONDS{
+    ReadConstantNumeric("DETACHED_FUNCTION_IDLE_TIMEOUT_IN_SECONDS")};
 
 // Version constants
 const unsigned int MSG_VERSION{
@@ -107,8 +122,18 @@ const unsigned int CONTRACT_STATE_VERSION{
 // Seed constans
 const bool ARCHIVAL_LOOKUP{
     ReadConstantString("ARCHIVAL_LOOKUP", "node.seed.") == "true"};
+const bool LOOKUP_REPLICA{
+    ReadConstantString("LOOKUP_REPLICA", "node.seed.") == "true"};
 const unsigned int SEED_TXN_COLLECTION_TIME_IN_SEC{
     ReadConstantNumeric("SEED_TXN_COLLECTION_TIME_IN_SEC", "node.seed.")};
+const bool ENABLE_TXN_ADDRESS_INDEX{
+    ReadConstantString("ENABLE_TXN_ADDRESS_INDEX", "node.seed.") == "true"};
+const bool ENABLE_EVENT_BLOOM_INDEX{
+    ReadConstantString("ENABLE_EVENT_BLOOM_INDEX", "node.seed.") == "true"};
+const unsigned int EVENT_QUERY_MAX_BLOCK_RANGE{
+    ReadConstantNumeric("EVENT_QUERY_MAX_BLOCK_RANGE", "node.seed.")};
+const unsigned int EVENT_QUERY_MAX_RESULTS{
+    ReadConstantNumeric("EVENT_QUERY_MAX_RESULTS", "node.seed.")};
 
 // Consensus constants
 const unsigned int COMMIT_WINDOW_IN_SECONDS{
@@ -123,6 +148,18 @@ const unsigned int SHARD_NUM_CONSENSUS_SUBSETS{
     ReadConstantNumeric("SHARD_NUM_CONSENSUS_SUBSETS", "node.consensus.")};
 const unsigned int COMMIT_TOLERANCE_PERCENT{
     ReadConstantNumeric("COMMIT_TOLERANCE_PERCENT", "node.consensus.")};
+const unsigned int AGGREGATED_PUBKEY_CACHE_SIZE{
+    ReadConstantNumeric("AGGREGATED_PUBKEY_CACHE_SIZE", "node.consensus.")};
+const bool ENABLE_CONSENSUS_STATS{
+    ReadConstantString("ENABLE_CONSENSUS_STATS", "node.consensus.") == "true"};
+const unsigned int CONSENSUS_STATS_DUMP_INTERVAL_IN_SECONDS{
+    ReadConstantNumeric("CONSENSUS_STATS_DUMP_INTERVAL_IN_SECONDS",
+                        "node.consensus.")};
+const string CONSENSUS_STATS_FILE{
+    ReadConstantString("CONSENSUS_STATS_FILE", "node.consensus.")};
+const bool ENABLE_ADAPTIVE_CONSENSUS_SUBSETS{
+    ReadConstantString("ENABLE_ADAPTIVE_CONSENSUS_SUBSETS",
+                       "node.consensus.") == "true"};
 
 // Data sharing constants
 const bool BROADCAST_TREEBASED_CLUSTER_MODE{
@@ -140,6 +177,100 @@ const unsigned int POW_PACKET_SENDERS{
     ReadConstantNumeric("POW_PACKET_SENDERS", "node.data_sharing.")};
 const unsigned int TX_SHARING_CLUSTER_SIZE{
     ReadConstantNumeric("TX_SHARING_CLUSTER_SIZE", "node.data_sharing.")};
+const bool ENABLE_COMPACT_MBNFORWARD{
+    ReadConstantString("ENABLE_COMPACT_MBNFORWARD",
+                       "node.data_sharing.") == "true"};
+const unsigned int COMPACT_MBNFORWARD_CACHE_EPOCHS{
+    ReadConstantNumeric("COMPACT_MBNFORWARD_CACHE_EPOCHS",
+                        "node.data_sharing.")};
+const unsigned int MISSING_TXN_FETCH_BATCH_SIZE{
+    ReadConstantNumeric("MISSING_TXN_FETCH_BATCH_SIZE", "node.data_sharing.")};
+const unsigned int MISSING_TXN_FETCH_PEERS{
+    ReadConstantNumeric("MISSING_TXN_FETCH_PEERS", "node.data_sharing.")};
+const unsigned int STATE_SYNC_NUM_CHUNKS{
+    ReadConstantNumeric("STATE_SYNC_NUM_CHUNKS", "node.data_sharing.")};
+const unsigned int STATE_SYNC_CHUNK_TIMEOUT_IN_SECONDS{ReadConstantNumeric(
+    "STATE_SYNC_CHUNK_TIMEOUT_IN_SECONDS", "node.data_sharing.")};
+const unsigned int STATE_SYNC_CHUNK_RETRIES{
+    ReadConstantNumeric("STATE_SYNC_CHUNK_RETRIES", "node.data_sharing.")};
+const unsigned int BLOCK_SYNC_CHUNK_SIZE{
+    ReadConstantNumeric("BLOCK_SYNC_CHUNK_SIZE", "node.data_sharing.")};
+const unsigned int BLOCK_SYNC_NUM_PARALLEL{
+    ReadConstantNumeric("BLOCK_SYNC_NUM_PARALLEL", "node.data_sharing.")};
+const unsigned int BLOCK_SYNC_CHUNK_TIMEOUT_IN_SECONDS{ReadConstantNumeric(
+    "BLOCK_SYNC_CHUNK_TIMEOUT_IN_SECONDS", "node.data_sharing.")};
+const unsigned int STATE_DELTA_PREFETCH_MAX_BLOCKS{ReadConstantNumeric(
+    "STATE_DELTA_PREFETCH_MAX_BLOCKS", "node.data_sharing.")};
+const unsigned int BLOCK_SUBSCRIPTION_TIMEOUT_IN_SECONDS{ReadConstantNumeric(
+    "BLOCK_SUBSCRIPTION_TIMEOUT_IN_SECONDS", "node.data_sharing.")};
+const unsigned int MAX_BLOCK_SUBSCRIBERS{
+    ReadConstantNumeric("MAX_BLOCK_SUBSCRIBERS", "node.data_sharing.")};
+const unsigned int LOOKUP_RESPONSE_CACHE_SIZE{
+    ReadConstantNumeric("LOOKUP_RESPONSE_CACHE_SIZE", "node.data_sharing.")};
+const unsigned int LOOKUP_RESPONSE_CACHE_MAX_ENTRY_KB{ReadConstantNumeric(
+    "LOOKUP_RESPONSE_CACHE_MAX_ENTRY_KB", "node.data_sharing.")};
+const unsigned int LOOKUP_SERVE_MAX_BLOCKS{
+    ReadConstantNumeric("LOOKUP_SERVE_MAX_BLOCKS", "node.data_sharing.")};
+const unsigned int MICROBLOCK_TXNS_PER_REQUEST{
+    ReadConstantNumeric("MICROBLOCK_TXNS_PER_REQUEST", "node.data_sharing.")};
+const unsigned int MICROBLOCK_TXNS_REQUESTS_PER_ROUND{ReadConstantNumeric(
+    "MICROBLOCK_TXNS_REQUESTS_PER_ROUND", "node.data_sharing.")};
+const unsigned int TXN_PACKET_BUFFER_MB{
+    ReadConstantNumeric("TXN_PACKET_BUFFER_MB", "node.data_sharing.")};
+const unsigned int SEED_TXN_BLKS_BUFFER_MB{
+    ReadConstantNumeric("SEED_TXN_BLKS_BUFFER_MB", "node.data_sharing.")};
+const unsigned int MBNFORWARD_TXN_BUFFER_MB{
+    ReadConstantNumeric("MBNFORWARD_TXN_BUFFER_MB", "node.data_sharing.")};
+const unsigned int MB_SUBMISSION_BUFFER_MB{
+    ReadConstantNumeric("MB_SUBMISSION_BUFFER_MB", "node.data_sharing.")};
+
+// Database constants
+const string LEVELDB_POINT_LOOKUP_DBS{
+    ReadConstantString("LEVELDB_POINT_LOOKUP_DBS", "node.database.")};
+const unsigned int LEVELDB_POINT_LOOKUP_BLOCK_CACHE_MB{ReadConstantNumeric(
+    "LEVELDB_POINT_LOOKUP_BLOCK_CACHE_MB", "node.database.")};
+const unsigned int LEVELDB_POINT_LOOKUP_BLOOM_FILTER_BITS{ReadConstantNumeric(
+    "LEVELDB_POINT_LOOKUP_BLOOM_FILTER_BITS", "node.database.")};
+const unsigned int LEVELDB_POINT_LOOKUP_WRITE_BUFFER_MB{ReadConstantNumeric(
+    "LEVELDB_POINT_LOOKUP_WRITE_BUFFER_MB", "node.database.")};
+const unsigned int LEVELDB_POINT_LOOKUP_BLOCK_SIZE_KB{ReadConstantNumeric(
+    "LEVELDB_POINT_LOOKUP_BLOCK_SIZE_KB", "node.database.")};
+const bool LEVELDB_POINT_LOOKUP_COMPRESSION{
+    ReadConstantString("LEVELDB_POINT_LOOKUP_COMPRESSION", "node.database.") ==
+    "true"};
+const string LEVELDB_SEQUENTIAL_DBS{
+    ReadConstantString("LEVELDB_SEQUENTIAL_DBS", "node.database.")};
+const unsigned int LEVELDB_SEQUENTIAL_BLOCK_CACHE_MB{
+    ReadConstantNumeric("LEVELDB_SEQUENTIAL_BLOCK_CACHE_MB", "node.database.")};
+const unsigned int LEVELDB_SEQUENTIAL_BLOOM_FILTER_BITS{ReadConstantNumeric(
+    "LEVELDB_SEQUENTIAL_BLOOM_FILTER_BITS", "node.database.")};
+const unsigned int LEVELDB_SEQUENTIAL_WRITE_BUFFER_MB{ReadConstantNumeric(
+    "LEVELDB_SEQUENTIAL_WRITE_BUFFER_MB", "node.database.")};
+const unsigned int LEVELDB_SEQUENTIAL_BLOCK_SIZE_KB{
+    ReadConstantNumeric("LEVELDB_SEQUENTIAL_BLOCK_SIZE_KB", "node.database.")};
+const bool LEVELDB_SEQUENTIAL_COMPRESSION{
+    ReadConstantString("LEVELDB_SEQUENTIAL_COMPRESSION", "node.database.") ==
+    "true"};
+const unsigned int ROCKSDB_COMPACTION_RATE_LIMIT_MB{
+    ReadConstantNumeric("ROCKSDB_COMPACTION_RATE_LIMIT_MB", "node.database.")};
+const string DB_DURABILITY_MODE{
+    ReadConstantString("DB_DURABILITY_MODE", "node.database.")};
+const string DB_DURABILITY_MODE_LOOKUP{
+    ReadConstantString("DB_DURABILITY_MODE_LOOKUP", "node.database.")};
+const bool ASYNC_BLOCK_STORAGE{
+    ReadConstantString("ASYNC_BLOCK_STORAGE", "node.database.") == "true"};
+const unsigned int STATEDELTA_RETENTION_DS_EPOCHS_SHARD{ReadConstantNumeric(
+    "STATEDELTA_RETENTION_DS_EPOCHS_SHARD", "node.database.")};
+const unsigned int STATEDELTA_RETENTION_DS_EPOCHS_DS{ReadConstantNumeric(
+    "STATEDELTA_RETENTION_DS_EPOCHS_DS", "node.database.")};
+const unsigned int STATEDELTA_RETENTION_DS_EPOCHS_LOOKUP{ReadConstantNumeric(
+    "STATEDELTA_RETENTION_DS_EPOCHS_LOOKUP", "node.database.")};
+const unsigned int TXBODY_RETENTION_DS_EPOCHS_LOOKUP{ReadConstantNumeric(
+    "TXBODY_RETENTION_DS_EPOCHS_LOOKUP", "node.database.")};
+const unsigned int PRUNE_BATCH_SIZE{
+    ReadConstantNumeric("PRUNE_BATCH_SIZE", "node.database.")};
+const unsigned int PRUNE_BATCH_INTERVAL_IN_MS{
+    ReadConstantNumeric("PRUNE_BATCH_INTERVAL_IN_MS", "node.database.")};
 
 // Dispatcher constants
 const string TXN_PATH{ReadConstantString("TXN_PATH", "node.dispatcher.")};
@@ -179,6 +310,10 @@ const unsigned int RETRY_REJOINING_TIMEOUT{
     ReadConstantNumeric("RETRY_REJOINING_TIMEOUT", "node.epoch_timing.")};
 const unsigned int RETRY_GETSTATEDELTAS_COUNT{
     ReadConstantNumeric("RETRY_GETSTATEDELTAS_COUNT", "node.epoch_timing.")};
+const unsigned int MISSING_TXN_HEDGE_DELAY_IN_MS{
+    ReadConstantNumeric("MISSING_TXN_HEDGE_DELAY_IN_MS", "node.epoch_timing.")};
+const unsigned int SYNC_POLL_INTERVAL_IN_MS{
+    ReadConstantNumeric("SYNC_POLL_INTERVAL_IN_MS", "node.epoch_timing.")};
 
 // Fallback constants
 const bool ENABLE_FALLBACK{
@@ -256,9 +391,27 @@ const bool SIGN_VERIFY_EMPTY_MSGTYP{
 const bool SIGN_VERIFY_NONEMPTY_MSGTYP{
     ReadConstantString("SIGN_VERIFY_NONEMPTY_MSGTYP", "node.gossip.") ==
     "true"};
+const bool ENABLE_GOSSIP_BATCHING{
+    ReadConstantString("ENABLE_GOSSIP_BATCHING", "node.gossip.") == "true"};
+const unsigned int MAX_GOSSIP_BATCH_SIZE{
+    ReadConstantNumeric("MAX_GOSSIP_BATCH_SIZE", "node.gossip.")};
+const uint64_t GOSSIP_RUMOR_STORE_MAX_ENTRIES{
+    ReadConstantNumeric("GOSSIP_RUMOR_STORE_MAX_ENTRIES", "node.gossip.")};
+const uint64_t GOSSIP_RUMOR_STORE_MAX_BYTES{
+    ReadConstantNumeric("GOSSIP_RUMOR_STORE_MAX_BYTES", "node.gossip.")};
+const bool ENABLE_GOSSIP_DIGEST_PULL{
+    ReadConstantString("ENABLE_GOSSIP_DIGEST_PULL", "node.gossip.") == "true"};
+const unsigned int GOSSIP_DIGEST_PULL_THRESHOLD_IN_BYTES{ReadConstantNumeric(
+    "GOSSIP_DIGEST_PULL_THRESHOLD_IN_BYTES", "node.gossip.")};
+const unsigned int GOSSIP_DIGEST_PULL_TIMEOUT_IN_MS{
+    ReadConstantNumeric("GOSSIP_DIGEST_PULL_TIMEOUT_IN_MS", "node.gossip.")};
+const unsigned int GOSSIP_DIGEST_MAX_PULLS_PER_ROUND{
+    ReadConstantNumeric("GOSSIP_DIGEST_MAX_PULLS_PER_ROUND", "node.gossip.")};
 
 // GPU mining constants
 const string GPU_TO_USE{ReadConstantString("GPU_TO_USE", "node.gpu.")};
+const string OPENCL_GPU_TO_USE{
+    ReadConstantString("GPU_TO_USE", "node.gpu.opencl.")};
 const unsigned int OPENCL_LOCAL_WORK_SIZE{
     ReadConstantNumeric("LOCAL_WORK_SIZE", "node.gpu.opencl.")};
 const unsigned int OPENCL_GLOBAL_WORK_SIZE_MULTIPLIER{
@@ -294,6 +447,60 @@ const unsigned int RPC_PORT{ReadConstantNumeric("RPC_PORT", "node.jsonrpc.")};
 const std::string IP_TO_BIND{ReadConstantString("IP_TO_BIND", "node.jsonrpc.")};
 const bool ENABLE_STATUS_RPC{
     ReadConstantString("ENABLE_STATUS_RPC", "node.jsonrpc.") == "true"};
+const unsigned int RPC_CONNECTION_THREADS{
+    ReadConstantNumeric("RPC_CONNECTION_THREADS", "node.jsonrpc.")};
+const unsigned int RPC_WORKER_THREADS{
+    ReadConstantNumeric("RPC_WORKER_THREADS", "node.jsonrpc.")};
+const unsigned int RPC_EXPENSIVE_WORKER_THREADS{
+    ReadConstantNumeric("RPC_EXPENSIVE_WORKER_THREADS", "node.jsonrpc.")};
+const unsigned int RPC_MAX_QUEUED_REQUESTS{
+    ReadConstantNumeric("RPC_MAX_QUEUED_REQUESTS", "node.jsonrpc.")};
+const unsigned int RPC_BATCH_THREADS{
+    ReadConstantNumeric("RPC_BATCH_THREADS", "node.jsonrpc.")};
+const unsigned int RPC_CONNECTION_TIMEOUT_IN_SECONDS{
+    ReadConstantNumeric("RPC_CONNECTION_TIMEOUT_IN_SECONDS", "node.jsonrpc.")};
+const unsigned int RPC_RESPONSE_CACHE_SIZE{
+    ReadConstantNumeric("RPC_RESPONSE_CACHE_SIZE", "node.jsonrpc.")};
+const unsigned int TXN_ADMISSION_SEEN_CAPACITY{
+    ReadConstantNumeric("TXN_ADMISSION_SEEN_CAPACITY", "node.jsonrpc.")};
+const unsigned int TXN_ADMISSION_MAX_QUEUED{
+    ReadConstantNumeric("TXN_ADMISSION_MAX_QUEUED", "node.jsonrpc.")};
+const unsigned int TXN_ADMISSION_BATCH_SIZE{
+    ReadConstantNumeric("TXN_ADMISSION_BATCH_SIZE", "node.jsonrpc.")};
+const unsigned int RPC_CLIENT_RATE_LIMIT{
+    ReadConstantNumeric("RPC_CLIENT_RATE_LIMIT", "node.jsonrpc.")};
+const std::string RPC_METHOD_RATE_LIMITS{
+    ReadConstantString("RPC_METHOD_RATE_LIMITS", "node.jsonrpc.")};
+const bool ENABLE_WEBSOCKET{
+    ReadConstantString("ENABLE_WEBSOCKET", "node.jsonrpc.") == "true"};
+const unsigned int WEBSOCKET_PORT{
+    ReadConstantNumeric("WEBSOCKET_PORT", "node.jsonrpc.")};
+const unsigned int WEBSOCKET_MAX_CONNECTIONS{
+    ReadConstantNumeric("WEBSOCKET_MAX_CONNECTIONS", "node.jsonrpc.")};
+const unsigned int WEBSOCKET_MAX_SUBSCRIPTIONS{
+    ReadConstantNumeric("WEBSOCKET_MAX_SUBSCRIPTIONS", "node.jsonrpc.")};
+const unsigned int WEBSOCKET_MAX_PENDING_BYTES{
+    ReadConstantNumeric("WEBSOCKET_MAX_PENDING_BYTES", "node.jsonrpc.")};
+const bool ENABLE_PROTO_RPC{
+    ReadConstantString("ENABLE_PROTO_RPC", "node.jsonrpc.") == "true"};
+const unsigned int PROTO_RPC_PORT{
+    ReadConstantNumeric("PROTO_RPC_PORT", "node.jsonrpc.")};
+const unsigned int PROTO_RPC_WORKER_THREADS{
+    ReadConstantNumeric("PROTO_RPC_WORKER_THREADS", "node.jsonrpc.")};
+const unsigned int PROTO_RPC_MAX_CONNECTIONS{
+    ReadConstantNumeric("PROTO_RPC_MAX_CONNECTIONS", "node.jsonrpc.")};
+const unsigned int PROTO_RPC_MAX_MESSAGE_SIZE{
+    ReadConstantNumeric("PROTO_RPC_MAX_MESSAGE_SIZE", "node.jsonrpc.")};
+const bool ENABLE_METRICS{
+    ReadConstantString("ENABLE_METRICS", "node.jsonrpc.") == "true"};
+const string METRICS_IP_TO_BIND{
+    ReadConstantString("METRICS_IP_TO_BIND", "node.jsonrpc.")};
+const unsigned int METRICS_PORT{
+    ReadConstantNumeric("METRICS_PORT", "node.jsonrpc.")};
+const unsigned int MEMORY_STATS_INTERVAL_IN_SECONDS{
+    ReadConstantNumeric("MEMORY_STATS_INTERVAL_IN_SECONDS", "node.jsonrpc.")};
+const bool ENABLE_MEMORY_STATS_LOG{
+    ReadConstantString("ENABLE_MEMORY_STATS_LOG", "node.jsonrpc.") == "true"};
 
 // Network composition constants
 const unsigned int COMM_SIZE{
@@ -315,8 +522,24 @@ const unsigned int FETCH_LOOKUP_MSG_MAX_RETRY{
 const uint32_t MAXMESSAGE{ReadConstantNumeric("MAXMESSAGE", "node.p2pcomm.")};
 const unsigned int MAXRETRYCONN{
     ReadConstantNumeric("MAXRETRYCONN", "node.p2pcomm.")};
+const unsigned int MESSAGE_PUMP_REACTORS{
+    ReadConstantNumeric("MESSAGE_PUMP_REACTORS", "node.p2pcomm.")};
 const unsigned int MSGQUEUE_SIZE{
     ReadConstantNumeric("MSGQUEUE_SIZE", "node.p2pcomm.")};
+const unsigned int DISPATCH_CONSENSUS_THREADS{
+    ReadConstantNumeric("DISPATCH_CONSENSUS_THREADS", "node.p2pcomm.")};
+const unsigned int DISPATCH_BLOCK_THREADS{
+    ReadConstantNumeric("DISPATCH_BLOCK_THREADS", "node.p2pcomm.")};
+const unsigned int DISPATCH_TXN_THREADS{
+    ReadConstantNumeric("DISPATCH_TXN_THREADS", "node.p2pcomm.")};
+const unsigned int DISPATCH_SYNC_THREADS{
+    ReadConstantNumeric("DISPATCH_SYNC_THREADS", "node.p2pcomm.")};
+const unsigned int DISPATCH_SERVE_THREADS{
+    ReadConstantNumeric("DISPATCH_SERVE_THREADS", "node.p2pcomm.")};
+const unsigned int SERVE_MAX_QUEUED_PER_PEER{
+    ReadConstantNumeric("SERVE_MAX_QUEUED_PER_PEER", "node.p2pcomm.")};
+const unsigned int SERVE_REQUESTS_PER_SECOND_PER_PEER{ReadConstantNumeric(
+    "SERVE_REQUESTS_PER_SECOND_PER_PEER", "node.p2pcomm.")};
 const unsigned int PUMPMESSAGE_MILLISECONDS{
     ReadConstantNumeric("PUMPMESSAGE_MILLISECONDS", "node.p2pcomm.")};
 const unsigned int SENDQUEUE_SIZE{
@@ -331,14 +554,76 @@ const unsigned int CONNECTION_TIMEOUT_IN_SECONDS{
     ReadConstantNumeric("CONNECTION_TIMEOUT_IN_SECONDS", "node.p2pcomm.")};
 const unsigned int BLACKLIST_NUM_TO_POP{
     ReadConstantNumeric("BLACKLIST_NUM_TO_POP", "node.p2pcomm.")};
+const bool ENABLE_CONNECTION_POOL{
+    ReadConstantString("ENABLE_CONNECTION_POOL", "node.p2pcomm.") == "true"};
+const unsigned int CONNECTION_POOL_IDLE_TIMEOUT_IN_SECONDS{
+    ReadConstantNumeric("CONNECTION_POOL_IDLE_TIMEOUT_IN_SECONDS",
+                        "node.p2pcomm.")};
+const unsigned int CONNECTION_POOL_MAX_IDLE_PER_PEER{
+    ReadConstantNumeric("CONNECTION_POOL_MAX_IDLE_PER_PEER", "node.p2pcomm.")};
+const bool ENABLE_WIRE_COMPRESSION{
+    ReadConstantString("ENABLE_WIRE_COMPRESSION", "node.p2pcomm.") == "true"};
+const unsigned int WIRE_COMPRESSION_THRESHOLD_IN_BYTES{
+    ReadConstantNumeric("WIRE_COMPRESSION_THRESHOLD_IN_BYTES",
+                        "node.p2pcomm.")};
+const unsigned int PEER_SEND_QUEUE_MAX_DEPTH{
+    ReadConstantNumeric("PEER_SEND_QUEUE_MAX_DEPTH", "node.p2pcomm.")};
+const unsigned int BROADCAST_DEDUP_BUCKETS{
+    ReadConstantNumeric("BROADCAST_DEDUP_BUCKETS", "node.p2pcomm.")};
+const unsigned int BROADCAST_DEDUP_MAX_ENTRIES{
+    ReadConstantNumeric("BROADCAST_DEDUP_MAX_ENTRIES", "node.p2pcomm.")};
+const bool ENABLE_MESSAGE_STATS{
+    ReadConstantString("ENABLE_MESSAGE_STATS", "node.p2pcomm.") == "true"};
+const unsigned int MESSAGE_STATS_DUMP_INTERVAL_IN_SECONDS{
+    ReadConstantNumeric("MESSAGE_STATS_DUMP_INTERVAL_IN_SECONDS",
+                        "node.p2pcomm.")};
+const string MESSAGE_STATS_FILE{
+    ReadConstantString("MESSAGE_STATS_FILE", "node.p2pcomm.")};
+const bool ENABLE_CHUNKED_BROADCAST{
+    ReadConstantString("ENABLE_CHUNKED_BROADCAST", "node.p2pcomm.") == "true"};
+const unsigned int CHUNKED_BROADCAST_THRESHOLD_IN_BYTES{
+    ReadConstantNumeric("CHUNKED_BROADCAST_THRESHOLD_IN_BYTES",
+                        "node.p2pcomm.")};
+const unsigned int CHUNKED_BROADCAST_PARITY_PERCENT{
+    ReadConstantNumeric("CHUNKED_BROADCAST_PARITY_PERCENT", "node.p2pcomm.")};
+const unsigned int CHUNKED_BROADCAST_MAX_PENDING{
+    ReadConstantNumeric("CHUNKED_BROADCAST_MAX_PENDING", "node.p2pcomm.")};
+const unsigned int DNS_CACHE_TTL_IN_SECONDS{
+    ReadConstantNumeric("DNS_CACHE_TTL_IN_SECONDS", "node.p2pcomm.")};
+const bool ENABLE_NETWORK_EMULATION{
+    ReadConstantString("ENABLE_NETWORK_EMULATION", "node.p2pcomm.") == "true"};
+const string NETWORK_EMULATION_FILE{
+    ReadConstantString("NETWORK_EMULATION_FILE", "node.p2pcomm.")};
 
 // PoW constants
 const bool CUDA_GPU_MINE{ReadConstantString("CUDA_GPU_MINE", "node.pow.") ==
                          "true"};
 const bool FULL_DATASET_MINE{
     ReadConstantString("FULL_DATASET_MINE", "node.pow.") == "true"};
+const std::string FULL_DATASET_HUGE_PAGES{
+    ReadConstantString("FULL_DATASET_HUGE_PAGES", "node.pow.")};
+const bool FULL_DATASET_NUMA_INTERLEAVE{
+    ReadConstantString("FULL_DATASET_NUMA_INTERLEAVE", "node.pow.") == "true"};
 const bool OPENCL_GPU_MINE{ReadConstantString("OPENCL_GPU_MINE", "node.pow.") ==
                            "true"};
+const unsigned int CPU_MINE_THREADS{
+    ReadConstantNumeric("CPU_MINE_THREADS", "node.pow.")};
+const bool CPU_MINE_AFFINITY{
+    ReadConstantString("CPU_MINE_AFFINITY", "node.pow.") == "true"};
+const std::string ETHASH_DAG_DIR{
+    ReadConstantString("ETHASH_DAG_DIR", "node.pow.")};
+const unsigned int ETHASH_PRECOMPUTE_BLOCKS{
+    ReadConstantNumeric("ETHASH_PRECOMPUTE_BLOCKS", "node.pow.")};
+const unsigned int POW_VERIFY_THREADS{
+    ReadConstantNumeric("POW_VERIFY_THREADS", "node.pow.")};
+const unsigned int POW_VERIFY_BATCH_SIZE{
+    ReadConstantNumeric("POW_VERIFY_BATCH_SIZE", "node.pow.")};
+const bool POW_SUBMISSION_RELAY{
+    ReadConstantString("POW_SUBMISSION_RELAY", "node.pow.") == "true"};
+const unsigned int POW_RELAY_INTERVAL_IN_SECONDS{
+    ReadConstantNumeric("POW_RELAY_INTERVAL_IN_SECONDS", "node.pow.")};
+const unsigned int POW_RELAY_BATCH_SIZE{
+    ReadConstantNumeric("POW_RELAY_BATCH_SIZE", "node.pow.")};
 const bool REMOTE_MINE{ReadConstantString("REMOTE_MINE", "node.pow.") ==
                        "true"};
 const std::string MINING_PROXY_URL{
@@ -349,6 +634,16 @@ const bool GETWORK_SERVER_MINE{
     ReadConstantString("GETWORK_SERVER_MINE", "node.pow.") == "true"};
 const unsigned int GETWORK_SERVER_PORT{
     ReadConstantNumeric("GETWORK_SERVER_PORT", "node.pow.")};
+const unsigned int GETWORK_SERVER_THREADS{
+    ReadConstantNumeric("GETWORK_SERVER_THREADS", "node.pow.")};
+const unsigned int GETWORK_SERVER_WORKERS{
+    ReadConstantNumeric("GETWORK_SERVER_WORKERS", "node.pow.")};
+const unsigned int GETWORK_LONG_POLL_WORKERS{
+    ReadConstantNumeric("GETWORK_LONG_POLL_WORKERS", "node.pow.")};
+const unsigned int GETWORK_MAX_QUEUED_REQUESTS{
+    ReadConstantNumeric("GETWORK_MAX_QUEUED_REQUESTS", "node.pow.")};
+const unsigned int GETWORK_LONG_POLL_SECONDS{
+    ReadConstantNumeric("GETWORK_LONG_POLL_SECONDS", "node.pow.")};
 const unsigned int DS_POW_DIFFICULTY{
     ReadConstantNumeric("DS_POW_DIFFICULTY", "node.pow.")};
 const unsigned int POW_DIFFICULTY{
@@ -409,6 +704,24 @@ const unsigned int RESUME_BLACKLIST_DELAY_IN_SECONDS{
     ReadConstantNumeric("RESUME_BLACKLIST_DELAY_IN_SECONDS", "node.recovery.")};
 const unsigned int INCRDB_DSNUMS_WITH_STATEDELTAS{
     ReadConstantNumeric("INCRDB_DSNUMS_WITH_STATEDELTAS", "node.recovery.")};
+const bool ENABLE_WARM_START{
+    ReadConstantString("ENABLE_WARM_START", "node.recovery.") == "true"};
+const unsigned int WARM_START_SNAPSHOT_INTERVAL{
+    ReadConstantNumeric("WARM_START_SNAPSHOT_INTERVAL", "node.recovery.")};
+const bool ASYNC_IO_USE_IO_URING{
+    ReadConstantString("ASYNC_IO_USE_IO_URING", "node.recovery.") == "true"};
+const unsigned int ASYNC_IO_QUEUE_DEPTH{
+    ReadConstantNumeric("ASYNC_IO_QUEUE_DEPTH", "node.recovery.")};
+const unsigned int DB_VERIF_THREADS{
+    ReadConstantNumeric("DB_VERIF_THREADS", "node.recovery.")};
+const unsigned int SYNC_COSIG_VERIF_THREADS{
+    ReadConstantNumeric("SYNC_COSIG_VERIF_THREADS", "node.recovery.")};
+const std::string PERSISTENCE_DOWNLOAD_URL{
+    ReadConstantString("PERSISTENCE_DOWNLOAD_URL", "node.recovery.")};
+const unsigned int PERSISTENCE_DOWNLOAD_CONNECTIONS{
+    ReadConstantNumeric("PERSISTENCE_DOWNLOAD_CONNECTIONS", "node.recovery.")};
+const uint64_t PERSISTENCE_DOWNLOAD_CHUNK_IN_BYTES{ReadConstantNumeric(
+    "PERSISTENCE_DOWNLOAD_CHUNK_IN_BYTES", "node.recovery.")};
 
 // Smart contract constants
 const bool ENABLE_SC{ReadConstantString("ENABLE_SC", "node.smart_contract.") ==
@@ -445,11 +758,42 @@ const string INPUT_CODE{
 const bool ENABLE_SCILLA_MULTI_VERSION{
     ReadConstantString("ENABLE_SCILLA_MULTI_VERSION", "node.smart_contract.") ==
     "true"};
+const bool ENABLE_SCILLA_SERVER{
+    ReadConstantString("ENABLE_SCILLA_SERVER", "node.smart_contract.") ==
+    "true"};
+const string SCILLA_SERVER_BINARY{
+    ReadConstantString("SCILLA_SERVER_BINARY", "node.smart_contract.")};
+const string SCILLA_SERVER_SOCKET_PATH{
+    ReadConstantString("SCILLA_SERVER_SOCKET_PATH", "node.smart_contract.")};
+const unsigned int SCILLA_SERVER_STARTUP_TIMEOUT_IN_MS{ReadConstantNumeric(
+    "SCILLA_SERVER_STARTUP_TIMEOUT_IN_MS", "node.smart_contract.")};
+// Only takes effect with the scilla server, which can read inputs inline
+const bool SCILLA_SERVER_INLINE_IO{
+    ENABLE_SCILLA_SERVER &&
+    ReadConstantString("SCILLA_SERVER_INLINE_IO", "node.smart_contract.") ==
+        "true"};
+const unsigned int SCILLA_CHECKER_CACHE_SIZE{
+    ReadConstantNumeric("SCILLA_CHECKER_CACHE_SIZE", "node.smart_contract.")};
+const bool SCILLA_STATE_DIFF_OUTPUT{
+    ReadConstantString("SCILLA_STATE_DIFF_OUTPUT", "node.smart_contract.") ==
+    "true"};
+const bool ENABLE_CONTRACT_PROFILING{
+    ReadConstantString("ENABLE_CONTRACT_PROFILING", "node.smart_contract.") ==
+    "true"};
+const unsigned int CONTRACT_PROFILING_DUMP_ENTRIES{ReadConstantNumeric(
+    "CONTRACT_PROFILING_DUMP_ENTRIES", "node.smart_contract.")};
+const unsigned int CONTRACT_PROFILING_DUMP_INTERVAL_IN_EPOCHS{
+    ReadConstantNumeric("CONTRACT_PROFILING_DUMP_INTERVAL_IN_EPOCHS",
+                        "node.smart_contract.")};
 
 // Test constants
 const bool ENABLE_CHECK_PERFORMANCE_LOG{
     ReadConstantString("ENABLE_CHECK_PERFORMANCE_LOG", "node.tests.") ==
     "true"};
+const bool ENABLE_EPOCH_TRACING{
+    ReadConstantString("ENABLE_EPOCH_TRACING", "node.tests.") == "true"};
+const unsigned int EPOCH_TRACE_BUFFER_SIZE{
+    ReadConstantNumeric("EPOCH_TRACE_BUFFER_SIZE", "node.tests.")};
 #ifdef FALLBACK_TEST
 const unsigned int FALLBACK_TEST_EPOCH{
     ReadConstantNumeric("FALLBACK_TEST_EPOCH", "node.tests.")};
@@ -490,6 +834,23 @@ const unsigned int SMALL_TXN_SIZE{
     ReadConstantNumeric("SMALL_TXN_SIZE", "node.transactions.")};
 const unsigned int ACCOUNT_IO_BATCH_SIZE{
     ReadConstantNumeric("ACCOUNT_IO_BATCH_SIZE", "node.transactions.")};
+const unsigned int TXN_VERIFICATION_NUM_THREADS{ReadConstantNumeric(
+    "TXN_VERIFICATION_NUM_THREADS", "node.transactions.")};
+const bool ENABLE_PARALLEL_PAYMENT_TXNS{
+    ReadConstantString("ENABLE_PARALLEL_PAYMENT_TXNS",
+                       "node.transactions.") == "true"};
+const unsigned int PAYMENT_TXN_BATCH_SIZE{
+    ReadConstantNumeric("PAYMENT_TXN_BATCH_SIZE", "node.transactions.")};
+const unsigned int TXN_PROCESSING_NUM_THREADS{
+    ReadConstantNumeric("TXN_PROCESSING_NUM_THREADS", "node.transactions.")};
+const bool ENABLE_BACKUP_TXN_REPLAY{
+    ReadConstantString("ENABLE_BACKUP_TXN_REPLAY", "node.transactions.") ==
+    "true"};
+const bool ENABLE_EARLY_MICROBLOCK_COMPOSITION{
+    ReadConstantString("ENABLE_EARLY_MICROBLOCK_COMPOSITION",
+                       "node.transactions.") == "true"};
+const unsigned int STATE_TRIE_HASHING_NUM_THREADS{ReadConstantNumeric(
+    "STATE_TRIE_HASHING_NUM_THREADS", "node.transactions.")};
 const bool ENABLE_REPOPULATE{
     ReadConstantString("ENABLE_REPOPULATE", "node.transactions.") == "true"};
 const unsigned int REPOPULATE_STATE_PER_N_DS{
@@ -77,6 +77,8 @@ enum MetaType : unsigned char {
   DSINCOMPLETED,
   LATESTACTIVEDSBLOCKNUM,
   WAKEUPFORUPGRADE,
+  /// Newest Tx block whose epoch was committed, if durability is not async
+  EPOCHCOMMITTED,
 };
 
 // Sync Type
@@ -129,6 +131,14 @@ extern const unsigned int MAX_ENTRIES_FOR_DIAGNOSTIC_DATA;
 extern const uint16_t CHAIN_ID;
 extern const std::string GENESIS_PUBKEY;
 extern const unsigned int UPGRADE_TARGET_DS_NUM;
+extern const unsigned int PUBKEY_INTERN_CACHE_SIZE;
+extern const unsigned int STATE_NODE_CACHE_SIZE;
+extern const unsigned int TXBODY_CACHE_SIZE;
+extern const unsigned int MICROBLOCK_CACHE_SIZE;
+extern const unsigned int CONTRACT_CODE_CACHE_SIZE;
+extern const unsigned int SCHEDULER_NUM_THREADS;
+extern const unsigned int DETACHED_FUNCTION_MAX_THREADS;
+extern const unsigned int DETACHED_FUNCTION_IDLE_TIMEOUT_IN_SECONDS;
 
 // Version constants
 extern const unsigned int MSG_VERSION;
@@ -146,7 +156,12 @@ extern const unsigned int CONTRACT_STATE_VERSION;
 
 // Seed Node
 extern const bool ARCHIVAL_LOOKUP;
+extern const bool LOOKUP_REPLICA;
 extern const unsigned int SEED_TXN_COLLECTION_TIME_IN_SEC;
+extern const bool ENABLE_TXN_ADDRESS_INDEX;
+extern const bool ENABLE_EVENT_BLOOM_INDEX;
+extern const unsigned int EVENT_QUERY_MAX_BLOCK_RANGE;
+extern const unsigned int EVENT_QUERY_MAX_RESULTS;
 
 // Consensus constants
 extern const unsigned int COMMIT_WINDOW_IN_SECONDS;
@@ -155,6 +170,11 @@ extern const unsigned int CONSENSUS_OBJECT_TIMEOUT;
 extern const unsigned int DS_NUM_CONSENSUS_SUBSETS;
 extern const unsigned int SHARD_NUM_CONSENSUS_SUBSETS;
 extern const unsigned int COMMIT_TOLERANCE_PERCENT;
+extern const unsigned int AGGREGATED_PUBKEY_CACHE_SIZE;
+extern const bool ENABLE_CONSENSUS_STATS;
+extern const unsigned int CONSENSUS_STATS_DUMP_INTERVAL_IN_SECONDS;
+extern const std::string CONSENSUS_STATS_FILE;
+extern const bool ENABLE_ADAPTIVE_CONSENSUS_SUBSETS;
 
 // Data sharing constants
 extern const bool BROADCAST_TREEBASED_CLUSTER_MODE;
@@ -164,6 +184,52 @@ extern const unsigned int NUM_NODES_TO_SEND_LOOKUP;
 extern const unsigned int NUM_OF_TREEBASED_CHILD_CLUSTERS;
 extern const unsigned int POW_PACKET_SENDERS;
 extern const unsigned int TX_SHARING_CLUSTER_SIZE;
+extern const bool ENABLE_COMPACT_MBNFORWARD;
+extern const unsigned int COMPACT_MBNFORWARD_CACHE_EPOCHS;
+extern const unsigned int MISSING_TXN_FETCH_BATCH_SIZE;
+extern const unsigned int MISSING_TXN_FETCH_PEERS;
+extern const unsigned int STATE_SYNC_NUM_CHUNKS;
+extern const unsigned int STATE_SYNC_CHUNK_TIMEOUT_IN_SECONDS;
+extern const unsigned int STATE_SYNC_CHUNK_RETRIES;
+extern const unsigned int BLOCK_SYNC_CHUNK_SIZE;
+extern const unsigned int BLOCK_SYNC_NUM_PARALLEL;
+extern const unsigned int BLOCK_SYNC_CHUNK_TIMEOUT_IN_SECONDS;
+extern const unsigned int STATE_DELTA_PREFETCH_MAX_BLOCKS;
+extern const unsigned int BLOCK_SUBSCRIPTION_TIMEOUT_IN_SECONDS;
+extern const unsigned int MAX_BLOCK_SUBSCRIBERS;
+extern const unsigned int LOOKUP_RESPONSE_CACHE_SIZE;
+extern const unsigned int LOOKUP_RESPONSE_CACHE_MAX_ENTRY_KB;
+extern const unsigned int LOOKUP_SERVE_MAX_BLOCKS;
+extern const unsigned int MICROBLOCK_TXNS_PER_REQUEST;
+extern const unsigned int MICROBLOCK_TXNS_REQUESTS_PER_ROUND;
+extern const unsigned int TXN_PACKET_BUFFER_MB;
+extern const unsigned int SEED_TXN_BLKS_BUFFER_MB;
+extern const unsigned int MBNFORWARD_TXN_BUFFER_MB;
+extern const unsigned int MB_SUBMISSION_BUFFER_MB;
+
+// Database constants
+extern const std::string LEVELDB_POINT_LOOKUP_DBS;
+extern const unsigned int LEVELDB_POINT_LOOKUP_BLOCK_CACHE_MB;
+extern const unsigned int LEVELDB_POINT_LOOKUP_BLOOM_FILTER_BITS;
+extern const unsigned int LEVELDB_POINT_LOOKUP_WRITE_BUFFER_MB;
+extern const unsigned int LEVELDB_POINT_LOOKUP_BLOCK_SIZE_KB;
+extern const bool LEVELDB_POINT_LOOKUP_COMPRESSION;
+extern const std::string LEVELDB_SEQUENTIAL_DBS;
+extern const unsigned int LEVELDB_SEQUENTIAL_BLOCK_CACHE_MB;
+extern const unsigned int LEVELDB_SEQUENTIAL_BLOOM_FILTER_BITS;
+extern const unsigned int LEVELDB_SEQUENTIAL_WRITE_BUFFER_MB;
+extern const unsigned int LEVELDB_SEQUENTIAL_BLOCK_SIZE_KB;
+extern const bool LEVELDB_SEQUENTIAL_COMPRESSION;
+extern const unsigned int ROCKSDB_COMPACTION_RATE_LIMIT_MB;
+extern const std::string DB_DURABILITY_MODE;
+extern const std::string DB_DURABILITY_MODE_LOOKUP;
+extern const bool ASYNC_BLOCK_STORAGE;
+extern const unsigned int STATEDELTA_RETENTION_DS_EPOCHS_SHARD;
+extern const unsigned int STATEDELTA_RETENTION_DS_EPOCHS_DS;
+extern const unsigned int STATEDELTA_RETENTION_DS_EPOCHS_LOOKUP;
+extern const unsigned int TXBODY_RETENTION_DS_EPOCHS_LOOKUP;
+extern const unsigned int PRUNE_BATCH_SIZE;
+extern const unsigned int PRUNE_BATCH_INTERVAL_IN_MS;
 
 // Dispatcher constants
 extern const bool USE_REMOTE_TXN_CREATOR;
@@ -186,6 +252,8 @@ extern const unsigned int NEW_LOOKUP_GETSHARD_TIMEOUT_IN_SECONDS;
 extern const unsigned int GETSTATEDELTAS_TIMEOUT_IN_SECONDS;
 extern const unsigned int RETRY_REJOINING_TIMEOUT;
 extern const unsigned int RETRY_GETSTATEDELTAS_COUNT;
+extern const unsigned int MISSING_TXN_HEDGE_DELAY_IN_MS;
+extern const unsigned int SYNC_POLL_INTERVAL_IN_MS;
 
 // Fallback constants
 extern const bool ENABLE_FALLBACK;
@@ -226,9 +294,18 @@ extern const unsigned int SIMULATED_NETWORK_DELAY_IN_MS;
 extern const unsigned int KEEP_RAWMSG_FROM_LAST_N_ROUNDS;
 extern const bool SIGN_VERIFY_EMPTY_MSGTYP;
 extern const bool SIGN_VERIFY_NONEMPTY_MSGTYP;
+extern const bool ENABLE_GOSSIP_BATCHING;
+extern const unsigned int MAX_GOSSIP_BATCH_SIZE;
+extern const uint64_t GOSSIP_RUMOR_STORE_MAX_ENTRIES;
+extern const uint64_t GOSSIP_RUMOR_STORE_MAX_BYTES;
+extern const bool ENABLE_GOSSIP_DIGEST_PULL;
+extern const unsigned int GOSSIP_DIGEST_PULL_THRESHOLD_IN_BYTES;
+extern const unsigned int GOSSIP_DIGEST_PULL_TIMEOUT_IN_MS;
+extern const unsigned int GOSSIP_DIGEST_MAX_PULLS_PER_ROUND;
 
 // GPU mining constants
 extern const std::string GPU_TO_USE;
+extern const std::string OPENCL_GPU_TO_USE;
 extern const unsigned int OPENCL_LOCAL_WORK_SIZE;
 extern const unsigned int OPENCL_GLOBAL_WORK_SIZE_MULTIPLIER;
 extern const unsigned int OPENCL_START_EPOCH;
@@ -251,6 +328,33 @@ extern const unsigned int HEARTBEAT_INTERVAL_IN_SECONDS;
 extern const unsigned int RPC_PORT;
 extern const std::string IP_TO_BIND;  // Only for non-lookup nodes
 extern const bool ENABLE_STATUS_RPC;  //
+extern const unsigned int RPC_CONNECTION_THREADS;  // Only for lookup nodes
+extern const unsigned int RPC_WORKER_THREADS;
+extern const unsigned int RPC_EXPENSIVE_WORKER_THREADS;
+extern const unsigned int RPC_MAX_QUEUED_REQUESTS;
+extern const unsigned int RPC_BATCH_THREADS;
+extern const unsigned int RPC_CONNECTION_TIMEOUT_IN_SECONDS;
+extern const unsigned int RPC_RESPONSE_CACHE_SIZE;
+extern const unsigned int TXN_ADMISSION_SEEN_CAPACITY;
+extern const unsigned int TXN_ADMISSION_MAX_QUEUED;
+extern const unsigned int TXN_ADMISSION_BATCH_SIZE;
+extern const unsigned int RPC_CLIENT_RATE_LIMIT;
+extern const std::string RPC_METHOD_RATE_LIMITS;
+extern const bool ENABLE_WEBSOCKET;
+extern const unsigned int WEBSOCKET_PORT;
+extern const unsigned int WEBSOCKET_MAX_CONNECTIONS;
+extern const unsigned int WEBSOCKET_MAX_SUBSCRIPTIONS;
+extern const unsigned int WEBSOCKET_MAX_PENDING_BYTES;
+extern const bool ENABLE_PROTO_RPC;
+extern const unsigned int PROTO_RPC_PORT;
+extern const unsigned int PROTO_RPC_WORKER_THREADS;
+extern const unsigned int PROTO_RPC_MAX_CONNECTIONS;
+extern const unsigned int PROTO_RPC_MAX_MESSAGE_SIZE;
+extern const bool ENABLE_METRICS;
+extern const std::string METRICS_IP_TO_BIND;
+extern const unsigned int METRICS_PORT;
+extern const unsigned int MEMORY_STATS_INTERVAL_IN_SECONDS;
+extern const bool ENABLE_MEMORY_STATS_LOG;
 
 // Network composition constants
 extern const unsigned int COMM_SIZE;
@@ -264,7 +368,15 @@ extern const unsigned int BROADCAST_EXPIRY;
 extern const unsigned int FETCH_LOOKUP_MSG_MAX_RETRY;
 extern const uint32_t MAXMESSAGE;
 extern const unsigned int MAXRETRYCONN;
+extern const unsigned int MESSAGE_PUMP_REACTORS;
 extern const unsigned int MSGQUEUE_SIZE;
+extern const unsigned int DISPATCH_CONSENSUS_THREADS;
+extern const unsigned int DISPATCH_BLOCK_THREADS;
+extern const unsigned int DISPATCH_TXN_THREADS;
+extern const unsigned int DISPATCH_SYNC_THREADS;
+extern const unsigned int DISPATCH_SERVE_THREADS;
+extern const unsigned int SERVE_MAX_QUEUED_PER_PEER;
+extern const unsigned int SERVE_REQUESTS_PER_SECOND_PER_PEER;
 extern const unsigned int PUMPMESSAGE_MILLISECONDS;
 extern const unsigned int SENDQUEUE_SIZE;
 extern const unsigned int MAX_GOSSIP_MSG_SIZE_IN_BYTES;
@@ -272,16 +384,50 @@ extern const unsigned int MIN_READ_WATERMARK_IN_BYTES;
 extern const unsigned int MAX_READ_WATERMARK_IN_BYTES;
 extern const unsigned int CONNECTION_TIMEOUT_IN_SECONDS;
 extern const unsigned int BLACKLIST_NUM_TO_POP;
+extern const bool ENABLE_CONNECTION_POOL;
+extern const unsigned int CONNECTION_POOL_IDLE_TIMEOUT_IN_SECONDS;
+extern const unsigned int CONNECTION_POOL_MAX_IDLE_PER_PEER;
+extern const bool ENABLE_WIRE_COMPRESSION;
+extern const unsigned int WIRE_COMPRESSION_THRESHOLD_IN_BYTES;
+extern const unsigned int PEER_SEND_QUEUE_MAX_DEPTH;
+extern const unsigned int BROADCAST_DEDUP_BUCKETS;
+extern const unsigned int BROADCAST_DEDUP_MAX_ENTRIES;
+extern const bool ENABLE_MESSAGE_STATS;
+extern const unsigned int MESSAGE_STATS_DUMP_INTERVAL_IN_SECONDS;
+extern const std::string MESSAGE_STATS_FILE;
+extern const bool ENABLE_CHUNKED_BROADCAST;
+extern const unsigned int CHUNKED_BROADCAST_THRESHOLD_IN_BYTES;
+extern const unsigned int CHUNKED_BROADCAST_PARITY_PERCENT;
+extern const unsigned int CHUNKED_BROADCAST_MAX_PENDING;
+extern const unsigned int DNS_CACHE_TTL_IN_SECONDS;
+extern const bool ENABLE_NETWORK_EMULATION;
+extern const std::string NETWORK_EMULATION_FILE;
 
 // PoW constants
 extern const bool CUDA_GPU_MINE;
 extern const bool FULL_DATASET_MINE;
+extern const std::string FULL_DATASET_HUGE_PAGES;
+extern const bool FULL_DATASET_NUMA_INTERLEAVE;
 extern const bool OPENCL_GPU_MINE;
+extern const unsigned int CPU_MINE_THREADS;
+extern const bool CPU_MINE_AFFINITY;
+extern const std::string ETHASH_DAG_DIR;
+extern const unsigned int ETHASH_PRECOMPUTE_BLOCKS;
+extern const unsigned int POW_VERIFY_THREADS;
+extern const unsigned int POW_VERIFY_BATCH_SIZE;
+extern const bool POW_SUBMISSION_RELAY;
+extern const unsigned int POW_RELAY_INTERVAL_IN_SECONDS;
+extern const unsigned int POW_RELAY_BATCH_SIZE;
 extern const bool REMOTE_MINE;
 extern const std::string MINING_PROXY_URL;
 extern const unsigned int CHECK_MINING_RESULT_INTERVAL;
 extern const bool GETWORK_SERVER_MINE;
 extern const unsigned int GETWORK_SERVER_PORT;
+extern const unsigned int GETWORK_SERVER_THREADS;
+extern const unsigned int GETWORK_SERVER_WORKERS;
+extern const unsigned int GETWORK_LONG_POLL_WORKERS;
+extern const unsigned int GETWORK_MAX_QUEUED_REQUESTS;
+extern const unsigned int GETWORK_LONG_POLL_SECONDS;
 extern const unsigned int DS_POW_DIFFICULTY;
 extern const unsigned int POW_DIFFICULTY;
 extern const unsigned int POW_BOUNDARY_N_DIVIDED;
@@ -312,6 +458,15 @@ extern const bool RECOVERY_TRIM_INCOMPLETED_BLOCK;
 extern const bool REJOIN_NODE_NOT_IN_NETWORK;
 extern const unsigned int RESUME_BLACKLIST_DELAY_IN_SECONDS;
 extern const unsigned int INCRDB_DSNUMS_WITH_STATEDELTAS;
+extern const bool ENABLE_WARM_START;
+extern const unsigned int WARM_START_SNAPSHOT_INTERVAL;
+extern const bool ASYNC_IO_USE_IO_URING;
+extern const unsigned int ASYNC_IO_QUEUE_DEPTH;
+extern const unsigned int DB_VERIF_THREADS;
+extern const unsigned int SYNC_COSIG_VERIF_THREADS;
+extern const std::string PERSISTENCE_DOWNLOAD_URL;
+extern const unsigned int PERSISTENCE_DOWNLOAD_CONNECTIONS;
+extern const uint64_t PERSISTENCE_DOWNLOAD_CHUNK_IN_BYTES;
 
 // Smart contract constants
 extern const bool ENABLE_SC;
@@ -328,9 +483,21 @@ extern const std::string INPUT_MESSAGE_JSON;
 extern const std::string OUTPUT_JSON;
 extern const std::string INPUT_CODE;
 extern const bool ENABLE_SCILLA_MULTI_VERSION;
+extern const bool ENABLE_SCILLA_SERVER;
+extern const std::string SCILLA_SERVER_BINARY;
+extern const std::string SCILLA_SERVER_SOCKET_PATH;
+extern const unsigned int SCILLA_SERVER_STARTUP_TIMEOUT_IN_MS;
+extern const bool SCILLA_SERVER_INLINE_IO;
+extern const unsigned int SCILLA_CHECKER_CACHE_SIZE;
+extern const bool SCILLA_STATE_DIFF_OUTPUT;
+extern const bool ENABLE_CONTRACT_PROFILING;
+extern const unsigned int CONTRACT_PROFILING_DUMP_ENTRIES;
+extern const unsigned int CONTRACT_PROFILING_DUMP_INTERVAL_IN_EPOCHS;
 
 // Test constants
 extern const bool ENABLE_CHECK_PERFORMANCE_LOG;
+extern const bool ENABLE_EPOCH_TRACING;
+extern const unsigned int EPOCH_TRACE_BUFFER_SIZE;
 #ifdef FALLBACK_TEST
 extern const unsigned int FALLBACK_TEST_EPOCH;
 #endif  // FALLBACK_TEST
@@ -353,6 +520,13 @@ extern const unsigned int PACKET_EPOCH_LATE_ALLOW;
 extern const unsigned int PACKET_BYTESIZE_LIMIT;
 extern const unsigned int SMALL_TXN_SIZE;
 extern const unsigned int ACCOUNT_IO_BATCH_SIZE;
+extern const unsigned int TXN_VERIFICATION_NUM_THREADS;
+extern const bool ENABLE_PARALLEL_PAYMENT_TXNS;
+extern const unsigned int PAYMENT_TXN_BATCH_SIZE;
+extern const unsigned int TXN_PROCESSING_NUM_THREADS;
+extern const bool ENABLE_BACKUP_TXN_REPLAY;
+extern const bool ENABLE_EARLY_MICROBLOCK_COMPOSITION;
+extern const unsigned int STATE_TRIE_HASHING_NUM_THREADS;
 extern const bool ENABLE_REPOPULATE;
 extern const unsigned int REPOPULATE_STATE_PER_N_DS;
 extern const unsigned int REPOPULATE_STATE_IN_DS;
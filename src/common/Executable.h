@@ -18,18 +18,47 @@
 #ifndef __EXECUTABLE_H__
 #define __EXECUTABLE_H__
 
+#include <functional>
+#include <unordered_map>
 #include <vector>
 #include "libNetwork/Peer.h"
 
 /// Specifies the interface required for classes that process messages.
 class Executable {
  public:
+  /// Cheap check of a message, run before it is queued. Returns false if the
+  /// message would be rejected anyway, e.g. as it is for an earlier epoch.
+  /// It sees the message as Execute would, and must neither block nor parse
+  /// more of the message than it needs.
+  typedef std::function<bool(const bytes& message, unsigned int offset)>
+      PreFilter;
+
   /// Message processing function.
   virtual bool Execute(const bytes& message, unsigned int offset,
                        const Peer& from) = 0;
 
+  /// Runs the pre-filter registered for the instruction at offset, if any,
+  /// on the rest of the message
+  bool PassesPreFilter(const bytes& message, unsigned int offset) const {
+    if (message.size() <= offset) {
+      return true;
+    }
+
+    const auto it = m_preFilters.find(message[offset]);
+    return it == m_preFilters.end() || it->second(message, offset + 1);
+  }
+
   /// Virtual destructor.
   virtual ~Executable() {}
+
+ protected:
+  /// Only to be called while constructing, as the filters are read unlocked
+  void RegisterPreFilter(unsigned char instruction, const PreFilter& filter) {
+    m_preFilters[instruction] = filter;
+  }
+
+ private:
+  std::unordered_map<unsigned char, PreFilter> m_preFilters;
 };
 
 #endif  // __EXECUTABLE_H__
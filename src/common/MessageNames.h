@@ -51,9 +51,12 @@ static const std::string NodeInstructionStrings[]{
     MAKE_LITERAL_STRING(FORWARDTXNPACKET),
     MAKE_LITERAL_STRING(FALLBACKCONSENSUS),
     MAKE_LITERAL_STRING(FALLBACKBLOCK),
-    MAKE_LITERAL_STRING(PROPOSEGASPRICE)};
+    MAKE_LITERAL_STRING(PROPOSEGASPRICE),
+    MAKE_LITERAL_STRING(DSGUARDNODENETWORKINFOUPDATE),
+    MAKE_LITERAL_STRING(MBNFORWARDTRANSACTIONCOMPACT),
+    MAKE_LITERAL_STRING(MISSINGTXNREQUEST)};
 
-static_assert(ARRAY_SIZE(NodeInstructionStrings) == PROPOSEGASPRICE + 1,
+static_assert(ARRAY_SIZE(NodeInstructionStrings) == MISSINGTXNREQUEST + 1,
               "NodeInstructionStrings definition is not correct");
 
 static const std::string LookupInstructionStrings[]{
@@ -87,9 +90,13 @@ static const std::string LookupInstructionStrings[]{
     MAKE_LITERAL_STRING(VCGETLATESTDSTXBLOCK),
     MAKE_LITERAL_STRING(FORWARDTXN),
     MAKE_LITERAL_STRING(GETGUARDNODENETWORKINFOUPDATE),
-    MAKE_LITERAL_STRING(SETHISTORICALDB)};
+    MAKE_LITERAL_STRING(SETHISTORICALDB),
+    MAKE_LITERAL_STRING(SUBSCRIBEBLOCKS),
+    MAKE_LITERAL_STRING(GETMICROBLOCKTXNSFROMLOOKUP),
+    MAKE_LITERAL_STRING(SETMICROBLOCKTXNSFROMLOOKUP)};
 
-static_assert(ARRAY_SIZE(LookupInstructionStrings) == SETHISTORICALDB + 1,
+static_assert(ARRAY_SIZE(LookupInstructionStrings) ==
+                  SETMICROBLOCKTXNSFROMLOOKUP + 1,
               "LookupInstructionStrings definition is not correct");
 
 static const std::string *MessageTypeInstructionStrings[]{
@@ -112,6 +119,25 @@ static_assert(
     ARRAY_SIZE(MessageTypeInstructionStrings) == ARRAY_SIZE(MessageTypeStrings),
     "Size of MessageTypeInstructionStrings and MessageTypeStrings is not same");
 
+static inline std::string GetMessageName(unsigned char msgType,
+                                         unsigned char instruction) {
+  const std::string InvalidMessageType = "INVALID_MESSAGE";
+  if (msgType >= ARRAY_SIZE(MessageTypeStrings)) {
+    return InvalidMessageType;
+  }
+
+  if (NULL == MessageTypeInstructionStrings[msgType]) {
+    return InvalidMessageType;
+  }
+
+  if (instruction >= MessageTypeInstructionSize[msgType]) {
+    return InvalidMessageType;
+  }
+
+  return MessageTypeStrings[msgType] + "_" +
+         MessageTypeInstructionStrings[msgType][instruction];
+}
+
 static const std::string MessageSizeKeyword = "Size of message ";
 static const std::string MessgeTimeKeyword = "Time to process message ";
 
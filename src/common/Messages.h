@@ -57,6 +57,8 @@ enum NodeInstructionType : unsigned char {
   FALLBACKBLOCK = 0x0A,
   PROPOSEGASPRICE = 0x0B,
   DSGUARDNODENETWORKINFOUPDATE = 0x0C,
+  MBNFORWARDTRANSACTIONCOMPACT = 0x0D,
+  MISSINGTXNREQUEST = 0x0E,
 };
 
 enum LookupInstructionType : unsigned char {
@@ -90,7 +92,10 @@ enum LookupInstructionType : unsigned char {
   VCGETLATESTDSTXBLOCK = 0x1B,
   FORWARDTXN = 0x1C,
   GETGUARDNODENETWORKINFOUPDATE = 0x1D,
-  SETHISTORICALDB = 0x1E
+  SETHISTORICALDB = 0x1E,
+  SUBSCRIBEBLOCKS = 0x1F,
+  GETMICROBLOCKTXNSFROMLOOKUP = 0x20,
+  SETMICROBLOCKTXNSFROMLOOKUP = 0x21
 };
 
 enum TxSharingMode : unsigned char {
@@ -7,8 +7,7 @@
 #include <vector>
 #include <string>
 
-#include <leveldb/db.h>
-#include <leveldb/write_batch.h>
+#include "depends/libDatabase/KVBackend.h"
 
 #include "libUtils/Logger.h"
 
@@ -16,12 +15,6 @@
 #pragma warning(disable:597) //will not be called for implicit or explicit conversions
 #endif
 
-namespace leveldb {
-    class DB;
-}
-
-namespace ldb = leveldb;
-
 /**
  * A modifiable reference to an existing object or vector in memory.
  */
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __KVBACKEND_H__
+#define __KVBACKEND_H__
+
+// Selects the key-value store under LevelDB and the other persistence
+// classes. RocksDB keeps the leveldb API (DB, Options, Slice, WriteBatch,
+// Iterator, Status), so code written against ldb:: builds with either;
+// configure with -DUSE_ROCKSDB=ON to use it.
+
+#ifdef USE_ROCKSDB
+
+#include <rocksdb/cache.h>
+#include <rocksdb/db.h>
+#include <rocksdb/filter_policy.h>
+#include <rocksdb/rate_limiter.h>
+#include <rocksdb/table.h>
+#include <rocksdb/write_batch.h>
+
+namespace ldb = rocksdb;
+
+#else
+
+#include <leveldb/cache.h>
+#include <leveldb/db.h>
+#include <leveldb/filter_policy.h>
+#include <leveldb/write_batch.h>
+
+namespace ldb = leveldb;
+
+#endif  // USE_ROCKSDB
+
+#endif  // __KVBACKEND_H__
@@ -15,8 +15,12 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <mutex>
 #include <string>
+#include <unordered_set>
 
+#include <boost/algorithm/string.hpp>
 #include <boost/filesystem.hpp>
 
 #include "LevelDB.h"
@@ -24,12 +28,148 @@
 #include "depends/common/Common.h"
 #include "depends/common/CommonData.h"
 #include "depends/common/FixedHash.h"
+#include "libUtils/Metrics.h"
 
 using namespace std;
 
+namespace
+{
+    bool ListsDB(const string& dbNames, const string& dbName)
+    {
+        vector<string> names;
+        boost::algorithm::split(names, dbNames, boost::algorithm::is_any_of(","));
+        return find(names.begin(), names.end(), dbName) != names.end();
+    }
+
+    /// The open databases, for SyncAll
+    mutex& GetOpenDBsMutex()
+    {
+        static mutex openDBsMutex;
+        return openDBsMutex;
+    }
+
+    unordered_set<LevelDB*>& GetOpenDBs()
+    {
+        static unordered_set<LevelDB*> openDBs;
+        return openDBs;
+    }
+
+    DBDurability ParseDurability(const string& mode)
+    {
+        if (mode == "epoch")
+        {
+            return DBDurability::EPOCH;
+        }
+        if (mode == "strict")
+        {
+            return DBDurability::STRICT;
+        }
+        if (mode != "async")
+        {
+            LOG_GENERAL(WARNING, "Unknown durability mode " << mode << ", using async");
+        }
+        return DBDurability::ASYNC;
+    }
+
+    Metrics::Histogram& GetWriteLatency()
+    {
+        static Metrics::Histogram& latency = Metrics::GetInstance().GetHistogram(
+            "zilliqa_db_write_seconds", "Time taken by each LevelDB write");
+        return latency;
+    }
+}
+
+ldb::Options LevelDB::GetOpenOptions()
+{
+    ldb::Options options;
+    options.max_open_files = 256;
+    options.create_if_missing = true;
+
+    unsigned int blockCacheMB, bloomFilterBits, writeBufferMB, blockSizeKB;
+    bool compression;
+    if (ListsDB(LEVELDB_POINT_LOOKUP_DBS, m_dbName))
+    {
+        blockCacheMB = LEVELDB_POINT_LOOKUP_BLOCK_CACHE_MB;
+        bloomFilterBits = LEVELDB_POINT_LOOKUP_BLOOM_FILTER_BITS;
+        writeBufferMB = LEVELDB_POINT_LOOKUP_WRITE_BUFFER_MB;
+        blockSizeKB = LEVELDB_POINT_LOOKUP_BLOCK_SIZE_KB;
+        compression = LEVELDB_POINT_LOOKUP_COMPRESSION;
+    }
+    else if (ListsDB(LEVELDB_SEQUENTIAL_DBS, m_dbName))
+    {
+        blockCacheMB = LEVELDB_SEQUENTIAL_BLOCK_CACHE_MB;
+        bloomFilterBits = LEVELDB_SEQUENTIAL_BLOOM_FILTER_BITS;
+        writeBufferMB = LEVELDB_SEQUENTIAL_WRITE_BUFFER_MB;
+        blockSizeKB = LEVELDB_SEQUENTIAL_BLOCK_SIZE_KB;
+        compression = LEVELDB_SEQUENTIAL_COMPRESSION;
+    }
+    else
+    {
+        return options;
+    }
+
+    // The cache and filter are kept across reopening the database
+    if (blockCacheMB > 0 && !m_blockCache)
+    {
+        m_blockCache = std::shared_ptr<ldb::Cache>(ldb::NewLRUCache(blockCacheMB * 1024 * 1024));
+    }
+    if (bloomFilterBits > 0 && !m_filterPolicy)
+    {
+        m_filterPolicy = std::shared_ptr<const ldb::FilterPolicy>(ldb::NewBloomFilterPolicy(bloomFilterBits));
+    }
+    if (writeBufferMB > 0)
+    {
+        options.write_buffer_size = writeBufferMB * 1024 * 1024;
+    }
+    options.compression = compression ? ldb::kSnappyCompression : ldb::kNoCompression;
+
+#ifdef USE_ROCKSDB
+    // RocksDB takes the block settings through its table factory
+    ldb::BlockBasedTableOptions tableOptions;
+    if (m_blockCache)
+    {
+        tableOptions.block_cache = m_blockCache;
+    }
+    if (m_filterPolicy)
+    {
+        tableOptions.filter_policy = m_filterPolicy;
+    }
+    if (blockSizeKB > 0)
+    {
+        tableOptions.block_size = blockSizeKB * 1024;
+    }
+    options.table_factory.reset(ldb::NewBlockBasedTableFactory(tableOptions));
+
+    // Keeps compaction from starving block processing of disk bandwidth
+    if (ROCKSDB_COMPACTION_RATE_LIMIT_MB > 0)
+    {
+        if (!m_rateLimiter)
+        {
+            m_rateLimiter.reset(ldb::NewGenericRateLimiter(ROCKSDB_COMPACTION_RATE_LIMIT_MB * 1024 * 1024));
+        }
+        options.rate_limiter = m_rateLimiter;
+    }
+#else
+    options.block_cache = m_blockCache.get();
+    options.filter_policy = m_filterPolicy.get();
+    if (blockSizeKB > 0)
+    {
+        options.block_size = blockSizeKB * 1024;
+    }
+#endif // USE_ROCKSDB
+
+    return options;
+}
+
 
 LevelDB::LevelDB(const string& dbName, const string& path, const string& subdirectory)
+    : m_unsynced(false)
 {
+    {
+        lock_guard<mutex> g(GetOpenDBsMutex());
+        GetOpenDBs().insert(this);
+    }
+
     this->m_subdirectory = subdirectory;
     this->m_dbName = dbName;
     this->m_db = NULL;
@@ -40,16 +180,14 @@ LevelDB::LevelDB(const string& dbName, const string& path, const string& subdire
         return;
     }
 
-    leveldb::Options options;
-    options.max_open_files = 256;
-    options.create_if_missing = true;
+    ldb::Options options = GetOpenOptions();
 
-    leveldb::DB* db;
-    leveldb::Status status;
+    ldb::DB* db;
+    ldb::Status status;
 
     if(m_subdirectory.empty())
     {
-        status = leveldb::DB::Open(options, "./" + path + "/" + this->m_dbName, &db);
+        status = ldb::DB::Open(options, "./" + path + "/" + this->m_dbName, &db);
         LOG_GENERAL(INFO,"./" + path + "/" + this->m_dbName);
     }
     else
@@ -58,7 +196,7 @@ LevelDB::LevelDB(const string& dbName, const string& path, const string& subdire
         {
             boost::filesystem::create_directories("./" + path + "/" + this->m_subdirectory);
         }
-        status = leveldb::DB::Open(options, 
+        status = ldb::DB::Open(options, 
             "./" + path + "/" + this->m_subdirectory + "/" + this->m_dbName,
             &db);
         LOG_GENERAL(INFO,"./" + path + "/" + this->m_subdirectory + "/" + this->m_dbName);
@@ -73,16 +211,20 @@ LevelDB::LevelDB(const string& dbName, const string& path, const string& subdire
 }
 
 LevelDB::LevelDB(const std::string & dbName, const std::string& subdirectory, bool diagnostic)
+    : m_unsynced(false)
 {
+    {
+        lock_guard<mutex> g(GetOpenDBsMutex());
+        GetOpenDBs().insert(this);
+    }
+
     this->m_subdirectory = subdirectory;
     this->m_dbName = dbName;
 
-    leveldb::Options options;
-    options.max_open_files = 256;
-    options.create_if_missing = true;
+    ldb::Options options = GetOpenOptions();
 
-    leveldb::DB* db;
-    leveldb::Status status;
+    ldb::DB* db;
+    ldb::Status status;
 
     // Diagnostic tool provides the option to pass the persistance db_path
     // that might not be the current directory (case when 'diagnostic' is true).
@@ -94,7 +236,7 @@ LevelDB::LevelDB(const std::string & dbName, const std::string& subdirectory, bo
         boost::filesystem::create_directories(db_path);
     }
 
-    status = leveldb::DB::Open(options, db_path + "/" + this->m_dbName, &db);
+    status = ldb::DB::Open(options, db_path + "/" + this->m_dbName, &db);
     if(!status.ok())
     {
         // throw exception();
@@ -104,12 +246,79 @@ LevelDB::LevelDB(const std::string & dbName, const std::string& subdirectory, bo
     m_db.reset(db);
 }
 
-leveldb::Slice toSlice(boost::multiprecision::uint256_t num)
+LevelDB::~LevelDB()
+{
+    lock_guard<mutex> g(GetOpenDBsMutex());
+    GetOpenDBs().erase(this);
+}
+
+DBDurability LevelDB::GetDurability()
+{
+    static const DBDurability durability = ParseDurability(
+        LOOKUP_NODE_MODE ? DB_DURABILITY_MODE_LOOKUP : DB_DURABILITY_MODE);
+    return durability;
+}
+
+ldb::WriteOptions LevelDB::GetWriteOptions()
+{
+    ldb::WriteOptions options;
+    options.sync = GetDurability() == DBDurability::STRICT;
+    return options;
+}
+
+ldb::Status LevelDB::MarkWritten(const ldb::Status& status)
+{
+    // Only once the write is done, so that a Sync cannot miss it
+    if (GetDurability() != DBDurability::STRICT)
+    {
+        m_unsynced = true;
+    }
+    return status;
+}
+
+bool LevelDB::Sync()
+{
+    if (!m_db || !m_unsynced.exchange(false))
+    {
+        return true;
+    }
+
+#ifdef USE_ROCKSDB
+    ldb::Status s = m_db->SyncWAL();
+#else
+    // Syncing the log syncs every write before it, even with an empty batch
+    ldb::WriteOptions options;
+    options.sync = true;
+    ldb::WriteBatch batch;
+    ldb::Status s = m_db->Write(options, &batch);
+#endif // USE_ROCKSDB
+    if (!s.ok())
+    {
+        m_unsynced = true;
+        LOG_GENERAL(WARNING, "[Sync] " << m_dbName << " Status: " << s.ToString());
+        return false;
+    }
+
+    return true;
+}
+
+bool LevelDB::SyncAll()
+{
+    lock_guard<mutex> g(GetOpenDBsMutex());
+    bool ret = true;
+    for (auto db : GetOpenDBs())
+    {
+        ret = db->Sync() && ret;
+    }
+    return ret;
+}
+
+ldb::Slice toSlice(boost::multiprecision::uint256_t num)
 {
     dev::FixedHash<32> h;
     dev::bytesRef ref(h.data(), 32);
     dev::toBigEndian(num, ref);
-    return (leveldb::Slice)h.ref();
+    return (ldb::Slice)h.ref();
 }
 
 string LevelDB::GetDBName()
@@ -127,7 +336,7 @@ string LevelDB::GetDBName()
 string LevelDB::Lookup(const std::string & key) const
 {
     string value;
-    leveldb::Status s = m_db->Get(leveldb::ReadOptions(), key, &value);
+    ldb::Status s = m_db->Get(ldb::ReadOptions(), key, &value);
     if (!s.ok())
     {
         // TODO
@@ -140,7 +349,7 @@ string LevelDB::Lookup(const std::string & key) const
 string LevelDB::Lookup(const boost::multiprecision::uint256_t & blockNum) const
 {
     string value;
-    leveldb::Status s = m_db->Get(leveldb::ReadOptions(), blockNum.convert_to<string>(), &value);
+    ldb::Status s = m_db->Get(ldb::ReadOptions(), blockNum.convert_to<string>(), &value);
 
     if (!s.ok())
     {
@@ -154,7 +363,7 @@ string LevelDB::Lookup(const boost::multiprecision::uint256_t & blockNum) const
 string LevelDB::Lookup(const boost::multiprecision::uint256_t & blockNum, bool &found) const
 {
     string value;
-    leveldb::Status s = m_db->Get(leveldb::ReadOptions(), blockNum.convert_to<string>(), &value);
+    ldb::Status s = m_db->Get(ldb::ReadOptions(), blockNum.convert_to<string>(), &value);
 
     if (!s.ok())
     {
@@ -168,7 +377,7 @@ string LevelDB::Lookup(const boost::multiprecision::uint256_t & blockNum, bool &
 string LevelDB::Lookup(const dev::h256 & key) const
 {
     string value;
-    leveldb::Status s = m_db->Get(leveldb::ReadOptions(), leveldb::Slice(key.hex()), &value);
+    ldb::Status s = m_db->Get(ldb::ReadOptions(), ldb::Slice(key.hex()), &value);
     if (!s.ok())
     {
         // TODO
@@ -181,8 +390,8 @@ string LevelDB::Lookup(const dev::h256 & key) const
 string LevelDB::Lookup(const dev::bytesConstRef & key) const
 {
     string value;
-    leveldb::Status s = m_db->Get(leveldb::ReadOptions(), ldb::Slice((char const*)key.data(), 32),
-                                  &value);
+    ldb::Status s = m_db->Get(ldb::ReadOptions(), ldb::Slice((char const*)key.data(), 32),
+                              &value);
     if (!s.ok())
     {
         // TODO
@@ -192,7 +401,7 @@ string LevelDB::Lookup(const dev::bytesConstRef & key) const
     return value;
 }
 
-std::shared_ptr<leveldb::DB> LevelDB::GetDB()
+std::shared_ptr<ldb::DB> LevelDB::GetDB()
 {
     return this->m_db;
 }
@@ -205,10 +414,11 @@ int LevelDB::Insert(const dev::h256 & key, dev::bytesConstRef value)
 int LevelDB::Insert(const boost::multiprecision::uint256_t & blockNum,
                     const vector<unsigned char> & body)
 {
-    leveldb::Status s = m_db->Put(leveldb::WriteOptions(),
-                                  leveldb::Slice(blockNum.convert_to<string>()),
-                                  leveldb::Slice(vector_ref<const unsigned char>(&body[0],
-                                                                                 body.size())));
+    Metrics::Timer timer(GetWriteLatency());
+    ldb::Status s = MarkWritten(m_db->Put(GetWriteOptions(),
+                                          ldb::Slice(blockNum.convert_to<string>()),
+                                          ldb::Slice(vector_ref<const unsigned char>(&body[0],
+                                                                                     body.size()))));
 
     if (!s.ok())
     {
@@ -221,9 +431,10 @@ int LevelDB::Insert(const boost::multiprecision::uint256_t & blockNum,
 int LevelDB::Insert(const boost::multiprecision::uint256_t & blockNum,
                     const std::string & body)
 {
-    leveldb::Status s = m_db->Put(leveldb::WriteOptions(),
-                                  leveldb::Slice(blockNum.convert_to<string>()),
-                                  leveldb::Slice(body.c_str(), body.size()));
+    Metrics::Timer timer(GetWriteLatency());
+    ldb::Status s = MarkWritten(m_db->Put(GetWriteOptions(),
+                                          ldb::Slice(blockNum.convert_to<string>()),
+                                          ldb::Slice(body.c_str(), body.size())));
 
     if (!s.ok())
     {
@@ -235,12 +446,13 @@ int LevelDB::Insert(const boost::multiprecision::uint256_t & blockNum,
 
 int LevelDB::Insert(const string & key, const vector<unsigned char> & body)
 {
-    return Insert(leveldb::Slice(key), leveldb::Slice(dev::bytesConstRef(&body[0], body.size())));
+    return Insert(ldb::Slice(key), ldb::Slice(dev::bytesConstRef(&body[0], body.size())));
 }
 
-int LevelDB::Insert(const leveldb::Slice & key, dev::bytesConstRef value)
+int LevelDB::Insert(const ldb::Slice & key, dev::bytesConstRef value)
 {
-    leveldb::Status s = m_db->Put(leveldb::WriteOptions(), key, ldb::Slice(value));
+    Metrics::Timer timer(GetWriteLatency());
+    ldb::Status s = MarkWritten(m_db->Put(GetWriteOptions(), key, ldb::Slice(value)));
     if (!s.ok())
     {
         return -1;
@@ -251,9 +463,10 @@ int LevelDB::Insert(const leveldb::Slice & key, dev::bytesConstRef value)
 
 int LevelDB::Insert(const dev::h256 & key, const string & value)
 {
-    leveldb::Status s = m_db->Put(leveldb::WriteOptions(),
-                                  ldb::Slice((char const*)key.data(), key.size),
-                                  ldb::Slice(value.data(), value.size()));
+    Metrics::Timer timer(GetWriteLatency());
+    ldb::Status s = MarkWritten(m_db->Put(GetWriteOptions(),
+                                          ldb::Slice((char const*)key.data(), key.size),
+                                          ldb::Slice(value.data(), value.size())));
     if (!s.ok())
     {
         return -1;
@@ -264,9 +477,10 @@ int LevelDB::Insert(const dev::h256 & key, const string & value)
 
 int LevelDB::Insert(const dev::h256 & key, const vector<unsigned char> & body)
 {
-    leveldb::Status s = m_db->Put(leveldb::WriteOptions(), leveldb::Slice(key.hex()),
-                                  leveldb::Slice(vector_ref<const unsigned char>(&body[0],
-                                                                                 body.size())));
+    Metrics::Timer timer(GetWriteLatency());
+    ldb::Status s = MarkWritten(m_db->Put(GetWriteOptions(), ldb::Slice(key.hex()),
+                                          ldb::Slice(vector_ref<const unsigned char>(&body[0],
+                                                                                     body.size()))));
     if (!s.ok())
     {
         return -1;
@@ -275,9 +489,10 @@ int LevelDB::Insert(const dev::h256 & key, const vector<unsigned char> & body)
     return 0;
 }
 
-int LevelDB::Insert(const leveldb::Slice & key, const leveldb::Slice & value)
+int LevelDB::Insert(const ldb::Slice & key, const ldb::Slice & value)
 {
-    leveldb::Status s = m_db->Put(leveldb::WriteOptions(), key, value);
+    Metrics::Timer timer(GetWriteLatency());
+    ldb::Status s = MarkWritten(m_db->Put(GetWriteOptions(), key, value));
     if (!s.ok())
     {
         return -1;
@@ -295,8 +510,8 @@ int LevelDB::BatchInsert(std::unordered_map<dev::h256, std::pair<std::string, un
     {
         if (i.second.second)
         {
-            batch.Put(leveldb::Slice(i.first.hex()),
-                      leveldb::Slice(i.second.first.data(), i.second.first.size()));
+            batch.Put(ldb::Slice(i.first.hex()),
+                      ldb::Slice(i.second.first.data(), i.second.first.size()));
         }
     }
 
@@ -310,7 +525,9 @@ int LevelDB::BatchInsert(std::unordered_map<dev::h256, std::pair<std::string, un
         }
     }
 
-    ldb::Status s = m_db->Write(leveldb::WriteOptions(), &batch);
+    Metrics::Timer timer(GetWriteLatency());
+
+    ldb::Status s = MarkWritten(m_db->Write(GetWriteOptions(), &batch));
 
     if (!s.ok())
     {
@@ -327,12 +544,14 @@ bool LevelDB::BatchInsert(const std::unordered_map<std::string, std::string>& kv
     for (const auto & i: kv_map)
     {
         if (!i.second.empty()) {
-            batch.Put(leveldb::Slice(i.first),
-                      leveldb::Slice(i.second));
+            batch.Put(ldb::Slice(i.first),
+                      ldb::Slice(i.second));
         }
     }
 
-    ldb::Status s = m_db->Write(leveldb::WriteOptions(), &batch);
+    Metrics::Timer timer(GetWriteLatency());
+
+    ldb::Status s = MarkWritten(m_db->Write(GetWriteOptions(), &batch));
 
     if (!s.ok())
     {
@@ -342,6 +561,19 @@ bool LevelDB::BatchInsert(const std::unordered_map<std::string, std::string>& kv
     return true;
 }
 
+int LevelDB::BatchInsert(ldb::WriteBatch& batch)
+{
+    Metrics::Timer timer(GetWriteLatency());
+    ldb::Status s = MarkWritten(m_db->Write(GetWriteOptions(), &batch));
+
+    if (!s.ok())
+    {
+        return -1;
+    }
+
+    return 0;
+}
+
 bool LevelDB::Exists(const dev::h256 & key) const
 {
     auto ret = Lookup(key);
@@ -362,7 +594,7 @@ bool LevelDB::Exists(const std::string & key) const
 
 int LevelDB::DeleteKey(const dev::h256 & key)
 {
-    leveldb::Status s = m_db->Delete(leveldb::WriteOptions(), ldb::Slice(key.hex()));
+    ldb::Status s = MarkWritten(m_db->Delete(GetWriteOptions(), ldb::Slice(key.hex())));
     if (!s.ok())
     {
         return -1;
@@ -373,7 +605,7 @@ int LevelDB::DeleteKey(const dev::h256 & key)
 
 int LevelDB::DeleteKey(const boost::multiprecision::uint256_t & blockNum)
 {
-    leveldb::Status s = m_db->Delete(leveldb::WriteOptions(), ldb::Slice(blockNum.convert_to<string>()));
+    ldb::Status s = MarkWritten(m_db->Delete(GetWriteOptions(), ldb::Slice(blockNum.convert_to<string>())));
     if (!s.ok())
     {
         return -1;
@@ -384,7 +616,7 @@ int LevelDB::DeleteKey(const boost::multiprecision::uint256_t & blockNum)
 
 int LevelDB::DeleteKey(const std::string & key)
 {
-    leveldb::Status s = m_db->Delete(leveldb::WriteOptions(), ldb::Slice(key));
+    ldb::Status s = MarkWritten(m_db->Delete(GetWriteOptions(), ldb::Slice(key)));
     if(!s.ok())
     {
         return -1;
@@ -421,13 +653,11 @@ bool LevelDB::RefreshDB()
 {
     m_db.reset();
 
-    leveldb::Options options;
-    options.max_open_files = 256;
-    options.create_if_missing = true;
+    ldb::Options options = GetOpenOptions();
 
-    leveldb::DB* db;
+    ldb::DB* db;
 
-    leveldb::Status status = leveldb::DB::Open(options, "./" + PERSISTENCE_PATH + "/" + this->m_dbName, &db);
+    ldb::Status status = ldb::DB::Open(options, "./" + PERSISTENCE_PATH + "/" + this->m_dbName, &db);
     if(!status.ok())
     {
         // throw exception();
@@ -442,9 +672,9 @@ bool LevelDB::RefreshDB()
 int LevelDB::DeleteDBForNormalNode()
 {
     m_db.reset();
-    leveldb::Status s = leveldb::DestroyDB("./" + PERSISTENCE_PATH +
+    ldb::Status s = ldb::DestroyDB("./" + PERSISTENCE_PATH +
         (this->m_subdirectory.size() ? "/" + this->m_subdirectory : "") + "/" + this->m_dbName,
-        leveldb::Options());
+        ldb::Options());
     if (!s.ok())
     {
         LOG_GENERAL(INFO, "[DeleteDB] Status: " << s.ToString());
@@ -465,13 +695,11 @@ bool LevelDB::ResetDBForNormalNode()
     {
         boost::filesystem::remove_all("./" + PERSISTENCE_PATH + "/" + this->m_dbName);
 
-        leveldb::Options options;
-        options.max_open_files = 256;
-        options.create_if_missing = true;
+        ldb::Options options = GetOpenOptions();
 
-        leveldb::DB* db;
+        ldb::DB* db;
 
-        leveldb::Status status = leveldb::DB::Open(options, "./" + PERSISTENCE_PATH + "/" + this->m_dbName, &db);
+        ldb::Status status = ldb::DB::Open(options, "./" + PERSISTENCE_PATH + "/" + this->m_dbName, &db);
         if(!status.ok())
         {
             // throw exception();
@@ -492,7 +720,7 @@ bool LevelDB::ResetDBForNormalNode()
 int LevelDB::DeleteDBForLookupNode()
 {
     m_db.reset();
-    leveldb::Status s = leveldb::DestroyDB(this->m_dbName, leveldb::Options());
+    ldb::Status s = ldb::DestroyDB(this->m_dbName, ldb::Options());
     if (!s.ok())
     {
         LOG_GENERAL(INFO, "[DeleteDB] Status: " << s.ToString());
@@ -509,13 +737,11 @@ bool LevelDB::ResetDBForLookupNode()
     {
         boost::filesystem::remove_all("./" + PERSISTENCE_PATH + "/" + this->m_dbName);
 
-        leveldb::Options options;
-        options.max_open_files = 256;
-        options.create_if_missing = true;
+        ldb::Options options = GetOpenOptions();
 
-        leveldb::DB* db;
+        ldb::DB* db;
 
-        leveldb::Status status = leveldb::DB::Open(options, "./" + PERSISTENCE_PATH + "/" + this->m_dbName, &db);
+        ldb::Status status = ldb::DB::Open(options, "./" + PERSISTENCE_PATH + "/" + this->m_dbName, &db);
         if(!status.ok())
         {
             // throw exception();
@@ -19,18 +19,31 @@
 #ifndef __LEVELDB_H__
 #define __LEVELDB_H__
 
+#include <atomic>
 #include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
 
-#include <leveldb/db.h>
+#include "depends/libDatabase/KVBackend.h"
 
 #include "depends/common/Common.h"
 #include "depends/common/FixedHash.h"
 //#include "libUtils/Logger.h"
 
-leveldb::Slice toSlice(boost::multiprecision::uint256_t num);
+ldb::Slice toSlice(boost::multiprecision::uint256_t num);
+
+/// How durable the writes to the databases are, set by DB_DURABILITY_MODE,
+/// or DB_DURABILITY_MODE_LOOKUP on lookups
+enum class DBDurability
+{
+    /// Left to the OS to write out, so a crash of the machine can lose them
+    ASYNC,
+    /// Synced to disk for all databases at once when an epoch is committed
+    EPOCH,
+    /// Synced to disk by each write
+    STRICT
+};
 
 /// Utility class for providing database-type storage.
 class LevelDB
@@ -39,7 +52,29 @@ class LevelDB
 
     std::string m_subdirectory;
 
-    std::shared_ptr<leveldb::DB> m_db;
+    // Owned here as leveldb only keeps pointers to them, so declared before
+    // m_db to outlive it
+    std::shared_ptr<ldb::Cache> m_blockCache;
+    std::shared_ptr<const ldb::FilterPolicy> m_filterPolicy;
+#ifdef USE_ROCKSDB
+    std::shared_ptr<ldb::RateLimiter> m_rateLimiter;
+#endif // USE_ROCKSDB
+
+    std::shared_ptr<ldb::DB> m_db;
+
+    /// Returns the options for opening this database, tuned by the storage
+    /// profile (LEVELDB_POINT_LOOKUP_DBS or LEVELDB_SEQUENTIAL_DBS) that lists
+    /// its name, or the leveldb defaults if neither does
+    ldb::Options GetOpenOptions();
+
+    /// Set by the writes that were not synced, and cleared by Sync
+    std::atomic<bool> m_unsynced;
+
+    /// Returns the options for a write, which is synced if STRICT
+    ldb::WriteOptions GetWriteOptions();
+
+    /// Wraps each write, to note that it was not synced unless STRICT
+    ldb::Status MarkWritten(const ldb::Status& status);
 
 public:
 
@@ -47,10 +82,20 @@ public:
     explicit LevelDB(const std::string & dbName, const std::string& subdirectory = "", bool diagnostic = false);
     explicit LevelDB(const std::string& dbName, const std::string& path, const std::string& subdirectory = "");
     /// Destructor.
-    ~LevelDB() = default;
+    ~LevelDB();
+
+    static DBDurability GetDurability();
+
+    /// Makes the writes to this database so far durable, if they were not
+    /// synced as they were made
+    bool Sync();
+
+    /// Syncs every open database, so that the writes of an epoch are durable
+    /// before it is marked as committed
+    static bool SyncAll();
 
     /// Returns the reference to the leveldb database instance.
-    std::shared_ptr<leveldb::DB> GetDB();
+    std::shared_ptr<ldb::DB> GetDB();
 
     /// Returns the DB Name
     std::string GetDBName();
@@ -85,7 +130,7 @@ public:
     int Insert(const std::string & key, const std::vector<unsigned char> & body);
 
     /// Sets the value at the specified key.
-    int Insert(const leveldb::Slice & key, dev::bytesConstRef value);
+    int Insert(const ldb::Slice & key, dev::bytesConstRef value);
 
     /// Sets the value at the specified key.
     int Insert(const dev::h256 & key, const std::string & value);
@@ -94,7 +139,7 @@ public:
     int Insert(const dev::h256 & key, const std::vector<unsigned char> & body);
 
     /// Sets the value at the specified key.
-    int Insert(const leveldb::Slice & key, const leveldb::Slice & value);
+    int Insert(const ldb::Slice & key, const ldb::Slice & value);
 
     /// Sets the value at the specified key for multiple such pairs.
     int BatchInsert(std::unordered_map<dev::h256, std::pair<std::string, unsigned>> & m_main,
@@ -102,6 +147,9 @@ public:
 
     bool BatchInsert(const std::unordered_map<std::string, std::string>& kv_map);
 
+    /// Applies all the writes in the batch at once.
+    int BatchInsert(ldb::WriteBatch& batch);
+
     /// Returns true if value corresponding to specified key exists.
     bool Exists(const dev::h256 & key) const;
     bool Exists(const boost::multiprecision::uint256_t & blockNum) const;
@@ -0,0 +1,88 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "NodeCache.h"
+
+using namespace std;
+
+namespace dev {
+
+NodeCache::NodeCache(unsigned int capacity)
+    : m_shardCapacity((capacity + NUM_SHARDS - 1) / NUM_SHARDS) {}
+
+NodeCache::Shard& NodeCache::ShardOf(h256 const& hash) {
+  // The key is already a hash, so any of its bytes spreads evenly
+  return m_shards[hash[0] % NUM_SHARDS];
+}
+
+bool NodeCache::Get(h256 const& hash, string& value) {
+  if (m_shardCapacity == 0) {
+    return false;
+  }
+
+  Shard& shard = ShardOf(hash);
+  {
+    lock_guard<mutex> g(shard.m_mutex);
+    auto it = shard.m_index.find(hash);
+    if (it != shard.m_index.end()) {
+      shard.m_lru.splice(shard.m_lru.begin(), shard.m_lru, it->second);
+      value = it->second->second;
+      m_hits++;
+      return true;
+    }
+  }
+
+  m_misses++;
+  return false;
+}
+
+void NodeCache::Put(h256 const& hash, string const& value) {
+  if (m_shardCapacity == 0 || value.empty()) {
+    return;
+  }
+
+  Shard& shard = ShardOf(hash);
+  lock_guard<mutex> g(shard.m_mutex);
+
+  auto it = shard.m_index.find(hash);
+  if (it != shard.m_index.end()) {
+    shard.m_lru.splice(shard.m_lru.begin(), shard.m_lru, it->second);
+    return;
+  }
+
+  if (shard.m_lru.size() >= m_shardCapacity) {
+    shard.m_index.erase(shard.m_lru.back().first);
+    shard.m_lru.pop_back();
+  }
+  shard.m_lru.emplace_front(hash, value);
+  shard.m_index.emplace(hash, shard.m_lru.begin());
+}
+
+void NodeCache::Clear() {
+  for (auto& shard : m_shards) {
+    lock_guard<mutex> g(shard.m_mutex);
+    shard.m_lru.clear();
+    shard.m_index.clear();
+  }
+}
+
+void NodeCache::ResetStats() {
+  m_hits = 0;
+  m_misses = 0;
+}
+
+}  // namespace dev
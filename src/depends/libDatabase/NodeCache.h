@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __NODECACHE_H__
+#define __NODECACHE_H__
+
+#include <array>
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+
+#include "depends/common/FixedHash.h"
+
+namespace dev {
+
+/// Bounded LRU cache of trie nodes read from or written to LevelDB, keyed by
+/// node hash. Nodes are content-addressed, so a cached entry never goes stale.
+/// Split into NUM_SHARDS independently locked LRU lists.
+class NodeCache {
+ public:
+  static constexpr unsigned int NUM_SHARDS = 16;
+
+  /// capacity is the total number of nodes held; 0 disables the cache
+  explicit NodeCache(unsigned int capacity);
+
+  /// Copies the node into value and marks it most recently used
+  bool Get(h256 const& hash, std::string& value);
+
+  void Put(h256 const& hash, std::string const& value);
+
+  void Clear();
+
+  uint64_t GetHits() const { return m_hits; }
+  uint64_t GetMisses() const { return m_misses; }
+  void ResetStats();
+
+ private:
+  struct Shard {
+    std::mutex m_mutex;
+    std::list<std::pair<h256, std::string>> m_lru;
+    std::unordered_map<h256,
+                       std::list<std::pair<h256, std::string>>::iterator>
+        m_index;
+  };
+
+  Shard& ShardOf(h256 const& hash);
+
+  const unsigned int m_shardCapacity;
+  std::array<Shard, NUM_SHARDS> m_shards;
+  std::atomic<uint64_t> m_hits{0};
+  std::atomic<uint64_t> m_misses{0};
+};
+
+}  // namespace dev
+
+#endif  // __NODECACHE_H__
@@ -24,6 +24,7 @@
 #include "depends/common/Common.h"
 #include "depends/common/SHA3.h"
 #include "OverlayDB.h"
+#include "libUtils/Logger.h"
 
 using namespace std;
 using namespace dev;
@@ -32,34 +33,77 @@ namespace dev
 {
 	h256 const EmptyTrie = sha3(rlp(""));
 
+	OverlayDB::~OverlayDB()
+	{
+		if (m_committing.valid())
+			m_committing.wait();
+	}
+
 	void OverlayDB::ResetDB()
 	{
+		waitCommitted();
 		m_levelDB.ResetDB();
+		m_nodeCache.Clear();
 	}
 
 	void OverlayDB::RefreshDB()
 	{
+		waitCommitted();
 		m_levelDB.RefreshDB();
+		m_nodeCache.Clear();
 	}
 
-	void OverlayDB::commit()
+	void OverlayDB::commit(std::function<void()> const& onWritten)
 	{
+		waitCommitted();
+
 	// #if DEV_GUARDED_DB
-	// 		DEV_READ_GUARDED(x_this)
+	// 		DEV_WRITE_GUARDED(x_this)
 	// #endif
 		{
-			shared_lock<shared_timed_mutex> lock(x_this);
-			m_levelDB.BatchInsert(m_main, m_aux);
+			unique_lock<shared_timed_mutex> lock(x_this);
+			m_frozenMain.swap(m_main);
+			m_frozenAux.swap(m_aux);
 		}
-			
-	// #if DEV_GUARDED_DB
-	// 		DEV_WRITE_GUARDED(x_this)
-	// #endif
+
+		if (m_nodeCache.GetHits() + m_nodeCache.GetMisses() > 0)
+		{
+			LOG_GENERAL(INFO, "Node cache hits = " << m_nodeCache.GetHits()
+						<< " misses = " << m_nodeCache.GetMisses());
+			m_nodeCache.ResetStats();
+		}
+
+		m_committing = std::async(std::launch::async, [this, onWritten]() { writeFrozen(onWritten); });
+	}
+
+	void OverlayDB::waitCommitted()
+	{
+		if (m_committing.valid())
+			m_committing.get();
+	}
+
+	void OverlayDB::writeFrozen(std::function<void()> const& onWritten)
+	{
+		// Only commit swaps the frozen overlay, and it waits for this first, so
+		// it is read here without the lock
+		const bool written = m_levelDB.BatchInsert(m_frozenMain, m_frozenAux) == 0;
+		if (written)
+		{
+			for (const auto& i: m_frozenMain)
+				if (i.second.second)
+					m_nodeCache.Put(i.first, i.second.first);
+		}
+		else
+			LOG_GENERAL(WARNING, "Failed to write " << m_frozenMain.size() << " trie nodes");
+
 		{
 			unique_lock<shared_timed_mutex> lock(x_this);
-			m_aux.clear();
-			m_main.clear();
+			m_frozenAux.clear();
+			m_frozenMain.clear();
 		}
+
+		if (written && onWritten)
+			onWritten();
 	}
 
 	bytes OverlayDB::lookupAux(h256 const& _h) const
@@ -68,6 +112,13 @@ namespace dev
 		if (!ret.empty())
 			return ret;
 
+		{
+			shared_lock<shared_timed_mutex> lock(x_this);
+			auto it = m_frozenAux.find(_h);
+			if (it != m_frozenAux.end() && it->second.second)
+				return it->second.first;
+		}
+
 		bytes b = _h.asBytes();
 		b.push_back(255);	// for aux
 
@@ -86,9 +137,12 @@ namespace dev
 	std::string OverlayDB::lookup(h256 const& _h) const
 	{
 		std::string ret = MemoryDB::lookup(_h);
-	
-		if (ret.empty())
+
+		if (ret.empty() && !lookupFrozen(_h, ret) && !m_nodeCache.Get(_h, ret))
+		{
 			ret = m_levelDB.Lookup(_h);
+			m_nodeCache.Put(_h, ret);
+		}
 	
 		return ret;
 	}
@@ -98,9 +152,23 @@ namespace dev
 		if (MemoryDB::exists(_h))
 			return true;
 
+		std::string value;
+		if (lookupFrozen(_h, value) || m_nodeCache.Get(_h, value))
+			return true;
+
 		return m_levelDB.Exists(_h);
 	}
 
+	bool OverlayDB::lookupFrozen(h256 const& _h, std::string& _value) const
+	{
+		shared_lock<shared_timed_mutex> lock(x_this);
+		auto it = m_frozenMain.find(_h);
+		if (it == m_frozenMain.end() || !it->second.second)
+			return false;
+		_value = it->second.first;
+		return true;
+	}
+
 	void OverlayDB::kill(h256 const& _h)
 	{
 		MemoryDB::kill(_h);
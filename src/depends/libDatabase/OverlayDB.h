@@ -19,6 +19,8 @@
 #ifndef __OVERLAYDB_H__
 #define __OVERLAYDB_H__
 
+#include <functional>
+#include <future>
 #include <memory>
 
 #include "common/Constants.h"
@@ -26,6 +28,7 @@
 #include "depends/common/RLP.h"
 #include "LevelDB.h"
 #include "MemoryDB.h"
+#include "NodeCache.h"
 
 namespace dev
 {
@@ -33,13 +36,19 @@ namespace dev
 	class OverlayDB: public MemoryDB
 	{
 	public:
-		explicit OverlayDB(const std::string & dbName): m_levelDB(dbName) {}
-		~OverlayDB() = default;
+		explicit OverlayDB(const std::string & dbName): m_levelDB(dbName), m_nodeCache(STATE_NODE_CACHE_SIZE) {}
+		~OverlayDB();
 
 		void ResetDB();
 		void RefreshDB();
 
-		void commit();
+		/// Freezes the overlay and writes it to LevelDB in one batch off the
+		/// calling thread, while new writes go to a fresh overlay. onWritten
+		/// runs once the batch is in, and not at all if it failed. A commit
+		/// first waits for the one before it.
+		void commit(std::function<void()> const& onWritten = {});
+		/// Waits for the batch of the last commit to be written
+		void waitCommitted();
 		void rollback();
 
 		std::string lookup(h256 const& _h) const;
@@ -51,7 +60,20 @@ namespace dev
 	private:
 		using MemoryDB::clear;
 
+		void writeFrozen(std::function<void()> const& onWritten);
+		bool lookupFrozen(h256 const& _h, std::string& _value) const;
+
 		LevelDB m_levelDB;
+
+		/// The overlay of the commit being written, still read until it is in
+		/// LevelDB. Guarded by x_this.
+		std::unordered_map<h256, std::pair<std::string, unsigned>> m_frozenMain;
+		std::unordered_map<h256, std::pair<bytes, bool>> m_frozenAux;
+		std::future<void> m_committing;
+
+		/// Recently read or committed nodes, so lookups of the upper trie levels
+		/// do not go to LevelDB every time
+		mutable NodeCache m_nodeCache;
 	};
 }
 
@@ -19,7 +19,12 @@
 #ifndef __TRIEDB_H__
 #define __TRIEDB_H__
 
+#include <algorithm>
+#include <atomic>
 #include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
 
 #include "depends/common/Exceptions.h"
 #include "depends/common/SHA3.h"
@@ -142,6 +147,12 @@ namespace dev
 
         void insert(bytesConstRef _key, bytesConstRef _value);
 
+        /// Inserts all of _kvs, with the same resulting root as inserting them in
+        /// order. The pairs are sorted by key and, once the root is a branch, the
+        /// subtries under each first nibble are updated on up to _numThreads
+        /// threads and the root is rebuilt from their new references.
+        void insertBatch(std::vector<std::pair<bytes, bytes>>& _kvs, unsigned _numThreads);
+
         void remove(bytes const& _key) { remove(&_key); }
         void remove(bytesConstRef _key);
 
@@ -868,6 +879,95 @@ namespace dev
         m_root = forceInsertNode(&b);
     }
 
+    template <class DB> void GenericTrieDB<DB>::insertBatch(std::vector<std::pair<bytes, bytes>>& _kvs, unsigned _numThreads)
+    {
+        // Sort by key, keeping only the last value given for each key
+        std::stable_sort(_kvs.begin(), _kvs.end(), [](std::pair<bytes, bytes> const& _a, std::pair<bytes, bytes> const& _b) { return _a.first < _b.first; });
+        std::vector<std::pair<bytes, bytes>> sorted;
+        sorted.reserve(_kvs.size());
+        for (auto& kv: _kvs)
+        {
+            if (!sorted.empty() && sorted.back().first == kv.first)
+                sorted.back().second = std::move(kv.second);
+            else
+                sorted.emplace_back(std::move(kv));
+        }
+        _kvs.clear();
+
+        // Until the root is a branch every insert reshapes it, so go one by one.
+        // An empty key would land in the root itself.
+        auto it = sorted.begin();
+        for (; it != sorted.end(); ++it)
+        {
+            if (_numThreads > 1 && !it->first.empty() && RLP(node(m_root)).itemCount() == 17)
+                break;
+            insert(&it->first, &it->second);
+        }
+        if (it == sorted.end())
+            return;
+        if (std::any_of(it, sorted.end(), [](std::pair<bytes, bytes> const& _kv) { return _kv.first.empty(); }))
+        {
+            for (; it != sorted.end(); ++it)
+                insert(&it->first, &it->second);
+            return;
+        }
+
+        std::string rootValue = node(m_root);
+        RLP root(rootValue);
+
+        // Keys are sorted, so each first nibble owns a contiguous range
+        std::vector<std::pair<size_t, size_t>> ranges(16, {0, 0});
+        std::vector<byte> nibbles;
+        for (size_t i = it - sorted.begin(); i < sorted.size(); ++i)
+        {
+            byte n = sorted[i].first[0] >> 4;
+            if (nibbles.empty() || nibbles.back() != n)
+            {
+                nibbles.push_back(n);
+                ranges[n].first = i;
+            }
+            ranges[n].second = i + 1;
+        }
+
+        // The new reference (hash or inlined node) for each updated child
+        std::vector<bytes> children(16);
+        std::atomic<size_t> next{0};
+        auto worker = [&]()
+        {
+            for (size_t j = next++; j < nibbles.size(); j = next++)
+            {
+                byte n = nibbles[j];
+                bytes child = root[n].data().toBytes();
+                for (size_t i = ranges[n].first; i < ranges[n].second; ++i)
+                {
+                    RLPStream s;
+                    mergeAtAux(s, RLP(child), NibbleSlice(&sorted[i].first).mid(1), &sorted[i].second);
+                    child = s.out();
+                }
+                children[n] = std::move(child);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        for (unsigned i = 1; i < std::min<size_t>(_numThreads, nibbles.size()); ++i)
+            threads.emplace_back(worker);
+        worker();
+        for (auto& t: threads)
+            t.join();
+
+        RLPStream r(17);
+        for (byte i = 0; i < 16; ++i)
+            if (children[i].empty())
+                r.append(root[i]);
+            else
+                r.appendRaw(children[i]);
+        r.append(root[16]);
+
+        forceKillNode(m_root);
+        bytes b = r.out();
+        m_root = forceInsertNode(&b);
+    }
+
     template <class DB> std::string GenericTrieDB<DB>::at(bytesConstRef _key) const
     {
         return atAux(RLP(node(m_root)), _key);
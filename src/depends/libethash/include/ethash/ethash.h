@@ -80,6 +80,29 @@ void ethash_destroy_epoch_context(struct ethash_epoch_context* context) NOEXCEPT
 
 void ethash_destroy_epoch_context_full(struct ethash_epoch_context_full* context) NOEXCEPT;
 
+/** Flags for ethash_set_full_dataset_alloc_flags(). */
+enum ethash_full_dataset_alloc_flags
+{
+    /** Ask the kernel to back the full dataset with transparent huge pages. */
+    ETHASH_ALLOC_TRANSPARENT_HUGE_PAGES = 1 << 0,
+    /** Map the full dataset from the reserved huge page pool, else fall back. */
+    ETHASH_ALLOC_EXPLICIT_HUGE_PAGES = 1 << 1,
+    /** Interleave the pages of the full dataset across all NUMA nodes. */
+    ETHASH_ALLOC_NUMA_INTERLEAVE = 1 << 2,
+};
+
+/**
+ * Sets how the full datasets of the contexts created later are allocated.
+ *
+ * The flags only take effect on Linux, and each one is best effort: the
+ * allocation falls back to ordinary pages and the default placement when
+ * the kernel does not support it. Without NUMA interleaving, pages are
+ * placed on the node of the thread that first writes them.
+ *
+ * @param flags  Bitwise OR of ethash_full_dataset_alloc_flags.
+ */
+void ethash_set_full_dataset_alloc_flags(int flags) NOEXCEPT;
+
 #ifdef __cplusplus
 }
 #endif
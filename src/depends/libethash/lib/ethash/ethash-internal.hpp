@@ -37,4 +37,8 @@ void build_light_cache(hash512 cache[], int num_items, const hash256& seed) noex
 
 hash1024 calculate_dataset_item(const epoch_context& context, uint32_t index) noexcept;
 
+/// Stores a computed item of the full dataset, safely for threads that read
+/// it concurrently with the lazy lookup of hash().
+void store_dataset_item(hash1024& item, const hash1024& computed) noexcept;
+
 }  // namespace ethash
@@ -9,11 +9,18 @@
 
 #include <ethash/keccak.hpp>
 
+#include <atomic>
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
 #include <limits>
 
+#if __linux__
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 #if __clang__
 #define ATTRIBUTE_NO_SANITIZE_UNSIGNED_INTEGER_OVERFLOW \
     __attribute__((no_sanitize("unsigned-integer-overflow")))
@@ -260,6 +267,15 @@ result hash(const epoch_context& context, const hash256& header_hash, uint64_t n
     return {hash_final(seed, mix_hash), mix_hash};
 }
 
+void store_dataset_item(hash1024& item, const hash1024& computed) noexcept
+{
+    // The first word goes last, so that a thread that sees it non-zero reads
+    // the whole item while other threads fill the dataset
+    std::memcpy(&item.words[1], &computed.words[1], sizeof(item) - sizeof(item.words[0]));
+    std::atomic_thread_fence(std::memory_order_release);
+    item.words[0] = computed.words[0];
+}
+
 result hash(const epoch_context_full& context, const hash256& header_hash, uint64_t nonce) noexcept
 {
     static const auto lazy_lookup = [](const epoch_context& context, uint32_t index) noexcept
@@ -268,10 +284,13 @@ result hash(const epoch_context_full& context, const hash256& header_hash, uint6
         hash1024& item = full_dataset[index];
         if (item.words[0] == 0)
         {
-            // TODO: Copy elision here makes it thread-safe?
-            item = calculate_dataset_item(context, index);
+            const hash1024 computed = calculate_dataset_item(context, index);
+            store_dataset_item(item, computed);
+            return computed;
         }
 
+        // Pairs with the release fence of store_dataset_item
+        std::atomic_thread_fence(std::memory_order_acquire);
         return item;
     };
 
@@ -361,6 +380,73 @@ int ethash_calculate_full_dataset_num_items(int epoch_number) noexcept
 
 namespace
 {
+std::atomic<int> full_dataset_alloc_flags{0};
+
+#if __linux__
+constexpr size_t huge_page_size = 2 * 1024 * 1024;
+constexpr int mpol_interleave = 3;
+
+size_t get_full_dataset_map_size(size_t num_items) noexcept
+{
+    const size_t size = num_items * sizeof(hash1024);
+    return (size + huge_page_size - 1) / huge_page_size * huge_page_size;
+}
+#endif
+
+/// Allocates zeroed memory for the full dataset, in the way set by
+/// ethash_set_full_dataset_alloc_flags().
+hash1024* allocate_full_dataset(size_t num_items) noexcept
+{
+#if __linux__
+    const int flags = full_dataset_alloc_flags.load();
+    const size_t size = get_full_dataset_map_size(num_items);
+    void* data = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+    if (flags & ETHASH_ALLOC_EXPLICIT_HUGE_PAGES)
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+            MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+
+    if (data == MAP_FAILED)
+    {
+        data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (data == MAP_FAILED)
+            return nullptr;
+
+#ifdef MADV_HUGEPAGE
+        if (flags & (ETHASH_ALLOC_TRANSPARENT_HUGE_PAGES | ETHASH_ALLOC_EXPLICIT_HUGE_PAGES))
+            madvise(data, size, MADV_HUGEPAGE);
+#endif
+    }
+
+#ifdef SYS_mbind
+    if (flags & ETHASH_ALLOC_NUMA_INTERLEAVE)
+    {
+        // The kernel narrows the mask to the nodes the process may use.
+        const unsigned long all_nodes = ~0UL;
+        syscall(SYS_mbind, data, size, mpol_interleave, &all_nodes,
+            sizeof(all_nodes) * 8 + 1, 0);
+    }
+#endif
+
+    return static_cast<hash1024*>(data);
+#else
+    return static_cast<hash1024*>(std::calloc(num_items, sizeof(hash1024)));
+#endif
+}
+
+void free_full_dataset(hash1024* full_dataset, size_t num_items) noexcept
+{
+#if __linux__
+    if (full_dataset)
+        munmap(full_dataset, get_full_dataset_map_size(num_items));
+#else
+    (void)num_items;
+    std::free(full_dataset);
+#endif
+}
+
 epoch_context_full* create_epoch_context(int epoch_number, bool full) noexcept
 {
     static_assert(sizeof(epoch_context_full) < sizeof(hash512), "epoch_context too big");
@@ -384,7 +470,7 @@ epoch_context_full* create_epoch_context(int epoch_number, bool full) noexcept
     {
         // TODO: This can be "optimized" by doing single allocation for light and full caches.
         const size_t num_items = static_cast<size_t>(full_dataset_num_items);
-        full_dataset = static_cast<hash1024*>(std::calloc(num_items, sizeof(hash1024)));
+        full_dataset = allocate_full_dataset(num_items);
         if (!full_dataset)
         {
             std::free(alloc_data);
@@ -415,7 +501,7 @@ epoch_context_full* ethash_create_epoch_context_full(int epoch_number) noexcept
 
 void ethash_destroy_epoch_context_full(epoch_context_full* context) noexcept
 {
-    std::free(context->full_dataset);
+    free_full_dataset(context->full_dataset, static_cast<size_t>(context->full_dataset_num_items));
     ethash_destroy_epoch_context(context);
 }
 
@@ -425,4 +511,9 @@ void ethash_destroy_epoch_context(epoch_context* context) noexcept
     std::free(context);
 }
 
+void ethash_set_full_dataset_alloc_flags(int flags) noexcept
+{
+    full_dataset_alloc_flags = flags;
+}
+
 }  // extern "C"
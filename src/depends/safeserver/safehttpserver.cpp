@@ -8,9 +8,19 @@
  ************************************************************************/
 
 #include "safehttpserver.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
 #include <cstdlib>
+#include <deque>
+#include <functional>
+#include <mutex>
 #include <sstream>
 #include <iostream>
+#include <thread>
+#include <vector>
 #include "jsonrpccpp/common/specificationparser.h"
 
 
@@ -25,6 +35,86 @@ struct mhd_coninfo {
         stringstream request;
         SafeHttpServer* server;
         int code;
+        // Set by the worker that answered the request, before it resumes the connection
+        bool handled;
+        string response;
+};
+
+/**
+ * Fixed set of threads answering queued requests in arrival order, with a bound on the requests waiting.
+ */
+class SafeHttpServer::RequestPool
+{
+    public:
+        RequestPool(unsigned int threads, unsigned int maxQueued, const function<void()>& threadInit) :
+            maxQueued(maxQueued), stopping(false)
+        {
+            for (unsigned int i = 0; i < threads; i++)
+            {
+                this->threads.emplace_back([this, threadInit] {
+                    if (threadInit)
+                    {
+                        threadInit();
+                    }
+                    this->Run();
+                });
+            }
+        }
+
+        // Answers the requests still queued before returning
+        ~RequestPool()
+        {
+            {
+                lock_guard<mutex> g(this->mutexJobs);
+                this->stopping = true;
+            }
+            this->cvJobs.notify_all();
+            for (auto& thread : this->threads)
+            {
+                thread.join();
+            }
+        }
+
+        bool TryAdd(function<void()> job)
+        {
+            {
+                lock_guard<mutex> g(this->mutexJobs);
+                if (this->jobs.size() >= this->maxQueued)
+                {
+                    return false;
+                }
+                this->jobs.emplace_back(move(job));
+            }
+            this->cvJobs.notify_one();
+            return true;
+        }
+
+    private:
+        void Run()
+        {
+            while (true)
+            {
+                function<void()> job;
+                {
+                    unique_lock<mutex> g(this->mutexJobs);
+                    this->cvJobs.wait(g, [this] { return this->stopping || !this->jobs.empty(); });
+                    if (this->jobs.empty())
+                    {
+                        return;
+                    }
+                    job = move(this->jobs.front());
+                    this->jobs.pop_front();
+                }
+                job();
+            }
+        }
+
+        const unsigned int maxQueued;
+        bool stopping;
+        mutex mutexJobs;
+        condition_variable cvJobs;
+        deque<function<void()>> jobs;
+        vector<thread> threads;
 };
 
 SafeHttpServer::SafeHttpServer(int port, const std::string &sslcert, const std::string &sslkey, int threads) :
@@ -34,8 +124,202 @@ SafeHttpServer::SafeHttpServer(int port, const std::string &sslcert, const std::
     running(false),
     path_sslcert(sslcert),
     path_sslkey(sslkey),
-    daemon(NULL)
+    daemon(NULL),
+    workers(0),
+    expensiveWorkers(0),
+    maxQueued(0),
+    connectionTimeout(0),
+    batchThreads(1)
+{
+}
+
+SafeHttpServer::~SafeHttpServer()
+{
+    this->StopListening();
+}
+
+void SafeHttpServer::SetRequestPools(unsigned int workers, unsigned int expensiveWorkers, unsigned int maxQueued,
+        const std::set<std::string>& expensiveMethods)
+{
+    this->workers = workers;
+    this->expensiveWorkers = expensiveWorkers;
+    this->maxQueued = maxQueued;
+    this->expensiveMethods = expensiveMethods;
+}
+
+void SafeHttpServer::SetConnectionTimeout(unsigned int seconds)
+{
+    this->connectionTimeout = seconds;
+}
+
+void SafeHttpServer::SetBatchThreads(unsigned int threads)
+{
+    this->batchThreads = std::max(threads, 1u);
+}
+
+void SafeHttpServer::SetAdmissionFilter(
+        const std::function<bool(const std::string&, const std::vector<std::string>&)>& filter)
+{
+    this->admissionFilter = filter;
+}
+
+void SafeHttpServer::SetThreadInit(const std::function<void()>& init)
+{
+    this->threadInit = init;
+}
+
+void SafeHttpServer::SetDirectHandler(const std::function<bool(const std::string&, std::string&)>& handler)
+{
+    this->directHandler = handler;
+}
+
+void SafeHttpServer::HandleCall(IClientConnectionHandler* handler, const std::string& call,
+        std::string& response) const
 {
+    if (this->directHandler && this->directHandler(call, response))
+    {
+        return;
+    }
+    handler->HandleRequest(call, response);
+}
+
+// Splits a batch into its calls and hands each to the handler on its own, so that the calls run in parallel.
+// Anything that is not a non-empty array goes to the handler as is, which also reports malformed requests.
+void SafeHttpServer::HandleRequest(IClientConnectionHandler* handler, const std::string& request,
+        std::string& response) const
+{
+    size_t first = request.find_first_not_of(" \t\r\n");
+    if (this->batchThreads <= 1 || first == string::npos || request[first] != '[')
+    {
+        HandleCall(handler, request, response);
+        return;
+    }
+
+    Json::Value batch;
+    string errors;
+    Json::CharReaderBuilder readerBuilder;
+    unique_ptr<Json::CharReader> reader(readerBuilder.newCharReader());
+    if (!reader->parse(request.c_str(), request.c_str() + request.size(), &batch, &errors) || !batch.isArray() ||
+            batch.empty())
+    {
+        handler->HandleRequest(request, response);
+        return;
+    }
+
+    Json::StreamWriterBuilder writerBuilder;
+    writerBuilder["indentation"] = "";
+    vector<string> calls(batch.size());
+    for (Json::ArrayIndex i = 0; i < batch.size(); i++)
+    {
+        calls[i] = Json::writeString(writerBuilder, batch[i]);
+    }
+
+    vector<string> results(calls.size());
+    atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t i = next++; i < calls.size(); i = next++)
+        {
+            try
+            {
+                HandleCall(handler, calls[i], results[i]);
+            }
+            catch (const Json::Exception& e)
+            {
+                results[i].clear();
+            }
+        }
+    };
+    vector<thread> workers;
+    for (size_t i = 1; i < std::min<size_t>(this->batchThreads, calls.size()); i++)
+    {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : workers)
+    {
+        t.join();
+    }
+
+    // Notifications have no response, so neither does a batch of only notifications
+    response.clear();
+    for (const auto& result : results)
+    {
+        size_t end = result.find_last_not_of(" \t\r\n");
+        if (end == string::npos)
+        {
+            continue;
+        }
+        response += response.empty() ? "[" : ",";
+        response.append(result, 0, end + 1);
+    }
+    if (!response.empty())
+    {
+        response += "]";
+    }
+}
+
+// Looks for the method names in the raw request rather than parsing it, the handler parses it anyway.
+std::vector<std::string> SafeHttpServer::GetMethods(const std::string& request)
+{
+    vector<string> methods;
+    const string key = "\"method\"";
+    for (size_t pos = request.find(key); pos != string::npos; pos = request.find(key, pos))
+    {
+        pos += key.size();
+        size_t begin = request.find_first_not_of(" \t\r\n:", pos);
+        if (begin == string::npos || request[begin] != '"')
+        {
+            continue;
+        }
+        size_t end = request.find('"', begin + 1);
+        if (end == string::npos)
+        {
+            break;
+        }
+        methods.emplace_back(request.substr(begin + 1, end - begin - 1));
+        pos = end;
+    }
+    return methods;
+}
+
+// A batch request goes to the expensive pool if any of its calls would.
+SafeHttpServer::RequestPool* SafeHttpServer::GetPool(const std::vector<std::string>& methods) const
+{
+    if (this->expensivePool == nullptr || this->expensiveMethods.empty())
+    {
+        return this->pool.get();
+    }
+
+    for (const auto& method : methods)
+    {
+        if (this->expensiveMethods.count(method) > 0)
+        {
+            return this->expensivePool.get();
+        }
+    }
+    return this->pool.get();
+}
+
+// The IP address of the client, empty if it cannot be told
+static string GetClientAddress(MHD_Connection* connection)
+{
+    const union MHD_ConnectionInfo* info = MHD_get_connection_info(connection, MHD_CONNECTION_INFO_CLIENT_ADDRESS);
+    if (info == NULL || info->client_addr == NULL)
+    {
+        return "";
+    }
+
+    char buf[INET6_ADDRSTRLEN] = {0};
+    const struct sockaddr* addr = info->client_addr;
+    if (addr->sa_family == AF_INET)
+    {
+        inet_ntop(AF_INET, &reinterpret_cast<const struct sockaddr_in*>(addr)->sin_addr, buf, sizeof(buf));
+    }
+    else if (addr->sa_family == AF_INET6)
+    {
+        inet_ntop(AF_INET6, &reinterpret_cast<const struct sockaddr_in6*>(addr)->sin6_addr, buf, sizeof(buf));
+    }
+    return buf;
 }
 
 IClientConnectionHandler *SafeHttpServer::GetHandler(const std::string &url)
@@ -52,25 +336,45 @@ bool SafeHttpServer::StartListening()
 {
     if(!this->running)
     {
+        unsigned int flags = MHD_USE_SELECT_INTERNALLY;
+        if (this->workers > 0)
+        {
+            flags |= MHD_USE_SUSPEND_RESUME;
+            this->pool.reset(new RequestPool(this->workers, this->maxQueued, this->threadInit));
+            if (this->expensiveWorkers > 0)
+            {
+                this->expensivePool.reset(new RequestPool(this->expensiveWorkers, this->maxQueued, this->threadInit));
+            }
+        }
+
         if (this->path_sslcert != "" && this->path_sslkey != "")
         {
             try {
                 SpecificationParser::GetFileContent(this->path_sslcert, this->sslcert);
                 SpecificationParser::GetFileContent(this->path_sslkey, this->sslkey);
 
-                this->daemon = MHD_start_daemon(MHD_USE_SSL | MHD_USE_SELECT_INTERNALLY, this->port, NULL, NULL, SafeHttpServer::callback, this, MHD_OPTION_HTTPS_MEM_KEY, this->sslkey.c_str(), MHD_OPTION_HTTPS_MEM_CERT, this->sslcert.c_str(), MHD_OPTION_THREAD_POOL_SIZE, this->threads, MHD_OPTION_END);
+                this->daemon = MHD_start_daemon(MHD_USE_SSL | flags, this->port, NULL, NULL, SafeHttpServer::callback, this, MHD_OPTION_HTTPS_MEM_KEY, this->sslkey.c_str(), MHD_OPTION_HTTPS_MEM_CERT, this->sslcert.c_str(), MHD_OPTION_THREAD_POOL_SIZE, this->threads, MHD_OPTION_CONNECTION_TIMEOUT, this->connectionTimeout, MHD_OPTION_END);
             }
             catch (JsonRpcException& ex)
             {
+                this->pool.reset();
+                this->expensivePool.reset();
                 return false;
             }
         }
         else
         {
-            this->daemon = MHD_start_daemon(MHD_USE_SELECT_INTERNALLY, this->port, NULL, NULL, SafeHttpServer::callback, this,   MHD_OPTION_THREAD_POOL_SIZE, this->threads, MHD_OPTION_END);
+            this->daemon = MHD_start_daemon(flags, this->port, NULL, NULL, SafeHttpServer::callback, this,   MHD_OPTION_THREAD_POOL_SIZE, this->threads, MHD_OPTION_CONNECTION_TIMEOUT, this->connectionTimeout, MHD_OPTION_END);
         }
         if (this->daemon != NULL)
+        {
             this->running = true;
+        }
+        else
+        {
+            this->pool.reset();
+            this->expensivePool.reset();
+        }
 
     }
     return this->running;
@@ -80,6 +384,9 @@ bool SafeHttpServer::StopListening()
 {
     if(this->running)
     {
+        // Answer the queued requests first, their suspended connections must be resumed before the daemon stops
+        this->pool.reset();
+        this->expensivePool.reset();
         MHD_stop_daemon(this->daemon);
         this->running = false;
     }
@@ -128,6 +435,7 @@ int SafeHttpServer::callback(void *cls, MHD_Connection *connection, const char *
         struct mhd_coninfo* client_connection = new mhd_coninfo;
         client_connection->connection = connection;
         client_connection->server = static_cast<SafeHttpServer*>(cls);
+        client_connection->handled = false;
         *con_cls = client_connection;
         return MHD_YES;
     }
@@ -150,10 +458,54 @@ int SafeHttpServer::callback(void *cls, MHD_Connection *connection, const char *
                 client_connection->code = MHD_HTTP_INTERNAL_SERVER_ERROR;
                 client_connection->server->SendResponse("No client conneciton handler found", client_connection);
             }
+            else if (client_connection->handled)
+            {
+                // Called again after a worker answered the request and resumed the connection
+                client_connection->server->SendResponse(client_connection->response, client_connection);
+            }
+            else if (client_connection->server->admissionFilter &&
+                    !client_connection->server->admissionFilter(GetClientAddress(connection),
+                            GetMethods(client_connection->request.str())))
+            {
+                client_connection->code = MHD_HTTP_TOO_MANY_REQUESTS;
+                client_connection->server->SendResponse("Too many requests", client_connection);
+            }
+            else if (client_connection->server->pool != nullptr)
+            {
+                client_connection->code = MHD_HTTP_OK;
+                RequestPool* pool =
+                        client_connection->server->GetPool(GetMethods(client_connection->request.str()));
+
+                // Suspend before queueing, so that the worker cannot resume the connection first
+                MHD_suspend_connection(connection);
+                bool queued = pool->TryAdd([client_connection, handler]() {
+                    try
+                    {
+                        client_connection->server->HandleRequest(handler, client_connection->request.str(),
+                                client_connection->response);
+                    }
+                    catch (const Json::Exception& e)
+                    {
+                        client_connection->code = MHD_HTTP_INTERNAL_SERVER_ERROR;
+                        client_connection->response = "Exception while reading Json ";
+                    }
+                    client_connection->handled = true;
+                    MHD_resume_connection(client_connection->connection);
+                });
+                if (!queued)
+                {
+                    client_connection->code = MHD_HTTP_SERVICE_UNAVAILABLE;
+                    client_connection->response = "Too many requests queued";
+                    client_connection->handled = true;
+                    MHD_resume_connection(connection);
+                }
+                // Answered once the connection is resumed
+                return MHD_YES;
+            }
             else
             {
                 client_connection->code = MHD_HTTP_OK;
-                handler->HandleRequest(client_connection->request.str(), response);
+                client_connection->server->HandleCall(handler, client_connection->request.str(), response);
                 client_connection->server->SendResponse(response, client_connection);
             }
         }
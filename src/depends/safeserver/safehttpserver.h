@@ -25,7 +25,12 @@ typedef intptr_t ssize_t;
 #include <sys/socket.h>
 #endif
 
+#include <functional>
 #include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <vector>
 #include <microhttpd.h>
 #include "jsonrpccpp/server/abstractserverconnector.h"
 
@@ -48,6 +53,47 @@ namespace jsonrpc
              * @param sslcert - defines the path to a SSL certificate, if this path is != "", then SSL/HTTPS is used with the given certificate.
              */
             SafeHttpServer(int port, const std::string& sslcert = "", const std::string& sslkey = "", int threads = 50);
+            ~SafeHttpServer();
+
+            /**
+             * @brief Answers requests on worker pools instead of on the connection threads, from the next StartListening.
+             * Requests calling one of expensiveMethods go to a pool of their own, so they cannot hold up the others.
+             * A request finding maxQueued requests already waiting in its pool is answered with HTTP 503.
+             * @param workers - size of the pool for other requests, 0 answers requests on the connection threads
+             */
+            void SetRequestPools(unsigned int workers, unsigned int expensiveWorkers, unsigned int maxQueued,
+                    const std::set<std::string>& expensiveMethods);
+
+            /**
+             * @brief Closes connections, kept alive ones included, that stay idle for longer than seconds (0 never closes them)
+             */
+            void SetConnectionTimeout(unsigned int seconds);
+
+            /**
+             * @brief Runs the calls of a batch request on up to threads threads, for servers with request pools.
+             * The responses keep the order of the calls. 1 runs the calls one after another.
+             */
+            void SetBatchThreads(unsigned int threads);
+
+            /**
+             * @brief Turns away the requests that filter returns false for with HTTP 429, before they are queued.
+             * The filter gets the client IP address and the methods the request calls.
+             */
+            void SetAdmissionFilter(
+                    const std::function<bool(const std::string&, const std::vector<std::string>&)>& filter);
+
+            /**
+             * @brief Runs init first on each thread of the request pools, e.g. to set its affinity.
+             * Only takes effect for pools started afterwards.
+             */
+            void SetThreadInit(const std::function<void()>& init);
+
+            /**
+             * @brief Offers each call to handler before the connection handler, which answers it when handler
+             * returns false. handler writes the whole response of the calls it answers itself, e.g. to render
+             * large results straight to text.
+             */
+            void SetDirectHandler(const std::function<bool(const std::string&, std::string&)>& handler);
 
             virtual bool StartListening();
             virtual bool StopListening();
@@ -59,6 +105,8 @@ namespace jsonrpc
             void SetUrlHandler(const std::string &url, IClientConnectionHandler *handler);
 
         private:
+            class RequestPool;
+
             int port;
             int threads;
             bool running;
@@ -71,6 +119,29 @@ namespace jsonrpc
 
             std::map<std::string, IClientConnectionHandler*> urlhandler;
 
+            unsigned int workers;
+            unsigned int expensiveWorkers;
+            unsigned int maxQueued;
+            unsigned int connectionTimeout;
+            unsigned int batchThreads;
+            std::set<std::string> expensiveMethods;
+            std::unique_ptr<RequestPool> pool;
+            std::unique_ptr<RequestPool> expensivePool;
+            std::function<bool(const std::string&, const std::vector<std::string>&)> admissionFilter;
+            std::function<void()> threadInit;
+            std::function<bool(const std::string&, std::string&)> directHandler;
+
+            // The method names in a request, or in the calls of a batch request
+            static std::vector<std::string> GetMethods(const std::string& request);
+
+            RequestPool* GetPool(const std::vector<std::string>& methods) const;
+
+            void HandleRequest(IClientConnectionHandler* handler, const std::string& request,
+                    std::string& response) const;
+
+            // A single call, answered by directHandler if it takes it
+            void HandleCall(IClientConnectionHandler* handler, const std::string& call, std::string& response) const;
+
             static int callback(void *cls, struct MHD_Connection *connection, const char *url, const char *method, const char *version, const char *upload_data, size_t *upload_data_size, void **con_cls);
 
             IClientConnectionHandler* GetHandler(const std::string &url);
@@ -15,134 +15,145 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <map>
 #include <string>
-#include <unordered_map>
 #include <vector>
 
 #include "libPersistence/BlockStorage.h"
 
-std::string getCsvHeader(uint64_t start, uint64_t stop) {
-  std::string ret = "Node";
+/// Where a node was in a DS epoch, kept small as there is one per node per
+/// epoch
+struct Assignment {
+  enum : uint32_t { NOT_SHARDED = 0, DS_COMMITTEE, FIRST_SHARD };
+
+  uint32_t role = NOT_SHARDED;  // FIRST_SHARD + shard index for shard nodes
+  uint32_t index = 0;
+};
+
+typedef std::map<std::string, std::vector<Assignment>> Results;
+
+void writeCsvHeader(std::ostream& out, uint64_t start, uint64_t stop) {
+  out << "Node";
 
   for (uint64_t i = start; i <= stop; ++i) {
-    ret += ",DS epoch " + std::to_string(i);
+    out << ",DS epoch " << i;
   }
 
-  return ret;
+  out << "\n";
+}
+
+void assign(Results& results, const std::string& ip, size_t numEpochs,
+            size_t column, uint32_t role, uint32_t index) {
+  auto& row = results[ip];
+  if (row.empty()) {
+    row.resize(numEpochs);
+  }
+  row[column] = {role, index};
 }
 
-void processShards(
-    const DequeOfShard& shards,
-    std::map<std::string, std::map<uint64_t, std::string>>& results,
-    uint64_t dsEpochNo) {
-  uint64_t shardIndex = 0;
+void processShards(const DequeOfShard& shards, Results& results,
+                   size_t numEpochs, size_t column) {
+  uint32_t shardIndex = 0;
 
   for (auto shardItr = shards.begin(); shardItr != shards.end();
        ++shardItr, ++shardIndex) {
     for (size_t peerIndex = 0; peerIndex < shardItr->size(); ++peerIndex) {
       // get the peer and convert to ip.
-      Peer peer = std::get<1>((*shardItr)[peerIndex]);
-      std::string ip = peer.GetPrintableIPAddress();
-
-      if (results.find(ip) == results.end()) {
-        results[ip] = std::map<uint64_t, std::string>();
-      }
-
-      results[ip][dsEpochNo] = "Shard " + std::to_string(shardIndex) +
-                               " Index " + std::to_string(peerIndex);
+      const Peer& peer = std::get<1>((*shardItr)[peerIndex]);
+      assign(results, peer.GetPrintableIPAddress(), numEpochs, column,
+             Assignment::FIRST_SHARD + shardIndex, peerIndex);
     }
   }
 }
 
-void processDSCommittee(
-    const DequeOfNode& dsCommittee,
-    std::map<std::string, std::map<uint64_t, std::string>>& results,
-    uint64_t dsEpochNo) {
-  uint64_t dsCommitteeIndex = 0;
+void processDSCommittee(const DequeOfNode& dsCommittee, Results& results,
+                        size_t numEpochs, size_t column) {
+  uint32_t dsCommitteeIndex = 0;
 
   for (auto peerItr = dsCommittee.begin(); peerItr != dsCommittee.end();
        ++peerItr, ++dsCommitteeIndex) {
     // get the peer and convert to ip.
-    Peer peer = std::get<1>(*peerItr);
-    std::string ip = peer.GetPrintableIPAddress();
-
-    if (results.find(ip) == results.end()) {
-      results[ip] = std::map<uint64_t, std::string>();
-    }
-
-    results[ip][dsEpochNo] = "DS Index " + std::to_string(dsCommitteeIndex);
+    const Peer& peer = std::get<1>(*peerItr);
+    assign(results, peer.GetPrintableIPAddress(), numEpochs, column,
+           Assignment::DS_COMMITTEE, dsCommitteeIndex);
   }
 }
 
-void processResults(
-    std::map<std::string, std::map<uint64_t, std::string>>& results,
-    std::string& output, uint64_t blockStart, uint64_t blockStop) {
-  output = getCsvHeader(blockStart, blockStop) + "\n";
-
-  for (auto const& it : results) {
-    std::string ip = it.first;
-
-    std::string row = ip + ",";
-    for (uint64_t block = blockStart; block < blockStop; ++block) {
-      if (results[ip].find(block) != results[ip].end()) {
-        row += results[ip][block] + ",";
-      } else {
-        row += "Not sharded,";
-      }
-    }
-    // Last block.
-    if (results[ip].find(blockStop) != results[ip].end()) {
-      row += results[ip][blockStop];
-    } else {
-      row += "Not sharded";
-    }
-
-    output += row + "\n";
+void writeAssignment(std::ostream& out, const Assignment& assignment) {
+  switch (assignment.role) {
+    case Assignment::NOT_SHARDED:
+      out << "Not sharded";
+      break;
+    case Assignment::DS_COMMITTEE:
+      out << "DS Index " << assignment.index;
+      break;
+    default:
+      out << "Shard " << assignment.role - Assignment::FIRST_SHARD << " Index "
+          << assignment.index;
   }
 }
 
 int main(int argc, char** argv) {
   if (argc < 2) {
-    std::cout << "[USAGE] " << argv[0] << " <output csv filename> [db path]"
+    std::cout << "[USAGE] " << argv[0]
+              << " <output csv filename> [db path] [first DS block] [last DS "
+                 "block]"
               << std::endl;
     return -1;
   }
 
   std::string path = "./";
-  if (argc == 3) {
+  if (argc >= 3) {
     path = std::string(argv[2]);
     path += (path.back() == '/' ? "" : "/");
   }
 
   BlockStorage& bs = BlockStorage::GetBlockStorage(path, true);
 
-  std::map<uint64_t, DiagnosticDataNodes> diagnosticDataMap =
-      std::map<uint64_t, DiagnosticDataNodes>();
-  bs.GetDiagnosticDataNodes(diagnosticDataMap);
-  if (diagnosticDataMap.empty()) {
+  uint64_t first, last;
+  if (!bs.GetDiagnosticDataNodesRange(first, last)) {
     std::cout << "Nothing to read in the Diagnostic DB" << std::endl;
     return 0;
   }
-
-  size_t blockCount = diagnosticDataMap.size();
-  uint64_t blockStart = diagnosticDataMap.begin()->first;
-
-  std::map<std::string, std::map<uint64_t, std::string>> results =
-      std::map<std::string, std::map<uint64_t, std::string>>();
-  for (auto const& it : diagnosticDataMap) {
-    uint64_t dsEpochNo = it.first;
-    processShards(it.second.shards, results, dsEpochNo);
-    processDSCommittee(it.second.dsCommittee, results, dsEpochNo);
+  if (argc >= 4) {
+    first = std::max<uint64_t>(first, std::stoull(argv[3]));
+  }
+  if (argc >= 5) {
+    last = std::min<uint64_t>(last, std::stoull(argv[4]));
+  }
+  if (first > last) {
+    std::cout << "Nothing to read in the requested range" << std::endl;
+    return 0;
   }
 
-  std::string output;
-  processResults(results, output, blockStart, blockStart + blockCount);
-
-  // Write to csv file.
+  // The entries are read one at a time, and only where each node was is
+  // kept, as a row of the csv needs every epoch
+  const size_t numEpochs = last - first + 1;
+  Results results;
+  bs.ForEachDiagnosticDataNodes(
+      first, last,
+      [&results, first, numEpochs](uint64_t dsEpochNo,
+                                   const DiagnosticDataNodes& entry) {
+        processShards(entry.shards, results, numEpochs, dsEpochNo - first);
+        processDSCommittee(entry.dsCommittee, results, numEpochs,
+                           dsEpochNo - first);
+        return true;
+      });
+
+  // Write to csv file, a row at a time
   std::ofstream out(argv[1]);
-  out << output;
+  writeCsvHeader(out, first, last);
+  for (const auto& it : results) {
+    out << it.first;
+    for (const auto& assignment : it.second) {
+      out << ",";
+      writeAssignment(out, assignment);
+    }
+    out << "\n";
+  }
   out.close();
 
   return 0;
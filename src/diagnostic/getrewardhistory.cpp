@@ -15,11 +15,10 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <fstream>
 #include <iostream>
-#include <map>
 #include <string>
-#include <unordered_map>
-#include <vector>
 
 #include "libPersistence/BlockStorage.h"
 
@@ -33,40 +32,48 @@ std::string getCsvHeader() {
 
 int main(int argc, char** argv) {
   if (argc < 2) {
-    std::cout << "[USAGE] " << argv[0] << " <output csv filename> [db path]"
+    std::cout << "[USAGE] " << argv[0]
+              << " <output csv filename> [db path] [first DS block] [last DS "
+                 "block]"
               << std::endl;
     return -1;
   }
 
   std::string path = "./";
-  if (argc == 3) {
+  if (argc >= 3) {
     path = std::string(argv[2]);
     path += (path.back() == '/' ? "" : "/");
   }
 
   BlockStorage& bs = BlockStorage::GetBlockStorage(path, true);
 
-  std::map<uint64_t, DiagnosticDataCoinbase> diagnosticDataMap =
-      std::map<uint64_t, DiagnosticDataCoinbase>();
-  bs.GetDiagnosticDataCoinbase(diagnosticDataMap);
-  if (diagnosticDataMap.empty()) {
+  uint64_t first, last;
+  if (!bs.GetDiagnosticDataCoinbaseRange(first, last)) {
     std::cout << "Nothing to read in the Diagnostic DB" << std::endl;
     return 0;
   }
+  if (argc >= 4) {
+    first = std::max<uint64_t>(first, std::stoull(argv[3]));
+  }
+  if (argc >= 5) {
+    last = std::min<uint64_t>(last, std::stoull(argv[4]));
+  }
 
-  // Write to csv file.
+  // Write to csv file, a row per entry as it is read
   std::ofstream out(argv[1]);
-  out << getCsvHeader() << std::endl;
-  for (auto const& it : diagnosticDataMap) {
-    auto const& entry = it.second;
-    out << it.first << "," << entry.nodeCount << "," << entry.sigCount << ","
-        << entry.lookupCount << "," << entry.totalReward << ","
-        << entry.baseReward << "," << entry.baseRewardEach << ","
-        << entry.lookupReward << "," << entry.rewardEachLookup << ","
-        << entry.nodeReward << "," << entry.rewardEach << ","
-        << entry.balanceLeft << "," << entry.luckyDrawWinnerKey << ","
-        << entry.luckyDrawWinnerAddr << std::endl;
-  }
+  out << getCsvHeader() << "\n";
+  bs.ForEachDiagnosticDataCoinbase(
+      first, last,
+      [&out](uint64_t dsBlockNum, const DiagnosticDataCoinbase& entry) {
+        out << dsBlockNum << "," << entry.nodeCount << "," << entry.sigCount
+            << "," << entry.lookupCount << "," << entry.totalReward << ","
+            << entry.baseReward << "," << entry.baseRewardEach << ","
+            << entry.lookupReward << "," << entry.rewardEachLookup << ","
+            << entry.nodeReward << "," << entry.rewardEach << ","
+            << entry.balanceLeft << "," << entry.luckyDrawWinnerKey << ","
+            << entry.luckyDrawWinnerAddr << "\n";
+        return true;
+      });
 
   out.close();
 
@@ -115,17 +115,16 @@ bool ConsensusCommon::VerifyMessage(const bytes& msg, unsigned int offset,
   return result;
 }
 
-PubKey ConsensusCommon::AggregateKeys(const vector<bool>& peer_map) {
+PubKey ConsensusCommon::AggregateKeys(const BitVector& peer_map) {
   LOG_MARKER();
 
   vector<PubKey> keys;
+  keys.reserve(peer_map.size());
   DequeOfNode::const_iterator j = m_committee.begin();
   for (unsigned int i = 0; i < peer_map.size(); i++, j++) {
-    if (peer_map.at(i)) {
-      keys.emplace_back(j->first);
-    }
+    keys.emplace_back(j->first);
   }
-  shared_ptr<PubKey> result = MultiSig::AggregatePubKeys(keys);
+  shared_ptr<PubKey> result = MultiSig::AggregatePubKeys(keys, peer_map);
   if (result == nullptr) {
     return PubKey();
   }
@@ -247,6 +246,24 @@ bool ConsensusCommon::PreProcessMessage(const bytes& message,
   return false;
 }
 
+bool ConsensusCommon::IsForBlockOrLater(const bytes& message,
+                                        const unsigned int offset,
+                                        uint64_t blockNumber) {
+  if (message.size() <= offset) {
+    LOG_GENERAL(WARNING,
+                "Msg offset " << offset << " >= size " << message.size());
+    return false;
+  }
+
+  uint64_t messageBlockNumber = 0;
+  if (!Messenger::PeekConsensusBlockNumber(message, offset + 1,
+                                           messageBlockNumber)) {
+    return false;
+  }
+
+  return messageBlockNumber >= blockNumber;
+}
+
 ConsensusCommon::ConsensusErrorCode ConsensusCommon::GetConsensusErrorCode()
     const {
   return m_consensusErrorCode;
@@ -277,7 +294,7 @@ const Signature& ConsensusCommon::GetCS1() const {
   return m_CS1;
 }
 
-const vector<bool>& ConsensusCommon::GetB1() const {
+const BitVector& ConsensusCommon::GetB1() const {
   if (m_state != DONE) {
     LOG_GENERAL(WARNING, "GetB1 called before DONE");
   }
@@ -293,7 +310,7 @@ const Signature& ConsensusCommon::GetCS2() const {
   return m_CS2;
 }
 
-const vector<bool>& ConsensusCommon::GetB2() const {
+const BitVector& ConsensusCommon::GetB2() const {
   if (m_state != DONE) {
     LOG_GENERAL(WARNING, "GetB2 called before DONE");
   }
@@ -27,6 +27,7 @@
 
 #include "libCrypto/MultiSig.h"
 #include "libNetwork/ShardStruct.h"
+#include "libUtils/BitVector.h"
 #include "libUtils/TimeLockedFunction.h"
 
 struct ChallengeSubsetInfo {
@@ -143,19 +144,19 @@ class ConsensusCommon {
   Signature m_collectiveSig;
 
   /// Response map for the generated collective signature
-  std::vector<bool> m_responseMap;
+  BitVector m_responseMap;
 
   /// Co-sig for first round
   Signature m_CS1;
 
   /// Co-sig bitmap for first round
-  std::vector<bool> m_B1;
+  BitVector m_B1;
 
   /// Co-sig for second round
   Signature m_CS2;
 
   /// Co-sig bitmap for second round
-  std::vector<bool> m_B2;
+  BitVector m_B2;
 
   /// Generated commit secret
   std::shared_ptr<CommitSecret> m_commitSecret;
@@ -181,7 +182,7 @@ class ConsensusCommon {
                      const Signature& toverify, uint16_t peer_id);
 
   /// Aggregates public keys according to the response map.
-  PubKey AggregateKeys(const std::vector<bool>& peer_map);
+  PubKey AggregateKeys(const BitVector& peer_map);
 
   /// Aggregates the list of received commits.
   CommitPoint AggregateCommits(const std::vector<CommitPoint>& commits);
@@ -219,6 +220,11 @@ class ConsensusCommon {
                          uint32_t& consensusID, PubKey& senderPubKey,
                          bytes& reserializedMessage) const;
 
+  /// Cheap check, without the signature, that the consensus message at
+  /// offset is for blockNumber or later. False for malformed messages too.
+  static bool IsForBlockOrLater(const bytes& message, const unsigned int offset,
+                                uint64_t blockNumber);
+
   /// Returns the consensus error code
   ConsensusErrorCode GetConsensusErrorCode() const;
 
@@ -235,13 +241,13 @@ class ConsensusCommon {
   const Signature& GetCS1() const;
 
   /// Returns the co-sig bitmap for first round
-  const std::vector<bool>& GetB1() const;
+  const BitVector& GetB1() const;
 
   /// Returns the co-sig for second round
   const Signature& GetCS2() const;
 
   /// Returns the co-sig bitmap for second round
-  const std::vector<bool>& GetB2() const;
+  const BitVector& GetB2() const;
 
   /// Returns the fraction of the shard required to achieve consensus
   static unsigned int NumForConsensus(unsigned int shardSize);
@@ -15,6 +15,8 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+
 #include "ConsensusLeader.h"
 #include "common/Constants.h"
 #include "common/Messages.h"
@@ -101,6 +103,16 @@ void ConsensusLeader::SetStateSubset(uint16_t subsetID, State newState) {
 void ConsensusLeader::GenerateConsensusSubsets() {
   LOG_MARKER();
 
+  const ConsensusStats::Phase commitPhase = (m_state == ANNOUNCE_DONE)
+                                                ? ConsensusStats::COMMIT
+                                                : ConsensusStats::FINALCOMMIT;
+  RecordPhase(commitPhase, m_phaseStart);
+  if (ENABLE_CONSENSUS_STATS) {
+    ConsensusStats::GetInstance().RecordMissing(
+        m_DS, commitPhase, 0, m_committee.size() - m_commitCounter);
+  }
+  m_phaseStart = ConsensusStats::TimePoint::clock::now();
+
   // Get the list of all the peers who committed, by peer index
   vector<unsigned int> peersWhoCommitted;
   for (unsigned int index = 0; index < m_commitMap.size(); index++) {
@@ -118,19 +130,34 @@ void ConsensusLeader::GenerateConsensusSubsets() {
   LOG_GENERAL(INFO, "m_numForConsensus = " << m_numForConsensus);
   LOG_GENERAL(INFO, "numSubsets        = " << numSubsets);
 
+  // The first subset not restricted to ds guards gets the backups that have
+  // been quickest to commit, so that subset is likely to finish first
+  const unsigned int fastSubset = (m_DS && GUARD_MODE) ? 1 : 0;
+  if (ENABLE_ADAPTIVE_CONSENSUS_SUBSETS) {
+    vector<uint64_t> latencies(m_committee.size(), 0);
+    for (auto index : peersWhoCommitted) {
+      latencies.at(index) = ConsensusStats::GetInstance().GetCommitLatency(
+          m_committee.at(index).first);
+    }
+    stable_sort(peersWhoCommitted.begin(), peersWhoCommitted.end(),
+                [&latencies](unsigned int a, unsigned int b) {
+                  return latencies.at(a) < latencies.at(b);
+                });
+  }
+
   m_consensusSubsets.clear();
   m_consensusSubsets.resize(numSubsets);
 
   for (unsigned int i = 0; i < numSubsets; i++) {
     ConsensusSubset& subset = m_consensusSubsets.at(i);
     subset.commitMap.resize(m_committee.size());
-    fill(subset.commitMap.begin(), subset.commitMap.end(), false);
+    subset.commitMap.Fill(false);
     subset.commitPointMap.resize(m_committee.size());
     subset.commitPoints.clear();
     subset.responseCounter = 0;
     subset.responseDataMap.resize(m_committee.size());
     subset.responseMap.resize(m_committee.size());
-    fill(subset.responseMap.begin(), subset.responseMap.end(), false);
+    subset.responseMap.Fill(false);
     subset.responseData.clear();
 
     subset.state = m_state;
@@ -189,6 +216,26 @@ void ConsensusLeader::GenerateConsensusSubsets() {
       }
     }
 
+    // Take the subset aggregate out of the running one when fewer commits
+    // have to be removed from it than summed afresh
+    vector<unsigned int> excludedPeers;
+    for (unsigned int index = 0; index < m_commitMap.size(); index++) {
+      if (m_commitMap.at(index) && !subset.commitMap.at(index)) {
+        excludedPeers.push_back(index);
+      }
+    }
+    if (m_aggregatedCommit.Initialized() &&
+        (excludedPeers.size() < subset.commitPoints.size())) {
+      subset.aggregatedCommit = m_aggregatedCommit;
+      for (auto index : excludedPeers) {
+        if (!MultiSig::AccumulateCommit(subset.aggregatedCommit,
+                                        m_commitPointMap.at(index), true)) {
+          subset.aggregatedCommit.m_initialized = false;
+          break;
+        }
+      }
+    }
+
     if (DEBUG_LEVEL >= 5) {
       LOG_GENERAL(INFO, "SubsetID: " << i);
       for (unsigned int k = 0; k < subset.commitMap.size(); k++) {
@@ -197,12 +244,15 @@ void ConsensusLeader::GenerateConsensusSubsets() {
       }
     }
 
-    random_shuffle(peersWhoCommitted.begin(), peersWhoCommitted.end());
+    if (!ENABLE_ADAPTIVE_CONSENSUS_SUBSETS || (i + 1 != fastSubset)) {
+      random_shuffle(peersWhoCommitted.begin(), peersWhoCommitted.end());
+    }
   }
   // Clear out the original commit map stuff, we don't need it anymore at this
   // point
   m_commitPointMap.clear();
   m_commitPoints.clear();
+  m_aggregatedCommit.m_initialized = false;
   m_commitMap.clear();
 }
 
@@ -210,6 +260,7 @@ bool ConsensusLeader::StartConsensusSubsets() {
   LOG_MARKER();
 
   ConsensusMessageType type = ConsensusMessageType::CHALLENGE;
+  ConsensusStats::Phase phase = ConsensusStats::CHALLENGE;
   // Update overall internal state
   if (m_state == ANNOUNCE_DONE) {
     m_state = CHALLENGE_DONE;
@@ -217,6 +268,7 @@ bool ConsensusLeader::StartConsensusSubsets() {
   } else if (m_state == COLLECTIVESIG_DONE) {
     m_state = FINALCHALLENGE_DONE;
     type = ConsensusMessageType::FINALCHALLENGE;
+    phase = ConsensusStats::FINALCHALLENGE;
   } else {
     LOG_GENERAL(WARNING, "Wrong state");
     return false;
@@ -241,6 +293,7 @@ bool ConsensusLeader::StartConsensusSubsets() {
     // Add the leader to the responses
     Response r(*m_commitSecret, subset.challenge, m_myPrivKey);
     subset.responseData.emplace_back(r);
+    subset.aggregatedResponse = r;
     subset.responseDataMap.at(m_myID) = r;
     subset.responseMap.at(m_myID) = true;
     subset.responseCounter = 1;
@@ -262,6 +315,9 @@ bool ConsensusLeader::StartConsensusSubsets() {
 
   P2PComm::GetInstance().SendMessage(peerInfo, challenge);
 
+  RecordPhase(phase, m_phaseStart);
+  m_phaseStart = ConsensusStats::TimePoint::clock::now();
+
   return true;
 }
 
@@ -295,24 +351,40 @@ void ConsensusLeader::SubsetEnded(uint16_t subsetID) {
   }
 }
 
+void ConsensusLeader::RecordPhase(ConsensusStats::Phase phase,
+                                  const ConsensusStats::TimePoint& start,
+                                  unsigned int subsetID) {
+  if (ENABLE_CONSENSUS_STATS) {
+    ConsensusStats::GetInstance().RecordPhase(m_DS, phase, subsetID, start);
+  }
+}
+
 bool ConsensusLeader::ProcessMessageCommitCore(
     const bytes& commit, unsigned int offset, Action action,
     [[gnu::unused]] ConsensusMessageType returnmsgtype,
     [[gnu::unused]] State nextstate, const Peer& from) {
   LOG_MARKER();
 
-  lock_guard<mutex> g(m_mutex);
-
   // Initial checks
   // ==============
 
   if (!CheckState(action)) {
+    if (ENABLE_CONSENSUS_STATS) {
+      ConsensusStats::GetInstance().RecordLate(
+          m_DS,
+          (action == PROCESS_COMMIT) ? ConsensusStats::COMMIT
+                                     : ConsensusStats::FINALCOMMIT,
+          0);
+    }
     return false;
   }
 
   // Extract and check commit message body
   // =====================================
 
+  // These checks only read state fixed at construction, so they run without
+  // m_mutex and commits from many backups are verified in parallel
+
   uint16_t backupID = 0;
 
   CommitPoint commitPoint;
@@ -333,11 +405,6 @@ bool ConsensusLeader::ProcessMessageCommitCore(
     return false;
   }
 
-  if (m_commitMap.at(backupID)) {
-    LOG_GENERAL(WARNING, "Backup already sent commit");
-    return false;
-  }
-
   // Check the commit
   if (!commitPoint.Initialized()) {
     LOG_GENERAL(WARNING, "Invalid commit");
@@ -361,12 +428,30 @@ bool ConsensusLeader::ProcessMessageCommitCore(
   // Update internal state
   // =====================
 
+  lock_guard<mutex> g(m_mutex);
+
   if (!CheckState(action)) {
     return false;
   }
 
+  if (m_commitMap.at(backupID)) {
+    LOG_GENERAL(WARNING, "Backup already sent commit");
+    return false;
+  }
+
+  if (ENABLE_ADAPTIVE_CONSENSUS_SUBSETS) {
+    ConsensusStats::GetInstance().RecordCommitLatency(
+        m_committee.at(backupID).first,
+        chrono::duration_cast<chrono::microseconds>(
+            ConsensusStats::TimePoint::clock::now() - m_phaseStart)
+            .count());
+  }
+
   // 33-byte commit
   m_commitPoints.emplace_back(commitPoint);
+  if (!MultiSig::AccumulateCommit(m_aggregatedCommit, commitPoint)) {
+    LOG_GENERAL(WARNING, "Running commit aggregation failed");
+  }
   m_commitPointMap.at(backupID) = commitPoint;
   m_commitMap.at(backupID) = true;
 
@@ -485,8 +570,11 @@ bool ConsensusLeader::GenerateChallengeMessage(bytes& challenge,
     // Generate challenge object
     // =========================
 
-    // Aggregate commits
-    si.aggregatedCommit = AggregateCommits(subset.commitPoints);
+    // Aggregate commits, unless already derived from the running aggregate
+    if (!subset.aggregatedCommit.Initialized()) {
+      subset.aggregatedCommit = AggregateCommits(subset.commitPoints);
+    }
+    si.aggregatedCommit = subset.aggregatedCommit;
     if (!si.aggregatedCommit.Initialized()) {
       LOG_GENERAL(WARNING,
                   "[Subset " << subsetID << "] AggregateCommits failed");
@@ -563,9 +651,49 @@ bool ConsensusLeader::ProcessMessageResponseCore(
     return false;
   }
 
+  const ConsensusStats::Phase responsePhase =
+      (action == PROCESS_RESPONSE) ? ConsensusStats::RESPONSE
+                                   : ConsensusStats::FINALRESPONSE;
+
+  // A backup in several subsets answers all their challenges over the same
+  // commit, so its responses are first checked together. Only if that fails
+  // is each checked on its own below, to single out the bad ones.
+  vector<bool> verified(subsetInfo.size(), false);
+  if (subsetInfo.size() > 1) {
+    vector<unsigned int> pending;
+    vector<Response> responses;
+    vector<Challenge> challenges;
+    for (unsigned int subsetID = 0; subsetID < subsetInfo.size(); subsetID++) {
+      const ConsensusSubset& subset = m_consensusSubsets.at(subsetID);
+      if ((backupID < subset.commitMap.size()) &&
+          subset.commitMap.at(backupID) && !subset.responseMap.at(backupID) &&
+          (pending.empty() ||
+           (subset.commitPointMap.at(backupID) ==
+            m_consensusSubsets.at(pending.front()).commitPointMap.at(
+                backupID)))) {
+        pending.emplace_back(subsetID);
+        responses.emplace_back(subsetInfo.at(subsetID).response);
+        challenges.emplace_back(subset.challenge);
+      }
+    }
+    if ((pending.size() > 1) &&
+        MultiSig::VerifyResponses(
+            responses, challenges, GetCommitteeMember(backupID).first,
+            m_consensusSubsets.at(pending.front()).commitPointMap.at(
+                backupID))) {
+      for (const auto subsetID : pending) {
+        verified.at(subsetID) = true;
+      }
+    }
+  }
+
   for (unsigned int subsetID = 0; subsetID < subsetInfo.size(); subsetID++) {
     // Check subset state
     if (!CheckStateSubset(subsetID, action)) {
+      if (ENABLE_CONSENSUS_STATS) {
+        ConsensusStats::GetInstance().RecordLate(m_DS, responsePhase,
+                                                 subsetID);
+      }
       continue;
     }
 
@@ -591,7 +719,8 @@ bool ConsensusLeader::ProcessMessageResponseCore(
       continue;
     }
 
-    if (!MultiSig::VerifyResponse(subsetInfo.at(subsetID).response,
+    if (!verified.at(subsetID) &&
+        !MultiSig::VerifyResponse(subsetInfo.at(subsetID).response,
                                   subset.challenge,
                                   GetCommitteeMember(backupID).first,
                                   subset.commitPointMap.at(backupID))) {
@@ -612,8 +741,22 @@ bool ConsensusLeader::ProcessMessageResponseCore(
       return false;
     }
 
+    // Checked again now that m_mutex is held, in case a duplicate response
+    // was verified concurrently
+    if (subset.responseMap.at(backupID)) {
+      LOG_GENERAL(WARNING, "[Subset " << subsetID << "] [Backup " << backupID
+                                      << "] Already responded");
+      continue;
+    }
+
     // 32-byte response
     subset.responseData.emplace_back(subsetInfo.at(subsetID).response);
+    if (!MultiSig::AccumulateResponse(subset.aggregatedResponse,
+                                      subsetInfo.at(subsetID).response)) {
+      LOG_GENERAL(WARNING, "[Subset " << subsetID
+                                      << "] Running response aggregation "
+                                         "failed");
+    }
     subset.responseDataMap.at(backupID) = subsetInfo.at(subsetID).response;
     subset.responseMap.at(backupID) = true;
     subset.responseCounter++;
@@ -630,6 +773,14 @@ bool ConsensusLeader::ProcessMessageResponseCore(
     if (subset.responseCounter == m_numForConsensus) {
       LOG_GENERAL(INFO, "[Subset " << subsetID << "] Sufficient responses");
 
+      RecordPhase(responsePhase, m_phaseStart, subsetID);
+      if (ENABLE_CONSENSUS_STATS) {
+        ConsensusStats::GetInstance().RecordMissing(
+            m_DS, responsePhase, subsetID,
+            subset.commitMap.Count() - subset.responseCounter);
+      }
+
+      const auto collectiveSigStart = ConsensusStats::TimePoint::clock::now();
       bytes collectivesig = {m_classByte, m_insByte,
                              static_cast<uint8_t>(returnmsgtype)};
       if (!GenerateCollectiveSigMessage(
@@ -637,6 +788,10 @@ bool ConsensusLeader::ProcessMessageResponseCore(
         LOG_GENERAL(WARNING, "GenerateCollectiveSigMessage failed");
         return false;
       }
+      RecordPhase((action == PROCESS_RESPONSE)
+                      ? ConsensusStats::COLLECTIVESIG
+                      : ConsensusStats::FINALCOLLECTIVESIG,
+                  collectiveSigStart, subsetID);
 
       // Update internal state
       // =====================
@@ -657,13 +812,14 @@ bool ConsensusLeader::ProcessMessageResponseCore(
 
         // reset settings for second round of consensus
         m_commitMap.resize(m_committee.size());
-        fill(m_commitMap.begin(), m_commitMap.end(), false);
+        m_commitMap.Fill(false);
         m_commitPointMap.resize(m_committee.size());
         m_commitPoints.clear();
 
         // Add the leader to the commits
         m_commitMap.at(m_myID) = true;
         m_commitPoints.emplace_back(*m_commitPoint);
+        m_aggregatedCommit = *m_commitPoint;
         m_commitPointMap.at(m_myID) = *m_commitPoint;
         m_commitCounter = 1;
 
@@ -671,7 +827,7 @@ bool ConsensusLeader::ProcessMessageResponseCore(
         m_commitFailureMap.clear();
 
         m_commitRedundantCounter = 0;
-        fill(m_commitRedundantMap.begin(), m_commitRedundantMap.end(), false);
+        m_commitRedundantMap.Fill(false);
 
       } else {
         // Save the collective sig over the second round
@@ -697,6 +853,9 @@ bool ConsensusLeader::ProcessMessageResponseCore(
         P2PComm::GetInstance().SendMessage(peerInfo, collectivesig);
       }
 
+      // Final commits are timed from the collective sig going out
+      m_phaseStart = ConsensusStats::TimePoint::clock::now();
+
       if ((m_state == COLLECTIVESIG_DONE) && (m_numOfSubsets > 1)) {
         // Start timer for accepting final commits
         // =================================
@@ -754,8 +913,10 @@ bool ConsensusLeader::GenerateCollectiveSigMessage(bytes& collectivesig,
 
   ConsensusSubset& subset = m_consensusSubsets.at(subsetID);
 
-  // Aggregate responses
-  Response aggregated_response = AggregateResponses(subset.responseData);
+  // Aggregate responses, normally already summed as they arrived
+  Response aggregated_response = subset.aggregatedResponse.Initialized()
+                                     ? subset.aggregatedResponse
+                                     : AggregateResponses(subset.responseData);
   if (!aggregated_response.Initialized()) {
     LOG_GENERAL(WARNING, "AggregateCommits failed");
     SetStateSubset(subsetID, ERROR);
@@ -840,6 +1001,7 @@ ConsensusLeader::ConsensusLeader(
   // Add the leader to the commits
   m_commitMap.at(m_myID) = true;
   m_commitPoints.emplace_back(*m_commitPoint);
+  m_aggregatedCommit = *m_commitPoint;
   m_commitPointMap.at(m_myID) = *m_commitPoint;
   m_commitCounter = 1;
 
@@ -875,6 +1037,8 @@ bool ConsensusLeader::StartConsensus(
     return false;
   }
 
+  const auto announceStart = ConsensusStats::TimePoint::clock::now();
+
   // Assemble announcement message body
   // ==================================
   bytes announcement_message = {m_classByte, m_insByte,
@@ -896,6 +1060,9 @@ bool ConsensusLeader::StartConsensus(
   m_commitRedundantCounter = 0;
   m_commitFailureCounter = 0;
 
+  RecordPhase(ConsensusStats::ANNOUNCE, announceStart);
+  m_phaseStart = ConsensusStats::TimePoint::clock::now();
+
   // Multicast to all nodes in the committee
   // =======================================
 
@@ -25,6 +25,7 @@
 #include <vector>
 
 #include "ConsensusCommon.h"
+#include "ConsensusStats.h"
 #include "libCrypto/MultiSig.h"
 #include "libUtils/TimeLockedFunction.h"
 
@@ -64,13 +65,14 @@ class ConsensusLeader : public ConsensusCommon {
   bool m_sufficientCommitsReceived;
   unsigned int m_sufficientCommitsNumForSubsets;
 
-  std::vector<bool> m_commitMap;
+  BitVector m_commitMap;
   std::vector<CommitPoint>
       m_commitPointMap;  // ordered list of commits of size = committee size
   std::vector<CommitPoint> m_commitPoints;  // unordered list of commits of size
                                             // = 2/3 of committee size + 1
+  CommitPoint m_aggregatedCommit;  // running aggregate of m_commitPoints
   unsigned int m_commitRedundantCounter;
-  std::vector<bool> m_commitRedundantMap;
+  BitVector m_commitRedundantMap;
   std::vector<CommitPoint>
       m_commitRedundantPointMap;  // ordered list of redundant commits of size =
                                   // 1/3 of committee size
@@ -82,23 +84,28 @@ class ConsensusLeader : public ConsensusCommon {
 
   // Tracking data for each consensus subset
   struct ConsensusSubset {
-    std::vector<bool> commitMap;
+    BitVector commitMap;
     std::vector<CommitPoint> commitPointMap;  // Ordered list of commits of
                                               // fixed size = committee size
     std::vector<CommitPoint> commitPoints;
+    CommitPoint aggregatedCommit;  // aggregate of commitPoints
     unsigned int responseCounter;
     Challenge challenge;  // Challenge / Finalchallenge value generated
     std::vector<Response> responseDataMap;  // Ordered list of responses of
                                             // fixed size = committee size
     /// Response map for the generated collective signature
-    std::vector<bool> responseMap;
+    BitVector responseMap;
     std::vector<Response> responseData;
+    Response aggregatedResponse;  // running aggregate of responseData
     Signature collectiveSig;
     State state;  // Subset consensus state
   };
   std::vector<ConsensusSubset> m_consensusSubsets;
   unsigned int m_numSubsetsRunning;
 
+  // Start of the phase currently timed for ConsensusStats
+  ConsensusStats::TimePoint m_phaseStart;
+
   NodeCommitFailureHandlerFunc m_nodeCommitFailureHandlerFunc;
   ShardCommitFailureHandlerFunc m_shardCommitFailureHandlerFunc;
 
@@ -109,6 +116,9 @@ class ConsensusLeader : public ConsensusCommon {
   void GenerateConsensusSubsets();
   bool StartConsensusSubsets();
   void SubsetEnded(uint16_t subsetID);
+  void RecordPhase(ConsensusStats::Phase phase,
+                   const ConsensusStats::TimePoint& start,
+                   unsigned int subsetID = 0);
   bool ProcessMessageCommitCore(const bytes& commit, unsigned int offset,
                                 Action action,
                                 ConsensusMessageType returnmsgtype,
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <fstream>
+#include <map>
+#include <thread>
+
+#include "ConsensusStats.h"
+#include "common/Constants.h"
+#include "libUtils/DetachedFunction.h"
+#include "libUtils/Logger.h"
+#include "libUtils/TimeUtils.h"
+
+using namespace std;
+
+ConsensusStats::ConsensusStats() { Clear(); }
+
+ConsensusStats::~ConsensusStats() {}
+
+ConsensusStats& ConsensusStats::GetInstance() {
+  static ConsensusStats stats;
+  return stats;
+}
+
+ConsensusStats::Entry& ConsensusStats::GetEntry(bool isDS, Phase phase,
+                                                unsigned int subsetID) {
+  return m_entries[isDS ? 1 : 0][min<unsigned int>(phase, NUM_PHASES - 1)]
+                  [min(subsetID, MAX_SUBSETS - 1)];
+}
+
+void ConsensusStats::RecordPhase(bool isDS, Phase phase, unsigned int subsetID,
+                                 const TimePoint& start) {
+  RecordPhaseUs(isDS, phase, subsetID,
+                chrono::duration_cast<chrono::microseconds>(
+                    chrono::steady_clock::now() - start)
+                    .count());
+}
+
+void ConsensusStats::RecordPhaseUs(bool isDS, Phase phase,
+                                   unsigned int subsetID, uint64_t us) {
+  Entry& entry = GetEntry(isDS, phase, subsetID);
+  entry.m_count++;
+  entry.m_totalUs += us;
+  entry.m_hist[MessageStats::GetHistogramBucket(us)]++;
+}
+
+void ConsensusStats::RecordMissing(bool isDS, Phase phase,
+                                   unsigned int subsetID, unsigned int count) {
+  GetEntry(isDS, phase, subsetID).m_missing += count;
+}
+
+void ConsensusStats::RecordLate(bool isDS, Phase phase, unsigned int subsetID) {
+  GetEntry(isDS, phase, subsetID).m_late++;
+}
+
+void ConsensusStats::RecordCommitLatency(const PubKey& backup, uint64_t us) {
+  lock_guard<mutex> g(m_mutexCommitLatency);
+  auto it = m_commitLatencyUs.find(backup);
+  if (it == m_commitLatencyUs.end()) {
+    m_commitLatencyUs.emplace(backup, us);
+  } else {
+    // Weight of 1/8 for the new sample, so one slow round does not demote a
+    // usually fast backup
+    it->second = (it->second * 7 + us) / 8;
+  }
+}
+
+uint64_t ConsensusStats::GetCommitLatency(const PubKey& backup) const {
+  lock_guard<mutex> g(m_mutexCommitLatency);
+  auto it = m_commitLatencyUs.find(backup);
+  return (it == m_commitLatencyUs.end()) ? UINT64_MAX : it->second;
+}
+
+bool ConsensusStats::GetSnapshot(bool isDS, Phase phase, unsigned int subsetID,
+                                 Snapshot& snapshot) const {
+  if (phase >= NUM_PHASES || subsetID >= MAX_SUBSETS) {
+    return false;
+  }
+
+  const Entry& entry = m_entries[isDS ? 1 : 0][phase][subsetID];
+  snapshot.m_count = entry.m_count;
+  snapshot.m_totalUs = entry.m_totalUs;
+  snapshot.m_missing = entry.m_missing;
+  snapshot.m_late = entry.m_late;
+  for (unsigned int i = 0; i < MessageStats::NUM_HISTOGRAM_BUCKETS; i++) {
+    snapshot.m_hist[i] = entry.m_hist[i];
+  }
+
+  return (snapshot.m_count > 0) || (snapshot.m_missing > 0) ||
+         (snapshot.m_late > 0);
+}
+
+#define MAKE_LITERAL_PAIR(s) \
+  { s, #s }
+
+string ConsensusStats::GetPhaseName(Phase phase) {
+  static const map<Phase, string> PhaseStrings = {
+      MAKE_LITERAL_PAIR(ANNOUNCE),       MAKE_LITERAL_PAIR(COMMIT),
+      MAKE_LITERAL_PAIR(CHALLENGE),      MAKE_LITERAL_PAIR(RESPONSE),
+      MAKE_LITERAL_PAIR(COLLECTIVESIG),  MAKE_LITERAL_PAIR(FINALCOMMIT),
+      MAKE_LITERAL_PAIR(FINALCHALLENGE), MAKE_LITERAL_PAIR(FINALRESPONSE),
+      MAKE_LITERAL_PAIR(FINALCOLLECTIVESIG)};
+
+  auto it = PhaseStrings.find(phase);
+  return (it == PhaseStrings.end()) ? "UNKNOWN" : it->second;
+}
+
+void ConsensusStats::WriteCsvHeader(ostream& os) {
+  os << "timestamp,committee,phase,subset,count,total_us,missing,late,hist"
+     << endl;
+}
+
+void ConsensusStats::WriteCsv(ostream& os, uint64_t timestamp) const {
+  for (unsigned int ds = 0; ds < 2; ds++) {
+    for (unsigned int phase = 0; phase < NUM_PHASES; phase++) {
+      for (unsigned int subsetID = 0; subsetID < MAX_SUBSETS; subsetID++) {
+        Snapshot snapshot;
+        if (!GetSnapshot(ds == 1, static_cast<Phase>(phase), subsetID,
+                         snapshot)) {
+          continue;
+        }
+
+        os << timestamp << "," << (ds == 1 ? "DS" : "SHARD") << ","
+           << GetPhaseName(static_cast<Phase>(phase)) << "," << subsetID << ","
+           << snapshot.m_count << "," << snapshot.m_totalUs << ","
+           << snapshot.m_missing << "," << snapshot.m_late << ",";
+        for (unsigned int i = 0; i < MessageStats::NUM_HISTOGRAM_BUCKETS;
+             i++) {
+          os << (i > 0 ? ";" : "") << snapshot.m_hist[i];
+        }
+        os << "\n";
+      }
+    }
+  }
+  os.flush();
+}
+
+bool ConsensusStats::DumpToFile(const string& fileName) const {
+  ofstream fs(fileName, ofstream::out | ofstream::app);
+  if (!fs.is_open()) {
+    LOG_GENERAL(WARNING, "Failed to open " << fileName);
+    return false;
+  }
+
+  if (fs.tellp() == 0) {
+    WriteCsvHeader(fs);
+  }
+
+  // Seconds since epoch, so dumps from different nodes can be lined up
+  WriteCsv(fs, get_time_as_int() / 1000000);
+  return fs.good();
+}
+
+void ConsensusStats::StartPeriodicDump() {
+  if (CONSENSUS_STATS_DUMP_INTERVAL_IN_SECONDS == 0) {
+    return;
+  }
+
+  auto func = [this]() -> void {
+    while (true) {
+      this_thread::sleep_for(
+          chrono::seconds(CONSENSUS_STATS_DUMP_INTERVAL_IN_SECONDS));
+      DumpToFile(CONSENSUS_STATS_FILE);
+    }
+  };
+
+  DetachedFunction(DetachedFunction::Lane::BLOCKING, 1, func);
+}
+
+void ConsensusStats::Clear() {
+  {
+    lock_guard<mutex> g(m_mutexCommitLatency);
+    m_commitLatencyUs.clear();
+  }
+
+  for (auto& committees : m_entries) {
+    for (auto& phases : committees) {
+      for (auto& entry : phases) {
+        entry.m_count = 0;
+        entry.m_totalUs = 0;
+        entry.m_missing = 0;
+        entry.m_late = 0;
+        for (unsigned int i = 0; i < MessageStats::NUM_HISTOGRAM_BUCKETS;
+             i++) {
+          entry.m_hist[i] = 0;
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CONSENSUSSTATS_H__
+#define __CONSENSUSSTATS_H__
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+#include "libCrypto/Schnorr.h"
+#include "libNetwork/MessageStats.h"
+
+/// Per (committee, phase, subset) timings of the leader's side of consensus,
+/// plus counts of backups that missed or were late for a phase. Dumped as CSV
+/// rows in the same layout as MessageStats. Also keeps each backup's commit
+/// latency for composing consensus subsets.
+class ConsensusStats {
+ public:
+  enum Phase : unsigned char {
+    ANNOUNCE = 0x00,     // generating and sending the announcement
+    COMMIT,              // announcement sent -> enough commits
+    CHALLENGE,           // enough commits -> challenges sent
+    RESPONSE,            // challenges sent -> enough responses, per subset
+    COLLECTIVESIG,       // generating the collective sig, per subset
+    FINALCOMMIT,         // collective sig sent -> enough final commits
+    FINALCHALLENGE,      // enough final commits -> final challenges sent
+    FINALRESPONSE,       // final challenges sent -> enough final responses
+    FINALCOLLECTIVESIG,  // generating the final collective sig
+    NUM_PHASES
+  };
+
+  /// Subsets beyond this are recorded under the last one
+  static const unsigned int MAX_SUBSETS = 8;
+
+  typedef MessageStats::Histogram Histogram;
+
+  struct Snapshot {
+    uint64_t m_count = 0;
+    uint64_t m_totalUs = 0;
+    uint64_t m_missing = 0;
+    uint64_t m_late = 0;
+    Histogram m_hist{};
+  };
+
+ private:
+  struct Entry {
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_totalUs;
+    std::atomic<uint64_t> m_missing;
+    std::atomic<uint64_t> m_late;
+    std::atomic<uint64_t> m_hist[MessageStats::NUM_HISTOGRAM_BUCKETS];
+  };
+
+  // Indexed by [isDS][phase][subset]
+  Entry m_entries[2][NUM_PHASES][MAX_SUBSETS];
+
+  // Smoothed commit latency of each backup seen so far
+  mutable std::mutex m_mutexCommitLatency;
+  std::unordered_map<PubKey, uint64_t> m_commitLatencyUs;
+
+  ConsensusStats();
+  ~ConsensusStats();
+
+  // Singleton should not implement these
+  ConsensusStats(ConsensusStats const&) = delete;
+  void operator=(ConsensusStats const&) = delete;
+
+  Entry& GetEntry(bool isDS, Phase phase, unsigned int subsetID);
+
+ public:
+  typedef std::chrono::steady_clock::time_point TimePoint;
+
+  /// Returns the singleton ConsensusStats instance.
+  static ConsensusStats& GetInstance();
+
+  /// Records a phase that started at start and ended now
+  void RecordPhase(bool isDS, Phase phase, unsigned int subsetID,
+                   const TimePoint& start);
+
+  /// Records a phase duration directly
+  void RecordPhaseUs(bool isDS, Phase phase, unsigned int subsetID,
+                     uint64_t us);
+
+  /// Counts backups that had not sent their message when the phase ended
+  void RecordMissing(bool isDS, Phase phase, unsigned int subsetID,
+                     unsigned int count);
+
+  /// Counts a backup message that arrived after the phase ended
+  void RecordLate(bool isDS, Phase phase, unsigned int subsetID);
+
+  /// Folds a backup's commit latency into its moving average
+  void RecordCommitLatency(const PubKey& backup, uint64_t us);
+
+  /// Returns the backup's average commit latency, or UINT64_MAX if none of
+  /// its commits were seen yet
+  uint64_t GetCommitLatency(const PubKey& backup) const;
+
+  /// Returns false if nothing was recorded for this entry
+  bool GetSnapshot(bool isDS, Phase phase, unsigned int subsetID,
+                   Snapshot& snapshot) const;
+
+  static std::string GetPhaseName(Phase phase);
+
+  /// Writes the CSV column names
+  static void WriteCsvHeader(std::ostream& os);
+
+  /// Writes one row per entry seen so far. Counters are cumulative, so the
+  /// last rows of a file hold the totals.
+  void WriteCsv(std::ostream& os, uint64_t timestamp) const;
+
+  /// Appends the current counters to the file, adding the header if needed
+  bool DumpToFile(const std::string& fileName) const;
+
+  /// Dumps to CONSENSUS_STATS_FILE every
+  /// CONSENSUS_STATS_DUMP_INTERVAL_IN_SECONDS
+  void StartPeriodicDump();
+
+  void Clear();
+};
+
+#endif  // __CONSENSUSSTATS_H__
@@ -15,6 +15,8 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+
 #include "MultiSig.h"
 #include "Sha2.h"
 #include "libUtils/Logger.h"
@@ -194,7 +196,8 @@ void CommitPoint::Set(const CommitSecret& secret) {
   }
 
   if (EC_POINT_mul(Schnorr::GetInstance().GetCurve().m_group.get(), m_p.get(),
-                   secret.m_s.get(), NULL, NULL, NULL) != 1) {
+                   secret.m_s.get(), NULL, NULL,
+                   Schnorr::GetThreadScratch().m_ctx.get()) != 1) {
     LOG_GENERAL(WARNING, "Commit gen failed");
     m_initialized = false;
   } else {
@@ -208,16 +211,10 @@ CommitPoint& CommitPoint::operator=(const CommitPoint& src) {
 }
 
 bool CommitPoint::operator==(const CommitPoint& r) const {
-  unique_ptr<BN_CTX, void (*)(BN_CTX*)> ctx(BN_CTX_new(), BN_CTX_free);
-  if (ctx == nullptr) {
-    LOG_GENERAL(WARNING, "Memory allocation failure");
-    // throw exception();
-    return false;
-  }
-
   return (m_initialized && r.m_initialized &&
           (EC_POINT_cmp(Schnorr::GetInstance().GetCurve().m_group.get(),
-                        m_p.get(), r.m_p.get(), ctx.get()) == 0));
+                        m_p.get(), r.m_p.get(),
+                        Schnorr::GetThreadScratch().m_ctx.get()) == 0));
 }
 
 CommitPointHash::CommitPointHash()
@@ -620,25 +617,20 @@ void Response::Set(const CommitSecret& secret, const Challenge& challenge,
   m_initialized = false;
 
   // Compute s = k - krpiv*c
-  unique_ptr<BN_CTX, void (*)(BN_CTX*)> ctx(BN_CTX_new(), BN_CTX_free);
-  if (ctx == nullptr) {
-    LOG_GENERAL(WARNING, "Memory allocation failure");
-    // throw exception();
-    return;
-  }
+  BN_CTX* ctx = Schnorr::GetThreadScratch().m_ctx.get();
 
   const Curve& curve = Schnorr::GetInstance().GetCurve();
 
   // kpriv*c
   if (BN_mod_mul(m_r.get(), challenge.m_c.get(), privkey.m_d.get(),
-                 curve.m_order.get(), ctx.get()) == 0) {
+                 curve.m_order.get(), ctx) == 0) {
     LOG_GENERAL(WARNING, "BIGNUM mod mul failed");
     return;
   }
 
   // k-kpriv*c
   if (BN_mod_sub(m_r.get(), secret.m_s.get(), m_r.get(), curve.m_order.get(),
-                 ctx.get()) == 0) {
+                 ctx) == 0) {
     LOG_GENERAL(WARNING, "BIGNUM mod add failed");
     return;
   }
@@ -656,6 +648,131 @@ bool Response::operator==(const Response& r) const {
           (BN_cmp(m_r.get(), r.m_r.get()) == 0));
 }
 
+AggregatedPubKeyCache::AggregatedPubKeyCache(unsigned int capacity)
+    : m_capacity(capacity) {}
+
+bool AggregatedPubKeyCache::IsSameCommittee(
+    const vector<PubKey>& committee) const {
+  if (committee.size() != m_committee.size()) {
+    return false;
+  }
+
+  const Curve& curve = Schnorr::GetInstance().GetCurve();
+  BN_CTX* ctx = Schnorr::GetThreadScratch().m_ctx.get();
+
+  for (unsigned int i = 0; i < committee.size(); i++) {
+    if (EC_POINT_cmp(curve.m_group.get(), committee[i].m_P.get(),
+                     m_committee[i].m_P.get(), ctx) != 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+shared_ptr<PubKey> AggregatedPubKeyCache::Get(const vector<PubKey>& committee,
+                                              const BitVector& bitmap) {
+  if (committee.size() != bitmap.size()) {
+    LOG_GENERAL(WARNING, "Mismatch: committee size = "
+                             << committee.size()
+                             << ", bitmap size = " << bitmap.size());
+    return nullptr;
+  }
+
+  const unsigned int numSet = bitmap.Count();
+  if (numSet == 0) {
+    LOG_GENERAL(WARNING, "Empty list of public keys");
+    return nullptr;
+  }
+
+  // Pick the cached subset that needs the fewest point additions
+  shared_ptr<PubKey> base;
+  BitVector baseBitmap;
+  unsigned int bestDistance = numSet;
+  {
+    lock_guard<mutex> g(m_mutex);
+
+    if (!IsSameCommittee(committee)) {
+      m_committee = committee;
+      m_entries.clear();
+    }
+
+    for (auto it = m_entries.begin(); it != m_entries.end(); it++) {
+      const unsigned int distance = bitmap.CountDifferent(it->m_bitmap);
+
+      if (distance == 0) {
+        m_entries.splice(m_entries.begin(), m_entries, it);
+        return make_shared<PubKey>(it->m_aggregatedKey);
+      }
+
+      if (distance < bestDistance) {
+        bestDistance = distance;
+        base = make_shared<PubKey>(it->m_aggregatedKey);
+        baseBitmap = it->m_bitmap;
+      }
+    }
+  }
+
+  shared_ptr<PubKey> result;
+  if (base == nullptr) {
+    vector<PubKey> keys;
+    keys.reserve(numSet);
+    bitmap.ForEachSet(
+        [&keys, &committee](size_t i) { keys.emplace_back(committee[i]); });
+    result = MultiSig::AggregatePubKeys(keys);
+  } else {
+    const Curve& curve = Schnorr::GetInstance().GetCurve();
+    CurveScratch& scratch = Schnorr::GetThreadScratch();
+    EC_POINT* negated = scratch.m_point.get();
+
+    BitVector changed(bitmap);
+    changed ^= baseBitmap;
+    bool ok = true;
+    changed.ForEachSet([&](size_t i) {
+      if (!ok) {
+        return;
+      }
+
+      const EC_POINT* delta = committee[i].m_P.get();
+      if (!bitmap[i]) {
+        // Member left the subset, subtract its key
+        if ((EC_POINT_copy(negated, delta) == 0) ||
+            (EC_POINT_invert(curve.m_group.get(), negated,
+                             scratch.m_ctx.get()) == 0)) {
+          LOG_GENERAL(WARNING, "Pubkey negation failed");
+          ok = false;
+          return;
+        }
+        delta = negated;
+      }
+
+      if (EC_POINT_add(curve.m_group.get(), base->m_P.get(), base->m_P.get(),
+                       delta, scratch.m_ctx.get()) == 0) {
+        LOG_GENERAL(WARNING, "Pubkey aggregation failed");
+        ok = false;
+      }
+    });
+    if (!ok) {
+      return nullptr;
+    }
+    result = base;
+  }
+
+  if (result == nullptr) {
+    return nullptr;
+  }
+
+  lock_guard<mutex> g(m_mutex);
+  if (IsSameCommittee(committee)) {
+    m_entries.push_front({bitmap, *result});
+    if (m_entries.size() > m_capacity) {
+      m_entries.pop_back();
+    }
+  }
+
+  return result;
+}
+
 MultiSig::MultiSig() {}
 
 MultiSig::~MultiSig() {}
@@ -692,6 +809,12 @@ shared_ptr<PubKey> MultiSig::AggregatePubKeys(const vector<PubKey>& pubkeys) {
   return aggregatedPubkey;
 }
 
+shared_ptr<PubKey> MultiSig::AggregatePubKeys(const vector<PubKey>& committee,
+                                              const BitVector& bitmap) {
+  static AggregatedPubKeyCache cache(AGGREGATED_PUBKEY_CACHE_SIZE);
+  return cache.Get(committee, bitmap);
+}
+
 shared_ptr<CommitPoint> MultiSig::AggregateCommits(
     const vector<CommitPoint>& commitPoints) {
   const Curve& curve = Schnorr::GetInstance().GetCurve();
@@ -736,17 +859,12 @@ shared_ptr<Response> MultiSig::AggregateResponses(
     return nullptr;
   }
 
-  unique_ptr<BN_CTX, void (*)(BN_CTX*)> ctx(BN_CTX_new(), BN_CTX_free);
-  if (ctx == nullptr) {
-    LOG_GENERAL(WARNING, "Memory allocation failure");
-    // throw exception();
-    return nullptr;
-  }
+  BN_CTX* ctx = Schnorr::GetThreadScratch().m_ctx.get();
 
   for (unsigned int i = 1; i < responses.size(); i++) {
     if (BN_mod_add(aggregatedResponse->m_r.get(), aggregatedResponse->m_r.get(),
                    responses.at(i).m_r.get(), curve.m_order.get(),
-                   ctx.get()) == 0) {
+                   ctx) == 0) {
       LOG_GENERAL(WARNING, "Response aggregation failed");
       return nullptr;
     }
@@ -755,6 +873,71 @@ shared_ptr<Response> MultiSig::AggregateResponses(
   return aggregatedResponse;
 }
 
+bool MultiSig::AccumulateCommit(CommitPoint& aggregatedCommit,
+                                const CommitPoint& commitPoint, bool subtract) {
+  if (!commitPoint.Initialized()) {
+    LOG_GENERAL(WARNING, "Commit point not initialized");
+    return false;
+  }
+
+  if (!aggregatedCommit.Initialized()) {
+    if (subtract) {
+      LOG_GENERAL(WARNING, "Nothing to subtract commit from");
+      return false;
+    }
+    aggregatedCommit = commitPoint;
+    return aggregatedCommit.Initialized();
+  }
+
+  const Curve& curve = Schnorr::GetInstance().GetCurve();
+  CurveScratch& scratch = Schnorr::GetThreadScratch();
+
+  const EC_POINT* delta = commitPoint.m_p.get();
+  if (subtract) {
+    if ((EC_POINT_copy(scratch.m_point.get(), delta) == 0) ||
+        (EC_POINT_invert(curve.m_group.get(), scratch.m_point.get(),
+                         scratch.m_ctx.get()) == 0)) {
+      LOG_GENERAL(WARNING, "Commit negation failed");
+      return false;
+    }
+    delta = scratch.m_point.get();
+  }
+
+  if (EC_POINT_add(curve.m_group.get(), aggregatedCommit.m_p.get(),
+                   aggregatedCommit.m_p.get(), delta,
+                   scratch.m_ctx.get()) == 0) {
+    LOG_GENERAL(WARNING, "Commit aggregation failed");
+    aggregatedCommit.m_initialized = false;
+    return false;
+  }
+
+  return true;
+}
+
+bool MultiSig::AccumulateResponse(Response& aggregatedResponse,
+                                  const Response& response) {
+  if (!response.Initialized()) {
+    LOG_GENERAL(WARNING, "Response not initialized");
+    return false;
+  }
+
+  if (!aggregatedResponse.Initialized()) {
+    aggregatedResponse = response;
+    return aggregatedResponse.Initialized();
+  }
+
+  if (BN_mod_add(aggregatedResponse.m_r.get(), aggregatedResponse.m_r.get(),
+                 response.m_r.get(),
+                 Schnorr::GetInstance().GetCurve().m_order.get(),
+                 Schnorr::GetThreadScratch().m_ctx.get()) == 0) {
+    LOG_GENERAL(WARNING, "Response aggregation failed");
+    aggregatedResponse.m_initialized = false;
+    return false;
+  }
+
+  return true;
+}
+
 shared_ptr<Signature> MultiSig::AggregateSign(
     const Challenge& challenge, const Response& aggregatedResponse) {
   if (!challenge.Initialized()) {
@@ -817,45 +1000,143 @@ bool MultiSig::VerifyResponse(const Response& response,
     bool err = false;
 
     // Regenerate the commitmment part of the signature
-    unique_ptr<EC_POINT, void (*)(EC_POINT*)> Q(
+    CurveScratch& scratch = Schnorr::GetThreadScratch();
+    EC_POINT* Q = scratch.m_point.get();
+    BN_CTX* ctx = scratch.m_ctx.get();
+
+    // 1. Check if s is in [1, ..., order-1]
+    err = (BN_is_zero(response.m_r.get()) ||
+           (BN_cmp(response.m_r.get(), curve.m_order.get()) != -1));
+    if (err) {
+      LOG_GENERAL(WARNING, "Response not in range");
+      return false;
+    }
+
+    // 2. Compute Q = sG + r*kpub
+    err = (EC_POINT_mul(curve.m_group.get(), Q, response.m_r.get(),
+                        pubkey.m_P.get(), challenge.m_c.get(), ctx) == 0);
+    if (err) {
+      LOG_GENERAL(WARNING, "Commit regenerate failed");
+      return false;
+    }
+
+    // 3. Q == commitPoint
+    err = (EC_POINT_cmp(curve.m_group.get(), Q, commitPoint.m_p.get(), ctx) !=
+           0);
+    if (err) {
+      LOG_GENERAL(WARNING,
+                  "Generated commit point doesn't match the "
+                  "given one");
+      return false;
+    }
+  } catch (const std::exception& e) {
+    LOG_GENERAL(WARNING,
+                "Error with MultiSig::VerifyResponse." << ' ' << e.what());
+    return false;
+  }
+  return true;
+}
+
+bool MultiSig::VerifyResponses(const vector<Response>& responses,
+                               const vector<Challenge>& challenges,
+                               const PubKey& pubkey,
+                               const CommitPoint& commitPoint) {
+  if (responses.empty() || (responses.size() != challenges.size())) {
+    LOG_GENERAL(WARNING, "Response count mismatch");
+    return false;
+  }
+
+  if (responses.size() == 1) {
+    return VerifyResponse(responses.front(), challenges.front(), pubkey,
+                          commitPoint);
+  }
+
+  try {
+    if (!commitPoint.Initialized()) {
+      LOG_GENERAL(WARNING, "Commit point not initialized");
+      return false;
+    }
+
+    const Curve& curve = Schnorr::GetInstance().GetCurve();
+    const BIGNUM* order = curve.m_order.get();
+
+    // Every response s_i to c_i satisfies s_i*G + c_i*kpub = Q, so any
+    // weighted sum of them does too:
+    // (sum w_i*s_i)*G + (sum w_i*c_i)*kpub = (sum w_i)*Q
+    // The weights are random so that a wrong response cannot be offset by
+    // another one. Two multiplications replace one per response.
+
+    CurveScratch& scratch = Schnorr::GetThreadScratch();
+    BN_CTX* ctx = scratch.m_ctx.get();
+
+    unique_ptr<BIGNUM, void (*)(BIGNUM*)> weight(BN_new(), BN_clear_free);
+    unique_ptr<BIGNUM, void (*)(BIGNUM*)> term(BN_new(), BN_clear_free);
+    unique_ptr<BIGNUM, void (*)(BIGNUM*)> sumS(BN_new(), BN_clear_free);
+    unique_ptr<BIGNUM, void (*)(BIGNUM*)> sumC(BN_new(), BN_clear_free);
+    unique_ptr<BIGNUM, void (*)(BIGNUM*)> sumW(BN_new(), BN_clear_free);
+    unique_ptr<EC_POINT, void (*)(EC_POINT*)> rhs(
         EC_POINT_new(curve.m_group.get()), EC_POINT_clear_free);
-    unique_ptr<BN_CTX, void (*)(BN_CTX*)> ctx(BN_CTX_new(), BN_CTX_free);
+    if ((weight == nullptr) || (term == nullptr) || (sumS == nullptr) ||
+        (sumC == nullptr) || (sumW == nullptr) || (rhs == nullptr)) {
+      LOG_GENERAL(WARNING, "Memory allocation failure");
+      return false;
+    }
+    BN_zero(sumS.get());
+    BN_zero(sumC.get());
+    BN_zero(sumW.get());
 
-    if ((ctx != nullptr) && (Q != nullptr)) {
-      // 1. Check if s is in [1, ..., order-1]
-      err = (BN_is_zero(response.m_r.get()) ||
-             (BN_cmp(response.m_r.get(), curve.m_order.get()) != -1));
-      if (err) {
-        LOG_GENERAL(WARNING, "Response not in range");
+    for (unsigned int i = 0; i < responses.size(); i++) {
+      const Response& response = responses.at(i);
+      const Challenge& challenge = challenges.at(i);
+
+      if (!response.Initialized()) {
+        LOG_GENERAL(WARNING, "Response not initialized");
         return false;
       }
 
-      // 2. Compute Q = sG + r*kpub
-      err =
-          (EC_POINT_mul(curve.m_group.get(), Q.get(), response.m_r.get(),
-                        pubkey.m_P.get(), challenge.m_c.get(), ctx.get()) == 0);
-      if (err) {
-        LOG_GENERAL(WARNING, "Commit regenerate failed");
+      if (!challenge.Initialized()) {
+        LOG_GENERAL(WARNING, "Challenge not initialized");
         return false;
       }
 
-      // 3. Q == commitPoint
-      err = (EC_POINT_cmp(curve.m_group.get(), Q.get(), commitPoint.m_p.get(),
-                          ctx.get()) != 0);
-      if (err) {
-        LOG_GENERAL(WARNING,
-                    "Generated commit point doesn't match the "
-                    "given one");
+      // Check if s is in [1, ..., order-1]
+      if (BN_is_zero(response.m_r.get()) ||
+          (BN_cmp(response.m_r.get(), order) != -1)) {
+        LOG_GENERAL(WARNING, "Response not in range");
         return false;
       }
-    } else {
-      LOG_GENERAL(WARNING, "Memory allocation failure");
-      // throw exception();
+
+      if ((BN_rand(weight.get(), 128, -1, 0) == 0) ||
+          (BN_mod_mul(term.get(), weight.get(), response.m_r.get(), order,
+                      ctx) == 0) ||
+          (BN_mod_add(sumS.get(), sumS.get(), term.get(), order, ctx) == 0) ||
+          (BN_mod_mul(term.get(), weight.get(), challenge.m_c.get(), order,
+                      ctx) == 0) ||
+          (BN_mod_add(sumC.get(), sumC.get(), term.get(), order, ctx) == 0) ||
+          (BN_mod_add(sumW.get(), sumW.get(), weight.get(), order, ctx) ==
+           0)) {
+        LOG_GENERAL(WARNING, "Response weighting failed");
+        return false;
+      }
+    }
+
+    EC_POINT* lhs = scratch.m_point.get();
+    if ((EC_POINT_mul(curve.m_group.get(), lhs, sumS.get(), pubkey.m_P.get(),
+                      sumC.get(), ctx) == 0) ||
+        (EC_POINT_mul(curve.m_group.get(), rhs.get(), NULL,
+                      commitPoint.m_p.get(), sumW.get(), ctx) == 0)) {
+      LOG_GENERAL(WARNING, "Commit regenerate failed");
+      return false;
+    }
+
+    if (EC_POINT_cmp(curve.m_group.get(), lhs, rhs.get(), ctx) != 0) {
+      LOG_GENERAL(WARNING,
+                  "Generated commit point doesn't match the given one");
       return false;
     }
   } catch (const std::exception& e) {
     LOG_GENERAL(WARNING,
-                "Error with MultiSig::VerifyResponse." << ' ' << e.what());
+                "Error with MultiSig::VerifyResponses." << ' ' << e.what());
     return false;
   }
   return true;
@@ -937,11 +1218,11 @@ bool MultiSig::MultiSigVerify(const bytes& message, unsigned int offset,
     // Regenerate the commitment part of the signature
     unique_ptr<BIGNUM, void (*)(BIGNUM*)> challenge_built(BN_new(),
                                                           BN_clear_free);
-    unique_ptr<EC_POINT, void (*)(EC_POINT*)> Q(
-        EC_POINT_new(curve.m_group.get()), EC_POINT_clear_free);
-    unique_ptr<BN_CTX, void (*)(BN_CTX*)> ctx(BN_CTX_new(), BN_CTX_free);
+    CurveScratch& scratch = Schnorr::GetThreadScratch();
+    EC_POINT* Q = scratch.m_point.get();
+    BN_CTX* ctx = scratch.m_ctx.get();
 
-    if ((challenge_built != nullptr) && (ctx != nullptr) && (Q != nullptr)) {
+    if (challenge_built != nullptr) {
       // 1. Check if r,s is in [1, ..., order-1]
       err2 = (BN_is_zero(toverify.m_r.get()) ||
               BN_is_negative(toverify.m_r.get()) ||
@@ -963,8 +1244,8 @@ bool MultiSig::MultiSigVerify(const bytes& message, unsigned int offset,
 
       // 2. Compute Q = sG + r*kpub
       err2 =
-          (EC_POINT_mul(curve.m_group.get(), Q.get(), toverify.m_s.get(),
-                        pubkey.m_P.get(), toverify.m_r.get(), ctx.get()) == 0);
+          (EC_POINT_mul(curve.m_group.get(), Q, toverify.m_s.get(),
+                        pubkey.m_P.get(), toverify.m_r.get(), ctx) == 0);
       err = err || err2;
       if (err2) {
         LOG_GENERAL(WARNING, "Commit regenerate failed");
@@ -972,7 +1253,7 @@ bool MultiSig::MultiSigVerify(const bytes& message, unsigned int offset,
       }
 
       // 3. If Q = O (the neutral point), return 0;
-      err2 = (EC_POINT_is_at_infinity(curve.m_group.get(), Q.get()));
+      err2 = (EC_POINT_is_at_infinity(curve.m_group.get(), Q));
       err = err || err2;
       if (err2) {
         LOG_GENERAL(WARNING, "Commit at infinity");
@@ -981,7 +1262,7 @@ bool MultiSig::MultiSigVerify(const bytes& message, unsigned int offset,
 
       // 4. r' = H(Q, kpub, m)
       // 4.1 Convert the committment to octets first
-      err2 = (EC_POINT_point2oct(curve.m_group.get(), Q.get(),
+      err2 = (EC_POINT_point2oct(curve.m_group.get(), Q,
                                  POINT_CONVERSION_COMPRESSED, buf.data(),
                                  Schnorr::PUBKEY_COMPRESSED_SIZE_BYTES, NULL) !=
               Schnorr::PUBKEY_COMPRESSED_SIZE_BYTES);
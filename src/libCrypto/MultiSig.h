@@ -18,11 +18,14 @@
 #ifndef __MULTISIG_H__
 #define __MULTISIG_H__
 
+#include <list>
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "Schnorr.h"
 #include "common/Serializable.h"
+#include "libUtils/BitVector.h"
 
 // Commitment is composed of a random secret scalar, a public point and a hash
 // of the public point. It is generated by each signer.
@@ -251,6 +254,31 @@ struct Response : public Serializable {
   bool operator==(const Response& r) const;
 };
 
+/// Caches aggregated public keys of committee subsets, keyed by the subset
+/// bitmap. A bitmap close to a cached one is aggregated by adding and
+/// subtracting only the members that differ.
+class AggregatedPubKeyCache {
+  struct Entry {
+    BitVector m_bitmap;
+    PubKey m_aggregatedKey;
+  };
+
+  std::mutex m_mutex;
+  std::vector<PubKey> m_committee;
+  std::list<Entry> m_entries;  // most recently used first
+  const unsigned int m_capacity;
+
+  bool IsSameCommittee(const std::vector<PubKey>& committee) const;
+
+ public:
+  /// Constructor.
+  explicit AggregatedPubKeyCache(unsigned int capacity);
+
+  /// Returns the aggregated key of the committee members set in bitmap.
+  std::shared_ptr<PubKey> Get(const std::vector<PubKey>& committee,
+                              const BitVector& bitmap);
+};
+
 /// Implements the functionality for EC-Schnorr multisignature scheme
 /// operations.
 class MultiSig {
@@ -270,6 +298,11 @@ class MultiSig {
   static std::shared_ptr<PubKey> AggregatePubKeys(
       const std::vector<PubKey>& pubkeys);
 
+  /// Aggregates the public keys of the committee members set in bitmap,
+  /// reusing earlier aggregates of the same committee where possible.
+  static std::shared_ptr<PubKey> AggregatePubKeys(
+      const std::vector<PubKey>& committee, const BitVector& bitmap);
+
   /// Aggregates the received commitments for the multisignature aggregator.
   static std::shared_ptr<CommitPoint> AggregateCommits(
       const std::vector<CommitPoint>& commitPoints);
@@ -278,6 +311,17 @@ class MultiSig {
   static std::shared_ptr<Response> AggregateResponses(
       const std::vector<Response>& responses);
 
+  /// Adds one commitment to a running aggregate, or removes it if subtract
+  /// is set. An uninitialized aggregate is set to the commitment.
+  static bool AccumulateCommit(CommitPoint& aggregatedCommit,
+                               const CommitPoint& commitPoint,
+                               bool subtract = false);
+
+  /// Adds one response to a running aggregate. An uninitialized aggregate is
+  /// set to the response.
+  static bool AccumulateResponse(Response& aggregatedResponse,
+                                 const Response& response);
+
   /// Generates the aggregated signature for the multisignature aggregator.
   static std::shared_ptr<Signature> AggregateSign(
       const Challenge& challenge, const Response& aggregatedResponse);
@@ -287,6 +331,14 @@ class MultiSig {
                              const Challenge& challenge, const PubKey& pubkey,
                              const CommitPoint& commitPoint);
 
+  /// Verifies the responses of one signer to several challenges, all made
+  /// over the same commit point, in one combined check. When it fails, the
+  /// caller can single out the bad ones with VerifyResponse.
+  static bool VerifyResponses(const std::vector<Response>& responses,
+                              const std::vector<Challenge>& challenges,
+                              const PubKey& pubkey,
+                              const CommitPoint& commitPoint);
+
   /// Checks the multi-signature validity using EC curve parameters and the
   /// specified aggregated PubKey.
   bool MultiSigVerify(const bytes& message, const Signature& toverify,
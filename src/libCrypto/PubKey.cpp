@@ -19,11 +19,49 @@
 #include <openssl/ec.h>
 #include <openssl/err.h>
 
+#include <cstring>
+#include <unordered_map>
+
+#include <boost/functional/hash.hpp>
+
 #include "Schnorr.h"
 #include "libUtils/Logger.h"
 
 using namespace std;
 
+namespace {
+
+/// Maps compressed key encodings to already decoded points, so the square
+/// root needed to decompress a point is only computed once per key.
+class DecodedPointCache {
+  mutex m_mutex;
+  unordered_map<string, shared_ptr<const EC_POINT>> m_points;
+  const unsigned int m_capacity;
+
+ public:
+  explicit DecodedPointCache(unsigned int capacity) : m_capacity(capacity) {}
+
+  shared_ptr<const EC_POINT> Get(const string& encoding) {
+    lock_guard<mutex> g(m_mutex);
+    auto it = m_points.find(encoding);
+    return (it == m_points.end()) ? nullptr : it->second;
+  }
+
+  void Add(const string& encoding, const shared_ptr<const EC_POINT>& point) {
+    if (m_capacity == 0) {
+      return;
+    }
+
+    lock_guard<mutex> g(m_mutex);
+    if (m_points.size() >= m_capacity) {
+      m_points.erase(m_points.begin());
+    }
+    m_points.emplace(encoding, point);
+  }
+};
+
+}  // namespace
+
 // ============================================================================
 // Construction
 // ============================================================================
@@ -64,7 +102,7 @@ PubKey::PubKey(const PrivKey& privkey)
     return;
   }
   if (EC_POINT_mul(curve.m_group.get(), m_P.get(), privkey.m_d.get(), NULL,
-                   NULL, NULL) == 0) {
+                   NULL, Schnorr::GetThreadScratch().m_ctx.get()) == 0) {
     LOG_GENERAL(WARNING, "Public key generation failed");
     return;
   }
@@ -125,9 +163,32 @@ PubKey PubKey::GetPubKeyFromString(const string& key) {
   return PubKey(key_v, 0);
 }
 
+shared_ptr<const EC_POINT> PubKey::GetInternedPoint(const bytes& src,
+                                                    unsigned int offset) {
+  static DecodedPointCache cache(PUBKEY_INTERN_CACHE_SIZE);
+
+  if (offset + PUB_KEY_SIZE > src.size()) {
+    return ECPOINTSerialize::GetNumber(src, offset, PUB_KEY_SIZE);
+  }
+
+  const string encoding(src.begin() + offset,
+                        src.begin() + offset + PUB_KEY_SIZE);
+
+  shared_ptr<const EC_POINT> point = cache.Get(encoding);
+  if (point != nullptr) {
+    return point;
+  }
+
+  point = ECPOINTSerialize::GetNumber(src, offset, PUB_KEY_SIZE);
+  if (point != nullptr) {
+    cache.Add(encoding, point);
+  }
+
+  return point;
+}
+
 int PubKey::Deserialize(const bytes& src, unsigned int offset) {
-  shared_ptr<EC_POINT> result =
-      ECPOINTSerialize::GetNumber(src, offset, PUB_KEY_SIZE);
+  shared_ptr<const EC_POINT> result = GetInternedPoint(src, offset);
 
   if (result == nullptr) {
     LOG_GENERAL(WARNING, "ECPOINTSerialize::GetNumber failed");
@@ -153,43 +214,42 @@ PubKey& PubKey::operator=(const PubKey& src) {
   return *this;
 }
 
-bool PubKey::comparePreChecks(const PubKey& r, shared_ptr<BIGNUM>& lhs_bnvalue,
-                              shared_ptr<BIGNUM>& rhs_bnvalue) const {
-  unique_ptr<BN_CTX, void (*)(BN_CTX*)> ctx(BN_CTX_new(), BN_CTX_free);
-  if (ctx == nullptr) {
-    LOG_GENERAL(FATAL, "Memory allocation failure");
-    return false;
-  }
+size_t PubKey::encodeCompressed(
+    array<unsigned char, PUB_KEY_SIZE>& buf) const {
+  return EC_POINT_point2oct(
+      Schnorr::GetInstance().GetCurve().m_group.get(), m_P.get(),
+      POINT_CONVERSION_COMPRESSED, buf.data(), buf.size(),
+      Schnorr::GetThreadScratch().m_ctx.get());
+}
 
-  lhs_bnvalue.reset(
-      EC_POINT_point2bn(Schnorr::GetInstance().GetCurve().m_group.get(),
-                        m_P.get(), POINT_CONVERSION_COMPRESSED, NULL,
-                        ctx.get()),
-      BN_clear_free);
-  rhs_bnvalue.reset(
-      EC_POINT_point2bn(Schnorr::GetInstance().GetCurve().m_group.get(),
-                        r.m_P.get(), POINT_CONVERSION_COMPRESSED, NULL,
-                        ctx.get()),
-      BN_clear_free);
+bool PubKey::operator<(const PubKey& r) const {
+  array<unsigned char, PUB_KEY_SIZE> lhs{}, rhs{};
+  size_t lhsLen = encodeCompressed(lhs);
+  size_t rhsLen = r.encodeCompressed(rhs);
 
-  if ((lhs_bnvalue == nullptr) || (rhs_bnvalue == nullptr)) {
-    LOG_GENERAL(FATAL, "Memory allocation failure");
+  if ((lhsLen == 0) || (rhsLen == 0)) {
+    LOG_GENERAL(WARNING, "EC_POINT_point2oct failed");
     return false;
   }
 
-  return true;
-}
-
-bool PubKey::operator<(const PubKey& r) const {
-  shared_ptr<BIGNUM> lhs_bnvalue, rhs_bnvalue;
-  return comparePreChecks(r, lhs_bnvalue, rhs_bnvalue) &&
-         BN_cmp(lhs_bnvalue.get(), rhs_bnvalue.get()) == -1;
+  // Same order as comparing the encodings as big-endian numbers; the point at
+  // infinity encodes to a single zero byte and sorts first
+  if (lhsLen != rhsLen) {
+    return lhsLen < rhsLen;
+  }
+  return memcmp(lhs.data(), rhs.data(), lhsLen) < 0;
 }
 
 bool PubKey::operator>(const PubKey& r) const { return r < *this; }
 
 bool PubKey::operator==(const PubKey& r) const {
-  shared_ptr<BIGNUM> lhs_bnvalue, rhs_bnvalue;
-  return comparePreChecks(r, lhs_bnvalue, rhs_bnvalue) &&
-         BN_cmp(lhs_bnvalue.get(), rhs_bnvalue.get()) == 0;
-}
\ No newline at end of file
+  return EC_POINT_cmp(Schnorr::GetInstance().GetCurve().m_group.get(),
+                      m_P.get(), r.m_P.get(),
+                      Schnorr::GetThreadScratch().m_ctx.get()) == 0;
+}
+
+size_t PubKey::Hash() const {
+  array<unsigned char, PUB_KEY_SIZE> buf{};
+  size_t len = encodeCompressed(buf);
+  return boost::hash_range(buf.begin(), buf.begin() + len);
+}
@@ -30,9 +30,12 @@
 #include "generate_dsa_nonce.h"
 #endif
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 
 #include "Schnorr.h"
+#include "libUtils/JoinableFunction.h"
 #include "libUtils/Logger.h"
 
 using namespace std;
@@ -52,10 +55,39 @@ Curve::Curve()
   if (!EC_GROUP_get_order(m_group.get(), m_order.get(), NULL)) {
     LOG_GENERAL(FATAL, "Recover curve order failed");
   }
+#if OPENSSL_VERSION_NUMBER < 0x30000000L  // deprecated in OpenSSL 3.0
+  // Store a table of generator multiples so that every sG + rP in Verify and
+  // MultiSig does not rebuild it. The group is read-only from here on.
+  if (!EC_GROUP_precompute_mult(m_group.get(), NULL)) {
+    LOG_GENERAL(WARNING, "Generator precomputation failed");
+  }
+#endif
 }
 
 Curve::~Curve() {}
 
+CurveScratch::CurveScratch(const Curve& curve)
+    : m_ctx(BN_CTX_new(), BN_CTX_free),
+      m_point(EC_POINT_new(curve.m_group.get()), EC_POINT_clear_free),
+      m_group(curve.m_group) {
+  if ((m_ctx == nullptr) || (m_point == nullptr)) {
+    LOG_GENERAL(FATAL, "Memory allocation failure");
+  }
+}
+
+EC_POINT* CurveScratch::GetBatchPoint(size_t index) {
+  while (m_batchPoints.size() <= index) {
+    m_batchPoints.emplace_back(EC_POINT_new(m_group.get()),
+                               EC_POINT_clear_free);
+    if (m_batchPoints.back() == nullptr) {
+      m_batchPoints.pop_back();
+      LOG_GENERAL(WARNING, "Memory allocation failure");
+      return nullptr;
+    }
+  }
+  return m_batchPoints[index].get();
+}
+
 Schnorr::Schnorr() {}
 
 Schnorr::~Schnorr() {}
@@ -67,6 +99,11 @@ Schnorr& Schnorr::GetInstance() {
 
 const Curve& Schnorr::GetCurve() const { return m_curve; }
 
+CurveScratch& Schnorr::GetThreadScratch() {
+  thread_local CurveScratch scratch(GetInstance().GetCurve());
+  return scratch;
+}
+
 PairOfKey Schnorr::GenKeyPair() {
   // LOG_MARKER();
 
@@ -124,11 +161,11 @@ bool Schnorr::Sign(const bytes& message, unsigned int offset, unsigned int size,
   int res = 1;       // result to return
 
   unique_ptr<BIGNUM, void (*)(BIGNUM*)> k(BN_new(), BN_clear_free);
-  unique_ptr<EC_POINT, void (*)(EC_POINT*)> Q(
-      EC_POINT_new(m_curve.m_group.get()), EC_POINT_clear_free);
-  unique_ptr<BN_CTX, void (*)(BN_CTX*)> ctx(BN_CTX_new(), BN_CTX_free);
+  CurveScratch& scratch = GetThreadScratch();
+  EC_POINT* Q = scratch.m_point.get();
+  BN_CTX* ctx = scratch.m_ctx.get();
 
-  if ((k != nullptr) && (ctx != nullptr) && (Q != nullptr)) {
+  if (k != nullptr) {
     do {
       err = false;
 
@@ -137,7 +174,7 @@ bool Schnorr::Sign(const bytes& message, unsigned int offset, unsigned int size,
         err = (BN_generate_dsa_nonce(
                    k.get(), m_curve.m_order.get(), privkey.m_d.get(),
                    static_cast<const unsigned char*>(message.data()),
-                   message.size(), ctx.get()) == 0);
+                   message.size(), ctx) == 0);
 
         // err =
         // (BN_rand(k.get(), BN_num_bits(m_curve.m_order.get()), -1, 0) == 0);
@@ -148,8 +185,8 @@ bool Schnorr::Sign(const bytes& message, unsigned int offset, unsigned int size,
       } while (BN_is_zero(k.get()));
 
       // 2. Compute the commitment Q = kG, where G is the base point
-      err = (EC_POINT_mul(m_curve.m_group.get(), Q.get(), k.get(), NULL, NULL,
-                          NULL) == 0);
+      err = (EC_POINT_mul(m_curve.m_group.get(), Q, k.get(), NULL, NULL,
+                          ctx) == 0);
       if (err) {
         LOG_GENERAL(WARNING, "Commit generation failed");
         return false;
@@ -158,7 +195,7 @@ bool Schnorr::Sign(const bytes& message, unsigned int offset, unsigned int size,
       // 3. Compute the challenge r = H(Q, kpub, m)
 
       // Convert the committment to octets first
-      err = (EC_POINT_point2oct(m_curve.m_group.get(), Q.get(),
+      err = (EC_POINT_point2oct(m_curve.m_group.get(), Q,
                                 POINT_CONVERSION_COMPRESSED, buf.data(),
                                 PUBKEY_COMPRESSED_SIZE_BYTES,
                                 NULL) != PUBKEY_COMPRESSED_SIZE_BYTES);
@@ -208,7 +245,7 @@ bool Schnorr::Sign(const bytes& message, unsigned int offset, unsigned int size,
       // 4. Compute s = k - r*krpiv
       // 4.1 r*kpriv
       err = (BN_mod_mul(result.m_s.get(), result.m_r.get(), privkey.m_d.get(),
-                        m_curve.m_order.get(), ctx.get()) == 0);
+                        m_curve.m_order.get(), ctx) == 0);
       if (err) {
         LOG_GENERAL(WARNING, "Response mod mul failed");
         return false;
@@ -216,7 +253,7 @@ bool Schnorr::Sign(const bytes& message, unsigned int offset, unsigned int size,
 
       // 4.2 k-r*kpriv
       err = (BN_mod_sub(result.m_s.get(), k.get(), result.m_s.get(),
-                        m_curve.m_order.get(), ctx.get()) == 0);
+                        m_curve.m_order.get(), ctx) == 0);
       if (err) {
         LOG_GENERAL(WARNING, "BIGNUM mod sub failed");
         return false;
@@ -254,8 +291,121 @@ bool Schnorr::Verify(const bytes& message, unsigned int offset,
   // functions
   lock_guard<mutex> g(m_mutexSchnorr);
 
-  // Initial checks
+  return VerifyNoLock(message, offset, size, toverify, pubkey);
+}
+
+const unsigned int Schnorr::VERIFY_CHUNK_SIZE;
+
+bool Schnorr::VerifyBatch(const vector<bytes>& messages,
+                          const vector<Signature>& toverify,
+                          const vector<PubKey>& pubkeys,
+                          vector<bool>& results, unsigned int numThreads) {
+  results.assign(messages.size(), false);
+
+  if ((messages.size() != toverify.size()) ||
+      (messages.size() != pubkeys.size())) {
+    LOG_GENERAL(WARNING, "Batch size mismatch");
+    return false;
+  }
+
+  // Not vector<bool>, whose elements cannot be written concurrently
+  vector<unsigned char> valid(messages.size(), 0);
+
+  numThreads = max(1U, min<unsigned int>(numThreads, messages.size()));
+
+  // Chunks small enough that every thread gets work
+  const unsigned int chunkSize = min<unsigned int>(
+      VERIFY_CHUNK_SIZE, (messages.size() + numThreads - 1) / numThreads);
+  const unsigned int numChunks =
+      (chunkSize == 0) ? 0 : (messages.size() + chunkSize - 1) / chunkSize;
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+  // OpenSSL 1.1.0 and later is thread-safe as long as each thread has its own
+  // scratch objects, and the curve itself is only read when verifying
+  if (numThreads > 1) {
+    atomic<unsigned int> next{0};
+
+    auto worker = [&]() -> void {
+      for (unsigned int c = next++; c < numChunks; c = next++) {
+        VerifyChunkNoLock(messages, toverify, pubkeys, c * chunkSize,
+                          min<unsigned int>((c + 1) * chunkSize, valid.size()),
+                          valid);
+      }
+    };
+
+    {
+      JoinableFunction joinableFunc(numThreads, worker);
+    }
+  } else
+#endif
+  {
+    // Verify every entry under one lock instead of taking it per signature
+    lock_guard<mutex> g(m_mutexSchnorr);
+    for (unsigned int c = 0; c < numChunks; c++) {
+      VerifyChunkNoLock(messages, toverify, pubkeys, c * chunkSize,
+                        min<unsigned int>((c + 1) * chunkSize, valid.size()),
+                        valid);
+    }
+  }
+
+  bool allValid = true;
+  for (unsigned int i = 0; i < valid.size(); i++) {
+    results[i] = (valid[i] != 0);
+    allValid = allValid && results[i];
+  }
+
+  return allValid;
+}
 
+void Schnorr::VerifyChunkNoLock(const vector<bytes>& messages,
+                                const vector<Signature>& toverify,
+                                const vector<PubKey>& pubkeys,
+                                unsigned int begin, unsigned int end,
+                                vector<unsigned char>& valid) {
+#if OPENSSL_VERSION_NUMBER < 0x30000000L  // deprecated in OpenSSL 3.0
+  // Regenerate every commitment of the chunk first, so that a single field
+  // inversion brings them all to affine form rather than one per signature
+  // when each is converted to octets
+  CurveScratch& scratch = GetThreadScratch();
+  array<EC_POINT*, VERIFY_CHUNK_SIZE> commits;
+  array<unsigned int, VERIFY_CHUNK_SIZE> indexes;
+  size_t count = 0;
+
+  for (unsigned int i = begin; i < end; i++) {
+    if (!CheckMessage(messages[i], 0, messages[i].size())) {
+      continue;
+    }
+    EC_POINT* Q = scratch.GetBatchPoint(count);
+    if ((Q != nullptr) &&
+        RegenerateCommitment(toverify[i], pubkeys[i], Q, scratch.m_ctx.get())) {
+      commits[count] = Q;
+      indexes[count] = i;
+      count++;
+    }
+  }
+
+  if ((count > 1) &&
+      (EC_POINTs_make_affine(m_curve.m_group.get(), count, commits.data(),
+                             scratch.m_ctx.get()) == 0)) {
+    // Each point is still converted on its own below
+    LOG_GENERAL(WARNING, "Commit batch normalization failed");
+  }
+
+  for (size_t j = 0; j < count; j++) {
+    const unsigned int i = indexes[j];
+    valid[i] = CheckChallenge(messages[i], 0, messages[i].size(), toverify[i],
+                              pubkeys[i], commits[j]);
+  }
+#else
+  for (unsigned int i = begin; i < end; i++) {
+    valid[i] = VerifyNoLock(messages[i], 0, messages[i].size(), toverify[i],
+                            pubkeys[i]);
+  }
+#endif
+}
+
+bool Schnorr::CheckMessage(const bytes& message, unsigned int offset,
+                           unsigned int size) {
   if (message.size() == 0) {
     LOG_GENERAL(WARNING, "Empty message");
     return false;
@@ -266,128 +416,127 @@ bool Schnorr::Verify(const bytes& message, unsigned int offset,
     return false;
   }
 
-  try {
-    // Main verification procedure
+  return true;
+}
 
-    // The algorithm to check the signature (r, s) on a message m using a public
-    // key kpub is as follows
-    // 1. Check if r,s is in [1, ..., order-1]
-    // 2. Compute Q = sG + r*kpub
-    // 3. If Q = O (the neutral point), return 0;
-    // 4. r' = H(Q, kpub, m)
-    // 5. return r' == r
+bool Schnorr::VerifyNoLock(const bytes& message, unsigned int offset,
+                           unsigned int size, const Signature& toverify,
+                           const PubKey& pubkey) {
+  // Initial checks
+  if (!CheckMessage(message, offset, size)) {
+    return false;
+  }
 
-    bytes buf(PUBKEY_COMPRESSED_SIZE_BYTES);
-    SHA2<HASH_TYPE::HASH_VARIANT_256> sha2;
+  // Main verification procedure
 
-    bool err = false;
-    bool err2 = false;
+  // The algorithm to check the signature (r, s) on a message m using a public
+  // key kpub is as follows
+  // 1. Check if r,s is in [1, ..., order-1]
+  // 2. Compute Q = sG + r*kpub
+  // 3. If Q = O (the neutral point), return 0;
+  // 4. r' = H(Q, kpub, m)
+  // 5. return r' == r
 
-    // Regenerate the commitmment part of the signature
-    unique_ptr<BIGNUM, void (*)(BIGNUM*)> challenge_built(BN_new(),
-                                                          BN_clear_free);
-    unique_ptr<EC_POINT, void (*)(EC_POINT*)> Q(
-        EC_POINT_new(m_curve.m_group.get()), EC_POINT_clear_free);
-    unique_ptr<BN_CTX, void (*)(BN_CTX*)> ctx(BN_CTX_new(), BN_CTX_free);
-
-    if ((challenge_built != nullptr) && (ctx != nullptr) && (Q != nullptr)) {
-      // 1. Check if r,s is in [1, ..., order-1]
-      err2 = (BN_is_zero(toverify.m_r.get()) ||
-              BN_is_negative(toverify.m_r.get()) ||
-              (BN_cmp(toverify.m_r.get(), m_curve.m_order.get()) != -1));
-      err = err || err2;
-      if (err2) {
-        LOG_GENERAL(WARNING, "Challenge not in range");
-        return false;
-      }
+  CurveScratch& scratch = GetThreadScratch();
+  EC_POINT* Q = scratch.m_point.get();
 
-      err2 = (BN_is_zero(toverify.m_s.get()) ||
-              BN_is_negative(toverify.m_s.get()) ||
-              (BN_cmp(toverify.m_s.get(), m_curve.m_order.get()) != -1));
-      err = err || err2;
-      if (err2) {
-        LOG_GENERAL(WARNING, "Response not in range");
-        return false;
-      }
+  return RegenerateCommitment(toverify, pubkey, Q, scratch.m_ctx.get()) &&
+         CheckChallenge(message, offset, size, toverify, pubkey, Q);
+}
 
-      // 2. Compute Q = sG + r*kpub
-      err2 =
-          (EC_POINT_mul(m_curve.m_group.get(), Q.get(), toverify.m_s.get(),
-                        pubkey.m_P.get(), toverify.m_r.get(), ctx.get()) == 0);
-      err = err || err2;
-      if (err2) {
-        LOG_GENERAL(WARNING, "Commit regenerate failed");
-        return false;
-      }
+bool Schnorr::RegenerateCommitment(const Signature& toverify,
+                                   const PubKey& pubkey, EC_POINT* Q,
+                                   BN_CTX* ctx) {
+  // 1. Check if r,s is in [1, ..., order-1]
+  if (BN_is_zero(toverify.m_r.get()) || BN_is_negative(toverify.m_r.get()) ||
+      (BN_cmp(toverify.m_r.get(), m_curve.m_order.get()) != -1)) {
+    LOG_GENERAL(WARNING, "Challenge not in range");
+    return false;
+  }
 
-      // 3. If Q = O (the neutral point), return 0;
-      err2 = (EC_POINT_is_at_infinity(m_curve.m_group.get(), Q.get()));
-      err = err || err2;
-      if (err2) {
-        LOG_GENERAL(WARNING, "Commit at infinity");
-        return false;
-      }
+  if (BN_is_zero(toverify.m_s.get()) || BN_is_negative(toverify.m_s.get()) ||
+      (BN_cmp(toverify.m_s.get(), m_curve.m_order.get()) != -1)) {
+    LOG_GENERAL(WARNING, "Response not in range");
+    return false;
+  }
 
-      // 4. r' = H(Q, kpub, m)
-      // 4.1 Convert the committment to octets first
-      err2 = (EC_POINT_point2oct(m_curve.m_group.get(), Q.get(),
-                                 POINT_CONVERSION_COMPRESSED, buf.data(),
-                                 PUBKEY_COMPRESSED_SIZE_BYTES,
-                                 NULL) != PUBKEY_COMPRESSED_SIZE_BYTES);
-      err = err || err2;
-      if (err2) {
-        LOG_GENERAL(WARNING, "Commit octet conversion failed");
-        return false;
-      }
+  // 2. Compute Q = sG + r*kpub
+  if (EC_POINT_mul(m_curve.m_group.get(), Q, toverify.m_s.get(),
+                   pubkey.m_P.get(), toverify.m_r.get(), ctx) == 0) {
+    LOG_GENERAL(WARNING, "Commit regenerate failed");
+    return false;
+  }
 
-      // Hash commitment
-      sha2.Update(buf);
+  // 3. If Q = O (the neutral point), return 0;
+  if (EC_POINT_is_at_infinity(m_curve.m_group.get(), Q)) {
+    LOG_GENERAL(WARNING, "Commit at infinity");
+    return false;
+  }
 
-      // Reset buf
-      fill(buf.begin(), buf.end(), 0x00);
+  return true;
+}
 
-      // 4.2 Convert the public key to octets
-      err2 = (EC_POINT_point2oct(m_curve.m_group.get(), pubkey.m_P.get(),
-                                 POINT_CONVERSION_COMPRESSED, buf.data(),
-                                 PUBKEY_COMPRESSED_SIZE_BYTES,
-                                 NULL) != PUBKEY_COMPRESSED_SIZE_BYTES);
-      err = err || err2;
-      if (err2) {
-        LOG_GENERAL(WARNING, "Pubkey octet conversion failed");
-        return false;
-      }
+bool Schnorr::CheckChallenge(const bytes& message, unsigned int offset,
+                             unsigned int size, const Signature& toverify,
+                             const PubKey& pubkey, const EC_POINT* Q) {
+  try {
+    bytes buf(PUBKEY_COMPRESSED_SIZE_BYTES);
+    SHA2<HASH_TYPE::HASH_VARIANT_256> sha2;
 
-      // Hash public key
-      sha2.Update(buf);
+    // Regenerate the commitmment part of the signature
+    unique_ptr<BIGNUM, void (*)(BIGNUM*)> challenge_built(BN_new(),
+                                                          BN_clear_free);
+    if (challenge_built == nullptr) {
+      LOG_GENERAL(WARNING, "Memory allocation failure");
+      return false;
+    }
 
-      // 4.3 Hash message
-      sha2.Update(message, offset, size);
-      bytes digest = sha2.Finalize();
+    // 4. r' = H(Q, kpub, m)
+    // 4.1 Convert the committment to octets first
+    if (EC_POINT_point2oct(m_curve.m_group.get(), Q,
+                           POINT_CONVERSION_COMPRESSED, buf.data(),
+                           PUBKEY_COMPRESSED_SIZE_BYTES,
+                           NULL) != PUBKEY_COMPRESSED_SIZE_BYTES) {
+      LOG_GENERAL(WARNING, "Commit octet conversion failed");
+      return false;
+    }
 
-      // 5. return r' == r
-      err2 = (BN_bin2bn(digest.data(), digest.size(), challenge_built.get()) ==
-              NULL);
-      err = err || err2;
-      if (err2) {
-        LOG_GENERAL(WARNING, "Challenge bin2bn conversion failed");
-        return false;
-      }
+    // Hash commitment
+    sha2.Update(buf);
 
-      err2 = (BN_nnmod(challenge_built.get(), challenge_built.get(),
-                       m_curve.m_order.get(), NULL) == 0);
-      err = err || err2;
-      if (err2) {
-        LOG_GENERAL(WARNING, "Challenge rebuild mod failed");
-        return false;
-      }
+    // Reset buf
+    fill(buf.begin(), buf.end(), 0x00);
 
-      sha2.Reset();
-    } else {
-      LOG_GENERAL(WARNING, "Memory allocation failure");
-      // throw exception();
+    // 4.2 Convert the public key to octets
+    if (EC_POINT_point2oct(m_curve.m_group.get(), pubkey.m_P.get(),
+                           POINT_CONVERSION_COMPRESSED, buf.data(),
+                           PUBKEY_COMPRESSED_SIZE_BYTES,
+                           NULL) != PUBKEY_COMPRESSED_SIZE_BYTES) {
+      LOG_GENERAL(WARNING, "Pubkey octet conversion failed");
+      return false;
+    }
+
+    // Hash public key
+    sha2.Update(buf);
+
+    // 4.3 Hash message
+    sha2.Update(message, offset, size);
+    bytes digest = sha2.Finalize();
+
+    // 5. return r' == r
+    if (BN_bin2bn(digest.data(), digest.size(), challenge_built.get()) ==
+        NULL) {
+      LOG_GENERAL(WARNING, "Challenge bin2bn conversion failed");
       return false;
     }
-    return (!err) && (BN_cmp(challenge_built.get(), toverify.m_r.get()) == 0);
+
+    if (BN_nnmod(challenge_built.get(), challenge_built.get(),
+                 m_curve.m_order.get(), NULL) == 0) {
+      LOG_GENERAL(WARNING, "Challenge rebuild mod failed");
+      return false;
+    }
+
+    return BN_cmp(challenge_built.get(), toverify.m_r.get()) == 0;
   } catch (const std::exception& e) {
     LOG_GENERAL(WARNING, "Error with Schnorr::Verify." << ' ' << e.what());
     return false;
@@ -47,6 +47,27 @@ struct Curve {
   ~Curve();
 };
 
+/// Per-thread scratch objects reused across EC-Schnorr operations instead of
+/// allocating them on every call.
+struct CurveScratch {
+  /// BIGNUM context, only used for temporaries inside OpenSSL calls.
+  std::unique_ptr<BN_CTX, void (*)(BN_CTX*)> m_ctx;
+
+  /// Point for intermediate results such as the regenerated commitment.
+  std::unique_ptr<EC_POINT, void (*)(EC_POINT*)> m_point;
+
+  /// Constructor.
+  explicit CurveScratch(const Curve& curve);
+
+  /// Returns the index-th point kept for the commitments of a batch, creating
+  /// it on first use. Returns nullptr if it cannot be allocated.
+  EC_POINT* GetBatchPoint(size_t index);
+
+ private:
+  std::shared_ptr<EC_GROUP> m_group;
+  std::vector<std::unique_ptr<EC_POINT, void (*)(EC_POINT*)>> m_batchPoints;
+};
+
 /// EC-Schnorr utility for serializing BIGNUM data type.
 struct BIGNUMSerialize {
   static std::mutex m_mutexBIGNUM;
@@ -114,8 +135,15 @@ class PrivKey : public Serializable {
 /// Stores information on an EC-Schnorr public key.
 class PubKey : public Serializable {
   bool constructPreChecks();
-  bool comparePreChecks(const PubKey& r, std::shared_ptr<BIGNUM>& lhs_bnvalue,
-                        std::shared_ptr<BIGNUM>& rhs_bnvalue) const;
+
+  /// Writes the compressed encoding of the point into buf and returns its
+  /// length, or 0 on failure.
+  size_t encodeCompressed(std::array<unsigned char, PUB_KEY_SIZE>& buf) const;
+
+  /// Returns the decoded point for a compressed encoding, decoding it only
+  /// the first time that encoding is seen.
+  static std::shared_ptr<const EC_POINT> GetInternedPoint(const bytes& src,
+                                                          unsigned int offset);
 
  public:
   /// The point on the curve.
@@ -157,6 +185,9 @@ class PubKey : public Serializable {
   /// Equality operator.
   bool operator==(const PubKey& r) const;
 
+  /// Returns a hash of the compressed encoding of the key.
+  std::size_t Hash() const;
+
   /// Utility std::string conversion function for public key info.
   explicit operator std::string() const {
     std::string output;
@@ -172,13 +203,7 @@ namespace std {
 template <>
 struct hash<PubKey> {
   size_t operator()(PubKey const& pubKey) const noexcept {
-    std::size_t seed = 0;
-    std::string pubKeyStr;
-    if (!DataConversion::SerializableToHexStr(pubKey, pubKeyStr)) {
-      return seed;
-    }
-    boost::hash_combine(seed, pubKeyStr);
-    return seed;
+    return pubKey.Hash();
   }
 };
 }  // namespace std
@@ -260,6 +285,34 @@ class Schnorr {
   Schnorr(Schnorr const&) = delete;
   void operator=(Schnorr const&) = delete;
 
+  /// Entries of a batch that one thread verifies together
+  static const unsigned int VERIFY_CHUNK_SIZE = 64;
+
+  /// Verification body shared by Verify and VerifyBatch. Caller must hold
+  /// m_mutexSchnorr unless OpenSSL is thread-safe, as for the helpers below.
+  bool VerifyNoLock(const bytes& message, unsigned int offset,
+                    unsigned int size, const Signature& toverify,
+                    const PubKey& pubkey);
+
+  /// Verifies the batch entries in [begin, end), at most VERIFY_CHUNK_SIZE
+  /// of them, setting valid[i] for each.
+  void VerifyChunkNoLock(const std::vector<bytes>& messages,
+                         const std::vector<Signature>& toverify,
+                         const std::vector<PubKey>& pubkeys, unsigned int begin,
+                         unsigned int end, std::vector<unsigned char>& valid);
+
+  static bool CheckMessage(const bytes& message, unsigned int offset,
+                           unsigned int size);
+
+  /// Steps 1 to 3 of Verify: range checks and Q = sG + r*kpub into Q
+  bool RegenerateCommitment(const Signature& toverify, const PubKey& pubkey,
+                            EC_POINT* Q, BN_CTX* ctx);
+
+  /// Steps 4 and 5 of Verify: whether H(Q, kpub, m) matches r
+  bool CheckChallenge(const bytes& message, unsigned int offset,
+                      unsigned int size, const Signature& toverify,
+                      const PubKey& pubkey, const EC_POINT* Q);
+
  public:
   /// Public key is a point (x, y) on the curve.
   /// Each coordinate requires 32 bytes.
@@ -275,6 +328,9 @@ class Schnorr {
   /// Returns the EC curve used.
   const Curve& GetCurve() const;
 
+  /// Returns the scratch objects owned by the calling thread.
+  static CurveScratch& GetThreadScratch();
+
   /// Generates a new PrivKey and PubKey pair.
   PairOfKey GenKeyPair();
 
@@ -296,6 +352,15 @@ class Schnorr {
   bool Verify(const bytes& message, unsigned int offset, unsigned int size,
               const Signature& toverify, const PubKey& pubkey);
 
+  /// Checks a batch of signatures, where toverify[i] and pubkeys[i] belong to
+  /// messages[i]. Returns true only if all are valid; results flags each one
+  /// so that the bad signatures can be singled out when the batch fails.
+  /// With numThreads > 1 the entries are spread across that many threads.
+  bool VerifyBatch(const std::vector<bytes>& messages,
+                   const std::vector<Signature>& toverify,
+                   const std::vector<PubKey>& pubkeys,
+                   std::vector<bool>& results, unsigned int numThreads = 1);
+
   /// Utility function for printing EC_POINT coordinates.
   void PrintPoint(const EC_POINT* point);
 };
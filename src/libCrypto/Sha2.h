@@ -19,7 +19,10 @@
 #define __SHA2_H__
 
 #include <openssl/sha.h>
+#include <algorithm>
+#include <cstring>
 #include <vector>
+#include "Sha256Backend.h"
 #include "libUtils/Logger.h"
 
 /// List of supported hash variants.
@@ -29,23 +32,29 @@ class HASH_TYPE {
   static const unsigned int HASH_VARIANT_512 = 512;
 };
 
-/// Implements SHA2 hash algorithm.
+/// Implements SHA2 hash algorithm. Blocks are compressed on the SHA
+/// instructions of the CPU where it has them, otherwise by OpenSSL.
 template <unsigned int SIZE>
 class SHA2 {
   static const unsigned int HASH_OUTPUT_SIZE = SIZE / 8;
+  static const unsigned int BLOCK_SIZE = Sha256Backend::BLOCK_SIZE;
+
+  /// nullptr when on OpenSSL
+  Sha256Backend::Compress m_compress;
   SHA256_CTX m_context;
-  bytes output;
+  uint32_t m_state[8];
+  unsigned char m_buffer[BLOCK_SIZE];
+  size_t m_buffered;
+  uint64_t m_length;
 
  public:
   /// Constructor.
-  SHA2() : output(HASH_OUTPUT_SIZE) {
-    if (SIZE != HASH_TYPE::HASH_VARIANT_256) {
-      LOG_GENERAL(FATAL, "assertion failed (" << __FILE__ << ":" << __LINE__
-                                              << ": " << __FUNCTION__ << ")");
-    }
+  SHA2() : SHA2(Sha256Backend::GetDefaultCompress()) {}
 
-    Reset();
-  }
+  /// Constructor for the given backend, falling back to OpenSSL if the CPU
+  /// cannot run it.
+  explicit SHA2(Sha256Backend::Kind backend)
+      : SHA2(Sha256Backend::GetCompress(backend)) {}
 
   /// Destructor.
   ~SHA2() {}
@@ -57,7 +66,7 @@ class SHA2 {
       return;
     }
 
-    SHA256_Update(&m_context, input.data(), input.size());
+    Update(input.data(), input.size());
   }
 
   /// Hash update function.
@@ -67,23 +76,100 @@ class SHA2 {
                                               << ": " << __FUNCTION__ << ")");
     }
 
-    SHA256_Update(&m_context, input.data() + offset, size);
+    Update(input.data() + offset, size);
+  }
+
+  /// Hash update function, for input that is not held in bytes.
+  void Update(const unsigned char* input, size_t size) {
+    if (m_compress == nullptr) {
+      SHA256_Update(&m_context, input, size);
+      return;
+    }
+
+    m_length += size;
+
+    if (m_buffered > 0) {
+      const size_t taken = std::min<size_t>(size, BLOCK_SIZE - m_buffered);
+      memcpy(m_buffer + m_buffered, input, taken);
+      m_buffered += taken;
+      input += taken;
+      size -= taken;
+      if (m_buffered < BLOCK_SIZE) {
+        return;
+      }
+      m_compress(m_state, m_buffer, 1);
+      m_buffered = 0;
+    }
+
+    // Whole blocks are hashed straight from the input
+    const size_t numBlocks = size / BLOCK_SIZE;
+    if (numBlocks > 0) {
+      m_compress(m_state, input, numBlocks);
+      input += numBlocks * BLOCK_SIZE;
+      size -= numBlocks * BLOCK_SIZE;
+    }
+
+    memcpy(m_buffer, input, size);
+    m_buffered = size;
   }
 
   /// Resets the algorithm.
-  void Reset() { SHA256_Init(&m_context); }
+  void Reset() {
+    if (m_compress == nullptr) {
+      SHA256_Init(&m_context);
+      return;
+    }
+
+    memcpy(m_state, Sha256Backend::GetInitialState(), sizeof(m_state));
+    m_buffered = 0;
+    m_length = 0;
+  }
+
+  /// Hash finalize function, writing the HASH_OUTPUT_SIZE bytes of the hash
+  /// to out rather than to a new bytes. Reset before hashing anew.
+  void Finalize(unsigned char* out) {
+    if (m_compress == nullptr) {
+      SHA256_Final(out, &m_context);
+      return;
+    }
+
+    // Pad with 0x80, zeros and the length in bits, to a whole block
+    const uint64_t bits = m_length * 8;
+    m_buffer[m_buffered++] = 0x80;
+    if (m_buffered > BLOCK_SIZE - 8) {
+      memset(m_buffer + m_buffered, 0, BLOCK_SIZE - m_buffered);
+      m_compress(m_state, m_buffer, 1);
+      m_buffered = 0;
+    }
+    memset(m_buffer + m_buffered, 0, BLOCK_SIZE - 8 - m_buffered);
+    for (unsigned int i = 0; i < 8; i++) {
+      m_buffer[BLOCK_SIZE - 1 - i] =
+          static_cast<unsigned char>(bits >> (8 * i));
+    }
+    m_compress(m_state, m_buffer, 1);
+
+    for (unsigned int i = 0; i < HASH_OUTPUT_SIZE; i++) {
+      out[i] = static_cast<unsigned char>(m_state[i / 4] >> (24 - 8 * (i % 4)));
+    }
+  }
 
   /// Hash finalize function.
   bytes Finalize() {
-    switch (SIZE) {
-      case 256:
-        SHA256_Final(output.data(), &m_context);
-        break;
-      default:
-        break;
-    }
+    bytes output(HASH_OUTPUT_SIZE);
+    Finalize(output.data());
     return output;
   }
+
+ private:
+  explicit SHA2(Sha256Backend::Compress compress)
+      : m_compress(compress) {
+    if (SIZE != HASH_TYPE::HASH_VARIANT_256) {
+      LOG_GENERAL(FATAL, "assertion failed (" << __FILE__ << ":" << __LINE__
+                                              << ": " << __FUNCTION__ << ")");
+    }
+
+    Reset();
+  }
 };
 
 #endif  // __SHA2_H__
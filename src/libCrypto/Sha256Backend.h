@@ -0,0 +1,318 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SHA256BACKEND_H__
+#define __SHA256BACKEND_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define SHA256_BACKEND_X86
+#elif defined(__aarch64__) && defined(__linux__)
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2 (1 << 6)
+#endif
+#define SHA256_BACKEND_ARMV8
+#endif
+
+/// SHA-256 block compression on the hash instructions of the CPU (SHA-NI on
+/// x86, the crypto extensions on ARMv8). The backend is picked at run time;
+/// where the CPU has neither, SHA2 stays on OpenSSL.
+class Sha256Backend {
+ public:
+  enum Kind { OPENSSL, SHA_NI, ARMV8 };
+
+  static constexpr size_t BLOCK_SIZE = 64;
+
+  /// Hashes numBlocks consecutive 64-byte blocks into state
+  typedef void (*Compress)(uint32_t* state, const unsigned char* blocks,
+                           size_t numBlocks);
+
+  /// Whether this build and CPU can run the backend. The CPU is queried
+  /// once, as that can trap to the hypervisor.
+  static bool IsSupported(Kind kind) {
+    static const bool supported[] = {true, Detect(SHA_NI), Detect(ARMV8)};
+    return kind >= OPENSSL && kind <= ARMV8 && supported[kind];
+  }
+
+  /// nullptr for OPENSSL or a backend this build or CPU cannot run
+  static Compress GetCompress(Kind kind) {
+    return IsSupported(kind) ? CompressOf(kind) : nullptr;
+  }
+
+  /// The fastest backend that runs here and hashes a known input right
+  static Kind GetDefault() {
+    static const Kind kind = []() {
+      for (const Kind candidate : {SHA_NI, ARMV8}) {
+        if (SelfTest(candidate)) {
+          return candidate;
+        }
+      }
+      return OPENSSL;
+    }();
+    return kind;
+  }
+
+  /// GetCompress(GetDefault())
+  static Compress GetDefaultCompress() {
+    static const Compress compress = CompressOf(GetDefault());
+    return compress;
+  }
+
+  static const char* GetName(Kind kind) {
+    switch (kind) {
+      case SHA_NI:
+        return "SHA-NI";
+      case ARMV8:
+        return "ARMv8";
+      default:
+        return "OpenSSL";
+    }
+  }
+
+  static const uint32_t* GetInitialState() {
+    static const uint32_t initialState[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+        0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+    return initialState;
+  }
+
+ private:
+  static bool Detect(Kind kind) {
+    switch (kind) {
+#ifdef SHA256_BACKEND_X86
+      case SHA_NI: {
+        unsigned int eax, ebx, ecx, edx;
+        // SHA-NI, and the SSSE3 and SSE4.1 used around it
+        if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) == 0 ||
+            (ebx & (1u << 29)) == 0 ||
+            __get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0) {
+          return false;
+        }
+        return (ecx & (1u << 9)) != 0 && (ecx & (1u << 19)) != 0;
+      }
+#endif
+#ifdef SHA256_BACKEND_ARMV8
+      case ARMV8:
+        return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+#endif
+      default:
+        return false;
+    }
+  }
+
+  static Compress CompressOf(Kind kind) {
+    switch (kind) {
+#ifdef SHA256_BACKEND_X86
+      case SHA_NI:
+        return CompressShaNi;
+#endif
+#ifdef SHA256_BACKEND_ARMV8
+      case ARMV8:
+        return CompressArmV8;
+#endif
+      default:
+        return nullptr;
+    }
+  }
+
+  /// The round constants
+  static const uint32_t* GetK() {
+    static const uint32_t k[64] = {
+        0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+        0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+        0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+        0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+        0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+        0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+        0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+        0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+        0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+        0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+        0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+    return k;
+  }
+
+  /// Compresses the padded block of "abc" and compares with its digest
+  static bool SelfTest(Kind kind) {
+    const Compress compress = GetCompress(kind);
+    if (compress == nullptr) {
+      return false;
+    }
+
+    unsigned char block[BLOCK_SIZE] = {'a', 'b', 'c', 0x80};
+    block[BLOCK_SIZE - 1] = 24;
+    uint32_t state[8];
+    memcpy(state, GetInitialState(), sizeof(state));
+    compress(state, block, 1);
+
+    static const uint32_t expected[8] = {0xba7816bf, 0x8f01cfea, 0x414140de,
+                                         0x5dae2223, 0xb00361a3, 0x96177a9c,
+                                         0xb410ff61, 0xf20015ad};
+    return memcmp(state, expected, sizeof(state)) == 0;
+  }
+
+#ifdef SHA256_BACKEND_X86
+#define SHA256_NI_TARGET __attribute__((target("sha,sse4.1"), always_inline))
+
+  /// Four rounds on the message words w. The state is kept as ABEF and CDGH,
+  /// the order sha256rnds2 takes.
+  SHA256_NI_TARGET static inline void RoundsShaNi(__m128i& state0,
+                                                  __m128i& state1, __m128i w,
+                                                  const uint32_t* k) {
+    w = _mm_add_epi32(w, _mm_loadu_si128(reinterpret_cast<const __m128i*>(k)));
+    state1 = _mm_sha256rnds2_epu32(state1, state0, w);
+    state0 = _mm_sha256rnds2_epu32(state0, state1, _mm_shuffle_epi32(w, 0x0E));
+  }
+
+  /// The next four words of the message schedule, from the last sixteen
+  SHA256_NI_TARGET static inline __m128i ScheduleShaNi(__m128i w0, __m128i w1,
+                                                       __m128i w2,
+                                                       __m128i w3) {
+    w0 = _mm_sha256msg1_epu32(w0, w1);
+    w0 = _mm_add_epi32(w0, _mm_alignr_epi8(w3, w2, 4));
+    return _mm_sha256msg2_epu32(w0, w3);
+  }
+
+  __attribute__((target("sha,sse4.1"))) static void CompressShaNi(
+      uint32_t* state, const unsigned char* blocks, size_t numBlocks) {
+    const uint32_t* k = GetK();
+    const __m128i byteSwap =
+        _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    __m128i tmp = _mm_loadu_si128(reinterpret_cast<const __m128i*>(state));
+    __m128i state1 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(state + 4));
+    tmp = _mm_shuffle_epi32(tmp, 0xB1);
+    state1 = _mm_shuffle_epi32(state1, 0x1B);
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    for (; numBlocks > 0; --numBlocks, blocks += BLOCK_SIZE) {
+      const __m128i abefSave = state0;
+      const __m128i cdghSave = state1;
+      const __m128i* words = reinterpret_cast<const __m128i*>(blocks);
+
+      __m128i w0 = _mm_shuffle_epi8(_mm_loadu_si128(words), byteSwap);
+      __m128i w1 = _mm_shuffle_epi8(_mm_loadu_si128(words + 1), byteSwap);
+      __m128i w2 = _mm_shuffle_epi8(_mm_loadu_si128(words + 2), byteSwap);
+      __m128i w3 = _mm_shuffle_epi8(_mm_loadu_si128(words + 3), byteSwap);
+      RoundsShaNi(state0, state1, w0, k);
+      RoundsShaNi(state0, state1, w1, k + 4);
+      RoundsShaNi(state0, state1, w2, k + 8);
+      RoundsShaNi(state0, state1, w3, k + 12);
+
+      for (unsigned int round = 16; round < 64; round += 16) {
+        w0 = ScheduleShaNi(w0, w1, w2, w3);
+        RoundsShaNi(state0, state1, w0, k + round);
+        w1 = ScheduleShaNi(w1, w2, w3, w0);
+        RoundsShaNi(state0, state1, w1, k + round + 4);
+        w2 = ScheduleShaNi(w2, w3, w0, w1);
+        RoundsShaNi(state0, state1, w2, k + round + 8);
+        w3 = ScheduleShaNi(w3, w0, w1, w2);
+        RoundsShaNi(state0, state1, w3, k + round + 12);
+      }
+
+      state0 = _mm_add_epi32(state0, abefSave);
+      state1 = _mm_add_epi32(state1, cdghSave);
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(tmp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, tmp, 8);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state), state0);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(state + 4), state1);
+  }
+
+#undef SHA256_NI_TARGET
+#endif
+
+#ifdef SHA256_BACKEND_ARMV8
+#define SHA256_ARM_TARGET \
+  __attribute__((target("arch=armv8-a+crypto"), always_inline))
+
+  /// Four rounds on the message words w, with the state kept as ABCD and
+  /// EFGH
+  SHA256_ARM_TARGET static inline void RoundsArmV8(uint32x4_t& state0,
+                                                   uint32x4_t& state1,
+                                                   uint32x4_t w,
+                                                   const uint32_t* k) {
+    w = vaddq_u32(w, vld1q_u32(k));
+    const uint32x4_t abcd = state0;
+    state0 = vsha256hq_u32(state0, state1, w);
+    state1 = vsha256h2q_u32(state1, abcd, w);
+  }
+
+  /// The next four words of the message schedule, from the last sixteen
+  SHA256_ARM_TARGET static inline uint32x4_t ScheduleArmV8(uint32x4_t w0,
+                                                           uint32x4_t w1,
+                                                           uint32x4_t w2,
+                                                           uint32x4_t w3) {
+    return vsha256su1q_u32(vsha256su0q_u32(w0, w1), w2, w3);
+  }
+
+  __attribute__((target("arch=armv8-a+crypto"))) static void CompressArmV8(
+      uint32_t* state, const unsigned char* blocks, size_t numBlocks) {
+    const uint32_t* k = GetK();
+    uint32x4_t state0 = vld1q_u32(state);
+    uint32x4_t state1 = vld1q_u32(state + 4);
+
+    for (; numBlocks > 0; --numBlocks, blocks += BLOCK_SIZE) {
+      const uint32x4_t abcdSave = state0;
+      const uint32x4_t efghSave = state1;
+
+      uint32x4_t w0 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks)));
+      uint32x4_t w1 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 16)));
+      uint32x4_t w2 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 32)));
+      uint32x4_t w3 = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + 48)));
+      RoundsArmV8(state0, state1, w0, k);
+      RoundsArmV8(state0, state1, w1, k + 4);
+      RoundsArmV8(state0, state1, w2, k + 8);
+      RoundsArmV8(state0, state1, w3, k + 12);
+
+      for (unsigned int round = 16; round < 64; round += 16) {
+        w0 = ScheduleArmV8(w0, w1, w2, w3);
+        RoundsArmV8(state0, state1, w0, k + round);
+        w1 = ScheduleArmV8(w1, w2, w3, w0);
+        RoundsArmV8(state0, state1, w1, k + round + 4);
+        w2 = ScheduleArmV8(w2, w3, w0, w1);
+        RoundsArmV8(state0, state1, w2, k + round + 8);
+        w3 = ScheduleArmV8(w3, w0, w1, w2);
+        RoundsArmV8(state0, state1, w3, k + round + 12);
+      }
+
+      state0 = vaddq_u32(state0, abcdSave);
+      state1 = vaddq_u32(state1, efghSave);
+    }
+
+    vst1q_u32(state, state0);
+    vst1q_u32(state + 4, state1);
+  }
+
+#undef SHA256_ARM_TARGET
+#endif
+};
+
+#endif  // __SHA256BACKEND_H__
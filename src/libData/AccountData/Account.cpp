@@ -38,6 +38,40 @@ using namespace Contract;
 // =======================================
 // AccountBase
 
+namespace {
+
+// First bytes of the compact layout. A protobuf AccountBase always starts with
+// the tag of its version field (0x08), so the two formats cannot be confused.
+const uint8_t COMPACT_ACCOUNT_TAG = 0xF0;
+const uint8_t COMPACT_CONTRACT_TAG = 0xF1;
+
+const unsigned int COMPACT_ACCOUNT_SIZE =
+    1 + sizeof(uint32_t) + UINT128_SIZE + sizeof(uint64_t);
+const unsigned int COMPACT_CONTRACT_SIZE =
+    COMPACT_ACCOUNT_SIZE + 2 * COMMON_HASH_SIZE;
+
+template <class T>
+void PutBigEndian(bytes& dst, unsigned int& pos, const T& number,
+                  unsigned int size) {
+  for (unsigned int i = 0; i < size; i++) {
+    dst[pos + i] =
+        static_cast<uint8_t>((number >> (8 * (size - 1 - i))) & 0xFF);
+  }
+  pos += size;
+}
+
+template <class T>
+T GetBigEndian(const bytes& src, unsigned int& pos, unsigned int size) {
+  T number = 0;
+  for (unsigned int i = 0; i < size; i++) {
+    number = (number << 8) | src[pos + i];
+  }
+  pos += size;
+  return number;
+}
+
+}  // namespace
+
 AccountBase::AccountBase(const uint128_t& balance, const uint64_t& nonce,
                          const uint32_t& version)
     : m_version(version),
@@ -47,6 +81,11 @@ AccountBase::AccountBase(const uint128_t& balance, const uint64_t& nonce,
       m_codeHash(h256()) {}
 
 bool AccountBase::Serialize(bytes& dst, unsigned int offset) const {
+  if (m_version >= COMPACT_ACCOUNT_VERSION) {
+    SerializeCompact(dst, offset);
+    return true;
+  }
+
   if (!Messenger::SetAccountBase(dst, offset, *this)) {
     LOG_GENERAL(WARNING, "Messenger::SetAccount failed.");
     return false;
@@ -58,6 +97,11 @@ bool AccountBase::Serialize(bytes& dst, unsigned int offset) const {
 bool AccountBase::Deserialize(const bytes& src, unsigned int offset) {
   // LOG_MARKER();
 
+  if (offset < src.size() && (src[offset] == COMPACT_ACCOUNT_TAG ||
+                              src[offset] == COMPACT_CONTRACT_TAG)) {
+    return DeserializeCompact(src, offset);
+  }
+
   if (!Messenger::GetAccountBase(src, offset, *this)) {
     LOG_GENERAL(WARNING, "Messenger::GetAccount failed.");
     return false;
@@ -66,6 +110,59 @@ bool AccountBase::Deserialize(const bytes& src, unsigned int offset) {
   return true;
 }
 
+void AccountBase::SerializeCompact(bytes& dst, unsigned int offset) const {
+  const bool contract = isContract() || (m_storageRoot != h256());
+  const unsigned int size =
+      contract ? COMPACT_CONTRACT_SIZE : COMPACT_ACCOUNT_SIZE;
+  if (dst.size() < offset + size) {
+    dst.resize(offset + size);
+  }
+
+  unsigned int pos = offset;
+  dst[pos++] = contract ? COMPACT_CONTRACT_TAG : COMPACT_ACCOUNT_TAG;
+  PutBigEndian(dst, pos, m_version, sizeof(uint32_t));
+  PutBigEndian(dst, pos, m_balance, UINT128_SIZE);
+  PutBigEndian(dst, pos, m_nonce, sizeof(uint64_t));
+  if (contract) {
+    copy(m_storageRoot.begin(), m_storageRoot.end(), dst.begin() + pos);
+    pos += COMMON_HASH_SIZE;
+    copy(m_codeHash.begin(), m_codeHash.end(), dst.begin() + pos);
+  }
+}
+
+bool AccountBase::DeserializeCompact(const bytes& src, unsigned int offset) {
+  if (offset >= src.size()) {
+    LOG_GENERAL(WARNING, "No compact account at offset " << offset);
+    return false;
+  }
+
+  const bool contract = (src[offset] == COMPACT_CONTRACT_TAG);
+  const unsigned int size =
+      contract ? COMPACT_CONTRACT_SIZE : COMPACT_ACCOUNT_SIZE;
+  if (src.size() - offset != size) {
+    LOG_GENERAL(WARNING, "Compact account size " << src.size() - offset
+                                                 << " expected " << size);
+    return false;
+  }
+
+  unsigned int pos = offset + 1;
+  m_version = GetBigEndian<uint32_t>(src, pos, sizeof(uint32_t));
+  m_balance = GetBigEndian<uint128_t>(src, pos, UINT128_SIZE);
+  m_nonce = GetBigEndian<uint64_t>(src, pos, sizeof(uint64_t));
+  if (contract) {
+    copy(src.begin() + pos, src.begin() + pos + COMMON_HASH_SIZE,
+         m_storageRoot.asArray().begin());
+    pos += COMMON_HASH_SIZE;
+    copy(src.begin() + pos, src.begin() + pos + COMMON_HASH_SIZE,
+         m_codeHash.asArray().begin());
+  } else {
+    m_storageRoot = h256();
+    m_codeHash = h256();
+  }
+
+  return true;
+}
+
 void AccountBase::SetVersion(const uint32_t& version) { m_version = version; }
 
 const uint32_t& AccountBase::GetVersion() const { return m_version; }
@@ -246,8 +343,8 @@ string Account::GetRawStorage(const h256& k_hash, bool temp) const {
     //             "Not contract account, why call Account::GetRawStorage!");
     return "";
   }
-  return ContractStorage::GetContractStorage().GetContractStateData(k_hash,
-                                                                    temp);
+  return ContractStorage::GetContractStorage().GetContractStateData(
+      m_address, k_hash, temp);
 }
 
 bool Account::PrepareInitDataJson(const bytes& initData, const Address& addr,
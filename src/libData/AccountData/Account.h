@@ -19,7 +19,6 @@
 #define __ACCOUNT_H__
 
 #include <json/json.h>
-#include <leveldb/db.h>
 #include <array>
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
@@ -30,6 +29,7 @@
 #include "Address.h"
 #include "common/Constants.h"
 #include "common/Serializable.h"
+#include "depends/libDatabase/KVBackend.h"
 #include "libPersistence/ContractStorage.h"
 
 #pragma GCC diagnostic push
@@ -48,6 +48,12 @@ static uint32_t scilla_version_place_holder;
 template <class KeyType, class DB>
 using AccountTrieDB = dev::SpecificTrieDB<dev::GenericTrieDB<DB>, KeyType>;
 
+/// Accounts from this version on are stored in a fixed binary layout instead
+/// of protobuf:
+/// tag (1) | version (4) | balance (16) | nonce (8) [| storageRoot (32) |
+/// codeHash (32)], integers big-endian, the hashes present only for contracts
+const uint32_t COMPACT_ACCOUNT_VERSION = 2;
+
 class AccountBase : public SerializableDataBlock {
  protected:
   uint32_t m_version;
@@ -66,8 +72,15 @@ class AccountBase : public SerializableDataBlock {
   bool Serialize(bytes& dst, unsigned int offset) const;
 
   /// Implements the Deserialize function inherited from Serializable.
+  /// Reads both the protobuf and the compact layout.
   bool Deserialize(const bytes& src, unsigned int offset);
 
+  /// Writes the COMPACT_ACCOUNT_VERSION layout regardless of m_version
+  void SerializeCompact(bytes& dst, unsigned int offset) const;
+
+  /// Reads the COMPACT_ACCOUNT_VERSION layout without allocating
+  bool DeserializeCompact(const bytes& src, unsigned int offset);
+
   void SetVersion(const uint32_t& version);
 
   const uint32_t& GetVersion() const;
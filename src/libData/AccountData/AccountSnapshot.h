@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __ACCOUNTSNAPSHOT_H__
+#define __ACCOUNTSNAPSHOT_H__
+
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include <boost/multiprecision/cpp_int.hpp>
+#pragma GCC diagnostic pop
+
+#include "Address.h"
+#include "depends/common/FixedHash.h"
+
+/// Committed balance and nonce of an account, as seen by an AccountSnapshot
+struct AccountSnapshotEntry {
+  boost::multiprecision::uint128_t m_balance{0};
+  uint64_t m_nonce{0};
+  /// false if the account was removed, or was never created
+  bool m_exists{false};
+};
+
+/// Immutable version of the committed account state. Each commit publishes a
+/// new version on top of the previous one, holding only the accounts that
+/// commit changed; accounts that no version changed are read from the state
+/// trie at GetRoot(), the root last moved to disk. Versions are never
+/// modified once made, so readers holding one need no lock, and keep seeing
+/// the state of one commit while newer versions are published.
+class AccountSnapshot {
+ public:
+  using Changes = std::unordered_map<Address, AccountSnapshotEntry>;
+
+  /// Versions chained past this depth are merged into one on Extend, which
+  /// bounds the number of maps a lookup walks
+  static constexpr unsigned int MAX_DEPTH = 16;
+
+  /// A version with no changes over the state at root
+  static std::shared_ptr<const AccountSnapshot> Rebase(const dev::h256& root) {
+    return std::shared_ptr<const AccountSnapshot>(
+        new AccountSnapshot(root, Changes(), nullptr));
+  }
+
+  /// A version with changes on top of prev
+  static std::shared_ptr<const AccountSnapshot> Extend(
+      const std::shared_ptr<const AccountSnapshot>& prev, Changes&& changes) {
+    if (prev->m_depth < MAX_DEPTH) {
+      return std::shared_ptr<const AccountSnapshot>(
+          new AccountSnapshot(prev->m_root, std::move(changes), prev));
+    }
+
+    // Newer changes win, so only fill in the accounts they do not hold
+    for (const AccountSnapshot* v = prev.get(); v != nullptr;
+         v = v->m_prev.get()) {
+      for (const auto& entry : v->m_changes) {
+        changes.emplace(entry);
+      }
+    }
+    return std::shared_ptr<const AccountSnapshot>(
+        new AccountSnapshot(prev->m_root, std::move(changes), nullptr));
+  }
+
+  const dev::h256& GetRoot() const { return m_root; }
+
+  unsigned int GetDepth() const { return m_depth; }
+
+  /// Returns false if no version since the root changed the account, in which
+  /// case it must be read from the trie at GetRoot()
+  bool Find(const Address& address, AccountSnapshotEntry& entry) const {
+    for (const AccountSnapshot* v = this; v != nullptr; v = v->m_prev.get()) {
+      auto it = v->m_changes.find(address);
+      if (it != v->m_changes.end()) {
+        entry = it->second;
+        return true;
+      }
+    }
+    return false;
+  }
+
+ private:
+  AccountSnapshot(const dev::h256& root, Changes&& changes,
+                  std::shared_ptr<const AccountSnapshot> prev)
+      : m_root(root),
+        m_changes(std::move(changes)),
+        m_prev(std::move(prev)),
+        m_depth(m_prev ? m_prev->m_depth + 1 : 1) {}
+
+  const dev::h256 m_root;
+  const Changes m_changes;
+  const std::shared_ptr<const AccountSnapshot> m_prev;
+  const unsigned int m_depth;
+};
+
+#endif  // __ACCOUNTSNAPSHOT_H__
@@ -15,13 +15,19 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
-#include <leveldb/db.h>
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <numeric>
 
 #include "AccountStore.h"
+#include "depends/libDatabase/KVBackend.h"
 #include "libCrypto/Sha2.h"
 #include "libMessage/Messenger.h"
 #include "libPersistence/BlockStorage.h"
 #include "libPersistence/ContractStorage.h"
+#include "libUtils/JoinableFunction.h"
+#include "libUtils/MemoryStats.h"
 #include "libUtils/SysCommand.h"
 
 using namespace std;
@@ -29,8 +35,58 @@ using namespace dev;
 using namespace boost::multiprecision;
 using namespace Contract;
 
+namespace {
+// Private copy of the accounts touched by one group of payment txns, so that
+// groups can be applied concurrently without sharing AccountStoreTemp
+class PaymentOverlay : public AccountStoreBase<map<Address, Account>> {
+ public:
+  bool UpdateAccounts(const Transaction& transaction,
+                      TransactionReceipt& receipt) {
+    // Same check AccountStoreSC does before handing over a payment
+    const Account* toAccount = GetAccount(transaction.GetToAddr());
+    if (toAccount != nullptr && toAccount->isContract()) {
+      LOG_GENERAL(WARNING, "Contract account won't accept normal txn");
+      return false;
+    }
+
+    return AccountStoreBase<map<Address, Account>>::UpdateAccounts(transaction,
+                                                                   receipt);
+  }
+
+  const map<Address, Account>& GetAddressToAccount() const {
+    return *m_addressToAccount;
+  }
+};
+}  // namespace
+
 AccountStore::AccountStore() {
   m_accountStoreTemp = make_unique<AccountStoreTemp>(*this);
+
+  // Contract code and states are not counted, they are in ContractStorage
+  MemoryStats::GetInstance().Register("accountstore", [this]() {
+    shared_lock<shared_timed_mutex> lock(m_mutexPrimary);
+    MemoryStats::Usage usage;
+    usage.m_entries = m_addressToAccount->size();
+    usage.m_bytes = MemoryStats::NodeBytes(*m_addressToAccount);
+    return usage;
+  });
+  MemoryStats::GetInstance().Register("accountstore.revertibles", [this]() {
+    lock_guard<mutex> g(m_mutexRevertibles);
+    MemoryStats::Usage usage;
+    usage.m_entries = m_undoJournal.size();
+    usage.m_bytes = m_undoJournal.capacity() * sizeof(UndoEntry) +
+                    MemoryStats::NodeBytes(m_undoTouched);
+    return usage;
+  });
+  MemoryStats::GetInstance().Register("accountstore.temp", [this]() {
+    lock_guard<mutex> g(m_mutexDelta);
+    const auto& accounts = *m_accountStoreTemp->GetAddressToAccount();
+    MemoryStats::Usage usage;
+    usage.m_entries = accounts.size();
+    usage.m_bytes =
+        MemoryStats::NodeBytes(accounts) + m_stateDeltaSerialized.size();
+    return usage;
+  });
 }
 
 AccountStore::~AccountStore() {
@@ -53,7 +109,9 @@ void AccountStore::InitSoft() {
 
   unique_lock<shared_timed_mutex> g(m_mutexPrimary);
 
-  AccountStoreTrie<OverlayDB, unordered_map<Address, Account>>::Init();
+  ClearSnapshot();
+
+  AccountStoreTrie<OverlayDB, FixedHashMap<Address, Account>>::Init();
 
   InitRevertibles();
 
@@ -82,23 +140,114 @@ void AccountStore::InitRevertibles() {
 
   lock_guard<mutex> g(m_mutexRevertibles);
 
-  m_addressToAccountRevChanged.clear();
-  m_addressToAccountRevCreated.clear();
+  m_undoJournal.clear();
+  m_undoTouched.clear();
 
   ContractStorage::GetContractStorage().InitRevertibles();
 }
 
+void AccountStore::RecordUndo(const Address& address, const Account& previous,
+                              bool created) {
+  if (!m_undoTouched.emplace(address).second) {
+    return;
+  }
+  if (created) {
+    m_undoJournal.push_back({address, true, Account()});
+  } else {
+    m_undoJournal.push_back({address, false, previous});
+  }
+}
+
 AccountStore& AccountStore::GetInstance() {
   static AccountStore accountstore;
   return accountstore;
 }
 
+template <class Container>
+void AccountStore::PublishSnapshotChanges(const Container& addresses) {
+  const shared_ptr<const AccountSnapshot> snapshot = atomic_load(&m_snapshot);
+  if (!snapshot) {
+    // Nothing to build on, the accounts are read under the lock until the
+    // next commit to disk
+    return;
+  }
+
+  AccountSnapshot::Changes changes;
+  for (const auto& address : addresses) {
+    AccountSnapshotEntry& entry = changes[address];
+    auto it = m_addressToAccount->find(address);
+    if (it != m_addressToAccount->end()) {
+      entry.m_balance = it->second.GetBalance();
+      entry.m_nonce = it->second.GetNonce();
+      entry.m_exists = true;
+    }
+  }
+
+  atomic_store(&m_snapshot, AccountSnapshot::Extend(snapshot, move(changes)));
+}
+
+void AccountStore::PublishSnapshotRoot(const h256& root) {
+  atomic_store(&m_snapshot, AccountSnapshot::Rebase(root));
+}
+
+void AccountStore::ClearSnapshot() {
+  atomic_store(&m_snapshot, shared_ptr<const AccountSnapshot>());
+  m_snapshotClears++;
+}
+
+bool AccountStore::GetAccountFromSnapshot(const Address& address,
+                                          AccountSnapshotEntry& entry) {
+  const uint64_t clears = m_snapshotClears;
+  const shared_ptr<const AccountSnapshot> snapshot = atomic_load(&m_snapshot);
+  if (!snapshot) {
+    return false;
+  }
+
+  if (snapshot->Find(address, entry)) {
+    return true;
+  }
+
+  string rawAccountBase;
+  try {
+    // A view of its own, as m_state moves on with the uncommitted updates
+    SpecificTrieDB<GenericTrieDB<OverlayDB>, Address> state(
+        &m_db, snapshot->GetRoot(), Verification::Skip);
+    rawAccountBase = state.at(address);
+  } catch (const boost::exception& e) {
+    LOG_GENERAL(WARNING, "Error with AccountStore::GetAccountFromSnapshot. "
+                             << boost::diagnostic_information(e));
+    return false;
+  }
+
+  // The trie nodes of the root are only dropped after ClearSnapshot, so the
+  // read holds unless one happened meanwhile
+  if (m_snapshotClears != clears) {
+    return false;
+  }
+
+  AccountSnapshotEntry found;
+  if (!rawAccountBase.empty()) {
+    Account account;
+    if (!account.DeserializeBase(
+            bytes(rawAccountBase.begin(), rawAccountBase.end()), 0)) {
+      LOG_GENERAL(WARNING, "Account::DeserializeBase failed");
+      return false;
+    }
+    found.m_balance = account.GetBalance();
+    found.m_nonce = account.GetNonce();
+    found.m_exists = true;
+  }
+  entry = found;
+
+  return true;
+}
+
 bool AccountStore::Serialize(bytes& src, unsigned int offset) const {
   LOG_MARKER();
   shared_lock<shared_timed_mutex> lock(m_mutexPrimary);
-  return AccountStoreTrie<
-      dev::OverlayDB, std::unordered_map<Address, Account>>::Serialize(src,
-                                                                       offset);
+  return AccountStoreTrie<dev::OverlayDB,
+                          FixedHashMap<Address, Account>>::Serialize(src,
+                                                                     offset);
 }
 
 bool AccountStore::Deserialize(const bytes& src, unsigned int offset) {
@@ -108,7 +257,37 @@ bool AccountStore::Deserialize(const bytes& src, unsigned int offset) {
 
   unique_lock<shared_timed_mutex> g(m_mutexPrimary);
 
-  if (!Messenger::GetAccountStore(src, offset, *this)) {
+  const bool ret = Messenger::GetAccountStore(src, offset, *this);
+  // Also flushes the accounts read before a failure, as the map keeps them
+  UpdateStateTrieDirty();
+  if (!ret) {
+    LOG_GENERAL(WARNING, "Messenger::GetAccountStore failed.");
+    return false;
+  }
+
+  return true;
+}
+
+bool AccountStore::SerializeChunk(bytes& dst, unsigned int offset,
+                                  unsigned int chunkIndex,
+                                  unsigned int numChunks,
+                                  dev::h256& stateRoot) const {
+  LOG_MARKER();
+  shared_lock<shared_timed_mutex> lock(m_mutexPrimary);
+  stateRoot = GetStateRootHash();
+  return AccountStoreTrie<dev::OverlayDB, FixedHashMap<Address, Account>>::
+      SerializeChunk(dst, offset, chunkIndex, numChunks);
+}
+
+bool AccountStore::DeserializeChunk(const bytes& src, unsigned int offset) {
+  LOG_MARKER();
+
+  unique_lock<shared_timed_mutex> g(m_mutexPrimary);
+
+  const bool ret = Messenger::GetAccountStore(src, offset, *this);
+  PublishSnapshotChanges(m_dirtyAccounts);
+  UpdateStateTrieDirty();
+  if (!ret) {
     LOG_GENERAL(WARNING, "Messenger::GetAccountStore failed.");
     return false;
   }
@@ -152,16 +331,26 @@ bool AccountStore::DeserializeDelta(const bytes& src, unsigned int offset,
     unique_lock<mutex> g2(m_mutexRevertibles, defer_lock);
     lock(g, g2);
 
-    if (!Messenger::GetAccountStoreDelta(src, offset, *this, revertible,
-                                         false)) {
+    const bool ret = Messenger::GetAccountStoreDelta(src, offset, *this,
+                                                     revertible, false);
+    // Also flushes the accounts applied before a failure, as the map keeps
+    // them
+    PublishSnapshotChanges(m_dirtyAccounts);
+    UpdateStateTrieDirty();
+    if (!ret) {
       LOG_GENERAL(WARNING, "Messenger::GetAccountStoreDelta failed.");
       return false;
     }
   } else {
     unique_lock<shared_timed_mutex> g(m_mutexPrimary);
 
-    if (!Messenger::GetAccountStoreDelta(src, offset, *this, revertible,
-                                         false)) {
+    const bool ret = Messenger::GetAccountStoreDelta(src, offset, *this,
+                                                     revertible, false);
+    // Also flushes the accounts applied before a failure, as the map keeps
+    // them
+    PublishSnapshotChanges(m_dirtyAccounts);
+    UpdateStateTrieDirty();
+    if (!ret) {
       LOG_GENERAL(WARNING, "Messenger::GetAccountStoreDelta failed.");
       return false;
     }
@@ -227,12 +416,18 @@ bool AccountStore::MoveUpdatesToDisk(bool repopulate) {
   }
 
   try {
-    if (repopulate && !RepopulateStateTrie()) {
-      LOG_GENERAL(WARNING, "RepopulateStateTrie failed");
+    if (repopulate) {
+      // Repopulating resets the db, taking the snapshot's trie nodes with it
+      ClearSnapshot();
+      if (!RepopulateStateTrie()) {
+        LOG_GENERAL(WARNING, "RepopulateStateTrie failed");
+      }
     }
-    m_state.db()->commit();
     m_prevRoot = m_state.root();
-    MoveRootToDisk(m_prevRoot);
+    // The trie nodes are written in the background, and the root is only
+    // recorded once they are in, so the root on disk is never ahead of them
+    m_state.db()->commit([this, root = m_prevRoot]() { MoveRootToDisk(root); });
+    PublishSnapshotRoot(m_prevRoot);
   } catch (const boost::exception& e) {
     LOG_GENERAL(WARNING, "Error with AccountStore::MoveUpdatesToDisk. "
                              << boost::diagnostic_information(e));
@@ -309,15 +504,32 @@ bool AccountStore::RepopulateStateTrie() {
 bool AccountStore::UpdateStateTrieFromTempStateDB() {
   LOG_MARKER();
 
-  leveldb::Iterator* iter = nullptr;
+  ldb::Iterator* iter = nullptr;
+  vector<StateSharedPtr> states;
+  BlockStorage::GetBlockStorage().GetTempStateInBatch(iter, states);
+
+  // Read and decode the next batch while the current one goes into the trie
+  bool more = true;
+  while (more) {
+    more = iter->Valid();
+    vector<StateSharedPtr> next;
+    future<bool> reader;
+    if (more) {
+      reader = async(launch::async, [&iter, &next]() -> bool {
+        return BlockStorage::GetBlockStorage().GetTempStateInBatch(iter, next);
+      });
+    }
 
-  while (iter == nullptr || iter->Valid()) {
-    vector<StateSharedPtr> states;
-    BlockStorage::GetBlockStorage().GetTempStateInBatch(iter, states);
     for (const auto& state : states) {
       UpdateStateTrie(state->first, state->second);
     }
+
+    if (more) {
+      reader.get();
+    }
+    states.swap(next);
   }
+  delete iter;
 
   BlockStorage::GetBlockStorage().ResetDB(BlockStorage::TEMP_STATE);
 
@@ -335,6 +547,8 @@ void AccountStore::DiscardUnsavedUpdates() {
     m_state.db()->rollback();
     m_state.setRoot(m_prevRoot);
     m_addressToAccount->clear();
+    m_dirtyAccounts.clear();
+    PublishSnapshotRoot(m_prevRoot);
   } catch (const boost::exception& e) {
     LOG_GENERAL(WARNING, "Error with AccountStore::DiscardUnsavedUpdates. "
                              << boost::diagnostic_information(e));
@@ -344,12 +558,6 @@ void AccountStore::DiscardUnsavedUpdates() {
 bool AccountStore::RetrieveFromDisk() {
   LOG_MARKER();
 
-  InitSoft();
-
-  unique_lock<shared_timed_mutex> g(m_mutexPrimary, defer_lock);
-  unique_lock<mutex> g2(m_mutexDB, defer_lock);
-  lock(g, g2);
-
   bytes rootBytes;
   if (!BlockStorage::GetBlockStorage().GetStateRoot(rootBytes)) {
     // To support backward compatibilty - lookup with new binary trying to
@@ -357,14 +565,25 @@ bool AccountStore::RetrieveFromDisk() {
     if (BlockStorage::GetBlockStorage().GetMetadata(STATEROOT, rootBytes)) {
       BlockStorage::GetBlockStorage().PutStateRoot(rootBytes);
     } else {
+      InitSoft();
       return false;
     }
   }
 
+  return RetrieveFromDisk(h256(rootBytes));
+}
+
+bool AccountStore::RetrieveFromDisk(const h256& root) {
+  InitSoft();
+
+  unique_lock<shared_timed_mutex> g(m_mutexPrimary, defer_lock);
+  unique_lock<mutex> g2(m_mutexDB, defer_lock);
+  lock(g, g2);
+
   try {
-    h256 root(rootBytes);
     LOG_GENERAL(INFO, "StateRootHash:" << root.hex());
     m_state.setRoot(root);
+    PublishSnapshotRoot(root);
   } catch (const boost::exception& e) {
     LOG_GENERAL(WARNING, "Error with AccountStore::RetrieveFromDisk. "
                              << boost::diagnostic_information(e));
@@ -392,6 +611,134 @@ bool AccountStore::UpdateAccountsTemp(const uint64_t& blockNum,
                                             transaction, receipt, true);
 }
 
+void AccountStore::UpdateAccountsTempBatch(
+    const uint64_t& blockNum, const unsigned int& numShards, const bool& isDS,
+    const vector<Transaction>& transactions,
+    vector<TransactionReceipt>& receipts, vector<bool>& results,
+    unsigned int numThreads) {
+  // Receipts already passed in, e.g. with the epoch set, are kept
+  const unsigned int numTxns = transactions.size();
+  receipts.resize(numTxns);
+  results.assign(numTxns, false);
+
+  unique_lock<shared_timed_mutex> g(m_mutexPrimary, defer_lock);
+  unique_lock<mutex> g2(m_mutexDelta, defer_lock);
+  lock(g, g2);
+
+  auto isPayment = [&transactions](unsigned int i) {
+    return transactions[i].GetData().empty() &&
+           transactions[i].GetCode().empty();
+  };
+
+  // Contract txns share the interpreter and the temp contract states, and a
+  // chain call can reach any account, so each one runs alone on
+  // AccountStoreTemp. The runs of payment txns between them are applied in
+  // parallel, keeping the outcome of serial execution.
+  unsigned int begin = 0;
+  while (begin < numTxns) {
+    unsigned int end = begin;
+    while (end < numTxns && isPayment(end)) {
+      end++;
+    }
+
+    if (numThreads > 1 && end - begin > 1) {
+      UpdatePaymentsTempParallel(transactions, begin, end, receipts, results,
+                                 numThreads);
+    } else {
+      end = max(end, begin + 1);
+      for (unsigned int i = begin; i < end; i++) {
+        results[i] = m_accountStoreTemp->UpdateAccounts(
+            blockNum, numShards, isDS, transactions[i], receipts[i], true);
+      }
+    }
+
+    begin = end;
+  }
+}
+
+void AccountStore::UpdatePaymentsTempParallel(
+    const vector<Transaction>& transactions, unsigned int begin,
+    unsigned int end, vector<TransactionReceipt>& receipts,
+    vector<bool>& results, unsigned int numThreads) {
+  const unsigned int numTxns = end - begin;
+
+  // Union the txns that share a sender or recipient, so every account is
+  // touched by exactly one group
+  vector<unsigned int> parent(numTxns);
+  iota(parent.begin(), parent.end(), 0);
+  auto findRoot = [&parent](unsigned int i) {
+    while (parent[i] != i) {
+      parent[i] = parent[parent[i]];
+      i = parent[i];
+    }
+    return i;
+  };
+
+  map<Address, unsigned int> firstToucher;
+  for (unsigned int i = 0; i < numTxns; i++) {
+    const Transaction& transaction = transactions[begin + i];
+    const Address fromAddr =
+        Account::GetAddressFromPublicKey(transaction.GetSenderPubKey());
+    for (const auto& addr : {fromAddr, transaction.GetToAddr()}) {
+      auto it = firstToucher.emplace(addr, i).first;
+      parent[findRoot(i)] = findRoot(it->second);
+    }
+  }
+
+  // Groups keep their txns in batch order
+  vector<vector<unsigned int>> groups;
+  map<unsigned int, unsigned int> rootToGroup;
+  for (unsigned int i = 0; i < numTxns; i++) {
+    auto it = rootToGroup.emplace(findRoot(i), groups.size()).first;
+    if (it->second == groups.size()) {
+      groups.emplace_back();
+    }
+    groups[it->second].emplace_back(begin + i);
+  }
+
+  // Seed each overlay from AccountStoreTemp. This pulls the accounts into
+  // AccountStoreTemp just like applying the txns there would.
+  vector<PaymentOverlay> overlays(groups.size());
+  for (const auto& entry : firstToucher) {
+    const Account* account = m_accountStoreTemp->GetAccount(entry.first);
+    if (account != nullptr) {
+      overlays[rootToGroup.at(findRoot(entry.second))].AddAccount(entry.first,
+                                                                  *account);
+    }
+  }
+
+  // Not vector<bool>, whose elements cannot be written concurrently
+  vector<unsigned char> applied(transactions.size(), 0);
+  atomic<unsigned int> next{0};
+
+  auto worker = [&]() -> void {
+    for (unsigned int i = next++; i < groups.size(); i = next++) {
+      for (const auto& txnIndex : groups[i]) {
+        applied[txnIndex] = overlays[i].UpdateAccounts(transactions[txnIndex],
+                                                       receipts[txnIndex]);
+      }
+    }
+  };
+
+  {
+    JoinableFunction joinableFunc(
+        min<unsigned int>(numThreads, groups.size()), worker);
+  }
+
+  // Groups touch disjoint accounts, so merging them in any order gives the
+  // state serial execution would have
+  for (const auto& overlay : overlays) {
+    for (const auto& entry : overlay.GetAddressToAccount()) {
+      m_accountStoreTemp->AddAccountDuringDeserialization(entry.first,
+                                                          entry.second);
+    }
+  }
+
+  for (unsigned int i = begin; i < end; i++) {
+    results[i] = (applied[i] != 0);
+  }
+}
+
 bool AccountStore::UpdateCoinbaseTemp(const Address& rewardee,
                                       const Address& genesisAddress,
                                       const uint128_t& amount) {
@@ -459,19 +806,28 @@ void AccountStore::CommitTempRevertible() {
 void AccountStore::RevertCommitTemp() {
   LOG_MARKER();
 
-  unique_lock<shared_timed_mutex> g(m_mutexPrimary);
+  unique_lock<shared_timed_mutex> g(m_mutexPrimary, defer_lock);
+  unique_lock<mutex> g2(m_mutexRevertibles, defer_lock);
+  lock(g, g2);
 
-  // Revert changed
-  for (auto const entry : m_addressToAccountRevChanged) {
-    // LOG_GENERAL(INFO, "Revert changed address: " << entry.first);
-    (*m_addressToAccount)[entry.first] = entry.second;
-    UpdateStateTrie(entry.first, entry.second);
-  }
-  for (auto const entry : m_addressToAccountRevCreated) {
-    // LOG_GENERAL(INFO, "Remove created address: " << entry.first);
-    RemoveAccount(entry.first);
-    RemoveFromTrie(entry.first);
+  vector<Address> reverted;
+  reverted.reserve(m_undoJournal.size());
+
+  for (auto it = m_undoJournal.rbegin(); it != m_undoJournal.rend(); ++it) {
+    reverted.emplace_back(it->m_address);
+    if (it->m_created) {
+      RemoveAccount(it->m_address);
+      RemoveFromTrie(it->m_address);
+    } else {
+      UpdateStateTrie(it->m_address, it->m_previous);
+      (*m_addressToAccount)[it->m_address] = move(it->m_previous);
+    }
   }
+  // The previous accounts were moved out, so the journal is spent
+  m_undoJournal.clear();
+  m_undoTouched.clear();
+
+  PublishSnapshotChanges(reverted);
 
   ContractStorage::GetContractStorage().RevertContractStates();
 }
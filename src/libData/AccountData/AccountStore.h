@@ -19,10 +19,12 @@
 #define __ACCOUNTSTORE_H__
 
 #include <json/json.h>
+#include <atomic>
 #include <map>
 #include <set>
 #include <shared_mutex>
 #include <unordered_map>
+#include <vector>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
@@ -30,6 +32,7 @@
 #pragma GCC diagnostic pop
 
 #include "Account.h"
+#include "AccountSnapshot.h"
 #include "AccountStoreSC.h"
 #include "AccountStoreTrie.h"
 #include "Address.h"
@@ -71,15 +74,25 @@ class AccountStoreTemp : public AccountStoreSC<std::map<Address, Account>> {
 // Singleton class for providing interface related Account System
 class AccountStore
     : public AccountStoreTrie<dev::OverlayDB,
-                              std::unordered_map<Address, Account>>,
+                              FixedHashMap<Address, Account>>,
       Singleton<AccountStore> {
   /// instantiate of AccountStoreTemp, which is serving for the StateDelta
   /// generation
   std::unique_ptr<AccountStoreTemp> m_accountStoreTemp;
 
-  /// used for states reverting
-  std::unordered_map<Address, Account> m_addressToAccountRevChanged;
-  std::unordered_map<Address, Account> m_addressToAccountRevCreated;
+  /// An account as it was before its first change by a revertible commit
+  struct UndoEntry {
+    Address m_address;
+    /// the account did not exist, so reverting removes it
+    bool m_created;
+    Account m_previous;
+  };
+
+  /// used for states reverting: appended to on the first touch of each
+  /// address since InitRevertibles, and replayed backwards by
+  /// RevertCommitTemp
+  std::vector<UndoEntry> m_undoJournal;
+  std::set<Address> m_undoTouched;
 
   /// primary mutex used by account store for protecting permanent states from
   /// external access
@@ -91,12 +104,41 @@ class AccountStore
   /// buffer for the raw bytes of state delta serialized
   bytes m_stateDeltaSerialized;
 
+  /// last published version of the committed state, read and replaced with
+  /// std::atomic_load and std::atomic_store. Null while the trie at its root
+  /// may not be readable, e.g. while the state is being rebuilt.
+  std::shared_ptr<const AccountSnapshot> m_snapshot;
+  /// bumped by ClearSnapshot, so that a reader can tell the trie may have
+  /// been reset under it
+  std::atomic<uint64_t> m_snapshotClears{0};
+
   AccountStore();
   ~AccountStore();
 
   /// Store the trie root to leveldb
   void MoveRootToDisk(const dev::h256& root);
 
+  /// Publish the accounts at addresses, as now in m_addressToAccount, on top
+  /// of the current snapshot. Called with m_mutexPrimary held exclusively.
+  template <class Container>
+  void PublishSnapshotChanges(const Container& addresses);
+  /// Publish a snapshot of the state at root, which must be on disk
+  void PublishSnapshotRoot(const dev::h256& root);
+  /// Stop serving reads from snapshots until the next PublishSnapshotRoot
+  void ClearSnapshot();
+
+  /// Journal the account at address, unless already journalled since
+  /// InitRevertibles. Called with m_mutexRevertibles held.
+  void RecordUndo(const Address& address, const Account& previous,
+                  bool created);
+
+  /// apply the payment txns in [begin, end) to AccountStoreTemp, in parallel
+  /// groups that touch disjoint accounts
+  void UpdatePaymentsTempParallel(
+      const std::vector<Transaction>& transactions, unsigned int begin,
+      unsigned int end, std::vector<TransactionReceipt>& receipts,
+      std::vector<bool>& results, unsigned int numThreads);
+
  public:
   /// Returns the singleton AccountStore instance.
   static AccountStore& GetInstance();
@@ -105,6 +147,14 @@ class AccountStore
 
   bool Deserialize(const bytes& src, unsigned int offset) override;
 
+  /// Serializes one chunk of the state for a joining node, along with the
+  /// root of the whole state it was cut from
+  bool SerializeChunk(bytes& dst, unsigned int offset, unsigned int chunkIndex,
+                      unsigned int numChunks, dev::h256& stateRoot) const;
+
+  /// Adds the accounts of a state chunk, keeping those already present
+  bool DeserializeChunk(const bytes& src, unsigned int offset);
+
   /// generate serialized raw bytes for StateDelta
   bool SerializeDelta();
 
@@ -138,6 +188,16 @@ class AccountStore
   void DiscardUnsavedUpdates();
   /// repopulate the in-memory data structures from persistent storage
   bool RetrieveFromDisk();
+  /// as above, from the state of an earlier root whose trie nodes are still
+  /// in the state database, such as that of a past Tx block
+  bool RetrieveFromDisk(const dev::h256& root);
+
+  /// Reads an account as of the last commit from the published snapshot,
+  /// without taking m_mutexPrimary, so it never waits on a commit. Returns
+  /// false if no snapshot is published, in which case callers fall back to
+  /// GetAccount under the lock.
+  bool GetAccountFromSnapshot(const Address& address,
+                              AccountSnapshotEntry& entry);
 
   Account* GetAccountTemp(const Address& address);
 
@@ -147,6 +207,17 @@ class AccountStore
                           const Transaction& transaction,
                           TransactionReceipt& receipt);
 
+  /// update account states in AccountStoreTemp for a batch of txns, with the
+  /// same outcome as calling UpdateAccountsTemp on each in order. Payment txns
+  /// that touch disjoint accounts are applied on numThreads threads; contract
+  /// txns run one at a time, between the runs of payments around them.
+  void UpdateAccountsTempBatch(const uint64_t& blockNum,
+                               const unsigned int& numShards, const bool& isDS,
+                               const std::vector<Transaction>& transactions,
+                               std::vector<TransactionReceipt>& receipts,
+                               std::vector<bool>& results,
+                               unsigned int numThreads);
+
   /// add account in AccountStoreTemp
   void AddAccountTemp(const Address& address, const Account& account) {
     m_accountStoreTemp->AddAccount(address, account);
@@ -165,7 +236,8 @@ class AccountStore
                           const Address& genesisAddress,
                           const boost::multiprecision::uint128_t& amount);
 
-  /// used in deserialization
+  /// used in deserialization. The state trie is updated once the whole
+  /// delta or store has been read, see UpdateStateTrieDirty.
   void AddAccountDuringDeserialization(const Address& address,
                                        const Account& account,
                                        const Account& oriAccount,
@@ -174,14 +246,10 @@ class AccountStore
     (*m_addressToAccount)[address] = account;
 
     if (revertible) {
-      if (fullCopy) {
-        m_addressToAccountRevCreated[address] = account;
-      } else {
-        m_addressToAccountRevChanged[address] = oriAccount;
-      }
+      RecordUndo(address, oriAccount, fullCopy);
     }
 
-    UpdateStateTrie(address, account);
+    m_dirtyAccounts.emplace(address);
   }
 
   /// return the hash of the raw bytes of StateDelta
@@ -22,7 +22,7 @@ AccountStoreAtomic<MAP>::AccountStoreAtomic(AccountStoreSC<MAP>& parent)
 template <class MAP>
 Account* AccountStoreAtomic<MAP>::GetAccount(const Address& address) {
   Account* account =
-      AccountStoreBase<std::unordered_map<Address, Account>>::GetAccount(
+      AccountStoreBase<FixedHashMap<Address, Account>>::GetAccount(
           address);
   if (account != nullptr) {
     // LOG_GENERAL(INFO, "Got From Temp");
@@ -42,7 +42,7 @@ Account* AccountStoreAtomic<MAP>::GetAccount(const Address& address) {
 }
 
 template <class MAP>
-const std::shared_ptr<std::unordered_map<Address, Account>>&
+const std::shared_ptr<FixedHashMap<Address, Account>>&
 AccountStoreAtomic<MAP>::GetAddressToAccount() {
   return this->m_addressToAccount;
 }
@@ -23,16 +23,19 @@
 #include <condition_variable>
 #include <functional>
 #include <mutex>
+#include <vector>
 
 #include "AccountStoreBase.h"
+#include "libData/DataStructures/FlatHashMap.h"
 #include "libUtils/DetachedFunction.h"
+#include "libUtils/LRUCache.h"
 
 template <class MAP>
 class AccountStoreSC;
 
 template <class MAP>
 class AccountStoreAtomic
-    : public AccountStoreBase<std::unordered_map<Address, Account>> {
+    : public AccountStoreBase<FixedHashMap<Address, Account>> {
   AccountStoreSC<MAP>& m_parent;
 
  public:
@@ -40,7 +43,7 @@ class AccountStoreAtomic
 
   Account* GetAccount(const Address& address) override;
 
-  const std::shared_ptr<std::unordered_map<Address, Account>>&
+  const std::shared_ptr<FixedHashMap<Address, Account>>&
   GetAddressToAccount();
 };
 
@@ -80,6 +83,18 @@ class AccountStoreSC : public AccountStoreBase<MAP> {
   /// the interpreter path for each hop of invoking
   std::string m_root_w_version;
 
+  /// checker output of successfully checked code, keyed by code hash and
+  /// interpreter path, as the checker only reads the code
+  LRUCache<std::string, std::string> m_checkerCache;
+
+  /// interpreter inputs keyed by file path, sent along with the call when
+  /// SCILLA_SERVER_INLINE_IO is on
+  Json::Value m_scillaInputs;
+
+  /// output of the last runner invocation, when the server returned it
+  /// parsed
+  Json::Value m_scillaOutput;
+
   /// the depth of chain call while executing the current txn
   unsigned int m_curDepth = 0;
 
@@ -93,6 +108,10 @@ class AccountStoreSC : public AccountStoreBase<MAP> {
   bool ParseContractCheckerOutput(const std::string& checkerPrint,
                                   TransactionReceipt& receipt);
 
+  /// read and parse the output of the last runner invocation
+  bool GetScillaOutput(Json::Value& jsonOutput, const std::string& runnerPrint,
+                       TransactionReceipt& receipt,
+                       const Address& contract = Address());
   /// verify the return from scilla_runner for deployment is valid
   bool ParseCreateContract(uint64_t& gasRemained,
                            const std::string& runnerPrint,
@@ -124,17 +143,27 @@ class AccountStoreSC : public AccountStoreBase<MAP> {
   /// Utility functions
   /// get the json format file for the current blocknum
   Json::Value GetBlockStateJson(const uint64_t& BlockNum) const;
-  /// get the command for invoking the scilla_checker while deploying
-  std::string GetContractCheckerCmdStr(const std::string& root_w_version);
-  /// get the command for invoking the scilla_runner while deploying
-  std::string GetCreateContractCmdStr(const std::string& root_w_version,
-                                      const uint64_t& available_gas);
-  /// get the command for invoking the scilla_runner while calling
-  std::string GetCallContractCmdStr(const std::string& root_w_version,
-                                    const uint64_t& available_gas);
+  /// get the arguments for invoking the scilla_checker while deploying
+  std::vector<std::string> GetContractCheckerArgs(
+      const std::string& root_w_version);
+  /// get the arguments for invoking the scilla_runner while deploying
+  std::vector<std::string> GetCreateContractArgs(
+      const std::string& root_w_version, const uint64_t& available_gas);
+  /// get the arguments for invoking the scilla_runner while calling
+  std::vector<std::string> GetCallContractArgs(
+      const std::string& root_w_version, const uint64_t& available_gas);
+  /// run the scilla_checker or scilla_runner of m_root_w_version, on the
+  /// scilla server if enabled, else as a new process
+  bool ExecuteScilla(bool checker, const std::vector<std::string>& args,
+                     std::string& output, int& pid);
   /// updating m_root_w_version
   bool PrepareRootPathWVersion(const uint32_t& scilla_version);
 
+  /// clear the input files (or in-memory inputs) of the last invocation
+  void PrepareScillaFiles();
+  /// write one interpreter input to path, or keep it in m_scillaInputs
+  void ExportScillaInput(const std::string& path, const Json::Value& input);
+
   /// generate input files for interpreter to deploy contract
   bool ExportCreateContractFiles(const Account& contract);
 
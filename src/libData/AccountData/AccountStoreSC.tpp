@@ -19,6 +19,8 @@
 #include <boost/filesystem.hpp>
 #include <chrono>
 
+#include "ContractProfiler.h"
+#include "ScillaClient.h"
 #include "libPersistence/ContractStorage.h"
 #include "libUtils/DataConversion.h"
 #include "libUtils/JsonUtils.h"
@@ -29,7 +31,8 @@
 const unsigned int MAX_SCILLA_OUTPUT_SIZE_IN_BYTES = 5120;
 
 template <class MAP>
-AccountStoreSC<MAP>::AccountStoreSC() {
+AccountStoreSC<MAP>::AccountStoreSC()
+    : m_checkerCache(SCILLA_CHECKER_CACHE_SIZE) {
   m_accountStoreAtomic = std::make_unique<AccountStoreAtomic<MAP>>(*this);
   m_txnProcessTimeout = false;
 }
@@ -182,44 +185,58 @@ bool AccountStoreSC<MAP>::UpdateAccounts(
       return false;
     }
 
-    // Undergo scilla checker
+    // Undergo scilla checker, unless this code passed it before
     bool ret_checker = true;
     std::string checkerPrint;
+    const std::string checkerKey =
+        toAccount->GetCodeHash().hex() + m_root_w_version;
 
     int pid = -1;
-    auto func1 = [this, &checkerPrint, &ret_checker, &pid,
-                  &receipt]() mutable -> void {
-      if (!SysCommand::ExecuteCmd(SysCommand::WITH_OUTPUT_PID,
-                                  GetContractCheckerCmdStr(m_root_w_version),
-                                  checkerPrint, pid)) {
-        LOG_GENERAL(WARNING, "ExecuteCmd failed: "
-                                 << GetContractCheckerCmdStr(m_root_w_version));
-        receipt.AddError(EXECUTE_CMD_FAILED);
-        ret_checker = false;
+    if (!m_checkerCache.Get(checkerKey, checkerPrint)) {
+      auto tpProfile = r_timer_start();
+      auto func1 = [this, &checkerPrint, &ret_checker, &pid,
+                    &receipt]() mutable -> void {
+        if (!ExecuteScilla(true, GetContractCheckerArgs(m_root_w_version),
+                           checkerPrint, pid)) {
+          LOG_GENERAL(WARNING, "Failed to run scilla checker");
+          receipt.AddError(EXECUTE_CMD_FAILED);
+          ret_checker = false;
+        }
+        cv_callContract.notify_all();
+      };
+      DetachedFunction(1, func1);
+
+      {
+        std::unique_lock<std::mutex> lk(m_MutexCVCallContract);
+        cv_callContract.wait(lk);
       }
-      cv_callContract.notify_all();
-    };
-    DetachedFunction(1, func1);
 
-    {
-      std::unique_lock<std::mutex> lk(m_MutexCVCallContract);
-      cv_callContract.wait(lk);
-    }
+      if (m_txnProcessTimeout) {
+        LOG_GENERAL(
+            WARNING,
+            "Txn processing timeout! Interrupt current contract check, pid: "
+                << pid);
+        if (pid >= 0) {
+          kill(pid, SIGKILL);
+        }
+        receipt.AddError(EXECUTE_CMD_TIMEOUT);
+        ret_checker = false;
+      }
+      ContractProfiler::GetInstance().AddInvocation(toAddr,
+                                                    m_txnProcessTimeout);
+      ContractProfiler::GetInstance().AddTime(
+          toAddr, ContractProfiler::EXECUTE, r_timer_end(tpProfile));
 
-    if (m_txnProcessTimeout) {
-      LOG_GENERAL(
-          WARNING,
-          "Txn processing timeout! Interrupt current contract check, pid: "
-              << pid);
-      if (pid >= 0) {
-        kill(pid, SIGKILL);
+      if (ret_checker && !ParseContractCheckerOutput(checkerPrint, receipt)) {
+        ret_checker = false;
       }
-      receipt.AddError(EXECUTE_CMD_TIMEOUT);
-      ret_checker = false;
-    }
 
-    if (ret_checker && !ParseContractCheckerOutput(checkerPrint, receipt)) {
-      ret_checker = false;
+      if (ret_checker) {
+        m_checkerCache.Put(checkerKey, checkerPrint);
+      }
+    } else {
+      LOG_GENERAL(INFO, "Scilla checker result cached for code "
+                            << toAccount->GetCodeHash());
     }
 
     // Undergo scilla runner
@@ -229,14 +246,13 @@ bool AccountStoreSC<MAP>::UpdateAccounts(
       std::string runnerPrint;
 
       pid = -1;
+      auto tpProfile = r_timer_start();
       auto func2 = [this, &runnerPrint, &ret, &pid, gasRemained,
                     &receipt]() mutable -> void {
-        if (!SysCommand::ExecuteCmd(
-                SysCommand::WITH_OUTPUT_PID,
-                GetCreateContractCmdStr(m_root_w_version, gasRemained),
+        if (!ExecuteScilla(
+                false, GetCreateContractArgs(m_root_w_version, gasRemained),
                 runnerPrint, pid)) {
-          LOG_GENERAL(WARNING, "ExecuteCmd failed: " << GetCreateContractCmdStr(
-                                   m_root_w_version, gasRemained));
+          LOG_GENERAL(WARNING, "Failed to run scilla runner for deployment");
           receipt.AddError(EXECUTE_CMD_FAILED);
           ret = false;
         }
@@ -260,6 +276,10 @@ bool AccountStoreSC<MAP>::UpdateAccounts(
         receipt.AddError(EXECUTE_CMD_TIMEOUT);
         ret = false;
       }
+      ContractProfiler::GetInstance().AddInvocation(toAddr,
+                                                    m_txnProcessTimeout);
+      ContractProfiler::GetInstance().AddTime(
+          toAddr, ContractProfiler::EXECUTE, r_timer_end(tpProfile));
 
       if (ret && !ParseCreateContract(gasRemained, runnerPrint, receipt)) {
         ret = false;
@@ -363,10 +383,13 @@ bool AccountStoreSC<MAP>::UpdateAccounts(
     }
 
     m_curBlockNum = blockNum;
+    auto tpProfile = r_timer_start();
     if (!ExportCallContractFiles(*toAccount, transaction)) {
       LOG_GENERAL(WARNING, "ExportCallContractFiles failed");
       return false;
     }
+    ContractProfiler::GetInstance().AddTime(toAddr, ContractProfiler::EXPORT,
+                                            r_timer_end(tpProfile));
 
     DiscardTransferBalanceAtomic();
 
@@ -389,15 +412,14 @@ bool AccountStoreSC<MAP>::UpdateAccounts(
     std::string runnerPrint;
     bool ret = true;
     int pid = -1;
+    tpProfile = r_timer_start();
 
     auto func = [this, &runnerPrint, &ret, &pid, gasRemained,
                  &receipt]() mutable -> void {
-      if (!SysCommand::ExecuteCmd(
-              SysCommand::WITH_OUTPUT_PID,
-              GetCallContractCmdStr(m_root_w_version, gasRemained), runnerPrint,
-              pid)) {
-        LOG_GENERAL(WARNING, "ExecuteCmd failed: " << GetCallContractCmdStr(
-                                 m_root_w_version, gasRemained));
+      if (!ExecuteScilla(false,
+                         GetCallContractArgs(m_root_w_version, gasRemained),
+                         runnerPrint, pid)) {
+        LOG_GENERAL(WARNING, "Failed to run scilla runner for call");
         receipt.AddError(EXECUTE_CMD_FAILED);
         ret = false;
       }
@@ -422,6 +444,9 @@ bool AccountStoreSC<MAP>::UpdateAccounts(
       receipt.AddError(EXECUTE_CMD_TIMEOUT);
       ret = false;
     }
+    ContractProfiler::GetInstance().AddInvocation(toAddr, m_txnProcessTimeout);
+    ContractProfiler::GetInstance().AddTime(toAddr, ContractProfiler::EXECUTE,
+                                            r_timer_end(tpProfile));
     if (ENABLE_CHECK_PERFORMANCE_LOG) {
       LOG_GENERAL(DEBUG, "Executed root transition in " << r_timer_end(tpStart)
                                                         << " microseconds");
@@ -502,15 +527,41 @@ Json::Value AccountStoreSC<MAP>::GetBlockStateJson(
 }
 
 template <class MAP>
-bool AccountStoreSC<MAP>::ExportCreateContractFiles(const Account& contract) {
-  LOG_MARKER();
-
-  boost::filesystem::remove_all("./" + SCILLA_FILES);
-  boost::filesystem::create_directories("./" + SCILLA_FILES);
+void AccountStoreSC<MAP>::PrepareScillaFiles() {
+  if (SCILLA_SERVER_INLINE_IO) {
+    m_scillaInputs = Json::objectValue;
+  } else {
+    boost::filesystem::remove_all("./" + SCILLA_FILES);
+    boost::filesystem::create_directories("./" + SCILLA_FILES);
+  }
 
   if (!(boost::filesystem::exists("./" + SCILLA_LOG))) {
     boost::filesystem::create_directories("./" + SCILLA_LOG);
   }
+}
+
+template <class MAP>
+void AccountStoreSC<MAP>::ExportScillaInput(const std::string& path,
+                                            const Json::Value& input) {
+  if (SCILLA_SERVER_INLINE_IO) {
+    m_scillaInputs[path] = input;
+    return;
+  }
+
+  if (input.isString()) {
+    std::ofstream os(path);
+    os << input.asString();
+    os.close();
+  } else {
+    JSONUtils::GetInstance().writeJsontoFile(path, input);
+  }
+}
+
+template <class MAP>
+bool AccountStoreSC<MAP>::ExportCreateContractFiles(const Account& contract) {
+  LOG_MARKER();
+
+  PrepareScillaFiles();
 
   std::pair<Json::Value, Json::Value> roots;
   uint32_t scilla_version;
@@ -525,16 +576,14 @@ bool AccountStoreSC<MAP>::ExportCreateContractFiles(const Account& contract) {
   }
 
   // Scilla code
-  std::ofstream os(INPUT_CODE);
-  os << DataConversion::CharArrayToString(contract.GetCode());
-  os.close();
+  ExportScillaInput(INPUT_CODE,
+                    DataConversion::CharArrayToString(contract.GetCode()));
 
   // Initialize Json
-  JSONUtils::GetInstance().writeJsontoFile(INIT_JSON, roots.first);
+  ExportScillaInput(INIT_JSON, roots.first);
 
   // Block Json
-  JSONUtils::GetInstance().writeJsontoFile(INPUT_BLOCKCHAIN_JSON,
-                                           GetBlockStateJson(m_curBlockNum));
+  ExportScillaInput(INPUT_BLOCKCHAIN_JSON, GetBlockStateJson(m_curBlockNum));
 
   return true;
 }
@@ -544,12 +593,7 @@ bool AccountStoreSC<MAP>::ExportContractFiles(const Account& contract) {
   LOG_MARKER();
   std::chrono::system_clock::time_point tpStart;
 
-  boost::filesystem::remove_all("./" + SCILLA_FILES);
-  boost::filesystem::create_directories("./" + SCILLA_FILES);
-
-  if (!(boost::filesystem::exists("./" + SCILLA_LOG))) {
-    boost::filesystem::create_directories("./" + SCILLA_LOG);
-  }
+  PrepareScillaFiles();
 
   if (ENABLE_CHECK_PERFORMANCE_LOG) {
     tpStart = r_timer_start();
@@ -568,19 +612,17 @@ bool AccountStoreSC<MAP>::ExportContractFiles(const Account& contract) {
   }
 
   // Scilla code
-  std::ofstream os(INPUT_CODE);
-  os << DataConversion::CharArrayToString(contract.GetCode());
-  os.close();
+  ExportScillaInput(INPUT_CODE,
+                    DataConversion::CharArrayToString(contract.GetCode()));
 
   // Initialize Json
-  JSONUtils::GetInstance().writeJsontoFile(INIT_JSON, roots.first);
+  ExportScillaInput(INIT_JSON, roots.first);
 
   // State Json
-  JSONUtils::GetInstance().writeJsontoFile(INPUT_STATE_JSON, roots.second);
+  ExportScillaInput(INPUT_STATE_JSON, roots.second);
 
   // Block Json
-  JSONUtils::GetInstance().writeJsontoFile(INPUT_BLOCKCHAIN_JSON,
-                                           GetBlockStateJson(m_curBlockNum));
+  ExportScillaInput(INPUT_BLOCKCHAIN_JSON, GetBlockStateJson(m_curBlockNum));
 
   if (ENABLE_CHECK_PERFORMANCE_LOG) {
     LOG_GENERAL(DEBUG, "LDB Read (microsec) = " << r_timer_end(tpStart));
@@ -612,7 +654,7 @@ bool AccountStoreSC<MAP>::ExportCallContractFiles(
       Account::GetAddressFromPublicKey(transaction.GetSenderPubKey()).hex();
   msgObj["_amount"] = transaction.GetAmount().convert_to<std::string>();
 
-  JSONUtils::GetInstance().writeJsontoFile(INPUT_MESSAGE_JSON, msgObj);
+  ExportScillaInput(INPUT_MESSAGE_JSON, msgObj);
 
   return true;
 }
@@ -627,7 +669,7 @@ bool AccountStoreSC<MAP>::ExportCallContractFiles(
     return false;
   }
 
-  JSONUtils::GetInstance().writeJsontoFile(INPUT_MESSAGE_JSON, contractData);
+  ExportScillaInput(INPUT_MESSAGE_JSON, contractData);
 
   return true;
 }
@@ -650,40 +692,89 @@ bool AccountStoreSC<MAP>::PrepareRootPathWVersion(
 }
 
 template <class MAP>
-std::string AccountStoreSC<MAP>::GetContractCheckerCmdStr(
+std::vector<std::string> AccountStoreSC<MAP>::GetContractCheckerArgs(
     const std::string& root_w_version) {
-  std::string cmdStr = root_w_version + '/' + SCILLA_CHECKER + " -libdir " +
-                       root_w_version + '/' + SCILLA_LIB + " " + INPUT_CODE;
-
-  LOG_GENERAL(INFO, cmdStr);
-  return cmdStr;
+  return {"-libdir", root_w_version + '/' + SCILLA_LIB, INPUT_CODE};
 }
 
 template <class MAP>
-std::string AccountStoreSC<MAP>::GetCreateContractCmdStr(
+std::vector<std::string> AccountStoreSC<MAP>::GetCreateContractArgs(
     const std::string& root_w_version, const uint64_t& available_gas) {
-  std::string cmdStr =
-      root_w_version + '/' + SCILLA_BINARY + " -init " + INIT_JSON +
-      " -iblockchain " + INPUT_BLOCKCHAIN_JSON + " -o " + OUTPUT_JSON + " -i " +
-      INPUT_CODE + " -libdir " + root_w_version + '/' + SCILLA_LIB +
-      " -gaslimit " + std::to_string(available_gas) + " -jsonerrors";
-
-  LOG_GENERAL(INFO, cmdStr);
-  return cmdStr;
+  return {"-init",
+          INIT_JSON,
+          "-iblockchain",
+          INPUT_BLOCKCHAIN_JSON,
+          "-o",
+          OUTPUT_JSON,
+          "-i",
+          INPUT_CODE,
+          "-libdir",
+          root_w_version + '/' + SCILLA_LIB,
+          "-gaslimit",
+          std::to_string(available_gas),
+          "-jsonerrors"};
 }
 
 template <class MAP>
-std::string AccountStoreSC<MAP>::GetCallContractCmdStr(
+std::vector<std::string> AccountStoreSC<MAP>::GetCallContractArgs(
     const std::string& root_w_version, const uint64_t& available_gas) {
+  std::vector<std::string> args = {"-init",
+                                   INIT_JSON,
+                                   "-istate",
+                                   INPUT_STATE_JSON,
+                                   "-iblockchain",
+                                   INPUT_BLOCKCHAIN_JSON,
+                                   "-imessage",
+                                   INPUT_MESSAGE_JSON,
+                                   "-o",
+                                   OUTPUT_JSON,
+                                   "-i",
+                                   INPUT_CODE,
+                                   "-libdir",
+                                   root_w_version + '/' + SCILLA_LIB,
+                                   "-gaslimit",
+                                   std::to_string(available_gas),
+                                   "-disable-pp-json",
+                                   "-disable-validate-json",
+                                   "-jsonerrors"};
+  // Output only the fields the transition changed
+  if (SCILLA_STATE_DIFF_OUTPUT) {
+    args.emplace_back("-state-diff");
+  }
+  return args;
+}
+
+template <class MAP>
+bool AccountStoreSC<MAP>::ExecuteScilla(bool checker,
+                                        const std::vector<std::string>& args,
+                                        std::string& output, int& pid) {
   std::string cmdStr =
-      root_w_version + '/' + SCILLA_BINARY + " -init " + INIT_JSON +
-      " -istate " + INPUT_STATE_JSON + " -iblockchain " +
-      INPUT_BLOCKCHAIN_JSON + " -imessage " + INPUT_MESSAGE_JSON + " -o " +
-      OUTPUT_JSON + " -i " + INPUT_CODE + " -libdir " + root_w_version + '/' +
-      SCILLA_LIB + " -gaslimit " + std::to_string(available_gas) +
-      " -disable-pp-json" + " -disable-validate-json" + " -jsonerrors";
+      m_root_w_version + '/' + (checker ? SCILLA_CHECKER : SCILLA_BINARY);
+  for (const auto& arg : args) {
+    cmdStr += " " + arg;
+  }
   LOG_GENERAL(INFO, cmdStr);
-  return cmdStr;
+
+  m_scillaOutput = Json::nullValue;
+
+  if (ENABLE_SCILLA_SERVER) {
+    Json::Value result;
+    if (!ScillaClient::GetInstance().Execute(m_root_w_version, checker, args,
+                                             m_scillaInputs, output, result,
+                                             pid)) {
+      return false;
+    }
+    // Keep a runner's output parsed rather than print and parse it again
+    if (!checker && SCILLA_SERVER_INLINE_IO) {
+      m_scillaOutput.swap(result);
+    } else if (!result.isNull()) {
+      output = JSONUtils::GetInstance().convertJsontoStr(result);
+    }
+    return true;
+  }
+
+  return SysCommand::ExecuteCmd(SysCommand::WITH_OUTPUT_PID, cmdStr, output,
+                                pid);
 }
 
 template <class MAP>
@@ -710,17 +801,33 @@ bool AccountStoreSC<MAP>::ParseCreateContract(uint64_t& gasRemained,
 }
 
 template <class MAP>
-bool AccountStoreSC<MAP>::ParseCreateContractOutput(
-    Json::Value& jsonOutput, const std::string& runnerPrint,
-    TransactionReceipt& receipt) {
-  // LOG_MARKER();
+bool AccountStoreSC<MAP>::GetScillaOutput(Json::Value& jsonOutput,
+                                          const std::string& runnerPrint,
+                                          TransactionReceipt& receipt,
+                                          const Address& contract) {
+  // Inline, the server hands back the output already parsed
+  if (!m_scillaOutput.isNull()) {
+    jsonOutput = Json::nullValue;
+    jsonOutput.swap(m_scillaOutput);
+    return true;
+  }
 
-  std::ifstream in(OUTPUT_JSON, std::ios::binary);
   std::string outStr;
+  std::ifstream in;
+  if (!SCILLA_SERVER_INLINE_IO) {
+    in.open(OUTPUT_JSON, std::ios::binary | std::ios::ate);
+  }
 
-  if (!in.is_open()) {
-    LOG_GENERAL(WARNING,
-                "Error opening output file or no output file generated");
+  if (in.is_open()) {
+    // Read in one go rather than char by char
+    outStr.resize(in.tellg());
+    in.seekg(0);
+    in.read(&outStr[0], outStr.size());
+  } else {
+    if (!SCILLA_SERVER_INLINE_IO) {
+      LOG_GENERAL(WARNING,
+                  "Error opening output file or no output file generated");
+    }
 
     // Check the printout
     if (!runnerPrint.empty()) {
@@ -729,9 +836,6 @@ bool AccountStoreSC<MAP>::ParseCreateContractOutput(
       receipt.AddError(NO_OUTPUT);
       return false;
     }
-  } else {
-    outStr = {std::istreambuf_iterator<char>(in),
-              std::istreambuf_iterator<char>()};
   }
 
   LOG_GENERAL(
@@ -741,6 +845,9 @@ bool AccountStoreSC<MAP>::ParseCreateContractOutput(
                          ? outStr.substr(0, MAX_SCILLA_OUTPUT_SIZE_IN_BYTES) +
                                "\n ... "
                          : outStr));
+  if (contract != Address()) {
+    ContractProfiler::GetInstance().AddOutputBytes(contract, outStr.size());
+  }
 
   if (!JSONUtils::GetInstance().convertStrtoJson(outStr, jsonOutput)) {
     receipt.AddError(JSON_OUTPUT_CORRUPTED);
@@ -749,6 +856,15 @@ bool AccountStoreSC<MAP>::ParseCreateContractOutput(
   return true;
 }
 
+template <class MAP>
+bool AccountStoreSC<MAP>::ParseCreateContractOutput(
+    Json::Value& jsonOutput, const std::string& runnerPrint,
+    TransactionReceipt& receipt) {
+  // LOG_MARKER();
+
+  return GetScillaOutput(jsonOutput, runnerPrint, receipt);
+}
+
 template <class MAP>
 bool AccountStoreSC<MAP>::ParseCreateContractJsonOutput(
     const Json::Value& _json, uint64_t& gasRemained,
@@ -824,36 +940,12 @@ bool AccountStoreSC<MAP>::ParseCallContractOutput(
   if (ENABLE_CHECK_PERFORMANCE_LOG) {
     tpStart = r_timer_start();
   }
-  std::ifstream in(OUTPUT_JSON, std::ios::binary);
-  std::string outStr;
-
-  if (!in.is_open()) {
-    LOG_GENERAL(WARNING,
-                "Error opening output file or no output file generated");
-
-    // Check the printout
-    if (!runnerPrint.empty()) {
-      outStr = runnerPrint;
-    } else {
-      receipt.AddError(NO_OUTPUT);
-      return false;
-    }
-  } else {
-    outStr = {std::istreambuf_iterator<char>(in),
-              std::istreambuf_iterator<char>()};
-  }
-  LOG_GENERAL(
-      INFO,
-      "Output: " << std::endl
-                 << (outStr.length() > MAX_SCILLA_OUTPUT_SIZE_IN_BYTES
-                         ? outStr.substr(0, MAX_SCILLA_OUTPUT_SIZE_IN_BYTES) +
-                               "\n ... "
-                         : outStr));
-
-  if (!JSONUtils::GetInstance().convertStrtoJson(outStr, jsonOutput)) {
-    receipt.AddError(JSON_OUTPUT_CORRUPTED);
+  auto tpProfile = r_timer_start();
+  if (!GetScillaOutput(jsonOutput, runnerPrint, receipt, m_curContractAddr)) {
     return false;
   }
+  ContractProfiler::GetInstance().AddTime(
+      m_curContractAddr, ContractProfiler::PARSE, r_timer_end(tpProfile));
   if (ENABLE_CHECK_PERFORMANCE_LOG) {
     LOG_GENERAL(DEBUG, "Parse scilla-runner output (microseconds) = "
                            << r_timer_end(tpStart));
@@ -893,6 +985,8 @@ bool AccountStoreSC<MAP>::ParseCallContractJsonOutput(
     return false;
   }
   LOG_GENERAL(INFO, "gasRemained: " << gasRemained);
+  ContractProfiler::GetInstance().AddGasUsed(
+      m_curContractAddr, startGas > gasRemained ? startGas - gasRemained : 0);
 
   if (!_json.isMember("message") || !_json.isMember("states") ||
       !_json.isMember("events")) {
@@ -932,6 +1026,8 @@ bool AccountStoreSC<MAP>::ParseCallContractJsonOutput(
     return false;
   }
 
+  // With SCILLA_STATE_DIFF_OUTPUT only the changed fields are listed, and the
+  // others keep their stored values
   std::vector<Contract::StateEntry> state_entries;
   for (const auto& s : _json["states"]) {
     if (!s.isMember("vname") || !s.isMember("type") || !s.isMember("value")) {
@@ -942,15 +1038,17 @@ bool AccountStoreSC<MAP>::ParseCallContractJsonOutput(
       continue;
     }
     std::string vname = s["vname"].asString();
+    if (vname == "_balance") {
+      continue;
+    }
     std::string type = s["type"].asString();
     std::string value =
         s["value"].isString()
             ? s["value"].asString()
             : JSONUtils::GetInstance().convertJsontoStr(s["value"]);
 
-    if (vname != "_balance") {
-      state_entries.push_back(std::make_tuple(vname, true, type, value));
-    }
+    state_entries.emplace_back(std::move(vname), true, std::move(type),
+                               std::move(value));
   }
 
   for (const auto& e : _json["events"]) {
@@ -1033,11 +1131,18 @@ bool AccountStoreSC<MAP>::ParseCallContractJsonOutput(
     }
   }
 
+  auto persistStates = [this, contractAccount, &state_entries, temp]() {
+    auto tpProfile = r_timer_start();
+    if (!contractAccount->SetStorage(state_entries, temp)) {
+      LOG_GENERAL(WARNING, "SetStorage failed");
+    }
+    ContractProfiler::GetInstance().AddTime(
+        m_curContractAddr, ContractProfiler::PERSIST, r_timer_end(tpProfile));
+  };
+
   if (first) {
     if (ret) {
-      if (!contractAccount->SetStorage(state_entries, temp)) {
-        LOG_GENERAL(WARNING, "SetStorage failed");
-      }
+      persistStates();
       if (ENABLE_CHECK_PERFORMANCE_LOG) {
         LOG_GENERAL(DEBUG,
                     "LDB Write (microseconds) = " << r_timer_end(tpStart));
@@ -1048,9 +1153,7 @@ bool AccountStoreSC<MAP>::ParseCallContractJsonOutput(
     Contract::ContractStorage::GetContractStorage().BufferCurrentState();
   }
 
-  if (!contractAccount->SetStorage(state_entries, temp)) {
-    LOG_GENERAL(WARNING, "SetStorage failed");
-  }
+  persistStates();
 
   if (ENABLE_CHECK_PERFORMANCE_LOG) {
     LOG_GENERAL(DEBUG, "LDB Write (microseconds) = " << r_timer_end(tpStart));
@@ -1091,23 +1194,24 @@ bool AccountStoreSC<MAP>::ParseCallContractJsonOutput(
   input_message["_tag"] = _json["message"]["_tag"];
   input_message["params"] = _json["message"]["params"];
 
+  auto tpProfile = r_timer_start();
   if (!ExportCallContractFiles(*account, input_message)) {
     LOG_GENERAL(WARNING, "ExportCallContractFiles failed");
     receipt.AddError(PREPARATION_FAILED);
     return false;
   }
+  ContractProfiler::GetInstance().AddTime(recipient, ContractProfiler::EXPORT,
+                                          r_timer_end(tpProfile));
 
   std::string runnerPrint;
   bool result = true;
   int pid = -1;
   auto func = [this, &runnerPrint, &result, &pid, gasRemained,
                &receipt]() mutable -> void {
-    if (!SysCommand::ExecuteCmd(
-            SysCommand::WITH_OUTPUT_PID,
-            GetCallContractCmdStr(m_root_w_version, gasRemained), runnerPrint,
-            pid)) {
-      LOG_GENERAL(WARNING, "ExecuteCmd failed: " << GetCallContractCmdStr(
-                               m_root_w_version, gasRemained));
+    if (!ExecuteScilla(false,
+                       GetCallContractArgs(m_root_w_version, gasRemained),
+                       runnerPrint, pid)) {
+      LOG_GENERAL(WARNING, "Failed to run scilla runner for call");
       receipt.AddError(EXECUTE_CMD_FAILED);
       result = false;
     }
@@ -1118,6 +1222,7 @@ bool AccountStoreSC<MAP>::ParseCallContractJsonOutput(
     tpStart = r_timer_start();
   }
 
+  tpProfile = r_timer_start();
   DetachedFunction(1, func);
 
   {
@@ -1135,6 +1240,9 @@ bool AccountStoreSC<MAP>::ParseCallContractJsonOutput(
     receipt.AddError(EXECUTE_CMD_TIMEOUT);
     result = false;
   }
+  ContractProfiler::GetInstance().AddInvocation(recipient, m_txnProcessTimeout);
+  ContractProfiler::GetInstance().AddTime(recipient, ContractProfiler::EXECUTE,
+                                          r_timer_end(tpProfile));
 
   if (ENABLE_CHECK_PERFORMANCE_LOG) {
     LOG_GENERAL(DEBUG, "Executed " << input_message["_tag"] << " in "
@@ -18,6 +18,8 @@
 #ifndef __ACCOUNTSTORETRIE_H__
 #define __ACCOUNTSTORETRIE_H__
 
+#include <set>
+
 #include "AccountStoreSC.h"
 #include "depends/libDatabase/MemoryDB.h"
 #include "depends/libDatabase/OverlayDB.h"
@@ -34,8 +36,14 @@ class AccountStoreTrie : public AccountStoreSC<MAP> {
 
   AccountStoreTrie();
 
+  // Accounts changed in the map but not yet written to m_state, in address
+  // order so a flush walks neighbouring trie paths together
+  std::set<Address> m_dirtyAccounts;
+
   bool UpdateStateTrie(const Address& address, const Account& account);
   bool RemoveFromTrie(const Address& address);
+  /// Writes each account in m_dirtyAccounts to m_state once
+  bool UpdateStateTrieDirty();
 
  public:
   virtual void Init() override;
@@ -44,6 +52,10 @@ class AccountStoreTrie : public AccountStoreSC<MAP> {
 
   bool Serialize(bytes& dst, unsigned int offset) const override;
 
+  /// Serializes chunk chunkIndex of the state split numChunks ways by address
+  bool SerializeChunk(bytes& dst, unsigned int offset, unsigned int chunkIndex,
+                      unsigned int numChunks) const;
+
   Account* GetAccount(const Address& address) override;
 
   dev::h256 GetStateRootHash() const;
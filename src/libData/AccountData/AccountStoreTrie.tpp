@@ -15,6 +15,7 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include "common/Constants.h"
 #include "libPersistence/ContractStorage.h"
 
 #include "libMessage/MessengerAccountStoreTrie.h"
@@ -34,6 +35,7 @@ void AccountStoreTrie<DB, MAP>::Init() {
 template <class DB, class MAP>
 void AccountStoreTrie<DB, MAP>::InitTrie() {
   m_state.init();
+  m_dirtyAccounts.clear();
   m_prevRoot = m_state.root();
 }
 
@@ -49,6 +51,20 @@ bool AccountStoreTrie<DB, MAP>::Serialize(bytes& dst,
   return true;
 }
 
+template <class DB, class MAP>
+bool AccountStoreTrie<DB, MAP>::SerializeChunk(bytes& dst, unsigned int offset,
+                                               unsigned int chunkIndex,
+                                               unsigned int numChunks) const {
+  if (!MessengerAccountStoreTrie::SetAccountStoreTrieChunk(
+          dst, offset, m_state, this->m_addressToAccount, chunkIndex,
+          numChunks)) {
+    LOG_GENERAL(WARNING, "Messenger::SetAccountStoreTrieChunk failed.");
+    return false;
+  }
+
+  return true;
+}
+
 template <class DB, class MAP>
 Account* AccountStoreTrie<DB, MAP>::GetAccount(const Address& address) {
   // LOG_MARKER();
@@ -95,6 +111,33 @@ bool AccountStoreTrie<DB, MAP>::UpdateStateTrie(const Address& address,
   return true;
 }
 
+template <class DB, class MAP>
+bool AccountStoreTrie<DB, MAP>::UpdateStateTrieDirty() {
+  bool ret = true;
+
+  std::vector<std::pair<bytes, bytes>> kvs;
+  kvs.reserve(m_dirtyAccounts.size());
+  for (const auto& address : m_dirtyAccounts) {
+    // Accounts removed since are taken out of the trie by RemoveFromTrie
+    auto it = this->m_addressToAccount->find(address);
+    if (it == this->m_addressToAccount->end()) {
+      continue;
+    }
+    bytes rawBytes;
+    if (!it->second.SerializeBase(rawBytes, 0)) {
+      LOG_GENERAL(WARNING, "Messenger::SetAccountBase failed");
+      ret = false;
+      continue;
+    }
+    kvs.emplace_back(address.asBytes(), std::move(rawBytes));
+  }
+  m_dirtyAccounts.clear();
+
+  m_state.insertBatch(kvs, STATE_TRIE_HASHING_NUM_THREADS);
+
+  return ret;
+}
+
 template <class DB, class MAP>
 bool AccountStoreTrie<DB, MAP>::RemoveFromTrie(const Address& address) {
   // LOG_MARKER();
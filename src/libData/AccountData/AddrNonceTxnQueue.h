@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __ADDRNONCETXNQUEUE_H__
+#define __ADDRNONCETXNQUEUE_H__
+
+#include <functional>
+#include <map>
+#include <set>
+#include <tuple>
+
+#include "Address.h"
+#include "Transaction.h"
+#include "libUtils/EpochArena.h"
+
+/// Transactions whose nonce is ahead of their sender's, held until the sender
+/// catches up. Senders whose lowest held nonce is the expected one are kept
+/// in a ready set ordered by gas price, so taking the next transaction does
+/// not rescan every sender. The caller reports nonce changes via Refresh.
+/// The queue lives for one microblock, so it can take its memory from the
+/// arena of the epoch.
+class AddrNonceTxnQueue {
+  typedef std::tuple<boost::multiprecision::uint128_t, Address> ReadyKey;
+  typedef std::map<uint64_t, Transaction, std::less<uint64_t>,
+                   ArenaAllocator<std::pair<const uint64_t, Transaction>>>
+      SenderTxns;
+
+  ArenaAllocator<char> m_alloc;
+  std::map<Address, SenderTxns, std::less<Address>,
+           ArenaAllocator<std::pair<const Address, SenderTxns>>>
+      m_txns;
+
+  // Highest gas price first, then lowest address
+  struct ReadyOrder {
+    bool operator()(const ReadyKey& l, const ReadyKey& r) const {
+      if (std::get<0>(l) != std::get<0>(r)) {
+        return std::get<0>(l) > std::get<0>(r);
+      }
+      return std::get<1>(l) < std::get<1>(r);
+    }
+  };
+  std::set<ReadyKey, ReadyOrder, ArenaAllocator<ReadyKey>> m_ready;
+  std::map<Address, boost::multiprecision::uint128_t, std::less<Address>,
+           ArenaAllocator<std::pair<const Address,
+                                    boost::multiprecision::uint128_t>>>
+      m_readyGasPrice;
+
+  void removeReady(const Address& sender) {
+    auto it = m_readyGasPrice.find(sender);
+    if (it != m_readyGasPrice.end()) {
+      m_ready.erase(ReadyKey(it->second, sender));
+      m_readyGasPrice.erase(it);
+    }
+  }
+
+ public:
+  /// Allocates from arena if given, which must outlive the queue
+  explicit AddrNonceTxnQueue(EpochArena* arena = nullptr)
+      : m_alloc(arena),
+        m_txns(m_alloc),
+        m_ready(m_alloc),
+        m_readyGasPrice(m_alloc) {}
+
+  /// Holds a transaction until its sender reaches its nonce, keeping the one
+  /// with the higher gas price if the sender already has one at that nonce
+  void Insert(const Address& sender, const Transaction& t,
+              uint64_t expectedNonce) {
+    auto senderIt = m_txns.find(sender);
+    if (senderIt == m_txns.end()) {
+      senderIt = m_txns.emplace(sender, SenderTxns(m_alloc)).first;
+    }
+    auto& senderTxns = senderIt->second;
+    auto it = senderTxns.find(t.GetNonce());
+    if (it == senderTxns.end()) {
+      senderTxns.emplace(t.GetNonce(), t);
+    } else if (t.GetGasPrice() > it->second.GetGasPrice()) {
+      it->second = t;
+    }
+    Refresh(sender, expectedNonce);
+  }
+
+  /// Re-evaluates whether sender's lowest held transaction can go next. Call
+  /// after anything that may have changed the sender's nonce.
+  void Refresh(const Address& sender, uint64_t expectedNonce) {
+    removeReady(sender);
+
+    auto it = m_txns.find(sender);
+    if (it == m_txns.end()) {
+      return;
+    }
+
+    const auto& lowest = *it->second.begin();
+    if (lowest.first == expectedNonce) {
+      const auto& gasPrice = lowest.second.GetGasPrice();
+      m_ready.emplace(gasPrice, sender);
+      m_readyGasPrice.emplace(sender, gasPrice);
+    }
+  }
+
+  /// Takes the ready transaction with the highest gas price. The sender is
+  /// no longer ready until Refresh is called with its new nonce.
+  bool PopReady(Transaction& t) {
+    if (m_ready.empty()) {
+      return false;
+    }
+
+    const Address sender = std::get<1>(*m_ready.begin());
+    removeReady(sender);
+
+    auto it = m_txns.find(sender);
+    t = std::move(it->second.begin()->second);
+    it->second.erase(it->second.begin());
+    if (it->second.empty()) {
+      m_txns.erase(it);
+    }
+
+    return true;
+  }
+
+  bool Contains(const Address& sender) const {
+    return m_txns.find(sender) != m_txns.end();
+  }
+
+  /// Calls f on every transaction still held
+  void ForEach(const std::function<void(const Transaction&)>& f) const {
+    for (const auto& kv : m_txns) {
+      for (const auto& nonceTxn : kv.second) {
+        f(nonceTxn.second);
+      }
+    }
+  }
+
+  void clear() {
+    m_txns.clear();
+    m_ready.clear();
+    m_readyGasPrice.clear();
+  }
+};
+
+#endif  // __ADDRNONCETXNQUEUE_H__
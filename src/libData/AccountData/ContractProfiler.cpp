@@ -0,0 +1,157 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <vector>
+
+#include "ContractProfiler.h"
+#include "common/Constants.h"
+#include "libUtils/Logger.h"
+#include "libUtils/Metrics.h"
+
+using namespace std;
+
+namespace {
+const char* PHASE_NAMES[ContractProfiler::NUM_PHASES] = {"export", "execute",
+                                                         "parse", "persist"};
+}  // namespace
+
+uint64_t ContractProfiler::Profile::GetTotalTimeInUs() const {
+  uint64_t total = 0;
+  for (const auto& time : m_timeInUs) {
+    total += time;
+  }
+  return total;
+}
+
+void ContractProfiler::AddTime(const Address& contract, Phase phase,
+                               double timeInUs) {
+  // Exported whether or not profiling is on, as it is cheap and per phase only
+  static Metrics::Histogram* phaseTimes[NUM_PHASES] = {};
+  static once_flag phaseTimesFlag;
+  call_once(phaseTimesFlag, []() {
+    for (unsigned int i = 0; i < NUM_PHASES; ++i) {
+      phaseTimes[i] = &Metrics::GetInstance().GetHistogram(
+          "zilliqa_scilla_seconds", "Time spent on contract calls, per phase",
+          string("phase=\"") + PHASE_NAMES[i] + "\"");
+    }
+  });
+  if (phase < NUM_PHASES) {
+    phaseTimes[phase]->Observe(timeInUs / 1000000);
+  }
+
+  if (!ENABLE_CONTRACT_PROFILING) {
+    return;
+  }
+
+  lock_guard<mutex> g(m_mutex);
+  m_profiles[contract].m_timeInUs[phase] += timeInUs;
+}
+
+void ContractProfiler::AddInvocation(const Address& contract, bool timedOut) {
+  if (!ENABLE_CONTRACT_PROFILING) {
+    return;
+  }
+
+  lock_guard<mutex> g(m_mutex);
+  Profile& profile = m_profiles[contract];
+  profile.m_invocations++;
+  if (timedOut) {
+    profile.m_timeouts++;
+  }
+}
+
+void ContractProfiler::AddGasUsed(const Address& contract, uint64_t gasUsed) {
+  if (!ENABLE_CONTRACT_PROFILING) {
+    return;
+  }
+
+  lock_guard<mutex> g(m_mutex);
+  m_profiles[contract].m_gasUsed += gasUsed;
+}
+
+void ContractProfiler::AddOutputBytes(const Address& contract,
+                                      uint64_t outputBytes) {
+  if (!ENABLE_CONTRACT_PROFILING) {
+    return;
+  }
+
+  lock_guard<mutex> g(m_mutex);
+  m_profiles[contract].m_outputBytes += outputBytes;
+}
+
+Json::Value ContractProfiler::GetProfilesJson(unsigned int maxEntries) {
+  vector<pair<Address, Profile>> profiles;
+  {
+    lock_guard<mutex> g(m_mutex);
+    profiles.assign(m_profiles.begin(), m_profiles.end());
+  }
+
+  sort(profiles.begin(), profiles.end(),
+       [](const pair<Address, Profile>& a, const pair<Address, Profile>& b) {
+         return a.second.GetTotalTimeInUs() > b.second.GetTotalTimeInUs();
+       });
+  if (profiles.size() > maxEntries) {
+    profiles.resize(maxEntries);
+  }
+
+  Json::Value _json = Json::arrayValue;
+  for (const auto& entry : profiles) {
+    const Profile& profile = entry.second;
+
+    Json::Value tmpJson;
+    tmpJson["address"] = entry.first.hex();
+    tmpJson["invocations"] = to_string(profile.m_invocations);
+    tmpJson["timeouts"] = to_string(profile.m_timeouts);
+    tmpJson["gas_used"] = to_string(profile.m_gasUsed);
+    tmpJson["output_bytes"] = to_string(profile.m_outputBytes);
+    tmpJson["total_time_us"] = to_string(profile.GetTotalTimeInUs());
+    for (unsigned int i = 0; i < NUM_PHASES; i++) {
+      tmpJson[string(PHASE_NAMES[i]) + "_time_us"] =
+          to_string(profile.m_timeInUs[i]);
+    }
+    _json.append(tmpJson);
+  }
+
+  return _json;
+}
+
+void ContractProfiler::Dump() {
+  if (!ENABLE_CONTRACT_PROFILING) {
+    return;
+  }
+
+  for (const auto& entry : GetProfilesJson(CONTRACT_PROFILING_DUMP_ENTRIES)) {
+    LOG_GENERAL(INFO, "[CONTRACT] "
+                          << entry["address"].asString()
+                          << " calls=" << entry["invocations"].asString()
+                          << " timeouts=" << entry["timeouts"].asString()
+                          << " gas=" << entry["gas_used"].asString()
+                          << " out=" << entry["output_bytes"].asString()
+                          << " us=" << entry["total_time_us"].asString()
+                          << " (export " << entry["export_time_us"].asString()
+                          << " execute " << entry["execute_time_us"].asString()
+                          << " parse " << entry["parse_time_us"].asString()
+                          << " persist " << entry["persist_time_us"].asString()
+                          << ")");
+  }
+}
+
+void ContractProfiler::Reset() {
+  lock_guard<mutex> g(m_mutex);
+  m_profiles.clear();
+}
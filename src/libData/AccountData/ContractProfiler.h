@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CONTRACTPROFILER_H__
+#define __CONTRACTPROFILER_H__
+
+#include <json/json.h>
+#include <array>
+#include <mutex>
+#include <unordered_map>
+
+#include "Address.h"
+#include "common/Singleton.h"
+
+/// Cumulative cost of executing each contract on this node, split by phase,
+/// for finding the contracts that take up the shard's time. Recording is a
+/// no-op unless ENABLE_CONTRACT_PROFILING is set.
+class ContractProfiler : public Singleton<ContractProfiler> {
+ public:
+  enum Phase : unsigned int {
+    EXPORT = 0,  // writing the interpreter inputs
+    EXECUTE,     // running the interpreter, including its start-up
+    PARSE,       // reading and parsing its output
+    PERSIST,     // writing the new contract states
+    NUM_PHASES
+  };
+
+  struct Profile {
+    uint64_t m_invocations = 0;
+    uint64_t m_timeouts = 0;
+    uint64_t m_gasUsed = 0;
+    uint64_t m_outputBytes = 0;
+    std::array<uint64_t, NUM_PHASES> m_timeInUs{};
+
+    uint64_t GetTotalTimeInUs() const;
+  };
+
+  ContractProfiler() = default;
+
+  void AddTime(const Address& contract, Phase phase, double timeInUs);
+
+  /// Counts one interpreter invocation for the contract
+  void AddInvocation(const Address& contract, bool timedOut);
+
+  void AddGasUsed(const Address& contract, uint64_t gasUsed);
+
+  void AddOutputBytes(const Address& contract, uint64_t outputBytes);
+
+  /// The profiles of the maxEntries contracts that took the most time, most
+  /// expensive first
+  Json::Value GetProfilesJson(unsigned int maxEntries);
+
+  /// Logs the profiles of the CONTRACT_PROFILING_DUMP_ENTRIES most expensive
+  /// contracts
+  void Dump();
+
+  void Reset();
+
+ private:
+  std::mutex m_mutex;
+  std::unordered_map<Address, Profile> m_profiles;
+};
+
+#endif  // __CONTRACTPROFILER_H__
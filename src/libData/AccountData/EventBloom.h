@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __EVENTBLOOM_H__
+#define __EVENTBLOOM_H__
+
+#include <string>
+
+#include "Address.h"
+#include "depends/common/FixedHash.h"
+#include "libCrypto/Sha2.h"
+
+/// 2048 bit bloom filter over the contract addresses and event names of
+/// event logs, set like the log blooms of Ethereum: three 11 bit indices
+/// taken from the SHA256 of each item. The address is added alone and
+/// together with the event name, so both query forms need one probe.
+class EventBloom {
+  dev::h2048 m_bits;
+
+  static dev::h256 ItemHash(const Address& address,
+                            const std::string& eventName) {
+    SHA2<HASH_TYPE::HASH_VARIANT_256> sha2;
+    sha2.Update(address.asBytes());
+    if (!eventName.empty()) {
+      sha2.Update(bytes(eventName.begin(), eventName.end()));
+    }
+    return dev::h256(sha2.Finalize());
+  }
+
+ public:
+  static const unsigned int SIZE = dev::h2048::size;
+
+  EventBloom() = default;
+  explicit EventBloom(const dev::h2048& bits) : m_bits(bits) {}
+
+  void Add(const Address& address, const std::string& eventName) {
+    m_bits.shiftBloom<3>(ItemHash(address, ""));
+    m_bits.shiftBloom<3>(ItemHash(address, eventName));
+  }
+
+  /// Whether an event of the address, with the event name unless it is
+  /// empty, may have been added
+  bool MayContain(const Address& address, const std::string& eventName) const {
+    return m_bits.contains(
+        ItemHash(address, eventName).bloomPart<3, dev::h2048::size>());
+  }
+
+  EventBloom& operator|=(const EventBloom& other) {
+    m_bits |= other.m_bits;
+    return *this;
+  }
+
+  bool Empty() const { return !m_bits; }
+
+  const dev::h2048& GetBits() const { return m_bits; }
+};
+
+#endif  // __EVENTBLOOM_H__
@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "PooledTransaction.h"
+
+using namespace std;
+
+PooledTransaction::PubKeyBytes PooledTransaction::EncodePubKey(
+    const PubKey& pubKey) {
+  bytes encoded;
+  pubKey.Serialize(encoded, 0);
+
+  PubKeyBytes result{};
+  copy_n(encoded.begin(), min<size_t>(encoded.size(), result.size()),
+         result.begin());
+  return result;
+}
+
+PooledTransaction::PooledTransaction(const Transaction& t)
+    : m_tranID(t.GetTranID()),
+      m_version(t.GetVersion()),
+      m_codeSize(t.GetCode().size()),
+      m_nonce(t.GetNonce()),
+      m_gasLimit(t.GetGasLimit()),
+      m_amount(t.GetAmount()),
+      m_gasPrice(t.GetGasPrice()),
+      m_toAddr(t.GetToAddr()),
+      m_senderPubKey(EncodePubKey(t.GetSenderPubKey())),
+      m_signature{} {
+  bytes signature;
+  t.GetSignature().Serialize(signature, 0);
+  copy_n(signature.begin(), min<size_t>(signature.size(), m_signature.size()),
+         m_signature.begin());
+
+  m_payload.reserve(t.GetCode().size() + t.GetData().size());
+  m_payload.insert(m_payload.end(), t.GetCode().begin(), t.GetCode().end());
+  m_payload.insert(m_payload.end(), t.GetData().begin(), t.GetData().end());
+}
+
+Transaction PooledTransaction::ToTransaction() const {
+  const bytes senderPubKey(m_senderPubKey.begin(), m_senderPubKey.end());
+  const bytes signature(m_signature.begin(), m_signature.end());
+
+  return Transaction(
+      m_tranID,
+      TransactionCoreInfo(
+          m_version, m_nonce, m_toAddr, PubKey(senderPubKey, 0), m_amount,
+          m_gasPrice, m_gasLimit,
+          bytes(m_payload.begin(), m_payload.begin() + m_codeSize),
+          bytes(m_payload.begin() + m_codeSize, m_payload.end())),
+      Signature(signature, 0));
+}
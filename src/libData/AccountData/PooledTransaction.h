@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __POOLEDTRANSACTION_H__
+#define __POOLEDTRANSACTION_H__
+
+#include <array>
+#include <cstdint>
+
+#include "Address.h"
+#include "Transaction.h"
+
+/// Compact form of a Transaction while it waits in a TxnPool. The sender key
+/// and the signature stay encoded in fixed arrays, instead of holding curve
+/// points and bignums on the heap, and the code and data share one buffer
+/// that plain transfers leave empty. The serialized core fields are dropped,
+/// to be encoded again if needed. The Transaction is rebuilt when the pool
+/// hands it out.
+class PooledTransaction {
+ public:
+  using PubKeyBytes = std::array<unsigned char, PUB_KEY_SIZE>;
+  using SignatureBytes =
+      std::array<unsigned char,
+                 SIGNATURE_CHALLENGE_SIZE + SIGNATURE_RESPONSE_SIZE>;
+
+  explicit PooledTransaction(const Transaction& t);
+
+  /// Rebuilds the full transaction
+  Transaction ToTransaction() const;
+
+  const TxnHash& GetTranID() const { return m_tranID; }
+
+  const uint64_t& GetNonce() const { return m_nonce; }
+
+  const PubKeyBytes& GetSenderPubKey() const { return m_senderPubKey; }
+
+  const boost::multiprecision::uint128_t& GetGasPrice() const {
+    return m_gasPrice;
+  }
+
+  const uint64_t& GetGasLimit() const { return m_gasLimit; }
+
+  /// Bytes of the code and data, held outside the object
+  std::size_t GetPayloadSize() const { return m_payload.size(); }
+
+  /// Returns the compressed encoding of a key, as kept by the pool
+  static PubKeyBytes EncodePubKey(const PubKey& pubKey);
+
+ private:
+  TxnHash m_tranID;
+  uint32_t m_version;
+  /// Length of the code at the front of m_payload
+  uint32_t m_codeSize;
+  uint64_t m_nonce;
+  uint64_t m_gasLimit;
+  boost::multiprecision::uint128_t m_amount;
+  boost::multiprecision::uint128_t m_gasPrice;
+  Address m_toAddr;
+  PubKeyBytes m_senderPubKey;
+  SignatureBytes m_signature;
+  /// The code followed by the data
+  bytes m_payload;
+};
+
+#endif  // __POOLEDTRANSACTION_H__
@@ -0,0 +1,401 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ReceiptEncoding.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+
+namespace {
+
+enum Tag : unsigned char {
+  TAG_NULL = 0,
+  TAG_FALSE,
+  TAG_TRUE,
+  TAG_INT,
+  TAG_UINT,
+  TAG_REAL,
+  TAG_STRING,
+  TAG_DECIMAL,
+  TAG_HEX,
+  TAG_ARRAY,
+  TAG_OBJECT
+};
+
+/// Strings with fixed ids in VERSION 1, so this list must not change
+const vector<string> DICTIONARY = {
+    "success", "cumulative_gas", "epoch_num", "event_logs",
+    "errors",  "_eventname",     "address",   "params",
+    "vname",   "type",           "value",     "0",
+    "1",       "2",              "3",         "ByStr20",
+    "Uint128", "String"};
+
+/// Depth of nested arrays and objects, beyond which a decode is refused
+const unsigned int MAX_NESTING = 64;
+
+const unordered_map<string, uint64_t>& GetDictionaryIds() {
+  static const unordered_map<string, uint64_t> ids = []() {
+    unordered_map<string, uint64_t> ret;
+    for (uint64_t i = 0; i < DICTIONARY.size(); i++) {
+      ret.emplace(DICTIONARY[i], i);
+    }
+    return ret;
+  }();
+  return ids;
+}
+
+void PutVarint(bytes& dst, uint64_t value) {
+  while (value >= 0x80) {
+    dst.push_back(static_cast<unsigned char>(value | 0x80));
+    value >>= 7;
+  }
+  dst.push_back(static_cast<unsigned char>(value));
+}
+
+bool GetVarint(const bytes& src, size_t& pos, uint64_t& value) {
+  value = 0;
+  for (unsigned int shift = 0; shift < 64; shift += 7) {
+    if (pos >= src.size()) {
+      return false;
+    }
+    const unsigned char b = src[pos++];
+    value |= static_cast<uint64_t>(b & 0x7F) << shift;
+    if (!(b & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/// A decimal string that reads back the same from its uint64 value
+bool IsDecimal(const string& str) {
+  if (str.empty() || str.size() > 20 || (str.size() > 1 && str[0] == '0')) {
+    return false;
+  }
+  for (const char c : str) {
+    if (c < '0' || c > '9') {
+      return false;
+    }
+  }
+  return str.size() < 20 || str <= "18446744073709551615";
+}
+
+/// A 0x prefixed string of lower case hex digits in whole bytes
+bool IsHex(const string& str) {
+  if (str.size() <= 2 || str.size() % 2 != 0 || str.compare(0, 2, "0x") != 0) {
+    return false;
+  }
+  for (size_t i = 2; i < str.size(); i++) {
+    const char c = str[i];
+    if (!((c >= '0' && c <= '9') || (c >= 'a' && c <= 'f'))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+unsigned char HexDigit(char c) {
+  return (c <= '9') ? (c - '0') : (c - 'a' + 10);
+}
+
+class Encoder {
+  unordered_map<string, uint64_t> m_tableIds;
+  vector<const string*> m_table;
+  bytes m_body;
+
+  void PutString(const string& str) {
+    const auto& dictionaryIds = GetDictionaryIds();
+    const auto dictionaryIt = dictionaryIds.find(str);
+    if (dictionaryIt != dictionaryIds.end()) {
+      PutVarint(m_body, dictionaryIt->second);
+      return;
+    }
+
+    auto it = m_tableIds.find(str);
+    if (it == m_tableIds.end()) {
+      it = m_tableIds.emplace(str, DICTIONARY.size() + m_table.size()).first;
+      m_table.emplace_back(&it->first);
+    }
+    PutVarint(m_body, it->second);
+  }
+
+ public:
+  void PutValue(const Json::Value& value) {
+    switch (value.type()) {
+      case Json::nullValue:
+        m_body.push_back(TAG_NULL);
+        break;
+      case Json::booleanValue:
+        m_body.push_back(value.asBool() ? TAG_TRUE : TAG_FALSE);
+        break;
+      case Json::intValue: {
+        const int64_t i = value.asInt64();
+        m_body.push_back(TAG_INT);
+        PutVarint(m_body, (static_cast<uint64_t>(i) << 1) ^
+                              static_cast<uint64_t>(i >> 63));
+        break;
+      }
+      case Json::uintValue:
+        m_body.push_back(TAG_UINT);
+        PutVarint(m_body, value.asUInt64());
+        break;
+      case Json::realValue: {
+        const double d = value.asDouble();
+        uint64_t bits;
+        memcpy(&bits, &d, sizeof(bits));
+        m_body.push_back(TAG_REAL);
+        for (unsigned int i = 0; i < sizeof(bits); i++) {
+          m_body.push_back(static_cast<unsigned char>(bits >> (8 * i)));
+        }
+        break;
+      }
+      case Json::stringValue: {
+        const string str = value.asString();
+        if (IsDecimal(str)) {
+          m_body.push_back(TAG_DECIMAL);
+          PutVarint(m_body, stoull(str));
+        } else if (IsHex(str)) {
+          m_body.push_back(TAG_HEX);
+          PutVarint(m_body, (str.size() - 2) / 2);
+          for (size_t i = 2; i < str.size(); i += 2) {
+            m_body.push_back((HexDigit(str[i]) << 4) | HexDigit(str[i + 1]));
+          }
+        } else {
+          m_body.push_back(TAG_STRING);
+          PutString(str);
+        }
+        break;
+      }
+      case Json::arrayValue:
+        m_body.push_back(TAG_ARRAY);
+        PutVarint(m_body, value.size());
+        for (const auto& item : value) {
+          PutValue(item);
+        }
+        break;
+      case Json::objectValue:
+        // The members are kept sorted by key
+        m_body.push_back(TAG_OBJECT);
+        PutVarint(m_body, value.size());
+        for (auto it = value.begin(); it != value.end(); ++it) {
+          PutString(it.name());
+          PutValue(*it);
+        }
+        break;
+    }
+  }
+
+  void Finish(bytes& dst) const {
+    dst.clear();
+    dst.push_back(ReceiptEncoding::VERSION);
+    PutVarint(dst, m_table.size());
+    for (const auto str : m_table) {
+      PutVarint(dst, str->size());
+      dst.insert(dst.end(), str->begin(), str->end());
+    }
+    dst.insert(dst.end(), m_body.begin(), m_body.end());
+  }
+};
+
+class Decoder {
+  const bytes& m_src;
+  size_t m_pos = 0;
+  vector<string> m_table;
+
+  bool GetString(string& str) {
+    uint64_t id;
+    if (!GetVarint(m_src, m_pos, id)) {
+      return false;
+    }
+    if (id < DICTIONARY.size()) {
+      str = DICTIONARY[id];
+      return true;
+    }
+    id -= DICTIONARY.size();
+    if (id >= m_table.size()) {
+      return false;
+    }
+    str = m_table[id];
+    return true;
+  }
+
+  bool GetCount(uint64_t& count) {
+    // Every item takes at least a byte, which bounds what is reserved
+    return GetVarint(m_src, m_pos, count) && count <= m_src.size() - m_pos;
+  }
+
+ public:
+  explicit Decoder(const bytes& src) : m_src(src) {}
+
+  bool GetTable() {
+    if (m_src.empty() || m_src[0] != ReceiptEncoding::VERSION) {
+      return false;
+    }
+    m_pos = 1;
+
+    uint64_t count;
+    if (!GetCount(count)) {
+      return false;
+    }
+    m_table.reserve(count);
+    for (uint64_t i = 0; i < count; i++) {
+      uint64_t length;
+      if (!GetVarint(m_src, m_pos, length) ||
+          length > m_src.size() - m_pos) {
+        return false;
+      }
+      m_table.emplace_back(m_src.begin() + m_pos,
+                           m_src.begin() + m_pos + length);
+      m_pos += length;
+    }
+    return true;
+  }
+
+  bool GetValue(Json::Value& value, unsigned int nesting) {
+    if (m_pos >= m_src.size() || nesting > MAX_NESTING) {
+      return false;
+    }
+
+    uint64_t number;
+    switch (m_src[m_pos++]) {
+      case TAG_NULL:
+        value = Json::nullValue;
+        return true;
+      case TAG_FALSE:
+        value = false;
+        return true;
+      case TAG_TRUE:
+        value = true;
+        return true;
+      case TAG_INT:
+        if (!GetVarint(m_src, m_pos, number)) {
+          return false;
+        }
+        value = static_cast<Json::Int64>((number >> 1) ^ (~(number & 1) + 1));
+        return true;
+      case TAG_UINT:
+        if (!GetVarint(m_src, m_pos, number)) {
+          return false;
+        }
+        value = static_cast<Json::UInt64>(number);
+        return true;
+      case TAG_REAL: {
+        if (m_src.size() - m_pos < sizeof(uint64_t)) {
+          return false;
+        }
+        uint64_t bits = 0;
+        for (unsigned int i = 0; i < sizeof(bits); i++) {
+          bits |= static_cast<uint64_t>(m_src[m_pos++]) << (8 * i);
+        }
+        double d;
+        memcpy(&d, &bits, sizeof(d));
+        value = d;
+        return true;
+      }
+      case TAG_STRING: {
+        string str;
+        if (!GetString(str)) {
+          return false;
+        }
+        value = str;
+        return true;
+      }
+      case TAG_DECIMAL:
+        if (!GetVarint(m_src, m_pos, number)) {
+          return false;
+        }
+        value = to_string(number);
+        return true;
+      case TAG_HEX: {
+        static const char* DIGITS = "0123456789abcdef";
+        if (!GetVarint(m_src, m_pos, number) ||
+            number > m_src.size() - m_pos) {
+          return false;
+        }
+        string str = "0x";
+        str.reserve(2 + 2 * number);
+        for (uint64_t i = 0; i < number; i++) {
+          const unsigned char b = m_src[m_pos++];
+          str.push_back(DIGITS[b >> 4]);
+          str.push_back(DIGITS[b & 0x0F]);
+        }
+        value = str;
+        return true;
+      }
+      case TAG_ARRAY:
+        if (!GetCount(number)) {
+          return false;
+        }
+        value = Json::arrayValue;
+        for (uint64_t i = 0; i < number; i++) {
+          if (!GetValue(value.append(Json::nullValue), nesting + 1)) {
+            return false;
+          }
+        }
+        return true;
+      case TAG_OBJECT:
+        if (!GetCount(number)) {
+          return false;
+        }
+        value = Json::objectValue;
+        for (uint64_t i = 0; i < number; i++) {
+          string key;
+          if (!GetString(key) || value.isMember(key) ||
+              !GetValue(value[key], nesting + 1)) {
+            return false;
+          }
+        }
+        return true;
+      default:
+        return false;
+    }
+  }
+
+  bool AtEnd() const { return m_pos == m_src.size(); }
+};
+
+}  // namespace
+
+const unsigned char ReceiptEncoding::VERSION;
+
+bool ReceiptEncoding::Encode(const Json::Value& receiptObj, bytes& dst) {
+  try {
+    Encoder encoder;
+    encoder.PutValue(receiptObj);
+    encoder.Finish(dst);
+  } catch (const exception& e) {
+    LOG_GENERAL(WARNING, "Failed to encode receipt: " << e.what());
+    return false;
+  }
+  return true;
+}
+
+bool ReceiptEncoding::Decode(const bytes& src, Json::Value& receiptObj) {
+  Decoder decoder(src);
+  Json::Value obj;
+  if (!decoder.GetTable() || !decoder.GetValue(obj, 0) || !decoder.AtEnd()) {
+    LOG_GENERAL(WARNING, "Corrupted receipt of " << src.size() << " bytes");
+    return false;
+  }
+  receiptObj = move(obj);
+  return true;
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RECEIPTENCODING_H__
+#define __RECEIPTENCODING_H__
+
+#include <json/json.h>
+
+#include "common/BaseType.h"
+
+/// Compact binary form of the receipt json, stored and hashed in place of
+/// its string form. It starts with VERSION, then a table of the strings
+/// used by the receipt, each stored once, then the json values as a tag
+/// byte and their content. Field names of receipts and event logs are in a
+/// fixed dictionary, and decimal numbers and 0x prefixed hex held as strings
+/// (the gas, epoch and addresses) are stored as numbers and raw bytes.
+/// Objects are written in the sorted order of their keys, so the same json
+/// always gives the same bytes.
+class ReceiptEncoding {
+ public:
+  static const unsigned char VERSION = 1;
+
+  static bool Encode(const Json::Value& receiptObj, bytes& dst);
+
+  /// Fails on anything other than a whole encoding of VERSION
+  static bool Decode(const bytes& src, Json::Value& receiptObj);
+};
+
+#endif  // __RECEIPTENCODING_H__
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <signal.h>
+#include <unistd.h>
+#include <chrono>
+#include <thread>
+
+#include <boost/filesystem.hpp>
+
+#include "ScillaClient.h"
+#include "common/Constants.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+
+namespace {
+const unsigned int SOCKET_POLL_INTERVAL_IN_MS = 50;
+}  // namespace
+
+ScillaClient::~ScillaClient() {
+  lock_guard<mutex> g(m_mutexServers);
+  for (auto& entry : m_servers) {
+    StopServer(entry.second);
+  }
+}
+
+bool ScillaClient::StartServer(const string& root_w_version, Server& server) {
+  StopServer(server);
+
+  boost::system::error_code ec;
+  boost::filesystem::remove(server.m_socketPath, ec);
+
+  const string binary = root_w_version + '/' + SCILLA_SERVER_BINARY;
+  const string libdir = root_w_version + '/' + SCILLA_LIB;
+
+  pid_t pid = fork();
+  if (pid < 0) {
+    LOG_GENERAL(WARNING, "Failed to fork " << binary);
+    return false;
+  }
+
+  if (pid == 0) {
+    // Own process group, like the interpreters spawned by SysCommand
+    setpgid(0, 0);
+    execl(binary.c_str(), binary.c_str(), "-socket",
+          server.m_socketPath.c_str(), "-libdir", libdir.c_str(), NULL);
+    _exit(1);
+  }
+
+  server.m_pid = pid;
+
+  const auto deadline =
+      chrono::steady_clock::now() +
+      chrono::milliseconds(SCILLA_SERVER_STARTUP_TIMEOUT_IN_MS);
+  while (!boost::filesystem::exists(server.m_socketPath, ec)) {
+    if (kill(pid, 0) != 0 || chrono::steady_clock::now() > deadline) {
+      LOG_GENERAL(WARNING, "Failed to start " << binary << " on "
+                                              << server.m_socketPath);
+      StopServer(server);
+      return false;
+    }
+    this_thread::sleep_for(chrono::milliseconds(SOCKET_POLL_INTERVAL_IN_MS));
+  }
+
+  server.m_connector =
+      make_unique<jsonrpc::UnixDomainSocketClient>(server.m_socketPath);
+  server.m_client = make_unique<jsonrpc::Client>(*server.m_connector);
+
+  LOG_GENERAL(INFO, "Started " << binary << " (pid " << pid << ") on "
+                               << server.m_socketPath);
+
+  return true;
+}
+
+void ScillaClient::StopServer(Server& server) {
+  server.m_client.reset();
+  server.m_connector.reset();
+
+  if (server.m_pid > 0) {
+    kill(-server.m_pid, SIGKILL);
+    server.m_pid = -1;
+  }
+}
+
+bool ScillaClient::Execute(const string& root_w_version, bool checker,
+                           const vector<string>& args,
+                           const Json::Value& inputs, string& output,
+                           Json::Value& result, int& pid) {
+  lock_guard<mutex> g(m_mutexServers);
+
+  auto it = m_servers.find(root_w_version);
+  if (it == m_servers.end()) {
+    it = m_servers.emplace(root_w_version, Server()).first;
+    it->second.m_socketPath =
+        SCILLA_SERVER_SOCKET_PATH + '.' + to_string(m_servers.size() - 1);
+  }
+  Server& server = it->second;
+
+  // Restart the server if it died or was killed on a timeout
+  if (server.m_pid <= 0 || kill(server.m_pid, 0) != 0) {
+    if (!StartServer(root_w_version, server)) {
+      return false;
+    }
+  }
+
+  pid = server.m_pid;
+
+  Json::Value params;
+  params["argv"] = Json::arrayValue;
+  for (const auto& arg : args) {
+    params["argv"].append(arg);
+  }
+  if (!inputs.isNull()) {
+    params["inputs"] = inputs;
+  }
+
+  try {
+    Json::Value ret =
+        server.m_client->CallMethod(checker ? "check" : "run", params);
+    if (ret.isString()) {
+      output = ret.asString();
+    } else {
+      result.swap(ret);
+    }
+  } catch (jsonrpc::JsonRpcException& e) {
+    LOG_GENERAL(WARNING, "Scilla server call failed: " << e.what());
+    if (e.GetCode() == jsonrpc::Errors::ERROR_CLIENT_CONNECTOR) {
+      StopServer(server);
+      return false;
+    }
+    // The interpreter reported an error; parse it like its printed output
+    output = e.GetMessage();
+  }
+
+  return true;
+}
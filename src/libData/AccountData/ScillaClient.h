@@ -0,0 +1,68 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SCILLACLIENT_H__
+#define __SCILLACLIENT_H__
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "jsonrpccpp/client.h"
+#include "jsonrpccpp/client/connectors/unixdomainsocketclient.h"
+
+#include "common/Singleton.h"
+
+/// Client of long-running scilla-server processes, one per Scilla root
+/// directory, reached over a unix domain socket. Avoids paying the
+/// interpreter start-up cost on every contract check, deployment and call.
+class ScillaClient : public Singleton<ScillaClient> {
+  struct Server {
+    int m_pid = -1;
+    std::string m_socketPath;
+    std::unique_ptr<jsonrpc::UnixDomainSocketClient> m_connector;
+    std::unique_ptr<jsonrpc::Client> m_client;
+  };
+
+  std::map<std::string, Server> m_servers;
+  std::mutex m_mutexServers;
+
+  /// Spawns the server under root_w_version and waits for its socket
+  bool StartServer(const std::string& root_w_version, Server& server);
+
+  /// Kills the server, if still running, and drops its connection
+  void StopServer(Server& server);
+
+ public:
+  ScillaClient() = default;
+  ~ScillaClient();
+
+  /// Runs the checker (or the runner) with the given arguments on the server
+  /// for root_w_version, starting it if needed. pid is set to the server
+  /// process so that a timeout can kill it; it is restarted on the next call.
+  /// inputs, if not null, maps input file paths named in args to their
+  /// contents, which the server then reads in place of the files. A textual
+  /// result goes to output, any other to result.
+  bool Execute(const std::string& root_w_version, bool checker,
+               const std::vector<std::string>& args,
+               const Json::Value& inputs, std::string& output,
+               Json::Value& result, int& pid);
+};
+
+#endif  // __SCILLACLIENT_H__
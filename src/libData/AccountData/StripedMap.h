@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __STRIPEDMAP_H__
+#define __STRIPEDMAP_H__
+
+#include <array>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+#include <utility>
+
+/// Hash map split into NUM_STRIPES unordered_maps, each behind its own lock,
+/// so lookups and updates of accounts in different stripes do not contend.
+/// Has the subset of the unordered_map interface used as the MAP of the
+/// account stores.
+///
+/// Each call locks its stripe only for its own duration. Pointers and
+/// references to elements stay valid until they are erased, as the account
+/// stores rely on; iterators are invalidated by inserts into their stripe, and
+/// iterating while other threads insert still needs an outer lock.
+template <class Key, class T, class Hash = std::hash<Key>,
+          unsigned int NUM_STRIPES = 16>
+class StripedMap {
+  typedef std::unordered_map<Key, T, Hash> Stripe;
+
+  std::array<Stripe, NUM_STRIPES> m_stripes;
+  mutable std::array<std::shared_timed_mutex, NUM_STRIPES> m_mutexes;
+
+  static unsigned int stripeOf(const Key& key) {
+    return Hash()(key) % NUM_STRIPES;
+  }
+
+  template <class Map, class StripeIt>
+  class Iterator {
+    friend class StripedMap;
+
+    Map* m_map;
+    unsigned int m_stripe;
+    StripeIt m_it;
+
+    // Moves past the end of empty stripes
+    void skipEmpty() {
+      while (m_stripe < NUM_STRIPES &&
+             m_it == m_map->m_stripes[m_stripe].end()) {
+        if (++m_stripe < NUM_STRIPES) {
+          m_it = m_map->m_stripes[m_stripe].begin();
+        }
+      }
+    }
+
+    Iterator(Map* map, unsigned int stripe, StripeIt it)
+        : m_map(map), m_stripe(stripe), m_it(it) {}
+
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename std::iterator_traits<StripeIt>::value_type value_type;
+    typedef typename std::iterator_traits<StripeIt>::difference_type
+        difference_type;
+    typedef typename std::iterator_traits<StripeIt>::pointer pointer;
+    typedef typename std::iterator_traits<StripeIt>::reference reference;
+
+    Iterator() : m_map(nullptr), m_stripe(NUM_STRIPES) {}
+
+    /// iterator converts to const_iterator
+    template <class M, class I>
+    Iterator(const Iterator<M, I>& src)
+        : m_map(src.m_map), m_stripe(src.m_stripe), m_it(src.m_it) {}
+
+    reference operator*() const { return *m_it; }
+    pointer operator->() const { return &*m_it; }
+
+    Iterator& operator++() {
+      ++m_it;
+      skipEmpty();
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator tmp(*this);
+      ++(*this);
+      return tmp;
+    }
+
+    bool operator==(const Iterator& r) const {
+      return (m_stripe == r.m_stripe) &&
+             (m_stripe == NUM_STRIPES || m_it == r.m_it);
+    }
+
+    bool operator!=(const Iterator& r) const { return !(*this == r); }
+
+    template <class M, class I>
+    friend class Iterator;
+  };
+
+ public:
+  typedef Key key_type;
+  typedef T mapped_type;
+  typedef std::pair<const Key, T> value_type;
+  typedef Iterator<StripedMap, typename Stripe::iterator> iterator;
+  typedef Iterator<const StripedMap, typename Stripe::const_iterator>
+      const_iterator;
+
+  StripedMap() = default;
+
+  StripedMap(const StripedMap& src) { *this = src; }
+
+  StripedMap& operator=(const StripedMap& src) {
+    if (this != &src) {
+      for (unsigned int i = 0; i < NUM_STRIPES; i++) {
+        std::shared_lock<std::shared_timed_mutex> g(src.m_mutexes[i]);
+        std::unique_lock<std::shared_timed_mutex> g2(m_mutexes[i]);
+        m_stripes[i] = src.m_stripes[i];
+      }
+    }
+    return *this;
+  }
+
+  iterator begin() {
+    iterator it(this, 0, m_stripes[0].begin());
+    it.skipEmpty();
+    return it;
+  }
+
+  const_iterator begin() const {
+    const_iterator it(this, 0, m_stripes[0].begin());
+    it.skipEmpty();
+    return it;
+  }
+
+  iterator end() { return iterator(this, NUM_STRIPES, {}); }
+
+  const_iterator end() const { return const_iterator(this, NUM_STRIPES, {}); }
+
+  iterator find(const Key& key) {
+    const unsigned int stripe = stripeOf(key);
+    std::shared_lock<std::shared_timed_mutex> g(m_mutexes[stripe]);
+    auto it = m_stripes[stripe].find(key);
+    return (it == m_stripes[stripe].end()) ? end()
+                                           : iterator(this, stripe, it);
+  }
+
+  const_iterator find(const Key& key) const {
+    const unsigned int stripe = stripeOf(key);
+    std::shared_lock<std::shared_timed_mutex> g(m_mutexes[stripe]);
+    auto it = m_stripes[stripe].find(key);
+    return (it == m_stripes[stripe].end()) ? end()
+                                           : const_iterator(this, stripe, it);
+  }
+
+  std::size_t count(const Key& key) const { return (find(key) != end()); }
+
+  template <class... Args>
+  std::pair<iterator, bool> emplace(const Key& key, Args&&... args) {
+    const unsigned int stripe = stripeOf(key);
+    std::unique_lock<std::shared_timed_mutex> g(m_mutexes[stripe]);
+    auto result =
+        m_stripes[stripe].emplace(key, T(std::forward<Args>(args)...));
+    return {iterator(this, stripe, result.first), result.second};
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return emplace(value.first, value.second);
+  }
+
+  T& operator[](const Key& key) {
+    const unsigned int stripe = stripeOf(key);
+    std::unique_lock<std::shared_timed_mutex> g(m_mutexes[stripe]);
+    return m_stripes[stripe][key];
+  }
+
+  std::size_t erase(const Key& key) {
+    const unsigned int stripe = stripeOf(key);
+    std::unique_lock<std::shared_timed_mutex> g(m_mutexes[stripe]);
+    return m_stripes[stripe].erase(key);
+  }
+
+  void clear() {
+    for (unsigned int i = 0; i < NUM_STRIPES; i++) {
+      std::unique_lock<std::shared_timed_mutex> g(m_mutexes[i]);
+      m_stripes[i].clear();
+    }
+  }
+
+  std::size_t size() const {
+    std::size_t result = 0;
+    for (unsigned int i = 0; i < NUM_STRIPES; i++) {
+      std::shared_lock<std::shared_timed_mutex> g(m_mutexes[i]);
+      result += m_stripes[i].size();
+    }
+    return result;
+  }
+
+  bool empty() const { return size() == 0; }
+};
+
+#endif  // __STRIPEDMAP_H__
@@ -31,7 +31,17 @@ unsigned char ACC_COND = 0x1;
 unsigned char TX_COND = 0x2;
 
 bool Transaction::SerializeCoreFields(bytes& dst, unsigned int offset) const {
-  return Messenger::SetTransactionCoreInfo(dst, offset, m_coreInfo);
+  if (m_serializedCoreInfo.empty()) {
+    return Messenger::SetTransactionCoreInfo(dst, offset, m_coreInfo);
+  }
+
+  if (dst.size() < offset + m_serializedCoreInfo.size()) {
+    dst.resize(offset + m_serializedCoreInfo.size());
+  }
+  copy(m_serializedCoreInfo.begin(), m_serializedCoreInfo.end(),
+       dst.begin() + offset);
+
+  return true;
 }
 
 Transaction::Transaction() {}
@@ -39,7 +49,8 @@ Transaction::Transaction() {}
 Transaction::Transaction(const Transaction& src)
     : m_tranID(src.m_tranID),
       m_coreInfo(src.m_coreInfo),
-      m_signature(src.m_signature) {}
+      m_signature(src.m_signature),
+      m_serializedCoreInfo(src.m_serializedCoreInfo) {}
 
 Transaction::Transaction(const bytes& src, unsigned int offset) {
   Deserialize(src, offset);
@@ -53,7 +64,10 @@ Transaction::Transaction(const uint32_t& version, const uint64_t& nonce,
     : m_coreInfo(version, nonce, toAddr, senderKeyPair.second, amount, gasPrice,
                  gasLimit, code, data) {
   bytes txnData;
-  SerializeCoreFields(txnData, 0);
+  if (!SerializeCoreFields(txnData, 0)) {
+    LOG_GENERAL(WARNING, "We failed to serialize the core fields.");
+    return;
+  }
 
   // Generate the transaction ID
   SHA2<HASH_TYPE::HASH_VARIANT_256> sha2;
@@ -64,6 +78,7 @@ Transaction::Transaction(const uint32_t& version, const uint64_t& nonce,
     return;
   }
   copy(output.begin(), output.end(), m_tranID.asArray().begin());
+  m_serializedCoreInfo = txnData;
 
   // Generate the signature
   if (!Schnorr::GetInstance().Sign(txnData, senderKeyPair.first,
@@ -92,7 +107,10 @@ Transaction::Transaction(const uint32_t& version, const uint64_t& nonce,
                  gasLimit, code, data),
       m_signature(signature) {
   bytes txnData;
-  SerializeCoreFields(txnData, 0);
+  if (!SerializeCoreFields(txnData, 0)) {
+    LOG_GENERAL(WARNING, "We failed to serialize the core fields.");
+    return;
+  }
 
   // Generate the transaction ID
   SHA2<HASH_TYPE::HASH_VARIANT_256> sha2;
@@ -103,6 +121,7 @@ Transaction::Transaction(const uint32_t& version, const uint64_t& nonce,
     return;
   }
   copy(output.begin(), output.end(), m_tranID.asArray().begin());
+  m_serializedCoreInfo = txnData;
 
   // Verify the signature
   if (!Schnorr::GetInstance().Verify(txnData, m_signature,
@@ -116,6 +135,14 @@ Transaction::Transaction(const TxnHash& tranID,
                          const Signature& signature)
     : m_tranID(tranID), m_coreInfo(coreInfo), m_signature(signature) {}
 
+Transaction::Transaction(const TxnHash& tranID,
+                         const TransactionCoreInfo& coreInfo,
+                         const Signature& signature, bytes&& serializedCoreInfo)
+    : m_tranID(tranID),
+      m_coreInfo(coreInfo),
+      m_signature(signature),
+      m_serializedCoreInfo(move(serializedCoreInfo)) {}
+
 bool Transaction::Serialize(bytes& dst, unsigned int offset) const {
   if (!Messenger::SetTransaction(dst, offset, *this)) {
     LOG_GENERAL(WARNING, "Messenger::SetTransaction failed.");
@@ -140,6 +167,10 @@ const TransactionCoreInfo& Transaction::GetCoreInfo() const {
   return m_coreInfo;
 }
 
+const bytes& Transaction::GetSerializedCoreInfo() const {
+  return m_serializedCoreInfo;
+}
+
 const uint32_t& Transaction::GetVersion() const { return m_coreInfo.version; }
 
 const uint64_t& Transaction::GetNonce() const { return m_coreInfo.nonce; }
@@ -206,6 +237,7 @@ Transaction& Transaction::operator=(const Transaction& src) {
        m_tranID.asArray().begin());
   m_signature = src.m_signature;
   m_coreInfo = src.m_coreInfo;
+  m_serializedCoreInfo = src.m_serializedCoreInfo;
 
   return *this;
 }
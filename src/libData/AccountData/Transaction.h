@@ -69,6 +69,9 @@ class Transaction : public SerializableDataBlock {
   TxnHash m_tranID;
   TransactionCoreInfo m_coreInfo;
   Signature m_signature;
+  // The serialized core fields that m_tranID hashes and m_signature signs,
+  // kept so they are not encoded again. Empty if not computed.
+  bytes m_serializedCoreInfo;
 
  public:
   /// Default constructor.
@@ -106,6 +109,10 @@ class Transaction : public SerializableDataBlock {
   Transaction(const TxnHash& tranID, const TransactionCoreInfo coreInfo,
               const Signature& signature);
 
+  /// Constructor with core information and its serialized form.
+  Transaction(const TxnHash& tranID, const TransactionCoreInfo& coreInfo,
+              const Signature& signature, bytes&& serializedCoreInfo);
+
   /// Constructor for loading transaction information from a byte stream.
   Transaction(const bytes& src, unsigned int offset);
 
@@ -123,6 +130,10 @@ class Transaction : public SerializableDataBlock {
   /// Returns the core information of transaction
   const TransactionCoreInfo& GetCoreInfo() const;
 
+  /// Returns the serialized core information, or an empty array if this
+  /// transaction was not built from it
+  const bytes& GetSerializedCoreInfo() const;
+
   /// Returns the current version.
   const uint32_t& GetVersion() const;
 
@@ -16,6 +16,7 @@
  */
 
 #include "TransactionReceipt.h"
+#include "ReceiptEncoding.h"
 #include "libMessage/Messenger.h"
 #include "libUtils/JsonUtils.h"
 
@@ -42,19 +43,6 @@ bool TransactionReceipt::Deserialize(const bytes& src, unsigned int offset) {
     return false;
   }
 
-  if (!JSONUtils::GetInstance().convertStrtoJson(m_tranReceiptStr,
-                                                 m_tranReceiptObj)) {
-    LOG_GENERAL(WARNING, "Error with convert receipt string to json object");
-    return false;
-  }
-
-  try {
-    update();
-  } catch (const std::exception& e) {
-    LOG_GENERAL(WARNING, "Error with TransactionReceipt::Deserialize."
-                             << ' ' << e.what());
-    return false;
-  }
   return true;
 }
 
@@ -86,23 +74,74 @@ void TransactionReceipt::SetEpochNum(const uint64_t& epochNum) {
   m_tranReceiptObj["epoch_num"] = to_string(epochNum);
 }
 
+string TransactionReceipt::GetString() const {
+  Json::Value receiptObj;
+  if (!ReceiptEncoding::Decode(m_tranReceiptBytes, receiptObj)) {
+    return "{}";
+  }
+  return JSONUtils::GetInstance().convertJsontoStr(receiptObj);
+}
+
 void TransactionReceipt::SetString(const std::string& tranReceiptStr) {
+  Json::Value receiptObj;
+  bytes receiptBytes;
   if (!JSONUtils::GetInstance().convertStrtoJson(tranReceiptStr,
-                                                 m_tranReceiptObj)) {
+                                                 receiptObj) ||
+      !ReceiptEncoding::Encode(receiptObj, receiptBytes)) {
     LOG_GENERAL(WARNING, "Error with convert receipt string to json object");
     return;
   }
-  m_tranReceiptStr = tranReceiptStr;
+  m_tranReceiptObj = move(receiptObj);
+  m_tranReceiptBytes = move(receiptBytes);
+  RebuildEventBloom();
+}
+
+bool TransactionReceipt::SetBytes(const bytes& tranReceiptBytes) {
+  Json::Value receiptObj;
+  if (!ReceiptEncoding::Decode(tranReceiptBytes, receiptObj)) {
+    return false;
+  }
+  m_tranReceiptObj = move(receiptObj);
+  m_tranReceiptBytes = tranReceiptBytes;
+  RebuildEventBloom();
+  return true;
+}
+
+void TransactionReceipt::RebuildEventBloom() {
+  m_eventBloom = EventBloom();
+  if (m_tranReceiptObj.isMember("event_logs")) {
+    for (const auto& eventObj : m_tranReceiptObj["event_logs"]) {
+      AddToEventBloom(eventObj);
+    }
+  }
 }
 
 void TransactionReceipt::AddEntry(const LogEntry& entry) {
   m_tranReceiptObj["event_logs"].append(entry.GetJsonObject());
+  AddToEventBloom(entry.GetJsonObject());
+}
+
+void TransactionReceipt::AddToEventBloom(const Json::Value& eventObj) {
+  // Installed entries have the address as 0x prefixed hex
+  std::string address = eventObj.get("address", "").asString();
+  if (address.size() == ACC_ADDR_SIZE * 2 + 2 &&
+      address.compare(0, 2, "0x") == 0) {
+    address.erase(0, 2);
+  }
+  bytes addrBytes;
+  if (address.size() != ACC_ADDR_SIZE * 2 ||
+      !DataConversion::HexStrToUint8Vec(address, addrBytes)) {
+    return;
+  }
+  m_eventBloom.Add(Address(addrBytes),
+                   eventObj.get("_eventname", "").asString());
 }
 
 void TransactionReceipt::clear() {
-  m_tranReceiptStr.clear();
+  m_tranReceiptBytes.clear();
   m_tranReceiptObj.clear();
   m_errorObj.clear();
+  m_eventBloom = EventBloom();
   m_depth = 0;
   update();
 }
@@ -123,12 +162,13 @@ void TransactionReceipt::InstallError() {
 
 void TransactionReceipt::update() {
   if (m_tranReceiptObj == Json::nullValue) {
-    m_tranReceiptStr = "{}";
+    ReceiptEncoding::Encode(Json::Value(Json::objectValue), m_tranReceiptBytes);
     return;
   }
   InstallError();
-  m_tranReceiptStr =
-      JSONUtils::GetInstance().convertJsontoStr(m_tranReceiptObj);
+  if (!ReceiptEncoding::Encode(m_tranReceiptObj, m_tranReceiptBytes)) {
+    LOG_GENERAL(WARNING, "Failed to encode the receipt");
+  }
 }
 
 /// Implements the Serialize function inherited from Serializable.
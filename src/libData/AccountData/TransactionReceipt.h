@@ -26,10 +26,12 @@
 #include <unordered_map>
 #include <vector>
 
+#include "EventBloom.h"
 #include "LogEntry.h"
 #include "Transaction.h"
 #include "depends/common/FixedHash.h"
 #include "libCrypto/Sha2.h"
+#include "libData/DataStructures/FlatHashMap.h"
 #include "libUtils/DataConversion.h"
 #include "libUtils/Logger.h"
 
@@ -58,10 +60,17 @@ enum ReceiptError : unsigned int {
 
 class TransactionReceipt : public SerializableDataBlock {
   Json::Value m_tranReceiptObj = Json::nullValue;
-  std::string m_tranReceiptStr;
+  /// ReceiptEncoding of the receipt as of the last update, which is what is
+  /// stored and hashed
+  bytes m_tranReceiptBytes;
   uint64_t m_cumGas = 0;
   unsigned int m_depth = 0;
   Json::Value m_errorObj;
+  /// Over the event logs, kept as they are added or read back
+  EventBloom m_eventBloom;
+
+  void AddToEventBloom(const Json::Value& eventObj);
+  void RebuildEventBloom();
 
  public:
   TransactionReceipt();
@@ -74,11 +83,16 @@ class TransactionReceipt : public SerializableDataBlock {
   void SetCumGas(const uint64_t& cumGas);
   void SetEpochNum(const uint64_t& epochNum);
   void AddEntry(const LogEntry& entry);
-  const std::string& GetString() const { return m_tranReceiptStr; }
+  /// Renders the json of GetBytes, for the RPC
+  std::string GetString() const;
   void SetString(const std::string& tranReceiptStr);
+  const bytes& GetBytes() const { return m_tranReceiptBytes; }
+  /// Takes a receipt in ReceiptEncoding as it was stored or sent
+  bool SetBytes(const bytes& tranReceiptBytes);
   const uint64_t& GetCumGas() const { return m_cumGas; }
   void clear();
   const Json::Value& GetJsonValue() const { return m_tranReceiptObj; }
+  const EventBloom& GetEventBloom() const { return m_eventBloom; }
   void update();
 };
 
@@ -115,15 +129,14 @@ class TransactionWithReceipt : public SerializableDataBlock {
 
     SHA2<HASH_TYPE::HASH_VARIANT_256> sha2;
     for (const auto& tr : txrs) {
-      sha2.Update(DataConversion::StringToCharArray(
-          tr.GetTransactionReceipt().GetString()));
+      sha2.Update(tr.GetTransactionReceipt().GetBytes());
     }
     return TxnHash(sha2.Finalize());
   }
 
   static bool ComputeTransactionReceiptsHash(
       const std::vector<TxnHash>& txnOrder,
-      std::unordered_map<TxnHash, TransactionWithReceipt>& txrs,
+      FixedHashMap<TxnHash, TransactionWithReceipt>& txrs,
       TxnHash& trHash) {
     std::vector<TransactionWithReceipt> vec;
 
@@ -18,49 +18,129 @@
 #ifndef __TXNPOOL_H__
 #define __TXNPOOL_H__
 
+#include <cstdint>
 #include <functional>
-#include <map>
+#include <set>
 #include <unordered_map>
 
 #include "Account.h"
+#include "PooledTransaction.h"
 #include "Transaction.h"
 
+/// Pending transactions, each stored once in HashIndex in its compact pooled
+/// form; the gas price index orders their hashes and the sender/nonce index
+/// points into them. unordered_map nodes are stable, so the pointers survive
+/// rehashing and moving the pool, but copies have to rebuild the indexes.
 struct TxnPool {
+  /// Sender and nonce of a pooled transaction, referring to the sender key
+  /// held by that transaction instead of copying it
+  struct PubKeyNonce {
+    const PooledTransaction::PubKeyBytes* pubKey;
+    uint64_t nonce;
+
+    bool operator==(const PubKeyNonce& r) const {
+      return (nonce == r.nonce) && (*pubKey == *r.pubKey);
+    }
+  };
+
   struct PubKeyNonceHash {
-    std::size_t operator()(
-        const std::pair<PubKey, boost::multiprecision::uint128_t>& p) const {
-      std::size_t seed = 0;
-      boost::hash_combine(seed, std::string(p.first));
-      boost::hash_combine(seed, p.second.convert_to<std::string>());
+    std::size_t operator()(const PubKeyNonce& p) const {
+      std::size_t seed = boost::hash_range(p.pubKey->begin(), p.pubKey->end());
+      boost::hash_combine(seed, p.nonce);
 
       return seed;
     }
   };
 
-  std::unordered_map<TxnHash, Transaction> HashIndex;
-  std::map<boost::multiprecision::uint128_t, std::map<TxnHash, Transaction>,
-           std::greater<boost::multiprecision::uint128_t>>
-      GasIndex;
-  std::unordered_map<std::pair<PubKey, uint64_t>, Transaction, PubKeyNonceHash>
+  /// Position of a pooled transaction in the gas price order. The price is
+  /// split into native words so ordering avoids multiprecision compares.
+  struct GasKey {
+    uint64_t priceHigh;
+    uint64_t priceLow;
+    TxnHash tranID;
+
+    explicit GasKey(const PooledTransaction& t)
+        : priceHigh(static_cast<uint64_t>(t.GetGasPrice() >> 64)),
+          priceLow(static_cast<uint64_t>(t.GetGasPrice() & UINT64_MAX)),
+          tranID(t.GetTranID()) {}
+
+    /// Highest gas price first, then lowest hash
+    bool operator<(const GasKey& r) const {
+      if (priceHigh != r.priceHigh) {
+        return priceHigh > r.priceHigh;
+      }
+      if (priceLow != r.priceLow) {
+        return priceLow > r.priceLow;
+      }
+      return tranID < r.tranID;
+    }
+  };
+
+  std::unordered_map<TxnHash, PooledTransaction> HashIndex;
+  std::set<GasKey> GasIndex;
+  std::unordered_map<PubKeyNonce, const PooledTransaction*, PubKeyNonceHash>
       NonceIndex;
+  /// Sum of the gas limits of the pooled transactions
+  boost::multiprecision::uint128_t GasLimitTotal = 0;
+
+  TxnPool() = default;
+  TxnPool(TxnPool&&) = default;
+  TxnPool& operator=(TxnPool&&) = default;
+
+  TxnPool(const TxnPool& src) : HashIndex(src.HashIndex) { reindex(); }
+
+  TxnPool& operator=(const TxnPool& src) {
+    if (this != &src) {
+      HashIndex = src.HashIndex;
+      reindex();
+    }
+    return *this;
+  }
 
   void clear() {
     HashIndex.clear();
     GasIndex.clear();
     NonceIndex.clear();
+    GasLimitTotal = 0;
   }
 
   unsigned int size() { return HashIndex.size(); }
 
+  /// Estimate of the heap bytes of the transactions and the indexes
+  uint64_t memoryBytes() const {
+    uint64_t bytes = 0;
+    for (const auto& entry : HashIndex) {
+      bytes += entry.second.GetPayloadSize();
+    }
+    // The nodes of the three indexes, with two pointers of overhead each
+    return bytes +
+           HashIndex.size() *
+               (sizeof(std::pair<const TxnHash, PooledTransaction>) +
+                sizeof(GasKey) + 4 * sizeof(void*) +
+                sizeof(std::pair<const PubKeyNonce, const PooledTransaction*>));
+  }
+
   bool exist(const TxnHash& th) {
     return HashIndex.find(th) != HashIndex.end();
   }
 
   bool get(const TxnHash& th, Transaction& t) {
-    if (!exist(th)) {
+    auto searchHash = HashIndex.find(th);
+    if (searchHash == HashIndex.end()) {
+      return false;
+    }
+    t = searchHash->second.ToTransaction();
+
+    return true;
+  }
+
+  /// Removes the transaction with this hash from the pool into t
+  bool take(const TxnHash& th, Transaction& t) {
+    auto searchHash = HashIndex.find(th);
+    if (searchHash == HashIndex.end()) {
       return false;
     }
-    t = HashIndex.at(th);
+    t = take(searchHash);
 
     return true;
   }
@@ -70,52 +150,28 @@ struct TxnPool {
       return false;
     }
 
-    auto searchNonce = NonceIndex.find({t.GetSenderPubKey(), t.GetNonce()});
+    const auto sender = PooledTransaction::EncodePubKey(t.GetSenderPubKey());
+    auto searchNonce = NonceIndex.find({&sender, t.GetNonce()});
     if (searchNonce != NonceIndex.end()) {
-      if ((t.GetGasPrice() > searchNonce->second.GetGasPrice()) ||
-          (t.GetGasPrice() == searchNonce->second.GetGasPrice() &&
-           t.GetTranID() < searchNonce->second.GetTranID())) {
-        // erase from HashIdxTxns
-        auto searchHash = HashIndex.find(searchNonce->second.GetTranID());
-        if (searchHash != HashIndex.end()) {
-          HashIndex.erase(searchHash);
-        }
-        // erase from GasIdxTxns
-        auto searchGas = GasIndex.find(searchNonce->second.GetGasPrice());
-        if (searchGas != GasIndex.end()) {
-          auto searchGasHash =
-              searchGas->second.find(searchNonce->second.GetTranID());
-          if (searchGasHash != searchGas->second.end()) {
-            searchGas->second.erase(searchGasHash);
-          }
-        }
-        HashIndex[t.GetTranID()] = t;
-        GasIndex[t.GetGasPrice()][t.GetTranID()] = t;
-        searchNonce->second = t;
+      const PooledTransaction& existing = *searchNonce->second;
+      if ((t.GetGasPrice() > existing.GetGasPrice()) ||
+          (t.GetGasPrice() == existing.GetGasPrice() &&
+           t.GetTranID() < existing.GetTranID())) {
+        erase(HashIndex.find(existing.GetTranID()));
+        add(t);
       }
     } else {
-      HashIndex[t.GetTranID()] = t;
-      GasIndex[t.GetGasPrice()][t.GetTranID()] = t;
-      NonceIndex[{t.GetSenderPubKey(), t.GetNonce()}] = t;
+      add(t);
     }
     return true;
   }
 
   void findSameNonceButHigherGas(Transaction& t) {
-    auto searchNonce = NonceIndex.find({t.GetSenderPubKey(), t.GetNonce()});
+    const auto sender = PooledTransaction::EncodePubKey(t.GetSenderPubKey());
+    auto searchNonce = NonceIndex.find({&sender, t.GetNonce()});
     if (searchNonce != NonceIndex.end()) {
-      if (searchNonce->second.GetGasPrice() > t.GetGasPrice()) {
-        t = std::move(searchNonce->second);
-
-        // erase tx nonce map
-        NonceIndex.erase(searchNonce);
-        // erase tx gas map
-        GasIndex[t.GetGasPrice()].erase(t.GetTranID());
-        if (GasIndex[t.GetGasPrice()].empty()) {
-          GasIndex.erase(t.GetGasPrice());
-        }
-        // erase tx hash map
-        HashIndex.erase(t.GetTranID());
+      if (searchNonce->second->GetGasPrice() > t.GetGasPrice()) {
+        t = take(HashIndex.find(searchNonce->second->GetTranID()));
       }
     }
   }
@@ -125,32 +181,59 @@ struct TxnPool {
       return false;
     }
 
-    auto firstGas = GasIndex.begin();
-    auto firstHash = firstGas->second.begin();
+    t = take(HashIndex.find(GasIndex.begin()->tranID));
+    return true;
+  }
 
-    if (firstHash != firstGas->second.end()) {
-      t = std::move(firstHash->second);
+ private:
+  void addToIndexes(const PooledTransaction& t) {
+    GasIndex.emplace(t);
+    NonceIndex[{&t.GetSenderPubKey(), t.GetNonce()}] = &t;
+    GasLimitTotal += t.GetGasLimit();
+  }
 
-      // erase tx gas map
-      firstGas->second.erase(firstHash);
-      if (firstGas->second.empty()) {
-        GasIndex.erase(firstGas);
-      }
-      // erase tx nonce map
-      NonceIndex.erase({t.GetSenderPubKey(), t.GetNonce()});
-      // erase tx hash m ap
-      HashIndex.erase(t.GetTranID());
-      return true;
+  void add(const Transaction& t) {
+    addToIndexes(HashIndex.emplace(t.GetTranID(), PooledTransaction(t))
+                     .first->second);
+  }
+
+  void reindex() {
+    GasIndex.clear();
+    NonceIndex.clear();
+    GasLimitTotal = 0;
+    for (const auto& entry : HashIndex) {
+      addToIndexes(entry.second);
     }
-    return false;
+  }
+
+  void eraseFromIndexes(const PooledTransaction& t) {
+    NonceIndex.erase({&t.GetSenderPubKey(), t.GetNonce()});
+    GasIndex.erase(GasKey(t));
+    GasLimitTotal -= t.GetGasLimit();
+  }
+
+  void erase(std::unordered_map<TxnHash, PooledTransaction>::iterator it) {
+    eraseFromIndexes(it->second);
+    HashIndex.erase(it);
+  }
+
+  /// Removes the transaction from the pool and returns it in full
+  Transaction take(
+      std::unordered_map<TxnHash, PooledTransaction>::iterator it) {
+    eraseFromIndexes(it->second);
+    Transaction t = it->second.ToTransaction();
+    HashIndex.erase(it);
+    return t;
   }
 };
 
 inline std::ostream& operator<<(std::ostream& os, const TxnPool& t) {
   os << "Txn in txnPool: " << std::endl;
   for (const auto& entry : t.HashIndex) {
+    const bytes sender(entry.second.GetSenderPubKey().begin(),
+                       entry.second.GetSenderPubKey().end());
     os << "TranID: " << entry.first.hex() << " Sender:"
-       << Account::GetAddressFromPublicKey(entry.second.GetSenderPubKey())
+       << Account::GetAddressFromPublicKey(PubKey(sender, 0))
        << " Nonce: " << entry.second.GetNonce() << std::endl;
   }
   return os;
@@ -18,6 +18,8 @@
 #ifndef __BLOCKCHAIN_H__
 #define __BLOCKCHAIN_H__
 
+#include <atomic>
+#include <memory>
 #include <mutex>
 #include <vector>
 
@@ -29,68 +31,136 @@
 #include "libData/BlockData/Block/DSBlock.h"
 #include "libData/DataStructures/CircularArray.h"
 #include "libPersistence/BlockStorage.h"
+#include "libUtils/MemoryStats.h"
 
 /// Transient storage for DS/Tx/ Blocks. The block should have function
 /// .GetHeader().GetBlockNum()
+///
+/// Blocks are kept behind shared pointers to const, swapped into the slots
+/// atomically, so that readers never take the lock nor copy a block unless
+/// they ask for one by value. Writers are serialised by m_mutexBlocks.
 template <class T>
 class BlockChain {
+ public:
+  typedef std::shared_ptr<const T> BlockPtr;
+
+ private:
   std::mutex m_mutexBlocks;
-  CircularArray<T> m_blocks;
+  CircularArray<BlockPtr> m_blocks;
+
+  /// Published after the slot is stored and before m_lastBlock, so that
+  /// readers that see a last block can get it by number
+  std::atomic<uint64_t> m_blockCount;
+  /// Read and written with std::atomic_load and std::atomic_store
+  BlockPtr m_lastBlock;
+
+  static const BlockPtr& GetEmptyBlock() {
+    static const BlockPtr emptyBlock = std::make_shared<const T>();
+    return emptyBlock;
+  }
+
+  static uint64_t GetBlockNum(const BlockPtr& block) {
+    return block ? block->GetHeader().GetBlockNum() : INIT_BLOCK_NUMBER;
+  }
+
+  BlockPtr GetPersistedBlock(const uint64_t& blockNum) {
+    BlockPtr block = GetBlockFromPersistentStorage(blockNum);
+    return block ? block : GetEmptyBlock();
+  }
 
  protected:
   /// Constructor.
-  BlockChain() { Reset(); }
+  BlockChain() : m_blockCount(0) { Reset(); }
 
-  virtual T GetBlockFromPersistentStorage(const uint64_t& blockNum) = 0;
+  virtual BlockPtr GetBlockFromPersistentStorage(const uint64_t& blockNum) = 0;
 
  public:
   /// Destructor.
   ~BlockChain() {}
 
   /// Reset
-  void Reset() { m_blocks.resize(BLOCKCHAIN_SIZE); }
-
-  /// Returns the number of blocks.
-  uint64_t GetBlockCount() {
+  void Reset() {
     std::lock_guard<std::mutex> g(m_mutexBlocks);
-    return m_blocks.size();
+    m_blocks.resize(BLOCKCHAIN_SIZE);
+    m_blockCount = 0;
+    std::atomic_store(&m_lastBlock, BlockPtr());
   }
 
-  /// Returns the last stored block.
-  T GetLastBlock() {
-    std::lock_guard<std::mutex> g(m_mutexBlocks);
-    try {
-      return m_blocks.back();
-    } catch (...) {
-      return T();
-    }
+  /// Returns the number of blocks.
+  uint64_t GetBlockCount() { return m_blockCount; }
+
+  /// Returns the last stored block, or a dummy block if there is none.
+  BlockPtr GetLastBlockPtr() {
+    BlockPtr block = std::atomic_load(&m_lastBlock);
+    return block ? block : GetEmptyBlock();
   }
 
-  /// Returns the block at the specified block number.
-  T GetBlock(const uint64_t& blockNum) {
-    std::lock_guard<std::mutex> g(m_mutexBlocks);
+  /// Returns the block at the specified block number, or a dummy block if it
+  /// is not known.
+  BlockPtr GetBlockPtr(const uint64_t& blockNum) {
+    const uint64_t blockCount = m_blockCount;
+    const BlockPtr lastBlock = std::atomic_load(&m_lastBlock);
 
-    if (m_blocks.size() > 0 &&
-        (m_blocks.back().GetHeader().GetBlockNum() < blockNum)) {
+    if (blockCount > 0 && lastBlock &&
+        (lastBlock->GetHeader().GetBlockNum() < blockNum)) {
       LOG_GENERAL(WARNING,
                   "BlockNum too high " << blockNum << " Dummy block used");
-      return T();
+      return GetEmptyBlock();
+    }
+
+    else if (blockNum + m_blocks.capacity() < blockCount) {
+      return GetPersistedBlock(blockNum);
     }
 
-    else if (blockNum + m_blocks.capacity() < m_blocks.size()) {
-      return GetBlockFromPersistentStorage(blockNum);
+    BlockPtr block = std::atomic_load(&m_blocks[blockNum]);
+    const uint64_t blockNumInSlot = GetBlockNum(block);
+    if (blockNumInSlot != INIT_BLOCK_NUMBER && blockNumInSlot > blockNum) {
+      // The slot was reused by a newer block since the count was read
+      return GetPersistedBlock(blockNum);
     }
 
-    if (m_blocks[blockNum].GetHeader().GetBlockNum() != blockNum) {
+    if (blockNumInSlot != blockNum) {
       LOG_GENERAL(WARNING,
                   "BlockNum : " << blockNum << " != GetBlockNum() : "
-                                << m_blocks[blockNum].GetHeader().GetBlockNum()
+                                << blockNumInSlot
                                 << ", a dummy block will be used and abnormal "
                                    "behavior may happen!");
-      return T();
+      return GetEmptyBlock();
     }
-    return m_blocks[blockNum];
+    return block;
   }
+
+  /// Returns the number of blocks held and the bytes of their serialized
+  /// forms, which are close to the memory they take
+  MemoryStats::Usage GetMemoryUsage() {
+    std::vector<BlockPtr> blocks;
+    {
+      std::lock_guard<std::mutex> g(m_mutexBlocks);
+      for (size_t i = 0; i < m_blocks.capacity(); i++) {
+        BlockPtr block = std::atomic_load(&m_blocks[i]);
+        if (block) {
+          blocks.emplace_back(std::move(block));
+        }
+      }
+    }
+
+    MemoryStats::Usage usage;
+    for (const auto& block : blocks) {
+      bytes serialized;
+      if (block->Serialize(serialized, 0)) {
+        usage.m_entries++;
+        usage.m_bytes += serialized.size();
+      }
+    }
+    return usage;
+  }
+
+  /// Returns a copy of the last stored block.
+  T GetLastBlock() { return *GetLastBlockPtr(); }
+
+  /// Returns a copy of the block at the specified block number.
+  T GetBlock(const uint64_t& blockNum) { return *GetBlockPtr(blockNum); }
+
   /// Adds a block to the chain.
   int AddBlock(const T& block) {
     uint64_t blockNumOfNewBlock = block.GetHeader().GetBlockNum();
@@ -98,13 +168,12 @@ class BlockChain {
     std::lock_guard<std::mutex> g(m_mutexBlocks);
 
     uint64_t blockNumOfExistingBlock =
-        m_blocks[blockNumOfNewBlock].GetHeader().GetBlockNum();
+        GetBlockNum(std::atomic_load(&m_blocks[blockNumOfNewBlock]));
 
     if (blockNumOfExistingBlock < blockNumOfNewBlock ||
         INIT_BLOCK_NUMBER == blockNumOfExistingBlock) {
       if (m_blocks.size() > 0) {
-        uint64_t blockNumOfLastBlock =
-            m_blocks.back().GetHeader().GetBlockNum();
+        uint64_t blockNumOfLastBlock = GetBlockNum(m_lastBlock);
         uint64_t blockNumMissed = blockNumOfNewBlock - blockNumOfLastBlock - 1;
         if (blockNumMissed > 0) {
           LOG_GENERAL(INFO,
@@ -113,8 +182,16 @@ class BlockChain {
                           << blockNumMissed);
           m_blocks.increase_size(blockNumMissed);
         }
+      } else {
+        // A chain restored from its newest blocks starts past the genesis
+        m_blocks.increase_size(blockNumOfNewBlock);
       }
-      m_blocks.insert_new(blockNumOfNewBlock, block);
+
+      BlockPtr newBlock = std::make_shared<const T>(block);
+      std::atomic_store(&m_blocks[blockNumOfNewBlock], newBlock);
+      m_blocks.increase_size(1);
+      m_blockCount = m_blocks.size();
+      std::atomic_store(&m_lastBlock, newBlock);
     } else {
       LOG_GENERAL(WARNING, "Failed to add " << blockNumOfNewBlock << " "
                                             << blockNumOfExistingBlock);
@@ -127,33 +204,33 @@ class BlockChain {
 
 class DSBlockChain : public BlockChain<DSBlock> {
  public:
-  DSBlock GetBlockFromPersistentStorage(const uint64_t& blockNum) {
+  BlockPtr GetBlockFromPersistentStorage(const uint64_t& blockNum) {
     DSBlockSharedPtr block;
     if (!BlockStorage::GetBlockStorage().GetDSBlock(blockNum, block)) {
       LOG_GENERAL(WARNING, "BlockNum not in persistent storage "
                                << blockNum << " Dummy block used");
-      return DSBlock();
+      return nullptr;
     }
-    return *block;
+    return block;
   }
 };
 
 class TxBlockChain : public BlockChain<TxBlock> {
  public:
-  TxBlock GetBlockFromPersistentStorage(const uint64_t& blockNum) {
+  BlockPtr GetBlockFromPersistentStorage(const uint64_t& blockNum) {
     TxBlockSharedPtr block;
     if (!BlockStorage::GetBlockStorage().GetTxBlock(blockNum, block)) {
       LOG_GENERAL(WARNING, "BlockNum not in persistent storage "
                                << blockNum << " Dummy block used");
-      return TxBlock();
+      return nullptr;
     }
-    return *block;
+    return block;
   }
 };
 
 class VCBlockChain : public BlockChain<VCBlock> {
  public:
-  VCBlock GetBlockFromPersistentStorage([
+  BlockPtr GetBlockFromPersistentStorage([
       [gnu::unused]] const uint64_t& blockNum) {
     throw "vc block persistent storage not supported";
   }
@@ -161,7 +238,7 @@ class VCBlockChain : public BlockChain<VCBlock> {
 
 class FallbackBlockChain : public BlockChain<FallbackBlock> {
  public:
-  FallbackBlock GetBlockFromPersistentStorage([
+  BlockPtr GetBlockFromPersistentStorage([
       [gnu::unused]] const uint64_t& blockNum) {
     throw "fallback block persistent storage not supported";
   }
@@ -50,11 +50,11 @@ void BlockBase::SetBlockHash(const BlockHash& blockHash) {
 
 const Signature& BlockBase::GetCS1() const { return m_cosigs.m_CS1; }
 
-const vector<bool>& BlockBase::GetB1() const { return m_cosigs.m_B1; }
+const BitVector& BlockBase::GetB1() const { return m_cosigs.m_B1; }
 
 const Signature& BlockBase::GetCS2() const { return m_cosigs.m_CS2; }
 
-const vector<bool>& BlockBase::GetB2() const { return m_cosigs.m_B2; }
+const BitVector& BlockBase::GetB2() const { return m_cosigs.m_B2; }
 
 void BlockBase::SetCoSignatures(const ConsensusCommon& src) {
   m_cosigs.m_CS1 = src.GetCS1();
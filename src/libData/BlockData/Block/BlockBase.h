@@ -30,17 +30,18 @@
 #include "libCrypto/Schnorr.h"
 #include "libData/AccountData/Transaction.h"
 #include "libData/BlockData/BlockHeader/BlockHeaderBase.h"
+#include "libUtils/BitVector.h"
 
 struct CoSignatures {
   Signature m_CS1;
-  std::vector<bool> m_B1;
+  BitVector m_B1;
   Signature m_CS2;
-  std::vector<bool> m_B2;
+  BitVector m_B2;
 
   CoSignatures(unsigned int bitmaplen = 1) : m_B1(bitmaplen), m_B2(bitmaplen) {}
   CoSignatures(const CoSignatures& src) = default;
-  CoSignatures(const Signature& CS1, const std::vector<bool>& B1,
-               const Signature& CS2, const std::vector<bool>& B2)
+  CoSignatures(const Signature& CS1, const BitVector& B1,
+               const Signature& CS2, const BitVector& B2)
       : m_CS1(CS1), m_B1(B1), m_CS2(CS2), m_B2(B2) {}
 };
 
@@ -78,13 +79,13 @@ class BlockBase : public SerializableDataBlock {
   const Signature& GetCS1() const;
 
   /// Returns the co-sig bitmap for first round.
-  const std::vector<bool>& GetB1() const;
+  const BitVector& GetB1() const;
 
   /// Returns the co-sig for second round.
   const Signature& GetCS2() const;
 
   /// Returns the co-sig bitmap for second round.
-  const std::vector<bool>& GetB2() const;
+  const BitVector& GetB2() const;
 
   /// Sets the co-sig members.
   void SetCoSignatures(const ConsensusCommon& src);
@@ -31,21 +31,77 @@ BlockHeaderBase::BlockHeaderBase(const uint32_t& version,
       m_committeeHash(committeeHash),
       m_prevHash(prevHash) {}
 
-BlockHash BlockHeaderBase::GetMyHash() const {
+BlockHeaderBase::BlockHeaderBase(const BlockHeaderBase& src)
+    : m_serializedHeader(atomic_load(&src.m_serializedHeader)),
+      m_version(src.m_version),
+      m_committeeHash(src.m_committeeHash),
+      m_prevHash(src.m_prevHash) {}
+
+BlockHeaderBase& BlockHeaderBase::operator=(const BlockHeaderBase& src) {
+  if (this != &src) {
+    m_version = src.m_version;
+    m_committeeHash = src.m_committeeHash;
+    m_prevHash = src.m_prevHash;
+    atomic_store(&m_serializedHeader, atomic_load(&src.m_serializedHeader));
+  }
+  return *this;
+}
+
+shared_ptr<const BlockHeaderBase::SerializedHeader>
+BlockHeaderBase::GetSerializedHeader() const {
+  shared_ptr<const SerializedHeader> cached = atomic_load(&m_serializedHeader);
+  if (cached) {
+    return cached;
+  }
+
+  auto serializedHeader = make_shared<SerializedHeader>();
+  if (!Serialize(serializedHeader->m_serialized, 0)) {
+    return nullptr;
+  }
+
   SHA2<HASH_TYPE::HASH_VARIANT_256> sha2;
-  bytes vec;
-  Serialize(vec, 0);
-  sha2.Update(vec);
+  sha2.Update(serializedHeader->m_serialized);
   const bytes& resVec = sha2.Finalize();
-  BlockHash blockHash;
-  std::copy(resVec.begin(), resVec.end(), blockHash.asArray().begin());
-  return blockHash;
+  std::copy(resVec.begin(), resVec.end(),
+            serializedHeader->m_hash.asArray().begin());
+
+  // Racing threads compute the same bytes, so either may be kept
+  cached = move(serializedHeader);
+  atomic_store(&m_serializedHeader, cached);
+  return cached;
+}
+
+void BlockHeaderBase::InvalidateSerializedHeader() {
+  atomic_store(&m_serializedHeader, shared_ptr<const SerializedHeader>());
+}
+
+BlockHash BlockHeaderBase::GetMyHash() const {
+  const auto serializedHeader = GetSerializedHeader();
+  if (!serializedHeader) {
+    return BlockHash();
+  }
+  return serializedHeader->m_hash;
+}
+
+bool BlockHeaderBase::SerializeCached(bytes& dst, unsigned int offset) const {
+  const auto serializedHeader = GetSerializedHeader();
+  if (!serializedHeader) {
+    return false;
+  }
+
+  const bytes& serialized = serializedHeader->m_serialized;
+  if (dst.size() < offset + serialized.size()) {
+    dst.resize(offset + serialized.size());
+  }
+  std::copy(serialized.begin(), serialized.end(), dst.begin() + offset);
+  return true;
 }
 
 const uint32_t& BlockHeaderBase::GetVersion() const { return m_version; }
 
 void BlockHeaderBase::SetVersion(const uint32_t& version) {
   m_version = version;
+  InvalidateSerializedHeader();
 }
 
 const CommitteeHash& BlockHeaderBase::GetCommitteeHash() const {
@@ -54,12 +110,14 @@ const CommitteeHash& BlockHeaderBase::GetCommitteeHash() const {
 
 void BlockHeaderBase::SetCommitteeHash(const CommitteeHash& committeeHash) {
   m_committeeHash = committeeHash;
+  InvalidateSerializedHeader();
 }
 
 const BlockHash& BlockHeaderBase::GetPrevHash() const { return m_prevHash; }
 
 void BlockHeaderBase::SetPrevHash(const BlockHash& prevHash) {
   m_prevHash = prevHash;
+  InvalidateSerializedHeader();
 }
 
 bool BlockHeaderBase::operator==(const BlockHeaderBase& header) const {
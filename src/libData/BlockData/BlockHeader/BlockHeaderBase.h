@@ -19,6 +19,7 @@
 #define __BLOCKHEADERBASE_H__
 
 #include <array>
+#include <memory>
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 #include <boost/multiprecision/cpp_int.hpp>
@@ -36,21 +37,42 @@ const uint64_t INIT_BLOCK_NUMBER = (uint64_t)-1;
 
 /// [TODO] Base class for all supported block header types
 class BlockHeaderBase : public SerializableDataBlock {
+  /// The canonical serialization of the header and its hash
+  struct SerializedHeader {
+    bytes m_serialized;
+    BlockHash m_hash;
+  };
+
+  /// Computed on first use and shared by the copies of the header.
+  /// Read and written with std::atomic_load and std::atomic_store
+  mutable std::shared_ptr<const SerializedHeader> m_serializedHeader;
+
+  std::shared_ptr<const SerializedHeader> GetSerializedHeader() const;
+
  protected:
   // TODO: pull out all common code from ds, micro and tx block header
   uint32_t m_version;
   CommitteeHash m_committeeHash;
   BlockHash m_prevHash;
 
+  /// Drops the cached serialization, to be called whenever the header changes
+  void InvalidateSerializedHeader();
+
  public:
   // Constructors
   BlockHeaderBase();
   BlockHeaderBase(const uint32_t& version, const CommitteeHash& committeeHash,
                   const BlockHash& prevHash);
+  BlockHeaderBase(const BlockHeaderBase& src);
+
+  BlockHeaderBase& operator=(const BlockHeaderBase& src);
 
   /// Calculate my hash
   BlockHash GetMyHash() const;
 
+  /// Same as Serialize, but copies the cached serialization if there is one
+  bool SerializeCached(bytes& dst, unsigned int offset) const;
+
   /// Returns the current version of this block.
   const uint32_t& GetVersion() const;
 
@@ -83,6 +83,8 @@ BlockHash DSBlockHeader::GetHashForRandom() const {
 }
 
 bool DSBlockHeader::Deserialize(const bytes& src, unsigned int offset) {
+  InvalidateSerializedHeader();
+
   if (!Messenger::GetDSBlockHeader(src, offset, *this)) {
     LOG_GENERAL(WARNING, "Messenger::GetDSBlockHeader failed.");
     return false;
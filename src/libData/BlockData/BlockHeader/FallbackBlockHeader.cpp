@@ -66,6 +66,8 @@ bool FallbackBlockHeader::Serialize(bytes& dst, unsigned int offset) const {
 }
 
 bool FallbackBlockHeader::Deserialize(const bytes& src, unsigned int offset) {
+  InvalidateSerializedHeader();
+
   if (!Messenger::GetFallbackBlockHeader(src, offset, *this)) {
     LOG_GENERAL(WARNING, "Messenger::GetFallbackBlockHeader failed.");
     return false;
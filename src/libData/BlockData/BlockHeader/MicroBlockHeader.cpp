@@ -67,6 +67,8 @@ bool MicroBlockHeader::Serialize(bytes& dst, unsigned int offset) const {
 }
 
 bool MicroBlockHeader::Deserialize(const bytes& src, unsigned int offset) {
+  InvalidateSerializedHeader();
+
   if (!Messenger::GetMicroBlockHeader(src, offset, *this)) {
     LOG_GENERAL(WARNING, "Messenger::GetMicroBlockHeader failed.");
     return false;
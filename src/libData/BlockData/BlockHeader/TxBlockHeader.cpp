@@ -65,6 +65,8 @@ bool TxBlockHeader::Serialize(bytes& dst, unsigned int offset) const {
 }
 
 bool TxBlockHeader::Deserialize(const bytes& src, unsigned int offset) {
+  InvalidateSerializedHeader();
+
   if (!Messenger::GetTxBlockHeader(src, offset, *this)) {
     LOG_GENERAL(WARNING, "Messenger::GetTxBlockHeader failed.");
     return false;
@@ -62,6 +62,8 @@ bool VCBlockHeader::Serialize(bytes& dst, unsigned int offset) const {
 }
 
 bool VCBlockHeader::Deserialize(const bytes& src, unsigned int offset) {
+  InvalidateSerializedHeader();
+
   if (!Messenger::GetVCBlockHeader(src, offset, *this)) {
     LOG_GENERAL(WARNING, "Messenger::GetVCBlockHeader failed.");
     return false;
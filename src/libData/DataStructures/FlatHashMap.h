@@ -0,0 +1,436 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FLATHASHMAP_H__
+#define __FLATHASHMAP_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// Hash of keys whose bytes are already uniformly random, such as addresses
+/// and txn hashes: takes their first 8 bytes as they are, instead of hashing
+/// the whole key again. Key is a dev::FixedHash of at least 8 bytes.
+template <class Key>
+struct RandomBytesHash {
+  size_t operator()(const Key& key) const {
+    static_assert(Key::size >= sizeof(uint64_t), "Key is too short");
+    uint64_t h;
+    memcpy(&h, key.data(), sizeof(h));
+    return h;
+  }
+};
+
+/// Hash map whose index is a flat, linearly probed array of 8-byte slots, each
+/// holding 32 bits of the hash of its key and the index of its element.
+/// A lookup reads a run of adjacent slots and compares keys only on a match
+/// of the hash bits, instead of following the bucket list and node pointers
+/// of an unordered_map. The hash is mixed with a random per-process seed, so
+/// that keys cannot be ground offline to pile up in one run of slots.
+///
+/// The elements live in chunks that are never moved, allocated in doubling
+/// sizes, so pointers and references to elements stay valid until they are
+/// erased, as the account stores rely on. Iterators stay valid across inserts
+/// and the erasure of other elements. Has the subset of the unordered_map
+/// interface used by the account stores and the txn maps of the node.
+template <class Key, class T, class Hash = std::hash<Key>>
+class FlatHashMap {
+ public:
+  typedef Key key_type;
+  typedef T mapped_type;
+  typedef std::pair<const Key, T> value_type;
+
+ private:
+  static const uint32_t EMPTY = UINT32_MAX;
+  static const unsigned int MIN_SLOT_BITS = 3;
+  static const unsigned int FIRST_CHUNK_BITS = 3;
+
+  struct Slot {
+    uint32_t m_tag;
+    uint32_t m_index;
+  };
+
+  typedef typename std::aligned_storage<sizeof(value_type),
+                                        alignof(value_type)>::type Storage;
+
+  std::vector<Slot> m_slots;
+  unsigned int m_shift;
+  std::size_t m_size;
+
+  /// Chunk c holds the elements from index 8 * (2^c - 1), 8 * 2^c of them
+  std::vector<std::unique_ptr<Storage[]>> m_chunks;
+  std::vector<bool> m_live;
+  std::vector<uint32_t> m_free;
+
+  static uint64_t Seed() {
+    static const uint64_t seed = [] {
+      std::random_device rd;
+      return ((static_cast<uint64_t>(rd()) << 32) | rd()) | 1;
+    }();
+    return seed;
+  }
+
+  static uint32_t TagOf(const Key& key) {
+    return (static_cast<uint64_t>(Hash()(key)) * Seed()) >> 32;
+  }
+
+  std::size_t HomeOf(uint32_t tag) const { return tag >> m_shift; }
+
+  std::size_t Mask() const { return m_slots.size() - 1; }
+
+  value_type* Element(uint32_t index) const {
+    const uint64_t n = static_cast<uint64_t>(index) + (1u << FIRST_CHUNK_BITS);
+    const unsigned int chunk = 63 - __builtin_clzll(n) - FIRST_CHUNK_BITS;
+    const uint64_t offset = n - (1ull << (chunk + FIRST_CHUNK_BITS));
+    return reinterpret_cast<value_type*>(&m_chunks[chunk][offset]);
+  }
+
+  /// Returns an unused element index, adding a chunk if all are in use
+  uint32_t Allocate() {
+    if (!m_free.empty()) {
+      const uint32_t index = m_free.back();
+      m_free.pop_back();
+      return index;
+    }
+
+    const uint32_t index = m_live.size();
+    if (index == ((1u << (m_chunks.size() + FIRST_CHUNK_BITS)) -
+                  (1u << FIRST_CHUNK_BITS))) {
+      m_chunks.emplace_back(
+          new Storage[1u << (m_chunks.size() + FIRST_CHUNK_BITS)]);
+    }
+    m_live.push_back(false);
+    return index;
+  }
+
+  void Release(uint32_t index) {
+    Element(index)->~value_type();
+    m_live[index] = false;
+    m_free.push_back(index);
+  }
+
+  /// Returns the slot of key, or the empty slot ending its run
+  std::size_t Probe(const Key& key, uint32_t tag) const {
+    std::size_t pos = HomeOf(tag);
+    while (m_slots[pos].m_index != EMPTY &&
+           (m_slots[pos].m_tag != tag ||
+            !(Element(m_slots[pos].m_index)->first == key))) {
+      pos = (pos + 1) & Mask();
+    }
+    return pos;
+  }
+
+  void Rehash(unsigned int slotBits) {
+    std::vector<Slot> slots(std::size_t(1) << slotBits, Slot{0, EMPTY});
+    m_shift = 32 - slotBits;
+    const std::size_t mask = slots.size() - 1;
+
+    for (const Slot& slot : m_slots) {
+      if (slot.m_index != EMPTY) {
+        std::size_t pos = HomeOf(slot.m_tag);
+        while (slots[pos].m_index != EMPTY) {
+          pos = (pos + 1) & mask;
+        }
+        slots[pos] = slot;
+      }
+    }
+    m_slots.swap(slots);
+  }
+
+  /// Keeps the slots at most 3/4 full after adding count elements
+  void Grow(std::size_t count) {
+    unsigned int slotBits = 32 - m_shift;
+    while ((m_size + count) * 4 > (std::size_t(3) << slotBits)) {
+      ++slotBits;
+    }
+    if (slotBits != 32 - m_shift) {
+      Rehash(slotBits);
+    }
+  }
+
+  /// Empties slot pos and moves back the following slots of its run
+  void EraseSlot(std::size_t pos) {
+    std::size_t hole = pos;
+    for (std::size_t next = (pos + 1) & Mask();
+         m_slots[next].m_index != EMPTY; next = (next + 1) & Mask()) {
+      const std::size_t home = HomeOf(m_slots[next].m_tag);
+      if (((next - home) & Mask()) >= ((next - hole) & Mask())) {
+        m_slots[hole] = m_slots[next];
+        hole = next;
+      }
+    }
+    m_slots[hole].m_index = EMPTY;
+  }
+
+  /// Adds the element just constructed at index unless its key is present
+  std::pair<uint32_t, bool> Place(uint32_t index) {
+    const Key& key = Element(index)->first;
+    const uint32_t tag = TagOf(key);
+    std::size_t pos = Probe(key, tag);
+    if (m_slots[pos].m_index != EMPTY) {
+      Release(index);
+      return {m_slots[pos].m_index, false};
+    }
+
+    if ((m_size + 1) * 4 > m_slots.size() * 3) {
+      Grow(1);
+      pos = Probe(key, tag);
+    }
+    m_slots[pos] = {tag, index};
+    m_live[index] = true;
+    ++m_size;
+    return {index, true};
+  }
+
+  template <class Map, class Value>
+  class Iterator {
+    friend class FlatHashMap;
+
+    Map* m_map;
+    uint32_t m_index;
+
+    void SkipDead() {
+      while (m_index < m_map->m_live.size() && !m_map->m_live[m_index]) {
+        ++m_index;
+      }
+    }
+
+    Iterator(Map* map, uint32_t index) : m_map(map), m_index(index) {}
+
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef typename std::remove_const<Value>::type value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef Value* pointer;
+    typedef Value& reference;
+
+    Iterator() : m_map(nullptr), m_index(EMPTY) {}
+
+    /// iterator converts to const_iterator
+    template <class M, class V>
+    Iterator(const Iterator<M, V>& src)
+        : m_map(src.m_map), m_index(src.m_index) {}
+
+    reference operator*() const { return *m_map->Element(m_index); }
+    pointer operator->() const { return m_map->Element(m_index); }
+
+    Iterator& operator++() {
+      ++m_index;
+      SkipDead();
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator tmp(*this);
+      ++(*this);
+      return tmp;
+    }
+
+    bool operator==(const Iterator& r) const { return m_index == r.m_index; }
+    bool operator!=(const Iterator& r) const { return m_index != r.m_index; }
+
+    template <class M, class V>
+    friend class Iterator;
+  };
+
+ public:
+  typedef Iterator<FlatHashMap, value_type> iterator;
+  typedef Iterator<const FlatHashMap, const value_type> const_iterator;
+
+  FlatHashMap()
+      : m_slots(std::size_t(1) << MIN_SLOT_BITS, Slot{0, EMPTY}),
+        m_shift(32 - MIN_SLOT_BITS),
+        m_size(0) {}
+
+  FlatHashMap(const FlatHashMap& src) : FlatHashMap() { *this = src; }
+
+  FlatHashMap(FlatHashMap&& src) noexcept : FlatHashMap() { swap(src); }
+
+  ~FlatHashMap() { clear(); }
+
+  FlatHashMap& operator=(const FlatHashMap& src) {
+    if (this != &src) {
+      clear();
+      Grow(src.m_size);
+      for (const auto& entry : src) {
+        insert(entry);
+      }
+    }
+    return *this;
+  }
+
+  FlatHashMap& operator=(FlatHashMap&& src) noexcept {
+    if (this != &src) {
+      clear();
+      swap(src);
+    }
+    return *this;
+  }
+
+  void swap(FlatHashMap& other) noexcept {
+    m_slots.swap(other.m_slots);
+    std::swap(m_shift, other.m_shift);
+    std::swap(m_size, other.m_size);
+    m_chunks.swap(other.m_chunks);
+    m_live.swap(other.m_live);
+    m_free.swap(other.m_free);
+  }
+
+  iterator begin() {
+    iterator it(this, 0);
+    it.SkipDead();
+    return it;
+  }
+
+  const_iterator begin() const {
+    const_iterator it(this, 0);
+    it.SkipDead();
+    return it;
+  }
+
+  iterator end() { return iterator(this, m_live.size()); }
+
+  const_iterator end() const { return const_iterator(this, m_live.size()); }
+
+  bool empty() const { return m_size == 0; }
+
+  std::size_t size() const { return m_size; }
+
+  /// Makes room for count elements in all, without rehashing on the way
+  void reserve(std::size_t count) {
+    if (count > m_size) {
+      Grow(count - m_size);
+    }
+  }
+
+  iterator find(const Key& key) {
+    const std::size_t pos = Probe(key, TagOf(key));
+    return (m_slots[pos].m_index == EMPTY)
+               ? end()
+               : iterator(this, m_slots[pos].m_index);
+  }
+
+  const_iterator find(const Key& key) const {
+    const std::size_t pos = Probe(key, TagOf(key));
+    return (m_slots[pos].m_index == EMPTY)
+               ? end()
+               : const_iterator(this, m_slots[pos].m_index);
+  }
+
+  std::size_t count(const Key& key) const { return (find(key) != end()); }
+
+  T& at(const Key& key) {
+    auto it = find(key);
+    if (it == end()) {
+      throw std::out_of_range("FlatHashMap::at");
+    }
+    return it->second;
+  }
+
+  const T& at(const Key& key) const {
+    auto it = find(key);
+    if (it == end()) {
+      throw std::out_of_range("FlatHashMap::at");
+    }
+    return it->second;
+  }
+
+  template <class... Args>
+  std::pair<iterator, bool> emplace(Args&&... args) {
+    const uint32_t index = Allocate();
+    try {
+      new (Element(index)) value_type(std::forward<Args>(args)...);
+    } catch (...) {
+      m_free.push_back(index);
+      throw;
+    }
+    const auto result = Place(index);
+    return {iterator(this, result.first), result.second};
+  }
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    return emplace(value);
+  }
+
+  std::pair<iterator, bool> insert(value_type&& value) {
+    return emplace(std::move(value));
+  }
+
+  template <class P, class = typename std::enable_if<
+                         std::is_constructible<value_type, P&&>::value>::type>
+  std::pair<iterator, bool> insert(P&& value) {
+    return emplace(std::forward<P>(value));
+  }
+
+  T& operator[](const Key& key) {
+    auto it = find(key);
+    if (it != end()) {
+      return it->second;
+    }
+    return emplace(std::piecewise_construct, std::forward_as_tuple(key),
+                   std::forward_as_tuple())
+        .first->second;
+  }
+
+  std::size_t erase(const Key& key) {
+    const std::size_t pos = Probe(key, TagOf(key));
+    if (m_slots[pos].m_index == EMPTY) {
+      return 0;
+    }
+    Release(m_slots[pos].m_index);
+    EraseSlot(pos);
+    --m_size;
+    return 1;
+  }
+
+  iterator erase(const_iterator it) {
+    iterator next(this, it.m_index);
+    ++next;
+    erase(it->first);
+    return next;
+  }
+
+  void clear() {
+    for (uint32_t index = 0; index < m_live.size(); ++index) {
+      if (m_live[index]) {
+        Element(index)->~value_type();
+      }
+    }
+    m_live.clear();
+    m_free.clear();
+    m_chunks.clear();
+    m_slots.assign(std::size_t(1) << MIN_SLOT_BITS, Slot{0, EMPTY});
+    m_shift = 32 - MIN_SLOT_BITS;
+    m_size = 0;
+  }
+};
+
+/// FlatHashMap keyed by a dev::FixedHash of random bytes, such as Address or
+/// TxnHash
+template <class Key, class T>
+using FixedHashMap = FlatHashMap<Key, T, RandomBytesHash<Key>>;
+
+#endif  // __FLATHASHMAP_H__
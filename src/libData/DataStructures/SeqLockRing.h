@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SEQLOCKRING_H__
+#define __SEQLOCKRING_H__
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/// Ring of the last capacity pushed values, where each slot is guarded by a
+/// sequence lock. Readers never block writers: a reader that overlaps a write
+/// to a slot retries that slot, and skips it once the slot has moved on to a
+/// newer value.
+template <class T>
+class SeqLockRing {
+  static_assert(std::is_trivially_copyable<T>::value,
+                "SeqLockRing values are copied while they may be written");
+
+  struct Slot {
+    /// odd while a write is in progress
+    std::atomic<uint64_t> m_seq{0};
+    /// number of the push that wrote m_value, plus one (0 = never written)
+    uint64_t m_pushNum{0};
+    T m_value{};
+  };
+
+  const uint64_t m_capacity;
+  std::unique_ptr<Slot[]> m_slots;
+  std::atomic<uint64_t> m_numPushed{0};
+
+  void Write(uint64_t pushNum, const T& value) {
+    Slot& slot = m_slots[pushNum % m_capacity];
+
+    uint64_t seq = slot.m_seq.load(std::memory_order_relaxed);
+    while ((seq & 1) ||
+           !slot.m_seq.compare_exchange_weak(seq, seq + 1,
+                                             std::memory_order_acquire)) {
+      seq = slot.m_seq.load(std::memory_order_relaxed);
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.m_pushNum = pushNum + 1;
+    slot.m_value = value;
+
+    slot.m_seq.store(seq + 2, std::memory_order_release);
+  }
+
+ public:
+  explicit SeqLockRing(uint64_t capacity)
+      : m_capacity(capacity), m_slots(new Slot[capacity]) {}
+
+  SeqLockRing(const SeqLockRing&) = delete;
+  SeqLockRing& operator=(const SeqLockRing&) = delete;
+
+  uint64_t capacity() const { return m_capacity; }
+
+  /// Writers normally push from a single thread. Concurrent writers are safe,
+  /// they only wait on each other if one laps the other around the ring.
+  void Push(const T& value) {
+    if (m_capacity == 0) {
+      return;
+    }
+
+    Write(m_numPushed.fetch_add(1, std::memory_order_relaxed), value);
+  }
+
+  /// Pushes values in order, claiming their slots at once. Only the last
+  /// capacity of them are written, as the others would be overwritten.
+  void PushAll(const std::vector<T>& values) {
+    if (m_capacity == 0 || values.empty()) {
+      return;
+    }
+
+    const uint64_t firstPushNum =
+        m_numPushed.fetch_add(values.size(), std::memory_order_relaxed);
+    const uint64_t skipped =
+        (values.size() > m_capacity) ? values.size() - m_capacity : 0;
+    for (uint64_t i = skipped; i < values.size(); i++) {
+      Write(firstPushNum + i, values[i]);
+    }
+  }
+
+  /// Appends up to the last maxCount pushed values to values, newest first
+  void GetLatest(uint64_t maxCount, std::vector<T>& values) const {
+    const uint64_t numPushed = m_numPushed.load(std::memory_order_acquire);
+    const uint64_t count = std::min(std::min(maxCount, m_capacity), numPushed);
+
+    for (uint64_t i = 0; i < count; i++) {
+      const uint64_t pushNum = numPushed - i - 1;
+      const Slot& slot = m_slots[pushNum % m_capacity];
+
+      while (true) {
+        const uint64_t seq = slot.m_seq.load(std::memory_order_acquire);
+        if (seq & 1) {
+          continue;
+        }
+        const uint64_t slotPushNum = slot.m_pushNum;
+        const T value = slot.m_value;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.m_seq.load(std::memory_order_relaxed) != seq) {
+          continue;
+        }
+        // Not written yet by its claimer, or already reused by a newer push
+        if (slotPushNum == pushNum + 1) {
+          values.emplace_back(value);
+        }
+        break;
+      }
+    }
+  }
+};
+
+#endif  // __SEQLOCKRING_H__
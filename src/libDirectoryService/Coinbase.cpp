@@ -29,8 +29,8 @@ using namespace std;
 using namespace boost::multiprecision;
 
 template <class Container>
-bool DirectoryService::SaveCoinbaseCore(const vector<bool>& b1,
-                                        const vector<bool>& b2,
+bool DirectoryService::SaveCoinbaseCore(const BitVector& b1,
+                                        const BitVector& b2,
                                         const Container& shard,
                                         const int32_t& shard_id,
                                         const uint64_t& epochNum) {
@@ -43,8 +43,8 @@ bool DirectoryService::SaveCoinbaseCore(const vector<bool>& b1,
 
   LOG_MARKER();
 
-  auto it = m_coinbaseRewardees.find(epochNum);
-  if (it != m_coinbaseRewardees.end()) {
+  auto it = m_coinbaseRewardedShards.find(epochNum);
+  if (it != m_coinbaseRewardedShards.end()) {
     if (it->second.find(shard_id) != it->second.end()) {
       LOG_GENERAL(INFO, "Already have cosigs of shard " << shard_id);
       return false;
@@ -67,16 +67,16 @@ bool DirectoryService::SaveCoinbaseCore(const vector<bool>& b1,
       4096;  // This means the max priority is 12. A node need to continually
              // run for 5 days to achieve this reputation.
 
+  m_coinbaseRewardedShards[epochNum].emplace(shard_id);
+
   for (const auto& kv : shard) {
     const auto& pubKey = std::get<SHARD_NODE_PUBKEY>(kv);
-    if (b1.at(i)) {
-      m_coinbaseRewardees[epochNum][shard_id].push_back(pubKey);
-      if (m_mapNodeReputation[pubKey] < MAX_REPUTATION) {
-        ++m_mapNodeReputation[pubKey];
-      }
+    const uint32_t cosigs = (b1.at(i) ? 1 : 0) + (b2.at(i) ? 1 : 0);
+    if (cosigs > 0) {
+      m_coinbaseCosigCounts[pubKey] += cosigs;
+      m_coinbaseCosigTotal += cosigs;
     }
-    if (b2.at(i)) {
-      m_coinbaseRewardees[epochNum][shard_id].push_back(pubKey);
+    for (uint32_t j = 0; j < cosigs; ++j) {
       if (m_mapNodeReputation[pubKey] < MAX_REPUTATION) {
         ++m_mapNodeReputation[pubKey];
       }
@@ -98,8 +98,8 @@ bool DirectoryService::SaveCoinbaseCore(const vector<bool>& b1,
   return true;
 }
 
-bool DirectoryService::SaveCoinbase(const vector<bool>& b1,
-                                    const vector<bool>& b2,
+bool DirectoryService::SaveCoinbase(const BitVector& b1,
+                                    const BitVector& b2,
                                     const int32_t& shard_id,
                                     const uint64_t& epochNum) {
   if (LOOKUP_NODE_MODE) {
@@ -131,6 +131,14 @@ bool DirectoryService::SaveCoinbase(const vector<bool>& b1,
   }
 }
 
+void DirectoryService::ClearCoinbaseRewardees() {
+  lock_guard<mutex> g(m_mutexCoinbaseRewardees);
+  m_coinbaseRewardedShards.clear();
+  m_coinbaseCosigCounts.clear();
+  m_coinbaseCosigTotal = 0;
+  m_coinbaseLookupRewardees.clear();
+}
+
 void DirectoryService::InitCoinbase() {
   if (LOOKUP_NODE_MODE) {
     LOG_GENERAL(WARNING,
@@ -146,34 +154,25 @@ void DirectoryService::InitCoinbase() {
 
   lock_guard<mutex> g(m_mutexCoinbaseRewardees);
 
+  m_coinbaseRewardedShards[epochNum].emplace(CoinbaseReward::LOOKUP_REWARD);
   for (const auto& lookupNode : vecLookup) {
-    m_coinbaseRewardees[epochNum][CoinbaseReward::LOOKUP_REWARD].push_back(
-        lookupNode.first);
+    m_coinbaseLookupRewardees.push_back(lookupNode.first);
   }
 
-  if (m_coinbaseRewardees.size() < NUM_FINAL_BLOCK_PER_POW - 1) {
+  if (m_coinbaseRewardedShards.size() < NUM_FINAL_BLOCK_PER_POW - 1) {
     LOG_GENERAL(INFO, "[CNBSE]"
                           << "Less then expected epoch rewardees "
-                          << m_coinbaseRewardees.size());
-  } else if (m_coinbaseRewardees.size() > NUM_FINAL_BLOCK_PER_POW - 1) {
+                          << m_coinbaseRewardedShards.size());
+  } else if (m_coinbaseRewardedShards.size() > NUM_FINAL_BLOCK_PER_POW - 1) {
     LOG_GENERAL(INFO, "[CNBSE]"
                           << "More then expected epoch rewardees "
-                          << m_coinbaseRewardees.size());
+                          << m_coinbaseRewardedShards.size());
   }
 
   Address coinbaseAddress = Address();
 
-  uint128_t sig_count = 0;
-  uint32_t lookup_count = 0;
-  for (auto const& epochNum : m_coinbaseRewardees) {
-    for (auto const& shardId : epochNum.second) {
-      if (shardId.first == CoinbaseReward::LOOKUP_REWARD) {
-        lookup_count += shardId.second.size();
-      } else {
-        sig_count += shardId.second.size();
-      }
-    }
-  }
+  const uint128_t sig_count = m_coinbaseCosigTotal;
+  const uint32_t lookup_count = m_coinbaseLookupRewardees.size();
   LOG_GENERAL(INFO, "Total signatures count: " << sig_count << " lookup count "
                                                << lookup_count);
 
@@ -320,50 +319,46 @@ void DirectoryService::InitCoinbase() {
       INFO,
       "[CNBSE] Rewarding cosig rewards to lookup, DS, and shard nodes...");
 
-  for (const auto& epochNumShardRewardee : m_coinbaseRewardees) {
-    const auto& epochNum = epochNumShardRewardee.first;
-    const auto& shards = epochNumShardRewardee.second;
-    LOG_GENERAL(INFO, "[CNBSE] Rewarding epoch " << epochNum);
-    for (const auto& shardIdRewardee : shards) {
-      const auto& shardId = shardIdRewardee.first;
-      const auto& rewardees = shardIdRewardee.second;
-      LOG_GENERAL(INFO, "[CNBSE] Rewarding shard " << shardId);
-      if (shardId == CoinbaseReward::LOOKUP_REWARD) {
-        for (const auto& pk : rewardees) {
-          const auto& addr = Account::GetAddressFromPublicKey(pk);
-          if (!AccountStore::GetInstance().UpdateCoinbaseTemp(
-                  addr, coinbaseAddress, reward_each_lookup)) {
-            LOG_GENERAL(WARNING, "Could not reward " << addr << " - " << pk);
-          } else {
-            nonGuard.emplace_back(addr);
-            suc_lookup_counter++;
-          }
-        }
-      } else {
-        for (const auto& pk : rewardees) {
-          if (GUARD_MODE && pubKeyAndIsGuard[pk]) {
-            suc_counter++;
-          } else {
-            const auto& addr = Account::GetAddressFromPublicKey(pk);
-            if (!AccountStore::GetInstance().UpdateCoinbaseTemp(
-                    addr, coinbaseAddress, reward_each)) {
-              LOG_GENERAL(WARNING, "Could not reward " << addr << " - " << pk);
-            } else {
-              if (addr == myAddr) {
-                LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
-                          "[REWARD] Rewarded " << reward_each << " for blk "
-                                               << epochNum);
-                LOG_STATE("[REWARD]["
-                          << setw(15) << left
-                          << m_mediator.m_selfPeer.GetPrintableIPAddress()
-                          << "][" << m_mediator.m_currentEpochNum << "]["
-                          << reward_each << "] for blk " << epochNum);
-              }
-              suc_counter++;
-            }
-          }
-        }
+  for (const auto& pk : m_coinbaseLookupRewardees) {
+    const auto& addr = Account::GetAddressFromPublicKey(pk);
+    if (!AccountStore::GetInstance().UpdateCoinbaseTemp(addr, coinbaseAddress,
+                                                        reward_each_lookup)) {
+      LOG_GENERAL(WARNING, "Could not reward " << addr << " - " << pk);
+    } else {
+      nonGuard.emplace_back(addr);
+      suc_lookup_counter++;
+    }
+  }
+
+  for (const auto& pkCount : m_coinbaseCosigCounts) {
+    const auto& pk = pkCount.first;
+    const auto& count = pkCount.second;
+    if (GUARD_MODE && pubKeyAndIsGuard[pk]) {
+      suc_counter += count;
+      continue;
+    }
+
+    uint128_t reward = 0;
+    if (!SafeMath<uint128_t>::mul(reward_each, count, reward)) {
+      LOG_GENERAL(WARNING, "reward multiplication unsafe!");
+      continue;
+    }
+
+    const auto& addr = Account::GetAddressFromPublicKey(pk);
+    if (!AccountStore::GetInstance().UpdateCoinbaseTemp(addr, coinbaseAddress,
+                                                        reward)) {
+      LOG_GENERAL(WARNING, "Could not reward " << addr << " - " << pk);
+    } else {
+      if (addr == myAddr) {
+        LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
+                  "[REWARD] Rewarded " << reward << " for " << count
+                                       << " cosigs");
+        LOG_STATE("[REWARD][" << setw(15) << left
+                              << m_mediator.m_selfPeer.GetPrintableIPAddress()
+                              << "][" << m_mediator.m_currentEpochNum << "]["
+                              << reward << "] for " << count << " cosigs");
       }
+      suc_counter += count;
     }
   }
 
@@ -38,6 +38,7 @@
 #include "libUtils/HashUtils.h"
 #include "libUtils/Logger.h"
 #include "libUtils/SanityChecks.h"
+#include "libUtils/Tracing.h"
 
 using namespace std;
 using namespace boost::multiprecision;
@@ -352,8 +353,10 @@ void DirectoryService::StartFirstTxEpoch() {
   {
     std::lock_guard<mutex> lock(m_mutexMicroBlocks);
     m_microBlocks.clear();
+    m_microBlockTotals.clear();
     m_missingMicroBlocks.clear();
     m_microBlockStateDeltas.clear();
+    m_appliedStateDeltas.clear();
     m_totalTxnFees = 0;
   }
 
@@ -485,6 +488,7 @@ void DirectoryService::ProcessDSBlockConsensusWhenDone() {
   }
 
   LOG_EPOCH(INFO, m_mediator.m_currentEpochNum, "DSBlock consensus DONE");
+  TRACE_SPAN("DSBlock.Commit", m_mediator.m_currentEpochNum);
 
   lock_guard<mutex> g(m_mediator.m_node->m_mutexDSBlock);
 
@@ -541,6 +545,7 @@ void DirectoryService::ProcessDSBlockConsensusWhenDone() {
   } else if (m_mode == PRIMARY_DS) {
     ClearReputationOfNodeFailToJoin(m_shards, m_mapNodeReputation);
   }
+  PublishShardingStructure();
 
   m_mediator.m_node->m_myshardId = m_shards.size();
   BlockStorage::GetBlockStorage().PutShardStructure(
@@ -565,15 +570,15 @@ void DirectoryService::ProcessDSBlockConsensusWhenDone() {
 
     auto sendDSBlockToLookupNodesAndNewDSMembers =
         [this]([[gnu::unused]] const VectorOfNode& lookups,
-               const bytes& message) -> void {
-      SendDSBlockToLookupNodesAndNewDSMembers(message);
+               const SharedBytes& message) -> void {
+      SendDSBlockToLookupNodesAndNewDSMembers(*message);
     };
 
     auto sendDSBlockToShardNodes =
-        [this](const bytes& message, const DequeOfShard& shards,
+        [this](const SharedBytes& message, const DequeOfShard& shards,
                const unsigned int& my_shards_lo,
                const unsigned int& my_shards_hi) -> void {
-      SendDSBlockToShardNodes(message, shards, my_shards_lo, my_shards_hi);
+      SendDSBlockToShardNodes(*message, shards, my_shards_lo, my_shards_hi);
     };
 
     DataSender::GetInstance().SendDataToOthers(
@@ -593,6 +598,7 @@ void DirectoryService::ProcessDSBlockConsensusWhenDone() {
 
   ClearVCBlockVector();
   UpdateDSCommiteeComposition();
+  m_mediator.PublishEpochContext();
   UpdateMyDSModeAndConsensusId();
 
   if (m_mediator.m_DSCommittee->at(GetConsensusLeaderID()).first ==
@@ -630,6 +636,7 @@ bool DirectoryService::ProcessDSBlockConsensus(
   }
 
   LOG_MARKER();
+  TRACE_SPAN("DSBlock.Consensus", m_mediator.m_currentEpochNum);
   // Consensus messages must be processed in correct sequence as they come in
   // It is possible for ANNOUNCE to arrive before correct DS state
   // In that case, ANNOUNCE will sleep for a second below
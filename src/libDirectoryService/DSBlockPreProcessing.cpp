@@ -16,6 +16,7 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <thread>
 
@@ -35,10 +36,13 @@
 #include "libUtils/DataConversion.h"
 #include "libUtils/DetachedFunction.h"
 #include "libUtils/HashUtils.h"
+#include "libUtils/JoinableFunction.h"
 #include "libUtils/Logger.h"
+#include "libUtils/ParallelSort.h"
 #include "libUtils/SanityChecks.h"
 #include "libUtils/ShardSizeCalculator.h"
 #include "libUtils/TimestampVerifier.h"
+#include "libUtils/Tracing.h"
 
 using namespace std;
 using namespace boost::multiprecision;
@@ -154,9 +158,11 @@ void DirectoryService::ComputeSharding(const VectorOfPoWSoln& sortedPoWSolns) {
     m_shards.emplace_back();
   }
 
-  // Push all the sorted PoW submissions into an ordered map with key =
-  // H(last_block_hash, pow_hash)
-  map<array<unsigned char, BLOCK_HASH_SIZE>, PubKey> sortedPoWs;
+  // Order the sorted PoW submissions by H(last_block_hash, pow_hash). The
+  // nodes are referred to by their index in sortedPoWSolns, and of the ones
+  // with the same hash only the first is kept.
+  using SortHash = array<unsigned char, BLOCK_HASH_SIZE>;
+  vector<pair<SortHash, uint32_t>> sortedPoWs(sortedPoWSolns.size());
   bytes lastBlockHash(BLOCK_HASH_SIZE);
 
   if (m_mediator.m_currentEpochNum > 1) {
@@ -164,20 +170,38 @@ void DirectoryService::ComputeSharding(const VectorOfPoWSoln& sortedPoWSolns) {
         m_mediator.m_txBlockChain.GetLastBlock().GetBlockHash().asBytes();
   }
 
-  bytes hashVec(BLOCK_HASH_SIZE + POW_SIZE);
-  copy(lastBlockHash.begin(), lastBlockHash.end(), hashVec.begin());
-  for (const auto& kv : sortedPoWSolns) {
-    const PubKey& key = kv.second;
-    const auto& powHash = kv.first;
-    copy(powHash.begin(), powHash.end(), hashVec.begin() + BLOCK_HASH_SIZE);
-
-    const bytes& sortHashVec = HashUtils::BytesToHash(hashVec);
-    array<unsigned char, BLOCK_HASH_SIZE> sortHash;
-    copy(sortHashVec.begin(), sortHashVec.end(), sortHash.begin());
-    sortedPoWs.emplace(sortHash, key);
-  }
-
-  // Distribute the map-ordered nodes among the generated shards
+  const unsigned int numThreads = max(1U, thread::hardware_concurrency());
+  {
+    atomic<uint32_t> next{0};
+    auto worker = [&]() -> void {
+      bytes hashVec(BLOCK_HASH_SIZE + POW_SIZE);
+      copy(lastBlockHash.begin(), lastBlockHash.end(), hashVec.begin());
+      for (uint32_t i = next++; i < sortedPoWSolns.size(); i = next++) {
+        const auto& powHash = sortedPoWSolns[i].first;
+        copy(powHash.begin(), powHash.end(), hashVec.begin() + BLOCK_HASH_SIZE);
+
+        const bytes& sortHashVec = HashUtils::BytesToHash(hashVec);
+        copy(sortHashVec.begin(), sortHashVec.end(),
+             sortedPoWs[i].first.begin());
+        sortedPoWs[i].second = i;
+      }
+    };
+    JoinableFunction joinableFunc(
+        min<size_t>(numThreads, max<size_t>(1, sortedPoWSolns.size())),
+        worker);
+  }
+
+  ParallelSort(sortedPoWs.begin(), sortedPoWs.end(),
+               less<pair<SortHash, uint32_t>>(), numThreads);
+  sortedPoWs.erase(
+      unique(sortedPoWs.begin(), sortedPoWs.end(),
+             [](const pair<SortHash, uint32_t>& a,
+                const pair<SortHash, uint32_t>& b) {
+               return a.first == b.first;
+             }),
+      sortedPoWs.end());
+
+  // Distribute the hash-ordered nodes among the generated shards
   // First fill up first shard, then second shard, ..., then final shard
   uint32_t shard_index = 0;
   for (const auto& kv : sortedPoWs) {
@@ -195,11 +219,12 @@ void DirectoryService::ComputeSharding(const VectorOfPoWSoln& sortedPoWSolns) {
         LOG_GENERAL(WARNING, "[DSSORT] "
                                  << " unable to convert hash to string");
       } else {
-        LOG_GENERAL(INFO, "[DSSORT] " << kv.second << " " << hashStr << endl);
+        LOG_GENERAL(INFO, "[DSSORT] " << sortedPoWSolns[kv.second].second
+                                      << " " << hashStr << endl);
       }
     }
     // Put the node into the shard
-    const PubKey& key = kv.second;
+    const PubKey& key = sortedPoWSolns[kv.second].second;
     m_shards.at(shard_index)
         .emplace_back(key, m_allPoWConns.at(key), m_mapNodeReputation[key]);
     m_publicKeyToshardIdMap.emplace(key, shard_index);
@@ -623,10 +648,34 @@ bool DirectoryService::VerifyNodePriority(const DequeOfShard& shards,
 
 VectorOfPoWSoln DirectoryService::SortPoWSoln(const MapOfPubKeyPoW& mapOfPoWs,
                                               bool trimBeyondCommSize) {
-  std::map<array<unsigned char, 32>, PubKey> PoWOrderSorter;
+  // Order the solutions by result, referring to the nodes by their index in
+  // mapOfPoWs. Of the nodes with the same result only the last in key order
+  // is kept, so the index breaks ties from the greatest down.
+  using PoWResult = array<unsigned char, 32>;
+  vector<const MapOfPubKeyPoW::value_type*> nodes;
+  vector<pair<PoWResult, uint32_t>> PoWOrderSorter;
   for (const auto& powsoln : mapOfPoWs) {
-    PoWOrderSorter[powsoln.second.result] = powsoln.first;
-  }
+    PoWOrderSorter.emplace_back(powsoln.second.result, nodes.size());
+    nodes.emplace_back(&powsoln);
+  }
+  ParallelSort(PoWOrderSorter.begin(), PoWOrderSorter.end(),
+               [](const pair<PoWResult, uint32_t>& a,
+                  const pair<PoWResult, uint32_t>& b) {
+                 return a.first != b.first ? a.first < b.first
+                                           : a.second > b.second;
+               },
+               max(1U, thread::hardware_concurrency()));
+  PoWOrderSorter.erase(
+      unique(PoWOrderSorter.begin(), PoWOrderSorter.end(),
+             [](const pair<PoWResult, uint32_t>& a,
+                const pair<PoWResult, uint32_t>& b) {
+               return a.first == b.first;
+             }),
+      PoWOrderSorter.end());
+
+  auto toSoln = [&nodes](const pair<PoWResult, uint32_t>& kv) {
+    return make_pair(kv.first, nodes[kv.second]->first);
+  };
 
   // Put it back to vector for easy manipulation and adjustment of the ordering
   VectorOfPoWSoln sortedPoWSolns;
@@ -645,24 +694,17 @@ VectorOfPoWSoln DirectoryService::SortPoWSoln(const MapOfPubKeyPoW& mapOfPoWs,
       for (auto kv = PoWOrderSorter.begin();
            (kv != PoWOrderSorter.end()) && (count < numNodesAfterTrim);
            kv++, count++) {
-        sortedPoWSolns.emplace_back(*kv);
+        sortedPoWSolns.emplace_back(toSoln(*kv));
       }
     } else {
       // If total num of shard nodes to be trim, ensure shard guards do not get
-      // trimmed. To do it, a new map  will be created to included all shard
-      // guards and a subset of normal shard nods
+      // trimmed. To do it, the shard guards are selected first, then a subset
+      // of normal shard nodes.
       // Steps:
-      // 1. Maintain a map that called "FilteredPoWOrderSorter". It will
-      // eventually contains Shard guards + subset of normal nodes
-      // 2. Maintain a shadow copy of "PoWOrderSorter" called
-      // "ShadowPoWOrderSorter". It is to track non guards node.
-      // 3. Add shard guards to "FilteredPoWOrderSorter" ands remove it from
-      // "ShadowPoWOrderSorter"
-      // 4. If there are still slots left, obtained remaining normal shard node
-      // from "ShadowPoWOrderSorter". Use it to populate
-      // "FilteredPoWOrderSorter"
-      // 5. Finally, sort "FilteredPoWOrderSorter" and stored result in
-      // "PoWOrderSorter"
+      // 1. Mark shard guards as selected, in order, up to the guard count
+      // 2. If there are still slots left, mark the remaining unselected nodes
+      // as selected in order
+      // 3. Finally, output the selected nodes in sorted order
       uint32_t trimmedGuardCount = ceil(numNodesAfterTrim * SHARD_GUARD_TOL);
       uint32_t trimmedNonGuardCount = numNodesAfterTrim - trimmedGuardCount;
 
@@ -681,39 +723,38 @@ VectorOfPoWSoln DirectoryService::SortPoWSoln(const MapOfPubKeyPoW& mapOfPoWs,
                         << " to trimmedGuardCount to form a complete shard.");
       }
 
-      // Assign all shard guards first
-      std::map<array<unsigned char, 32>, PubKey> FilteredPoWOrderSorter;
-      std::map<array<unsigned char, 32>, PubKey> ShadowPoWOrderSorter =
-          PoWOrderSorter;
+      vector<bool> selected(PoWOrderSorter.size(), false);
 
-      // Add shard guards to "FilteredPoWOrderSorter"
-      // Remove it from "ShadowPoWOrderSorter"
-      for (auto kv = PoWOrderSorter.begin();
-           (kv != PoWOrderSorter.end()) && (count < numNodesAfterTrim); kv++) {
-        if (Guard::GetInstance().IsNodeInShardGuardList(kv->second)) {
+      // Assign all shard guards first
+      for (size_t i = 0;
+           (i < PoWOrderSorter.size()) && (count < numNodesAfterTrim); i++) {
+        const PubKey& key = nodes[PoWOrderSorter[i].second]->first;
+        if (Guard::GetInstance().IsNodeInShardGuardList(key)) {
           if (count == trimmedGuardCount) {
             LOG_GENERAL(INFO,
                         "Could not form max number of shard. Only allowed "
                             << trimmedGuardCount);
             break;
           }
-          FilteredPoWOrderSorter.emplace(*kv);
-          ShadowPoWOrderSorter.erase(kv->first);
+          selected[i] = true;
           count++;
         }
       }
 
       // Assign non shard guards if there is any slots
-      for (auto kv = ShadowPoWOrderSorter.begin();
-           (kv != ShadowPoWOrderSorter.end()) && (count < numNodesAfterTrim);
-           kv++) {
-        FilteredPoWOrderSorter.emplace(*kv);
-        count++;
+      for (size_t i = 0;
+           (i < PoWOrderSorter.size()) && (count < numNodesAfterTrim); i++) {
+        if (!selected[i]) {
+          selected[i] = true;
+          count++;
+        }
       }
 
-      // Sort "FilteredPoWOrderSorter" and stored it in "sortedPoWSolns"
-      for (auto kv : FilteredPoWOrderSorter) {
-        sortedPoWSolns.emplace_back(kv);
+      // Store the selected nodes in sorted order in "sortedPoWSolns"
+      for (size_t i = 0; i < PoWOrderSorter.size(); i++) {
+        if (selected[i]) {
+          sortedPoWSolns.emplace_back(toSoln(PoWOrderSorter[i]));
+        }
       }
       LOG_GENERAL(INFO, "Trimmed counts = " << trimmedGuardCount << " "
                                             << trimmedNonGuardCount);
@@ -724,7 +765,7 @@ VectorOfPoWSoln DirectoryService::SortPoWSoln(const MapOfPubKeyPoW& mapOfPoWs,
 
   } else {
     for (const auto& kv : PoWOrderSorter) {
-      sortedPoWSolns.emplace_back(kv);
+      sortedPoWSolns.emplace_back(toSoln(kv));
     }
   }
 
@@ -1216,6 +1257,7 @@ void DirectoryService::RunConsensusOnDSBlock(bool isRejoin) {
   }
 
   LOG_MARKER();
+  TRACE_SPAN("DSBlock.Prepare", m_mediator.m_currentEpochNum);
 
   LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
             "Number of PoW recvd: " << m_allPoWs.size() << ", DS PoW recvd: "
@@ -1232,10 +1274,7 @@ void DirectoryService::RunConsensusOnDSBlock(bool isRejoin) {
     SetState(DSBLOCK_CONSENSUS_PREP);
   }
 
-  {
-    lock_guard<mutex> h(m_mutexCoinbaseRewardees);
-    m_coinbaseRewardees.clear();
-  }
+  ClearCoinbaseRewardees();
 
   {
     lock_guard<mutex> g(m_mutexAllPOW);
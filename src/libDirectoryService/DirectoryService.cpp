@@ -37,9 +37,12 @@
 #include "libUtils/DetachedFunction.h"
 #include "libUtils/HashUtils.h"
 #include "libUtils/Logger.h"
+#include "libUtils/MemoryStats.h"
+#include "libUtils/Metrics.h"
 #include "libUtils/RootComputation.h"
 #include "libUtils/SanityChecks.h"
 #include "libUtils/TimestampVerifier.h"
+#include "libUtils/Tracing.h"
 
 using namespace std;
 using namespace boost::multiprecision;
@@ -54,6 +57,63 @@ DirectoryService::DirectoryService(Mediator& mediator) : m_mediator(mediator) {
   m_mediator.m_consensusID = 1;
   m_viewChangeCounter = 0;
   m_forceMulticast = false;
+
+  // Consensus messages of an earlier epoch would only be buffered, never used
+  const auto isCurrentConsensus = [this](const bytes& message,
+                                         unsigned int offset) {
+    return ConsensusCommon::IsForBlockOrLater(message, offset,
+                                              m_mediator.m_currentEpochNum);
+  };
+  RegisterPreFilter(DSInstructionType::DSBLOCKCONSENSUS, isCurrentConsensus);
+  RegisterPreFilter(DSInstructionType::FINALBLOCKCONSENSUS, isCurrentConsensus);
+  RegisterPreFilter(DSInstructionType::VIEWCHANGECONSENSUS,
+                    isCurrentConsensus);
+
+  MemoryStats::GetInstance().Register("ds.mbsubmissionbuffer", [this]() {
+    lock_guard<mutex> g(m_mutexMBSubmissionBuffer);
+    MemoryStats::Usage usage;
+    usage.m_entries = m_MBSubmissionBuffer.Size();
+    usage.m_bytes = m_MBSubmissionBuffer.Bytes();
+    return usage;
+  });
+  MemoryStats::GetInstance().Register(
+      "ds.finalblockconsensusbuffer", [this]() {
+        lock_guard<mutex> g(m_mutexFinalBlockConsensusBuffer);
+        MemoryStats::Usage usage;
+        for (const auto& consensus : m_finalBlockConsensusBuffer) {
+          for (const auto& message : consensus.second) {
+            usage.m_entries++;
+            usage.m_bytes += sizeof(message) + get<NODE_MSG>(message).size();
+          }
+        }
+        return usage;
+      });
+
+  if (!LOOKUP_NODE_MODE) {
+    const auto setGasPriceGauge =
+        [this](const string& stat,
+               const function<uint128_t(const GasPriceStats::Summary&)>& get) {
+          Metrics::GetInstance().SetGaugeFunction(
+              "zilliqa_gas_price", "Gas prices read by the gas pricer",
+              [this, get]() {
+                return get(m_gasPriceStats.GetSummary()).convert_to<double>();
+              },
+              "stat=\"" + stat + "\"");
+        };
+    setGasPriceGauge("proposal_min", [](const GasPriceStats::Summary& s) {
+      return s.m_minProposal;
+    });
+    setGasPriceGauge("proposal_max", [](const GasPriceStats::Summary& s) {
+      return s.m_maxProposal;
+    });
+    setGasPriceGauge("ds_block_mean", [](const GasPriceStats::Summary& s) {
+      return s.m_windowMean;
+    });
+    Metrics::GetInstance().SetGaugeFunction(
+        "zilliqa_gas_price_proposals",
+        "Gas prices proposed in the DS PoW submissions of the epoch",
+        [this]() { return m_gasPriceStats.GetSummary().m_numProposals; });
+  }
 }
 
 DirectoryService::~DirectoryService() {}
@@ -70,30 +130,29 @@ void DirectoryService::StartSynchronization() {
 
   this->CleanVariables();
 
-  if (!m_mediator.m_node->GetOfflineLookups()) {
-    LOG_GENERAL(WARNING, "Cannot sync currently");
-    return;
-  }
-
-  auto func = [this]() -> void {
-    while (m_mediator.m_lookup->GetSyncType() != SyncType::NO_SYNC) {
-      m_mediator.m_lookup->ComposeAndSendGetDirectoryBlocksFromSeed(
-          m_mediator.m_blocklinkchain.GetLatestIndex() + 1);
-      m_synchronizer.FetchLatestTxBlocks(
-          m_mediator.m_lookup,
-          m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum() +
-              1);
-      this_thread::sleep_for(chrono::seconds(NEW_NODE_SYNC_INTERVAL));
+  m_mediator.m_node->GetOfflineLookupsAsync([this](bool fetched) {
+    if (!fetched) {
+      LOG_GENERAL(WARNING, "Cannot sync currently");
+      return;
     }
-  };
 
-  auto func2 = [this]() -> void {
+    m_mediator.m_lookup->RunWhileSyncing(
+        [this]() {
+          TRACE_SPAN("Sync", m_mediator.m_currentEpochNum);
+          m_mediator.m_lookup->ComposeAndSendGetDirectoryBlocksFromSeed(
+              m_mediator.m_blocklinkchain.GetLatestIndex() + 1);
+          m_synchronizer.FetchLatestTxBlocks(
+              m_mediator.m_lookup, m_mediator.m_txBlockChain.GetLastBlock()
+                                           .GetHeader()
+                                           .GetBlockNum() +
+                                       1);
+        },
+        []() { return NEW_NODE_SYNC_INTERVAL; });
+
     if (!m_mediator.m_lookup->GetDSInfoLoop()) {
       LOG_GENERAL(WARNING, "Unable to fetch DS info");
     }
-  };
-  DetachedFunction(1, func);
-  DetachedFunction(1, func2);
+  });
 }
 
 bool DirectoryService::CheckState(Action action) {
@@ -396,6 +455,24 @@ uint16_t DirectoryService::GetConsensusLeaderID() const {
   return m_consensusLeaderID.load();
 }
 
+void DirectoryService::PublishShardingStructure() {
+  std::atomic_store(&m_shardingStructure,
+                    ShardingStructurePtr(make_shared<ShardingStructure>(
+                        DequeOfShard(m_shards))));
+  m_mediator.PublishEpochContext();
+}
+
+ShardingStructurePtr DirectoryService::GetShardingStructure() const {
+  ShardingStructurePtr shardingStructure =
+      std::atomic_load(&m_shardingStructure);
+  if (!shardingStructure) {
+    static const ShardingStructurePtr empty =
+        make_shared<ShardingStructure>(DequeOfShard());
+    return empty;
+  }
+  return shardingStructure;
+}
+
 bool DirectoryService::CleanVariables() {
   if (LOOKUP_NODE_MODE) {
     LOG_GENERAL(WARNING,
@@ -407,6 +484,7 @@ bool DirectoryService::CleanVariables() {
   LOG_MARKER();
 
   m_shards.clear();
+  PublishShardingStructure();
   m_publicKeyToshardIdMap.clear();
   m_allPoWConns.clear();
   m_mapNodeReputation.clear();
@@ -441,7 +519,9 @@ bool DirectoryService::CleanVariables() {
   {
     std::lock_guard<mutex> lock(m_mutexMicroBlocks);
     m_microBlocks.clear();
+    m_microBlockTotals.clear();
     m_microBlockStateDeltas.clear();
+    m_appliedStateDeltas.clear();
     m_missingMicroBlocks.clear();
     m_totalTxnFees = 0;
   }
@@ -1112,26 +1192,11 @@ void DirectoryService::GetEntireNetworkPeerInfo(VectorOfNode& peers,
 
 bool DirectoryService::CheckIfDSNode(const PubKey& submitterPubKey) {
   lock_guard<mutex> g(m_mediator.m_mutexDSCommittee);
-
-  for (const auto& dsMember : *m_mediator.m_DSCommittee) {
-    if (dsMember.first == submitterPubKey) {
-      return true;
-    }
-  }
-
-  return false;
+  return m_DSCommitteeIndex.Contains(*m_mediator.m_DSCommittee,
+                                     submitterPubKey);
 }
 
 bool DirectoryService::CheckIfShardNode(const PubKey& submitterPubKey) {
   lock_guard<mutex> g(m_mutexShards);
-
-  for (const auto& shard : m_shards) {
-    for (const auto& node : shard) {
-      if (std::get<SHARD_NODE_PUBKEY>(node) == submitterPubKey) {
-        return true;
-      }
-    }
-  }
-
-  return false;
+  return m_shardsIndex.Contains(m_shards, submitterPubKey);
 }
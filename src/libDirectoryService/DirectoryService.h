@@ -29,19 +29,26 @@
 #include <map>
 #include <set>
 #include <shared_mutex>
+#include <unordered_set>
 #include <vector>
 
+#include "common/Constants.h"
 #include "common/Executable.h"
 #include "libConsensus/Consensus.h"
 #include "libCrypto/Schnorr.h"
 #include "libData/BlockData/Block.h"
 #include "libData/BlockData/BlockHeader/BlockHashSet.h"
 #include "libData/MiningData/DSPowSolution.h"
+#include "libDirectoryService/GasPriceStats.h"
 #include "libLookup/Synchronizer.h"
 #include "libNetwork/DataSender.h"
+#include "libNetwork/NodeIndex.h"
 #include "libNetwork/P2PComm.h"
 #include "libNetwork/ShardStruct.h"
+#include "libNetwork/ShardingStructure.h"
 #include "libPersistence/BlockStorage.h"
+#include "libUtils/BitVector.h"
+#include "libUtils/BoundedBuffer.h"
 #include "libUtils/TimeUtils.h"
 
 class Mediator;
@@ -139,6 +146,9 @@ class DirectoryService : public Executable {
   std::mutex m_mutexAllDSPOWs;
   MapOfPubKeyPoW m_allDSPoWs;  // map<pubkey, DS PoW Sol
 
+  /// Follows the gas prices of m_allDSPoWs and of the last DS blocks
+  GasPriceStats m_gasPriceStats;
+
   // Consensus variables
   std::shared_ptr<ConsensusCommon> m_consensusObject;
   bytes m_consensusBlockHash;
@@ -157,10 +167,15 @@ class DirectoryService : public Executable {
     MBSubmissionBufferEntry(const MicroBlock& microBlock,
                             const bytes& stateDelta)
         : m_microBlock(microBlock), m_stateDelta(stateDelta) {}
+    // Approximate memory held, counted against the buffer budget
+    uint64_t GetBytes() const {
+      return sizeof(*this) + m_stateDelta.size() +
+             m_microBlock.GetTranHashes().size() * sizeof(TxnHash);
+    }
   };
   std::mutex m_mutexMBSubmissionBuffer;
-  std::unordered_map<uint64_t, std::vector<MBSubmissionBufferEntry>>
-      m_MBSubmissionBuffer;
+  BoundedBuffer<MBSubmissionBufferEntry> m_MBSubmissionBuffer{
+      uint64_t{MB_SUBMISSION_BUFFER_MB} * 1024 * 1024};
 
   std::mutex m_mutexFinalBlockConsensusBuffer;
   std::unordered_map<uint32_t, VectorOfNodeMsg> m_finalBlockConsensusBuffer;
@@ -206,9 +221,15 @@ class DirectoryService : public Executable {
   Mediator& m_mediator;
 
   // Coinbase
-  // Map<EpochNumber, Map<shard-id, vector <Public keys to be rewarded>>
-  std::map<uint64_t, std::map<int32_t, std::vector<PubKey>>>
-      m_coinbaseRewardees;
+  // Reward counters of the DS epoch, kept up to date as each block commits so
+  // that InitCoinbase need not walk the cosigs of every block
+  // Map<EpochNumber, Set<shard-id whose cosigs have been counted>>
+  std::map<uint64_t, std::set<int32_t>> m_coinbaseRewardedShards;
+  // Map<Public key, number of cosigs to be rewarded>
+  std::map<PubKey, uint32_t> m_coinbaseCosigCounts;
+  boost::multiprecision::uint128_t m_coinbaseCosigTotal = 0;
+  // Lookup nodes to be rewarded, once for each time they are listed
+  std::vector<PubKey> m_coinbaseLookupRewardees;
   std::mutex m_mutexCoinbaseRewardees;
 
   // pow solutions
@@ -226,6 +247,19 @@ class DirectoryService : public Executable {
                                   const Peer& from);
   bool VerifyPoWSubmission(const DSPowSolution& sol);
 
+  // Stages of VerifyPoWSubmission, so that packets can verify many
+  // submissions in parallel and only record the accepted ones serially
+  void WaitForPoWSubmissionState();
+  /// Runs the cheap checks of a submission. Returns false if it is rejected,
+  /// and true with verify set to false if it is ignored without verifying.
+  bool CheckPoWSubmission(const DSPowSolution& sol, bool& verify);
+  /// Verifies the PoW itself. Safe to call from several threads at once.
+  bool CheckPoWSubmissionHash(const DSPowSolution& sol);
+  void AcceptPoWSubmission(const DSPowSolution& sol);
+  /// Verifies the submissions of a packet in parallel batches, after
+  /// dropping the repeated (submitter, nonce) pairs
+  void VerifyPoWSubmissions(const std::vector<DSPowSolution>& sols);
+
   bool ProcessDSBlockConsensus(const bytes& message, unsigned int offset,
                                const Peer& from);
   bool ProcessMicroblockSubmission(const bytes& message, unsigned int offset,
@@ -321,6 +355,9 @@ class DirectoryService : public Executable {
   bool RunConsensusOnFinalBlockWhenDSBackup();
   bool ComposeFinalBlock();
   bool CheckWhetherDSBlockIsFresh(const uint64_t dsblock_num);
+  void BufferMBSubmission(const uint64_t epochNumber,
+                          const MicroBlock& microBlock,
+                          const bytes& stateDelta);
   void CommitMBSubmissionMsgBuffer();
   bool ProcessMicroblockSubmissionFromShard(
       const uint64_t epochNumber, const std::vector<MicroBlock>& microBlocks,
@@ -334,16 +371,39 @@ class DirectoryService : public Executable {
                                   uint64_t& allGasLimit, uint64_t& allGasUsed,
                                   boost::multiprecision::uint128_t& allRewards,
                                   uint32_t& numTxs);
+  /// Adds a microblock to m_microBlocks and to the totals of its epoch
+  bool AddMicroBlock(const uint64_t epochNum, const MicroBlock& microBlock);
+  void RemoveMicroBlock(const uint64_t epochNum,
+                        std::set<MicroBlock>::const_iterator microBlock);
+  /// Returns false if the totals have to be added up from the microblocks
+  bool GetMicroBlockTotals(const uint64_t epochNum, uint64_t& allGasLimit,
+                           uint64_t& allGasUsed,
+                           boost::multiprecision::uint128_t& allRewards,
+                           uint32_t& numTxs);
+  /// Leaves the totals unchanged and returns false if adding would overflow
+  static bool AddToMicroBlockTotals(
+      const MicroBlockHeader& header, uint64_t& allGasLimit,
+      uint64_t& allGasUsed, boost::multiprecision::uint128_t& allRewards);
   bool VerifyMicroBlockCoSignature(const MicroBlock& microBlock,
                                    uint32_t shardId);
-  bool ProcessStateDelta(const bytes& stateDelta,
-                         const StateHash& microBlockStateDeltaHash,
-                         const BlockHash& microBlockHash);
+  /// Checks a shard's state delta against its microblock and decodes the
+  /// contracts it changes, without touching any shared state. Returns true
+  /// with apply set to false if there is nothing to apply.
+  bool CheckStateDelta(const bytes& stateDelta,
+                       const StateHash& microBlockStateDeltaHash, bool& apply,
+                       std::unordered_set<Address>& contracts);
+  /// Merges a checked state delta into m_stateDeltaFromShards. Caller must
+  /// hold m_mutexMicroBlocks.
+  bool ApplyStateDelta(const bytes& stateDelta, uint32_t shardId,
+                       std::unordered_set<Address>&& contracts,
+                       const BlockHash& microBlockHash);
+  bool ReapplyStateDeltas();
   void SkipDSMicroBlock();
   void PrepareRunConsensusOnFinalBlockNormal();
 
   // FinalBlockValidator functions
   bool CheckBlockHash();
+  bool CheckFinalBlockCommitteeHash();
   bool CheckFinalBlockValidity(bytes& errorMsg);
   bool CheckMicroBlockValidity(bytes& errorMsg);
   bool CheckFinalBlockVersion();
@@ -354,6 +414,7 @@ class DirectoryService : public Executable {
                         bool generateErrorMsg);
   bool CheckLegitimacyOfMicroBlocks();
   bool CheckMicroBlockInfo();
+  bool CheckMbInfoHash();
   bool CheckStateRoot();
   bool CheckStateDeltaHash();
   void LoadUnavailableMicroBlocks();
@@ -471,7 +532,13 @@ class DirectoryService : public Executable {
   // Sharding committee members
   std::mutex m_mutexShards;
   DequeOfShard m_shards;
+  /// Read and written with std::atomic_load and std::atomic_store
+  ShardingStructurePtr m_shardingStructure;
   std::map<PubKey, uint32_t> m_publicKeyToshardIdMap;
+  // Index of m_shards, guarded by m_mutexShards
+  NodeIndex m_shardsIndex;
+  // Index of the DS committee, guarded by m_mediator.m_mutexDSCommittee
+  NodeIndex m_DSCommitteeIndex;
 
   // Proof of Reputation(PoR) variables.
   std::map<PubKey, uint16_t> m_mapNodeReputation;
@@ -492,6 +559,16 @@ class DirectoryService : public Executable {
   /// failed
   bytes m_stateDeltaFromShards;
 
+  /// The shard state deltas merged into m_stateDeltaFromShards, by shard id,
+  /// with the contracts each changes. Deltas that change the same contract
+  /// do not commute, so they are merged in shard id order whatever order
+  /// they arrive in. Guarded by m_mutexMicroBlocks.
+  struct AppliedStateDelta {
+    bytes m_stateDelta;
+    std::unordered_set<Address> m_contracts;
+  };
+  std::map<uint32_t, AppliedStateDelta> m_appliedStateDeltas;
+
   /// Whether ds started microblock consensus
   std::atomic<bool> m_stopRecvNewMBSubmission;
 
@@ -504,6 +581,18 @@ class DirectoryService : public Executable {
   std::unordered_map<uint64_t, std::vector<BlockHash>> m_missingMicroBlocks;
   std::unordered_map<uint64_t, std::unordered_map<BlockHash, bytes>>
       m_microBlockStateDeltas;
+  /// Totals of the microblocks of each epoch, added up as they come in so
+  /// that the final block is composed and checked without walking them
+  struct MicroBlockTotals {
+    uint64_t m_gasLimit = 0;
+    uint64_t m_gasUsed = 0;
+    boost::multiprecision::uint128_t m_rewards = 0;
+    uint32_t m_numTxs = 0;
+    /// Which microblocks an overflow leaves out depends on their order, so
+    /// after one the totals are added up again in the order of m_microBlocks
+    bool m_overflowed = false;
+  };
+  std::unordered_map<uint64_t, MicroBlockTotals> m_microBlockTotals;
   boost::multiprecision::uint128_t m_totalTxnFees;
 
   Synchronizer m_synchronizer;
@@ -515,6 +604,13 @@ class DirectoryService : public Executable {
 
   std::mutex m_MutexCVViewChangePrecheck;
   std::condition_variable cv_viewChangePrecheck;
+  /// Whether the seed answered the precheck, guarded by
+  /// m_MutexCVViewChangePrecheck
+  bool m_vcPreCheckReceived = false;
+
+  /// When the current view change started, from which the candidate leader
+  /// waits VIEWCHANGE_EXTRA_TIME before announcing
+  std::chrono::system_clock::time_point m_viewChangeStartTime;
 
   // Guard mode recovery. currently used only by lookup node.
   std::mutex m_mutexLookupStoreForGuardNodeUpdate;
@@ -570,19 +666,27 @@ class DirectoryService : public Executable {
   void RunConsensusOnFinalBlock();
 
   // Coinbase
-  bool SaveCoinbase(const std::vector<bool>& b1, const std::vector<bool>& b2,
+  bool SaveCoinbase(const BitVector& b1, const BitVector& b2,
                     const int32_t& shard_id, const uint64_t& epochNum);
   void InitCoinbase();
+  void ClearCoinbaseRewardees();
   void StoreCoinbaseInDiagnosticDB(const DiagnosticDataCoinbase& entry);
 
   template <class Container>
-  bool SaveCoinbaseCore(const std::vector<bool>& b1,
-                        const std::vector<bool>& b2, const Container& shard,
+  bool SaveCoinbaseCore(const BitVector& b1,
+                        const BitVector& b2, const Container& shard,
                         const int32_t& shard_id, const uint64_t& epochNum);
 
   /// Implements the Execute function inherited from Executable.
   bool Execute(const bytes& message, unsigned int offset, const Peer& from);
 
+  /// Shares a copy of m_shards with the readers of GetShardingStructure, once
+  /// m_shards is final for the DS epoch. Called by the thread writing it.
+  void PublishShardingStructure();
+
+  /// Returns the last published sharding structure, which never changes
+  ShardingStructurePtr GetShardingStructure() const;
+
   /// Used by PoW winner to configure sharding variables as the next DS leader
   bool ProcessShardingStructure(
       const DequeOfShard& shards,
@@ -35,6 +35,8 @@
 #include "libUtils/DetachedFunction.h"
 #include "libUtils/Logger.h"
 #include "libUtils/SanityChecks.h"
+#include "libUtils/Scheduler.h"
+#include "libUtils/Tracing.h"
 
 using namespace std;
 using namespace boost::multiprecision;
@@ -62,16 +64,26 @@ void DirectoryService::StoreFinalBlockToDisk() {
             "Storing Tx Block" << endl
                                << *m_finalBlock);
 
+  EpochWrites writes;
+
   bytes serializedTxBlock;
   m_finalBlock->Serialize(serializedTxBlock, 0);
-  BlockStorage::GetBlockStorage().PutTxBlock(
-      m_finalBlock->GetHeader().GetBlockNum(), serializedTxBlock);
+  writes.AddTxBlock(m_finalBlock->GetHeader().GetBlockNum(),
+                    serializedTxBlock);
 
   bytes stateDelta;
   AccountStore::GetInstance().GetSerializedDelta(stateDelta);
-  BlockStorage::GetBlockStorage().PutStateDelta(
+  writes.AddStateDelta(
       m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum(),
       stateDelta);
+
+  if (!BlockStorage::GetBlockStorage().PutEpochWrites(writes)) {
+    LOG_GENERAL(WARNING, "Failed to store final block "
+                             << m_finalBlock->GetHeader().GetBlockNum());
+    return;
+  }
+  BlockStorage::GetBlockStorage().CommitEpoch(
+      m_finalBlock->GetHeader().GetBlockNum());
 }
 
 bool DirectoryService::ComposeFinalBlockMessageForSender(
@@ -113,6 +125,7 @@ void DirectoryService::ProcessFinalBlockConsensusWhenDone() {
   }
 
   LOG_EPOCH(INFO, m_mediator.m_currentEpochNum, "Final block consensus DONE");
+  TRACE_SPAN("FinalBlock.Commit", m_mediator.m_currentEpochNum);
 
   // Clear microblock(s)
   // m_microBlocks.clear();
@@ -144,12 +157,9 @@ void DirectoryService::ProcessFinalBlockConsensusWhenDone() {
 
   // StoreMicroBlocksToDisk();
 
-  auto resumeBlackList = []() mutable -> void {
-    this_thread::sleep_for(chrono::seconds(RESUME_BLACKLIST_DELAY_IN_SECONDS));
-    Blacklist::GetInstance().Enable(true);
-  };
-
-  DetachedFunction(1, resumeBlackList);
+  Scheduler::GetInstance().ScheduleAfter(
+      []() -> void { Blacklist::GetInstance().Enable(true); },
+      RESUME_BLACKLIST_DELAY_IN_SECONDS * 1000);
 
   if (isVacuousEpoch) {
     if (!AccountStore::GetInstance().MoveUpdatesToDisk(
@@ -223,6 +233,10 @@ void DirectoryService::ProcessFinalBlockConsensusWhenDone() {
   AccountStore::GetInstance().InitTemp();
   AccountStore::GetInstance().InitRevertibles();
   m_stateDeltaFromShards.clear();
+  {
+    lock_guard<mutex> g(m_mutexMicroBlocks);
+    m_appliedStateDeltas.clear();
+  }
   m_allPoWConns.clear();
   ClearDSPoWSolns();
   ResetPoWSubmissionCounter();
@@ -292,6 +306,7 @@ bool DirectoryService::ProcessFinalBlockConsensus(const bytes& message,
                                                   unsigned int offset,
                                                   const Peer& from) {
   LOG_MARKER();
+  TRACE_SPAN("FinalBlock.Consensus", m_mediator.m_currentEpochNum);
 
   if (LOOKUP_NODE_MODE) {
     LOG_GENERAL(WARNING,
@@ -36,10 +36,81 @@
 #include "libUtils/RootComputation.h"
 #include "libUtils/SanityChecks.h"
 #include "libUtils/TimestampVerifier.h"
+#include "libUtils/Tracing.h"
 
 using namespace std;
 using namespace boost::multiprecision;
 
+bool DirectoryService::AddToMicroBlockTotals(const MicroBlockHeader& header,
+                                             uint64_t& allGasLimit,
+                                             uint64_t& allGasUsed,
+                                             uint128_t& allRewards) {
+  uint64_t gasLimit = 0, gasUsed = 0;
+  uint128_t rewards = 0;
+
+  if (!SafeMath<uint64_t>::add(allGasLimit, header.GetGasLimit(), gasLimit) ||
+      !SafeMath<uint64_t>::add(allGasUsed, header.GetGasUsed(), gasUsed) ||
+      !SafeMath<uint128_t>::add(allRewards, header.GetRewards(), rewards)) {
+    return false;
+  }
+
+  allGasLimit = gasLimit;
+  allGasUsed = gasUsed;
+  allRewards = rewards;
+  return true;
+}
+
+bool DirectoryService::AddMicroBlock(const uint64_t epochNum,
+                                     const MicroBlock& microBlock) {
+  if (!m_microBlocks[epochNum].emplace(microBlock).second) {
+    return false;
+  }
+
+  auto& totals = m_microBlockTotals[epochNum];
+  if (!totals.m_overflowed &&
+      !AddToMicroBlockTotals(microBlock.GetHeader(), totals.m_gasLimit,
+                             totals.m_gasUsed, totals.m_rewards)) {
+    LOG_GENERAL(WARNING, "Microblock totals overflowed for epoch " << epochNum);
+    totals.m_overflowed = true;
+  }
+  totals.m_numTxs += microBlock.GetHeader().GetNumTxs();
+
+  return true;
+}
+
+void DirectoryService::RemoveMicroBlock(
+    const uint64_t epochNum, set<MicroBlock>::const_iterator microBlock) {
+  // Without an overflow every microblock was added in full, so it can be
+  // taken out again
+  auto& totals = m_microBlockTotals[epochNum];
+  if (!totals.m_overflowed) {
+    const auto& header = microBlock->GetHeader();
+    totals.m_gasLimit -= header.GetGasLimit();
+    totals.m_gasUsed -= header.GetGasUsed();
+    totals.m_rewards -= header.GetRewards();
+  }
+  totals.m_numTxs -= microBlock->GetHeader().GetNumTxs();
+
+  m_microBlocks[epochNum].erase(microBlock);
+}
+
+bool DirectoryService::GetMicroBlockTotals(const uint64_t epochNum,
+                                           uint64_t& allGasLimit,
+                                           uint64_t& allGasUsed,
+                                           uint128_t& allRewards,
+                                           uint32_t& numTxs) {
+  const auto& totals = m_microBlockTotals[epochNum];
+  if (totals.m_overflowed) {
+    return false;
+  }
+
+  allGasLimit = totals.m_gasLimit;
+  allGasUsed = totals.m_gasUsed;
+  allRewards = totals.m_rewards;
+  numTxs = totals.m_numTxs;
+  return true;
+}
+
 void DirectoryService::ExtractDataFromMicroblocks(
     vector<MicroBlockInfo>& mbInfos, uint64_t& allGasLimit,
     uint64_t& allGasUsed, uint128_t& allRewards, uint32_t& numTxs) {
@@ -61,6 +132,10 @@ void DirectoryService::ExtractDataFromMicroblocks(
 
     auto& microBlocks = m_microBlocks[m_mediator.m_currentEpochNum];
 
+    const bool haveTotals =
+        GetMicroBlockTotals(m_mediator.m_currentEpochNum, allGasLimit,
+                            allGasUsed, allRewards, numTxs);
+
     for (auto& microBlock : microBlocks) {
       LOG_STATE("[STATS][" << std::setw(15) << std::left
                            << m_mediator.m_selfPeer.GetPrintableIPAddress()
@@ -74,32 +149,12 @@ void DirectoryService::ExtractDataFromMicroblocks(
                             << microBlock.GetHeader().GetShardId() << endl
                             << "hash: " << microBlock.GetHeader().GetHashes());
 
-      uint64_t tmpGasLimit = allGasLimit, tmpGasUsed = allGasUsed;
-      uint128_t tmpRewards = allRewards;
-
-      bool flag = true;
-      if (!SafeMath<uint64_t>::add(
-              allGasLimit, microBlock.GetHeader().GetGasLimit(), allGasLimit)) {
-        flag = false;
-      }
-      if (flag &&
-          !SafeMath<uint64_t>::add(
-              allGasUsed, microBlock.GetHeader().GetGasUsed(), allGasUsed)) {
-        flag = false;
-      }
-      if (flag &&
-          !SafeMath<uint128_t>::add(
-              allRewards, microBlock.GetHeader().GetRewards(), allRewards)) {
-        flag = false;
-      }
-      if (!flag) {
-        allGasLimit = tmpGasLimit;
-        allGasUsed = tmpGasUsed;
-        allRewards = tmpRewards;
+      if (!haveTotals) {
+        AddToMicroBlockTotals(microBlock.GetHeader(), allGasLimit, allGasUsed,
+                              allRewards);
+        numTxs += microBlock.GetHeader().GetNumTxs();
       }
 
-      numTxs += microBlock.GetHeader().GetNumTxs();
-
       mbInfos.push_back({microBlock.GetBlockHash(),
                          microBlock.GetHeader().GetTxRootHash(),
                          microBlock.GetHeader().GetShardId()});
@@ -232,8 +287,8 @@ bool DirectoryService::RunConsensusOnFinalBlockWhenDSPrimary() {
     LOG_GENERAL(WARNING, "DS ComposeMicroBlock Failed");
     m_mediator.m_node->m_microblock = nullptr;
   } else {
-    m_microBlocks[m_mediator.m_currentEpochNum].emplace(
-        *(m_mediator.m_node->m_microblock));
+    AddMicroBlock(m_mediator.m_currentEpochNum,
+                  *(m_mediator.m_node->m_microblock));
   }
 
   // stores it in m_finalBlock
@@ -497,34 +552,15 @@ bool DirectoryService::CheckLegitimacyOfMicroBlocks() {
     lock_guard<mutex> g(m_mutexMicroBlocks);
 
     auto& microBlocks = m_microBlocks[m_mediator.m_currentEpochNum];
-    for (auto& microBlock : microBlocks) {
-      uint64_t tmpGasLimit = allGasLimit, tmpGasUsed = allGasUsed;
-      uint128_t tmpRewards = allRewards;
-
-      bool flag = true;
-      if (!SafeMath<uint64_t>::add(
-              allGasLimit, microBlock.GetHeader().GetGasLimit(), allGasLimit)) {
-        flag = false;
-      }
-      if (flag &&
-          !SafeMath<uint64_t>::add(
-              allGasUsed, microBlock.GetHeader().GetGasUsed(), allGasUsed)) {
-        flag = false;
-      }
-      if (flag &&
-          !SafeMath<uint128_t>::add(
-              allRewards, microBlock.GetHeader().GetRewards(), allRewards)) {
-        flag = false;
-      }
-      if (!flag) {
-        allGasLimit = tmpGasLimit;
-        allGasUsed = tmpGasUsed;
-        allRewards = tmpRewards;
+    if (!GetMicroBlockTotals(m_mediator.m_currentEpochNum, allGasLimit,
+                             allGasUsed, allRewards, allNumTxns)) {
+      for (auto& microBlock : microBlocks) {
+        AddToMicroBlockTotals(microBlock.GetHeader(), allGasLimit, allGasUsed,
+                              allRewards);
+        allNumTxns += microBlock.GetHeader().GetNumTxs();
       }
-
-      allNumTxns += microBlock.GetHeader().GetNumTxs();
-      ++allNumMicroBlockHashes;
     }
+    allNumMicroBlockHashes = microBlocks.size();
   }
 
   bool ret = true;
@@ -779,15 +815,27 @@ bool DirectoryService::CheckMicroBlockInfo() {
     }
   }
 
+  return true;
+}
+
+// Sets no error code, so that it can run alongside the other checks
+bool DirectoryService::CheckMbInfoHash() {
   // Compute the MBInfoHash of the MicroBlock information
   MBInfoHash mbInfoHash;
-  if (!Messenger::GetMbInfoHash(microBlockInfos, mbInfoHash)) {
+  if (!Messenger::GetMbInfoHash(m_finalBlock->GetMicroBlockInfos(),
+                                mbInfoHash)) {
     LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
               "Messenger::GetMbInfoHash failed");
     return false;
   }
 
-  return mbInfoHash == m_finalBlock->GetHeader().GetMbInfoHash();
+  if (mbInfoHash != m_finalBlock->GetHeader().GetMbInfoHash()) {
+    LOG_CHECK_FAIL("MB info hash", m_finalBlock->GetHeader().GetMbInfoHash(),
+                   mbInfoHash);
+    return false;
+  }
+
+  return true;
 }
 
 // Check state root
@@ -861,6 +909,11 @@ bool DirectoryService::CheckBlockHash() {
     return false;
   }
 
+  return true;
+}
+
+// Sets no error code, so that it can run alongside the other checks
+bool DirectoryService::CheckFinalBlockCommitteeHash() {
   // Verify the CommitteeHash member of the BlockHeaderBase
   CommitteeHash committeeHash;
   if (!Messenger::GetDSCommitteeHash(*m_mediator.m_DSCommittee,
@@ -888,12 +941,25 @@ bool DirectoryService::CheckFinalBlockValidity(bytes& errorMsg) {
     return true;
   }
 
-  return CheckBlockHash() && CheckFinalBlockVersion() &&
-         CheckFinalBlockNumber() && CheckPreviousFinalBlockHash() &&
-         CheckFinalBlockTimestamp() &&
-         CheckMicroBlocks(errorMsg, false, true) &&
-         CheckLegitimacyOfMicroBlocks() && CheckMicroBlockInfo() &&
-         CheckStateRoot() && CheckStateDeltaHash();
+  // The committee and micro block info hashes depend only on the proposal and
+  // the DS committee, so they are computed on the pool while the micro blocks
+  // and the state are checked
+  auto& pool = m_mediator.m_node->m_validationPool;
+  auto committeeHashValid =
+      pool.Submit([this]() { return CheckFinalBlockCommitteeHash(); });
+  auto mbInfoHashValid = pool.Submit([this]() { return CheckMbInfoHash(); });
+
+  const bool valid =
+      CheckBlockHash() && CheckFinalBlockVersion() && CheckFinalBlockNumber() &&
+      CheckPreviousFinalBlockHash() && CheckFinalBlockTimestamp() &&
+      CheckMicroBlocks(errorMsg, false, true) &&
+      CheckLegitimacyOfMicroBlocks() && CheckMicroBlockInfo() &&
+      CheckStateRoot() && CheckStateDeltaHash();
+
+  // Both are waited for even after a failure, as they read m_finalBlock
+  const bool committeeHashOk = committeeHashValid.get();
+  const bool mbInfoHashOk = mbInfoHashValid.get();
+  return valid && committeeHashOk && mbInfoHashOk;
 }
 
 bool DirectoryService::CheckMicroBlockValidity(bytes& errorMsg) {
@@ -929,8 +995,8 @@ bool DirectoryService::CheckMicroBlockValidity(bytes& errorMsg) {
   if (!ret) {
     m_mediator.m_node->m_microblock = nullptr;
   } else {
-    m_microBlocks[m_mediator.m_currentEpochNum].emplace(
-        *(m_mediator.m_node->m_microblock));
+    AddMicroBlock(m_mediator.m_currentEpochNum,
+                  *(m_mediator.m_node->m_microblock));
   }
 
   return ret;
@@ -1120,6 +1186,7 @@ void DirectoryService::PrepareRunConsensusOnFinalBlockNormal() {
 
 void DirectoryService::RunConsensusOnFinalBlock() {
   LOG_MARKER();
+  TRACE_SPAN("FinalBlock.Prepare", m_mediator.m_currentEpochNum);
 
   if (LOOKUP_NODE_MODE) {
     LOG_GENERAL(WARNING,
@@ -1234,7 +1301,7 @@ void DirectoryService::RemoveDSMicroBlock() {
                       });
   if (dsmb != microBlocksAtEpoch.end()) {
     LOG_GENERAL(INFO, "Removed DS microblock from list of microblocks");
-    microBlocksAtEpoch.erase(dsmb);
+    RemoveMicroBlock(m_mediator.m_currentEpochNum, dsmb);
   }
 
   m_mediator.m_node->m_microblock = nullptr;
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "GasPriceStats.h"
+#include "libUtils/SafeMath.h"
+
+using namespace std;
+using namespace boost::multiprecision;
+
+void GasPriceStats::SetProposal(const PubKey& submitter,
+                                const uint128_t& gasPrice) {
+  lock_guard<mutex> g(m_mutex);
+
+  auto& bySubmitter = m_proposals.get<BySubmitter>();
+  auto it = bySubmitter.find(submitter);
+  if (it == bySubmitter.end()) {
+    bySubmitter.insert({submitter, gasPrice});
+  } else {
+    bySubmitter.modify(it,
+                       [&gasPrice](Proposal& p) { p.m_gasPrice = gasPrice; });
+  }
+}
+
+void GasPriceStats::ClearProposals() {
+  lock_guard<mutex> g(m_mutex);
+  m_proposals.clear();
+}
+
+bool GasPriceStats::GetMedianProposal(const uint128_t& upperBound,
+                                      uint128_t& median) const {
+  lock_guard<mutex> g(m_mutex);
+
+  const auto& byGasPrice = m_proposals.get<ByGasPrice>();
+  const size_t n = byGasPrice.rank(byGasPrice.upper_bound(upperBound));
+  if (n == 0) {
+    return false;
+  }
+
+  const auto iter = byGasPrice.nth(n / 2);
+  if (n % 2 == 0) {
+    median = (byGasPrice.nth(n / 2 - 1)->m_gasPrice + iter->m_gasPrice) / 2;
+  } else {
+    median = iter->m_gasPrice;
+  }
+  return true;
+}
+
+void GasPriceStats::SyncWindow(const uint64_t lowBlockNum,
+                               const uint64_t highBlockNum,
+                               const GasPriceOfBlock& gasPriceOfBlock) {
+  lock_guard<mutex> g(m_mutex);
+
+  if (lowBlockNum > highBlockNum) {
+    ClearWindow();
+    return;
+  }
+
+  const uint64_t windowHigh = m_windowLow + m_window.size() - 1;
+  if (m_window.empty() || m_windowOverflow || lowBlockNum < m_windowLow ||
+      highBlockNum < windowHigh || lowBlockNum > windowHigh + 1) {
+    // Not a move forward of the window, e.g. after the chain was rebuilt
+    ClearWindow();
+    m_windowLow = lowBlockNum;
+  }
+
+  for (uint64_t i = m_windowLow + m_window.size(); i <= highBlockNum; ++i) {
+    PushBlock(gasPriceOfBlock(i));
+  }
+  while (m_windowLow < lowBlockNum) {
+    PopBlock();
+  }
+}
+
+bool GasPriceStats::GetWindowMean(uint128_t& mean) const {
+  lock_guard<mutex> g(m_mutex);
+
+  if (m_window.empty() || m_windowOverflow) {
+    return false;
+  }
+  return SafeMath<uint128_t>::div(m_windowSum, m_window.size(), mean);
+}
+
+GasPriceStats::Summary GasPriceStats::GetSummary() const {
+  Summary summary;
+  GetWindowMean(summary.m_windowMean);
+
+  lock_guard<mutex> g(m_mutex);
+
+  const auto& byGasPrice = m_proposals.get<ByGasPrice>();
+  summary.m_numProposals = byGasPrice.size();
+  if (!byGasPrice.empty()) {
+    summary.m_minProposal = byGasPrice.begin()->m_gasPrice;
+    summary.m_maxProposal = byGasPrice.rbegin()->m_gasPrice;
+  }
+  summary.m_windowSize = m_window.size();
+  return summary;
+}
+
+void GasPriceStats::ClearWindow() {
+  m_window.clear();
+  m_windowLow = 0;
+  m_windowSum = 0;
+  m_windowOverflow = false;
+}
+
+void GasPriceStats::PushBlock(const uint128_t& gasPrice) {
+  m_window.push_back(gasPrice);
+  if (!SafeMath<uint128_t>::add(m_windowSum, gasPrice, m_windowSum)) {
+    m_windowOverflow = true;
+  }
+}
+
+void GasPriceStats::PopBlock() {
+  if (!m_windowOverflow) {
+    m_windowSum -= m_window.front();
+  }
+  m_window.pop_front();
+  ++m_windowLow;
+}
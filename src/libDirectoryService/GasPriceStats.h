@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __GASPRICESTATS_H__
+#define __GASPRICESTATS_H__
+
+#include <deque>
+#include <functional>
+#include <mutex>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/ranked_index.hpp>
+#include <boost/multi_index_container.hpp>
+#include <boost/multiprecision/cpp_int.hpp>
+#pragma GCC diagnostic pop
+
+#include "libCrypto/Schnorr.h"
+
+/// Statistics the gas pricer reads each DS epoch, kept up to date as their
+/// inputs change instead of being recomputed from them.
+///
+/// The gas prices proposed in the DS PoW submissions are held in a ranked
+/// index, so that replacing a proposal and finding the median of the ones
+/// under a bound take O(log n). The gas prices of the last DS blocks are held
+/// in a sliding window with their sum, which moves by one block per DS epoch.
+class GasPriceStats {
+ public:
+  typedef std::function<boost::multiprecision::uint128_t(uint64_t)>
+      GasPriceOfBlock;
+
+  struct Summary {
+    size_t m_numProposals = 0;
+    boost::multiprecision::uint128_t m_minProposal = 0;
+    boost::multiprecision::uint128_t m_maxProposal = 0;
+    size_t m_windowSize = 0;
+    boost::multiprecision::uint128_t m_windowMean = 0;
+  };
+
+  /// Sets the gas price proposed by a submitter, replacing its last one
+  void SetProposal(const PubKey& submitter,
+                   const boost::multiprecision::uint128_t& gasPrice);
+
+  void ClearProposals();
+
+  /// Gets the median of the proposals not above upperBound, the mean of the
+  /// two middle ones if there is an even number of them
+  bool GetMedianProposal(const boost::multiprecision::uint128_t& upperBound,
+                         boost::multiprecision::uint128_t& median) const;
+
+  /// Moves the window to the blocks lowBlockNum to highBlockNum, reading the
+  /// gas prices of the blocks it does not hold yet with gasPriceOfBlock
+  void SyncWindow(const uint64_t lowBlockNum, const uint64_t highBlockNum,
+                  const GasPriceOfBlock& gasPriceOfBlock);
+
+  /// Gets the mean gas price of the blocks in the window, or false if it is
+  /// empty or its sum overflowed
+  bool GetWindowMean(boost::multiprecision::uint128_t& mean) const;
+
+  Summary GetSummary() const;
+
+ private:
+  struct Proposal {
+    PubKey m_submitter;
+    boost::multiprecision::uint128_t m_gasPrice;
+  };
+
+  struct BySubmitter {};
+  struct ByGasPrice {};
+
+  typedef boost::multi_index::multi_index_container<
+      Proposal,
+      boost::multi_index::indexed_by<
+          boost::multi_index::ordered_unique<
+              boost::multi_index::tag<BySubmitter>,
+              boost::multi_index::member<Proposal, PubKey,
+                                         &Proposal::m_submitter>>,
+          boost::multi_index::ranked_non_unique<
+              boost::multi_index::tag<ByGasPrice>,
+              boost::multi_index::member<Proposal,
+                                         boost::multiprecision::uint128_t,
+                                         &Proposal::m_gasPrice>>>>
+      Proposals;
+
+  mutable std::mutex m_mutex;
+  Proposals m_proposals;
+
+  /// Gas prices of the blocks m_windowLow onwards
+  std::deque<boost::multiprecision::uint128_t> m_window;
+  uint64_t m_windowLow = 0;
+  boost::multiprecision::uint128_t m_windowSum = 0;
+  bool m_windowOverflow = false;
+
+  void ClearWindow();
+  void PushBlock(const boost::multiprecision::uint128_t& gasPrice);
+  void PopBlock();
+};
+
+#endif  // __GASPRICESTATS_H__
@@ -58,22 +58,14 @@ uint128_t DirectoryService::GetHistoricalMeanGasPrice() {
   uint64_t lowDSBlockNum = (curDSBlockNum > MEAN_GAS_PRICE_DS_NUM)
                                ? (curDSBlockNum - MEAN_GAS_PRICE_DS_NUM)
                                : 0;
-  uint64_t totalBlockNum = 0;
-  uint128_t totalGasPrice = 0;
-  for (uint64_t i = curDSBlockNum; i >= lowDSBlockNum; --i) {
-    if (i == 0) {
-      break;
-    }
-    if (!SafeMath<uint128_t>::add(
-            totalGasPrice,
-            m_mediator.m_dsBlockChain.GetBlock(i).GetHeader().GetGasPrice(),
-            totalGasPrice)) {
-      continue;
-    }
-    totalBlockNum++;
-  }
+  // The genesis DS block is not counted
+  m_gasPriceStats.SyncWindow(
+      max<uint64_t>(lowDSBlockNum, 1), curDSBlockNum, [this](uint64_t i) {
+        return m_mediator.m_dsBlockChain.GetBlock(i).GetHeader().GetGasPrice();
+      });
+
   uint128_t ret;
-  if (!SafeMath<uint128_t>::div(totalGasPrice, totalBlockNum, ret)) {
+  if (!m_gasPriceStats.GetWindowMean(ret)) {
     return m_mediator.m_dsBlockChain.GetLastBlock().GetHeader().GetGasPrice();
   }
   return ret;
@@ -109,28 +101,9 @@ uint128_t DirectoryService::GetIncreasedGasPrice() {
                  PRECISION_MIN_VALUE * mean_val;
   }
 
-  multiset<uint128_t> gasProposals;
-  for (const auto& soln : m_allDSPoWs) {
-    if (soln.second.gasPrice <= upperbound) {
-      gasProposals.emplace(soln.second.gasPrice);
-    }
-  }
-  if (gasProposals.empty()) {
-    return GetHistoricalMeanGasPrice();
-  }
-
-  // Get median value
-  const size_t n = gasProposals.size();
-  auto iter = gasProposals.cbegin();
-  std::advance(iter, n / 2);
-
   uint128_t median_val;
-
-  if (n % 2 == 0) {
-    const auto iter2 = iter--;
-    median_val = (*iter + *iter2) / 2;
-  } else {
-    median_val = *iter;
+  if (!m_gasPriceStats.GetMedianProposal(upperbound, median_val)) {
+    return mean_val;
   }
 
   return max(max(lowerbound, min(median_val, upperbound)),
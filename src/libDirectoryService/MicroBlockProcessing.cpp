@@ -16,8 +16,11 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <numeric>
 #include <thread>
+#include <unordered_set>
 
 #include "DirectoryService.h"
 #include "common/Constants.h"
@@ -33,6 +36,7 @@
 #include "libUtils/BitVector.h"
 #include "libUtils/DataConversion.h"
 #include "libUtils/DetachedFunction.h"
+#include "libUtils/JoinableFunction.h"
 #include "libUtils/Logger.h"
 #include "libUtils/SanityChecks.h"
 #include "libUtils/TimestampVerifier.h"
@@ -51,7 +55,7 @@ bool DirectoryService::VerifyMicroBlockCoSignature(const MicroBlock& microBlock,
 
   LOG_MARKER();
 
-  const vector<bool>& B2 = microBlock.GetB2();
+  const BitVector& B2 = microBlock.GetB2();
   vector<PubKey> keys;
   unsigned int index = 0;
   unsigned int count = 0;
@@ -104,7 +108,7 @@ bool DirectoryService::VerifyMicroBlockCoSignature(const MicroBlock& microBlock,
 
   // Verify the collective signature
   bytes message;
-  if (!microBlock.GetHeader().Serialize(message, 0)) {
+  if (!microBlock.GetHeader().SerializeCached(message, 0)) {
     LOG_GENERAL(WARNING, "MicroBlockHeader serialization failed");
     return false;
   }
@@ -122,14 +126,16 @@ bool DirectoryService::VerifyMicroBlockCoSignature(const MicroBlock& microBlock,
   return true;
 }
 
-bool DirectoryService::ProcessStateDelta(
+bool DirectoryService::CheckStateDelta(
     const bytes& stateDelta, const StateHash& microBlockStateDeltaHash,
-    const BlockHash& microBlockHash) {
+    bool& apply, unordered_set<Address>& contracts) {
   LOG_MARKER();
 
+  apply = false;
+
   if (LOOKUP_NODE_MODE) {
     LOG_GENERAL(WARNING,
-                "DirectoryService::ProcessStateDelta not expected to be "
+                "DirectoryService::CheckStateDelta not expected to be "
                 "called from LookUp node.");
     return true;
   }
@@ -168,13 +174,56 @@ bool DirectoryService::ProcessStateDelta(
     return false;
   }
 
-  if (microBlockStateDeltaHash == StateHash()) {
-    LOG_GENERAL(INFO, "State Delta from microblock is empty");
+  if (!Messenger::StateDeltaToContractAddresses(stateDelta, 0, contracts)) {
+    LOG_GENERAL(WARNING, "Messenger::StateDeltaToContractAddresses failed.");
     return false;
   }
 
-  if (!AccountStore::GetInstance().DeserializeDeltaTemp(stateDelta, 0)) {
+  apply = true;
+  return true;
+}
+
+bool DirectoryService::ApplyStateDelta(const bytes& stateDelta,
+                                       uint32_t shardId,
+                                       unordered_set<Address>&& contracts,
+                                       const BlockHash& microBlockHash) {
+  LOG_MARKER();
+
+  // Deltas to balances and nonces commute, so the delta can be merged on top
+  // of the others unless it changes a contract that a higher shard changed
+  bool reapply = false;
+  for (auto it = m_appliedStateDeltas.upper_bound(shardId);
+       it != m_appliedStateDeltas.end() && !reapply; ++it) {
+    for (const auto& address : contracts) {
+      if (it->second.m_contracts.find(address) !=
+          it->second.m_contracts.end()) {
+        LOG_GENERAL(INFO, "Contract " << address << " changed by shard "
+                                      << shardId << " and " << it->first
+                                      << ", merging in shard order");
+        reapply = true;
+        break;
+      }
+    }
+  }
+
+  auto applied = m_appliedStateDeltas.emplace(
+      shardId, AppliedStateDelta{stateDelta, move(contracts)});
+  if (!applied.second) {
+    LOG_GENERAL(WARNING,
+                "State delta of shard " << shardId << " already applied");
+    return false;
+  }
+
+  if (reapply) {
+    if (!ReapplyStateDeltas()) {
+      m_appliedStateDeltas.erase(applied.first);
+      ReapplyStateDeltas();
+      return false;
+    }
+  } else if (!AccountStore::GetInstance().DeserializeDeltaTemp(stateDelta,
+                                                                0)) {
     LOG_GENERAL(WARNING, "AccountStore::DeserializeDeltaTemp failed.");
+    m_appliedStateDeltas.erase(applied.first);
     return false;
   }
 
@@ -191,6 +240,22 @@ bool DirectoryService::ProcessStateDelta(
   return true;
 }
 
+bool DirectoryService::ReapplyStateDeltas() {
+  AccountStore::GetInstance().InitTemp();
+
+  for (const auto& entry : m_appliedStateDeltas) {
+    if (!AccountStore::GetInstance().DeserializeDeltaTemp(
+            entry.second.m_stateDelta, 0)) {
+      LOG_GENERAL(WARNING, "AccountStore::DeserializeDeltaTemp failed for "
+                           "state delta of shard "
+                               << entry.first);
+      return false;
+    }
+  }
+
+  return true;
+}
+
 bool DirectoryService::ProcessMicroblockSubmissionFromShardCore(
     const MicroBlock& microBlock, const bytes& stateDelta) {
   if (LOOKUP_NODE_MODE) {
@@ -276,6 +341,18 @@ bool DirectoryService::ProcessMicroblockSubmissionFromShardCore(
                         << endl
                         << microBlock.GetHeader().GetHashes());
 
+  // Check and decode the state delta before locking, so that the
+  // submissions of all the shards can be done at once
+  const bool isVacuousEpoch = m_mediator.GetIsVacuousEpoch();
+  bool applyStateDelta = false;
+  unordered_set<Address> contracts;
+  if (!isVacuousEpoch &&
+      !CheckStateDelta(stateDelta, microBlock.GetHeader().GetStateDeltaHash(),
+                       applyStateDelta, contracts)) {
+    LOG_GENERAL(WARNING, "State delta attached to the microblock is invalid");
+    return false;
+  }
+
   lock_guard<mutex> g(m_mutexMicroBlocks);
 
   if (m_stopRecvNewMBSubmission) {
@@ -310,16 +387,13 @@ bool DirectoryService::ProcessMicroblockSubmissionFromShardCore(
     LOG_GENERAL(WARNING, "Failed to put microblock in persistence");
   }
 
-  if (!m_mediator.GetIsVacuousEpoch()) {
-    if (!ProcessStateDelta(stateDelta,
-                           microBlock.GetHeader().GetStateDeltaHash(),
-                           microBlock.GetBlockHash())) {
-      LOG_GENERAL(WARNING, "State delta attached to the microblock is invalid");
-      return false;
-    }
+  if (applyStateDelta && !ApplyStateDelta(stateDelta, shardId, move(contracts),
+                                          microBlock.GetBlockHash())) {
+    LOG_GENERAL(WARNING, "State delta attached to the microblock is invalid");
+    return false;
   }
 
-  microBlocksAtEpoch.emplace(microBlock);
+  AddMicroBlock(m_mediator.m_currentEpochNum, microBlock);
 
   LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
             microBlocksAtEpoch.size()
@@ -351,25 +425,30 @@ bool DirectoryService::ProcessMicroblockSubmissionFromShardCore(
   return true;
 }
 
+void DirectoryService::BufferMBSubmission(const uint64_t epochNumber,
+                                          const MicroBlock& microBlock,
+                                          const bytes& stateDelta) {
+  lock_guard<mutex> g(m_mutexMBSubmissionBuffer);
+  MBSubmissionBufferEntry entry(microBlock, stateDelta);
+  const uint64_t bytes = entry.GetBytes();
+  const unsigned int dropped =
+      m_MBSubmissionBuffer.Push(epochNumber, move(entry), bytes);
+  if (dropped > 0) {
+    LOG_GENERAL(WARNING, "MB submission buffer over budget, dropped "
+                             << dropped << " oldest submissions");
+  }
+}
+
 void DirectoryService::CommitMBSubmissionMsgBuffer() {
   LOG_MARKER();
 
   lock_guard<mutex> g(m_mutexMBSubmissionBuffer);
 
-  for (auto it = m_MBSubmissionBuffer.begin();
-       it != m_MBSubmissionBuffer.end();) {
-    if (it->first < m_mediator.m_currentEpochNum) {
-      it = m_MBSubmissionBuffer.erase(it);
-    } else if (it->first == m_mediator.m_currentEpochNum) {
-      for (const auto& entry : it->second) {
-        ProcessMicroblockSubmissionFromShardCore(entry.m_microBlock,
-                                                 entry.m_stateDelta);
-      }
-      m_MBSubmissionBuffer.erase(it);
-      break;
-    } else {
-      it++;
-    }
+  m_MBSubmissionBuffer.EraseBefore(m_mediator.m_currentEpochNum);
+  for (const auto& entry :
+       m_MBSubmissionBuffer.Take(m_mediator.m_currentEpochNum)) {
+    ProcessMicroblockSubmissionFromShardCore(entry.m_microBlock,
+                                             entry.m_stateDelta);
   }
 }
 
@@ -435,17 +514,13 @@ bool DirectoryService::ProcessMicroblockSubmissionFromShard(
   const auto& stateDelta = stateDeltas.at(0);
 
   if (m_mediator.m_currentEpochNum < epochNumber) {
-    lock_guard<mutex> g(m_mutexMBSubmissionBuffer);
-    m_MBSubmissionBuffer[epochNumber].emplace_back(microBlock, stateDelta);
-
+    BufferMBSubmission(epochNumber, microBlock, stateDelta);
     return true;
   } else if (m_mediator.m_currentEpochNum == epochNumber) {
     if (CheckState(PROCESS_MICROBLOCKSUBMISSION)) {
       return ProcessMicroblockSubmissionFromShardCore(microBlock, stateDelta);
     } else {
-      lock_guard<mutex> g(m_mutexMBSubmissionBuffer);
-      m_MBSubmissionBuffer[epochNumber].emplace_back(microBlock, stateDelta);
-
+      BufferMBSubmission(epochNumber, microBlock, stateDelta);
       return true;
     }
   }
@@ -523,20 +598,50 @@ bool DirectoryService::ProcessMissingMicroblockSubmission(
                   << " , local: " << m_mediator.m_currentEpochNum);
   }
 
+  if (microBlocks.size() != stateDeltas.size()) {
+    LOG_GENERAL(WARNING, "size of microBlocks fetched "
+                             << microBlocks.size()
+                             << " is different from size of "
+                                "stateDeltas fetched "
+                             << stateDeltas.size());
+    return false;
+  }
+
+  // Check and decode the state deltas in parallel before locking, then merge
+  // them in shard order
+  const bool isVacuousEpoch = m_mediator.GetIsVacuousEpoch(epochNumber);
+  vector<unsigned char> stateDeltaValid(microBlocks.size(), true);
+  vector<unsigned char> applyStateDelta(microBlocks.size(), false);
+  vector<unordered_set<Address>> contracts(microBlocks.size());
+  if (!isVacuousEpoch && !microBlocks.empty()) {
+    atomic<unsigned int> next(0);
+    auto checkStateDeltas = [&]() -> void {
+      for (unsigned int i = next++; i < microBlocks.size(); i = next++) {
+        bool apply = false;
+        stateDeltaValid[i] = CheckStateDelta(
+            stateDeltas[i], microBlocks[i].GetHeader().GetStateDeltaHash(),
+            apply, contracts[i]);
+        applyStateDelta[i] = apply;
+      }
+    };
+    const unsigned int numThreads = min<unsigned int>(
+        microBlocks.size(), max(1U, thread::hardware_concurrency()));
+    JoinableFunction joinableFunc(numThreads, checkStateDeltas);
+  }
+
+  vector<unsigned int> order(microBlocks.size());
+  iota(order.begin(), order.end(), 0);
+  stable_sort(order.begin(), order.end(),
+              [&microBlocks](unsigned int a, unsigned int b) {
+                return microBlocks[a].GetHeader().GetShardId() <
+                       microBlocks[b].GetHeader().GetShardId();
+              });
+
   {
     lock_guard<mutex> g(m_mutexMicroBlocks);
     auto& microBlocksAtEpoch = m_microBlocks[epochNumber];
 
-    if (microBlocks.size() != stateDeltas.size()) {
-      LOG_GENERAL(WARNING, "size of microBlocks fetched "
-                               << microBlocks.size()
-                               << " is different from size of "
-                                  "stateDeltas fetched "
-                               << stateDeltas.size());
-      return false;
-    }
-
-    for (unsigned int i = 0; i < microBlocks.size(); ++i) {
+    for (const unsigned int i : order) {
       if (!m_mediator.CheckWhetherBlockIsLatest(
               microBlocks.at(i).GetHeader().GetDSBlockNum() + 1,
               microBlocks.at(i).GetHeader().GetEpochNum())) {
@@ -637,11 +742,11 @@ bool DirectoryService::ProcessMissingMicroblockSubmission(
         }
       }
 
-      if (!m_mediator.GetIsVacuousEpoch(epochNumber)) {
-        if (!ProcessStateDelta(
-                stateDeltas.at(i),
-                microBlocks.at(i).GetHeader().GetStateDeltaHash(),
-                microBlocks.at(i).GetBlockHash())) {
+      if (!isVacuousEpoch) {
+        if (!stateDeltaValid[i] ||
+            (applyStateDelta[i] &&
+             !ApplyStateDelta(stateDeltas.at(i), shardId, move(contracts[i]),
+                              microBlocks.at(i).GetBlockHash()))) {
           LOG_GENERAL(WARNING,
                       "State delta attached to the microblock is invalid");
           continue;
@@ -655,7 +760,7 @@ bool DirectoryService::ProcessMissingMicroblockSubmission(
         LOG_GENERAL(WARNING, "Failed to put microblock in persistence");
       }
 
-      microBlocksAtEpoch.emplace(microBlocks.at(i));
+      AddMicroBlock(epochNumber, microBlocks.at(i));
       // m_fetchedMicroBlocks.emplace(microBlock);
 
       LOG_GENERAL(INFO, microBlocksAtEpoch.size()
@@ -16,7 +16,9 @@
  */
 
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <functional>
 #include <thread>
 
 #include "DirectoryService.h"
@@ -27,6 +29,7 @@
 #include "depends/libTrie/TrieDB.h"
 #include "depends/libTrie/TrieHash.h"
 #include "libCrypto/Sha2.h"
+#include "libLookup/Lookup.h"
 #include "libMediator/Mediator.h"
 #include "libMessage/Messenger.h"
 #include "libNetwork/Guard.h"
@@ -104,8 +107,12 @@ bool DirectoryService::ProcessPoWPacketSubmission(
     return false;
   }
 
-  // check if sender pubkey is one from our expected list
-  if (!CheckIfDSNode(senderPubKey)) {
+  // check if sender pubkey is one from our expected list, which includes
+  // the lookups if they relay the submissions
+  if (!CheckIfDSNode(senderPubKey) &&
+      !(POW_SUBMISSION_RELAY &&
+        Lookup::VerifySenderNode(m_mediator.m_lookup->GetLookupNodesStatic(),
+                                 senderPubKey))) {
     LOG_GENERAL(WARNING,
                 "PubKey of packet sender "
                     << from
@@ -115,14 +122,7 @@ bool DirectoryService::ProcessPoWPacketSubmission(
   }
 
   LOG_GENERAL(INFO, "PoW solutions received in this packet: " << tmp.size());
-  for (auto& sol : tmp) {
-    // No point processing the other solutions if DS Block consensus is starting
-    if ((m_state == DSBLOCK_CONSENSUS_PREP) || (m_state == DSBLOCK_CONSENSUS)) {
-      LOG_GENERAL(INFO, "Too late");
-      break;
-    }
-    VerifyPoWSubmission(sol);
-  }
+  VerifyPoWSubmissions(tmp);
 
   return true;
 }
@@ -132,6 +132,9 @@ bool DirectoryService::ProcessPoWSubmission(const bytes& message,
                                             const Peer& from) {
   LOG_MARKER();
   if (LOOKUP_NODE_MODE) {
+    if (POW_SUBMISSION_RELAY) {
+      return m_mediator.m_lookup->RelayPoWSubmission(message, offset, from);
+    }
     LOG_GENERAL(WARNING,
                 "DirectoryService::ProcessPoWSubmission not expected to be "
                 "called from LookUp node.");
@@ -235,6 +238,115 @@ bool DirectoryService::VerifyPoWSubmission(const DSPowSolution& sol) {
     return true;
   }
 
+  WaitForPoWSubmissionState();
+
+  bool verify = false;
+  if (!CheckPoWSubmission(sol, verify)) {
+    return false;
+  }
+  if (!verify) {
+    return true;
+  }
+
+  // m_timespec = r_timer_start();
+
+  bool result = CheckPoWSubmissionHash(sol);
+
+  // LOG_GENERAL(INFO, "[POWSTAT] " << r_timer_end(m_timespec));
+
+  if (result) {
+    AcceptPoWSubmission(sol);
+  }
+
+  return result;
+}
+
+void DirectoryService::VerifyPoWSubmissions(
+    const std::vector<DSPowSolution>& sols) {
+  LOG_MARKER();
+
+  WaitForPoWSubmissionState();
+
+  // Drop the (submitter, nonce) pairs repeated in the packet or already
+  // recorded, and the submissions past the limit of their submitter. The
+  // limit is checked again on accepting, against the counter of the node.
+  set<pair<PubKey, uint64_t>> seen;
+  map<PubKey, unsigned int> perSubmitter;
+  vector<reference_wrapper<const DSPowSolution>> unique;
+  {
+    lock_guard<mutex> g(m_mutexAllPOW);
+    for (const auto& sol : sols) {
+      const PubKey& submitterPubKey = sol.GetSubmitterKey();
+      if (!seen.emplace(submitterPubKey, sol.GetNonce()).second) {
+        continue;
+      }
+      auto it = m_allPoWs.find(submitterPubKey);
+      if (it != m_allPoWs.end() && it->second.nonce == sol.GetNonce()) {
+        continue;
+      }
+      if (perSubmitter[submitterPubKey]++ >= POW_SUBMISSION_LIMIT) {
+        continue;
+      }
+      unique.emplace_back(sol);
+    }
+  }
+  if (unique.size() < sols.size()) {
+    LOG_GENERAL(INFO, "Dropped " << sols.size() - unique.size()
+                                 << " repeated PoW submissions");
+  }
+
+  const unsigned int numThreads =
+      POW_VERIFY_THREADS > 0
+          ? POW_VERIFY_THREADS
+          : max(thread::hardware_concurrency(), (unsigned int)1);
+  const size_t batchSize = max(POW_VERIFY_BATCH_SIZE, (unsigned int)1);
+
+  for (size_t begin = 0; begin < unique.size(); begin += batchSize) {
+    // No point processing the other solutions if DS Block consensus is starting
+    if ((m_state == DSBLOCK_CONSENSUS_PREP) || (m_state == DSBLOCK_CONSENSUS)) {
+      LOG_GENERAL(INFO, "Too late");
+      break;
+    }
+
+    const size_t end = min(begin + batchSize, unique.size());
+
+    vector<reference_wrapper<const DSPowSolution>> batch;
+    for (size_t i = begin; i < end; i++) {
+      bool verify = false;
+      if (CheckPoWSubmission(unique[i], verify) && verify) {
+        batch.emplace_back(unique[i]);
+      }
+    }
+
+    // Workers pull submissions off the batch, all hashing against the one
+    // light cache of the epoch
+    vector<char> results(batch.size(), false);
+    atomic<size_t> next{0};
+    auto verifyBatch = [this, &batch, &results, &next]() {
+      for (size_t i = next++; i < batch.size(); i = next++) {
+        results[i] = CheckPoWSubmissionHash(batch[i]);
+      }
+    };
+
+    const size_t numWorkers = min<size_t>(numThreads, batch.size());
+    vector<thread> workers;
+    for (size_t i = 1; i < numWorkers; i++) {
+      workers.emplace_back(verifyBatch);
+    }
+    verifyBatch();
+    for (auto& worker : workers) {
+      worker.join();
+    }
+
+    for (size_t i = 0; i < batch.size(); i++) {
+      if (results[i]) {
+        AcceptPoWSubmission(batch[i]);
+      }
+    }
+  }
+}
+
+void DirectoryService::WaitForPoWSubmissionState() {
   if (m_state == FINALBLOCK_CONSENSUS) {
     std::unique_lock<std::mutex> cv_lk(m_MutexCVPOWSubmission);
 
@@ -246,6 +358,11 @@ bool DirectoryService::VerifyPoWSubmission(const DSPowSolution& sol) {
 
     LOG_EPOCH(INFO, m_mediator.m_currentEpochNum, "State transition completed");
   }
+}
+
+bool DirectoryService::CheckPoWSubmission(const DSPowSolution& sol,
+                                          bool& verify) {
+  verify = false;
 
   if (!CheckState(PROCESS_POWSUBMISSION)) {
     return false;
@@ -255,12 +372,6 @@ bool DirectoryService::VerifyPoWSubmission(const DSPowSolution& sol) {
   uint64_t blockNumber = sol.GetBlockNumber();
   Peer submitterPeer = sol.GetSubmitterPeer();
   PubKey submitterPubKey = sol.GetSubmitterKey();
-  uint64_t nonce = sol.GetNonce();
-  string resultingHash = sol.GetResultingHash();
-  string mixHash = sol.GetMixHash();
-  Signature signature = sol.GetSignature();
-  uint32_t lookupId = sol.GetLookupId();
-  uint128_t gasPrice = sol.GetGasPrice();
 
   // Check block number
   if (!CheckWhetherDSBlockIsFresh(blockNumber)) {
@@ -292,10 +403,6 @@ bool DirectoryService::VerifyPoWSubmission(const DSPowSolution& sol) {
     return false;
   }
 
-  // Define the PoW parameters
-  array<unsigned char, 32> rand1 = m_mediator.m_dsBlockRand;
-  array<unsigned char, 32> rand2 = m_mediator.m_txBlockRand;
-
   LOG_GENERAL(INFO, "Block = " << blockNumber);
 
   uint8_t expectedDSDiff = DS_POW_DIFFICULTY;
@@ -339,74 +446,96 @@ bool DirectoryService::VerifyPoWSubmission(const DSPowSolution& sol) {
     }
   }
 
-  // m_timespec = r_timer_start();
-
-  auto headerHash = POW::GenHeaderHash(rand1, rand2, submitterPeer.m_ipAddress,
-                                       submitterPubKey, lookupId, gasPrice);
-  bool result = POW::GetInstance().PoWVerify(
-      blockNumber, difficultyLevel, headerHash, nonce, resultingHash, mixHash);
-
-  // LOG_GENERAL(INFO, "[POWSTAT] " << r_timer_end(m_timespec));
-
-  if (result) {
-    // Do another check on the state before accessing m_allPoWs
-    // Accept slightly late entries as we need to multicast the DSBLOCK to
-    // everyone if ((m_state != POW_SUBMISSION) && (m_state !=
-    // DSBLOCK_CONSENSUS_PREP))
-    if (CheckState(VERIFYPOW)) {
-      // LOG_GENERAL(INFO, "Verified OK");
-      lock(m_mutexAllPOW, m_mutexAllPoWConns);
-      lock_guard<mutex> g(m_mutexAllPOW, adopt_lock);
-      lock_guard<mutex> g2(m_mutexAllPoWConns, adopt_lock);
-
-      array<uint8_t, 32> resultingHashArr, mixHashArr;
-      DataConversion::HexStrToStdArray(resultingHash, resultingHashArr);
-      DataConversion::HexStrToStdArray(mixHash, mixHashArr);
-      PoWSolution soln(nonce, resultingHashArr, mixHashArr, lookupId, gasPrice);
-
-      m_allPoWConns.emplace(submitterPubKey, submitterPeer);
-      if (m_allPoWs.find(submitterPubKey) == m_allPoWs.end()) {
-        m_allPoWs[submitterPubKey] = soln;
-      } else if (m_allPoWs[submitterPubKey].result > soln.result) {
-        // string harderSolnStr, oldSolnStr;
-        // DataConversion::charArrToHexStr(soln.result, harderSolnStr);
-        // DataConversion::charArrToHexStr(m_allPoWs[submitterPubKey].result,
-        // oldSolnStr);
-        LOG_GENERAL(INFO, "Replaced");
-        m_allPoWs[submitterPubKey] = soln;
-      } else if (m_allPoWs[submitterPubKey].result == soln.result) {
-        LOG_GENERAL(INFO, "Duplicated");
-        return true;
-      }
+  verify = true;
+  return true;
+}
 
-      uint8_t expectedDSDiff = DS_POW_DIFFICULTY;
-      if (blockNumber > 1) {
-        expectedDSDiff = m_mediator.m_dsBlockChain.GetLastBlock()
-                             .GetHeader()
-                             .GetDSDifficulty();
-      }
+bool DirectoryService::CheckPoWSubmissionHash(const DSPowSolution& sol) {
+  // Define the PoW parameters
+  array<unsigned char, 32> rand1 = m_mediator.m_dsBlockRand;
+  array<unsigned char, 32> rand2 = m_mediator.m_txBlockRand;
 
-      // Push the same solution into the DS PoW list if it qualifies
-      if (difficultyLevel >= expectedDSDiff) {
-        AddDSPoWs(submitterPubKey, soln);
-      }
+  const Peer& submitterPeer = sol.GetSubmitterPeer();
+  auto headerHash = POW::GenHeaderHash(
+      rand1, rand2, submitterPeer.m_ipAddress, sol.GetSubmitterKey(),
+      sol.GetLookupId(), sol.GetGasPrice());
+  bool result = POW::GetInstance().PoWVerify(
+      sol.GetBlockNumber(), sol.GetDifficultyLevel(), headerHash,
+      sol.GetNonce(), sol.GetResultingHash(), sol.GetMixHash());
 
-      UpdatePoWSubmissionCounterforNode(submitterPubKey);
-    }
-  } else {
+  if (!result) {
     string rand1Str, rand2Str;
     DataConversion::charArrToHexStr(rand1, rand1Str);
     DataConversion::charArrToHexStr(rand2, rand2Str);
     LOG_GENERAL(INFO, "[Invalid PoW] Block: "
-                          << blockNumber
-                          << " Diff: " << to_string(difficultyLevel)
-                          << " Nonce: " << nonce << " IP: " << submitterPeer
-                          << " Rand1: " << rand1Str << " Rand2: " << rand2Str);
+                          << sol.GetBlockNumber()
+                          << " Diff: " << to_string(sol.GetDifficultyLevel())
+                          << " Nonce: " << sol.GetNonce()
+                          << " IP: " << submitterPeer << " Rand1: " << rand1Str
+                          << " Rand2: " << rand2Str);
   }
 
   return result;
 }
 
+void DirectoryService::AcceptPoWSubmission(const DSPowSolution& sol) {
+  // Do another check on the state before accessing m_allPoWs
+  // Accept slightly late entries as we need to multicast the DSBLOCK to
+  // everyone if ((m_state != POW_SUBMISSION) && (m_state !=
+  // DSBLOCK_CONSENSUS_PREP))
+  if (!CheckState(VERIFYPOW)) {
+    return;
+  }
+
+  const PubKey& submitterPubKey = sol.GetSubmitterKey();
+
+  // LOG_GENERAL(INFO, "Verified OK");
+  lock(m_mutexAllPOW, m_mutexAllPoWConns);
+  lock_guard<mutex> g(m_mutexAllPOW, adopt_lock);
+  lock_guard<mutex> g2(m_mutexAllPoWConns, adopt_lock);
+
+  // Submissions of a node verified at the same time all passed the limit
+  // check before any of them was counted, so it is made again here
+  if (CheckPoWSubmissionExceedsLimitsForNode(submitterPubKey)) {
+    LOG_GENERAL(WARNING, "Max PoW sent");
+    return;
+  }
+
+  array<uint8_t, 32> resultingHashArr, mixHashArr;
+  DataConversion::HexStrToStdArray(sol.GetResultingHash(), resultingHashArr);
+  DataConversion::HexStrToStdArray(sol.GetMixHash(), mixHashArr);
+  PoWSolution soln(sol.GetNonce(), resultingHashArr, mixHashArr,
+                   sol.GetLookupId(), sol.GetGasPrice());
+
+  m_allPoWConns.emplace(submitterPubKey, sol.GetSubmitterPeer());
+  if (m_allPoWs.find(submitterPubKey) == m_allPoWs.end()) {
+    m_allPoWs[submitterPubKey] = soln;
+  } else if (m_allPoWs[submitterPubKey].result > soln.result) {
+    // string harderSolnStr, oldSolnStr;
+    // DataConversion::charArrToHexStr(soln.result, harderSolnStr);
+    // DataConversion::charArrToHexStr(m_allPoWs[submitterPubKey].result,
+    // oldSolnStr);
+    LOG_GENERAL(INFO, "Replaced");
+    m_allPoWs[submitterPubKey] = soln;
+  } else if (m_allPoWs[submitterPubKey].result == soln.result) {
+    LOG_GENERAL(INFO, "Duplicated");
+    return;
+  }
+
+  uint8_t expectedDSDiff = DS_POW_DIFFICULTY;
+  if (sol.GetBlockNumber() > 1) {
+    expectedDSDiff =
+        m_mediator.m_dsBlockChain.GetLastBlock().GetHeader().GetDSDifficulty();
+  }
+
+  // Push the same solution into the DS PoW list if it qualifies
+  if (sol.GetDifficultyLevel() >= expectedDSDiff) {
+    AddDSPoWs(submitterPubKey, soln);
+  }
+
+  UpdatePoWSubmissionCounterforNode(submitterPubKey);
+}
+
 bool DirectoryService::CheckSolnFromNonDSCommittee(
     const PubKey& submitterPubKey, const Peer& submitterPeer) {
   lock_guard<mutex> g(m_mediator.m_mutexDSCommittee);
@@ -459,6 +588,7 @@ void DirectoryService::ResetPoWSubmissionCounter() {
 void DirectoryService::AddDSPoWs(PubKey Pubk, const PoWSolution& DSPOWSoln) {
   lock_guard<mutex> g(m_mutexAllDSPOWs);
   m_allDSPoWs[Pubk] = DSPOWSoln;
+  m_gasPriceStats.SetProposal(Pubk, DSPOWSoln.gasPrice);
 }
 
 MapOfPubKeyPoW DirectoryService::GetAllDSPoWs() {
@@ -469,6 +599,7 @@ MapOfPubKeyPoW DirectoryService::GetAllDSPoWs() {
 void DirectoryService::ClearDSPoWSolns() {
   lock_guard<mutex> g(m_mutexAllDSPOWs);
   m_allDSPoWs.clear();
+  m_gasPriceStats.ClearProposals();
 }
 
 std::array<unsigned char, 32> DirectoryService::GetDSPoWSoln(PubKey Pubk) {
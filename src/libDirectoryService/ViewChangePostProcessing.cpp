@@ -35,6 +35,7 @@
 #include "libUtils/DetachedFunction.h"
 #include "libUtils/Logger.h"
 #include "libUtils/SanityChecks.h"
+#include "libUtils/Tracing.h"
 
 using namespace std;
 
@@ -70,6 +71,7 @@ void DirectoryService::ProcessViewChangeConsensusWhenDone() {
   }
 
   LOG_EPOCH(INFO, m_mediator.m_currentEpochNum, "View change consensus DONE");
+  TRACE_SPAN("ViewChange.Commit", m_mediator.m_currentEpochNum);
   m_pendingVCBlock->SetCoSignatures(*m_consensusObject);
 
   m_candidateLeaderIndex = 0;
@@ -95,7 +97,7 @@ void DirectoryService::ProcessViewChangeConsensusWhenDone() {
   }
 
   bytes message;
-  if (!m_pendingVCBlock->GetHeader().Serialize(message, 0)) {
+  if (!m_pendingVCBlock->GetHeader().SerializeCached(message, 0)) {
     LOG_GENERAL(WARNING, "VCBlockHeader serialization failed");
     return;
   }
@@ -243,6 +245,7 @@ void DirectoryService::ProcessViewChangeConsensusWhenDone() {
                 "I am backup member of the DS shard");
     }
   }
+  m_mediator.PublishEpochContext();
 
   switch (viewChangeState) {
     case DSBLOCK_CONSENSUS:
@@ -380,6 +383,7 @@ bool DirectoryService::ProcessViewChangeConsensus(const bytes& message,
   }
 
   LOG_MARKER();
+  TRACE_SPAN("ViewChange.Consensus", m_mediator.m_currentEpochNum);
   // Consensus messages must be processed in correct sequence as they come in
   // It is possible for ANNOUNCE to arrive before correct DS state
   // In that case, ANNOUNCE will sleep for a second below
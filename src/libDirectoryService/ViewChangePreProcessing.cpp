@@ -37,6 +37,7 @@
 #include "libUtils/Logger.h"
 #include "libUtils/SanityChecks.h"
 #include "libUtils/TimestampVerifier.h"
+#include "libUtils/Tracing.h"
 
 using namespace std;
 
@@ -268,6 +269,9 @@ void DirectoryService::RunConsensusOnViewChange() {
   }
 
   LOG_MARKER();
+  TRACE_SPAN("ViewChange.Prepare", m_mediator.m_currentEpochNum);
+
+  m_viewChangeStartTime = r_timer_start();
 
   SetLastKnownGoodState();
   SetState(VIEWCHANGE_CONSENSUS_PREP);
@@ -283,7 +287,6 @@ void DirectoryService::RunConsensusOnViewChange() {
   // i.e in first epoch, it will request for block 1, which means fetch latest
   // block (including block 0)
   if (dsCurBlockNum != 0 && txCurBlockNum != 0) {
-    VCFetchLatestDSTxBlockFromSeedNodes();
     if (!NodeVCPrecheck()) {
       LOG_GENERAL(WARNING,
                   "[RDS]Failed the vc precheck. Node is lagging behind the "
@@ -456,13 +459,22 @@ bool DirectoryService::NodeVCPrecheck() {
     m_vcPreCheckDSBlocks.clear();
     m_vcPreCheckTxBlocks.clear();
   }
+  {
+    lock_guard<mutex> g(m_MutexCVViewChangePrecheck);
+    m_vcPreCheckReceived = false;
+  }
 
-  std::unique_lock<std::mutex> cv_lk(m_MutexCVViewChangePrecheck);
-  if (cv_viewChangePrecheck.wait_for(
-          cv_lk, std::chrono::seconds(VIEWCHANGE_PRECHECK_TIME)) ==
-      std::cv_status::timeout) {
-    LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
-              "Timeout while waiting for precheck. ");
+  // Ask only once ready for the answer, which can come back before we wait
+  VCFetchLatestDSTxBlockFromSeedNodes();
+
+  {
+    std::unique_lock<std::mutex> cv_lk(m_MutexCVViewChangePrecheck);
+    if (!cv_viewChangePrecheck.wait_for(
+            cv_lk, std::chrono::seconds(VIEWCHANGE_PRECHECK_TIME),
+            [this] { return m_vcPreCheckReceived; })) {
+      LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
+                "Timeout while waiting for precheck. ");
+    }
   }
 
   {
@@ -657,7 +669,10 @@ bool DirectoryService::RunConsensusOnViewChangeWhenCandidateLeader(
     m_pendingVCBlock->Serialize(m, 0);
   }
 
-  std::this_thread::sleep_for(std::chrono::seconds(VIEWCHANGE_EXTRA_TIME));
+  // The backups set up their consensus objects once their own precheck is
+  // done, which ran alongside ours, so only wait out the rest of the time
+  std::this_thread::sleep_until(m_viewChangeStartTime +
+                                std::chrono::seconds(VIEWCHANGE_EXTRA_TIME));
 
   auto announcementGeneratorFunc =
       [this](bytes& dst, unsigned int offset, const uint32_t consensusID,
@@ -795,6 +810,10 @@ bool DirectoryService::ProcessGetDSTxBlockMessage(
   m_vcPreCheckDSBlocks = vcPreCheckDSBlocks;
   m_vcPreCheckTxBlocks = vcPreCheckTxBlocks;
 
+  {
+    lock_guard<mutex> g2(m_MutexCVViewChangePrecheck);
+    m_vcPreCheckReceived = true;
+  }
   cv_viewChangePrecheck.notify_all();
   return true;
 }
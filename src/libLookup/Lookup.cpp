@@ -33,6 +33,7 @@
 #include "common/Messages.h"
 #include "libData/AccountData/Account.h"
 #include "libData/AccountData/AccountStore.h"
+#include "libData/AccountData/MBnForwardedTxnEntry.h"
 #include "libData/AccountData/Transaction.h"
 #include "libData/BlockChainData/BlockChain.h"
 #include "libData/BlockChainData/BlockLinkChain.h"
@@ -46,16 +47,21 @@
 #include "libPOW/pow.h"
 #include "libPersistence/BlockStorage.h"
 #include "libServer/GetWorkServer.h"
+#include "libUtils/DNSCache.h"
 #include "libUtils/DataConversion.h"
 #include "libUtils/DetachedFunction.h"
 #include "libUtils/GetTxnFromFile.h"
+#include "libUtils/JoinableFunction.h"
 #include "libUtils/SanityChecks.h"
+#include "libUtils/Scheduler.h"
 #include "libUtils/SysCommand.h"
+#include "libUtils/Tracing.h"
 
 using namespace std;
 using namespace boost::multiprecision;
 
-Lookup::Lookup(Mediator& mediator, SyncType syncType) : m_mediator(mediator) {
+Lookup::Lookup(Mediator& mediator, SyncType syncType)
+    : m_mediator(mediator), m_blockResponseCache(LOOKUP_RESPONSE_CACHE_SIZE) {
   m_syncType.store(SyncType::NO_SYNC);
   vector<SyncType> ignorable_syncTypes = {NO_SYNC, RECOVERY_ALL_SYNC, DB_VERIF};
   if (syncType >= SYNC_TYPE_COUNT) {
@@ -70,6 +76,15 @@ Lookup::Lookup(Mediator& mediator, SyncType syncType) : m_mediator(mediator) {
   SetAboveLayer();
   if (LOOKUP_NODE_MODE) {
     SetDSCommitteInfo();
+    m_txnAdmission = make_unique<TxnAdmission>(
+        [this](const vector<Transaction>& txns, vector<bool>& valid) {
+          m_mediator.m_validator->VerifyTransactions(txns, valid);
+        },
+        [this](const Transaction& tx, uint32_t shardId) {
+          AddToTxnShardMap(tx, shardId);
+        },
+        TXN_ADMISSION_SEEN_CAPACITY, TXN_ADMISSION_MAX_QUEUED,
+        TXN_ADMISSION_BATCH_SIZE);
   }
 }
 
@@ -97,54 +112,126 @@ void Lookup::InitAsNewJoiner() {
 
 void Lookup::InitSync() {
   LOG_MARKER();
-  auto func = [this]() -> void {
+  auto step = [this]() -> void {
     uint64_t dsBlockNum = 0;
     uint64_t txBlockNum = 0;
+    if (m_mediator.m_dsBlockChain.GetBlockCount() != 1) {
+      dsBlockNum = m_mediator.m_dsBlockChain.GetBlockCount();
+    }
+    if (m_mediator.m_txBlockChain.GetBlockCount() != 1) {
+      txBlockNum = m_mediator.m_txBlockChain.GetBlockCount();
+    }
+    LOG_GENERAL(INFO,
+                "TxBlockNum " << txBlockNum << " DSBlockNum: " << dsBlockNum);
+    ComposeAndSendGetDirectoryBlocksFromSeed(
+        m_mediator.m_blocklinkchain.GetLatestIndex() + 1);
+    GetTxBlockChunksFromSeedNodes(txBlockNum);
+    SubscribeToBlocksFromSeed();
+  };
 
-    // Hack to allow seed server to be restarted so as to get my newlookup ip
-    // and register me with multiplier.
-    this_thread::sleep_for(chrono::seconds(NEW_LOOKUP_SYNC_DELAY_IN_SECONDS));
+  // Ask for the sharding structure from lookup
+  auto done = [this]() -> void {
+    m_receivedShardStruct = false;
+    RequestUntilAnswered(
+        [this]() { ComposeAndSendGetShardingStructureFromSeed(); },
+        [this]() { return m_receivedShardStruct.load(); }, 1,
+        NEW_LOOKUP_GETSHARD_TIMEOUT_IN_SECONDS, [this](bool received) {
+          if (!received) {
+            LOG_GENERAL(WARNING, "Didn't receive sharding structure!");
+            return;
+          }
+          ProcessEntireShardingStructure();
+        });
+  };
 
-    // Initialize all blockchains and blocklinkchain
-    // InitAsNewJoiner();
+  // Hack to allow seed server to be restarted so as to get my newlookup ip
+  // and register me with multiplier.
+  Scheduler::GetInstance().ScheduleAfter(
+      [this, step, done]() {
+        // Initialize all blockchains and blocklinkchain
+        // InitAsNewJoiner();
 
-    // Set myself offline
-    GetMyLookupOffline();
+        // Set myself offline
+        GetMyLookupOffline();
 
-    while (GetSyncType() != SyncType::NO_SYNC) {
-      if (m_mediator.m_dsBlockChain.GetBlockCount() != 1) {
-        dsBlockNum = m_mediator.m_dsBlockChain.GetBlockCount();
-      }
-      if (m_mediator.m_txBlockChain.GetBlockCount() != 1) {
-        txBlockNum = m_mediator.m_txBlockChain.GetBlockCount();
-      }
-      LOG_GENERAL(INFO,
-                  "TxBlockNum " << txBlockNum << " DSBlockNum: " << dsBlockNum);
-      ComposeAndSendGetDirectoryBlocksFromSeed(
-          m_mediator.m_blocklinkchain.GetLatestIndex() + 1);
-      GetTxBlockFromSeedNodes(txBlockNum, 0);
+        RunWhileSyncing(step, []() { return NEW_NODE_SYNC_INTERVAL; }, done);
+      },
+      NEW_LOOKUP_SYNC_DELAY_IN_SECONDS * 1000);
+}
 
-      this_thread::sleep_for(chrono::seconds(NEW_NODE_SYNC_INTERVAL));
+void Lookup::RunWhileSyncing(
+    const function<void()>& step,
+    const function<unsigned int()>& intervalInSeconds,
+    const function<void()>& done) {
+  Scheduler::GetInstance().ScheduleAfter(
+      [this, step, intervalInSeconds, done]() {
+        RunSyncStep(step, intervalInSeconds, done);
+      },
+      0);
+}
+
+void Lookup::RunSyncStep(const function<void()>& step,
+                         const function<unsigned int()>& intervalInSeconds,
+                         const function<void()>& done) {
+  if (GetSyncType() == SyncType::NO_SYNC) {
+    if (done) {
+      done();
     }
-    // Ask for the sharding structure from lookup
-    ComposeAndSendGetShardingStructureFromSeed();
-    std::unique_lock<std::mutex> cv_lk(m_mutexShardStruct);
-    if (cv_shardStruct.wait_for(
-            cv_lk,
-            std::chrono::seconds(NEW_LOOKUP_GETSHARD_TIMEOUT_IN_SECONDS)) ==
-        std::cv_status::timeout) {
-      LOG_GENERAL(WARNING, "Didn't receive sharding structure!");
-    } else {
-      ProcessEntireShardingStructure();
+    return;
+  }
+
+  step();
+
+  Scheduler::GetInstance().ScheduleAfter(
+      [this, step, intervalInSeconds, done]() {
+        RunSyncStep(step, intervalInSeconds, done);
+      },
+      static_cast<int64_t>(intervalInSeconds()) * 1000);
+}
+
+void Lookup::RequestUntilAnswered(const function<void()>& send,
+                                  const function<bool()>& answered,
+                                  const unsigned int maxTries,
+                                  const unsigned int intervalInSeconds,
+                                  const function<void(bool)>& done) {
+  const unsigned int pollsPerTry =
+      max(intervalInSeconds * 1000 / max(SYNC_POLL_INTERVAL_IN_MS, 1u), 1u);
+  auto request = make_shared<PendingRequest>(
+      PendingRequest{send, answered, maxTries, pollsPerTry, done, 0, 0});
+  Scheduler::GetInstance().ScheduleAfter(
+      [this, request]() { PollRequest(request); }, 0);
+}
+
+void Lookup::PollRequest(const shared_ptr<PendingRequest>& request) {
+  if (request->m_answered()) {
+    if (request->m_done) {
+      request->m_done(true);
     }
-  };
-  DetachedFunction(1, func);
+    return;
+  }
+
+  if (request->m_pollsLeft == 0) {
+    if (request->m_tries >= request->m_maxTries) {
+      if (request->m_done) {
+        request->m_done(false);
+      }
+      return;
+    }
+    request->m_tries++;
+    request->m_pollsLeft = request->m_pollsPerTry;
+    request->m_send();
+  }
+
+  request->m_pollsLeft--;
+  Scheduler::GetInstance().ScheduleAfter(
+      [this, request]() { PollRequest(request); }, SYNC_POLL_INTERVAL_IN_MS);
 }
 
 void Lookup::SetLookupNodes(const VectorOfNode& lookupNodes) {
   // Only used for random testing
   m_lookupNodes = lookupNodes;
   m_lookupNodesStatic = lookupNodes;
+  m_lookupNodesStaticIndex.Rebuild(m_lookupNodesStatic);
 }
 
 void Lookup::SetLookupNodes() {
@@ -192,6 +279,8 @@ void Lookup::SetLookupNodes() {
           string url = v.second.get<string>("hostname");
           if (!url.empty()) {
             lookup_node.SetHostname(url);
+            DNSCache::GetInstance().Prefetch(url,
+                                             lookup_node.GetListenPortHost());
           }
         }
         if (lookupType == "node.multipliers") {
@@ -217,6 +306,7 @@ void Lookup::SetLookupNodes() {
   }
 
   m_lookupNodesStatic = m_lookupNodes;
+  m_lookupNodesStaticIndex.Rebuild(m_lookupNodesStatic);
 }
 
 void Lookup::SetAboveLayer() {
@@ -240,6 +330,7 @@ void Lookup::SetAboveLayer() {
       string url = v.second.get<string>("hostname");
       if (!url.empty()) {
         lookup_node.SetHostname(url);
+        DNSCache::GetInstance().Prefetch(url, lookup_node.GetListenPortHost());
       }
       m_seedNodes.emplace_back(pubKey, lookup_node);
     }
@@ -416,20 +507,13 @@ VectorOfNode Lookup::GetLookupNodesStatic() const {
 }
 
 bool Lookup::IsLookupNode(const PubKey& pubKey) const {
-  VectorOfNode lookups = GetLookupNodesStatic();
-  return std::find_if(lookups.begin(), lookups.end(),
-                      [&pubKey](const PairOfNode& node) {
-                        return node.first == pubKey;
-                      }) != lookups.end();
+  lock_guard<mutex> lock(m_mutexLookupNodes);
+  return m_lookupNodesStaticIndex.Contains(m_lookupNodesStatic, pubKey);
 }
 
 bool Lookup::IsLookupNode(const Peer& peerInfo) const {
-  VectorOfNode lookups = GetLookupNodesStatic();
-  return std::find_if(lookups.begin(), lookups.end(),
-                      [&peerInfo](const PairOfNode& node) {
-                        return node.second.GetIpAddress() ==
-                               peerInfo.GetIpAddress();
-                      }) != lookups.end();
+  lock_guard<mutex> lock(m_mutexLookupNodes);
+  return m_lookupNodesStaticIndex.Contains(m_lookupNodesStatic, peerInfo);
 }
 
 uint128_t Lookup::TryGettingResolvedIP(const Peer& peer) const {
@@ -438,10 +522,12 @@ uint128_t Lookup::TryGettingResolvedIP(const Peer& peer) const {
   auto resolved_ip = peer.GetIpAddress();  // existing one
   if (!url.empty()) {
     boost::multiprecision::uint128_t tmpIp;
-    if (IPConverter::ResolveDNS(url, peer.GetListenPortHost(), tmpIp)) {
+    // Never block the sender on the resolver, a miss is resolved in the
+    // background and served from the cache next time
+    if (DNSCache::GetInstance().Get(url, peer.GetListenPortHost(), tmpIp)) {
       resolved_ip = tmpIp;  // resolved one
     } else {
-      LOG_GENERAL(WARNING, "Unable to resolve DNS for " << url);
+      LOG_GENERAL(INFO, "DNS for " << url << " not resolved yet");
     }
   }
 
@@ -571,7 +657,7 @@ bytes Lookup::ComposeGetDSInfoMessage(bool initialDS) {
   return getDSNodesMessage;
 }
 
-bytes Lookup::ComposeGetStateMessage() {
+bytes Lookup::ComposeGetStateMessage(uint32_t chunkIndex, uint32_t numChunks) {
   LOG_MARKER();
 
   bytes getStateMessage = {MessageType::LOOKUP,
@@ -579,7 +665,7 @@ bytes Lookup::ComposeGetStateMessage() {
 
   if (!Messenger::SetLookupGetStateFromSeed(
           getStateMessage, MessageOffset::BODY,
-          m_mediator.m_selfPeer.m_listenPortHost)) {
+          m_mediator.m_selfPeer.m_listenPortHost, chunkIndex, numChunks)) {
     LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
               "Messenger::SetLookupGetStateFromSeed failed.");
     return {};
@@ -601,7 +687,120 @@ bool Lookup::GetDSInfoFromLookupNodes(bool initialDS) {
 }
 
 bool Lookup::GetStateFromSeedNodes() {
-  SendMessageToRandomSeedNode(ComposeGetStateMessage());
+  if (STATE_SYNC_NUM_CHUNKS <= 1) {
+    SendMessageToRandomSeedNode(ComposeGetStateMessage(0, 0));
+    return true;
+  }
+
+  unsigned int round;
+  {
+    lock_guard<mutex> g(m_mutexSetState);
+    // The chunks are added on top of each other, so start from an empty state
+    AccountStore::GetInstance().Init();
+    m_stateChunksReceived.clear();
+    m_stateChunksRoot = dev::h256();
+    m_staleStateRoots.clear();
+    round = ++m_stateSyncRound;
+  }
+
+  // Asks again for the chunks that have not arrived, keeping those applied
+  RequestUntilAnswered(
+      [this, round]() {
+        lock_guard<mutex> g(m_mutexSetState);
+        if (round != m_stateSyncRound) {
+          return;
+        }
+        LOG_GENERAL(INFO, "Received " << m_stateChunksReceived.size() << " of "
+                                      << STATE_SYNC_NUM_CHUNKS
+                                      << " state chunks, asking for the rest");
+        RequestMissingStateChunks();
+      },
+      [this, round]() {
+        lock_guard<mutex> g(m_mutexSetState);
+        return round != m_stateSyncRound || AlreadyJoinedNetwork();
+      },
+      STATE_SYNC_CHUNK_RETRIES + 1, STATE_SYNC_CHUNK_TIMEOUT_IN_SECONDS);
+
+  return true;
+}
+
+void Lookup::RequestMissingStateChunks() {
+  // Each chunk goes to a randomly picked seed, spreading out the download
+  for (uint32_t i = 0; i < STATE_SYNC_NUM_CHUNKS; i++) {
+    if (m_stateChunksReceived.find(i) == m_stateChunksReceived.end()) {
+      SendMessageToRandomSeedNode(
+          ComposeGetStateMessage(i, STATE_SYNC_NUM_CHUNKS));
+    }
+  }
+}
+
+bool Lookup::ProcessStateChunk(const bytes& accountStoreBytes,
+                               const uint32_t chunkIndex,
+                               const uint32_t numChunks,
+                               const dev::h256& stateRoot, bool& complete) {
+  complete = false;
+
+  if (numChunks != STATE_SYNC_NUM_CHUNKS || chunkIndex >= numChunks) {
+    LOG_GENERAL(WARNING, "Unexpected state chunk " << chunkIndex << " of "
+                                                   << numChunks);
+    return false;
+  }
+
+  if (m_staleStateRoots.find(stateRoot) != m_staleStateRoots.end()) {
+    LOG_GENERAL(INFO, "Dropped state chunk " << chunkIndex
+                                             << " of stale state root "
+                                             << stateRoot);
+    return true;
+  }
+
+  bool restarted = false;
+  if (m_stateChunksReceived.empty()) {
+    m_stateChunksRoot = stateRoot;
+  } else if (stateRoot != m_stateChunksRoot) {
+    // The seeds have moved on to a new state since the first chunks, which
+    // cannot be combined with the rest
+    LOG_GENERAL(INFO, "State root changed from " << m_stateChunksRoot << " to "
+                                                 << stateRoot
+                                                 << ", restarting state sync");
+    m_staleStateRoots.emplace(m_stateChunksRoot);
+    AccountStore::GetInstance().Init();
+    m_stateChunksReceived.clear();
+    m_stateChunksRoot = stateRoot;
+    restarted = true;
+  }
+
+  // Retries can bring the same chunk twice
+  if (m_stateChunksReceived.find(chunkIndex) == m_stateChunksReceived.end()) {
+    if (!AccountStore::GetInstance().DeserializeChunk(accountStoreBytes, 0)) {
+      LOG_GENERAL(WARNING, "Deserialize AccountStore chunk " << chunkIndex
+                                                             << " failed");
+      return false;
+    }
+    m_stateChunksReceived.emplace(chunkIndex);
+  }
+
+  if (restarted) {
+    RequestMissingStateChunks();
+  }
+
+  if (m_stateChunksReceived.size() < numChunks) {
+    return true;
+  }
+
+  if (AccountStore::GetInstance().GetStateRootHash() != m_stateChunksRoot) {
+    LOG_GENERAL(WARNING, "State chunks do not add up to state root "
+                             << m_stateChunksRoot << ", restarting state sync");
+    AccountStore::GetInstance().Init();
+    m_stateChunksReceived.clear();
+    RequestMissingStateChunks();
+    return false;
+  }
+
+  LOG_GENERAL(INFO, "Applied all " << numChunks << " state chunks");
+  m_stateChunksReceived.clear();
+  // Stops the retries of this sync
+  m_stateSyncRound++;
+  complete = true;
   return true;
 }
 
@@ -723,6 +922,129 @@ bool Lookup::GetTxBlockFromSeedNodes(uint64_t lowBlockNum,
   return true;
 }
 
+bool Lookup::GetTxBlockChunksFromSeedNodes(uint64_t lowBlockNum) {
+  LOG_MARKER();
+
+  // Without a tx block of its own yet, the node starts wherever the seed says
+  if (BLOCK_SYNC_NUM_PARALLEL <= 1 || BLOCK_SYNC_CHUNK_SIZE == 0 ||
+      lowBlockNum <= 1) {
+    return GetTxBlockFromSeedNodes(lowBlockNum, 0);
+  }
+
+  RequestTxBlockChunks(lowBlockNum);
+
+  return true;
+}
+
+void Lookup::RequestTxBlockChunks(uint64_t lowBlockNum) {
+  vector<Peer> seeds;
+  {
+    lock_guard<mutex> lock(m_mutexSeedNodes);
+    for (const auto& seed : m_seedNodes) {
+      seeds.emplace_back(TryGettingResolvedIP(seed.second),
+                         seed.second.GetListenPortHost());
+    }
+  }
+
+  if (seeds.empty()) {
+    LOG_GENERAL(WARNING, "Seed nodes are empty");
+    return;
+  }
+
+  lock_guard<mutex> g(m_mutexTxBlockSync);
+
+  const auto now = chrono::steady_clock::now();
+  for (auto it = m_txBlockSyncRequests.begin();
+       it != m_txBlockSyncRequests.end();) {
+    if (it->first < lowBlockNum) {
+      it = m_txBlockSyncRequests.erase(it);
+    } else if (now - it->second.m_sentTime >
+               chrono::seconds(BLOCK_SYNC_CHUNK_TIMEOUT_IN_SECONDS)) {
+      LOG_GENERAL(INFO, "Tx blocks from " << it->first << " timed out");
+      auto throughput = m_seedThroughput.find(it->second.m_ipAddress);
+      if (throughput != m_seedThroughput.end()) {
+        throughput->second /= 2;
+      }
+      it = m_txBlockSyncRequests.erase(it);
+    } else {
+      it++;
+    }
+  }
+
+  // Seeds not heard from yet go first so that every seed gets measured
+  stable_sort(seeds.begin(), seeds.end(),
+              [this](const Peer& a, const Peer& b) {
+                auto itA = m_seedThroughput.find(a.m_ipAddress);
+                auto itB = m_seedThroughput.find(b.m_ipAddress);
+                if (itB == m_seedThroughput.end()) {
+                  return false;
+                }
+                if (itA == m_seedThroughput.end()) {
+                  return true;
+                }
+                return itA->second > itB->second;
+              });
+
+  // The first chunk runs up to the next multiple of BLOCK_SYNC_CHUNK_SIZE, so
+  // that chunks line up across rounds
+  unsigned int seedIndex = 0;
+  uint64_t chunkLow = lowBlockNum;
+  for (unsigned int i = 0; i < BLOCK_SYNC_NUM_PARALLEL; i++) {
+    const uint64_t chunkHigh =
+        (chunkLow / BLOCK_SYNC_CHUNK_SIZE + 1) * BLOCK_SYNC_CHUNK_SIZE - 1;
+
+    auto buffered = m_txBlockSyncChunks.upper_bound(chunkLow);
+    const bool isBuffered =
+        buffered != m_txBlockSyncChunks.begin() &&
+        prev(buffered)->second.back().GetHeader().GetBlockNum() >= chunkLow;
+
+    if (!isBuffered && m_txBlockSyncRequests.find(chunkLow) ==
+                           m_txBlockSyncRequests.end()) {
+      const Peer& seed = seeds.at(seedIndex++ % seeds.size());
+      Blacklist::GetInstance().Exclude(seed.m_ipAddress);
+      P2PComm::GetInstance().SendMessage(
+          seed, ComposeGetTxBlockMessage(chunkLow, chunkHigh));
+      m_txBlockSyncRequests[chunkLow] = {seed.m_ipAddress, now};
+    }
+
+    chunkLow = chunkHigh + 1;
+  }
+}
+
+bool Lookup::RecordTxBlockChunk(uint64_t lowBlockNum, uint64_t numBlocks,
+                                const Peer& from) {
+  // Weight of the latest chunk in the smoothed throughput of a seed
+  const double THROUGHPUT_WEIGHT = 0.3;
+
+  lock_guard<mutex> g(m_mutexTxBlockSync);
+
+  auto it = m_txBlockSyncRequests.find(lowBlockNum);
+  if (it == m_txBlockSyncRequests.end() ||
+      it->second.m_ipAddress != from.m_ipAddress) {
+    return false;
+  }
+
+  if (numBlocks > 0) {
+    const double seconds =
+        max(chrono::duration<double>(chrono::steady_clock::now() -
+                                     it->second.m_sentTime)
+                .count(),
+            0.001);
+    const double throughput = numBlocks / seconds;
+    auto entry = m_seedThroughput.emplace(from.m_ipAddress, throughput);
+    if (!entry.second) {
+      entry.first->second = THROUGHPUT_WEIGHT * throughput +
+                            (1 - THROUGHPUT_WEIGHT) * entry.first->second;
+    }
+    LOG_GENERAL(INFO, numBlocks << " tx blocks from " << from << " at "
+                                << entry.first->second << " blocks/s");
+  }
+
+  m_txBlockSyncRequests.erase(it);
+
+  return true;
+}
+
 bool Lookup::GetStateDeltaFromSeedNodes(const uint64_t& blockNum)
 
 {
@@ -750,44 +1072,47 @@ bool Lookup::SetDSCommitteInfo(bool replaceMyPeerWithDefault) {
   ptree pt;
   read_xml("config.xml", pt);
 
-  lock_guard<mutex> g(m_mediator.m_mutexDSCommittee);
+  {
+    lock_guard<mutex> g(m_mediator.m_mutexDSCommittee);
 
-  for (ptree::value_type const& v : pt.get_child("nodes")) {
-    if (v.first == "peer") {
-      bytes pubkeyBytes;
-      if (!DataConversion::HexStrToUint8Vec(v.second.get<string>("pubk"),
-                                            pubkeyBytes)) {
-        continue;
-      }
-      PubKey key(pubkeyBytes, 0);
+    for (ptree::value_type const& v : pt.get_child("nodes")) {
+      if (v.first == "peer") {
+        bytes pubkeyBytes;
+        if (!DataConversion::HexStrToUint8Vec(v.second.get<string>("pubk"),
+                                              pubkeyBytes)) {
+          continue;
+        }
+        PubKey key(pubkeyBytes, 0);
 
-      struct in_addr ip_addr;
-      inet_pton(AF_INET, v.second.get<string>("ip").c_str(), &ip_addr);
-      Peer peer((uint128_t)ip_addr.s_addr, v.second.get<unsigned int>("port"));
+        struct in_addr ip_addr;
+        inet_pton(AF_INET, v.second.get<string>("ip").c_str(), &ip_addr);
+        Peer peer((uint128_t)ip_addr.s_addr,
+                  v.second.get<unsigned int>("port"));
 
-      if (replaceMyPeerWithDefault && (key == m_mediator.m_selfKey.second)) {
-        m_mediator.m_DSCommittee->emplace_back(make_pair(key, Peer()));
-        LOG_GENERAL(INFO, "Added self " << Peer());
-      } else {
-        m_mediator.m_DSCommittee->emplace_back(make_pair(key, peer));
-        LOG_GENERAL(INFO, "Added peer " << peer);
+        if (replaceMyPeerWithDefault && (key == m_mediator.m_selfKey.second)) {
+          m_mediator.m_DSCommittee->emplace_back(make_pair(key, Peer()));
+          LOG_GENERAL(INFO, "Added self " << Peer());
+        } else {
+          m_mediator.m_DSCommittee->emplace_back(make_pair(key, peer));
+          LOG_GENERAL(INFO, "Added peer " << peer);
+        }
       }
     }
   }
+  m_mediator.PublishEpochContext();
 
   return true;
 }
 
-DequeOfShard Lookup::GetShardPeers() {
+ShardingStructurePtr Lookup::GetShardPeers() {
   if (!LOOKUP_NODE_MODE) {
     LOG_GENERAL(WARNING,
                 "Lookup::GetShardPeers not expected to be called from "
                 "other than the LookUp node.");
-    return DequeOfShard();
+    return make_shared<ShardingStructure>(DequeOfShard());
   }
 
-  lock_guard<mutex> g(m_mediator.m_ds->m_mutexShards);
-  return m_mediator.m_ds->m_shards;
+  return m_mediator.m_ds->GetShardingStructure();
 }
 
 vector<Peer> Lookup::GetNodePeers() {
@@ -903,17 +1228,19 @@ bool Lookup::ProcessGetDSInfoFromSeed(const bytes& message, unsigned int offset,
   }
 
   else {
-    lock_guard<mutex> g(m_mediator.m_mutexDSCommittee);
+    // Served from the published committee, so concurrent requests neither
+    // wait on the committee lock nor hold it while signing
+    const auto context = m_mediator.GetEpochContext();
 
-    for (const auto& ds : *m_mediator.m_DSCommittee) {
-      LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
+    for (const auto& ds : *context->m_dsCommittee) {
+      LOG_EPOCH(INFO, context->m_epochNum,
                 "IP:" << ds.second.GetPrintableIPAddress());
     }
 
     if (!Messenger::SetLookupSetDSInfoFromSeed(
             dsInfoMessage, MessageOffset::BODY, m_mediator.m_selfKey,
-            DSCOMMITTEE_VERSION, *m_mediator.m_DSCommittee, false)) {
-      LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+            DSCOMMITTEE_VERSION, *context->m_dsCommittee, false)) {
+      LOG_EPOCH(WARNING, context->m_epochNum,
                 "Messenger::SetLookupSetDSInfoFromSeed failed.");
       return false;
     }
@@ -971,37 +1298,74 @@ bool Lookup::ProcessGetDSBlockFromSeed(const bytes& message,
     return false;
   }
 
+  Peer requestingNode(from.m_ipAddress, portNo);
+
+  // The range a request resolves to only moves with the DS chain tip
+  const string cacheKey =
+      "ds:" + to_string(lowBlockNum) + ':' + to_string(highBlockNum) + ':' +
+      to_string(
+          m_mediator.m_dsBlockChain.GetLastBlock().GetHeader().GetBlockNum());
+  shared_ptr<const bytes> cachedMessage;
+  if (m_blockResponseCache.Get(cacheKey, cachedMessage)) {
+    LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
+              "ProcessGetDSBlockFromSeed requested by "
+                  << from << " for blocks " << lowBlockNum << " to "
+                  << highBlockNum << " served from cache");
+    P2PComm::GetInstance().SendMessage(requestingNode, *cachedMessage);
+    return true;
+  }
+
   vector<DSBlock> dsBlocks;
-  RetrieveDSBlocks(dsBlocks, lowBlockNum, highBlockNum);
+  RetrieveDSBlocks(dsBlocks, lowBlockNum, highBlockNum, false,
+                   LOOKUP_SERVE_MAX_BLOCKS);
   LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
             "ProcessGetDSBlockFromSeed requested by " << from << " for blocks "
                                                       << lowBlockNum << " to "
                                                       << highBlockNum);
 
-  bytes dsBlockMessage = {MessageType::LOOKUP,
-                          LookupInstructionType::SETDSBLOCKFROMSEED};
+  auto dsBlockMessage = make_shared<bytes>(
+      bytes{MessageType::LOOKUP, LookupInstructionType::SETDSBLOCKFROMSEED});
 
   if (!Messenger::SetLookupSetDSBlockFromSeed(
-          dsBlockMessage, MessageOffset::BODY, lowBlockNum, highBlockNum,
+          *dsBlockMessage, MessageOffset::BODY, lowBlockNum, highBlockNum,
           m_mediator.m_selfKey, dsBlocks)) {
     LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
               "Messenger::SetLookupSetDSBlockFromSeed failed.");
     return false;
   }
 
-  Peer requestingNode(from.m_ipAddress, portNo);
+  if (!dsBlocks.empty()) {
+    CacheBlockResponse(cacheKey, dsBlockMessage);
+  }
+
   LOG_GENERAL(INFO, requestingNode);
-  P2PComm::GetInstance().SendMessage(requestingNode, dsBlockMessage);
+  P2PComm::GetInstance().SendMessage(requestingNode, *dsBlockMessage);
 
   return true;
 }
 
+void Lookup::CacheBlockResponse(const string& key,
+                                const shared_ptr<const bytes>& response) {
+  if (response->size() > LOOKUP_RESPONSE_CACHE_MAX_ENTRY_KB * 1024) {
+    return;
+  }
+  m_blockResponseCache.Put(key, response);
+}
+
+void Lookup::LogBlockResponseCacheStats() {
+  LOG_GENERAL(INFO, "Block response cache hits = "
+                        << m_blockResponseCache.GetHits()
+                        << " misses = " << m_blockResponseCache.GetMisses());
+  m_blockResponseCache.ResetStats();
+}
+
 // TODO: Refactor the code to remove the following assumption
 // lowBlockNum = 1 => Latest block number
 // lowBlockNum = 0 => lowBlockNum set to 1
 // highBlockNum = 0 => Latest block number
 void Lookup::RetrieveDSBlocks(vector<DSBlock>& dsBlocks, uint64_t& lowBlockNum,
-                              uint64_t& highBlockNum, bool partialRetrieve) {
+                              uint64_t& highBlockNum, bool partialRetrieve,
+                              uint64_t maxBlocks) {
   lock_guard<mutex> g(m_mediator.m_node->m_mutexDSBlock);
 
   uint64_t curBlockNum =
@@ -1031,6 +1395,11 @@ void Lookup::RetrieveDSBlocks(vector<DSBlock>& dsBlocks, uint64_t& lowBlockNum,
     highBlockNum = curBlockNum;
   }
 
+  if ((maxBlocks > 0) && (highBlockNum >= lowBlockNum) &&
+      (highBlockNum - lowBlockNum >= maxBlocks)) {
+    highBlockNum = lowBlockNum + maxBlocks - 1;
+  }
+
   uint64_t blockNum;
   for (blockNum = lowBlockNum; blockNum <= highBlockNum; blockNum++) {
     try {
@@ -1072,8 +1441,11 @@ bool Lookup::ProcessGetStateFromSeed(const bytes& message, unsigned int offset,
   LOG_MARKER();
 
   uint32_t portNo = 0;
+  uint32_t chunkIndex = 0;
+  uint32_t numChunks = 0;
 
-  if (!Messenger::GetLookupGetStateFromSeed(message, offset, portNo)) {
+  if (!Messenger::GetLookupGetStateFromSeed(message, offset, portNo,
+                                            chunkIndex, numChunks)) {
     LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
               "Messenger::GetLookupGetStateFromSeed failed.");
     return false;
@@ -1085,7 +1457,7 @@ bool Lookup::ProcessGetStateFromSeed(const bytes& message, unsigned int offset,
 
   if (!Messenger::SetLookupSetStateFromSeed(
           setStateMessage, MessageOffset::BODY, m_mediator.m_selfKey,
-          AccountStore::GetInstance())) {
+          AccountStore::GetInstance(), chunkIndex, numChunks)) {
     LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
               "Messenger::SetLookupSetStateFromSeed failed.");
     return false;
@@ -1122,26 +1494,50 @@ bool Lookup::ProcessGetTxBlockFromSeed(const bytes& message,
     return false;
   }
 
+  Peer requestingNode(from.m_ipAddress, portNo);
+
+  // The range a request resolves to only moves with the DS and Tx chain tips
+  const string cacheKey =
+      "tx:" + to_string(lowBlockNum) + ':' + to_string(highBlockNum) + ':' +
+      to_string(
+          m_mediator.m_dsBlockChain.GetLastBlock().GetHeader().GetBlockNum()) +
+      ':' +
+      to_string(
+          m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum());
+  shared_ptr<const bytes> cachedMessage;
+  if (m_blockResponseCache.Get(cacheKey, cachedMessage)) {
+    LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
+              "ProcessGetTxBlockFromSeed requested by "
+                  << from << " for blocks " << lowBlockNum << " to "
+                  << highBlockNum << " served from cache");
+    P2PComm::GetInstance().SendMessage(requestingNode, *cachedMessage);
+    return true;
+  }
+
   vector<TxBlock> txBlocks;
-  RetrieveTxBlocks(txBlocks, lowBlockNum, highBlockNum);
+  RetrieveTxBlocks(txBlocks, lowBlockNum, highBlockNum,
+                   LOOKUP_SERVE_MAX_BLOCKS);
 
   LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
             "ProcessGetTxBlockFromSeed requested by " << from << " for blocks "
                                                       << lowBlockNum << " to "
                                                       << highBlockNum);
 
-  bytes txBlockMessage = {MessageType::LOOKUP,
-                          LookupInstructionType::SETTXBLOCKFROMSEED};
+  auto txBlockMessage = make_shared<bytes>(
+      bytes{MessageType::LOOKUP, LookupInstructionType::SETTXBLOCKFROMSEED});
   if (!Messenger::SetLookupSetTxBlockFromSeed(
-          txBlockMessage, MessageOffset::BODY, lowBlockNum, highBlockNum,
+          *txBlockMessage, MessageOffset::BODY, lowBlockNum, highBlockNum,
           m_mediator.m_selfKey, txBlocks)) {
     LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
               "Messenger::SetLookupSetTxBlockFromSeed failed.");
     return false;
   }
 
-  Peer requestingNode(from.m_ipAddress, portNo);
-  P2PComm::GetInstance().SendMessage(requestingNode, txBlockMessage);
+  if (!txBlocks.empty()) {
+    CacheBlockResponse(cacheKey, txBlockMessage);
+  }
+
+  P2PComm::GetInstance().SendMessage(requestingNode, *txBlockMessage);
 
   return true;
 }
@@ -1151,7 +1547,7 @@ bool Lookup::ProcessGetTxBlockFromSeed(const bytes& message,
 // lowBlockNum = 0 => lowBlockNum set to 1
 // highBlockNum = 0 => Latest block number
 void Lookup::RetrieveTxBlocks(vector<TxBlock>& txBlocks, uint64_t& lowBlockNum,
-                              uint64_t& highBlockNum) {
+                              uint64_t& highBlockNum, uint64_t maxBlocks) {
   lock_guard<mutex> g(m_mediator.m_node->m_mutexFinalBlock);
 
   if (lowBlockNum == 0) {
@@ -1183,6 +1579,11 @@ void Lookup::RetrieveTxBlocks(vector<TxBlock>& txBlocks, uint64_t& lowBlockNum,
     return;
   }
 
+  if ((maxBlocks > 0) && (highBlockNum >= lowBlockNum) &&
+      (highBlockNum - lowBlockNum >= maxBlocks)) {
+    highBlockNum = lowBlockNum + maxBlocks - 1;
+  }
+
   uint64_t blockNum;
   for (blockNum = lowBlockNum; blockNum <= highBlockNum; blockNum++) {
     try {
@@ -1295,6 +1696,16 @@ bool Lookup::ProcessGetStateDeltasFromSeed(const bytes& message,
                 << from << " for blocks: " << lowBlockNum << " to "
                 << highBlockNum);
 
+  // The requester applies the deltas of exactly the range it asked for, so
+  // an oversized range is refused rather than cut short
+  if ((LOOKUP_SERVE_MAX_BLOCKS > 0) && (highBlockNum >= lowBlockNum) &&
+      (highBlockNum - lowBlockNum >= LOOKUP_SERVE_MAX_BLOCKS)) {
+    LOG_GENERAL(WARNING, "Refusing " << highBlockNum - lowBlockNum + 1
+                                     << " state deltas, more than "
+                                     << LOOKUP_SERVE_MAX_BLOCKS);
+    return false;
+  }
+
   vector<bytes> stateDeltas;
   for (auto i = lowBlockNum; i <= highBlockNum; i++) {
     bytes stateDelta;
@@ -1303,7 +1714,7 @@ bool Lookup::ProcessGetStateDeltasFromSeed(const bytes& message,
           INFO, "Block Number "
                     << i << " absent. Didn't include it in response message.");
     }
-    stateDeltas.emplace_back(stateDelta);
+    stateDeltas.emplace_back(move(stateDelta));
   }
 
   bytes stateDeltasMessage = {MessageType::LOOKUP,
@@ -1395,8 +1806,9 @@ bool Lookup::ProcessSetShardFromSeed([[gnu::unused]] const bytes& message,
   lock_guard<mutex> g(m_mediator.m_ds->m_mutexShards);
 
   m_mediator.m_ds->m_shards = move(shards);
+  m_mediator.m_ds->PublishShardingStructure();
 
-  cv_shardStruct.notify_all();
+  m_receivedShardStruct = true;
 
   return true;
 }
@@ -1419,7 +1831,8 @@ bool Lookup::GetShardFromLookup() {
   return true;
 }
 
-bool Lookup::AddMicroBlockToStorage(const MicroBlock& microblock) {
+bool Lookup::AddMicroBlockToWrites(const MicroBlock& microblock,
+                                   EpochWrites& writes) {
   TxBlock txblk =
       m_mediator.m_txBlockChain.GetBlock(microblock.GetHeader().GetEpochNum());
   LOG_GENERAL(INFO, "[SendMB]"
@@ -1449,11 +1862,13 @@ bool Lookup::AddMicroBlockToStorage(const MicroBlock& microblock) {
 
   bytes body;
   microblock.Serialize(body, 0);
-  if (!BlockStorage::GetBlockStorage().PutMicroBlock(microblock.GetBlockHash(),
-                                                     body)) {
-    LOG_GENERAL(WARNING, "Failed to put microblock in body");
-    return false;
-  }
+
+  // The txn hashes also go to the index of the Tx block, so that
+  // GetTransactionsForTxBlock need not read back every micro block
+  writes.AddMicroBlock(microblock.GetBlockHash(), body);
+  writes.AddTxBlockTxns(txblk.GetHeader().GetBlockNum(),
+                        txblk.GetMicroBlockInfos().at(i).m_shardId,
+                        microblock.GetBlockHash(), microblock.GetTranHashes());
 
   return true;
 }
@@ -1685,6 +2100,7 @@ bool Lookup::ProcessSetDSInfoFromSeed(const bytes& message, unsigned int offset,
       LOG_GENERAL(INFO, "[DSINFOVERIF] Success");
     }
   }
+  m_mediator.PublishEpochContext();
 
   //    Data::GetInstance().SetDSPeers(dsPeers);
   //#endif // IS_LOOKUP_NODE
@@ -1799,7 +2215,8 @@ bool Lookup::ProcessSetTxBlockFromSeed(const bytes& message,
   //#ifndef IS_LOOKUP_NODE
   LOG_MARKER();
 
-  if (AlreadyJoinedNetwork()) {
+  // A replica goes on taking the blocks pushed to it
+  if (AlreadyJoinedNetwork() && !LOOKUP_REPLICA) {
     cv_setTxBlockFromSeed.notify_all();
     return true;
   }
@@ -1830,6 +2247,8 @@ bool Lookup::ProcessSetTxBlockFromSeed(const bytes& message,
                                                  << lowBlockNum << " to "
                                                  << highBlockNum);
 
+  const bool chunked = RecordTxBlockChunk(lowBlockNum, txBlocks.size(), from);
+
   // Update GetWork Server info for new nodes not in shards
   if (GETWORK_SERVER_MINE) {
     // roughly calc how many seconds to next PoW
@@ -1863,44 +2282,104 @@ bool Lookup::ProcessSetTxBlockFromSeed(const bytes& message,
       m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum() + 1;
 
   if (latestSynBlockNum > highBlockNum) {
-    // TODO: We should get blocks from n nodes.
     LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
               "I already have the block. latestSynBlockNum="
                   << latestSynBlockNum << " highBlockNum=" << highBlockNum);
     return false;
-  } else {
-    auto res = m_mediator.m_validator->CheckTxBlocks(
-        txBlocks, m_mediator.m_blocklinkchain.GetBuiltDSComm(),
-        m_mediator.m_blocklinkchain.GetLatestBlockLink());
-    switch (res) {
-      case ValidatorBase::TxBlockValidationMsg::VALID:
+  }
+
+  if (chunked && lowBlockNum > latestSynBlockNum) {
+    LOG_GENERAL(INFO, "Buffering tx blocks " << lowBlockNum << " to "
+                                             << highBlockNum
+                                             << " until earlier ones arrive");
+    lock_guard<mutex> g(m_mutexTxBlockSync);
+    m_txBlockSyncChunks[lowBlockNum] = move(txBlocks);
+    return true;
+  }
+
+  if (CheckAndCommitTxBlocks(txBlocks) && chunked) {
+    CommitBufferedTxBlockChunks();
+    RequestTxBlockChunks(
+        m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum() +
+        1);
+  }
+
+  return true;
+}
+
+bool Lookup::CheckAndCommitTxBlocks(const vector<TxBlock>& txBlocks) {
+  const uint64_t oldTxBlockNum =
+      m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum();
+
+  auto res = m_mediator.m_validator->CheckTxBlocks(
+      txBlocks, m_mediator.m_blocklinkchain.GetBuiltDSComm(),
+      m_mediator.m_blocklinkchain.GetLatestBlockLink());
+  switch (res) {
+    case ValidatorBase::TxBlockValidationMsg::VALID:
 #ifdef SJ_TEST_SJ_TXNBLKS_PROCESS_SLOW
-        if (LOOKUP_NODE_MODE && ARCHIVAL_LOOKUP) {
-          LOG_GENERAL(INFO,
-                      "Processing txnblks recvd from lookup is slow "
-                      "(SJ_TEST_SJ_TXNBLKS_PROCESS_SLOW)");
-          this_thread::sleep_for(chrono::seconds(10));
-        }
+      if (LOOKUP_NODE_MODE && ARCHIVAL_LOOKUP) {
+        LOG_GENERAL(INFO,
+                    "Processing txnblks recvd from lookup is slow "
+                    "(SJ_TEST_SJ_TXNBLKS_PROCESS_SLOW)");
+        this_thread::sleep_for(chrono::seconds(10));
+      }
 #endif  // SJ_TEST_SJ_TXNBLKS_PROCESS_SLOW
-        CommitTxBlocks(txBlocks);
-        break;
-      case ValidatorBase::TxBlockValidationMsg::INVALID:
-        LOG_GENERAL(INFO, "[TxBlockVerif]"
-                              << "Invalid blocks");
-        break;
-      case ValidatorBase::TxBlockValidationMsg::STALEDSINFO:
-        LOG_GENERAL(INFO, "[TxBlockVerif]"
-                              << "Saved to buffer");
-        m_txBlockBuffer.clear();
-        for (const auto& txBlock : txBlocks) {
-          m_txBlockBuffer.emplace_back(txBlock);
-        }
-        break;
-      default:;
-    }
+      CommitTxBlocks(txBlocks);
+      break;
+    case ValidatorBase::TxBlockValidationMsg::INVALID:
+      LOG_GENERAL(INFO, "[TxBlockVerif]"
+                            << "Invalid blocks");
+      break;
+    case ValidatorBase::TxBlockValidationMsg::STALEDSINFO:
+      LOG_GENERAL(INFO, "[TxBlockVerif]"
+                            << "Saved to buffer");
+      m_txBlockBuffer.clear();
+      for (const auto& txBlock : txBlocks) {
+        m_txBlockBuffer.emplace_back(txBlock);
+      }
+      break;
+    default:;
   }
 
-  return true;
+  return m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum() >
+         oldTxBlockNum;
+}
+
+void Lookup::CommitBufferedTxBlockChunks() {
+  while (true) {
+    const uint64_t nextBlockNum =
+        m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum() + 1;
+    vector<TxBlock> txBlocks;
+    {
+      lock_guard<mutex> g(m_mutexTxBlockSync);
+      auto it = m_txBlockSyncChunks.begin();
+      while (it != m_txBlockSyncChunks.end() &&
+             it->second.back().GetHeader().GetBlockNum() < nextBlockNum) {
+        it = m_txBlockSyncChunks.erase(it);
+      }
+      if (it == m_txBlockSyncChunks.end() || it->first > nextBlockNum) {
+        return;
+      }
+      txBlocks = move(it->second);
+      m_txBlockSyncChunks.erase(it);
+    }
+
+    // Drop the blocks a truncated earlier chunk left this one overlapping
+    txBlocks.erase(txBlocks.begin(),
+                   find_if(txBlocks.begin(), txBlocks.end(),
+                           [nextBlockNum](const TxBlock& txBlock) {
+                             return txBlock.GetHeader().GetBlockNum() >=
+                                    nextBlockNum;
+                           }));
+
+    LOG_GENERAL(INFO, "Committing buffered tx blocks "
+                          << nextBlockNum << " to "
+                          << txBlocks.back().GetHeader().GetBlockNum());
+
+    if (!CheckAndCommitTxBlocks(txBlocks)) {
+      return;
+    }
+  }
 }
 
 bool Lookup::GetDSInfo() {
@@ -1971,8 +2450,20 @@ void Lookup::CommitTxBlocks(const vector<TxBlock>& txBlocks) {
   uint64_t highBlockNum = txBlocks.back().GetHeader().GetBlockNum();
 
   if (m_syncType != SyncType::RECOVERY_ALL_SYNC) {
+    bool applied = false;
+    vector<bytes> stateDeltas;
+    if (TakePrefetchedStateDeltas(lowBlockNum, highBlockNum, stateDeltas)) {
+      LOG_GENERAL(INFO, "Applying prefetched state deltas for blocks "
+                            << lowBlockNum << " to " << highBlockNum);
+      lock_guard<mutex> g(m_mutexSetStateDeltasFromSeed);
+      applied = ApplyStateDeltas(lowBlockNum, highBlockNum, stateDeltas);
+    }
+
+    // Fetch the deltas of the chunks after this one while it is applied
+    PrefetchStateDeltas(highBlockNum + 1);
+
     unsigned int retry = 1;
-    while (retry <= RETRY_GETSTATEDELTAS_COUNT) {
+    while (!applied && retry <= RETRY_GETSTATEDELTAS_COUNT) {
       // Get the state-delta for all txBlocks from random lookup nodes
       GetStateDeltasFromSeedNodes(lowBlockNum, highBlockNum);
       std::unique_lock<std::mutex> cv_lk(m_mutexSetStateDeltaFromSeed);
@@ -1988,7 +2479,7 @@ void Lookup::CommitTxBlocks(const vector<TxBlock>& txBlocks) {
         break;
       }
     }
-    if (retry > RETRY_GETSTATEDELTAS_COUNT) {
+    if (!applied && retry > RETRY_GETSTATEDELTAS_COUNT) {
       LOG_GENERAL(WARNING, "Failed to receive state-deltas for txBlks: "
                                << lowBlockNum << "-" << highBlockNum);
       cv_setTxBlockFromSeed.notify_all();
@@ -2016,6 +2507,8 @@ void Lookup::CommitTxBlocks(const vector<TxBlock>& txBlocks) {
     BlockStorage::GetBlockStorage().PutTxBlock(
         txBlock.GetHeader().GetBlockNum(), serializedTxBlock);
   }
+  BlockStorage::GetBlockStorage().CommitEpoch(
+      txBlocks.back().GetHeader().GetBlockNum());
 
   m_mediator.m_currentEpochNum =
       m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum();
@@ -2118,13 +2611,11 @@ bool Lookup::ProcessSetStateDeltasFromSeed(const bytes& message,
                                            const Peer& from) {
   LOG_MARKER();
 
-  if (AlreadyJoinedNetwork()) {
+  if (AlreadyJoinedNetwork() && !LOOKUP_REPLICA) {
     cv_setStateDeltasFromSeed.notify_all();
     return true;
   }
 
-  unique_lock<mutex> lock(m_mutexSetStateDeltasFromSeed);
-
   uint64_t lowBlockNum = 0;
   uint64_t highBlockNum = 0;
   vector<bytes> stateDeltas;
@@ -2157,6 +2648,24 @@ bool Lookup::ProcessSetStateDeltasFromSeed(const bytes& message,
     return false;
   }
 
+  // Deltas fetched ahead are kept for their own CommitTxBlocks, so that they
+  // do not wait on the ones being applied now
+  if (StorePrefetchedStateDeltas(lowBlockNum, highBlockNum, stateDeltas)) {
+    return true;
+  }
+
+  unique_lock<mutex> lock(m_mutexSetStateDeltasFromSeed);
+
+  if (!ApplyStateDeltas(lowBlockNum, highBlockNum, stateDeltas)) {
+    return false;
+  }
+
+  cv_setStateDeltasFromSeed.notify_all();
+  return true;
+}
+
+bool Lookup::ApplyStateDeltas(uint64_t lowBlockNum, uint64_t highBlockNum,
+                              const vector<bytes>& stateDeltas) {
   int txBlkNum = lowBlockNum;
   bytes tmp;
   for (const auto& delta : stateDeltas) {
@@ -2185,38 +2694,153 @@ bool Lookup::ProcessSetStateDeltasFromSeed(const bytes& message,
     txBlkNum++;
   }
 
-  cv_setStateDeltasFromSeed.notify_all();
   return true;
 }
 
-bool Lookup::ProcessSetStateFromSeed(const bytes& message, unsigned int offset,
-                                     [[gnu::unused]] const Peer& from) {
-  LOG_MARKER();
+void Lookup::PrefetchStateDeltas(uint64_t lowBlockNum) {
+  if (STATE_DELTA_PREFETCH_MAX_BLOCKS == 0) {
+    return;
+  }
 
-  if (AlreadyJoinedNetwork()) {
-    return true;
+  vector<pair<uint64_t, uint64_t>> ranges;
+  {
+    lock(m_mutexTxBlockSync, m_mutexPrefetchedStateDeltas);
+    lock_guard<mutex> g(m_mutexTxBlockSync, adopt_lock);
+    lock_guard<mutex> g2(m_mutexPrefetchedStateDeltas, adopt_lock);
+
+    m_prefetchedStateDeltas.erase(
+        m_prefetchedStateDeltas.begin(),
+        m_prefetchedStateDeltas.lower_bound(lowBlockNum));
+    m_stateDeltaPrefetchRequests.erase(
+        m_stateDeltaPrefetchRequests.begin(),
+        m_stateDeltaPrefetchRequests.lower_bound(lowBlockNum));
+
+    uint64_t numBlocks = m_prefetchedStateDeltas.size();
+    for (const auto& request : m_stateDeltaPrefetchRequests) {
+      numBlocks += request.second - request.first + 1;
+    }
+
+    // Only the buffered tx block chunks are known to follow the current range
+    for (auto it = m_txBlockSyncChunks.lower_bound(lowBlockNum);
+         it != m_txBlockSyncChunks.end(); it++) {
+      const uint64_t chunkLow = it->first;
+      const uint64_t chunkHigh = it->second.back().GetHeader().GetBlockNum();
+      if (m_stateDeltaPrefetchRequests.find(chunkLow) !=
+              m_stateDeltaPrefetchRequests.end() ||
+          m_prefetchedStateDeltas.find(chunkLow) !=
+              m_prefetchedStateDeltas.end()) {
+        continue;
+      }
+      if (numBlocks + chunkHigh - chunkLow + 1 >
+          STATE_DELTA_PREFETCH_MAX_BLOCKS) {
+        break;
+      }
+      numBlocks += chunkHigh - chunkLow + 1;
+      m_stateDeltaPrefetchRequests[chunkLow] = chunkHigh;
+      ranges.emplace_back(chunkLow, chunkHigh);
+    }
   }
 
-  unique_lock<mutex> lock(m_mutexSetState);
-  PubKey lookupPubKey;
-  bytes accountStoreBytes;
-  if (!Messenger::GetLookupSetStateFromSeed(message, offset, lookupPubKey,
-                                            accountStoreBytes)) {
-    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
-              "Messenger::GetLookupSetStateFromSeed failed.");
+  for (const auto& range : ranges) {
+    LOG_GENERAL(INFO, "Prefetching state deltas for blocks "
+                          << range.first << " to " << range.second);
+    SendMessageToRandomSeedNode(
+        ComposeGetStateDeltasMessage(range.first, range.second));
+  }
+}
+
+bool Lookup::StorePrefetchedStateDeltas(uint64_t lowBlockNum,
+                                        uint64_t highBlockNum,
+                                        vector<bytes>& stateDeltas) {
+  lock_guard<mutex> g(m_mutexPrefetchedStateDeltas);
+
+  auto it = m_stateDeltaPrefetchRequests.find(lowBlockNum);
+  if (it == m_stateDeltaPrefetchRequests.end() ||
+      it->second != highBlockNum) {
     return false;
   }
+  m_stateDeltaPrefetchRequests.erase(it);
 
-  if (!VerifySenderNode(GetSeedNodes(), lookupPubKey)) {
-    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+  uint64_t blockNum = lowBlockNum;
+  for (auto& delta : stateDeltas) {
+    m_prefetchedStateDeltas[blockNum++] = move(delta);
+  }
+
+  return true;
+}
+
+bool Lookup::TakePrefetchedStateDeltas(uint64_t lowBlockNum,
+                                       uint64_t highBlockNum,
+                                       vector<bytes>& stateDeltas) {
+  lock_guard<mutex> g(m_mutexPrefetchedStateDeltas);
+
+  // Whatever is still in flight for this range is fetched again the usual way
+  m_stateDeltaPrefetchRequests.erase(lowBlockNum);
+
+  auto begin = m_prefetchedStateDeltas.find(lowBlockNum);
+  auto end = m_prefetchedStateDeltas.upper_bound(highBlockNum);
+  if (begin == m_prefetchedStateDeltas.end() ||
+      static_cast<uint64_t>(distance(begin, end)) !=
+          highBlockNum - lowBlockNum + 1) {
+    return false;
+  }
+
+  stateDeltas.clear();
+  for (auto it = begin; it != end; it++) {
+    stateDeltas.emplace_back(move(it->second));
+  }
+  m_prefetchedStateDeltas.erase(begin, end);
+
+  return true;
+}
+
+bool Lookup::ProcessSetStateFromSeed(const bytes& message, unsigned int offset,
+                                     [[gnu::unused]] const Peer& from) {
+  LOG_MARKER();
+
+  if (AlreadyJoinedNetwork()) {
+    return true;
+  }
+
+  unique_lock<mutex> lock(m_mutexSetState);
+  PubKey lookupPubKey;
+  bytes accountStoreBytes;
+  uint32_t chunkIndex = 0;
+  uint32_t numChunks = 0;
+  dev::h256 stateRoot;
+  if (!Messenger::GetLookupSetStateFromSeed(message, offset, lookupPubKey,
+                                            accountStoreBytes, chunkIndex,
+                                            numChunks, stateRoot)) {
+    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+              "Messenger::GetLookupSetStateFromSeed failed.");
+    return false;
+  }
+
+  if (!VerifySenderNode(GetSeedNodes(), lookupPubKey)) {
+    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
               "The message sender pubkey: "
                   << lookupPubKey << " is not in my lookup node list.");
     return false;
   }
 
-  if (!AccountStore::GetInstance().Deserialize(accountStoreBytes, 0)) {
-    LOG_GENERAL(WARNING, "Deserialize AccountStore Failed");
-    return false;
+  if (numChunks == 0) {
+    if (!AccountStore::GetInstance().Deserialize(accountStoreBytes, 0)) {
+      LOG_GENERAL(WARNING, "Deserialize AccountStore Failed");
+      return false;
+    }
+    // A seed that does not chunk sends the whole state, ending any chunked
+    // sync in progress
+    m_stateSyncRound++;
+  } else {
+    bool complete = false;
+    if (!ProcessStateChunk(accountStoreBytes, chunkIndex, numChunks, stateRoot,
+                           complete)) {
+      return false;
+    }
+    // The rest of the sync waits for the last chunk
+    if (!complete) {
+      return true;
+    }
   }
 
   if (!LOOKUP_NODE_MODE) {
@@ -2784,22 +3408,150 @@ bool Lookup::ProcessRaiseStartPoW(const bytes& message, unsigned int offset,
   LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
             "Threads running ProcessGetStartPoWFromSeed notified to start PoW");
 
-  // Sleep for a while, then let all remaining threads running
-  // ProcessGetStartPoWFromSeed know that it's too late to do PoW Sleep time =
+  // After a while, let all remaining threads running
+  // ProcessGetStartPoWFromSeed know that it's too late to do PoW. Wait time =
   // time it takes for new node to try getting DSInfo + actual PoW window
-  this_thread::sleep_for(
-      chrono::seconds(NEW_NODE_SYNC_INTERVAL + POW_WINDOW_IN_SECONDS +
-                      POWPACKETSUBMISSION_WINDOW_IN_SECONDS));
-  m_receivedRaiseStartPoW.store(false);
-  cv_startPoWSubmission.notify_all();
+  Scheduler::GetInstance().ScheduleAfter(
+      [this]() {
+        m_receivedRaiseStartPoW.store(false);
+        cv_startPoWSubmission.notify_all();
 
-  LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
-            "Threads running ProcessGetStartPoWFromSeed notified it's too "
-            "late to start PoW");
+        LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
+                  "Threads running ProcessGetStartPoWFromSeed notified it's "
+                  "too late to start PoW");
+      },
+      static_cast<int64_t>(NEW_NODE_SYNC_INTERVAL + POW_WINDOW_IN_SECONDS +
+                           POWPACKETSUBMISSION_WINDOW_IN_SECONDS) *
+          1000);
+
+  return true;
+}
+
+bool Lookup::RelayPoWSubmission(const bytes& message, unsigned int offset,
+                                const Peer& from) {
+  LOG_MARKER();
+
+  if (!LOOKUP_NODE_MODE) {
+    LOG_GENERAL(WARNING,
+                "Lookup::RelayPoWSubmission not expected to be called from "
+                "other than the LookUp node.");
+    return true;
+  }
+
+  uint64_t blockNumber;
+  uint8_t difficultyLevel;
+  Peer submitterPeer;
+  PubKey submitterKey;
+  uint64_t nonce;
+  string resultingHash;
+  string mixHash;
+  uint32_t lookupId;
+  uint128_t gasPrice;
+  Signature signature;
+  // Also checks the signature of the submitter, which the DS nodes take as
+  // checked once the packet is signed by a lookup
+  if (!Messenger::GetDSPoWSubmission(message, offset, blockNumber,
+                                     difficultyLevel, submitterPeer,
+                                     submitterKey, nonce, resultingHash,
+                                     mixHash, signature, lookupId, gasPrice)) {
+    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+              "Messenger::GetDSPoWSubmission failed.");
+    return false;
+  }
+
+  if (from.GetIpAddress() != submitterPeer.GetIpAddress()) {
+    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+              "The sender ip adress " << from.GetPrintableIPAddress()
+                                      << " not match with address in message "
+                                      << submitterPeer.GetPrintableIPAddress());
+    return false;
+  }
+
+  if (resultingHash.size() != 64 || mixHash.size() != 64) {
+    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+              "Wrong hash size submitted by "
+                  << submitterPeer.GetPrintableIPAddress());
+    return false;
+  }
+
+  if (blockNumber <=
+      m_mediator.m_dsBlockChain.GetLastBlock().GetHeader().GetBlockNum()) {
+    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+              "PoW submitted for stale DS block " << blockNumber);
+    return false;
+  }
+
+  lock_guard<mutex> g(m_mutexPoWRelay);
+
+  if (blockNumber != m_powRelayBlockNum) {
+    m_powRelayBlockNum = blockNumber;
+    m_powRelaySeen.clear();
+    m_powRelayCounts.clear();
+  }
+
+  if (!m_powRelaySeen.emplace(submitterKey, nonce).second) {
+    return true;
+  }
+  if (m_powRelayCounts[submitterKey]++ >= POW_SUBMISSION_LIMIT) {
+    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+              "Node " << submitterKey
+                      << " submitted pow count already reach limit");
+    return false;
+  }
+
+  m_powRelaySolutions.emplace_back(blockNumber, difficultyLevel, submitterPeer,
+                                   submitterKey, nonce, resultingHash, mixHash,
+                                   lookupId, gasPrice, signature);
+
+  if (m_powRelaySolutions.size() >= POW_RELAY_BATCH_SIZE) {
+    DetachedFunction(DetachedFunction::Lane::BLOCKING, 1,
+                     [this]() { FlushPoWRelay(); });
+  } else if (!m_powRelayFlushScheduled) {
+    m_powRelayFlushScheduled = true;
+    Scheduler::GetInstance().ScheduleAfter(
+        [this]() { FlushPoWRelay(); },
+        static_cast<int64_t>(POW_RELAY_INTERVAL_IN_SECONDS) * 1000);
+  }
 
   return true;
 }
 
+void Lookup::FlushPoWRelay() {
+  LOG_MARKER();
+
+  vector<DSPowSolution> solutions;
+  {
+    lock_guard<mutex> g(m_mutexPoWRelay);
+    solutions.swap(m_powRelaySolutions);
+    m_powRelayFlushScheduled = false;
+  }
+
+  if (solutions.empty()) {
+    return;
+  }
+
+  bytes packet = {MessageType::DIRECTORY,
+                  DSInstructionType::POWPACKETSUBMISSION};
+  if (!Messenger::SetDSPoWPacketSubmission(packet, MessageOffset::BODY,
+                                           solutions, m_mediator.m_selfKey)) {
+    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+              "Messenger::SetDSPoWPacketSubmission failed.");
+    return;
+  }
+
+  vector<Peer> peerList;
+  {
+    lock_guard<mutex> g(m_mediator.m_mutexDSCommittee);
+    for (const auto& i : *m_mediator.m_DSCommittee) {
+      peerList.push_back(i.second);
+    }
+  }
+
+  LOG_GENERAL(INFO, "Relaying " << solutions.size() << " PoW submissions to "
+                                << peerList.size() << " DS nodes");
+  P2PComm::GetInstance().SendMessage(peerList, packet);
+}
+
 bool Lookup::ProcessGetStartPoWFromSeed(const bytes& message,
                                         unsigned int offset, const Peer& from) {
   LOG_MARKER();
@@ -2926,20 +3678,20 @@ void Lookup::StartSynchronization() {
 
   this->CleanVariables();
 
-  auto func = [this]() -> void {
-    GetMyLookupOffline();
-    GetDSInfoFromLookupNodes();
-    while (GetSyncType() != SyncType::NO_SYNC) {
-      GetDSBlockFromLookupNodes(m_mediator.m_dsBlockChain.GetBlockCount(), 0);
-      GetTxBlockFromLookupNodes(m_mediator.m_txBlockChain.GetBlockCount(), 0);
-      this_thread::sleep_for(chrono::seconds(NEW_NODE_SYNC_INTERVAL));
-    }
-  };
-  DetachedFunction(1, func);
+  GetMyLookupOffline();
+  GetDSInfoFromLookupNodes();
+  RunWhileSyncing(
+      [this]() {
+        TRACE_SPAN("Sync", m_mediator.m_currentEpochNum);
+        GetDSBlockFromLookupNodes(m_mediator.m_dsBlockChain.GetBlockCount(),
+                                  0);
+        GetTxBlockFromLookupNodes(m_mediator.m_txBlockChain.GetBlockCount(),
+                                  0);
+      },
+      []() { return NEW_NODE_SYNC_INTERVAL; });
 }
 
 bool Lookup::GetDSInfoLoop() {
-  unsigned int counter = 0;
   {
     lock_guard<mutex> g(m_mediator.m_mutexDSCommittee);
     if (m_mediator.m_DSCommittee->size() > 0) {
@@ -2949,30 +3701,20 @@ bool Lookup::GetDSInfoLoop() {
     }
   }
 
-  while (counter <= FETCH_LOOKUP_MSG_MAX_RETRY) {
-    GetDSInfoFromSeedNodes();
-    unique_lock<mutex> lk(m_mutexDSInfoUpdation);
-    if (cv_dsInfoUpdate.wait_for(lk, chrono::seconds(NEW_NODE_SYNC_INTERVAL)) ==
-        cv_status::timeout) {
-      counter++;
-
-    } else {
-      break;
-    }
-  }
-  {
-    lock_guard<mutex> g(m_mediator.m_mutexDSCommittee);
-    if (m_mediator.m_DSCommittee->size() > 0) {
-      return true;
-    } else {
-      LOG_GENERAL(WARNING, "ds committee still unset");
-      return false;
-    }
-  }
-
-  LOG_GENERAL(WARNING, "Exceeded max tries " << counter << "/"
-                                             << FETCH_LOOKUP_MSG_MAX_RETRY);
-  return false;
+  RequestUntilAnswered(
+      [this]() { GetDSInfoFromSeedNodes(); },
+      [this]() {
+        lock_guard<mutex> g(m_mediator.m_mutexDSCommittee);
+        return m_mediator.m_DSCommittee->size() > 0;
+      },
+      FETCH_LOOKUP_MSG_MAX_RETRY + 1, NEW_NODE_SYNC_INTERVAL,
+      [](bool received) {
+        if (!received) {
+          LOG_GENERAL(WARNING, "ds committee still unset, exceeded max tries "
+                                   << FETCH_LOOKUP_MSG_MAX_RETRY);
+        }
+      });
+  return true;
 }
 
 bytes Lookup::ComposeGetLookupOfflineMessage() {
@@ -3131,6 +3873,12 @@ bool Lookup::FinishRejoinAsLookup() {
     return true;
   }
 
+  // A replica is not one of the lookups, so it has nothing to announce
+  if (LOOKUP_REPLICA) {
+    StartReplicaFollowing();
+    return true;
+  }
+
   return GetMyLookupOnline();
 }
 
@@ -3160,6 +3908,7 @@ bool Lookup::CleanVariables() {
   {
     std::lock_guard<mutex> lock(m_mediator.m_ds->m_mutexShards);
     m_mediator.m_ds->m_shards.clear();
+    m_mediator.m_ds->PublishShardingStructure();
   }
   {
     std::lock_guard<mutex> lock(m_mutexNodesInNetwork);
@@ -3178,7 +3927,9 @@ bool Lookup::ToBlockMessage(unsigned char ins_byte) {
     return true;
   }
 
-  return m_syncType != SyncType::NO_SYNC &&
+  // A replica takes no part in syncing or dispatch, so it only ever takes
+  // what it is sent
+  return (m_syncType != SyncType::NO_SYNC || LOOKUP_REPLICA) &&
          (ins_byte != LookupInstructionType::SETDSBLOCKFROMSEED &&
           ins_byte != LookupInstructionType::SETDSINFOFROMSEED &&
           ins_byte != LookupInstructionType::SETTXBLOCKFROMSEED &&
@@ -3187,7 +3938,8 @@ bool Lookup::ToBlockMessage(unsigned char ins_byte) {
           ins_byte != LookupInstructionType::SETLOOKUPONLINE &&
           ins_byte != LookupInstructionType::SETSTATEDELTAFROMSEED &&
           ins_byte != LookupInstructionType::SETSTATEDELTASFROMSEED &&
-          ins_byte != LookupInstructionType::SETDIRBLOCKSFROMSEED);
+          ins_byte != LookupInstructionType::SETDIRBLOCKSFROMSEED &&
+          ins_byte != LookupInstructionType::SETMICROBLOCKTXNSFROMLOOKUP);
 }
 
 bytes Lookup::ComposeGetOfflineLookupNodes() {
@@ -3510,7 +4262,10 @@ bool Lookup::Execute(const bytes& message, unsigned int offset,
       &Lookup::ProcessVCGetLatestDSTxBlockFromSeed,
       &Lookup::ProcessForwardTxn,
       &Lookup::ProcessGetDSGuardNetworkInfo,
-      &Lookup::ProcessSetHistoricalDB};
+      &Lookup::ProcessSetHistoricalDB,
+      &Lookup::ProcessSubscribeBlocks,
+      &Lookup::ProcessGetMicroBlockTxnsFromLookup,
+      &Lookup::ProcessSetMicroBlockTxnsFromLookup};
 
   const unsigned char ins_byte = message.at(offset);
   const unsigned int ins_handlers_count =
@@ -3555,6 +4310,18 @@ bool Lookup::AddToTxnShardMap(const Transaction& tx, uint32_t shardId) {
   return true;
 }
 
+TxnAdmission::Result Lookup::AdmitTxn(const Transaction& tx,
+                                     uint32_t shardId) {
+  if (!LOOKUP_NODE_MODE) {
+    LOG_GENERAL(WARNING,
+                "Lookup::AdmitTxn not expected to be called from "
+                "other than the LookUp node.");
+    return TxnAdmission::BUSY;
+  }
+
+  return m_txnAdmission->Admit(tx, shardId);
+}
+
 bool Lookup::DeleteTxnShardMap(uint32_t shardId) {
   if (!LOOKUP_NODE_MODE) {
     LOG_GENERAL(WARNING,
@@ -3570,6 +4337,68 @@ bool Lookup::DeleteTxnShardMap(uint32_t shardId) {
   return true;
 }
 
+void Lookup::TakeTxnShardMap(uint32_t shardId, vector<Transaction>& txns) {
+  txns.clear();
+
+  lock_guard<mutex> g(m_txnShardMapMutex);
+
+  auto it = m_txnShardMap.find(shardId);
+  if (it != m_txnShardMap.end()) {
+    txns.swap(it->second);
+  }
+}
+
+void Lookup::RestoreTxnShardMap(uint32_t shardId, vector<Transaction>& txns) {
+  if (txns.empty()) {
+    return;
+  }
+
+  lock_guard<mutex> g(m_txnShardMapMutex);
+
+  auto& pending = m_txnShardMap[shardId];
+  txns.insert(txns.end(), make_move_iterator(pending.begin()),
+              make_move_iterator(pending.end()));
+  pending.swap(txns);
+  txns.clear();
+}
+
+void Lookup::AddToDispatchedTxns(const vector<Transaction>& txns) {
+  lock_guard<mutex> g(m_mutexDispatchedTxns);
+
+  const uint64_t epochNum = m_mediator.m_currentEpochNum;
+
+  auto& hashes = m_dispatchedTxnsByEpoch[epochNum];
+  for (const auto& txn : txns) {
+    if (m_dispatchedTxns.emplace(txn.GetTranID(), txn).second) {
+      hashes.emplace_back(txn.GetTranID());
+    }
+  }
+
+  // Txns are picked up within an epoch or two of dispatch, older ones can
+  // still be fetched from the shard as missing txns
+  while (!m_dispatchedTxnsByEpoch.empty() &&
+         m_dispatchedTxnsByEpoch.begin()->first +
+                 COMPACT_MBNFORWARD_CACHE_EPOCHS <=
+             epochNum) {
+    for (const auto& hash : m_dispatchedTxnsByEpoch.begin()->second) {
+      m_dispatchedTxns.erase(hash);
+    }
+    m_dispatchedTxnsByEpoch.erase(m_dispatchedTxnsByEpoch.begin());
+  }
+}
+
+bool Lookup::GetDispatchedTxn(const TxnHash& txnHash, Transaction& txn) {
+  lock_guard<mutex> g(m_mutexDispatchedTxns);
+
+  auto it = m_dispatchedTxns.find(txnHash);
+  if (it == m_dispatchedTxns.end()) {
+    return false;
+  }
+
+  txn = it->second;
+  return true;
+}
+
 void Lookup::SenderTxnBatchThread() {
   if (!LOOKUP_NODE_MODE) {
     LOG_GENERAL(WARNING,
@@ -3627,103 +4456,122 @@ void Lookup::SendTxnPacketToNodes(uint32_t numShards) {
   this_thread::sleep_for(
       chrono::milliseconds(LOOKUP_DELAY_SEND_TXNPACKET_IN_MS));
 
+  // The packets are independent, so they are built and sent side by side to
+  // keep the last shards from missing TX_DISTRIBUTE_TIME_IN_MS
   for (unsigned int i = 0; i < numShards + 1; i++) {
-    bytes msg = {MessageType::NODE, NodeInstructionType::FORWARDTXNPACKET};
-    bool result = false;
+    mp[i];
+  }
+  atomic<unsigned int> next{0};
 
-    {
-      lock_guard<mutex> g(m_txnShardMapMutex);
-      auto transactionNumber = mp[i].size();
+  auto worker = [&]() -> void {
+    for (unsigned int i = next++; i < numShards + 1; i = next++) {
+      SendTxnPacketToShard(i, numShards, mp.at(i));
+    }
+  };
+
+  {
+    JoinableFunction joinableFunc(
+        max(1U, min(thread::hardware_concurrency(), numShards + 1)), worker);
+  }
+}
 
-      LOG_GENERAL(INFO, "Txn number generated: " << transactionNumber);
+void Lookup::SendTxnPacketToShard(uint32_t shardId, uint32_t numShards,
+                                  const vector<Transaction>& genTxns) {
+  bytes msg = {MessageType::NODE, NodeInstructionType::FORWARDTXNPACKET};
 
-      if (m_txnShardMap[i].empty() && mp[i].empty()) {
-        LOG_GENERAL(INFO, "No txns to send to shard " << i);
-        continue;
-      }
+  // Txns submitted while the packet is built and sent queue up for the next
+  vector<Transaction> txns;
+  TakeTxnShardMap(shardId, txns);
+
+  auto transactionNumber = genTxns.size();
+
+  LOG_GENERAL(INFO, "Txn number generated: " << transactionNumber);
 
-      result = Messenger::SetNodeForwardTxnBlock(
+  if (txns.empty() && genTxns.empty()) {
+    LOG_GENERAL(INFO, "No txns to send to shard " << shardId);
+    return;
+  }
+
+  if (!Messenger::SetNodeForwardTxnBlock(
           msg, MessageOffset::BODY, m_mediator.m_currentEpochNum,
-          m_mediator.m_dsBlockChain.GetLastBlock().GetHeader().GetBlockNum(), i,
-          m_mediator.m_selfKey, m_txnShardMap[i], mp[i]);
-    }
+          m_mediator.m_dsBlockChain.GetLastBlock().GetHeader().GetBlockNum(),
+          shardId, m_mediator.m_selfKey, txns, genTxns)) {
+    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+              "Messenger::SetNodeForwardTxnBlock failed.");
+    LOG_GENERAL(WARNING, "Cannot create packet for " << shardId << " shard");
+    RestoreTxnShardMap(shardId, txns);
+    return;
+  }
 
-    if (!result) {
-      LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
-                "Messenger::SetNodeForwardTxnBlock failed.");
-      LOG_GENERAL(WARNING, "Cannot create packet for " << i << " shard");
-      continue;
-    }
-    vector<Peer> toSend;
-    if (i < numShards) {
-      {
-        lock_guard<mutex> g(m_mediator.m_ds->m_mutexShards);
-        uint16_t lastBlockHash = DataConversion::charArrTo16Bits(
-            m_mediator.m_txBlockChain.GetLastBlock().GetBlockHash().asBytes());
-        uint32_t leader_id = m_mediator.m_node->CalculateShardLeaderFromShard(
-            lastBlockHash, m_mediator.m_ds->m_shards.at(i).size(),
-            m_mediator.m_ds->m_shards.at(i));
-        LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
-                  "Shard leader id " << leader_id);
-
-        auto it = m_mediator.m_ds->m_shards.at(i).begin();
-        // Lookup sends to NUM_NODES_TO_SEND_LOOKUP + Leader
-        unsigned int num_node_to_send = NUM_NODES_TO_SEND_LOOKUP;
-        for (unsigned int j = 0; j < num_node_to_send &&
-                                 it != m_mediator.m_ds->m_shards.at(i).end();
-             j++, it++) {
-          if (distance(m_mediator.m_ds->m_shards.at(i).begin(), it) ==
-              leader_id) {
-            num_node_to_send++;
-          } else {
-            toSend.push_back(std::get<SHARD_NODE_PEER>(*it));
-            LOG_GENERAL(INFO, "Sent to node " << get<SHARD_NODE_PEER>(*it));
-          }
-        }
-        if (m_mediator.m_ds->m_shards.at(i).empty()) {
-          continue;
+  if (ENABLE_COMPACT_MBNFORWARD) {
+    AddToDispatchedTxns(txns);
+    AddToDispatchedTxns(genTxns);
+  }
+  vector<Peer> toSend;
+  if (shardId < numShards) {
+    {
+      lock_guard<mutex> g(m_mediator.m_ds->m_mutexShards);
+      const auto& shard = m_mediator.m_ds->m_shards.at(shardId);
+      uint16_t lastBlockHash = DataConversion::charArrTo16Bits(
+          m_mediator.m_txBlockChain.GetLastBlock().GetBlockHash().asBytes());
+      uint32_t leader_id = m_mediator.m_node->CalculateShardLeaderFromShard(
+          lastBlockHash, shard.size(), shard);
+      LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
+                "Shard leader id " << leader_id);
+
+      auto it = shard.begin();
+      // Lookup sends to NUM_NODES_TO_SEND_LOOKUP + Leader
+      unsigned int num_node_to_send = NUM_NODES_TO_SEND_LOOKUP;
+      for (unsigned int j = 0; j < num_node_to_send && it != shard.end();
+           j++, it++) {
+        if (distance(shard.begin(), it) == leader_id) {
+          num_node_to_send++;
+        } else {
+          toSend.push_back(std::get<SHARD_NODE_PEER>(*it));
+          LOG_GENERAL(INFO, "Sent to node " << get<SHARD_NODE_PEER>(*it));
         }
       }
+      if (shard.empty()) {
+        RestoreTxnShardMap(shardId, txns);
+        return;
+      }
+    }
 
-      P2PComm::GetInstance().SendBroadcastMessage(toSend, msg);
+    P2PComm::GetInstance().SendBroadcastMessage(toSend, msg);
+  } else if (shardId == numShards) {
+    // To send DS
+    {
+      lock_guard<mutex> g(m_mediator.m_mutexDSCommittee);
 
-      DeleteTxnShardMap(i);
-    } else if (i == numShards) {
-      // To send DS
-      {
-        lock_guard<mutex> g(m_mediator.m_mutexDSCommittee);
+      if (m_mediator.m_DSCommittee->empty()) {
+        RestoreTxnShardMap(shardId, txns);
+        return;
+      }
 
-        if (m_mediator.m_DSCommittee->empty()) {
-          continue;
-        }
+      // Send to NUM_NODES_TO_SEND_LOOKUP which including DS leader
+      PairOfNode dsLeader;
+      if (Node::GetDSLeader(m_mediator.m_blocklinkchain.GetLatestBlockLink(),
+                            m_mediator.m_dsBlockChain.GetLastBlock(),
+                            *m_mediator.m_DSCommittee, dsLeader)) {
+        toSend.push_back(dsLeader.second);
+      }
 
-        // Send to NUM_NODES_TO_SEND_LOOKUP which including DS leader
-        PairOfNode dsLeader;
-        if (Node::GetDSLeader(m_mediator.m_blocklinkchain.GetLatestBlockLink(),
-                              m_mediator.m_dsBlockChain.GetLastBlock(),
-                              *m_mediator.m_DSCommittee, dsLeader)) {
-          toSend.push_back(dsLeader.second);
+      for (auto const& i : *m_mediator.m_DSCommittee) {
+        if (toSend.size() < NUM_NODES_TO_SEND_LOOKUP &&
+            i.second != dsLeader.second) {
+          toSend.push_back(i.second);
         }
 
-        for (auto const& i : *m_mediator.m_DSCommittee) {
-          if (toSend.size() < NUM_NODES_TO_SEND_LOOKUP &&
-              i.second != dsLeader.second) {
-            toSend.push_back(i.second);
-          }
-
-          if (toSend.size() >= NUM_NODES_TO_SEND_LOOKUP) {
-            break;
-          }
+        if (toSend.size() >= NUM_NODES_TO_SEND_LOOKUP) {
+          break;
         }
       }
+    }
 
-      P2PComm::GetInstance().SendBroadcastMessage(toSend, msg);
-
-      LOG_GENERAL(INFO, "[DSMB]"
-                            << " Sent DS the txns");
+    P2PComm::GetInstance().SendBroadcastMessage(toSend, msg);
 
-      DeleteTxnShardMap(i);
-    }
+    LOG_GENERAL(INFO, "[DSMB]"
+                          << " Sent DS the txns");
   }
 }
 
@@ -3972,3 +4820,352 @@ bool Lookup::ProcessSetHistoricalDB(const bytes& message, unsigned int offset,
   LOG_GENERAL(INFO, "HistDB Success");
   return true;
 }
+
+bool Lookup::ProcessSubscribeBlocks(const bytes& message, unsigned int offset,
+                                    const Peer& from) {
+  if (!LOOKUP_NODE_MODE) {
+    LOG_GENERAL(WARNING,
+                "Lookup::ProcessSubscribeBlocks not expected to be called from "
+                "other than the LookUp node.");
+    return true;
+  }
+
+  LOG_MARKER();
+
+  uint64_t nextBlockNum = 0;
+  uint32_t portNo = 0;
+
+  if (!Messenger::GetLookupSubscribeBlocks(message, offset, nextBlockNum,
+                                           portNo)) {
+    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+              "Messenger::GetLookupSubscribeBlocks failed.");
+    return false;
+  }
+
+  Peer subscriber(from.m_ipAddress, portNo);
+  const auto now = chrono::steady_clock::now();
+
+  lock_guard<mutex> g(m_mutexBlockSubscribers);
+
+  for (auto it = m_blockSubscribers.begin(); it != m_blockSubscribers.end();) {
+    if (it->second.m_expiry < now) {
+      it = m_blockSubscribers.erase(it);
+    } else {
+      it++;
+    }
+  }
+
+  if (m_blockSubscribers.find(subscriber) == m_blockSubscribers.end() &&
+      m_blockSubscribers.size() >= MAX_BLOCK_SUBSCRIBERS) {
+    LOG_GENERAL(WARNING, "Too many block subscribers, ignoring " << subscriber);
+    return false;
+  }
+
+  BlockSubscription& subscription = m_blockSubscribers[subscriber];
+  subscription.m_nextBlockNum = nextBlockNum;
+  subscription.m_expiry =
+      now + chrono::seconds(BLOCK_SUBSCRIPTION_TIMEOUT_IN_SECONDS);
+
+  LOG_GENERAL(INFO,
+              subscriber << " subscribed to tx blocks from " << nextBlockNum);
+
+  return true;
+}
+
+void Lookup::SubscribeToBlocksFromSeed() {
+  LOG_MARKER();
+
+  // State deltas are not applied in this mode, so pushed ones would be wrong
+  if (m_syncType == SyncType::RECOVERY_ALL_SYNC) {
+    return;
+  }
+
+  bytes subscribeMessage = {MessageType::LOOKUP,
+                            LookupInstructionType::SUBSCRIBEBLOCKS};
+
+  if (!Messenger::SetLookupSubscribeBlocks(
+          subscribeMessage, MessageOffset::BODY,
+          m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum() +
+              1,
+          m_mediator.m_selfPeer.m_listenPortHost)) {
+    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+              "Messenger::SetLookupSubscribeBlocks failed.");
+    return;
+  }
+
+  SendMessageToRandomSeedNode(subscribeMessage);
+}
+
+void Lookup::StartReplicaFollowing() {
+  if (!LOOKUP_REPLICA || m_replicaFollowing.exchange(true)) {
+    return;
+  }
+
+  LOG_MARKER();
+
+  auto func = [this]() -> void {
+    uint64_t lastBlockNum =
+        m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum();
+    m_microBlockTxnsFrom = lastBlockNum + 1;
+    while (true) {
+      this_thread::sleep_for(chrono::seconds(NEW_NODE_SYNC_INTERVAL));
+
+      const uint64_t blockNum =
+          m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum();
+      if (blockNum == lastBlockNum) {
+        // A pushed block was missed, or needs a new DS committee to verify,
+        // and the subscription waits on it
+        LOG_GENERAL(INFO, "No tx block pushed since " << blockNum
+                                                      << ", fetching");
+        ComposeAndSendGetDirectoryBlocksFromSeed(
+            m_mediator.m_blocklinkchain.GetLatestIndex() + 1);
+        GetTxBlockChunksFromSeedNodes(blockNum + 1);
+      }
+      lastBlockNum = blockNum;
+
+      SubscribeToBlocksFromSeed();
+      FetchMicroBlockTxnsFromSeed();
+    }
+  };
+  DetachedFunction(DetachedFunction::Lane::BLOCKING, 1, func);
+}
+
+bool Lookup::ProcessGetMicroBlockTxnsFromLookup(const bytes& message,
+                                                unsigned int offset,
+                                                const Peer& from) {
+  if (!LOOKUP_NODE_MODE) {
+    LOG_GENERAL(WARNING,
+                "Lookup::ProcessGetMicroBlockTxnsFromLookup not expected to be "
+                "called from other than the LookUp node.");
+    return true;
+  }
+
+  LOG_MARKER();
+
+  vector<pair<uint64_t, uint32_t>> microBlocks;
+  uint32_t portNo = 0;
+
+  if (!Messenger::GetLookupGetMicroBlockTxnsFromLookup(message, offset,
+                                                       microBlocks, portNo)) {
+    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+              "Messenger::GetLookupGetMicroBlockTxnsFromLookup failed.");
+    return false;
+  }
+
+  // The requester asks again for what it still lacks
+  if (microBlocks.size() > MICROBLOCK_TXNS_PER_REQUEST) {
+    microBlocks.resize(MICROBLOCK_TXNS_PER_REQUEST);
+  }
+
+  // Each record is sent as it is stored, one read per micro block
+  vector<bytes> records;
+  for (const auto& microBlock : microBlocks) {
+    bytes record;
+    if (BlockStorage::GetBlockStorage().GetMicroBlockTxns(
+            microBlock.first, microBlock.second, record)) {
+      records.emplace_back(move(record));
+    }
+  }
+
+  LOG_GENERAL(INFO, "Sending " << records.size() << " of "
+                               << microBlocks.size()
+                               << " micro blocks with txns to " << from);
+
+  if (records.empty()) {
+    return true;
+  }
+
+  bytes recordsMessage = {MessageType::LOOKUP,
+                          LookupInstructionType::SETMICROBLOCKTXNSFROMLOOKUP};
+  if (!Messenger::SetLookupSetMicroBlockTxnsFromLookup(
+          recordsMessage, MessageOffset::BODY, records)) {
+    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+              "Messenger::SetLookupSetMicroBlockTxnsFromLookup failed.");
+    return false;
+  }
+
+  P2PComm::GetInstance().SendMessage(Peer(from.m_ipAddress, portNo),
+                                     recordsMessage);
+  return true;
+}
+
+bool Lookup::ProcessSetMicroBlockTxnsFromLookup(const bytes& message,
+                                                unsigned int offset,
+                                                const Peer& from) {
+  if (!LOOKUP_NODE_MODE) {
+    LOG_GENERAL(WARNING,
+                "Lookup::ProcessSetMicroBlockTxnsFromLookup not expected to be "
+                "called from other than the LookUp node.");
+    return true;
+  }
+
+  LOG_MARKER();
+
+  vector<bytes> records;
+  if (!Messenger::GetLookupSetMicroBlockTxnsFromLookup(message, offset,
+                                                       records)) {
+    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+              "Messenger::GetLookupSetMicroBlockTxnsFromLookup failed.");
+    return false;
+  }
+
+  bool result = true;
+  for (const auto& record : records) {
+    bytes microBlock;
+    vector<bytes> txBodies;
+    if (!BlockStorage::UnpackMicroBlockTxns(record, microBlock, txBodies)) {
+      LOG_GENERAL(WARNING, "Malformed micro block txns record from " << from);
+      result = false;
+      continue;
+    }
+
+    MBnForwardedTxnEntry entry;
+    if (!entry.m_microBlock.Deserialize(microBlock, 0)) {
+      LOG_GENERAL(WARNING, "Failed to deserialize micro block from " << from);
+      result = false;
+      continue;
+    }
+    entry.m_transactions.reserve(txBodies.size());
+    bool deserialized = true;
+    for (const auto& body : txBodies) {
+      entry.m_transactions.emplace_back();
+      if (!entry.m_transactions.back().Deserialize(body, 0)) {
+        deserialized = false;
+        break;
+      }
+    }
+    if (!deserialized) {
+      LOG_GENERAL(WARNING, "Failed to deserialize txn bodies of micro block "
+                               << entry.m_microBlock.GetBlockHash());
+      result = false;
+      continue;
+    }
+
+    result = m_mediator.m_node->CommitFetchedMicroBlockTxns(entry) && result;
+  }
+
+  return result;
+}
+
+void Lookup::FetchMicroBlockTxnsFromSeed() {
+  const uint64_t lastBlockNum =
+      m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum();
+  const size_t maxMicroBlocks =
+      static_cast<size_t>(MICROBLOCK_TXNS_PER_REQUEST) *
+      MICROBLOCK_TXNS_REQUESTS_PER_ROUND;
+
+  // Only the leading blocks with every micro block stored are skipped next
+  // time, the others are looked at again until their answers are in
+  vector<pair<uint64_t, uint32_t>> missing;
+  bool allStored = true;
+  for (uint64_t blockNum = m_microBlockTxnsFrom;
+       blockNum <= lastBlockNum && missing.size() < maxMicroBlocks;
+       blockNum++) {
+    TxBlockSharedPtr txBlock;
+    TxBlockTxns stored;
+    if (!BlockStorage::GetBlockStorage().GetTxBlock(blockNum, txBlock) ||
+        !BlockStorage::GetBlockStorage().GetTxBlockTxns(blockNum, stored)) {
+      break;
+    }
+
+    for (const auto& info : txBlock->GetMicroBlockInfos()) {
+      // Empty micro blocks are not forwarded, so no lookup stores them
+      if (info.m_txnRootHash == TxnHash() ||
+          stored.find(info.m_shardId) != stored.end()) {
+        continue;
+      }
+      missing.emplace_back(blockNum, info.m_shardId);
+    }
+
+    if (allStored && missing.empty()) {
+      m_microBlockTxnsFrom = blockNum + 1;
+    } else {
+      allStored = false;
+    }
+  }
+
+  if (missing.empty()) {
+    return;
+  }
+
+  LOG_GENERAL(INFO, "Fetching the txns of " << missing.size()
+                                            << " micro blocks from "
+                                            << m_microBlockTxnsFrom);
+
+  // The requests go out together, each to its own random seed node, so their
+  // reads and transfers overlap
+  const unsigned int perRequest = max(MICROBLOCK_TXNS_PER_REQUEST, 1u);
+  for (size_t i = 0; i < missing.size(); i += perRequest) {
+    const vector<pair<uint64_t, uint32_t>> microBlocks(
+        missing.begin() + i,
+        missing.begin() + min(missing.size(), i + perRequest));
+
+    bytes requestMessage = {MessageType::LOOKUP,
+                            LookupInstructionType::GETMICROBLOCKTXNSFROMLOOKUP};
+    if (!Messenger::SetLookupGetMicroBlockTxnsFromLookup(
+            requestMessage, MessageOffset::BODY, microBlocks,
+            m_mediator.m_selfPeer.m_listenPortHost)) {
+      LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+                "Messenger::SetLookupGetMicroBlockTxnsFromLookup failed.");
+      return;
+    }
+    SendMessageToRandomSeedNode(requestMessage);
+  }
+}
+
+void Lookup::PushTxBlockToSubscribers(const TxBlock& txBlock,
+                                      const bytes& stateDelta) {
+  const uint64_t blockNum = txBlock.GetHeader().GetBlockNum();
+
+  // Subscribers that are behind catch up by asking for blocks, so only those
+  // expecting this very block get it and the state delta applied in order
+  vector<Peer> subscribers;
+  {
+    lock_guard<mutex> g(m_mutexBlockSubscribers);
+    const auto now = chrono::steady_clock::now();
+    for (auto it = m_blockSubscribers.begin();
+         it != m_blockSubscribers.end();) {
+      if (it->second.m_expiry < now) {
+        it = m_blockSubscribers.erase(it);
+        continue;
+      }
+      if (it->second.m_nextBlockNum == blockNum) {
+        subscribers.emplace_back(it->first);
+        it->second.m_nextBlockNum++;
+      }
+      it++;
+    }
+  }
+
+  if (subscribers.empty()) {
+    return;
+  }
+
+  bytes txBlockMessage = {MessageType::LOOKUP,
+                          LookupInstructionType::SETTXBLOCKFROMSEED};
+  if (!Messenger::SetLookupSetTxBlockFromSeed(
+          txBlockMessage, MessageOffset::BODY, blockNum, blockNum,
+          m_mediator.m_selfKey, vector<TxBlock>{txBlock})) {
+    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+              "Messenger::SetLookupSetTxBlockFromSeed failed.");
+    return;
+  }
+
+  bytes stateDeltaMessage = {MessageType::LOOKUP,
+                             LookupInstructionType::SETSTATEDELTASFROMSEED};
+  if (!Messenger::SetLookupSetStateDeltasFromSeed(
+          stateDeltaMessage, MessageOffset::BODY, blockNum, blockNum,
+          m_mediator.m_selfKey, vector<bytes>{stateDelta})) {
+    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+              "Messenger::SetLookupSetStateDeltasFromSeed failed.");
+    return;
+  }
+
+  LOG_GENERAL(INFO, "Pushing tx block " << blockNum << " to "
+                                        << subscribers.size()
+                                        << " subscribers");
+
+  // The block goes first so that its state delta wakes up the commit
+  P2PComm::GetInstance().SendMessage(subscribers, txBlockMessage);
+  P2PComm::GetInstance().SendMessage(subscribers, stateDeltaMessage);
+}
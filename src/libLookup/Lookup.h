@@ -22,8 +22,13 @@
 #include <chrono>
 #include <condition_variable>
 #include <cstdlib>
+#include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -33,9 +38,14 @@
 #include "libData/BlockData/Block/DSBlock.h"
 #include "libData/BlockData/Block/MicroBlock.h"
 #include "libData/BlockData/Block/TxBlock.h"
+#include "libData/MiningData/DSPowSolution.h"
+#include "libLookup/TxnAdmission.h"
+#include "libNetwork/NodeIndex.h"
 #include "libNetwork/Peer.h"
 #include "libNetwork/ShardStruct.h"
+#include "libNetwork/ShardingStructure.h"
 #include "libUtils/IPConverter.h"
+#include "libUtils/LRUCache.h"
 #include "libUtils/Logger.h"
 
 #include <condition_variable>
@@ -43,6 +53,7 @@
 #include <mutex>
 #include <vector>
 
+class EpochWrites;
 class Mediator;
 class Synchronizer;
 
@@ -66,6 +77,8 @@ class Lookup : public Executable {
   // m_lookupNodesStatic is the fixed copy of m_lookupNodes after loading from
   // constants.xml.
   VectorOfNode m_lookupNodesStatic;
+  // Index of m_lookupNodesStatic, guarded by m_mutexLookupNodes
+  mutable NodeIndex m_lookupNodesStaticIndex;
 
   // To ensure that the confirm of DS node rejoin won't be later than
   // It receiving a new DS block
@@ -88,6 +101,18 @@ class Lookup : public Executable {
   std::mutex m_MutexCVStartPoWSubmission;
   std::condition_variable cv_startPoWSubmission;
 
+  // PoW submissions relayed to the DS committee, if POW_SUBMISSION_RELAY.
+  // The seen pairs and counts are kept for the DS block being mined.
+  std::mutex m_mutexPoWRelay;
+  uint64_t m_powRelayBlockNum = 0;
+  std::vector<DSPowSolution> m_powRelaySolutions;
+  std::set<std::pair<PubKey, uint64_t>> m_powRelaySeen;
+  std::map<PubKey, unsigned int> m_powRelayCounts;
+  bool m_powRelayFlushScheduled = false;
+
+  /// Sends the buffered PoW submissions to the DS committee in one packet
+  void FlushPoWRelay();
+
   // Store the StateRootHash of latest txBlock before States are repopulated.
   StateHash m_prevStateRootHashTemp;
 
@@ -118,22 +143,130 @@ class Lookup : public Executable {
   std::mutex m_mutexSetStateDeltaFromSeed;
   std::mutex m_mutexSetTxBodyFromSeed;
   std::mutex m_mutexSetState;
+
+  // Chunked state sync of a new joiner, guarded by m_mutexSetState
+  std::set<uint32_t> m_stateChunksReceived;
+  dev::h256 m_stateChunksRoot;
+  std::set<dev::h256> m_staleStateRoots;
+  unsigned int m_stateSyncRound = 0;
+
+  /// Asks random seed nodes for each state chunk not yet received
+  void RequestMissingStateChunks();
+
+  /// Applies one state chunk; complete is set once all the chunks are applied
+  /// and add up to the state root they were cut from
+  bool ProcessStateChunk(const bytes& accountStoreBytes,
+                         const uint32_t chunkIndex, const uint32_t numChunks,
+                         const dev::h256& stateRoot, bool& complete);
   std::mutex mutable m_mutexLookupNodes;
   std::mutex m_mutexCheckDirBlocks;
   std::mutex m_mutexMicroBlocksBuffer;
 
-  std::mutex m_mutexShardStruct;
-  std::condition_variable cv_shardStruct;
+  /// Set once the sharding structure asked for by InitSync is received
+  std::atomic<bool> m_receivedShardStruct{false};
+
+  /// Whether StartReplicaFollowing has started its thread
+  std::atomic<bool> m_replicaFollowing{false};
+
+  /// The first tx block whose micro block txns are not all stored yet, as
+  /// far as FetchMicroBlockTxnsFromSeed knows
+  uint64_t m_microBlockTxnsFrom{0};
+
+  /// A request sent again until answered, polled on the scheduler
+  struct PendingRequest {
+    std::function<void()> m_send;
+    std::function<bool()> m_answered;
+    unsigned int m_maxTries;
+    unsigned int m_pollsPerTry;
+    std::function<void(bool)> m_done;
+    unsigned int m_tries;
+    unsigned int m_pollsLeft;
+  };
+
+  void PollRequest(const std::shared_ptr<PendingRequest>& request);
+  void RunSyncStep(const std::function<void()>& step,
+                   const std::function<unsigned int()>& intervalInSeconds,
+                   const std::function<void()>& done);
 
   // Get StateDeltas from seed
   std::mutex m_mutexSetStateDeltasFromSeed;
   std::condition_variable cv_setStateDeltasFromSeed;
 
+  // State deltas fetched ahead of the tx blocks they belong to, by block
+  // number, and the ranges asked for, by low block number. Bounded by
+  // STATE_DELTA_PREFETCH_MAX_BLOCKS.
+  std::mutex m_mutexPrefetchedStateDeltas;
+  std::map<uint64_t, bytes> m_prefetchedStateDeltas;
+  std::map<uint64_t, uint64_t> m_stateDeltaPrefetchRequests;
+
+  /// Applies the state deltas of the given blocks, in order
+  bool ApplyStateDeltas(uint64_t lowBlockNum, uint64_t highBlockNum,
+                        const std::vector<bytes>& stateDeltas);
+
+  /// Asks for the state deltas of the buffered tx block chunks from
+  /// lowBlockNum on, up to STATE_DELTA_PREFETCH_MAX_BLOCKS blocks
+  void PrefetchStateDeltas(uint64_t lowBlockNum);
+
+  /// Keeps the state deltas if they answer a prefetch. Returns false if they
+  /// were not prefetched.
+  bool StorePrefetchedStateDeltas(uint64_t lowBlockNum, uint64_t highBlockNum,
+                                  std::vector<bytes>& stateDeltas);
+
+  /// Moves out the prefetched state deltas of the given blocks, if they are
+  /// all there
+  bool TakePrefetchedStateDeltas(uint64_t lowBlockNum, uint64_t highBlockNum,
+                                 std::vector<bytes>& stateDeltas);
+
   // TxBlockBuffer
   std::vector<TxBlock> m_txBlockBuffer;
 
+  // Parallel tx block sync of a new or rejoining node, guarded by
+  // m_mutexTxBlockSync
+  struct TxBlockSyncRequest {
+    boost::multiprecision::uint128_t m_ipAddress;
+    std::chrono::steady_clock::time_point m_sentTime;
+  };
+  std::mutex m_mutexTxBlockSync;
+  std::map<uint64_t, TxBlockSyncRequest> m_txBlockSyncRequests;
+  std::map<uint64_t, std::vector<TxBlock>> m_txBlockSyncChunks;
+  // Smoothed blocks per second received from each seed node
+  std::map<boost::multiprecision::uint128_t, double> m_seedThroughput;
+
+  /// Asks seed nodes, fastest first, for the chunks of BLOCK_SYNC_CHUNK_SIZE
+  /// tx blocks from lowBlockNum on that are neither buffered nor in flight
+  void RequestTxBlockChunks(uint64_t lowBlockNum);
+
+  /// Updates the throughput of the seed node that answered a chunk request.
+  /// Returns false if the blocks were not asked for as a chunk.
+  bool RecordTxBlockChunk(uint64_t lowBlockNum, uint64_t numBlocks,
+                          const Peer& from);
+
+  /// Validates and commits the tx blocks, buffering them if the DS info is
+  /// not there yet. Returns true if they were committed.
+  bool CheckAndCommitTxBlocks(const std::vector<TxBlock>& txBlocks);
+
+  /// Commits the buffered chunks that now follow on from the chain tip
+  void CommitBufferedTxBlockChunks();
+
+  // New join nodes that have new tx blocks pushed to them, with the block
+  // each expects next and when its subscription lapses
+  struct BlockSubscription {
+    uint64_t m_nextBlockNum;
+    std::chrono::steady_clock::time_point m_expiry;
+  };
+  std::mutex m_mutexBlockSubscribers;
+  std::unordered_map<Peer, BlockSubscription> m_blockSubscribers;
+
+  // Txns dispatched to the shards in the last COMPACT_MBNFORWARD_CACHE_EPOCHS
+  // epochs, used to rebuild compact microblock forwards
+  std::mutex m_mutexDispatchedTxns;
+  std::unordered_map<TxnHash, Transaction> m_dispatchedTxns;
+  std::map<uint64_t, std::vector<TxnHash>> m_dispatchedTxnsByEpoch;
+
+  void AddToDispatchedTxns(const std::vector<Transaction>& txns);
+
   bytes ComposeGetDSInfoMessage(bool initialDS = false);
-  bytes ComposeGetStateMessage();
+  bytes ComposeGetStateMessage(uint32_t chunkIndex, uint32_t numChunks);
 
   bytes ComposeGetDSBlockMessage(uint64_t lowBlockNum, uint64_t highBlockNum);
   bytes ComposeGetTxBlockMessage(uint64_t lowBlockNum, uint64_t highBlockNum);
@@ -148,10 +281,22 @@ class Lookup : public Executable {
 
   void ComposeAndSendGetShardingStructureFromSeed();
 
+  /// A maxBlocks other than 0 lowers highBlockNum so that no more blocks
+  /// than that are retrieved; the requester asks for the rest next time
   void RetrieveDSBlocks(std::vector<DSBlock>& dsBlocks, uint64_t& lowBlockNum,
-                        uint64_t& highBlockNum, bool partialRetrieve = false);
+                        uint64_t& highBlockNum, bool partialRetrieve = false,
+                        uint64_t maxBlocks = 0);
   void RetrieveTxBlocks(std::vector<TxBlock>& txBlocks, uint64_t& lowBlockNum,
-                        uint64_t& highBlockNum);
+                        uint64_t& highBlockNum, uint64_t maxBlocks = 0);
+
+  // Signed DS and Tx block range responses, keyed by the request and the
+  // chain tips it was answered at. Syncing nodes mostly ask for the same
+  // recent ranges, which are then sent without fetching and serializing the
+  // blocks again.
+  LRUCache<std::string, std::shared_ptr<const bytes>> m_blockResponseCache;
+
+  void CacheBlockResponse(const std::string& key,
+                          const std::shared_ptr<const bytes>& response);
 
  public:
   /// Constructor.
@@ -163,6 +308,24 @@ class Lookup : public Executable {
   /// Sync new lookup node.
   void InitSync();
 
+  /// Runs step on the scheduler, and again every intervalInSeconds() seconds
+  /// while the node syncs, then runs done. Takes the place of a thread that
+  /// sleeps between the steps, so that the sync flows share the threads of
+  /// the scheduler and their fetches proceed side by side.
+  void RunWhileSyncing(const std::function<void()>& step,
+                       const std::function<unsigned int()>& intervalInSeconds,
+                       const std::function<void()>& done = nullptr);
+
+  /// Runs send on the scheduler until answered() holds, at most maxTries
+  /// times and intervalInSeconds apart, then runs done with whether it was
+  /// answered. answered() is polled every SYNC_POLL_INTERVAL_IN_MS, in place
+  /// of a thread waiting on a condition variable for the reply.
+  void RequestUntilAnswered(const std::function<void()>& send,
+                            const std::function<bool()>& answered,
+                            const unsigned int maxTries,
+                            const unsigned int intervalInSeconds,
+                            const std::function<void(bool)>& done = nullptr);
+
   // Setting the lookup nodes
   // Hardcoded for now -- to be called by constructor
   void SetLookupNodes();
@@ -180,9 +343,14 @@ class Lookup : public Executable {
   // Getter for m_seedNodes
   VectorOfNode GetSeedNodes() const;
 
+  void LogBlockResponseCacheStats();
+
   std::mutex m_txnShardMapMutex;
   std::map<uint32_t, std::vector<Transaction>> m_txnShardMap;
 
+  /// Checks the submitted txns on their way to m_txnShardMap
+  std::unique_ptr<TxnAdmission> m_txnAdmission;
+
   bool IsLookupNode(const PubKey& pubKey) const;
 
   bool IsLookupNode(const Peer& peerInfo) const;
@@ -213,11 +381,16 @@ class Lookup : public Executable {
   // TODO: move the Get and ProcessSet functions to Synchronizer
   std::vector<Peer> GetAboveLayer();
   bool GetDSInfoFromSeedNodes();
+  /// Asks the seed nodes for the DS committee until it is set, on the
+  /// scheduler. Returns false if it is already set.
   bool GetDSInfoLoop();
   bool GetDSInfoFromLookupNodes(bool initialDS = false);
   bool GetDSBlockFromLookupNodes(uint64_t lowBlockNum, uint64_t highBlockNum);
   bool GetTxBlockFromLookupNodes(uint64_t lowBlockNum, uint64_t highBlockNum);
   bool GetTxBlockFromSeedNodes(uint64_t lowBlockNum, uint64_t highBlockNum);
+  /// Fetches the tx blocks from lowBlockNum to the latest one, in chunks
+  /// spread over several seed nodes if BLOCK_SYNC_NUM_PARALLEL is above 1
+  bool GetTxBlockChunksFromSeedNodes(uint64_t lowBlockNum);
   bool GetStateDeltaFromSeedNodes(const uint64_t& blockNum);
   bool GetStateDeltasFromSeedNodes(uint64_t lowBlockNum, uint64_t highBlockNum);
 
@@ -238,7 +411,7 @@ class Lookup : public Executable {
 
   bool SetDSCommitteInfo(bool replaceMyPeerWithDefault = false);
 
-  DequeOfShard GetShardPeers();
+  ShardingStructurePtr GetShardPeers();
   std::vector<Peer> GetNodePeers();
 
   // Start synchronization with other lookup nodes as a lookup node
@@ -255,10 +428,24 @@ class Lookup : public Executable {
 
   bool AddToTxnShardMap(const Transaction& tx, uint32_t shardId);
 
+  /// Adds a submitted txn to the shard map once its signature is checked,
+  /// which is done in the background. Txns seen recently are refused.
+  TxnAdmission::Result AdmitTxn(const Transaction& tx, uint32_t shardId);
+
   void CheckBufferTxBlocks();
 
   bool DeleteTxnShardMap(uint32_t shardId);
 
+  /// Moves the txns queued for the shard into txns, so that they are sent
+  /// without holding up RPC ingestion on m_txnShardMapMutex
+  void TakeTxnShardMap(uint32_t shardId, std::vector<Transaction>& txns);
+
+  /// Puts back txns taken but not sent, ahead of the ones queued since
+  void RestoreTxnShardMap(uint32_t shardId, std::vector<Transaction>& txns);
+
+  /// Looks up the body of a txn recently dispatched to the shards
+  bool GetDispatchedTxn(const TxnHash& txnHash, Transaction& txn);
+
   void SetServerTrue();
 
   bool GetIsServer();
@@ -267,6 +454,11 @@ class Lookup : public Executable {
 
   void SendTxnPacketToNodes(uint32_t);
 
+  /// Builds and sends the packet of queued and generated txns to one shard,
+  /// or to the DS committee if shardId is numShards
+  void SendTxnPacketToShard(uint32_t shardId, uint32_t numShards,
+                            const std::vector<Transaction>& genTxns);
+
   bool ProcessEntireShardingStructure();
   bool ProcessGetDSInfoFromSeed(const bytes& message, unsigned int offset,
                                 const Peer& from);
@@ -301,7 +493,9 @@ class Lookup : public Executable {
   bool ProcessSetMicroBlockFromLookup([[gnu::unused]] const bytes& message,
                                       [[gnu::unused]] unsigned int offset,
                                       [[gnu::unused]] const Peer& from);
-  bool AddMicroBlockToStorage(const MicroBlock& microblock);
+  /// Adds the micro block and its txn hashes to writes, to be put along
+  /// with the txn bodies
+  bool AddMicroBlockToWrites(const MicroBlock& microblock, EpochWrites& writes);
 
   bool ProcessGetOfflineLookups(const bytes& message, unsigned int offset,
                                 const Peer& from);
@@ -330,6 +524,11 @@ class Lookup : public Executable {
   bool ProcessSetOfflineLookups(const bytes& message, unsigned int offset,
                                 const Peer& from);
 
+  /// Checks a PoW submission sent to this lookup and buffers it, to be sent
+  /// on to the DS committee in a packet signed by this lookup
+  bool RelayPoWSubmission(const bytes& message, unsigned int offset,
+                          const Peer& from);
+
   bool ProcessRaiseStartPoW(const bytes& message, unsigned int offset,
                             const Peer& from);
   bool ProcessGetStartPoWFromSeed(const bytes& message, unsigned int offset,
@@ -354,6 +553,33 @@ class Lookup : public Executable {
 
   bool ProcessSetHistoricalDB(const bytes& message, unsigned int offset,
                               const Peer& from);
+  bool ProcessSubscribeBlocks(const bytes& message, unsigned int offset,
+                              const Peer& from);
+  bool ProcessGetMicroBlockTxnsFromLookup(const bytes& message,
+                                          unsigned int offset,
+                                          const Peer& from);
+  bool ProcessSetMicroBlockTxnsFromLookup(const bytes& message,
+                                          unsigned int offset,
+                                          const Peer& from);
+
+  /// Asks the seed nodes for the micro blocks and txn bodies of the tx blocks
+  /// from m_microBlockTxnsFrom on that are not stored yet, in up to
+  /// MICROBLOCK_TXNS_REQUESTS_PER_ROUND requests sent without waiting
+  void FetchMicroBlockTxnsFromSeed();
+
+  /// Asks a random seed node to push the tx blocks after the latest one here
+  /// as they are committed, renewing any earlier subscription
+  void SubscribeToBlocksFromSeed();
+
+  /// Keeps a synced LOOKUP_REPLICA following the seed nodes: renews its
+  /// block subscription, and fetches the DS and tx blocks after its tip
+  /// whenever no pushed block has arrived for a while
+  void StartReplicaFollowing();
+
+  /// Pushes a newly committed tx block and its state delta to the subscribers
+  /// expecting it
+  void PushTxBlockToSubscribers(const TxBlock& txBlock,
+                                const bytes& stateDelta);
   void ComposeAndSendGetDirectoryBlocksFromSeed(const uint64_t& index_num,
                                                 bool toSendSeed = true);
 
@@ -92,6 +92,7 @@ bool Synchronizer::AddGenesisTxBlockToBlockChain(TxBlockChain& txBlockChain,
   txBlock.Serialize(serializedTxBlock, 0);
   BlockStorage::GetBlockStorage().PutTxBlock(txBlock.GetHeader().GetBlockNum(),
                                              serializedTxBlock);
+  BlockStorage::GetBlockStorage().CommitEpoch(txBlock.GetHeader().GetBlockNum());
 
   return true;
 }
@@ -173,7 +174,7 @@ bool Synchronizer::FetchLatestTxBlockSeed(Lookup* lookup,
     return true;
   }
 
-  lookup->GetTxBlockFromSeedNodes(currentBlockChainSize, 0);
+  lookup->GetTxBlockChunksFromSeedNodes(currentBlockChainSize);
   return true;
 }
 
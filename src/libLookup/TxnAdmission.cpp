@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "TxnAdmission.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+
+bool TxnAdmission::SeenFilter::Insert(const TxnHash& hash) {
+  if (m_partCapacity == 0) {
+    return true;
+  }
+
+  Part& part = GetPart(hash);
+  lock_guard<mutex> g(part.m_mutex);
+  if (!part.m_hashes.emplace(hash).second) {
+    return false;
+  }
+  part.m_order.emplace_back(hash);
+  if (part.m_order.size() > m_partCapacity) {
+    part.m_hashes.erase(part.m_order.front());
+    part.m_order.pop_front();
+  }
+  return true;
+}
+
+void TxnAdmission::SeenFilter::Erase(const TxnHash& hash) {
+  if (m_partCapacity == 0) {
+    return;
+  }
+
+  // Left in m_order, where it only ages out an entry early
+  Part& part = GetPart(hash);
+  lock_guard<mutex> g(part.m_mutex);
+  part.m_hashes.erase(hash);
+}
+
+TxnAdmission::TxnAdmission(const Verifier& verifier, const Sink& sink,
+                           unsigned int seenCapacity, unsigned int maxQueued,
+                           unsigned int batchSize)
+    : m_verifier(verifier),
+      m_sink(sink),
+      m_maxQueued(maxQueued),
+      m_batchSize(max(batchSize, 1u)),
+      m_seen(seenCapacity) {
+  m_thread = thread([this]() { Run(); });
+}
+
+TxnAdmission::~TxnAdmission() {
+  {
+    lock_guard<mutex> g(m_mutex);
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  m_thread.join();
+}
+
+TxnAdmission::Result TxnAdmission::Admit(const Transaction& tx,
+                                         uint32_t shardId) {
+  if (!m_seen.Insert(tx.GetTranID())) {
+    return DUPLICATE;
+  }
+
+  {
+    lock_guard<mutex> g(m_mutex);
+    if (m_queue.size() < m_maxQueued) {
+      m_queue.emplace_back(tx, shardId);
+      m_cv.notify_one();
+      return QUEUED;
+    }
+  }
+
+  // Not checked, so it may be submitted again
+  m_seen.Erase(tx.GetTranID());
+  return BUSY;
+}
+
+void TxnAdmission::Run() {
+  vector<Transaction> txns;
+  vector<uint32_t> shardIds;
+  vector<bool> valid;
+
+  while (true) {
+    txns.clear();
+    shardIds.clear();
+    {
+      unique_lock<mutex> g(m_mutex);
+      m_cv.wait(g, [this]() { return m_stop || !m_queue.empty(); });
+      // The txns queued before stopping are still handed on
+      if (m_queue.empty()) {
+        return;
+      }
+      while (!m_queue.empty() && txns.size() < m_batchSize) {
+        txns.emplace_back(move(m_queue.front().first));
+        shardIds.emplace_back(m_queue.front().second);
+        m_queue.pop_front();
+      }
+    }
+
+    valid.assign(txns.size(), false);
+    m_verifier(txns, valid);
+
+    for (unsigned int i = 0; i < txns.size(); i++) {
+      if (valid[i]) {
+        m_sink(txns[i], shardIds[i]);
+      } else {
+        LOG_GENERAL(WARNING,
+                    "Signature incorrect, txn rejected: " << txns[i].GetTranID());
+      }
+    }
+  }
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TXNADMISSION_H__
+#define __TXNADMISSION_H__
+
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "libData/AccountData/Transaction.h"
+
+/// Admits the txns submitted to a lookup. A txn whose hash was seen recently
+/// is turned away at once, so a resubmission costs a hash lookup rather than
+/// a signature check. The others are queued, and one thread checks their
+/// signatures in batches and hands the valid ones on, so that the caller
+/// need not wait for the check.
+class TxnAdmission {
+ public:
+  enum Result { QUEUED, DUPLICATE, BUSY };
+
+  /// Sets valid[i] to whether the signature of txns[i] holds
+  typedef std::function<void(const std::vector<Transaction>& txns,
+                             std::vector<bool>& valid)>
+      Verifier;
+  /// Takes a txn that passed, along with the shard given to Admit
+  typedef std::function<void(const Transaction& tx, uint32_t shardId)> Sink;
+
+  /// Remembers the last seenCapacity hashes, and refuses txns beyond
+  /// maxQueued waiting for their check
+  TxnAdmission(const Verifier& verifier, const Sink& sink,
+               unsigned int seenCapacity, unsigned int maxQueued,
+               unsigned int batchSize);
+  ~TxnAdmission();
+
+  Result Admit(const Transaction& tx, uint32_t shardId);
+
+ private:
+  /// The recently seen hashes, split by hash so that concurrent submissions
+  /// seldom share a lock. Each part drops its oldest hash when full.
+  class SeenFilter {
+    static const unsigned int NUM_PARTS = 16;
+
+    struct Part {
+      std::mutex m_mutex;
+      std::unordered_set<TxnHash> m_hashes;
+      std::deque<TxnHash> m_order;
+    };
+
+    const unsigned int m_partCapacity;
+    std::array<Part, NUM_PARTS> m_parts;
+
+    Part& GetPart(const TxnHash& hash) {
+      return m_parts[hash.asArray()[0] % NUM_PARTS];
+    }
+
+   public:
+    explicit SeenFilter(unsigned int capacity)
+        : m_partCapacity((capacity + NUM_PARTS - 1) / NUM_PARTS) {}
+
+    /// Returns false if hash was seen already
+    bool Insert(const TxnHash& hash);
+    void Erase(const TxnHash& hash);
+  };
+
+  void Run();
+
+  const Verifier m_verifier;
+  const Sink m_sink;
+  const unsigned int m_maxQueued;
+  const unsigned int m_batchSize;
+
+  SeenFilter m_seen;
+
+  std::deque<std::pair<Transaction, uint32_t>> m_queue;
+  bool m_stop = false;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::thread m_thread;
+};
+
+#endif  // __TXNADMISSION_H__
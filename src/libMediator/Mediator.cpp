@@ -16,6 +16,7 @@
  */
 
 #include <array>
+#include <chrono>
 
 #include "Mediator.h"
 #include "common/Constants.h"
@@ -23,6 +24,8 @@
 #include "libServer/GetWorkServer.h"
 #include "libUtils/DataConversion.h"
 #include "libUtils/DetachedFunction.h"
+#include "libUtils/MemoryStats.h"
+#include "libUtils/Metrics.h"
 #include "libUtils/ShardSizeCalculator.h"
 #include "libValidator/Validator.h"
 
@@ -47,6 +50,13 @@ Mediator::Mediator(const PairOfKey& key, const Peer& peer)
       m_isVacuousEpoch(false),
       m_curSWInfo() {
   SetupLogLevel();
+
+  MemoryStats::GetInstance().Register(
+      "blockchain.ds", [this]() { return m_dsBlockChain.GetMemoryUsage(); });
+  MemoryStats::GetInstance().Register(
+      "blockchain.tx", [this]() { return m_txBlockChain.GetMemoryUsage(); });
+
+  PublishEpochContext();
 }
 
 Mediator::~Mediator() {}
@@ -57,6 +67,8 @@ void Mediator::RegisterColleagues(DirectoryService* ds, Node* node,
   m_node = node;
   m_lookup = lookup;
   m_validator = validator;
+
+  PublishEpochContext();
 }
 
 void Mediator::UpdateDSBlockRand(bool isGenesis) {
@@ -72,12 +84,15 @@ void Mediator::UpdateDSBlockRand(bool isGenesis) {
     DSBlock lastBlock = m_dsBlockChain.GetLastBlock();
     SHA2<HASH_TYPE::HASH_VARIANT_256> sha2;
     bytes vec;
-    lastBlock.GetHeader().Serialize(vec, 0);
+    lastBlock.GetHeader().SerializeCached(vec, 0);
     sha2.Update(vec);
     bytes randVec;
     randVec = sha2.Finalize();
     copy(randVec.begin(), randVec.end(), m_dsBlockRand.begin());
   }
+
+  // Called once the DS block chain moves on
+  PublishEpochContext();
 }
 
 void Mediator::UpdateTxBlockRand(bool isGenesis) {
@@ -92,7 +107,7 @@ void Mediator::UpdateTxBlockRand(bool isGenesis) {
     TxBlock lastBlock = m_txBlockChain.GetLastBlock();
     SHA2<HASH_TYPE::HASH_VARIANT_256> sha2;
     bytes vec;
-    lastBlock.GetHeader().Serialize(vec, 0);
+    lastBlock.GetHeader().SerializeCached(vec, 0);
     sha2.Update(vec);
     bytes randVec;
     randVec = sha2.Finalize();
@@ -125,6 +140,17 @@ std::string Mediator::GetNodeMode(const Peer& peer) {
 void Mediator::IncreaseEpochNum() {
   std::lock_guard<mutex> lock(m_mutexVacuousEpoch);
   m_currentEpochNum++;
+
+  static Metrics::Histogram& epochDuration =
+      Metrics::GetInstance().GetHistogram("zilliqa_epoch_duration_seconds",
+                                          "Time between consecutive epochs");
+  static chrono::steady_clock::time_point lastEpochStart;
+  const auto now = chrono::steady_clock::now();
+  if (lastEpochStart != chrono::steady_clock::time_point()) {
+    epochDuration.Observe(
+        chrono::duration<double>(now - lastEpochStart).count());
+  }
+  lastEpochStart = now;
   if ((m_currentEpochNum + NUM_VACUOUS_EPOCHS) % NUM_FINAL_BLOCK_PER_POW == 0) {
     m_isVacuousEpoch = true;
   } else {
@@ -149,6 +175,32 @@ void Mediator::IncreaseEpochNum() {
   LOG_GENERAL(INFO, "Epoch number is now " << m_currentEpochNum);
 
   LOG_STATE("Epoch = " << m_currentEpochNum);
+
+  PublishEpochContext();
+}
+
+void Mediator::PublishEpochContext() {
+  auto context = make_shared<EpochContext>();
+
+  lock_guard<mutex> g(m_mutexEpochContext);
+  context->m_epochNum = m_currentEpochNum;
+  context->m_lastDSBlock = m_dsBlockChain.GetLastBlockPtr();
+  context->m_lastTxBlock = m_txBlockChain.GetLastBlockPtr();
+  {
+    lock_guard<mutex> g2(m_mutexDSCommittee);
+    context->m_dsCommittee = make_shared<const DequeOfNode>(*m_DSCommittee);
+  }
+  if (m_ds) {
+    context->m_shards = m_ds->GetShardingStructure();
+  } else {
+    context->m_shards = make_shared<ShardingStructure>(DequeOfShard());
+  }
+
+  atomic_store(&m_epochContext, EpochContextPtr(move(context)));
+}
+
+EpochContextPtr Mediator::GetEpochContext() const {
+  return atomic_load(&m_epochContext);
 }
 
 bool Mediator::GetIsVacuousEpoch() { return m_isVacuousEpoch; }
@@ -19,6 +19,7 @@
 #define __MEDIATOR_H__
 
 #include <deque>
+#include <memory>
 
 #include "libCrypto/Schnorr.h"
 #include "libData/BlockChainData/BlockChain.h"
@@ -29,6 +30,19 @@
 #include "libNode/Node.h"
 #include "libValidator/Validator.h"
 
+/// What the handlers of a message need to know of the current epoch, published
+/// as a whole so that a handler reads it once, without locks or copies, and
+/// sees the epoch number, blocks and committees of the same moment.
+struct EpochContext {
+  uint64_t m_epochNum = 0;
+  DSBlockChain::BlockPtr m_lastDSBlock;
+  TxBlockChain::BlockPtr m_lastTxBlock;
+  std::shared_ptr<const DequeOfNode> m_dsCommittee;
+  ShardingStructurePtr m_shards;
+};
+
+typedef std::shared_ptr<const EpochContext> EpochContextPtr;
+
 /// A mediator class for providing access to global members.
 class Mediator {
  public:
@@ -93,6 +107,10 @@ class Mediator {
   /// Record current software information which already downloaded to this node
   SWInfo m_curSWInfo;
 
+  /// Read and written with std::atomic_load and std::atomic_store
+  EpochContextPtr m_epochContext;
+  std::mutex m_mutexEpochContext;
+
   /// Constructor.
   Mediator(const PairOfKey& key, const Peer& peer);
 
@@ -113,6 +131,14 @@ class Mediator {
 
   void IncreaseEpochNum();
 
+  /// Publishes the current epoch number, last blocks, DS committee and shards
+  /// to the readers of GetEpochContext. Called after any of them changes, by
+  /// a thread not holding m_mutexDSCommittee.
+  void PublishEpochContext();
+
+  /// Returns the last published epoch context, which never changes
+  EpochContextPtr GetEpochContext() const;
+
   bool GetIsVacuousEpoch();
 
   bool GetIsVacuousEpoch(const uint64_t& epochNum);
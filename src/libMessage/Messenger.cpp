@@ -23,9 +23,12 @@
 #include "libMessage/ZilliqaMessage.pb.h"
 #include "libUtils/Logger.h"
 
+#include <google/protobuf/arena.h>
 #include <google/protobuf/io/coded_stream.h>
 #include <google/protobuf/io/zero_copy_stream_impl_lite.h>
+#include <google/protobuf/wire_format_lite.h>
 #include <algorithm>
+#include <functional>
 #include <map>
 #include <random>
 #include <unordered_set>
@@ -47,8 +50,7 @@ void SerializableToProtobufByteArray(const Serializable& serializable,
 
 bool ProtobufByteArrayToSerializable(const ByteArray& byteArray,
                                      Serializable& serializable) {
-  bytes tmp;
-  copy(byteArray.data().begin(), byteArray.data().end(), back_inserter(tmp));
+  const bytes tmp(byteArray.data().begin(), byteArray.data().end());
   return serializable.Deserialize(tmp, 0) == 0;
 }
 
@@ -63,8 +65,7 @@ void SerializableToProtobufByteArray(const SerializableDataBlock& serializable,
 // Temporary function for use by data blocks
 bool ProtobufByteArrayToSerializable(const ByteArray& byteArray,
                                      SerializableDataBlock& serializable) {
-  bytes tmp;
-  copy(byteArray.data().begin(), byteArray.data().end(), back_inserter(tmp));
+  const bytes tmp(byteArray.data().begin(), byteArray.data().end());
   return serializable.Deserialize(tmp, 0);
 }
 
@@ -77,26 +78,93 @@ void NumberToProtobufByteArray(const T& number, ByteArray& byteArray) {
 
 template <class T, size_t S>
 void ProtobufByteArrayToNumber(const ByteArray& byteArray, T& number) {
-  bytes tmp;
-  copy(byteArray.data().begin(), byteArray.data().end(), back_inserter(tmp));
+  const bytes tmp(byteArray.data().begin(), byteArray.data().end());
   number = Serializable::GetNumber<T>(tmp, 0, S);
 }
 
 template <class T>
 bool SerializeToArray(const T& protoMessage, bytes& dst,
                       const unsigned int offset) {
-  if ((offset + protoMessage.ByteSize()) > dst.size()) {
-    dst.resize(offset + protoMessage.ByteSize());
+  // Sizing walks the whole message, so do it once and serialize with the
+  // sizes it cached
+  const unsigned int size = protoMessage.ByteSize();
+  if ((offset + size) > dst.size()) {
+    dst.resize(offset + size);
   }
 
-  return protoMessage.SerializeToArray(dst.data() + offset,
-                                       protoMessage.ByteSize());
+  protoMessage.SerializeWithCachedSizesToArray(dst.data() + offset);
+  return true;
+}
+
+// Messages with many submessages, such as blocks, sharding structures and
+// txn packets, are built on an arena, which frees them all at once rather
+// than one allocation at a time
+template <class T>
+T& CreateArenaMessage(google::protobuf::Arena& arena) {
+  return *google::protobuf::Arena::CreateMessage<T>(&arena);
 }
 
 template bool SerializeToArray<ProtoAccountStore>(
     const ProtoAccountStore& protoMessage, bytes& dst,
     const unsigned int offset);
 
+/// Calls handler on each entry of a serialized ProtoAccountStore in turn, so
+/// a large state delta is never held as one parsed message
+bool ForEachAccountStoreEntry(
+    const bytes& src, const unsigned int offset,
+    const function<bool(const ProtoAccountStore::AddressAccount&)>& handler) {
+  if (offset > src.size()) {
+    LOG_GENERAL(WARNING, "Offset " << offset << " beyond size " << src.size());
+    return false;
+  }
+
+  // Serialized entries are all there is to a ProtoAccountStore
+  const uint32_t ENTRY_TAG = (ProtoAccountStore::kEntriesFieldNumber << 3) |
+                             2;  // length-delimited
+
+  google::protobuf::io::CodedInputStream codedIn(src.data() + offset,
+                                                 src.size() - offset);
+  codedIn.SetTotalBytesLimit(src.size() - offset, src.size() - offset);
+
+  ProtoAccountStore::AddressAccount entry;
+  for (uint32_t tag = codedIn.ReadTag(); tag != 0; tag = codedIn.ReadTag()) {
+    uint32_t length = 0;
+    if (tag != ENTRY_TAG || !codedIn.ReadVarint32(&length)) {
+      LOG_GENERAL(WARNING, "ProtoAccountStore initialization failed");
+      return false;
+    }
+
+    const auto limit = codedIn.PushLimit(length);
+    if (!entry.ParseFromCodedStream(&codedIn) ||
+        !codedIn.ConsumedEntireMessage() || !entry.IsInitialized()) {
+      LOG_GENERAL(WARNING, "ProtoAccountStore initialization failed");
+      return false;
+    }
+    codedIn.PopLimit(limit);
+
+    if (!handler(entry)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Writes first and second back to back, as signed over in announcements
+template <class T, class U>
+bool SerializeToArray(const T& first, const U& second, bytes& dst,
+                      const unsigned int offset) {
+  const unsigned int firstSize = first.ByteSize();
+  const unsigned int size = firstSize + second.ByteSize();
+  if ((offset + size) > dst.size()) {
+    dst.resize(offset + size);
+  }
+
+  first.SerializeWithCachedSizesToArray(dst.data() + offset);
+  second.SerializeWithCachedSizesToArray(dst.data() + offset + firstSize);
+  return true;
+}
+
 template <class T>
 bool RepeatableToArray(const T& repeatable, bytes& dst,
                        const unsigned int offset) {
@@ -106,7 +174,7 @@ bool RepeatableToArray(const T& repeatable, bytes& dst,
       LOG_GENERAL(WARNING, "SerializeToArray failed, offset: " << tempOffset);
       return false;
     }
-    tempOffset += element.ByteSize();
+    tempOffset += element.GetCachedSize();
   }
   return true;
 }
@@ -326,7 +394,8 @@ inline bool CheckRequiredFieldsProtoTransactionCoreInfo(
 
 inline bool CheckRequiredFieldsProtoTransactionReceipt(
     const ProtoTransactionReceipt& protoTransactionReceipt) {
-  return protoTransactionReceipt.has_receipt() &&
+  return (protoTransactionReceipt.has_compactreceipt() ||
+          protoTransactionReceipt.has_receipt()) &&
          protoTransactionReceipt.has_cumgas();
 }
 
@@ -766,12 +835,12 @@ void BlockBaseToProtobuf(const BlockBase& base,
       protoBlockBase.mutable_cosigs();
 
   SerializableToProtobufByteArray(base.GetCS1(), *cosigs->mutable_cs1());
-  for (const auto& i : base.GetB1()) {
-    cosigs->add_b1(i);
+  for (size_t i = 0; i < base.GetB1().size(); i++) {
+    cosigs->add_b1(base.GetB1()[i]);
   }
   SerializableToProtobufByteArray(base.GetCS2(), *cosigs->mutable_cs2());
-  for (const auto& i : base.GetB2()) {
-    cosigs->add_b2(i);
+  for (size_t i = 0; i < base.GetB2().size(); i++) {
+    cosigs->add_b2(base.GetB2()[i]);
   }
 }
 
@@ -788,11 +857,13 @@ bool ProtobufToBlockBase(const ProtoBlockBase& protoBlockBase,
   cosigs.m_B2.resize(protoBlockBase.cosigs().b2().size());
 
   PROTOBUFBYTEARRAYTOSERIALIZABLE(protoBlockBase.cosigs().cs1(), cosigs.m_CS1);
-  copy(protoBlockBase.cosigs().b1().begin(), protoBlockBase.cosigs().b1().end(),
-       cosigs.m_B1.begin());
+  for (int i = 0; i < protoBlockBase.cosigs().b1().size(); i++) {
+    cosigs.m_B1[i] = protoBlockBase.cosigs().b1(i);
+  }
   PROTOBUFBYTEARRAYTOSERIALIZABLE(protoBlockBase.cosigs().cs2(), cosigs.m_CS2);
-  copy(protoBlockBase.cosigs().b2().begin(), protoBlockBase.cosigs().b2().end(),
-       cosigs.m_B2.begin());
+  for (int i = 0; i < protoBlockBase.cosigs().b2().size(); i++) {
+    cosigs.m_B2[i] = protoBlockBase.cosigs().b2(i);
+  }
 
   base.SetCoSignatures(cosigs);
 
@@ -1046,8 +1117,17 @@ void TransactionToProtobuf(const Transaction& transaction,
                            ProtoTransaction& protoTransaction) {
   protoTransaction.set_tranid(transaction.GetTranID().data(),
                               transaction.GetTranID().size);
-  TransactionCoreInfoToProtobuf(transaction.GetCoreInfo(),
-                                *protoTransaction.mutable_info());
+
+  // Parsing the bytes the tranID was computed over is cheaper than encoding
+  // the core fields, the sender pubkey in particular, all over again
+  const bytes& coreInfoBytes = transaction.GetSerializedCoreInfo();
+  if (coreInfoBytes.empty() ||
+      !protoTransaction.mutable_info()->ParseFromArray(coreInfoBytes.data(),
+                                                       coreInfoBytes.size())) {
+    protoTransaction.mutable_info()->Clear();
+    TransactionCoreInfoToProtobuf(transaction.GetCoreInfo(),
+                                  *protoTransaction.mutable_info());
+  }
 
   SerializableToProtobufByteArray(transaction.GetSignature(),
                                   *protoTransaction.mutable_signature());
@@ -1102,10 +1182,7 @@ bool ProtobufToTransaction(const ProtoTransaction& protoTransaction,
     return false;
   }
 
-  transaction = Transaction(
-      tranID, txnCoreInfo.version, txnCoreInfo.nonce, txnCoreInfo.toAddr,
-      txnCoreInfo.senderPubKey, txnCoreInfo.amount, txnCoreInfo.gasPrice,
-      txnCoreInfo.gasLimit, txnCoreInfo.code, txnCoreInfo.data, signature);
+  transaction = Transaction(tranID, txnCoreInfo, signature, move(txnData));
 
   return true;
 }
@@ -1149,8 +1226,9 @@ bool ProtobufToTransactionArray(
 
 void TransactionReceiptToProtobuf(const TransactionReceipt& transReceipt,
                                   ProtoTransactionReceipt& protoTransReceipt) {
-  protoTransReceipt.set_receipt(transReceipt.GetString());
-  // protoTransReceipt.set_cumgas(transReceipt.GetCumGas());
+  const bytes& receiptBytes = transReceipt.GetBytes();
+  protoTransReceipt.set_compactreceipt(receiptBytes.data(),
+                                       receiptBytes.size());
   protoTransReceipt.set_cumgas(transReceipt.GetCumGas());
 }
 
@@ -1161,12 +1239,19 @@ bool ProtobufToTransactionReceipt(
     LOG_GENERAL(WARNING, "CheckRequiredFieldsProtoTransactionReceipt failed");
     return false;
   }
-  std::string tranReceiptStr;
-  tranReceiptStr.resize(protoTransactionReceipt.receipt().size());
-  copy(protoTransactionReceipt.receipt().begin(),
-       protoTransactionReceipt.receipt().end(), tranReceiptStr.begin());
-  transactionReceipt.SetString(tranReceiptStr);
+  // Before the receipt, which replaces the json that SetCumGas adds to
   transactionReceipt.SetCumGas(protoTransactionReceipt.cumgas());
+  if (protoTransactionReceipt.has_compactreceipt()) {
+    const bytes receiptBytes(protoTransactionReceipt.compactreceipt().begin(),
+                             protoTransactionReceipt.compactreceipt().end());
+    if (!transactionReceipt.SetBytes(receiptBytes)) {
+      LOG_GENERAL(WARNING, "TransactionReceipt::SetBytes failed");
+      return false;
+    }
+  } else {
+    // Stored before receipts were encoded
+    transactionReceipt.SetString(protoTransactionReceipt.receipt());
+  }
 
   return true;
 }
@@ -1963,8 +2048,8 @@ bool SetConsensusAnnouncementCore(
     return false;
   }
 
-  bytes tmp(announcement.consensusinfo().ByteSize());
-  announcement.consensusinfo().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(announcement.consensusinfo(), tmp, 0);
 
   Signature signature;
 
@@ -1988,52 +2073,32 @@ bool SetConsensusAnnouncementCore(
         LOG_GENERAL(WARNING, "Announcement dsblock content not initialized");
         return false;
       }
-      inputToSigning.resize(announcement.consensusinfo().ByteSize() +
-                            announcement.dsblock().ByteSize());
-      announcement.consensusinfo().SerializeToArray(
-          inputToSigning.data(), announcement.consensusinfo().ByteSize());
-      announcement.dsblock().SerializeToArray(
-          inputToSigning.data() + announcement.consensusinfo().ByteSize(),
-          announcement.dsblock().ByteSize());
+      SerializeToArray(announcement.consensusinfo(), announcement.dsblock(),
+                       inputToSigning, 0);
       break;
     case ConsensusAnnouncement::AnnouncementCase::kMicroblock:
       if (!announcement.microblock().IsInitialized()) {
         LOG_GENERAL(WARNING, "Announcement microblock content not initialized");
         return false;
       }
-      inputToSigning.resize(announcement.consensusinfo().ByteSize() +
-                            announcement.microblock().ByteSize());
-      announcement.consensusinfo().SerializeToArray(
-          inputToSigning.data(), announcement.consensusinfo().ByteSize());
-      announcement.microblock().SerializeToArray(
-          inputToSigning.data() + announcement.consensusinfo().ByteSize(),
-          announcement.microblock().ByteSize());
+      SerializeToArray(announcement.consensusinfo(), announcement.microblock(),
+                       inputToSigning, 0);
       break;
     case ConsensusAnnouncement::AnnouncementCase::kFinalblock:
       if (!announcement.finalblock().IsInitialized()) {
         LOG_GENERAL(WARNING, "Announcement finalblock content not initialized");
         return false;
       }
-      inputToSigning.resize(announcement.consensusinfo().ByteSize() +
-                            announcement.finalblock().ByteSize());
-      announcement.consensusinfo().SerializeToArray(
-          inputToSigning.data(), announcement.consensusinfo().ByteSize());
-      announcement.finalblock().SerializeToArray(
-          inputToSigning.data() + announcement.consensusinfo().ByteSize(),
-          announcement.finalblock().ByteSize());
+      SerializeToArray(announcement.consensusinfo(), announcement.finalblock(),
+                       inputToSigning, 0);
       break;
     case ConsensusAnnouncement::AnnouncementCase::kVcblock:
       if (!announcement.vcblock().IsInitialized()) {
         LOG_GENERAL(WARNING, "Announcement vcblock content not initialized");
         return false;
       }
-      inputToSigning.resize(announcement.consensusinfo().ByteSize() +
-                            announcement.vcblock().ByteSize());
-      announcement.consensusinfo().SerializeToArray(
-          inputToSigning.data(), announcement.consensusinfo().ByteSize());
-      announcement.vcblock().SerializeToArray(
-          inputToSigning.data() + announcement.consensusinfo().ByteSize(),
-          announcement.vcblock().ByteSize());
+      SerializeToArray(announcement.consensusinfo(), announcement.vcblock(),
+                       inputToSigning, 0);
       break;
     case ConsensusAnnouncement::AnnouncementCase::kFallbackblock:
       if (!announcement.fallbackblock().IsInitialized()) {
@@ -2041,13 +2106,8 @@ bool SetConsensusAnnouncementCore(
                     "Announcement fallbackblock content not initialized");
         return false;
       }
-      inputToSigning.resize(announcement.consensusinfo().ByteSize() +
-                            announcement.fallbackblock().ByteSize());
-      announcement.consensusinfo().SerializeToArray(
-          inputToSigning.data(), announcement.consensusinfo().ByteSize());
-      announcement.fallbackblock().SerializeToArray(
-          inputToSigning.data() + announcement.consensusinfo().ByteSize(),
-          announcement.fallbackblock().ByteSize());
+      SerializeToArray(announcement.consensusinfo(),
+                       announcement.fallbackblock(), inputToSigning, 0);
       break;
     case ConsensusAnnouncement::AnnouncementCase::ANNOUNCEMENT_NOT_SET:
     default:
@@ -2127,49 +2187,24 @@ bool GetConsensusAnnouncementCore(
   bytes tmp;
 
   if (announcement.has_dsblock() && announcement.dsblock().IsInitialized()) {
-    tmp.resize(announcement.consensusinfo().ByteSize() +
-               announcement.dsblock().ByteSize());
-    announcement.consensusinfo().SerializeToArray(
-        tmp.data(), announcement.consensusinfo().ByteSize());
-    announcement.dsblock().SerializeToArray(
-        tmp.data() + announcement.consensusinfo().ByteSize(),
-        announcement.dsblock().ByteSize());
+    SerializeToArray(announcement.consensusinfo(), announcement.dsblock(),
+                     tmp, 0);
   } else if (announcement.has_microblock() &&
              announcement.microblock().IsInitialized()) {
-    tmp.resize(announcement.consensusinfo().ByteSize() +
-               announcement.microblock().ByteSize());
-    announcement.consensusinfo().SerializeToArray(
-        tmp.data(), announcement.consensusinfo().ByteSize());
-    announcement.microblock().SerializeToArray(
-        tmp.data() + announcement.consensusinfo().ByteSize(),
-        announcement.microblock().ByteSize());
+    SerializeToArray(announcement.consensusinfo(), announcement.microblock(),
+                     tmp, 0);
   } else if (announcement.has_finalblock() &&
              announcement.finalblock().IsInitialized()) {
-    tmp.resize(announcement.consensusinfo().ByteSize() +
-               announcement.finalblock().ByteSize());
-    announcement.consensusinfo().SerializeToArray(
-        tmp.data(), announcement.consensusinfo().ByteSize());
-    announcement.finalblock().SerializeToArray(
-        tmp.data() + announcement.consensusinfo().ByteSize(),
-        announcement.finalblock().ByteSize());
+    SerializeToArray(announcement.consensusinfo(), announcement.finalblock(),
+                     tmp, 0);
   } else if (announcement.has_vcblock() &&
              announcement.vcblock().IsInitialized()) {
-    tmp.resize(announcement.consensusinfo().ByteSize() +
-               announcement.vcblock().ByteSize());
-    announcement.consensusinfo().SerializeToArray(
-        tmp.data(), announcement.consensusinfo().ByteSize());
-    announcement.vcblock().SerializeToArray(
-        tmp.data() + announcement.consensusinfo().ByteSize(),
-        announcement.vcblock().ByteSize());
+    SerializeToArray(announcement.consensusinfo(), announcement.vcblock(),
+                     tmp, 0);
   } else if (announcement.has_fallbackblock() &&
              announcement.fallbackblock().IsInitialized()) {
-    tmp.resize(announcement.consensusinfo().ByteSize() +
-               announcement.fallbackblock().ByteSize());
-    announcement.consensusinfo().SerializeToArray(
-        tmp.data(), announcement.consensusinfo().ByteSize());
-    announcement.fallbackblock().SerializeToArray(
-        tmp.data() + announcement.consensusinfo().ByteSize(),
-        announcement.fallbackblock().ByteSize());
+    SerializeToArray(announcement.consensusinfo(), announcement.fallbackblock(),
+                     tmp, 0);
   } else {
     LOG_GENERAL(WARNING, "Announcement content not set");
     return false;
@@ -2360,7 +2395,8 @@ bool Messenger::SetAccountDelta(bytes& dst, const unsigned int offset,
 template <class MAP>
 bool Messenger::SetAccountStore(bytes& dst, const unsigned int offset,
                                 const MAP& addressToAccount) {
-  ProtoAccountStore result;
+  google::protobuf::Arena arena;
+  ProtoAccountStore& result = CreateArenaMessage<ProtoAccountStore>(arena);
 
   LOG_GENERAL(INFO, "Accounts to serialize: " << addressToAccount.size());
 
@@ -2386,7 +2422,8 @@ bool Messenger::SetAccountStore(bytes& dst, const unsigned int offset,
 template <class MAP>
 bool Messenger::GetAccountStore(const bytes& src, const unsigned int offset,
                                 MAP& addressToAccount) {
-  ProtoAccountStore result;
+  google::protobuf::Arena arena;
+  ProtoAccountStore& result = CreateArenaMessage<ProtoAccountStore>(arena);
 
   result.ParseFromArray(src.data() + offset, src.size() - offset);
 
@@ -2419,7 +2456,8 @@ bool Messenger::GetAccountStore(const bytes& src, const unsigned int offset,
 
 bool Messenger::GetAccountStore(const bytes& src, const unsigned int offset,
                                 AccountStore& accountStore) {
-  ProtoAccountStore result;
+  google::protobuf::Arena arena;
+  ProtoAccountStore& result = CreateArenaMessage<ProtoAccountStore>(arena);
 
   result.ParseFromArray(src.data() + offset, src.size() - offset);
 
@@ -2453,12 +2491,17 @@ bool Messenger::GetAccountStore(const bytes& src, const unsigned int offset,
 bool Messenger::SetAccountStoreDelta(bytes& dst, const unsigned int offset,
                                      AccountStoreTemp& accountStoreTemp,
                                      AccountStore& accountStore) {
-  ProtoAccountStore result;
-
   LOG_GENERAL(INFO, "Account deltas to serialize: "
                         << accountStoreTemp.GetNumOfAccounts());
 
+  // A ProtoAccountStore of one entry serializes to just that entry, so
+  // appending them one at a time gives the same bytes as serializing the
+  // whole store, without building it in memory first
+  unsigned int curOffset = offset;
+  google::protobuf::Arena arena;
+  ProtoAccountStore& result = CreateArenaMessage<ProtoAccountStore>(arena);
   for (const auto& entry : *accountStoreTemp.GetAddressToAccount()) {
+    result.Clear();
     ProtoAccountStore::AddressAccount* protoEntry = result.add_entries();
     protoEntry->set_address(entry.first.data(), entry.first.size);
     ProtoAccount* protoEntryAccount = protoEntry->mutable_account();
@@ -2468,163 +2511,182 @@ bool Messenger::SetAccountStoreDelta(bytes& dst, const unsigned int offset,
       LOG_GENERAL(WARNING, "ProtoAccount initialization failed");
       return false;
     }
+
+    if (!SerializeToArray(result, dst, curOffset)) {
+      LOG_GENERAL(WARNING, "SerializeToArray failed, offset: " << curOffset);
+      return false;
+    }
+    curOffset += result.ByteSize();
   }
 
-  if (!result.IsInitialized()) {
-    LOG_GENERAL(WARNING, "ProtoAccountStore initialization failed");
-    return false;
+  if (dst.size() < curOffset) {
+    dst.resize(curOffset);
   }
 
-  return SerializeToArray(result, dst, offset);
+  return true;
 }
 
 bool Messenger::StateDeltaToAddressMap(
     const bytes& src, const unsigned int offset,
     unordered_map<Address, int256_t>& accountMap) {
-  ProtoAccountStore result;
+  return ForEachAccountStoreEntry(
+      src, offset,
+      [&accountMap](const ProtoAccountStore::AddressAccount& entry) -> bool {
+        Address address;
 
-  result.ParseFromArray(src.data() + offset, src.size() - offset);
+        copy(entry.address().begin(),
+             entry.address().begin() +
+                 min((unsigned int)entry.address().size(),
+                     (unsigned int)address.size),
+             address.asArray().begin());
 
-  if (!result.IsInitialized()) {
-    LOG_GENERAL(WARNING, "ProtoAccountStore initialization failed");
-    return false;
-  }
+        uint128_t tmpNumber;
 
-  for (const auto& entry : result.entries()) {
-    Address address;
-    Account account;
+        ProtobufByteArrayToNumber<uint128_t, UINT128_SIZE>(
+            entry.account().base().balance(), tmpNumber);
 
-    copy(entry.address().begin(),
-         entry.address().begin() + min((unsigned int)entry.address().size(),
-                                       (unsigned int)address.size),
-         address.asArray().begin());
+        int256_t balanceDelta = entry.account().numbersign()
+                                    ? tmpNumber.convert_to<int256_t>()
+                                    : 0 - tmpNumber.convert_to<int256_t>();
 
-    uint128_t tmpNumber;
+        accountMap.insert(make_pair(address, balanceDelta));
 
-    ProtobufByteArrayToNumber<uint128_t, UINT128_SIZE>(
-        entry.account().base().balance(), tmpNumber);
+        return true;
+      });
+}
 
-    int256_t balanceDelta = entry.account().numbersign()
-                                ? tmpNumber.convert_to<int256_t>()
-                                : 0 - tmpNumber.convert_to<int256_t>();
+bool Messenger::StateDeltaToContractAddresses(
+    const bytes& src, const unsigned int offset,
+    unordered_set<Address>& addresses) {
+  return ForEachAccountStoreEntry(
+      src, offset,
+      [&addresses](const ProtoAccountStore::AddressAccount& entry) -> bool {
+        if (entry.account().code().empty() &&
+            entry.account().storage().empty()) {
+          return true;
+        }
 
-    accountMap.insert(make_pair(address, balanceDelta));
-  }
+        Address address;
 
-  return true;
+        copy(entry.address().begin(),
+             entry.address().begin() +
+                 min((unsigned int)entry.address().size(),
+                     (unsigned int)address.size),
+             address.asArray().begin());
+
+        addresses.emplace(address);
+
+        return true;
+      });
 }
 
 bool Messenger::GetAccountStoreDelta(const bytes& src,
                                      const unsigned int offset,
                                      AccountStore& accountStore,
                                      const bool revertible, bool temp) {
-  ProtoAccountStore result;
-
-  result.ParseFromArray(src.data() + offset, src.size() - offset);
-
-  if (!result.IsInitialized()) {
-    LOG_GENERAL(WARNING, "ProtoAccountStore initialization failed");
-    return false;
-  }
-
-  LOG_GENERAL(INFO,
-              "Total Number of Accounts Delta: " << result.entries().size());
+  unsigned int numEntries = 0;
+
+  const bool ret = ForEachAccountStoreEntry(
+      src, offset,
+      [&](const ProtoAccountStore::AddressAccount& entry) -> bool {
+        Address address;
+        Account account, t_account;
+
+        copy(entry.address().begin(),
+             entry.address().begin() +
+                 min((unsigned int)entry.address().size(),
+                     (unsigned int)address.size),
+             address.asArray().begin());
+
+        const Account* oriAccount = accountStore.GetAccount(address);
+        bool fullCopy = false;
+        if (oriAccount == nullptr) {
+          Account acc(0, 0);
+          accountStore.AddAccount(address, acc);
+          oriAccount = accountStore.GetAccount(address);
+          fullCopy = true;
+
+          if (oriAccount == nullptr) {
+            LOG_GENERAL(WARNING, "Failed to create account for " << address);
+            return false;
+          }
+        }
 
-  for (const auto& entry : result.entries()) {
-    Address address;
-    Account account, t_account;
+        t_account = *oriAccount;
+        account = *oriAccount;
+        if (!ProtobufToAccountDelta(entry.account(), account, address,
+                                    fullCopy, temp, revertible)) {
+          LOG_GENERAL(WARNING,
+                      "ProtobufToAccountDelta failed for account at address "
+                          << entry.address());
+          return false;
+        }
 
-    copy(entry.address().begin(),
-         entry.address().begin() + min((unsigned int)entry.address().size(),
-                                       (unsigned int)address.size),
-         address.asArray().begin());
+        accountStore.AddAccountDuringDeserialization(
+            address, account, t_account, fullCopy, revertible);
+        numEntries++;
 
-    const Account* oriAccount = accountStore.GetAccount(address);
-    bool fullCopy = false;
-    if (oriAccount == nullptr) {
-      Account acc(0, 0);
-      accountStore.AddAccount(address, acc);
-      oriAccount = accountStore.GetAccount(address);
-      fullCopy = true;
+        return true;
+      });
 
-      if (oriAccount == nullptr) {
-        LOG_GENERAL(WARNING, "Failed to create account for " << address);
-        return false;
-      }
-    }
+  LOG_GENERAL(INFO, "Total Number of Accounts Delta: " << numEntries);
 
-    t_account = *oriAccount;
-    account = *oriAccount;
-    if (!ProtobufToAccountDelta(entry.account(), account, address, fullCopy,
-                                temp, revertible)) {
-      LOG_GENERAL(WARNING,
-                  "ProtobufToAccountDelta failed for account at address "
-                      << entry.address());
-      return false;
-    }
-
-    accountStore.AddAccountDuringDeserialization(address, account, t_account,
-                                                 fullCopy, revertible);
-  }
-
-  return true;
+  return ret;
 }
 
 bool Messenger::GetAccountStoreDelta(const bytes& src,
                                      const unsigned int offset,
                                      AccountStoreTemp& accountStoreTemp,
                                      bool temp) {
-  ProtoAccountStore result;
-
-  result.ParseFromArray(src.data() + offset, src.size() - offset);
-
-  if (!result.IsInitialized()) {
-    LOG_GENERAL(WARNING, "ProtoAccountStore initialization failed");
-    return false;
-  }
+  unsigned int numEntries = 0;
+
+  const bool ret = ForEachAccountStoreEntry(
+      src, offset,
+      [&](const ProtoAccountStore::AddressAccount& entry) -> bool {
+        Address address;
+        Account account;
+
+        copy(entry.address().begin(),
+             entry.address().begin() +
+                 min((unsigned int)entry.address().size(),
+                     (unsigned int)address.size),
+             address.asArray().begin());
+
+        const Account* oriAccount = accountStoreTemp.GetAccount(address);
+        bool fullCopy = false;
+        if (oriAccount == nullptr) {
+          Account acc(0, 0);
+          LOG_GENERAL(INFO, "Creating new account: " << address);
+          accountStoreTemp.AddAccount(address, acc);
+          fullCopy = true;
+        }
 
-  LOG_GENERAL(INFO,
-              "Total Number of Accounts Delta: " << result.entries().size());
+        oriAccount = accountStoreTemp.GetAccount(address);
 
-  for (const auto& entry : result.entries()) {
-    Address address;
-    Account account;
-
-    copy(entry.address().begin(),
-         entry.address().begin() + min((unsigned int)entry.address().size(),
-                                       (unsigned int)address.size),
-         address.asArray().begin());
-
-    const Account* oriAccount = accountStoreTemp.GetAccount(address);
-    bool fullCopy = false;
-    if (oriAccount == nullptr) {
-      Account acc(0, 0);
-      LOG_GENERAL(INFO, "Creating new account: " << address);
-      accountStoreTemp.AddAccount(address, acc);
-      fullCopy = true;
-    }
+        if (oriAccount == nullptr) {
+          LOG_GENERAL(WARNING, "Failed to create account for " << address);
+          return false;
+        }
 
-    oriAccount = accountStoreTemp.GetAccount(address);
+        account = *oriAccount;
 
-    if (oriAccount == nullptr) {
-      LOG_GENERAL(WARNING, "Failed to create account for " << address);
-      return false;
-    }
+        if (!ProtobufToAccountDelta(entry.account(), account, address,
+                                    fullCopy, temp)) {
+          LOG_GENERAL(WARNING,
+                      "ProtobufToAccountDelta failed for account at address "
+                          << entry.address());
+          return false;
+        }
 
-    account = *oriAccount;
+        accountStoreTemp.AddAccountDuringDeserialization(address, account);
+        numEntries++;
 
-    if (!ProtobufToAccountDelta(entry.account(), account, address, fullCopy,
-                                temp)) {
-      LOG_GENERAL(WARNING,
-                  "ProtobufToAccountDelta failed for account at address "
-                      << entry.address());
-      return false;
-    }
+        return true;
+      });
 
-    accountStoreTemp.AddAccountDuringDeserialization(address, account);
-  }
+  LOG_GENERAL(INFO, "Total Number of Accounts Delta: " << numEntries);
 
-  return true;
+  return ret;
 }
 
 bool Messenger::GetMbInfoHash(const std::vector<MicroBlockInfo>& mbInfos,
@@ -3036,7 +3098,9 @@ bool Messenger::GetTransactionFileOffset(const bytes& src,
 
 bool Messenger::SetTransactionArray(bytes& dst, const unsigned int offset,
                                     const std::vector<Transaction>& txns) {
-  ProtoTransactionArray result;
+  google::protobuf::Arena arena;
+  ProtoTransactionArray& result =
+      CreateArenaMessage<ProtoTransactionArray>(arena);
   TransactionArrayToProtobuf(txns, result);
   if (!result.IsInitialized()) {
     LOG_GENERAL(WARNING, "ProtoTransactionArray initialization failed");
@@ -3047,7 +3111,9 @@ bool Messenger::SetTransactionArray(bytes& dst, const unsigned int offset,
 
 bool Messenger::GetTransactionArray(const bytes& src, const unsigned int offset,
                                     std::vector<Transaction>& txns) {
-  ProtoTransactionArray result;
+  google::protobuf::Arena arena;
+  ProtoTransactionArray& result =
+      CreateArenaMessage<ProtoTransactionArray>(arena);
 
   result.ParseFromArray(src.data() + offset, src.size() - offset);
 
@@ -3443,8 +3509,8 @@ bool Messenger::SetPMHello(bytes& dst, const unsigned int offset,
     LOG_GENERAL(WARNING, "PMHello.Data initialization failed");
     return false;
   }
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   Signature signature;
   if (!Schnorr::GetInstance().Sign(tmp, key.first, key.second, signature)) {
@@ -3481,8 +3547,8 @@ bool Messenger::GetPMHello(const bytes& src, const unsigned int offset,
   Signature signature;
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.signature(), signature);
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   if (!Schnorr::GetInstance().Verify(tmp, 0, tmp.size(), signature, pubKey)) {
     LOG_GENERAL(WARNING, "PMHello signature wrong");
@@ -3527,8 +3593,8 @@ bool Messenger::SetDSPoWSubmission(
     return false;
   }
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   // We use MultiSig::SignKey to emphasize that this is for the
   // Proof-of-Possession (PoP) phase (refer to #1097)
@@ -3580,8 +3646,8 @@ bool Messenger::GetDSPoWSubmission(const bytes& src, const unsigned int offset,
   ProtobufByteArrayToNumber<uint128_t, UINT128_SIZE>(result.data().gasprice(),
                                                      gasPrice);
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   // We use MultiSig::VerifyKey to emphasize that this is for the
   // Proof-of-Possession (PoP) phase (refer to #1097)
@@ -3607,8 +3673,8 @@ bool Messenger::SetDSPoWPacketSubmission(
 
   SerializableToProtobufByteArray(keys.second, *result.mutable_pubkey());
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
   Signature signature;
   if (!Schnorr::GetInstance().Sign(tmp, keys.first, keys.second, signature)) {
     LOG_GENERAL(WARNING, "Failed to sign DSPoWPacketSubmission");
@@ -3642,8 +3708,8 @@ bool Messenger::GetDSPowPacketSubmission(const bytes& src,
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.pubkey(), pubKey);
   Signature signature;
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.signature(), signature);
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
   if (!Schnorr::GetInstance().Verify(tmp, 0, tmp.size(), signature, pubKey)) {
     LOG_GENERAL(WARNING, "DSPoWPacketSubmission signature wrong");
     return false;
@@ -3683,8 +3749,8 @@ bool Messenger::SetDSMicroBlockSubmission(bytes& dst, const unsigned int offset,
     return false;
   }
 
-  bytes tmp(result.mutable_data()->ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   Signature signature;
   if (!Schnorr::GetInstance().Sign(tmp, keys.first, keys.second, signature)) {
@@ -3724,8 +3790,8 @@ bool Messenger::GetDSMicroBlockSubmission(
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.signature(), signature);
 
   // Check signature
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
   if (!Schnorr::GetInstance().Verify(tmp, 0, tmp.size(), signature, pubKey)) {
     LOG_GENERAL(WARNING, "DSMicroBlockSubmission signature wrong");
     return false;
@@ -3756,7 +3822,9 @@ bool Messenger::SetDSDSBlockAnnouncement(
     const MapOfPubKeyPoW& dsWinnerPoWs, bytes& messageToCosign) {
   LOG_MARKER();
 
-  ConsensusAnnouncement announcement;
+  google::protobuf::Arena arena;
+  ConsensusAnnouncement& announcement =
+      CreateArenaMessage<ConsensusAnnouncement>(arena);
 
   // Set the DSBlock announcement parameters
 
@@ -3800,7 +3868,7 @@ bool Messenger::SetDSDSBlockAnnouncement(
   // first round of consensus
 
   messageToCosign.clear();
-  if (!dsBlock.GetHeader().Serialize(messageToCosign, 0)) {
+  if (!dsBlock.GetHeader().SerializeCached(messageToCosign, 0)) {
     LOG_GENERAL(WARNING, "DSBlockHeader serialization failed");
     return false;
   }
@@ -3818,7 +3886,9 @@ bool Messenger::GetDSDSBlockAnnouncement(
     bytes& messageToCosign) {
   LOG_MARKER();
 
-  ConsensusAnnouncement announcement;
+  google::protobuf::Arena arena;
+  ConsensusAnnouncement& announcement =
+      CreateArenaMessage<ConsensusAnnouncement>(arena);
 
   announcement.ParseFromArray(src.data() + offset, src.size() - offset);
 
@@ -3888,7 +3958,7 @@ bool Messenger::GetDSDSBlockAnnouncement(
   // round of consensus
 
   messageToCosign.clear();
-  if (!dsBlock.GetHeader().Serialize(messageToCosign, 0)) {
+  if (!dsBlock.GetHeader().SerializeCached(messageToCosign, 0)) {
     LOG_GENERAL(WARNING, "DSBlockHeader serialization failed");
     return false;
   }
@@ -3903,7 +3973,9 @@ bool Messenger::SetDSFinalBlockAnnouncement(
     const shared_ptr<MicroBlock>& microBlock, bytes& messageToCosign) {
   LOG_MARKER();
 
-  ConsensusAnnouncement announcement;
+  google::protobuf::Arena arena;
+  ConsensusAnnouncement& announcement =
+      CreateArenaMessage<ConsensusAnnouncement>(arena);
 
   // Set the FinalBlock announcement parameters
 
@@ -3932,7 +4004,7 @@ bool Messenger::SetDSFinalBlockAnnouncement(
   // first round of consensus
 
   messageToCosign.clear();
-  if (!txBlock.GetHeader().Serialize(messageToCosign, 0)) {
+  if (!txBlock.GetHeader().SerializeCached(messageToCosign, 0)) {
     LOG_GENERAL(WARNING, "TxBlockHeader serialization failed");
     return false;
   }
@@ -3949,7 +4021,9 @@ bool Messenger::GetDSFinalBlockAnnouncement(
     shared_ptr<MicroBlock>& microBlock, bytes& messageToCosign) {
   LOG_MARKER();
 
-  ConsensusAnnouncement announcement;
+  google::protobuf::Arena arena;
+  ConsensusAnnouncement& announcement =
+      CreateArenaMessage<ConsensusAnnouncement>(arena);
 
   announcement.ParseFromArray(src.data() + offset, src.size() - offset);
 
@@ -3989,7 +4063,7 @@ bool Messenger::GetDSFinalBlockAnnouncement(
   // round of consensus
 
   messageToCosign.clear();
-  if (!txBlock.GetHeader().Serialize(messageToCosign, 0)) {
+  if (!txBlock.GetHeader().SerializeCached(messageToCosign, 0)) {
     LOG_GENERAL(WARNING, "TxBlockHeader serialization failed");
     return false;
   }
@@ -4004,7 +4078,9 @@ bool Messenger::SetDSVCBlockAnnouncement(
     bytes& messageToCosign) {
   LOG_MARKER();
 
-  ConsensusAnnouncement announcement;
+  google::protobuf::Arena arena;
+  ConsensusAnnouncement& announcement =
+      CreateArenaMessage<ConsensusAnnouncement>(arena);
 
   // Set the VCBlock announcement parameters
 
@@ -4028,7 +4104,7 @@ bool Messenger::SetDSVCBlockAnnouncement(
   // first round of consensus
 
   messageToCosign.clear();
-  if (!vcBlock.GetHeader().Serialize(messageToCosign, 0)) {
+  if (!vcBlock.GetHeader().SerializeCached(messageToCosign, 0)) {
     LOG_GENERAL(WARNING, "VCBlockHeader serialization failed");
     return false;
   }
@@ -4044,7 +4120,9 @@ bool Messenger::GetDSVCBlockAnnouncement(
     const PubKey& leaderKey, VCBlock& vcBlock, bytes& messageToCosign) {
   LOG_MARKER();
 
-  ConsensusAnnouncement announcement;
+  google::protobuf::Arena arena;
+  ConsensusAnnouncement& announcement =
+      CreateArenaMessage<ConsensusAnnouncement>(arena);
 
   announcement.ParseFromArray(src.data() + offset, src.size() - offset);
 
@@ -4075,7 +4153,7 @@ bool Messenger::GetDSVCBlockAnnouncement(
   // round of consensus
 
   messageToCosign.clear();
-  if (!vcBlock.GetHeader().Serialize(messageToCosign, 0)) {
+  if (!vcBlock.GetHeader().SerializeCached(messageToCosign, 0)) {
     LOG_GENERAL(WARNING, "VCBlockHeader serialization failed");
     return false;
   }
@@ -4145,7 +4223,8 @@ bool Messenger::SetNodeVCDSBlocksMessage(
     const uint32_t& shardingStructureVersion, const DequeOfShard& shards) {
   LOG_MARKER();
 
-  NodeDSBlock result;
+  google::protobuf::Arena arena;
+  NodeDSBlock& result = CreateArenaMessage<NodeDSBlock>(arena);
 
   result.set_shardid(shardId);
   DSBlockToProtobuf(dsBlock, *result.mutable_dsblock());
@@ -4172,7 +4251,8 @@ bool Messenger::GetNodeVCDSBlocksMessage(const bytes& src,
                                          DequeOfShard& shards) {
   LOG_MARKER();
 
-  NodeDSBlock result;
+  google::protobuf::Arena arena;
+  NodeDSBlock& result = CreateArenaMessage<NodeDSBlock>(arena);
 
   result.ParseFromArray(src.data() + offset, src.size() - offset);
 
@@ -4206,7 +4286,8 @@ bool Messenger::SetNodeFinalBlock(bytes& dst, const unsigned int offset,
                                   const bytes& stateDelta) {
   LOG_MARKER();
 
-  NodeFinalBlock result;
+  google::protobuf::Arena arena;
+  NodeFinalBlock& result = CreateArenaMessage<NodeFinalBlock>(arena);
 
   result.set_dsblocknumber(dsBlockNumber);
   result.set_consensusid(consensusID);
@@ -4227,7 +4308,8 @@ bool Messenger::GetNodeFinalBlock(const bytes& src, const unsigned int offset,
                                   bytes& stateDelta) {
   LOG_MARKER();
 
-  NodeFinalBlock result;
+  google::protobuf::Arena arena;
+  NodeFinalBlock& result = CreateArenaMessage<NodeFinalBlock>(arena);
 
   result.ParseFromArray(src.data() + offset, src.size() - offset);
 
@@ -4253,7 +4335,9 @@ bool Messenger::SetNodeMBnForwardTransaction(
     const vector<TransactionWithReceipt>& txns) {
   LOG_MARKER();
 
-  NodeMBnForwardTransaction result;
+  google::protobuf::Arena arena;
+  NodeMBnForwardTransaction& result =
+      CreateArenaMessage<NodeMBnForwardTransaction>(arena);
 
   MicroBlockToProtobuf(microBlock, *result.mutable_microblock());
 
@@ -4281,7 +4365,9 @@ bool Messenger::GetNodeMBnForwardTransaction(const bytes& src,
                                              MBnForwardedTxnEntry& entry) {
   LOG_MARKER();
 
-  NodeMBnForwardTransaction result;
+  google::protobuf::Arena arena;
+  NodeMBnForwardTransaction& result =
+      CreateArenaMessage<NodeMBnForwardTransaction>(arena);
 
   result.ParseFromArray(src.data() + offset, src.size() - offset);
 
@@ -4306,6 +4392,67 @@ bool Messenger::GetNodeMBnForwardTransaction(const bytes& src,
   return true;
 }
 
+bool Messenger::SetNodeMBnForwardTransactionCompact(
+    bytes& dst, const unsigned int offset, const MicroBlock& microBlock,
+    const vector<TransactionWithReceipt>& txns, const uint32_t listenPort) {
+  LOG_MARKER();
+
+  NodeMBnForwardTransactionCompact result;
+
+  MicroBlockToProtobuf(microBlock, *result.mutable_microblock());
+
+  // The txn hashes in the microblock identify the bodies, so only the
+  // receipts that the receiver cannot derive on its own are sent
+  for (const auto& txn : txns) {
+    SerializableToProtobufByteArray(txn.GetTransactionReceipt(),
+                                    *result.add_txnreceipts());
+  }
+
+  result.set_listenport(listenPort);
+
+  if (!result.IsInitialized()) {
+    LOG_GENERAL(WARNING,
+                "SetNodeMBnForwardTransactionCompact initialization failed");
+    return false;
+  }
+
+  LOG_GENERAL(INFO, "EpochNum: " << microBlock.GetHeader().GetEpochNum()
+                                 << " MBHash: " << microBlock.GetBlockHash()
+                                 << " Receipts: " << txns.size());
+
+  return SerializeToArray(result, dst, offset);
+}
+
+bool Messenger::GetNodeMBnForwardTransactionCompact(
+    const bytes& src, const unsigned int offset, MicroBlock& microBlock,
+    vector<TransactionReceipt>& receipts, uint32_t& listenPort) {
+  LOG_MARKER();
+
+  NodeMBnForwardTransactionCompact result;
+
+  result.ParseFromArray(src.data() + offset, src.size() - offset);
+
+  if (!result.IsInitialized()) {
+    LOG_GENERAL(WARNING,
+                "NodeMBnForwardTransactionCompact initialization failed");
+    return false;
+  }
+
+  if (!ProtobufToMicroBlock(result.microblock(), microBlock)) {
+    return false;
+  }
+
+  for (const auto& receipt : result.txnreceipts()) {
+    TransactionReceipt tr;
+    PROTOBUFBYTEARRAYTOSERIALIZABLE(receipt, tr);
+    receipts.emplace_back(tr);
+  }
+
+  listenPort = result.listenport();
+
+  return true;
+}
+
 bool Messenger::SetNodeVCBlock(bytes& dst, const unsigned int offset,
                                const VCBlock& vcBlock) {
   LOG_MARKER();
@@ -4345,7 +4492,8 @@ bool Messenger::SetNodeForwardTxnBlock(
     const std::vector<Transaction>& txnsGenerated) {
   LOG_MARKER();
 
-  NodeForwardTxnBlock result;
+  google::protobuf::Arena arena;
+  NodeForwardTxnBlock& result = CreateArenaMessage<NodeForwardTxnBlock>(arena);
 
   result.set_epochnumber(epochNumber);
   result.set_dsblocknum(dsBlockNum);
@@ -4427,7 +4575,8 @@ bool Messenger::SetNodeForwardTxnBlock(bytes& dst, const unsigned int offset,
                                        const Signature& signature) {
   LOG_MARKER();
 
-  NodeForwardTxnBlock result;
+  google::protobuf::Arena arena;
+  NodeForwardTxnBlock& result = CreateArenaMessage<NodeForwardTxnBlock>(arena);
 
   result.set_epochnumber(epochNumber);
   result.set_dsblocknum(dsBlockNum);
@@ -4470,10 +4619,12 @@ bool Messenger::SetNodeForwardTxnBlock(bytes& dst, const unsigned int offset,
 bool Messenger::GetNodeForwardTxnBlock(
     const bytes& src, const unsigned int offset, uint64_t& epochNumber,
     uint64_t& dsBlockNum, uint32_t& shardId, PubKey& lookupPubKey,
-    std::vector<Transaction>& txns, Signature& signature) {
+    std::vector<Transaction>& txns, Signature& signature,
+    const std::function<bool(const TxnHash&)>& skipTxn) {
   LOG_MARKER();
 
-  NodeForwardTxnBlock result;
+  google::protobuf::Arena arena;
+  NodeForwardTxnBlock& result = CreateArenaMessage<NodeForwardTxnBlock>(arena);
 
   result.ParseFromArray(src.data() + offset, src.size() - offset);
 
@@ -4487,6 +4638,7 @@ bool Messenger::GetNodeForwardTxnBlock(
   shardId = result.shardid();
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.pubkey(), lookupPubKey);
 
+  unsigned int skippedCount = 0;
   if (result.transactions().size() > 0) {
     bytes tmp;
     if (!RepeatableToArray(result.transactions(), tmp, 0)) {
@@ -4501,21 +4653,54 @@ bool Messenger::GetNodeForwardTxnBlock(
     }
 
     for (const auto& txn : result.transactions()) {
+      // Decoding the sender pubkey and checking the txn signature dominate
+      // here, so txns the caller already has are dropped by their tranID
+      if (skipTxn && txn.tranid().size() == TxnHash::size) {
+        const TxnHash tranID(
+            reinterpret_cast<const uint8_t*>(txn.tranid().data()),
+            TxnHash::ConstructFromPointer);
+        if (skipTxn(tranID)) {
+          skippedCount++;
+          continue;
+        }
+      }
       Transaction t;
       if (!ProtobufToTransaction(txn, t)) {
         LOG_GENERAL(WARNING, "ProtobufToTransaction failed");
         return false;
       }
-      txns.emplace_back(t);
+      txns.emplace_back(move(t));
     }
   }
 
   LOG_GENERAL(INFO, "Epoch: " << epochNumber << " Shard: " << shardId
-                              << " Received txns: " << txns.size());
+                              << " Received txns: " << txns.size()
+                              << " Skipped: " << skippedCount);
 
   return true;
 }
 
+bool Messenger::CopyNodeForwardTxnBlock(const bytes& src,
+                                        const unsigned int srcOffset,
+                                        bytes& dst,
+                                        const unsigned int dstOffset) {
+  LOG_MARKER();
+
+  google::protobuf::Arena arena;
+  NodeForwardTxnBlock& result = CreateArenaMessage<NodeForwardTxnBlock>(arena);
+
+  result.ParseFromArray(src.data() + srcOffset, src.size() - srcOffset);
+
+  if (!result.IsInitialized()) {
+    LOG_GENERAL(WARNING, "NodeForwardTxnBlock initialization failed");
+    return false;
+  }
+
+  result.DiscardUnknownFields();
+
+  return SerializeToArray(result, dst, dstOffset);
+}
+
 bool Messenger::SetNodeMicroBlockAnnouncement(
     bytes& dst, const unsigned int offset, const uint32_t consensusID,
     const uint64_t blockNumber, const bytes& blockHash, const uint16_t leaderID,
@@ -4523,7 +4708,9 @@ bool Messenger::SetNodeMicroBlockAnnouncement(
     bytes& messageToCosign) {
   LOG_MARKER();
 
-  ConsensusAnnouncement announcement;
+  google::protobuf::Arena arena;
+  ConsensusAnnouncement& announcement =
+      CreateArenaMessage<ConsensusAnnouncement>(arena);
 
   // Set the MicroBlock announcement parameters
 
@@ -4547,7 +4734,7 @@ bool Messenger::SetNodeMicroBlockAnnouncement(
   // first round of consensus
 
   messageToCosign.clear();
-  if (!microBlock.GetHeader().Serialize(messageToCosign, 0)) {
+  if (!microBlock.GetHeader().SerializeCached(messageToCosign, 0)) {
     LOG_GENERAL(WARNING, "MicroBlockHeader serialization failed");
     return false;
   }
@@ -4563,7 +4750,9 @@ bool Messenger::GetNodeMicroBlockAnnouncement(
     const PubKey& leaderKey, MicroBlock& microBlock, bytes& messageToCosign) {
   LOG_MARKER();
 
-  ConsensusAnnouncement announcement;
+  google::protobuf::Arena arena;
+  ConsensusAnnouncement& announcement =
+      CreateArenaMessage<ConsensusAnnouncement>(arena);
 
   announcement.ParseFromArray(src.data() + offset, src.size() - offset);
 
@@ -4594,7 +4783,7 @@ bool Messenger::GetNodeMicroBlockAnnouncement(
   // round of consensus
 
   messageToCosign.clear();
-  if (!microBlock.GetHeader().Serialize(messageToCosign, 0)) {
+  if (!microBlock.GetHeader().SerializeCached(messageToCosign, 0)) {
     LOG_GENERAL(WARNING, "MicroBlockHeader serialization failed");
     return false;
   }
@@ -4609,7 +4798,9 @@ bool Messenger::SetNodeFallbackBlockAnnouncement(
     bytes& messageToCosign) {
   LOG_MARKER();
 
-  ConsensusAnnouncement announcement;
+  google::protobuf::Arena arena;
+  ConsensusAnnouncement& announcement =
+      CreateArenaMessage<ConsensusAnnouncement>(arena);
 
   // Set the FallbackBlock announcement parameters
 
@@ -4635,7 +4826,7 @@ bool Messenger::SetNodeFallbackBlockAnnouncement(
   // first round of consensus
 
   messageToCosign.clear();
-  if (!fallbackBlock.GetHeader().Serialize(messageToCosign, 0)) {
+  if (!fallbackBlock.GetHeader().SerializeCached(messageToCosign, 0)) {
     LOG_GENERAL(WARNING, "FallbackBlockHeader serialization failed");
     return false;
   }
@@ -4652,7 +4843,9 @@ bool Messenger::GetNodeFallbackBlockAnnouncement(
     bytes& messageToCosign) {
   LOG_MARKER();
 
-  ConsensusAnnouncement announcement;
+  google::protobuf::Arena arena;
+  ConsensusAnnouncement& announcement =
+      CreateArenaMessage<ConsensusAnnouncement>(arena);
 
   announcement.ParseFromArray(src.data() + offset, src.size() - offset);
 
@@ -4684,7 +4877,7 @@ bool Messenger::GetNodeFallbackBlockAnnouncement(
   // round of consensus
 
   messageToCosign.clear();
-  if (!fallbackBlock.GetHeader().Serialize(messageToCosign, 0)) {
+  if (!fallbackBlock.GetHeader().SerializeCached(messageToCosign, 0)) {
     LOG_GENERAL(WARNING, "FallbackBlockHeader serialization failed");
     return false;
   }
@@ -5112,7 +5305,9 @@ bool Messenger::SetLookupSetDSBlockFromSeed(bytes& dst,
                                             const vector<DSBlock>& dsBlocks) {
   LOG_MARKER();
 
-  LookupSetDSBlockFromSeed result;
+  google::protobuf::Arena arena;
+  LookupSetDSBlockFromSeed& result =
+      CreateArenaMessage<LookupSetDSBlockFromSeed>(arena);
 
   result.mutable_data()->set_lowblocknum(lowBlockNum);
   result.mutable_data()->set_highblocknum(highBlockNum);
@@ -5128,8 +5323,8 @@ bool Messenger::SetLookupSetDSBlockFromSeed(bytes& dst,
     LOG_GENERAL(WARNING, "LookupSetDSBlockFromSeed.Data initialization failed");
     return false;
   }
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   if (!Schnorr::GetInstance().Sign(tmp, lookupKey.first, lookupKey.second,
                                    signature)) {
@@ -5152,7 +5347,9 @@ bool Messenger::GetLookupSetDSBlockFromSeed(
     uint64_t& highBlockNum, PubKey& lookupPubKey, vector<DSBlock>& dsBlocks) {
   LOG_MARKER();
 
-  LookupSetDSBlockFromSeed result;
+  google::protobuf::Arena arena;
+  LookupSetDSBlockFromSeed& result =
+      CreateArenaMessage<LookupSetDSBlockFromSeed>(arena);
 
   result.ParseFromArray(src.data() + offset, src.size() - offset);
 
@@ -5174,8 +5371,8 @@ bool Messenger::GetLookupSetDSBlockFromSeed(
     dsBlocks.emplace_back(dsblock);
   }
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   Signature signature;
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.signature(), signature);
@@ -5232,6 +5429,45 @@ bool Messenger::GetLookupGetTxBlockFromSeed(const bytes& src,
   return true;
 }
 
+bool Messenger::SetLookupSubscribeBlocks(bytes& dst, const unsigned int offset,
+                                         const uint64_t nextBlockNum,
+                                         const uint32_t listenPort) {
+  LOG_MARKER();
+
+  LookupSubscribeBlocks result;
+
+  result.set_nextblocknum(nextBlockNum);
+  result.set_listenport(listenPort);
+
+  if (!result.IsInitialized()) {
+    LOG_GENERAL(WARNING, "LookupSubscribeBlocks initialization failed");
+    return false;
+  }
+
+  return SerializeToArray(result, dst, offset);
+}
+
+bool Messenger::GetLookupSubscribeBlocks(const bytes& src,
+                                         const unsigned int offset,
+                                         uint64_t& nextBlockNum,
+                                         uint32_t& listenPort) {
+  LOG_MARKER();
+
+  LookupSubscribeBlocks result;
+
+  result.ParseFromArray(src.data() + offset, src.size() - offset);
+
+  if (!result.IsInitialized()) {
+    LOG_GENERAL(WARNING, "LookupSubscribeBlocks initialization failed");
+    return false;
+  }
+
+  nextBlockNum = result.nextblocknum();
+  listenPort = result.listenport();
+
+  return true;
+}
+
 bool Messenger::SetLookupSetTxBlockFromSeed(bytes& dst,
                                             const unsigned int offset,
                                             const uint64_t lowBlockNum,
@@ -5240,7 +5476,9 @@ bool Messenger::SetLookupSetTxBlockFromSeed(bytes& dst,
                                             const vector<TxBlock>& txBlocks) {
   LOG_MARKER();
 
-  LookupSetTxBlockFromSeed result;
+  google::protobuf::Arena arena;
+  LookupSetTxBlockFromSeed& result =
+      CreateArenaMessage<LookupSetTxBlockFromSeed>(arena);
 
   result.mutable_data()->set_lowblocknum(lowBlockNum);
   result.mutable_data()->set_highblocknum(highBlockNum);
@@ -5257,8 +5495,8 @@ bool Messenger::SetLookupSetTxBlockFromSeed(bytes& dst,
     return false;
   }
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   if (!Schnorr::GetInstance().Sign(tmp, lookupKey.first, lookupKey.second,
                                    signature)) {
@@ -5281,7 +5519,9 @@ bool Messenger::GetLookupSetTxBlockFromSeed(
     uint64_t& highBlockNum, PubKey& lookupPubKey, vector<TxBlock>& txBlocks) {
   LOG_MARKER();
 
-  LookupSetTxBlockFromSeed result;
+  google::protobuf::Arena arena;
+  LookupSetTxBlockFromSeed& result =
+      CreateArenaMessage<LookupSetTxBlockFromSeed>(arena);
 
   google::protobuf::io::ArrayInputStream arrayIn(src.data() + offset,
                                                  src.size() - offset);
@@ -5307,8 +5547,8 @@ bool Messenger::GetLookupSetTxBlockFromSeed(
     txBlocks.emplace_back(block);
   }
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.pubkey(), lookupPubKey);
   Signature signature;
@@ -5427,8 +5667,8 @@ bool Messenger::SetLookupSetStateDeltaFromSeed(bytes& dst,
                 "LookupSetStateDeltaFromSeed.Data initialization failed");
     return false;
   }
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   if (!Schnorr::GetInstance().Sign(tmp, lookupKey.first, lookupKey.second,
                                    signature)) {
@@ -5469,8 +5709,8 @@ bool Messenger::SetLookupSetStateDeltasFromSeed(
                 "LookupSetStateDeltasFromSeed.Data initialization failed");
     return false;
   }
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   if (!Schnorr::GetInstance().Sign(tmp, lookupKey.first, lookupKey.second,
                                    signature)) {
@@ -5510,8 +5750,8 @@ bool Messenger::GetLookupSetStateDeltaFromSeed(const bytes& src,
   std::copy(result.data().statedelta().begin(),
             result.data().statedelta().end(), stateDelta.begin());
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.pubkey(), lookupPubKey);
   Signature signature;
@@ -5549,8 +5789,8 @@ bool Messenger::GetLookupSetStateDeltasFromSeed(
     stateDeltas.emplace_back(tmp);
   }
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.pubkey(), lookupPubKey);
   Signature signature;
@@ -5565,12 +5805,18 @@ bool Messenger::GetLookupSetStateDeltasFromSeed(
 }
 
 bool Messenger::SetLookupGetStateFromSeed(bytes& dst, const unsigned int offset,
-                                          const uint32_t listenPort) {
+                                          const uint32_t listenPort,
+                                          const uint32_t chunkIndex,
+                                          const uint32_t numChunks) {
   LOG_MARKER();
 
   LookupGetStateFromSeed result;
 
   result.set_listenport(listenPort);
+  if (numChunks > 0) {
+    result.set_chunkindex(chunkIndex);
+    result.set_numchunks(numChunks);
+  }
 
   if (!result.IsInitialized()) {
     LOG_GENERAL(WARNING, "LookupGetStateFromSeed initialization failed");
@@ -5582,7 +5828,9 @@ bool Messenger::SetLookupGetStateFromSeed(bytes& dst, const unsigned int offset,
 
 bool Messenger::GetLookupGetStateFromSeed(const bytes& src,
                                           const unsigned int offset,
-                                          uint32_t& listenPort) {
+                                          uint32_t& listenPort,
+                                          uint32_t& chunkIndex,
+                                          uint32_t& numChunks) {
   LOG_MARKER();
 
   LookupGetStateFromSeed result;
@@ -5595,27 +5843,60 @@ bool Messenger::GetLookupGetStateFromSeed(const bytes& src,
   }
 
   listenPort = result.listenport();
+  chunkIndex = result.chunkindex();
+  numChunks = result.numchunks();
 
   return true;
 }
 
+// Appends what a state chunk signature covers besides the accounts
+void AppendStateChunkPosition(bytes& dst, const dev::h256& stateRoot,
+                              const uint32_t chunkIndex,
+                              const uint32_t numChunks) {
+  dst.insert(dst.end(), stateRoot.begin(), stateRoot.end());
+  Serializable::SetNumber<uint32_t>(dst, dst.size(), chunkIndex,
+                                    sizeof(uint32_t));
+  Serializable::SetNumber<uint32_t>(dst, dst.size(), numChunks,
+                                    sizeof(uint32_t));
+}
+
 bool Messenger::SetLookupSetStateFromSeed(bytes& dst, const unsigned int offset,
                                           const PairOfKey& lookupKey,
-                                          const AccountStore& accountStore) {
+                                          const AccountStore& accountStore,
+                                          const uint32_t chunkIndex,
+                                          const uint32_t numChunks) {
   LOG_MARKER();
 
-  LookupSetStateFromSeed result;
+  google::protobuf::Arena arena;
+  LookupSetStateFromSeed& result =
+      CreateArenaMessage<LookupSetStateFromSeed>(arena);
 
   SerializableToProtobufByteArray(lookupKey.second, *result.mutable_pubkey());
   Signature signature;
 
   bytes tmp;
 
-  if (!accountStore.Serialize(tmp, 0)) {
-    LOG_GENERAL(WARNING, "Failed to serialize AccountStore");
-    return false;
+  if (numChunks == 0) {
+    if (!accountStore.Serialize(tmp, 0)) {
+      LOG_GENERAL(WARNING, "Failed to serialize AccountStore");
+      return false;
+    }
+    result.mutable_accountstore()->set_data(tmp.data(), tmp.size());
+  } else {
+    dev::h256 stateRoot;
+    if (!accountStore.SerializeChunk(tmp, 0, chunkIndex, numChunks,
+                                     stateRoot)) {
+      LOG_GENERAL(WARNING, "Failed to serialize AccountStore chunk");
+      return false;
+    }
+    result.mutable_accountstore()->set_data(tmp.data(), tmp.size());
+    result.set_chunkindex(chunkIndex);
+    result.set_numchunks(numChunks);
+    result.mutable_stateroot()->set_data(stateRoot.data(), stateRoot.size);
+
+    // The chunk position and state root are signed along with the accounts
+    AppendStateChunkPosition(tmp, stateRoot, chunkIndex, numChunks);
   }
-  result.mutable_accountstore()->set_data(tmp.data(), tmp.size());
 
   if (!Schnorr::GetInstance().Sign(tmp, lookupKey.first, lookupKey.second,
                                    signature)) {
@@ -5636,10 +5917,15 @@ bool Messenger::SetLookupSetStateFromSeed(bytes& dst, const unsigned int offset,
 bool Messenger::GetLookupSetStateFromSeed(const bytes& src,
                                           const unsigned int offset,
                                           PubKey& lookupPubKey,
-                                          bytes& accountStoreBytes) {
+                                          bytes& accountStoreBytes,
+                                          uint32_t& chunkIndex,
+                                          uint32_t& numChunks,
+                                          dev::h256& stateRoot) {
   LOG_MARKER();
 
-  LookupSetStateFromSeed result;
+  google::protobuf::Arena arena;
+  LookupSetStateFromSeed& result =
+      CreateArenaMessage<LookupSetStateFromSeed>(arena);
 
   google::protobuf::io::ArrayInputStream arrayIn(src.data() + offset,
                                                  src.size() - offset);
@@ -5660,8 +5946,22 @@ bool Messenger::GetLookupSetStateFromSeed(const bytes& src,
   copy(result.accountstore().data().begin(), result.accountstore().data().end(),
        back_inserter(accountStoreBytes));
 
-  if (!Schnorr::GetInstance().Verify(accountStoreBytes, signature,
-                                     lookupPubKey)) {
+  chunkIndex = result.chunkindex();
+  numChunks = result.numchunks();
+
+  bytes signedData = accountStoreBytes;
+  if (numChunks > 0) {
+    if (result.stateroot().data().size() != stateRoot.size) {
+      LOG_GENERAL(WARNING, "Invalid state root size in state chunk");
+      return false;
+    }
+    copy(result.stateroot().data().begin(), result.stateroot().data().end(),
+         stateRoot.asArray().begin());
+
+    AppendStateChunkPosition(signedData, stateRoot, chunkIndex, numChunks);
+  }
+
+  if (!Schnorr::GetInstance().Verify(signedData, signature, lookupPubKey)) {
     LOG_GENERAL(WARNING, "Invalid signature in accounts");
     return false;
   }
@@ -5686,8 +5986,8 @@ bool Messenger::SetLookupSetLookupOffline(bytes& dst, const unsigned int offset,
     LOG_GENERAL(WARNING, "LookupSetLookupOffline.Data initialization failed");
     return false;
   }
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   if (!Schnorr::GetInstance().Sign(tmp, lookupKey.first, lookupKey.second,
                                    signature)) {
@@ -5724,8 +6024,8 @@ bool Messenger::GetLookupSetLookupOffline(const bytes& src,
   listenPort = result.data().listenport();
   msgType = result.data().msgtype();
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.pubkey(), lookupPubkey);
   Signature signature;
@@ -5756,8 +6056,8 @@ bool Messenger::SetLookupSetLookupOnline(bytes& dst, const unsigned int offset,
     LOG_GENERAL(WARNING, "LookupSetLookupOnline.Data initialization failed");
     return false;
   }
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   if (!Schnorr::GetInstance().Sign(tmp, lookupKey.first, lookupKey.second,
                                    signature)) {
@@ -5792,8 +6092,8 @@ bool Messenger::GetLookupSetLookupOnline(const bytes& src,
   msgType = result.data().msgtype();
   listenPort = result.data().listenport();
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.pubkey(), pubKey);
 
@@ -5941,8 +6241,8 @@ bool Messenger::GetLookupSetRaiseStartPoW(const bytes& src,
   msgType = result.data().msgtype();
   blockNumber = result.data().blocknumber();
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.pubkey(), dsPubKey);
   Signature signature;
@@ -5973,8 +6273,8 @@ bool Messenger::SetLookupSetRaiseStartPoW(bytes& dst, const unsigned int offset,
     LOG_GENERAL(WARNING, "LookupRaiseStartPoW.Data initialization failed");
     return false;
   }
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   if (!Schnorr::GetInstance().Sign(tmp, dsKey.first, dsKey.second, signature)) {
     LOG_GENERAL(WARNING, "Failed to sign raise start PoW message");
@@ -6009,8 +6309,8 @@ bool Messenger::SetLookupGetStartPoWFromSeed(bytes& dst,
                 "LookupGetStartPoWFromSeed.Data initialization failed");
     return false;
   }
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   if (!Schnorr::GetInstance().Sign(tmp, keys.first, keys.second, signature)) {
     LOG_GENERAL(WARNING, "Failed to sign GetStartPoWFromSeed message");
@@ -6043,8 +6343,8 @@ bool Messenger::GetLookupGetStartPoWFromSeed(const bytes& src,
     return false;
   }
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   PubKey pubKey;
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.pubkey(), pubKey);
@@ -6126,7 +6426,9 @@ bool Messenger::SetForwardTxnBlockFromSeed(
     bytes& dst, const unsigned int offset,
     const vector<Transaction>& shardTransactions,
     const vector<Transaction>& dsTransactions) {
-  LookupForwardTxnsFromSeed result;
+  google::protobuf::Arena arena;
+  LookupForwardTxnsFromSeed& result =
+      CreateArenaMessage<LookupForwardTxnsFromSeed>(arena);
 
   if (!shardTransactions.empty()) {
     TransactionArrayToProtobuf(shardTransactions,
@@ -6148,7 +6450,9 @@ bool Messenger::GetForwardTxnBlockFromSeed(
     const bytes& src, const unsigned int offset,
     vector<Transaction>& shardTransactions,
     vector<Transaction>& dsTransactions) {
-  LookupForwardTxnsFromSeed result;
+  google::protobuf::Arena arena;
+  LookupForwardTxnsFromSeed& result =
+      CreateArenaMessage<LookupForwardTxnsFromSeed>(arena);
 
   result.ParseFromArray(src.data() + offset, src.size() - offset);
 
@@ -6331,7 +6635,9 @@ bool Messenger::SetLookupSetMicroBlockFromLookup(
     bytes& dst, const unsigned int offset, const PairOfKey& lookupKey,
     const vector<MicroBlock>& mbs) {
   LOG_MARKER();
-  LookupSetMicroBlockFromLookup result;
+  google::protobuf::Arena arena;
+  LookupSetMicroBlockFromLookup& result =
+      CreateArenaMessage<LookupSetMicroBlockFromLookup>(arena);
 
   for (const auto& mb : mbs) {
     MicroBlockToProtobuf(mb, *result.add_microblocks());
@@ -6368,7 +6674,9 @@ bool Messenger::GetLookupSetMicroBlockFromLookup(const bytes& src,
                                                  PubKey& lookupPubKey,
                                                  vector<MicroBlock>& mbs) {
   LOG_MARKER();
-  LookupSetMicroBlockFromLookup result;
+  google::protobuf::Arena arena;
+  LookupSetMicroBlockFromLookup& result =
+      CreateArenaMessage<LookupSetMicroBlockFromLookup>(arena);
 
   result.ParseFromArray(src.data() + offset, src.size() - offset);
 
@@ -6534,6 +6842,97 @@ bool Messenger::GetLookupSetTxnsFromLookup(
   return true;
 }
 
+bool Messenger::SetLookupGetMicroBlockTxnsFromLookup(
+    bytes& dst, const unsigned int offset,
+    const vector<pair<uint64_t, uint32_t>>& microBlocks,
+    const uint32_t portNo) {
+  LOG_MARKER();
+
+  LookupGetMicroBlockTxnsFromLookup result;
+
+  result.set_portno(portNo);
+  for (const auto& microBlock : microBlocks) {
+    auto protoMicroBlock = result.add_microblocks();
+    protoMicroBlock->set_epochnum(microBlock.first);
+    protoMicroBlock->set_shardid(microBlock.second);
+  }
+
+  if (!result.IsInitialized()) {
+    LOG_GENERAL(WARNING,
+                "LookupGetMicroBlockTxnsFromLookup initialization failed");
+    return false;
+  }
+
+  return SerializeToArray(result, dst, offset);
+}
+
+bool Messenger::GetLookupGetMicroBlockTxnsFromLookup(
+    const bytes& src, const unsigned int offset,
+    vector<pair<uint64_t, uint32_t>>& microBlocks, uint32_t& portNo) {
+  LOG_MARKER();
+
+  LookupGetMicroBlockTxnsFromLookup result;
+
+  result.ParseFromArray(src.data() + offset, src.size() - offset);
+
+  if (!result.IsInitialized()) {
+    LOG_GENERAL(WARNING,
+                "LookupGetMicroBlockTxnsFromLookup initialization failed");
+    return false;
+  }
+
+  portNo = result.portno();
+  microBlocks.clear();
+  for (const auto& protoMicroBlock : result.microblocks()) {
+    microBlocks.emplace_back(protoMicroBlock.epochnum(),
+                             protoMicroBlock.shardid());
+  }
+
+  return true;
+}
+
+bool Messenger::SetLookupSetMicroBlockTxnsFromLookup(
+    bytes& dst, const unsigned int offset, const vector<bytes>& records) {
+  LOG_MARKER();
+
+  LookupSetMicroBlockTxnsFromLookup result;
+
+  for (const auto& record : records) {
+    result.add_records(record.data(), record.size());
+  }
+
+  if (!result.IsInitialized()) {
+    LOG_GENERAL(WARNING,
+                "LookupSetMicroBlockTxnsFromLookup initialization failed");
+    return false;
+  }
+
+  return SerializeToArray(result, dst, offset);
+}
+
+bool Messenger::GetLookupSetMicroBlockTxnsFromLookup(const bytes& src,
+                                                     const unsigned int offset,
+                                                     vector<bytes>& records) {
+  LOG_MARKER();
+
+  LookupSetMicroBlockTxnsFromLookup result;
+
+  result.ParseFromArray(src.data() + offset, src.size() - offset);
+
+  if (!result.IsInitialized()) {
+    LOG_GENERAL(WARNING,
+                "LookupSetMicroBlockTxnsFromLookup initialization failed");
+    return false;
+  }
+
+  records.clear();
+  for (const auto& record : result.records()) {
+    records.emplace_back(record.begin(), record.end());
+  }
+
+  return true;
+}
+
 bool Messenger::SetLookupGetDirectoryBlocksFromSeed(bytes& dst,
                                                     const unsigned int offset,
                                                     const uint32_t portNo,
@@ -6613,8 +7012,8 @@ bool Messenger::SetLookupSetDirectoryBlocksFromSeed(
     return false;
   }
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   if (!Schnorr::GetInstance().Sign(tmp, lookupKey.first, lookupKey.second,
                                    signature)) {
@@ -6653,8 +7052,8 @@ bool Messenger::GetLookupSetDirectoryBlocksFromSeed(
     return false;
   }
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.pubkey(), pubKey);
 
@@ -6731,6 +7130,57 @@ bool Messenger::GetLookupSetDirectoryBlocksFromSeed(
 // Consensus messages
 // ============================================================================
 
+bool Messenger::PeekConsensusBlockNumber(const bytes& src,
+                                         const unsigned int offset,
+                                         uint64_t& blockNumber) {
+  using google::protobuf::internal::WireFormatLite;
+
+  if (offset > src.size()) {
+    LOG_GENERAL(WARNING, "Offset " << offset << " beyond size " << src.size());
+    return false;
+  }
+
+  // Every consensus message keeps its block number at the same place in its
+  // consensus info, so any of them will do for the field numbers
+  const uint32_t INFO_TAG = WireFormatLite::MakeTag(
+      ConsensusCommit::kConsensusinfoFieldNumber,
+      WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+  const uint32_t BLOCKNUM_TAG = WireFormatLite::MakeTag(
+      ConsensusCommit::ConsensusInfo::kBlocknumberFieldNumber,
+      WireFormatLite::WIRETYPE_VARINT);
+
+  google::protobuf::io::CodedInputStream codedIn(src.data() + offset,
+                                                 src.size() - offset);
+
+  for (uint32_t tag = codedIn.ReadTag(); tag != 0; tag = codedIn.ReadTag()) {
+    if (tag != INFO_TAG) {
+      if (!WireFormatLite::SkipField(&codedIn, tag)) {
+        break;
+      }
+      continue;
+    }
+
+    uint32_t length = 0;
+    if (!codedIn.ReadVarint32(&length)) {
+      break;
+    }
+    codedIn.PushLimit(length);
+
+    for (tag = codedIn.ReadTag(); tag != 0; tag = codedIn.ReadTag()) {
+      if (tag == BLOCKNUM_TAG) {
+        return codedIn.ReadVarint64(&blockNumber);
+      }
+      if (!WireFormatLite::SkipField(&codedIn, tag)) {
+        break;
+      }
+    }
+    break;
+  }
+
+  LOG_GENERAL(WARNING, "Consensus message has no block number");
+  return false;
+}
+
 bool Messenger::SetConsensusCommit(
     bytes& dst, const unsigned int offset, const uint32_t consensusID,
     const uint64_t blockNumber, const bytes& blockHash, const uint16_t backupID,
@@ -6758,8 +7208,8 @@ bool Messenger::SetConsensusCommit(
     return false;
   }
 
-  bytes tmp(result.consensusinfo().ByteSize());
-  result.consensusinfo().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.consensusinfo(), tmp, 0);
 
   Signature signature;
 
@@ -6852,8 +7302,8 @@ bool Messenger::GetConsensusCommit(const bytes& src, const unsigned int offset,
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.consensusinfo().commitpointhash(),
                                   commitPointHash);
 
-  bytes tmp(result.consensusinfo().ByteSize());
-  result.consensusinfo().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.consensusinfo(), tmp, 0);
 
   Signature signature;
 
@@ -6898,8 +7348,8 @@ bool Messenger::SetConsensusChallenge(
     return false;
   }
 
-  bytes tmp(result.consensusinfo().ByteSize());
-  result.consensusinfo().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.consensusinfo(), tmp, 0);
 
   Signature signature;
 
@@ -6992,8 +7442,8 @@ bool Messenger::GetConsensusChallenge(
     subsetInfo.emplace_back(si);
   }
 
-  bytes tmp(result.consensusinfo().ByteSize());
-  result.consensusinfo().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.consensusinfo(), tmp, 0);
 
   Signature signature;
 
@@ -7032,8 +7482,8 @@ bool Messenger::SetConsensusResponse(
     return false;
   }
 
-  bytes tmp(result.consensusinfo().ByteSize());
-  result.consensusinfo().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.consensusinfo(), tmp, 0);
 
   Signature signature;
 
@@ -7126,8 +7576,8 @@ bool Messenger::GetConsensusResponse(
     subsetInfo.emplace_back(si);
   }
 
-  bytes tmp(result.consensusinfo().ByteSize());
-  result.consensusinfo().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.consensusinfo(), tmp, 0);
 
   Signature signature;
 
@@ -7145,7 +7595,7 @@ bool Messenger::GetConsensusResponse(
 bool Messenger::SetConsensusCollectiveSig(
     bytes& dst, const unsigned int offset, const uint32_t consensusID,
     const uint64_t blockNumber, const bytes& blockHash, const uint16_t leaderID,
-    const Signature& collectiveSig, const vector<bool>& bitmap,
+    const Signature& collectiveSig, const BitVector& bitmap,
     const PairOfKey& leaderKey) {
   LOG_MARKER();
 
@@ -7158,8 +7608,8 @@ bool Messenger::SetConsensusCollectiveSig(
   result.mutable_consensusinfo()->set_leaderid(leaderID);
   SerializableToProtobufByteArray(
       collectiveSig, *result.mutable_consensusinfo()->mutable_collectivesig());
-  for (const auto& i : bitmap) {
-    result.mutable_consensusinfo()->add_bitmap(i);
+  for (size_t i = 0; i < bitmap.size(); i++) {
+    result.mutable_consensusinfo()->add_bitmap(bitmap[i]);
   }
 
   if (!result.consensusinfo().IsInitialized()) {
@@ -7167,8 +7617,8 @@ bool Messenger::SetConsensusCollectiveSig(
     return false;
   }
 
-  bytes tmp(result.consensusinfo().ByteSize());
-  result.consensusinfo().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.consensusinfo(), tmp, 0);
 
   Signature signature;
 
@@ -7192,7 +7642,7 @@ bool Messenger::SetConsensusCollectiveSig(
 bool Messenger::GetConsensusCollectiveSig(
     const bytes& src, const unsigned int offset, const uint32_t consensusID,
     const uint64_t blockNumber, const bytes& blockHash, const uint16_t leaderID,
-    vector<bool>& bitmap, Signature& collectiveSig, const PubKey& leaderKey) {
+    BitVector& bitmap, Signature& collectiveSig, const PubKey& leaderKey) {
   LOG_MARKER();
 
   ConsensusCollectiveSig result;
@@ -7254,12 +7704,13 @@ bool Messenger::GetConsensusCollectiveSig(
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.consensusinfo().collectivesig(),
                                   collectiveSig);
 
-  for (const auto& i : result.consensusinfo().bitmap()) {
-    bitmap.emplace_back(i);
+  bitmap = BitVector(result.consensusinfo().bitmap().size());
+  for (int i = 0; i < result.consensusinfo().bitmap().size(); i++) {
+    bitmap[i] = result.consensusinfo().bitmap(i);
   }
 
-  bytes tmp(result.consensusinfo().ByteSize());
-  result.consensusinfo().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.consensusinfo(), tmp, 0);
 
   Signature signature;
 
@@ -7294,8 +7745,8 @@ bool Messenger::SetConsensusCommitFailure(
     return false;
   }
 
-  bytes tmp(result.consensusinfo().ByteSize());
-  result.consensusinfo().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.consensusinfo(), tmp, 0);
 
   Signature signature;
 
@@ -7384,8 +7835,8 @@ bool Messenger::GetConsensusCommitFailure(
   copy(result.consensusinfo().errormsg().begin(),
        result.consensusinfo().errormsg().end(), errorMsg.begin());
 
-  bytes tmp(result.consensusinfo().ByteSize());
-  result.consensusinfo().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.consensusinfo(), tmp, 0);
 
   Signature signature;
 
@@ -7420,8 +7871,8 @@ bool Messenger::SetConsensusConsensusFailure(
     return false;
   }
 
-  bytes tmp(result.consensusinfo().ByteSize());
-  result.consensusinfo().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.consensusinfo(), tmp, 0);
 
   Signature signature;
 
@@ -7504,8 +7955,8 @@ bool Messenger::GetConsensusConsensusFailure(
     return false;
   }
 
-  bytes tmp(result.consensusinfo().ByteSize());
-  result.consensusinfo().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.consensusinfo(), tmp, 0);
 
   Signature signature;
 
@@ -7595,8 +8046,8 @@ bool Messenger::SetVCNodeSetDSTxBlockFromSeed(bytes& dst,
     return false;
   }
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   if (!Schnorr::GetInstance().Sign(tmp, lookupKey.first, lookupKey.second,
                                    signature)) {
@@ -7648,8 +8099,8 @@ bool Messenger::GetVCNodeSetDSTxBlockFromSeed(const bytes& src,
 
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.pubkey(), lookupPubKey);
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   Signature signature;
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.signature(), signature);
@@ -7683,8 +8134,8 @@ bool Messenger::SetDSLookupNewDSGuardNetworkInfo(
     return false;
   }
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   Signature signature;
   if (!Schnorr::GetInstance().Sign(tmp, dsguardkey.first, dsguardkey.second,
@@ -7724,8 +8175,8 @@ bool Messenger::GetDSLookupNewDSGuardNetworkInfo(
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.signature(), signature);
 
   // Check signature
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
   if (!Schnorr::GetInstance().Verify(tmp, 0, tmp.size(), signature,
                                      dsGuardPubkey)) {
     LOG_GENERAL(WARNING, "DSLookupSetDSGuardNetworkInfoUpdate signature wrong");
@@ -7751,8 +8202,8 @@ bool Messenger::SetLookupGetNewDSGuardNetworkInfoFromLookup(
   SerializableToProtobufByteArray(lookupKey.second, *result.mutable_pubkey());
 
   if (result.data().IsInitialized()) {
-    bytes tmp(result.data().ByteSize());
-    result.data().SerializeToArray(tmp.data(), tmp.size());
+    bytes tmp;
+    SerializeToArray(result.data(), tmp, 0);
 
     Signature signature;
     if (!Schnorr::GetInstance().Sign(tmp, lookupKey.first, lookupKey.second,
@@ -7795,8 +8246,8 @@ bool Messenger::GetLookupGetNewDSGuardNetworkInfoFromLookup(
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.signature(), signature);
 
   // Check signature
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
   if (!Schnorr::GetInstance().Verify(tmp, 0, tmp.size(), signature,
                                      senderPubKey)) {
     LOG_GENERAL(WARNING, "DSMicroBlockSubmission signature wrong");
@@ -7832,8 +8283,8 @@ bool Messenger::SetNodeSetNewDSGuardNetworkInfo(
                 "NodeSetGuardNodeNetworkInfoUpdate.Data initialization failed");
     return false;
   }
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
 
   Signature signature;
   if (!Schnorr::GetInstance().Sign(tmp, lookupKey.first, lookupKey.second,
@@ -7870,8 +8321,8 @@ bool Messenger::SetNodeGetNewDSGuardNetworkInfo(
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.lookuppubkey(), lookupPubKey);
   Signature signature;
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.signature(), signature);
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
   if (!Schnorr::GetInstance().Verify(tmp, 0, tmp.size(), signature,
                                      lookupPubKey)) {
     LOG_GENERAL(WARNING, "NodeSetGuardNodeNetworkInfoUpdate signature wrong");
@@ -7909,8 +8360,8 @@ bool Messenger::SetSeedNodeHistoricalDB(bytes& dst, const unsigned int offset,
     return false;
   }
 
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
   Signature signature;
   if (!Schnorr::GetInstance().Sign(tmp, archivalKeys.first, archivalKeys.second,
                                    signature)) {
@@ -7942,8 +8393,8 @@ bool Messenger::GetSeedNodeHistoricalDB(const bytes& src,
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.pubkey(), archivalPubKey);
   Signature signature;
   PROTOBUFBYTEARRAYTOSERIALIZABLE(result.signature(), signature);
-  bytes tmp(result.data().ByteSize());
-  result.data().SerializeToArray(tmp.data(), tmp.size());
+  bytes tmp;
+  SerializeToArray(result.data(), tmp, 0);
   if (!Schnorr::GetInstance().Verify(tmp, 0, tmp.size(), signature,
                                      archivalPubKey)) {
     LOG_GENERAL(WARNING, "SeedSetHistoricalDB signature wrong");
@@ -18,6 +18,8 @@
 #define __MESSENGER_H__
 
 #include <boost/variant.hpp>
+#include <functional>
+#include <unordered_set>
 #include "common/BaseType.h"
 #include "common/Serializable.h"
 #include "libCrypto/Schnorr.h"
@@ -199,6 +201,11 @@ class Messenger {
   static bool StateDeltaToAddressMap(
       const bytes& src, const unsigned int offset,
       std::unordered_map<Address, boost::multiprecision::int256_t>& accountMap);
+  /// Addresses of the accounts whose code or storage the delta changes,
+  /// whose deltas are the only ones that do not commute with each other
+  static bool StateDeltaToContractAddresses(
+      const bytes& src, const unsigned int offset,
+      std::unordered_set<Address>& addresses);
 
   static bool SetBlockLink(bytes& dst, const unsigned int offset,
                            const std::tuple<uint32_t, uint64_t, uint64_t,
@@ -371,6 +378,14 @@ class Messenger {
                                            const unsigned int offset,
                                            MBnForwardedTxnEntry& entry);
 
+  static bool SetNodeMBnForwardTransactionCompact(
+      bytes& dst, const unsigned int offset, const MicroBlock& microBlock,
+      const std::vector<TransactionWithReceipt>& txns,
+      const uint32_t listenPort);
+  static bool GetNodeMBnForwardTransactionCompact(
+      const bytes& src, const unsigned int offset, MicroBlock& microBlock,
+      std::vector<TransactionReceipt>& receipts, uint32_t& listenPort);
+
   static bool SetNodeForwardTxnBlock(
       bytes& dst, const unsigned int offset, const uint64_t& epochNumber,
       const uint64_t& dsBlockNum, const uint32_t& shardId,
@@ -383,10 +398,18 @@ class Messenger {
                                      const PubKey& lookupKey,
                                      std::vector<Transaction>& txns,
                                      const Signature& signature);
+  /// Txns for which skipTxn returns true are left out of txns without being
+  /// decoded or verified; the packet signature still covers them
   static bool GetNodeForwardTxnBlock(
       const bytes& src, const unsigned int offset, uint64_t& epochNumber,
       uint64_t& dsBlockNum, uint32_t& shardId, PubKey& lookupPubKey,
-      std::vector<Transaction>& txns, Signature& signature);
+      std::vector<Transaction>& txns, Signature& signature,
+      const std::function<bool(const TxnHash&)>& skipTxn = nullptr);
+  /// Re-serializes the txn packet in src without any unknown or trailing data,
+  /// leaving the txns encoded as they are
+  static bool CopyNodeForwardTxnBlock(const bytes& src,
+                                      const unsigned int srcOffset, bytes& dst,
+                                      const unsigned int dstOffset);
 
   static bool SetNodeMicroBlockAnnouncement(
       bytes& dst, const unsigned int offset, const uint32_t consensusID,
@@ -492,6 +515,13 @@ class Messenger {
                                           uint64_t& lowBlockNum,
                                           uint64_t& highBlockNum,
                                           uint32_t& listenPort);
+  static bool SetLookupSubscribeBlocks(bytes& dst, const unsigned int offset,
+                                       const uint64_t nextBlockNum,
+                                       const uint32_t listenPort);
+  static bool GetLookupSubscribeBlocks(const bytes& src,
+                                       const unsigned int offset,
+                                       uint64_t& nextBlockNum,
+                                       uint32_t& listenPort);
   static bool SetLookupSetTxBlockFromSeed(bytes& dst, const unsigned int offset,
                                           const uint64_t lowBlockNum,
                                           const uint64_t highBlockNum,
@@ -541,18 +571,28 @@ class Messenger {
                                               uint64_t& highBlockNum,
                                               PubKey& lookupPubKey,
                                               std::vector<bytes>& stateDeltas);
+  /// numChunks is 0 to ask for the whole state in one message
   static bool SetLookupGetStateFromSeed(bytes& dst, const unsigned int offset,
-                                        const uint32_t listenPort);
+                                        const uint32_t listenPort,
+                                        const uint32_t chunkIndex,
+                                        const uint32_t numChunks);
   static bool GetLookupGetStateFromSeed(const bytes& src,
                                         const unsigned int offset,
-                                        uint32_t& listenPort);
+                                        uint32_t& listenPort,
+                                        uint32_t& chunkIndex,
+                                        uint32_t& numChunks);
   static bool SetLookupSetStateFromSeed(bytes& dst, const unsigned int offset,
                                         const PairOfKey& lookupKey,
-                                        const AccountStore& accountStore);
+                                        const AccountStore& accountStore,
+                                        const uint32_t chunkIndex,
+                                        const uint32_t numChunks);
   static bool GetLookupSetStateFromSeed(const bytes& src,
                                         const unsigned int offset,
                                         PubKey& lookupPubKey,
-                                        bytes& accountStoreBytes);
+                                        bytes& accountStoreBytes,
+                                        uint32_t& chunkIndex,
+                                        uint32_t& numChunks,
+                                        dev::h256& stateRoot);
   static bool SetLookupSetLookupOffline(bytes& dst, const unsigned int offset,
                                         const uint8_t msgType,
                                         const uint32_t listenPort,
@@ -669,6 +709,21 @@ class Messenger {
       const bytes& src, const unsigned int offset, PubKey& lookupPubKey,
       std::vector<TransactionWithReceipt>& txns);
 
+  /// microBlocks holds the epoch number and shard id of each micro block
+  static bool SetLookupGetMicroBlockTxnsFromLookup(
+      bytes& dst, const unsigned int offset,
+      const std::vector<std::pair<uint64_t, uint32_t>>& microBlocks,
+      const uint32_t portNo);
+  static bool GetLookupGetMicroBlockTxnsFromLookup(
+      const bytes& src, const unsigned int offset,
+      std::vector<std::pair<uint64_t, uint32_t>>& microBlocks,
+      uint32_t& portNo);
+  static bool SetLookupSetMicroBlockTxnsFromLookup(
+      bytes& dst, const unsigned int offset, const std::vector<bytes>& records);
+  static bool GetLookupSetMicroBlockTxnsFromLookup(const bytes& src,
+                                                   const unsigned int offset,
+                                                   std::vector<bytes>& records);
+
   static bool SetLookupGetDirectoryBlocksFromSeed(bytes& dst,
                                                   const unsigned int offset,
                                                   const uint32_t portNo,
@@ -697,6 +752,14 @@ class Messenger {
   // Consensus messages
   // ============================================================================
 
+  /// Reads the block number of any consensus message from its consensus info
+  /// alone, without parsing the rest or checking the signature, so that
+  /// stale messages can be told apart cheaply. offset is that of the message
+  /// body, after the consensus message type.
+  static bool PeekConsensusBlockNumber(const bytes& src,
+                                       const unsigned int offset,
+                                       uint64_t& blockNumber);
+
   template <class T>
   static bool PreProcessMessage(const bytes& src, const unsigned int offset,
                                 uint32_t& consensusID, PubKey& senderPubKey,
@@ -784,11 +847,11 @@ class Messenger {
       bytes& dst, const unsigned int offset, const uint32_t consensusID,
       const uint64_t blockNumber, const bytes& blockHash,
       const uint16_t leaderID, const Signature& collectiveSig,
-      const std::vector<bool>& bitmap, const PairOfKey& leaderKey);
+      const BitVector& bitmap, const PairOfKey& leaderKey);
   static bool GetConsensusCollectiveSig(
       const bytes& src, const unsigned int offset, const uint32_t consensusID,
       const uint64_t blockNumber, const bytes& blockHash,
-      const uint16_t leaderID, std::vector<bool>& bitmap,
+      const uint16_t leaderID, BitVector& bitmap,
       Signature& collectiveSig, const PubKey& leaderKey);
 
   static bool SetConsensusCommitFailure(bytes& dst, const unsigned int offset,
@@ -17,6 +17,8 @@
 
 #include "MessengerAccountStoreBase.h"
 #include "libData/AccountData/AccountStore.h"
+#include "libData/AccountData/StripedMap.h"
+#include "libData/DataStructures/FlatHashMap.h"
 #include "libMessage/ZilliqaMessage.pb.h"
 #include "libUtils/Logger.h"
 
@@ -37,13 +39,13 @@ bool ProtobufToAccount(const ProtoAccount& protoAccount, Account& account,
                        const Address& addr);
 
 template bool
-MessengerAccountStoreBase::SetAccountStore<unordered_map<Address, Account>>(
+MessengerAccountStoreBase::SetAccountStore<FixedHashMap<Address, Account>>(
     bytes& dst, const unsigned int offset,
-    const unordered_map<Address, Account>& addressToAccount);
+    const FixedHashMap<Address, Account>& addressToAccount);
 template bool
-MessengerAccountStoreBase::GetAccountStore<unordered_map<Address, Account>>(
+MessengerAccountStoreBase::GetAccountStore<FixedHashMap<Address, Account>>(
     const bytes& src, const unsigned int offset,
-    unordered_map<Address, Account>& addressToAccount);
+    FixedHashMap<Address, Account>& addressToAccount);
 
 template bool MessengerAccountStoreBase::SetAccountStore<map<Address, Account>>(
     bytes& dst, const unsigned int offset,
@@ -52,6 +54,15 @@ template bool MessengerAccountStoreBase::GetAccountStore<map<Address, Account>>(
     const bytes& src, const unsigned int offset,
     map<Address, Account>& addressToAccount);
 
+template bool
+MessengerAccountStoreBase::SetAccountStore<StripedMap<Address, Account>>(
+    bytes& dst, const unsigned int offset,
+    const StripedMap<Address, Account>& addressToAccount);
+template bool
+MessengerAccountStoreBase::GetAccountStore<StripedMap<Address, Account>>(
+    const bytes& src, const unsigned int offset,
+    StripedMap<Address, Account>& addressToAccount);
+
 template <class MAP>
 bool MessengerAccountStoreBase::SetAccountStore(bytes& dst,
                                                 const unsigned int offset,
@@ -16,6 +16,7 @@
  */
 
 #include "MessengerAccountStoreTrie.h"
+#include "libData/DataStructures/FlatHashMap.h"
 #include "libMessage/ZilliqaMessage.pb.h"
 #include "libUtils/Logger.h"
 
@@ -31,11 +32,44 @@ bool ProtobufToAccount(const ProtoAccount& protoAccount, Account& account,
                        const Address& addr);
 
 template bool MessengerAccountStoreTrie::SetAccountStoreTrie<
-    dev::OverlayDB, std::unordered_map<Address, Account>>(
+    dev::OverlayDB, FixedHashMap<Address, Account>>(
     bytes& dst, const unsigned int offset,
     const dev::SpecificTrieDB<dev::GenericTrieDB<dev::OverlayDB>, Address>&
         stateTrie,
-    const shared_ptr<unordered_map<Address, Account>>& addressToAccount);
+    const shared_ptr<FixedHashMap<Address, Account>>& addressToAccount);
+
+template bool MessengerAccountStoreTrie::SetAccountStoreTrieChunk<
+    dev::OverlayDB, FixedHashMap<Address, Account>>(
+    bytes& dst, const unsigned int offset,
+    const dev::SpecificTrieDB<dev::GenericTrieDB<dev::OverlayDB>, Address>&
+        stateTrie,
+    const shared_ptr<FixedHashMap<Address, Account>>& addressToAccount,
+    const unsigned int chunkIndex, const unsigned int numChunks);
+
+// Converts the account the trie holds at address, preferring the copy in
+// addressToAccount
+template <class MAP>
+bool TrieEntryToProtobuf(const Address& address, dev::bytesConstRef rawAccount,
+                         const shared_ptr<MAP>& addressToAccount,
+                         ProtoAccount& protoAccount) {
+  auto it = addressToAccount->find(address);
+  if (it != addressToAccount->end()) {
+    AccountToProtobuf(it->second, protoAccount);
+    return true;
+  }
+
+  Account account;
+  if (!account.DeserializeBase(bytes(rawAccount.begin(), rawAccount.end()),
+                               0)) {
+    LOG_GENERAL(WARNING, "Account::DeserializeBase failed");
+    return false;
+  }
+  if (account.GetCodeHash() != dev::h256()) {
+    account.SetAddress(address);
+  }
+  AccountToProtobuf(account, protoAccount);
+  return true;
+}
 
 template <class DB, class MAP>
 bool MessengerAccountStoreTrie::SetAccountStoreTrie(
@@ -50,21 +84,9 @@ bool MessengerAccountStoreTrie::SetAccountStoreTrie(
     protoEntry->set_address(address.data(), address.size);
     ProtoAccount* protoEntryAccount = protoEntry->mutable_account();
 
-    auto it = addressToAccount->find(address);
-    if (it != addressToAccount->end()) {
-      const Account& account = it->second;
-      AccountToProtobuf(account, *protoEntryAccount);
-    } else {
-      Account account;
-      if (!account.DeserializeBase(bytes(i.second.begin(), i.second.end()),
-                                   0)) {
-        LOG_GENERAL(WARNING, "Account::DeserializeBase failed");
-        continue;
-      }
-      if (account.GetCodeHash() != dev::h256()) {
-        account.SetAddress(address);
-      }
-      AccountToProtobuf(account, *protoEntryAccount);
+    if (!TrieEntryToProtobuf(address, i.second, addressToAccount,
+                             *protoEntryAccount)) {
+      continue;
     }
 
     if (!protoEntryAccount->IsInitialized()) {
@@ -79,4 +101,58 @@ bool MessengerAccountStoreTrie::SetAccountStoreTrie(
   }
 
   return SerializeToArray(result, dst, offset);
-}
\ No newline at end of file
+}
+
+template <class DB, class MAP>
+bool MessengerAccountStoreTrie::SetAccountStoreTrieChunk(
+    bytes& dst, const unsigned int offset,
+    const dev::SpecificTrieDB<dev::GenericTrieDB<DB>, Address>& stateTrie,
+    const shared_ptr<MAP>& addressToAccount, const unsigned int chunkIndex,
+    const unsigned int numChunks) {
+  if (numChunks == 0 || numChunks > 256 || chunkIndex >= numChunks) {
+    LOG_GENERAL(WARNING, "Invalid state chunk " << chunkIndex << " of "
+                                                << numChunks);
+    return false;
+  }
+
+  // Trie keys are the address bytes, so each chunk is one contiguous range
+  const unsigned int firstByteLo = chunkIndex * 256 / numChunks;
+  const unsigned int firstByteHi = (chunkIndex + 1) * 256 / numChunks;
+
+  ProtoAccountStore result;
+
+  Address start;
+  start[0] = firstByteLo;
+  for (auto i = stateTrie.lower_bound(start); i != stateTrie.end(); ++i) {
+    const auto entry = *i;
+    if (entry.first[0] >= firstByteHi) {
+      break;
+    }
+
+    ProtoAccountStore::AddressAccount* protoEntry = result.add_entries();
+    Address address(entry.first);
+    protoEntry->set_address(address.data(), address.size);
+    ProtoAccount* protoEntryAccount = protoEntry->mutable_account();
+
+    if (!TrieEntryToProtobuf(address, entry.second, addressToAccount,
+                             *protoEntryAccount)) {
+      continue;
+    }
+
+    if (!protoEntryAccount->IsInitialized()) {
+      LOG_GENERAL(WARNING, "ProtoAccount initialization failed.");
+      return false;
+    }
+  }
+
+  if (!result.IsInitialized()) {
+    LOG_GENERAL(WARNING, "ProtoAccountStore initialization failed.");
+    return false;
+  }
+
+  LOG_GENERAL(INFO, "State chunk " << chunkIndex << " of " << numChunks
+                                   << " has " << result.entries().size()
+                                   << " accounts");
+
+  return SerializeToArray(result, dst, offset);
+}
@@ -36,6 +36,15 @@ class MessengerAccountStoreTrie {
       bytes& dst, const unsigned int offset,
       const dev::SpecificTrieDB<dev::GenericTrieDB<DB>, Address>& stateTrie,
       const std::shared_ptr<MAP>& addressToAccount);
+
+  /// Serializes the accounts whose address starts with a byte in chunk
+  /// chunkIndex of [0, 256) split into numChunks equal ranges
+  template <class DB, class MAP>
+  static bool SetAccountStoreTrieChunk(
+      bytes& dst, const unsigned int offset,
+      const dev::SpecificTrieDB<dev::GenericTrieDB<DB>, Address>& stateTrie,
+      const std::shared_ptr<MAP>& addressToAccount,
+      const unsigned int chunkIndex, const unsigned int numChunks);
 };
 
 #endif  // __MESSENGERACCOUNTSTORETRIE_H__
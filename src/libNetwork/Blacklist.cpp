@@ -21,7 +21,11 @@
 
 using namespace std;
 
-Blacklist::Blacklist() : m_enabled(true) {}
+BlacklistKey::BlacklistKey(const boost::multiprecision::uint128_t& ip)
+    : m_hi((ip >> 64).convert_to<uint64_t>()),
+      m_lo((ip & UINT64_MAX).convert_to<uint64_t>()) {}
+
+Blacklist::Blacklist() : m_table(make_shared<const Table>()), m_enabled(true) {}
 
 Blacklist::~Blacklist() {}
 
@@ -30,15 +34,24 @@ Blacklist& Blacklist::GetInstance() {
   return blacklist;
 }
 
+shared_ptr<const Blacklist::Table> Blacklist::LoadTable() const {
+  return atomic_load(&m_table);
+}
+
+void Blacklist::PublishTable(shared_ptr<const Table> table) {
+  atomic_store(&m_table, move(table));
+}
+
 /// P2PComm may use this function
 bool Blacklist::Exist(const boost::multiprecision::uint128_t& ip) {
   if (!m_enabled) {
     return false;
   }
 
-  lock_guard<mutex> g(m_mutexBlacklistIP);
-  return (m_blacklistIP.end() != m_blacklistIP.find(ip) &&
-          (m_excludedIP.end() == m_excludedIP.find(ip)));
+  const BlacklistKey key(ip);
+  const auto table = LoadTable();
+  return (table->m_blacklistIP.end() != table->m_blacklistIP.find(key) &&
+          (table->m_excludedIP.end() == table->m_excludedIP.find(key)));
 }
 
 /// Reputation Manager may use this function
@@ -47,12 +60,23 @@ void Blacklist::Add(const boost::multiprecision::uint128_t& ip) {
     return;
   }
 
+  const BlacklistKey key(ip);
+
   lock_guard<mutex> g(m_mutexBlacklistIP);
-  if (m_excludedIP.end() == m_excludedIP.find(ip)) {
-    m_blacklistIP.emplace(ip, true);
-  } else {
+  const auto table = LoadTable();
+  if (table->m_excludedIP.end() != table->m_excludedIP.find(key)) {
     LOG_GENERAL(INFO, "Excluded " << IPConverter::ToStrFromNumericalIP(ip));
+    return;
+  }
+
+  // Misbehaving peers get reported over and over, avoid copying for nothing
+  if (table->m_blacklistIP.end() != table->m_blacklistIP.find(key)) {
+    return;
   }
+
+  auto newTable = make_shared<Table>(*table);
+  newTable->m_blacklistIP.emplace(key);
+  PublishTable(move(newTable));
 }
 
 /// Reputation Manager may use this function
@@ -61,14 +85,25 @@ void Blacklist::Remove(const boost::multiprecision::uint128_t& ip) {
     return;
   }
 
+  const BlacklistKey key(ip);
+
   lock_guard<mutex> g(m_mutexBlacklistIP);
-  m_blacklistIP.erase(ip);
+  const auto table = LoadTable();
+  if (table->m_blacklistIP.end() == table->m_blacklistIP.find(key)) {
+    return;
+  }
+
+  auto newTable = make_shared<Table>(*table);
+  newTable->m_blacklistIP.erase(key);
+  PublishTable(move(newTable));
 }
 
 /// Reputation Manager may use this function
 void Blacklist::Clear() {
   lock_guard<mutex> g(m_mutexBlacklistIP);
-  m_blacklistIP.clear();
+  auto newTable = make_shared<Table>();
+  newTable->m_excludedIP = LoadTable()->m_excludedIP;
+  PublishTable(move(newTable));
   LOG_GENERAL(INFO, "Blacklist cleared");
 }
 
@@ -78,24 +113,26 @@ void Blacklist::Pop(unsigned int num_to_pop) {
   }
 
   lock_guard<mutex> g(m_mutexBlacklistIP);
-  LOG_GENERAL(INFO, "Num of nodes in blacklist: " << m_blacklistIP.size());
+  auto newTable = make_shared<Table>(*LoadTable());
+  auto& blacklistIP = newTable->m_blacklistIP;
+  LOG_GENERAL(INFO, "Num of nodes in blacklist: " << blacklistIP.size());
 
   unsigned int counter = 0;
-  for (auto it = m_blacklistIP.begin(); it != m_blacklistIP.end();) {
+  for (auto it = blacklistIP.begin(); it != blacklistIP.end();) {
     if (counter < num_to_pop) {
-      it = m_blacklistIP.erase(it);
+      it = blacklistIP.erase(it);
       counter++;
     } else {
       break;
     }
   }
 
+  PublishTable(move(newTable));
   LOG_GENERAL(INFO, "Removed " << counter << " nodes from blacklist");
 }
 
 unsigned int Blacklist::SizeOfBlacklist() {
-  lock_guard<mutex> g(m_mutexBlacklistIP);
-  return m_blacklistIP.size();
+  return LoadTable()->m_blacklistIP.size();
 }
 
 void Blacklist::Enable(const bool enable) {
@@ -110,14 +147,34 @@ void Blacklist::Exclude(const boost::multiprecision::uint128_t& ip) {
   if (!m_enabled) {
     return;
   }
+
+  const BlacklistKey key(ip);
+
   lock_guard<mutex> g(m_mutexBlacklistIP);
-  m_excludedIP.emplace(ip);
+  const auto table = LoadTable();
+  if (table->m_excludedIP.end() != table->m_excludedIP.find(key)) {
+    return;
+  }
+
+  auto newTable = make_shared<Table>(*table);
+  newTable->m_excludedIP.emplace(key);
+  PublishTable(move(newTable));
 }
 
 void Blacklist::RemoveExclude(const boost::multiprecision::uint128_t& ip) {
   if (!m_enabled) {
     return;
   }
+
+  const BlacklistKey key(ip);
+
   lock_guard<mutex> g(m_mutexBlacklistIP);
-  m_excludedIP.erase(ip);
-}
\ No newline at end of file
+  const auto table = LoadTable();
+  if (table->m_excludedIP.end() == table->m_excludedIP.find(key)) {
+    return;
+  }
+
+  auto newTable = make_shared<Table>(*table);
+  newTable->m_excludedIP.erase(key);
+  PublishTable(move(newTable));
+}
@@ -23,20 +23,37 @@
 #include <boost/multiprecision/cpp_int.hpp>
 #pragma GCC diagnostic pop
 #include <atomic>
+#include <memory>
 #include <mutex>
-#include <set>
-#include <unordered_map>
-
-namespace std {
-template <>
-struct hash<boost::multiprecision::uint128_t> {
-  std::size_t operator()(const boost::multiprecision::uint128_t& key) const {
-    return std::hash<std::string>()(key.convert_to<std::string>());
+#include <unordered_set>
+
+/// Compact fixed-width form of an IPv4 or IPv6 address used as hash key
+struct BlacklistKey {
+  uint64_t m_hi;
+  uint64_t m_lo;
+
+  explicit BlacklistKey(const boost::multiprecision::uint128_t& ip);
+
+  bool operator==(const BlacklistKey& r) const {
+    return m_hi == r.m_hi && m_lo == r.m_lo;
+  }
+};
+
+struct BlacklistKeyHash {
+  std::size_t operator()(const BlacklistKey& key) const {
+    // IPv4 addresses only occupy m_lo, so fold m_hi in with a multiplier
+    return std::hash<uint64_t>()(key.m_lo ^ (key.m_hi * 0x9E3779B97F4A7C15ULL));
   }
 };
-}  // namespace std
 
 class Blacklist {
+  /// Immutable table that readers share. Writers copy it, apply their
+  /// change and publish the copy, so Exist() never takes a lock.
+  struct Table {
+    std::unordered_set<BlacklistKey, BlacklistKeyHash> m_blacklistIP;
+    std::unordered_set<BlacklistKey, BlacklistKeyHash> m_excludedIP;
+  };
+
   Blacklist();
   ~Blacklist();
 
@@ -44,11 +61,14 @@ class Blacklist {
   Blacklist(Blacklist const&) = delete;
   void operator=(Blacklist const&) = delete;
 
+  // Serializes writers only
   std::mutex m_mutexBlacklistIP;
-  std::unordered_map<boost::multiprecision::uint128_t, bool> m_blacklistIP;
-  std::set<boost::multiprecision::uint128_t> m_excludedIP;
+  std::shared_ptr<const Table> m_table;
   std::atomic<bool> m_enabled;
 
+  std::shared_ptr<const Table> LoadTable() const;
+  void PublishTable(std::shared_ptr<const Table> table);
+
  public:
   static Blacklist& GetInstance();
 
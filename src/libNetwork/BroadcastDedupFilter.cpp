@@ -0,0 +1,113 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <cstring>
+
+#include <boost/functional/hash.hpp>
+
+#include "BroadcastDedupFilter.h"
+
+using namespace std;
+
+size_t BroadcastDedupFilter::HashOfHash::operator()(const bytes& hash) const {
+  // Keys are already SHA-256 digests, so their leading bytes are as good a
+  // bucket index as any
+  if (hash.size() >= sizeof(size_t)) {
+    size_t result;
+    memcpy(&result, hash.data(), sizeof(size_t));
+    return result;
+  }
+
+  return boost::hash_range(hash.begin(), hash.end());
+}
+
+BroadcastDedupFilter::BroadcastDedupFilter(
+    unsigned int numBuckets, chrono::milliseconds bucketDuration,
+    unsigned int maxEntries)
+    : m_numBuckets(max(numBuckets, 1u)),
+      m_bucketDuration(bucketDuration),
+      m_maxEntries(maxEntries),
+      m_buckets(m_numBuckets),
+      m_newestBucketStart(chrono::steady_clock::now()),
+      m_size(0) {}
+
+void BroadcastDedupFilter::Roll() {
+  m_size -= m_buckets.back().size();
+  m_buckets.pop_back();
+  m_buckets.emplace_front();
+}
+
+void BroadcastDedupFilter::RollExpired() {
+  const auto now = chrono::steady_clock::now();
+
+  unsigned int rolls = 0;
+  while (rolls < m_numBuckets &&
+         now - m_newestBucketStart >= m_bucketDuration) {
+    Roll();
+    m_newestBucketStart += m_bucketDuration;
+    rolls++;
+  }
+
+  if (now - m_newestBucketStart >= m_bucketDuration) {
+    // Idle for longer than the whole window, everything has been dropped
+    m_newestBucketStart = now;
+  }
+}
+
+bool BroadcastDedupFilter::ContainsNoLock(const bytes& hash) const {
+  for (const auto& bucket : m_buckets) {
+    if (bucket.find(hash) != bucket.end()) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool BroadcastDedupFilter::Insert(const bytes& hash) {
+  lock_guard<mutex> g(m_mutex);
+
+  RollExpired();
+
+  if (ContainsNoLock(hash)) {
+    return false;
+  }
+
+  for (unsigned int i = 0; i < m_numBuckets && m_size >= m_maxEntries; i++) {
+    Roll();
+  }
+
+  m_buckets.front().insert(hash);
+  m_size++;
+  return true;
+}
+
+bool BroadcastDedupFilter::Contains(const bytes& hash) {
+  lock_guard<mutex> g(m_mutex);
+
+  RollExpired();
+
+  return ContainsNoLock(hash);
+}
+
+unsigned int BroadcastDedupFilter::Size() {
+  lock_guard<mutex> g(m_mutex);
+
+  RollExpired();
+
+  return m_size;
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BROADCASTDEDUPFILTER_H__
+#define __BROADCASTDEDUPFILTER_H__
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <unordered_set>
+
+#include "common/BaseType.h"
+
+/// Remembers broadcast message hashes for a limited time so that duplicates
+/// can be discarded. Hashes are kept in a ring of time buckets; when the
+/// newest bucket has been open for a bucket duration the oldest bucket is
+/// dropped as a whole, so expiry needs no per-message bookkeeping. Rolling
+/// also happens early whenever the total number of hashes exceeds the limit.
+class BroadcastDedupFilter {
+  struct HashOfHash {
+    size_t operator()(const bytes& hash) const;
+  };
+
+  using Bucket = std::unordered_set<bytes, HashOfHash>;
+
+  const unsigned int m_numBuckets;
+  const std::chrono::milliseconds m_bucketDuration;
+  const unsigned int m_maxEntries;
+
+  std::mutex m_mutex;
+  std::deque<Bucket> m_buckets;  // newest first
+  std::chrono::time_point<std::chrono::steady_clock> m_newestBucketStart;
+  unsigned int m_size;
+
+  void Roll();
+  void RollExpired();
+  bool ContainsNoLock(const bytes& hash) const;
+
+ public:
+  BroadcastDedupFilter(unsigned int numBuckets,
+                       std::chrono::milliseconds bucketDuration,
+                       unsigned int maxEntries);
+
+  /// Records the hash. Returns false if it has been seen before and has not
+  /// expired yet.
+  bool Insert(const bytes& hash);
+
+  /// Returns true if the hash has been seen before and has not expired yet.
+  bool Contains(const bytes& hash);
+
+  /// Returns the number of hashes currently remembered.
+  unsigned int Size();
+};
+
+#endif  // __BROADCASTDEDUPFILTER_H__
@@ -0,0 +1,241 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "ChunkAssembler.h"
+#include "common/Constants.h"
+#include "libCrypto/Sha2.h"
+#include "libUtils/Logger.h"
+#include "libUtils/ReedSolomon.h"
+
+using namespace std;
+
+namespace {
+const unsigned int CHUNK_HASH_LEN = 32;
+const unsigned int CHUNK_PEER_LEN = UINT128_SIZE + sizeof(uint32_t);
+const unsigned int CHUNK_HDR_LEN = CHUNK_HASH_LEN + sizeof(uint32_t) +
+                                   sizeof(uint16_t) * 4;
+}  // anonymous namespace
+
+void ChunkFrame::Serialize(bytes& dst) const {
+  dst.clear();
+  dst.reserve(CHUNK_HDR_LEN + m_relayPeers.size() * CHUNK_PEER_LEN +
+              m_chunk.size());
+
+  dst.insert(dst.end(), m_hash.begin(), m_hash.end());
+  unsigned int offset = dst.size();
+  Serializable::SetNumber<uint32_t>(dst, offset, m_length, sizeof(uint32_t));
+  offset += sizeof(uint32_t);
+  Serializable::SetNumber<uint16_t>(dst, offset, m_dataChunks,
+                                    sizeof(uint16_t));
+  offset += sizeof(uint16_t);
+  Serializable::SetNumber<uint16_t>(dst, offset, m_parityChunks,
+                                    sizeof(uint16_t));
+  offset += sizeof(uint16_t);
+  Serializable::SetNumber<uint16_t>(dst, offset, m_index, sizeof(uint16_t));
+  offset += sizeof(uint16_t);
+  Serializable::SetNumber<uint16_t>(dst, offset, m_relayPeers.size(),
+                                    sizeof(uint16_t));
+  offset += sizeof(uint16_t);
+
+  for (const auto& peer : m_relayPeers) {
+    offset += peer.Serialize(dst, offset);
+  }
+
+  dst.insert(dst.end(), m_chunk.begin(), m_chunk.end());
+}
+
+bool ChunkFrame::Deserialize(const bytes& src, unsigned int offset) {
+  if (src.size() < offset + CHUNK_HDR_LEN) {
+    LOG_GENERAL(WARNING, "Chunk header too short");
+    return false;
+  }
+
+  m_hash.assign(src.begin() + offset, src.begin() + offset + CHUNK_HASH_LEN);
+  offset += CHUNK_HASH_LEN;
+  m_length = Serializable::GetNumber<uint32_t>(src, offset, sizeof(uint32_t));
+  offset += sizeof(uint32_t);
+  m_dataChunks =
+      Serializable::GetNumber<uint16_t>(src, offset, sizeof(uint16_t));
+  offset += sizeof(uint16_t);
+  m_parityChunks =
+      Serializable::GetNumber<uint16_t>(src, offset, sizeof(uint16_t));
+  offset += sizeof(uint16_t);
+  m_index = Serializable::GetNumber<uint16_t>(src, offset, sizeof(uint16_t));
+  offset += sizeof(uint16_t);
+  const unsigned int numRelayPeers =
+      Serializable::GetNumber<uint16_t>(src, offset, sizeof(uint16_t));
+  offset += sizeof(uint16_t);
+
+  if (numRelayPeers > ReedSolomon::MAX_TOTAL_SHARDS ||
+      src.size() < offset + numRelayPeers * CHUNK_PEER_LEN) {
+    LOG_GENERAL(WARNING, "Invalid chunk relay list");
+    return false;
+  }
+
+  m_relayPeers.clear();
+  for (unsigned int i = 0; i < numRelayPeers; i++) {
+    Peer peer;
+    if (peer.Deserialize(src, offset) != 0) {
+      return false;
+    }
+    m_relayPeers.emplace_back(peer);
+    offset += CHUNK_PEER_LEN;
+  }
+
+  m_chunk.assign(src.begin() + offset, src.end());
+  return true;
+}
+
+ChunkAssembler::ChunkAssembler(unsigned int maxPending,
+                               chrono::milliseconds expiry, uint32_t maxLength)
+    : m_maxPending(max(maxPending, 1u)),
+      m_expiry(expiry),
+      m_maxLength(maxLength) {}
+
+bool ChunkAssembler::Split(const bytes& message, const vector<Peer>& peers,
+                           unsigned int parityPercent,
+                           vector<ChunkFrame>& frames) {
+  const unsigned int totalChunks = peers.size();
+  if (totalChunks == 0 || totalChunks > ReedSolomon::MAX_TOTAL_SHARDS) {
+    return false;
+  }
+
+  // Reserve parityPercent of the data chunks for parity
+  const unsigned int dataChunks =
+      max(1u, totalChunks * 100 / (100 + parityPercent));
+  const unsigned int parityChunks = totalChunks - dataChunks;
+
+  vector<bytes> chunks;
+  if (!ReedSolomon::Encode(message, dataChunks, parityChunks, chunks)) {
+    return false;
+  }
+
+  SHA2<HASH_TYPE::HASH_VARIANT_256> sha256;
+  sha256.Update(message);
+  const bytes hash = sha256.Finalize();
+
+  frames.clear();
+  frames.resize(totalChunks);
+  for (unsigned int i = 0; i < totalChunks; i++) {
+    ChunkFrame& frame = frames[i];
+    frame.m_hash = hash;
+    frame.m_length = message.size();
+    frame.m_dataChunks = dataChunks;
+    frame.m_parityChunks = parityChunks;
+    frame.m_index = i;
+    frame.m_relayPeers = peers;
+    frame.m_chunk = move(chunks[i]);
+  }
+
+  return true;
+}
+
+ChunkAssembler::AddResult ChunkAssembler::Add(const ChunkFrame& frame,
+                                              PendingMessage& ready) {
+  if (frame.m_hash.size() != CHUNK_HASH_LEN || frame.m_dataChunks == 0 ||
+      frame.m_dataChunks + frame.m_parityChunks >
+          ReedSolomon::MAX_TOTAL_SHARDS ||
+      frame.m_index >= frame.m_dataChunks + frame.m_parityChunks ||
+      frame.m_length > m_maxLength ||
+      frame.m_chunk.size() !=
+          ReedSolomon::GetShardSize(frame.m_length, frame.m_dataChunks)) {
+    LOG_GENERAL(WARNING, "Invalid chunk " << frame.m_index << " of "
+                                          << frame.m_dataChunks << "+"
+                                          << frame.m_parityChunks);
+    return CHUNK_REJECTED;
+  }
+
+  lock_guard<mutex> g(m_mutexPending);
+
+  auto it = m_pending.find(frame.m_hash);
+  if (it == m_pending.end()) {
+    if (m_pending.size() >= m_maxPending) {
+      auto oldest = min_element(
+          m_pending.begin(), m_pending.end(),
+          [](const pair<const bytes, PendingMessage>& a,
+             const pair<const bytes, PendingMessage>& b) {
+            return a.second.m_firstSeen < b.second.m_firstSeen;
+          });
+      LOG_GENERAL(INFO, "Dropping incomplete chunked message with "
+                            << oldest->second.m_chunks.size() << " of "
+                            << oldest->second.m_dataChunks << " chunks");
+      m_pending.erase(oldest);
+    }
+
+    PendingMessage pending;
+    pending.m_length = frame.m_length;
+    pending.m_dataChunks = frame.m_dataChunks;
+    pending.m_parityChunks = frame.m_parityChunks;
+    pending.m_firstSeen = chrono::steady_clock::now();
+    it = m_pending.emplace(frame.m_hash, move(pending)).first;
+  } else if (it->second.m_length != frame.m_length ||
+             it->second.m_dataChunks != frame.m_dataChunks ||
+             it->second.m_parityChunks != frame.m_parityChunks) {
+    LOG_GENERAL(WARNING, "Chunk layout differs from earlier chunks");
+    return CHUNK_REJECTED;
+  }
+
+  if (!it->second.m_chunks.emplace(frame.m_index, frame.m_chunk).second) {
+    return CHUNK_DUPLICATE;
+  }
+
+  if (it->second.m_chunks.size() < it->second.m_dataChunks) {
+    return CHUNK_STORED;
+  }
+
+  ready = move(it->second);
+  m_pending.erase(it);
+  return CHUNK_COMPLETED;
+}
+
+bool ChunkAssembler::Assemble(const bytes& hash, const PendingMessage& ready,
+                              bytes& message) {
+  if (!ReedSolomon::Decode(ready.m_chunks, ready.m_dataChunks,
+                           ready.m_parityChunks, ready.m_length, message)) {
+    LOG_GENERAL(WARNING, "Failed to decode chunked message");
+    return false;
+  }
+
+  SHA2<HASH_TYPE::HASH_VARIANT_256> sha256;
+  sha256.Update(message);
+  if (sha256.Finalize() != hash) {
+    LOG_GENERAL(WARNING, "Incorrect chunked message hash.");
+    return false;
+  }
+
+  return true;
+}
+
+void ChunkAssembler::CleanupExpired() {
+  lock_guard<mutex> g(m_mutexPending);
+
+  const auto now = chrono::steady_clock::now();
+  for (auto it = m_pending.begin(); it != m_pending.end();) {
+    if (now - it->second.m_firstSeen > m_expiry) {
+      it = m_pending.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+size_t ChunkAssembler::Size() {
+  lock_guard<mutex> g(m_mutexPending);
+  return m_pending.size();
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CHUNKASSEMBLER_H__
+#define __CHUNKASSEMBLER_H__
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include "Peer.h"
+#include "common/BaseType.h"
+
+/// One erasure-coded piece of a broadcast message. On the wire it is
+/// [hash][length][data chunks][parity chunks][index][relay count]
+/// [relay peers][chunk]. A receiver forwards a chunk that carries relay
+/// peers to all of them (without the list), so that every peer of the
+/// group ends up with every chunk while the origin uploads each only once.
+struct ChunkFrame {
+  bytes m_hash;
+  uint32_t m_length = 0;
+  uint16_t m_dataChunks = 0;
+  uint16_t m_parityChunks = 0;
+  uint16_t m_index = 0;
+  std::vector<Peer> m_relayPeers;
+  bytes m_chunk;
+
+  void Serialize(bytes& dst) const;
+  bool Deserialize(const bytes& src, unsigned int offset);
+};
+
+/// Collects chunks per message hash until enough of them have arrived to
+/// rebuild the message.
+class ChunkAssembler {
+ public:
+  enum AddResult : unsigned char {
+    CHUNK_REJECTED = 0x00,
+    CHUNK_DUPLICATE = 0x01,
+    CHUNK_STORED = 0x02,
+    CHUNK_COMPLETED = 0x03
+  };
+
+  struct PendingMessage {
+    uint32_t m_length = 0;
+    uint16_t m_dataChunks = 0;
+    uint16_t m_parityChunks = 0;
+    std::map<unsigned int, bytes> m_chunks;
+    std::chrono::time_point<std::chrono::steady_clock> m_firstSeen;
+  };
+
+ private:
+  std::mutex m_mutexPending;
+  std::map<bytes, PendingMessage> m_pending;
+
+  const unsigned int m_maxPending;
+  const std::chrono::milliseconds m_expiry;
+  const uint32_t m_maxLength;
+
+ public:
+  ChunkAssembler(unsigned int maxPending, std::chrono::milliseconds expiry,
+                 uint32_t maxLength);
+
+  /// Encodes message into one frame per peer, each peer getting a distinct
+  /// chunk and the whole peer list to relay it to
+  static bool Split(const bytes& message, const std::vector<Peer>& peers,
+                    unsigned int parityPercent,
+                    std::vector<ChunkFrame>& frames);
+
+  /// Stores the chunk. On CHUNK_COMPLETED, ready holds the chunks needed by
+  /// Assemble and the message is no longer tracked.
+  AddResult Add(const ChunkFrame& frame, PendingMessage& ready);
+
+  /// Decodes the chunks and checks the result against the message hash
+  static bool Assemble(const bytes& hash, const PendingMessage& ready,
+                       bytes& message);
+
+  /// Drops messages that did not complete within the expiry
+  void CleanupExpired();
+
+  size_t Size();
+};
+
+#endif  // __CHUNKASSEMBLER_H__
@@ -0,0 +1,154 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <errno.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "ConnectionPool.h"
+#include "common/Constants.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+
+ConnectionPool::ConnectionPool() {}
+
+ConnectionPool::~ConnectionPool() { Clear(); }
+
+ConnectionPool& ConnectionPool::GetInstance() {
+  static ConnectionPool pool;
+  return pool;
+}
+
+bool ConnectionPool::IsExpired(const IdleConnection& conn) {
+  return chrono::steady_clock::now() - conn.m_lastUsed >
+         chrono::seconds(CONNECTION_POOL_IDLE_TIMEOUT_IN_SECONDS);
+}
+
+bool ConnectionPool::IsHealthy(int socket) {
+  // The receiver never writes back on this connection, so anything other
+  // than "would block" means the peer has closed or reset it
+  unsigned char c;
+  ssize_t n = recv(socket, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+  return (n < 0) && (errno == EAGAIN || errno == EWOULDBLOCK);
+}
+
+void ConnectionPool::CloseSocket(int socket) {
+  shutdown(socket, SHUT_RDWR);
+  close(socket);
+}
+
+int ConnectionPool::Acquire(const Peer& peer) {
+  lock_guard<mutex> g(m_mutexIdleConnections);
+
+  auto it = m_idleConnections.find(peer);
+  if (it == m_idleConnections.end()) {
+    return -1;
+  }
+
+  auto& conns = it->second;
+  int socket = -1;
+
+  // Most recently used sockets are at the back and least likely to be stale
+  while (!conns.empty()) {
+    IdleConnection conn = conns.back();
+    conns.pop_back();
+
+    if (!IsExpired(conn) && IsHealthy(conn.m_socket)) {
+      socket = conn.m_socket;
+      break;
+    }
+
+    LOG_GENERAL(DEBUG, "Dropping stale connection to " << peer);
+    CloseSocket(conn.m_socket);
+  }
+
+  if (conns.empty()) {
+    m_idleConnections.erase(it);
+  }
+
+  return socket;
+}
+
+void ConnectionPool::Release(const Peer& peer, int socket) {
+  if (socket < 0) {
+    return;
+  }
+
+  lock_guard<mutex> g(m_mutexIdleConnections);
+
+  auto& conns = m_idleConnections[peer];
+  if (conns.size() >= CONNECTION_POOL_MAX_IDLE_PER_PEER) {
+    CloseSocket(socket);
+    return;
+  }
+
+  conns.push_back({socket, chrono::steady_clock::now()});
+}
+
+void ConnectionPool::Discard(int socket) {
+  if (socket < 0) {
+    return;
+  }
+
+  CloseSocket(socket);
+}
+
+void ConnectionPool::CleanupIdle() {
+  lock_guard<mutex> g(m_mutexIdleConnections);
+
+  unsigned int counter = 0;
+  for (auto it = m_idleConnections.begin(); it != m_idleConnections.end();) {
+    auto& conns = it->second;
+
+    // Sockets are appended in order of use, so expired ones are at the front
+    while (!conns.empty() && IsExpired(conns.front())) {
+      CloseSocket(conns.front().m_socket);
+      conns.pop_front();
+      counter++;
+    }
+
+    if (conns.empty()) {
+      it = m_idleConnections.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  if (counter > 0) {
+    LOG_GENERAL(INFO, "Closed " << counter << " idle connections");
+  }
+}
+
+void ConnectionPool::Clear() {
+  lock_guard<mutex> g(m_mutexIdleConnections);
+
+  for (auto& entry : m_idleConnections) {
+    for (const auto& conn : entry.second) {
+      CloseSocket(conn.m_socket);
+    }
+  }
+
+  m_idleConnections.clear();
+}
+
+unsigned int ConnectionPool::SizeOfIdle(const Peer& peer) {
+  lock_guard<mutex> g(m_mutexIdleConnections);
+
+  auto it = m_idleConnections.find(peer);
+  return (it == m_idleConnections.end()) ? 0 : it->second.size();
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __CONNECTIONPOOL_H__
+#define __CONNECTIONPOOL_H__
+
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+
+#include "Peer.h"
+
+/// Keeps idle outbound sockets per peer so that SendJob can reuse an
+/// established connection instead of connecting for every message.
+class ConnectionPool {
+  struct IdleConnection {
+    int m_socket;
+    std::chrono::time_point<std::chrono::steady_clock> m_lastUsed;
+  };
+
+  std::mutex m_mutexIdleConnections;
+  std::map<Peer, std::deque<IdleConnection>> m_idleConnections;
+
+  ConnectionPool();
+  ~ConnectionPool();
+
+  // Singleton should not implement these
+  ConnectionPool(ConnectionPool const&) = delete;
+  void operator=(ConnectionPool const&) = delete;
+
+  static bool IsExpired(const IdleConnection& conn);
+  static bool IsHealthy(int socket);
+  static void CloseSocket(int socket);
+
+ public:
+  /// Returns the singleton ConnectionPool instance.
+  static ConnectionPool& GetInstance();
+
+  /// Returns an idle and healthy socket to the peer, or -1 if there is none
+  int Acquire(const Peer& peer);
+
+  /// Hands a socket back to the pool after a successful send
+  void Release(const Peer& peer, int socket);
+
+  /// Closes a socket that failed and must not be reused
+  void Discard(int socket);
+
+  /// Closes all idle sockets past CONNECTION_POOL_IDLE_TIMEOUT_IN_SECONDS
+  void CleanupIdle();
+
+  /// Closes all idle sockets
+  void Clear();
+
+  /// Returns the number of idle sockets kept for the peer
+  unsigned int SizeOfIdle(const Peer& peer);
+};
+
+#endif  // __CONNECTIONPOOL_H__
@@ -27,7 +27,7 @@
 using namespace std;
 
 void SendDataToLookupNodesDefault(const VectorOfNode& lookups,
-                                  const bytes& message) {
+                                  const SharedBytes& message) {
   if (LOOKUP_NODE_MODE) {
     LOG_GENERAL(WARNING,
                 "DataSender::SendDataToLookupNodesDefault not "
@@ -62,7 +62,7 @@ void SendDataToLookupNodesDefault(const VectorOfNode& lookups,
 }
 
 void SendDataToShardNodesDefault(
-    const bytes& message,
+    const SharedBytes& message,
     const std::deque<std::vector<Peer>>& sharded_receivers,
     bool forceMulticast) {
   if (LOOKUP_NODE_MODE) {
@@ -74,17 +74,19 @@ void SendDataToShardNodesDefault(
   // Too few target shards - avoid asking all DS clusters to send
   LOG_MARKER();
 
+  if (BROADCAST_GOSSIP_MODE && !forceMulticast) {
+    P2PComm::GetInstance().SendRumorToForeignPeers(sharded_receivers, *message);
+    return;
+  }
+
   for (const auto& receivers : sharded_receivers) {
-    if (BROADCAST_GOSSIP_MODE && !forceMulticast) {
-      P2PComm::GetInstance().SendRumorToForeignPeers(receivers, message);
-    } else {
-      P2PComm::GetInstance().SendBroadcastMessage(receivers, message);
-    }
+    P2PComm::GetInstance().SendChunkedBroadcastMessage(receivers, message);
   }
 }
 
 SendDataToLookupFunc SendDataToLookupFuncDefault =
-    [](const VectorOfNode& lookups, const bytes& message) mutable -> void {
+    [](const VectorOfNode& lookups,
+       const SharedBytes& message) mutable -> void {
   SendDataToLookupNodesDefault(lookups, message);
 };
 
@@ -275,15 +277,19 @@ bool DataSender::SendDataToOthers(
   }
 
   if (inB2) {
-    bytes message;
+    bytes composedMessage;
     if (!(composeMessageForSenderFunc &&
-          composeMessageForSenderFunc(message))) {
+          composeMessageForSenderFunc(composedMessage))) {
       LOG_GENERAL(
           WARNING,
           "composeMessageForSenderFunc undefined or cannot compose message");
       return false;
     }
 
+    // The same buffer is queued for the lookups and every shard receiver
+    const SharedBytes message =
+        make_shared<const bytes>(move(composedMessage));
+
     uint16_t randomDigits =
         DataConversion::charArrTo16Bits(hashForRandom.asBytes());
     bool committeeTooSmall = tmpCommittee.size() <= TX_SHARING_CLUSTER_SIZE;
@@ -27,9 +27,11 @@
 #include "libData/BlockData/Block/BlockBase.h"
 
 typedef std::function<bool(bytes& message)> ComposeMessageForSenderFunc;
-typedef std::function<void(const VectorOfNode& lookups, const bytes& message)>
+typedef std::function<void(const VectorOfNode& lookups,
+                           const SharedBytes& message)>
     SendDataToLookupFunc;
-typedef std::function<void(const bytes& message, const DequeOfShard& shards,
+typedef std::function<void(const SharedBytes& message,
+                           const DequeOfShard& shards,
                            const unsigned int& my_shards_lo,
                            const unsigned int& my_shards_hi)>
     SendDataToShardFunc;
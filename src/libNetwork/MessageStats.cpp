@@ -0,0 +1,202 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <fstream>
+
+#include "MessageStats.h"
+#include "common/Constants.h"
+#include "common/MessageNames.h"
+#include "common/Messages.h"
+#include "libUtils/DetachedFunction.h"
+#include "libUtils/Logger.h"
+#include "libUtils/TimeUtils.h"
+
+using namespace std;
+
+MessageStats::MessageStats() { Clear(); }
+
+MessageStats::~MessageStats() {}
+
+MessageStats& MessageStats::GetInstance() {
+  static MessageStats stats;
+  return stats;
+}
+
+MessageStats::Entry* MessageStats::GetEntry(const bytes& message) {
+  if (message.size() <= MessageOffset::INST) {
+    return nullptr;
+  }
+
+  const unsigned char msgType = message[MessageOffset::TYPE];
+  const unsigned char instruction = message[MessageOffset::INST];
+  if (msgType >= MAX_MSG_TYPES || instruction >= MAX_INSTRUCTIONS) {
+    return nullptr;
+  }
+
+  return &m_entries[msgType][instruction];
+}
+
+void MessageStats::RecordReceived(const bytes& message) {
+  Entry* entry = GetEntry(message);
+  if (entry == nullptr) {
+    return;
+  }
+
+  entry->m_countIn++;
+  entry->m_bytesIn += message.size();
+}
+
+void MessageStats::RecordSent(const bytes& message, unsigned int numPeers) {
+  Entry* entry = GetEntry(message);
+  if (entry == nullptr) {
+    return;
+  }
+
+  entry->m_countOut += numPeers;
+  entry->m_bytesOut += (uint64_t)message.size() * numPeers;
+}
+
+void MessageStats::RecordProcessed(const bytes& message, uint64_t queueWaitUs,
+                                   uint64_t handlerUs) {
+  Entry* entry = GetEntry(message);
+  if (entry == nullptr) {
+    return;
+  }
+
+  entry->m_processed++;
+  entry->m_queueWaitUs += queueWaitUs;
+  entry->m_handlerUs += handlerUs;
+  entry->m_queueWaitHist[GetHistogramBucket(queueWaitUs)]++;
+  entry->m_handlerHist[GetHistogramBucket(handlerUs)]++;
+}
+
+bool MessageStats::GetSnapshot(unsigned char msgType, unsigned char instruction,
+                               Snapshot& snapshot) const {
+  if (msgType >= MAX_MSG_TYPES || instruction >= MAX_INSTRUCTIONS) {
+    return false;
+  }
+
+  const Entry& entry = m_entries[msgType][instruction];
+  snapshot.m_countIn = entry.m_countIn;
+  snapshot.m_bytesIn = entry.m_bytesIn;
+  snapshot.m_countOut = entry.m_countOut;
+  snapshot.m_bytesOut = entry.m_bytesOut;
+  snapshot.m_processed = entry.m_processed;
+  snapshot.m_queueWaitUs = entry.m_queueWaitUs;
+  snapshot.m_handlerUs = entry.m_handlerUs;
+  for (unsigned int i = 0; i < NUM_HISTOGRAM_BUCKETS; i++) {
+    snapshot.m_queueWaitHist[i] = entry.m_queueWaitHist[i];
+    snapshot.m_handlerHist[i] = entry.m_handlerHist[i];
+  }
+
+  return (snapshot.m_countIn > 0) || (snapshot.m_countOut > 0);
+}
+
+unsigned int MessageStats::GetHistogramBucket(uint64_t us) {
+  if (us == 0) {
+    return 0;
+  }
+
+  // Number of significant bits, i.e. 1 for 1 us, 2 for [2, 4) us, ...
+  const unsigned int bucket = 64 - __builtin_clzll(us);
+  return min(bucket, NUM_HISTOGRAM_BUCKETS - 1);
+}
+
+void MessageStats::WriteCsvHeader(ostream& os) {
+  os << "timestamp,name,type,instruction,count_in,bytes_in,count_out,"
+        "bytes_out,processed,queue_wait_us,handler_us,queue_wait_hist,"
+        "handler_hist"
+     << endl;
+}
+
+void MessageStats::WriteCsv(ostream& os, uint64_t timestamp) const {
+  auto writeHistogram = [&os](const Histogram& hist) {
+    for (unsigned int i = 0; i < NUM_HISTOGRAM_BUCKETS; i++) {
+      os << (i > 0 ? ";" : "") << hist[i];
+    }
+  };
+
+  for (unsigned int msgType = 0; msgType < MAX_MSG_TYPES; msgType++) {
+    for (unsigned int ins = 0; ins < MAX_INSTRUCTIONS; ins++) {
+      Snapshot snapshot;
+      if (!GetSnapshot(msgType, ins, snapshot)) {
+        continue;
+      }
+
+      os << timestamp << "," << GetMessageName(msgType, ins) << ","
+         << msgType << "," << ins << "," << snapshot.m_countIn << ","
+         << snapshot.m_bytesIn << "," << snapshot.m_countOut << ","
+         << snapshot.m_bytesOut << "," << snapshot.m_processed << ","
+         << snapshot.m_queueWaitUs << "," << snapshot.m_handlerUs << ",";
+      writeHistogram(snapshot.m_queueWaitHist);
+      os << ",";
+      writeHistogram(snapshot.m_handlerHist);
+      os << "\n";
+    }
+  }
+  os.flush();
+}
+
+bool MessageStats::DumpToFile(const string& fileName) const {
+  ofstream fs(fileName, ofstream::out | ofstream::app);
+  if (!fs.is_open()) {
+    LOG_GENERAL(WARNING, "Failed to open " << fileName);
+    return false;
+  }
+
+  if (fs.tellp() == 0) {
+    WriteCsvHeader(fs);
+  }
+
+  // Seconds since epoch, so dumps from different nodes can be lined up
+  WriteCsv(fs, get_time_as_int() / 1000000);
+  return fs.good();
+}
+
+void MessageStats::StartPeriodicDump() {
+  if (MESSAGE_STATS_DUMP_INTERVAL_IN_SECONDS == 0) {
+    return;
+  }
+
+  auto func = [this]() -> void {
+    while (true) {
+      this_thread::sleep_for(
+          chrono::seconds(MESSAGE_STATS_DUMP_INTERVAL_IN_SECONDS));
+      DumpToFile(MESSAGE_STATS_FILE);
+    }
+  };
+
+  DetachedFunction(DetachedFunction::Lane::BLOCKING, 1, func);
+}
+
+void MessageStats::Clear() {
+  for (auto& entries : m_entries) {
+    for (auto& entry : entries) {
+      entry.m_countIn = 0;
+      entry.m_bytesIn = 0;
+      entry.m_countOut = 0;
+      entry.m_bytesOut = 0;
+      entry.m_processed = 0;
+      entry.m_queueWaitUs = 0;
+      entry.m_handlerUs = 0;
+      for (unsigned int i = 0; i < NUM_HISTOGRAM_BUCKETS; i++) {
+        entry.m_queueWaitHist[i] = 0;
+        entry.m_handlerHist[i] = 0;
+      }
+    }
+  }
+}
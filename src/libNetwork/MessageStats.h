@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __MESSAGESTATS_H__
+#define __MESSAGESTATS_H__
+
+#include <array>
+#include <atomic>
+#include <ostream>
+#include <string>
+
+#include "common/BaseType.h"
+
+/// Per (message type, instruction) counters of traffic and processing time.
+/// The counters are dumped as CSV rows that grepperf reads directly, which
+/// replaces scraping MessageSizeKeyword lines out of the logs.
+class MessageStats {
+ public:
+  static const unsigned int MAX_MSG_TYPES = 8;
+  static const unsigned int MAX_INSTRUCTIONS = 64;
+
+  /// Bucket 0 counts durations under 1 us, bucket i > 0 counts durations in
+  /// [2^(i-1), 2^i) us and the last bucket also takes anything longer
+  static const unsigned int NUM_HISTOGRAM_BUCKETS = 24;
+
+  typedef std::array<uint64_t, NUM_HISTOGRAM_BUCKETS> Histogram;
+
+  struct Snapshot {
+    uint64_t m_countIn = 0;
+    uint64_t m_bytesIn = 0;
+    uint64_t m_countOut = 0;
+    uint64_t m_bytesOut = 0;
+    uint64_t m_processed = 0;
+    uint64_t m_queueWaitUs = 0;
+    uint64_t m_handlerUs = 0;
+    Histogram m_queueWaitHist{};
+    Histogram m_handlerHist{};
+  };
+
+ private:
+  struct Entry {
+    std::atomic<uint64_t> m_countIn;
+    std::atomic<uint64_t> m_bytesIn;
+    std::atomic<uint64_t> m_countOut;
+    std::atomic<uint64_t> m_bytesOut;
+    std::atomic<uint64_t> m_processed;
+    std::atomic<uint64_t> m_queueWaitUs;
+    std::atomic<uint64_t> m_handlerUs;
+    std::atomic<uint64_t> m_queueWaitHist[NUM_HISTOGRAM_BUCKETS];
+    std::atomic<uint64_t> m_handlerHist[NUM_HISTOGRAM_BUCKETS];
+  };
+
+  Entry m_entries[MAX_MSG_TYPES][MAX_INSTRUCTIONS];
+
+  MessageStats();
+  ~MessageStats();
+
+  // Singleton should not implement these
+  MessageStats(MessageStats const&) = delete;
+  void operator=(MessageStats const&) = delete;
+
+  Entry* GetEntry(const bytes& message);
+
+ public:
+  /// Returns the singleton MessageStats instance.
+  static MessageStats& GetInstance();
+
+  /// Counts a message handed over for processing
+  void RecordReceived(const bytes& message);
+
+  /// Counts a message queued for sending to numPeers peers
+  void RecordSent(const bytes& message, unsigned int numPeers);
+
+  /// Records how long a message waited for a handler and how long it took
+  void RecordProcessed(const bytes& message, uint64_t queueWaitUs,
+                       uint64_t handlerUs);
+
+  /// Returns false if nothing was recorded for this message type/instruction
+  bool GetSnapshot(unsigned char msgType, unsigned char instruction,
+                   Snapshot& snapshot) const;
+
+  static unsigned int GetHistogramBucket(uint64_t us);
+
+  /// Writes the CSV column names
+  static void WriteCsvHeader(std::ostream& os);
+
+  /// Writes one row per message type/instruction seen so far. Counters are
+  /// cumulative, so the last rows of a file hold the totals.
+  void WriteCsv(std::ostream& os, uint64_t timestamp) const;
+
+  /// Appends the current counters to the file, adding the header if needed
+  bool DumpToFile(const std::string& fileName) const;
+
+  /// Dumps to MESSAGE_STATS_FILE every MESSAGE_STATS_DUMP_INTERVAL_IN_SECONDS
+  void StartPeriodicDump();
+
+  void Clear();
+};
+
+#endif  // __MESSAGESTATS_H__
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "MetricsExporter.h"
+
+#include <event2/buffer.h>
+#include <event2/event.h>
+#include <event2/http.h>
+#include <sstream>
+
+#include "libUtils/DetachedFunction.h"
+#include "libUtils/Logger.h"
+#include "libUtils/Metrics.h"
+
+using namespace std;
+
+namespace {
+
+void HandleRequest(struct evhttp_request* request, void*) {
+  const char* uri = evhttp_request_get_uri(request);
+  if (evhttp_request_get_command(request) != EVHTTP_REQ_GET || uri == nullptr ||
+      string(uri).compare(0, 8, "/metrics") != 0) {
+    evhttp_send_error(request, HTTP_NOTFOUND, nullptr);
+    return;
+  }
+
+  ostringstream oss;
+  Metrics::GetInstance().WriteText(oss);
+  const string text = oss.str();
+
+  struct evbuffer* body = evbuffer_new();
+  if (body == nullptr) {
+    evhttp_send_error(request, HTTP_INTERNAL, nullptr);
+    return;
+  }
+  evbuffer_add(body, text.data(), text.size());
+  evhttp_add_header(evhttp_request_get_output_headers(request), "Content-Type",
+                    "text/plain; version=0.0.4");
+  evhttp_send_reply(request, HTTP_OK, "OK", body);
+  evbuffer_free(body);
+}
+
+}  // namespace
+
+bool MetricsExporter::Start(const string& address, unsigned int port) {
+  if (m_started) {
+    LOG_GENERAL(WARNING, "Metrics exporter already started");
+    return false;
+  }
+
+  struct event_base* base = event_base_new();
+  if (base == nullptr) {
+    LOG_GENERAL(WARNING, "event_base_new failure.");
+    return false;
+  }
+
+  struct evhttp* http = evhttp_new(base);
+  if (http == nullptr) {
+    LOG_GENERAL(WARNING, "evhttp_new failure.");
+    event_base_free(base);
+    return false;
+  }
+
+  if (evhttp_bind_socket(http, address.c_str(), port) != 0) {
+    LOG_GENERAL(WARNING,
+                "Cannot serve metrics on " << address << ":" << port);
+    evhttp_free(http);
+    event_base_free(base);
+    return false;
+  }
+
+  evhttp_set_allowed_methods(http, EVHTTP_REQ_GET);
+  evhttp_set_gencb(http, HandleRequest, nullptr);
+  m_started = true;
+
+  LOG_GENERAL(INFO, "Serving metrics on " << address << ":" << port);
+
+  auto funcRunExporter = [base, http]() -> void {
+    event_base_dispatch(base);
+    evhttp_free(http);
+    event_base_free(base);
+  };
+  DetachedFunction(DetachedFunction::Lane::BLOCKING, 1, funcRunExporter);
+
+  return true;
+}
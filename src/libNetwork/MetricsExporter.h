@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __METRICSEXPORTER_H__
+#define __METRICSEXPORTER_H__
+
+#include <string>
+
+#include "common/Singleton.h"
+
+/// Serves the metrics of Metrics at /metrics over HTTP, on an event loop of
+/// its own, so that Prometheus can scrape the node
+class MetricsExporter : public Singleton<MetricsExporter> {
+  bool m_started = false;
+
+ public:
+  /// Listens on address:port, returning false if that fails. Serves until
+  /// the process exits.
+  bool Start(const std::string& address, unsigned int port);
+};
+
+#endif  // __METRICSEXPORTER_H__
@@ -0,0 +1,287 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <boost/property_tree/ptree.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+#include <cmath>
+#include <fstream>
+#include <thread>
+
+#include "NetworkEmulator.h"
+#include "libUtils/IPConverter.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+using boost::property_tree::ptree;
+
+namespace {
+
+const string DEFAULT_REGION = "default";
+
+bool ParseDistribution(const string& name,
+                       NetworkEmulator::Distribution& distribution) {
+  if (name == "constant") {
+    distribution = NetworkEmulator::CONSTANT;
+  } else if (name == "uniform") {
+    distribution = NetworkEmulator::UNIFORM;
+  } else if (name == "normal") {
+    distribution = NetworkEmulator::NORMAL;
+  } else if (name == "lognormal") {
+    distribution = NetworkEmulator::LOGNORMAL;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+bool ParseLink(const ptree& pt, NetworkEmulator::Link& link) {
+  if (!ParseDistribution(pt.get<string>("distribution", "constant"),
+                         link.m_distribution)) {
+    LOG_GENERAL(WARNING, "Unknown latency distribution "
+                             << pt.get<string>("distribution"));
+    return false;
+  }
+  link.m_latencyMs = pt.get<double>("latency_ms", 0);
+  link.m_jitterMs = pt.get<double>("jitter_ms", 0);
+  link.m_bandwidthKbps = pt.get<double>("bandwidth_kbps", 0);
+  link.m_loss = pt.get<double>("loss", 0);
+  link.m_reset = pt.get<double>("reset", 0);
+
+  if (link.m_latencyMs < 0 || link.m_jitterMs < 0 ||
+      link.m_bandwidthKbps < 0 || link.m_loss < 0 || link.m_reset < 0 ||
+      link.m_loss + link.m_reset > 1) {
+    LOG_GENERAL(WARNING, "Invalid link parameters");
+    return false;
+  }
+  return true;
+}
+
+/// The time size bytes take to go out at kbps, or none without a cap
+chrono::steady_clock::duration TransmitTime(size_t size, double kbps) {
+  if (kbps <= 0) {
+    return chrono::steady_clock::duration::zero();
+  }
+  return chrono::duration_cast<chrono::steady_clock::duration>(
+      chrono::duration<double>(size * 8 / (kbps * 1000)));
+}
+
+}  // namespace
+
+NetworkEmulator::NetworkEmulator() : m_selfRegion(DEFAULT_REGION) {}
+
+NetworkEmulator::~NetworkEmulator() {}
+
+NetworkEmulator& NetworkEmulator::GetInstance() {
+  static NetworkEmulator emulator;
+  return emulator;
+}
+
+bool NetworkEmulator::Load(const string& fileName) {
+  ifstream config(fileName);
+  if (config.fail()) {
+    LOG_GENERAL(WARNING, "Cannot open network emulation file " << fileName);
+    return false;
+  }
+
+  vector<Region> regions;
+  map<pair<string, string>, Link> links;
+  Link defaultLink;
+  double uplinkKbps = 0;
+  uint64_t seed = 0;
+
+  try {
+    ptree pt;
+    read_xml(config, pt);
+    const ptree& root = pt.get_child("network_emulation");
+
+    seed = root.get<uint64_t>("seed", random_device()());
+    uplinkKbps = root.get<double>("uplink_kbps", 0);
+
+    for (const ptree::value_type& v : root) {
+      if (v.first == "region") {
+        Region region;
+        region.m_name = v.second.get<string>("name");
+        for (const ptree::value_type& r : v.second) {
+          if (r.first == "ports") {
+            const string ports = r.second.data();
+            const size_t dash = ports.find('-');
+            const uint32_t first = stoul(ports.substr(0, dash));
+            const uint32_t last =
+                dash == string::npos ? first : stoul(ports.substr(dash + 1));
+            region.m_ports.emplace_back(first, last);
+          } else if (r.first == "ip") {
+            boost::multiprecision::uint128_t ip;
+            if (!IPConverter::ToNumericalIPFromStr(r.second.data(), ip)) {
+              return false;
+            }
+            region.m_ips.emplace_back(ip);
+          }
+        }
+        regions.emplace_back(move(region));
+      } else if (v.first == "link") {
+        Link link;
+        if (!ParseLink(v.second, link)) {
+          return false;
+        }
+        links[{v.second.get<string>("from"), v.second.get<string>("to")}] =
+            link;
+      } else if (v.first == "default_link") {
+        if (!ParseLink(v.second, defaultLink)) {
+          return false;
+        }
+      }
+    }
+  } catch (const exception& e) {
+    LOG_GENERAL(WARNING,
+                "Cannot parse network emulation file " << fileName << ": "
+                                                       << e.what());
+    return false;
+  }
+
+  lock_guard<mutex> g(m_mutex);
+  m_regions = move(regions);
+  m_links = move(links);
+  m_defaultLink = defaultLink;
+  m_uplinkKbps = uplinkKbps;
+  m_peerLinks.clear();
+  m_random.seed(seed);
+  m_loaded = true;
+
+  LOG_GENERAL(INFO, "Network emulation: " << m_regions.size() << " regions "
+                                          << m_links.size() << " links seed "
+                                          << seed);
+  return true;
+}
+
+void NetworkEmulator::SetSelf(const Peer& self) {
+  lock_guard<mutex> g(m_mutex);
+  m_selfRegion = GetRegion(self);
+  LOG_GENERAL(INFO, "Network emulation region " << m_selfRegion);
+}
+
+const string& NetworkEmulator::GetRegion(const Peer& peer) const {
+  for (const auto& region : m_regions) {
+    for (const auto& ports : region.m_ports) {
+      if (peer.m_listenPortHost >= ports.first &&
+          peer.m_listenPortHost <= ports.second) {
+        return region.m_name;
+      }
+    }
+    for (const auto& ip : region.m_ips) {
+      if (peer.m_ipAddress == ip) {
+        return region.m_name;
+      }
+    }
+  }
+  return DEFAULT_REGION;
+}
+
+const NetworkEmulator::Link& NetworkEmulator::GetLink(const string& from,
+                                                      const string& to) const {
+  auto it = m_links.find({from, to});
+  if (it == m_links.end()) {
+    it = m_links.find({to, from});
+  }
+  return it == m_links.end() ? m_defaultLink : it->second;
+}
+
+double NetworkEmulator::SampleLatencyMs(const Link& link) {
+  double latencyMs = link.m_latencyMs;
+
+  switch (link.m_distribution) {
+    case UNIFORM:
+      latencyMs = uniform_real_distribution<double>(
+          link.m_latencyMs - link.m_jitterMs,
+          link.m_latencyMs + link.m_jitterMs)(m_random);
+      break;
+    case NORMAL:
+      latencyMs =
+          normal_distribution<double>(link.m_latencyMs, link.m_jitterMs)(
+              m_random);
+      break;
+    case LOGNORMAL:
+      // latency_ms is the median and jitter_ms about the spread below it,
+      // which leaves the long tail of WAN round trips
+      if (link.m_latencyMs > 0) {
+        const double sigma =
+            log1p(link.m_jitterMs / max(link.m_latencyMs, 1.0));
+        latencyMs = lognormal_distribution<double>(log(link.m_latencyMs),
+                                                   sigma)(m_random);
+      }
+      break;
+    case CONSTANT:
+    default:
+      break;
+  }
+
+  return max(latencyMs, 0.0);
+}
+
+NetworkEmulator::Verdict NetworkEmulator::Shape(
+    const Peer& peer, size_t size,
+    const chrono::steady_clock::time_point& queuedAt) {
+  chrono::steady_clock::time_point deliverAt;
+  {
+    lock_guard<mutex> g(m_mutex);
+    if (!m_loaded) {
+      return DELIVER;
+    }
+
+    const Link& link = GetLink(m_selfRegion, GetRegion(peer));
+
+    const double fate = uniform_real_distribution<double>(0, 1)(m_random);
+    if (fate < link.m_loss) {
+      m_dropped++;
+      return DROP;
+    }
+    if (fate < link.m_loss + link.m_reset) {
+      m_reset++;
+      return RESET;
+    }
+
+    // The message goes out once the uplink and the path to the peer are
+    // free, and arrives a sampled latency later, but never ahead of the
+    // previous message to the same peer, as TCP delivers in order
+    const auto now = chrono::steady_clock::now();
+    PeerLink& peerLink = m_peerLinks[peer];
+
+    const auto start =
+        max(queuedAt, max(peerLink.m_busyUntil, m_uplinkBusyUntil));
+    m_uplinkBusyUntil = start + TransmitTime(size, m_uplinkKbps);
+    peerLink.m_busyUntil = start + TransmitTime(size, link.m_bandwidthKbps);
+
+    deliverAt =
+        max(m_uplinkBusyUntil, peerLink.m_busyUntil) +
+        chrono::duration_cast<chrono::steady_clock::duration>(
+            chrono::duration<double, milli>(SampleLatencyMs(link)));
+    deliverAt = max(deliverAt, peerLink.m_lastDelivery);
+    peerLink.m_lastDelivery = deliverAt;
+
+    if (deliverAt > now) {
+      m_delayMs +=
+          chrono::duration_cast<chrono::milliseconds>(deliverAt - now).count();
+    }
+  }
+
+  this_thread::sleep_until(deliverAt);
+  m_delivered++;
+  return DELIVER;
+}
+
+NetworkEmulator::Stats NetworkEmulator::GetStats() const {
+  return {m_delivered, m_dropped, m_reset, m_delayMs};
+}
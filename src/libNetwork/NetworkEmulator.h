@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __NETWORKEMULATOR_H__
+#define __NETWORKEMULATOR_H__
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "Peer.h"
+
+/// Shapes the messages this node sends as if the peers were spread over a
+/// WAN, for local runs where every node is on the same host. The peers are
+/// grouped into regions, and each pair of regions is joined by a link with
+/// a latency distribution, a bandwidth cap, and rates of lost messages and
+/// reset connections. The topology is read from NETWORK_EMULATION_FILE:
+///
+///   <network_emulation>
+///     <seed>1</seed>
+///     <uplink_kbps>100000</uplink_kbps>
+///     <region>
+///       <name>asia</name>
+///       <ports>5001-5010</ports>
+///       <ip>10.0.0.1</ip>
+///     </region>
+///     <link>
+///       <from>asia</from>
+///       <to>europe</to>
+///       <distribution>lognormal</distribution>
+///       <latency_ms>120</latency_ms>
+///       <jitter_ms>15</jitter_ms>
+///       <bandwidth_kbps>20000</bandwidth_kbps>
+///       <loss>0.001</loss>
+///       <reset>0.0001</reset>
+///     </link>
+///     <default_link>...</default_link>
+///   </network_emulation>
+///
+/// A peer is in the first region listing its port or address, else in the
+/// region "default". Links apply both ways unless the reverse one is given,
+/// and pairs without a link use default_link, which passes everything as is
+/// when absent. Each message is held back until the link would have
+/// delivered it, in order per peer, on the sending thread.
+class NetworkEmulator {
+ public:
+  enum Verdict { DELIVER, DROP, RESET };
+
+  enum Distribution { CONSTANT, UNIFORM, NORMAL, LOGNORMAL };
+
+  struct Link {
+    Distribution m_distribution = CONSTANT;
+    double m_latencyMs = 0;
+    double m_jitterMs = 0;
+    /// 0 for no cap
+    double m_bandwidthKbps = 0;
+    double m_loss = 0;
+    double m_reset = 0;
+  };
+
+  struct Stats {
+    uint64_t m_delivered;
+    uint64_t m_dropped;
+    uint64_t m_reset;
+    /// Total time the messages were held back
+    uint64_t m_delayMs;
+  };
+
+ private:
+  struct Region {
+    std::string m_name;
+    std::vector<std::pair<uint32_t, uint32_t>> m_ports;
+    std::vector<boost::multiprecision::uint128_t> m_ips;
+  };
+
+  /// What has been sent to one peer so far
+  struct PeerLink {
+    std::chrono::steady_clock::time_point m_busyUntil;
+    std::chrono::steady_clock::time_point m_lastDelivery;
+  };
+
+  std::mutex m_mutex;
+  bool m_loaded = false;
+  std::vector<Region> m_regions;
+  std::map<std::pair<std::string, std::string>, Link> m_links;
+  Link m_defaultLink;
+  double m_uplinkKbps = 0;
+  std::string m_selfRegion;
+  std::map<Peer, PeerLink> m_peerLinks;
+  std::chrono::steady_clock::time_point m_uplinkBusyUntil;
+  std::mt19937_64 m_random;
+
+  std::atomic<uint64_t> m_delivered{0};
+  std::atomic<uint64_t> m_dropped{0};
+  std::atomic<uint64_t> m_reset{0};
+  std::atomic<uint64_t> m_delayMs{0};
+
+  NetworkEmulator();
+  ~NetworkEmulator();
+
+  // Singleton should not implement these
+  NetworkEmulator(NetworkEmulator const&) = delete;
+  void operator=(NetworkEmulator const&) = delete;
+
+  const std::string& GetRegion(const Peer& peer) const;
+  const Link& GetLink(const std::string& from, const std::string& to) const;
+  double SampleLatencyMs(const Link& link);
+
+ public:
+  /// Returns the singleton NetworkEmulator instance.
+  static NetworkEmulator& GetInstance();
+
+  /// Reads the topology from the file, replacing any read before
+  bool Load(const std::string& fileName);
+
+  /// Sets the region the sends are shaped from
+  void SetSelf(const Peer& self);
+
+  /// Decides what becomes of a message of the given size, queued for the
+  /// peer at queuedAt, and waits until it is due if it is to be delivered
+  Verdict Shape(const Peer& peer, size_t size,
+                const std::chrono::steady_clock::time_point& queuedAt);
+
+  Stats GetStats() const;
+};
+
+#endif  // __NETWORKEMULATOR_H__
@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __NODEINDEX_H__
+#define __NODEINDEX_H__
+
+#include <unordered_map>
+#include <utility>
+
+#include "ShardStruct.h"
+
+/// Hash index of a list of nodes by public key and by IP address, so that
+/// the membership checks on the message paths need not scan the list.
+///
+/// The committees are changed in place in many places, so the index is not
+/// kept in step with its list. Instead each hit is checked against the node
+/// at the recorded position, and a key that is missing or out of place is
+/// looked up the slow way, rebuilding the index if it is there after all.
+/// A member is thus found in O(1) once the index has caught up with the
+/// latest change, and the answer is always that of a scan of the list.
+///
+/// The index is guarded by the lock of the list it indexes.
+class NodeIndex {
+  /// Shard and index in the shard, or 0 and the index in a flat list
+  using Position = std::pair<uint32_t, uint32_t>;
+
+  struct IpHash {
+    size_t operator()(const boost::multiprecision::uint128_t& ip) const {
+      const uint64_t low = static_cast<uint64_t>(ip);
+      const uint64_t high = static_cast<uint64_t>(ip >> 64);
+      return std::hash<uint64_t>()(low ^ (high * 0x9E3779B97F4A7C15ull));
+    }
+  };
+
+  std::unordered_map<PubKey, Position> m_byPubKey;
+  std::unordered_map<boost::multiprecision::uint128_t, Position, IpHash>
+      m_byIp;
+
+  template <class Nodes, class Visitor>
+  static void Visit(const Nodes& nodes, const Visitor& visitor) {
+    for (uint32_t i = 0; i < nodes.size(); i++) {
+      visitor(Position(0, i), nodes[i].first, nodes[i].second);
+    }
+  }
+
+  template <class Visitor>
+  static void Visit(const DequeOfShard& shards, const Visitor& visitor) {
+    for (uint32_t i = 0; i < shards.size(); i++) {
+      for (uint32_t j = 0; j < shards[i].size(); j++) {
+        visitor(Position(i, j), std::get<SHARD_NODE_PUBKEY>(shards[i][j]),
+                std::get<SHARD_NODE_PEER>(shards[i][j]));
+      }
+    }
+  }
+
+  template <class Nodes>
+  static bool At(const Nodes& nodes, const Position& position,
+                 const PairOfNode*& node) {
+    if (position.first != 0 || position.second >= nodes.size()) {
+      return false;
+    }
+    node = &nodes[position.second];
+    return true;
+  }
+
+  static bool IsAt(const DequeOfShard& shards, const Position& position,
+                   const PubKey& pubKey) {
+    return position.first < shards.size() &&
+           position.second < shards[position.first].size() &&
+           std::get<SHARD_NODE_PUBKEY>(
+               shards[position.first][position.second]) == pubKey;
+  }
+
+  static bool IsAt(const DequeOfShard& shards, const Position& position,
+                   const boost::multiprecision::uint128_t& ip) {
+    return position.first < shards.size() &&
+           position.second < shards[position.first].size() &&
+           std::get<SHARD_NODE_PEER>(shards[position.first][position.second])
+                   .GetIpAddress() == ip;
+  }
+
+  template <class Nodes>
+  static bool IsAt(const Nodes& nodes, const Position& position,
+                   const PubKey& pubKey) {
+    const PairOfNode* node = nullptr;
+    return At(nodes, position, node) && node->first == pubKey;
+  }
+
+  template <class Nodes>
+  static bool IsAt(const Nodes& nodes, const Position& position,
+                   const boost::multiprecision::uint128_t& ip) {
+    const PairOfNode* node = nullptr;
+    return At(nodes, position, node) && node->second.GetIpAddress() == ip;
+  }
+
+ public:
+  /// Indexes the nodes, a VectorOfNode, DequeOfNode or DequeOfShard
+  template <class Nodes>
+  void Rebuild(const Nodes& nodes) {
+    m_byPubKey.clear();
+    m_byIp.clear();
+    Visit(nodes, [this](const Position& position, const PubKey& pubKey,
+                        const Peer& peer) {
+      // The first of duplicates wins, as with a scan of the list
+      m_byPubKey.emplace(pubKey, position);
+      m_byIp.emplace(peer.GetIpAddress(), position);
+    });
+  }
+
+  /// Returns true if a node of the list has the public key
+  template <class Nodes>
+  bool Contains(const Nodes& nodes, const PubKey& pubKey) {
+    const auto it = m_byPubKey.find(pubKey);
+    if (it != m_byPubKey.end() && IsAt(nodes, it->second, pubKey)) {
+      return true;
+    }
+
+    bool found = false;
+    Visit(nodes, [&found, &pubKey](const Position&, const PubKey& key,
+                                   const Peer&) {
+      found = found || key == pubKey;
+    });
+    if (found) {
+      Rebuild(nodes);
+    }
+    return found;
+  }
+
+  /// Returns true if a node of the list has the IP address of the peer
+  template <class Nodes>
+  bool Contains(const Nodes& nodes, const Peer& peer) {
+    const boost::multiprecision::uint128_t& ip = peer.GetIpAddress();
+    const auto it = m_byIp.find(ip);
+    if (it != m_byIp.end() && IsAt(nodes, it->second, ip)) {
+      return true;
+    }
+
+    bool found = false;
+    Visit(nodes, [&found, &ip](const Position&, const PubKey&,
+                               const Peer& node) {
+      found = found || node.GetIpAddress() == ip;
+    });
+    if (found) {
+      Rebuild(nodes);
+    }
+    return found;
+  }
+};
+
+#endif  // __NODEINDEX_H__
@@ -29,19 +29,26 @@
 #include <signal.h>
 #include <stdint.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <unistd.h>
 #include <cstring>
 #include <memory>
 
 #include "Blacklist.h"
+#include "ConnectionPool.h"
+#include "MessageStats.h"
+#include "NetworkEmulator.h"
 #include "P2PComm.h"
 #include "common/Messages.h"
 #include "libCrypto/Sha2.h"
+#include "libUtils/CompressionUtils.h"
 #include "libUtils/DataConversion.h"
 #include "libUtils/DetachedFunction.h"
 #include "libUtils/JoinableFunction.h"
 #include "libUtils/Logger.h"
+#include "libUtils/ReedSolomon.h"
 #include "libUtils/SafeMath.h"
+#include "libUtils/ThreadRoles.h"
 
 using namespace std;
 using namespace boost::multiprecision;
@@ -49,6 +56,8 @@ using namespace boost::multiprecision;
 const unsigned char START_BYTE_NORMAL = 0x11;
 const unsigned char START_BYTE_BROADCAST = 0x22;
 const unsigned char START_BYTE_GOSSIP = 0x33;
+const unsigned char START_BYTE_CHUNK = 0x44;
+const unsigned char START_BYTE_COMPRESSED_FLAG = 0x80;
 const unsigned int HDR_LEN = 6;
 const unsigned int HASH_LEN = 32;
 const unsigned int GOSSIP_MSGTYPE_LEN = 1;
@@ -57,12 +66,24 @@ const unsigned int GOSSIP_SNDR_LISTNR_PORT_LEN = 4;
 
 P2PComm::Dispatcher P2PComm::m_dispatcher;
 
-/// Comparison operator for ordering the list of message hashes.
-struct hash_compare {
-  bool operator()(const bytes& l, const bytes& r) {
-    return equal(l.begin(), l.end(), r.begin(), r.end());
-  }
-};
+// Released messages kept for reuse, and the largest buffer kept with them
+const unsigned int MESSAGE_POOL_SIZE = 1024;
+const size_t MESSAGE_POOL_MAX_CAPACITY = 1024 * 1024;
+
+using MessagePool =
+    boost::lockfree::queue<pair<bytes, Peer>*,
+                           boost::lockfree::capacity<MESSAGE_POOL_SIZE>>;
+
+static MessagePool& GetMessagePool() {
+  static MessagePool pool;
+  return pool;
+}
+
+// Gossip and chunk frames do not start with the message type
+static bool CarriesMessageType(unsigned char startByte) {
+  return (startByte == START_BYTE_NORMAL) ||
+         (startByte == START_BYTE_BROADCAST);
+}
 
 static void close_socket(int* cli_sock) {
   if (cli_sock != NULL) {
@@ -71,48 +92,39 @@ static void close_socket(int* cli_sock) {
   }
 }
 
-static bool comparePairSecond(
-    const pair<bytes, chrono::time_point<chrono::system_clock>>& a,
-    const pair<bytes, chrono::time_point<chrono::system_clock>>& b) {
-  return a.second < b.second;
-}
+P2PComm::P2PComm()
+    : m_broadcastHashes(BROADCAST_DEDUP_BUCKETS,
+                        chrono::milliseconds(BROADCAST_EXPIRY * 1000 /
+                                             max(BROADCAST_DEDUP_BUCKETS, 1u)),
+                        BROADCAST_DEDUP_MAX_ENTRIES),
+      m_chunkAssembler(CHUNKED_BROADCAST_MAX_PENDING,
+                       chrono::seconds(BROADCAST_EXPIRY),
+                       MAX_READ_WATERMARK_IN_BYTES) {
+  for (unsigned int lane = 0; lane < NUM_SEND_LANES; lane++) {
+    m_sendQueues.emplace_back(
+        make_unique<boost::lockfree::queue<SendJob*>>(SENDQUEUE_SIZE));
+    m_sendQueueDepth[lane] = 0;
+  }
 
-P2PComm::P2PComm() : m_sendQueue(SENDQUEUE_SIZE) {
-  auto func = [this]() -> void {
-    bytes emptyHash;
+  if (ENABLE_NETWORK_EMULATION) {
+    NetworkEmulator::GetInstance().Load(NETWORK_EMULATION_FILE);
+  }
 
+  auto func = [this]() -> void {
     while (true) {
       this_thread::sleep_for(chrono::seconds(BROADCAST_INTERVAL));
-      lock(m_broadcastToRemoveMutex, m_broadcastHashesMutex);
-      lock_guard<mutex> g(m_broadcastToRemoveMutex, adopt_lock);
-      lock_guard<mutex> g2(m_broadcastHashesMutex, adopt_lock);
-
-      if (m_broadcastToRemove.empty() ||
-          m_broadcastToRemove.front().second >
-              chrono::system_clock::now() - chrono::seconds(BROADCAST_EXPIRY)) {
-        continue;
-      }
-
-      auto up = upper_bound(
-          m_broadcastToRemove.begin(), m_broadcastToRemove.end(),
-          make_pair(emptyHash, chrono::system_clock::now() -
-                                   chrono::seconds(BROADCAST_EXPIRY)),
-          comparePairSecond);
-
-      for (auto it = m_broadcastToRemove.begin(); it != up; ++it) {
-        m_broadcastHashes.erase(it->first);
-      }
-
-      m_broadcastToRemove.erase(m_broadcastToRemove.begin(), up);
+      ConnectionPool::GetInstance().CleanupIdle();
+      m_chunkAssembler.CleanupExpired();
+      LogSendQueueStats();
     }
   };
 
-  DetachedFunction(1, func);
+  DetachedFunction(DetachedFunction::Lane::BLOCKING, 1, func);
 }
 
 P2PComm::~P2PComm() {
   SendJob* job = NULL;
-  while (m_sendQueue.pop(job)) {
+  while (PopSendJob(job)) {
     delete job;
   }
 }
@@ -122,13 +134,12 @@ P2PComm& P2PComm::GetInstance() {
   return comm;
 }
 
-uint32_t SendJob::writeMsg(const void* buf, int cli_sock, const Peer& from,
-                           const uint32_t message_length) {
+uint32_t SendJob::writeMsg(struct iovec* iov, int iovcnt, int cli_sock,
+                           const Peer& from, const uint32_t message_length) {
   uint32_t written_length = 0;
 
   while (written_length < message_length) {
-    ssize_t n = write(cli_sock, (unsigned char*)buf + written_length,
-                      message_length - written_length);
+    ssize_t n = writev(cli_sock, iov, iovcnt);
 
     if (P2PComm::IsHostHavingNetworkIssue()) {
       LOG_GENERAL(WARNING, "[blacklist] Encountered "
@@ -155,6 +166,19 @@ uint32_t SendJob::writeMsg(const void* buf, int cli_sock, const Peer& from,
     }
 
     written_length += n;
+
+    // Skip the buffers that went out completely and resume from the middle
+    // of the one that was written partially
+    size_t remaining = n;
+    while (iovcnt > 0 && remaining >= iov->iov_len) {
+      remaining -= iov->iov_len;
+      ++iov;
+      --iovcnt;
+    }
+    if (iovcnt > 0) {
+      iov->iov_base = (unsigned char*)iov->iov_base + remaining;
+      iov->iov_len -= remaining;
+    }
   }
 
   if (written_length > 1000000) {
@@ -164,6 +188,67 @@ uint32_t SendJob::writeMsg(const void* buf, int cli_sock, const Peer& from,
   return written_length;
 }
 
+bool SendJob::writeFrame(int cli_sock, const Peer& peer, const bytes& message,
+                         unsigned char start_byte, const bytes& msg_hash) {
+  // Transmission format:
+  // 0x01 ~ 0xFF - version, defined in constant file
+  // 0x11 - start byte
+  // 0xLL 0xLL 0xLL 0xLL - 4-byte length of message
+  // <message>
+
+  // 0x01 ~ 0xFF - version, defined in constant file
+  // 0x22 - start byte (broadcast)
+  // 0xLL 0xLL 0xLL 0xLL - 4-byte length of hash + message
+  // <32-byte hash> <message>
+
+  // 0x01 ~ 0xFF - version, defined in constant file
+  // 0x33 - start byte (report)
+  // 0x00 0x00 0x00 0x01 - 4-byte length of message
+  // 0x00
+
+  // A start byte with START_BYTE_COMPRESSED_FLAG set carries a compressed
+  // <message>; the broadcast hash always covers the uncompressed one
+
+  // Several frames may be written back-to-back on a pooled connection
+  uint32_t length = message.size();
+  const bool is_broadcast =
+      (start_byte & ~START_BYTE_COMPRESSED_FLAG) == START_BYTE_BROADCAST;
+
+  if (is_broadcast) {
+    if (msg_hash.size() != HASH_LEN) {
+      LOG_GENERAL(WARNING, "Wrong message hash length.");
+      return false;
+    }
+    length += HASH_LEN;
+  }
+
+  unsigned char buf[HDR_LEN] = {(unsigned char)(MSG_VERSION & 0xFF),
+                                start_byte,
+                                (unsigned char)((length >> 24) & 0xFF),
+                                (unsigned char)((length >> 16) & 0xFF),
+                                (unsigned char)((length >> 8) & 0xFF),
+                                (unsigned char)(length & 0xFF)};
+
+  // Header, hash and body go out in a single writev straight from the
+  // caller's buffers, so the body is never copied into a send buffer
+  struct iovec iov[3];
+  int iovcnt = 0;
+
+  iov[iovcnt].iov_base = buf;
+  iov[iovcnt++].iov_len = HDR_LEN;
+
+  if (is_broadcast) {
+    iov[iovcnt].iov_base = const_cast<unsigned char*>(msg_hash.data());
+    iov[iovcnt++].iov_len = HASH_LEN;
+  }
+
+  iov[iovcnt].iov_base = const_cast<unsigned char*>(message.data());
+  iov[iovcnt++].iov_len = message.size();
+
+  const uint32_t frame_length = HDR_LEN + length;
+  return frame_length == writeMsg(iov, iovcnt, cli_sock, peer, frame_length);
+}
+
 bool SendJob::SendMessageSocketCore(const Peer& peer, const bytes& message,
                                     unsigned char start_byte,
                                     const bytes& msg_hash) {
@@ -182,14 +267,33 @@ bool SendJob::SendMessageSocketCore(const Peer& peer, const bytes& message,
   }
 
   try {
-    int cli_sock = socket(AF_INET, SOCK_STREAM, 0);
-    unique_ptr<int, void (*)(int*)> cli_sock_closer(&cli_sock, close_socket);
-
     // LINUX HAS NO SO_NOSIGPIPE
     // int set = 1;
     // setsockopt(cli_sock, SOL_SOCKET, SO_NOSIGPIPE, (void *)&set,
     // sizeof(int));
     signal(SIGPIPE, SIG_IGN);
+
+    if (ENABLE_CONNECTION_POOL) {
+      ConnectionPool& pool = ConnectionPool::GetInstance();
+      int pooled_sock = pool.Acquire(peer);
+
+      if (pooled_sock >= 0) {
+        if (writeFrame(pooled_sock, peer, message, start_byte, msg_hash)) {
+          pool.Release(peer, pooled_sock);
+          return true;
+        }
+
+        // The peer may have dropped the connection while it sat idle, so
+        // fall through and resend the whole frame on a fresh one
+        LOG_GENERAL(INFO,
+                    "Pooled connection to " << peer << " failed. Reconnecting");
+        pool.Discard(pooled_sock);
+      }
+    }
+
+    int cli_sock = socket(AF_INET, SOCK_STREAM, 0);
+    unique_ptr<int, void (*)(int*)> cli_sock_closer(&cli_sock, close_socket);
+
     if (cli_sock < 0) {
       LOG_GENERAL(WARNING, "Socket creation failed. Code = "
                                << errno << " Desc: " << std::strerror(errno)
@@ -218,50 +322,13 @@ bool SendJob::SendMessageSocketCore(const Peer& peer, const bytes& message,
       return false;
     }
 
-    // Transmission format:
-    // 0x01 ~ 0xFF - version, defined in constant file
-    // 0x11 - start byte
-    // 0xLL 0xLL 0xLL 0xLL - 4-byte length of message
-    // <message>
-
-    // 0x01 ~ 0xFF - version, defined in constant file
-    // 0x22 - start byte (broadcast)
-    // 0xLL 0xLL 0xLL 0xLL - 4-byte length of hash + message
-    // <32-byte hash> <message>
-
-    // 0x01 ~ 0xFF - version, defined in constant file
-    // 0x33 - start byte (report)
-    // 0x00 0x00 0x00 0x01 - 4-byte length of message
-    // 0x00
-    uint32_t length = message.size();
-
-    if (start_byte == START_BYTE_BROADCAST) {
-      length += HASH_LEN;
-    }
-
-    unsigned char buf[HDR_LEN] = {(unsigned char)(MSG_VERSION & 0xFF),
-                                  start_byte,
-                                  (unsigned char)((length >> 24) & 0xFF),
-                                  (unsigned char)((length >> 16) & 0xFF),
-                                  (unsigned char)((length >> 8) & 0xFF),
-                                  (unsigned char)(length & 0xFF)};
-
-    if (HDR_LEN != writeMsg(buf, cli_sock, peer, HDR_LEN)) {
-      LOG_GENERAL(INFO, "DEBUG: not written_length == " << HDR_LEN);
-    }
-
-    if (start_byte != START_BYTE_BROADCAST) {
-      writeMsg(&message.at(0), cli_sock, peer, length);
-      return true;
-    }
-
-    if (HASH_LEN != writeMsg(&msg_hash.at(0), cli_sock, peer, HASH_LEN)) {
-      LOG_GENERAL(WARNING, "Wrong message hash length.");
-      return true;
+    // A failed write on a fresh connection is not retried, as it is likely
+    // the other end terminated the connection due to a duplicated message
+    if (writeFrame(cli_sock, peer, message, start_byte, msg_hash) &&
+        ENABLE_CONNECTION_POOL) {
+      cli_sock_closer.release();
+      ConnectionPool::GetInstance().Release(peer, cli_sock);
     }
-
-    length -= HASH_LEN;
-    writeMsg(&message.at(0), cli_sock, peer, length);
   } catch (const std::exception& e) {
     LOG_GENERAL(WARNING, "Error with write socket." << ' ' << e.what());
     return false;
@@ -269,10 +336,27 @@ bool SendJob::SendMessageSocketCore(const Peer& peer, const bytes& message,
   return true;
 }
 
-void SendJob::SendMessageCore(const Peer& peer, const bytes message,
-                              unsigned char startbyte, const bytes hash) {
+void SendJob::SendMessageCore(
+    const Peer& peer, const bytes& message, unsigned char startbyte,
+    const bytes& hash, const chrono::steady_clock::time_point& queuedAt) {
+  bool reset = false;
+  if (ENABLE_NETWORK_EMULATION) {
+    const size_t frameSize = HDR_LEN + hash.size() + message.size();
+    switch (NetworkEmulator::GetInstance().Shape(peer, frameSize, queuedAt)) {
+      case NetworkEmulator::DROP:
+        return;
+      case NetworkEmulator::RESET:
+        // Goes through the retries as if the peer had reset the connection
+        reset = true;
+        break;
+      default:
+        break;
+    }
+  }
+
   uint32_t retry_counter = 0;
-  while (!SendMessageSocketCore(peer, message, startbyte, hash)) {
+  while (reset || !SendMessageSocketCore(peer, message, startbyte, hash)) {
+    reset = false;
     // comment this since we already check this in SendMessageSocketCore() and
     // also add to blacklist
     /*if (P2PComm::IsHostHavingNetworkIssue()) {
@@ -302,13 +386,49 @@ void SendJob::SendMessageCore(const Peer& peer, const bytes message,
   }
 }
 
+void SendJob::CompressMessage() {
+  if (!ENABLE_WIRE_COMPRESSION || m_compressed ||
+      m_message->size() < WIRE_COMPRESSION_THRESHOLD_IN_BYTES) {
+    return;
+  }
+
+  bytes compressed;
+  if (!CompressionUtils::Compress(*m_message, compressed)) {
+    return;
+  }
+
+  // Payloads that do not shrink (e.g. already compressed data) go out as is
+  if (compressed.size() >= m_message->size()) {
+    return;
+  }
+
+  LOG_GENERAL(DEBUG, "Compressed message from " << m_message->size() << " to "
+                                                << compressed.size()
+                                                << " bytes");
+
+  m_message = make_shared<const bytes>(move(compressed));
+  m_compressed = true;
+}
+
+unsigned char SendJob::GetWireStartByte() const {
+  return m_compressed ? (m_startbyte | START_BYTE_COMPRESSED_FLAG)
+                      : m_startbyte;
+}
+
+void SendJob::QueueForPeer(const Peer& peer) {
+  if (PeerSendQueue::GetInstance().Push(
+          peer, m_lane, {m_message, GetWireStartByte(), m_hash})) {
+    P2PComm::GetInstance().DrainPeerSendQueueAsync(peer);
+  }
+}
+
 void SendJobPeer::DoSend() {
   if (Blacklist::GetInstance().Exist(m_peer.m_ipAddress)) {
     LOG_GENERAL(INFO, m_peer << " is blacklisted - blocking all messages");
     return;
   }
 
-  SendMessageCore(m_peer, m_message, m_startbyte, m_hash);
+  QueueForPeer(m_peer);
 }
 
 template <class T>
@@ -340,7 +460,7 @@ void SendJobPeers<T>::DoSend() {
       continue;
     }
 
-    SendMessageCore(peer, m_message, m_startbyte, m_hash);
+    QueueForPeer(peer);
   }
 
   if ((m_startbyte == START_BYTE_BROADCAST) && (m_selfPeer != Peer())) {
@@ -350,68 +470,251 @@ void SendJobPeers<T>::DoSend() {
   }
 }
 
+void P2PComm::QueueSendJob(SendJob* job) {
+  if (!m_sendQueues.at(job->m_lane)->bounded_push(job)) {
+    LOG_GENERAL(WARNING, "SendQueue is full for lane "
+                             << PeerSendQueue::GetLaneName(job->m_lane));
+    delete job;
+    return;
+  }
+
+  m_sendQueueDepth[job->m_lane]++;
+}
+
+bool P2PComm::PopSendJob(SendJob*& job) {
+  // Always serve the most urgent lane that has something queued
+  for (unsigned int lane = 0; lane < NUM_SEND_LANES; lane++) {
+    if (m_sendQueues.at(lane)->pop(job)) {
+      m_sendQueueDepth[lane]--;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void P2PComm::LogSendQueueStats() {
+  PeerSendQueue& peerQueue = PeerSendQueue::GetInstance();
+
+  for (unsigned int i = 0; i < NUM_SEND_LANES; i++) {
+    const SendLane lane = (SendLane)i;
+    LOG_GENERAL(INFO, "[SENDQ] " << PeerSendQueue::GetLaneName(lane)
+                                 << " jobs=" << m_sendQueueDepth[i]
+                                 << " queued=" << peerQueue.GetLaneDepth(lane)
+                                 << " dropped="
+                                 << peerQueue.GetLaneDropped(lane));
+  }
+
+  if (ENABLE_NETWORK_EMULATION) {
+    const NetworkEmulator::Stats stats =
+        NetworkEmulator::GetInstance().GetStats();
+    LOG_GENERAL(INFO, "[NETEM] delivered=" << stats.m_delivered
+                                           << " dropped=" << stats.m_dropped
+                                           << " reset=" << stats.m_reset
+                                           << " delay_ms=" << stats.m_delayMs);
+  }
+}
+
+SendLane P2PComm::GetSendLane(const bytes& message, unsigned char startByte) {
+  if (startByte == START_BYTE_GOSSIP) {
+    return SEND_LANE_GOSSIP;
+  }
+
+  // Chunks are only used for large blocks
+  if (startByte == START_BYTE_CHUNK) {
+    return SEND_LANE_BLOCK;
+  }
+
+  if (message.size() <= MessageOffset::INST) {
+    return SEND_LANE_BLOCK;
+  }
+
+  const unsigned char type = message.at(MessageOffset::TYPE);
+  const unsigned char ins = message.at(MessageOffset::INST);
+
+  switch (type) {
+    case MessageType::DIRECTORY:
+      if (ins == DSInstructionType::DSBLOCKCONSENSUS ||
+          ins == DSInstructionType::FINALBLOCKCONSENSUS ||
+          ins == DSInstructionType::VIEWCHANGECONSENSUS) {
+        return SEND_LANE_CONSENSUS;
+      }
+      break;
+    case MessageType::NODE:
+      if (ins == NodeInstructionType::MICROBLOCKCONSENSUS ||
+          ins == NodeInstructionType::FALLBACKCONSENSUS) {
+        return SEND_LANE_CONSENSUS;
+      }
+      if (ins == NodeInstructionType::SUBMITTRANSACTION ||
+          ins == NodeInstructionType::FORWARDTXNPACKET) {
+        return SEND_LANE_TXN;
+      }
+      break;
+    case MessageType::CONSENSUSUSER:
+      return SEND_LANE_CONSENSUS;
+    case MessageType::LOOKUP:
+      if (ins == LookupInstructionType::FORWARDTXN) {
+        return SEND_LANE_TXN;
+      }
+      break;
+    default:
+      break;
+  }
+
+  return SEND_LANE_BLOCK;
+}
+
+void P2PComm::DrainPeerSendQueueAsync(const Peer& peer) {
+  auto funcDrain = [peer]() mutable -> void {
+    PeerSendItem item;
+    while (PeerSendQueue::GetInstance().Pop(peer, item)) {
+      SendJob::SendMessageCore(peer, *item.m_message, item.m_startbyte,
+                               item.m_hash, item.m_queuedAt);
+    }
+  };
+  m_SendPool.AddJob(funcDrain);
+}
+
 void P2PComm::ProcessSendJob(SendJob* job) {
   auto funcSendMsg = [job]() mutable -> void {
+    // Compress once per job, on the pool thread, for all of its peers
+    job->CompressMessage();
     job->DoSend();
     delete job;
   };
   m_SendPool.AddJob(funcSendMsg);
 }
 
-void P2PComm::ClearBroadcastHashAsync(const bytes& message_hash) {
-  LOG_MARKER();
-  lock_guard<mutex> guard(m_broadcastToRemoveMutex);
-  m_broadcastToRemove.emplace_back(message_hash, chrono::system_clock::now());
+pair<bytes, Peer>* P2PComm::AcquireMessage() {
+  pair<bytes, Peer>* message = nullptr;
+  if (GetMessagePool().pop(message)) {
+    return message;
+  }
+  return new pair<bytes, Peer>();
 }
 
-void P2PComm::ProcessBroadCastMsg(bytes& message, const Peer& from) {
-  bytes msg_hash(message.begin() + HDR_LEN,
-                 message.begin() + HDR_LEN + HASH_LEN);
+void P2PComm::ReleaseMessage(pair<bytes, Peer>* message) {
+  if (message == nullptr) {
+    return;
+  }
 
-  P2PComm& p2p = P2PComm::GetInstance();
+  // Keep the buffer for the next message unless it would pin a large block
+  if (message->first.capacity() > MESSAGE_POOL_MAX_CAPACITY) {
+    bytes().swap(message->first);
+  } else {
+    message->first.clear();
+  }
 
-  // Check if this message has been received before
-  bool found = false;
-  {
-    lock_guard<mutex> guard(p2p.m_broadcastHashesMutex);
-
-    found =
-        (p2p.m_broadcastHashes.find(msg_hash) != p2p.m_broadcastHashes.end());
-    // While we have the lock, we should quickly add the hash
-    if (!found) {
-      SHA2<HASH_TYPE::HASH_VARIANT_256> sha256;
-      sha256.Update(message, HDR_LEN + HASH_LEN,
-                    message.size() - HDR_LEN - HASH_LEN);
-      bytes this_msg_hash = sha256.Finalize();
-
-      if (this_msg_hash == msg_hash) {
-        p2p.m_broadcastHashes.insert(this_msg_hash);
-      } else {
-        LOG_GENERAL(WARNING, "Incorrect message hash.");
-        return;
-      }
-    }
+  if (!GetMessagePool().bounded_push(message)) {
+    delete message;
   }
+}
 
-  if (found) {
+// The message holds only the payload that follows msgHash in the frame
+void P2PComm::ProcessBroadCastMsg(const bytes& msgHash,
+                                  pair<bytes, Peer>* message) {
+  P2PComm& p2p = P2PComm::GetInstance();
+
+  // Check if this message has been received before
+  if (p2p.m_broadcastHashes.Contains(msgHash)) {
     // We already sent and/or received this message before -> discard
     LOG_GENERAL(INFO, "Discarding duplicate");
+    ReleaseMessage(message);
     return;
   }
 
-  p2p.ClearBroadcastHashAsync(msg_hash);
+  SHA2<HASH_TYPE::HASH_VARIANT_256> sha256;
+  sha256.Update(message->first);
+  if (sha256.Finalize() != msgHash) {
+    LOG_GENERAL(WARNING, "Incorrect message hash.");
+    ReleaseMessage(message);
+    return;
+  }
+
+  // Another connection may have delivered the same message meanwhile
+  if (!p2p.m_broadcastHashes.Insert(msgHash)) {
+    LOG_GENERAL(INFO, "Discarding duplicate");
+    ReleaseMessage(message);
+    return;
+  }
 
   string msgHashStr;
-  if (!DataConversion::Uint8VecToHexStr(msg_hash, msgHashStr)) {
+  if (!DataConversion::Uint8VecToHexStr(msgHash, msgHashStr)) {
+    ReleaseMessage(message);
     return;
   }
 
   LOG_STATE("[BROAD][" << std::setw(15) << std::left << p2p.m_selfPeer << "]["
                        << msgHashStr.substr(0, 6) << "] RECV");
 
-  // Move the shared_ptr message to raw pointer type
-  pair<bytes, Peer>* raw_message = new pair<bytes, Peer>(
-      bytes(message.begin() + HDR_LEN + HASH_LEN, message.end()), from);
+  // Queue the message
+  m_dispatcher(message);
+}
+
+void P2PComm::ProcessChunkMsg(bytes& message, const Peer& from) {
+  ChunkFrame frame;
+  if (!frame.Deserialize(message, HDR_LEN)) {
+    LOG_GENERAL(WARNING, "Invalid chunk from " << from);
+    return;
+  }
+
+  P2PComm& p2p = P2PComm::GetInstance();
+
+  // Late chunks of a message we already have
+  if (p2p.m_broadcastHashes.Contains(frame.m_hash)) {
+    return;
+  }
+
+  vector<Peer> relayPeers;
+  relayPeers.swap(frame.m_relayPeers);
+
+  ChunkAssembler::PendingMessage ready;
+  const auto result = p2p.m_chunkAssembler.Add(frame, ready);
+  if (result == ChunkAssembler::CHUNK_REJECTED ||
+      result == ChunkAssembler::CHUNK_DUPLICATE) {
+    return;
+  }
+
+  // Pass a chunk from the origin on to the rest of its group before the
+  // possibly slow decoding, and only once, so a frame cannot be amplified
+  if (!relayPeers.empty()) {
+    relayPeers.erase(
+        remove(relayPeers.begin(), relayPeers.end(), p2p.m_selfPeer),
+        relayPeers.end());
+
+    bytes relay;
+    frame.Serialize(relay);
+    p2p.SendMessage(relayPeers, make_shared<const bytes>(move(relay)),
+                    START_BYTE_CHUNK);
+  }
+
+  if (result != ChunkAssembler::CHUNK_COMPLETED) {
+    return;
+  }
+
+  bytes assembled;
+  if (!ChunkAssembler::Assemble(frame.m_hash, ready, assembled)) {
+    return;
+  }
+
+  // Another connection may have delivered the same message meanwhile
+  if (!p2p.m_broadcastHashes.Insert(frame.m_hash)) {
+    LOG_GENERAL(INFO, "Discarding duplicate");
+    return;
+  }
+
+  string msgHashStr;
+  if (!DataConversion::Uint8VecToHexStr(frame.m_hash, msgHashStr)) {
+    return;
+  }
+
+  LOG_STATE("[BROAD][" << std::setw(15) << std::left << p2p.m_selfPeer << "]["
+                       << msgHashStr.substr(0, 6) << "] RECV "
+                       << ready.m_chunks.size() << " CHUNKS");
+
+  pair<bytes, Peer>* raw_message = AcquireMessage();
+  raw_message->first = move(assembled);
+  raw_message->second = from;
 
   // Queue the message
   m_dispatcher(raw_message);
@@ -444,12 +747,26 @@ void P2PComm::ProcessBroadCastMsg(bytes& message, const Peer& from) {
 
     if (p2p.SpreadForeignRumor(rumor_message)) {
       // skip the keys and signature.
-      bytes tmp(rumor_message.begin() + PUB_KEY_SIZE +
-                    SIGNATURE_CHALLENGE_SIZE + SIGNATURE_RESPONSE_SIZE,
-                rumor_message.end());
-      std::pair<bytes, Peer>* raw_message = new pair<bytes, Peer>(tmp, from);
+      std::pair<bytes, Peer>* raw_message = AcquireMessage();
+      raw_message->first.assign(rumor_message.begin() + PUB_KEY_SIZE +
+                                    SIGNATURE_CHALLENGE_SIZE +
+                                    SIGNATURE_RESPONSE_SIZE,
+                                rumor_message.end());
+      raw_message->second = from;
 
-      LOG_GENERAL(INFO, "Rumor size: " << tmp.size());
+      LOG_GENERAL(INFO, "Rumor size: " << raw_message->first.size());
+
+      // Queue the message
+      m_dispatcher(raw_message);
+    }
+  } else if (gossipMsgTyp == (uint8_t)RRS::Message::Type::BATCH) {
+    for (auto& rumor :
+         p2p.m_rumorManager.RumorBatchReceived(rumor_message, from)) {
+      LOG_GENERAL(INFO, "Rumor size: " << rumor.size());
+
+      std::pair<bytes, Peer>* raw_message = AcquireMessage();
+      raw_message->first = std::move(rumor);
+      raw_message->second = from;
 
       // Queue the message
       m_dispatcher(raw_message);
@@ -458,8 +775,9 @@ void P2PComm::ProcessBroadCastMsg(bytes& message, const Peer& from) {
     auto resp = p2p.m_rumorManager.RumorReceived(
         (unsigned int)gossipMsgTyp, gossipMsgRound, rumor_message, from);
     if (resp.first) {
-      std::pair<bytes, Peer>* raw_message =
-          new pair<bytes, Peer>(resp.second, from);
+      std::pair<bytes, Peer>* raw_message = AcquireMessage();
+      raw_message->first = std::move(resp.second);
+      raw_message->second = from;
 
       LOG_GENERAL(INFO, "Rumor size: " << rumor_message.size());
 
@@ -469,51 +787,41 @@ void P2PComm::ProcessBroadCastMsg(bytes& message, const Peer& from) {
   }
 }
 
-void P2PComm::EventCallback(struct bufferevent* bev, short events,
-                            [[gnu::unused]] void* ctx) {
-  unique_ptr<struct bufferevent, decltype(&bufferevent_free)> socket_closer(
-      bev, bufferevent_free);
+bool P2PComm::DecompressFrame(bytes& message) {
+  const unsigned char startByte = message[1] & ~START_BYTE_COMPRESSED_FLAG;
 
-  if (events & BEV_EVENT_ERROR) {
-    LOG_GENERAL(WARNING, "Error from bufferevent.");
-    return;
+  // The broadcast hash stays outside the compressed part of the frame
+  const unsigned int prefixLength =
+      (startByte == START_BYTE_BROADCAST) ? HDR_LEN + HASH_LEN : HDR_LEN;
+
+  if (message.size() <= prefixLength) {
+    LOG_GENERAL(WARNING, "Compressed message too short.");
+    return false;
   }
 
-  // Not all bytes read out
-  if (!(events & (BEV_EVENT_EOF | BEV_EVENT_ERROR))) {
-    LOG_GENERAL(WARNING, "Unknown error from bufferevent.");
-    return;
+  bytes body;
+  if (!CompressionUtils::Decompress(message.data() + prefixLength,
+                                    message.size() - prefixLength,
+                                    MAX_READ_WATERMARK_IN_BYTES, body)) {
+    LOG_GENERAL(WARNING, "Failed to decompress message.");
+    return false;
   }
 
-  // Get the IP info
-  int fd = bufferevent_getfd(bev);
-  struct sockaddr_in cli_addr;
-  socklen_t addr_size = sizeof(struct sockaddr_in);
-  getpeername(fd, (struct sockaddr*)&cli_addr, &addr_size);
-  Peer from(cli_addr.sin_addr.s_addr, cli_addr.sin_port);
+  message.resize(prefixLength);
+  message.insert(message.end(), body.begin(), body.end());
 
-  // Get the data stored in buffer
-  struct evbuffer* input = bufferevent_get_input(bev);
-  if (input == NULL) {
-    LOG_GENERAL(WARNING, "bufferevent_get_input failure.");
-    return;
-  }
-  size_t len = evbuffer_get_length(input);
-  if (len == 0) {
-    LOG_GENERAL(WARNING, "evbuffer_get_length failure.");
-    return;
-  }
-  bytes message(len);
-  if (evbuffer_copyout(input, message.data(), len) !=
-      static_cast<ev_ssize_t>(len)) {
-    LOG_GENERAL(WARNING, "evbuffer_copyout failure.");
-    return;
-  }
-  if (evbuffer_drain(input, len) != 0) {
-    LOG_GENERAL(WARNING, "evbuffer_drain failure.");
-    return;
-  }
+  // Rewrite the header as if the frame had been sent uncompressed
+  const uint32_t length = message.size() - HDR_LEN;
+  message[1] = startByte;
+  message[2] = (length >> 24) & 0xFF;
+  message[3] = (length >> 16) & 0xFF;
+  message[4] = (length >> 8) & 0xFF;
+  message[5] = length & 0xFF;
+
+  return true;
+}
 
+void P2PComm::ProcessMessage(bytes& message, Peer from) {
   // Reception format:
   // 0x01 ~ 0xFF - version, defined in constant file
   // 0x11 - start byte
@@ -536,40 +844,14 @@ void P2PComm::EventCallback(struct bufferevent* bev, short events,
   // 0x00 0x00 0x00 0x01 - 4-byte length of message
   // 0x00
 
-  // Check for minimum message size
-  if (message.size() <= HDR_LEN) {
-    LOG_GENERAL(WARNING, "Empty message received.");
+  // Any of the above with START_BYTE_COMPRESSED_FLAG set in the start byte
+  // carries a compressed <message> and is expanded before processing
+  if ((message[1] & START_BYTE_COMPRESSED_FLAG) && !DecompressFrame(message)) {
     return;
   }
 
-  const unsigned char version = message[0];
   const unsigned char startByte = message[1];
-
-  // Check for version requirement
-  if (version != (unsigned char)(MSG_VERSION & 0xFF)) {
-    LOG_GENERAL(WARNING, "Header version wrong, received ["
-                             << version - 0x00 << "] while expected ["
-                             << MSG_VERSION << "].");
-    return;
-  }
-
-  const uint32_t messageLength =
-      (message[2] << 24) + (message[3] << 16) + (message[4] << 8) + message[5];
-
-  {
-    // Check for length consistency
-    uint32_t res;
-
-    if (!SafeMath<uint32_t>::sub(message.size(), HDR_LEN, res)) {
-      LOG_GENERAL(WARNING, "Unexpected subtraction operation!");
-      return;
-    }
-
-    if (messageLength != res) {
-      LOG_GENERAL(WARNING, "Incorrect message length.");
-      return;
-    }
-  }
+  const uint32_t messageLength = message.size() - HDR_LEN;
 
   if (startByte == START_BYTE_BROADCAST) {
     LOG_PAYLOAD(INFO, "Incoming broadcast " << from, message,
@@ -582,14 +864,21 @@ void P2PComm::EventCallback(struct bufferevent* bev, short events,
       return;
     }
 
-    ProcessBroadCastMsg(message, from);
+    const bytes msgHash(message.begin() + HDR_LEN,
+                        message.begin() + HDR_LEN + HASH_LEN);
+    pair<bytes, Peer>* raw_message = AcquireMessage();
+    raw_message->first.assign(message.begin() + HDR_LEN + HASH_LEN,
+                              message.end());
+    raw_message->second = from;
+
+    ProcessBroadCastMsg(msgHash, raw_message);
   } else if (startByte == START_BYTE_NORMAL) {
     LOG_PAYLOAD(INFO, "Incoming normal " << from, message,
                 Logger::MAX_BYTES_TO_DISPLAY);
 
-    // Move the shared_ptr message to raw pointer type
-    pair<bytes, Peer>* raw_message = new pair<bytes, Peer>(
-        bytes(message.begin() + HDR_LEN, message.end()), from);
+    pair<bytes, Peer>* raw_message = AcquireMessage();
+    raw_message->first.assign(message.begin() + HDR_LEN, message.end());
+    raw_message->second = from;
 
     // Queue the message
     m_dispatcher(raw_message);
@@ -617,23 +906,182 @@ void P2PComm::EventCallback(struct bufferevent* bev, short events,
     }
 
     ProcessGossipMsg(message, from);
+  } else if (startByte == START_BYTE_CHUNK) {
+    ProcessChunkMsg(message, from);
   } else {
     // Unexpected start byte. Drop this message
     LOG_GENERAL(WARNING, "Incorrect start byte.");
   }
 }
 
+bool P2PComm::ProcessReceivedFrames(struct evbuffer* input, const Peer& from) {
+  // A sender using a pooled connection writes several frames on the same
+  // socket, so consume every complete frame and leave partial ones buffered
+  while (true) {
+    size_t len = evbuffer_get_length(input);
+    if (len < HDR_LEN) {
+      return true;
+    }
+
+    unsigned char header[HDR_LEN];
+    if (evbuffer_copyout(input, header, HDR_LEN) !=
+        static_cast<ev_ssize_t>(HDR_LEN)) {
+      LOG_GENERAL(WARNING, "evbuffer_copyout failure.");
+      return false;
+    }
+
+    const unsigned char version = header[0];
+
+    // Check for version requirement
+    if (version != (unsigned char)(MSG_VERSION & 0xFF)) {
+      LOG_GENERAL(WARNING, "Header version wrong, received ["
+                               << version - 0x00 << "] while expected ["
+                               << MSG_VERSION << "].");
+      return false;
+    }
+
+    const uint32_t messageLength =
+        (header[2] << 24) + (header[3] << 16) + (header[4] << 8) + header[5];
+
+    // Check for minimum message size
+    if (messageLength == 0) {
+      LOG_GENERAL(WARNING, "Empty message received.");
+      return false;
+    }
+
+    uint32_t frameLength;
+    if (!SafeMath<uint32_t>::add(messageLength, HDR_LEN, frameLength)) {
+      LOG_GENERAL(WARNING, "Unexpected addition operation!");
+      return false;
+    }
+
+    if (len < frameLength) {
+      return true;
+    }
+
+    // Uncompressed normal and broadcast frames carry the payload as is
+    const unsigned char startByte = header[1];
+    if (startByte == START_BYTE_NORMAL || startByte == START_BYTE_BROADCAST) {
+      if (!ProcessReceivedPayload(input, startByte, messageLength, from)) {
+        return false;
+      }
+      continue;
+    }
+
+    bytes message(frameLength);
+    if (evbuffer_remove(input, message.data(), frameLength) !=
+        static_cast<int>(frameLength)) {
+      LOG_GENERAL(WARNING, "evbuffer_remove failure.");
+      return false;
+    }
+
+    ProcessMessage(message, from);
+  }
+}
+
+// Reads the payload of a complete frame straight into the message for the
+// dispatcher, so that it is not copied out of the frame a second time
+bool P2PComm::ProcessReceivedPayload(struct evbuffer* input,
+                                     unsigned char startByte,
+                                     uint32_t messageLength, const Peer& from) {
+  if (evbuffer_drain(input, HDR_LEN) != 0) {
+    LOG_GENERAL(WARNING, "evbuffer_drain failure.");
+    return false;
+  }
+
+  bytes msgHash;
+  if (startByte == START_BYTE_BROADCAST) {
+    if (messageLength <= HASH_LEN) {
+      LOG_GENERAL(WARNING,
+                  "Hash missing or empty broadcast message (messageLength = "
+                      << messageLength << ")");
+      return evbuffer_drain(input, messageLength) == 0;
+    }
+
+    msgHash.resize(HASH_LEN);
+    if (evbuffer_remove(input, msgHash.data(), HASH_LEN) !=
+        static_cast<int>(HASH_LEN)) {
+      LOG_GENERAL(WARNING, "evbuffer_remove failure.");
+      return false;
+    }
+    messageLength -= HASH_LEN;
+  }
+
+  pair<bytes, Peer>* raw_message = AcquireMessage();
+  raw_message->first.resize(messageLength);
+  raw_message->second = from;
+  if (evbuffer_remove(input, raw_message->first.data(), messageLength) !=
+      static_cast<int>(messageLength)) {
+    LOG_GENERAL(WARNING, "evbuffer_remove failure.");
+    ReleaseMessage(raw_message);
+    return false;
+  }
+
+  if (startByte == START_BYTE_BROADCAST) {
+    LOG_PAYLOAD(INFO, "Incoming broadcast " << from, raw_message->first,
+                Logger::MAX_BYTES_TO_DISPLAY);
+    ProcessBroadCastMsg(msgHash, raw_message);
+    return true;
+  }
+
+  LOG_PAYLOAD(INFO, "Incoming normal " << from, raw_message->first,
+              Logger::MAX_BYTES_TO_DISPLAY);
+
+  // Queue the message
+  m_dispatcher(raw_message);
+  return true;
+}
+
+Peer P2PComm::GetPeerFromBufferEvent(struct bufferevent* bev) {
+  int fd = bufferevent_getfd(bev);
+  struct sockaddr_in cli_addr;
+  socklen_t addr_size = sizeof(struct sockaddr_in);
+  getpeername(fd, (struct sockaddr*)&cli_addr, &addr_size);
+  return Peer(cli_addr.sin_addr.s_addr, cli_addr.sin_port);
+}
+
+void P2PComm::EventCallback(struct bufferevent* bev, short events,
+                            [[gnu::unused]] void* ctx) {
+  unique_ptr<struct bufferevent, decltype(&bufferevent_free)> socket_closer(
+      bev, bufferevent_free);
+
+  if (events & BEV_EVENT_ERROR) {
+    LOG_GENERAL(WARNING, "Error from bufferevent.");
+    return;
+  }
+
+  if (events & BEV_EVENT_TIMEOUT) {
+    LOG_GENERAL(DEBUG, "Closing idle connection.");
+    return;
+  }
+
+  // Not all bytes read out
+  if (!(events & BEV_EVENT_EOF)) {
+    LOG_GENERAL(WARNING, "Unknown error from bufferevent.");
+    return;
+  }
+
+  // Get the data stored in buffer
+  struct evbuffer* input = bufferevent_get_input(bev);
+  if (input == NULL) {
+    LOG_GENERAL(WARNING, "bufferevent_get_input failure.");
+    return;
+  }
+
+  // Frames completed by the final read may still be waiting in the buffer
+  if (ProcessReceivedFrames(input, GetPeerFromBufferEvent(bev)) &&
+      evbuffer_get_length(input) > 0) {
+    LOG_GENERAL(WARNING, "Incorrect message length.");
+  }
+}
+
 void P2PComm::ReadCallback(struct bufferevent* bev, [[gnu::unused]] void* ctx) {
   struct evbuffer* input = bufferevent_get_input(bev);
 
   size_t len = evbuffer_get_length(input);
   if (len >= MAX_READ_WATERMARK_IN_BYTES) {
     // Get the IP info
-    int fd = bufferevent_getfd(bev);
-    struct sockaddr_in cli_addr;
-    socklen_t addr_size = sizeof(struct sockaddr_in);
-    getpeername(fd, (struct sockaddr*)&cli_addr, &addr_size);
-    Peer from(cli_addr.sin_addr.s_addr, cli_addr.sin_port);
+    Peer from = GetPeerFromBufferEvent(bev);
     LOG_GENERAL(WARNING, "[blacklist] Encountered data of size: "
                              << len << " being received."
                              << " Adding sending node "
@@ -641,6 +1089,11 @@ void P2PComm::ReadCallback(struct bufferevent* bev, [[gnu::unused]] void* ctx) {
                              << " to blacklist");
     Blacklist::GetInstance().Add(from.m_ipAddress);
     bufferevent_free(bev);
+    return;
+  }
+
+  if (!ProcessReceivedFrames(input, GetPeerFromBufferEvent(bev))) {
+    bufferevent_free(bev);
   }
 }
 
@@ -689,6 +1142,14 @@ void P2PComm::AcceptConnectionCallback([[gnu::unused]] evconnlistener* listener,
 
   bufferevent_setwatermark(bev, EV_READ, MIN_READ_WATERMARK_IN_BYTES,
                            MAX_READ_WATERMARK_IN_BYTES);
+  // Senders keep pooled connections open for up to
+  // CONNECTION_POOL_IDLE_TIMEOUT_IN_SECONDS, so only reclaim inbound ones that
+  // stay idle well past that
+  struct timeval read_timeout;
+  read_timeout.tv_sec = 2 * CONNECTION_POOL_IDLE_TIMEOUT_IN_SECONDS;
+  read_timeout.tv_usec = 0;
+  bufferevent_set_timeouts(bev, &read_timeout, NULL);
+
   bufferevent_setcb(bev, ReadCallback, NULL, EventCallback, NULL);
   bufferevent_enable(bev, EV_READ | EV_WRITE);
 }
@@ -706,13 +1167,13 @@ void P2PComm::StartMessagePump(uint32_t listen_port_host,
   auto funcCheckSendQueue = [this]() mutable -> void {
     SendJob* job = NULL;
     while (true) {
-      while (m_sendQueue.pop(job)) {
+      while (PopSendJob(job)) {
         ProcessSendJob(job);
       }
       std::this_thread::sleep_for(std::chrono::microseconds(1));
     }
   };
-  DetachedFunction(1, funcCheckSendQueue);
+  DetachedFunction(DetachedFunction::Lane::BLOCKING, 1, funcCheckSendQueue);
 
   m_dispatcher = dispatcher;
 
@@ -722,6 +1183,38 @@ void P2PComm::StartMessagePump(uint32_t listen_port_host,
   serv_addr.sin_port = htons(listen_port_host);
   serv_addr.sin_addr.s_addr = INADDR_ANY;
 
+  unsigned int num_reactors = max(MESSAGE_PUMP_REACTORS, 1u);
+  unsigned int listener_flags = LEV_OPT_REUSEABLE | LEV_OPT_CLOSE_ON_FREE;
+
+  if (num_reactors > 1) {
+#ifdef LEV_OPT_REUSEABLE_PORT
+    // Every reactor binds its own listener to the same port and the kernel
+    // spreads incoming connections across them
+    listener_flags |= LEV_OPT_REUSEABLE_PORT;
+#else
+    LOG_GENERAL(WARNING,
+                "SO_REUSEPORT not supported by libevent, using one reactor");
+    num_reactors = 1;
+#endif
+  }
+
+  LOG_GENERAL(INFO, "Starting " << num_reactors << " message pump reactor(s)");
+
+  if (num_reactors > 1) {
+    auto funcRunReactor = [serv_addr, listener_flags]() mutable -> void {
+      RunMessagePumpReactor(serv_addr, listener_flags);
+    };
+    DetachedFunction(DetachedFunction::Lane::BLOCKING, num_reactors - 1,
+                     funcRunReactor);
+  }
+
+  RunMessagePumpReactor(serv_addr, listener_flags);
+}
+
+void P2PComm::RunMessagePumpReactor(const struct sockaddr_in& serv_addr,
+                                    unsigned int listener_flags) {
+  ThreadRoles::GetInstance().ApplyToCurrentThread("Pump");
+
   // Create the listener
   struct event_base* base = event_base_new();
   if (base == NULL) {
@@ -731,8 +1224,7 @@ void P2PComm::StartMessagePump(uint32_t listen_port_host,
   }
 
   struct evconnlistener* listener = evconnlistener_new_bind(
-      base, AcceptConnectionCallback, nullptr,
-      LEV_OPT_REUSEABLE | LEV_OPT_CLOSE_ON_FREE, -1,
+      base, AcceptConnectionCallback, nullptr, listener_flags, -1,
       (struct sockaddr*)&serv_addr, sizeof(struct sockaddr_in));
 
   if (listener == NULL) {
@@ -749,12 +1241,39 @@ void P2PComm::StartMessagePump(uint32_t listen_port_host,
 
 void P2PComm::SendMessage(const vector<Peer>& peers, const bytes& message,
                           const unsigned char& startByteType) {
+  if (peers.empty()) {
+    return;
+  }
+
+  SendMessage(peers, make_shared<const bytes>(message), startByteType);
+}
+
+void P2PComm::SendMessage(const deque<Peer>& peers, const bytes& message,
+                          const unsigned char& startByteType) {
+  if (peers.empty()) {
+    return;
+  }
+
+  SendMessage(peers, make_shared<const bytes>(message), startByteType);
+}
+
+void P2PComm::SendMessage(const Peer& peer, const bytes& message,
+                          const unsigned char& startByteType) {
+  SendMessage(peer, make_shared<const bytes>(message), startByteType);
+}
+
+void P2PComm::SendMessage(const vector<Peer>& peers, const SharedBytes& message,
+                          const unsigned char& startByteType) {
   // LOG_MARKER();
 
   if (peers.empty()) {
     return;
   }
 
+  if (ENABLE_MESSAGE_STATS && CarriesMessageType(startByteType)) {
+    MessageStats::GetInstance().RecordSent(*message, peers.size());
+  }
+
   // Make job
   SendJob* job = new SendJobPeers<vector<Peer>>;
   dynamic_cast<SendJobPeers<vector<Peer>>*>(job)->m_peers = peers;
@@ -762,14 +1281,13 @@ void P2PComm::SendMessage(const vector<Peer>& peers, const bytes& message,
   job->m_startbyte = startByteType;
   job->m_message = message;
   job->m_hash.clear();
+  job->m_lane = GetSendLane(*message, startByteType);
 
   // Queue job
-  if (!m_sendQueue.bounded_push(job)) {
-    LOG_GENERAL(WARNING, "SendQueue is full");
-  }
+  QueueSendJob(job);
 }
 
-void P2PComm::SendMessage(const deque<Peer>& peers, const bytes& message,
+void P2PComm::SendMessage(const deque<Peer>& peers, const SharedBytes& message,
                           const unsigned char& startByteType) {
   // LOG_MARKER();
 
@@ -777,6 +1295,10 @@ void P2PComm::SendMessage(const deque<Peer>& peers, const bytes& message,
     return;
   }
 
+  if (ENABLE_MESSAGE_STATS && CarriesMessageType(startByteType)) {
+    MessageStats::GetInstance().RecordSent(*message, peers.size());
+  }
+
   // Make job
   SendJob* job = new SendJobPeers<deque<Peer>>;
   dynamic_cast<SendJobPeers<deque<Peer>>*>(job)->m_peers = peers;
@@ -784,17 +1306,20 @@ void P2PComm::SendMessage(const deque<Peer>& peers, const bytes& message,
   job->m_startbyte = startByteType;
   job->m_message = message;
   job->m_hash.clear();
+  job->m_lane = GetSendLane(*message, startByteType);
 
   // Queue job
-  if (!m_sendQueue.bounded_push(job)) {
-    LOG_GENERAL(WARNING, "SendQueue is full");
-  }
+  QueueSendJob(job);
 }
 
-void P2PComm::SendMessage(const Peer& peer, const bytes& message,
+void P2PComm::SendMessage(const Peer& peer, const SharedBytes& message,
                           const unsigned char& startByteType) {
   // LOG_MARKER();
 
+  if (ENABLE_MESSAGE_STATS && CarriesMessageType(startByteType)) {
+    MessageStats::GetInstance().RecordSent(*message, 1);
+  }
+
   // Make job
   SendJob* job = new SendJobPeer;
   dynamic_cast<SendJobPeer*>(job)->m_peer = peer;
@@ -802,23 +1327,44 @@ void P2PComm::SendMessage(const Peer& peer, const bytes& message,
   job->m_startbyte = startByteType;
   job->m_message = message;
   job->m_hash.clear();
+  job->m_lane = GetSendLane(*message, startByteType);
 
   // Queue job
-  if (!m_sendQueue.bounded_push(job)) {
-    LOG_GENERAL(WARNING, "SendQueue is full");
-  }
+  QueueSendJob(job);
 }
 
 void P2PComm::SendBroadcastMessage(const vector<Peer>& peers,
                                    const bytes& message) {
+  if (peers.empty()) {
+    return;
+  }
+
+  SendBroadcastMessage(peers, make_shared<const bytes>(message));
+}
+
+void P2PComm::SendBroadcastMessage(const deque<Peer>& peers,
+                                   const bytes& message) {
+  if (peers.empty()) {
+    return;
+  }
+
+  SendBroadcastMessage(peers, make_shared<const bytes>(message));
+}
+
+void P2PComm::SendBroadcastMessage(const vector<Peer>& peers,
+                                   const SharedBytes& message) {
   LOG_MARKER();
 
   if (peers.empty()) {
     return;
   }
 
+  if (ENABLE_MESSAGE_STATS) {
+    MessageStats::GetInstance().RecordSent(*message, peers.size());
+  }
+
   SHA2<HASH_TYPE::HASH_VARIANT_256> sha256;
-  sha256.Update(message);
+  sha256.Update(*message);
 
   // Make job
   SendJob* job = new SendJobPeers<vector<Peer>>;
@@ -827,28 +1373,30 @@ void P2PComm::SendBroadcastMessage(const vector<Peer>& peers,
   job->m_startbyte = START_BYTE_BROADCAST;
   job->m_message = message;
   job->m_hash = sha256.Finalize();
+  job->m_lane = GetSendLane(*message, START_BYTE_BROADCAST);
 
   bytes hashCopy(job->m_hash);
 
   // Queue job
-  if (!m_sendQueue.bounded_push(job)) {
-    LOG_GENERAL(WARNING, "SendQueue is full");
-  }
+  QueueSendJob(job);
 
-  lock_guard<mutex> guard(m_broadcastHashesMutex);
-  m_broadcastHashes.insert(hashCopy);
+  m_broadcastHashes.Insert(hashCopy);
 }
 
 void P2PComm::SendBroadcastMessage(const deque<Peer>& peers,
-                                   const bytes& message) {
+                                   const SharedBytes& message) {
   LOG_MARKER();
 
   if (peers.empty()) {
     return;
   }
 
+  if (ENABLE_MESSAGE_STATS) {
+    MessageStats::GetInstance().RecordSent(*message, peers.size());
+  }
+
   SHA2<HASH_TYPE::HASH_VARIANT_256> sha256;
-  sha256.Update(message);
+  sha256.Update(*message);
 
   // Make job
   SendJob* job = new SendJobPeers<deque<Peer>>;
@@ -857,16 +1405,49 @@ void P2PComm::SendBroadcastMessage(const deque<Peer>& peers,
   job->m_startbyte = START_BYTE_BROADCAST;
   job->m_message = message;
   job->m_hash = sha256.Finalize();
+  job->m_lane = GetSendLane(*message, START_BYTE_BROADCAST);
 
   bytes hashCopy(job->m_hash);
 
   // Queue job
-  if (!m_sendQueue.bounded_push(job)) {
-    LOG_GENERAL(WARNING, "SendQueue is full");
+  QueueSendJob(job);
+
+  m_broadcastHashes.Insert(hashCopy);
+}
+
+void P2PComm::SendChunkedBroadcastMessage(const vector<Peer>& peers,
+                                          const SharedBytes& message) {
+  if (!ENABLE_CHUNKED_BROADCAST ||
+      message->size() < CHUNKED_BROADCAST_THRESHOLD_IN_BYTES ||
+      peers.size() < 2 || peers.size() > ReedSolomon::MAX_TOTAL_SHARDS) {
+    SendBroadcastMessage(peers, message);
+    return;
   }
 
-  lock_guard<mutex> guard(m_broadcastHashesMutex);
-  m_broadcastHashes.insert(hashCopy);
+  LOG_MARKER();
+
+  vector<ChunkFrame> frames;
+  if (!ChunkAssembler::Split(*message, peers, CHUNKED_BROADCAST_PARITY_PERCENT,
+                             frames)) {
+    SendBroadcastMessage(peers, message);
+    return;
+  }
+
+  LOG_GENERAL(INFO, "Sending " << message->size() << " bytes as "
+                               << frames.front().m_dataChunks << "+"
+                               << frames.front().m_parityChunks
+                               << " chunks of " << frames.front().m_chunk.size()
+                               << " bytes");
+
+  // The chunks relayed back to us must not rebuild our own message
+  m_broadcastHashes.Insert(frames.front().m_hash);
+
+  for (unsigned int i = 0; i < frames.size(); i++) {
+    bytes frame;
+    frames[i].Serialize(frame);
+    SendMessage(peers[i], make_shared<const bytes>(move(frame)),
+                START_BYTE_CHUNK);
+  }
 }
 
 void P2PComm::SendMessageNoQueue(const Peer& peer, const bytes& message,
@@ -880,6 +1461,10 @@ void P2PComm::SendMessageNoQueue(const Peer& peer, const bytes& message,
     return;
   }
 
+  if (ENABLE_MESSAGE_STATS && CarriesMessageType(startByteType)) {
+    MessageStats::GetInstance().RecordSent(message, 1);
+  }
+
   SendJob::SendMessageCore(peer, message, startByteType, {});
 }
 
@@ -911,7 +1496,19 @@ void P2PComm::SendRumorToForeignPeers(const std::deque<Peer>& foreignPeers,
   m_rumorManager.SendRumorToForeignPeers(foreignPeers, message);
 }
 
-void P2PComm::SetSelfPeer(const Peer& self) { m_selfPeer = self; }
+void P2PComm::SendRumorToForeignPeers(
+    const std::deque<std::vector<Peer>>& foreignPeerGroups,
+    const bytes& message) {
+  LOG_MARKER();
+  m_rumorManager.SendRumorToForeignPeers(foreignPeerGroups, message);
+}
+
+void P2PComm::SetSelfPeer(const Peer& self) {
+  m_selfPeer = self;
+  if (ENABLE_NETWORK_EMULATION) {
+    NetworkEmulator::GetInstance().SetSelf(self);
+  }
+}
 
 void P2PComm::SetSelfKey(const PairOfKey& self) { m_selfKey = self; }
 
@@ -19,29 +19,42 @@
 #define __P2PCOMM_H__
 
 #include <event2/util.h>
+#include <atomic>
 #include <boost/lockfree/queue.hpp>
+#include <chrono>
 #include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <set>
 #include <vector>
 
+#include "BroadcastDedupFilter.h"
+#include "ChunkAssembler.h"
 #include "Peer.h"
+#include "PeerSendQueue.h"
 #include "RumorManager.h"
 #include "common/BaseType.h"
 #include "common/Constants.h"
 #include "libUtils/Logger.h"
 #include "libUtils/ThreadPool.h"
 
+struct evbuffer;
+struct iovec;
+struct sockaddr_in;
 struct evconnlistener;
 
 extern const unsigned char START_BYTE_NORMAL;
+extern const unsigned char START_BYTE_BROADCAST;
 extern const unsigned char START_BYTE_GOSSIP;
+extern const unsigned char START_BYTE_CHUNK;
 
 class SendJob {
  protected:
-  static uint32_t writeMsg(const void* buf, int cli_sock, const Peer& from,
-                           const uint32_t message_length);
+  static uint32_t writeMsg(struct iovec* iov, int iovcnt, int cli_sock,
+                           const Peer& from, const uint32_t message_length);
+  static bool writeFrame(int cli_sock, const Peer& peer, const bytes& message,
+                         unsigned char start_byte, const bytes& msg_hash);
   static bool SendMessageSocketCore(const Peer& peer, const bytes& message,
                                     unsigned char start_byte,
                                     const bytes& msg_hash);
@@ -49,11 +62,28 @@ class SendJob {
  public:
   Peer m_selfPeer;
   unsigned char m_startbyte;
-  bytes m_message;
+  SharedBytes m_message;
   bytes m_hash;
+  bool m_compressed{false};
+  SendLane m_lane{SEND_LANE_BLOCK};
 
-  static void SendMessageCore(const Peer& peer, const bytes message,
-                              unsigned char startbyte, const bytes hash);
+  /// Replaces m_message with its compressed form when wire compression is
+  /// enabled and the message is large enough to benefit from it.
+  void CompressMessage();
+
+  /// Returns the start byte to put on the wire for this job's message.
+  unsigned char GetWireStartByte() const;
+
+  /// Writes the message to the peer, retrying failed connections. With
+  /// ENABLE_NETWORK_EMULATION it is first shaped as if queued at queuedAt.
+  static void SendMessageCore(
+      const Peer& peer, const bytes& message, unsigned char startbyte,
+      const bytes& hash,
+      const std::chrono::steady_clock::time_point& queuedAt =
+          std::chrono::steady_clock::now());
+
+  /// Queues the message for the peer, starting a sender if it has none.
+  void QueueForPeer(const Peer& peer);
 
   virtual ~SendJob() {}
   virtual void DoSend() = 0;
@@ -74,18 +104,12 @@ class SendJobPeers : public SendJob {
 
 /// Provides network layer functionality.
 class P2PComm {
-  std::set<bytes> m_broadcastHashes;
-  std::mutex m_broadcastHashesMutex;
-  std::deque<
-      std::pair<bytes, std::chrono::time_point<std::chrono::system_clock>>>
-      m_broadcastToRemove;
-  std::mutex m_broadcastToRemoveMutex;
+  BroadcastDedupFilter m_broadcastHashes;
+  ChunkAssembler m_chunkAssembler;
   RumorManager m_rumorManager;
 
   const static uint32_t MAXPUMPMESSAGE = 128;
 
-  void ClearBroadcastHashAsync(const bytes& message_hash);
-
   P2PComm();
   ~P2PComm();
 
@@ -101,14 +125,30 @@ class P2PComm {
 
   ThreadPool m_SendPool{MAXMESSAGE, "SendPool"};
 
-  boost::lockfree::queue<SendJob*> m_sendQueue;
+  // One queue of send jobs per SendLane, drained most urgent first
+  std::vector<std::unique_ptr<boost::lockfree::queue<SendJob*>>> m_sendQueues;
+  std::atomic<uint64_t> m_sendQueueDepth[NUM_SEND_LANES];
+  void QueueSendJob(SendJob* job);
+  bool PopSendJob(SendJob*& job);
+  void LogSendQueueStats();
   void ProcessSendJob(SendJob* job);
 
-  static void ProcessBroadCastMsg(bytes& message, const Peer& from);
+  static void ProcessBroadCastMsg(const bytes& msgHash,
+                                  std::pair<bytes, Peer>* message);
   static void ProcessGossipMsg(bytes& message, Peer& from);
+  static void ProcessChunkMsg(bytes& message, const Peer& from);
+  static bool DecompressFrame(bytes& message);
+  static void ProcessMessage(bytes& message, Peer from);
+  static bool ProcessReceivedFrames(struct evbuffer* input, const Peer& from);
+  static bool ProcessReceivedPayload(struct evbuffer* input,
+                                     unsigned char startByte,
+                                     uint32_t messageLength, const Peer& from);
+  static Peer GetPeerFromBufferEvent(struct bufferevent* bev);
 
   static void EventCallback(struct bufferevent* bev, short events, void* ctx);
   static void ReadCallback(struct bufferevent* bev, void* ctx);
+  static void RunMessagePumpReactor(const struct sockaddr_in& serv_addr,
+                                    unsigned int listener_flags);
   static void AcceptConnectionCallback(evconnlistener* listener,
                                        evutil_socket_t cli_sock,
                                        struct sockaddr* cli_addr, int socklen,
@@ -120,9 +160,22 @@ class P2PComm {
 
   using Dispatcher = std::function<void(std::pair<bytes, Peer>*)>;
 
+  /// Returns a message for the dispatcher, reusing a released one if any
+  static std::pair<bytes, Peer>* AcquireMessage();
+
+  /// Takes back a message handed to the dispatcher once it is processed, so
+  /// that it and the capacity of its buffer are reused by AcquireMessage
+  static void ReleaseMessage(std::pair<bytes, Peer>* message);
+
   using BroadcastListFunc = std::function<std::vector<Peer>(
       unsigned char msg_type, unsigned char ins_type, const Peer&)>;
 
+  /// Returns the send lane for a message based on its type and instruction.
+  static SendLane GetSendLane(const bytes& message, unsigned char startByte);
+
+  /// Sends everything queued for the peer on a thread from the send pool.
+  void DrainPeerSendQueueAsync(const Peer& peer);
+
   void InitializeRumorManager(const VectorOfNode& peers,
                               const std::vector<PubKey>& fullNetworkKeys);
   inline static bool IsHostHavingNetworkIssue();
@@ -139,7 +192,8 @@ class P2PComm {
                                struct sockaddr* cli_addr, int socklen,
                                void* arg);
 
-  /// Listens for incoming socket connections.
+  /// Listens for incoming socket connections on MESSAGE_PUMP_REACTORS event
+  /// loops. Blocks the calling thread, which runs one of the loops.
   void StartMessagePump(uint32_t listen_port_host, Dispatcher dispatcher);
 
   /// Multicasts message to specified list of peers.
@@ -162,6 +216,33 @@ class P2PComm {
   void SendBroadcastMessage(const std::deque<Peer>& peers,
                             const bytes& message);
 
+  /// Multicasts a shared message to specified list of peers without copying it.
+  void SendMessage(const std::vector<Peer>& peers, const SharedBytes& message,
+                   const unsigned char& startByteType = START_BYTE_NORMAL);
+
+  /// Multicasts a shared message to specified list of peers without copying it.
+  void SendMessage(const std::deque<Peer>& peers, const SharedBytes& message,
+                   const unsigned char& startByteType = START_BYTE_NORMAL);
+
+  /// Sends a shared normal message to specified peer without copying it.
+  void SendMessage(const Peer& peer, const SharedBytes& message,
+                   const unsigned char& startByteType = START_BYTE_NORMAL);
+
+  /// Multicasts a shared message of type=broadcast without copying it.
+  void SendBroadcastMessage(const std::vector<Peer>& peers,
+                            const SharedBytes& message);
+
+  /// Multicasts a shared message of type=broadcast without copying it.
+  void SendBroadcastMessage(const std::deque<Peer>& peers,
+                            const SharedBytes& message);
+
+  /// Broadcasts a large message as erasure-coded chunks, one distinct chunk
+  /// per peer, which the peers relay among themselves and decode once
+  /// enough have arrived. Falls back to SendBroadcastMessage when disabled by
+  /// ENABLE_CHUNKED_BROADCAST or below CHUNKED_BROADCAST_THRESHOLD_IN_BYTES.
+  void SendChunkedBroadcastMessage(const std::vector<Peer>& peers,
+                                   const SharedBytes& message);
+
   void RebroadcastMessage(const std::vector<Peer>& peers, const bytes& message,
                           const bytes& msg_hash);
 
@@ -185,6 +266,11 @@ class P2PComm {
   void SendRumorToForeignPeers(const std::deque<Peer>& foreignPeers,
                                const bytes& message);
 
+  /// Gossips one forward message to several groups of foreign peers.
+  void SendRumorToForeignPeers(
+      const std::deque<std::vector<Peer>>& foreignPeerGroups,
+      const bytes& message);
+
   Signature SignMessage(const bytes& message);
 
   bool VerifyMessage(const bytes& message, const Signature& toverify,
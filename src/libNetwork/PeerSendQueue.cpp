@@ -0,0 +1,159 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "PeerSendQueue.h"
+#include "common/Constants.h"
+#include "libUtils/Logger.h"
+#include "libUtils/MemoryStats.h"
+
+using namespace std;
+
+PeerSendQueue::PeerSendQueue() {
+  for (unsigned int lane = 0; lane < NUM_SEND_LANES; lane++) {
+    m_laneDepth[lane] = 0;
+    m_laneDropped[lane] = 0;
+  }
+
+  // A message sent to several peers is counted once per peer
+  MemoryStats::GetInstance().Register("sendqueue", [this]() {
+    lock_guard<mutex> g(m_mutexQueues);
+    MemoryStats::Usage usage;
+    for (const auto& queue : m_queues) {
+      for (const auto& lane : queue.second.m_lanes) {
+        for (const auto& item : lane) {
+          usage.m_entries++;
+          usage.m_bytes += item.m_message->size() + item.m_hash.size();
+        }
+      }
+    }
+    return usage;
+  });
+}
+
+PeerSendQueue::~PeerSendQueue() {}
+
+PeerSendQueue& PeerSendQueue::GetInstance() {
+  static PeerSendQueue queue;
+  return queue;
+}
+
+const char* PeerSendQueue::GetLaneName(SendLane lane) {
+  switch (lane) {
+    case SEND_LANE_CONSENSUS:
+      return "CONSENSUS";
+    case SEND_LANE_BLOCK:
+      return "BLOCK";
+    case SEND_LANE_TXN:
+      return "TXN";
+    case SEND_LANE_GOSSIP:
+      return "GOSSIP";
+    default:
+      return "UNKNOWN";
+  }
+}
+
+bool PeerSendQueue::Push(const Peer& peer, SendLane lane,
+                         PeerSendItem&& item) {
+  if (lane >= NUM_SEND_LANES) {
+    LOG_GENERAL(WARNING, "Invalid send lane " << (unsigned int)lane);
+    return false;
+  }
+
+  lock_guard<mutex> g(m_mutexQueues);
+
+  PeerQueue& queue = m_queues[peer];
+
+  if (queue.m_depth >= PEER_SEND_QUEUE_MAX_DEPTH) {
+    // Make room by evicting the newest message of the least urgent lane,
+    // but never in favour of a message that is itself less urgent
+    int victim = NUM_SEND_LANES - 1;
+    while (victim > lane && queue.m_lanes[victim].empty()) {
+      victim--;
+    }
+
+    if (victim <= lane) {
+      m_laneDropped[lane]++;
+      LOG_GENERAL(WARNING, "Send queue to " << peer << " is full, dropping "
+                                            << GetLaneName(lane)
+                                            << " message");
+      return false;
+    }
+
+    queue.m_lanes[victim].pop_back();
+    queue.m_depth--;
+    m_laneDepth[victim]--;
+    m_laneDropped[victim]++;
+    LOG_GENERAL(WARNING, "Send queue to "
+                             << peer << " is full, dropped "
+                             << GetLaneName((SendLane)victim) << " message");
+  }
+
+  queue.m_lanes[lane].emplace_back(move(item));
+  queue.m_depth++;
+  m_laneDepth[lane]++;
+
+  if (queue.m_draining) {
+    return false;
+  }
+
+  queue.m_draining = true;
+  return true;
+}
+
+bool PeerSendQueue::Pop(const Peer& peer, PeerSendItem& item) {
+  lock_guard<mutex> g(m_mutexQueues);
+
+  auto it = m_queues.find(peer);
+  if (it == m_queues.end()) {
+    return false;
+  }
+
+  PeerQueue& queue = it->second;
+
+  for (unsigned int lane = 0; lane < NUM_SEND_LANES; lane++) {
+    if (!queue.m_lanes[lane].empty()) {
+      item = move(queue.m_lanes[lane].front());
+      queue.m_lanes[lane].pop_front();
+      queue.m_depth--;
+      m_laneDepth[lane]--;
+      return true;
+    }
+  }
+
+  // Nothing left for this peer, so the next Push starts a new drain
+  m_queues.erase(it);
+  return false;
+}
+
+uint64_t PeerSendQueue::GetLaneDepth(SendLane lane) const {
+  return (lane < NUM_SEND_LANES) ? m_laneDepth[lane].load() : 0;
+}
+
+uint64_t PeerSendQueue::GetLaneDropped(SendLane lane) const {
+  return (lane < NUM_SEND_LANES) ? m_laneDropped[lane].load() : 0;
+}
+
+void PeerSendQueue::Clear() {
+  lock_guard<mutex> g(m_mutexQueues);
+
+  m_queues.clear();
+
+  for (unsigned int lane = 0; lane < NUM_SEND_LANES; lane++) {
+    m_laneDepth[lane] = 0;
+    m_laneDropped[lane] = 0;
+  }
+}
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PEERSENDQUEUE_H__
+#define __PEERSENDQUEUE_H__
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <map>
+#include <mutex>
+
+#include "Peer.h"
+#include "common/BaseType.h"
+
+/// Send priority classes, from most to least urgent.
+enum SendLane : unsigned char {
+  SEND_LANE_CONSENSUS = 0x00,
+  SEND_LANE_BLOCK = 0x01,
+  SEND_LANE_TXN = 0x02,
+  SEND_LANE_GOSSIP = 0x03,
+  NUM_SEND_LANES = 0x04
+};
+
+/// One message waiting to be written to a single peer.
+struct PeerSendItem {
+  SharedBytes m_message;
+  unsigned char m_startbyte;
+  bytes m_hash;
+  std::chrono::steady_clock::time_point m_queuedAt =
+      std::chrono::steady_clock::now();
+};
+
+/// Holds outgoing messages per destination so that each peer is served by
+/// at most one sender at a time, always taking its most urgent lane first.
+/// A peer's queue is bounded by PEER_SEND_QUEUE_MAX_DEPTH; when it is full
+/// the newest message of a less urgent lane is dropped to make room, or the
+/// incoming message is dropped if nothing queued is less urgent.
+class PeerSendQueue {
+  struct PeerQueue {
+    std::deque<PeerSendItem> m_lanes[NUM_SEND_LANES];
+    unsigned int m_depth = 0;
+    bool m_draining = false;
+  };
+
+  std::mutex m_mutexQueues;
+  std::map<Peer, PeerQueue> m_queues;
+
+  std::atomic<uint64_t> m_laneDepth[NUM_SEND_LANES];
+  std::atomic<uint64_t> m_laneDropped[NUM_SEND_LANES];
+
+  PeerSendQueue();
+  ~PeerSendQueue();
+
+  // Singleton should not implement these
+  PeerSendQueue(PeerSendQueue const&) = delete;
+  void operator=(PeerSendQueue const&) = delete;
+
+ public:
+  /// Returns the singleton PeerSendQueue instance.
+  static PeerSendQueue& GetInstance();
+
+  /// Returns a printable name for the lane
+  static const char* GetLaneName(SendLane lane);
+
+  /// Queues a message for the peer. Returns true if the caller has to start
+  /// draining the peer's queue, i.e. no one is serving this peer yet.
+  bool Push(const Peer& peer, SendLane lane, PeerSendItem&& item);
+
+  /// Takes the most urgent message queued for the peer. Returns false once
+  /// the queue is empty, after which the peer is no longer being served.
+  bool Pop(const Peer& peer, PeerSendItem& item);
+
+  /// Returns the number of messages queued in the lane across all peers
+  uint64_t GetLaneDepth(SendLane lane) const;
+
+  /// Returns the number of messages of the lane dropped due to backpressure
+  uint64_t GetLaneDropped(SendLane lane) const;
+
+  /// Drops everything queued and resets the counters
+  void Clear();
+};
+
+#endif  // __PEERSENDQUEUE_H__
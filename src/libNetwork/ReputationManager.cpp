@@ -22,7 +22,8 @@
 #include "libUtils/Logger.h"
 #include "libUtils/SafeMath.h"
 
-ReputationManager::ReputationManager() {}
+ReputationManager::ReputationManager()
+    : m_awardRounds(0), m_bannedIPsSnapshot(std::make_shared<const IPSet>()) {}
 
 ReputationManager::~ReputationManager() {}
 
@@ -33,13 +34,15 @@ ReputationManager& ReputationManager::GetInstance() {
 
 bool ReputationManager::IsNodeBanned(
     const boost::multiprecision::uint128_t& IPAddress) {
-  return (GetReputation(IPAddress) <= REPTHRESHOLD);
+  const std::shared_ptr<const IPSet> bannedIPs =
+      std::atomic_load(&m_bannedIPsSnapshot);
+  return bannedIPs->find(IPAddress) != bannedIPs->end();
 }
 
 void ReputationManager::PunishNode(
     const boost::multiprecision::uint128_t& IPAddress, int32_t Penalty) {
-  UpdateReputation(IPAddress, Penalty);
-  if (!Blacklist::GetInstance().Exist(IPAddress) and IsNodeBanned(IPAddress)) {
+  if (UpdateReputation(IPAddress, Penalty) &&
+      !Blacklist::GetInstance().Exist(IPAddress)) {
     LOG_GENERAL(INFO, "Node " << IPConverter::ToStrFromNumericalIP(IPAddress)
                               << " banned.");
     Blacklist::GetInstance().Add(IPAddress);
@@ -47,9 +50,34 @@ void ReputationManager::PunishNode(
 }
 
 void ReputationManager::AwardAllNodes() {
-  std::vector<boost::multiprecision::uint128_t> AllKnownIPs = GetAllKnownIP();
-  for (const auto& ip : AllKnownIPs) {
-    AwardNode(ip);
+  std::vector<boost::multiprecision::uint128_t> unbannedIPs;
+  {
+    std::lock_guard<std::mutex> lock(m_mutexReputations);
+    m_awardRounds++;
+
+    // Only the banned nodes can change status
+    for (auto it = m_bannedIPs.begin(); it != m_bannedIPs.end();) {
+      auto reputation = m_Reputations.find(*it);
+      if (reputation == m_Reputations.end() ||
+          GetScore(reputation->second) > REPTHRESHOLD) {
+        unbannedIPs.emplace_back(*it);
+        it = m_bannedIPs.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    if (!unbannedIPs.empty()) {
+      PublishBannedIPs();
+    }
+  }
+
+  for (const auto& ip : unbannedIPs) {
+    if (Blacklist::GetInstance().Exist(ip)) {
+      LOG_GENERAL(INFO, "Node " << IPConverter::ToStrFromNumericalIP(ip)
+                                << " unbanned.");
+      Blacklist::GetInstance().Remove(ip);
+    }
   }
 }
 
@@ -59,31 +87,48 @@ void ReputationManager::AddNodeIfNotKnown(
   AddNodeIfNotKnownInternal(IPAddress);
 }
 
-void ReputationManager::AddNodeIfNotKnownInternal(
+ReputationManager::Reputation& ReputationManager::AddNodeIfNotKnownInternal(
     const boost::multiprecision::uint128_t& IPAddress) {
-  if (m_Reputations.find(IPAddress) == m_Reputations.end()) {
-    m_Reputations.emplace(IPAddress, ScoreType::GOOD);
+  return m_Reputations
+      .emplace(IPAddress, Reputation{ScoreType::GOOD, m_awardRounds})
+      .first->second;
+}
+
+int32_t ReputationManager::GetScore(const Reputation& reputation) const {
+  const uint64_t rounds = m_awardRounds - reputation.m_awardRound;
+  const int64_t room =
+      static_cast<int64_t>(ScoreType::UPPERREPTHRESHOLD) - reputation.m_score;
+
+  // Each award is capped at the upper bound, and so is their sum
+  if (rounds == 0) {
+    return reputation.m_score;
   }
+  if (room < 0 ||
+      rounds > static_cast<uint64_t>(room / ScoreType::AWARD_FOR_GOOD_NODES)) {
+    return ScoreType::UPPERREPTHRESHOLD;
+  }
+  return reputation.m_score +
+         static_cast<int32_t>(rounds * ScoreType::AWARD_FOR_GOOD_NODES);
 }
 
 int32_t ReputationManager::GetReputation(
     const boost::multiprecision::uint128_t& IPAddress) {
   std::lock_guard<std::mutex> lock(m_mutexReputations);
-  AddNodeIfNotKnownInternal(IPAddress);
-  return m_Reputations[IPAddress];
+  return GetScore(AddNodeIfNotKnownInternal(IPAddress));
 }
 
 void ReputationManager::Clear() {
   LOG_MARKER();
   std::lock_guard<std::mutex> lock(m_mutexReputations);
   m_Reputations.clear();
+  m_bannedIPs.clear();
+  PublishBannedIPs();
 }
 
 void ReputationManager::SetReputation(
-    const boost::multiprecision::uint128_t& IPAddress,
+    const boost::multiprecision::uint128_t& IPAddress, Reputation& reputation,
     const int32_t ReputationScore) {
-  std::lock_guard<std::mutex> lock(m_mutexReputations);
-  AddNodeIfNotKnownInternal(IPAddress);
+  reputation.m_awardRound = m_awardRounds;
 
   if (ReputationScore > ScoreType::UPPERREPTHRESHOLD) {
     LOG_GENERAL(
@@ -91,17 +136,26 @@ void ReputationManager::SetReputation(
         "Reputation score too high. Exceed upper bound. ReputationScore: "
             << ReputationScore << ". Setting reputation to "
             << ScoreType::UPPERREPTHRESHOLD);
-    m_Reputations[IPAddress] = ScoreType::UPPERREPTHRESHOLD;
-    return;
+    reputation.m_score = ScoreType::UPPERREPTHRESHOLD;
+  } else {
+    reputation.m_score = ReputationScore;
   }
 
-  m_Reputations[IPAddress] = ReputationScore;
+  const bool changed = reputation.m_score <= REPTHRESHOLD
+                           ? m_bannedIPs.insert(IPAddress).second
+                           : m_bannedIPs.erase(IPAddress) > 0;
+  if (changed) {
+    PublishBannedIPs();
+  }
 }
 
-void ReputationManager::UpdateReputation(
+bool ReputationManager::UpdateReputation(
     const boost::multiprecision::uint128_t& IPAddress,
     const int32_t ReputationScoreDelta) {
-  int32_t NewRep = GetReputation(IPAddress);
+  std::lock_guard<std::mutex> lock(m_mutexReputations);
+  Reputation& reputation = AddNodeIfNotKnownInternal(IPAddress);
+  const int32_t OldRep = GetScore(reputation);
+  int32_t NewRep = OldRep;
 
   // Update result with score delta
   if (!(SafeMath<int32_t>::add(NewRep, ReputationScoreDelta, NewRep))) {
@@ -109,34 +163,20 @@ void ReputationManager::UpdateReputation(
   }
 
   // Further deduct score if node is going to be ban
-  if (NewRep <= REPTHRESHOLD && !IsNodeBanned(IPAddress)) {
+  if (NewRep <= REPTHRESHOLD && OldRep > REPTHRESHOLD) {
     if (!(SafeMath<int32_t>::sub(
             NewRep, ScoreType::BAN_MULTIPLIER * ScoreType::AWARD_FOR_GOOD_NODES,
             NewRep))) {
       LOG_GENERAL(WARNING, "Underflow detected.");
     }
   }
-  SetReputation(IPAddress, NewRep);
-}
-
-std::vector<boost::multiprecision::uint128_t>
-ReputationManager::GetAllKnownIP() {
-  std::lock_guard<std::mutex> lock(m_mutexReputations);
+  SetReputation(IPAddress, reputation, NewRep);
 
-  std::vector<boost::multiprecision::uint128_t> AllKnownIPs;
-  for (const auto& node : m_Reputations) {
-    AllKnownIPs.emplace_back(node.first);
-  }
-  return AllKnownIPs;
+  return reputation.m_score <= REPTHRESHOLD;
 }
 
-void ReputationManager::AwardNode(
-    const boost::multiprecision::uint128_t& IPAddress) {
-  UpdateReputation(IPAddress, ScoreType::AWARD_FOR_GOOD_NODES);
-
-  if (Blacklist::GetInstance().Exist(IPAddress) && !IsNodeBanned(IPAddress)) {
-    LOG_GENERAL(INFO, "Node " << IPConverter::ToStrFromNumericalIP(IPAddress)
-                              << " unbanned.");
-    Blacklist::GetInstance().Remove(IPAddress);
-  }
+void ReputationManager::PublishBannedIPs() {
+  std::atomic_store(&m_bannedIPsSnapshot,
+                    std::shared_ptr<const IPSet>(
+                        std::make_shared<const IPSet>(m_bannedIPs)));
 }
@@ -25,22 +25,40 @@
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 #include <boost/multiprecision/cpp_int.hpp>
 #pragma GCC diagnostic pop
+#include <boost/functional/hash.hpp>
 #include <functional>
+#include <limits>
+#include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
+/// Scores are kept together with the award round they were last updated in,
+/// and the awards of the rounds since are added when they are read, so that
+/// AwardAllNodes does not touch the scores. The banned nodes are published as
+/// an immutable set, for IsNodeBanned to read without taking the lock.
 class ReputationManager {
-  // Custom hasher
-  // Ref:
-  // https://stackoverflow.com/questions/32082786/why-i-cannot-use-neither-stdunordered-map-nor-boostunordered-map-with-boost
-  template <typename T>
-  struct hash_str {
-    size_t operator()(const T& t) const {
-      return std::hash<std::string>()(t.str());
+  // Hashes both 64 bit halves of the address
+  struct hash_uint128 {
+    size_t operator()(const boost::multiprecision::uint128_t& t) const {
+      const uint64_t low = std::numeric_limits<uint64_t>::max();
+      size_t seed = 0;
+      boost::hash_combine(seed, static_cast<uint64_t>(t & low));
+      boost::hash_combine(seed, static_cast<uint64_t>(t >> 64));
+      return seed;
     }
   };
 
+  typedef std::unordered_set<boost::multiprecision::uint128_t, hash_uint128>
+      IPSet;
+
+  struct Reputation {
+    int32_t m_score;
+    /// The award round m_score is as of
+    uint64_t m_awardRound;
+  };
+
   ReputationManager();
   ~ReputationManager();
 
@@ -52,9 +70,11 @@ class ReputationManager {
   /// Returns the singleton P2PComm instance.
   static ReputationManager& GetInstance();
   void AddNodeIfNotKnown(const boost::multiprecision::uint128_t& IPAddress);
+  /// Does not take the lock
   bool IsNodeBanned(const boost::multiprecision::uint128_t& IPAddress);
   void PunishNode(const boost::multiprecision::uint128_t& IPAddress,
                   const int32_t Penalty);
+  /// Awards every known node, in time proportional to the banned nodes only
   void AwardAllNodes();
   int32_t GetReputation(const boost::multiprecision::uint128_t& IPAddress);
   void Clear();
@@ -76,18 +96,27 @@ class ReputationManager {
   std::mutex m_mutexReputations;
 
  private:
-  std::unordered_map<boost::multiprecision::uint128_t, int32_t,
-                     hash_str<boost::multiprecision::uint128_t>>
+  std::unordered_map<boost::multiprecision::uint128_t, Reputation,
+                     hash_uint128>
       m_Reputations;
+  /// Number of AwardAllNodes calls so far
+  uint64_t m_awardRounds;
+  /// The nodes whose score is at or below REPTHRESHOLD
+  IPSet m_bannedIPs;
+  /// Copy of m_bannedIPs, read and written with std::atomic_load and
+  /// std::atomic_store
+  std::shared_ptr<const IPSet> m_bannedIPsSnapshot;
 
-  void AddNodeIfNotKnownInternal(
+  Reputation& AddNodeIfNotKnownInternal(
       const boost::multiprecision::uint128_t& IPAddress);
+  /// Returns the score with the awards since its last update
+  int32_t GetScore(const Reputation& reputation) const;
   void SetReputation(const boost::multiprecision::uint128_t& IPAddress,
-                     const int32_t ReputationScore);
-  void UpdateReputation(const boost::multiprecision::uint128_t& IPAddress,
+                     Reputation& reputation, const int32_t ReputationScore);
+  /// Returns whether the node is banned after the update
+  bool UpdateReputation(const boost::multiprecision::uint128_t& IPAddress,
                         const int32_t ReputationScoreDelta);
-  std::vector<boost::multiprecision::uint128_t> GetAllKnownIP();
-  void AwardNode(const boost::multiprecision::uint128_t& IPAddress);
+  void PublishBannedIPs();
 };
 
 #endif  // __REPUTATION_MANAGER_H__
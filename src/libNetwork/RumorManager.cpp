@@ -26,6 +26,7 @@
 #include "libCrypto/Sha2.h"
 #include "libUtils/DataConversion.h"
 #include "libUtils/HashUtils.h"
+#include "libUtils/MemoryStats.h"
 
 namespace {
 RRS::Message::Type convertType(uint8_t type) {
@@ -36,22 +37,70 @@ RRS::Message::Type convertType(uint8_t type) {
   }
 }
 
+bool IsSignedType(const RRS::Message::Type t) {
+  switch (t) {
+    case RRS::Message::Type::EMPTY_PUSH:
+    case RRS::Message::Type::EMPTY_PULL:
+      return SIGN_VERIFY_EMPTY_MSGTYP;
+    case RRS::Message::Type::LAZY_PUSH:
+    case RRS::Message::Type::LAZY_PULL:
+    case RRS::Message::Type::PUSH:
+    case RRS::Message::Type::PULL:
+      return SIGN_VERIFY_NONEMPTY_MSGTYP;
+    case RRS::Message::Type::BATCH:
+      // One signature covers every entry, whatever their types
+      return SIGN_VERIFY_EMPTY_MSGTYP || SIGN_VERIFY_NONEMPTY_MSGTYP;
+    default:
+      return false;
+  }
+}
+
+// Each batch entry is [type][rounds][body length][body]
+const unsigned int BATCH_ENTRY_HDR_LEN =
+    1 + sizeof(uint32_t) + sizeof(uint32_t);
+
+// Room kept for the P2PComm frame header when sizing a batch
+const unsigned int BATCH_WIRE_HDR_RESERVED_LEN = 16;
+
+// A digest is [hash][raw message size]
+const unsigned int DIGEST_LEN = COMMON_HASH_SIZE + sizeof(uint32_t);
+
 }  // anonymous namespace
 
 // CONSTRUCTORS
 RumorManager::RumorManager()
     : m_peerIdPeerBimap(),
       m_peerIdSet(),
-      m_rumorIdHashBimap(),
-      m_rumorHashRawMsgBimap(),
+      m_rumorBytes(0),
+      m_rumorsEvicted(0),
+      m_digestPullsLeft(0),
+      m_digestPullsSent(0),
+      m_digestPullsRetried(0),
       m_selfPeer(),
       m_selfKey(),
-      m_rumorRawMsgTimestamp(),
       m_rumorIdGenerator(0),
       m_mutex(),
       m_continueRoundMutex(),
       m_continueRound(false),
-      m_condStopRound() {}
+      m_condStopRound(),
+      m_batchesSent(0),
+      m_batchedMsgsSent(0),
+      m_maxBatchSize(0),
+      m_batchesReceived(0),
+      m_batchedMsgsReceived(0) {
+  // The rumors kept for KEEP_RAWMSG_FROM_LAST_N_ROUNDS rounds
+  MemoryStats::GetInstance().Register("rumormanager.rawmsgs", [this]() {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    MemoryStats::Usage usage;
+    usage.m_entries = m_rumors.size();
+    usage.m_bytes = m_rumorBytes;
+    for (const auto& message : m_bufferRawMsg) {
+      usage.m_entries++;
+      usage.m_bytes += message.size();
+    }
+    return usage;
+  });
+}
 
 RumorManager::~RumorManager() {}
 
@@ -67,7 +116,6 @@ void RumorManager::StartRounds() {
   }
 
   std::thread([&]() {
-    unsigned int rounds = 0;
     while (true) {
       std::unique_lock<std::mutex> guard(m_continueRoundMutex);
       m_continueRound = true;
@@ -81,16 +129,16 @@ void RumorManager::StartRounds() {
                                       << result.first.size() << " peers");
 
         // Get the corresponding Peer to which to send Push Messages if any.
+        std::vector<Peer> toPeers;
         for (const auto& i : result.first) {
           auto l = m_peerIdPeerBimap.left.find(i);
           if (l != m_peerIdPeerBimap.left.end()) {
-            SendMessages(l->second, result.second);
+            toPeers.emplace_back(l->second);
           }
         }
-        if (++rounds % KEEP_RAWMSG_FROM_LAST_N_ROUNDS == 0) {
-          CleanUp();
-          rounds = 0;
-        }
+        SendMessages(toPeers, result.second);
+        IssueDigestPulls();
+        CleanUp();
       }  // end critical section
       if (m_condStopRound.wait_for(guard,
                                    std::chrono::milliseconds(ROUND_TIME_IN_MS),
@@ -136,15 +184,18 @@ bool RumorManager::Initialize(const VectorOfNode& peers, const Peer& myself,
 
   m_rumorIdGenerator = 0;
   m_peerIdPeerBimap.clear();
-  m_rumorIdHashBimap.clear();
   m_peerIdSet.clear();
   m_selfPeer = myself;
   m_selfKey = myKeys;
-  m_rumorHashRawMsgBimap.clear();
-  m_rumorRawMsgTimestamp.clear();
+  m_rumors.clear();
+  m_rumorHashes.clear();
+  m_generations.clear();
+  m_generations.push_back({0, std::chrono::steady_clock::now(), {}});
+  m_rumorBytes = 0;
+  m_digestPulls.clear();
+  m_digestPullsLeft = GOSSIP_DIGEST_MAX_PULLS_PER_ROUND;
   m_fullNetworkKeys.clear();
   m_pubKeyPeerBiMap.clear();
-  m_hashesSubscriberMap.clear();
 
   int peerIdGenerator = 0;
   for (const auto& p : peers) {
@@ -157,6 +208,7 @@ bool RumorManager::Initialize(const VectorOfNode& peers, const Peer& myself,
     }
   }
   m_fullNetworkKeys = fullNetworkKeys;
+  m_pullsPerPeer.assign(peerIdGenerator + 1, 0);
 
   // Now create the one and only RumorHolder
   if (GOSSIP_CUSTOM_ROUNDS_SETTINGS) {
@@ -251,30 +303,23 @@ bool RumorManager::AddRumor(const RumorManager::RawBytes& message) {
       return true;
     }
 
-    auto it = m_rumorIdHashBimap.right.find(hash);
-    if (it == m_rumorIdHashBimap.right.end()) {
-      m_rumorIdHashBimap.insert(
-          RumorIdRumorBimap::value_type(++m_rumorIdGenerator, hash));
-
-      auto result = m_rumorHashRawMsgBimap.insert(
-          RumorHashRumorBiMap::value_type(hash, message));
-
-      if (result.second) {
-        // add the timestamp for this raw rumor message
-        m_rumorRawMsgTimestamp.push_back(std::make_pair(
-            result.first, std::chrono::high_resolution_clock::now()));
+    const Rumor* known = FindRumor(hash);
+    if (known == nullptr || known->m_id == 0) {
+      MakeRoom(hash.size() + message.size());
+      const int64_t rumorId = AddRumorHash(hash, true).m_id;
 
+      if (AddRawMessage(hash, message)) {
         std::string output;
         if (!DataConversion::Uint8VecToHexStr(hash, output)) {
           return false;
         }
         LOG_PAYLOAD(INFO,
                     "Initiated msg ("
-                        << m_selfPeer << "): [ RumorId: " << m_rumorIdGenerator
+                        << m_selfPeer << "): [ RumorId: " << rumorId
                         << ", Round: 0, Hash: " << output.substr(0, 6) << " ]",
                     message, 10);
 
-        return m_rumorHolder->addRumor(m_rumorIdGenerator);
+        return m_rumorHolder->addRumor(rumorId);
       }
     } else {
       LOG_GENERAL(DEBUG, "This Rumor was already received. No problem.");
@@ -326,9 +371,10 @@ void RumorManager::SendRumorToForeignPeers(
     LOG_GENERAL(INFO, i);
   }
 
-  RawBytes cmd = GenerateGossipForwardMessage(message);
-
-  P2PComm::GetInstance().SendMessage(toForeignPeers, cmd, START_BYTE_GOSSIP);
+  P2PComm::GetInstance().SendMessage(
+      toForeignPeers,
+      std::make_shared<const RawBytes>(GenerateGossipForwardMessage(message)),
+      START_BYTE_GOSSIP);
 }
 
 void RumorManager::SendRumorToForeignPeers(
@@ -342,9 +388,10 @@ void RumorManager::SendRumorToForeignPeers(
     LOG_GENERAL(INFO, i);
   }
 
-  RawBytes cmd = GenerateGossipForwardMessage(message);
-
-  P2PComm::GetInstance().SendMessage(toForeignPeers, cmd, START_BYTE_GOSSIP);
+  P2PComm::GetInstance().SendMessage(
+      toForeignPeers,
+      std::make_shared<const RawBytes>(GenerateGossipForwardMessage(message)),
+      START_BYTE_GOSSIP);
 }
 
 void RumorManager::SendRumorToForeignPeer(const Peer& toForeignPeer,
@@ -355,22 +402,40 @@ void RumorManager::SendRumorToForeignPeer(const Peer& toForeignPeer,
                   << toForeignPeer << "by me:" << m_selfPeer,
               message, Logger::MAX_BYTES_TO_DISPLAY);
 
-  RawBytes cmd = GenerateGossipForwardMessage(message);
+  P2PComm::GetInstance().SendMessage(
+      toForeignPeer,
+      std::make_shared<const RawBytes>(GenerateGossipForwardMessage(message)),
+      START_BYTE_GOSSIP);
+}
+
+void RumorManager::SendRumorToForeignPeers(
+    const std::deque<std::vector<Peer>>& toForeignPeerGroups,
+    const RawBytes& message) {
+  LOG_MARKER();
+  LOG_PAYLOAD(INFO,
+              "Forwarding new gossip to foreign peer groups. My IP = "
+                  << m_selfPeer,
+              message, Logger::MAX_BYTES_TO_DISPLAY);
+
+  // Sign and compose once, then share the buffer across all groups
+  const SharedBytes cmd =
+      std::make_shared<const RawBytes>(GenerateGossipForwardMessage(message));
 
-  P2PComm::GetInstance().SendMessage(toForeignPeer, cmd, START_BYTE_GOSSIP);
+  for (const auto& toForeignPeers : toForeignPeerGroups) {
+    LOG_GENERAL(INFO, "Foreign Peers: ");
+    for (auto& i : toForeignPeers) {
+      LOG_GENERAL(INFO, i);
+    }
+
+    P2PComm::GetInstance().SendMessage(toForeignPeers, cmd, START_BYTE_GOSSIP);
+  }
 }
 
 std::pair<bool, RumorManager::RawBytes> RumorManager::VerifyMessage(
     const RawBytes& message, const RRS::Message::Type& t, const Peer& from) {
   bytes message_wo_keysig;
 
-  if (((RRS::Message::Type::EMPTY_PUSH == t ||
-        RRS::Message::Type::EMPTY_PULL == t) &&
-       SIGN_VERIFY_EMPTY_MSGTYP) ||
-      ((RRS::Message::Type::LAZY_PUSH == t ||
-        RRS::Message::Type::LAZY_PULL == t || RRS::Message::Type::PUSH == t ||
-        RRS::Message::Type::PULL == t) &&
-       SIGN_VERIFY_NONEMPTY_MSGTYP)) {
+  if (IsSignedType(t)) {
     // verify if the pubkey is from with-in our network
     PubKey senderPubKey;
     if (senderPubKey.Deserialize(message, 0) != 0) {
@@ -437,17 +502,99 @@ std::pair<bool, RumorManager::RawBytes> RumorManager::RumorReceived(
     return {false, {}};
   }
 
-  int64_t recvdRumorId = -1;
   RRS::Message::Type t = convertType(type);
-  bool toBeDispatched = false;
+  if (RRS::Message::Type::BATCH == t) {
+    LOG_GENERAL(WARNING, "Batched rumors must go through RumorBatchReceived");
+    return {false, {}};
+  }
 
   auto result = VerifyMessage(message, t, from);
   if (!result.first) {
     return {false, {}};
   }
-  bytes message_wo_keysig(result.second);
 
   // All checks passed. Good to accept this rumor
+  std::vector<RRS::Message> replies;
+  auto resp = ProcessRumor(t, round, result.second, from, p->second, replies);
+  SendMessages(from, replies);
+
+  return resp;
+}
+
+std::vector<RumorManager::RawBytes> RumorManager::RumorBatchReceived(
+    const RawBytes& message, const Peer& from) {
+  std::vector<RawBytes> toBeDispatched;
+  {
+    std::lock_guard<std::mutex> guard(m_continueRoundMutex);
+    if (!m_continueRound) {
+      return toBeDispatched;
+    }
+  }
+
+  std::lock_guard<std::mutex> guard(m_mutex);
+
+  auto p = m_peerIdPeerBimap.right.find(from);
+  if (p == m_peerIdPeerBimap.right.end()) {
+    // I dont know this peer, missing in my peerlist.
+    LOG_GENERAL(DEBUG, "Received Rumor from peer : "
+                           << from << " which does not exist in my peerlist.");
+    return toBeDispatched;
+  }
+
+  // The signature covers the whole batch, so entries are not verified again
+  auto result = VerifyMessage(message, RRS::Message::Type::BATCH, from);
+  if (!result.first) {
+    return toBeDispatched;
+  }
+  const RawBytes& batch = result.second;
+
+  std::vector<RRS::Message> replies;
+  unsigned int count = 0;
+  unsigned int offset = 0;
+  while (offset < batch.size()) {
+    if (batch.size() - offset < BATCH_ENTRY_HDR_LEN) {
+      LOG_GENERAL(WARNING, "Truncated batch entry header from " << from);
+      break;
+    }
+
+    const RRS::Message::Type t = convertType(batch.at(offset));
+    const int32_t round = Serializable::GetNumber<uint32_t>(
+        batch, offset + 1, sizeof(uint32_t));
+    const uint32_t length = Serializable::GetNumber<uint32_t>(
+        batch, offset + 1 + sizeof(uint32_t), sizeof(uint32_t));
+    offset += BATCH_ENTRY_HDR_LEN;
+
+    if (length > batch.size() - offset) {
+      LOG_GENERAL(WARNING, "Truncated batch entry body from " << from);
+      break;
+    }
+
+    const RawBytes entry(batch.begin() + offset,
+                         batch.begin() + offset + length);
+    offset += length;
+    count++;
+
+    auto resp = ProcessRumor(t, round, entry, from, p->second, replies);
+    if (resp.first) {
+      toBeDispatched.emplace_back(std::move(resp.second));
+    }
+  }
+
+  m_batchesReceived++;
+  m_batchedMsgsReceived += count;
+  LOG_GENERAL(DEBUG, "Received batch of " << count << " rumors from " << from);
+
+  SendMessages(from, replies);
+
+  return toBeDispatched;
+}
+
+std::pair<bool, RumorManager::RawBytes> RumorManager::ProcessRumor(
+    const RRS::Message::Type t, int32_t round,
+    const RawBytes& message_wo_keysig, const Peer& from, int peerId,
+    std::vector<RRS::Message>& replies) {
+  int64_t recvdRumorId = -1;
+  bool toBeDispatched = false;
 
   if (RRS::Message::Type::EMPTY_PUSH == t ||
       RRS::Message::Type::EMPTY_PULL == t) {
@@ -456,49 +603,67 @@ std::pair<bool, RumorManager::RawBytes> RumorManager::RumorReceived(
                            << RRS::Message::s_enumKeyToString[t]);
   } else if (RRS::Message::Type::LAZY_PUSH == t ||
              RRS::Message::Type::LAZY_PULL == t) {
-    auto it = m_rumorIdHashBimap.right.find(message_wo_keysig);
-    if (it == m_rumorIdHashBimap.right.end()) {
-      recvdRumorId = ++m_rumorIdGenerator;
-
-      m_rumorIdHashBimap.insert(
-          RumorIdRumorBimap::value_type(recvdRumorId, message_wo_keysig));
+    // A digest carries the size of the raw message after the hash
+    const bool isDigest =
+        ENABLE_GOSSIP_DIGEST_PULL && message_wo_keysig.size() == DIGEST_LEN;
+    const RawBytes hash(message_wo_keysig.begin(),
+                        message_wo_keysig.end() -
+                            (isDigest ? sizeof(uint32_t) : 0));
+    const uint32_t rawSize =
+        isDigest ? Serializable::GetNumber<uint32_t>(
+                       message_wo_keysig, hash.size(), sizeof(uint32_t))
+                 : 0;
+
+    const Rumor* known = FindRumor(hash);
+    if (known == nullptr || known->m_id == 0) {
+      MakeRoom(hash.size());
+      Rumor& rumor = AddRumorHash(hash, true);
+      recvdRumorId = rumor.m_id;
 
       // Now that's the new hash message. So we dont have the real message.
-      // So lets ask the sender for it.
-      RRS::Message pullMsg(RRS::Message::Type::PULL, recvdRumorId, -1);
-      SendMessage(from, pullMsg);
+      // So lets ask the sender for it, or one of the announcers if it is
+      // large.
+      if (isDigest) {
+        DigestReceived(hash, rumor, rawSize, peerId);
+      } else {
+        replies.emplace_back(RRS::Message::Type::PULL, recvdRumorId, -1);
+      }
     } else {
-      recvdRumorId = it->second;
+      recvdRumorId = known->m_id;
       LOG_GENERAL(DEBUG, "Old Gossip hash message received from "
                              << from << ". [ RumorId: " << recvdRumorId
                              << ", Current Round: " << round);
       // check if we have received the real message for this old rumor.
-      auto it = m_rumorHashRawMsgBimap.left.find(message_wo_keysig);
-      if (it == m_rumorHashRawMsgBimap.left.end()) {
+      if (!known->m_hasRawMsg) {
         // didn't receive real message (PUSH) yet :( Lets ask this peer.
-        RRS::Message pullMsg(RRS::Message::Type::PULL, recvdRumorId, -1);
-        SendMessage(from, pullMsg);
+        if (isDigest) {
+          DigestReceived(hash, *FindRumor(hash), rawSize, peerId);
+        } else {
+          replies.emplace_back(RRS::Message::Type::PULL, recvdRumorId, -1);
+        }
       }
     }
   } else if (RRS::Message::Type::PULL == t) {
     // Now that sender wants the real message, lets send it to him.
-    auto it1 = m_rumorHashRawMsgBimap.left.find(message_wo_keysig);
-    if (it1 != m_rumorHashRawMsgBimap.left.end()) {
-      auto it2 = m_rumorIdHashBimap.right.find(message_wo_keysig);
-      if (it2 != m_rumorIdHashBimap.right.end()) {
-        recvdRumorId = it2->second;
-        RRS::Message pushMsg(RRS::Message::Type::PUSH, recvdRumorId, -1);
-        SendMessage(from, pushMsg);
+    Rumor* rumor = FindRumor(message_wo_keysig);
+    if (rumor != nullptr && rumor->m_hasRawMsg) {
+      if (rumor->m_id != 0) {
+        replies.emplace_back(RRS::Message::Type::PUSH, rumor->m_id, -1);
       }
     } else  // I dont have it as of now. Add this peer to subscriber list for
             // this hash message.
     {
-      auto it2 = m_hashesSubscriberMap.find(message_wo_keysig);
-      if (it2 == m_hashesSubscriberMap.end()) {
-        m_hashesSubscriberMap.insert(RumorHashesPeersMap::value_type(
-            message_wo_keysig, std::set<Peer>()));
+      if (rumor == nullptr) {
+        MakeRoom(message_wo_keysig.size());
+        rumor = &AddRumorHash(message_wo_keysig, false);
+      }
+      if (rumor->m_subscribers.empty()) {
+        rumor->m_subscribers.resize(m_peerIdPeerBimap.size() + 1);
+        m_rumorBytes += rumor->m_subscribers.size() / 8 + 1;
+      }
+      if (static_cast<size_t>(peerId) < rumor->m_subscribers.size()) {
+        rumor->m_subscribers[peerId] = true;
       }
-      m_hashesSubscriberMap[message_wo_keysig].insert(from);
     }
     return {false, {}};
   } else if (RRS::Message::Type::PUSH == t) {
@@ -511,26 +676,28 @@ std::pair<bool, RumorManager::RawBytes> RumorManager::RumorReceived(
       std::string hashStr;
       DataConversion::Uint8VecToHexStr(hash, hashStr);
 
-      auto it1 = m_rumorIdHashBimap.right.find(hash);
-      if (it1 != m_rumorIdHashBimap.right.end()) {
-        recvdRumorId = it1->second;
+      const Rumor* known = FindRumor(hash);
+      if (known != nullptr && known->m_id != 0) {
+        recvdRumorId = known->m_id;
       } else {
         // I have not asked for this raw message.. so ignoring
         return {false, {}};
       }
 
       // toBeDispatched
-      auto result = m_rumorHashRawMsgBimap.insert(
-          RumorHashRumorBiMap::value_type(hash, message_wo_keysig));
-      if (result.second) {
+      if (!known->m_hasRawMsg) {
+        // Making room may expire this very rumor, if it is that old
+        MakeRoom(message_wo_keysig.size());
+      }
+      if (FindRumor(hash) == nullptr) {
+        return {false, {}};
+      }
+      if (AddRawMessage(hash, message_wo_keysig)) {
         LOG_PAYLOAD(
             INFO,
             "New msg for hash [" << hashStr.substr(0, 6) << "] from " << from,
             message_wo_keysig, Logger::MAX_BYTES_TO_DISPLAY);
         toBeDispatched = true;
-        // add the timestamp for this raw rumor message
-        m_rumorRawMsgTimestamp.push_back(std::make_pair(
-            result.first, std::chrono::high_resolution_clock::now()));
       } else {
         LOG_PAYLOAD(DEBUG,
                     "Old Gossip Raw message received from Peer: "
@@ -540,22 +707,28 @@ std::pair<bool, RumorManager::RawBytes> RumorManager::RumorReceived(
       }
 
       // Do i have any peers subscribed with me for this hash.
-      auto it2 = m_hashesSubscriberMap.find(hash);
-      if (it2 != m_hashesSubscriberMap.end()) {
+      Rumor* rumor = FindRumor(hash);
+      if (rumor != nullptr && !rumor->m_subscribers.empty()) {
         // Send PUSH
         LOG_GENERAL(
             DEBUG,
             "Sending Gossip Raw Message to subscribers of Gossip_Message_Hash: "
                 << hashStr.substr(0, 6));
-        for (auto& p : it2->second) {
+        BitVector subscribers;
+        std::swap(subscribers, rumor->m_subscribers);
+        m_rumorBytes -= subscribers.size() / 8 + 1;
+        subscribers.ForEachSet([&](size_t subscriberId) {
           // avoid un-neccessarily sending again back to sender itself
-          if (p == from) {
-            continue;
+          if (static_cast<int>(subscriberId) == peerId) {
+            return;
+          }
+          auto p = m_peerIdPeerBimap.left.find(subscriberId);
+          if (p == m_peerIdPeerBimap.left.end()) {
+            return;
           }
           RRS::Message pushMsg(RRS::Message::Type::PUSH, recvdRumorId, -1);
-          SendMessage(p, pushMsg);
-        }
-        m_hashesSubscriberMap.erase(hash);
+          SendMessage(p->second, pushMsg);
+        });
       }
     }
     return {toBeDispatched, message_wo_keysig};
@@ -567,12 +740,13 @@ std::pair<bool, RumorManager::RawBytes> RumorManager::RumorReceived(
   RRS::Message recvMsg(t, recvdRumorId, round);
 
   std::pair<int, std::vector<RRS::Message>> pullMsgs =
-      m_rumorHolder->receivedMessage(recvMsg, p->second);
+      m_rumorHolder->receivedMessage(recvMsg, peerId);
 
   LOG_GENERAL(DEBUG, "Sending " << pullMsgs.second.size()
                                 << " EMPTY_PULL or LAZY_PULL Messages");
 
-  SendMessages(from, pullMsgs.second);
+  replies.insert(replies.end(), pullMsgs.second.begin(),
+                 pullMsgs.second.end());
 
   return {toBeDispatched, message_wo_keysig};
 }
@@ -589,103 +763,229 @@ void RumorManager::AppendKeyAndSignature(RawBytes& result,
   result.insert(result.end(), tmp.begin(), tmp.end());
 }
 
-void RumorManager::SendMessage(const Peer& toPeer,
-                               const RRS::Message& message) {
+RumorManager::RawBytes RumorManager::ComposeGossipHeader(
+    const RRS::Message::Type t, uint32_t rounds) {
   // Add round and type to outgoing message
-  RRS::Message::Type t = message.type();
   RawBytes cmd = {(unsigned char)t};
   unsigned int cur_offset = RRSMessageOffset::R_ROUNDS;
 
-  Serializable::SetNumber<uint32_t>(cmd, cur_offset, message.rounds(),
-                                    sizeof(uint32_t));
+  Serializable::SetNumber<uint32_t>(cmd, cur_offset, rounds, sizeof(uint32_t));
 
   cur_offset += sizeof(uint32_t);
 
   Serializable::SetNumber<uint32_t>(
       cmd, cur_offset, m_selfPeer.m_listenPortHost, sizeof(uint32_t));
 
-  if (!(RRS::Message::Type::EMPTY_PUSH == t ||
-        RRS::Message::Type::EMPTY_PULL == t)) {
-    // Get the hash messages based on rumor id.
-    auto it1 = m_rumorIdHashBimap.left.find(message.rumorId());
-    if (it1 != m_rumorIdHashBimap.left.end()) {
-      if (RRS::Message::Type::PUSH == t) {
-        // Get the raw message based on hash
-        auto it2 = m_rumorHashRawMsgBimap.left.find(it1->second);
-        if (it2 != m_rumorHashRawMsgBimap.left.end()) {
-          if (SIGN_VERIFY_NONEMPTY_MSGTYP) {
-            // Add pubkey and signature before message body
-            AppendKeyAndSignature(cmd, it2->second);
-          }
+  return cmd;
+}
 
-          // Add raw message to outgoing message
-          cmd.insert(cmd.end(), it2->second.begin(), it2->second.end());
-          std::string gossipHashStr;
-          if (!DataConversion::Uint8VecToHexStr(it1->second, gossipHashStr)) {
-            return;
-          }
-          LOG_GENERAL(INFO, "Sending [" << gossipHashStr.substr(0, 6) << "] to "
-                                        << toPeer);
-        } else {
-          // Nothing to send.
-          return;
-        }
-      } else if (RRS::Message::Type::LAZY_PUSH == t ||
-                 RRS::Message::Type::LAZY_PULL == t ||
-                 RRS::Message::Type::PULL == t) {
-        if (SIGN_VERIFY_NONEMPTY_MSGTYP) {
-          // Add pubkey and signature before message body
-          AppendKeyAndSignature(cmd, it1->second);
-        }
+bool RumorManager::ComposeMessageBody(const RRS::Message& message,
+                                      const std::vector<Peer>& toPeers,
+                                      RawBytes& body) {
+  RRS::Message::Type t = message.type();
 
-        // Add hash message to outgoing message for types
-        // LAZY_PULL/LAZY_PUSH/PULL
-        cmd.insert(cmd.end(), it1->second.begin(), it1->second.end());
-        LOG_GENERAL(DEBUG, "Sending Gossip Hash Message: "
-                               << message << " To Peer : " << toPeer);
-      } else {
-        return;
-      }
-    }
-  } else {  // EMPTY_PULL/ EMPTY_PUSH
+  if (RRS::Message::Type::EMPTY_PUSH == t ||
+      RRS::Message::Type::EMPTY_PULL == t) {
     if (SIGN_VERIFY_EMPTY_MSGTYP) {
-      // Add pubkey and signature before message body
-      RawBytes dummyMsg = {'D', 'U', 'M', 'M', 'Y'};
-      AppendKeyAndSignature(cmd, dummyMsg);
       // Add dummy message to outgoing message
-      cmd.insert(cmd.end(), dummyMsg.begin(), dummyMsg.end());
+      body = {'D', 'U', 'M', 'M', 'Y'};
     }
+    return true;
   }
 
+  // Get the hash messages based on rumor id.
+  const RawBytes* hash = nullptr;
+  const Rumor* rumor = FindRumor(message.rumorId(), hash);
+  if (rumor == nullptr) {
+    return false;
+  }
+
+  if (RRS::Message::Type::PUSH == t) {
+    // Get the raw message based on hash
+    if (!rumor->m_hasRawMsg) {
+      // Nothing to send.
+      return false;
+    }
+
+    std::string gossipHashStr;
+    if (!DataConversion::Uint8VecToHexStr(*hash, gossipHashStr)) {
+      return false;
+    }
+
+    // Add raw message to outgoing message
+    body = rumor->m_rawMsg;
+    for (const auto& toPeer : toPeers) {
+      LOG_GENERAL(INFO, "Sending [" << gossipHashStr.substr(0, 6) << "] to "
+                                    << toPeer);
+    }
+  } else if (RRS::Message::Type::LAZY_PUSH == t ||
+             RRS::Message::Type::LAZY_PULL == t ||
+             RRS::Message::Type::PULL == t) {
+    // Add hash message to outgoing message for types
+    // LAZY_PULL/LAZY_PUSH/PULL
+    body = *hash;
+    const uint32_t rawSize = rumor->m_hasRawMsg
+                                 ? static_cast<uint32_t>(rumor->m_rawMsg.size())
+                                 : rumor->m_rawSize;
+    if (RRS::Message::Type::PULL != t && IsDigestPulled(rawSize)) {
+      Serializable::SetNumber<uint32_t>(body, body.size(), rawSize,
+                                        sizeof(uint32_t));
+    }
+    LOG_GENERAL(DEBUG, "Sending Gossip Hash Message: " << message);
+  } else {
+    return false;
+  }
+
+  return true;
+}
+
+void RumorManager::SendGossipFrame(const std::vector<Peer>& toPeers,
+                                   const SharedBytes& cmd) {
   // Send the message to peer .
   if (SIMULATED_NETWORK_DELAY_IN_MS > 0) {
     std::this_thread::sleep_for(
         std::chrono::milliseconds(SIMULATED_NETWORK_DELAY_IN_MS));
   }
-  P2PComm::GetInstance().SendMessage(toPeer, cmd, START_BYTE_GOSSIP);
+  P2PComm::GetInstance().SendMessage(toPeers, cmd, START_BYTE_GOSSIP);
+}
+
+void RumorManager::SendMessage(const Peer& toPeer,
+                               const RRS::Message& message) {
+  RawBytes body;
+  if (!ComposeMessageBody(message, {toPeer}, body)) {
+    return;
+  }
+
+  RawBytes cmd = ComposeGossipHeader(message.type(), message.rounds());
+
+  if (IsSignedType(message.type())) {
+    // Add pubkey and signature before message body
+    AppendKeyAndSignature(cmd, body);
+  }
+  cmd.insert(cmd.end(), body.begin(), body.end());
+
+  SendGossipFrame({toPeer}, std::make_shared<const RawBytes>(std::move(cmd)));
+}
+
+std::vector<SharedBytes> RumorManager::ComposeBatches(
+    const std::vector<RRS::Message>& messages,
+    const std::vector<Peer>& toPeers) {
+  std::vector<SharedBytes> batches;
+
+  const unsigned int overhead =
+      BATCH_WIRE_HDR_RESERVED_LEN + RRSMessageOffset::R_ROUNDS +
+      sizeof(uint32_t) + sizeof(uint32_t) + PUB_KEY_SIZE +
+      SIGNATURE_CHALLENGE_SIZE + SIGNATURE_RESPONSE_SIZE;
+
+  RawBytes entries;
+  unsigned int count = 0;
+
+  auto flush = [&]() {
+    if (count == 0) {
+      return;
+    }
+
+    RawBytes cmd = ComposeGossipHeader(RRS::Message::Type::BATCH, 0);
+    if (IsSignedType(RRS::Message::Type::BATCH)) {
+      // A single signature for all entries instead of one per rumor
+      AppendKeyAndSignature(cmd, entries);
+    }
+    cmd.insert(cmd.end(), entries.begin(), entries.end());
+    batches.emplace_back(std::make_shared<const RawBytes>(std::move(cmd)));
+
+    m_batchesSent += toPeers.size();
+    m_batchedMsgsSent += count * toPeers.size();
+    if (count > m_maxBatchSize) {
+      m_maxBatchSize = count;
+    }
+
+    entries.clear();
+    count = 0;
+  };
+
+  for (const auto& message : messages) {
+    RawBytes body;
+    if (!ComposeMessageBody(message, toPeers, body)) {
+      continue;
+    }
+
+    if ((count >= MAX_GOSSIP_BATCH_SIZE) ||
+        (overhead + entries.size() + BATCH_ENTRY_HDR_LEN + body.size() >=
+         MAX_GOSSIP_MSG_SIZE_IN_BYTES)) {
+      flush();
+    }
+
+    unsigned int cur_offset = entries.size();
+    entries.push_back((unsigned char)message.type());
+    cur_offset++;
+    Serializable::SetNumber<uint32_t>(entries, cur_offset, message.rounds(),
+                                      sizeof(uint32_t));
+    cur_offset += sizeof(uint32_t);
+    Serializable::SetNumber<uint32_t>(entries, cur_offset, body.size(),
+                                      sizeof(uint32_t));
+    entries.insert(entries.end(), body.begin(), body.end());
+    count++;
+  }
+
+  flush();
+
+  return batches;
 }
 
 void RumorManager::SendMessages(const Peer& toPeer,
                                 const std::vector<RRS::Message>& messages) {
-  for (auto& k : messages) {
-    SendMessage(toPeer, k);
-  }
+  SendMessages(std::vector<Peer>{toPeer}, messages);
 }
 
-// PUBLIC CONST METHODS
-const RumorManager::RumorIdRumorBimap& RumorManager::rumors() const {
-  return m_rumorIdHashBimap;
+void RumorManager::SendMessages(const std::vector<Peer>& toPeers,
+                                const std::vector<RRS::Message>& messages) {
+  if (toPeers.empty() || messages.empty()) {
+    return;
+  }
+
+  if (!ENABLE_GOSSIP_BATCHING || messages.size() == 1) {
+    for (const auto& toPeer : toPeers) {
+      for (const auto& k : messages) {
+        SendMessage(toPeer, k);
+      }
+    }
+    return;
+  }
+
+  // The batch does not depend on the receiver, so compose it only once
+  for (const auto& batch : ComposeBatches(messages, toPeers)) {
+    SendGossipFrame(toPeers, batch);
+  }
 }
 
 void RumorManager::PrintStatistics() {
   LOG_MARKER();
+  if (m_digestPullsSent > 0) {
+    LOG_GENERAL(INFO, "Gossip digest pulls sent: "
+                          << m_digestPullsSent << ", retried: "
+                          << m_digestPullsRetried
+                          << ", waiting: " << m_digestPulls.size());
+  }
+  if (m_batchesSent > 0 || m_batchesReceived > 0) {
+    LOG_GENERAL(INFO, "Gossip batches sent: "
+                          << m_batchesSent << " (avg "
+                          << (m_batchesSent > 0
+                                  ? m_batchedMsgsSent / m_batchesSent
+                                  : 0)
+                          << " rumors, max " << m_maxBatchSize
+                          << "), received: " << m_batchesReceived << " (avg "
+                          << (m_batchesReceived > 0
+                                  ? m_batchedMsgsReceived / m_batchesReceived
+                                  : 0)
+                          << " rumors)");
+  }
   // we use hash of message to uniquely identify message across different nodes
   // in network.
   for (const auto& i : m_rumorHolder->rumorsMap()) {
     uint32_t rumorId = i.first;
-    auto it = m_rumorIdHashBimap.left.find(rumorId);
-    if (it != m_rumorIdHashBimap.left.end()) {
-      bytes this_msg_hash = HashUtils::BytesToHash(it->second);
+    const RawBytes* hash = nullptr;
+    if (FindRumor(rumorId, hash) != nullptr) {
+      bytes this_msg_hash = HashUtils::BytesToHash(*hash);
       const RRS::RumorStateMachine& state = i.second;
       std::string gossipHashStr;
       if (!DataConversion::Uint8VecToHexStr(this_msg_hash, gossipHashStr)) {
@@ -699,28 +999,249 @@ void RumorManager::PrintStatistics() {
 }
 
 void RumorManager::CleanUp() {
-  int count = 0;
-  auto now = std::chrono::high_resolution_clock::now();
-  while (!m_rumorRawMsgTimestamp.empty()) {
-    auto elapsed_milliseconds =
-        std::chrono::duration_cast<std::chrono::milliseconds>(
-            now - m_rumorRawMsgTimestamp.front().second)
-            .count();
-    LOG_GENERAL(DEBUG, "elapsed_milliseconds:" << elapsed_milliseconds
-                                               << " , m_rawMessageExpiryInMs:"
-                                               << m_rawMessageExpiryInMs);
-    if (elapsed_milliseconds > m_rawMessageExpiryInMs) {  // older
-      auto hash = m_rumorRawMsgTimestamp.front().first->left;
-      m_rumorHashRawMsgBimap.erase(m_rumorRawMsgTimestamp.front().first);
-
-      m_rumorIdHashBimap.right.erase(hash);
-      m_rumorRawMsgTimestamp.pop_front();
-      count++;
-    } else {
-      break;  // other in deque are definately not older. so quit loop
-    }
-  }
+  const size_t before = m_rumors.size();
+  AdvanceGeneration();
+  const size_t count = before - m_rumors.size();
   if (count != 0) {
     LOG_GENERAL(INFO, "Cleaned " << count << " messages");
   }
 }
+
+RumorManager::Rumor* RumorManager::FindRumor(const RawBytes& hash) {
+  auto it = m_rumors.find(hash);
+  return it == m_rumors.end() ? nullptr : &it->second;
+}
+
+RumorManager::Rumor* RumorManager::FindRumor(int64_t id,
+                                             const RawBytes*& hash) {
+  auto it = m_rumorHashes.find(id);
+  if (it == m_rumorHashes.end()) {
+    return nullptr;
+  }
+  hash = &it->second;
+  return FindRumor(it->second);
+}
+
+uint64_t RumorManager::GetFootprint(const RawBytes& hash, const Rumor& rumor) {
+  // The hash is held by the rumor, its id and its generation
+  return sizeof(Rumor) + 3 * hash.size() + rumor.m_rawMsg.size() +
+         (rumor.m_id != 0 ? sizeof(int64_t) + sizeof(RawBytes) : 0) +
+         (rumor.m_announcers.empty() ? 0 : rumor.m_announcers.size() / 8 + 1);
+}
+
+RumorManager::Rumor& RumorManager::AddRumorHash(const RawBytes& hash,
+                                                bool withId) {
+  auto it = m_rumors.find(hash);
+  if (it == m_rumors.end()) {
+    it = m_rumors.emplace(hash, Rumor()).first;
+    it->second.m_generation = m_generations.back().m_number;
+    m_generations.back().m_hashes.emplace_back(hash);
+    m_rumorBytes += GetFootprint(hash, it->second);
+  }
+
+  Rumor& rumor = it->second;
+  if (withId && rumor.m_id == 0) {
+    m_rumorBytes -= GetFootprint(hash, rumor);
+    rumor.m_id = ++m_rumorIdGenerator;
+    m_rumorHashes.emplace(rumor.m_id, hash);
+    m_rumorBytes += GetFootprint(hash, rumor);
+  }
+  return rumor;
+}
+
+bool RumorManager::AddRawMessage(const RawBytes& hash, const RawBytes& rawMsg) {
+  Rumor* rumor = FindRumor(hash);
+  if (rumor == nullptr || rumor->m_hasRawMsg) {
+    return false;
+  }
+
+  m_rumorBytes -= GetFootprint(hash, *rumor);
+  rumor->m_rawMsg = rawMsg;
+  rumor->m_hasRawMsg = true;
+  // Nothing is left to pull
+  rumor->m_announcers = BitVector();
+  if (rumor->m_pullPeer != 0) {
+    FinishPull(*rumor);
+  }
+  m_rumorBytes += GetFootprint(hash, *rumor);
+
+  // Kept for the full expiry from now on, the entry in its old generation
+  // being skipped when that one expires
+  if (rumor->m_generation != m_generations.back().m_number) {
+    rumor->m_generation = m_generations.back().m_number;
+    m_generations.back().m_hashes.emplace_back(hash);
+  }
+  return true;
+}
+
+bool RumorManager::ExpireOldestGeneration() {
+  if (m_generations.empty()) {
+    return false;
+  }
+
+  const Generation& oldest = m_generations.front();
+  for (const auto& hash : oldest.m_hashes) {
+    auto it = m_rumors.find(hash);
+    if (it == m_rumors.end() || it->second.m_generation != oldest.m_number) {
+      // Gone already, or completed in a later generation
+      continue;
+    }
+
+    m_rumorBytes -= GetFootprint(hash, it->second);
+    m_rumorBytes -= it->second.m_subscribers.empty()
+                        ? 0
+                        : it->second.m_subscribers.size() / 8 + 1;
+    if (it->second.m_id != 0) {
+      m_rumorHashes.erase(it->second.m_id);
+    }
+    if (it->second.m_pullPeer != 0) {
+      FinishPull(it->second);
+    }
+    m_rumors.erase(it);
+  }
+
+  m_generations.pop_front();
+  if (m_generations.empty()) {
+    m_generations.push_back(
+        {oldest.m_number + 1, std::chrono::steady_clock::now(), {}});
+  }
+  return true;
+}
+
+void RumorManager::AdvanceGeneration() {
+  const auto now = std::chrono::steady_clock::now();
+  m_generations.push_back({m_generations.back().m_number + 1, now, {}});
+
+  // A generation is expired once the one after it, and so its last rumor,
+  // is older than the expiry
+  const auto expiry = std::chrono::milliseconds(m_rawMessageExpiryInMs);
+  while (m_generations.size() > 1 && now - m_generations[1].m_start > expiry) {
+    ExpireOldestGeneration();
+  }
+}
+
+void RumorManager::MakeRoom(uint64_t bytes) {
+  uint64_t evicted = 0;
+  while (!m_rumors.empty() &&
+         (m_rumorBytes + bytes > GOSSIP_RUMOR_STORE_MAX_BYTES ||
+          m_rumors.size() >= GOSSIP_RUMOR_STORE_MAX_ENTRIES)) {
+    const size_t before = m_rumors.size();
+    if (m_generations.size() == 1) {
+      // The current generation alone is over the caps, so drop it too
+      m_generations.push_back({m_generations.back().m_number + 1,
+                               std::chrono::steady_clock::now(), {}});
+    }
+    ExpireOldestGeneration();
+    evicted += before - m_rumors.size();
+  }
+
+  if (evicted > 0) {
+    m_rumorsEvicted += evicted;
+    LOG_GENERAL(WARNING, "Rumor store full, evicted "
+                             << evicted << " rumors early (" << m_rumorsEvicted
+                             << " so far), " << m_rumors.size() << " rumors "
+                             << m_rumorBytes << " bytes left");
+  }
+}
+
+bool RumorManager::IsDigestPulled(uint32_t rawSize) {
+  return ENABLE_GOSSIP_DIGEST_PULL && rawSize > 0 &&
+         rawSize >= GOSSIP_DIGEST_PULL_THRESHOLD_IN_BYTES;
+}
+
+void RumorManager::DigestReceived(const RawBytes& hash, Rumor& rumor,
+                                  uint32_t rawSize, int peerId) {
+  m_rumorBytes -= GetFootprint(hash, rumor);
+  if (rumor.m_rawSize == 0) {
+    rumor.m_rawSize = rawSize;
+  }
+  if (rumor.m_announcers.empty()) {
+    rumor.m_announcers.resize(m_peerIdPeerBimap.size() + 1);
+  }
+  if (peerId != rumor.m_pullPeer &&
+      static_cast<size_t>(peerId) < rumor.m_announcers.size()) {
+    rumor.m_announcers[peerId] = true;
+  }
+  m_rumorBytes += GetFootprint(hash, rumor);
+
+  if (!rumor.m_pullQueued) {
+    rumor.m_pullQueued = true;
+    m_digestPulls.push_back(rumor.m_id);
+  }
+  if (rumor.m_pullPeer == 0) {
+    PullDigest(rumor);
+  }
+}
+
+bool RumorManager::PullDigest(Rumor& rumor) {
+  if (m_digestPullsLeft == 0) {
+    return false;
+  }
+
+  // Spread the pulls over the announcers, so a slow peer holds up few
+  int chosen = 0;
+  rumor.m_announcers.ForEachSet([&](size_t id) {
+    if (id < m_pullsPerPeer.size() &&
+        (chosen == 0 || m_pullsPerPeer[id] < m_pullsPerPeer[chosen])) {
+      chosen = static_cast<int>(id);
+    }
+  });
+  auto p = m_peerIdPeerBimap.left.find(chosen);
+  if (chosen == 0 || p == m_peerIdPeerBimap.left.end()) {
+    return false;
+  }
+
+  if (rumor.m_pullPeer != 0) {
+    FinishPull(rumor);
+    m_digestPullsRetried++;
+  }
+  rumor.m_announcers[chosen] = false;
+  rumor.m_pullPeer = chosen;
+  rumor.m_pulledAt = std::chrono::steady_clock::now();
+  m_pullsPerPeer[chosen]++;
+  m_digestPullsLeft--;
+  m_digestPullsSent++;
+
+  RRS::Message pullMsg(RRS::Message::Type::PULL, rumor.m_id, -1);
+  SendMessage(p->second, pullMsg);
+  return true;
+}
+
+void RumorManager::FinishPull(Rumor& rumor) {
+  if (static_cast<size_t>(rumor.m_pullPeer) < m_pullsPerPeer.size() &&
+      m_pullsPerPeer[rumor.m_pullPeer] > 0) {
+    m_pullsPerPeer[rumor.m_pullPeer]--;
+  }
+  rumor.m_pullPeer = 0;
+}
+
+void RumorManager::IssueDigestPulls() {
+  m_digestPullsLeft = GOSSIP_DIGEST_MAX_PULLS_PER_ROUND;
+
+  const auto now = std::chrono::steady_clock::now();
+  const auto timeout =
+      std::chrono::milliseconds(GOSSIP_DIGEST_PULL_TIMEOUT_IN_MS);
+
+  for (size_t waiting = m_digestPulls.size(); waiting > 0; waiting--) {
+    const int64_t id = m_digestPulls.front();
+    m_digestPulls.pop_front();
+
+    const RawBytes* hash = nullptr;
+    Rumor* rumor = FindRumor(id, hash);
+    if (rumor == nullptr) {
+      // Expired, along with its pull
+      continue;
+    }
+    if (rumor->m_hasRawMsg) {
+      rumor->m_pullQueued = false;
+      continue;
+    }
+
+    // A timed out pull stays in flight until another announcer is asked, as
+    // the raw message may still come
+    if (rumor->m_pullPeer == 0 || now - rumor->m_pulledAt > timeout) {
+      PullDigest(*rumor);
+    }
+    m_digestPulls.push_back(id);
+  }
+}
@@ -19,6 +19,8 @@
 #define __RUMORMANAGER_H__
 
 #include <boost/bimap.hpp>
+#include <boost/functional/hash.hpp>
+#include <atomic>
 #include <condition_variable>
 #include <deque>
 #include <map>
@@ -28,7 +30,9 @@
 #include "Peer.h"
 #include "ShardStruct.h"
 #include "libCrypto/Schnorr.h"
+#include "libData/DataStructures/FlatHashMap.h"
 #include "libRumorSpreading/RumorHolder.h"
+#include "libUtils/BitVector.h"
 
 enum RRSMessageOffset : unsigned int {
   R_TYPE = 0,
@@ -45,26 +49,69 @@ class RumorManager {
  private:
   // TYPES
   typedef boost::bimap<int, Peer> PeerIdPeerBiMap;
-  typedef boost::bimap<int, RawBytes> RumorIdRumorBimap;
-  typedef boost::bimap<RawBytes, RawBytes> RumorHashRumorBiMap;
-  typedef std::map<RawBytes, std::set<Peer>> RumorHashesPeersMap;
-  typedef std::deque<std::pair<RumorHashRumorBiMap::iterator,
-                               std::chrono::high_resolution_clock::time_point>>
-      RumorRawMsgTimestampDeque;
   typedef boost::bimap<PubKey, Peer> PubKeyPeerBiMap;
 
+  struct RawBytesHash {
+    size_t operator()(const RawBytes& bytes) const {
+      return boost::hash_range(bytes.begin(), bytes.end());
+    }
+  };
+
+  /// What is known of the rumor with a given hash
+  struct Rumor {
+    /// 0 until the hash is announced to us or by us, when it is only known
+    /// because peers asked for it
+    int64_t m_id = 0;
+    bool m_hasRawMsg = false;
+    RawBytes m_rawMsg;
+    /// Ids of the peers to send the raw message to once it arrives
+    BitVector m_subscribers;
+    /// The generation that last added or completed the rumor
+    uint64_t m_generation = 0;
+
+    // Digest pull state, for the large rumors announced by digest
+    /// Size of the raw message given by the digest
+    uint32_t m_rawSize = 0;
+    /// Ids of the peers that announced the digest and were not asked yet
+    BitVector m_announcers;
+    /// Id of the peer asked for the raw message, 0 if none, and since when
+    int m_pullPeer = 0;
+    std::chrono::steady_clock::time_point m_pulledAt;
+    /// Whether the rumor id is in m_digestPulls
+    bool m_pullQueued = false;
+  };
+
+  /// The hashes of the rumors added or completed in one generation. The
+  /// rumors are expired a generation at a time, once all were added at
+  /// least m_rawMessageExpiryInMs ago.
+  struct Generation {
+    uint64_t m_number;
+    std::chrono::steady_clock::time_point m_start;
+    std::vector<RawBytes> m_hashes;
+  };
+
   // MEMBERS
   std::shared_ptr<RRS::RumorHolder> m_rumorHolder;
   PeerIdPeerBiMap m_peerIdPeerBimap;
   PubKeyPeerBiMap m_pubKeyPeerBiMap;
   std::unordered_set<int> m_peerIdSet;
-  RumorIdRumorBimap m_rumorIdHashBimap;
-  RumorHashRumorBiMap m_rumorHashRawMsgBimap;
-  RumorHashesPeersMap m_hashesSubscriberMap;
+  FlatHashMap<RawBytes, Rumor, RawBytesHash> m_rumors;
+  FlatHashMap<int64_t, RawBytes> m_rumorHashes;
+  std::deque<Generation> m_generations;
+  /// Estimated bytes held by m_rumors, m_rumorHashes and m_generations
+  uint64_t m_rumorBytes;
+  uint64_t m_rumorsEvicted;
+  /// Ids of the large rumors waiting for their raw message, oldest first
+  std::deque<int64_t> m_digestPulls;
+  /// Digest pulls in flight to each peer id
+  std::vector<unsigned int> m_pullsPerPeer;
+  /// Digest pulls that can still be sent in this round
+  unsigned int m_digestPullsLeft;
+  uint64_t m_digestPullsSent;
+  uint64_t m_digestPullsRetried;
   Peer m_selfPeer;
   PairOfKey m_selfKey;
   std::vector<RawBytes> m_bufferRawMsg;
-  RumorRawMsgTimestampDeque m_rumorRawMsgTimestamp;
   std::vector<PubKey> m_fullNetworkKeys;
 
   int64_t m_rumorIdGenerator;
@@ -75,13 +122,99 @@ class RumorManager {
 
   int32_t m_rawMessageExpiryInMs;
 
+  // Batching statistics
+  std::atomic<uint64_t> m_batchesSent;
+  std::atomic<uint64_t> m_batchedMsgsSent;
+  std::atomic<unsigned int> m_maxBatchSize;
+  std::atomic<uint64_t> m_batchesReceived;
+  std::atomic<uint64_t> m_batchedMsgsReceived;
+
   void SendMessages(const Peer& toPeer,
                     const std::vector<RRS::Message>& messages);
 
+  /// Sends the messages to every peer, packed into BATCH frames when
+  /// ENABLE_GOSSIP_BATCHING is set and there is more than one message
+  void SendMessages(const std::vector<Peer>& toPeers,
+                    const std::vector<RRS::Message>& messages);
+
   void SendMessage(const Peer& toPeer, const RRS::Message& message);
 
+  void SendGossipFrame(const std::vector<Peer>& toPeers,
+                       const SharedBytes& cmd);
+
+  RawBytes ComposeGossipHeader(const RRS::Message::Type t, uint32_t rounds);
+
+  /// Fills body with the raw message, hash or dummy carried by the message.
+  /// Returns false if there is nothing to send.
+  bool ComposeMessageBody(const RRS::Message& message,
+                          const std::vector<Peer>& toPeers, RawBytes& body);
+
+  /// Packs the messages into signed BATCH frames of at most
+  /// MAX_GOSSIP_BATCH_SIZE entries and MAX_GOSSIP_MSG_SIZE_IN_BYTES bytes
+  std::vector<SharedBytes> ComposeBatches(
+      const std::vector<RRS::Message>& messages,
+      const std::vector<Peer>& toPeers);
+
+  /// Handles an already verified rumor. Messages to send back to the sender
+  /// are appended to replies. Caller must hold m_mutex.
+  std::pair<bool, RawBytes> ProcessRumor(const RRS::Message::Type t,
+                                         int32_t round,
+                                         const RawBytes& message_wo_keysig,
+                                         const Peer& from, int peerId,
+                                         std::vector<RRS::Message>& replies);
+
   RawBytes GenerateGossipForwardMessage(const RawBytes& message);
 
+  /// Returns the rumor with the hash, or nullptr. Caller must hold m_mutex,
+  /// as for all of the rumor store below.
+  Rumor* FindRumor(const RawBytes& hash);
+
+  /// Returns the rumor with the id, or nullptr
+  Rumor* FindRumor(int64_t id, const RawBytes*& hash);
+
+  /// Returns the rumor with the hash, adding it if it is not known, and
+  /// gives it an id if it has none yet
+  Rumor& AddRumorHash(const RawBytes& hash, bool withId);
+
+  /// Stores the raw message of the rumor, stamped with the current
+  /// generation. Returns false if it was already there.
+  bool AddRawMessage(const RawBytes& hash, const RawBytes& rawMsg);
+
+  static uint64_t GetFootprint(const RawBytes& hash, const Rumor& rumor);
+
+  /// Starts a new generation, and expires the generations whose rumors are
+  /// all older than m_rawMessageExpiryInMs
+  void AdvanceGeneration();
+
+  /// Expires the oldest generation. Returns false if there is none to drop.
+  bool ExpireOldestGeneration();
+
+  /// Expires the oldest generations, the current one included if need be,
+  /// until bytes more fit under GOSSIP_RUMOR_STORE_MAX_BYTES and one more
+  /// rumor under GOSSIP_RUMOR_STORE_MAX_ENTRIES
+  void MakeRoom(uint64_t bytes);
+
+  /// Whether a rumor of rawSize bytes is announced by digest, that is its
+  /// hash followed by its size, and pulled from one announcer at a time
+  static bool IsDigestPulled(uint32_t rawSize);
+
+  /// Records that the peer announced the digest of the rumor, and pulls the
+  /// rumor if no pull is in flight
+  void DigestReceived(const RawBytes& hash, Rumor& rumor, uint32_t rawSize,
+                      int peerId);
+
+  /// Sends a PULL for the rumor to the announcer with the fewest digest
+  /// pulls in flight, if the budget of the round allows. Returns false if
+  /// nothing was sent.
+  bool PullDigest(Rumor& rumor);
+
+  /// Forgets the pull in flight for the rumor
+  void FinishPull(Rumor& rumor);
+
+  /// Refills the pull budget, and pulls again from another announcer the
+  /// rumors whose pull timed out. Called once a round.
+  void IssueDigestPulls();
+
  public:
   // CREATORS
   RumorManager();
@@ -102,6 +235,10 @@ class RumorManager {
                                           const RawBytes& message,
                                           const Peer& from);
 
+  /// Unpacks a BATCH frame and returns the rumors to be dispatched
+  std::vector<RawBytes> RumorBatchReceived(const RawBytes& message,
+                                           const Peer& from);
+
   void StartRounds();
   void StopRounds();
 
@@ -114,6 +251,10 @@ class RumorManager {
   void SendRumorToForeignPeers(const std::vector<Peer>& toForeignPeers,
                                const RawBytes& message);
 
+  void SendRumorToForeignPeers(
+      const std::deque<std::vector<Peer>>& toForeignPeerGroups,
+      const RawBytes& message);
+
   void PrintStatistics();
 
   void CleanUp();
@@ -122,8 +263,6 @@ class RumorManager {
       const RawBytes& message, const RRS::Message::Type& t, const Peer& from);
 
   void AppendKeyAndSignature(RawBytes& result, const RawBytes& messageToSig);
-  // CONST METHODS
-  const RumorIdRumorBimap& rumors() const;
 };
 
 #endif  //__RUMORMANAGER_H__
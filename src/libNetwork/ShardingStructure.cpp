@@ -0,0 +1,40 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ShardingStructure.h"
+
+using namespace std;
+
+ShardingStructure::ShardingStructure(DequeOfShard shards)
+    : m_shards(move(shards)) {
+  for (uint32_t shardId = 0; shardId < m_shards.size(); shardId++) {
+    const auto& shard = m_shards[shardId];
+    for (uint32_t index = 0; index < shard.size(); index++) {
+      m_positions.emplace(get<SHARD_NODE_PUBKEY>(shard[index]),
+                          Position{shardId, index});
+    }
+  }
+}
+
+bool ShardingStructure::Find(const PubKey& pubKey, Position& position) const {
+  const auto it = m_positions.find(pubKey);
+  if (it == m_positions.end()) {
+    return false;
+  }
+  position = it->second;
+  return true;
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __SHARDINGSTRUCTURE_H__
+#define __SHARDINGSTRUCTURE_H__
+
+#include <map>
+#include <memory>
+
+#include "ShardStruct.h"
+
+/// Immutable copy of the shards of a DS epoch, indexed by public key. Shared
+/// through ShardingStructurePtr, so that readers outside the DS epoch
+/// processing neither copy the shards nor hold m_mutexShards.
+class ShardingStructure {
+ public:
+  /// Where a node sits in the shards
+  struct Position {
+    uint32_t shardId;
+    uint32_t index;
+  };
+
+  explicit ShardingStructure(DequeOfShard shards);
+
+  const DequeOfShard& GetShards() const { return m_shards; }
+
+  size_t GetNumShards() const { return m_shards.size(); }
+
+  /// Returns the number of nodes over all the shards
+  size_t GetNumNodes() const { return m_positions.size(); }
+
+  /// Finds the shard of a node and its index within it
+  bool Find(const PubKey& pubKey, Position& position) const;
+
+ private:
+  const DequeOfShard m_shards;
+  std::map<PubKey, Position> m_positions;
+};
+
+using ShardingStructurePtr = std::shared_ptr<const ShardingStructure>;
+
+#endif  // __SHARDINGSTRUCTURE_H__
@@ -41,6 +41,7 @@
 #include "libNetwork/Blacklist.h"
 #include "libNetwork/Guard.h"
 #include "libPOW/pow.h"
+#include "libServer/WebSocketServer.h"
 #include "libUtils/BitVector.h"
 #include "libUtils/DataConversion.h"
 #include "libUtils/DetachedFunction.h"
@@ -50,6 +51,7 @@
 #include "libUtils/TimeLockedFunction.h"
 #include "libUtils/TimeUtils.h"
 #include "libUtils/TimestampVerifier.h"
+#include "libUtils/Tracing.h"
 
 using namespace std;
 using namespace boost::multiprecision;
@@ -119,7 +121,7 @@ bool Node::VerifyDSBlockCoSignature(const DSBlock& dsblock) {
   unsigned int index = 0;
   unsigned int count = 0;
 
-  const vector<bool>& B2 = dsblock.GetB2();
+  const BitVector& B2 = dsblock.GetB2();
   if (m_mediator.m_DSCommittee->size() != B2.size()) {
     LOG_CHECK_FAIL("Cosig size", B2.size(), m_mediator.m_DSCommittee->size());
     return false;
@@ -127,9 +129,10 @@ bool Node::VerifyDSBlockCoSignature(const DSBlock& dsblock) {
 
   // Generate the aggregated key
   vector<PubKey> keys;
+  keys.reserve(m_mediator.m_DSCommittee->size());
   for (auto const& kv : *m_mediator.m_DSCommittee) {
+    keys.emplace_back(kv.first);
     if (B2.at(index)) {
-      keys.emplace_back(kv.first);
       count++;
     }
     index++;
@@ -140,7 +143,7 @@ bool Node::VerifyDSBlockCoSignature(const DSBlock& dsblock) {
     return false;
   }
 
-  shared_ptr<PubKey> aggregatedKey = MultiSig::AggregatePubKeys(keys);
+  shared_ptr<PubKey> aggregatedKey = MultiSig::AggregatePubKeys(keys, B2);
   if (aggregatedKey == nullptr) {
     LOG_GENERAL(WARNING, "Aggregated key generation failed");
     return false;
@@ -148,7 +151,7 @@ bool Node::VerifyDSBlockCoSignature(const DSBlock& dsblock) {
 
   // Verify the collective signature
   bytes message;
-  if (!dsblock.GetHeader().Serialize(message, 0)) {
+  if (!dsblock.GetHeader().SerializeCached(message, 0)) {
     LOG_GENERAL(WARNING, "DSBlockHeader serialization failed");
     return false;
   }
@@ -157,8 +160,10 @@ bool Node::VerifyDSBlockCoSignature(const DSBlock& dsblock) {
   if (!MultiSig::GetInstance().MultiSigVerify(
           message, 0, message.size(), dsblock.GetCS2(), *aggregatedKey)) {
     LOG_GENERAL(WARNING, "Cosig verification failed");
-    for (auto& kv : keys) {
-      LOG_GENERAL(WARNING, kv);
+    for (unsigned int i = 0; i < keys.size(); i++) {
+      if (B2.at(i)) {
+        LOG_GENERAL(WARNING, keys.at(i));
+      }
     }
     return false;
   }
@@ -328,6 +333,7 @@ bool Node::ProcessVCDSBlocksMessage(const bytes& message,
                                     unsigned int cur_offset,
                                     [[gnu::unused]] const Peer& from) {
   LOG_MARKER();
+  TRACE_SPAN("DSBlock.Process", m_mediator.m_currentEpochNum);
   lock_guard<mutex> g(m_mutexDSBlock);
 
   if (!LOOKUP_NODE_MODE) {
@@ -477,6 +483,7 @@ bool Node::ProcessVCDSBlocksMessage(const bytes& message,
   }
 
   m_mediator.m_ds->m_shards = move(t_shards);
+  m_mediator.m_ds->PublishShardingStructure();
 
   m_myshardId = shardId;
   BlockStorage::GetBlockStorage().PutShardStructure(m_mediator.m_ds->m_shards,
@@ -487,6 +494,10 @@ bool Node::ProcessVCDSBlocksMessage(const bytes& message,
   // Add to block chain and Store the DS block to disk.
   StoreDSBlockToDisk(dsblock);
 
+  if (LOOKUP_NODE_MODE && ENABLE_WEBSOCKET) {
+    WebSocketServer::GetInstance().NotifyDSBlock(dsblock);
+  }
+
   BlockStorage::GetBlockStorage().ResetDB(BlockStorage::STATE_DELTA);
 
   m_proposedGasPrice =
@@ -510,6 +521,7 @@ bool Node::ProcessVCDSBlocksMessage(const bytes& message,
   m_mediator.UpdateDSBlockRand();  // Update the rand1 value for next PoW
   UpdateDSCommiteeComposition(*m_mediator.m_DSCommittee,
                               m_mediator.m_dsBlockChain.GetLastBlock());
+  m_mediator.PublishEpochContext();
 
   uint16_t lastBlockHash = 0;
   if (m_mediator.m_currentEpochNum > 1) {
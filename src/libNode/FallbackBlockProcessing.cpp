@@ -66,7 +66,7 @@ bool Node::VerifyFallbackBlockCoSignature(const FallbackBlock& fallbackblock) {
 
   uint32_t shard_id = fallbackblock.GetHeader().GetShardId();
 
-  const vector<bool>& B2 = fallbackblock.GetB2();
+  const BitVector& B2 = fallbackblock.GetB2();
   if (m_mediator.m_ds->m_shards[shard_id].size() != B2.size()) {
     LOG_GENERAL(WARNING,
                 "Mismatch: shard "
@@ -100,7 +100,7 @@ bool Node::VerifyFallbackBlockCoSignature(const FallbackBlock& fallbackblock) {
 
   // Verify the collective signature
   bytes message;
-  if (!fallbackblock.GetHeader().Serialize(message, 0)) {
+  if (!fallbackblock.GetHeader().SerializeCached(message, 0)) {
     LOG_GENERAL(WARNING, "FallbackBlockHeader serialization failed");
     return false;
   }
@@ -93,7 +93,7 @@ void Node::ProcessFallbackConsensusWhenDone() {
   }
 
   bytes message;
-  if (!m_pendingFallbackBlock->GetHeader().Serialize(message, 0)) {
+  if (!m_pendingFallbackBlock->GetHeader().SerializeCached(message, 0)) {
     LOG_GENERAL(WARNING, "FallbackBlockHeader serialization failed");
     return;
   }
@@ -222,6 +222,7 @@ void Node::ProcessFallbackConsensusWhenDone() {
   for (unsigned int i = 0; i <= m_myshardId; i++) {
     m_mediator.m_ds->m_shards.pop_front();
   }
+  m_mediator.m_ds->PublishShardingStructure();
 
   auto composeFallbackBlockMessageForSender =
       [this](bytes& fallback_message) -> bool {
@@ -25,6 +25,7 @@
 #include "libUtils/DataConversion.h"
 #include "libUtils/DetachedFunction.h"
 #include "libUtils/Logger.h"
+#include "libUtils/Scheduler.h"
 #include "libUtils/TimestampVerifier.h"
 
 using namespace std;
@@ -300,63 +301,69 @@ void Node::FallbackTimerLaunch() {
   m_fallbackStarted = false;
 
   auto func = [this]() -> void {
-    while (m_runFallback) {
-      this_thread::sleep_for(chrono::seconds(FALLBACK_CHECK_INTERVAL));
+    if (!m_runFallback) {
+      Scheduler::GetInstance().Cancel(m_fallbackTimerHandle);
+      return;
+    }
+
+    if (m_mediator.m_ds->m_mode != DirectoryService::IDLE) {
+      Scheduler::GetInstance().Cancel(m_fallbackTimerHandle);
+      m_fallbackTimerLaunched = false;
+      return;
+    }
 
-      if (m_mediator.m_ds->m_mode != DirectoryService::IDLE) {
-        m_fallbackTimerLaunched = false;
+    lock_guard<mutex> g(m_mutexFallbackTimer);
+
+    if (m_fallbackStarted) {
+      if (LOOKUP_NODE_MODE) {
+        LOG_GENERAL(WARNING,
+                    "Node::FallbackTimerLaunch when started is "
+                    "true not expected to be called from "
+                    "LookUp node.");
+        Scheduler::GetInstance().Cancel(m_fallbackTimerHandle);
         return;
       }
 
-      lock_guard<mutex> g(m_mutexFallbackTimer);
+      if (m_fallbackTimer >= FALLBACK_INTERVAL_STARTED) {
+        UpdateFallbackConsensusLeader();
 
-      if (m_fallbackStarted) {
-        if (LOOKUP_NODE_MODE) {
-          LOG_GENERAL(WARNING,
-                      "Node::FallbackTimerLaunch when started is "
-                      "true not expected to be called from "
-                      "LookUp node.");
-          return;
-        }
+        auto func = [this]() -> void { RunConsensusOnFallback(); };
+        DetachedFunction(1, func);
 
-        if (m_fallbackTimer >= FALLBACK_INTERVAL_STARTED) {
-          UpdateFallbackConsensusLeader();
+        m_fallbackTimer = 0;
+      }
+    } else {
+      bool runConsensus = false;
 
+      if (!LOOKUP_NODE_MODE) {
+        if (m_fallbackTimer >=
+            (FALLBACK_INTERVAL_WAITING * (m_myshardId + 1))) {
           auto func = [this]() -> void { RunConsensusOnFallback(); };
           DetachedFunction(1, func);
-
+          m_fallbackStarted = true;
+          runConsensus = true;
           m_fallbackTimer = 0;
-        }
-      } else {
-        bool runConsensus = false;
-
-        if (!LOOKUP_NODE_MODE) {
-          if (m_fallbackTimer >=
-              (FALLBACK_INTERVAL_WAITING * (m_myshardId + 1))) {
-            auto func = [this]() -> void { RunConsensusOnFallback(); };
-            DetachedFunction(1, func);
-            m_fallbackStarted = true;
-            runConsensus = true;
-            m_fallbackTimer = 0;
-            m_justDidFallback = true;
-          }
-        }
-
-        if (m_fallbackTimer >= FALLBACK_INTERVAL_WAITING &&
-            m_state != WAITING_FALLBACKBLOCK &&
-            m_state != FALLBACK_CONSENSUS_PREP &&
-            m_state != FALLBACK_CONSENSUS && !runConsensus) {
-          SetState(WAITING_FALLBACKBLOCK);
           m_justDidFallback = true;
-          cv_fallbackBlock.notify_all();
         }
       }
 
-      m_fallbackTimer += FALLBACK_CHECK_INTERVAL;
+      if (m_fallbackTimer >= FALLBACK_INTERVAL_WAITING &&
+          m_state != WAITING_FALLBACKBLOCK &&
+          m_state != FALLBACK_CONSENSUS_PREP &&
+          m_state != FALLBACK_CONSENSUS && !runConsensus) {
+        SetState(WAITING_FALLBACKBLOCK);
+        m_justDidFallback = true;
+        cv_fallbackBlock.notify_all();
+      }
     }
+
+    m_fallbackTimer += FALLBACK_CHECK_INTERVAL;
   };
 
-  DetachedFunction(1, func);
+  // Checked every interval, on the shared scheduler rather than a thread that
+  // sleeps for the lifetime of the node
+  m_fallbackTimerHandle = Scheduler::GetInstance().SchedulePeriodically(
+      func, FALLBACK_CHECK_INTERVAL * 1000);
   m_fallbackTimerLaunched = true;
 }
 
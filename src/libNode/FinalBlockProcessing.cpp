@@ -15,7 +15,9 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 #include <boost/multiprecision/cpp_int.hpp>
@@ -36,24 +38,31 @@
 #include "libCrypto/Sha2.h"
 #include "libData/AccountData/Account.h"
 #include "libData/AccountData/AccountStore.h"
+#include "libData/AccountData/ContractProfiler.h"
 #include "libData/AccountData/Transaction.h"
 #include "libData/AccountData/TransactionReceipt.h"
+#include "libLookup/Lookup.h"
 #include "libMediator/Mediator.h"
 #include "libMessage/Messenger.h"
 #include "libNetwork/Blacklist.h"
 #include "libNetwork/Guard.h"
 #include "libPOW/pow.h"
+#include "libPersistence/ContractStorage.h"
 #include "libServer/Server.h"
+#include "libServer/WebSocketServer.h"
 #include "libUtils/BitVector.h"
 #include "libUtils/DataConversion.h"
 #include "libUtils/DetachedFunction.h"
 #include "libUtils/HashUtils.h"
+#include "libUtils/JoinableFunction.h"
 #include "libUtils/Logger.h"
 #include "libUtils/RootComputation.h"
 #include "libUtils/SanityChecks.h"
+#include "libUtils/Scheduler.h"
 #include "libUtils/TimeLockedFunction.h"
 #include "libUtils/TimeUtils.h"
 #include "libUtils/TimestampVerifier.h"
+#include "libUtils/Tracing.h"
 
 using namespace std;
 using namespace boost::multiprecision;
@@ -71,8 +80,30 @@ void Node::StoreFinalBlock(const TxBlock& txBlock) {
   // Store Tx Block to disk
   bytes serializedTxBlock;
   txBlock.Serialize(serializedTxBlock, 0);
-  BlockStorage::GetBlockStorage().PutTxBlock(txBlock.GetHeader().GetBlockNum(),
-                                             serializedTxBlock);
+  const uint64_t blockNum = txBlock.GetHeader().GetBlockNum();
+  // The state delta, and the state in a vacuous epoch, were stored or queued
+  // before
+  QueueStorage([blockNum, serializedTxBlock = move(serializedTxBlock)]() {
+    if (!BlockStorage::GetBlockStorage().PutTxBlock(blockNum,
+                                                    serializedTxBlock)) {
+      LOG_GENERAL(WARNING, "PutTxBlock failed for block " << blockNum);
+      return;
+    }
+    BlockStorage::GetBlockStorage().CommitEpoch(blockNum);
+    BlockStorage::GetBlockStorage().LogReadCacheStats();
+    Contract::ContractStorage::GetContractStorage().LogCodeCacheStats();
+  });
+  if (LOOKUP_NODE_MODE) {
+    m_mediator.m_lookup->LogBlockResponseCacheStats();
+  }
+  PruneHistory(txBlock.GetHeader().GetBlockNum());
+
+  if (ENABLE_CONTRACT_PROFILING && CONTRACT_PROFILING_DUMP_INTERVAL_IN_EPOCHS &&
+      txBlock.GetHeader().GetBlockNum() %
+              CONTRACT_PROFILING_DUMP_INTERVAL_IN_EPOCHS ==
+          0) {
+    ContractProfiler::GetInstance().Dump();
+  }
 
   m_mediator.IncreaseEpochNum();
 
@@ -93,6 +124,48 @@ void Node::StoreFinalBlock(const TxBlock& txBlock) {
       << "] RECV");
 }
 
+void Node::PruneHistory(const uint64_t& txBlockNum) {
+  // Once a DS epoch, at its vacuous epoch
+  if (ARCHIVAL_LOOKUP || (txBlockNum + 1) % NUM_FINAL_BLOCK_PER_POW != 0) {
+    return;
+  }
+
+  unsigned int stateDeltaRetention = 0;
+  unsigned int txBodyRetention = 0;
+  if (LOOKUP_NODE_MODE) {
+    // Lookups serve the state deltas uploaded for incremental db too
+    stateDeltaRetention = STATEDELTA_RETENTION_DS_EPOCHS_LOOKUP;
+    if (stateDeltaRetention > 0) {
+      stateDeltaRetention =
+          max(stateDeltaRetention, INCRDB_DSNUMS_WITH_STATEDELTAS);
+    }
+    txBodyRetention = TXBODY_RETENTION_DS_EPOCHS_LOOKUP;
+  } else if (m_mediator.m_ds->m_mode != DirectoryService::IDLE) {
+    stateDeltaRetention = STATEDELTA_RETENTION_DS_EPOCHS_DS;
+  } else {
+    stateDeltaRetention = STATEDELTA_RETENTION_DS_EPOCHS_SHARD;
+  }
+
+  // First block of the oldest DS epoch kept, or 0 to keep all
+  const uint64_t numDSEpochs = txBlockNum / NUM_FINAL_BLOCK_PER_POW + 1;
+  auto keepFrom = [numDSEpochs](unsigned int retention) -> uint64_t {
+    return (retention == 0 || numDSEpochs <= retention)
+               ? 0
+               : (numDSEpochs - retention) * NUM_FINAL_BLOCK_PER_POW;
+  };
+  const uint64_t stateDeltaBelow = keepFrom(stateDeltaRetention);
+  const uint64_t txBodyBelow = keepFrom(txBodyRetention);
+
+  if (stateDeltaBelow == 0 && txBodyBelow == 0) {
+    return;
+  }
+
+  auto func = [stateDeltaBelow, txBodyBelow]() mutable -> void {
+    BlockStorage::GetBlockStorage().PruneHistory(stateDeltaBelow, txBodyBelow);
+  };
+  DetachedFunction(1, func);
+}
+
 bool Node::IsMicroBlockTxRootHashInFinalBlock(
     const MBnForwardedTxnEntry& entry, bool& isEveryMicroBlockAvailable) {
   LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
@@ -228,7 +301,7 @@ bool Node::VerifyFinalBlockCoSignature(const TxBlock& txblock) {
   unsigned int index = 0;
   unsigned int count = 0;
 
-  const vector<bool>& B2 = txblock.GetB2();
+  const BitVector& B2 = txblock.GetB2();
   if (m_mediator.m_DSCommittee->size() != B2.size()) {
     LOG_CHECK_FAIL("Cosig size", B2.size(), m_mediator.m_DSCommittee->size());
     return false;
@@ -257,7 +330,7 @@ bool Node::VerifyFinalBlockCoSignature(const TxBlock& txblock) {
 
   // Verify the collective signature
   bytes message;
-  if (!txblock.GetHeader().Serialize(message, 0)) {
+  if (!txblock.GetHeader().SerializeCached(message, 0)) {
     LOG_GENERAL(WARNING, "TxBlockHeader serialization failed");
     return false;
   }
@@ -426,7 +499,7 @@ void Node::CallActOnFinalblock() {
   };
 
   auto sendMbnFowardTxnToShardNodes =
-      []([[gnu::unused]] const bytes& message,
+      []([[gnu::unused]] const SharedBytes& message,
          [[gnu::unused]] const DequeOfShard& shards,
          [[gnu::unused]] const unsigned int& my_shards_lo,
          [[gnu::unused]] const unsigned int& my_shards_hi) -> void {};
@@ -474,14 +547,30 @@ bool Node::ComposeMBnForwardTxnMessageForSender(bytes& mb_txns_message) {
   }
 
   // Transaction body sharing
-  mb_txns_message = {MessageType::NODE,
-                     NodeInstructionType::MBNFORWARDTRANSACTION};
-
-  if (!Messenger::SetNodeMBnForwardTransaction(
-          mb_txns_message, MessageOffset::BODY, *m_microblock, txns_to_send)) {
-    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
-              "Messenger::SetNodeMBnForwardTransaction failed.");
-    return false;
+  if (ENABLE_COMPACT_MBNFORWARD) {
+    // Lookups already hold most bodies, so send only the receipts and let
+    // them ask for whatever they cannot find
+    mb_txns_message = {MessageType::NODE,
+                       NodeInstructionType::MBNFORWARDTRANSACTIONCOMPACT};
+
+    if (!Messenger::SetNodeMBnForwardTransactionCompact(
+            mb_txns_message, MessageOffset::BODY, *m_microblock, txns_to_send,
+            m_mediator.m_selfPeer.m_listenPortHost)) {
+      LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+                "Messenger::SetNodeMBnForwardTransactionCompact failed.");
+      return false;
+    }
+  } else {
+    mb_txns_message = {MessageType::NODE,
+                       NodeInstructionType::MBNFORWARDTRANSACTION};
+
+    if (!Messenger::SetNodeMBnForwardTransaction(
+            mb_txns_message, MessageOffset::BODY, *m_microblock,
+            txns_to_send)) {
+      LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+                "Messenger::SetNodeMBnForwardTransaction failed.");
+      return false;
+    }
   }
 
   LOG_STATE(
@@ -535,6 +624,7 @@ bool Node::ProcessFinalBlockCore(const bytes& message, unsigned int offset,
                                  [[gnu::unused]] const Peer& from,
                                  bool buffered) {
   LOG_MARKER();
+  TRACE_SPAN("FinalBlock.Process", m_mediator.m_currentEpochNum);
 
   uint64_t dsBlockNumber = 0;
   uint32_t consensusID = 0;
@@ -552,19 +642,22 @@ bool Node::ProcessFinalBlockCore(const bytes& message, unsigned int offset,
     if (m_mediator.m_lookup->GetSyncType() != SyncType::NO_SYNC) {
       // Buffer the Final Block
       lock_guard<mutex> g(m_mutexSeedTxnBlksBuffer);
-      m_seedTxnBlksBuffer.push_back(message);
+      const unsigned int dropped = m_seedTxnBlksBuffer.Push(
+          m_mediator.m_currentEpochNum, message, message.size());
+      if (dropped > 0) {
+        LOG_GENERAL(WARNING, "FBLK buffer over budget, dropped "
+                                 << dropped << " oldest FBLKS");
+      }
       LOG_GENERAL(INFO, "Seed not synced, buffered this FBLK");
       return false;
     } else {
       // If seed node is synced and have buffered txn blocks
       lock_guard<mutex> g(m_mutexSeedTxnBlksBuffer);
-      if (!m_seedTxnBlksBuffer.empty()) {
+      if (!m_seedTxnBlksBuffer.Empty()) {
         LOG_GENERAL(INFO, "Seed synced, processing buffered FBLKS");
-        for (const auto& txnblk : m_seedTxnBlksBuffer) {
-          ProcessFinalBlockCore(txnblk, offset, Peer(), true);
+        for (const auto& txnblk : m_seedTxnBlksBuffer.TakeAll()) {
+          ProcessFinalBlockCore(txnblk.second, offset, Peer(), true);
         }
-        // clear the buffer since all buffered ones are checked and processed
-        m_seedTxnBlksBuffer.clear();
       }
     }
   }
@@ -705,8 +798,12 @@ bool Node::ProcessFinalBlockCore(const bytes& message, unsigned int offset,
     }
   }
 
-  BlockStorage::GetBlockStorage().PutStateDelta(
-      txBlock.GetHeader().GetBlockNum(), stateDelta);
+  const uint64_t blockNum = txBlock.GetHeader().GetBlockNum();
+  QueueStorage([blockNum, stateDelta]() {
+    if (!BlockStorage::GetBlockStorage().PutStateDelta(blockNum, stateDelta)) {
+      LOG_GENERAL(WARNING, "PutStateDelta failed for block " << blockNum);
+    }
+  });
 
   if (!LOOKUP_NODE_MODE &&
       (!CheckStateRoot(txBlock) || m_doRejoinAtStateRoot)) {
@@ -716,12 +813,9 @@ bool Node::ProcessFinalBlockCore(const bytes& message, unsigned int offset,
     return false;
   }
 
-  auto resumeBlackList = []() mutable -> void {
-    this_thread::sleep_for(chrono::seconds(RESUME_BLACKLIST_DELAY_IN_SECONDS));
-    Blacklist::GetInstance().Enable(true);
-  };
-
-  DetachedFunction(1, resumeBlackList);
+  Scheduler::GetInstance().ScheduleAfter(
+      []() -> void { Blacklist::GetInstance().Enable(true); },
+      RESUME_BLACKLIST_DELAY_IN_SECONDS * 1000);
 
   if (!isVacuousEpoch) {
     if (!LoadUnavailableMicroBlockHashes(
@@ -740,6 +834,9 @@ bool Node::ProcessFinalBlockCore(const bytes& message, unsigned int offset,
     // Remove because shard nodes will be shuffled in next epoch.
     CleanMicroblockConsensusBuffer();
 
+    // The state on disk goes with the deltas and blocks before it
+    WaitForStoragePipeline();
+
     if (!AccountStore::GetInstance().MoveUpdatesToDisk(
             ENABLE_REPOPULATE && (m_mediator.m_dsBlockChain.GetLastBlock()
                                           .GetHeader()
@@ -760,6 +857,13 @@ bool Node::ProcessFinalBlockCore(const bytes& message, unsigned int offset,
         << "] FINISH WRITE STATE TO DISK");
   }
 
+  if (LOOKUP_NODE_MODE) {
+    m_mediator.m_lookup->PushTxBlockToSubscribers(txBlock, stateDelta);
+    if (ENABLE_WEBSOCKET) {
+      WebSocketServer::GetInstance().NotifyTxBlock(txBlock);
+    }
+  }
+
   // m_mediator.HeartBeatPulse();
 
   if (txBlock.GetMicroBlockInfos().size() == 1) {
@@ -862,16 +966,74 @@ bool Node::ProcessStateDeltaFromFinalBlock(
 void Node::CommitForwardedTransactions(const MBnForwardedTxnEntry& entry) {
   LOG_MARKER();
 
-  for (const auto& twr : entry.m_transactions) {
-    if (LOOKUP_NODE_MODE) {
-      Server::AddToRecentTransactions(twr.GetTransaction().GetTranID());
+  const auto& transactions = entry.m_transactions;
+
+  // The bodies are serialized across threads, then put in one batch along
+  // with the micro block
+  vector<bytes> serializedTxBodies(transactions.size());
+  const unsigned int numThreads = max(
+      1U, min<unsigned int>(TXN_PROCESSING_NUM_THREADS, transactions.size()));
+  if (numThreads > 1) {
+    atomic<unsigned int> next{0};
+    auto worker = [&]() -> void {
+      for (unsigned int i = next++; i < transactions.size(); i = next++) {
+        transactions[i].Serialize(serializedTxBodies[i], 0);
+      }
+    };
+    JoinableFunction joinableFunc(numThreads, worker);
+  } else {
+    for (unsigned int i = 0; i < transactions.size(); i++) {
+      transactions[i].Serialize(serializedTxBodies[i], 0);
     }
+  }
 
-    // Store TxBody to disk
-    bytes serializedTxBody;
-    twr.Serialize(serializedTxBody, 0);
-    BlockStorage::GetBlockStorage().PutTxBody(twr.GetTransaction().GetTranID(),
-                                              serializedTxBody);
+  EpochWrites writes;
+  if (!m_mediator.m_lookup->AddMicroBlockToWrites(entry.m_microBlock,
+                                                  writes)) {
+    LOG_GENERAL(WARNING, "Failed to add micro block "
+                             << entry.m_microBlock.GetBlockHash());
+  }
+
+  vector<TxnHash> tranHashes;
+  tranHashes.reserve(transactions.size());
+  EventBloom eventBloom;
+  for (unsigned int i = 0; i < transactions.size(); i++) {
+    const auto& twr = transactions[i];
+    tranHashes.emplace_back(twr.GetTransaction().GetTranID());
+    eventBloom |= twr.GetTransactionReceipt().GetEventBloom();
+
+    writes.AddTxBody(twr.GetTransaction().GetTranID(), serializedTxBodies[i]);
+
+    if (LOOKUP_NODE_MODE && ENABLE_TXN_ADDRESS_INDEX) {
+      const Transaction& tx = twr.GetTransaction();
+      const uint64_t& epochNum = entry.m_microBlock.GetHeader().GetEpochNum();
+      writes.AddTxnAddressIndex(tx.GetSenderAddr(), epochNum, tx.GetTranID());
+      // Contract creations have no recipient to index
+      if (tx.GetToAddr() != NullAddress &&
+          tx.GetToAddr() != tx.GetSenderAddr()) {
+        writes.AddTxnAddressIndex(tx.GetToAddr(), epochNum, tx.GetTranID());
+      }
+    }
+  }
+  if (LOOKUP_NODE_MODE && ENABLE_EVENT_BLOOM_INDEX && !eventBloom.Empty()) {
+    writes.AddEventBloom(entry.m_microBlock.GetHeader().GetEpochNum(),
+                         entry.m_microBlock.GetHeader().GetShardId(),
+                         eventBloom);
+  }
+  if (LOOKUP_NODE_MODE) {
+    // Also packed in one record, for other lookups to fetch whole
+    bytes microBlock;
+    entry.m_microBlock.Serialize(microBlock, 0);
+    writes.AddMicroBlockTxns(entry.m_microBlock.GetHeader().GetEpochNum(),
+                             entry.m_microBlock.GetHeader().GetShardId(),
+                             microBlock, serializedTxBodies);
+  }
+  BlockStorage::GetBlockStorage().PutEpochWrites(writes);
+  if (LOOKUP_NODE_MODE) {
+    Server::AddToRecentTransactions(tranHashes);
+  }
+  if (LOOKUP_NODE_MODE && ENABLE_WEBSOCKET) {
+    WebSocketServer::GetInstance().NotifyTxns(entry.m_transactions);
   }
   LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
             "Proceessed " << entry.m_transactions.size() << " of txns.");
@@ -921,6 +1083,18 @@ void Node::DeleteEntryFromFwdingAssgnAndMissingBodyCountMap(
   }
 }
 
+// Approximate memory held by a buffered entry, counted against its budget
+static uint64_t GetMBnForwardedTxnEntryBytes(
+    const MBnForwardedTxnEntry& entry) {
+  uint64_t bytes = sizeof(entry) + entry.m_microBlock.GetTranHashes().size() *
+                                       sizeof(TxnHash);
+  for (const auto& twr : entry.m_transactions) {
+    bytes += sizeof(twr) + twr.GetTransaction().GetCode().size() +
+             twr.GetTransaction().GetData().size();
+  }
+  return bytes;
+}
+
 bool Node::ProcessMBnForwardTransaction(const bytes& message,
                                         unsigned int cur_offset,
                                         [[gnu::unused]] const Peer& from) {
@@ -941,6 +1115,11 @@ bool Node::ProcessMBnForwardTransaction(const bytes& message,
     return false;
   }
 
+  return ProcessMBnForwardedTxnEntry(entry, from);
+}
+
+bool Node::ProcessMBnForwardedTxnEntry(const MBnForwardedTxnEntry& entry,
+                                       const Peer& from) {
   // Verify Microblock agains forwarded txns
   // BlockHash
   BlockHash temp_blockHash = entry.m_microBlock.GetHeader().GetMyHash();
@@ -987,8 +1166,13 @@ bool Node::ProcessMBnForwardTransaction(const bytes& message,
   if (m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum() <
       entry.m_microBlock.GetHeader().GetEpochNum()) {
     lock_guard<mutex> g(m_mutexMBnForwardedTxnBuffer);
-    m_mbnForwardedTxnBuffer[entry.m_microBlock.GetHeader().GetEpochNum()]
-        .push_back(entry);
+    const unsigned int dropped = m_mbnForwardedTxnBuffer.Push(
+        entry.m_microBlock.GetHeader().GetEpochNum(), entry,
+        GetMBnForwardedTxnEntryBytes(entry));
+    if (dropped > 0) {
+      LOG_GENERAL(WARNING, "MBnForwardedTxn buffer over budget, dropped "
+                               << dropped << " oldest entries");
+    }
 
     return true;
   }
@@ -996,6 +1180,77 @@ bool Node::ProcessMBnForwardTransaction(const bytes& message,
   return ProcessMBnForwardTransactionCore(entry);
 }
 
+bool Node::CommitFetchedMicroBlockTxns(const MBnForwardedTxnEntry& entry) {
+  if (!LOOKUP_NODE_MODE) {
+    LOG_GENERAL(WARNING,
+                "Node::CommitFetchedMicroBlockTxns not expected to be called "
+                "from Normal node.");
+    return false;
+  }
+
+  const MicroBlock& microBlock = entry.m_microBlock;
+  const auto& header = microBlock.GetHeader();
+
+  if (header.GetMyHash() != microBlock.GetBlockHash()) {
+    LOG_CHECK_FAIL("Block hash", microBlock.GetBlockHash(),
+                   header.GetMyHash());
+    return false;
+  }
+
+  TxBlockSharedPtr txBlock;
+  if (!BlockStorage::GetBlockStorage().GetTxBlock(header.GetEpochNum(),
+                                                  txBlock)) {
+    LOG_GENERAL(WARNING, "No Tx block " << header.GetEpochNum()
+                                        << " to check micro block against");
+    return false;
+  }
+  const auto& infos = txBlock->GetMicroBlockInfos();
+  if (none_of(infos.begin(), infos.end(),
+              [&microBlock](const MicroBlockInfo& info) {
+                return info.m_microBlockHash == microBlock.GetBlockHash() &&
+                       info.m_shardId == microBlock.GetHeader().GetShardId();
+              })) {
+    LOG_GENERAL(WARNING, "Micro block " << microBlock.GetBlockHash()
+                                        << " is not in Tx block "
+                                        << header.GetEpochNum());
+    return false;
+  }
+
+  // The stored txn hashes come from the micro block, so they must be those
+  // of the txns
+  const auto& tranHashes = microBlock.GetTranHashes();
+  if (tranHashes.size() != entry.m_transactions.size()) {
+    LOG_CHECK_FAIL("Txn count", tranHashes.size(),
+                   entry.m_transactions.size());
+    return false;
+  }
+  for (unsigned int i = 0; i < tranHashes.size(); i++) {
+    if (tranHashes[i] != entry.m_transactions[i].GetTransaction().GetTranID()) {
+      LOG_CHECK_FAIL("Txn hash", tranHashes[i],
+                     entry.m_transactions[i].GetTransaction().GetTranID());
+      return false;
+    }
+  }
+
+  const TxnHash txnHash = ComputeRoot(entry.m_transactions);
+  if (txnHash != header.GetTxRootHash()) {
+    LOG_CHECK_FAIL("Txn root hash", header.GetTxRootHash(), txnHash);
+    return false;
+  }
+
+  const TxnHash txReceiptHash =
+      TransactionWithReceipt::ComputeTransactionReceiptsHash(
+          entry.m_transactions);
+  if (txReceiptHash != header.GetTranReceiptHash()) {
+    LOG_CHECK_FAIL("Txn receipt hash", header.GetTranReceiptHash(),
+                   txReceiptHash);
+    return false;
+  }
+
+  CommitForwardedTransactions(entry);
+  return true;
+}
+
 bool Node::ProcessMBnForwardTransactionCore(const MBnForwardedTxnEntry& entry) {
   if (!LOOKUP_NODE_MODE) {
     LOG_GENERAL(WARNING,
@@ -1018,8 +1273,6 @@ bool Node::ProcessMBnForwardTransactionCore(const MBnForwardedTxnEntry& entry) {
       return false;
     }
 
-    m_mediator.m_lookup->AddMicroBlockToStorage(entry.m_microBlock);
-
     CommitForwardedTransactions(entry);
 
     LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
@@ -1044,6 +1297,200 @@ bool Node::ProcessMBnForwardTransactionCore(const MBnForwardedTxnEntry& entry) {
   return true;
 }
 
+bool Node::BuildCompactMBnForwardEntry(const CompactMBnForwardEntry& compact,
+                                       MBnForwardedTxnEntry& entry) {
+  const auto& tranHashes = compact.m_microBlock.GetTranHashes();
+
+  entry.m_microBlock = compact.m_microBlock;
+  entry.m_transactions.clear();
+  entry.m_transactions.reserve(tranHashes.size());
+
+  for (unsigned int i = 0; i < tranHashes.size(); i++) {
+    auto it = compact.m_transactions.find(tranHashes.at(i));
+    if (it == compact.m_transactions.end()) {
+      return false;
+    }
+    entry.m_transactions.emplace_back(it->second, compact.m_receipts.at(i));
+  }
+
+  return true;
+}
+
+bool Node::ProcessMBnForwardTransactionCompact(const bytes& message,
+                                               unsigned int offset,
+                                               const Peer& from) {
+  if (!LOOKUP_NODE_MODE) {
+    LOG_GENERAL(WARNING,
+                "Node::ProcessMBnForwardTransactionCompact not expected to be "
+                "called from Normal node.");
+    return true;
+  }
+
+  LOG_MARKER();
+
+  CompactMBnForwardEntry compact;
+  uint32_t listenPort = 0;
+
+  if (!Messenger::GetNodeMBnForwardTransactionCompact(
+          message, offset, compact.m_microBlock, compact.m_receipts,
+          listenPort)) {
+    LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+              "Messenger::GetNodeMBnForwardTransactionCompact failed.");
+    return false;
+  }
+
+  const auto& tranHashes = compact.m_microBlock.GetTranHashes();
+  if (compact.m_receipts.size() != tranHashes.size()) {
+    LOG_CHECK_FAIL("Receipts count", tranHashes.size(),
+                   compact.m_receipts.size());
+    return false;
+  }
+
+  const BlockHash mbHash = compact.m_microBlock.GetBlockHash();
+  const uint64_t mbEpochNum = compact.m_microBlock.GetHeader().GetEpochNum();
+  vector<TxnHash> missingTxnHashes;
+
+  {
+    lock_guard<mutex> g(m_mutexCompactMBnForwardBuffer);
+
+    // Several shard nodes forward the same microblock, one fetch is enough
+    if (m_compactMBnForwardBuffer.find(mbHash) !=
+        m_compactMBnForwardBuffer.end()) {
+      LOG_GENERAL(INFO, "Already fetching missing txns of microblock "
+                            << mbHash << ", ignore forward from " << from);
+      return true;
+    }
+
+    for (const auto& tranHash : tranHashes) {
+      Transaction txn;
+      if (m_mediator.m_lookup->GetDispatchedTxn(tranHash, txn)) {
+        compact.m_transactions.emplace(tranHash, txn);
+      } else {
+        missingTxnHashes.emplace_back(tranHash);
+      }
+    }
+
+    LOG_GENERAL(INFO, "[SendMBnTXBOD] Compact forward from "
+                          << from << " MBHash: " << mbHash << " Txns: "
+                          << tranHashes.size()
+                          << " Missing: " << missingTxnHashes.size());
+
+    if (!missingTxnHashes.empty()) {
+      for (auto it = m_compactMBnForwardBuffer.begin();
+           it != m_compactMBnForwardBuffer.end();) {
+        if (it->second.m_microBlock.GetHeader().GetEpochNum() +
+                COMPACT_MBNFORWARD_CACHE_EPOCHS <=
+            m_mediator.m_currentEpochNum) {
+          LOG_GENERAL(WARNING, "Missing txns of microblock "
+                                   << it->first << " never arrived");
+          it = m_compactMBnForwardBuffer.erase(it);
+        } else {
+          ++it;
+        }
+      }
+      m_compactMBnForwardBuffer.emplace(mbHash, move(compact));
+    }
+  }
+
+  if (missingTxnHashes.empty()) {
+    MBnForwardedTxnEntry entry;
+    if (!BuildCompactMBnForwardEntry(compact, entry)) {
+      return false;
+    }
+    return ProcessMBnForwardedTxnEntry(entry, from);
+  }
+
+  // Fetch the remaining bodies through the missing txn path of the sender
+  bytes request = {MessageType::NODE,
+                   NodeInstructionType::MISSINGTXNREQUEST};
+
+  if (!Messenger::SetNodeMissingTxnsErrorMsg(
+          request, MessageOffset::BODY, missingTxnHashes, mbEpochNum,
+          m_mediator.m_selfPeer.m_listenPortHost)) {
+    LOG_GENERAL(WARNING, "Messenger::SetNodeMissingTxnsErrorMsg failed");
+    lock_guard<mutex> g(m_mutexCompactMBnForwardBuffer);
+    m_compactMBnForwardBuffer.erase(mbHash);
+    return false;
+  }
+
+  P2PComm::GetInstance().SendMessage(Peer(from.m_ipAddress, listenPort),
+                                     request);
+
+  return true;
+}
+
+bool Node::ProcessCompactMBnForwardMissingTxn(const bytes& message,
+                                              unsigned int offset,
+                                              const Peer& from) {
+  if (!LOOKUP_NODE_MODE) {
+    LOG_GENERAL(WARNING,
+                "Node::ProcessCompactMBnForwardMissingTxn not expected to be "
+                "called from Normal node.");
+    return true;
+  }
+
+  LOG_MARKER();
+
+  unsigned int cur_offset = offset;
+
+  auto msgBlockNum =
+      Serializable::GetNumber<uint64_t>(message, cur_offset, sizeof(uint64_t));
+  cur_offset += sizeof(uint64_t);
+
+  std::vector<Transaction> txns;
+  if (!Messenger::GetTransactionArray(message, cur_offset, txns)) {
+    LOG_GENERAL(WARNING, "Messenger::GetTransactionArray failed.");
+    return false;
+  }
+
+  unordered_map<TxnHash, Transaction> received;
+  for (const auto& txn : txns) {
+    received.emplace(txn.GetTranID(), txn);
+  }
+
+  vector<MBnForwardedTxnEntry> completed;
+
+  {
+    lock_guard<mutex> g(m_mutexCompactMBnForwardBuffer);
+
+    for (auto it = m_compactMBnForwardBuffer.begin();
+         it != m_compactMBnForwardBuffer.end();) {
+      auto& compact = it->second;
+      if (compact.m_microBlock.GetHeader().GetEpochNum() != msgBlockNum) {
+        ++it;
+        continue;
+      }
+
+      for (const auto& tranHash : compact.m_microBlock.GetTranHashes()) {
+        auto found = received.find(tranHash);
+        if (found != received.end()) {
+          compact.m_transactions.emplace(tranHash, found->second);
+        }
+      }
+
+      completed.emplace_back();
+      if (BuildCompactMBnForwardEntry(compact, completed.back())) {
+        it = m_compactMBnForwardBuffer.erase(it);
+      } else {
+        completed.pop_back();
+        ++it;
+      }
+    }
+  }
+
+  LOG_GENERAL(INFO, "Received " << txns.size() << " missing txns of epoch "
+                                << msgBlockNum << " from " << from
+                                << ", completed " << completed.size()
+                                << " microblocks");
+
+  bool result = true;
+  for (const auto& entry : completed) {
+    result = ProcessMBnForwardedTxnEntry(entry, from) && result;
+  }
+
+  return result;
+}
+
 void Node::CommitMBnForwardedTransactionBuffer() {
   if (!LOOKUP_NODE_MODE) {
     LOG_GENERAL(WARNING,
@@ -1056,14 +1503,10 @@ void Node::CommitMBnForwardedTransactionBuffer() {
 
   lock_guard<mutex> g(m_mutexMBnForwardedTxnBuffer);
 
-  for (auto it = m_mbnForwardedTxnBuffer.begin();
-       it != m_mbnForwardedTxnBuffer.end();) {
-    if (it->first <=
+  for (const auto& entry : m_mbnForwardedTxnBuffer.TakeAll()) {
+    if (entry.first <=
         m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum()) {
-      for (const auto& entry : it->second) {
-        ProcessMBnForwardTransactionCore(entry);
-      }
+      ProcessMBnForwardTransactionCore(entry.second);
     }
-    it = m_mbnForwardedTxnBuffer.erase(it);
   }
 }
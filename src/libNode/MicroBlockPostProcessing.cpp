@@ -48,6 +48,7 @@
 #include "libUtils/SanityChecks.h"
 #include "libUtils/TimeLockedFunction.h"
 #include "libUtils/TimeUtils.h"
+#include "libUtils/Tracing.h"
 
 using namespace std;
 using namespace boost::multiprecision;
@@ -190,6 +191,7 @@ bool Node::ProcessMicroBlockConsensusCore(const bytes& message,
                                           unsigned int offset,
                                           const Peer& from) {
   LOG_MARKER();
+  TRACE_SPAN("MicroBlock.Consensus", m_mediator.m_currentEpochNum);
 
   if (!CheckState(PROCESS_MICROBLOCKCONSENSUS)) {
     LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
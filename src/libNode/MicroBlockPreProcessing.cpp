@@ -15,9 +15,12 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <array>
 #include <chrono>
 #include <functional>
+#include <random>
+#include <set>
 #include <thread>
 
 #pragma GCC diagnostic push
@@ -35,6 +38,7 @@
 #include "libCrypto/Sha2.h"
 #include "libData/AccountData/Account.h"
 #include "libData/AccountData/AccountStore.h"
+#include "libData/AccountData/AddrNonceTxnQueue.h"
 #include "libData/AccountData/Transaction.h"
 #include "libData/AccountData/TransactionReceipt.h"
 #include "libData/AccountData/TxnOrderVerifier.h"
@@ -50,6 +54,7 @@
 #include "libUtils/TimeLockedFunction.h"
 #include "libUtils/TimeUtils.h"
 #include "libUtils/TimestampVerifier.h"
+#include "libUtils/Tracing.h"
 
 using namespace std;
 using namespace boost::multiprecision;
@@ -115,6 +120,12 @@ bool Node::ComposeMicroBlock() {
     txRootHash = ComputeRoot(m_TxnOrder);
 
     numTxs = t_processedTransactions.size();
+
+    static Metrics::Histogram& txnsPerMicroBlock =
+        Metrics::GetInstance().GetHistogram(
+            "zilliqa_microblock_txns", "Txns in each composed microblock", "",
+            {0, 10, 100, 500, 1000, 2000, 5000, 10000});
+    txnsPerMicroBlock.Observe(numTxs);
     if (numTxs != m_TxnOrder.size()) {
       LOG_GENERAL(WARNING, "FATAL Num txns and Order size not same "
                                << " numTxs " << numTxs << " m_TxnOrder "
@@ -179,8 +190,6 @@ bool Node::OnNodeMissingTxns(const bytes& errorMsg, const unsigned int offset,
 
   Peer peer(from.m_ipAddress, portNo);
 
-  lock_guard<mutex> g(m_mutexProcessedTransactions);
-
   unsigned int cur_offset = 0;
   bytes tx_message = {MessageType::NODE,
                       NodeInstructionType::SUBMITTRANSACTION};
@@ -192,22 +201,38 @@ bool Node::OnNodeMissingTxns(const bytes& errorMsg, const unsigned int offset,
   cur_offset += sizeof(uint64_t);
 
   std::vector<Transaction> txns;
+  std::vector<TxnHash> unprocessedTransactions;
 
-  const std::unordered_map<TxnHash, TransactionWithReceipt>&
-      processedTransactions = (epochNum == m_mediator.m_currentEpochNum)
-                                  ? t_processedTransactions
-                                  : m_processedTransactions[epochNum];
-
-  for (const auto& hash : missingTransactions) {
-    // LOG_GENERAL(INFO, "Peer " << from << " : " << portNo << " missing txn "
-    // << missingTransactions[i])
-    auto found = processedTransactions.find(hash);
-    if (found != processedTransactions.end()) {
-      txns.emplace_back(found->second.GetTransaction());
-    } else {
-      LOG_GENERAL(INFO,
-                  "Leader unable to find txn proposed in microblock " << hash);
-      continue;
+  {
+    lock_guard<mutex> g(m_mutexProcessedTransactions);
+
+    const FixedHashMap<TxnHash, TransactionWithReceipt>&
+        processedTransactions = (epochNum == m_mediator.m_currentEpochNum)
+                                    ? t_processedTransactions
+                                    : m_processedTransactions[epochNum];
+
+    for (const auto& hash : missingTransactions) {
+      // LOG_GENERAL(INFO, "Peer " << from << " : " << portNo << " missing txn "
+      // << missingTransactions[i])
+      auto found = processedTransactions.find(hash);
+      if (found != processedTransactions.end()) {
+        txns.emplace_back(found->second.GetTransaction());
+      } else {
+        unprocessedTransactions.emplace_back(hash);
+      }
+    }
+  }
+
+  // Backups asked by their peers may only hold the bodies in the txn pool
+  if (!unprocessedTransactions.empty()) {
+    lock_guard<mutex> g(m_mutexCreatedTransactions);
+    for (const auto& hash : unprocessedTransactions) {
+      Transaction t;
+      if (m_createdTxns.get(hash, t)) {
+        txns.emplace_back(t);
+      } else {
+        LOG_GENERAL(INFO, "Unable to find txn proposed in microblock " << hash);
+      }
     }
   }
 
@@ -221,6 +246,122 @@ bool Node::OnNodeMissingTxns(const bytes& errorMsg, const unsigned int offset,
   return true;
 }
 
+bool Node::ProcessMissingTxnRequest(const bytes& message, unsigned int offset,
+                                    const Peer& from) {
+  if (LOOKUP_NODE_MODE) {
+    LOG_GENERAL(WARNING,
+                "Node::ProcessMissingTxnRequest not expected to be called "
+                "from LookUp node.");
+    return true;
+  }
+
+  LOG_MARKER();
+
+  return OnNodeMissingTxns(message, offset, from);
+}
+
+void Node::FetchMissingTxns(const vector<TxnHash>& missingTxnHashes) {
+  if (LOOKUP_NODE_MODE) {
+    LOG_GENERAL(WARNING,
+                "Node::FetchMissingTxns not expected to be called from "
+                "LookUp node");
+    return;
+  }
+
+  uint64_t fetchRound;
+  {
+    lock_guard<mutex> g(m_mutexMissingTxnsToFetch);
+    m_missingTxnsToFetch.clear();
+    m_missingTxnsToFetch.insert(missingTxnHashes.begin(),
+                                missingTxnHashes.end());
+    fetchRound = ++m_missingTxnsFetchRound;
+  }
+
+  if (MISSING_TXN_FETCH_PEERS == 0) {
+    return;
+  }
+
+  vector<Peer> peers;
+  {
+    lock_guard<mutex> g(m_mutexShardMember);
+    for (unsigned int i = 0; i < m_myShardMembers->size(); i++) {
+      // The leader is already asked through the commit failure
+      if (i != m_consensusMyID && i != m_consensusLeaderID) {
+        peers.emplace_back(m_myShardMembers->at(i).second);
+      }
+    }
+  }
+
+  if (peers.empty()) {
+    return;
+  }
+
+  shuffle(peers.begin(), peers.end(), mt19937(random_device()()));
+
+  auto func = [this, peers, fetchRound]() mutable -> void {
+    const uint64_t epochNum = m_mediator.m_currentEpochNum;
+    const auto deadline = chrono::steady_clock::now() +
+                          chrono::seconds(FETCHING_MISSING_DATA_TIMEOUT);
+    const unsigned int numPeers =
+        min(MISSING_TXN_FETCH_PEERS, (unsigned int)peers.size());
+    const unsigned int batchSize = max(MISSING_TXN_FETCH_BATCH_SIZE, 1u);
+    unsigned int nextPeer = 0;
+
+    while (true) {
+      this_thread::sleep_for(
+          chrono::milliseconds(MISSING_TXN_HEDGE_DELAY_IN_MS));
+
+      if (chrono::steady_clock::now() >= deadline) {
+        return;
+      }
+
+      vector<TxnHash> stillMissing;
+      {
+        lock_guard<mutex> g(m_mutexMissingTxnsToFetch);
+        if (m_missingTxnsFetchRound != fetchRound) {
+          return;
+        }
+        stillMissing.assign(m_missingTxnsToFetch.begin(),
+                            m_missingTxnsToFetch.end());
+      }
+
+      if (stillMissing.empty()) {
+        return;
+      }
+
+      LOG_GENERAL(INFO, "Hedging fetch of " << stillMissing.size()
+                                            << " missing txns over "
+                                            << numPeers << " peers");
+
+      // Split the hashes into batches spread over a few peers, and move on
+      // to other peers next round in case these ones are slow too
+      for (unsigned int i = 0, b = 0; i < stillMissing.size();
+           i += batchSize, b++) {
+        vector<TxnHash> batch(
+            stillMissing.begin() + i,
+            stillMissing.begin() +
+                min((unsigned int)stillMissing.size(), i + batchSize));
+
+        bytes request = {MessageType::NODE,
+                         NodeInstructionType::MISSINGTXNREQUEST};
+        if (!Messenger::SetNodeMissingTxnsErrorMsg(
+                request, MessageOffset::BODY, batch, epochNum,
+                m_mediator.m_selfPeer.m_listenPortHost)) {
+          LOG_GENERAL(WARNING, "Messenger::SetNodeMissingTxnsErrorMsg failed");
+          return;
+        }
+
+        P2PComm::GetInstance().SendMessage(
+            peers.at((nextPeer + b % numPeers) % peers.size()), request);
+      }
+
+      nextPeer += numPeers;
+    }
+  };
+
+  DetachedFunction(1, func);
+}
+
 bool Node::OnCommitFailure([
     [gnu::unused]] const std::map<unsigned int, bytes>& commitFailureMap) {
   if (LOOKUP_NODE_MODE) {
@@ -253,7 +394,7 @@ bool Node::OnCommitFailure([
   return true;
 }
 
-void Node::NotifyTimeout(bool& txnProcTimeout) {
+void Node::ScheduleTxnProcTimeout() {
   int timeout_time = std::max(
       0,
       ((int)MICROBLOCK_TIMEOUT -
@@ -261,11 +402,39 @@ void Node::NotifyTimeout(bool& txnProcTimeout) {
        (int)CONSENSUS_OBJECT_TIMEOUT));
   LOG_GENERAL(INFO, "The overall timeout for txn processing will be "
                         << timeout_time << " seconds");
-  unique_lock<mutex> lock(m_mutexCVTxnProcFinished);
-  if (cv_TxnProcFinished.wait_for(lock, chrono::seconds(timeout_time)) ==
-      cv_status::timeout) {
-    txnProcTimeout = true;
-    AccountStore::GetInstance().NotifyTimeout();
+
+  lock_guard<mutex> g(m_mutexTxnProcTimeout);
+  Scheduler::GetInstance().Cancel(m_txnProcTimeoutHandle);
+  const uint64_t round = ++m_txnProcRound;
+  m_txnProcTimeout = false;
+
+  m_txnProcTimeoutHandle = Scheduler::GetInstance().ScheduleAfter(
+      [this, round]() -> void {
+        lock_guard<mutex> g(m_mutexTxnProcTimeout);
+        // A callback already handed out when cancelled must still not fire
+        if (m_txnProcRound == round) {
+          m_txnProcTimeout = true;
+          AccountStore::GetInstance().NotifyTimeout();
+        }
+      },
+      timeout_time * 1000);
+}
+
+void Node::CancelTxnProcTimeout() {
+  lock_guard<mutex> g(m_mutexTxnProcTimeout);
+  Scheduler::GetInstance().Cancel(m_txnProcTimeoutHandle);
+  m_txnProcTimeoutHandle = 0;
+  m_txnProcRound++;
+}
+
+void Node::WaitForQueuedTxns(unsigned int timeoutMs) {
+  unique_lock<mutex> lock(m_mutexCreatedTransactions);
+  if (cv_TxnsQueued.wait_for(lock, chrono::milliseconds(timeoutMs), [this]() {
+        return ENABLE_EARLY_MICROBLOCK_COMPOSITION &&
+               m_createdTxns.GasLimitTotal >= MICROBLOCK_GAS_LIMIT;
+      })) {
+    LOG_GENERAL(INFO, "TxnPool holds " << m_createdTxns.GasLimitTotal
+                                       << " gas, composing microblock now");
   }
 }
 
@@ -278,39 +447,14 @@ void Node::ProcessTransactionWhenShardLeader() {
 
   lock_guard<mutex> g(m_mutexCreatedTransactions);
 
+  DropStalePreCheckedTxns();
   t_createdTxns = m_createdTxns;
-  map<Address, map<uint64_t, Transaction>> t_addrNonceTxnMap;
+  ResetEpochArena();
+  AddrNonceTxnQueue t_addrNonceTxnQueue(&m_epochArena);
   t_processedTransactions.clear();
   m_TxnOrder.clear();
 
-  bool txnProcTimeout = false;
-
-  auto txnProcTimer = [this, &txnProcTimeout]() -> void {
-    NotifyTimeout(txnProcTimeout);
-  };
-
-  DetachedFunction(1, txnProcTimer);
-
-  this_thread::sleep_for(chrono::milliseconds(100));
-
-  auto findOneFromAddrNonceTxnMap =
-      [](Transaction& t,
-         map<Address, map<uint64_t, Transaction>>& t_addrNonceTxnMap) -> bool {
-    for (auto it = t_addrNonceTxnMap.begin(); it != t_addrNonceTxnMap.end();
-         it++) {
-      if (it->second.begin()->first ==
-          AccountStore::GetInstance().GetNonceTemp(it->first) + 1) {
-        t = std::move(it->second.begin()->second);
-        it->second.erase(it->second.begin());
-
-        if (it->second.empty()) {
-          t_addrNonceTxnMap.erase(it);
-        }
-        return true;
-      }
-    }
-    return false;
-  };
+  ScheduleTxnProcTimeout();
 
   auto appendOne = [this](const Transaction& t, const TransactionReceipt& tr) {
     t_processedTransactions.insert(
@@ -324,16 +468,16 @@ void Node::ProcessTransactionWhenShardLeader() {
   vector<Transaction> gasLimitExceededTxnBuffer;
 
   while (m_gasUsedTotal < MICROBLOCK_GAS_LIMIT) {
-    if (txnProcTimeout) {
+    if (m_txnProcTimeout) {
       break;
     }
 
     Transaction t;
     TransactionReceipt tr;
 
-    // check m_addrNonceTxnMap contains any txn meets right nonce,
+    // check t_addrNonceTxnQueue contains any txn meets right nonce,
     // if contains, process it
-    if (findOneFromAddrNonceTxnMap(t, t_addrNonceTxnMap)) {
+    if (t_addrNonceTxnQueue.PopReady(t)) {
       // check whether m_createdTransaction have transaction with same Addr and
       // nonce if has and with larger gasPrice then replace with that one.
       // (*optional step)
@@ -344,7 +488,15 @@ void Node::ProcessTransactionWhenShardLeader() {
         continue;
       }
 
-      if (m_mediator.m_validator->CheckCreatedTransaction(t, tr)) {
+      const bool applied = m_mediator.m_validator->CheckCreatedTransaction(
+          t, tr, IsTxnPreChecked(t));
+      UpdateSenderNonceTemp(t, applied);
+      if (applied) {
+        // The sender's nonce advanced, so its next held txn may be ready
+        const Address senderAddr = t.GetSenderAddr();
+        t_addrNonceTxnQueue.Refresh(senderAddr,
+                                    GetSenderNonceTemp(senderAddr) + 1);
+
         if (!SafeMath<uint64_t>::add(m_gasUsedTotal, tr.GetCumGas(),
                                      m_gasUsedTotal)) {
           LOG_GENERAL(WARNING, "m_gasUsedTotal addition unsafe!");
@@ -365,47 +517,41 @@ void Node::ProcessTransactionWhenShardLeader() {
         continue;
       }
     }
+    // if enabled, process new come-in payment transactions in a batch
+    else if (ENABLE_PARALLEL_PAYMENT_TXNS &&
+             ProcessPaymentTxnBatch(t_addrNonceTxnQueue, appendOne)) {
+    }
     // if no txn in u_map meet right nonce process new come-in transactions
     else if (t_createdTxns.findOne(t)) {
       // LOG_GENERAL(INFO, "findOneFromCreated");
 
       Address senderAddr = t.GetSenderAddr();
+      const uint64_t expectedNonce = GetSenderNonceTemp(senderAddr) + 1;
       // check nonce, if nonce larger than expected, put it into
-      // m_addrNonceTxnMap
-      if (t.GetNonce() >
-          AccountStore::GetInstance().GetNonceTemp(senderAddr) + 1) {
+      // t_addrNonceTxnQueue
+      if (t.GetNonce() > expectedNonce) {
         // LOG_GENERAL(INFO, "High nonce: "
         //                     << t.GetNonce() << " cur sender " <<
         //                     senderAddr.hex()
-        //                     << " nonce: "
-        //                     <<
-        //                     AccountStore::GetInstance().GetNonceTemp(senderAddr));
-        auto it1 = t_addrNonceTxnMap.find(senderAddr);
-        if (it1 != t_addrNonceTxnMap.end()) {
-          auto it2 = it1->second.find(t.GetNonce());
-          if (it2 != it1->second.end()) {
-            // found the txn with same addr and same nonce
-            // then compare the gasprice and remains the higher one
-            if (t.GetGasPrice() > it2->second.GetGasPrice()) {
-              it2->second = t;
-            }
-            continue;
-          }
-        }
-        t_addrNonceTxnMap[senderAddr].insert({t.GetNonce(), t});
+        //                     << " nonce: " << expectedNonce - 1);
+        t_addrNonceTxnQueue.Insert(senderAddr, t, expectedNonce);
       }
       // if nonce too small, ignore it
-      else if (t.GetNonce() <
-               AccountStore::GetInstance().GetNonceTemp(senderAddr) + 1) {
+      else if (t.GetNonce() < expectedNonce) {
         // LOG_GENERAL(INFO,
         //             "Nonce too small"
-        //                 << " Expected "
-        //                 <<
-        //                 AccountStore::GetInstance().GetNonceTemp(senderAddr)
+        //                 << " Expected " << expectedNonce - 1
         //                 << " Found " << t.GetNonce());
       }
       // if nonce correct, process it
-      else if (m_mediator.m_validator->CheckCreatedTransaction(t, tr)) {
+      else if (m_mediator.m_validator->CheckCreatedTransaction(
+                   t, tr, IsTxnPreChecked(t))) {
+        UpdateSenderNonceTemp(t, true);
+        if (t_addrNonceTxnQueue.Contains(senderAddr)) {
+          t_addrNonceTxnQueue.Refresh(senderAddr,
+                                      GetSenderNonceTemp(senderAddr) + 1);
+        }
+
         if (!SafeMath<uint64_t>::add(m_gasUsedTotal, tr.GetCumGas(),
                                      m_gasUsedTotal)) {
           LOG_GENERAL(WARNING, "m_gasUsedTotal addition unsafe!");
@@ -424,19 +570,17 @@ void Node::ProcessTransactionWhenShardLeader() {
         appendOne(t, tr);
       } else {
         // LOG_GENERAL(WARNING, "CheckCreatedTransaction failed");
+        UpdateSenderNonceTemp(t, false);
       }
     } else {
       break;
     }
   }
 
-  cv_TxnProcFinished.notify_all();
+  CancelTxnProcTimeout();
   // Put txns in map back into pool
-  for (const auto& kv : t_addrNonceTxnMap) {
-    for (const auto& nonceTxn : kv.second) {
-      t_createdTxns.insert(nonceTxn.second);
-    }
-  }
+  t_addrNonceTxnQueue.ForEach(
+      [this](const Transaction& t) { t_createdTxns.insert(t); });
 
   for (const auto& t : gasLimitExceededTxnBuffer) {
     t_createdTxns.insert(t);
@@ -496,6 +640,7 @@ void Node::UpdateProcessedTransactions() {
     lock_guard<mutex> g(m_mutexCreatedTransactions);
     m_createdTxns = std::move(t_createdTxns);
     t_createdTxns.clear();
+    GetTxnPoolSizeGauge().Set(m_createdTxns.size());
   }
 
   {
@@ -515,40 +660,14 @@ void Node::ProcessTransactionWhenShardBackup() {
 
   lock_guard<mutex> g(m_mutexCreatedTransactions);
 
+  DropStalePreCheckedTxns();
   t_createdTxns = m_createdTxns;
   m_expectedTranOrdering.clear();
-  map<Address, map<uint64_t, Transaction>> t_addrNonceTxnMap;
+  ResetEpochArena();
+  AddrNonceTxnQueue t_addrNonceTxnQueue(&m_epochArena);
   t_processedTransactions.clear();
 
-  bool txnProcTimeout = false;
-
-  auto txnProcTimer = [this, &txnProcTimeout]() -> void {
-    NotifyTimeout(txnProcTimeout);
-  };
-
-  DetachedFunction(1, txnProcTimer);
-
-  this_thread::sleep_for(chrono::milliseconds(100));
-
-  auto findOneFromAddrNonceTxnMap =
-      [](Transaction& t,
-         std::map<Address, map<uint64_t, Transaction>>& t_addrNonceTxnMap)
-      -> bool {
-    for (auto it = t_addrNonceTxnMap.begin(); it != t_addrNonceTxnMap.end();
-         it++) {
-      if (it->second.begin()->first ==
-          AccountStore::GetInstance().GetNonceTemp(it->first) + 1) {
-        t = std::move(it->second.begin()->second);
-        it->second.erase(it->second.begin());
-
-        if (it->second.empty()) {
-          t_addrNonceTxnMap.erase(it);
-        }
-        return true;
-      }
-    }
-    return false;
-  };
+  ScheduleTxnProcTimeout();
 
   auto appendOne = [this](const Transaction& t, const TransactionReceipt& tr) {
     m_expectedTranOrdering.emplace_back(t.GetTranID());
@@ -562,16 +681,16 @@ void Node::ProcessTransactionWhenShardBackup() {
   vector<Transaction> gasLimitExceededTxnBuffer;
 
   while (m_gasUsedTotal < MICROBLOCK_GAS_LIMIT) {
-    if (txnProcTimeout) {
+    if (m_txnProcTimeout) {
       break;
     }
 
     Transaction t;
     TransactionReceipt tr;
 
-    // check t_addrNonceTxnMap contains any txn meets right nonce,
+    // check t_addrNonceTxnQueue contains any txn meets right nonce,
     // if contains, process it
-    if (findOneFromAddrNonceTxnMap(t, t_addrNonceTxnMap)) {
+    if (t_addrNonceTxnQueue.PopReady(t)) {
       // check whether m_createdTransaction have transaction with same Addr and
       // nonce if has and with larger gasPrice then replace with that one.
       // (*optional step)
@@ -582,7 +701,15 @@ void Node::ProcessTransactionWhenShardBackup() {
         continue;
       }
 
-      if (m_mediator.m_validator->CheckCreatedTransaction(t, tr)) {
+      const bool applied = m_mediator.m_validator->CheckCreatedTransaction(
+          t, tr, IsTxnPreChecked(t));
+      UpdateSenderNonceTemp(t, applied);
+      if (applied) {
+        // The sender's nonce advanced, so its next held txn may be ready
+        const Address senderAddr = t.GetSenderAddr();
+        t_addrNonceTxnQueue.Refresh(senderAddr,
+                                    GetSenderNonceTemp(senderAddr) + 1);
+
         if (!SafeMath<uint64_t>::add(m_gasUsedTotal, tr.GetCumGas(),
                                      m_gasUsedTotal)) {
           LOG_GENERAL(WARNING, "m_gasUsedTotal addition unsafe!");
@@ -602,33 +729,31 @@ void Node::ProcessTransactionWhenShardBackup() {
         continue;
       }
     }
+    // if enabled, process new come-in payment transactions in a batch
+    else if (ENABLE_PARALLEL_PAYMENT_TXNS &&
+             ProcessPaymentTxnBatch(t_addrNonceTxnQueue, appendOne)) {
+    }
     // if no txn in u_map meet right nonce process new come-in transactions
     else if (t_createdTxns.findOne(t)) {
       Address senderAddr = t.GetSenderAddr();
+      const uint64_t expectedNonce = GetSenderNonceTemp(senderAddr) + 1;
       // check nonce, if nonce larger than expected, put it into
-      // t_addrNonceTxnMap
-      if (t.GetNonce() >
-          AccountStore::GetInstance().GetNonceTemp(senderAddr) + 1) {
-        auto it1 = t_addrNonceTxnMap.find(senderAddr);
-        if (it1 != t_addrNonceTxnMap.end()) {
-          auto it2 = it1->second.find(t.GetNonce());
-          if (it2 != it1->second.end()) {
-            // found the txn with same addr and same nonce
-            // then compare the gasprice and remains the higher one
-            if (t.GetGasPrice() > it2->second.GetGasPrice()) {
-              it2->second = t;
-            }
-            continue;
-          }
-        }
-        t_addrNonceTxnMap[senderAddr].insert({t.GetNonce(), t});
+      // t_addrNonceTxnQueue
+      if (t.GetNonce() > expectedNonce) {
+        t_addrNonceTxnQueue.Insert(senderAddr, t, expectedNonce);
       }
       // if nonce too small, ignore it
-      else if (t.GetNonce() <
-               AccountStore::GetInstance().GetNonceTemp(senderAddr) + 1) {
+      else if (t.GetNonce() < expectedNonce) {
       }
       // if nonce correct, process it
-      else if (m_mediator.m_validator->CheckCreatedTransaction(t, tr)) {
+      else if (m_mediator.m_validator->CheckCreatedTransaction(
+                   t, tr, IsTxnPreChecked(t))) {
+        UpdateSenderNonceTemp(t, true);
+        if (t_addrNonceTxnQueue.Contains(senderAddr)) {
+          t_addrNonceTxnQueue.Refresh(senderAddr,
+                                      GetSenderNonceTemp(senderAddr) + 1);
+        }
+
         if (!SafeMath<uint64_t>::add(m_gasUsedTotal, tr.GetCumGas(),
                                      m_gasUsedTotal)) {
           LOG_GENERAL(WARNING, "m_gasUsedTotal addition overflow!");
@@ -645,26 +770,265 @@ void Node::ProcessTransactionWhenShardBackup() {
           break;
         }
         appendOne(t, tr);
+      } else {
+        UpdateSenderNonceTemp(t, false);
       }
     } else {
       break;
     }
   }
 
-  cv_TxnProcFinished.notify_all();
+  CancelTxnProcTimeout();
 
   // Put remaining txns back in pool
-  for (const auto& kv : t_addrNonceTxnMap) {
-    for (const auto& nonceTxn : kv.second) {
-      t_createdTxns.insert(nonceTxn.second);
-    }
-  }
+  t_addrNonceTxnQueue.ForEach(
+      [this](const Transaction& t) { t_createdTxns.insert(t); });
 
   for (const auto& t : gasLimitExceededTxnBuffer) {
     t_createdTxns.insert(t);
   }
 }
 
+void Node::DropStalePreCheckedTxns() {
+  if (m_preCheckedStateRoot !=
+      AccountStore::GetInstance().GetStateRootHash()) {
+    m_preCheckedTxns.clear();
+  }
+}
+
+bool Node::IsTxnPreChecked(const Transaction& t) const {
+  return m_preCheckedTxns.find(t.GetTranID()) != m_preCheckedTxns.end();
+}
+
+uint64_t Node::GetSenderNonceTemp(const Address& senderAddr) {
+  auto it = t_senderNonces.find(senderAddr);
+  if (it == t_senderNonces.end()) {
+    it = t_senderNonces
+             .emplace(senderAddr,
+                      AccountStore::GetInstance().GetNonceTemp(senderAddr))
+             .first;
+  }
+  return it->second;
+}
+
+void Node::UpdateSenderNonceTemp(const Transaction& t, bool applied) {
+  // Only the sender's nonce changes. A failed txn may still have charged the
+  // sender, so its nonce is read again from AccountStoreTemp next time.
+  if (applied) {
+    t_senderNonces[t.GetSenderAddr()] = t.GetNonce();
+  } else {
+    t_senderNonces.erase(t.GetSenderAddr());
+  }
+}
+
+Metrics::Gauge& Node::GetTxnPoolSizeGauge() {
+  static Metrics::Gauge& size = Metrics::GetInstance().GetGauge(
+      "zilliqa_txn_pool_size", "Txns in the pool waiting to be processed");
+  return size;
+}
+
+void Node::ResetEpochArena() {
+  // Move the map off the arena first, in case even an empty one holds some
+  t_senderNonces = SenderNonceMap();
+  m_epochArena.Reset();
+  t_senderNonces =
+      SenderNonceMap(SenderNonceMap::allocator_type(&m_epochArena));
+}
+
+bool Node::ProcessPaymentTxnBatch(
+    AddrNonceTxnQueue& addrNonceTxnQueue,
+    const function<void(const Transaction&, const TransactionReceipt&)>&
+        appendOne) {
+  if (m_gasUsedTotal >= MICROBLOCK_GAS_LIMIT) {
+    return false;
+  }
+
+  // A payment uses at most NORMAL_TRAN_GAS, so the serial loop would not hit
+  // the gas limit before the end of a batch of this size
+  const uint64_t maxBatchSize = min<uint64_t>(
+      PAYMENT_TXN_BATCH_SIZE,
+      (MICROBLOCK_GAS_LIMIT - m_gasUsedTotal - 1) / NORMAL_TRAN_GAS + 1);
+
+  vector<Transaction> batch;
+  set<Address> senders;
+  bool taken = false;
+  Transaction t;
+
+  while (batch.size() < maxBatchSize && t_createdTxns.findOne(t)) {
+    const Address senderAddr = t.GetSenderAddr();
+
+    // Contract txns, and a second txn from a sender whose nonce is about to
+    // change, are left for the serial loop
+    if (!t.GetData().empty() || !t.GetCode().empty() ||
+        senders.find(senderAddr) != senders.end()) {
+      t_createdTxns.insert(t);
+      break;
+    }
+
+    taken = true;
+
+    const uint64_t expectedNonce = GetSenderNonceTemp(senderAddr) + 1;
+    if (t.GetNonce() > expectedNonce) {
+      addrNonceTxnQueue.Insert(senderAddr, t, expectedNonce);
+      continue;
+    } else if (t.GetNonce() < expectedNonce) {
+      continue;
+    }
+
+    batch.emplace_back(t);
+    senders.emplace(senderAddr);
+
+    // A held txn of this sender may become ready, which the serial loop
+    // would take before the next one from the pool
+    if (addrNonceTxnQueue.Contains(senderAddr)) {
+      break;
+    }
+  }
+
+  if (batch.empty()) {
+    return taken;
+  }
+
+  vector<bool> preChecked;
+  preChecked.reserve(batch.size());
+  for (const auto& txn : batch) {
+    preChecked.emplace_back(IsTxnPreChecked(txn));
+  }
+
+  vector<TransactionReceipt> receipts;
+  vector<bool> results;
+  m_mediator.m_validator->CheckCreatedTransactions(batch, receipts, results,
+                                                   preChecked);
+
+  for (unsigned int i = 0; i < batch.size(); i++) {
+    UpdateSenderNonceTemp(batch[i], results[i]);
+    if (!results[i]) {
+      continue;
+    }
+
+    const Address senderAddr = batch[i].GetSenderAddr();
+    if (addrNonceTxnQueue.Contains(senderAddr)) {
+      addrNonceTxnQueue.Refresh(senderAddr, GetSenderNonceTemp(senderAddr) + 1);
+    }
+
+    if (!SafeMath<uint64_t>::add(m_gasUsedTotal, receipts[i].GetCumGas(),
+                                 m_gasUsedTotal)) {
+      LOG_GENERAL(WARNING, "m_gasUsedTotal addition unsafe!");
+      break;
+    }
+    uint128_t txnFee;
+    if (!SafeMath<uint128_t>::mul(receipts[i].GetCumGas(),
+                                  batch[i].GetGasPrice(), txnFee)) {
+      LOG_GENERAL(WARNING, "txnFee multiplication unsafe!");
+      continue;
+    }
+    if (!SafeMath<uint128_t>::add(m_txnFees, txnFee, m_txnFees)) {
+      LOG_GENERAL(WARNING, "m_txnFees addition unsafe!");
+      break;
+    }
+    appendOne(batch[i], receipts[i]);
+  }
+
+  return true;
+}
+
+bool Node::ReplayTxnsInLeaderOrder(const vector<TxnHash>& tranHashes) {
+  LOG_MARKER();
+
+  vector<Transaction> txns;
+  vector<bool> preChecked;
+  txns.reserve(tranHashes.size());
+  preChecked.reserve(tranHashes.size());
+
+  {
+    lock_guard<mutex> g(m_mutexCreatedTransactions);
+
+    DropStalePreCheckedTxns();
+
+    // Left in the pool afterwards are exactly the txns the leader did not take
+    t_createdTxns = m_createdTxns;
+    for (const auto& tranHash : tranHashes) {
+      Transaction t;
+      if (!t_createdTxns.take(tranHash, t)) {
+        LOG_GENERAL(WARNING, "Txn " << tranHash << " not in pool");
+        return false;
+      }
+      preChecked.emplace_back(IsTxnPreChecked(t));
+      txns.emplace_back(t);
+    }
+  }
+
+  // Start again from the state ProcessTransactionWhenShardBackup started from
+  AccountStore::GetInstance().InitTemp();
+  if (m_mediator.m_ds->m_mode != DirectoryService::Mode::IDLE &&
+      !AccountStore::GetInstance().DeserializeDeltaTemp(
+          m_mediator.m_ds->m_stateDeltaFromShards, 0)) {
+    LOG_GENERAL(WARNING, "AccountStore::DeserializeDeltaTemp failed");
+    return false;
+  }
+
+  if (ENABLE_ACCOUNTS_POPULATING) {
+    UpdateBalanceForPreGeneratedAccounts();
+  }
+
+  // The leader only takes a txn with the next nonce of its sender
+  map<Address, uint64_t> nextNonces;
+  for (const auto& t : txns) {
+    const Address senderAddr = t.GetSenderAddr();
+    auto it = nextNonces.find(senderAddr);
+    if (it == nextNonces.end()) {
+      const uint64_t nextNonce = AccountStore::GetInstance()
+                                     .GetNonceTemp(senderAddr)
+                                     .convert_to<uint64_t>() +
+                                 1;
+      it = nextNonces.emplace(senderAddr, nextNonce).first;
+    }
+    if (t.GetNonce() != it->second++) {
+      LOG_GENERAL(WARNING, "Txn " << t.GetTranID() << " has nonce "
+                                  << t.GetNonce() << " out of order");
+      return false;
+    }
+  }
+
+  vector<TransactionReceipt> receipts;
+  vector<bool> results;
+  m_mediator.m_validator->CheckCreatedTransactions(txns, receipts, results,
+                                                   preChecked);
+
+  t_processedTransactions.clear();
+  m_expectedTranOrdering.clear();
+  m_gasUsedTotal = 0;
+  m_txnFees = 0;
+
+  for (unsigned int i = 0; i < txns.size(); i++) {
+    if (!results[i]) {
+      LOG_GENERAL(WARNING, "Txn " << txns[i].GetTranID() << " failed");
+      return false;
+    }
+
+    if (!SafeMath<uint64_t>::add(m_gasUsedTotal, receipts[i].GetCumGas(),
+                                 m_gasUsedTotal)) {
+      LOG_GENERAL(WARNING, "m_gasUsedTotal addition overflow!");
+      return false;
+    }
+    uint128_t txnFee;
+    if (!SafeMath<uint128_t>::mul(receipts[i].GetCumGas(),
+                                  txns[i].GetGasPrice(), txnFee) ||
+        !SafeMath<uint128_t>::add(m_txnFees, txnFee, m_txnFees)) {
+      LOG_GENERAL(WARNING, "m_txnFees overflow!");
+      return false;
+    }
+
+    m_expectedTranOrdering.emplace_back(txns[i].GetTranID());
+    t_processedTransactions.insert(make_pair(
+        txns[i].GetTranID(), TransactionWithReceipt(txns[i], receipts[i])));
+  }
+
+  LOG_GENERAL(INFO, "Replayed " << txns.size() << " txns in leader's order");
+
+  return true;
+}
+
 void Node::UpdateBalanceForPreGeneratedAccounts() {
   LOG_MARKER();
   int counter = 0;
@@ -697,8 +1061,7 @@ bool Node::RunConsensusOnMicroBlockWhenShardLeader() {
 
   if (m_mediator.m_ds->m_mode == DirectoryService::Mode::IDLE &&
       !m_mediator.GetIsVacuousEpoch()) {
-    std::this_thread::sleep_for(chrono::milliseconds(TX_DISTRIBUTE_TIME_IN_MS +
-                                                     ANNOUNCEMENT_DELAY_IN_MS));
+    WaitForQueuedTxns(TX_DISTRIBUTE_TIME_IN_MS + ANNOUNCEMENT_DELAY_IN_MS);
   }
 
   m_txn_distribute_window_open = false;
@@ -808,7 +1171,7 @@ bool Node::RunConsensusOnMicroBlockWhenShardBackup() {
                 .GetDSDifficulty() >= TXN_DS_TARGET_DIFFICULTY) ||
        m_mediator.m_dsBlockChain.GetLastBlock().GetHeader().GetBlockNum() >=
            TXN_DS_TARGET_NUM)) {
-    std::this_thread::sleep_for(chrono::milliseconds(TX_DISTRIBUTE_TIME_IN_MS));
+    WaitForQueuedTxns(TX_DISTRIBUTE_TIME_IN_MS);
     ProcessTransactionWhenShardBackup();
   }
 
@@ -868,6 +1231,7 @@ bool Node::RunConsensusOnMicroBlock() {
   }
 
   LOG_MARKER();
+  TRACE_SPAN("MicroBlock.Prepare", m_mediator.m_currentEpochNum);
 
   SetState(MICROBLOCK_CONSENSUS_PREP);
   m_txn_distribute_window_open = true;
@@ -1014,6 +1378,8 @@ unsigned char Node::CheckLegitimacyOfTxnHashes(bytes& errorMsg) {
         return false;
       }
 
+      FetchMissingTxns(missingTxnHashes);
+
       {
         lock_guard<mutex> g(m_mutexCreatedTransactions);
         LOG_GENERAL(WARNING, m_createdTxns);
@@ -1034,6 +1400,14 @@ unsigned char Node::CheckLegitimacyOfTxnHashes(bytes& errorMsg) {
       return LEGITIMACYRESULT::MISSEDTXN;
     }
 
+    // Our order was within tolerance but the state must follow the leader's
+    if (ENABLE_BACKUP_TXN_REPLAY &&
+        m_microblock->GetTranHashes() != m_expectedTranOrdering &&
+        !ReplayTxnsInLeaderOrder(m_microblock->GetTranHashes())) {
+      LOG_GENERAL(WARNING, "Failed to replay the txns in the leader's order");
+      return LEGITIMACYRESULT::WRONGORDER;
+    }
+
     if (!AccountStore::GetInstance().SerializeDelta()) {
       LOG_GENERAL(WARNING, "AccountStore::SerializeDelta failed");
       return LEGITIMACYRESULT::SERIALIZATIONERROR;
@@ -1130,7 +1504,7 @@ bool Node::CheckMicroBlockHashes(bytes& errorMsg) {
   return true;
 }
 
-bool Node::CheckMicroBlockTxnRootHash() {
+bool Node::CheckMicroBlockTxnRootHash(const TxnHash& expectedTxRootHash) {
   if (LOOKUP_NODE_MODE) {
     LOG_GENERAL(WARNING,
                 "Node::CheckMicroBlockTxnRootHash not expected to be "
@@ -1139,8 +1513,6 @@ bool Node::CheckMicroBlockTxnRootHash() {
   }
 
   // Check transaction root
-  TxnHash expectedTxRootHash = ComputeRoot(m_microblock->GetTranHashes());
-
   if (expectedTxRootHash != m_microblock->GetHeader().GetTxRootHash()) {
     LOG_CHECK_FAIL("Txn root hash", m_microblock->GetHeader().GetTxRootHash(),
                    expectedTxRootHash);
@@ -1156,7 +1528,8 @@ bool Node::CheckMicroBlockTxnRootHash() {
   return true;
 }
 
-bool Node::CheckMicroBlockStateDeltaHash() {
+bool Node::CheckMicroBlockStateDeltaHash(
+    const StateHash& expectedStateDeltaHash) {
   if (LOOKUP_NODE_MODE) {
     LOG_GENERAL(WARNING,
                 "Node::CheckMicroBlockStateDeltaHash not expected to be "
@@ -1164,9 +1537,6 @@ bool Node::CheckMicroBlockStateDeltaHash() {
     return true;
   }
 
-  StateHash expectedStateDeltaHash =
-      AccountStore::GetInstance().GetStateDeltaHash();
-
   if (expectedStateDeltaHash != m_microblock->GetHeader().GetStateDeltaHash()) {
     LOG_CHECK_FAIL("State delta hash",
                    m_microblock->GetHeader().GetStateDeltaHash(),
@@ -1183,19 +1553,18 @@ bool Node::CheckMicroBlockStateDeltaHash() {
   return true;
 }
 
-bool Node::CheckMicroBlockTranReceiptHash() {
-  TxnHash expectedTranHash;
-  if (!TransactionWithReceipt::ComputeTransactionReceiptsHash(
-          m_microblock->GetTranHashes(), t_processedTransactions,
-          expectedTranHash)) {
+bool Node::CheckMicroBlockTranReceiptHash(
+    const pair<bool, TxnHash>& expectedTranHash) {
+  if (!expectedTranHash.first) {
     LOG_GENERAL(WARNING, "Cannot compute transaction receipts hash");
     return false;
   }
 
-  if (expectedTranHash != m_microblock->GetHeader().GetTranReceiptHash()) {
+  if (expectedTranHash.second !=
+      m_microblock->GetHeader().GetTranReceiptHash()) {
     LOG_CHECK_FAIL("Txn receipt hash",
                    m_microblock->GetHeader().GetTranReceiptHash(),
-                   expectedTranHash);
+                   expectedTranHash.second);
 
     m_consensusObject->SetConsensusErrorCode(
         ConsensusCommon::INVALID_MICROBLOCK_TRAN_RECEIPT_HASH);
@@ -1203,7 +1572,7 @@ bool Node::CheckMicroBlockTranReceiptHash() {
     return false;
   }
 
-  LOG_GENERAL(INFO, "Txn receipt hash = " << expectedTranHash);
+  LOG_GENERAL(INFO, "Txn receipt hash = " << expectedTranHash.second);
 
   return true;
 }
@@ -1218,10 +1587,36 @@ bool Node::CheckMicroBlockValidity(bytes& errorMsg) {
 
   LOG_MARKER();
 
-  return CheckMicroBlockVersion() && CheckMicroBlockshardId() &&
-         CheckMicroBlockTimestamp() && CheckMicroBlockHashes(errorMsg) &&
-         CheckMicroBlockTxnRootHash() && CheckMicroBlockStateDeltaHash() &&
-         CheckMicroBlockTranReceiptHash();
+  // The txn root depends only on the proposed hashes, so it is computed on the
+  // pool while the txns are checked. The job keeps its own reference to the
+  // micro block, as it is not waited for if a check fails.
+  const auto microblock = m_microblock;
+  auto txRootHash = m_validationPool.Submit(
+      [microblock]() { return ComputeRoot(microblock->GetTranHashes()); });
+
+  if (!CheckMicroBlockVersion() || !CheckMicroBlockshardId() ||
+      !CheckMicroBlockTimestamp() || !CheckMicroBlockHashes(errorMsg)) {
+    return false;
+  }
+
+  // The state delta and the receipts are both final once the txns are
+  // checked, and their hashes are computed side by side. The results are
+  // compared in the order the checks always ran, so the error code set is
+  // that of the first check to fail.
+  auto tranReceiptHash = m_validationPool.Submit([this, microblock]() {
+    pair<bool, TxnHash> ret;
+    ret.first = TransactionWithReceipt::ComputeTransactionReceiptsHash(
+        microblock->GetTranHashes(), t_processedTransactions, ret.second);
+    return ret;
+  });
+  const StateHash stateDeltaHash =
+      AccountStore::GetInstance().GetStateDeltaHash();
+  // Waited for before anything returns, as it reads t_processedTransactions
+  const pair<bool, TxnHash> tranReceiptHashResult = tranReceiptHash.get();
+
+  return CheckMicroBlockTxnRootHash(txRootHash.get()) &&
+         CheckMicroBlockStateDeltaHash(stateDeltaHash) &&
+         CheckMicroBlockTranReceiptHash(tranReceiptHashResult);
 
   // Check gas limit (must satisfy some equations)
   // Check gas used (must be <= gas limit)
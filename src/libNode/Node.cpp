@@ -16,8 +16,10 @@
  */
 
 #include <arpa/inet.h>
+#include <signal.h>
 #include <array>
 #include <chrono>
+#include <fstream>
 #include <functional>
 #include <thread>
 #include <tuple>
@@ -52,11 +54,16 @@
 #include "libPersistence/Retriever.h"
 #include "libUtils/DataConversion.h"
 #include "libUtils/DetachedFunction.h"
+#include "libUtils/JoinableFunction.h"
 #include "libUtils/Logger.h"
+#include "libUtils/MemoryStats.h"
+#include "libUtils/ParallelDownload.h"
 #include "libUtils/SanityChecks.h"
 #include "libUtils/SysCommand.h"
+#include "libUtils/ThreadPool.h"
 #include "libUtils/TimeLockedFunction.h"
 #include "libUtils/TimeUtils.h"
+#include "libUtils/Tracing.h"
 #include "libValidator/Validator.h"
 
 using namespace std;
@@ -130,16 +137,195 @@ void Node::AddBalanceToGenesisAccount() {
 
 Node::Node(Mediator& mediator, [[gnu::unused]] unsigned int syncType,
            [[gnu::unused]] bool toRetrieveHistory)
-    : m_mediator(mediator) {}
+    : m_mediator(mediator) {
+  // Consensus messages of an earlier epoch would only be buffered, never used
+  const auto isCurrentConsensus = [this](const bytes& message,
+                                         unsigned int offset) {
+    return ConsensusCommon::IsForBlockOrLater(message, offset,
+                                              m_mediator.m_currentEpochNum);
+  };
+  RegisterPreFilter(NodeInstructionType::MICROBLOCKCONSENSUS,
+                    isCurrentConsensus);
+  RegisterPreFilter(NodeInstructionType::FALLBACKCONSENSUS,
+                    isCurrentConsensus);
+
+  RegisterPreFilter(NodeInstructionType::FORWARDTXNPACKET,
+                    [this](const bytes&, unsigned int) {
+                      return !m_mediator.GetIsVacuousEpoch();
+                    });
+
+  MemoryStats::GetInstance().Register("node.txnpool", [this]() {
+    lock_guard<mutex> g(m_mutexCreatedTransactions);
+    MemoryStats::Usage usage;
+    usage.m_entries = m_createdTxns.size();
+    usage.m_bytes = m_createdTxns.memoryBytes();
+    return usage;
+  });
+  MemoryStats::GetInstance().Register("node.txnpacketbuffer", [this]() {
+    lock_guard<mutex> g(m_mutexTxnPacketBuffer);
+    MemoryStats::Usage usage;
+    usage.m_entries = m_txnPacketBuffer.Size();
+    usage.m_bytes = m_txnPacketBuffer.Bytes();
+    return usage;
+  });
+  MemoryStats::GetInstance().Register(
+      "node.microblockconsensusbuffer", [this]() {
+        lock_guard<mutex> g(m_mutexMicroBlockConsensusBuffer);
+        MemoryStats::Usage usage;
+        for (const auto& consensus : m_microBlockConsensusBuffer) {
+          for (const auto& message : consensus.second) {
+            usage.m_entries++;
+            usage.m_bytes += sizeof(message) + get<NODE_MSG>(message).size();
+          }
+        }
+        return usage;
+      });
+}
+
+Node::~Node() { WaitForStoragePipeline(); }
+
+void Node::QueueStorage(const function<void()>& job) {
+  if (!ASYNC_BLOCK_STORAGE) {
+    job();
+    return;
+  }
+
+  lock_guard<mutex> g(m_mutexStoragePipeline);
+  m_lastStorageJob = m_storagePipeline.Submit(job).share();
+}
 
-Node::~Node() {}
+void Node::WaitForStoragePipeline() {
+  shared_future<void> last;
+  {
+    lock_guard<mutex> g(m_mutexStoragePipeline);
+    last = m_lastStorageJob;
+  }
+  if (last.valid()) {
+    last.wait();
+  }
+}
+
+namespace {
+/// Downloads a .tar.gz and extracts it into the directory as it arrives
+bool DownloadAndExtract(const string& url, const string& tarball,
+                        const string& directory,
+                        const unsigned int numConnections) {
+  // A tar that exits early must not take the node down with a SIGPIPE
+  sigset_t sigpipe, oldMask;
+  sigemptyset(&sigpipe);
+  sigaddset(&sigpipe, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &sigpipe, &oldMask);
+
+  bool ret = false;
+  FILE* tar = popen(("tar -xzf - -C " + directory).c_str(), "w");
+  if (tar == nullptr) {
+    LOG_GENERAL(WARNING, "popen() failed!");
+  } else {
+    ParallelDownload download(url, tarball, numConnections,
+                              PERSISTENCE_DOWNLOAD_CHUNK_IN_BYTES);
+    ret = download.Run([tar](const char* data, size_t size) {
+      return fwrite(data, 1, size, tar) == size;
+    });
+    const int status = pclose(tar);
+    if (status != 0) {
+      LOG_GENERAL(WARNING, "Extracting " << tarball << " failed with status "
+                                         << status);
+      ret = false;
+    }
+  }
+
+  const timespec noWait{0, 0};
+  while (sigtimedwait(&sigpipe, nullptr, &noWait) == SIGPIPE) {
+  }
+  pthread_sigmask(SIG_SETMASK, &oldMask, nullptr);
+
+  if (ret) {
+    boost::filesystem::remove(tarball);
+  }
+  return ret;
+}
+}  // namespace
 
 bool Node::DownloadPersistenceFromS3() {
   LOG_MARKER();
-  string output;
-  // TBD - find better way to capture the exit status of command
-  SysCommand::ExecuteCmdWithOutput("./downloadIncrDB.py", output);
-  return (output.find("Done!") != std::string::npos);
+
+  if (PERSISTENCE_DOWNLOAD_URL.empty()) {
+    string output;
+    // TBD - find better way to capture the exit status of command
+    SysCommand::ExecuteCmdWithOutput("./downloadIncrDB.py", output);
+    return (output.find("Done!") != std::string::npos);
+  }
+
+  // The download resumes from its journal, but the extraction starts over
+  boost::system::error_code ec;
+  boost::filesystem::remove_all("persistence", ec);
+  if (!DownloadAndExtract(PERSISTENCE_DOWNLOAD_URL + "/persistence.tar.gz",
+                          "persistence.tar.gz", ".",
+                          PERSISTENCE_DOWNLOAD_CONNECTIONS)) {
+    return false;
+  }
+
+  // Lists the Tx block numbers that have a state delta, one per line
+  const string manifest = "StateDeltaFromS3/stateDeltas";
+  boost::filesystem::create_directories("StateDeltaFromS3", ec);
+  boost::filesystem::remove(manifest, ec);
+  if (!ParallelDownload(PERSISTENCE_DOWNLOAD_URL + "/stateDeltas", manifest,
+                        1, PERSISTENCE_DOWNLOAD_CHUNK_IN_BYTES)
+           .Run()) {
+    return false;
+  }
+
+  vector<uint64_t> blockNums;
+  {
+    ifstream in(manifest);
+    uint64_t blockNum = 0;
+    while (in >> blockNum) {
+      blockNums.emplace_back(blockNum);
+    }
+  }
+  boost::filesystem::remove(manifest, ec);
+  if (blockNums.empty()) {
+    LOG_GENERAL(INFO, "No state deltas to download");
+    return true;
+  }
+
+  // Only the deltas since the last state in the persistence are replayed
+  const uint64_t window =
+      INCRDB_DSNUMS_WITH_STATEDELTAS * NUM_FINAL_BLOCK_PER_POW;
+  const uint64_t newest = *max_element(blockNums.begin(), blockNums.end());
+  const uint64_t oldest = window > 0 ? ((newest + 1) / window) * window : 0;
+
+  vector<future<bool>> downloads;
+  ThreadPool pool(PERSISTENCE_DOWNLOAD_CONNECTIONS, "DownloadPersistence");
+  for (const auto& blockNum : blockNums) {
+    if (blockNum < oldest) {
+      continue;
+    }
+
+    const string name = "stateDelta_" + to_string(blockNum);
+    const string tarball = "StateDeltaFromS3/" + name + ".tar.gz";
+    // Left by an earlier attempt that got as far as extracting it
+    if (boost::filesystem::exists("StateDeltaFromS3/" + name) &&
+        !boost::filesystem::exists(tarball) &&
+        !boost::filesystem::exists(tarball + ".journal")) {
+      continue;
+    }
+
+    downloads.emplace_back(pool.Submit([name, tarball]() {
+      return DownloadAndExtract(
+          PERSISTENCE_DOWNLOAD_URL + "/" + name + ".tar.gz", tarball,
+          "StateDeltaFromS3", 1);
+    }));
+  }
+
+  bool ret = true;
+  for (auto& download : downloads) {
+    ret = download.get() && ret;
+  }
+
+  LOG_GENERAL(INFO, "Downloaded " << downloads.size() << " state deltas from "
+                                  << oldest << " to " << newest);
+  return ret;
 }
 
 bool Node::Install(const SyncType syncType, const bool toRetrieveHistory,
@@ -390,7 +576,14 @@ bool Node::ValidateDB() {
     }
   }
 
-  if (!m_mediator.m_validator->CheckDirBlocks(dirBlocks, dsComm, 0, dsComm)) {
+  const unsigned int numThreads =
+      DB_VERIF_THREADS > 0
+          ? DB_VERIF_THREADS
+          : max(thread::hardware_concurrency(), (unsigned int)1);
+
+  BlockLink latestBlockLink;
+  if (!m_mediator.m_validator->VerifyDirBlocks(dirBlocks, dsComm, numThreads,
+                                               dsComm, latestBlockLink)) {
     LOG_GENERAL(WARNING, "Failed to verify Dir Blocks");
     return false;
   }
@@ -401,38 +594,64 @@ bool Node::ValidateDB() {
     txBlocks.emplace_back(*txblock);
   }
 
-  if (m_mediator.m_validator->CheckTxBlocks(
-          txBlocks, dsComm, m_mediator.m_blocklinkchain.GetLatestBlockLink()) !=
+  if (m_mediator.m_validator->CheckTxBlocks(txBlocks, dsComm,
+                                            latestBlockLink) !=
       ValidatorBase::TxBlockValidationMsg::VALID) {
     LOG_GENERAL(WARNING, "Failed to verify TxBlocks");
     return false;
   }
 
-  for (uint i = 1; i < txBlocks.size(); i++) {
-    auto microblockInfos = txBlocks.at(i).GetMicroBlockInfos();
-    for (const auto& mbInfo : microblockInfos) {
-      MicroBlockSharedPtr mbptr;
-      LOG_GENERAL(INFO, mbInfo.m_shardId);
-      /// Skip because empty microblocks are not stored
-      if (mbInfo.m_txnRootHash == TxnHash()) {
-        continue;
-      }
-      if (BlockStorage::GetBlockStorage().GetMicroBlock(mbInfo.m_microBlockHash,
-                                                        mbptr)) {
-        auto tranHashes = mbptr->GetTranHashes();
-        for (const auto& tranHash : tranHashes) {
+  // The micro blocks and txn bodies of each Tx block are checked on their
+  // own, so split the Tx blocks into ranges checked in parallel
+  auto checkBodies = [&txBlocks](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+      for (const auto& mbInfo : txBlocks.at(i).GetMicroBlockInfos()) {
+        /// Skip because empty microblocks are not stored
+        if (mbInfo.m_txnRootHash == TxnHash()) {
+          continue;
+        }
+        MicroBlockSharedPtr mbptr;
+        if (!BlockStorage::GetBlockStorage().GetMicroBlock(
+                mbInfo.m_microBlockHash, mbptr)) {
+          LOG_GENERAL(WARNING, " " << mbInfo.m_microBlockHash
+                                   << "failed to fetch microblock");
+          return false;
+        }
+        for (const auto& tranHash : mbptr->GetTranHashes()) {
           TxBodySharedPtr tx;
           if (!BlockStorage::GetBlockStorage().GetTxBody(tranHash, tx)) {
             LOG_GENERAL(WARNING, " " << tranHash << " failed to fetch");
             return false;
           }
         }
-      } else {
-        LOG_GENERAL(WARNING, " " << mbInfo.m_microBlockHash
-                                 << "failed to fetch microblock");
-        return false;
       }
     }
+    return true;
+  };
+
+  {
+    ThreadPool pool(numThreads, "ValidateDB");
+    const size_t rangeSize = 100;
+    vector<future<bool>> ranges;
+    for (size_t begin = 1; begin < txBlocks.size(); begin += rangeSize) {
+      const size_t end = min(begin + rangeSize, txBlocks.size());
+      ranges.emplace_back(pool.Submit(
+          [&checkBodies, begin, end]() { return checkBodies(begin, end); }));
+    }
+
+    const size_t progressStep = max<size_t>(ranges.size() / 20, 1);
+    bool bodiesFound = true;
+    for (size_t i = 0; i < ranges.size(); i++) {
+      bodiesFound = ranges[i].get() && bodiesFound;
+      if ((i + 1) % progressStep == 0) {
+        LOG_GENERAL(INFO, "Checked bodies of "
+                              << min((i + 1) * rangeSize, txBlocks.size() - 1)
+                              << " / " << txBlocks.size() - 1 << " Tx blocks");
+      }
+    }
+    if (!bodiesFound) {
+      return false;
+    }
   }
   LOG_GENERAL(INFO, "ValidateDB Success");
 
@@ -547,15 +766,42 @@ bool Node::StartRetrieveHistory(const SyncType syncType,
 
   m_retriever = std::make_shared<Retriever>(m_mediator);
 
-  /// Retrieve block link
-  bool ds_result =
-      m_retriever->RetrieveBlockLink(RECOVERY_TRIM_INCOMPLETED_BLOCK &&
-                                     SyncType::RECOVERY_ALL_SYNC == syncType);
+  auto tpRetrieve = r_timer_start();
+  bool ds_result = false;
+  bool st_result = false;
+  bool tx_result = false;
+
+  {
+    /// Retrieve block link on its own thread. It only rebuilds the DS side
+    /// (DS blocks, block links, DS committee), so it can run alongside the
+    /// states and Tx blocks, which only touch the Tx side.
+    auto retrieveBlockLink = [this, syncType, &ds_result]() -> void {
+      auto tpStart = r_timer_start();
+      ds_result = m_retriever->RetrieveBlockLink(
+          RECOVERY_TRIM_INCOMPLETED_BLOCK &&
+          SyncType::RECOVERY_ALL_SYNC == syncType);
+      LOG_GENERAL(INFO, "RetrieveBlockLink " << (ds_result ? "done" : "failed")
+                                             << " in " << r_timer_end(tpStart)
+                                             << " us");
+    };
+    JoinableFunction blockLinkFunc(1, retrieveBlockLink);
+
+    /// Retrieve Tx blocks, relative final-block state-delta from persistence
+    auto tpStart = r_timer_start();
+    st_result = m_retriever->RetrieveStates();
+    LOG_GENERAL(INFO, "RetrieveStates " << (st_result ? "done" : "failed")
+                                        << " in " << r_timer_end(tpStart)
+                                        << " us");
+
+    tpStart = r_timer_start();
+    tx_result = m_retriever->RetrieveTxBlocks(RECOVERY_TRIM_INCOMPLETED_BLOCK);
+    LOG_GENERAL(INFO, "RetrieveTxBlocks " << (tx_result ? "done" : "failed")
+                                          << " in " << r_timer_end(tpStart)
+                                          << " us");
+  }
 
-  /// Retrieve Tx blocks, relative final-block state-delta from persistence
-  bool st_result = m_retriever->RetrieveStates();
-  bool tx_result =
-      m_retriever->RetrieveTxBlocks(RECOVERY_TRIM_INCOMPLETED_BLOCK);
+  LOG_GENERAL(INFO, "Retrieved persistence in " << r_timer_end(tpRetrieve)
+                                                 << " us");
 
   if (!tx_result) {
     return false;
@@ -689,23 +935,20 @@ bool Node::StartRetrieveHistory(const SyncType syncType,
       }
     }
   }
+  m_mediator.m_ds->PublishShardingStructure();
 
   bool bInShardStructure = false;
 
   if (bDS) {
     m_myshardId = m_mediator.m_ds->m_shards.size();
   } else {
-    for (unsigned int i = 0;
-         i < m_mediator.m_ds->m_shards.size() && !bInShardStructure; ++i) {
-      for (const auto& shardNode : m_mediator.m_ds->m_shards.at(i)) {
-        if (get<SHARD_NODE_PUBKEY>(shardNode) == m_mediator.m_selfKey.second) {
-          SetMyshardId(i);
-          LOG_GENERAL(
-              INFO, "This node belongs to sharding structure #" << m_myshardId);
-          bInShardStructure = true;
-          break;
-        }
-      }
+    ShardingStructure::Position position;
+    if (m_mediator.m_ds->GetShardingStructure()->Find(
+            m_mediator.m_selfKey.second, position)) {
+      SetMyshardId(position.shardId);
+      LOG_GENERAL(INFO,
+                  "This node belongs to sharding structure #" << m_myshardId);
+      bInShardStructure = true;
     }
   }
 
@@ -956,6 +1199,27 @@ bool Node::GetOfflineLookups(bool endless) {
   return true;
 }
 
+void Node::GetOfflineLookupsAsync(const function<void(bool)>& done) {
+  m_mediator.m_lookup->RequestUntilAnswered(
+      [this]() { m_synchronizer.FetchOfflineLookups(m_mediator.m_lookup); },
+      [this]() {
+        lock_guard<mutex> lock(
+            m_mediator.m_lookup->m_mutexOfflineLookupsUpdation);
+        return m_mediator.m_lookup->m_fetchedOfflineLookups;
+      },
+      FETCH_LOOKUP_MSG_MAX_RETRY, NEW_NODE_SYNC_INTERVAL,
+      [this, done](bool fetched) {
+        if (!fetched) {
+          LOG_GENERAL(WARNING, "Fetch offline lookup nodes failed");
+        } else {
+          lock_guard<mutex> lock(
+              m_mediator.m_lookup->m_mutexOfflineLookupsUpdation);
+          m_mediator.m_lookup->m_fetchedOfflineLookups = false;
+        }
+        done(fetched);
+      });
+}
+
 void Node::StartSynchronization() {
   if (LOOKUP_NODE_MODE) {
     LOG_GENERAL(WARNING,
@@ -966,27 +1230,31 @@ void Node::StartSynchronization() {
   LOG_MARKER();
 
   SetState(SYNC);
-  auto func = [this]() -> void {
-    if (!GetOfflineLookups()) {
+  GetOfflineLookupsAsync([this](bool fetched) {
+    if (!fetched) {
       LOG_GENERAL(WARNING, "Cannot rejoin currently");
       return;
     }
 
-    while (m_mediator.m_lookup->GetSyncType() != SyncType::NO_SYNC) {
-      m_mediator.m_lookup->ComposeAndSendGetDirectoryBlocksFromSeed(
-          m_mediator.m_blocklinkchain.GetLatestIndex() + 1);
-      m_synchronizer.FetchLatestTxBlockSeed(
-          m_mediator.m_lookup,
-          // m_mediator.m_txBlockChain.GetBlockCount());
-          m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum() +
-              1);
-      this_thread::sleep_for(chrono::seconds(m_mediator.m_lookup->m_startedPoW
-                                                 ? POW_WINDOW_IN_SECONDS
-                                                 : NEW_NODE_SYNC_INTERVAL));
-    }
-  };
-
-  DetachedFunction(1, func);
+    m_mediator.m_lookup->RunWhileSyncing(
+        [this]() {
+          TRACE_SPAN("Sync", m_mediator.m_currentEpochNum);
+          m_mediator.m_lookup->ComposeAndSendGetDirectoryBlocksFromSeed(
+              m_mediator.m_blocklinkchain.GetLatestIndex() + 1);
+          m_synchronizer.FetchLatestTxBlockSeed(
+              m_mediator.m_lookup,
+              // m_mediator.m_txBlockChain.GetBlockCount());
+              m_mediator.m_txBlockChain.GetLastBlock()
+                      .GetHeader()
+                      .GetBlockNum() +
+                  1);
+          m_mediator.m_lookup->SubscribeToBlocksFromSeed();
+        },
+        [this]() {
+          return m_mediator.m_lookup->m_startedPoW ? POW_WINDOW_IN_SECONDS
+                                                   : NEW_NODE_SYNC_INTERVAL;
+        });
+  });
 }
 
 uint32_t Node::CalculateShardLeaderFromDequeOfNode(
@@ -1162,9 +1430,25 @@ bool Node::ProcessSubmitMissingTxn(const bytes& message, unsigned int offset,
     return false;
   }
 
-  lock_guard<mutex> g(m_mutexCreatedTransactions);
-  for (const auto& submittedTxn : txns) {
-    m_createdTxns.insert(submittedTxn);
+  {
+    lock_guard<mutex> g(m_mutexCreatedTransactions);
+    for (const auto& submittedTxn : txns) {
+      m_createdTxns.insert(submittedTxn);
+    }
+    GetTxnPoolSizeGauge().Set(m_createdTxns.size());
+  }
+
+  // Several peers may be answering, so only wake up once all are fetched
+  {
+    lock_guard<mutex> g(m_mutexMissingTxnsToFetch);
+    for (const auto& submittedTxn : txns) {
+      m_missingTxnsToFetch.erase(submittedTxn.GetTranID());
+    }
+    if (!m_missingTxnsToFetch.empty()) {
+      LOG_GENERAL(INFO, "Still missing " << m_missingTxnsToFetch.size()
+                                         << " txns");
+      return true;
+    }
   }
 
   cv_MicroBlockMissingTxn.notify_all();
@@ -1172,8 +1456,15 @@ bool Node::ProcessSubmitMissingTxn(const bytes& message, unsigned int offset,
 }
 
 bool Node::ProcessSubmitTransaction(const bytes& message, unsigned int offset,
-                                    [[gnu::unused]] const Peer& from) {
+                                    const Peer& from) {
   if (LOOKUP_NODE_MODE) {
+    // Shard nodes answer compact microblock forwards with missing txns
+    if (offset < message.size() &&
+        message[offset] == SUBMITTRANSACTIONTYPE::MISSINGTXN) {
+      return ProcessCompactMBnForwardMissingTxn(
+          message, offset + MessageOffset::INST, from);
+    }
+
     LOG_GENERAL(WARNING,
                 "Node::ProcessSubmitTransaction not expected to be called "
                 "from LookUp node.");
@@ -1239,9 +1530,11 @@ bool Node::ProcessTxnPacketFromLookup([[gnu::unused]] const bytes& message,
   vector<Transaction> transactions;
   Signature signature;
 
-  if (!Messenger::GetNodeForwardTxnBlock(message, offset, epochNumber,
-                                         dsBlockNum, shardId, lookupPubKey,
-                                         transactions, signature)) {
+  // Only the header and the packet signature are needed to accept, forward
+  // or buffer the packet; its txns are decoded when it is processed
+  if (!Messenger::GetNodeForwardTxnBlock(
+          message, offset, epochNumber, dsBlockNum, shardId, lookupPubKey,
+          transactions, signature, [](const TxnHash&) { return true; })) {
     LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
               "Messenger::GetNodeForwardTxnBlock failed.");
     return false;
@@ -1259,11 +1552,10 @@ bool Node::ProcessTxnPacketFromLookup([[gnu::unused]] const bytes& message,
   // Avoid using the original message for broadcasting in case it contains
   // excess data beyond the TxnPacket
   bytes message2 = {MessageType::NODE, NodeInstructionType::FORWARDTXNPACKET};
-  if (!Messenger::SetNodeForwardTxnBlock(
-          message2, MessageOffset::BODY, epochNumber, dsBlockNum, shardId,
-          lookupPubKey, transactions, signature)) {
+  if (!Messenger::CopyNodeForwardTxnBlock(message, offset, message2,
+                                          MessageOffset::BODY)) {
     LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
-              "Messenger::GetNodeForwardTxnBlock failed.");
+              "Messenger::CopyNodeForwardTxnBlock failed.");
     return false;
   }
 
@@ -1290,7 +1582,12 @@ bool Node::ProcessTxnPacketFromLookup([[gnu::unused]] const bytes& message,
            0) ||
           m_justDidFallback))) {
       lock_guard<mutex> g2(m_mutexTxnPacketBuffer);
-      m_txnPacketBuffer.emplace_back(message2);
+      const unsigned int dropped =
+          m_txnPacketBuffer.Push(epochNumber, message2, message2.size());
+      if (dropped > 0) {
+        LOG_GENERAL(WARNING, "Txn packet buffer over budget, dropped "
+                                 << dropped << " oldest packets");
+      }
       return true;
     }
   }
@@ -1321,11 +1618,24 @@ bool Node::ProcessTxnPacketFromLookup([[gnu::unused]] const bytes& message,
               << m_mediator.m_currentEpochNum << "][" << shardId << "]["
               << string(lookupPubKey).substr(0, 6) << "][" << message2.size()
               << "] RECVFROMLOOKUP");
-    m_txnPacketBuffer.emplace_back(message2);
+    const unsigned int dropped =
+        m_txnPacketBuffer.Push(epochNumber, message2, message2.size());
+    if (dropped > 0) {
+      LOG_GENERAL(WARNING, "Txn packet buffer over budget, dropped "
+                               << dropped << " oldest packets");
+    }
   } else {
     LOG_GENERAL(INFO,
                 "Packet received from a non-lookup node, "
                 "should be from gossip neighbor and process it");
+    if (!Messenger::GetNodeForwardTxnBlock(
+            message2, MessageOffset::BODY, epochNumber, dsBlockNum, shardId,
+            lookupPubKey, transactions, signature,
+            [this](const TxnHash& txnHash) { return IsTxnKnown(txnHash); })) {
+      LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
+                "Messenger::GetNodeForwardTxnBlock failed.");
+      return false;
+    }
     return ProcessTxnPacketFromLookupCore(message2, epochNumber, dsBlockNum,
                                           shardId, lookupPubKey, transactions);
   }
@@ -1466,15 +1776,29 @@ bool Node::ProcessTxnPacketFromLookupCore(const bytes& message,
   // Process the txns
   unsigned int processed_count = 0;
 
+  // Taken before the checks, so a state change during them drops the tags
+  const StateHash stateRoot = AccountStore::GetInstance().GetStateRootHash();
+
   LOG_GENERAL(INFO, "Start check txn packet from lookup");
 
+  // Check all the signatures in one batch up front
+  vector<bool> validSignatures;
+  if (!m_mediator.m_validator->VerifyTransactions(txns, validSignatures)) {
+    LOG_GENERAL(WARNING, "Txn packet has invalid signatures");
+  }
+
   std::vector<Transaction> checkedTxns;
-  for (const auto& txn : txns) {
+  for (unsigned int i = 0; i < txns.size(); i++) {
+    const auto& txn = txns.at(i);
     if (m_mediator.GetIsVacuousEpoch()) {
       LOG_GENERAL(WARNING, "Already in vacuous epoch, stop proc txn");
       return false;
     }
-    if (m_mediator.m_validator->CheckCreatedTransactionFromLookup(txn)) {
+    if (!validSignatures.at(i)) {
+      LOG_GENERAL(WARNING, "Signature incorrect. Transaction rejected: "
+                               << txn.GetTranID());
+    } else if (m_mediator.m_validator->CheckCreatedTransactionFromLookup(
+                   txn, false)) {
       checkedTxns.push_back(txn);
     } else {
       LOG_GENERAL(WARNING, "Txn is not valid.");
@@ -1492,14 +1816,22 @@ bool Node::ProcessTxnPacketFromLookupCore(const bytes& message,
     LOG_GENERAL(INFO,
                 "TxnPool size before processing: " << m_createdTxns.size());
 
+    if (m_preCheckedStateRoot != stateRoot) {
+      m_preCheckedTxns.clear();
+      m_preCheckedStateRoot = stateRoot;
+    }
+
     for (const auto& txn : checkedTxns) {
       m_createdTxns.insert(txn);
+      m_preCheckedTxns.insert(txn.GetTranID());
     }
 
     LOG_GENERAL(INFO, "Txn processed: " << processed_count
                                         << " TxnPool size after processing: "
                                         << m_createdTxns.size());
+    GetTxnPoolSizeGauge().Set(m_createdTxns.size());
   }
+  cv_TxnsQueued.notify_all();
 
   LOG_STATE("[TXNPKTPROC][" << std::setw(15) << std::left
                             << m_mediator.m_selfPeer.GetPrintableIPAddress()
@@ -1549,6 +1881,11 @@ bool Node::ProcessProposeGasPrice([[gnu::unused]] const bytes& message,
   return true;
 }
 
+bool Node::IsTxnKnown(const TxnHash& txnHash) {
+  lock_guard<mutex> g(m_mutexCreatedTransactions);
+  return m_createdTxns.exist(txnHash);
+}
+
 void Node::CommitTxnPacketBuffer() {
   LOG_MARKER();
 
@@ -1560,7 +1897,8 @@ void Node::CommitTxnPacketBuffer() {
   }
 
   lock_guard<mutex> g(m_mutexTxnPacketBuffer);
-  for (const auto& message : m_txnPacketBuffer) {
+  for (const auto& packet : m_txnPacketBuffer.TakeAll()) {
+    const bytes& message = packet.second;
     uint64_t epochNumber = 0, dsBlockNum = 0;
     uint32_t shardId = 0;
     PubKey lookupPubKey;
@@ -1569,7 +1907,8 @@ void Node::CommitTxnPacketBuffer() {
 
     if (!Messenger::GetNodeForwardTxnBlock(
             message, MessageOffset::BODY, epochNumber, dsBlockNum, shardId,
-            lookupPubKey, transactions, signature)) {
+            lookupPubKey, transactions, signature,
+            [this](const TxnHash& txnHash) { return IsTxnKnown(txnHash); })) {
       LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
                 "Messenger::GetNodeForwardTxnBlock failed.");
       return;
@@ -1578,7 +1917,6 @@ void Node::CommitTxnPacketBuffer() {
     ProcessTxnPacketFromLookupCore(message, epochNumber, dsBlockNum, shardId,
                                    lookupPubKey, transactions);
   }
-  m_txnPacketBuffer.clear();
 }
 
 // Used by Zilliqa in pow branch. This will be useful for us when doing the
@@ -1645,6 +1983,8 @@ void Node::RejoinAsNormal(bool rejoiningAfterRecover) {
     auto func = [this, rejoiningAfterRecover]() mutable -> void {
       while (true) {
         m_mediator.m_lookup->SetSyncType(SyncType::NORMAL_SYNC);
+        // The databases are about to be replaced
+        this->WaitForStoragePipeline();
         this->CleanVariables();
         this->m_mediator.m_ds->CleanVariables();
         while (!this->DownloadPersistenceFromS3()) {
@@ -1752,10 +2092,13 @@ void Node::CleanCreatedTransaction() {
     std::lock_guard<mutex> g(m_mutexCreatedTransactions);
     m_createdTxns.clear();
     t_createdTxns.clear();
+    m_preCheckedTxns.clear();
+    ResetEpochArena();
+    GetTxnPoolSizeGauge().Set(0);
   }
   {
     std::lock_guard<mutex> g(m_mutexTxnPacketBuffer);
-    m_txnPacketBuffer.clear();
+    m_txnPacketBuffer.Clear();
   }
   {
     std::lock_guard<mutex> lock(m_mutexProcessedTransactions);
@@ -1769,19 +2112,12 @@ void Node::CleanCreatedTransaction() {
 
 bool Node::IsShardNode(const PubKey& pubKey) {
   lock_guard<mutex> lock(m_mutexShardMember);
-  return std::find_if(m_myShardMembers->begin(), m_myShardMembers->end(),
-                      [&pubKey](const PairOfNode& node) {
-                        return node.first == pubKey;
-                      }) != m_myShardMembers->end();
+  return m_myShardMembersIndex.Contains(*m_myShardMembers, pubKey);
 }
 
 bool Node::IsShardNode(const Peer& peerInfo) {
   lock_guard<mutex> lock(m_mutexShardMember);
-  return std::find_if(m_myShardMembers->begin(), m_myShardMembers->end(),
-                      [&peerInfo](const PairOfNode& node) {
-                        return node.second.GetIpAddress() ==
-                               peerInfo.GetIpAddress();
-                      }) != m_myShardMembers->end();
+  return m_myShardMembersIndex.Contains(*m_myShardMembers, peerInfo);
 }
 
 bool Node::ProcessDoRejoin(const bytes& message, unsigned int offset,
@@ -2072,7 +2408,8 @@ void Node::SendBlockToOtherShardNodes(const bytes& message,
                           << std::get<SHARD_NODE_PUBKEY>(kv) << " "
                           << std::get<SHARD_NODE_PEER>(kv));
   }
-  P2PComm::GetInstance().SendBroadcastMessage(shardBlockReceivers, message);
+  P2PComm::GetInstance().SendChunkedBroadcastMessage(
+      shardBlockReceivers, make_shared<const bytes>(message));
 }
 
 bool Node::Execute(const bytes& message, unsigned int offset,
@@ -2098,6 +2435,8 @@ bool Node::Execute(const bytes& message, unsigned int offset,
       &Node::ProcessFallbackBlock,
       &Node::ProcessProposeGasPrice,
       &Node::ProcessDSGuardNetworkInfoUpdate,
+      &Node::ProcessMBnForwardTransactionCompact,
+      &Node::ProcessMissingTxnRequest,
   };
 
   const unsigned char ins_byte = message.at(offset);
@@ -19,11 +19,14 @@
 
 #include <condition_variable>
 #include <deque>
+#include <functional>
+#include <future>
 #include <list>
 #include <map>
 #include <mutex>
 #include <shared_mutex>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "common/Constants.h"
@@ -35,11 +38,19 @@
 #include "libData/AccountData/TransactionReceipt.h"
 #include "libData/AccountData/TxnPool.h"
 #include "libData/BlockData/Block.h"
+#include "libData/DataStructures/FlatHashMap.h"
 #include "libLookup/Synchronizer.h"
 #include "libNetwork/DataSender.h"
+#include "libNetwork/NodeIndex.h"
 #include "libNetwork/P2PComm.h"
 #include "libPersistence/BlockStorage.h"
+#include "libUtils/BoundedBuffer.h"
+#include "libUtils/EpochArena.h"
+#include "libUtils/Metrics.h"
+#include "libUtils/Scheduler.h"
+#include "libUtils/ThreadPool.h"
 
+class AddrNonceTxnQueue;
 class Mediator;
 class Retriever;
 
@@ -104,7 +115,8 @@ class Node : public Executable {
   std::condition_variable cv_waitDSBlock;
 
   // Final Block Buffer for seed node
-  std::vector<bytes> m_seedTxnBlksBuffer;
+  BoundedBuffer<bytes> m_seedTxnBlksBuffer{uint64_t{SEED_TXN_BLKS_BUFFER_MB} *
+                                           1024 * 1024};
   std::mutex m_mutexSeedTxnBlksBuffer;
 
   // Persistence Retriever
@@ -121,12 +133,28 @@ class Node : public Executable {
   std::atomic<bool> m_txn_distribute_window_open;
   std::mutex m_mutexCreatedTransactions;
   TxnPool m_createdTxns, t_createdTxns;
+  // Txns in m_createdTxns that passed CheckCreatedTransactionFromLookup when
+  // the state root was m_preCheckedStateRoot, so composing a microblock can
+  // skip those checks; operates under m_mutexCreatedTransactions
+  std::unordered_set<TxnHash> m_preCheckedTxns;
+  dev::h256 m_preCheckedStateRoot;
   std::vector<TxnHash> m_expectedTranOrdering;
   std::mutex m_mutexProcessedTransactions;
   std::unordered_map<uint64_t,
-                     std::unordered_map<TxnHash, TransactionWithReceipt>>
+                     FixedHashMap<TxnHash, TransactionWithReceipt>>
       m_processedTransactions;
-  std::unordered_map<TxnHash, TransactionWithReceipt> t_processedTransactions;
+  FixedHashMap<TxnHash, TransactionWithReceipt> t_processedTransactions;
+  // Memory of the containers that only live while the txns of a microblock
+  // are selected; operates under m_mutexCreatedTransactions
+  EpochArena m_epochArena;
+  // Nonces in AccountStoreTemp of the senders seen while composing the
+  // microblock, so the selection loop need not take the account store locks
+  // for every lookup; only touched by the selection loop
+  typedef std::unordered_map<
+      Address, uint64_t, std::hash<Address>, std::equal_to<Address>,
+      ArenaAllocator<std::pair<const Address, uint64_t>>>
+      SenderNonceMap;
+  SenderNonceMap t_senderNonces;
   // operates under m_mutexProcessedTransaction
   std::vector<TxnHash> m_TxnOrder;
 
@@ -138,15 +166,32 @@ class Node : public Executable {
   //     m_committedTransactions;
 
   std::mutex m_mutexMBnForwardedTxnBuffer;
-  std::unordered_map<uint64_t, std::vector<MBnForwardedTxnEntry>>
-      m_mbnForwardedTxnBuffer;
+  BoundedBuffer<MBnForwardedTxnEntry> m_mbnForwardedTxnBuffer{
+      uint64_t{MBNFORWARD_TXN_BUFFER_MB} * 1024 * 1024};
+
+  // Compact forwards still waiting for missing txn bodies from the sender
+  struct CompactMBnForwardEntry {
+    MicroBlock m_microBlock;
+    std::vector<TransactionReceipt> m_receipts;
+    std::unordered_map<TxnHash, Transaction> m_transactions;
+  };
+  std::mutex m_mutexCompactMBnForwardBuffer;
+  std::unordered_map<BlockHash, CompactMBnForwardEntry>
+      m_compactMBnForwardBuffer;
 
   std::mutex m_mutexTxnPacketBuffer;
-  std::vector<bytes> m_txnPacketBuffer;
+  BoundedBuffer<bytes> m_txnPacketBuffer{uint64_t{TXN_PACKET_BUFFER_MB} *
+                                         1024 * 1024};
+
+  // txn proc timeout related. A timeout callback only fires for the round of
+  // txn processing it was scheduled for.
+  std::mutex m_mutexTxnProcTimeout;
+  uint64_t m_txnProcRound = 0;
+  std::atomic<bool> m_txnProcTimeout{false};
+  Scheduler::TaskHandle m_txnProcTimeoutHandle = 0;
 
-  // txn proc timeout related
-  std::mutex m_mutexCVTxnProcFinished;
-  std::condition_variable cv_TxnProcFinished;
+  // Notified when txns are added to m_createdTxns
+  std::condition_variable cv_TxnsQueued;
 
   std::mutex m_mutexMicroBlockConsensusBuffer;
   std::unordered_map<uint32_t, VectorOfNodeMsg> m_microBlockConsensusBuffer;
@@ -155,6 +200,7 @@ class Node : public Executable {
   std::mutex m_mutexFallbackTimer;
   uint32_t m_fallbackTimer;
   bool m_fallbackTimerLaunched = false;
+  Scheduler::TaskHandle m_fallbackTimerHandle = 0;
   bool m_fallbackStarted;
   std::mutex m_mutexPendingFallbackBlock;
   std::shared_ptr<FallbackBlock> m_pendingFallbackBlock;
@@ -204,8 +250,22 @@ class Node : public Executable {
   bool IsMicroBlockTxRootHashInFinalBlock(const MBnForwardedTxnEntry& entry,
                                           bool& isEveryMicroBlockAvailable);
 
+  /// Runs the disk writes of the final blocks, one at a time in the order
+  /// queued, so that the next epoch need not wait for them
+  ThreadPool m_storagePipeline{1, "StoragePipeline"};
+  std::mutex m_mutexStoragePipeline;
+  /// The write queued last, done once all those before it are
+  std::shared_future<void> m_lastStorageJob;
+
+  /// Queues job behind the writes already queued, or runs it now if
+  /// ASYNC_BLOCK_STORAGE is off
+  void QueueStorage(const std::function<void()>& job);
+
   // void StoreMicroBlocks();
   void StoreFinalBlock(const TxBlock& txBlock);
+  /// Prunes, in the background, the state deltas and txn bodies older than
+  /// the retention of this node's role, once a DS epoch
+  void PruneHistory(const uint64_t& txBlockNum);
   void InitiatePoW();
   void ScheduleMicroBlockConsensus();
   void BeginNextConsensusRound();
@@ -240,6 +300,18 @@ class Node : public Executable {
   bool ProcessMBnForwardTransaction(const bytes& message,
                                     unsigned int cur_offset, const Peer& from);
   bool ProcessMBnForwardTransactionCore(const MBnForwardedTxnEntry& entry);
+  bool ProcessMBnForwardedTxnEntry(const MBnForwardedTxnEntry& entry,
+                                   const Peer& from);
+  bool ProcessMBnForwardTransactionCompact(const bytes& message,
+                                           unsigned int offset,
+                                           const Peer& from);
+  bool ProcessMissingTxnRequest(const bytes& message, unsigned int offset,
+                                const Peer& from);
+  bool ProcessCompactMBnForwardMissingTxn(const bytes& message,
+                                          unsigned int offset,
+                                          const Peer& from);
+  bool BuildCompactMBnForwardEntry(const CompactMBnForwardEntry& compact,
+                                   MBnForwardedTxnEntry& entry);
   bool ProcessTxnPacketFromLookup(const bytes& message, unsigned int offset,
                                   const Peer& from);
   bool ProcessTxnPacketFromLookupCore(const bytes& message,
@@ -248,6 +320,9 @@ class Node : public Executable {
                                       const uint32_t& shardId,
                                       const PubKey& lookupPubKey,
                                       const std::vector<Transaction>& txns);
+  /// Whether the txn is already in the created txn pool, so that re-sent
+  /// copies in later txn packets need not be decoded again
+  bool IsTxnKnown(const TxnHash& txnHash);
   bool ProcessProposeGasPrice(const bytes& message, unsigned int offset,
                               const Peer& from);
 
@@ -289,11 +364,18 @@ class Node : public Executable {
   bool CheckMicroBlockshardId();
   bool CheckMicroBlockTimestamp();
   bool CheckMicroBlockHashes(bytes& errorMsg);
-  bool CheckMicroBlockTxnRootHash();
-  bool CheckMicroBlockStateDeltaHash();
-  bool CheckMicroBlockTranReceiptHash();
-
-  void NotifyTimeout(bool& txnProcTimeout);
+  bool CheckMicroBlockTxnRootHash(const TxnHash& expectedTxRootHash);
+  bool CheckMicroBlockStateDeltaHash(const StateHash& expectedStateDeltaHash);
+  bool CheckMicroBlockTranReceiptHash(
+      const std::pair<bool, TxnHash>& expectedTranHash);
+
+  /// Starts a round of txn processing and schedules its timeout
+  void ScheduleTxnProcTimeout();
+  /// Ends the round, so its timeout callback does nothing
+  void CancelTxnProcTimeout();
+  /// Waits timeoutMs for txns to arrive, or only until m_createdTxns holds a
+  /// microblock's worth of gas if ENABLE_EARLY_MICROBLOCK_COMPOSITION is set
+  void WaitForQueuedTxns(unsigned int timeoutMs);
   bool VerifyTxnsOrdering(const std::vector<TxnHash>& tranHashes,
                           std::vector<TxnHash>& missingtranHashes);
 
@@ -377,12 +459,23 @@ class Node : public Executable {
 
   std::mutex m_mutexShardMember;
   std::shared_ptr<DequeOfNode> m_myShardMembers;
+  // Index of *m_myShardMembers, guarded by m_mutexShardMember
+  NodeIndex m_myShardMembersIndex;
 
   std::shared_ptr<MicroBlock> m_microblock;
 
+  /// Runs the parts of a micro block or final block check that depend on
+  /// none of the others, alongside them
+  ThreadPool m_validationPool{2, "BlockValidation"};
+
   std::mutex m_mutexCVMicroBlockMissingTxn;
   std::condition_variable cv_MicroBlockMissingTxn;
 
+  // Missing txns of the proposed microblock not yet received from any peer
+  std::mutex m_mutexMissingTxnsToFetch;
+  std::unordered_set<TxnHash> m_missingTxnsToFetch;
+  uint64_t m_missingTxnsFetchRound = 0;
+
   // std::condition_variable m_cvNewRoundStarted;
   // std::mutex m_mutexNewRoundStarted;
   // bool m_newRoundStarted = false;
@@ -426,6 +519,10 @@ class Node : public Executable {
   /// Destructor.
   ~Node();
 
+  /// Waits for the disk writes of the final blocks processed so far, for
+  /// anything that reads them back or replaces the databases
+  void WaitForStoragePipeline();
+
   /// Install the Node
   bool Install(const SyncType syncType, const bool toRetrieveHistory = true,
                bool rejoiningAfterRecover = false);
@@ -479,6 +576,10 @@ class Node : public Executable {
 
   void CommitMBnForwardedTransactionBuffer();
 
+  /// Stores a micro block and its txns fetched from another lookup, once
+  /// they are checked against the stored Tx block
+  bool CommitFetchedMicroBlockTxns(const MBnForwardedTxnEntry& entry);
+
   void CleanCreatedTransaction();
 
   void AddBalanceToGenesisAccount();
@@ -497,10 +598,33 @@ class Node : public Executable {
 
   void ProcessTransactionWhenShardLeader();
   void ProcessTransactionWhenShardBackup();
+  /// Takes payment txns with the expected nonce and distinct senders from
+  /// t_createdTxns and applies them as one batch, with the same outcome and
+  /// order as the serial loop. Returns false if no txn was taken.
+  bool ProcessPaymentTxnBatch(
+      AddrNonceTxnQueue& addrNonceTxnQueue,
+      const std::function<void(const Transaction&, const TransactionReceipt&)>&
+          appendOne);
+  /// Drops the pre-check tags once the permanent states have changed
+  void DropStalePreCheckedTxns();
+  bool IsTxnPreChecked(const Transaction& t) const;
+  /// Returns the sender's nonce in AccountStoreTemp, through t_senderNonces
+  uint64_t GetSenderNonceTemp(const Address& senderAddr);
+  /// Keeps t_senderNonces coherent after a txn was applied to AccountStoreTemp
+  void UpdateSenderNonceTemp(const Transaction& t, bool applied);
+  /// Empties t_senderNonces and makes the memory of m_epochArena available
+  /// again. Nothing else allocated from the arena may still exist.
+  void ResetEpochArena();
+  /// Exported number of txns in m_createdTxns
+  static Metrics::Gauge& GetTxnPoolSizeGauge();
+  /// Re-applies the leader's txns in the leader's order, with independent
+  /// payment txns applied concurrently
+  bool ReplayTxnsInLeaderOrder(const std::vector<TxnHash>& tranHashes);
   bool ComposeMicroBlock();
   bool CheckMicroBlockValidity(bytes& errorMsg);
   bool OnNodeMissingTxns(const bytes& errorMsg, const unsigned int offset,
                          const Peer& from);
+  void FetchMissingTxns(const std::vector<TxnHash>& missingTxnHashes);
 
   void UpdateStateForNextConsensusRound();
 
@@ -563,6 +687,10 @@ class Node : public Executable {
   /// Fetch offline lookups with a counter for retrying
   bool GetOfflineLookups(bool endless = false);
 
+  /// Fetch offline lookups on the scheduler in the same way, without
+  /// blocking, then run done with whether they were fetched
+  void GetOfflineLookupsAsync(const std::function<void(bool)>& done);
+
   /// Fetch latest ds block with a counter for retrying
   bool GetLatestDSBlock();
 
@@ -38,6 +38,7 @@
 #include "libData/AccountData/Account.h"
 #include "libData/AccountData/AccountStore.h"
 #include "libData/AccountData/Transaction.h"
+#include "libLookup/Lookup.h"
 #include "libMediator/Mediator.h"
 #include "libMessage/Messenger.h"
 #include "libNetwork/Guard.h"
@@ -296,6 +297,12 @@ bool Node::SendPoWResultToDSComm(const uint64_t& block_num,
     return false;
   }
 
+  // The lookups check and batch the submissions for the DS committee
+  if (POW_SUBMISSION_RELAY) {
+    m_mediator.m_lookup->SendMessageToLookupNodes(powmessage);
+    return true;
+  }
+
   vector<Peer> peerList;
 
   // Send to PoW PACKET_SENDERS which including DS leader
@@ -43,6 +43,7 @@
 #include "libUtils/SanityChecks.h"
 #include "libUtils/TimeLockedFunction.h"
 #include "libUtils/TimeUtils.h"
+#include "libUtils/Tracing.h"
 
 using namespace std;
 using namespace boost::multiprecision;
@@ -53,7 +54,7 @@ bool Node::VerifyVCBlockCoSignature(const VCBlock& vcblock) {
   unsigned int index = 0;
   unsigned int count = 0;
 
-  const vector<bool>& B2 = vcblock.GetB2();
+  const BitVector& B2 = vcblock.GetB2();
   if (m_mediator.m_DSCommittee->size() != B2.size()) {
     LOG_GENERAL(WARNING, "Mismatch: DS committee size = "
                              << m_mediator.m_DSCommittee->size()
@@ -85,7 +86,7 @@ bool Node::VerifyVCBlockCoSignature(const VCBlock& vcblock) {
 
   // Verify the collective signature
   bytes message;
-  if (!vcblock.GetHeader().Serialize(message, 0)) {
+  if (!vcblock.GetHeader().SerializeCached(message, 0)) {
     LOG_GENERAL(WARNING, "VCBlockHeader serialization failed");
     return false;
   }
@@ -106,6 +107,7 @@ bool Node::VerifyVCBlockCoSignature(const VCBlock& vcblock) {
 bool Node::ProcessVCBlock(const bytes& message, unsigned int cur_offset,
                           [[gnu::unused]] const Peer& from) {
   LOG_MARKER();
+  TRACE_SPAN("ViewChange.Process", m_mediator.m_currentEpochNum);
 
   VCBlock vcblock;
 
@@ -234,6 +236,7 @@ bool Node::ProcessVCBlockCore(const VCBlock& vcblock) {
   }
 
   UpdateDSCommiteeCompositionAfterVC(vcblock, *m_mediator.m_DSCommittee);
+  m_mediator.PublishEpochContext();
 
   if (LOOKUP_NODE_MODE) {
     LOG_STATE("[VCBLK] DS = " << vcblock.GetHeader().GetViewChangeDSEpochNo()
@@ -15,9 +15,15 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <pthread.h>
+#include <sched.h>
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
+#include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <ctime>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
 
@@ -27,6 +33,8 @@
 #include "libCrypto/Sha2.h"
 #include "libServer/GetWorkServer.h"
 #include "libUtils/DataConversion.h"
+#include "libUtils/DetachedFunction.h"
+#include "libUtils/ThreadRoles.h"
 #include "pow.h"
 
 #ifdef OPENCL_MINE
@@ -39,6 +47,124 @@
 
 using namespace boost::multiprecision;
 
+namespace {
+// Pins the calling thread to core index, wrapping around the cores present
+void PinToCore(unsigned int index) {
+#if defined(__linux__)
+  const unsigned int numCores =
+      std::max(1U, std::thread::hardware_concurrency());
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  CPU_SET(index % numCores, &cpuSet);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) != 0) {
+    LOG_GENERAL(WARNING, "Failed to pin mining thread " << index
+                                                        << " to a core");
+  }
+#else
+  LOG_GENERAL(WARNING, "CPU_MINE_AFFINITY not supported on this platform, "
+                       "mining thread "
+                           << index << " not pinned");
+#endif
+}
+
+// Sets how ethash allocates the full datasets created from now on
+void SetFullDatasetAllocation() {
+  int flags = 0;
+  if (FULL_DATASET_HUGE_PAGES == "transparent") {
+    flags |= ETHASH_ALLOC_TRANSPARENT_HUGE_PAGES;
+  } else if (FULL_DATASET_HUGE_PAGES == "explicit") {
+    flags |= ETHASH_ALLOC_EXPLICIT_HUGE_PAGES;
+  } else if (FULL_DATASET_HUGE_PAGES != "none") {
+    LOG_GENERAL(WARNING, "Unknown FULL_DATASET_HUGE_PAGES "
+                             << FULL_DATASET_HUGE_PAGES
+                             << ", using ordinary pages");
+  }
+  if (FULL_DATASET_NUMA_INTERLEAVE) {
+    flags |= ETHASH_ALLOC_NUMA_INTERLEAVE;
+  }
+  ethash_set_full_dataset_alloc_flags(flags);
+}
+
+std::string FullDatasetPath(int epochNumber) {
+  return ETHASH_DAG_DIR + "/full-" + std::to_string(epochNumber);
+}
+
+size_t FullDatasetSize(const ethash::epoch_context_full& context) {
+  return ethash::get_full_dataset_size(context.full_dataset_num_items);
+}
+
+// Reads the dataset saved by SaveFullDataset, checking a few of its items
+bool LoadFullDataset(ethash::epoch_context_full& context) {
+  if (ETHASH_DAG_DIR.empty()) {
+    return false;
+  }
+
+  const std::string path = FullDatasetPath(context.epoch_number);
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+
+  const size_t size = FullDatasetSize(context);
+  char* data = reinterpret_cast<char*>(context.full_dataset);
+  file.read(data, size);
+  bool valid = file.gcount() == static_cast<std::streamsize>(size) &&
+               file.peek() == std::ifstream::traits_type::eof();
+
+  const uint32_t numItems = context.full_dataset_num_items;
+  for (uint32_t index : {0U, numItems / 2, numItems - 1}) {
+    if (!valid) {
+      break;
+    }
+    const ethash::hash1024 item =
+        ethash::calculate_dataset_item(context, index);
+    valid = std::memcmp(&item, &context.full_dataset[index], sizeof(item)) == 0;
+  }
+
+  if (!valid) {
+    LOG_GENERAL(WARNING, "Ignoring invalid ethash dataset " << path);
+    std::memset(data, 0, size);
+    return false;
+  }
+
+  LOG_GENERAL(INFO, "Loaded ethash dataset " << path);
+  return true;
+}
+
+void SaveFullDataset(const ethash::epoch_context_full& context) {
+  if (ETHASH_DAG_DIR.empty()) {
+    return;
+  }
+
+  boost::system::error_code ec;
+  boost::filesystem::create_directories(ETHASH_DAG_DIR, ec);
+
+  // Written aside first, so that a crash never leaves a partial dataset
+  const std::string path = FullDatasetPath(context.epoch_number);
+  const std::string tmpPath = path + ".tmp";
+  {
+    std::ofstream file(tmpPath, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(context.full_dataset),
+               FullDatasetSize(context));
+    if (!file) {
+      LOG_GENERAL(WARNING, "Failed to save ethash dataset " << path);
+      boost::filesystem::remove(tmpPath, ec);
+      return;
+    }
+  }
+
+  boost::filesystem::rename(tmpPath, path, ec);
+  if (ec) {
+    LOG_GENERAL(WARNING,
+                "Failed to save ethash dataset " << path << ": "
+                                                 << ec.message());
+    return;
+  }
+
+  LOG_GENERAL(INFO, "Saved ethash dataset " << path);
+}
+}  // namespace
+
 POW::POW() {
   m_currentBlockNum = 0;
   m_epochContextLight =
@@ -50,15 +176,18 @@ POW::POW() {
 
   if (!GETWORK_SERVER_MINE && FULL_DATASET_MINE && !CUDA_GPU_MINE &&
       !OPENCL_GPU_MINE && !REMOTE_MINE) {
-    m_epochContextFull = ethash::create_epoch_context_full(
-        ethash::get_epoch_number(m_currentBlockNum));
+    SetFullDatasetAllocation();
+    m_epochContextFull = CreateEpochContextFull(
+        ethash::get_epoch_number(m_currentBlockNum), true);
   }
 
   if (!LOOKUP_NODE_MODE) {
+    // Rigs with both kinds of GPU mine on all of them at once
+    if (CUDA_GPU_MINE) {
+      InitCUDA();
+    }
     if (OPENCL_GPU_MINE) {
       InitOpenCL();
-    } else if (CUDA_GPU_MINE) {
-      InitCUDA();
     }
   }
 }
@@ -236,27 +365,104 @@ bool POW::EthashConfigureClient(uint64_t block_number, bool fullDataset) {
                     << " currentBlockNum: " << m_currentBlockNum);
   }
 
-  if (ethash::get_epoch_number(block_number) !=
-      ethash::get_epoch_number(m_currentBlockNum)) {
-    auto epochNumber = ethash::get_epoch_number(block_number);
-    m_epochContextLight = ethash::create_epoch_context(epochNumber);
-  }
+  const int epochNumber = ethash::get_epoch_number(block_number);
 
   bool isMineFullCpu = fullDataset && !CUDA_GPU_MINE && !OPENCL_GPU_MINE &&
                        !GETWORK_SERVER_MINE && !REMOTE_MINE;
 
+  if (epochNumber != ethash::get_epoch_number(m_currentBlockNum)) {
+    if (m_nextEpochContexts.valid() && m_nextEpochNumber == epochNumber) {
+      // Waits for the build if it has not finished yet
+      EpochContexts next = m_nextEpochContexts.get();
+      m_epochContextLight = next.m_light;
+      if (next.m_full) {
+        m_epochContextFull = next.m_full;
+      }
+    } else {
+      m_epochContextLight = ethash::create_epoch_context(epochNumber);
+    }
+  }
+
   if (isMineFullCpu && (m_epochContextFull == nullptr ||
-                        ethash::get_epoch_number(block_number) !=
-                            ethash::get_epoch_number(m_currentBlockNum))) {
-    m_epochContextFull = ethash::create_epoch_context_full(
-        ethash::get_epoch_number(block_number));
+                        m_epochContextFull->epoch_number != epochNumber)) {
+    m_epochContextFull = CreateEpochContextFull(epochNumber, true);
   }
 
   m_currentBlockNum = block_number;
 
+  const uint64_t blocksToNextEpoch =
+      ethash::epoch_length - block_number % ethash::epoch_length;
+  if (blocksToNextEpoch <= ETHASH_PRECOMPUTE_BLOCKS &&
+      m_nextEpochNumber != epochNumber + 1) {
+    const int nextEpochNumber = epochNumber + 1;
+    LOG_GENERAL(INFO, "Building ethash epoch " << nextEpochNumber
+                                               << " contexts in background");
+    m_nextEpochNumber = nextEpochNumber;
+    m_nextEpochContexts =
+        std::async(std::launch::async, [nextEpochNumber, isMineFullCpu]() {
+          EpochContexts next;
+          next.m_light = ethash::create_epoch_context(nextEpochNumber);
+          if (isMineFullCpu) {
+            next.m_full = CreateEpochContextFull(nextEpochNumber, false);
+            FillFullDataset(*next.m_full);
+          }
+          return next;
+        });
+  }
+
   return true;
 }
 
+std::shared_ptr<ethash::epoch_context_full> POW::CreateEpochContextFull(
+    int epochNumber, bool fillInBackground) {
+  std::shared_ptr<ethash::epoch_context_full> context =
+      ethash::create_epoch_context_full(epochNumber);
+  if (context == nullptr) {
+    LOG_GENERAL(WARNING, "Failed to create ethash epoch " << epochNumber
+                                                          << " full context");
+    return context;
+  }
+
+  if (!LoadFullDataset(*context) && fillInBackground) {
+    // Mining fills the items it reads meanwhile, the same way
+    DetachedFunction(1, [context]() { FillFullDataset(*context); });
+  }
+
+  return context;
+}
+
+void POW::FillFullDataset(ethash::epoch_context_full& context) {
+  LOG_MARKER();
+
+  const uint32_t numItems = context.full_dataset_num_items;
+  const unsigned int numThreads =
+      std::max(1U, std::thread::hardware_concurrency());
+  const uint32_t itemsPerThread = (numItems + numThreads - 1) / numThreads;
+
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < numThreads; i++) {
+    threads.emplace_back([&context, i, itemsPerThread, numItems]() {
+      // Pages go to the NUMA node of the thread that first writes them, so
+      // fill on the CPUs that will mine
+      ThreadRoles::GetInstance().ApplyToCurrentThread("Mining");
+      const uint32_t begin = std::min(numItems, i * itemsPerThread);
+      const uint32_t end = std::min(numItems, begin + itemsPerThread);
+      for (uint32_t index = begin; index < end; index++) {
+        ethash::hash1024& item = context.full_dataset[index];
+        if (item.words[0] == 0) {
+          ethash::store_dataset_item(
+              item, ethash::calculate_dataset_item(context, index));
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  SaveFullDataset(context);
+}
+
 ethash_mining_result_t POW::MineGetWork(uint64_t blockNum,
                                         ethash_hash256 const& headerHash,
                                         uint8_t difficulty, int timeWindow) {
@@ -275,98 +481,138 @@ ethash_mining_result_t POW::MineGetWork(uint64_t blockNum,
   return result;
 }
 
-ethash_mining_result_t POW::MineLight(ethash_hash256 const& headerHash,
-                                      ethash_hash256 const& boundary,
-                                      uint64_t startNonce, int timeWindow) {
-  uint64_t nonce = startNonce;
+template <class Context>
+ethash_mining_result_t POW::MineCPU(const Context& context,
+                                    ethash_hash256 const& headerHash,
+                                    ethash_hash256 const& boundary,
+                                    uint64_t startNonce, int timeWindow) {
+  const unsigned int numThreads =
+      CPU_MINE_THREADS > 0 ? CPU_MINE_THREADS
+                           : std::max(1U, std::thread::hardware_concurrency());
   auto startTime = std::chrono::high_resolution_clock::now();
 
-  while (m_shouldMine) {
-    auto mineResult = ethash::hash(*m_epochContextLight, headerHash, nonce);
-    if (ethash::is_less_or_equal(mineResult.final_hash, boundary)) {
-      ethash_mining_result_t winning_result = {
-          BlockhashToHexString(mineResult.final_hash),
-          BlockhashToHexString(mineResult.mix_hash), nonce, true};
-      return winning_result;
-    }
-    nonce++;
+  std::atomic<bool> found{false};
+  std::mutex mutexResult;
+  ethash_mining_result_t result = {"", "", 0, false};
+
+  // Thread index tries startNonce + index, then every numThreads-th nonce
+  // after it, so the threads never hash the same nonce
+  auto worker = [&](unsigned int index) {
+    for (uint64_t nonce = startNonce + index; m_shouldMine && !found;
+         nonce += numThreads) {
+      auto mineResult = ethash::hash(context, headerHash, nonce);
+      if (ethash::is_less_or_equal(mineResult.final_hash, boundary)) {
+        std::lock_guard<std::mutex> g(mutexResult);
+        if (!found) {
+          result = {BlockhashToHexString(mineResult.final_hash),
+                    BlockhashToHexString(mineResult.mix_hash), nonce, true};
+          found = true;
+        }
+        return;
+      }
 
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    auto timePassedInSeconds = std::chrono::duration_cast<std::chrono::seconds>(
-                                   currentTime - startTime)
-                                   .count();
-    if (timePassedInSeconds > timeWindow) {
-      LOG_GENERAL(WARNING,
-                  "Time out while mining pow result, time "
-                  "passed in seconds "
-                      << timePassedInSeconds << ", time window " << timeWindow);
-      m_shouldMine = false;
-      break;
+      auto currentTime = std::chrono::high_resolution_clock::now();
+      auto timePassedInSeconds =
+          std::chrono::duration_cast<std::chrono::seconds>(currentTime -
+                                                           startTime)
+              .count();
+      if (timePassedInSeconds > timeWindow) {
+        // Only the first thread to time out reports it
+        if (m_shouldMine.exchange(false)) {
+          LOG_GENERAL(WARNING, "Time out while mining pow result, time "
+                               "passed in seconds "
+                                   << timePassedInSeconds << ", time window "
+                                   << timeWindow);
+        }
+        return;
+      }
     }
+  };
+
+  if (numThreads == 1) {
+    worker(0);
+    return result;
+  }
+
+  std::vector<std::thread> threads;
+  threads.reserve(numThreads);
+  for (unsigned int i = 0; i < numThreads; i++) {
+    threads.emplace_back([&worker, i] {
+      ThreadRoles::GetInstance().ApplyToCurrentThread("Mining");
+      if (CPU_MINE_AFFINITY) {
+        PinToCore(i);
+      }
+      worker(i);
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
   }
 
-  ethash_mining_result_t failure_result = {"", "", 0, false};
-  return failure_result;
+  return result;
+}
+
+ethash_mining_result_t POW::MineLight(ethash_hash256 const& headerHash,
+                                      ethash_hash256 const& boundary,
+                                      uint64_t startNonce, int timeWindow) {
+  return MineCPU(*m_epochContextLight, headerHash, boundary, startNonce,
+                 timeWindow);
 }
 
 ethash_mining_result_t POW::MineFull(ethash_hash256 const& headerHash,
                                      ethash_hash256 const& boundary,
                                      uint64_t startNonce, int timeWindow) {
-  uint64_t nonce = startNonce;
-  auto startTime = std::chrono::high_resolution_clock::now();
-
-  while (m_shouldMine) {
-    auto mineResult = ethash::hash(*m_epochContextFull, headerHash, nonce);
-    if (ethash::is_less_or_equal(mineResult.final_hash, boundary)) {
-      ethash_mining_result_t winning_result = {
-          BlockhashToHexString(mineResult.final_hash),
-          BlockhashToHexString(mineResult.mix_hash), nonce, true};
-      return winning_result;
-    }
-    nonce++;
-
-    auto currentTime = std::chrono::high_resolution_clock::now();
-    auto timePassedInSeconds = std::chrono::duration_cast<std::chrono::seconds>(
-                                   currentTime - startTime)
-                                   .count();
-    if (timePassedInSeconds > timeWindow) {
-      LOG_GENERAL(WARNING,
-                  "Time out while mining pow result, time "
-                  "passed in seconds "
-                      << timePassedInSeconds << ", time window " << timeWindow);
-      m_shouldMine = false;
-      break;
-    }
-  }
-
-  ethash_mining_result_t failure_result = {"", "", 0, false};
-  return failure_result;
+  return MineCPU(*m_epochContextFull, headerHash, boundary, startNonce,
+                 timeWindow);
 }
 
 ethash_mining_result_t POW::MineFullGPU(uint64_t blockNum,
                                         ethash_hash256 const& headerHash,
                                         uint8_t difficulty, uint64_t startNonce,
                                         int timeWindow) {
-  std::vector<std::unique_ptr<std::thread>> vecThread;
-  uint64_t nonce = startNonce;
-  m_minerIndex = 0;
-  // Clear old result
-  for (auto& miningResult : m_vecMiningResult) {
-    miningResult = ethash_mining_result_t{"", "", 0, false};
+  const std::vector<uint64_t> startNonces = GetGpuStartNonces(startNonce);
+
+  {
+    std::lock_guard<std::mutex> g(m_mutexMiningResult);
+    // Clear old result
+    for (auto& miningResult : m_vecMiningResult) {
+      miningResult = ethash_mining_result_t{"", "", 0, false};
+    }
+    m_numMinersRunning = m_miners.size();
   }
-  for (size_t i = 0; i < m_miners.size(); ++i) {
-    vecThread.push_back(std::make_unique<std::thread>([&] {
-      MineFullGPUThread(blockNum, headerHash, difficulty, nonce, timeWindow);
-    }));
+
+  std::vector<std::thread> vecThread;
+  for (unsigned int i = 0; i < m_miners.size(); ++i) {
+    vecThread.emplace_back([this, blockNum, &headerHash, difficulty,
+                            &startNonces, i, timeWindow] {
+      MineFullGPUThread(blockNum, headerHash, difficulty, startNonces[i], i,
+                        timeWindow);
+    });
   }
 
-  std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  // A GPU that fails only drops out of this round, the others keep mining
   std::unique_lock<std::mutex> lk(m_mutexMiningResult);
-  m_cvMiningResult.wait(lk);
+  m_cvMiningResult.wait(lk, [this] {
+    return m_numMinersRunning == 0 ||
+           std::any_of(m_vecMiningResult.begin(), m_vecMiningResult.end(),
+                       [](const ethash_mining_result_t& miningResult) {
+                         return miningResult.success;
+                       });
+  });
   m_shouldMine = false;
-  for (auto& ptrThead : vecThread) {
-    ptrThead->join();
+  lk.unlock();
+
+  for (auto& thread : vecThread) {
+    thread.join();
+  }
+
+  lk.lock();
+  std::ostringstream rates;
+  for (size_t i = 0; i < m_miners.size(); ++i) {
+    rates << " " << m_minerNames[i] << ": " << std::fixed
+          << std::setprecision(2) << m_gpuHashRates[i] / 1e6 << " MH/s";
   }
+  LOG_GENERAL(INFO, "GPU hash rates" << rates.str());
 
   for (const auto& miningResult : m_vecMiningResult) {
     if (miningResult.success) {
@@ -377,6 +623,39 @@ ethash_mining_result_t POW::MineFullGPU(uint64_t blockNum,
   return ethash_mining_result_t{"", "", 0, false};
 }
 
+std::vector<uint64_t> POW::GetGpuStartNonces(uint64_t startNonce) {
+  constexpr uint32_t NONCE_SEGMENT_WIDTH = 40;
+  const uint64_t NONCE_SEGMENT = (uint64_t)1 << NONCE_SEGMENT_WIDTH;
+
+  std::vector<double> rates = GetGpuHashRates();
+  double totalRate = 0;
+  for (const auto rate : rates) {
+    // Until all GPUs are measured they get equal shares
+    if (rate <= 0) {
+      totalRate = 0;
+      break;
+    }
+    totalRate += rate;
+  }
+
+  // Each GPU gets a share of one segment per GPU, so that a faster GPU takes
+  // as long as a slower one to run out of nonces
+  const double totalNonces = (double)NONCE_SEGMENT * rates.size();
+  std::vector<uint64_t> startNonces;
+  uint64_t offset = 0;
+  for (const auto rate : rates) {
+    startNonces.emplace_back(startNonce + offset);
+    offset += totalRate > 0 ? (uint64_t)(totalNonces * rate / totalRate)
+                            : NONCE_SEGMENT;
+  }
+  return startNonces;
+}
+
+std::vector<double> POW::GetGpuHashRates() {
+  std::lock_guard<std::mutex> g(m_mutexMiningResult);
+  return m_gpuHashRates;
+}
+
 ethash_mining_result_t POW::RemoteMine(const PairOfKey& pairOfKey,
                                        uint64_t blockNum,
                                        ethash_hash256 const& headerHash,
@@ -593,13 +872,18 @@ bool POW::VerifyRemoteSoln(uint64_t blockNum, ethash_hash256 const& boundary,
                            ethash_hash256& hashResult) {
   LOG_MARKER();
 
-  hashResult = LightHash(blockNum, headerHash, nonce).final_hash;
-  if (!ethash::is_less_or_equal(hashResult, boundary)) {
+  // The final hash follows from the claimed mix hash at the cost of a keccak,
+  // so solutions failing the boundary are dropped before the light hash
+  if (!ethash::verify_final_hash(headerHash, mixHash, nonce, boundary)) {
     return false;
   }
 
-  return ethash::verify(*m_epochContextLight, headerHash, mixHash, nonce,
-                        boundary);
+  // One light hash both checks the mix hash and gives the final hash
+  const auto result = LightHash(blockNum, headerHash, nonce);
+  hashResult = result.final_hash;
+  return std::memcmp(result.mix_hash.bytes, mixHash.bytes,
+                     sizeof(mixHash.bytes)) == 0 &&
+         ethash::is_less_or_equal(hashResult, boundary);
 }
 
 bool POW::SendVerifyResult(const PairOfKey& pairOfKey,
@@ -660,42 +944,52 @@ bool POW::SendVerifyResult(const PairOfKey& pairOfKey,
 
 void POW::MineFullGPUThread(uint64_t blockNum, ethash_hash256 const& headerHash,
                             uint8_t difficulty, uint64_t nonce,
-                            int timeWindow) {
+                            unsigned int index, int timeWindow) {
   LOG_MARKER();
-  auto index = m_minerIndex.load(std::memory_order_relaxed);
-  ++m_minerIndex;
-  LOG_GENERAL(INFO, "Difficulty : " << std::to_string(difficulty)
-                                    << ", miner index " << index);
+  LOG_GENERAL(INFO, "Difficulty : " << std::to_string(difficulty) << ", "
+                                    << m_minerNames[index] << " from nonce "
+                                    << nonce);
   dev::eth::WorkPackage wp;
   wp.blockNumber = blockNum;
   wp.boundary = (dev::h256)(dev::u256)((dev::bigint(1) << 256) /
                                        (dev::u256(1) << difficulty));
 
   wp.header = dev::h256{headerHash.bytes, dev::h256::ConstructFromPointer};
-
-  constexpr uint32_t NONCE_SEGMENT_WIDTH = 40;
-  const uint64_t NONCE_SEGMENT = (uint64_t)pow(2, NONCE_SEGMENT_WIDTH);
-  wp.startNonce = nonce + index * NONCE_SEGMENT;
+  wp.startNonce = nonce;
 
   auto startTime = std::chrono::high_resolution_clock::now();
 
+  ethash_mining_result_t miningResult{"", "", 0, false};
   dev::eth::Solution solution;
   while (m_shouldMine) {
+    const auto passStartTime = std::chrono::high_resolution_clock::now();
     if (!m_miners[index]->mine(wp, solution)) {
-      LOG_GENERAL(WARNING, "GPU failed to do mine, GPU miner log: "
+      LOG_GENERAL(WARNING, m_minerNames[index]
+                               << " failed to do mine, mining goes on with "
+                                  "the other GPUs. GPU miner log: "
                                << m_miners[index]->getLog());
-      m_vecMiningResult[index] = ethash_mining_result_t{"", "", 0, false};
-      m_cvMiningResult.notify_one();
-      return;
+      break;
+    }
+
+    // Each pass hashes the nonces from wp.startNonce up to solution.nonce
+    const auto passTime = std::chrono::duration<double>(
+                              std::chrono::high_resolution_clock::now() -
+                              passStartTime)
+                              .count();
+    if (passTime > 0 && solution.nonce > wp.startNonce) {
+      const double passRate = (solution.nonce - wp.startNonce) / passTime;
+      std::lock_guard<std::mutex> g(m_mutexMiningResult);
+      double& rate = m_gpuHashRates[index];
+      rate = rate > 0 ? 0.8 * rate + 0.2 * passRate : passRate;
     }
+
     auto hashResult = LightHash(blockNum, headerHash, solution.nonce);
     auto boundary = DifficultyLevelInIntDevided(difficulty);
     if (ethash::is_less_or_equal(hashResult.final_hash, boundary)) {
-      m_vecMiningResult[index] =
+      miningResult =
           ethash_mining_result_t{BlockhashToHexString(hashResult.final_hash),
                                  solution.mixHash.hex(), solution.nonce, true};
-      m_cvMiningResult.notify_one();
-      return;
+      break;
     }
     wp.startNonce = solution.nonce;
 
@@ -713,9 +1007,10 @@ void POW::MineFullGPUThread(uint64_t blockNum, ethash_hash256 const& headerHash,
     }
   }
 
-  m_vecMiningResult[index] = ethash_mining_result_t{"", "", 0, false};
+  std::lock_guard<std::mutex> g(m_mutexMiningResult);
+  m_vecMiningResult[index] = miningResult;
+  --m_numMinersRunning;
   m_cvMiningResult.notify_one();
-  return;
 }
 
 bytes POW::ConcatAndhash(const std::array<unsigned char, UINT256_SIZE>& rand1,
@@ -804,6 +1099,8 @@ bool POW::PoWVerify(uint64_t blockNum, uint8_t difficulty,
                     const std::string& winning_mixhash) {
   LOG_MARKER();
   EthashConfigureClient(blockNum);
+  const auto epochContextLight = GetEpochContextLight();
+
   const auto boundary = DifficultyLevelInIntDevided(difficulty);
   auto winnning_result = StringToBlockhash(winning_result);
   auto winningMixhash = StringToBlockhash(winning_mixhash);
@@ -813,7 +1110,7 @@ bool POW::PoWVerify(uint64_t blockNum, uint8_t difficulty,
     return false;
   }
 
-  return ethash::verify(*m_epochContextLight, headerHash, winningMixhash,
+  return ethash::verify(*epochContextLight, headerHash, winningMixhash,
                         winning_nonce, boundary);
 }
 
@@ -821,7 +1118,12 @@ ethash::result POW::LightHash(uint64_t blockNum,
                               ethash_hash256 const& headerHash,
                               uint64_t nonce) {
   EthashConfigureClient(blockNum);
-  return ethash::hash(*m_epochContextLight, headerHash, nonce);
+  return ethash::hash(*GetEpochContextLight(), headerHash, nonce);
+}
+
+std::shared_ptr<ethash::epoch_context> POW::GetEpochContextLight() {
+  std::lock_guard<std::mutex> g(m_mutexLightClientConfigure);
+  return m_epochContextLight;
 }
 
 bool POW::CheckSolnAgainstsTargetedDifficulty(const ethash_hash256& result,
@@ -849,7 +1151,9 @@ void POW::InitOpenCL() {
     LOG_GENERAL(FATAL, "Failed to configure OpenCL GPU, please check hardware");
   }
 
-  auto gpuToUse = GetGpuToUse();
+  auto gpuToUse = GetGpuToUse(CUDA_GPU_MINE && !OPENCL_GPU_TO_USE.empty()
+                                  ? OPENCL_GPU_TO_USE
+                                  : GPU_TO_USE);
   auto totalGpuDevice = CLMiner::getNumDevices();
 
   CLMiner::setNumInstances(gpuToUse.size());
@@ -863,7 +1167,9 @@ void POW::InitOpenCL() {
     }
 
     m_miners.push_back(std::make_unique<CLMiner>(gpuIndex));
+    m_minerNames.push_back("OpenCL GPU " + std::to_string(gpuIndex));
     m_vecMiningResult.push_back(ethash_mining_result_t{"", "", 0, false});
+    m_gpuHashRates.push_back(0);
   }
   LOG_GENERAL(INFO, "OpenCL GPU initialized in POW");
 #else
@@ -900,7 +1206,9 @@ void POW::InitCUDA() {
     }
 
     m_miners.push_back(std::make_unique<CUDAMiner>(gpuIndex));
+    m_minerNames.push_back("CUDA GPU " + std::to_string(gpuIndex));
     m_vecMiningResult.push_back(ethash_mining_result_t{"", "", 0, false});
+    m_gpuHashRates.push_back(0);
   }
   LOG_GENERAL(INFO, "CUDA GPU initialized in POW");
 #else
@@ -911,9 +1219,9 @@ void POW::InitCUDA() {
 #endif
 }
 
-std::set<unsigned int> POW::GetGpuToUse() {
+std::set<unsigned int> POW::GetGpuToUse(const std::string& gpuToUseStr) {
   std::set<unsigned int> gpuToUse;
-  std::stringstream ss(GPU_TO_USE);
+  std::stringstream ss(gpuToUseStr);
   std::string item;
   while (std::getline(ss, item, ',')) {
     unsigned int index = strtol(item.c_str(), NULL, 10);
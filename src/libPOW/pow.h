@@ -24,7 +24,9 @@
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 #include <boost/multiprecision/cpp_int.hpp>
 #pragma GCC diagnostic pop
+#include <future>
 #include <mutex>
+#include <set>
 #include <string>
 #include <thread>
 #include <vector>
@@ -108,7 +110,11 @@ class POW {
                                            uint8_t difficulty);
   bool CheckSolnAgainstsTargetedDifficulty(const std::string& result,
                                            uint8_t difficulty);
-  static std::set<unsigned int> GetGpuToUse();
+  static std::set<unsigned int> GetGpuToUse(
+      const std::string& gpuToUse = GPU_TO_USE);
+
+  /// Hashes per second last measured on each GPU miner, 0 until measured
+  std::vector<double> GetGpuHashRates();
 
   // Put it to public function so can directly test with it
   ethash_mining_result_t RemoteMine(const PairOfKey& pairOfKey,
@@ -133,17 +139,40 @@ class POW {
                         ethash_hash256 const& boundary, bool verifyResult);
 
  private:
+  struct EpochContexts {
+    std::shared_ptr<ethash::epoch_context> m_light;
+    std::shared_ptr<ethash::epoch_context_full> m_full;
+  };
+
   std::shared_ptr<ethash::epoch_context> m_epochContextLight = nullptr;
+  /// Concurrent hashers share the light cache through this, which keeps it
+  /// alive should another thread move the client on to the next epoch
+  std::shared_ptr<ethash::epoch_context> GetEpochContextLight();
   std::shared_ptr<ethash::epoch_context_full> m_epochContextFull = nullptr;
   uint64_t m_currentBlockNum;
+  /// contexts of the next ethash epoch, built in the background from
+  /// ETHASH_PRECOMPUTE_BLOCKS blocks before it starts
+  int m_nextEpochNumber{-1};
+  std::future<EpochContexts> m_nextEpochContexts;
   std::atomic<bool> m_shouldMine;
   std::vector<dev::eth::MinerPtr> m_miners;
+  /// Names the miners in logs, such as "CUDA GPU 0"
+  std::vector<std::string> m_minerNames;
+  // Guarded by m_mutexMiningResult
   std::vector<ethash_mining_result_t> m_vecMiningResult;
-  std::atomic<int> m_minerIndex;
+  std::vector<double> m_gpuHashRates;
+  unsigned int m_numMinersRunning{0};
   std::condition_variable m_cvMiningResult;
   std::mutex m_mutexMiningResult;
   std::unique_ptr<jsonrpc::HttpClient> m_httpClient;
 
+  /// Scans nonces from startNonce on CPU_MINE_THREADS threads until one
+  /// meets boundary, the time window passes or StopMining is called
+  template <class Context>
+  ethash_mining_result_t MineCPU(const Context& context,
+                                 ethash_hash256 const& headerHash,
+                                 ethash_hash256 const& boundary,
+                                 uint64_t startNonce, int timeWindow);
   ethash_mining_result_t MineLight(ethash_hash256 const& headerHash,
                                    ethash_hash256 const& boundary,
                                    uint64_t startNonce, int timeWindow);
@@ -158,8 +187,21 @@ class POW {
                                      uint8_t difficulty, uint64_t startNonce,
                                      int timeWindow);
   void MineFullGPUThread(uint64_t blockNum, ethash_hash256 const& headerHash,
-                         uint8_t difficulty, uint64_t nonce, int timeWindow);
+                         uint8_t difficulty, uint64_t nonce,
+                         unsigned int index, int timeWindow);
+  /// Splits the nonce space from startNonce across the GPU miners in
+  /// proportion to their measured hash rates
+  std::vector<uint64_t> GetGpuStartNonces(uint64_t startNonce);
   void InitOpenCL();
   void InitCUDA();
+
+  /// Creates the full context of an epoch with the dataset saved under
+  /// ETHASH_DAG_DIR. Without one, the dataset is filled as mining reads it,
+  /// and in the background if fillInBackground is set.
+  static std::shared_ptr<ethash::epoch_context_full> CreateEpochContextFull(
+      int epochNumber, bool fillInBackground);
+  /// Computes the items of the dataset not yet filled, on all cores, and
+  /// saves it under ETHASH_DAG_DIR
+  static void FillFullDataset(ethash::epoch_context_full& context);
 };
 #endif  // __POW_H__
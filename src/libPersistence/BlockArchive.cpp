@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+#include <boost/filesystem.hpp>
+
+#include "BlockArchive.h"
+#include "common/Serializable.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+namespace bfs = boost::filesystem;
+
+namespace {
+
+const uint32_t SEGMENT_MAGIC = 0x5a415243;  // "ZARC"
+const unsigned int KEY_LEN = dev::h256::size;
+const unsigned int OFFSET_LEN = sizeof(uint64_t);
+const unsigned int LENGTH_LEN = sizeof(uint32_t);
+const unsigned int INDEX_ENTRY_LEN = KEY_LEN + OFFSET_LEN + LENGTH_LEN;
+// index offset, entry count and magic
+const unsigned int FOOTER_LEN = OFFSET_LEN + LENGTH_LEN + sizeof(uint32_t);
+
+// Big-endian, as written by Serializable::SetNumber
+template <class numerictype>
+numerictype ReadNumber(const uint8_t* src, unsigned int len) {
+  numerictype result = 0;
+  for (unsigned int i = 0; i < len; i++) {
+    result = (result << 8) | src[i];
+  }
+  return result;
+}
+
+}  // namespace
+
+BlockArchive::Segment::Segment()
+    : m_data(nullptr), m_size(0), m_index(nullptr), m_count(0) {}
+
+BlockArchive::Segment::~Segment() {
+  if (m_data != nullptr) {
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+  }
+}
+
+bool BlockArchive::Segment::Open(const string& filename) {
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    LOG_GENERAL(WARNING, "Cannot open segment " << filename);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)FOOTER_LEN) {
+    LOG_GENERAL(WARNING, "Segment " << filename << " is truncated");
+    close(fd);
+    return false;
+  }
+
+  void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    LOG_GENERAL(WARNING, "Cannot map segment " << filename);
+    return false;
+  }
+  // Lookups jump around the whole file
+  madvise(data, st.st_size, MADV_RANDOM);
+
+  m_data = static_cast<const uint8_t*>(data);
+  m_size = st.st_size;
+
+  const uint8_t* footer = m_data + m_size - FOOTER_LEN;
+  const uint64_t indexOffset = ReadNumber<uint64_t>(footer, OFFSET_LEN);
+  const uint32_t count = ReadNumber<uint32_t>(footer + OFFSET_LEN, LENGTH_LEN);
+  const uint32_t magic =
+      ReadNumber<uint32_t>(footer + OFFSET_LEN + LENGTH_LEN, sizeof(uint32_t));
+
+  if (magic != SEGMENT_MAGIC ||
+      indexOffset + (uint64_t)count * INDEX_ENTRY_LEN !=
+          m_size - FOOTER_LEN) {
+    LOG_GENERAL(WARNING, "Segment " << filename << " is corrupted");
+    return false;
+  }
+
+  m_index = m_data + indexOffset;
+  m_count = count;
+
+  return true;
+}
+
+bool BlockArchive::Segment::Lookup(const dev::h256& key, bytes& value) const {
+  uint32_t lo = 0;
+  uint32_t hi = m_count;
+
+  while (lo < hi) {
+    const uint32_t mid = lo + (hi - lo) / 2;
+    const uint8_t* entry = m_index + (uint64_t)mid * INDEX_ENTRY_LEN;
+    const int cmp = memcmp(entry, key.data(), KEY_LEN);
+
+    if (cmp < 0) {
+      lo = mid + 1;
+    } else if (cmp > 0) {
+      hi = mid;
+    } else {
+      const uint64_t offset = ReadNumber<uint64_t>(entry + KEY_LEN, OFFSET_LEN);
+      const uint32_t length =
+          ReadNumber<uint32_t>(entry + KEY_LEN + OFFSET_LEN, LENGTH_LEN);
+      if (offset + length > (uint64_t)(m_index - m_data)) {
+        LOG_GENERAL(WARNING, "Segment entry out of range");
+        return false;
+      }
+      value.assign(m_data + offset, m_data + offset + length);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool BlockArchive::Open(const string& path) {
+  unique_lock<shared_timed_mutex> g(m_mutex);
+
+  m_segments.clear();
+  m_path = path;
+  m_open = true;
+
+  if (!bfs::exists(path)) {
+    return true;
+  }
+
+  vector<string> filenames;
+  for (const auto& entry : bfs::directory_iterator(path)) {
+    if (bfs::is_regular_file(entry.path()) &&
+        entry.path().extension() == SEGMENT_SUFFIX) {
+      filenames.emplace_back(entry.path().string());
+    }
+  }
+  sort(filenames.begin(), filenames.end());
+
+  for (const auto& filename : filenames) {
+    auto segment = make_unique<Segment>();
+    if (!segment->Open(filename)) {
+      continue;
+    }
+    m_segments.emplace_back(move(segment));
+  }
+
+  LOG_GENERAL(INFO, "Opened " << m_segments.size() << " segments in " << path);
+
+  return true;
+}
+
+void BlockArchive::Close() {
+  unique_lock<shared_timed_mutex> g(m_mutex);
+  m_segments.clear();
+  m_open = false;
+}
+
+bool BlockArchive::IsOpen() const {
+  shared_lock<shared_timed_mutex> g(m_mutex);
+  return m_open;
+}
+
+bool BlockArchive::Seal(const string& name,
+                        const map<dev::h256, bytes>& entries) {
+  unique_lock<shared_timed_mutex> g(m_mutex);
+
+  if (!m_open) {
+    LOG_GENERAL(WARNING, "Archive not opened");
+    return false;
+  }
+
+  const string filename =
+      (bfs::path(m_path) / (name + SEGMENT_SUFFIX)).string();
+  if (bfs::exists(filename)) {
+    LOG_GENERAL(WARNING, "Segment " << filename << " already sealed");
+    return false;
+  }
+
+  try {
+    bfs::create_directories(m_path);
+  } catch (const bfs::filesystem_error& e) {
+    LOG_GENERAL(WARNING, "Cannot create " << m_path << ": " << e.what());
+    return false;
+  }
+
+  // Only a complete segment ever appears under its final name
+  const string tmpFilename = filename + ".tmp";
+  try {
+    if (!WriteSegment(tmpFilename, entries)) {
+      bfs::remove(tmpFilename);
+      return false;
+    }
+    bfs::rename(tmpFilename, filename);
+  } catch (const bfs::filesystem_error& e) {
+    LOG_GENERAL(WARNING, "Cannot seal " << filename << ": " << e.what());
+    return false;
+  }
+
+  auto segment = make_unique<Segment>();
+  if (!segment->Open(filename)) {
+    return false;
+  }
+  m_segments.emplace_back(move(segment));
+
+  LOG_GENERAL(INFO, "Sealed segment " << filename << " of " << entries.size()
+                                       << " entries");
+
+  return true;
+}
+
+bool BlockArchive::Lookup(const dev::h256& key, bytes& value) const {
+  shared_lock<shared_timed_mutex> g(m_mutex);
+
+  for (const auto& segment : m_segments) {
+    if (segment->Lookup(key, value)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+unsigned int BlockArchive::GetNumSegments() const {
+  shared_lock<shared_timed_mutex> g(m_mutex);
+  return m_segments.size();
+}
+
+bool BlockArchive::WriteSegment(const string& filename,
+                                const map<dev::h256, bytes>& entries) {
+  ofstream file(filename, ios::binary | ios::trunc);
+  if (!file) {
+    LOG_GENERAL(WARNING, "Cannot create segment " << filename);
+    return false;
+  }
+
+  // Values in key order, then the index over them
+  bytes index(entries.size() * INDEX_ENTRY_LEN);
+  uint64_t offset = 0;
+  unsigned int curIndex = 0;
+  for (const auto& entry : entries) {
+    file.write(reinterpret_cast<const char*>(entry.second.data()),
+               entry.second.size());
+
+    copy(entry.first.begin(), entry.first.end(), index.begin() + curIndex);
+    Serializable::SetNumber<uint64_t>(index, curIndex + KEY_LEN, offset,
+                                      OFFSET_LEN);
+    Serializable::SetNumber<uint32_t>(index, curIndex + KEY_LEN + OFFSET_LEN,
+                                      entry.second.size(), LENGTH_LEN);
+
+    offset += entry.second.size();
+    curIndex += INDEX_ENTRY_LEN;
+  }
+  file.write(reinterpret_cast<const char*>(index.data()), index.size());
+
+  bytes footer(FOOTER_LEN);
+  Serializable::SetNumber<uint64_t>(footer, 0, offset, OFFSET_LEN);
+  Serializable::SetNumber<uint32_t>(footer, OFFSET_LEN, entries.size(),
+                                    LENGTH_LEN);
+  Serializable::SetNumber<uint32_t>(footer, OFFSET_LEN + LENGTH_LEN,
+                                    SEGMENT_MAGIC, sizeof(uint32_t));
+  file.write(reinterpret_cast<const char*>(footer.data()), footer.size());
+
+  file.close();
+  if (!file) {
+    LOG_GENERAL(WARNING, "Failed to write segment " << filename);
+    return false;
+  }
+
+  return true;
+}
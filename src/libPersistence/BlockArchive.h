@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef BLOCKARCHIVE_H
+#define BLOCKARCHIVE_H
+
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+#include "common/BaseType.h"
+#include "depends/common/FixedHash.h"
+
+/// Append-only archive of write-once historical data, such as txn bodies or
+/// micro blocks of old epochs, keyed by hash.
+///
+/// The archive is a directory of segment files. Each segment is written once,
+/// for a range of DS epochs, and never changes after; new data goes into new
+/// segments, so a backup only needs to copy the segments it does not have.
+/// A segment holds the values back to back, then an index of (key, offset,
+/// length) sorted by key, then a fixed-size footer. Segments are memory
+/// mapped and looked up by binary search of their index.
+class BlockArchive {
+ public:
+  static constexpr const char* SEGMENT_SUFFIX = ".seg";
+
+  /// One sealed, memory-mapped segment file
+  class Segment {
+    const uint8_t* m_data;
+    size_t m_size;
+    const uint8_t* m_index;
+    uint32_t m_count;
+
+   public:
+    Segment();
+    ~Segment();
+    Segment(const Segment&) = delete;
+    Segment& operator=(const Segment&) = delete;
+
+    /// Maps the segment file and checks its footer
+    bool Open(const std::string& filename);
+
+    /// Copies the value stored under key, if any
+    bool Lookup(const dev::h256& key, bytes& value) const;
+
+    uint32_t GetCount() const { return m_count; }
+  };
+
+  BlockArchive() = default;
+  BlockArchive(const BlockArchive&) = delete;
+  BlockArchive& operator=(const BlockArchive&) = delete;
+
+  /// Maps every segment found under path, which need not exist yet
+  bool Open(const std::string& path);
+
+  /// Unmaps all the segments
+  void Close();
+
+  bool IsOpen() const;
+
+  /// Writes entries as a new segment called name and maps it. Fails if a
+  /// segment of that name already exists, since segments are immutable.
+  bool Seal(const std::string& name,
+            const std::map<dev::h256, bytes>& entries);
+
+  /// Copies the value stored under key in any segment
+  bool Lookup(const dev::h256& key, bytes& value) const;
+
+  unsigned int GetNumSegments() const;
+
+  /// Writes entries to filename in the segment format
+  static bool WriteSegment(const std::string& filename,
+                           const std::map<dev::h256, bytes>& entries);
+
+ private:
+  std::string m_path;
+  bool m_open = false;
+  std::vector<std::unique_ptr<Segment>> m_segments;
+  mutable std::shared_timed_mutex m_mutex;
+};
+
+#endif  // BLOCKARCHIVE_H
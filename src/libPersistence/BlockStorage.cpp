@@ -21,21 +21,66 @@
 #include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <limits>
+#include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 
-#include <leveldb/db.h>
 #include <boost/filesystem.hpp>
 
 #include "BlockStorage.h"
 #include "common/Constants.h"
 #include "common/Serializable.h"
+#include "depends/libDatabase/KVBackend.h"
 #include "libData/BlockChainData/BlockLinkChain.h"
 #include "libMessage/Messenger.h"
 #include "libUtils/DataConversion.h"
 
 using namespace std;
 
+namespace {
+// Address index keys are the address, the zero-padded epoch number and the
+// txn hash, so the txns of an address are adjacent and ordered by epoch
+const unsigned int INDEX_EPOCH_DIGITS = 20;
+
+string TxnAddressIndexPrefix(const Address& address) { return address.hex(); }
+
+// Tx block txn keys are the zero-padded block number and shard id, so the
+// shards of a block are adjacent. Values are the micro block hash followed by
+// its txn hashes.
+const unsigned int INDEX_SHARD_DIGITS = 10;
+
+string ZeroPadded(const uint64_t& num, const unsigned int digits) {
+  string str = to_string(num);
+  str.insert(0, digits - str.size(), '0');
+  return str;
+}
+
+// Event bloom keys are the zero-padded block number for the bloom of the Tx
+// block, followed by the zero-padded shard id for that of a micro block, so
+// a block bloom comes right before those of its micro blocks
+EventBloom ToEventBloom(const ldb::Slice& value) {
+  if (value.size() != EventBloom::SIZE) {
+    return EventBloom();
+  }
+  return EventBloom(dev::h2048(
+      reinterpret_cast<const unsigned char*>(value.data()),
+      dev::h2048::ConstructFromPointer));
+}
+
+// Micro block txns records have the same keys as Tx block txn entries. Each
+// holds the serialized micro block and then its txn bodies, every item
+// preceded by its length.
+const unsigned int RECORD_LENGTH_SIZE = sizeof(uint32_t);
+
+void AppendRecordItem(bytes& record, const bytes& item) {
+  Serializable::SetNumber<uint32_t>(record, record.size(), item.size(),
+                                    RECORD_LENGTH_SIZE);
+  record.insert(record.end(), item.begin(), item.end());
+}
+}  // namespace
+
 BlockStorage& BlockStorage::GetBlockStorage(const std::string& path,
                                             bool diagnostic) {
   static BlockStorage bs(path, diagnostic);
@@ -54,6 +99,9 @@ bool BlockStorage::PutBlock(const uint64_t& blockNum, const bytes& body,
     ret = m_txBlockchainDB->Insert(blockNum, body);
     LOG_GENERAL(INFO, "Stored TxBlock num = " << blockNum);
   }
+  if (ENABLE_WARM_START && ret == 0 && blockType == BlockType::Tx) {
+    m_txBlockSnapshot.Add(blockNum, body);
+  }
   return (ret == 0);
 }
 
@@ -107,6 +155,7 @@ bool BlockStorage::PutTxBody(const dev::h256& key, const bytes& body) {
   {
     unique_lock<shared_timed_mutex> g(m_mutexTxBody);
     ret = m_txBodyDB->Insert(key, body) && m_txBodyTmpDB->Insert(key, body);
+    m_txBodyCache.Erase(key);
   }
 
   return (ret == 0);
@@ -116,54 +165,531 @@ bool BlockStorage::PutMicroBlock(const BlockHash& blockHash,
                                  const bytes& body) {
   unique_lock<shared_timed_mutex> g(m_mutexMicroBlock);
   int ret = m_microBlockDB->Insert(blockHash, body);
+  m_microBlockCache.Erase(blockHash);
 
   return (ret == 0);
 }
 
+void EpochWrites::AddTxBlock(const uint64_t& blockNum, const bytes& body) {
+  // Same keys as LevelDB::Insert
+  m_txBlocks.Put(to_string(blockNum), ldb::Slice(dev::bytesConstRef(&body)));
+  if (ENABLE_WARM_START) {
+    m_txBlockBodies.emplace_back(blockNum, body);
+  }
+}
+
+void EpochWrites::AddTxBody(const dev::h256& key, const bytes& body) {
+  m_txBodies.Put(key.hex(), ldb::Slice(dev::bytesConstRef(&body)));
+  m_txBodyKeys.emplace_back(key);
+}
+
+void EpochWrites::AddMicroBlock(const BlockHash& blockHash, const bytes& body) {
+  m_microBlocks.Put(blockHash.hex(), ldb::Slice(dev::bytesConstRef(&body)));
+  m_microBlockKeys.emplace_back(blockHash);
+}
+
+void EpochWrites::AddStateDelta(const uint64_t& finalBlockNum,
+                                const bytes& stateDelta) {
+  m_stateDeltas.Put(to_string(finalBlockNum),
+                    ldb::Slice(dev::bytesConstRef(&stateDelta)));
+}
+
+void EpochWrites::AddTxnAddressIndex(const Address& address,
+                                     const uint64_t& epochNum,
+                                     const TxnHash& txnHash) {
+  m_txnAddressIndex.Put(TxnAddressIndexPrefix(address) +
+                            ZeroPadded(epochNum, INDEX_EPOCH_DIGITS) +
+                            txnHash.hex(),
+                        ldb::Slice());
+  m_txnAddressIndexEntries++;
+}
+
+void EpochWrites::AddTxBlockTxns(const uint64_t& blockNum,
+                                 const uint32_t& shardId,
+                                 const BlockHash& microBlockHash,
+                                 const vector<TxnHash>& tranHashes) {
+  bytes value(microBlockHash.begin(), microBlockHash.end());
+  value.reserve(BlockHash::size + tranHashes.size() * TxnHash::size);
+  for (const auto& tranHash : tranHashes) {
+    value.insert(value.end(), tranHash.begin(), tranHash.end());
+  }
+  m_txBlockTxns.Put(ZeroPadded(blockNum, INDEX_EPOCH_DIGITS) +
+                        ZeroPadded(shardId, INDEX_SHARD_DIGITS),
+                    ldb::Slice(dev::bytesConstRef(&value)));
+  m_txBlockTxnsEntries++;
+}
+
+void EpochWrites::AddEventBloom(const uint64_t& blockNum,
+                                const uint32_t& shardId,
+                                const EventBloom& bloom) {
+  m_eventBlooms.Put(ZeroPadded(blockNum, INDEX_EPOCH_DIGITS) +
+                        ZeroPadded(shardId, INDEX_SHARD_DIGITS),
+                    ldb::Slice(reinterpret_cast<const char*>(
+                                   bloom.GetBits().data()),
+                               EventBloom::SIZE));
+  m_blockEventBlooms[blockNum] |= bloom;
+  m_eventBloomEntries++;
+}
+
+void EpochWrites::AddMicroBlockTxns(const uint64_t& blockNum,
+                                    const uint32_t& shardId,
+                                    const bytes& microBlock,
+                                    const vector<bytes>& txBodies) {
+  size_t size = RECORD_LENGTH_SIZE + microBlock.size();
+  for (const auto& body : txBodies) {
+    size += RECORD_LENGTH_SIZE + body.size();
+  }
+
+  bytes record;
+  record.reserve(size);
+  AppendRecordItem(record, microBlock);
+  for (const auto& body : txBodies) {
+    AppendRecordItem(record, body);
+  }
+  m_microBlockTxns.Put(ZeroPadded(blockNum, INDEX_EPOCH_DIGITS) +
+                           ZeroPadded(shardId, INDEX_SHARD_DIGITS),
+                       ldb::Slice(dev::bytesConstRef(&record)));
+  m_microBlockTxnsEntries++;
+}
+
+bool BlockStorage::PutEpochWrites(EpochWrites& writes) {
+  LOG_MARKER();
+
+  if (!writes.m_txBodyKeys.empty()) {
+    if (!LOOKUP_NODE_MODE) {
+      LOG_GENERAL(WARNING, "Non lookup node should not trigger this.");
+      return false;
+    }
+
+    unique_lock<shared_timed_mutex> g(m_mutexTxBody);
+    if (m_txBodyDB->BatchInsert(writes.m_txBodies) != 0 ||
+        m_txBodyTmpDB->BatchInsert(writes.m_txBodies) != 0) {
+      LOG_GENERAL(WARNING, "Failed to store " << writes.m_txBodyKeys.size()
+                                              << " txn bodies");
+      return false;
+    }
+    for (const auto& key : writes.m_txBodyKeys) {
+      m_txBodyCache.Erase(key);
+    }
+  }
+
+  {
+    unique_lock<shared_timed_mutex> g(m_mutexMicroBlock);
+    if (m_microBlockDB->BatchInsert(writes.m_microBlocks) != 0) {
+      LOG_GENERAL(WARNING, "Failed to store micro blocks");
+      return false;
+    }
+    for (const auto& blockHash : writes.m_microBlockKeys) {
+      m_microBlockCache.Erase(blockHash);
+    }
+  }
+
+  {
+    unique_lock<shared_timed_mutex> g(m_mutexStateDelta);
+    if (m_stateDeltaDB->BatchInsert(writes.m_stateDeltas) != 0) {
+      LOG_GENERAL(WARNING, "Failed to store state deltas");
+      return false;
+    }
+  }
+
+  if (writes.m_txnAddressIndexEntries > 0) {
+    if (!LOOKUP_NODE_MODE) {
+      LOG_GENERAL(WARNING, "Non lookup node should not trigger this.");
+      return false;
+    }
+
+    unique_lock<shared_timed_mutex> g(m_mutexTxnAddressIndex);
+    if (m_txnAddressIndexDB->BatchInsert(writes.m_txnAddressIndex) != 0) {
+      LOG_GENERAL(WARNING, "Failed to store txn address index");
+      return false;
+    }
+  }
+
+  if (writes.m_txBlockTxnsEntries > 0) {
+    if (!LOOKUP_NODE_MODE) {
+      LOG_GENERAL(WARNING, "Non lookup node should not trigger this.");
+      return false;
+    }
+
+    unique_lock<shared_timed_mutex> g(m_mutexTxBlockTxns);
+    if (m_txBlockTxnsDB->BatchInsert(writes.m_txBlockTxns) != 0) {
+      LOG_GENERAL(WARNING, "Failed to store tx block txn hashes");
+      return false;
+    }
+  }
+
+  if (writes.m_eventBloomEntries > 0) {
+    if (!LOOKUP_NODE_MODE) {
+      LOG_GENERAL(WARNING, "Non lookup node should not trigger this.");
+      return false;
+    }
+
+    // The micro blocks of a Tx block are stored apart, so merge with the
+    // block bloom stored so far
+    unique_lock<shared_timed_mutex> g(m_mutexEventBloom);
+    for (auto& entry : writes.m_blockEventBlooms) {
+      const string key = ZeroPadded(entry.first, INDEX_EPOCH_DIGITS);
+      const string stored = m_eventBloomDB->Lookup(key);
+      entry.second |= ToEventBloom(ldb::Slice(stored));
+      writes.m_eventBlooms.Put(
+          key, ldb::Slice(reinterpret_cast<const char*>(
+                              entry.second.GetBits().data()),
+                          EventBloom::SIZE));
+    }
+    if (m_eventBloomDB->BatchInsert(writes.m_eventBlooms) != 0) {
+      LOG_GENERAL(WARNING, "Failed to store event blooms");
+      return false;
+    }
+  }
+
+  if (writes.m_microBlockTxnsEntries > 0) {
+    if (!LOOKUP_NODE_MODE) {
+      LOG_GENERAL(WARNING, "Non lookup node should not trigger this.");
+      return false;
+    }
+
+    unique_lock<shared_timed_mutex> g(m_mutexMicroBlockTxns);
+    if (m_microBlockTxnsDB->BatchInsert(writes.m_microBlockTxns) != 0) {
+      LOG_GENERAL(WARNING, "Failed to store micro block txns");
+      return false;
+    }
+  }
+
+  {
+    unique_lock<shared_timed_mutex> g(m_mutexTxBlockchain);
+    if (m_txBlockchainDB->BatchInsert(writes.m_txBlocks) != 0) {
+      LOG_GENERAL(WARNING, "Failed to store tx blocks");
+      return false;
+    }
+  }
+
+  for (const auto& block : writes.m_txBlockBodies) {
+    m_txBlockSnapshot.Add(block.first, block.second);
+  }
+
+  return true;
+}
+
 bool BlockStorage::InitiateHistoricalDB(const string& path) {
   // If not explicitly convert to string, calls the other constructor
   {
     unique_lock<shared_timed_mutex> g(m_mutexTxnHistorical);
     m_txnHistoricalDB = make_shared<LevelDB>("txBodies", path, (string) "");
+    m_txnHistoricalCache.Clear();
   }
   {
     unique_lock<shared_timed_mutex> g(m_mutexMBHistorical);
     m_MBHistoricalDB = make_shared<LevelDB>("microBlocks", path, (string) "");
   }
 
-  return true;
+  return OpenHistoricalArchive(path + "/archive");
 }
 
-bool BlockStorage::GetTxnFromHistoricalDB(const dev::h256& key,
-                                          TxBodySharedPtr& body) {
-  std::string bodyString;
+bool BlockStorage::OpenHistoricalArchive(const string& path) {
   {
-    shared_lock<shared_timed_mutex> g(m_mutexTxnHistorical);
-    bodyString = m_txnHistoricalDB->Lookup(key);
+    unique_lock<shared_timed_mutex> g(m_mutexTxnHistorical);
+    m_txnHistoricalCache.Clear();
+  }
+  return m_txnArchive.Open(path + "/txBodies") &&
+         m_MBArchive.Open(path + "/microBlocks");
+}
+
+bool BlockStorage::SealHistoricalSegment(const uint64_t& loDSEpoch,
+                                         const uint64_t& hiDSEpoch) {
+  LOG_MARKER();
+
+  if (!m_txnArchive.IsOpen() || !m_MBArchive.IsOpen()) {
+    LOG_GENERAL(WARNING, "Historical archive not opened");
+    return false;
+  }
+
+  if (loDSEpoch > hiDSEpoch) {
+    LOG_GENERAL(WARNING, "Invalid DS epoch range " << loDSEpoch << " - "
+                                                   << hiDSEpoch);
+    return false;
+  }
+
+  list<MicroBlockSharedPtr> microBlocks;
+  if (!GetRangeMicroBlocks(loDSEpoch * NUM_FINAL_BLOCK_PER_POW,
+                           (hiDSEpoch + 1) * NUM_FINAL_BLOCK_PER_POW - 1, 0,
+                           numeric_limits<uint32_t>::max(), microBlocks)) {
+    LOG_GENERAL(WARNING, "No micro blocks to seal");
+    return false;
+  }
+
+  map<dev::h256, bytes> mbEntries;
+  map<dev::h256, bytes> txnEntries;
+  for (const auto& microBlock : microBlocks) {
+    bytes mbBytes;
+    if (!microBlock->Serialize(mbBytes, 0)) {
+      LOG_GENERAL(WARNING, "MicroBlock::Serialize failed");
+      return false;
+    }
+    mbEntries.emplace(microBlock->GetBlockHash(), mbBytes);
+
+    if (!LOOKUP_NODE_MODE) {
+      continue;
+    }
+    for (const auto& tranHash : microBlock->GetTranHashes()) {
+      string bodyString;
+      {
+        shared_lock<shared_timed_mutex> g(m_mutexTxBody);
+        bodyString = m_txBodyDB->Lookup(tranHash);
+      }
+      if (bodyString.empty()) {
+        LOG_GENERAL(WARNING, "Missing txn body " << tranHash);
+        return false;
+      }
+      txnEntries.emplace(tranHash,
+                         bytes(bodyString.begin(), bodyString.end()));
+    }
+  }
+
+  // Micro blocks last, so a sealed micro block implies its bodies are sealed
+  const string name = to_string(loDSEpoch) + "_" + to_string(hiDSEpoch);
+  return m_txnArchive.Seal(name, txnEntries) &&
+         m_MBArchive.Seal(name, mbEntries);
+}
+
+bool BlockStorage::GetTxnsForAddress(const Address& address,
+                                     const unsigned int page,
+                                     const unsigned int pageSize,
+                                     vector<pair<uint64_t, TxnHash>>& txns,
+                                     bool& hasMore) {
+  if (!LOOKUP_NODE_MODE) {
+    LOG_GENERAL(WARNING, "Non lookup node should not trigger this.");
+    return false;
+  }
+
+  if (page < 1 || pageSize == 0) {
+    LOG_GENERAL(WARNING, "Invalid page " << page << " of size " << pageSize);
+    return false;
+  }
+
+  txns.clear();
+  hasMore = false;
+
+  const string prefix = TxnAddressIndexPrefix(address);
+  const uint64_t skip = static_cast<uint64_t>(page - 1) * pageSize;
+  uint64_t seen = 0;
+
+  shared_lock<shared_timed_mutex> g(m_mutexTxnAddressIndex);
+  unique_ptr<ldb::Iterator> it(
+      m_txnAddressIndexDB->GetDB()->NewIterator(ldb::ReadOptions()));
+
+  // Walk backwards from the end of the address range, newest epoch first
+  it->Seek(prefix + "~");
+  if (it->Valid()) {
+    it->Prev();
+  } else {
+    it->SeekToLast();
+  }
+
+  for (; it->Valid() && it->key().starts_with(prefix); it->Prev(), seen++) {
+    if (seen < skip) {
+      continue;
+    }
+    if (txns.size() == pageSize) {
+      hasMore = true;
+      break;
+    }
+
+    const string key = it->key().ToString();
+    if (key.size() != prefix.size() + INDEX_EPOCH_DIGITS + TxnHash::size * 2) {
+      LOG_GENERAL(WARNING, "Malformed txn address index key " << key);
+      continue;
+    }
+    txns.emplace_back(
+        strtoull(key.substr(prefix.size(), INDEX_EPOCH_DIGITS).c_str(),
+                 nullptr, 10),
+        TxnHash(key.substr(prefix.size() + INDEX_EPOCH_DIGITS)));
   }
-  if (bodyString.empty()) {
+
+  return true;
+}
+
+bool BlockStorage::GetTxBlockTxns(const uint64_t& blockNum, TxBlockTxns& txns) {
+  if (!LOOKUP_NODE_MODE) {
+    LOG_GENERAL(WARNING, "Non lookup node should not trigger this.");
     return false;
   }
-  body = make_shared<TransactionWithReceipt>(
-      bytes(bodyString.begin(), bodyString.end()), 0);
+
+  txns.clear();
+
+  const string prefix = ZeroPadded(blockNum, INDEX_EPOCH_DIGITS);
+
+  shared_lock<shared_timed_mutex> g(m_mutexTxBlockTxns);
+  unique_ptr<ldb::Iterator> it(
+      m_txBlockTxnsDB->GetDB()->NewIterator(ldb::ReadOptions()));
+
+  for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix);
+       it->Next()) {
+    const string key = it->key().ToString();
+    const ldb::Slice value = it->value();
+    if (key.size() != prefix.size() + INDEX_SHARD_DIGITS ||
+        value.size() < BlockHash::size ||
+        (value.size() - BlockHash::size) % TxnHash::size != 0) {
+      LOG_GENERAL(WARNING, "Malformed tx block txns entry " << key);
+      continue;
+    }
+
+    const auto data = reinterpret_cast<const unsigned char*>(value.data());
+    auto& entry = txns[static_cast<uint32_t>(
+        strtoul(key.substr(prefix.size()).c_str(), nullptr, 10))];
+    entry.first = BlockHash(data, BlockHash::ConstructFromPointer);
+    for (size_t offset = BlockHash::size; offset < value.size();
+         offset += TxnHash::size) {
+      entry.second.emplace_back(data + offset, TxnHash::ConstructFromPointer);
+    }
+  }
 
   return true;
 }
 
-bool BlockStorage::GetHistoricalMicroBlock(const BlockHash& blockhash,
-                                           MicroBlockSharedPtr& microblock) {
-  string blockString;
+bool BlockStorage::GetMicroBlockTxns(const uint64_t& blockNum,
+                                     const uint32_t& shardId, bytes& record) {
+  if (!LOOKUP_NODE_MODE) {
+    LOG_GENERAL(WARNING, "Non lookup node should not trigger this.");
+    return false;
+  }
+
+  const string key = ZeroPadded(blockNum, INDEX_EPOCH_DIGITS) +
+                     ZeroPadded(shardId, INDEX_SHARD_DIGITS);
+  string value;
   {
-    shared_lock<shared_timed_mutex> g(m_mutexMBHistorical);
-    blockString = m_MBHistoricalDB->Lookup(blockhash);
+    shared_lock<shared_timed_mutex> g(m_mutexMicroBlockTxns);
+    value = m_microBlockTxnsDB->Lookup(key);
+  }
+  if (value.empty()) {
+    return false;
   }
 
-  if (blockString.empty()) {
+  record.assign(value.begin(), value.end());
+  return true;
+}
+
+bool BlockStorage::UnpackMicroBlockTxns(const bytes& record, bytes& microBlock,
+                                        vector<bytes>& txBodies) {
+  txBodies.clear();
+
+  bool first = true;
+  size_t offset = 0;
+  while (offset < record.size()) {
+    if (record.size() - offset < RECORD_LENGTH_SIZE) {
+      return false;
+    }
+    const size_t length = Serializable::GetNumber<uint32_t>(
+        record, offset, RECORD_LENGTH_SIZE);
+    offset += RECORD_LENGTH_SIZE;
+    if (record.size() - offset < length) {
+      return false;
+    }
+
+    const auto begin = record.begin() + offset;
+    if (first) {
+      microBlock.assign(begin, begin + length);
+      first = false;
+    } else {
+      txBodies.emplace_back(begin, begin + length);
+    }
+    offset += length;
+  }
+
+  return !first;
+}
+
+bool BlockStorage::GetEventBloomMatches(
+    const uint64_t& fromBlock, const uint64_t& toBlock,
+    const Address& address, const string& eventName,
+    vector<pair<uint64_t, uint32_t>>& matches) {
+  if (!LOOKUP_NODE_MODE) {
+    LOG_GENERAL(WARNING, "Non lookup node should not trigger this.");
     return false;
   }
 
-  microblock =
-      make_shared<MicroBlock>(bytes(blockString.begin(), blockString.end()), 0);
+  matches.clear();
+
+  const string end = ZeroPadded(toBlock, INDEX_EPOCH_DIGITS) + "~";
+
+  shared_lock<shared_timed_mutex> g(m_mutexEventBloom);
+  unique_ptr<ldb::Iterator> it(
+      m_eventBloomDB->GetDB()->NewIterator(ldb::ReadOptions()));
+
+  it->Seek(ZeroPadded(fromBlock, INDEX_EPOCH_DIGITS));
+  while (it->Valid() && it->key().compare(ldb::Slice(end)) < 0) {
+    const string key = it->key().ToString();
+    const uint64_t blockNum =
+        strtoull(key.substr(0, INDEX_EPOCH_DIGITS).c_str(), nullptr, 10);
+
+    if (key.size() == INDEX_EPOCH_DIGITS &&
+        !ToEventBloom(it->value()).MayContain(address, eventName)) {
+      // Skip the micro blocks of the block
+      if (blockNum == toBlock) {
+        break;
+      }
+      it->Seek(ZeroPadded(blockNum + 1, INDEX_EPOCH_DIGITS));
+      continue;
+    }
+
+    if (key.size() == INDEX_EPOCH_DIGITS + INDEX_SHARD_DIGITS &&
+        ToEventBloom(it->value()).MayContain(address, eventName)) {
+      matches.emplace_back(
+          blockNum, static_cast<uint32_t>(strtoul(
+                        key.substr(INDEX_EPOCH_DIGITS).c_str(), nullptr, 10)));
+    }
+    it->Next();
+  }
+
+  return true;
+}
+
+bool BlockStorage::GetTxnFromHistoricalDB(const dev::h256& key,
+                                          TxBodySharedPtr& body) {
+  // The historical db is read only, so a miss stays a miss
+  if (m_txnHistoricalCache.Get(key, body)) {
+    return body != nullptr;
+  }
+
+  bytes bodyBytes;
+  if (!m_txnArchive.Lookup(key, bodyBytes)) {
+    std::string bodyString;
+    {
+      shared_lock<shared_timed_mutex> g(m_mutexTxnHistorical);
+      if (m_txnHistoricalDB) {
+        bodyString = m_txnHistoricalDB->Lookup(key);
+      }
+    }
+    if (bodyString.empty()) {
+      m_txnHistoricalCache.Put(key, nullptr);
+      return false;
+    }
+    bodyBytes.assign(bodyString.begin(), bodyString.end());
+  }
+  body = make_shared<TransactionWithReceipt>(bodyBytes, 0);
+  m_txnHistoricalCache.Put(key, body);
+
+  return true;
+}
+
+bool BlockStorage::GetHistoricalMicroBlock(const BlockHash& blockhash,
+                                           MicroBlockSharedPtr& microblock) {
+  bytes blockBytes;
+  if (!m_MBArchive.Lookup(blockhash, blockBytes)) {
+    string blockString;
+    {
+      shared_lock<shared_timed_mutex> g(m_mutexMBHistorical);
+      if (m_MBHistoricalDB) {
+        blockString = m_MBHistoricalDB->Lookup(blockhash);
+      }
+    }
+
+    if (blockString.empty()) {
+      return false;
+    }
+    blockBytes.assign(blockString.begin(), blockString.end());
+  }
+
+  microblock = make_shared<MicroBlock>(blockBytes, 0);
 
   return true;
 }
@@ -172,6 +698,10 @@ bool BlockStorage::GetMicroBlock(const BlockHash& blockHash,
                                  MicroBlockSharedPtr& microblock) {
   LOG_MARKER();
 
+  if (m_microBlockCache.Get(blockHash, microblock)) {
+    return true;
+  }
+
   string blockString;
 
   {
@@ -184,6 +714,7 @@ bool BlockStorage::GetMicroBlock(const BlockHash& blockHash,
   }
   microblock =
       make_shared<MicroBlock>(bytes(blockString.begin(), blockString.end()), 0);
+  m_microBlockCache.Put(blockHash, microblock);
 
   return true;
 }
@@ -197,8 +728,7 @@ bool BlockStorage::GetRangeMicroBlocks(const uint64_t lowEpochNum,
 
   shared_lock<shared_timed_mutex> g(m_mutexMicroBlock);
 
-  leveldb::Iterator* it =
-      m_microBlockDB->GetDB()->NewIterator(leveldb::ReadOptions());
+  ldb::Iterator* it = m_microBlockDB->GetDB()->NewIterator(ldb::ReadOptions());
   for (it->SeekToFirst(); it->Valid(); it->Next()) {
     string bns = it->key().ToString();
     string blockString = it->value().ToString();
@@ -231,7 +761,7 @@ bool BlockStorage::GetRangeMicroBlocks(const uint64_t lowEpochNum,
   return true;
 }
 
-bool BlockStorage::PutTempState(const unordered_map<Address, Account>& states) {
+bool BlockStorage::PutTempState(const FixedHashMap<Address, Account>& states) {
   // LOG_MARKER();
 
   unordered_map<string, string> states_str;
@@ -248,14 +778,14 @@ bool BlockStorage::PutTempState(const unordered_map<Address, Account>& states) {
   return m_tempStateDB->BatchInsert(states_str);
 }
 
-bool BlockStorage::GetTempStateInBatch(leveldb::Iterator*& iter,
+bool BlockStorage::GetTempStateInBatch(ldb::Iterator*& iter,
                                        vector<StateSharedPtr>& states) {
   // LOG_MARKER();
 
   shared_lock<shared_timed_mutex> g(m_mutexTempState);
 
   if (iter == nullptr) {
-    iter = m_tempStateDB->GetDB()->NewIterator(leveldb::ReadOptions());
+    iter = m_tempStateDB->GetDB()->NewIterator(ldb::ReadOptions());
     iter->SeekToFirst();
   }
 
@@ -425,19 +955,152 @@ bool BlockStorage::GetTxBlock(const uint64_t& blockNum,
 }
 
 bool BlockStorage::GetTxBody(const dev::h256& key, TxBodySharedPtr& body) {
+  if (m_txBodyCache.Get(key, body)) {
+    return body != nullptr;
+  }
+
   std::string bodyString;
 
   {
     shared_lock<shared_timed_mutex> g(m_mutexTxBody);
     bodyString = m_txBodyDB->Lookup(key);
+    if (bodyString.empty()) {
+      // Recorded under the lock so that a concurrent put of this body, which
+      // erases the entry, cannot be overtaken by it
+      m_txBodyCache.Put(key, nullptr);
+      return false;
+    }
   }
 
-  if (bodyString.empty()) {
-    return false;
-  }
   body = TxBodySharedPtr(new TransactionWithReceipt(
       bytes(bodyString.begin(), bodyString.end()), 0));
+  m_txBodyCache.Put(key, body);
+
+  return true;
+}
+
+void BlockStorage::LogReadCacheStats() {
+  LOG_GENERAL(INFO, "TxBody cache hits = " << m_txBodyCache.GetHits()
+                                           << " misses = "
+                                           << m_txBodyCache.GetMisses());
+  LOG_GENERAL(INFO, "MicroBlock cache hits = "
+                        << m_microBlockCache.GetHits()
+                        << " misses = " << m_microBlockCache.GetMisses());
+  m_txBodyCache.ResetStats();
+  m_microBlockCache.ResetStats();
+}
+
+// Compacts the whole db. The handle is held without the BlockStorage lock, so
+// writes to the db carry on meanwhile.
+static void CompactDB(const shared_ptr<ldb::DB>& db) {
+#ifdef USE_ROCKSDB
+  db->CompactRange(ldb::CompactRangeOptions(), nullptr, nullptr);
+#else
+  db->CompactRange(nullptr, nullptr);
+#endif  // USE_ROCKSDB
+}
+
+unsigned int BlockStorage::DeleteInBatches(const shared_ptr<LevelDB>& db,
+                                           shared_timed_mutex& mutex,
+                                           const vector<string>& keys) {
+  const unsigned int batchSize = max(PRUNE_BATCH_SIZE, 1u);
+  unsigned int deleted = 0;
+
+  for (unsigned int i = 0; i < keys.size(); i += batchSize) {
+    ldb::WriteBatch batch;
+    const unsigned int end = min<size_t>(i + batchSize, keys.size());
+    for (unsigned int j = i; j < end; j++) {
+      batch.Delete(keys[j]);
+    }
+
+    {
+      unique_lock<shared_timed_mutex> g(mutex);
+      if (0 != db->BatchInsert(batch)) {
+        LOG_GENERAL(WARNING, "Failed to prune " << db->GetDBName());
+        break;
+      }
+    }
+    deleted += end - i;
+
+    this_thread::sleep_for(chrono::milliseconds(PRUNE_BATCH_INTERVAL_IN_MS));
+  }
+
+  if (deleted > 0) {
+    shared_ptr<ldb::DB> handle;
+    {
+      shared_lock<shared_timed_mutex> g(mutex);
+      handle = db->GetDB();
+    }
+    CompactDB(handle);
+  }
+
+  return deleted;
+}
 
+bool BlockStorage::PruneHistory(const uint64_t& stateDeltaBelow,
+                                const uint64_t& txBodyBelow) {
+  LOG_MARKER();
+
+  if (m_pruning.exchange(true)) {
+    LOG_GENERAL(INFO, "Pruning already in progress");
+    return false;
+  }
+
+  if (stateDeltaBelow > 0) {
+    vector<string> keys;
+    {
+      shared_lock<shared_timed_mutex> g(m_mutexStateDelta);
+      unique_ptr<ldb::Iterator> it(
+          m_stateDeltaDB->GetDB()->NewIterator(ldb::ReadOptions()));
+      for (it->SeekToFirst(); it->Valid(); it->Next()) {
+        const string key = it->key().ToString();
+        try {
+          if (stoull(key) < stateDeltaBelow) {
+            keys.emplace_back(key);
+          }
+        } catch (const exception&) {
+          LOG_GENERAL(WARNING, "Unexpected state delta key " << key);
+        }
+      }
+    }
+
+    LOG_GENERAL(INFO, "Pruned "
+                          << DeleteInBatches(m_stateDeltaDB, m_mutexStateDelta,
+                                             keys)
+                          << " state deltas below final block "
+                          << stateDeltaBelow);
+  }
+
+  if (LOOKUP_NODE_MODE && txBodyBelow > m_txBodyPrunedBelow) {
+    list<MicroBlockSharedPtr> microBlocks;
+    GetRangeMicroBlocks(m_txBodyPrunedBelow, txBodyBelow - 1, 0,
+                        numeric_limits<uint32_t>::max(), microBlocks);
+
+    vector<string> keys;
+    vector<string> recordKeys;
+    for (const auto& microBlock : microBlocks) {
+      for (const auto& tranHash : microBlock->GetTranHashes()) {
+        keys.emplace_back(tranHash.hex());
+        m_txBodyCache.Erase(tranHash);
+      }
+      recordKeys.emplace_back(
+          ZeroPadded(microBlock->GetHeader().GetEpochNum(),
+                     INDEX_EPOCH_DIGITS) +
+          ZeroPadded(microBlock->GetHeader().GetShardId(), INDEX_SHARD_DIGITS));
+    }
+
+    LOG_GENERAL(INFO, "Pruned "
+                          << DeleteInBatches(m_txBodyDB, m_mutexTxBody, keys)
+                          << " txn bodies below epoch " << txBodyBelow);
+    LOG_GENERAL(INFO, "Pruned " << DeleteInBatches(m_microBlockTxnsDB,
+                                                   m_mutexMicroBlockTxns,
+                                                   recordKeys)
+                                << " micro block txns records below epoch "
+                                << txBodyBelow);
+    m_txBodyPrunedBelow = txBodyBelow;
+  }
+
+  m_pruning = false;
   return true;
 }
 
@@ -464,6 +1127,7 @@ bool BlockStorage::DeleteTxBlock(const uint64_t& blocknum) {
   LOG_GENERAL(INFO, "Delete TxBlock Num: " << blocknum);
   unique_lock<shared_timed_mutex> g(m_mutexTxBlockchain);
   int ret = m_txBlockchainDB->DeleteKey(blocknum);
+  m_txBlockSnapshot.Remove(blocknum);
   return (ret == 0);
 }
 
@@ -475,6 +1139,7 @@ bool BlockStorage::DeleteTxBody(const dev::h256& key) {
   } else {
     unique_lock<shared_timed_mutex> g(m_mutexTxBody);
     ret = m_txBodyDB->DeleteKey(key);
+    m_txBodyCache.Erase(key);
   }
 
   return (ret == 0);
@@ -502,8 +1167,8 @@ bool BlockStorage::GetAllDSBlocks(std::list<DSBlockSharedPtr>& blocks) {
 
   shared_lock<shared_timed_mutex> g(m_mutexDsBlockchain);
 
-  leveldb::Iterator* it =
-      m_dsBlockchainDB->GetDB()->NewIterator(leveldb::ReadOptions());
+  ldb::Iterator* it =
+      m_dsBlockchainDB->GetDB()->NewIterator(ldb::ReadOptions());
   for (it->SeekToFirst(); it->Valid(); it->Next()) {
     string bns = it->key().ToString();
     string blockString = it->value().ToString();
@@ -534,8 +1199,8 @@ bool BlockStorage::GetAllTxBlocks(std::list<TxBlockSharedPtr>& blocks) {
 
   shared_lock<shared_timed_mutex> g(m_mutexTxBlockchain);
 
-  leveldb::Iterator* it =
-      m_txBlockchainDB->GetDB()->NewIterator(leveldb::ReadOptions());
+  ldb::Iterator* it =
+      m_txBlockchainDB->GetDB()->NewIterator(ldb::ReadOptions());
   for (it->SeekToFirst(); it->Valid(); it->Next()) {
     string bns = it->key().ToString();
     string blockString = it->value().ToString();
@@ -560,6 +1225,135 @@ bool BlockStorage::GetAllTxBlocks(std::list<TxBlockSharedPtr>& blocks) {
   return true;
 }
 
+bool BlockStorage::GetTxBlockNumRange(uint64_t& lowest, uint64_t& highest) {
+  LOG_MARKER();
+
+  shared_lock<shared_timed_mutex> g(m_mutexTxBlockchain);
+
+  // Keys are in string order, not in block number order
+  bool found = false;
+  ldb::Iterator* it =
+      m_txBlockchainDB->GetDB()->NewIterator(ldb::ReadOptions());
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    const uint64_t blockNum =
+        strtoull(it->key().ToString().c_str(), nullptr, 10);
+    if (!found) {
+      lowest = highest = blockNum;
+      found = true;
+    } else {
+      lowest = min(lowest, blockNum);
+      highest = max(highest, blockNum);
+    }
+  }
+
+  delete it;
+
+  if (!found) {
+    LOG_GENERAL(INFO, "Disk has no TxBlock");
+  }
+  return found;
+}
+
+bool BlockStorage::GetTxBlocks(const uint64_t& from, const uint64_t& to,
+                               std::list<TxBlockSharedPtr>& blocks) {
+  shared_lock<shared_timed_mutex> g(m_mutexTxBlockchain);
+
+  for (uint64_t blockNum = from; blockNum <= to; blockNum++) {
+    const string blockString = m_txBlockchainDB->Lookup(blockNum);
+    if (blockString.empty()) {
+      LOG_GENERAL(WARNING, "Lost TxBlock " << blockNum << " in the chain");
+      return false;
+    }
+    blocks.emplace_back(make_shared<TxBlock>(
+        bytes(blockString.begin(), blockString.end()), 0));
+  }
+
+  return true;
+}
+
+bool BlockStorage::GetRecentTxBlocks(std::list<TxBlockSharedPtr>& blocks) {
+  LOG_MARKER();
+
+  if (ENABLE_WARM_START && GetSnapshotTxBlocks(blocks)) {
+    return true;
+  }
+
+  uint64_t lowest = 0, highest = 0;
+  if (!GetTxBlockNumRange(lowest, highest)) {
+    return false;
+  }
+
+  const uint64_t window = m_txBlockSnapshot.GetCapacity();
+  const uint64_t from =
+      (highest - lowest >= window) ? highest + 1 - window : lowest;
+  list<TxBlockSharedPtr> result;
+  if (!GetTxBlocks(from, highest, result)) {
+    return false;
+  }
+
+  if (ENABLE_WARM_START) {
+    map<uint64_t, bytes> recent;
+    for (const auto& block : result) {
+      bytes body;
+      block->Serialize(body, 0);
+      recent.emplace(block->GetHeader().GetBlockNum(), move(body));
+    }
+    m_txBlockSnapshot.Reset(move(recent));
+    m_txBlockSnapshot.Write();
+  }
+
+  blocks = move(result);
+  LOG_GENERAL(INFO, "Retrieved TxBlocks " << from << " to " << highest
+                                          << " of " << lowest << " to "
+                                          << highest);
+  return true;
+}
+
+bool BlockStorage::GetSnapshotTxBlocks(std::list<TxBlockSharedPtr>& blocks) {
+  map<uint64_t, bytes> recent;
+  if (!m_txBlockSnapshot.Read(recent)) {
+    return false;
+  }
+
+  const uint64_t oldest = recent.begin()->first;
+  const uint64_t newest = recent.rbegin()->first;
+
+  // Too short to recreate the states from, unless it is the whole chain
+  if (oldest > 0 && recent.size() < m_txBlockSnapshot.GetCapacity()) {
+    LOG_GENERAL(WARNING, "Snapshot holds only " << recent.size()
+                                                << " Tx blocks");
+    return false;
+  }
+
+  {
+    shared_lock<shared_timed_mutex> g(m_mutexTxBlockchain);
+    for (const uint64_t& blockNum : {oldest, newest}) {
+      const string blockString = m_txBlockchainDB->Lookup(blockNum);
+      const bytes& body = recent.at(blockNum);
+      if (blockString.size() != body.size() ||
+          !equal(body.begin(), body.end(), blockString.begin())) {
+        LOG_GENERAL(WARNING, "Snapshot does not match TxBlock " << blockNum);
+        return false;
+      }
+    }
+    if (!m_txBlockchainDB->Lookup(newest + 1).empty()) {
+      LOG_GENERAL(WARNING, "Snapshot is older than TxBlock " << newest + 1);
+      return false;
+    }
+  }
+
+  list<TxBlockSharedPtr> result;
+  for (const auto& entry : recent) {
+    result.emplace_back(make_shared<TxBlock>(entry.second, 0));
+  }
+  blocks = move(result);
+  m_txBlockSnapshot.Reset(move(recent));
+
+  LOG_GENERAL(INFO, "Retrieved TxBlocks " << oldest << " to " << newest
+                                          << " from snapshot");
+  return true;
+}
+
 bool BlockStorage::GetAllTxBodiesTmp(std::list<TxnHash>& txnHashes) {
   if (!LOOKUP_NODE_MODE) {
     LOG_GENERAL(WARNING,
@@ -572,8 +1366,7 @@ bool BlockStorage::GetAllTxBodiesTmp(std::list<TxnHash>& txnHashes) {
 
   shared_lock<shared_timed_mutex> g(m_mutexTxBodyTmp);
 
-  leveldb::Iterator* it =
-      m_txBodyTmpDB->GetDB()->NewIterator(leveldb::ReadOptions());
+  ldb::Iterator* it = m_txBodyTmpDB->GetDB()->NewIterator(ldb::ReadOptions());
   for (it->SeekToFirst(); it->Valid(); it->Next()) {
     string hashString = it->key().ToString();
     if (hashString.empty()) {
@@ -594,8 +1387,7 @@ bool BlockStorage::GetAllBlockLink(std::list<BlockLink>& blocklinks) {
 
   shared_lock<shared_timed_mutex> g(m_mutexBlockLink);
 
-  leveldb::Iterator* it =
-      m_blockLinkDB->GetDB()->NewIterator(leveldb::ReadOptions());
+  ldb::Iterator* it = m_blockLinkDB->GetDB()->NewIterator(ldb::ReadOptions());
   for (it->SeekToFirst(); it->Valid(); it->Next()) {
     string bns = it->key().ToString();
     string blockString = it->value().ToString();
@@ -635,6 +1427,58 @@ bool BlockStorage::PutMetadata(MetaType type, const bytes& data) {
   return (ret == 0);
 }
 
+bool BlockStorage::CommitEpoch(const uint64_t& txBlockNum) {
+  const DBDurability durability = LevelDB::GetDurability();
+  if (durability == DBDurability::ASYNC) {
+    // A marker left from another mode would be stale once the node moves on
+    static once_flag clearMarker;
+    call_once(clearMarker, [this]() {
+      unique_lock<shared_timed_mutex> g(m_mutexMetadata);
+      m_metadataDB->DeleteKey(to_string((int)MetaType::EPOCHCOMMITTED));
+    });
+    return true;
+  }
+
+  if (durability == DBDurability::EPOCH && !LevelDB::SyncAll()) {
+    LOG_GENERAL(WARNING, "Failed to sync the dbs for Tx block " << txBlockNum);
+    return false;
+  }
+
+  const string marker = to_string(txBlockNum);
+  unique_lock<shared_timed_mutex> g(m_mutexMetadata);
+  if (m_metadataDB->Insert(to_string((int)MetaType::EPOCHCOMMITTED),
+                           bytes(marker.begin(), marker.end())) != 0 ||
+      !m_metadataDB->Sync()) {
+    LOG_GENERAL(WARNING, "Failed to mark Tx block " << txBlockNum
+                                                     << " as committed");
+    return false;
+  }
+  return true;
+}
+
+bool BlockStorage::GetCommittedEpoch(uint64_t& txBlockNum) {
+  if (LevelDB::GetDurability() == DBDurability::ASYNC) {
+    return false;
+  }
+
+  string marker;
+  {
+    shared_lock<shared_timed_mutex> g(m_mutexMetadata);
+    marker = m_metadataDB->Lookup(to_string((int)MetaType::EPOCHCOMMITTED));
+  }
+  if (marker.empty()) {
+    return false;
+  }
+
+  try {
+    txBlockNum = stoull(marker);
+  } catch (const exception& e) {
+    LOG_GENERAL(WARNING, "Bad commit marker " << marker << ": " << e.what());
+    return false;
+  }
+  return true;
+}
+
 bool BlockStorage::PutStateRoot(const bytes& data) {
   LOG_MARKER();
   unique_lock<shared_timed_mutex> g(m_mutexStateRoot);
@@ -910,32 +1754,17 @@ bool BlockStorage::PutDiagnosticDataCoinbase(
   return true;
 }
 
-bool BlockStorage::GetDiagnosticDataNodes(const uint64_t& dsBlockNum,
-                                          DequeOfShard& shards,
-                                          DequeOfNode& dsCommittee) {
-  LOG_MARKER();
-
-  string dataStr;
-
-  {
-    lock_guard<mutex> g(m_mutexDiagnostic);
-    dataStr = m_diagnosticDBNodes->Lookup(dsBlockNum);
-  }
-
-  if (dataStr.empty()) {
-    LOG_GENERAL(WARNING,
-                "Failed to retrieve diagnostic data for DS block number "
-                    << dsBlockNum);
-    return false;
-  }
+namespace {
 
+bool DecodeDiagnosticDataNodes(const string& dataStr,
+                               DiagnosticDataNodes& entry) {
   bytes data(dataStr.begin(), dataStr.end());
 
   uint32_t shardingStructureVersion = 0;
   uint32_t dsCommitteeVersion = 0;
   if (!Messenger::GetDiagnosticDataNodes(data, 0, shardingStructureVersion,
-                                         shards, dsCommitteeVersion,
-                                         dsCommittee)) {
+                                         entry.shards, dsCommitteeVersion,
+                                         entry.dsCommittee)) {
     LOG_GENERAL(WARNING, "Messenger::GetDiagnosticDataNodes failed");
     return false;
   }
@@ -955,15 +1784,30 @@ bool BlockStorage::GetDiagnosticDataNodes(const uint64_t& dsBlockNum,
   return true;
 }
 
-bool BlockStorage::GetDiagnosticDataCoinbase(const uint64_t& dsBlockNum,
-                                             DiagnosticDataCoinbase& entry) {
+bool DecodeDiagnosticDataCoinbase(const string& dataStr,
+                                  DiagnosticDataCoinbase& entry) {
+  bytes data(dataStr.begin(), dataStr.end());
+
+  if (!Messenger::GetDiagnosticDataCoinbase(data, 0, entry)) {
+    LOG_GENERAL(WARNING, "Messenger::GetDiagnosticDataCoinbase failed");
+    return false;
+  }
+
+  return true;
+}
+
+}  // namespace
+
+bool BlockStorage::GetDiagnosticDataNodes(const uint64_t& dsBlockNum,
+                                          DequeOfShard& shards,
+                                          DequeOfNode& dsCommittee) {
   LOG_MARKER();
 
   string dataStr;
 
   {
     lock_guard<mutex> g(m_mutexDiagnostic);
-    dataStr = m_diagnosticDBCoinbase->Lookup(dsBlockNum);
+    dataStr = m_diagnosticDBNodes->Lookup(dsBlockNum);
   }
 
   if (dataStr.empty()) {
@@ -973,123 +1817,154 @@ bool BlockStorage::GetDiagnosticDataCoinbase(const uint64_t& dsBlockNum,
     return false;
   }
 
-  bytes data(dataStr.begin(), dataStr.end());
-
-  if (!Messenger::GetDiagnosticDataCoinbase(data, 0, entry)) {
-    LOG_GENERAL(WARNING, "Messenger::GetDiagnosticDataCoinbase failed");
+  DiagnosticDataNodes entry;
+  if (!DecodeDiagnosticDataNodes(dataStr, entry)) {
     return false;
   }
 
+  shards = move(entry.shards);
+  dsCommittee = move(entry.dsCommittee);
   return true;
 }
 
+bool BlockStorage::GetDiagnosticDataCoinbase(const uint64_t& dsBlockNum,
+                                             DiagnosticDataCoinbase& entry) {
+  LOG_MARKER();
+
+  string dataStr;
+
+  {
+    lock_guard<mutex> g(m_mutexDiagnostic);
+    dataStr = m_diagnosticDBCoinbase->Lookup(dsBlockNum);
+  }
+
+  if (dataStr.empty()) {
+    LOG_GENERAL(WARNING,
+                "Failed to retrieve diagnostic data for DS block number "
+                    << dsBlockNum);
+    return false;
+  }
+
+  return DecodeDiagnosticDataCoinbase(dataStr, entry);
+}
+
 void BlockStorage::GetDiagnosticDataNodes(
     map<uint64_t, DiagnosticDataNodes>& diagnosticDataMap) {
   LOG_MARKER();
 
-  lock_guard<mutex> g(m_mutexDiagnostic);
+  uint64_t first, last;
+  if (!GetDiagnosticDataNodesRange(first, last)) {
+    return;
+  }
 
-  leveldb::Iterator* it =
-      m_diagnosticDBNodes->GetDB()->NewIterator(leveldb::ReadOptions());
+  ForEachDiagnosticDataNodes(
+      first, last,
+      [&diagnosticDataMap](uint64_t dsBlockNum,
+                           const DiagnosticDataNodes& entry) {
+        diagnosticDataMap.emplace(dsBlockNum, entry);
+        return true;
+      });
+}
 
-  unsigned int index = 0;
-  for (it->SeekToFirst(); it->Valid(); it->Next()) {
-    string dsBlockNumStr = it->key().ToString();
-    string dataStr = it->value().ToString();
+void BlockStorage::GetDiagnosticDataCoinbase(
+    map<uint64_t, DiagnosticDataCoinbase>& diagnosticDataMap) {
+  LOG_MARKER();
 
-    if (dsBlockNumStr.empty() || dataStr.empty()) {
-      LOG_GENERAL(WARNING,
-                  "Failed to retrieve diagnostic data at index " << index);
-      continue;
-    }
+  uint64_t first, last;
+  if (!GetDiagnosticDataCoinbaseRange(first, last)) {
+    return;
+  }
 
-    uint64_t dsBlockNum = 0;
-    try {
-      dsBlockNum = stoul(dsBlockNumStr);
-    } catch (...) {
-      LOG_GENERAL(WARNING,
-                  "Non-numeric key " << dsBlockNumStr << " at index " << index);
-      continue;
-    }
+  ForEachDiagnosticDataCoinbase(
+      first, last,
+      [&diagnosticDataMap](uint64_t dsBlockNum,
+                           const DiagnosticDataCoinbase& entry) {
+        diagnosticDataMap.emplace(dsBlockNum, entry);
+        return true;
+      });
+}
 
-    bytes data(dataStr.begin(), dataStr.end());
+bool BlockStorage::GetDiagnosticDataRange(const shared_ptr<LevelDB>& db,
+                                          uint64_t& first, uint64_t& last) {
+  lock_guard<mutex> g(m_mutexDiagnostic);
 
-    DiagnosticDataNodes entry;
-    uint32_t shardingStructureVersion = 0;
-    uint32_t dsCommitteeVersion = 0;
-
-    if (!Messenger::GetDiagnosticDataNodes(data, 0, shardingStructureVersion,
-                                           entry.shards, dsCommitteeVersion,
-                                           entry.dsCommittee)) {
-      LOG_GENERAL(
-          WARNING,
-          "Messenger::GetDiagnosticDataNodes failed for DS block number "
-              << dsBlockNumStr << " at index " << index);
-      continue;
-    }
+  // The keys are decimal strings, which leveldb does not keep in numeric
+  // order, so every key is visited. Only the keys are parsed.
+  unique_ptr<ldb::Iterator> it(db->GetDB()->NewIterator(ldb::ReadOptions()));
 
-    if (shardingStructureVersion != SHARDINGSTRUCTURE_VERSION) {
-      LOG_CHECK_FAIL("Sharding structure version", shardingStructureVersion,
-                     SHARDINGSTRUCTURE_VERSION)
+  bool found = false;
+  for (it->SeekToFirst(); it->Valid(); it->Next()) {
+    uint64_t dsBlockNum = 0;
+    try {
+      dsBlockNum = stoull(it->key().ToString());
+    } catch (...) {
+      LOG_GENERAL(WARNING, "Non-numeric key " << it->key().ToString());
       continue;
     }
 
-    if (dsCommitteeVersion != DSCOMMITTEE_VERSION) {
-      LOG_CHECK_FAIL("DS committee version", dsCommitteeVersion,
-                     DSCOMMITTEE_VERSION);
-      continue;
+    if (!found) {
+      first = last = dsBlockNum;
+      found = true;
+    } else {
+      first = min(first, dsBlockNum);
+      last = max(last, dsBlockNum);
     }
-
-    diagnosticDataMap.emplace(make_pair(dsBlockNum, entry));
-
-    index++;
   }
-}
 
-void BlockStorage::GetDiagnosticDataCoinbase(
-    map<uint64_t, DiagnosticDataCoinbase>& diagnosticDataMap) {
-  LOG_MARKER();
+  return found;
+}
 
-  lock_guard<mutex> g(m_mutexDiagnostic);
+bool BlockStorage::GetDiagnosticDataNodesRange(uint64_t& first,
+                                               uint64_t& last) {
+  return GetDiagnosticDataRange(m_diagnosticDBNodes, first, last);
+}
 
-  leveldb::Iterator* it =
-      m_diagnosticDBCoinbase->GetDB()->NewIterator(leveldb::ReadOptions());
+bool BlockStorage::GetDiagnosticDataCoinbaseRange(uint64_t& first,
+                                                  uint64_t& last) {
+  return GetDiagnosticDataRange(m_diagnosticDBCoinbase, first, last);
+}
 
-  unsigned int index = 0;
-  for (it->SeekToFirst(); it->Valid(); it->Next()) {
-    string dsBlockNumStr = it->key().ToString();
-    string dataStr = it->value().ToString();
+void BlockStorage::ForEachDiagnosticDataNodes(
+    uint64_t first, uint64_t last,
+    const function<bool(uint64_t, const DiagnosticDataNodes&)>& visitor) {
+  for (uint64_t dsBlockNum = first; dsBlockNum <= last; dsBlockNum++) {
+    string dataStr;
+    {
+      lock_guard<mutex> g(m_mutexDiagnostic);
+      dataStr = m_diagnosticDBNodes->Lookup(dsBlockNum);
+    }
 
-    if (dsBlockNumStr.empty() || dataStr.empty()) {
-      LOG_GENERAL(WARNING,
-                  "Failed to retrieve diagnostic data at index " << index);
+    DiagnosticDataNodes entry;
+    if (dataStr.empty() || !DecodeDiagnosticDataNodes(dataStr, entry)) {
       continue;
     }
 
-    uint64_t dsBlockNum = 0;
-    try {
-      dsBlockNum = stoul(dsBlockNumStr);
-    } catch (...) {
-      LOG_GENERAL(WARNING,
-                  "Non-numeric key " << dsBlockNumStr << " at index " << index);
-      continue;
+    if (!visitor(dsBlockNum, entry) ||
+        dsBlockNum == numeric_limits<uint64_t>::max()) {
+      break;
     }
+  }
+}
 
-    bytes data(dataStr.begin(), dataStr.end());
+void BlockStorage::ForEachDiagnosticDataCoinbase(
+    uint64_t first, uint64_t last,
+    const function<bool(uint64_t, const DiagnosticDataCoinbase&)>& visitor) {
+  for (uint64_t dsBlockNum = first; dsBlockNum <= last; dsBlockNum++) {
+    string dataStr;
+    {
+      lock_guard<mutex> g(m_mutexDiagnostic);
+      dataStr = m_diagnosticDBCoinbase->Lookup(dsBlockNum);
+    }
 
     DiagnosticDataCoinbase entry;
-
-    if (!Messenger::GetDiagnosticDataCoinbase(data, 0, entry)) {
-      LOG_GENERAL(
-          WARNING,
-          "Messenger::GetDiagnosticDataCoinbase failed for DS block number "
-              << dsBlockNumStr << " at index " << index);
+    if (dataStr.empty() || !DecodeDiagnosticDataCoinbase(dataStr, entry)) {
       continue;
     }
 
-    diagnosticDataMap.emplace(make_pair(dsBlockNum, entry));
-
-    index++;
+    if (!visitor(dsBlockNum, entry) ||
+        dsBlockNum == numeric_limits<uint64_t>::max()) {
+      break;
+    }
   }
 }
 
@@ -1138,11 +2013,13 @@ bool BlockStorage::ResetDB(DBTYPE type) {
     case TX_BLOCK: {
       unique_lock<shared_timed_mutex> g(m_mutexTxBlockchain);
       ret = m_txBlockchainDB->ResetDB();
+      m_txBlockSnapshot.Clear();
       break;
     }
     case TX_BODY: {
       unique_lock<shared_timed_mutex> g(m_mutexTxBody);
       ret = m_txBodyDB->ResetDB();
+      m_txBodyCache.Clear();
       break;
     }
     case TX_BODY_TMP: {
@@ -1153,6 +2030,7 @@ bool BlockStorage::ResetDB(DBTYPE type) {
     case MICROBLOCK: {
       unique_lock<shared_timed_mutex> g(m_mutexMicroBlock);
       ret = m_microBlockDB->ResetDB();
+      m_microBlockCache.Clear();
       break;
     }
     case DS_COMMITTEE: {
@@ -1211,6 +2089,26 @@ bool BlockStorage::ResetDB(DBTYPE type) {
       ret = m_stateRootDB->ResetDB();
       break;
     }
+    case TXN_ADDRESS_INDEX: {
+      unique_lock<shared_timed_mutex> g(m_mutexTxnAddressIndex);
+      ret = m_txnAddressIndexDB->ResetDB();
+      break;
+    }
+    case TX_BLOCK_TXNS: {
+      unique_lock<shared_timed_mutex> g(m_mutexTxBlockTxns);
+      ret = m_txBlockTxnsDB->ResetDB();
+      break;
+    }
+    case EVENT_BLOOMS: {
+      unique_lock<shared_timed_mutex> g(m_mutexEventBloom);
+      ret = m_eventBloomDB->ResetDB();
+      break;
+    }
+    case MICROBLOCK_TXNS: {
+      unique_lock<shared_timed_mutex> g(m_mutexMicroBlockTxns);
+      ret = m_microBlockTxnsDB->ResetDB();
+      break;
+    }
   }
   if (!ret) {
     LOG_GENERAL(INFO, "FAIL: Reset DB " << type << " failed");
@@ -1240,6 +2138,7 @@ bool BlockStorage::RefreshDB(DBTYPE type) {
     case TX_BODY: {
       unique_lock<shared_timed_mutex> g(m_mutexTxBody);
       ret = m_txBodyDB->RefreshDB();
+      m_txBodyCache.Clear();
       break;
     }
     case TX_BODY_TMP: {
@@ -1250,6 +2149,7 @@ bool BlockStorage::RefreshDB(DBTYPE type) {
     case MICROBLOCK: {
       unique_lock<shared_timed_mutex> g(m_mutexMicroBlock);
       ret = m_microBlockDB->RefreshDB();
+      m_microBlockCache.Clear();
       break;
     }
     case DS_COMMITTEE: {
@@ -1303,6 +2203,26 @@ bool BlockStorage::RefreshDB(DBTYPE type) {
       ret = m_stateRootDB->RefreshDB();
       break;
     }
+    case TXN_ADDRESS_INDEX: {
+      unique_lock<shared_timed_mutex> g(m_mutexTxnAddressIndex);
+      ret = m_txnAddressIndexDB->RefreshDB();
+      break;
+    }
+    case TX_BLOCK_TXNS: {
+      unique_lock<shared_timed_mutex> g(m_mutexTxBlockTxns);
+      ret = m_txBlockTxnsDB->RefreshDB();
+      break;
+    }
+    case EVENT_BLOOMS: {
+      unique_lock<shared_timed_mutex> g(m_mutexEventBloom);
+      ret = m_eventBloomDB->RefreshDB();
+      break;
+    }
+    case MICROBLOCK_TXNS: {
+      unique_lock<shared_timed_mutex> g(m_mutexMicroBlockTxns);
+      ret = m_microBlockTxnsDB->RefreshDB();
+      break;
+    }
     case TEMP_STATE: {
       unique_lock<shared_timed_mutex> g(m_mutexTempState);
       ret = m_tempStateDB->RefreshDB();
@@ -1398,6 +2318,26 @@ std::vector<std::string> BlockStorage::GetDBName(DBTYPE type) {
       ret.push_back(m_stateRootDB->GetDBName());
       break;
     }
+    case TXN_ADDRESS_INDEX: {
+      shared_lock<shared_timed_mutex> g(m_mutexTxnAddressIndex);
+      ret.push_back(m_txnAddressIndexDB->GetDBName());
+      break;
+    }
+    case TX_BLOCK_TXNS: {
+      shared_lock<shared_timed_mutex> g(m_mutexTxBlockTxns);
+      ret.push_back(m_txBlockTxnsDB->GetDBName());
+      break;
+    }
+    case EVENT_BLOOMS: {
+      shared_lock<shared_timed_mutex> g(m_mutexEventBloom);
+      ret.push_back(m_eventBloomDB->GetDBName());
+      break;
+    }
+    case MICROBLOCK_TXNS: {
+      shared_lock<shared_timed_mutex> g(m_mutexMicroBlockTxns);
+      ret.push_back(m_microBlockTxnsDB->GetDBName());
+      break;
+    }
   }
 
   return ret;
@@ -1421,7 +2361,9 @@ bool BlockStorage::ResetAll() {
            ResetDB(BLOCKLINK) & ResetDB(SHARD_STRUCTURE) &
            ResetDB(STATE_DELTA) & ResetDB(TEMP_STATE) &
            ResetDB(DIAGNOSTIC_NODES) & ResetDB(DIAGNOSTIC_COINBASE) &
-           ResetDB(STATE_ROOT);
+           ResetDB(STATE_ROOT) & ResetDB(TXN_ADDRESS_INDEX) &
+           ResetDB(TX_BLOCK_TXNS) & ResetDB(EVENT_BLOOMS) &
+           ResetDB(MICROBLOCK_TXNS);
   }
 }
 
@@ -1444,7 +2386,9 @@ bool BlockStorage::RefreshAll() {
            RefreshDB(BLOCKLINK) & RefreshDB(SHARD_STRUCTURE) &
            RefreshDB(STATE_DELTA) & RefreshDB(TEMP_STATE) &
            RefreshDB(DIAGNOSTIC_NODES) & RefreshDB(DIAGNOSTIC_COINBASE) &
-           RefreshDB(STATE_ROOT) &
+           RefreshDB(STATE_ROOT) & RefreshDB(TXN_ADDRESS_INDEX) &
+           RefreshDB(TX_BLOCK_TXNS) & RefreshDB(EVENT_BLOOMS) &
+           RefreshDB(MICROBLOCK_TXNS) &
            Contract::ContractStorage::GetContractStorage().RefreshAll();
   }
 }
\ No newline at end of file
@@ -18,17 +18,26 @@
 #ifndef BLOCKSTORAGE_H
 #define BLOCKSTORAGE_H
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
 #include <list>
+#include <map>
 #include <mutex>
 #include <shared_mutex>
 #include <vector>
 
+#include "BlockArchive.h"
 #include "ContractStorage.h"
+#include "WarmStartSnapshot.h"
 #include "common/Singleton.h"
 #include "depends/libDatabase/LevelDB.h"
 #include "libCrypto/Schnorr.h"
+#include "libData/AccountData/EventBloom.h"
 #include "libData/BlockData/Block.h"
 #include "libData/BlockData/Block/FallbackBlockWShardingStructure.h"
+#include "libData/DataStructures/FlatHashMap.h"
+#include "libUtils/LRUCache.h"
 
 typedef std::tuple<uint32_t, uint64_t, uint64_t, BlockType, BlockHash>
     BlockLink;
@@ -41,6 +50,9 @@ typedef std::shared_ptr<BlockLink> BlockLinkSharedPtr;
 typedef std::shared_ptr<MicroBlock> MicroBlockSharedPtr;
 typedef std::shared_ptr<TransactionWithReceipt> TxBodySharedPtr;
 typedef std::shared_ptr<std::pair<Address, Account>> StateSharedPtr;
+/// Per shard id, the hash of a Tx block's micro block and its txn hashes
+typedef std::map<uint32_t, std::pair<BlockHash, std::vector<TxnHash>>>
+    TxBlockTxns;
 
 struct DiagnosticDataNodes {
   DequeOfShard shards;
@@ -85,6 +97,51 @@ struct DiagnosticDataCoinbase {
   }
 };
 
+/// Writes made while storing a final block, grouped per database so that
+/// BlockStorage::PutEpochWrites applies each group as one batch.
+class EpochWrites {
+  friend class BlockStorage;
+
+  ldb::WriteBatch m_txBlocks;
+  ldb::WriteBatch m_txBodies;
+  ldb::WriteBatch m_microBlocks;
+  ldb::WriteBatch m_stateDeltas;
+  ldb::WriteBatch m_txnAddressIndex;
+  ldb::WriteBatch m_txBlockTxns;
+  ldb::WriteBatch m_eventBlooms;
+  ldb::WriteBatch m_microBlockTxns;
+  /// Merged into the stored block blooms when the writes are put
+  std::map<uint64_t, EventBloom> m_blockEventBlooms;
+  /// Kept for the warm start snapshot, if ENABLE_WARM_START
+  std::vector<std::pair<uint64_t, bytes>> m_txBlockBodies;
+  std::vector<dev::h256> m_txBodyKeys;
+  std::vector<BlockHash> m_microBlockKeys;
+  unsigned int m_txnAddressIndexEntries{0};
+  unsigned int m_txBlockTxnsEntries{0};
+  unsigned int m_eventBloomEntries{0};
+  unsigned int m_microBlockTxnsEntries{0};
+
+ public:
+  void AddTxBlock(const uint64_t& blockNum, const bytes& body);
+  void AddTxBody(const dev::h256& key, const bytes& body);
+  void AddMicroBlock(const BlockHash& blockHash, const bytes& body);
+  void AddStateDelta(const uint64_t& finalBlockNum, const bytes& stateDelta);
+  void AddTxnAddressIndex(const Address& address, const uint64_t& epochNum,
+                          const TxnHash& txnHash);
+  void AddTxBlockTxns(const uint64_t& blockNum, const uint32_t& shardId,
+                      const BlockHash& microBlockHash,
+                      const std::vector<TxnHash>& tranHashes);
+  /// Adds the bloom of the event logs of a micro block, and ORs it into the
+  /// bloom of its Tx block
+  void AddEventBloom(const uint64_t& blockNum, const uint32_t& shardId,
+                     const EventBloom& bloom);
+  /// Adds a micro block and its serialized txn bodies, in its order, as one
+  /// record that GetMicroBlockTxns reads back whole
+  void AddMicroBlockTxns(const uint64_t& blockNum, const uint32_t& shardId,
+                         const bytes& microBlock,
+                         const std::vector<bytes>& txBodies);
+};
+
 /// Manages persistent storage of DS and Tx blocks.
 class BlockStorage : public Singleton<BlockStorage> {
   std::shared_ptr<LevelDB> m_metadataDB;
@@ -106,9 +163,32 @@ class BlockStorage : public Singleton<BlockStorage> {
   std::shared_ptr<LevelDB> m_diagnosticDBNodes;
   std::shared_ptr<LevelDB> m_diagnosticDBCoinbase;
   std::shared_ptr<LevelDB> m_stateRootDB;
+  /// address to txn hash index, kept by lookups if ENABLE_TXN_ADDRESS_INDEX
+  std::shared_ptr<LevelDB> m_txnAddressIndexDB;
+  /// txn hashes of each Tx block by shard, kept by lookups
+  std::shared_ptr<LevelDB> m_txBlockTxnsDB;
+  /// event log blooms of each Tx block and of its micro blocks, kept by
+  /// lookups if ENABLE_EVENT_BLOOM_INDEX
+  std::shared_ptr<LevelDB> m_eventBloomDB;
+  /// each micro block with its txn bodies packed in one record, kept by
+  /// lookups to serve them in one read
+  std::shared_ptr<LevelDB> m_microBlockTxnsDB;
   /// used for historical data
   std::shared_ptr<LevelDB> m_txnHistoricalDB;
   std::shared_ptr<LevelDB> m_MBHistoricalDB;
+  /// sealed segments of old txn bodies and micro blocks, read before the
+  /// historical dbs
+  BlockArchive m_txnArchive;
+  BlockArchive m_MBArchive;
+
+  /// Recently stored or read bodies and micro blocks, already deserialized.
+  /// A null body records a txn hash that was looked up and not found.
+  LRUCache<dev::h256, TxBodySharedPtr> m_txBodyCache;
+  LRUCache<dev::h256, TxBodySharedPtr> m_txnHistoricalCache;
+  LRUCache<BlockHash, MicroBlockSharedPtr> m_microBlockCache;
+
+  /// The newest Tx blocks, saved for warm starts if ENABLE_WARM_START
+  WarmStartSnapshot m_txBlockSnapshot;
 
   BlockStorage(const std::string& path = "", bool diagnostic = false)
       : m_metadataDB(std::make_shared<LevelDB>("metadata")),
@@ -127,11 +207,25 @@ class BlockStorage : public Singleton<BlockStorage> {
         m_diagnosticDBCoinbase(
             std::make_shared<LevelDB>("diagnosticCoinb", path, diagnostic)),
         m_stateRootDB(std::make_shared<LevelDB>("stateRoot")),
+        m_txBodyCache(TXBODY_CACHE_SIZE),
+        m_txnHistoricalCache(TXBODY_CACHE_SIZE),
+        m_microBlockCache(MICROBLOCK_CACHE_SIZE),
+        // Enough blocks for the chain and for recreating the states from
+        // the state deltas
+        m_txBlockSnapshot(
+            "./" + PERSISTENCE_PATH + "/txBlocksSnapshot",
+            std::max(BLOCKCHAIN_SIZE, (INCRDB_DSNUMS_WITH_STATEDELTAS + 1) *
+                                          NUM_FINAL_BLOCK_PER_POW),
+            WARM_START_SNAPSHOT_INTERVAL),
         m_diagnosticDBNodesCounter(0),
         m_diagnosticDBCoinbaseCounter(0) {
     if (LOOKUP_NODE_MODE) {
       m_txBodyDB = std::make_shared<LevelDB>("txBodies");
       m_txBodyTmpDB = std::make_shared<LevelDB>("txBodiesTmp");
+      m_txnAddressIndexDB = std::make_shared<LevelDB>("txnAddressIndex");
+      m_txBlockTxnsDB = std::make_shared<LevelDB>("txBlockTxns");
+      m_eventBloomDB = std::make_shared<LevelDB>("eventBlooms");
+      m_microBlockTxnsDB = std::make_shared<LevelDB>("microBlockTxns");
     }
   };
   ~BlockStorage() = default;
@@ -155,7 +249,11 @@ class BlockStorage : public Singleton<BlockStorage> {
     TEMP_STATE,
     DIAGNOSTIC_NODES,
     DIAGNOSTIC_COINBASE,
-    STATE_ROOT
+    STATE_ROOT,
+    TXN_ADDRESS_INDEX,
+    TX_BLOCK_TXNS,
+    EVENT_BLOOMS,
+    MICROBLOCK_TXNS
   };
 
   /// Returns the singleton BlockStorage instance.
@@ -173,6 +271,14 @@ class BlockStorage : public Singleton<BlockStorage> {
 
   bool InitiateHistoricalDB(const std::string& path);
 
+  /// Opens the sealed archive of txn bodies and micro blocks under path
+  bool OpenHistoricalArchive(const std::string& path);
+
+  /// Seals the micro blocks of DS epochs loDSEpoch to hiDSEpoch, and the txn
+  /// bodies they hold, from the live dbs into new archive segments
+  bool SealHistoricalSegment(const uint64_t& loDSEpoch,
+                             const uint64_t& hiDSEpoch);
+
   /// Adds a Tx block to storage.
   bool PutTxBlock(const uint64_t& blockNum, const bytes& body);
 
@@ -182,6 +288,21 @@ class BlockStorage : public Singleton<BlockStorage> {
   /// Adds a transaction body to storage.
   bool PutTxBody(const dev::h256& key, const bytes& body);
 
+  /// Adds the grouped writes of an epoch to storage, one batch per database.
+  /// The Tx block batch goes last, so a stored Tx block implies its bodies,
+  /// micro blocks and state delta are stored too.
+  bool PutEpochWrites(EpochWrites& writes);
+
+  /// Logs and resets the hit rates of the txn body and micro block caches
+  void LogReadCacheStats();
+
+  /// Deletes the state deltas of final blocks below stateDeltaBelow, and the
+  /// txn bodies of micro blocks below txBodyBelow (0 keeps all), in batches of
+  /// PRUNE_BATCH_SIZE spaced by PRUNE_BATCH_INTERVAL_IN_MS, then compacts what
+  /// was pruned. Returns false without pruning if a pruning is in progress.
+  bool PruneHistory(const uint64_t& stateDeltaBelow,
+                    const uint64_t& txBodyBelow);
+
   /// Retrieves the requested DS block.
   bool GetDSBlock(const uint64_t& blockNum, DSBlockSharedPtr& block);
 
@@ -208,6 +329,37 @@ class BlockStorage : public Singleton<BlockStorage> {
   /// Retrieves the requested transaction body.
   bool GetTxBody(const dev::h256& key, TxBodySharedPtr& body);
 
+  /// Retrieves one page (1-based, newest first) of the txns sent from or to
+  /// address, as epoch number and txn hash pairs. hasMore tells whether
+  /// older txns follow the page.
+  bool GetTxnsForAddress(const Address& address, const unsigned int page,
+                         const unsigned int pageSize,
+                         std::vector<std::pair<uint64_t, TxnHash>>& txns,
+                         bool& hasMore);
+
+  /// Retrieves the txn hashes of the micro blocks of a Tx block stored so
+  /// far, by shard id, with one seek instead of a micro block read per shard
+  bool GetTxBlockTxns(const uint64_t& blockNum, TxBlockTxns& txns);
+
+  /// Retrieves the record of the micro block of a Tx block for a shard, as
+  /// put by EpochWrites::AddMicroBlockTxns
+  bool GetMicroBlockTxns(const uint64_t& blockNum, const uint32_t& shardId,
+                         bytes& record);
+
+  /// Splits a record of GetMicroBlockTxns into the serialized micro block and
+  /// txn bodies
+  static bool UnpackMicroBlockTxns(const bytes& record, bytes& microBlock,
+                                   std::vector<bytes>& txBodies);
+
+  /// Retrieves the block number and shard id of the micro blocks of Tx
+  /// blocks fromBlock to toBlock whose event blooms may hold events of the
+  /// address named eventName, or of any name if it is empty. The micro
+  /// blooms of a block are only read if its block bloom matches.
+  bool GetEventBloomMatches(
+      const uint64_t& fromBlock, const uint64_t& toBlock,
+      const Address& address, const std::string& eventName,
+      std::vector<std::pair<uint64_t, uint32_t>>& matches);
+
   bool GetTxnFromHistoricalDB(const dev::h256& key, TxBodySharedPtr& body);
 
   bool GetHistoricalMicroBlock(const BlockHash& blockhash,
@@ -242,6 +394,20 @@ class BlockStorage : public Singleton<BlockStorage> {
   /// Retrieves all the TxBlocks
   bool GetAllTxBlocks(std::list<TxBlockSharedPtr>& blocks);
 
+  /// Retrieves the lowest and highest TxBlock numbers on disk, reading only
+  /// the keys, so that the blocks can then be read by range
+  bool GetTxBlockNumRange(uint64_t& lowest, uint64_t& highest);
+
+  /// Retrieves the TxBlocks numbered from to to, oldest first
+  bool GetTxBlocks(const uint64_t& from, const uint64_t& to,
+                   std::list<TxBlockSharedPtr>& blocks);
+
+  /// Retrieves the newest TxBlocks, oldest first: enough of them to recreate
+  /// the states and fill the BlockChain cache, older ones being read from
+  /// disk when asked for. With ENABLE_WARM_START, they come from the
+  /// snapshot if it agrees with the database and ends at its newest block.
+  bool GetRecentTxBlocks(std::list<TxBlockSharedPtr>& blocks);
+
   /// Retrieves all the TxBodiesTmp
   bool GetAllTxBodiesTmp(std::list<TxnHash>& txnHashes);
 
@@ -257,6 +423,15 @@ class BlockStorage : public Singleton<BlockStorage> {
   /// Retrieve Last Transactions Trie Root Hash
   bool GetMetadata(MetaType type, bytes& data);
 
+  /// Marks the epoch of the Tx block as committed once every database has
+  /// been made durable, unless DBDurability is ASYNC. The Tx block, its
+  /// state delta and, in a vacuous epoch, the state are stored by then.
+  bool CommitEpoch(const uint64_t& txBlockNum);
+
+  /// Returns the newest Tx block marked by CommitEpoch, false if there is
+  /// none or DBDurability is ASYNC
+  bool GetCommittedEpoch(uint64_t& txBlockNum);
+
   // Retrieve the state root
   bool GetStateRoot(bytes& data);
 
@@ -281,10 +456,10 @@ class BlockStorage : public Singleton<BlockStorage> {
   bool GetStateDelta(const uint64_t& finalBlockNum, bytes& stateDelta);
 
   /// Write state to tempState in batch
-  bool PutTempState(const std::unordered_map<Address, Account>& states);
+  bool PutTempState(const FixedHashMap<Address, Account>& states);
 
   /// Get state from tempState in batch
-  bool GetTempStateInBatch(leveldb::Iterator*& iter,
+  bool GetTempStateInBatch(ldb::Iterator*& iter,
                            std::vector<StateSharedPtr>& states);
 
   /// Save data for diagnostic / monitoring purposes (nodes in network)
@@ -312,6 +487,30 @@ class BlockStorage : public Singleton<BlockStorage> {
   void GetDiagnosticDataCoinbase(
       std::map<uint64_t, DiagnosticDataCoinbase>& diagnosticDataMap);
 
+  /// Retrieve the lowest and highest DS block numbers in the diagnostic data
+  /// db, returns false if empty (nodes in network)
+  bool GetDiagnosticDataNodesRange(uint64_t& first, uint64_t& last);
+
+  /// Retrieve the lowest and highest DS block numbers in the diagnostic data
+  /// db, returns false if empty (coinbase rewards)
+  bool GetDiagnosticDataCoinbaseRange(uint64_t& first, uint64_t& last);
+
+  /// Passes the diagnostic data of DS blocks first to last to visitor in
+  /// order, reading one entry at a time, until visitor returns false (nodes
+  /// in network)
+  void ForEachDiagnosticDataNodes(
+      uint64_t first, uint64_t last,
+      const std::function<bool(uint64_t, const DiagnosticDataNodes&)>&
+          visitor);
+
+  /// Passes the diagnostic data of DS blocks first to last to visitor in
+  /// order, reading one entry at a time, until visitor returns false
+  /// (coinbase rewards)
+  void ForEachDiagnosticDataCoinbase(
+      uint64_t first, uint64_t last,
+      const std::function<bool(uint64_t, const DiagnosticDataCoinbase&)>&
+          visitor);
+
   /// Retrieve the number of entries in the diagnostic data db (nodes in
   /// network)
   unsigned int GetDiagnosticDataNodesCount();
@@ -341,6 +540,18 @@ class BlockStorage : public Singleton<BlockStorage> {
   bool RefreshAll();
 
  private:
+  /// Retrieves the TxBlocks of the warm start snapshot, see GetRecentTxBlocks
+  bool GetSnapshotTxBlocks(std::list<TxBlockSharedPtr>& blocks);
+
+  /// Deletes keys from db in rate-limited batches, returns the number deleted
+  unsigned int DeleteInBatches(const std::shared_ptr<LevelDB>& db,
+                               std::shared_timed_mutex& mutex,
+                               const std::vector<std::string>& keys);
+
+  /// The lowest and highest numeric keys of a diagnostic data db
+  bool GetDiagnosticDataRange(const std::shared_ptr<LevelDB>& db,
+                              uint64_t& first, uint64_t& last);
+
   std::mutex m_mutexDiagnostic;
 
   mutable std::shared_timed_mutex m_mutexMetadata;
@@ -357,11 +568,19 @@ class BlockStorage : public Singleton<BlockStorage> {
   mutable std::shared_timed_mutex m_mutexTxBody;
   mutable std::shared_timed_mutex m_mutexTxBodyTmp;
   mutable std::shared_timed_mutex m_mutexStateRoot;
+  mutable std::shared_timed_mutex m_mutexTxnAddressIndex;
+  mutable std::shared_timed_mutex m_mutexTxBlockTxns;
+  mutable std::shared_timed_mutex m_mutexEventBloom;
+  mutable std::shared_timed_mutex m_mutexMicroBlockTxns;
   mutable std::shared_timed_mutex m_mutexTxnHistorical;
   mutable std::shared_timed_mutex m_mutexMBHistorical;
 
   unsigned int m_diagnosticDBNodesCounter;
   unsigned int m_diagnosticDBCoinbaseCounter;
+
+  std::atomic<bool> m_pruning{false};
+  /// micro blocks below this epoch have had their txn bodies pruned
+  uint64_t m_txBodyPrunedBelow{0};
 };
 
 #endif  // BLOCKSTORAGE_H
@@ -25,34 +25,104 @@
 using namespace std;
 
 namespace Contract {
+
+namespace {
+
+void AddMemoryUsage(const unordered_map<string, bytes>& states,
+                    MemoryStats::Usage& usage) {
+  for (const auto& entry : states) {
+    usage.m_entries++;
+    usage.m_bytes += entry.first.size() + entry.second.size();
+  }
+}
+
+}  // namespace
+
+void ContractStorage::RegisterMemoryStats() {
+  MemoryStats::GetInstance().Register("contractstorage", [this]() {
+    shared_lock<shared_timed_mutex> g(m_stateMainMutex);
+    MemoryStats::Usage usage;
+    AddMemoryUsage(m_stateIndexMap, usage);
+    AddMemoryUsage(m_stateDataMap, usage);
+    return usage;
+  });
+  MemoryStats::GetInstance().Register("contractstorage.temp", [this]() {
+    shared_lock<shared_timed_mutex> g(m_stateMainMutex);
+    MemoryStats::Usage usage;
+    t_stateIndexLayers.AddMemoryUsage(usage);
+    t_stateDataLayers.AddMemoryUsage(usage);
+    return usage;
+  });
+  MemoryStats::GetInstance().Register("contractstorage.revertibles", [this]() {
+    shared_lock<shared_timed_mutex> g(m_stateMainMutex);
+    MemoryStats::Usage usage;
+    AddMemoryUsage(r_stateIndexMap, usage);
+    AddMemoryUsage(r_stateDataMap, usage);
+    return usage;
+  });
+}
 // Code
 // ======================================
 
 bool ContractStorage::PutContractCode(const dev::h160& address,
                                       const bytes& code) {
   unique_lock<shared_timed_mutex> g(m_codeMutex);
+  m_codeCache.Erase(address);
   return m_codeDB.Insert(address.hex(), code) == 0;
 }
 
 bool ContractStorage::PutContractCodeBatch(
     const unordered_map<string, string>& batch) {
   unique_lock<shared_timed_mutex> g(m_codeMutex);
+  // The batch is keyed by hex address, so the cache is dropped as a whole
+  m_codeCache.Clear();
   return m_codeDB.BatchInsert(batch);
 }
 
 const bytes ContractStorage::GetContractCode(const dev::h160& address) {
+  shared_ptr<const bytes> code;
+  if (m_codeCache.Get(address, code)) {
+    return *code;
+  }
+
+  // Cached under the lock, so that a write cannot come between the read and
+  // the cache
   shared_lock<shared_timed_mutex> g(m_codeMutex);
-  return DataConversion::StringToCharArray(m_codeDB.Lookup(address.hex()));
+  code = make_shared<const bytes>(
+      DataConversion::StringToCharArray(m_codeDB.Lookup(address.hex())));
+  if (!code->empty()) {
+    m_codeCache.Put(address, code);
+  }
+  return *code;
 }
 
 bool ContractStorage::DeleteContractCode(const dev::h160& address) {
   unique_lock<shared_timed_mutex> g(m_codeMutex);
+  m_codeCache.Erase(address);
   return m_codeDB.DeleteKey(address.hex()) == 0;
 }
 
+void ContractStorage::LogCodeCacheStats() {
+  LOG_GENERAL(INFO, "Contract code cache hits = "
+                        << m_codeCache.GetHits()
+                        << " misses = " << m_codeCache.GetMisses());
+  m_codeCache.ResetStats();
+}
+
 // State
 // ========================================
 
+// Keeps the value of key in m_map before its first revertible change
+static void RecordRevertible(unordered_map<string, bytes>& r_map,
+                             const unordered_map<string, bytes>& m_map,
+                             const string& key) {
+  if (r_map.find(key) != r_map.end()) {
+    return;
+  }
+  auto found = m_map.find(key);
+  r_map.emplace(key, found != m_map.end() ? found->second : bytes());
+}
+
 Index GetIndex(const dev::h160& address, const string& key,
                unsigned int counter) {
   SHA2<HASH_TYPE::HASH_VARIANT_256> sha2;
@@ -64,12 +134,14 @@ Index GetIndex(const dev::h160& address, const string& key,
   return dev::h256(sha2.Finalize());
 }
 
-bool ContractStorage::CheckIndexExists(const Index& index) {
+bool ContractStorage::CheckIndexExists(const dev::h160& address,
+                                       const Index& index) {
   shared_lock<shared_timed_mutex> g(m_stateIndexMutex);
-  auto t_found = t_stateDataMap.find(index.hex());
-  auto m_found = m_stateDataMap.find(index.hex());
-  return t_found != t_stateDataMap.end() || m_found != m_stateDataMap.end() ||
-         m_stateDataDB.Exists(index.hex());
+  const string key = GetDataKey(address, index);
+  // The last check is for states stored before their keys were prefixed
+  return t_stateDataLayers.Find(key) != nullptr ||
+         m_stateDataMap.find(key) != m_stateDataMap.end() ||
+         m_stateDataDB.Exists(key) || m_stateDataDB.Exists(index.hex());
 }
 
 Index ContractStorage::GetNewIndex(const dev::h160& address, const string& key,
@@ -83,7 +155,7 @@ Index ContractStorage::GetNewIndex(const dev::h160& address, const string& key,
     counter++;
   } while (find(existing_indexes.begin(), existing_indexes.end(), index) ==
                existing_indexes.end() &&
-           CheckIndexExists(index));
+           CheckIndexExists(address, index));
 
   return index;
 }
@@ -96,6 +168,23 @@ bool ContractStorage::PutContractState(const dev::h160& address,
 
   vector<Index> entry_indexes = GetContractStateIndexes(address, true);
 
+  // Only the states whose value changed are written
+  const vector<bytes> currentStates = GetContractStatesData(address, true);
+  unordered_map<Index, const bytes*> currentByIndex;
+  for (unsigned int i = 0;
+       i < entry_indexes.size() && i < currentStates.size(); i++) {
+    currentByIndex.emplace(entry_indexes[i], &currentStates[i]);
+  }
+
+  // The temp states hash in index order, with new indexes appended, so the
+  // new hash follows from the states already read and the changed ones
+  const bool hashInPlace = temp && currentStates.size() == entry_indexes.size();
+  vector<bytes> newStates;
+  unordered_map<Index, unsigned int> newPosByIndex;
+  if (hashInPlace) {
+    newStates = currentStates;
+  }
+
   for (const auto& state : states) {
     Index index = GetNewIndex(address, std::get<VNAME>(state), entry_indexes);
 
@@ -105,17 +194,51 @@ bool ContractStorage::PutContractState(const dev::h160& address,
       return false;
     }
 
+    auto current = currentByIndex.find(index);
+    if (current != currentByIndex.end() && *current->second == rawBytes) {
+      continue;
+    }
+
+    if (hashInPlace) {
+      auto pos = find(entry_indexes.begin(), entry_indexes.end(), index);
+      if (pos != entry_indexes.end()) {
+        newStates[pos - entry_indexes.begin()] = rawBytes;
+      } else if (newPosByIndex.find(index) != newPosByIndex.end()) {
+        newStates[newPosByIndex[index]] = rawBytes;
+      } else {
+        newPosByIndex.emplace(index, newStates.size());
+        newStates.emplace_back(rawBytes);
+      }
+    }
+
     entries.emplace_back(index, rawBytes);
   }
 
-  return PutContractState(address, entries, stateHash, temp, false,
-                          entry_indexes, true);
+  if (!hashInPlace) {
+    return PutContractState(address, entries, stateHash, temp, false,
+                            entry_indexes, true);
+  }
+
+  // Nothing changed, so neither the states nor their hash do
+  if (entries.empty()) {
+    stateHash = HashStates(newStates);
+    return true;
+  }
+
+  if (!PutContractState(address, entries, stateHash, temp, false,
+                        entry_indexes, true, false)) {
+    return false;
+  }
+  stateHash = HashStates(newStates);
+
+  return true;
 }
 
 bool ContractStorage::PutContractState(
     const dev::h160& address, const vector<pair<Index, bytes>>& entries,
     dev::h256& stateHash, bool temp, bool revertible,
-    const vector<Index>& existing_indexes, bool provideExisting) {
+    const vector<Index>& existing_indexes, bool provideExisting,
+    bool updateHash) {
   // LOG_MARKER();
   {
     unique_lock<shared_timed_mutex> g(m_stateMainMutex);
@@ -142,13 +265,14 @@ bool ContractStorage::PutContractState(
         entry_indexes.emplace_back(entry.first);
       }
 
+      const string key = GetDataKey(address, entry.first);
       if (temp) {
-        t_stateDataMap[entry.first.hex()] = entry.second;
+        t_stateDataLayers.Set(key, entry.second);
       } else {
         if (revertible) {
-          r_stateDataMap[entry.first.hex()] = m_stateDataMap[entry.first.hex()];
+          RecordRevertible(r_stateDataMap, m_stateDataMap, key);
         }
-        m_stateDataMap[entry.first.hex()] = entry.second;
+        m_stateDataMap[key] = entry.second;
       }
     }
 
@@ -159,23 +283,28 @@ bool ContractStorage::PutContractState(
     }
   }
 
-  stateHash = GetContractStateHash(address, temp);
+  if (updateHash) {
+    stateHash = GetContractStateHash(address, temp);
+  }
 
   return true;
 }
 
 void ContractStorage::BufferCurrentState() {
   LOG_MARKER();
-  shared_lock<shared_timed_mutex> g(m_stateMainMutex);
-  p_stateIndexMap = t_stateIndexMap;
-  p_stateDataMap = t_stateDataMap;
+  unique_lock<shared_timed_mutex> g(m_stateMainMutex);
+  // The chain call buffered before has succeeded, keep its changes
+  t_stateIndexLayers.Merge();
+  t_stateDataLayers.Merge();
+  t_stateIndexLayers.Push();
+  t_stateDataLayers.Push();
 }
 
 void ContractStorage::RevertPrevState() {
   LOG_MARKER();
   unique_lock<shared_timed_mutex> g(m_stateMainMutex);
-  t_stateIndexMap = std::move(p_stateIndexMap);
-  t_stateDataMap = std::move(p_stateDataMap);
+  t_stateIndexLayers.Pop();
+  t_stateDataLayers.Pop();
 }
 
 bool ContractStorage::SetContractStateIndexes(const dev::h160& address,
@@ -191,10 +320,10 @@ bool ContractStorage::SetContractStateIndexes(const dev::h160& address,
   }
 
   if (temp) {
-    t_stateIndexMap[address.hex()] = rawBytes;
+    t_stateIndexLayers.Set(address.hex(), rawBytes);
   } else {
     if (revertible) {
-      r_stateIndexMap[address.hex()] = m_stateIndexMap[address.hex()];
+      RecordRevertible(r_stateIndexMap, m_stateIndexMap, address.hex());
     }
     m_stateIndexMap[address.hex()] = rawBytes;
   }
@@ -240,10 +369,11 @@ vector<Index> ContractStorage::GetContractStateIndexes(const dev::h160& address,
 
   bytes rawBytes;
 
-  auto t_found = t_stateIndexMap.find(address.hex());
+  const bytes* t_found =
+      temp ? t_stateIndexLayers.Find(address.hex()) : nullptr;
   auto m_found = m_stateIndexMap.find(address.hex());
-  if (temp && t_found != t_stateIndexMap.end()) {
-    rawBytes = t_found->second;
+  if (t_found != nullptr) {
+    rawBytes = *t_found;
   } else if (m_found != m_stateIndexMap.end()) {
     rawBytes = m_found->second;
   } else if (m_stateIndexDB.Exists(address.hex())) {
@@ -274,38 +404,82 @@ vector<bytes> ContractStorage::GetContractStatesData(const dev::h160& address,
   vector<Index> indexes = GetContractStateIndexes(address, temp);
 
   vector<bytes> rawStates;
+  unordered_map<string, bytes> dbStates;
+  bool dbRead = false;
 
   // return vector of raw protobuf string
   for (const auto& index : indexes) {
-    auto t_found = t_stateDataMap.find(index.hex());
-    auto m_found = m_stateDataMap.find(index.hex());
-    if (temp && t_found != t_stateDataMap.end()) {
-      rawStates.push_back(t_found->second);
-    } else if (m_found != m_stateDataMap.end()) {
+    const string key = GetDataKey(address, index);
+    const bytes* t_found = temp ? t_stateDataLayers.Find(key) : nullptr;
+    auto m_found = m_stateDataMap.find(key);
+    if (t_found != nullptr) {
+      rawStates.push_back(*t_found);
+      continue;
+    }
+    if (m_found != m_stateDataMap.end()) {
       rawStates.push_back(m_found->second);
-    } else if (m_stateDataDB.Exists(index.hex())) {
+      continue;
+    }
+
+    // Read all the stored states of the account at the first one needed
+    if (!dbRead) {
+      dbStates = GetContractStatesDataFromDB(address);
+      dbRead = true;
+    }
+    auto db_found = dbStates.find(index.hex());
+    if (db_found != dbStates.end()) {
+      rawStates.push_back(std::move(db_found->second));
+    } else {
+      // Stored before the keys were prefixed, if at all
       std::string rawString = m_stateDataDB.Lookup(index.hex());
       rawStates.push_back(bytes(rawString.begin(), rawString.end()));
-    } else {
-      rawStates.push_back({});
     }
   }
 
   return rawStates;
 }
 
-string ContractStorage::GetContractStateData(const Index& index, bool temp) {
+unordered_map<string, bytes> ContractStorage::GetContractStatesDataFromDB(
+    const dev::h160& address) {
+  unordered_map<string, bytes> states;
+
+  const string prefix = address.hex();
+  const size_t keyLength = GetDataKey(address, Index()).size();
+
+  unique_ptr<ldb::Iterator> it(
+      m_stateDataDB.GetDB()->NewIterator(ldb::ReadOptions()));
+  for (it->Seek(prefix); it->Valid() && it->key().starts_with(prefix);
+       it->Next()) {
+    if (it->key().size() != keyLength) {
+      continue;
+    }
+    const ldb::Slice value = it->value();
+    states.emplace(it->key().ToString().substr(prefix.size()),
+                   bytes(value.data(), value.data() + value.size()));
+  }
+
+  return states;
+}
+
+string ContractStorage::GetContractStateData(const dev::h160& address,
+                                             const Index& index, bool temp) {
   // LOG_MARKER();
   shared_lock<shared_timed_mutex> g(m_stateDataMutex);
-  auto t_found = t_stateDataMap.find(index.hex());
-  auto m_found = m_stateDataMap.find(index.hex());
-  if (temp && t_found != t_stateDataMap.end()) {
-    return DataConversion::CharArrayToString(t_found->second);
+  const string key = GetDataKey(address, index);
+  const bytes* t_found = temp ? t_stateDataLayers.Find(key) : nullptr;
+  auto m_found = m_stateDataMap.find(key);
+  if (t_found != nullptr) {
+    return DataConversion::CharArrayToString(*t_found);
   }
   if (m_found != m_stateDataMap.end()) {
     return DataConversion::CharArrayToString(m_found->second);
   }
-  return m_stateDataDB.Lookup(index.hex());
+  string rawString = m_stateDataDB.Lookup(key);
+  if (rawString.empty()) {
+    // Stored before the keys were prefixed
+    rawString = m_stateDataDB.Lookup(index.hex());
+  }
+  return rawString;
 }
 
 bool ContractStorage::CommitStateDB() {
@@ -363,8 +537,8 @@ bool ContractStorage::CommitStateDB() {
 void ContractStorage::InitTempState() {
   LOG_MARKER();
 
-  t_stateIndexMap.clear();
-  t_stateDataMap.clear();
+  t_stateIndexLayers.Clear();
+  t_stateDataLayers.Clear();
 }
 
 bool ContractStorage::GetContractStateJson(
@@ -448,6 +622,73 @@ bool ContractStorage::GetContractStateJson(
   return true;
 }
 
+bool ContractStorage::GetContractSubStateJson(
+    const dev::h160& address, const string& vname,
+    const vector<string>& indices, Json::Value& value, bool temp) {
+  if (address == Address()) {
+    LOG_GENERAL(WARNING, "Null address rejected");
+    return false;
+  }
+
+  vector<bytes> rawStates = GetContractStatesData(address, temp);
+
+  for (const auto& rawState : rawStates) {
+    StateEntry entry;
+    uint32_t version;
+    if (!Messenger::GetStateData(rawState, 0, entry, version)) {
+      LOG_GENERAL(WARNING, "Messenger::GetStateData failed.");
+      return false;
+    }
+
+    if (std::get<VNAME>(entry) != vname) {
+      continue;
+    }
+
+    const string& tValue = std::get<VALUE>(entry);
+    Json::Value current;
+    if (!tValue.empty() && (tValue[0] == '[' || tValue[0] == '{')) {
+      if (!JSONUtils::GetInstance().convertStrtoJson(tValue, current)) {
+        LOG_GENERAL(WARNING, "Value of " << vname << " is not valid json");
+        return false;
+      }
+    } else {
+      current = tValue;
+    }
+
+    // Maps are either objects keyed by the map keys, or arrays of
+    // {"key":..., "val":...} entries
+    for (const auto& index : indices) {
+      Json::Value next;
+      bool found = false;
+      if (current.isObject() && current.isMember(index)) {
+        next = current[index];
+        found = true;
+      } else if (current.isArray()) {
+        for (const auto& item : current) {
+          if (item.isObject() && item.isMember("key") &&
+              item.isMember("val") && item["key"].isString() &&
+              item["key"].asString() == index) {
+            next = item["val"];
+            found = true;
+            break;
+          }
+        }
+      }
+      if (!found) {
+        LOG_GENERAL(INFO, "Key " << index << " not found in " << vname);
+        return false;
+      }
+      current = std::move(next);
+    }
+
+    value = std::move(current);
+    return true;
+  }
+
+  LOG_GENERAL(INFO, "State " << vname << " not found");
+  return false;
+}
+
 dev::h256 ContractStorage::GetContractStateHash(const dev::h160& address,
                                                 bool temp) {
   // LOG_MARKER();
@@ -457,7 +698,10 @@ dev::h256 ContractStorage::GetContractStateHash(const dev::h160& address,
   }
 
   // iterate the raw protobuf string and hash
-  vector<bytes> rawStates = GetContractStatesData(address, temp);
+  return HashStates(GetContractStatesData(address, temp));
+}
+
+dev::h256 ContractStorage::HashStates(const vector<bytes>& rawStates) {
   SHA2<HASH_TYPE::HASH_VARIANT_256> sha2;
   for (const auto& rawState : rawStates) {
     sha2.Update(rawState);
@@ -468,6 +712,7 @@ dev::h256 ContractStorage::GetContractStateHash(const dev::h160& address,
 void ContractStorage::Reset() {
   {
     unique_lock<shared_timed_mutex> g(m_codeMutex);
+    m_codeCache.Clear();
     m_codeDB.ResetDB();
   }
   {
@@ -487,6 +732,7 @@ bool ContractStorage::RefreshAll() {
   bool ret;
   {
     unique_lock<shared_timed_mutex> g(m_codeMutex);
+    m_codeCache.Clear();
     ret = m_codeDB.RefreshDB();
   }
   if (ret) {
@@ -19,12 +19,18 @@
 #define CONTRACTSTORAGE_H
 
 #include <json/json.h>
-#include <leveldb/db.h>
+#include <memory>
 #include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 #include "common/Constants.h"
 #include "common/Singleton.h"
+#include "depends/libDatabase/KVBackend.h"
 #include "depends/libDatabase/LevelDB.h"
+#include "libUtils/LRUCache.h"
+#include "libUtils/MemoryStats.h"
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
@@ -37,8 +43,78 @@ namespace Contract {
 
 Index GetIndex(const dev::h160& address, const std::string& key);
 
+/// Stack of copy-on-write layers of raw states. Writes go to the top layer
+/// and reads look from the top layer down, so a layer only holds the states
+/// changed while it was on top. Pushing or dropping a layer costs no copy;
+/// merging one into the layer below costs its number of changes.
+class StateLayers {
+  std::vector<std::unordered_map<std::string, bytes>> m_layers;
+
+ public:
+  StateLayers() : m_layers(1) {}
+
+  /// Returns the newest value of key, or nullptr if no layer has it
+  const bytes* Find(const std::string& key) const {
+    for (auto it = m_layers.rbegin(); it != m_layers.rend(); ++it) {
+      auto found = it->find(key);
+      if (found != it->end()) {
+        return &found->second;
+      }
+    }
+    return nullptr;
+  }
+
+  void Set(const std::string& key, const bytes& value) {
+    m_layers.back()[key] = value;
+  }
+
+  /// Starts a new empty layer on top
+  void Push() { m_layers.emplace_back(); }
+
+  /// Drops the top layer and its changes, keeping the bottom one
+  void Pop() {
+    if (m_layers.size() > 1) {
+      m_layers.pop_back();
+    }
+  }
+
+  /// Folds the top layer into the one below
+  void Merge() {
+    if (m_layers.size() < 2) {
+      return;
+    }
+    auto& below = m_layers[m_layers.size() - 2];
+    for (auto& entry : m_layers.back()) {
+      below[entry.first] = std::move(entry.second);
+    }
+    m_layers.pop_back();
+  }
+
+  /// Drops all the layers, leaving one empty
+  void Clear() {
+    m_layers.clear();
+    m_layers.emplace_back();
+  }
+
+  std::size_t Depth() const { return m_layers.size(); }
+
+  /// Adds the entries of all the layers and the bytes of their keys and
+  /// values to usage
+  void AddMemoryUsage(MemoryStats::Usage& usage) const {
+    for (const auto& layer : m_layers) {
+      for (const auto& entry : layer) {
+        usage.m_entries++;
+        usage.m_bytes += entry.first.size() + entry.second.size();
+      }
+    }
+  }
+};
+
 class ContractStorage : public Singleton<ContractStorage> {
   LevelDB m_codeDB;
+  /// The code of the contracts called most recently, as a few contracts take
+  /// most of the calls. Cleared of an address whenever its code is written.
+  LRUCache<dev::h160, std::shared_ptr<const bytes>> m_codeCache;
 
   LevelDB m_stateIndexDB;
   LevelDB m_stateDataDB;
@@ -47,18 +123,17 @@ class ContractStorage : public Singleton<ContractStorage> {
   std::unordered_map<std::string, bytes> m_stateIndexMap;
   std::unordered_map<std::string, bytes> m_stateDataMap;
 
-  // Used by AccountStoreTemp for StateDelta
-  std::unordered_map<std::string, bytes> t_stateIndexMap;
-  std::unordered_map<std::string, bytes> t_stateDataMap;
+  // Used by AccountStoreTemp for StateDelta. The bottom layer holds the temp
+  // states, and BufferCurrentState pushes a layer on top for a chain call, so
+  // that a failure in the chain call drops only what the chain call changed.
+  StateLayers t_stateIndexLayers;
+  StateLayers t_stateDataLayers;
 
-  // Used for RevertCommitTemp
+  // Used for RevertCommitTemp, the values in the m_maps before their first
+  // revertible change, empty for the ones that did not exist
   std::unordered_map<std::string, bytes> r_stateIndexMap;
   std::unordered_map<std::string, bytes> r_stateDataMap;
 
-  // Used for revert state due to failure in chain call
-  std::unordered_map<std::string, bytes> p_stateIndexMap;
-  std::unordered_map<std::string, bytes> p_stateDataMap;
-
   mutable std::shared_timed_mutex m_codeMutex;
   mutable std::shared_timed_mutex m_stateMainMutex;
   mutable std::shared_timed_mutex m_stateIndexMutex;
@@ -72,17 +147,38 @@ class ContractStorage : public Singleton<ContractStorage> {
   /// Get the raw rlp string of the states of an account
   std::vector<bytes> GetContractStatesData(const dev::h160& address, bool temp);
 
+  /// Get the states of an account in m_stateDataDB, by index, with a single
+  /// iteration over the keys prefixed by its address
+  std::unordered_map<std::string, bytes> GetContractStatesDataFromDB(
+      const dev::h160& address);
+
+  /// Keys of the states in m_stateDataDB, the m_map and the t_map, so that
+  /// the states of a contract sit next to each other in m_stateDataDB
+  static std::string GetDataKey(const dev::h160& address, const Index& index) {
+    return address.hex() + index.hex();
+  }
+
   ContractStorage()
       : m_codeDB("contractCode"),
+        m_codeCache(CONTRACT_CODE_CACHE_SIZE),
         m_stateIndexDB("contractStateIndex"),
-        m_stateDataDB("contractStateData"){};
+        m_stateDataDB("contractStateData") {
+    RegisterMemoryStats();
+  };
+
+  /// Reports the states held in memory by the m_maps, the t_layers and the
+  /// r_maps
+  void RegisterMemoryStats();
 
   ~ContractStorage() = default;
 
   Index GetNewIndex(const dev::h160& address, const std::string& key,
                     const std::vector<Index>& existing_indexes);
 
-  bool CheckIndexExists(const Index& index);
+  bool CheckIndexExists(const dev::h160& address, const Index& index);
+
+  /// Hash of the raw states of a contract, in index order
+  static dev::h256 HashStates(const std::vector<bytes>& rawStates);
 
  public:
   /// Returns the singleton ContractStorage instance.
@@ -104,12 +200,16 @@ class ContractStorage : public Singleton<ContractStorage> {
   /// Delete the contract code in persistence
   bool DeleteContractCode(const dev::h160& address);
 
+  /// Logs and resets the hit and miss counts of the code cache
+  void LogCodeCacheStats();
+
   /// Get the indexes of all the states of an contract account
   std::vector<Index> GetContractStateIndexes(const dev::h160& address,
                                              bool temp);
 
   /// Get the raw protobuf string of the state by a index
-  std::string GetContractStateData(const Index& index, bool temp);
+  std::string GetContractStateData(const dev::h160& address,
+                                   const Index& index, bool temp);
 
   /// Put one's contract states in database
   bool PutContractState(const dev::h160& address,
@@ -120,12 +220,13 @@ class ContractStorage : public Singleton<ContractStorage> {
                         const std::vector<std::pair<Index, bytes>>& entries,
                         dev::h256& stateHash, bool temp, bool revertible,
                         const std::vector<Index>& existing_indexes = {},
-                        bool provideExisting = false);
+                        bool provideExisting = false, bool updateHash = true);
 
-  /// Buffer the current t_map into p_map
+  /// Start buffering the changes to the temp states in a new layer, merging
+  /// the one buffered before into the temp states
   void BufferCurrentState();
 
-  /// Revert the t_map from the p_map just buffered
+  /// Drop the changes to the temp states buffered since BufferCurrentState
   void RevertPrevState();
 
   /// Put the in-memory m_map into database
@@ -139,6 +240,14 @@ class ContractStorage : public Singleton<ContractStorage> {
                             std::pair<Json::Value, Json::Value>& roots,
                             uint32_t& scilla_version, bool temp);
 
+  /// Get the json formatted value of the state vname of a contract account,
+  /// descended into by the map keys in indices, without converting the other
+  /// states to json
+  bool GetContractSubStateJson(const dev::h160& address,
+                               const std::string& vname,
+                               const std::vector<std::string>& indices,
+                               Json::Value& value, bool temp);
+
   /// Get the state hash of a contract account
   dev::h256 GetContractStateHash(const dev::h160& address, bool temp);
 
@@ -22,10 +22,9 @@ using namespace std;
 
 DB::DB(const string& name) {
   this->m_db_name = name;
-  leveldb::Options options;
+  ldb::Options options;
   options.create_if_missing = true;
-  leveldb::Status status =
-      leveldb::DB::Open(options, this->m_db_name, &this->m_db);
+  ldb::Status status = ldb::DB::Open(options, this->m_db_name, &this->m_db);
   if (!status.ok()) {
     LOG_GENERAL(WARNING, "Cannot init DB.");
     // throw exception();
@@ -36,7 +35,7 @@ DB::~DB() { delete m_db; }
 
 string DB::ReadFromDB(const string& key) {
   string value;
-  leveldb::Status s = m_db->Get(leveldb::ReadOptions(), key, &value);
+  ldb::Status s = m_db->Get(ldb::ReadOptions(), key, &value);
   if (!s.ok()) {
     return "DB_ERROR";
   } else {
@@ -44,10 +43,10 @@ string DB::ReadFromDB(const string& key) {
   }
 }
 
-leveldb::DB* DB::GetDB() { return this->m_db; }
+ldb::DB* DB::GetDB() { return this->m_db; }
 
 int DB::WriteToDB(const string& key, const string& value) {
-  leveldb::Status s = m_db->Put(leveldb::WriteOptions(), key, value);
+  ldb::Status s = m_db->Put(ldb::WriteOptions(), key, value);
   if (!s.ok()) {
     return -1;
   } else {
@@ -56,7 +55,7 @@ int DB::WriteToDB(const string& key, const string& value) {
 }
 
 int DB::DeleteFromDB(const string& key) {
-  leveldb::Status s = m_db->Delete(leveldb::WriteOptions(), key);
+  ldb::Status s = m_db->Delete(ldb::WriteOptions(), key);
   if (!s.ok()) {
     return -1;
   } else {
@@ -66,7 +65,7 @@ int DB::DeleteFromDB(const string& key) {
 
 int DB::DeleteDB() {
   delete m_db;
-  leveldb::Status s = leveldb::DestroyDB(this->m_db_name, leveldb::Options());
+  ldb::Status s = ldb::DestroyDB(this->m_db_name, ldb::Options());
   if (!s.ok()) {
     LOG_GENERAL(INFO, "Status: " << s.ToString());
     return -1;
@@ -18,14 +18,15 @@
 #ifndef DB_H
 #define DB_H
 
-#include <leveldb/db.h>
 #include <libUtils/Logger.h>
 #include <string>
 
+#include "depends/libDatabase/KVBackend.h"
+
 /// Utility class for providing database-type storage.
 class DB {
   std::string m_db_name;
-  leveldb::DB* m_db;
+  ldb::DB* m_db;
 
  public:
   /// Constructor.
@@ -35,7 +36,7 @@ class DB {
   ~DB();
 
   /// Returns the reference to the leveldb database instance.
-  leveldb::DB* GetDB();
+  ldb::DB* GetDB();
 
   /// Returns the value at the specified key.
   std::string ReadFromDB(const std::string& key);
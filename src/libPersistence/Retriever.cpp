@@ -34,7 +34,9 @@ bool Retriever::RetrieveTxBlocks(bool trimIncompletedBlocks) {
   LOG_MARKER();
   std::list<TxBlockSharedPtr> blocks;
   std::vector<bytes> extraStateDeltas;
-  if (!BlockStorage::GetBlockStorage().GetAllTxBlocks(blocks)) {
+  // Only the newest blocks, the older ones are read from the db when asked
+  // for
+  if (!BlockStorage::GetBlockStorage().GetRecentTxBlocks(blocks)) {
     LOG_GENERAL(WARNING, "RetrieveTxBlocks skipped or incompleted");
     return false;
   }
@@ -43,6 +45,27 @@ bool Retriever::RetrieveTxBlocks(bool trimIncompletedBlocks) {
     return a->GetHeader().GetBlockNum() < b->GetHeader().GetBlockNum();
   });
 
+  // Blocks past the last committed epoch may have been stored without the
+  // rest of their epoch, so only the committed ones are trusted
+  uint64_t committedBlockNum = 0;
+  if (BlockStorage::GetBlockStorage().GetCommittedEpoch(committedBlockNum)) {
+    while (!blocks.empty() &&
+           blocks.back()->GetHeader().GetBlockNum() > committedBlockNum) {
+      LOG_GENERAL(INFO, "Trim TxBlock "
+                            << blocks.back()->GetHeader().GetBlockNum()
+                            << " past the committed " << committedBlockNum);
+      BlockStorage::GetBlockStorage().DeleteTxBlock(
+          blocks.back()->GetHeader().GetBlockNum());
+      blocks.pop_back();
+    }
+    if (blocks.empty()) {
+      LOG_GENERAL(WARNING, "No TxBlock up to the committed "
+                               << committedBlockNum);
+      return false;
+    }
+  }
+
+  const uint64_t firstBlockNum = blocks.front()->GetHeader().GetBlockNum();
   unsigned int lastBlockNum = blocks.back()->GetHeader().GetBlockNum();
 
   unsigned int extra_txblocks = (lastBlockNum + 1) % NUM_FINAL_BLOCK_PER_POW;
@@ -130,7 +153,7 @@ bool Retriever::RetrieveTxBlocks(bool trimIncompletedBlocks) {
                 return false;
               }
               if (AccountStore::GetInstance().GetStateRootHash() !=
-                  (*std::next(blocks.begin(), j))
+                  (*std::next(blocks.begin(), j - firstBlockNum))
                       ->GetHeader()
                       .GetStateRootHash()) {
                 LOG_GENERAL(
@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <fstream>
+#include <iterator>
+
+#include <boost/filesystem.hpp>
+
+#include "WarmStartSnapshot.h"
+#include "common/Serializable.h"
+#include "libUtils/AsyncFileWriter.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+namespace bfs = boost::filesystem;
+
+namespace {
+const uint32_t SNAPSHOT_MAGIC = 0x5a575353;  // "ZWSS"
+const unsigned int BLOCKNUM_LEN = sizeof(uint64_t);
+const unsigned int LENGTH_LEN = sizeof(uint32_t);
+const unsigned int FOOTER_LEN = LENGTH_LEN + sizeof(uint32_t);
+const string TMP_SUFFIX = ".tmp";
+}  // namespace
+
+WarmStartSnapshot::WarmStartSnapshot(const string& filename,
+                                     unsigned int capacity,
+                                     unsigned int interval)
+    : m_filename(filename),
+      m_capacity(max(capacity, 1u)),
+      m_interval(max(interval, 1u)) {}
+
+WarmStartSnapshot::~WarmStartSnapshot() { WaitForWrites(); }
+
+void WarmStartSnapshot::Add(const uint64_t& blockNum, const bytes& body) {
+  bool isNewest = false;
+  {
+    lock_guard<mutex> g(m_mutexBlocks);
+    isNewest = m_blocks.empty() || blockNum > m_blocks.rbegin()->first;
+    m_blocks[blockNum] = body;
+    Trim();
+  }
+
+  if (isNewest && (blockNum + 1) % m_interval == 0) {
+    WriteInBackground();
+  }
+}
+
+void WarmStartSnapshot::Remove(const uint64_t& blockNum) {
+  lock_guard<mutex> g(m_mutexBlocks);
+  m_blocks.erase(blockNum);
+}
+
+void WarmStartSnapshot::Reset(map<uint64_t, bytes>&& blocks) {
+  lock_guard<mutex> g(m_mutexBlocks);
+  m_blocks = move(blocks);
+  Trim();
+}
+
+void WarmStartSnapshot::Clear() {
+  {
+    lock_guard<mutex> g(m_mutexBlocks);
+    m_blocks.clear();
+  }
+
+  lock_guard<mutex> g(m_mutexFile);
+  // A write in flight is then dropped rather than bringing the file back
+  ++m_generation;
+  m_queued = Contents();
+  m_hasQueued = false;
+  boost::system::error_code ec;
+  bfs::remove(m_filename, ec);
+}
+
+void WarmStartSnapshot::Trim() {
+  while (m_blocks.size() > m_capacity) {
+    m_blocks.erase(m_blocks.begin());
+  }
+}
+
+bool WarmStartSnapshot::Serialize(Contents& contents) {
+  map<uint64_t, bytes> blocks;
+  {
+    lock_guard<mutex> g(m_mutexBlocks);
+    // Only a consecutive run of blocks is of use on restart
+    auto first = m_blocks.end();
+    for (auto it = m_blocks.begin(); it != m_blocks.end(); ++it) {
+      if (it == m_blocks.begin() || it->first != prev(it)->first + 1) {
+        first = it;
+      }
+    }
+    blocks.insert(first, m_blocks.end());
+  }
+
+  if (blocks.empty()) {
+    return false;
+  }
+
+  size_t size = FOOTER_LEN;
+  for (const auto& block : blocks) {
+    size += BLOCKNUM_LEN + LENGTH_LEN + block.second.size();
+  }
+  contents.m_data.clear();
+  contents.m_data.reserve(size);
+
+  bytes prefix(BLOCKNUM_LEN + LENGTH_LEN);
+  for (const auto& block : blocks) {
+    Serializable::SetNumber<uint64_t>(prefix, 0, block.first, BLOCKNUM_LEN);
+    Serializable::SetNumber<uint32_t>(prefix, BLOCKNUM_LEN, block.second.size(),
+                                      LENGTH_LEN);
+    contents.m_data.insert(contents.m_data.end(), prefix.begin(),
+                           prefix.end());
+    contents.m_data.insert(contents.m_data.end(), block.second.begin(),
+                           block.second.end());
+  }
+
+  bytes footer(FOOTER_LEN);
+  Serializable::SetNumber<uint32_t>(footer, 0, blocks.size(), LENGTH_LEN);
+  Serializable::SetNumber<uint32_t>(footer, LENGTH_LEN, SNAPSHOT_MAGIC,
+                                    sizeof(uint32_t));
+  contents.m_data.insert(contents.m_data.end(), footer.begin(), footer.end());
+
+  contents.m_first = blocks.begin()->first;
+  contents.m_last = blocks.rbegin()->first;
+  return true;
+}
+
+bool WarmStartSnapshot::Replace(const uint64_t& first, const uint64_t& last) {
+  boost::system::error_code ec;
+  bfs::rename(m_filename + TMP_SUFFIX, m_filename, ec);
+  if (ec) {
+    LOG_GENERAL(WARNING, "Cannot replace snapshot " << m_filename << ": "
+                                                     << ec.message());
+    return false;
+  }
+
+  LOG_GENERAL(INFO, "Wrote snapshot of Tx blocks " << first << " to " << last);
+  return true;
+}
+
+bool WarmStartSnapshot::Write() {
+  Contents contents;
+  if (!Serialize(contents)) {
+    return false;
+  }
+
+  unique_lock<mutex> lock(m_mutexFile);
+  m_cvWrite.wait(lock, [this]() { return !m_writing && !m_hasQueued; });
+
+  const string tmpFilename = m_filename + TMP_SUFFIX;
+  {
+    ofstream file(tmpFilename, ios::binary | ios::trunc);
+    if (!file) {
+      LOG_GENERAL(WARNING, "Cannot create snapshot " << tmpFilename);
+      return false;
+    }
+
+    file.write(reinterpret_cast<const char*>(contents.m_data.data()),
+               contents.m_data.size());
+
+    file.close();
+    if (!file) {
+      LOG_GENERAL(WARNING, "Failed to write snapshot " << tmpFilename);
+      boost::system::error_code ec;
+      bfs::remove(tmpFilename, ec);
+      return false;
+    }
+  }
+
+  return Replace(contents.m_first, contents.m_last);
+}
+
+void WarmStartSnapshot::WriteInBackground() {
+  Contents contents;
+  if (!Serialize(contents)) {
+    return;
+  }
+
+  lock_guard<mutex> g(m_mutexFile);
+  if (m_writing) {
+    // Only the newest of the snapshots waiting to be written is of use
+    m_queued = move(contents);
+    m_hasQueued = true;
+    return;
+  }
+  StartWrite(move(contents));
+}
+
+void WarmStartSnapshot::StartWrite(Contents&& contents) {
+  m_writing = true;
+
+  const uint64_t generation = m_generation;
+  const uint64_t first = contents.m_first;
+  const uint64_t last = contents.m_last;
+  AsyncFileWriter::GetInstance().Write(
+      m_filename + TMP_SUFFIX, move(contents.m_data),
+      [this, generation, first, last](bool ok) {
+        lock_guard<mutex> g(m_mutexFile);
+        if (ok && generation == m_generation) {
+          Replace(first, last);
+        } else {
+          boost::system::error_code ec;
+          bfs::remove(m_filename + TMP_SUFFIX, ec);
+        }
+
+        m_writing = false;
+        if (m_hasQueued) {
+          m_hasQueued = false;
+          StartWrite(move(m_queued));
+        }
+        m_cvWrite.notify_all();
+      });
+}
+
+void WarmStartSnapshot::WaitForWrites() {
+  unique_lock<mutex> lock(m_mutexFile);
+  m_cvWrite.wait(lock, [this]() { return !m_writing && !m_hasQueued; });
+}
+
+bool WarmStartSnapshot::Read(map<uint64_t, bytes>& blocks) const {
+  bytes data;
+  {
+    ifstream file(m_filename, ios::binary);
+    if (!file) {
+      LOG_GENERAL(INFO, "No snapshot " << m_filename);
+      return false;
+    }
+    data.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+  }
+
+  if (data.size() < FOOTER_LEN ||
+      Serializable::GetNumber<uint32_t>(data, data.size() - sizeof(uint32_t),
+                                        sizeof(uint32_t)) != SNAPSHOT_MAGIC) {
+    LOG_GENERAL(WARNING, "Snapshot " << m_filename << " is truncated");
+    return false;
+  }
+
+  const size_t end = data.size() - FOOTER_LEN;
+  const uint32_t count =
+      Serializable::GetNumber<uint32_t>(data, end, LENGTH_LEN);
+
+  map<uint64_t, bytes> result;
+  size_t offset = 0;
+  while (offset < end) {
+    if (end - offset < BLOCKNUM_LEN + LENGTH_LEN) {
+      break;
+    }
+    const uint64_t blockNum =
+        Serializable::GetNumber<uint64_t>(data, offset, BLOCKNUM_LEN);
+    const uint32_t length = Serializable::GetNumber<uint32_t>(
+        data, offset + BLOCKNUM_LEN, LENGTH_LEN);
+    offset += BLOCKNUM_LEN + LENGTH_LEN;
+    if (end - offset < length ||
+        (!result.empty() && blockNum != result.rbegin()->first + 1)) {
+      break;
+    }
+    result.emplace_hint(result.end(), blockNum,
+                        bytes(data.begin() + offset,
+                              data.begin() + offset + length));
+    offset += length;
+  }
+
+  if (offset != end || result.size() != count || result.empty()) {
+    LOG_GENERAL(WARNING, "Snapshot " << m_filename << " is corrupted");
+    return false;
+  }
+
+  blocks = move(result);
+  return true;
+}
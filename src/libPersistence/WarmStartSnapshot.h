@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef WARMSTARTSNAPSHOT_H
+#define WARMSTARTSNAPSHOT_H
+
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include "common/BaseType.h"
+
+/// Copy of the most recent serialized Tx blocks, kept in a file so that a
+/// restart can rebuild the in-memory Tx block chain without reading and
+/// deserializing every Tx block in the database. Older blocks are read from
+/// the database when first asked for, as they are once out of the chain.
+///
+/// The file holds the blocks back to back in block number order, each as
+/// (block number, length, body), then a footer of (count, magic). It is
+/// rewritten every few blocks to a temporary file that is then renamed over
+/// the previous one, so a crash leaves the last complete snapshot behind.
+/// The writes made as blocks are added go through AsyncFileWriter, so that
+/// they do not hold up the commit of the epoch.
+/// The snapshot is never trusted on its own; BlockStorage checks it against
+/// the database before using it.
+class WarmStartSnapshot {
+ public:
+  /// Keeps the capacity newest blocks, and writes them out to filename each
+  /// time a block whose number + 1 is a multiple of interval is added
+  WarmStartSnapshot(const std::string& filename, unsigned int capacity,
+                    unsigned int interval);
+  /// Waits for the writes started by Add
+  ~WarmStartSnapshot();
+  WarmStartSnapshot(const WarmStartSnapshot&) = delete;
+  WarmStartSnapshot& operator=(const WarmStartSnapshot&) = delete;
+
+  void Add(const uint64_t& blockNum, const bytes& body);
+
+  /// Forgets a block, such as one trimmed from the database
+  void Remove(const uint64_t& blockNum);
+
+  /// Replaces the kept blocks, keeping only the capacity newest of them
+  void Reset(std::map<uint64_t, bytes>&& blocks);
+
+  /// Forgets all blocks and deletes the file
+  void Clear();
+
+  /// Writes the kept blocks to the file, after the writes started by Add
+  bool Write();
+
+  /// Waits for the writes started by Add to finish
+  void WaitForWrites();
+
+  /// Reads the blocks in the file, which were numbered consecutively
+  bool Read(std::map<uint64_t, bytes>& blocks) const;
+
+  unsigned int GetCapacity() const { return m_capacity; }
+
+ private:
+  struct Contents {
+    bytes m_data;
+    uint64_t m_first = 0;
+    uint64_t m_last = 0;
+  };
+
+  void Trim();
+  /// Serializes the newest consecutive run of kept blocks, false if none
+  bool Serialize(Contents& contents);
+  /// Renames the written temporary file over the snapshot. Caller holds
+  /// m_mutexFile.
+  bool Replace(const uint64_t& first, const uint64_t& last);
+  void WriteInBackground();
+  /// Caller holds m_mutexFile
+  void StartWrite(Contents&& contents);
+
+  const std::string m_filename;
+  const unsigned int m_capacity;
+  const unsigned int m_interval;
+
+  std::map<uint64_t, bytes> m_blocks;
+  std::mutex m_mutexBlocks;
+  /// Serialises writers of the file, without holding up Add
+  std::mutex m_mutexFile;
+  std::condition_variable m_cvWrite;
+  /// Set while a write started by Add is in flight; the next one waits in
+  /// m_queued, which only the newest is kept in
+  bool m_writing = false;
+  bool m_hasQueued = false;
+  Contents m_queued;
+  /// Bumped by Clear, so that a write in flight then is dropped
+  uint64_t m_generation = 0;
+};
+
+#endif  // WARMSTARTSNAPSHOT_H
@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <arpa/inet.h>
+#include <event2/buffer.h>
+#include <event2/event.h>
+#include <event2/thread.h>
+#include <cstring>
+
+#include "ProtoRpcServer.h"
+#include "common/Constants.h"
+#include "libUtils/DetachedFunction.h"
+
+using namespace std;
+using namespace ZilliqaMessage;
+
+namespace {
+const size_t FRAME_HEADER_SIZE = 4;
+/// Past this many unanswered requests, a connection is not read from until
+/// some are answered
+const unsigned int MAX_IN_FLIGHT_PER_CONNECTION = 64;
+
+string MakeFrame(const string& body) {
+  const uint32_t size = htonl(static_cast<uint32_t>(body.size()));
+  string frame(reinterpret_cast<const char*>(&size), FRAME_HEADER_SIZE);
+  frame += body;
+  return frame;
+}
+}  // namespace
+
+template <class Response>
+ProtoRpcServer::Handler ProtoRpcServer::MakeHandler(
+    Response (ProtoServer::*method)()) {
+  return [this, method]([[gnu::unused]] const string& params,
+                        string& result) -> bool {
+    return (m_protoServer.*method)().SerializeToString(&result);
+  };
+}
+
+template <class Request, class Response>
+ProtoRpcServer::Handler ProtoRpcServer::MakeHandler(
+    Response (ProtoServer::*method)(Request&)) {
+  return [this, method](const string& params, string& result) -> bool {
+    Request request;
+    if (!request.ParseFromString(params)) {
+      return false;
+    }
+    return (m_protoServer.*method)(request).SerializeToString(&result);
+  };
+}
+
+ProtoRpcServer::ProtoRpcServer(Mediator& mediator)
+    : m_protoServer(mediator),
+      m_workers(PROTO_RPC_WORKER_THREADS, "ProtoRpcWorkers") {
+  m_handlers = {
+      {"GetClientVersion", MakeHandler(&ProtoServer::GetClientVersion)},
+      {"GetNetworkId", MakeHandler(&ProtoServer::GetNetworkId)},
+      {"GetProtocolVersion", MakeHandler(&ProtoServer::GetProtocolVersion)},
+      {"GetGasPrice", MakeHandler(&ProtoServer::GetGasPrice)},
+      {"GetStorageAt", MakeHandler(&ProtoServer::GetStorageAt)},
+      {"GetBlockTransactionCount",
+       MakeHandler(&ProtoServer::GetBlockTransactionCount)},
+      {"CreateMessage", MakeHandler(&ProtoServer::CreateMessage)},
+      {"GetGasEstimate", MakeHandler(&ProtoServer::GetGasEstimate)},
+      {"GetTransactionReceipt",
+       MakeHandler(&ProtoServer::GetTransactionReceipt)},
+      {"isNodeSyncing", MakeHandler(&ProtoServer::isNodeSyncing)},
+      {"isNodeMining", MakeHandler(&ProtoServer::isNodeMining)},
+      {"GetHashrate", MakeHandler(&ProtoServer::GetHashrate)},
+      {"CreateTransaction", MakeHandler(&ProtoServer::CreateTransaction)},
+      {"GetTransaction", MakeHandler(&ProtoServer::GetTransaction)},
+      {"GetDsBlock", MakeHandler(&ProtoServer::GetDsBlock)},
+      {"GetTxBlock", MakeHandler(&ProtoServer::GetTxBlock)},
+      {"GetLatestDsBlock", MakeHandler(&ProtoServer::GetLatestDsBlock)},
+      {"GetLatestTxBlock", MakeHandler(&ProtoServer::GetLatestTxBlock)},
+      {"GetBalance", MakeHandler(&ProtoServer::GetBalance)},
+      {"GetSmartContractState",
+       MakeHandler(&ProtoServer::GetSmartContractState)},
+      {"GetSmartContractCode", MakeHandler(&ProtoServer::GetSmartContractCode)},
+      {"GetSmartContracts", MakeHandler(&ProtoServer::GetSmartContracts)},
+      {"GetContractAddressFromTransactionID",
+       MakeHandler(&ProtoServer::GetContractAddressFromTransactionID)},
+      {"GetNumPeers", MakeHandler(&ProtoServer::GetNumPeers)},
+      {"GetNumTxBlocks", MakeHandler(&ProtoServer::GetNumTxBlocks)},
+      {"GetNumDSBlocks", MakeHandler(&ProtoServer::GetNumDSBlocks)},
+      {"GetNumTransactions",
+       MakeHandler<StringResponse>(&ProtoServer::GetNumTransactions)},
+      {"GetTransactionRate", MakeHandler(&ProtoServer::GetTransactionRate)},
+      {"GetDSBlockRate", MakeHandler(&ProtoServer::GetDSBlockRate)},
+      {"GetTxBlockRate", MakeHandler(&ProtoServer::GetTxBlockRate)},
+      {"GetCurrentMiniEpoch", MakeHandler(&ProtoServer::GetCurrentMiniEpoch)},
+      {"GetCurrentDSEpoch", MakeHandler(&ProtoServer::GetCurrentDSEpoch)},
+      {"DSBlockListing", MakeHandler(&ProtoServer::DSBlockListing)},
+      {"TxBlockListing", MakeHandler(&ProtoServer::TxBlockListing)},
+      {"GetBlockchainInfo", MakeHandler(&ProtoServer::GetBlockchainInfo)},
+      {"GetRecentTransactions",
+       MakeHandler(&ProtoServer::GetRecentTransactions)},
+      {"GetShardingStructure", MakeHandler(&ProtoServer::GetShardingStructure)},
+      {"GetNumTxnsTxEpoch", MakeHandler(&ProtoServer::GetNumTxnsTxEpoch)},
+      {"GetNumTxnsDSEpoch", MakeHandler(&ProtoServer::GetNumTxnsDSEpoch)}};
+}
+
+string ProtoRpcServer::HandleFrame(const string& frame) {
+  ProtoRpcRequest request;
+  ProtoRpcResponse response;
+
+  if (!request.ParseFromString(frame)) {
+    response.set_error("Invalid request");
+  } else {
+    if (request.has_id()) {
+      response.set_id(request.id());
+    }
+
+    auto it = m_handlers.find(request.method());
+    if (it == m_handlers.end()) {
+      response.set_error("Method not found");
+    } else {
+      try {
+        string result;
+        if (!it->second(request.params(), result)) {
+          response.set_error("Invalid params");
+        } else {
+          response.set_result(result);
+        }
+      } catch (exception& e) {
+        LOG_GENERAL(INFO, "[Error]" << e.what()
+                                    << " Method: " << request.method());
+        response.set_error("Unable To Process");
+      }
+    }
+  }
+
+  string body;
+  response.SerializeToString(&body);
+  return MakeFrame(body);
+}
+
+void ProtoRpcServer::Start(unsigned int port) {
+  auto func = [this, port]() -> void { RunEventLoop(port); };
+  DetachedFunction(DetachedFunction::Lane::BLOCKING, 1, func);
+}
+
+void ProtoRpcServer::RunEventLoop(unsigned int port) {
+  // The workers activate m_wakeEvent from their own threads
+  if (evthread_use_pthreads() != 0) {
+    LOG_GENERAL(WARNING, "evthread_use_pthreads failure.");
+    return;
+  }
+
+  m_base = event_base_new();
+  if (m_base == NULL) {
+    LOG_GENERAL(WARNING, "event_base_new failure.");
+    return;
+  }
+
+  struct sockaddr_in serv_addr;
+  memset(&serv_addr, 0, sizeof(struct sockaddr_in));
+  serv_addr.sin_family = AF_INET;
+  serv_addr.sin_port = htons(port);
+  serv_addr.sin_addr.s_addr = INADDR_ANY;
+
+  struct evconnlistener* listener = evconnlistener_new_bind(
+      m_base, AcceptCallback, this, LEV_OPT_REUSEABLE | LEV_OPT_CLOSE_ON_FREE,
+      -1, (struct sockaddr*)&serv_addr, sizeof(struct sockaddr_in));
+  if (listener == NULL) {
+    LOG_GENERAL(WARNING, "evconnlistener_new_bind failure.");
+    event_base_free(m_base);
+    m_base = NULL;
+    return;
+  }
+
+  {
+    lock_guard<mutex> g(m_mutexResponses);
+    m_wakeEvent = event_new(m_base, -1, 0, WakeCallback, this);
+  }
+
+  LOG_GENERAL(INFO, "Protobuf RPC server listening on port " << port);
+
+  event_base_dispatch(m_base);
+
+  {
+    lock_guard<mutex> g(m_mutexResponses);
+    event_free(m_wakeEvent);
+    m_wakeEvent = NULL;
+  }
+  evconnlistener_free(listener);
+  event_base_free(m_base);
+  m_base = NULL;
+}
+
+void ProtoRpcServer::AcceptCallback(struct evconnlistener* listener,
+                                    evutil_socket_t sock,
+                                    [[gnu::unused]] struct sockaddr* addr,
+                                    [[gnu::unused]] int socklen, void* ctx) {
+  ProtoRpcServer* server = static_cast<ProtoRpcServer*>(ctx);
+
+  if (server->m_connections.size() >= PROTO_RPC_MAX_CONNECTIONS) {
+    LOG_GENERAL(WARNING, "Too many protobuf RPC connections, refusing one");
+    evutil_closesocket(sock);
+    return;
+  }
+
+  struct bufferevent* bev = bufferevent_socket_new(
+      evconnlistener_get_base(listener), sock, BEV_OPT_CLOSE_ON_FREE);
+  if (bev == NULL) {
+    LOG_GENERAL(WARNING, "bufferevent_socket_new failure.");
+    evutil_closesocket(sock);
+    return;
+  }
+
+  const uint64_t id = server->m_nextConnectionId++;
+  server->m_connections[id].m_bev = bev;
+  server->m_connectionIds[bev] = id;
+
+  bufferevent_setcb(bev, ReadCallback, NULL, EventCallback, server);
+  bufferevent_enable(bev, EV_READ | EV_WRITE);
+}
+
+void ProtoRpcServer::ReadCallback(struct bufferevent* bev, void* ctx) {
+  static_cast<ProtoRpcServer*>(ctx)->ProcessFrames(bev);
+}
+
+void ProtoRpcServer::EventCallback(struct bufferevent* bev, short events,
+                                   void* ctx) {
+  if (events & (BEV_EVENT_EOF | BEV_EVENT_ERROR | BEV_EVENT_TIMEOUT)) {
+    static_cast<ProtoRpcServer*>(ctx)->Close(bev);
+  }
+}
+
+void ProtoRpcServer::WakeCallback([[gnu::unused]] evutil_socket_t fd,
+                                  [[gnu::unused]] short events, void* ctx) {
+  static_cast<ProtoRpcServer*>(ctx)->SendResponses();
+}
+
+void ProtoRpcServer::Close(struct bufferevent* bev) {
+  auto it = m_connectionIds.find(bev);
+  if (it != m_connectionIds.end()) {
+    m_connections.erase(it->second);
+    m_connectionIds.erase(it);
+  }
+  bufferevent_free(bev);
+}
+
+void ProtoRpcServer::ProcessFrames(struct bufferevent* bev) {
+  auto idIt = m_connectionIds.find(bev);
+  if (idIt == m_connectionIds.end()) {
+    return;
+  }
+  const uint64_t id = idIt->second;
+  Connection& connection = m_connections[id];
+
+  struct evbuffer* input = bufferevent_get_input(bev);
+  while (connection.m_inFlight < MAX_IN_FLIGHT_PER_CONNECTION) {
+    const size_t length = evbuffer_get_length(input);
+    if (length < FRAME_HEADER_SIZE) {
+      break;
+    }
+
+    uint32_t size = 0;
+    evbuffer_copyout(input, &size, FRAME_HEADER_SIZE);
+    size = ntohl(size);
+    if (size > PROTO_RPC_MAX_MESSAGE_SIZE) {
+      LOG_GENERAL(WARNING, "Protobuf RPC frame of " << size
+                                                    << " bytes, closing");
+      Close(bev);
+      return;
+    }
+    if (length < FRAME_HEADER_SIZE + size) {
+      break;
+    }
+
+    evbuffer_drain(input, FRAME_HEADER_SIZE);
+    string frame(size, '\0');
+    evbuffer_remove(input, &frame[0], size);
+
+    connection.m_inFlight++;
+    m_workers.AddJob([this, id, frame]() -> void {
+      string response = HandleFrame(frame);
+
+      lock_guard<mutex> g(m_mutexResponses);
+      m_responses.emplace_back(id, move(response));
+      if (m_wakeEvent != NULL) {
+        event_active(m_wakeEvent, 0, 0);
+      }
+    });
+  }
+
+  if (connection.m_inFlight >= MAX_IN_FLIGHT_PER_CONNECTION) {
+    bufferevent_disable(bev, EV_READ);
+  }
+}
+
+void ProtoRpcServer::SendResponses() {
+  vector<pair<uint64_t, string>> responses;
+  {
+    lock_guard<mutex> g(m_mutexResponses);
+    responses.swap(m_responses);
+  }
+
+  for (auto& response : responses) {
+    auto it = m_connections.find(response.first);
+    if (it == m_connections.end()) {
+      continue;
+    }
+
+    Connection& connection = it->second;
+    bufferevent_write(connection.m_bev, response.second.data(),
+                      response.second.size());
+    if (connection.m_inFlight-- == MAX_IN_FLIGHT_PER_CONNECTION) {
+      // Frames that arrived while reading was paused are still buffered
+      bufferevent_enable(connection.m_bev, EV_READ);
+      ProcessFrames(connection.m_bev);
+    }
+  }
+}
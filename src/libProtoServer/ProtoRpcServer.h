@@ -0,0 +1,97 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PROTORPCSERVER_H__
+#define __PROTORPCSERVER_H__
+
+#include <event2/bufferevent.h>
+#include <event2/listener.h>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ProtoServer.h"
+#include "libUtils/Logger.h"
+#include "libUtils/ThreadPool.h"
+
+/// Serves the methods of ProtoServer over TCP, without any JSON. Each frame,
+/// in either direction, is a 4 byte big-endian length followed by that many
+/// bytes of a serialized ProtoRpcRequest or ProtoRpcResponse. Requests are
+/// answered by a pool of workers, so responses may come back out of order;
+/// clients match them to their requests by id.
+class ProtoRpcServer {
+  typedef std::function<bool(const std::string& params, std::string& result)>
+      Handler;
+
+  struct Connection {
+    struct bufferevent* m_bev;
+    unsigned int m_inFlight{0};
+  };
+
+  ProtoServer m_protoServer;
+  std::unordered_map<std::string, Handler> m_handlers;
+
+  struct event_base* m_base{nullptr};
+  /// Activated by the workers once they queued a response
+  struct event* m_wakeEvent{nullptr};
+
+  /// Only used from the event loop thread. Workers refer to connections by
+  /// id, so that a connection closed meanwhile just drops its responses.
+  uint64_t m_nextConnectionId{0};
+  std::unordered_map<uint64_t, Connection> m_connections;
+  std::unordered_map<struct bufferevent*, uint64_t> m_connectionIds;
+
+  std::mutex m_mutexResponses;
+  std::vector<std::pair<uint64_t, std::string>> m_responses;
+
+  /// Last, so that the workers are joined before what they use goes away
+  ThreadPool m_workers;
+
+  template <class Response>
+  Handler MakeHandler(Response (ProtoServer::*method)());
+
+  template <class Request, class Response>
+  Handler MakeHandler(Response (ProtoServer::*method)(Request&));
+
+  static void AcceptCallback(struct evconnlistener* listener,
+                             evutil_socket_t sock, struct sockaddr* addr,
+                             int socklen, void* ctx);
+  static void ReadCallback(struct bufferevent* bev, void* ctx);
+  static void EventCallback(struct bufferevent* bev, short events, void* ctx);
+  static void WakeCallback(evutil_socket_t fd, short events, void* ctx);
+
+  void RunEventLoop(unsigned int port);
+  void Close(struct bufferevent* bev);
+  void ProcessFrames(struct bufferevent* bev);
+  void SendResponses();
+
+ public:
+  explicit ProtoRpcServer(Mediator& mediator);
+  ~ProtoRpcServer() = default;
+
+  /// Listens on port from a thread of its own
+  void Start(unsigned int port);
+
+  /// Runs the request in frame (without its length) and returns the response
+  /// frame, length included
+  std::string HandleFrame(const std::string& frame);
+};
+
+#endif  // __PROTORPCSERVER_H__
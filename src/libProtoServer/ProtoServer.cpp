@@ -22,7 +22,7 @@
 #pragma GCC diagnostic pop
 #include <iostream>
 
-#include "Server.h"
+#include "ProtoServer.h"
 #include "common/Messages.h"
 #include "common/Serializable.h"
 #include "libCrypto/Schnorr.h"
@@ -41,38 +41,38 @@
 using namespace std;
 using namespace ZilliqaMessage;
 
-CircularArray<std::string> Server::m_RecentTransactions;
-std::mutex Server::m_mutexRecentTxns;
-
 const unsigned int PAGE_SIZE = 10;
 const unsigned int NUM_PAGES_CACHE = 2;
 const unsigned int TXN_PAGE_SIZE = 100;
 
+SeqLockRing<dev::h256> ProtoServer::m_RecentTransactions(TXN_PAGE_SIZE);
+
 //[warning] do not make this constant too big as it loops over blockchain
 const unsigned int REF_BLOCK_DIFF = 5;
 
 // Forward declarations (implementation in libMessage).
-int ProtobufToTransaction(const ProtoTransaction& protoTransaction,
-                          Transaction& transaction);
+bool ProtobufToTransaction(const ProtoTransaction& protoTransaction,
+                           Transaction& transaction);
 void TransactionToProtobuf(const Transaction& transaction,
                            ProtoTransaction& protoTransaction);
-void ProtobufToDSBlock(const ProtoDSBlock& protoDSBlock, DSBlock& dsBlock);
+bool ProtobufToDSBlock(const ProtoDSBlock& protoDSBlock, DSBlock& dsBlock);
 void DSBlockToProtobuf(const DSBlock& dsBlock, ProtoDSBlock& protoDSBlock);
 void TxBlockToProtobuf(const TxBlock& txBlock, ProtoTxBlock& protoTxBlock);
 
-Server::Server(Mediator& mediator) : m_mediator(mediator) {
+ProtoServer::ProtoServer(Mediator& mediator) : m_mediator(mediator) {
   m_StartTimeTx = 0;
   m_StartTimeDs = 0;
   m_DSBlockCache.first = 0;
   m_DSBlockCache.second.resize(NUM_PAGES_CACHE * PAGE_SIZE);
   m_TxBlockCache.first = 0;
   m_TxBlockCache.second.resize(NUM_PAGES_CACHE * PAGE_SIZE);
-  m_RecentTransactions.resize(TXN_PAGE_SIZE);
+  m_BlockTxPair.first = 0;
+  m_BlockTxPair.second = 0;
   m_TxBlockCountSumPair.first = 0;
   m_TxBlockCountSumPair.second = 0;
 }
 
-Server::~Server() {
+ProtoServer::~ProtoServer() {
   // destructor
 }
 
@@ -80,7 +80,8 @@ Server::~Server() {
 // Auxillary functions.
 ////////////////////////////////////////////////////////////////////////
 
-boost::multiprecision::uint256_t Server::GetNumTransactions(uint64_t blockNum) {
+boost::multiprecision::uint256_t ProtoServer::GetNumTransactions(
+    uint64_t blockNum) {
   uint64_t currBlockNum =
       m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum();
 
@@ -96,70 +97,79 @@ boost::multiprecision::uint256_t Server::GetNumTransactions(uint64_t blockNum) {
   return res;
 }
 
-void Server::AddToRecentTransactions(const dev::h256& txhash) {
-  lock_guard<mutex> g(m_mutexRecentTxns);
-  m_RecentTransactions.insert_new(m_RecentTransactions.size(), txhash.hex());
+void ProtoServer::AddToRecentTransactions(const dev::h256& txhash) {
+  m_RecentTransactions.Push(txhash);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////
 
-DefaultResponse Server::GetClientVersion() {
+DefaultResponse ProtoServer::GetClientVersion() {
   DefaultResponse ret;
   return ret;
 }
 
-DefaultResponse Server::GetNetworkId() {
+DefaultResponse ProtoServer::GetNetworkId() {
   DefaultResponse ret;
   ret.set_result(to_string(CHAIN_ID));
   return ret;
 }
 
-DefaultResponse Server::GetProtocolVersion() {
+DefaultResponse ProtoServer::GetProtocolVersion() {
   DefaultResponse ret;
   return ret;
 }
 
-DefaultResponse Server::GetGasPrice() {
+DefaultResponse ProtoServer::GetGasPrice() {
   DefaultResponse ret;
   return ret;
 }
 
-DefaultResponse Server::GetStorageAt([
+DefaultResponse ProtoServer::GetStorageAt([
     [gnu::unused]] GetStorageAtRequest& request) {
   DefaultResponse ret;
   return ret;
 }
 
-DefaultResponse Server::GetBlockTransactionCount([
+DefaultResponse ProtoServer::GetBlockTransactionCount([
     [gnu::unused]] GetBlockTransactionCountRequest& request) {
   DefaultResponse ret;
   return ret;
 }
 
-DefaultResponse Server::GetTransactionReceipt([
+DefaultResponse ProtoServer::GetTransactionReceipt([
     [gnu::unused]] GetTransactionRequest& request) {
   DefaultResponse ret;
   return ret;
 }
 
-DefaultResponse Server::isNodeSyncing() {
+DefaultResponse ProtoServer::isNodeSyncing() {
+  DefaultResponse ret;
+  return ret;
+}
+
+DefaultResponse ProtoServer::isNodeMining() {
   DefaultResponse ret;
   return ret;
 }
 
-DefaultResponse Server::isNodeMining() {
+DefaultResponse ProtoServer::GetHashrate() {
   DefaultResponse ret;
   return ret;
 }
 
-DefaultResponse Server::GetHashrate() {
+DefaultResponse ProtoServer::CreateMessage() {
+  DefaultResponse ret;
+  return ret;
+}
+
+DefaultResponse ProtoServer::GetGasEstimate() {
   DefaultResponse ret;
   return ret;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////
 
-CreateTransactionResponse Server::CreateTransaction(
+CreateTransactionResponse ProtoServer::CreateTransaction(
     CreateTransactionRequest& request) {
   LOG_MARKER();
 
@@ -174,8 +184,7 @@ CreateTransactionResponse Server::CreateTransaction(
 
     // Convert ProtoTransaction to Transaction.
     Transaction tx;
-    if (ProtobufToTransaction(request.tx(), tx) !=
-        0) {  // check if conversion failed.
+    if (!ProtobufToTransaction(request.tx(), tx)) {
       ret.set_error("ProtoTransaction to Transaction conversion failed");
       return ret;
     }
@@ -186,7 +195,8 @@ CreateTransactionResponse Server::CreateTransaction(
       return ret;
     }
 
-    unsigned int num_shards = m_mediator.m_lookup->GetShardPeers().size();
+    unsigned int num_shards =
+        m_mediator.m_lookup->GetShardPeers()->GetNumShards();
 
     const PubKey& senderPubKey = tx.GetSenderPubKey();
     const Address fromAddr = Account::GetAddressFromPublicKey(senderPubKey);
@@ -254,7 +264,8 @@ CreateTransactionResponse Server::CreateTransaction(
   return ret;
 }
 
-GetTransactionResponse Server::GetTransaction(GetTransactionRequest& request) {
+GetTransactionResponse ProtoServer::GetTransaction(
+    GetTransactionRequest& request) {
   LOG_MARKER();
 
   GetTransactionResponse ret;
@@ -296,7 +307,7 @@ GetTransactionResponse Server::GetTransaction(GetTransactionRequest& request) {
   return ret;
 }
 
-GetDSBlockResponse Server::GetDsBlock(ProtoBlockNum& protoBlockNum) {
+GetDSBlockResponse ProtoServer::GetDsBlock(ProtoBlockNum& protoBlockNum) {
   LOG_MARKER();
 
   GetDSBlockResponse ret;
@@ -337,7 +348,7 @@ GetDSBlockResponse Server::GetDsBlock(ProtoBlockNum& protoBlockNum) {
   return ret;
 }
 
-GetTxBlockResponse Server::GetTxBlock(ProtoBlockNum& protoBlockNum) {
+GetTxBlockResponse ProtoServer::GetTxBlock(ProtoBlockNum& protoBlockNum) {
   LOG_MARKER();
 
   GetTxBlockResponse ret;
@@ -378,7 +389,7 @@ GetTxBlockResponse Server::GetTxBlock(ProtoBlockNum& protoBlockNum) {
   return ret;
 }
 
-GetDSBlockResponse Server::GetLatestDsBlock() {
+GetDSBlockResponse ProtoServer::GetLatestDsBlock() {
   LOG_MARKER();
 
   GetDSBlockResponse ret;
@@ -398,7 +409,7 @@ GetDSBlockResponse Server::GetLatestDsBlock() {
   return ret;
 }
 
-GetTxBlockResponse Server::GetLatestTxBlock() {
+GetTxBlockResponse ProtoServer::GetLatestTxBlock() {
   LOG_MARKER();
 
   GetTxBlockResponse ret;
@@ -418,7 +429,7 @@ GetTxBlockResponse Server::GetLatestTxBlock() {
   return ret;
 }
 
-GetBalanceResponse Server::GetBalance(ProtoAddress& protoAddress) {
+GetBalanceResponse ProtoServer::GetBalance(ProtoAddress& protoAddress) {
   LOG_MARKER();
 
   GetBalanceResponse ret;
@@ -441,18 +452,24 @@ GetBalanceResponse Server::GetBalance(ProtoAddress& protoAddress) {
     }
 
     Address addr(tmpaddr);
-    const Account* account = AccountStore::GetInstance().GetAccount(addr);
 
-    if (account != nullptr) {
-      boost::multiprecision::uint128_t balance = account->GetBalance();
-      ret.set_balance(balance.str());
+    AccountSnapshotEntry entry;
+    if (!AccountStore::GetInstance().GetAccountFromSnapshot(addr, entry)) {
+      const Account* account = AccountStore::GetInstance().GetAccount(addr);
+      if (account != nullptr) {
+        entry.m_balance = account->GetBalance();
+        entry.m_nonce = account->GetNonce();
+        entry.m_exists = true;
+      }
+    }
 
-      boost::multiprecision::uint128_t nonce = account->GetNonce();
-      ret.set_nonce(nonce.str());
+    if (entry.m_exists) {
+      ret.set_balance(entry.m_balance.str());
+      ret.set_nonce(to_string(entry.m_nonce));
 
-      LOG_GENERAL(INFO, "balance " << balance.str() << " nonce: "
-                                   << nonce.convert_to<unsigned int>());
-    } else if (account == nullptr) {
+      LOG_GENERAL(INFO, "balance " << entry.m_balance.str()
+                                   << " nonce: " << entry.m_nonce);
+    } else {
       ret.set_balance("0");
       ret.set_nonce("0");
     }
@@ -466,7 +483,7 @@ GetBalanceResponse Server::GetBalance(ProtoAddress& protoAddress) {
   return ret;
 }
 
-GetSmartContractStateResponse Server::GetSmartContractState(
+GetSmartContractStateResponse ProtoServer::GetSmartContractState(
     ProtoAddress& protoAddress) {
   LOG_MARKER();
 
@@ -519,7 +536,8 @@ GetSmartContractStateResponse Server::GetSmartContractState(
   return ret;
 }
 
-GetSmartContractCodeResponse GetSmartContractCode(ProtoAddress& protoAddress) {
+GetSmartContractCodeResponse ProtoServer::GetSmartContractCode(
+    ProtoAddress& protoAddress) {
   LOG_MARKER();
 
   GetSmartContractCodeResponse ret;
@@ -565,7 +583,8 @@ GetSmartContractCodeResponse GetSmartContractCode(ProtoAddress& protoAddress) {
   return ret;
 }
 
-GetSmartContractResponse Server::GetSmartContracts(ProtoAddress& protoAddress) {
+GetSmartContractResponse ProtoServer::GetSmartContracts(
+    ProtoAddress& protoAddress) {
   LOG_MARKER();
 
   GetSmartContractResponse ret;
@@ -627,7 +646,7 @@ GetSmartContractResponse Server::GetSmartContracts(ProtoAddress& protoAddress) {
   return ret;
 }
 
-StringResponse Server::GetContractAddressFromTransactionID(
+StringResponse ProtoServer::GetContractAddressFromTransactionID(
     ProtoTxId& protoTxId) {
   LOG_MARKER();
 
@@ -670,7 +689,7 @@ StringResponse Server::GetContractAddressFromTransactionID(
   return ret;
 }
 
-UIntResponse Server::GetNumPeers() {
+UIntResponse ProtoServer::GetNumPeers() {
   LOG_MARKER();
 
   unsigned int numPeers = m_mediator.m_lookup->GetNodePeers().size();
@@ -681,7 +700,7 @@ UIntResponse Server::GetNumPeers() {
   return ret;
 }
 
-StringResponse Server::GetNumTxBlocks() {
+StringResponse ProtoServer::GetNumTxBlocks() {
   LOG_MARKER();
 
   StringResponse ret;
@@ -689,7 +708,7 @@ StringResponse Server::GetNumTxBlocks() {
   return ret;
 }
 
-StringResponse Server::GetNumDSBlocks() {
+StringResponse ProtoServer::GetNumDSBlocks() {
   LOG_MARKER();
 
   StringResponse ret;
@@ -697,11 +716,12 @@ StringResponse Server::GetNumDSBlocks() {
   return ret;
 }
 
-StringResponse Server::GetNumTransactions() {
+StringResponse ProtoServer::GetNumTransactions() {
   LOG_MARKER();
 
   uint64_t currBlock =
       m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum();
+  lock_guard<mutex> g(m_mutexBlockTxPair);
   if (m_BlockTxPair.first < currBlock) {
     for (uint64_t i = m_BlockTxPair.first + 1; i <= currBlock; i++) {
       m_BlockTxPair.second +=
@@ -715,7 +735,7 @@ StringResponse Server::GetNumTransactions() {
   return ret;
 }
 
-DoubleResponse Server::GetTransactionRate() {
+DoubleResponse ProtoServer::GetTransactionRate() {
   LOG_MARKER();
 
   DoubleResponse ret;
@@ -739,7 +759,7 @@ DoubleResponse Server::GetTransactionRate() {
   }
 
   boost::multiprecision::cpp_dec_float_50 numTxns(
-      Server::GetNumTransactions(refBlockNum));
+      ProtoServer::GetNumTransactions(refBlockNum));
   LOG_GENERAL(INFO, "Num Txns: " << numTxns);
 
   try {
@@ -772,7 +792,7 @@ DoubleResponse Server::GetTransactionRate() {
   return ret;
 }
 
-DoubleResponse Server::GetDSBlockRate() {
+DoubleResponse ProtoServer::GetDSBlockRate() {
   LOG_MARKER();
 
   DoubleResponse ret;
@@ -812,7 +832,7 @@ DoubleResponse Server::GetDSBlockRate() {
   return ret;
 }
 
-DoubleResponse Server::GetTxBlockRate() {
+DoubleResponse ProtoServer::GetTxBlockRate() {
   LOG_MARKER();
 
   DoubleResponse ret;
@@ -851,7 +871,7 @@ DoubleResponse Server::GetTxBlockRate() {
   return ret;
 }
 
-UInt64Response Server::GetCurrentMiniEpoch() {
+UInt64Response ProtoServer::GetCurrentMiniEpoch() {
   LOG_MARKER();
 
   UInt64Response ret;
@@ -859,7 +879,7 @@ UInt64Response Server::GetCurrentMiniEpoch() {
   return ret;
 }
 
-UInt64Response Server::GetCurrentDSEpoch() {
+UInt64Response ProtoServer::GetCurrentDSEpoch() {
   LOG_MARKER();
 
   UInt64Response ret;
@@ -868,11 +888,11 @@ UInt64Response Server::GetCurrentDSEpoch() {
   return ret;
 }
 
-ProtoBlockListing Server::DSBlockListing(ProtoPage& protoPage) {
+ProtoBlockListing ProtoServer::DSBlockListing(ProtoPage& protoPage) {
   LOG_MARKER();
 
   ProtoBlockListing ret;
-  if (protoPage.has_page()) {
+  if (!protoPage.has_page()) {
     ret.set_error("Page not in request");
     return ret;
   }
@@ -882,6 +902,8 @@ ProtoBlockListing Server::DSBlockListing(ProtoPage& protoPage) {
   auto maxPages = (currBlockNum / PAGE_SIZE) + 1;
   ret.set_maxpages(int(maxPages));
 
+  lock_guard<mutex> g(m_mutexDSBlockCache);
+
   if (m_DSBlockCache.second.size() == 0) {
     try {
       // add the hash of genesis block
@@ -961,11 +983,11 @@ ProtoBlockListing Server::DSBlockListing(ProtoPage& protoPage) {
   return ret;
 }
 
-ProtoBlockListing Server::TxBlockListing(ProtoPage& protoPage) {
+ProtoBlockListing ProtoServer::TxBlockListing(ProtoPage& protoPage) {
   LOG_MARKER();
 
   ProtoBlockListing ret;
-  if (protoPage.has_page()) {
+  if (!protoPage.has_page()) {
     ret.set_error("Page not in request");
     return ret;
   }
@@ -975,6 +997,8 @@ ProtoBlockListing Server::TxBlockListing(ProtoPage& protoPage) {
   auto maxPages = (currBlockNum / PAGE_SIZE) + 1;
   ret.set_maxpages(int(maxPages));
 
+  lock_guard<mutex> g(m_mutexTxBlockCache);
+
   if (m_TxBlockCache.second.size() == 0) {
     try {
       // add the hash of genesis block
@@ -1054,56 +1078,52 @@ ProtoBlockListing Server::TxBlockListing(ProtoPage& protoPage) {
   return ret;
 }
 
-ProtoBlockChainInfo Server::GetBlockchainInfo() {
+ProtoBlockChainInfo ProtoServer::GetBlockchainInfo() {
   ProtoBlockChainInfo ret;
 
-  ret.set_numpeers(Server::GetNumPeers().result());
-  ret.set_numtxblocks(Server::GetNumTxBlocks().result());
-  ret.set_numdsblocks(Server::GetNumDSBlocks().result());
-  ret.set_numtxns(Server::GetNumTransactions().result());
-  ret.set_txrate(Server::GetTransactionRate().result());
-  ret.set_txblockrate(Server::GetTxBlockRate().result());
-  ret.set_dsblockrate(Server::GetDSBlockRate().result());
-  ret.set_currentminiepoch(Server::GetCurrentMiniEpoch().result());
-  ret.set_currentdsepoch(Server::GetCurrentDSEpoch().result());
-  ret.set_numtxnsdsepoch(Server::GetNumTxnsDSEpoch().result());
-  ret.set_numtxnstxepoch(Server::GetNumTxnsTxEpoch().result());
-
-  ProtoShardingStruct sharding = Server::GetShardingStructure();
+  ret.set_numpeers(ProtoServer::GetNumPeers().result());
+  ret.set_numtxblocks(ProtoServer::GetNumTxBlocks().result());
+  ret.set_numdsblocks(ProtoServer::GetNumDSBlocks().result());
+  ret.set_numtxns(ProtoServer::GetNumTransactions().result());
+  ret.set_txrate(ProtoServer::GetTransactionRate().result());
+  ret.set_txblockrate(ProtoServer::GetTxBlockRate().result());
+  ret.set_dsblockrate(ProtoServer::GetDSBlockRate().result());
+  ret.set_currentminiepoch(ProtoServer::GetCurrentMiniEpoch().result());
+  ret.set_currentdsepoch(ProtoServer::GetCurrentDSEpoch().result());
+  ret.set_numtxnsdsepoch(ProtoServer::GetNumTxnsDSEpoch().result());
+  ret.set_numtxnstxepoch(ProtoServer::GetNumTxnsTxEpoch().result());
+
+  ProtoShardingStruct sharding = ProtoServer::GetShardingStructure();
   ret.set_allocated_shardingstructure(&sharding);
 
   return ret;
 }
 
-ProtoTxHashes Server::GetRecentTransactions() {
+ProtoTxHashes ProtoServer::GetRecentTransactions() {
   LOG_MARKER();
 
-  lock_guard<mutex> g(m_mutexRecentTxns);
-
-  uint64_t actualSize(m_RecentTransactions.capacity());
-  if (actualSize > m_RecentTransactions.size()) {
-    actualSize = m_RecentTransactions.size();
-  }
+  vector<dev::h256> txnHashes;
+  m_RecentTransactions.GetLatest(TXN_PAGE_SIZE, txnHashes);
 
   ProtoTxHashes ret;
-  ret.set_number(int(actualSize));
+  ret.set_number(int(txnHashes.size()));
 
-  uint64_t size = m_RecentTransactions.size();
-  for (uint64_t i = 0; i < actualSize; i++) {
+  for (const auto& txnHash : txnHashes) {
     auto txhash = ret.add_txhashes();
-    txhash->set_txhash(m_RecentTransactions[size - i - 1]);
+    txhash->set_txhash(txnHash.hex());
   }
 
   return ret;
 }
 
-ProtoShardingStruct Server::GetShardingStructure() {
+ProtoShardingStruct ProtoServer::GetShardingStructure() {
   LOG_MARKER();
 
   ProtoShardingStruct ret;
 
   try {
-    auto shards = m_mediator.m_lookup->GetShardPeers();
+    const auto shardingStructure = m_mediator.m_lookup->GetShardPeers();
+    const auto& shards = shardingStructure->GetShards();
 
     unsigned int num_shards = shards.size();
 
@@ -1123,7 +1143,7 @@ ProtoShardingStruct Server::GetShardingStructure() {
   return ret;
 }
 
-UIntResponse Server::GetNumTxnsTxEpoch() {
+UIntResponse ProtoServer::GetNumTxnsTxEpoch() {
   LOG_MARKER();
 
   UIntResponse ret;
@@ -1139,7 +1159,7 @@ UIntResponse Server::GetNumTxnsTxEpoch() {
   return ret;
 }
 
-StringResponse Server::GetNumTxnsDSEpoch() {
+StringResponse ProtoServer::GetNumTxnsDSEpoch() {
   LOG_MARKER();
 
   StringResponse ret;
@@ -1149,6 +1169,8 @@ StringResponse Server::GetNumTxnsDSEpoch() {
     auto latestTxBlockNum = latestTxBlock.GetBlockNum();
     auto latestDSBlockNum = latestTxBlock.GetDSBlockNum();
 
+    lock_guard<mutex> g(m_mutexTxBlockCountSumPair);
+
     if (latestTxBlockNum > m_TxBlockCountSumPair.first) {
       // Case where the DS Epoch is same
       if (m_mediator.m_txBlockChain.GetBlock(m_TxBlockCountSumPair.first)
@@ -15,6 +15,9 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#ifndef __PROTOSERVER_H__
+#define __PROTOSERVER_H__
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 #include <boost/multiprecision/cpp_int.hpp>
@@ -22,6 +25,7 @@
 #include <mutex>
 #include "libData/BlockData/BlockHeader/BlockHeaderBase.h"
 #include "libData/DataStructures/CircularArray.h"
+#include "libData/DataStructures/SeqLockRing.h"
 
 #include "ServerMessages.pb.h"
 #include "ServerRequest.pb.h"
@@ -29,20 +33,24 @@
 
 class Mediator;
 
-class Server {
+class ProtoServer {
   Mediator& m_mediator;
+  // The methods are called from the workers of ProtoRpcServer in parallel
+  std::mutex m_mutexBlockTxPair;
   std::pair<uint64_t, boost::multiprecision::uint256_t> m_BlockTxPair;
+  std::mutex m_mutexTxBlockCountSumPair;
   std::pair<uint64_t, boost::multiprecision::uint256_t> m_TxBlockCountSumPair;
   uint64_t m_StartTimeTx;
   uint64_t m_StartTimeDs;
+  std::mutex m_mutexDSBlockCache;
   std::pair<uint64_t, CircularArray<std::string>> m_DSBlockCache;
+  std::mutex m_mutexTxBlockCache;
   std::pair<uint64_t, CircularArray<std::string>> m_TxBlockCache;
-  static CircularArray<std::string> m_RecentTransactions;
-  static std::mutex m_mutexRecentTxns;
+  static SeqLockRing<dev::h256> m_RecentTransactions;
 
  public:
-  Server(Mediator& mediator);
-  ~Server();
+  ProtoServer(Mediator& mediator);
+  ~ProtoServer();
 
   // Auxillary functions.
   boost::multiprecision::uint256_t GetNumTransactions(uint64_t blockNum);
@@ -132,3 +140,5 @@ class Server {
 
   ZilliqaMessage::StringResponse GetNumTxnsDSEpoch();
 };
+
+#endif  // __PROTOSERVER_H__
@@ -37,6 +37,7 @@ class Message {
     FORWARD = 0x05,
     LAZY_PUSH = 0x06,
     LAZY_PULL = 0x07,
+    BATCH = 0x08,
     NUM_TYPES
   };
 
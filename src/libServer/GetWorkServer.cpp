@@ -16,6 +16,7 @@
  */
 
 #include <chrono>
+#include <memory>
 
 #include "depends/libethash/include/ethash/ethash.hpp"
 #include "depends/safeserver/safehttpserver.h"
@@ -34,10 +35,27 @@ using namespace jsonrpc;
 
 static ethash_mining_result_t FAIL_RESULT = {"", "", 0, false};
 
+// Workers seen less recently than this are dropped from the stats
+static const chrono::seconds MINER_STATS_EXPIRY{3600};
+// Bounds the stats kept, should workers keep making up new names
+static const size_t MAX_MINER_STATS = 4096;
+
+// Long polls are answered on a pool of their own, so that the miners waiting
+// for new work never hold up the shares being submitted
+static unique_ptr<SafeHttpServer> CreateHttpServer() {
+  auto httpserver = make_unique<SafeHttpServer>(
+      GETWORK_SERVER_PORT, "", "", GETWORK_SERVER_THREADS);
+  httpserver->SetRequestPools(GETWORK_SERVER_WORKERS,
+                              GETWORK_LONG_POLL_WORKERS,
+                              GETWORK_MAX_QUEUED_REQUESTS,
+                              {"eth_getWorkLongPoll"});
+  return httpserver;
+}
+
 // GetInstance returns the singleton instance
 GetWorkServer& GetWorkServer::GetInstance() {
-  static SafeHttpServer httpserver(GETWORK_SERVER_PORT);
-  static GetWorkServer powserver(httpserver);
+  static auto httpserver = CreateHttpServer();
+  static GetWorkServer powserver(*httpserver);
   return powserver;
 }
 
@@ -71,12 +89,14 @@ bool GetWorkServer::StartMining(const PoWWorkPackage& wp) {
     lock_guard<mutex> g(m_mutexResult);
     m_curResult.success = false;
   }
-  // set work package
+  // set work package, and wake up the miners polling for it
   {
     lock_guard<mutex> g(m_mutexWork);
     m_startTime = std::chrono::system_clock::now();
     m_curWork = wp;
+    m_submittedNonces.clear();
     m_isMining = true;
+    m_cvWork.notify_all();
   }
 
   LOG_GENERAL(INFO, "Got PoW Work : "
@@ -89,10 +109,38 @@ bool GetWorkServer::StartMining(const PoWWorkPackage& wp) {
 
 // StopMining stops mining and clear result
 void GetWorkServer::StopMining() {
-  m_isMining = false;
+  {
+    lock_guard<mutex> g(m_mutexWork);
+    if (m_isMining) {
+      m_isMining = false;
+      m_cvWork.notify_all();
+    }
+  }
 
-  lock_guard<mutex> g(m_mutexResult);
-  m_curResult.success = false;
+  {
+    lock_guard<mutex> g(m_mutexResult);
+    m_curResult.success = false;
+  }
+
+  lock_guard<mutex> g(m_mutexMinerStats);
+  const auto now = chrono::system_clock::now();
+  uint64_t hashrate = 0, acceptedShares = 0, rejectedShares = 0;
+  for (auto it = m_minerStats.begin(); it != m_minerStats.end();) {
+    if (now - it->second.lastSeen > MINER_STATS_EXPIRY) {
+      it = m_minerStats.erase(it);
+      continue;
+    }
+    hashrate += it->second.hashrate;
+    acceptedShares += it->second.acceptedShares;
+    rejectedShares += it->second.rejectedShares;
+    ++it;
+  }
+  if (!m_minerStats.empty()) {
+    LOG_GENERAL(INFO, "Miners: " << m_minerStats.size()
+                                 << ", hashrate: " << hashrate
+                                 << " H/s, shares accepted: " << acceptedShares
+                                 << ", rejected: " << rejectedShares);
+  }
 }
 
 // SetNextPoWTime sets the time of next PoW
@@ -143,31 +191,55 @@ ethash_mining_result_t GetWorkServer::VerifySubmit(const string& nonce,
     return FAIL_RESULT;
   }
 
-  lock_guard<mutex> g(m_mutexWork);
+  uint64_t blocknum;
+  {
+    lock_guard<mutex> g(m_mutexWork);
 
-  // check the header and boundary is same with current work
-  if (header != m_curWork.header) {
-    LOG_GENERAL(WARNING, "Submit header diff with current work");
-    LOG_GENERAL(WARNING, "Current header: " << m_curWork.header);
-    LOG_GENERAL(WARNING, "Submit header: " << header);
-    return FAIL_RESULT;
-  }
-  if (boundary != m_curWork.boundary) {
-    LOG_GENERAL(WARNING, "Submit boundary diff with current work");
-    LOG_GENERAL(WARNING, "Current boundary: " << m_curWork.boundary);
-    LOG_GENERAL(WARNING, "Submit boundary: " << boundary);
-    return FAIL_RESULT;
+    // check the header and boundary is same with current work
+    if (header != m_curWork.header) {
+      LOG_GENERAL(WARNING, "Submit header diff with current work");
+      LOG_GENERAL(WARNING, "Current header: " << m_curWork.header);
+      LOG_GENERAL(WARNING, "Submit header: " << header);
+      return FAIL_RESULT;
+    }
+    if (boundary != m_curWork.boundary) {
+      LOG_GENERAL(WARNING, "Submit boundary diff with current work");
+      LOG_GENERAL(WARNING, "Current boundary: " << m_curWork.boundary);
+      LOG_GENERAL(WARNING, "Submit boundary: " << boundary);
+      return FAIL_RESULT;
+    }
+    if (m_submittedNonces.count(winning_nonce) > 0) {
+      LOG_GENERAL(WARNING, "Nonce " << nonce << " already submitted");
+      return FAIL_RESULT;
+    }
+    blocknum = m_curWork.blocknum;
   }
 
+  // Shares are verified without holding the work, so that miners submitting
+  // at once do not wait on each other
+  const auto headerHash = POW::StringToBlockhash(header);
+  const auto mixHash = POW::StringToBlockhash(mixdigest);
+  const auto boundaryHash = POW::StringToBlockhash(boundary);
   ethash_hash256 final_result;
-  if (!POW::GetInstance().VerifyRemoteSoln(
-          m_curWork.blocknum, POW::StringToBlockhash(boundary), winning_nonce,
-          POW::StringToBlockhash(header), POW::StringToBlockhash(mixdigest),
-          final_result)) {
+  if (!POW::GetInstance().VerifyRemoteSoln(blocknum, boundaryHash,
+                                           winning_nonce, headerHash, mixHash,
+                                           final_result)) {
     LOG_GENERAL(WARNING, "Failed to verify PoW result from miner.");
     return FAIL_RESULT;
   }
 
+  {
+    lock_guard<mutex> g(m_mutexWork);
+    if (header != m_curWork.header) {
+      LOG_GENERAL(WARNING, "Work changed while verifying the submit");
+      return FAIL_RESULT;
+    }
+    if (!m_submittedNonces.emplace(winning_nonce).second) {
+      LOG_GENERAL(WARNING, "Nonce " << nonce << " already submitted");
+      return FAIL_RESULT;
+    }
+  }
+
   return ethash_mining_result_t{POW::BlockhashToHexString(final_result),
                                 mixdigest, winning_nonce, true};
 }
@@ -206,17 +278,38 @@ bool GetWorkServer::UpdateCurrentResult(
   return accept;
 }
 
+std::map<std::string, GetWorkMinerStats> GetWorkServer::GetMinerStats() {
+  lock_guard<mutex> g(m_mutexMinerStats);
+  return m_minerStats;
+}
+
+void GetWorkServer::UpdateMinerStats(const string& miner_wallet,
+                                     const string& worker, bool accepted) {
+  lock_guard<mutex> g(m_mutexMinerStats);
+  const string key = miner_wallet + "." + worker;
+  auto it = m_minerStats.find(key);
+  if (it == m_minerStats.end()) {
+    if (m_minerStats.size() >= MAX_MINER_STATS) {
+      return;
+    }
+    it = m_minerStats.emplace(key, GetWorkMinerStats()).first;
+  }
+  if (accepted) {
+    ++it->second.acceptedShares;
+  } else {
+    ++it->second.rejectedShares;
+  }
+  it->second.lastSeen = chrono::system_clock::now();
+}
+
 //////////////////////////////////////////////////
 // RPC Methods
 //////////////////////////////////////////////////
 
-// ETH getWork Server
-Json::Value GetWorkServer::getWork() {
-  LOG_MARKER();
+// GetWorkJson returns the current work, m_mutexWork must be held
+Json::Value GetWorkServer::GetWorkJson() {
   Json::Value result;
 
-  lock_guard<mutex> g(m_mutexWork);
-
   result.append(m_isMining ? m_curWork.header : "");
   result.append(m_isMining ? m_curWork.seed : "");
   result.append(m_isMining ? m_curWork.boundary : "");
@@ -226,11 +319,51 @@ Json::Value GetWorkServer::getWork() {
   return result;
 }
 
+// ETH getWork Server
+Json::Value GetWorkServer::getWork() {
+  LOG_MARKER();
+
+  lock_guard<mutex> g(m_mutexWork);
+  return GetWorkJson();
+}
+
+Json::Value GetWorkServer::getWorkLongPoll(const string& _header) {
+  LOG_MARKER();
+
+  string header = _header;
+  if (!header.empty() && !DataConversion::NormalizeHexString(header)) {
+    LOG_GENERAL(WARNING, "Invalid header: " << _header);
+    header.clear();
+  }
+
+  unique_lock<mutex> lk(m_mutexWork);
+  m_cvWork.wait_for(lk, chrono::seconds(GETWORK_LONG_POLL_SECONDS),
+                    [this, &header] {
+                      return (m_isMining ? m_curWork.header : "") != header;
+                    });
+  return GetWorkJson();
+}
+
+Json::Value GetWorkServer::getMinerStats() {
+  Json::Value result(Json::objectValue);
+  for (const auto& entry : GetMinerStats()) {
+    Json::Value stats;
+    stats["hashrate"] = Json::UInt64(entry.second.hashrate);
+    stats["acceptedShares"] = Json::UInt64(entry.second.acceptedShares);
+    stats["rejectedShares"] = Json::UInt64(entry.second.rejectedShares);
+    const auto lastSeen = chrono::duration_cast<chrono::seconds>(
+        entry.second.lastSeen.time_since_epoch());
+    stats["lastSeen"] = Json::Int64(lastSeen.count());
+    result[entry.first] = stats;
+  }
+  return result;
+}
+
 bool GetWorkServer::submitWork(const string& _nonce, const string& _header,
                                const string& _mixdigest,
                                const string& _boundary,
-                               [[gnu::unused]] const string& _miner_wallet,
-                               [[gnu::unused]] const string& _worker) {
+                               const string& _miner_wallet,
+                               const string& _worker) {
   LOG_MARKER();
 
   if (!m_isMining) {
@@ -258,13 +391,32 @@ bool GetWorkServer::submitWork(const string& _nonce, const string& _header,
   }
 
   auto result = VerifySubmit(nonce, header, mixdigest, boundary);
+  UpdateMinerStats(_miner_wallet, _worker, result.success);
 
   return UpdateCurrentResult(result);
-  ;
 }
 
-bool GetWorkServer::submitHashrate([[gnu::unused]] const string& hashrate,
-                                   [[gnu::unused]] const string& miner_wallet,
-                                   [[gnu::unused]] const string& worker) {
+bool GetWorkServer::submitHashrate(const string& hashrate,
+                                   const string& miner_wallet,
+                                   const string& worker) {
+  string rate = hashrate;
+  uint64_t value = 0;
+  if (!DataConversion::NormalizeHexString(rate) ||
+      !DataConversion::HexStringToUint64(rate, &value)) {
+    LOG_GENERAL(WARNING, "Invalid hashrate: " << hashrate);
+    return false;
+  }
+
+  lock_guard<mutex> g(m_mutexMinerStats);
+  const string key = miner_wallet + "." + worker;
+  auto it = m_minerStats.find(key);
+  if (it == m_minerStats.end()) {
+    if (m_minerStats.size() >= MAX_MINER_STATS) {
+      return false;
+    }
+    it = m_minerStats.emplace(key, GetWorkMinerStats()).first;
+  }
+  it->second.hashrate = value;
+  it->second.lastSeen = chrono::system_clock::now();
   return true;
 }
@@ -19,6 +19,11 @@
 #define __GETWORK_SERVER_H__
 
 #include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_set>
 
 #include "jsonrpccpp/server.h"
 #include "jsonrpccpp/server/abstractserverconnector.h"
@@ -40,6 +45,19 @@ class AbstractStubServer : public jsonrpc::AbstractServer<AbstractStubServer> {
                            jsonrpc::JSON_ARRAY, NULL),
         &AbstractStubServer::getWorkI);
 
+    // Answers as eth_getWork, once the work differs from header or after
+    // GETWORK_LONG_POLL_SECONDS
+    this->bindAndAddMethod(
+        jsonrpc::Procedure("eth_getWorkLongPoll", jsonrpc::PARAMS_BY_POSITION,
+                           jsonrpc::JSON_ARRAY, "header", jsonrpc::JSON_STRING,
+                           NULL),
+        &AbstractStubServer::getWorkLongPollI);
+
+    this->bindAndAddMethod(
+        jsonrpc::Procedure("eth_getMinerStats", jsonrpc::PARAMS_BY_POSITION,
+                           jsonrpc::JSON_OBJECT, NULL),
+        &AbstractStubServer::getMinerStatsI);
+
     this->bindAndAddMethod(
         jsonrpc::Procedure("eth_submitHashrate", jsonrpc::PARAMS_BY_POSITION,
                            jsonrpc::JSON_BOOLEAN, "Hashrate",
@@ -63,6 +81,15 @@ class AbstractStubServer : public jsonrpc::AbstractServer<AbstractStubServer> {
     (void)request;
     response = this->getWork();
   }
+  inline virtual void getWorkLongPollI(const Json::Value &request,
+                                       Json::Value &response) {
+    response = this->getWorkLongPoll(request[0u].asString());
+  }
+  inline virtual void getMinerStatsI(const Json::Value &request,
+                                     Json::Value &response) {
+    (void)request;
+    response = this->getMinerStats();
+  }
   inline virtual void submitHashrateI(const Json::Value &request,
                                       Json::Value &response) {
     response = this->submitHashrate(
@@ -76,6 +103,8 @@ class AbstractStubServer : public jsonrpc::AbstractServer<AbstractStubServer> {
   }
 
   virtual Json::Value getWork() = 0;
+  virtual Json::Value getWorkLongPoll(const std::string &header) = 0;
+  virtual Json::Value getMinerStats() = 0;
   virtual bool submitHashrate(const std::string &hashrate,
                               const std::string &miner_wallet,
                               const std::string &worker) = 0;
@@ -97,6 +126,15 @@ struct PoWWorkPackage {
   uint8_t difficulty;
 };
 
+/// What the server saw of one worker of a miner wallet
+struct GetWorkMinerStats {
+  /// hashes per second, as last reported by eth_submitHashrate
+  uint64_t hashrate{0};
+  uint64_t acceptedShares{0};
+  uint64_t rejectedShares{0};
+  std::chrono::system_clock::time_point lastSeen;
+};
+
 // Implement AbstractStubServer
 class GetWorkServer : public AbstractStubServer {
   // Constructor
@@ -116,6 +154,18 @@ class GetWorkServer : public AbstractStubServer {
 
   PoWWorkPackage m_curWork;
   std::mutex m_mutexWork;
+  /// notified when the work changes, for eth_getWorkLongPoll
+  std::condition_variable m_cvWork;
+  /// nonces submitted for m_curWork, to turn repeated shares away unverified
+  std::unordered_set<uint64_t> m_submittedNonces;
+
+  /// keyed by "<miner_wallet>.<worker>"
+  std::map<std::string, GetWorkMinerStats> m_minerStats;
+  std::mutex m_mutexMinerStats;
+
+  Json::Value GetWorkJson();
+  void UpdateMinerStats(const std::string &miner_wallet,
+                        const std::string &worker, bool accepted);
 
   ethash_mining_result_t m_curResult;
   std::mutex m_mutexResult;
@@ -148,8 +198,12 @@ class GetWorkServer : public AbstractStubServer {
 
   bool UpdateCurrentResult(const ethash_mining_result_t &newResult);
 
+  std::map<std::string, GetWorkMinerStats> GetMinerStats();
+
   // RPC methods
   virtual Json::Value getWork();
+  virtual Json::Value getWorkLongPoll(const std::string &header);
+  virtual Json::Value getMinerStats();
   virtual bool submitHashrate(const std::string &hashrate,
                               const std::string &miner_wallet,
                               const std::string &worker);
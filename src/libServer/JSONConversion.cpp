@@ -124,6 +124,80 @@ const Json::Value JSONConversion::convertDSblocktoJson(const DSBlock& dsblock) {
   return ret;
 }
 
+bool JSONConversion::writeTxBlock(const TxBlock& txblock, JSONWriter& writer) {
+  const TxBlockHeader& txheader = txblock.GetHeader();
+
+  std::string HeaderSignStr;
+  if (!DataConversion::SerializableToHexStr(txblock.GetCS2(), HeaderSignStr)) {
+    return false;
+  }
+
+  writer.BeginObject();
+  writer.Key("body").BeginObject();
+  writer.Key("HeaderSign").String(HeaderSignStr);
+  writer.Key("MicroBlockInfos").BeginArray();
+  for (auto const& i : txblock.GetMicroBlockInfos()) {
+    writer.BeginObject();
+    writer.Key("MicroBlockHash").String(i.m_microBlockHash.hex());
+    writer.Key("MicroBlockShardId").UInt(i.m_shardId);
+    writer.Key("MicroBlockTxnRootHash").String(i.m_txnRootHash.hex());
+    writer.EndObject();
+  }
+  writer.EndArray();
+  writer.EndObject();
+
+  writer.Key("header").BeginObject();
+  writer.Key("BlockNum").String(to_string(txheader.GetBlockNum()));
+  writer.Key("DSBlockNum").String(to_string(txheader.GetDSBlockNum()));
+  writer.Key("GasLimit").String(to_string(txheader.GetGasLimit()));
+  writer.Key("GasUsed").String(to_string(txheader.GetGasUsed()));
+  writer.Key("MbInfoHash").String(txheader.GetMbInfoHash().hex());
+  writer.Key("MinerPubKey")
+      .String(static_cast<string>(txheader.GetMinerPubKey()));
+  writer.Key("NumMicroBlocks").UInt(txblock.GetMicroBlockInfos().size());
+  writer.Key("NumTxns").UInt(txheader.GetNumTxs());
+  writer.Key("PrevBlockHash").String(txheader.GetPrevHash().hex());
+  writer.Key("Rewards").String(txheader.GetRewards().str());
+  writer.Key("StateDeltaHash").String(txheader.GetStateDeltaHash().hex());
+  writer.Key("StateRootHash").String(txheader.GetStateRootHash().hex());
+  writer.Key("Timestamp").String(to_string(txblock.GetTimestamp()));
+  writer.Key("Version").UInt(txheader.GetVersion());
+  writer.EndObject();
+  writer.EndObject();
+
+  return true;
+}
+
+bool JSONConversion::writeDSblock(const DSBlock& dsblock, JSONWriter& writer) {
+  const DSBlockHeader& dshead = dsblock.GetHeader();
+
+  string retSigstr;
+  if (!DataConversion::SerializableToHexStr(dsblock.GetCS2(), retSigstr)) {
+    return false;
+  }
+
+  writer.BeginObject();
+  writer.Key("header").BeginObject();
+  writer.Key("BlockNum").String(to_string(dshead.GetBlockNum()));
+  writer.Key("Difficulty").UInt(dshead.GetDifficulty());
+  writer.Key("DifficultyDS").UInt(dshead.GetDSDifficulty());
+  writer.Key("GasPrice").String(dshead.GetGasPrice().str());
+  writer.Key("LeaderPubKey")
+      .String(static_cast<string>(dshead.GetLeaderPubKey()));
+  writer.Key("PoWWinners").BeginArray();
+  for (const auto& dswinner : dshead.GetDSPoWWinners()) {
+    writer.String(static_cast<string>(dswinner.first));
+  }
+  writer.EndArray();
+  writer.Key("PrevHash").String(dshead.GetPrevHash().hex());
+  writer.Key("Timestamp").String(to_string(dsblock.GetTimestamp()));
+  writer.EndObject();
+  writer.Key("signature").String(retSigstr);
+  writer.EndObject();
+
+  return true;
+}
+
 const Transaction JSONConversion::convertJsontoTx(const Json::Value& _json) {
   uint32_t version = _json["version"].asUInt();
 
@@ -24,6 +24,7 @@
 
 #include "libData/BlockData/Block.h"
 #include "libData/BlockData/BlockHeader/BlockHashSet.h"
+#include "libServer/JSONWriter.h"
 
 class JSONConversion {
  public:
@@ -34,6 +35,10 @@ class JSONConversion {
   static const Json::Value convertTxBlocktoJson(const TxBlock& txblock);
   // converts a DSBlocck to JSON object
   static const Json::Value convertDSblocktoJson(const DSBlock& dsblock);
+  // writes a TxBlock as the JSON of convertTxBlocktoJson
+  static bool writeTxBlock(const TxBlock& txblock, JSONWriter& writer);
+  // writes a DSBlock as the JSON of convertDSblocktoJson
+  static bool writeDSblock(const DSBlock& dsblock, JSONWriter& writer);
   // converts a JSON to Tx
   static const Transaction convertJsontoTx(const Json::Value& _json);
   // check if a Json is a valid Tx
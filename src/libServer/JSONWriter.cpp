@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "JSONWriter.h"
+
+using namespace std;
+
+void JSONWriter::BeginItem() {
+  if (m_afterKey) {
+    m_afterKey = false;
+    return;
+  }
+  if (!m_empty.empty()) {
+    if (!m_empty.back()) {
+      m_out += ',';
+    }
+    m_empty.back() = false;
+  }
+}
+
+JSONWriter& JSONWriter::BeginObject() {
+  BeginItem();
+  m_out += '{';
+  m_empty.push_back(true);
+  return *this;
+}
+
+JSONWriter& JSONWriter::EndObject() {
+  m_out += '}';
+  m_empty.pop_back();
+  return *this;
+}
+
+JSONWriter& JSONWriter::BeginArray() {
+  BeginItem();
+  m_out += '[';
+  m_empty.push_back(true);
+  return *this;
+}
+
+JSONWriter& JSONWriter::EndArray() {
+  m_out += ']';
+  m_empty.pop_back();
+  return *this;
+}
+
+JSONWriter& JSONWriter::Key(const string& key) {
+  String(key);
+  m_out += ':';
+  m_afterKey = true;
+  return *this;
+}
+
+JSONWriter& JSONWriter::String(const string& value) {
+  static const char* DIGITS = "0123456789abcdef";
+
+  BeginItem();
+  m_out += '"';
+  for (const char c : value) {
+    switch (c) {
+      case '"':
+        m_out += "\\\"";
+        break;
+      case '\\':
+        m_out += "\\\\";
+        break;
+      case '\b':
+        m_out += "\\b";
+        break;
+      case '\f':
+        m_out += "\\f";
+        break;
+      case '\n':
+        m_out += "\\n";
+        break;
+      case '\r':
+        m_out += "\\r";
+        break;
+      case '\t':
+        m_out += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          m_out += "\\u00";
+          m_out += DIGITS[(c >> 4) & 0x0F];
+          m_out += DIGITS[c & 0x0F];
+        } else {
+          m_out += c;
+        }
+    }
+  }
+  m_out += '"';
+  return *this;
+}
+
+JSONWriter& JSONWriter::UInt(uint64_t value) {
+  BeginItem();
+  m_out += to_string(value);
+  return *this;
+}
+
+JSONWriter& JSONWriter::Null() {
+  BeginItem();
+  m_out += "null";
+  return *this;
+}
+
+JSONWriter& JSONWriter::Raw(const string& json) {
+  BeginItem();
+  m_out += json;
+  return *this;
+}
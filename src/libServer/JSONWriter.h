@@ -0,0 +1,56 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __JSONWRITER_H__
+#define __JSONWRITER_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/// Appends compact json text to a string as it is written, for responses
+/// that would otherwise be built as a Json::Value only to be written out.
+/// The caller writes the members of objects in the order of their keys, as
+/// Json::Value does.
+class JSONWriter {
+  std::string& m_out;
+  /// Whether each open array or object has no items yet
+  std::vector<bool> m_empty;
+  bool m_afterKey = false;
+
+  void BeginItem();
+
+ public:
+  explicit JSONWriter(std::string& out) : m_out(out) {}
+
+  JSONWriter& BeginObject();
+  JSONWriter& EndObject();
+  JSONWriter& BeginArray();
+  JSONWriter& EndArray();
+
+  /// Writes the key of the next member of the open object
+  JSONWriter& Key(const std::string& key);
+
+  JSONWriter& String(const std::string& value);
+  JSONWriter& UInt(uint64_t value);
+  JSONWriter& Null();
+
+  /// Writes text that is already json, such as a value that was cached
+  JSONWriter& Raw(const std::string& json);
+};
+
+#endif  // __JSONWRITER_H__
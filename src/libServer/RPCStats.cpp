@@ -0,0 +1,162 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <boost/algorithm/string.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "RPCStats.h"
+#include "common/Constants.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+
+RPCStats::RPCStats() : m_clientRate(RPC_CLIENT_RATE_LIMIT) {
+  ParseRateLimits(RPC_METHOD_RATE_LIMITS, m_methodRates);
+}
+
+RPCStats& RPCStats::GetInstance() {
+  static RPCStats stats;
+  return stats;
+}
+
+void RPCStats::ParseRateLimits(const string& config,
+                               unordered_map<string, double>& rates) {
+  vector<string> items;
+  boost::split(items, config, boost::is_any_of(","));
+  for (auto& item : items) {
+    boost::trim(item);
+    if (item.empty()) {
+      continue;
+    }
+
+    const size_t pos = item.find(':');
+    if (pos == string::npos) {
+      LOG_GENERAL(WARNING, "Rate limit " << item << " has no rate");
+      continue;
+    }
+    try {
+      rates[boost::trim_copy(item.substr(0, pos))] =
+          boost::lexical_cast<double>(boost::trim_copy(item.substr(pos + 1)));
+    } catch (const boost::bad_lexical_cast&) {
+      LOG_GENERAL(WARNING, "Rate limit " << item << " is not a number");
+    }
+  }
+}
+
+RPCStats::Entry& RPCStats::GetEntry(const string& method) {
+  {
+    shared_lock<shared_timed_mutex> lock(m_mutexEntries);
+    auto it = m_entries.find(method);
+    if (it != m_entries.end()) {
+      return *it->second;
+    }
+  }
+
+  unique_lock<shared_timed_mutex> lock(m_mutexEntries);
+  auto& entry = m_entries[method];
+  if (entry == nullptr) {
+    entry = make_unique<Entry>();
+  }
+  return *entry;
+}
+
+bool RPCStats::Admit(const string& clientAddress,
+                     const vector<string>& methods) {
+  if (!m_clientLimiter.TryAcquire(clientAddress, m_clientRate)) {
+    m_rejectedClients++;
+    return false;
+  }
+
+  for (const auto& method : methods) {
+    auto it = m_methodRates.find(method);
+    if (it != m_methodRates.end() &&
+        !m_methodLimiter.TryAcquire(method, it->second)) {
+      GetEntry(method).m_rejected++;
+      return false;
+    }
+  }
+  return true;
+}
+
+void RPCStats::RecordStart(const string& method) {
+  GetEntry(method).m_inFlight++;
+}
+
+void RPCStats::RecordEnd(const string& method, uint64_t latencyUs,
+                         bool failed) {
+  Entry& entry = GetEntry(method);
+  entry.m_inFlight--;
+  entry.m_calls++;
+  if (failed) {
+    entry.m_failed++;
+  }
+  entry.m_latencyUs += latencyUs;
+  entry.m_latencyHist[MessageStats::GetHistogramBucket(latencyUs)]++;
+}
+
+bool RPCStats::GetSnapshot(const string& method, Snapshot& snapshot) const {
+  shared_lock<shared_timed_mutex> lock(m_mutexEntries);
+  auto it = m_entries.find(method);
+  if (it == m_entries.end()) {
+    return false;
+  }
+
+  const Entry& entry = *it->second;
+  snapshot.m_calls = entry.m_calls;
+  snapshot.m_failed = entry.m_failed;
+  snapshot.m_rejected = entry.m_rejected;
+  snapshot.m_inFlight = entry.m_inFlight;
+  snapshot.m_latencyUs = entry.m_latencyUs;
+  for (unsigned int i = 0; i < MessageStats::NUM_HISTOGRAM_BUCKETS; i++) {
+    snapshot.m_latencyHist[i] = entry.m_latencyHist[i];
+  }
+  return true;
+}
+
+Json::Value RPCStats::GetStatsJson() const {
+  vector<string> methods;
+  {
+    shared_lock<shared_timed_mutex> lock(m_mutexEntries);
+    for (const auto& entry : m_entries) {
+      methods.emplace_back(entry.first);
+    }
+  }
+
+  Json::Value _json;
+  _json["rejectedClients"] = to_string(m_rejectedClients);
+  _json["methods"] = Json::objectValue;
+  for (const auto& method : methods) {
+    Snapshot snapshot;
+    if (!GetSnapshot(method, snapshot)) {
+      continue;
+    }
+
+    Json::Value tmpJson;
+    tmpJson["calls"] = to_string(snapshot.m_calls);
+    tmpJson["failed"] = to_string(snapshot.m_failed);
+    tmpJson["rejected"] = to_string(snapshot.m_rejected);
+    tmpJson["inFlight"] = to_string(snapshot.m_inFlight);
+    tmpJson["latencyUs"] = to_string(snapshot.m_latencyUs);
+    // Bucket i counts latencies in [2^(i-1), 2^i) us, as in MessageStats
+    tmpJson["latencyHist"] = Json::arrayValue;
+    for (const auto& count : snapshot.m_latencyHist) {
+      tmpJson["latencyHist"].append(to_string(count));
+    }
+    _json["methods"][method] = tmpJson;
+  }
+  return _json;
+}
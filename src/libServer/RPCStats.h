@@ -0,0 +1,101 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RPCSTATS_H__
+#define __RPCSTATS_H__
+
+#include <json/json.h>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "libNetwork/MessageStats.h"
+#include "libUtils/RateLimiter.h"
+
+/// Per JSON-RPC method counters of calls, failures, calls in flight and
+/// latency, and the admission control in front of the request queues: the
+/// per-method limits of RPC_METHOD_RATE_LIMITS and the per-client limit of
+/// RPC_CLIENT_RATE_LIMIT. A request over a limit is turned away before it is
+/// queued, so that expensive reads cannot delay CreateTransaction.
+class RPCStats {
+ public:
+  struct Snapshot {
+    uint64_t m_calls = 0;
+    uint64_t m_failed = 0;
+    uint64_t m_rejected = 0;
+    uint64_t m_inFlight = 0;
+    uint64_t m_latencyUs = 0;
+    MessageStats::Histogram m_latencyHist{};
+  };
+
+ private:
+  struct Entry {
+    std::atomic<uint64_t> m_calls{0};
+    std::atomic<uint64_t> m_failed{0};
+    std::atomic<uint64_t> m_rejected{0};
+    std::atomic<uint64_t> m_inFlight{0};
+    std::atomic<uint64_t> m_latencyUs{0};
+    std::atomic<uint64_t> m_latencyHist[MessageStats::NUM_HISTOGRAM_BUCKETS]{};
+  };
+
+  mutable std::shared_timed_mutex m_mutexEntries;
+  std::map<std::string, std::unique_ptr<Entry>> m_entries;
+
+  std::unordered_map<std::string, double> m_methodRates;
+  const double m_clientRate;
+  RateLimiter m_methodLimiter;
+  RateLimiter m_clientLimiter;
+  std::atomic<uint64_t> m_rejectedClients{0};
+
+  RPCStats();
+  ~RPCStats() = default;
+
+  // Singleton should not implement these
+  RPCStats(RPCStats const&) = delete;
+  void operator=(RPCStats const&) = delete;
+
+  Entry& GetEntry(const std::string& method);
+
+ public:
+  /// Returns the singleton RPCStats instance.
+  static RPCStats& GetInstance();
+
+  /// Parses "method:calls per second,..." into rates, skipping bad entries
+  static void ParseRateLimits(const std::string& config,
+                              std::unordered_map<std::string, double>& rates);
+
+  /// Returns false, counting the rejection, if the client or one of the
+  /// methods of its request went over its rate limit
+  bool Admit(const std::string& clientAddress,
+             const std::vector<std::string>& methods);
+
+  void RecordStart(const std::string& method);
+
+  void RecordEnd(const std::string& method, uint64_t latencyUs, bool failed);
+
+  /// Returns false if nothing was recorded for this method
+  bool GetSnapshot(const std::string& method, Snapshot& snapshot) const;
+
+  /// All the methods seen so far, with their counters and latency histograms
+  Json::Value GetStatsJson() const;
+};
+
+#endif  // __RPCSTATS_H__
@@ -25,6 +25,7 @@
 #pragma GCC diagnostic pop
 #include <iostream>
 
+#include "RPCStats.h"
 #include "Server.h"
 #include "common/Messages.h"
 #include "common/Serializable.h"
@@ -32,38 +33,45 @@
 #include "libCrypto/Sha2.h"
 #include "libData/AccountData/Account.h"
 #include "libData/AccountData/AccountStore.h"
+#include "libData/AccountData/ContractProfiler.h"
 #include "libData/AccountData/Transaction.h"
+#include "libLookup/Lookup.h"
 #include "libMediator/Mediator.h"
 #include "libMessage/Messenger.h"
 #include "libNetwork/P2PComm.h"
 #include "libNetwork/Peer.h"
 #include "libPersistence/BlockStorage.h"
+#include "libPersistence/ContractStorage.h"
 #include "libUtils/DetachedFunction.h"
 #include "libUtils/Logger.h"
+#include "libUtils/MemoryStats.h"
 #include "libUtils/TimeUtils.h"
+#include "libUtils/Tracing.h"
 
 using namespace jsonrpc;
 using namespace std;
 
-CircularArray<std::string> Server::m_RecentTransactions;
-std::mutex Server::m_mutexRecentTxns;
-
 const unsigned int PAGE_SIZE = 10;
 const unsigned int NUM_PAGES_CACHE = 2;
 const unsigned int TXN_PAGE_SIZE = 100;
+const unsigned int STATE_PAGE_SIZE = 100;
+
+SeqLockRing<dev::h256> Server::m_RecentTransactions(TXN_PAGE_SIZE);
 
 //[warning] do not make this constant too big as it loops over blockchain
 const unsigned int REF_BLOCK_DIFF = 1;
 
 Server::Server(Mediator& mediator, AbstractServerConnector& server)
-    : AbstractZServer(server), m_mediator(mediator) {
+    : AbstractZServer(server),
+      m_mediator(mediator),
+      m_responseCache(RPC_RESPONSE_CACHE_SIZE),
+      m_renderedCache(RPC_RESPONSE_CACHE_SIZE) {
   m_StartTimeTx = 0;
   m_StartTimeDs = 0;
   m_DSBlockCache.first = 0;
   m_DSBlockCache.second.resize(NUM_PAGES_CACHE * PAGE_SIZE);
   m_TxBlockCache.first = 0;
   m_TxBlockCache.second.resize(NUM_PAGES_CACHE * PAGE_SIZE);
-  m_RecentTransactions.resize(TXN_PAGE_SIZE);
   m_TxBlockCountSumPair.first = 0;
   m_TxBlockCountSumPair.second = 0;
 }
@@ -72,6 +80,22 @@ Server::~Server(){
     // destructor
 };
 
+void Server::HandleMethodCall(jsonrpc::Procedure& proc,
+                              const Json::Value& input, Json::Value& output) {
+  const string& method = proc.GetProcedureName();
+  RPCStats& stats = RPCStats::GetInstance();
+
+  stats.RecordStart(method);
+  auto startTime = r_timer_start();
+  try {
+    AbstractZServer::HandleMethodCall(proc, input, output);
+  } catch (...) {
+    stats.RecordEnd(method, r_timer_end(startTime), true);
+    throw;
+  }
+  stats.RecordEnd(method, r_timer_end(startTime), false);
+}
+
 string Server::GetNetworkId() {
   if (!LOOKUP_NODE_MODE) {
     throw JsonRpcException(RPC_INVALID_REQUEST, "Sent to a non-lookup");
@@ -113,22 +137,14 @@ bool Server::StartCollectorThread() {
       }
       // LOG_GENERAL(INFO, "Size of txns " << txns.size());
 
-      bool hasTxn = false;
-
-      for (auto const& i :
-           {SEND_TYPE::ARCHIVAL_SEND_SHARD, SEND_TYPE::ARCHIVAL_SEND_DS}) {
-        {
-          lock_guard<mutex> g(m_mediator.m_lookup->m_txnShardMapMutex);
-          if (m_mediator.m_lookup->m_txnShardMap.find(i) ==
-                  m_mediator.m_lookup->m_txnShardMap.end() ||
-              m_mediator.m_lookup->m_txnShardMap.at(i).empty()) {
-            continue;
-          }
-          hasTxn = true;
-        }
-      }
+      vector<Transaction> shardTxns;
+      vector<Transaction> dsTxns;
+      m_mediator.m_lookup->TakeTxnShardMap(SEND_TYPE::ARCHIVAL_SEND_SHARD,
+                                           shardTxns);
+      m_mediator.m_lookup->TakeTxnShardMap(SEND_TYPE::ARCHIVAL_SEND_DS,
+                                           dsTxns);
 
-      if (!hasTxn) {
+      if (shardTxns.empty() && dsTxns.empty()) {
         LOG_GENERAL(INFO, "No Txns to send for this seed node");
         continue;
       }
@@ -138,29 +154,35 @@ bool Server::StartCollectorThread() {
       auto upperLayerNodes = m_mediator.m_lookup->GetAboveLayer();
       auto upperLayerNode = upperLayerNodes.at(rand() % upperLayerNodes.size());
 
-      if (!Messenger::SetForwardTxnBlockFromSeed(
-              msg, MessageOffset::BODY,
-              m_mediator.m_lookup
-                  ->m_txnShardMap[SEND_TYPE::ARCHIVAL_SEND_SHARD],
-              m_mediator.m_lookup
-                  ->m_txnShardMap[SEND_TYPE::ARCHIVAL_SEND_DS])) {
+      if (!Messenger::SetForwardTxnBlockFromSeed(msg, MessageOffset::BODY,
+                                                 shardTxns, dsTxns)) {
+        m_mediator.m_lookup->RestoreTxnShardMap(SEND_TYPE::ARCHIVAL_SEND_SHARD,
+                                                shardTxns);
+        m_mediator.m_lookup->RestoreTxnShardMap(SEND_TYPE::ARCHIVAL_SEND_DS,
+                                                dsTxns);
         continue;
       }
 
       LOG_GENERAL(INFO, "Sent to " << upperLayerNode);
 
       P2PComm::GetInstance().SendMessage(upperLayerNode, msg);
-
-      for (auto const& i :
-           {SEND_TYPE::ARCHIVAL_SEND_SHARD, SEND_TYPE::ARCHIVAL_SEND_DS}) {
-        m_mediator.m_lookup->DeleteTxnShardMap(i);
-      }
     }
   };
-  DetachedFunction(1, collectorThread);
+  DetachedFunction(DetachedFunction::Lane::BLOCKING, 1, collectorThread);
   return true;
 }
 
+void Server::AdmitTxn(const Transaction& tx, uint32_t shardId) {
+  switch (m_mediator.m_lookup->AdmitTxn(tx, shardId)) {
+    case TxnAdmission::QUEUED:
+      return;
+    case TxnAdmission::DUPLICATE:
+      throw JsonRpcException(RPC_VERIFY_REJECTED, "Txn already received");
+    case TxnAdmission::BUSY:
+      throw JsonRpcException(RPC_IN_WARMUP, "Too many txns awaiting checks");
+  }
+}
+
 Json::Value Server::CreateTransaction(const Json::Value& _json) {
   LOG_MARKER();
 
@@ -195,17 +217,13 @@ Json::Value Server::CreateTransaction(const Json::Value& _json) {
                                      .convert_to<string>());
     }
 
-    if (!m_mediator.m_validator->VerifyTransaction(tx)) {
-      throw JsonRpcException(RPC_VERIFY_REJECTED,
-                             "Unable to verify transaction");
-    }
-
     // LOG_GENERAL(INFO, "Nonce: "<<tx.GetNonce().str()<<" toAddr:
     // "<<tx.GetToAddr().hex()<<" senderPubKey:
     // "<<static_cast<string>(tx.GetSenderPubKey());<<" amount:
     // "<<tx.GetAmount().str());
 
-    unsigned int num_shards = m_mediator.m_lookup->GetShardPeers().size();
+    unsigned int num_shards =
+        m_mediator.m_lookup->GetShardPeers()->GetNumShards();
 
     const PubKey& senderPubKey = tx.GetSenderPubKey();
     const Address fromAddr = Account::GetAddressFromPublicKey(senderPubKey);
@@ -231,10 +249,9 @@ Json::Value Server::CreateTransaction(const Json::Value& _json) {
     switch (GetTransactionType(tx)) {
       case NON_CONTRACT:
         if (!ARCHIVAL_LOOKUP) {
-          m_mediator.m_lookup->AddToTxnShardMap(tx, shard);
+          AdmitTxn(tx, shard);
         } else {
-          m_mediator.m_lookup->AddToTxnShardMap(tx,
-                                                SEND_TYPE::ARCHIVAL_SEND_SHARD);
+          AdmitTxn(tx, SEND_TYPE::ARCHIVAL_SEND_SHARD);
         }
         ret["Info"] = "Non-contract txn, sent to shard";
         ret["TranID"] = tx.GetTranID().hex();
@@ -246,10 +263,9 @@ Json::Value Server::CreateTransaction(const Json::Value& _json) {
           return ret;
         }
         if (!ARCHIVAL_LOOKUP) {
-          m_mediator.m_lookup->AddToTxnShardMap(tx, shard);
+          AdmitTxn(tx, shard);
         } else {
-          m_mediator.m_lookup->AddToTxnShardMap(tx,
-                                                SEND_TYPE::ARCHIVAL_SEND_SHARD);
+          AdmitTxn(tx, SEND_TYPE::ARCHIVAL_SEND_SHARD);
         }
         ret["Info"] = "Contract Creation txn, sent to shard";
         ret["TranID"] = tx.GetTranID().hex();
@@ -282,10 +298,9 @@ Json::Value Server::CreateTransaction(const Json::Value& _json) {
         }
         if ((to_shard == shard) && !sendToDs) {
           if (!ARCHIVAL_LOOKUP) {
-            m_mediator.m_lookup->AddToTxnShardMap(tx, shard);
+            AdmitTxn(tx, shard);
           } else {
-            m_mediator.m_lookup->AddToTxnShardMap(
-                tx, SEND_TYPE::ARCHIVAL_SEND_SHARD);
+            AdmitTxn(tx, SEND_TYPE::ARCHIVAL_SEND_SHARD);
           }
           ret["Info"] =
               "Contract Txn, Shards Match of the sender "
@@ -293,10 +308,9 @@ Json::Value Server::CreateTransaction(const Json::Value& _json) {
           ret["TranID"] = tx.GetTranID().hex();
         } else {
           if (!ARCHIVAL_LOOKUP) {
-            m_mediator.m_lookup->AddToTxnShardMap(tx, num_shards);
+            AdmitTxn(tx, num_shards);
           } else {
-            m_mediator.m_lookup->AddToTxnShardMap(tx,
-                                                  SEND_TYPE::ARCHIVAL_SEND_DS);
+            AdmitTxn(tx, SEND_TYPE::ARCHIVAL_SEND_DS);
           }
           ret["Info"] = "Contract Txn, Sent To Ds";
           ret["TranID"] = tx.GetTranID().hex();
@@ -351,6 +365,12 @@ Json::Value Server::GetTransaction(const string& transactionHash) {
     if (transactionHash.size() != TRAN_HASH_SIZE * 2) {
       throw JsonRpcException(RPC_INVALID_PARAMS, "Size not appropriate");
     }
+    const string cacheKey = "txn:" + tranHash.hex();
+    Json::Value cached;
+    if (m_responseCache.Get(cacheKey, cached)) {
+      return cached;
+    }
+
     bool isPresent = BlockStorage::GetBlockStorage().GetTxBody(tranHash, tptr);
     bool isPresentHistorical = false;
     if (m_mediator.m_lookup->m_historicalDB && !isPresent) {
@@ -359,8 +379,9 @@ Json::Value Server::GetTransaction(const string& transactionHash) {
                                                                  tptr);
     }
     if (isPresentHistorical || isPresent) {
-      Json::Value _json;
-      return JSONConversion::convertTxtoJson(*tptr);
+      Json::Value _json = JSONConversion::convertTxtoJson(*tptr);
+      m_responseCache.Put(cacheKey, _json);
+      return _json;
     } else {
       throw JsonRpcException(RPC_DATABASE_ERROR, "Txn Hash not Present");
     }
@@ -379,8 +400,21 @@ Json::Value Server::GetDsBlock(const string& blockNum) {
 
   try {
     uint64_t BlockNum = stoull(blockNum);
-    return JSONConversion::convertDSblocktoJson(
+    const string cacheKey = "dsblock:" + to_string(BlockNum);
+    Json::Value _json;
+    if (m_responseCache.Get(cacheKey, _json)) {
+      return _json;
+    }
+
+    _json = JSONConversion::convertDSblocktoJson(
         m_mediator.m_dsBlockChain.GetBlock(BlockNum));
+    // Blocks not yet committed render as a dummy block, keep those out
+    if (BlockNum <= m_mediator.m_dsBlockChain.GetLastBlock()
+                        .GetHeader()
+                        .GetBlockNum()) {
+      m_responseCache.Put(cacheKey, _json);
+    }
+    return _json;
   } catch (const JsonRpcException& je) {
     throw je;
   } catch (runtime_error& e) {
@@ -405,8 +439,21 @@ Json::Value Server::GetTxBlock(const string& blockNum) {
 
   try {
     uint64_t BlockNum = stoull(blockNum);
-    return JSONConversion::convertTxBlocktoJson(
+    const string cacheKey = "txblock:" + to_string(BlockNum);
+    Json::Value _json;
+    if (m_responseCache.Get(cacheKey, _json)) {
+      return _json;
+    }
+
+    _json = JSONConversion::convertTxBlocktoJson(
         m_mediator.m_txBlockChain.GetBlock(BlockNum));
+    // Blocks not yet committed render as a dummy block, keep those out
+    if (BlockNum <= m_mediator.m_txBlockChain.GetLastBlock()
+                        .GetHeader()
+                        .GetBlockNum()) {
+      m_responseCache.Put(cacheKey, _json);
+    }
+    return _json;
   } catch (const JsonRpcException& je) {
     throw je;
   } catch (runtime_error& e) {
@@ -441,13 +488,22 @@ Json::Value Server::GetLatestDsBlock() {
   }
 
   LOG_MARKER();
-  DSBlock Latest = m_mediator.m_dsBlockChain.GetLastBlock();
+  const auto context = m_mediator.GetEpochContext();
+  const DSBlock& Latest = *context->m_lastDSBlock;
 
-  LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
+  LOG_EPOCH(INFO, context->m_epochNum,
             "BlockNum " << Latest.GetHeader().GetBlockNum()
                         << "  Timestamp:        " << Latest.GetTimestamp());
 
-  return JSONConversion::convertDSblocktoJson(Latest);
+  // Shares the entry of GetDsBlock, a new DS block moves it to a new key
+  const string cacheKey =
+      "dsblock:" + to_string(Latest.GetHeader().GetBlockNum());
+  Json::Value _json;
+  if (!m_responseCache.Get(cacheKey, _json)) {
+    _json = JSONConversion::convertDSblocktoJson(Latest);
+    m_responseCache.Put(cacheKey, _json);
+  }
+  return _json;
 }
 
 Json::Value Server::GetLatestTxBlock() {
@@ -457,13 +513,22 @@ Json::Value Server::GetLatestTxBlock() {
     throw JsonRpcException(RPC_INVALID_REQUEST, "Sent to a non-lookup");
   }
 
-  TxBlock Latest = m_mediator.m_txBlockChain.GetLastBlock();
+  const auto context = m_mediator.GetEpochContext();
+  const TxBlock& Latest = *context->m_lastTxBlock;
 
-  LOG_EPOCH(INFO, m_mediator.m_currentEpochNum,
+  LOG_EPOCH(INFO, context->m_epochNum,
             "BlockNum " << Latest.GetHeader().GetBlockNum()
                         << "  Timestamp:        " << Latest.GetTimestamp());
 
-  return JSONConversion::convertTxBlocktoJson(Latest);
+  // Shares the entry of GetTxBlock, a new Tx block moves it to a new key
+  const string cacheKey =
+      "txblock:" + to_string(Latest.GetHeader().GetBlockNum());
+  Json::Value _json;
+  if (!m_responseCache.Get(cacheKey, _json)) {
+    _json = JSONConversion::convertTxBlocktoJson(Latest);
+    m_responseCache.Put(cacheKey, _json);
+  }
+  return _json;
 }
 
 Json::Value Server::GetBalance(const string& address) {
@@ -484,17 +549,26 @@ Json::Value Server::GetBalance(const string& address) {
       throw JsonRpcException(RPC_INVALID_ADDRESS_OR_KEY, "invalid address");
     }
     Address addr(tmpaddr);
-    const Account* account = AccountStore::GetInstance().GetAccount(addr);
+
+    // As of the last committed block, without waiting on the next one to
+    // commit, unless no snapshot is published
+    AccountSnapshotEntry entry;
+    if (!AccountStore::GetInstance().GetAccountFromSnapshot(addr, entry)) {
+      const Account* account = AccountStore::GetInstance().GetAccount(addr);
+      if (account != nullptr) {
+        entry.m_balance = account->GetBalance();
+        entry.m_nonce = account->GetNonce();
+        entry.m_exists = true;
+      }
+    }
 
     Json::Value ret;
-    if (account != nullptr) {
-      boost::multiprecision::uint128_t balance = account->GetBalance();
-      uint64_t nonce = account->GetNonce();
-
-      ret["balance"] = balance.str();
-      ret["nonce"] = static_cast<unsigned int>(nonce);
-      LOG_GENERAL(INFO, "balance " << balance.str() << " nonce: " << nonce);
-    } else if (account == nullptr) {
+    if (entry.m_exists) {
+      ret["balance"] = entry.m_balance.str();
+      ret["nonce"] = static_cast<unsigned int>(entry.m_nonce);
+      LOG_GENERAL(INFO, "balance " << entry.m_balance.str()
+                                   << " nonce: " << entry.m_nonce);
+    } else {
       throw JsonRpcException(RPC_INVALID_ADDRESS_OR_KEY,
                              "Account is not created");
     }
@@ -775,11 +849,11 @@ string Server::GetNumTransactions() {
   lock_guard<mutex> g(m_mutexBlockTxPair);
 
   uint64_t currBlock =
-      m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum();
+      m_mediator.m_txBlockChain.GetLastBlockPtr()->GetHeader().GetBlockNum();
   if (m_BlockTxPair.first < currBlock) {
     for (uint64_t i = m_BlockTxPair.first + 1; i <= currBlock; i++) {
       m_BlockTxPair.second +=
-          m_mediator.m_txBlockChain.GetBlock(i).GetHeader().GetNumTxs();
+          m_mediator.m_txBlockChain.GetBlockPtr(i)->GetHeader().GetNumTxs();
     }
   }
   m_BlockTxPair.first = currBlock;
@@ -793,7 +867,7 @@ size_t Server::GetNumTransactions(uint64_t blockNum) {
   }
 
   uint64_t currBlockNum =
-      m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum();
+      m_mediator.m_txBlockChain.GetLastBlockPtr()->GetHeader().GetBlockNum();
 
   if (blockNum >= currBlockNum) {
     return 0;
@@ -802,7 +876,7 @@ size_t Server::GetNumTransactions(uint64_t blockNum) {
   size_t i, res = 0;
 
   for (i = blockNum + 1; i <= currBlockNum; i++) {
-    res += m_mediator.m_txBlockChain.GetBlock(i).GetHeader().GetNumTxs();
+    res += m_mediator.m_txBlockChain.GetBlockPtr(i)->GetHeader().GetNumTxs();
   }
 
   return res;
@@ -951,7 +1025,7 @@ string Server::GetCurrentDSEpoch() {
   LOG_MARKER();
 
   return to_string(
-      m_mediator.m_dsBlockChain.GetLastBlock().GetHeader().GetBlockNum());
+      m_mediator.GetEpochContext()->m_lastDSBlock->GetHeader().GetBlockNum());
 }
 
 Json::Value Server::DSBlockListing(unsigned int page) {
@@ -1169,25 +1243,35 @@ Json::Value Server::GetRecentTransactions() {
   if (!LOOKUP_NODE_MODE) {
     throw JsonRpcException(RPC_INVALID_REQUEST, "Sent to a non-lookup");
   }
-  lock_guard<mutex> g(m_mutexRecentTxns);
+  vector<TxnHash> txnHashes;
+  m_RecentTransactions.GetLatest(TXN_PAGE_SIZE, txnHashes);
+
   Json::Value _json;
-  uint64_t actualSize(m_RecentTransactions.capacity());
-  if (actualSize > m_RecentTransactions.size()) {
-    actualSize = m_RecentTransactions.size();
-  }
-  uint64_t size = m_RecentTransactions.size();
-  _json["number"] = uint(actualSize);
+  _json["number"] = uint(txnHashes.size());
   _json["TxnHashes"] = Json::Value(Json::arrayValue);
-  for (uint64_t i = 0; i < actualSize; i++) {
-    _json["TxnHashes"].append(m_RecentTransactions[size - i - 1]);
+  for (const auto& txnHash : txnHashes) {
+    _json["TxnHashes"].append(txnHash.hex());
   }
 
   return _json;
 }
 
 void Server::AddToRecentTransactions(const TxnHash& txhash) {
-  lock_guard<mutex> g(m_mutexRecentTxns);
-  m_RecentTransactions.insert_new(m_RecentTransactions.size(), txhash.hex());
+  m_RecentTransactions.Push(txhash);
+}
+
+void Server::AddToRecentTransactions(const vector<TxnHash>& txhashes) {
+  m_RecentTransactions.PushAll(txhashes);
+}
+
+const set<string>& Server::GetExpensiveMethods() {
+  static const set<string> methods{
+      "GetSmartContractState",     "GetSmartContractInit",
+      "GetSmartContractCode",      "GetSmartContracts",
+      "GetTransactionsForTxBlock", "GetTransactionsForAddress",
+      "GetSmartContractSubState",  "GetSmartContractSubStatePage",
+      "GetMemoryStats",            "GetEvents"};
+  return methods;
 }
 Json::Value Server::GetShardingStructure() {
   LOG_MARKER();
@@ -1197,7 +1281,8 @@ Json::Value Server::GetShardingStructure() {
   try {
     Json::Value _json;
 
-    auto shards = m_mediator.m_lookup->GetShardPeers();
+    const auto shardingStructure = m_mediator.m_lookup->GetShardPeers();
+    const auto& shards = shardingStructure->GetShards();
 
     unsigned int num_shards = shards.size();
 
@@ -1240,7 +1325,8 @@ string Server::GetNumTxnsDSEpoch() {
     throw JsonRpcException(RPC_INVALID_REQUEST, "Sent to a non-lookup");
   }
   try {
-    auto latestTxBlock = m_mediator.m_txBlockChain.GetLastBlock().GetHeader();
+    auto latestTxBlock =
+        m_mediator.m_txBlockChain.GetLastBlockPtr()->GetHeader();
     auto latestTxBlockNum = latestTxBlock.GetBlockNum();
     auto latestDSBlockNum = latestTxBlock.GetDSBlockNum();
 
@@ -1248,12 +1334,12 @@ string Server::GetNumTxnsDSEpoch() {
 
     if (latestTxBlockNum > m_TxBlockCountSumPair.first) {
       // Case where the DS Epoch is same
-      if (m_mediator.m_txBlockChain.GetBlock(m_TxBlockCountSumPair.first)
-              .GetHeader()
+      if (m_mediator.m_txBlockChain.GetBlockPtr(m_TxBlockCountSumPair.first)
+              ->GetHeader()
               .GetDSBlockNum() == latestDSBlockNum) {
         for (auto i = latestTxBlockNum; i > m_TxBlockCountSumPair.first; i--) {
           m_TxBlockCountSumPair.second +=
-              m_mediator.m_txBlockChain.GetBlock(i).GetHeader().GetNumTxs();
+              m_mediator.m_txBlockChain.GetBlockPtr(i)->GetHeader().GetNumTxs();
         }
       }
       // Case if DS Epoch Changed
@@ -1261,13 +1347,11 @@ string Server::GetNumTxnsDSEpoch() {
         m_TxBlockCountSumPair.second = 0;
 
         for (auto i = latestTxBlockNum; i > m_TxBlockCountSumPair.first; i--) {
-          if (m_mediator.m_txBlockChain.GetBlock(i)
-                  .GetHeader()
-                  .GetDSBlockNum() < latestDSBlockNum) {
+          const auto block = m_mediator.m_txBlockChain.GetBlockPtr(i);
+          if (block->GetHeader().GetDSBlockNum() < latestDSBlockNum) {
             break;
           }
-          m_TxBlockCountSumPair.second +=
-              m_mediator.m_txBlockChain.GetBlock(i).GetHeader().GetNumTxs();
+          m_TxBlockCountSumPair.second += block->GetHeader().GetNumTxs();
         }
       }
 
@@ -1285,19 +1369,8 @@ string Server::GetNumTxnsDSEpoch() {
   }
 }
 
-Json::Value Server::GetTransactionsForTxBlock(const string& txBlockNum) {
-  LOG_MARKER();
-  if (!LOOKUP_NODE_MODE) {
-    throw JsonRpcException(RPC_INVALID_REQUEST, "Sent to a non-lookup");
-  }
-  uint64_t txNum;
-  Json::Value _json = Json::arrayValue;
-  try {
-    txNum = strtoull(txBlockNum.c_str(), NULL, 0);
-  } catch (exception& e) {
-    throw JsonRpcException(RPC_INVALID_PARAMETER, e.what());
-  }
-
+void Server::GetTxBlockTxnHashes(uint64_t txNum,
+                                 map<uint32_t, vector<TxnHash>>& txnHashes) {
   auto const& txBlock = m_mediator.m_txBlockChain.GetBlock(txNum);
 
   // TODO
@@ -1311,41 +1384,195 @@ Json::Value Server::GetTransactionsForTxBlock(const string& txBlockNum) {
 
   auto microBlockInfos = txBlock.GetMicroBlockInfos();
 
+  // Micro blocks stored before the index was kept are read back instead
+  TxBlockTxns indexed;
+  BlockStorage::GetBlockStorage().GetTxBlockTxns(txNum, indexed);
+
   bool hasTransactions = false;
   for (auto const& mbInfo : microBlockInfos) {
     MicroBlockSharedPtr mbptr;
-    _json[mbInfo.m_shardId] = Json::arrayValue;
+    vector<TxnHash>& shardHashes = txnHashes[mbInfo.m_shardId];
+    shardHashes.clear();
 
     if (mbInfo.m_txnRootHash == TxnHash()) {
       continue;
     }
 
-    if (!BlockStorage::GetBlockStorage().GetMicroBlock(mbInfo.m_microBlockHash,
-                                                       mbptr)) {
-      if (!m_mediator.m_lookup->m_historicalDB) {
-        throw JsonRpcException(RPC_DATABASE_ERROR, "Failed to get Microblock");
-      } else if (!BlockStorage::GetBlockStorage().GetHistoricalMicroBlock(
-                     mbInfo.m_microBlockHash, mbptr)) {
-        throw JsonRpcException(RPC_DATABASE_ERROR, "Failed to get Microblock");
+    const std::vector<TxnHash>* tranHashesPtr = nullptr;
+    auto it = indexed.find(mbInfo.m_shardId);
+    if (it != indexed.end() && it->second.first == mbInfo.m_microBlockHash) {
+      tranHashesPtr = &it->second.second;
+    } else {
+      if (!BlockStorage::GetBlockStorage().GetMicroBlock(
+              mbInfo.m_microBlockHash, mbptr)) {
+        if (!m_mediator.m_lookup->m_historicalDB) {
+          throw JsonRpcException(RPC_DATABASE_ERROR,
+                                 "Failed to get Microblock");
+        } else if (!BlockStorage::GetBlockStorage().GetHistoricalMicroBlock(
+                       mbInfo.m_microBlockHash, mbptr)) {
+          throw JsonRpcException(RPC_DATABASE_ERROR,
+                                 "Failed to get Microblock");
+        }
       }
+      tranHashesPtr = &mbptr->GetTranHashes();
     }
 
-    const std::vector<TxnHash>& tranHashes = mbptr->GetTranHashes();
+    const std::vector<TxnHash>& tranHashes = *tranHashesPtr;
     if (tranHashes.size() > 0) {
       hasTransactions = true;
-      for (const auto& tranHash : tranHashes) {
-        _json[mbInfo.m_shardId].append(tranHash.hex());
-      }
+      shardHashes = tranHashes;
     }
   }
 
   if (!hasTransactions) {
     throw JsonRpcException(RPC_MISC_ERROR, "TxBlock has no transactions");
   }
+}
 
+Json::Value Server::GetTransactionsForTxBlock(const string& txBlockNum) {
+  LOG_MARKER();
+  if (!LOOKUP_NODE_MODE) {
+    throw JsonRpcException(RPC_INVALID_REQUEST, "Sent to a non-lookup");
+  }
+  uint64_t txNum;
+  Json::Value _json = Json::arrayValue;
+  try {
+    txNum = strtoull(txBlockNum.c_str(), NULL, 0);
+  } catch (exception& e) {
+    throw JsonRpcException(RPC_INVALID_PARAMETER, e.what());
+  }
+
+  const string cacheKey = "txblocktxns:" + to_string(txNum);
+  if (m_responseCache.Get(cacheKey, _json)) {
+    return _json;
+  }
+
+  map<uint32_t, vector<TxnHash>> txnHashes;
+  GetTxBlockTxnHashes(txNum, txnHashes);
+  for (const auto& shard : txnHashes) {
+    _json[shard.first] = Json::arrayValue;
+    for (const auto& tranHash : shard.second) {
+      _json[shard.first].append(tranHash.hex());
+    }
+  }
+
+  m_responseCache.Put(cacheKey, _json);
   return _json;
 }
 
+bool Server::RenderDirect(const string& method, const Json::Value& param,
+                          string& result) {
+  // Only the inputs the method takes without any error are rendered here
+  if (!LOOKUP_NODE_MODE || !param.isString()) {
+    return false;
+  }
+  const string& str = param.asString();
+  if (str.empty() || str.size() > 19 || (str.size() > 1 && str[0] == '0') ||
+      str.find_first_not_of("0123456789") != string::npos) {
+    return false;
+  }
+  const uint64_t blockNum = stoull(str);
+
+  string cacheKey;
+  if (method == "GetDsBlock") {
+    cacheKey = "dsblock:" + to_string(blockNum);
+  } else if (method == "GetTxBlock") {
+    cacheKey = "txblock:" + to_string(blockNum);
+  } else if (method == "GetTransactionsForTxBlock") {
+    cacheKey = "txblocktxns:" + to_string(blockNum);
+  } else {
+    return false;
+  }
+  if (m_renderedCache.Get(cacheKey, result)) {
+    return true;
+  }
+
+  result.clear();
+  JSONWriter writer(result);
+  // Blocks not yet committed render as a dummy block, keep those out
+  bool committed = true;
+  if (method == "GetDsBlock") {
+    committed = blockNum <=
+                m_mediator.m_dsBlockChain.GetLastBlock().GetHeader().GetBlockNum();
+    if (!JSONConversion::writeDSblock(
+            m_mediator.m_dsBlockChain.GetBlock(blockNum), writer)) {
+      return false;
+    }
+  } else if (method == "GetTxBlock") {
+    committed = blockNum <=
+                m_mediator.m_txBlockChain.GetLastBlock().GetHeader().GetBlockNum();
+    if (!JSONConversion::writeTxBlock(
+            m_mediator.m_txBlockChain.GetBlock(blockNum), writer)) {
+      return false;
+    }
+  } else {
+    map<uint32_t, vector<TxnHash>> txnHashes;
+    GetTxBlockTxnHashes(blockNum, txnHashes);
+    // Shards missing below the highest shard id read as null, as in an array
+    // of Json::Value
+    uint32_t shardId = 0;
+    writer.BeginArray();
+    for (const auto& shard : txnHashes) {
+      for (; shardId < shard.first; shardId++) {
+        writer.Null();
+      }
+      writer.BeginArray();
+      for (const auto& tranHash : shard.second) {
+        writer.String(tranHash.hex());
+      }
+      writer.EndArray();
+      shardId++;
+    }
+    writer.EndArray();
+  }
+
+  if (committed) {
+    m_renderedCache.Put(cacheKey, result);
+  }
+  return true;
+}
+
+bool Server::HandleDirect(const string& request, string& response) {
+  Json::Value call;
+  string errors;
+  Json::CharReaderBuilder readerBuilder;
+  unique_ptr<Json::CharReader> reader(readerBuilder.newCharReader());
+  if (!reader->parse(request.c_str(), request.c_str() + request.size(), &call,
+                     &errors) ||
+      !call.isObject() || call["jsonrpc"] != "2.0" || !call.isMember("id") ||
+      !call["method"].isString() || !call["params"].isArray() ||
+      call["params"].size() != 1) {
+    return false;
+  }
+
+  const string method = call["method"].asString();
+  RPCStats& stats = RPCStats::GetInstance();
+  auto startTime = r_timer_start();
+  string result;
+  try {
+    if (!RenderDirect(method, call["params"][0u], result)) {
+      return false;
+    }
+  } catch (const exception&) {
+    // The call is made again through the methods, which report the error
+    return false;
+  }
+
+  response.clear();
+  JSONWriter writer(response);
+  writer.BeginObject();
+  Json::StreamWriterBuilder writerBuilder;
+  writerBuilder["indentation"] = "";
+  writer.Key("id").Raw(Json::writeString(writerBuilder, call["id"]));
+  writer.Key("jsonrpc").String("2.0");
+  writer.Key("result").Raw(result);
+  writer.EndObject();
+
+  stats.RecordStart(method);
+  stats.RecordEnd(method, r_timer_end(startTime), false);
+  return true;
+}
+
 string Server::GetNodeType() {
   if (!m_mediator.m_lookup->AlreadyJoinedNetwork()) {
     return "Not in network";
@@ -1361,15 +1588,12 @@ string Server::GetNodeType() {
 }
 
 Json::Value Server::GetDSCommittee() {
-  if (m_mediator.m_DSCommittee == NULL) {
+  const auto context = m_mediator.GetEpochContext();
+  if (context->m_dsCommittee == NULL) {
     throw JsonRpcException(RPC_INTERNAL_ERROR, "DS Committee empty");
   }
 
-  lock_guard<mutex>(m_mediator.m_mutexDSCommittee);
-
-  const DequeOfNode& dq = *m_mediator.m_DSCommittee;
-
-  return JSONConversion::convertDequeOfNode(dq);
+  return JSONConversion::convertDequeOfNode(*context->m_dsCommittee);
 }
 
 string Server::GetNodeState() {
@@ -1381,4 +1605,346 @@ string Server::GetNodeState() {
   } else {
     return m_mediator.m_ds->GetStateString();
   }
-}
\ No newline at end of file
+}
+
+Json::Value Server::GetContractProfiles() {
+  if (!ENABLE_CONTRACT_PROFILING) {
+    throw JsonRpcException(RPC_INVALID_REQUEST,
+                           "Contract profiling is not enabled");
+  }
+
+  return ContractProfiler::GetInstance().GetProfilesJson(
+      CONTRACT_PROFILING_DUMP_ENTRIES);
+}
+
+Json::Value Server::GetTransactionsForAddress(const string& address,
+                                              unsigned int page) {
+  LOG_MARKER();
+
+  if (!LOOKUP_NODE_MODE) {
+    throw JsonRpcException(RPC_INVALID_REQUEST, "Sent to a non-lookup");
+  }
+
+  if (!ENABLE_TXN_ADDRESS_INDEX) {
+    throw JsonRpcException(RPC_INVALID_REQUEST,
+                           "Txn address index is not enabled");
+  }
+
+  if (address.size() != ACC_ADDR_SIZE * 2) {
+    throw JsonRpcException(RPC_INVALID_PARAMETER,
+                           "Address size not appropriate");
+  }
+
+  bytes tmpaddr;
+  if (!DataConversion::HexStrToUint8Vec(address, tmpaddr)) {
+    throw JsonRpcException(RPC_INVALID_ADDRESS_OR_KEY, "invalid address");
+  }
+
+  if (page < 1) {
+    throw JsonRpcException(RPC_INVALID_PARAMETER, "Pages out of limit");
+  }
+
+  vector<pair<uint64_t, TxnHash>> txns;
+  bool hasMore = false;
+  if (!BlockStorage::GetBlockStorage().GetTxnsForAddress(
+          Address(tmpaddr), page, TXN_PAGE_SIZE, txns, hasMore)) {
+    throw JsonRpcException(RPC_DATABASE_ERROR, "Failed to read txn index");
+  }
+
+  Json::Value _json;
+  _json["page"] = page;
+  _json["hasMore"] = hasMore;
+  _json["txns"] = Json::arrayValue;
+  for (const auto& txn : txns) {
+    Json::Value tmpJson;
+    tmpJson["epoch"] = to_string(txn.first);
+    tmpJson["hash"] = txn.second.hex();
+    _json["txns"].append(tmpJson);
+  }
+
+  return _json;
+}
+
+Json::Value Server::GetEvents(const string& address, const string& eventName,
+                              const string& fromBlock, const string& toBlock) {
+  LOG_MARKER();
+
+  if (!LOOKUP_NODE_MODE) {
+    throw JsonRpcException(RPC_INVALID_REQUEST, "Sent to a non-lookup");
+  }
+
+  if (!ENABLE_EVENT_BLOOM_INDEX) {
+    throw JsonRpcException(RPC_INVALID_REQUEST,
+                           "Event bloom index is not enabled");
+  }
+
+  if (address.size() != ACC_ADDR_SIZE * 2) {
+    throw JsonRpcException(RPC_INVALID_PARAMETER,
+                           "Address size not appropriate");
+  }
+
+  bytes tmpaddr;
+  if (!DataConversion::HexStrToUint8Vec(address, tmpaddr)) {
+    throw JsonRpcException(RPC_INVALID_ADDRESS_OR_KEY, "invalid address");
+  }
+  const Address addr(tmpaddr);
+
+  const uint64_t from = strtoull(fromBlock.c_str(), NULL, 0);
+  const uint64_t to = strtoull(toBlock.c_str(), NULL, 0);
+  if (from > to || to - from >= EVENT_QUERY_MAX_BLOCK_RANGE) {
+    throw JsonRpcException(RPC_INVALID_PARAMETER,
+                           "Block range must be of 1 to " +
+                               to_string(EVENT_QUERY_MAX_BLOCK_RANGE) +
+                               " blocks");
+  }
+
+  vector<pair<uint64_t, uint32_t>> matches;
+  if (!BlockStorage::GetBlockStorage().GetEventBloomMatches(
+          from, to, addr, eventName, matches)) {
+    throw JsonRpcException(RPC_DATABASE_ERROR, "Failed to read event blooms");
+  }
+
+  const string addrStr = "0x" + addr.hex();
+
+  Json::Value _json;
+  _json["events"] = Json::arrayValue;
+  _json["hasMore"] = false;
+
+  uint64_t blockNum = INIT_BLOCK_NUMBER;
+  TxBlockTxns indexed;
+  for (const auto& match : matches) {
+    if (match.first != blockNum) {
+      // Results end at a block boundary, so the query can resume there
+      if (_json["events"].size() >= EVENT_QUERY_MAX_RESULTS) {
+        _json["hasMore"] = true;
+        _json["nextBlock"] = to_string(match.first);
+        break;
+      }
+      blockNum = match.first;
+      indexed.clear();
+      BlockStorage::GetBlockStorage().GetTxBlockTxns(blockNum, indexed);
+    }
+
+    vector<TxnHash> tranHashes;
+    auto it = indexed.find(match.second);
+    if (it != indexed.end()) {
+      tranHashes = it->second.second;
+    } else {
+      // Micro blocks stored before the index was kept are read back instead
+      const auto& txBlock = m_mediator.m_txBlockChain.GetBlock(blockNum);
+      for (const auto& mbInfo : txBlock.GetMicroBlockInfos()) {
+        MicroBlockSharedPtr mbptr;
+        if (mbInfo.m_shardId == match.second &&
+            BlockStorage::GetBlockStorage().GetMicroBlock(
+                mbInfo.m_microBlockHash, mbptr)) {
+          tranHashes = mbptr->GetTranHashes();
+          break;
+        }
+      }
+    }
+
+    for (const auto& tranHash : tranHashes) {
+      TxBodySharedPtr tptr;
+      if (!BlockStorage::GetBlockStorage().GetTxBody(tranHash, tptr) &&
+          !(m_mediator.m_lookup->m_historicalDB &&
+            BlockStorage::GetBlockStorage().GetTxnFromHistoricalDB(tranHash,
+                                                                   tptr))) {
+        LOG_GENERAL(WARNING, "Missing txn body " << tranHash);
+        continue;
+      }
+
+      const TransactionReceipt& receipt = tptr->GetTransactionReceipt();
+      if (!receipt.GetEventBloom().MayContain(addr, eventName)) {
+        continue;
+      }
+
+      for (const auto& event : receipt.GetJsonValue()["event_logs"]) {
+        if (event.get("address", "").asString() != addrStr ||
+            (!eventName.empty() &&
+             event.get("_eventname", "").asString() != eventName)) {
+          continue;
+        }
+        Json::Value tmpJson;
+        tmpJson["blockNum"] = to_string(blockNum);
+        tmpJson["txnHash"] = tranHash.hex();
+        tmpJson["event"] = event;
+        _json["events"].append(tmpJson);
+      }
+    }
+  }
+
+  return _json;
+}
+
+namespace {
+
+Address GetContractAddress(const string& address) {
+  if (address.size() != ACC_ADDR_SIZE * 2) {
+    throw JsonRpcException(Server::RPC_INVALID_PARAMETER,
+                           "Address size not appropriate");
+  }
+  bytes tmpaddr;
+  if (!DataConversion::HexStrToUint8Vec(address, tmpaddr)) {
+    throw JsonRpcException(Server::RPC_INVALID_ADDRESS_OR_KEY,
+                           "invalid address");
+  }
+
+  Address addr(tmpaddr);
+  const Account* account = AccountStore::GetInstance().GetAccount(addr);
+  if (account == nullptr) {
+    throw JsonRpcException(Server::RPC_INVALID_ADDRESS_OR_KEY,
+                           "Address does not exist");
+  }
+  if (!account->isContract()) {
+    throw JsonRpcException(Server::RPC_INVALID_ADDRESS_OR_KEY,
+                           "Address not contract address");
+  }
+  return addr;
+}
+
+Json::Value GetSubStateValue(const string& address, const string& variableName,
+                             const Json::Value& indices) {
+  if (variableName.empty()) {
+    throw JsonRpcException(Server::RPC_INVALID_PARAMETER,
+                           "Variable name empty");
+  }
+  if (!indices.isArray()) {
+    throw JsonRpcException(Server::RPC_INVALID_PARAMETER,
+                           "Indices not an array");
+  }
+
+  vector<string> keys;
+  for (const auto& index : indices) {
+    if (!index.isString()) {
+      throw JsonRpcException(Server::RPC_INVALID_PARAMETER,
+                             "Index not a string");
+    }
+    keys.emplace_back(index.asString());
+  }
+
+  const Address addr = GetContractAddress(address);
+
+  if (variableName == "_balance" && keys.empty()) {
+    const Account* account = AccountStore::GetInstance().GetAccount(addr);
+    return account->GetBalance().convert_to<string>();
+  }
+
+  Json::Value value;
+  if (!Contract::ContractStorage::GetContractStorage().GetContractSubStateJson(
+          addr, variableName, keys, value, false)) {
+    throw JsonRpcException(Server::RPC_INVALID_PARAMETER, "State not found");
+  }
+  return value;
+}
+
+}  // namespace
+
+Json::Value Server::GetSmartContractSubState(const string& address,
+                                             const string& variableName,
+                                             const Json::Value& indices) {
+  LOG_MARKER();
+
+  if (!LOOKUP_NODE_MODE) {
+    throw JsonRpcException(RPC_INVALID_REQUEST, "Sent to a non-lookup");
+  }
+
+  try {
+    Json::Value _json;
+    _json[variableName] = GetSubStateValue(address, variableName, indices);
+    return _json;
+  } catch (const JsonRpcException& je) {
+    throw je;
+  } catch (exception& e) {
+    LOG_GENERAL(INFO, "[Error]" << e.what() << " Input: " << address);
+    throw JsonRpcException(RPC_MISC_ERROR, "Unable To Process");
+  }
+}
+
+Json::Value Server::GetSmartContractSubStatePage(const string& address,
+                                                 const string& variableName,
+                                                 const Json::Value& indices,
+                                                 unsigned int page) {
+  LOG_MARKER();
+
+  if (!LOOKUP_NODE_MODE) {
+    throw JsonRpcException(RPC_INVALID_REQUEST, "Sent to a non-lookup");
+  }
+
+  if (page < 1) {
+    throw JsonRpcException(RPC_INVALID_PARAMETER, "Pages out of limit");
+  }
+
+  try {
+    const Json::Value value =
+        GetSubStateValue(address, variableName, indices);
+
+    const uint64_t begin = static_cast<uint64_t>(page - 1) * STATE_PAGE_SIZE;
+    const uint64_t end = begin + STATE_PAGE_SIZE;
+
+    Json::Value _json;
+    _json["page"] = page;
+    _json["entries"] = Json::objectValue;
+
+    if (value.isObject()) {
+      // Members are kept in key order, so pages are stable between calls
+      uint64_t i = 0;
+      for (auto it = value.begin(); it != value.end() && i < end; ++it, ++i) {
+        if (i >= begin) {
+          _json["entries"][it.name()] = *it;
+        }
+      }
+      _json["hasMore"] = value.size() > end;
+    } else if (value.isArray()) {
+      for (uint64_t i = begin; i < value.size() && i < end; i++) {
+        const Json::Value& item = value[static_cast<Json::ArrayIndex>(i)];
+        if (item.isObject() && item["key"].isString()) {
+          _json["entries"][item["key"].asString()] = item["val"];
+        }
+      }
+      _json["hasMore"] = value.size() > end;
+    } else {
+      throw JsonRpcException(RPC_INVALID_PARAMETER, "State is not a map");
+    }
+
+    return _json;
+  } catch (const JsonRpcException& je) {
+    throw je;
+  } catch (exception& e) {
+    LOG_GENERAL(INFO, "[Error]" << e.what() << " Input: " << address);
+    throw JsonRpcException(RPC_MISC_ERROR, "Unable To Process");
+  }
+}
+
+Json::Value Server::GetRPCStats() {
+  LOG_MARKER();
+
+  return RPCStats::GetInstance().GetStatsJson();
+}
+
+string Server::GetEpochTrace() {
+  LOG_MARKER();
+
+  if (!Tracing::IsEnabled()) {
+    throw JsonRpcException(RPC_INVALID_REQUEST, "Epoch tracing is disabled");
+  }
+
+  return Tracing::GetInstance().GetChromeTrace();
+}
+
+Json::Value Server::GetMemoryStats() {
+  LOG_MARKER();
+
+  Json::Value _json;
+  _json["subsystems"] = Json::objectValue;
+  uint64_t trackedBytes = 0;
+  for (const auto& entry : MemoryStats::GetInstance().GetReport()) {
+    Json::Value tmpJson;
+    tmpJson["entries"] = to_string(entry.second.m_entries);
+    tmpJson["bytes"] = to_string(entry.second.m_bytes);
+    _json["subsystems"][entry.first] = tmpJson;
+    trackedBytes += entry.second.m_bytes;
+  }
+  _json["trackedBytes"] = to_string(trackedBytes);
+  _json["residentBytes"] = to_string(MemoryStats::GetResidentBytes());
+  return _json;
+}
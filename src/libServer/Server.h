@@ -20,11 +20,16 @@
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 #include <boost/multiprecision/cpp_int.hpp>
 #pragma GCC diagnostic pop
+#include <map>
 #include <mutex>
+#include <set>
 #include "libData/BlockData/BlockHeader/BlockHeaderBase.h"
 #include "libData/DataStructures/CircularArray.h"
+#include "libData/DataStructures/SeqLockRing.h"
+#include "libUtils/LRUCache.h"
 
 class Mediator;
+class Transaction;
 
 class AbstractZServer : public jsonrpc::AbstractServer<AbstractZServer> {
  public:
@@ -225,6 +230,51 @@ class AbstractZServer : public jsonrpc::AbstractServer<AbstractZServer> {
         jsonrpc::Procedure("GetNodeState", jsonrpc::PARAMS_BY_POSITION,
                            jsonrpc::JSON_STRING, NULL),
         &AbstractZServer::GetNodeStateI);
+    this->bindAndAddMethod(
+        jsonrpc::Procedure("GetContractProfiles", jsonrpc::PARAMS_BY_POSITION,
+                           jsonrpc::JSON_ARRAY, NULL),
+        &AbstractZServer::GetContractProfilesI);
+    this->bindAndAddMethod(
+        jsonrpc::Procedure("GetTransactionsForAddress",
+                           jsonrpc::PARAMS_BY_POSITION, jsonrpc::JSON_OBJECT,
+                           "param01", jsonrpc::JSON_STRING, "param02",
+                           jsonrpc::JSON_INTEGER, NULL),
+        &AbstractZServer::GetTransactionsForAddressI);
+    this->bindAndAddMethod(
+        jsonrpc::Procedure("GetEvents", jsonrpc::PARAMS_BY_POSITION,
+                           jsonrpc::JSON_OBJECT, "param01",
+                           jsonrpc::JSON_STRING, "param02",
+                           jsonrpc::JSON_STRING, "param03",
+                           jsonrpc::JSON_STRING, "param04",
+                           jsonrpc::JSON_STRING, NULL),
+        &AbstractZServer::GetEventsI);
+    this->bindAndAddMethod(
+        jsonrpc::Procedure("GetSmartContractSubState",
+                           jsonrpc::PARAMS_BY_POSITION, jsonrpc::JSON_OBJECT,
+                           "param01", jsonrpc::JSON_STRING, "param02",
+                           jsonrpc::JSON_STRING, "param03",
+                           jsonrpc::JSON_ARRAY, NULL),
+        &AbstractZServer::GetSmartContractSubStateI);
+    this->bindAndAddMethod(
+        jsonrpc::Procedure("GetSmartContractSubStatePage",
+                           jsonrpc::PARAMS_BY_POSITION, jsonrpc::JSON_OBJECT,
+                           "param01", jsonrpc::JSON_STRING, "param02",
+                           jsonrpc::JSON_STRING, "param03",
+                           jsonrpc::JSON_ARRAY, "param04",
+                           jsonrpc::JSON_INTEGER, NULL),
+        &AbstractZServer::GetSmartContractSubStatePageI);
+    this->bindAndAddMethod(
+        jsonrpc::Procedure("GetRPCStats", jsonrpc::PARAMS_BY_POSITION,
+                           jsonrpc::JSON_OBJECT, NULL),
+        &AbstractZServer::GetRPCStatsI);
+    this->bindAndAddMethod(
+        jsonrpc::Procedure("GetEpochTrace", jsonrpc::PARAMS_BY_POSITION,
+                           jsonrpc::JSON_STRING, NULL),
+        &AbstractZServer::GetEpochTraceI);
+    this->bindAndAddMethod(
+        jsonrpc::Procedure("GetMemoryStats", jsonrpc::PARAMS_BY_POSITION,
+                           jsonrpc::JSON_OBJECT, NULL),
+        &AbstractZServer::GetMemoryStatsI);
   }
 
   inline virtual void GetNetworkIdI(const Json::Value& request,
@@ -397,6 +447,48 @@ class AbstractZServer : public jsonrpc::AbstractServer<AbstractZServer> {
     (void)request;
     response = this->GetNodeState();
   }
+  inline virtual void GetContractProfilesI(const Json::Value& request,
+                                           Json::Value& response) {
+    (void)request;
+    response = this->GetContractProfiles();
+  }
+  inline virtual void GetTransactionsForAddressI(const Json::Value& request,
+                                                 Json::Value& response) {
+    response = this->GetTransactionsForAddress(request[0u].asString(),
+                                               request[1u].asUInt());
+  }
+  inline virtual void GetEventsI(const Json::Value& request,
+                                 Json::Value& response) {
+    response =
+        this->GetEvents(request[0u].asString(), request[1u].asString(),
+                        request[2u].asString(), request[3u].asString());
+  }
+  inline virtual void GetSmartContractSubStateI(const Json::Value& request,
+                                                Json::Value& response) {
+    response = this->GetSmartContractSubState(
+        request[0u].asString(), request[1u].asString(), request[2u]);
+  }
+  inline virtual void GetSmartContractSubStatePageI(const Json::Value& request,
+                                                    Json::Value& response) {
+    response = this->GetSmartContractSubStatePage(
+        request[0u].asString(), request[1u].asString(), request[2u],
+        request[3u].asUInt());
+  }
+  inline virtual void GetRPCStatsI(const Json::Value& request,
+                                   Json::Value& response) {
+    (void)request;
+    response = this->GetRPCStats();
+  }
+  inline virtual void GetEpochTraceI(const Json::Value& request,
+                                     Json::Value& response) {
+    (void)request;
+    response = this->GetEpochTrace();
+  }
+  inline virtual void GetMemoryStatsI(const Json::Value& request,
+                                      Json::Value& response) {
+    (void)request;
+    response = this->GetMemoryStats();
+  }
   virtual std::string GetNetworkId() = 0;
   virtual Json::Value CreateTransaction(const Json::Value& param01) = 0;
   virtual Json::Value GetTransaction(const std::string& param01) = 0;
@@ -434,6 +526,22 @@ class AbstractZServer : public jsonrpc::AbstractServer<AbstractZServer> {
   virtual std::string GetNodeType() = 0;
   virtual Json::Value GetDSCommittee() = 0;
   virtual std::string GetNodeState() = 0;
+  virtual Json::Value GetContractProfiles() = 0;
+  virtual Json::Value GetTransactionsForAddress(const std::string& param01,
+                                                unsigned int param02) = 0;
+  virtual Json::Value GetEvents(const std::string& param01,
+                                const std::string& param02,
+                                const std::string& param03,
+                                const std::string& param04) = 0;
+  virtual Json::Value GetSmartContractSubState(const std::string& param01,
+                                               const std::string& param02,
+                                               const Json::Value& param03) = 0;
+  virtual Json::Value GetSmartContractSubStatePage(
+      const std::string& param01, const std::string& param02,
+      const Json::Value& param03, unsigned int param04) = 0;
+  virtual Json::Value GetRPCStats() = 0;
+  virtual std::string GetEpochTrace() = 0;
+  virtual Json::Value GetMemoryStats() = 0;
 };
 
 class Server : public AbstractZServer {
@@ -450,13 +558,37 @@ class Server : public AbstractZServer {
   std::pair<uint64_t, CircularArray<std::string>> m_DSBlockCache;
   std::mutex m_mutexTxBlockCache;
   std::pair<uint64_t, CircularArray<std::string>> m_TxBlockCache;
-  static CircularArray<std::string> m_RecentTransactions;
-  static std::mutex m_mutexRecentTxns;
+  static SeqLockRing<dev::h256> m_RecentTransactions;
+  /// Rendered JSON of committed blocks and txns, which never change once
+  /// committed. Keyed by what was rendered, e.g. "txblock:<num>", so that a
+  /// new block is simply a new key.
+  LRUCache<std::string, Json::Value> m_responseCache;
+  /// The same for the methods rendered straight to text by HandleDirect
+  LRUCache<std::string, std::string> m_renderedCache;
+
+  /// The txn hashes of each shard of a Tx block, throwing what
+  /// GetTransactionsForTxBlock reports
+  void GetTxBlockTxnHashes(
+      uint64_t txNum, std::map<uint32_t, std::vector<dev::h256>>& txnHashes);
+  bool RenderDirect(const std::string& method, const Json::Value& param,
+                    std::string& result);
+  /// Hands a submitted txn to the lookup, throwing if it is refused
+  void AdmitTxn(const Transaction& tx, uint32_t shardId);
 
  public:
   Server(Mediator& mediator, jsonrpc::AbstractServerConnector& server);
   ~Server();
 
+  /// Counts the call and its latency in RPCStats around the method itself
+  virtual void HandleMethodCall(jsonrpc::Procedure& proc,
+                                const Json::Value& input, Json::Value& output);
+
+  /// Answers calls of GetDsBlock, GetTxBlock and GetTransactionsForTxBlock
+  /// by writing the result as text, without building it as a Json::Value.
+  /// Returns false for any other call, or one that fails, which is then
+  /// made through the methods as usual.
+  bool HandleDirect(const std::string& request, std::string& response);
+
   virtual std::string GetNetworkId();
   virtual Json::Value CreateTransaction(const Json::Value& _json);
   virtual Json::Value GetTransaction(const std::string& transactionHash);
@@ -490,6 +622,11 @@ class Server : public AbstractZServer {
   virtual std::string GetNodeType();
   virtual Json::Value GetDSCommittee();
   static void AddToRecentTransactions(const dev::h256& txhash);
+  static void AddToRecentTransactions(const std::vector<dev::h256>& txhashes);
+
+  /// Methods that read contract states or many txn bodies, served by their
+  /// own workers so that they cannot hold up the others
+  static const std::set<std::string>& GetExpensiveMethods();
 
   // gets the number of transaction starting from block blockNum to most recent
   // block
@@ -497,9 +634,34 @@ class Server : public AbstractZServer {
   ContractType GetTransactionType(const Transaction& tx) const;
   bool StartCollectorThread();
   std::string GetNodeState();
+  Json::Value GetContractProfiles();
 
   Json::Value GetSmartContractState(const std::string& address);
   Json::Value GetSmartContractInit(const std::string& address);
   Json::Value GetSmartContractCode(const std::string& address);
   Json::Value GetTransactionsForTxBlock(const std::string& txBlockNum);
+  Json::Value GetTransactionsForAddress(const std::string& address,
+                                        unsigned int page);
+  /// The events of the contract at address named eventName, or of any name
+  /// if it is empty, in Tx blocks fromBlock to toBlock. Only the micro
+  /// blocks whose event blooms match are read.
+  Json::Value GetEvents(const std::string& address,
+                        const std::string& eventName,
+                        const std::string& fromBlock,
+                        const std::string& toBlock);
+  /// The value of a single state of a contract, or of an entry of its map
+  /// when indices holds the map keys leading to it
+  Json::Value GetSmartContractSubState(const std::string& address,
+                                       const std::string& variableName,
+                                       const Json::Value& indices);
+  /// A page of the entries of a map state, in key order
+  Json::Value GetSmartContractSubStatePage(const std::string& address,
+                                           const std::string& variableName,
+                                           const Json::Value& indices,
+                                           unsigned int page);
+  Json::Value GetRPCStats();
+  /// The spans of the epoch phases, in the Chrome trace event format
+  std::string GetEpochTrace();
+  /// The estimated memory of each subsystem, and the RSS of the process
+  Json::Value GetMemoryStats();
 };
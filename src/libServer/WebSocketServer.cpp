@@ -0,0 +1,586 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <arpa/inet.h>
+#include <event2/buffer.h>
+#include <event2/event.h>
+#include <openssl/evp.h>
+#include <openssl/sha.h>
+#include <algorithm>
+#include <cstring>
+
+#include "JSONConversion.h"
+#include "WebSocketServer.h"
+#include "common/Constants.h"
+#include "libUtils/DetachedFunction.h"
+#include "libUtils/JsonUtils.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+
+namespace {
+const unsigned char OPCODE_TEXT = 0x1;
+const unsigned char OPCODE_CLOSE = 0x8;
+const unsigned char OPCODE_PING = 0x9;
+const unsigned char OPCODE_PONG = 0xA;
+
+const size_t MAX_HANDSHAKE_BYTES = 8192;
+const uint64_t MAX_MESSAGE_BYTES = 65536;
+const unsigned int FLUSH_INTERVAL_IN_MS = 100;
+
+const string WEBSOCKET_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+string ToLower(string str) {
+  transform(str.begin(), str.end(), str.begin(), ::tolower);
+  return str;
+}
+
+// Event log addresses are "0x" prefixed, subscriptions may be either way
+string NormalizeAddress(const string& address) {
+  if (address.size() > 2 && address[0] == '0' &&
+      (address[1] == 'x' || address[1] == 'X')) {
+    return ToLower(address.substr(2));
+  }
+  return ToLower(address);
+}
+
+// Value of the header called name in the handshake request, "" if absent
+string GetHeader(const string& request, const string& name) {
+  const string lowerRequest = ToLower(request);
+  const string key = "\r\n" + ToLower(name) + ":";
+  size_t pos = lowerRequest.find(key);
+  if (pos == string::npos) {
+    return "";
+  }
+  pos += key.size();
+  size_t end = request.find("\r\n", pos);
+  string value = request.substr(pos, end - pos);
+  value.erase(0, value.find_first_not_of(" \t"));
+  value.erase(value.find_last_not_of(" \t") + 1);
+  return value;
+}
+}  // namespace
+
+string WebSocketServer::GetAcceptKey(const string& clientKey) {
+  const string key = clientKey + WEBSOCKET_GUID;
+  unsigned char digest[SHA_DIGEST_LENGTH];
+  SHA1(reinterpret_cast<const unsigned char*>(key.data()), key.size(),
+       digest);
+
+  // 4 output bytes per 3 input bytes, plus the terminating null
+  unsigned char encoded[4 * ((SHA_DIGEST_LENGTH + 2) / 3) + 1];
+  int len = EVP_EncodeBlock(encoded, digest, SHA_DIGEST_LENGTH);
+  return string(reinterpret_cast<char*>(encoded), len);
+}
+
+string WebSocketServer::MakeFrame(unsigned char opcode,
+                                  const string& payload) {
+  string frame;
+  frame.reserve(payload.size() + 10);
+  frame.push_back(static_cast<char>(0x80 | opcode));
+
+  const uint64_t len = payload.size();
+  if (len < 126) {
+    frame.push_back(static_cast<char>(len));
+  } else if (len <= 0xFFFF) {
+    frame.push_back(126);
+    frame.push_back(static_cast<char>((len >> 8) & 0xFF));
+    frame.push_back(static_cast<char>(len & 0xFF));
+  } else {
+    frame.push_back(127);
+    for (int shift = 56; shift >= 0; shift -= 8) {
+      frame.push_back(static_cast<char>((len >> shift) & 0xFF));
+    }
+  }
+
+  frame += payload;
+  return frame;
+}
+
+void WebSocketServer::Start(unsigned int port) {
+  auto func = [this, port]() -> void { RunEventLoop(port); };
+  DetachedFunction(DetachedFunction::Lane::BLOCKING, 1, func);
+}
+
+void WebSocketServer::RunEventLoop(unsigned int port) {
+  struct event_base* base = event_base_new();
+  if (base == NULL) {
+    LOG_GENERAL(WARNING, "event_base_new failure.");
+    return;
+  }
+
+  struct sockaddr_in serv_addr;
+  memset(&serv_addr, 0, sizeof(struct sockaddr_in));
+  serv_addr.sin_family = AF_INET;
+  serv_addr.sin_port = htons(port);
+  serv_addr.sin_addr.s_addr = INADDR_ANY;
+
+  struct evconnlistener* listener = evconnlistener_new_bind(
+      base, AcceptCallback, this, LEV_OPT_REUSEABLE | LEV_OPT_CLOSE_ON_FREE,
+      -1, (struct sockaddr*)&serv_addr, sizeof(struct sockaddr_in));
+  if (listener == NULL) {
+    LOG_GENERAL(WARNING, "evconnlistener_new_bind failure.");
+    event_base_free(base);
+    return;
+  }
+
+  // Notifiers run on the commit threads, so their frames are picked up here
+  // rather than written from there
+  struct event* flush = event_new(base, -1, EV_PERSIST, FlushCallback, this);
+  struct timeval interval;
+  interval.tv_sec = FLUSH_INTERVAL_IN_MS / 1000;
+  interval.tv_usec = (FLUSH_INTERVAL_IN_MS % 1000) * 1000;
+  event_add(flush, &interval);
+
+  LOG_GENERAL(INFO, "WebSocket server listening on port " << port);
+
+  event_base_dispatch(base);
+  event_free(flush);
+  evconnlistener_free(listener);
+  event_base_free(base);
+}
+
+void WebSocketServer::AcceptCallback(struct evconnlistener* listener,
+                                     evutil_socket_t sock,
+                                     [[gnu::unused]] struct sockaddr* addr,
+                                     [[gnu::unused]] int socklen, void* ctx) {
+  WebSocketServer* server = static_cast<WebSocketServer*>(ctx);
+
+  {
+    lock_guard<mutex> g(server->m_mutexConnections);
+    if (server->m_connections.size() >= WEBSOCKET_MAX_CONNECTIONS) {
+      LOG_GENERAL(WARNING, "Too many WebSocket connections, refusing one");
+      evutil_closesocket(sock);
+      return;
+    }
+  }
+
+  struct bufferevent* bev = bufferevent_socket_new(
+      evconnlistener_get_base(listener), sock, BEV_OPT_CLOSE_ON_FREE);
+  if (bev == NULL) {
+    LOG_GENERAL(WARNING, "bufferevent_socket_new failure.");
+    evutil_closesocket(sock);
+    return;
+  }
+
+  {
+    lock_guard<mutex> g(server->m_mutexConnections);
+    server->m_connections.emplace(bev, Connection());
+  }
+
+  bufferevent_setcb(bev, ReadCallback, NULL, EventCallback, server);
+  bufferevent_enable(bev, EV_READ | EV_WRITE);
+}
+
+void WebSocketServer::ReadCallback(struct bufferevent* bev, void* ctx) {
+  WebSocketServer* server = static_cast<WebSocketServer*>(ctx);
+
+  bool upgraded = false;
+  {
+    lock_guard<mutex> g(server->m_mutexConnections);
+    auto it = server->m_connections.find(bev);
+    if (it == server->m_connections.end()) {
+      return;
+    }
+    upgraded = it->second.m_upgraded;
+  }
+
+  if (!upgraded && !server->ProcessHandshake(bev)) {
+    return;
+  }
+
+  if (!server->ProcessFrames(bev)) {
+    server->CloseWhenWritten(bev);
+  }
+}
+
+void WebSocketServer::EventCallback(struct bufferevent* bev, short events,
+                                    void* ctx) {
+  if (events & (BEV_EVENT_EOF | BEV_EVENT_ERROR | BEV_EVENT_TIMEOUT)) {
+    static_cast<WebSocketServer*>(ctx)->Close(bev);
+  }
+}
+
+void WebSocketServer::CloseWhenWrittenCallback(struct bufferevent* bev,
+                                               void* ctx) {
+  if (evbuffer_get_length(bufferevent_get_output(bev)) == 0) {
+    static_cast<WebSocketServer*>(ctx)->Close(bev);
+  }
+}
+
+void WebSocketServer::FlushCallback([[gnu::unused]] evutil_socket_t fd,
+                                    [[gnu::unused]] short events, void* ctx) {
+  static_cast<WebSocketServer*>(ctx)->FlushPending();
+}
+
+void WebSocketServer::Close(struct bufferevent* bev) {
+  {
+    lock_guard<mutex> g(m_mutexConnections);
+    m_connections.erase(bev);
+  }
+  bufferevent_free(bev);
+}
+
+void WebSocketServer::CloseWhenWritten(struct bufferevent* bev) {
+  {
+    lock_guard<mutex> g(m_mutexConnections);
+    m_connections.erase(bev);
+  }
+  bufferevent_disable(bev, EV_READ);
+  bufferevent_setcb(bev, NULL, CloseWhenWrittenCallback, EventCallback, this);
+  CloseWhenWrittenCallback(bev, this);
+}
+
+void WebSocketServer::FlushPending() {
+  vector<struct bufferevent*> slowClients;
+  {
+    lock_guard<mutex> g(m_mutexConnections);
+    for (auto& entry : m_connections) {
+      if (entry.second.m_pending.empty()) {
+        continue;
+      }
+      struct evbuffer* output = bufferevent_get_output(entry.first);
+      if (evbuffer_get_length(output) + entry.second.m_pending.size() >
+          WEBSOCKET_MAX_PENDING_BYTES) {
+        slowClients.emplace_back(entry.first);
+        continue;
+      }
+      evbuffer_add(output, entry.second.m_pending.data(),
+                   entry.second.m_pending.size());
+      entry.second.m_pending.clear();
+    }
+  }
+
+  for (const auto& bev : slowClients) {
+    LOG_GENERAL(INFO, "Dropping WebSocket client too slow to keep up");
+    Close(bev);
+  }
+}
+
+bool WebSocketServer::ProcessHandshake(struct bufferevent* bev) {
+  struct evbuffer* input = bufferevent_get_input(bev);
+  struct evbuffer_ptr end = evbuffer_search(input, "\r\n\r\n", 4, NULL);
+  if (end.pos < 0) {
+    if (evbuffer_get_length(input) > MAX_HANDSHAKE_BYTES) {
+      LOG_GENERAL(WARNING, "WebSocket handshake too long");
+      Close(bev);
+    }
+    return false;
+  }
+
+  string request(end.pos + 4, '\0');
+  evbuffer_remove(input, &request[0], request.size());
+
+  const string clientKey = GetHeader(request, "Sec-WebSocket-Key");
+  if (ToLower(GetHeader(request, "Upgrade")) != "websocket" ||
+      clientKey.empty()) {
+    const string response =
+        "HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n";
+    bufferevent_write(bev, response.data(), response.size());
+    CloseWhenWritten(bev);
+    return false;
+  }
+
+  const string response =
+      "HTTP/1.1 101 Switching Protocols\r\n"
+      "Upgrade: websocket\r\n"
+      "Connection: Upgrade\r\n"
+      "Sec-WebSocket-Accept: " +
+      GetAcceptKey(clientKey) + "\r\n\r\n";
+  bufferevent_write(bev, response.data(), response.size());
+
+  lock_guard<mutex> g(m_mutexConnections);
+  auto it = m_connections.find(bev);
+  if (it == m_connections.end()) {
+    return false;
+  }
+  it->second.m_upgraded = true;
+  return true;
+}
+
+bool WebSocketServer::ProcessFrames(struct bufferevent* bev) {
+  struct evbuffer* input = bufferevent_get_input(bev);
+
+  while (true) {
+    const size_t len = evbuffer_get_length(input);
+    if (len < 2) {
+      return true;
+    }
+
+    unsigned char header[14];
+    evbuffer_copyout(input, header, min(len, sizeof(header)));
+
+    const bool fin = header[0] & 0x80;
+    const unsigned char opcode = header[0] & 0x0F;
+    uint64_t payloadLen = header[1] & 0x7F;
+    size_t headerLen = 2;
+
+    // Clients must mask what they send (RFC 6455 section 5.1)
+    if (!(header[1] & 0x80)) {
+      LOG_GENERAL(WARNING, "Unmasked WebSocket frame");
+      return false;
+    }
+
+    if (payloadLen == 126) {
+      headerLen = 4;
+      if (len < headerLen) {
+        return true;
+      }
+      payloadLen = (header[2] << 8) | header[3];
+    } else if (payloadLen == 127) {
+      headerLen = 10;
+      if (len < headerLen) {
+        return true;
+      }
+      payloadLen = 0;
+      for (unsigned int i = 2; i < 10; i++) {
+        payloadLen = (payloadLen << 8) | header[i];
+      }
+    }
+
+    if (payloadLen > MAX_MESSAGE_BYTES) {
+      LOG_GENERAL(WARNING, "WebSocket message of " << payloadLen
+                                                   << " bytes too large");
+      return false;
+    }
+
+    if (len < headerLen + 4 + payloadLen) {
+      return true;
+    }
+
+    const unsigned char* mask = header + headerLen;
+    unsigned char maskKey[4];
+    memcpy(maskKey, mask, 4);
+
+    evbuffer_drain(input, headerLen + 4);
+    string payload(payloadLen, '\0');
+    evbuffer_remove(input, &payload[0], payloadLen);
+    for (uint64_t i = 0; i < payloadLen; i++) {
+      payload[i] ^= maskKey[i % 4];
+    }
+
+    // Queries are small, so fragmented messages are not supported
+    if (!fin) {
+      LOG_GENERAL(WARNING, "Fragmented WebSocket message");
+      return false;
+    }
+
+    switch (opcode) {
+      case OPCODE_TEXT:
+        if (!ProcessQuery(bev, payload)) {
+          return false;
+        }
+        break;
+      case OPCODE_PING: {
+        const string pong = MakeFrame(OPCODE_PONG, payload);
+        bufferevent_write(bev, pong.data(), pong.size());
+        break;
+      }
+      case OPCODE_PONG:
+        break;
+      case OPCODE_CLOSE: {
+        const string close = MakeFrame(OPCODE_CLOSE, "");
+        bufferevent_write(bev, close.data(), close.size());
+        return false;
+      }
+      default:
+        LOG_GENERAL(WARNING, "Unexpected WebSocket opcode " << (int)opcode);
+        return false;
+    }
+  }
+}
+
+void WebSocketServer::Send(struct bufferevent* bev, const Json::Value& _json) {
+  const string frame =
+      MakeFrame(OPCODE_TEXT, JSONUtils::GetInstance().convertJsontoStr(_json));
+  bufferevent_write(bev, frame.data(), frame.size());
+}
+
+bool WebSocketServer::ProcessQuery(struct bufferevent* bev,
+                                   const string& query) {
+  Json::Value request;
+  Json::Value response;
+  if (!JSONUtils::GetInstance().convertStrtoJson(query, request) ||
+      !request.isObject() || !request["query"].isString()) {
+    response["error"] = "Invalid query";
+    Send(bev, response);
+    return true;
+  }
+
+  const string type = request["query"].asString();
+  response["query"] = type;
+
+  lock_guard<mutex> g(m_mutexConnections);
+  auto it = m_connections.find(bev);
+  if (it == m_connections.end()) {
+    return false;
+  }
+  Connection& conn = it->second;
+
+  const size_t numSubscriptions =
+      conn.m_txnHashes.size() + conn.m_logAddresses.size();
+
+  try {
+    if (type == "NewBlock") {
+      conn.m_txBlocks = true;
+    } else if (type == "NewDSBlock") {
+      conn.m_dsBlocks = true;
+    } else if (type == "TxnConfirmation") {
+      const Json::Value& hashes = request["hashes"];
+      if (!hashes.isArray() ||
+          numSubscriptions + hashes.size() > WEBSOCKET_MAX_SUBSCRIPTIONS) {
+        response["error"] = "Invalid or too many txn hashes";
+      } else {
+        for (const auto& hash : hashes) {
+          conn.m_txnHashes.emplace(hash.asString());
+        }
+      }
+    } else if (type == "EventLog") {
+      const Json::Value& addresses = request["addresses"];
+      const Json::Value& events = request["events"];
+      if (!addresses.isArray() || (!events.isNull() && !events.isArray()) ||
+          numSubscriptions + addresses.size() > WEBSOCKET_MAX_SUBSCRIPTIONS ||
+          events.size() > WEBSOCKET_MAX_SUBSCRIPTIONS) {
+        response["error"] = "Invalid or too many addresses or events";
+      } else {
+        for (const auto& address : addresses) {
+          conn.m_logAddresses.emplace(NormalizeAddress(address.asString()));
+        }
+        for (const auto& event : events) {
+          conn.m_logEvents.emplace(event.asString());
+        }
+      }
+    } else if (type == "Unsubscribe") {
+      const string what = request["type"].asString();
+      if (what == "NewBlock") {
+        conn.m_txBlocks = false;
+      } else if (what == "NewDSBlock") {
+        conn.m_dsBlocks = false;
+      } else if (what == "TxnConfirmation") {
+        conn.m_txnHashes.clear();
+      } else if (what == "EventLog") {
+        conn.m_logAddresses.clear();
+        conn.m_logEvents.clear();
+      } else {
+        response["error"] = "Unknown subscription type";
+      }
+    } else {
+      response["error"] = "Unknown query";
+    }
+  } catch (const exception& e) {
+    // e.g. a txn hash that is not hex
+    LOG_GENERAL(INFO, "[Error] " << e.what() << " Input: " << query);
+    response["error"] = "Invalid query parameters";
+  }
+
+  if (!response.isMember("error")) {
+    response["result"] = "ok";
+  }
+  Send(bev, response);
+  return true;
+}
+
+void WebSocketServer::NotifyTxBlock(const TxBlock& txBlock) {
+  lock_guard<mutex> g(m_mutexConnections);
+
+  string frame;
+  for (auto& entry : m_connections) {
+    if (!entry.second.m_txBlocks) {
+      continue;
+    }
+    // Rendered once, and only if someone is listening
+    if (frame.empty()) {
+      Json::Value _json;
+      _json["type"] = "NewBlock";
+      _json["value"] = JSONConversion::convertTxBlocktoJson(txBlock);
+      frame = MakeFrame(OPCODE_TEXT,
+                        JSONUtils::GetInstance().convertJsontoStr(_json));
+    }
+    entry.second.m_pending += frame;
+  }
+}
+
+void WebSocketServer::NotifyDSBlock(const DSBlock& dsBlock) {
+  lock_guard<mutex> g(m_mutexConnections);
+
+  string frame;
+  for (auto& entry : m_connections) {
+    if (!entry.second.m_dsBlocks) {
+      continue;
+    }
+    if (frame.empty()) {
+      Json::Value _json;
+      _json["type"] = "NewDSBlock";
+      _json["value"] = JSONConversion::convertDSblocktoJson(dsBlock);
+      frame = MakeFrame(OPCODE_TEXT,
+                        JSONUtils::GetInstance().convertJsontoStr(_json));
+    }
+    entry.second.m_pending += frame;
+  }
+}
+
+void WebSocketServer::NotifyTxns(
+    const vector<TransactionWithReceipt>& txns) {
+  lock_guard<mutex> g(m_mutexConnections);
+
+  for (auto& entry : m_connections) {
+    Connection& conn = entry.second;
+    if (conn.m_txnHashes.empty() && conn.m_logAddresses.empty()) {
+      continue;
+    }
+
+    for (const auto& twr : txns) {
+      const TxnHash& txnHash = twr.GetTransaction().GetTranID();
+
+      if (conn.m_txnHashes.erase(txnHash) > 0) {
+        Json::Value _json;
+        _json["type"] = "TxnConfirmation";
+        _json["value"] = JSONConversion::convertTxtoJson(twr);
+        conn.m_pending += MakeFrame(
+            OPCODE_TEXT, JSONUtils::GetInstance().convertJsontoStr(_json));
+      }
+
+      if (conn.m_logAddresses.empty()) {
+        continue;
+      }
+
+      Json::Value logs = Json::arrayValue;
+      for (const auto& log : twr.GetTransactionReceipt()
+                                 .GetJsonValue()
+                                 .get("event_logs", Json::arrayValue)) {
+        if (conn.m_logAddresses.count(
+                NormalizeAddress(log["address"].asString())) == 0) {
+          continue;
+        }
+        if (!conn.m_logEvents.empty() &&
+            conn.m_logEvents.count(log["_eventname"].asString()) == 0) {
+          continue;
+        }
+        logs.append(log);
+      }
+
+      if (!logs.empty()) {
+        Json::Value _json;
+        _json["type"] = "EventLog";
+        _json["value"]["TxnHash"] = txnHash.hex();
+        _json["value"]["event_logs"] = logs;
+        conn.m_pending += MakeFrame(
+            OPCODE_TEXT, JSONUtils::GetInstance().convertJsontoStr(_json));
+      }
+    }
+  }
+}
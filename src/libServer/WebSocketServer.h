@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __WEBSOCKETSERVER_H__
+#define __WEBSOCKETSERVER_H__
+
+#include <event2/bufferevent.h>
+#include <event2/listener.h>
+#include <json/json.h>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "common/Singleton.h"
+#include "libData/AccountData/TransactionReceipt.h"
+#include "libData/BlockData/Block.h"
+
+/// Pushes committed blocks, txn confirmations and contract event logs to the
+/// WebSocket clients that subscribed to them, so that they need not poll the
+/// JSON-RPC server. Clients subscribe with text messages such as
+///   {"query":"NewBlock"}, {"query":"NewDSBlock"},
+///   {"query":"TxnConfirmation","hashes":["<txn hash>",...]},
+///   {"query":"EventLog","addresses":["<contract>",...],"events":[...]},
+///   {"query":"Unsubscribe","type":"<one of the queries above>"}
+/// An empty "events" list matches every event of the addresses.
+class WebSocketServer : public Singleton<WebSocketServer> {
+  struct Connection {
+    bool m_upgraded{false};
+    bool m_txBlocks{false};
+    bool m_dsBlocks{false};
+    std::unordered_set<TxnHash> m_txnHashes;
+    /// lowercase hex without the 0x prefix
+    std::unordered_set<std::string> m_logAddresses;
+    std::unordered_set<std::string> m_logEvents;
+    /// frames queued by the notifiers, written out by the event loop
+    std::string m_pending;
+  };
+
+  /// Guards m_connections. Only the event loop thread adds, removes or writes
+  /// to connections, the notifiers only queue frames into m_pending.
+  std::mutex m_mutexConnections;
+  std::unordered_map<struct bufferevent*, Connection> m_connections;
+
+  static void AcceptCallback(struct evconnlistener* listener,
+                             evutil_socket_t sock, struct sockaddr* addr,
+                             int socklen, void* ctx);
+  static void ReadCallback(struct bufferevent* bev, void* ctx);
+  static void EventCallback(struct bufferevent* bev, short events, void* ctx);
+  static void CloseWhenWrittenCallback(struct bufferevent* bev, void* ctx);
+  static void FlushCallback(evutil_socket_t fd, short events, void* ctx);
+
+  void RunEventLoop(unsigned int port);
+  void Close(struct bufferevent* bev);
+  void CloseWhenWritten(struct bufferevent* bev);
+  void FlushPending();
+
+  /// Returns false if the connection must be closed
+  bool ProcessHandshake(struct bufferevent* bev);
+  bool ProcessFrames(struct bufferevent* bev);
+  bool ProcessQuery(struct bufferevent* bev, const std::string& query);
+
+  void Send(struct bufferevent* bev, const Json::Value& _json);
+
+ public:
+  /// Listens on port from a thread of its own
+  void Start(unsigned int port);
+
+  void NotifyTxBlock(const TxBlock& txBlock);
+
+  void NotifyDSBlock(const DSBlock& dsBlock);
+
+  /// Confirms the committed txns to the clients waiting on them, and sends
+  /// their event logs to the clients whose filters match
+  void NotifyTxns(const std::vector<TransactionWithReceipt>& txns);
+
+  /// Frames a text or control message (unmasked, as sent by servers)
+  static std::string MakeFrame(unsigned char opcode,
+                               const std::string& payload);
+
+  /// The Sec-WebSocket-Accept value for a client's Sec-WebSocket-Key
+  static std::string GetAcceptKey(const std::string& clientKey);
+};
+
+#endif  // __WEBSOCKETSERVER_H__
@@ -0,0 +1,413 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iterator>
+
+#ifdef HAVE_IO_URING
+#include <linux/io_uring.h>
+#endif  // HAVE_IO_URING
+
+#include "AsyncFileWriter.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+
+#ifdef HAVE_IO_URING
+
+namespace {
+// Largest write of one entry, whose length is 32 bits
+const size_t MAX_WRITE_LEN = 1 << 30;
+}  // namespace
+
+/// Just enough of io_uring to write files, through the system calls as
+/// liburing is not a dependency. Used only by the writer thread, which is
+/// the only one to touch the submission queue and the completion queue.
+class AsyncFileWriter::IoUring {
+ public:
+  /// Returns nullptr if the kernel lacks io_uring or its write operation, or
+  /// does not let the process use it
+  static unique_ptr<IoUring> Create(const unsigned int entries);
+  ~IoUring();
+
+  unsigned int GetEntries() const { return m_entries; }
+
+  /// Queues a write of what is left of the request, submitted by Wait.
+  /// Caller keeps the writes in flight within GetEntries().
+  void QueueWrite(Request& request);
+
+  /// Submits the queued writes, waits for at least one to complete and calls
+  /// handle with the request and result of each completed one
+  bool Wait(const function<void(Request&, int)>& handle);
+
+ private:
+  explicit IoUring(const int fd) : m_fd(fd) {}
+  bool SupportsWrite() const;
+  bool Map(const io_uring_params& params);
+
+  const int m_fd;
+  unsigned int m_entries = 0;
+
+  void* m_sqRing = nullptr;
+  size_t m_sqRingSize = 0;
+  void* m_cqRing = nullptr;
+  size_t m_cqRingSize = 0;
+  io_uring_sqe* m_sqes = nullptr;
+  size_t m_sqesSize = 0;
+
+  unsigned int* m_sqHead = nullptr;
+  unsigned int* m_sqTail = nullptr;
+  unsigned int m_sqMask = 0;
+  unsigned int* m_sqArray = nullptr;
+  unsigned int* m_cqHead = nullptr;
+  unsigned int* m_cqTail = nullptr;
+  unsigned int m_cqMask = 0;
+  io_uring_cqe* m_cqes = nullptr;
+};
+
+unique_ptr<AsyncFileWriter::IoUring> AsyncFileWriter::IoUring::Create(
+    const unsigned int entries) {
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  const int fd = syscall(__NR_io_uring_setup, entries, &params);
+  if (fd < 0) {
+    LOG_GENERAL(INFO, "io_uring unavailable: " << strerror(errno));
+    return nullptr;
+  }
+
+  unique_ptr<IoUring> ring(new IoUring(fd));
+  if (!ring->SupportsWrite()) {
+    LOG_GENERAL(INFO, "io_uring cannot write files on this kernel");
+    return nullptr;
+  }
+  if (!ring->Map(params)) {
+    LOG_GENERAL(WARNING, "Cannot map io_uring: " << strerror(errno));
+    return nullptr;
+  }
+  return ring;
+}
+
+AsyncFileWriter::IoUring::~IoUring() {
+  if (m_sqes != nullptr) {
+    munmap(m_sqes, m_sqesSize);
+  }
+  if (m_cqRing != nullptr && m_cqRing != m_sqRing) {
+    munmap(m_cqRing, m_cqRingSize);
+  }
+  if (m_sqRing != nullptr) {
+    munmap(m_sqRing, m_sqRingSize);
+  }
+  close(m_fd);
+}
+
+bool AsyncFileWriter::IoUring::SupportsWrite() const {
+  const unsigned int numOps = 256;
+  vector<char> buffer(sizeof(io_uring_probe) +
+                      numOps * sizeof(io_uring_probe_op));
+  auto probe = reinterpret_cast<io_uring_probe*>(buffer.data());
+  if (syscall(__NR_io_uring_register, m_fd, IORING_REGISTER_PROBE, probe,
+              numOps) < 0) {
+    // Kernels before probing was added also lack IORING_OP_WRITE
+    return false;
+  }
+  return probe->last_op >= IORING_OP_WRITE &&
+         (probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED);
+}
+
+bool AsyncFileWriter::IoUring::Map(const io_uring_params& params) {
+  m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+  m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (singleMmap) {
+    m_sqRingSize = m_cqRingSize = max(m_sqRingSize, m_cqRingSize);
+  }
+
+  void* sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING);
+  if (sqRing == MAP_FAILED) {
+    return false;
+  }
+  m_sqRing = sqRing;
+
+  if (singleMmap) {
+    m_cqRing = m_sqRing;
+  } else {
+    void* cqRing = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING);
+    if (cqRing == MAP_FAILED) {
+      return false;
+    }
+    m_cqRing = cqRing;
+  }
+
+  m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE,
+                    MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED) {
+    return false;
+  }
+  m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+  char* sq = static_cast<char*>(m_sqRing);
+  m_sqHead = reinterpret_cast<unsigned int*>(sq + params.sq_off.head);
+  m_sqTail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+  m_sqMask = *reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+  m_sqArray = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+
+  char* cq = static_cast<char*>(m_cqRing);
+  m_cqHead = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+  m_cqTail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+  m_cqMask = *reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+  m_cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+  m_entries = params.sq_entries;
+  return true;
+}
+
+void AsyncFileWriter::IoUring::QueueWrite(Request& request) {
+  const unsigned int tail = *m_sqTail;
+  const unsigned int index = tail & m_sqMask;
+
+  io_uring_sqe& sqe = m_sqes[index];
+  memset(&sqe, 0, sizeof(sqe));
+  sqe.opcode = IORING_OP_WRITE;
+  sqe.fd = request.m_fd;
+  sqe.off = request.m_written;
+  sqe.addr = reinterpret_cast<uint64_t>(request.m_data.data() +
+                                        request.m_written);
+  sqe.len = min(request.m_data.size() - request.m_written, MAX_WRITE_LEN);
+  sqe.user_data = reinterpret_cast<uint64_t>(&request);
+
+  m_sqArray[index] = index;
+  // The kernel must see the entry before the new tail
+  __atomic_store_n(m_sqTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+bool AsyncFileWriter::IoUring::Wait(
+    const function<void(Request&, int)>& handle) {
+  const unsigned int toSubmit =
+      *m_sqTail - __atomic_load_n(m_sqHead, __ATOMIC_ACQUIRE);
+  if (syscall(__NR_io_uring_enter, m_fd, toSubmit, 1, IORING_ENTER_GETEVENTS,
+              nullptr, 0) < 0 &&
+      errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+    LOG_GENERAL(WARNING, "io_uring_enter failed: " << strerror(errno));
+    return false;
+  }
+
+  unsigned int head = *m_cqHead;
+  const unsigned int tail = __atomic_load_n(m_cqTail, __ATOMIC_ACQUIRE);
+  for (; head != tail; ++head) {
+    const io_uring_cqe& cqe = m_cqes[head & m_cqMask];
+    Request& request = *reinterpret_cast<Request*>(cqe.user_data);
+    const int res = cqe.res;
+    handle(request, res);
+  }
+  __atomic_store_n(m_cqHead, head, __ATOMIC_RELEASE);
+  return true;
+}
+
+bool AsyncFileWriter::WriteWithRing(vector<Request*>& requests) {
+  size_t next = 0;
+  unsigned int inFlight = 0;
+
+  const auto handle = [this, &inFlight](Request& request, const int res) {
+    --inFlight;
+    if (res == -EINTR || res == -EAGAIN) {
+      m_ring->QueueWrite(request);
+      ++inFlight;
+      return;
+    }
+    if (res <= 0) {
+      LOG_GENERAL(WARNING, "Failed to write " << request.m_filename << ": "
+                                              << strerror(-res));
+      Complete(request, false);
+      return;
+    }
+
+    request.m_written += res;
+    if (request.m_written < request.m_data.size()) {
+      m_ring->QueueWrite(request);
+      ++inFlight;
+    } else {
+      Complete(request, true);
+    }
+  };
+
+  while (next < requests.size() || inFlight > 0) {
+    while (next < requests.size() && inFlight < m_ring->GetEntries()) {
+      Request& request = *requests[next++];
+      if (request.m_data.empty()) {
+        Complete(request, true);
+        continue;
+      }
+      m_ring->QueueWrite(request);
+      ++inFlight;
+    }
+    if (inFlight > 0 && !m_ring->Wait(handle)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+#else  // HAVE_IO_URING
+
+class AsyncFileWriter::IoUring {};
+
+bool AsyncFileWriter::WriteWithRing(
+    [[gnu::unused]] vector<Request*>& requests) {
+  return false;
+}
+
+#endif  // HAVE_IO_URING
+
+AsyncFileWriter::AsyncFileWriter(
+    [[gnu::unused]] const bool useIoUring,
+    [[gnu::unused]] const unsigned int queueDepth)
+    : m_usesIoUring(false), m_pool(1, "AsyncFileWriter") {
+#ifdef HAVE_IO_URING
+  if (useIoUring) {
+    m_ring = IoUring::Create(max(queueDepth, 1u));
+  }
+#endif  // HAVE_IO_URING
+  m_usesIoUring = m_ring != nullptr;
+  LOG_GENERAL(INFO,
+              "Writing files " << (m_ring ? "through io_uring" : "directly"));
+
+  m_thread = thread([this]() { Run(); });
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+  {
+    lock_guard<mutex> g(m_mutex);
+    m_stop = true;
+  }
+  m_cv.notify_all();
+  m_thread.join();
+}
+
+void AsyncFileWriter::Write(const string& filename, bytes&& data,
+                            Callback done) {
+  {
+    lock_guard<mutex> g(m_mutex);
+    m_requests.push_back({filename, move(data), move(done), -1, 0});
+  }
+  m_cv.notify_all();
+}
+
+void AsyncFileWriter::Run() {
+  while (true) {
+    vector<Request> batch;
+    {
+      unique_lock<mutex> lock(m_mutex);
+      // Callbacks may queue more writes, so stop only once they have run
+      m_cv.wait(lock, [this]() {
+        return !m_requests.empty() || (m_stop && m_pendingCallbacks == 0);
+      });
+      if (m_requests.empty()) {
+        return;
+      }
+      batch.assign(make_move_iterator(m_requests.begin()),
+                   make_move_iterator(m_requests.end()));
+      m_requests.clear();
+    }
+    WriteBatch(batch);
+  }
+}
+
+void AsyncFileWriter::WriteBatch(vector<Request>& batch) {
+  vector<Request*> opened;
+  for (auto& request : batch) {
+    request.m_fd = open(request.m_filename.c_str(),
+                        O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (request.m_fd < 0) {
+      LOG_GENERAL(WARNING, "Cannot create " << request.m_filename << ": "
+                                            << strerror(errno));
+      Complete(request, false);
+    } else {
+      opened.push_back(&request);
+    }
+  }
+
+  if (m_ring && !WriteWithRing(opened)) {
+    LOG_GENERAL(WARNING, "Writing files directly from now on");
+    m_ring.reset();
+    m_usesIoUring = false;
+  }
+
+  // All of them if there is no ring, else those left by a failed one
+  for (auto request : opened) {
+    if (request->m_fd >= 0) {
+      request->m_written = 0;
+      Complete(*request, WriteDirectly(*request));
+    }
+  }
+}
+
+bool AsyncFileWriter::WriteDirectly(Request& request) {
+  while (request.m_written < request.m_data.size()) {
+    const ssize_t res =
+        pwrite(request.m_fd, request.m_data.data() + request.m_written,
+               request.m_data.size() - request.m_written, request.m_written);
+    if (res < 0 && errno == EINTR) {
+      continue;
+    }
+    if (res <= 0) {
+      LOG_GENERAL(WARNING, "Failed to write " << request.m_filename << ": "
+                                              << strerror(errno));
+      return false;
+    }
+    request.m_written += res;
+  }
+  return true;
+}
+
+void AsyncFileWriter::Complete(Request& request, bool ok) {
+  if (request.m_fd >= 0) {
+    if (close(request.m_fd) != 0 && ok) {
+      LOG_GENERAL(WARNING, "Failed to close " << request.m_filename << ": "
+                                              << strerror(errno));
+      ok = false;
+    }
+    request.m_fd = -1;
+  }
+  bytes().swap(request.m_data);
+
+  if (!request.m_done) {
+    return;
+  }
+
+  {
+    lock_guard<mutex> g(m_mutex);
+    ++m_pendingCallbacks;
+  }
+  Callback done = move(request.m_done);
+  m_pool.AddJob([this, done, ok]() {
+    done(ok);
+    {
+      lock_guard<mutex> g(m_mutex);
+      --m_pendingCallbacks;
+    }
+    m_cv.notify_all();
+  });
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __ASYNCFILEWRITER_H__
+#define __ASYNCFILEWRITER_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "common/BaseType.h"
+#include "common/Constants.h"
+#include "common/Singleton.h"
+#include "libUtils/ThreadPool.h"
+
+/// Writes whole files off the calling thread, so that disk latency does not
+/// hold up the epoch. One thread takes the queued writes in batches and, where
+/// the kernel allows it, submits the batch to an io_uring so that the files
+/// are written concurrently; otherwise it writes them one after the other.
+/// Each write then calls back on a thread pool with whether it succeeded.
+class AsyncFileWriter : public Singleton<AsyncFileWriter> {
+ public:
+  typedef std::function<void(bool)> Callback;
+
+  explicit AsyncFileWriter(
+      const bool useIoUring = ASYNC_IO_USE_IO_URING,
+      const unsigned int queueDepth = ASYNC_IO_QUEUE_DEPTH);
+  ~AsyncFileWriter();
+
+  /// Replaces the content of filename with data, then calls done. Writes
+  /// are started in the order they are queued, but may complete otherwise.
+  void Write(const std::string& filename, bytes&& data, Callback done);
+
+  /// Whether the writes go through an io_uring
+  bool UsesIoUring() const { return m_usesIoUring; }
+
+ private:
+  struct Request {
+    std::string m_filename;
+    bytes m_data;
+    Callback m_done;
+    int m_fd;
+    size_t m_written;
+  };
+
+  class IoUring;
+
+  void Run();
+  void WriteBatch(std::vector<Request>& batch);
+  /// Returns false if the ring failed, leaving the unwritten requests to the
+  /// caller
+  bool WriteWithRing(std::vector<Request*>& requests);
+  static bool WriteDirectly(Request& request);
+  void Complete(Request& request, bool ok);
+
+  /// Used only by the writer thread, and dropped if it fails
+  std::unique_ptr<IoUring> m_ring;
+  std::atomic<bool> m_usesIoUring;
+
+  std::deque<Request> m_requests;
+  /// Callbacks handed to the pool and not yet run, which destruction waits
+  /// for along with the writes they queue
+  unsigned int m_pendingCallbacks = 0;
+  bool m_stop = false;
+  std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::thread m_thread;
+
+  /// Runs the callbacks
+  ThreadPool m_pool;
+};
+
+#endif  // __ASYNCFILEWRITER_H__
@@ -19,6 +19,89 @@
 
 using namespace std;
 
+BitVector::BitVector(size_t size, bool value)
+    : m_words((size + 63) >> 6, value ? ~0ull : 0), m_size(size) {
+  ClearTail();
+}
+
+BitVector::BitVector(const vector<bool>& bits) : BitVector(bits.size()) {
+  for (size_t index = 0; index < bits.size(); index++) {
+    if (bits[index]) {
+      m_words[index >> 6] |= Mask(index);
+    }
+  }
+}
+
+void BitVector::resize(size_t size, bool value) {
+  const size_t oldSize = m_size;
+  m_words.resize((size + 63) >> 6, value ? ~0ull : 0);
+  m_size = size;
+
+  // Bits of the old last word past the old size are clear
+  if (value) {
+    for (size_t index = oldSize; index < size && (index & 63) != 0; index++) {
+      m_words[index >> 6] |= Mask(index);
+    }
+  }
+  ClearTail();
+}
+
+void BitVector::Fill(bool value) {
+  fill(m_words.begin(), m_words.end(), value ? ~0ull : 0);
+  ClearTail();
+}
+
+size_t BitVector::Count() const {
+  size_t count = 0;
+  for (const uint64_t word : m_words) {
+    count += __builtin_popcountll(word);
+  }
+  return count;
+}
+
+size_t BitVector::CountDifferent(const BitVector& other) const {
+  size_t count = 0;
+  for (size_t w = 0; w < m_words.size() && w < other.m_words.size(); w++) {
+    count += __builtin_popcountll(m_words[w] ^ other.m_words[w]);
+  }
+  return count;
+}
+
+BitVector& BitVector::operator&=(const BitVector& other) {
+  for (size_t w = 0; w < m_words.size() && w < other.m_words.size(); w++) {
+    m_words[w] &= other.m_words[w];
+  }
+  return *this;
+}
+
+BitVector& BitVector::operator|=(const BitVector& other) {
+  for (size_t w = 0; w < m_words.size() && w < other.m_words.size(); w++) {
+    m_words[w] |= other.m_words[w];
+  }
+  ClearTail();
+  return *this;
+}
+
+BitVector& BitVector::operator^=(const BitVector& other) {
+  for (size_t w = 0; w < m_words.size() && w < other.m_words.size(); w++) {
+    m_words[w] ^= other.m_words[w];
+  }
+  ClearTail();
+  return *this;
+}
+
+vector<bool> BitVector::ToVector() const {
+  vector<bool> bits(m_size, false);
+  ForEachSet([&bits](size_t index) { bits[index] = true; });
+  return bits;
+}
+
+void BitVector::ClearTail() {
+  if ((m_size & 63) != 0) {
+    m_words.back() &= ~0ull << (64 - (m_size & 63));
+  }
+}
+
 unsigned int BitVector::GetBitVectorLengthInBytes(unsigned int length_in_bits) {
   return (((length_in_bits & 0x07) > 0) ? (length_in_bits >> 3) + 1
                                         : length_in_bits >> 3);
@@ -76,22 +159,23 @@ std::vector<bool> BitVector::GetBitVector(const bytes& src,
 
 unsigned int BitVector::SetBitVector(bytes& dst, unsigned int offset,
                                      const std::vector<bool>& value) {
+  return SetBitVector(dst, offset, BitVector(value));
+}
+
+unsigned int BitVector::SetBitVector(bytes& dst, unsigned int offset,
+                                     const BitVector& value) {
   const unsigned int length_needed = GetBitVectorSerializedSize(value.size());
 
   if ((offset + length_needed) > dst.size()) {
     dst.resize(offset + length_needed);
   }
-  fill(dst.begin() + offset, dst.begin() + offset + length_needed, 0x00);
 
   dst.at(offset) = value.size() >> 8;
   dst.at(offset + 1) = value.size();
 
-  unsigned int index = 0;
-  for (bool b : value) {
-    if (b) {
-      dst.at(offset + 2 + (index >> 3)) |= (1 << (7 - (index & 0x07)));
-    }
-    index++;
+  // The words hold the bytes in order, most significant first
+  for (unsigned int i = 0; i < length_needed - 2; i++) {
+    dst[offset + 2 + i] = value.m_words[i >> 3] >> (56 - ((i & 7) << 3));
   }
 
   return length_needed;
@@ -18,10 +18,104 @@
 #ifndef __BITVECTOR_H__
 #define __BITVECTOR_H__
 
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
 #include "common/BaseType.h"
 
+/// Bitmap packed into 64-bit words, as used for the members of a committee
+/// (cosignature and commit maps). Bit i is bit 63 - i % 64 of word i / 64, so
+/// that the words, written out big-endian, are the serialized bytes directly.
 class BitVector {
  public:
+  /// Reference to one bit, for writing through at() or []
+  class Reference {
+   public:
+    Reference(uint64_t& word, uint64_t mask) : m_word(word), m_mask(mask) {}
+
+    Reference& operator=(bool value) {
+      if (value) {
+        m_word |= m_mask;
+      } else {
+        m_word &= ~m_mask;
+      }
+      return *this;
+    }
+
+    Reference& operator=(const Reference& other) {
+      return *this = static_cast<bool>(other);
+    }
+
+    operator bool() const { return (m_word & m_mask) != 0; }
+
+   private:
+    uint64_t& m_word;
+    const uint64_t m_mask;
+  };
+
+  explicit BitVector(size_t size = 0, bool value = false);
+  explicit BitVector(const std::vector<bool>& bits);
+
+  size_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  bool operator[](size_t index) const {
+    return (m_words[index >> 6] & Mask(index)) != 0;
+  }
+  Reference operator[](size_t index) {
+    return Reference(m_words[index >> 6], Mask(index));
+  }
+
+  /// As [], but throws std::out_of_range like std::vector::at
+  bool at(size_t index) const {
+    CheckIndex(index);
+    return (*this)[index];
+  }
+  Reference at(size_t index) {
+    CheckIndex(index);
+    return (*this)[index];
+  }
+
+  void resize(size_t size, bool value = false);
+  void clear() {
+    m_words.clear();
+    m_size = 0;
+  }
+
+  /// Sets every bit to value, keeping the size
+  void Fill(bool value);
+
+  /// Number of bits set
+  size_t Count() const;
+
+  /// Number of bits that differ from other, which must be of the same size
+  size_t CountDifferent(const BitVector& other) const;
+
+  /// Calls f(index) for each bit set, in increasing order
+  template <class F>
+  void ForEachSet(F&& f) const {
+    for (size_t w = 0; w < m_words.size(); w++) {
+      for (uint64_t word = m_words[w]; word != 0;) {
+        const unsigned int bit = __builtin_clzll(word);
+        f((w << 6) + bit);
+        word ^= Mask(bit);
+      }
+    }
+  }
+
+  /// Bitwise operations with a bitmap of the same size
+  BitVector& operator&=(const BitVector& other);
+  BitVector& operator|=(const BitVector& other);
+  BitVector& operator^=(const BitVector& other);
+
+  bool operator==(const BitVector& other) const {
+    return m_size == other.m_size && m_words == other.m_words;
+  }
+  bool operator!=(const BitVector& other) const { return !(*this == other); }
+
+  std::vector<bool> ToVector() const;
+
   static unsigned int GetBitVectorLengthInBytes(unsigned int length_in_bits);
   static unsigned int GetBitVectorSerializedSize(unsigned int length_in_bits);
   static std::vector<bool> GetBitVector(const bytes& src, unsigned int offset,
@@ -29,6 +123,23 @@ class BitVector {
   static std::vector<bool> GetBitVector(const bytes& src, unsigned int offset);
   static unsigned int SetBitVector(bytes& dst, unsigned int offset,
                                    const std::vector<bool>& value);
+  static unsigned int SetBitVector(bytes& dst, unsigned int offset,
+                                   const BitVector& value);
+
+ private:
+  static uint64_t Mask(size_t index) { return 1ull << (63 - (index & 63)); }
+
+  void CheckIndex(size_t index) const {
+    if (index >= m_size) {
+      throw std::out_of_range("BitVector index out of range");
+    }
+  }
+
+  /// Clears the bits past size in the last word, which Count and == rely on
+  void ClearTail();
+
+  std::vector<uint64_t> m_words;
+  size_t m_size;
 };
 
 #endif  // __BITVECTOR_H__
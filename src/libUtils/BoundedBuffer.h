@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BOUNDEDBUFFER_H__
+#define __BOUNDEDBUFFER_H__
+
+#include <cstdint>
+#include <deque>
+#include <utility>
+#include <vector>
+
+/// Holds entries in arrival order, each filed under an epoch, within a budget
+/// of bytes; a budget of 0 disables the limit. Making room for a new entry
+/// drops the oldest entries first, so a lagging node keeps the most recent
+/// messages rather than running out of memory. Not thread-safe, the owner
+/// keeps it under its own mutex.
+template <class Entry>
+class BoundedBuffer {
+  struct Item {
+    uint64_t m_epoch;
+    Entry m_entry;
+    uint64_t m_bytes;
+  };
+
+  const uint64_t m_budget;
+  std::deque<Item> m_items;
+  uint64_t m_bytes = 0;
+
+ public:
+  explicit BoundedBuffer(uint64_t budget) : m_budget(budget) {}
+
+  /// Adds entry, whose size the caller gives as bytes. Returns the number of
+  /// entries dropped, which counts entry itself if it alone is over budget.
+  unsigned int Push(uint64_t epoch, Entry entry, uint64_t bytes) {
+    if (m_budget > 0 && bytes > m_budget) {
+      return 1;
+    }
+
+    unsigned int dropped = 0;
+    while (m_budget > 0 && !m_items.empty() && m_bytes + bytes > m_budget) {
+      m_bytes -= m_items.front().m_bytes;
+      m_items.pop_front();
+      dropped++;
+    }
+    m_items.push_back({epoch, std::move(entry), bytes});
+    m_bytes += bytes;
+    return dropped;
+  }
+
+  /// Removes and returns the entries of epoch, in arrival order
+  std::vector<Entry> Take(uint64_t epoch) {
+    std::vector<Entry> entries;
+    for (auto it = m_items.begin(); it != m_items.end();) {
+      if (it->m_epoch == epoch) {
+        m_bytes -= it->m_bytes;
+        entries.emplace_back(std::move(it->m_entry));
+        it = m_items.erase(it);
+      } else {
+        it++;
+      }
+    }
+    return entries;
+  }
+
+  /// Removes and returns all entries with their epochs, in arrival order
+  std::vector<std::pair<uint64_t, Entry>> TakeAll() {
+    std::vector<std::pair<uint64_t, Entry>> entries;
+    entries.reserve(m_items.size());
+    for (auto& item : m_items) {
+      entries.emplace_back(item.m_epoch, std::move(item.m_entry));
+    }
+    Clear();
+    return entries;
+  }
+
+  /// Drops the entries of the epochs before epoch
+  void EraseBefore(uint64_t epoch) {
+    for (auto it = m_items.begin(); it != m_items.end();) {
+      if (it->m_epoch < epoch) {
+        m_bytes -= it->m_bytes;
+        it = m_items.erase(it);
+      } else {
+        it++;
+      }
+    }
+  }
+
+  void Clear() {
+    m_items.clear();
+    m_bytes = 0;
+  }
+
+  bool Empty() const { return m_items.empty(); }
+  uint64_t Size() const { return m_items.size(); }
+  uint64_t Bytes() const { return m_bytes; }
+};
+
+#endif  // __BOUNDEDBUFFER_H__
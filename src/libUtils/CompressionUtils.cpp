@@ -0,0 +1,81 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <zlib.h>
+
+#include "CompressionUtils.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+
+static const unsigned int ORIGINAL_LENGTH_LEN = 4;
+
+bool CompressionUtils::Compress(const bytes& src, bytes& dst) {
+  if (src.size() > UINT32_MAX) {
+    LOG_GENERAL(WARNING, "Data too large to compress: " << src.size());
+    return false;
+  }
+
+  uLongf compressed_len = compressBound(src.size());
+  dst.resize(ORIGINAL_LENGTH_LEN + compressed_len);
+
+  const uint32_t original_len = src.size();
+  dst[0] = (original_len >> 24) & 0xFF;
+  dst[1] = (original_len >> 16) & 0xFF;
+  dst[2] = (original_len >> 8) & 0xFF;
+  dst[3] = original_len & 0xFF;
+
+  int ret = compress2(dst.data() + ORIGINAL_LENGTH_LEN, &compressed_len,
+                      src.data(), src.size(), Z_BEST_SPEED);
+  if (ret != Z_OK) {
+    LOG_GENERAL(WARNING, "compress2 failed. Code = " << ret);
+    return false;
+  }
+
+  dst.resize(ORIGINAL_LENGTH_LEN + compressed_len);
+  return true;
+}
+
+bool CompressionUtils::Decompress(const unsigned char* src, size_t len,
+                                  size_t max_size, bytes& dst) {
+  if (len <= ORIGINAL_LENGTH_LEN) {
+    LOG_GENERAL(WARNING, "Compressed data too short: " << len);
+    return false;
+  }
+
+  const uint32_t original_len =
+      (src[0] << 24) + (src[1] << 16) + (src[2] << 8) + src[3];
+
+  // Never trust the advertised length beyond what we would accept anyway
+  if (original_len == 0 || original_len > max_size) {
+    LOG_GENERAL(WARNING, "Unexpected decompressed length: "
+                             << original_len << " (max " << max_size << ")");
+    return false;
+  }
+
+  dst.resize(original_len);
+  uLongf decompressed_len = original_len;
+
+  int ret = uncompress(dst.data(), &decompressed_len, src + ORIGINAL_LENGTH_LEN,
+                       len - ORIGINAL_LENGTH_LEN);
+  if (ret != Z_OK || decompressed_len != original_len) {
+    LOG_GENERAL(WARNING, "uncompress failed. Code = " << ret);
+    return false;
+  }
+
+  return true;
+}
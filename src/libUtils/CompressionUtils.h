@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __COMPRESSIONUTILS_H__
+#define __COMPRESSIONUTILS_H__
+
+#include "common/BaseType.h"
+
+/// Utility class for compressing message payloads sent over the wire.
+/// Compressed data is laid out as [4-byte original length][deflate stream].
+class CompressionUtils {
+ public:
+  /// Compresses src into dst using the fastest deflate level.
+  static bool Compress(const bytes& src, bytes& dst);
+
+  /// Decompresses len bytes at src into dst, rejecting data that would
+  /// expand beyond max_size bytes.
+  static bool Decompress(const unsigned char* src, size_t len, size_t max_size,
+                         bytes& dst);
+};
+
+#endif  // __COMPRESSIONUTILS_H__
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "DNSCache.h"
+#include "common/Constants.h"
+#include "libUtils/DetachedFunction.h"
+#include "libUtils/IPConverter.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+using namespace boost::multiprecision;
+
+DNSCache::DNSCache() {}
+
+DNSCache::~DNSCache() {}
+
+DNSCache& DNSCache::GetInstance() {
+  static DNSCache cache;
+  return cache;
+}
+
+void DNSCache::ScheduleRefresh(const string& hostname, const uint32_t port,
+                               Entry& entry) {
+  if (entry.m_refreshing) {
+    return;
+  }
+  entry.m_refreshing = true;
+
+  auto func = [this, hostname, port]() -> void {
+    uint128_t ip;
+    bool resolved = IPConverter::ResolveDNS(hostname, port, ip);
+
+    lock_guard<mutex> g(m_mutexEntries);
+    auto& entry = m_entries[hostname];
+    entry.m_refreshing = false;
+
+    if (!resolved) {
+      // Keep serving the last known ip, the next Get will retry
+      LOG_GENERAL(WARNING, "Unable to resolve DNS for " << hostname);
+      return;
+    }
+
+    if (entry.m_resolved && entry.m_ip != ip) {
+      LOG_GENERAL(INFO, hostname << " moved from "
+                                 << IPConverter::ToStrFromNumericalIP(
+                                        entry.m_ip)
+                                 << " to "
+                                 << IPConverter::ToStrFromNumericalIP(ip));
+    }
+
+    entry.m_ip = ip;
+    entry.m_resolved = true;
+    entry.m_resolvedAt = chrono::steady_clock::now();
+  };
+
+  DetachedFunction(1, func);
+}
+
+bool DNSCache::Get(const string& hostname, const uint32_t port,
+                   uint128_t& ip) {
+  lock_guard<mutex> g(m_mutexEntries);
+
+  auto& entry = m_entries[hostname];
+
+  if (!entry.m_resolved ||
+      chrono::steady_clock::now() - entry.m_resolvedAt >
+          chrono::seconds(DNS_CACHE_TTL_IN_SECONDS)) {
+    ScheduleRefresh(hostname, port, entry);
+  }
+
+  if (!entry.m_resolved) {
+    return false;
+  }
+
+  ip = entry.m_ip;
+  return true;
+}
+
+void DNSCache::Prefetch(const string& hostname, const uint32_t port) {
+  lock_guard<mutex> g(m_mutexEntries);
+
+  auto& entry = m_entries[hostname];
+  if (!entry.m_resolved) {
+    ScheduleRefresh(hostname, port, entry);
+  }
+}
+
+void DNSCache::Clear() {
+  lock_guard<mutex> g(m_mutexEntries);
+  m_entries.clear();
+}
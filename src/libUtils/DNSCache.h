@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __DNSCACHE_H__
+#define __DNSCACHE_H__
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include <boost/multiprecision/cpp_int.hpp>
+#pragma GCC diagnostic pop
+
+/// Caches DNS lookups of lookup and seed hostnames so that senders never
+/// wait on the resolver. Entries older than DNS_CACHE_TTL_IN_SECONDS keep
+/// being served while they are refreshed on a detached thread.
+class DNSCache {
+  struct Entry {
+    boost::multiprecision::uint128_t m_ip = 0;
+    bool m_resolved = false;
+    bool m_refreshing = false;
+    std::chrono::time_point<std::chrono::steady_clock> m_resolvedAt;
+  };
+
+  std::mutex m_mutexEntries;
+  std::map<std::string, Entry> m_entries;
+
+  DNSCache();
+  ~DNSCache();
+
+  // Singleton should not implement these
+  DNSCache(DNSCache const&) = delete;
+  void operator=(DNSCache const&) = delete;
+
+  /// Starts resolving the hostname unless that is already in progress.
+  /// Caller must hold m_mutexEntries.
+  void ScheduleRefresh(const std::string& hostname, const uint32_t port,
+                       Entry& entry);
+
+ public:
+  /// Returns the singleton DNSCache instance.
+  static DNSCache& GetInstance();
+
+  /// Returns the last resolved ip of the hostname without blocking. Unknown
+  /// or expired hostnames are (re)resolved in the background.
+  bool Get(const std::string& hostname, const uint32_t port,
+           boost::multiprecision::uint128_t& ip);
+
+  /// Resolves the hostname in the background so that later calls to Get hit
+  void Prefetch(const std::string& hostname, const uint32_t port);
+
+  /// Drops all cached entries
+  void Clear();
+};
+
+#endif  // __DNSCACHE_H__
@@ -17,8 +17,218 @@
 
 #include "DataConversion.h"
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HEX_SIMD_X86
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#define HEX_SIMD_NEON
+#endif
+
 using namespace std;
 
+namespace {
+
+const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+/// Value of each character as a hex digit, or 0xFF if it is not one.
+/// Built at compile time, so it is ready for other static initializers.
+struct HexValues {
+  uint8_t m_values[256];
+
+  constexpr HexValues() : m_values{} {
+    for (unsigned int c = 0; c < 256; c++) {
+      m_values[c] = (c >= '0' && c <= '9')   ? c - '0'
+                    : (c >= 'A' && c <= 'F') ? c - 'A' + 10
+                    : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                                             : 0xFF;
+    }
+  }
+};
+
+constexpr HexValues HEX_VALUES;
+
+void BytesToHexScalar(const uint8_t* input, size_t size, char* out) {
+  for (size_t i = 0; i < size; i++) {
+    out[2 * i] = HEX_DIGITS[input[i] >> 4];
+    out[2 * i + 1] = HEX_DIGITS[input[i] & 0x0F];
+  }
+}
+
+bool HexToBytesScalar(const char* input, size_t size, uint8_t* out) {
+  for (size_t i = 0; i + 1 < size; i += 2) {
+    const uint8_t high = HEX_VALUES.m_values[(uint8_t)input[i]];
+    const uint8_t low = HEX_VALUES.m_values[(uint8_t)input[i + 1]];
+    if ((high | low) == 0xFF) {
+      return false;
+    }
+    out[i / 2] = (high << 4) | low;
+  }
+  return true;
+}
+
+// The vector paths take 16 bytes, or 32 digits, at a time, and leave the
+// remainder to the scalar ones. A block with a non-hex character is also
+// left to the scalar path, to stop at it.
+
+#ifdef HEX_SIMD_X86
+#define HEX_SSSE3 __attribute__((target("ssse3")))
+
+const bool HAS_SSSE3 = []() {
+  // Needed before the first constructors run
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("ssse3") != 0;
+}();
+
+HEX_SSSE3 size_t BytesToHexSsse3(const uint8_t* input, size_t size,
+                                 char* out) {
+  const __m128i digits = _mm_loadu_si128(
+      reinterpret_cast<const __m128i*>(static_cast<const char*>(HEX_DIGITS)));
+  const __m128i lowNibble = _mm_set1_epi8(0x0F);
+
+  size_t done = 0;
+  for (; done + 16 <= size; done += 16) {
+    const __m128i bytes =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + done));
+    const __m128i high = _mm_shuffle_epi8(
+        digits, _mm_and_si128(_mm_srli_epi16(bytes, 4), lowNibble));
+    const __m128i low =
+        _mm_shuffle_epi8(digits, _mm_and_si128(bytes, lowNibble));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * done),
+                     _mm_unpacklo_epi8(high, low));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 2 * done + 16),
+                     _mm_unpackhi_epi8(high, low));
+  }
+  return done;
+}
+
+/// Values of 16 hex digits, or false if one is not a hex digit
+HEX_SSSE3 inline bool HexValuesSsse3(__m128i chars, __m128i& values) {
+  const __m128i lower = _mm_or_si128(chars, _mm_set1_epi8(0x20));
+  // Signed compares, so characters from 0x80 fall in neither range
+  const __m128i isDigit =
+      _mm_and_si128(_mm_cmpgt_epi8(chars, _mm_set1_epi8('0' - 1)),
+                    _mm_cmplt_epi8(chars, _mm_set1_epi8('9' + 1)));
+  const __m128i isLetter =
+      _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+                    _mm_cmplt_epi8(lower, _mm_set1_epi8('f' + 1)));
+  if (_mm_movemask_epi8(_mm_or_si128(isDigit, isLetter)) != 0xFFFF) {
+    return false;
+  }
+
+  values = _mm_or_si128(
+      _mm_and_si128(isDigit, _mm_sub_epi8(chars, _mm_set1_epi8('0'))),
+      _mm_and_si128(isLetter, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+  return true;
+}
+
+HEX_SSSE3 size_t HexToBytesSsse3(const char* input, size_t size,
+                                 uint8_t* out) {
+  // Each pair of digits becomes 16 * high + low
+  const __m128i weights = _mm_set1_epi16(0x0110);
+
+  size_t done = 0;
+  for (; done + 32 <= size; done += 32) {
+    __m128i first, second;
+    if (!HexValuesSsse3(_mm_loadu_si128(
+                            reinterpret_cast<const __m128i*>(input + done)),
+                        first) ||
+        !HexValuesSsse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(
+                            input + done + 16)),
+                        second)) {
+      break;
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + done / 2),
+                     _mm_packus_epi16(_mm_maddubs_epi16(first, weights),
+                                      _mm_maddubs_epi16(second, weights)));
+  }
+  return done;
+}
+
+#undef HEX_SSSE3
+#endif  // HEX_SIMD_X86
+
+#ifdef HEX_SIMD_NEON
+size_t BytesToHexNeon(const uint8_t* input, size_t size, char* out) {
+  const uint8x16_t digits =
+      vld1q_u8(reinterpret_cast<const uint8_t*>(HEX_DIGITS));
+
+  size_t done = 0;
+  for (; done + 16 <= size; done += 16) {
+    const uint8x16_t bytes = vld1q_u8(input + done);
+    uint8x16x2_t chars;
+    chars.val[0] = vqtbl1q_u8(digits, vshrq_n_u8(bytes, 4));
+    chars.val[1] = vqtbl1q_u8(digits, vandq_u8(bytes, vdupq_n_u8(0x0F)));
+    vst2q_u8(reinterpret_cast<uint8_t*>(out + 2 * done), chars);
+  }
+  return done;
+}
+
+/// Values of 16 hex digits, or false if one is not a hex digit
+inline bool HexValuesNeon(uint8x16_t chars, uint8x16_t& values) {
+  const uint8x16_t digit = vsubq_u8(chars, vdupq_n_u8('0'));
+  const uint8x16_t letter =
+      vsubq_u8(vorrq_u8(chars, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+  // Unsigned, so characters below the range wrap around above it
+  const uint8x16_t isDigit = vcltq_u8(digit, vdupq_n_u8(10));
+  const uint8x16_t isLetter = vcltq_u8(letter, vdupq_n_u8(6));
+  if (vminvq_u8(vorrq_u8(isDigit, isLetter)) == 0) {
+    return false;
+  }
+
+  values = vbslq_u8(isDigit, digit, vaddq_u8(letter, vdupq_n_u8(10)));
+  return true;
+}
+
+size_t HexToBytesNeon(const char* input, size_t size, uint8_t* out) {
+  size_t done = 0;
+  for (; done + 32 <= size; done += 32) {
+    // Deinterleaved, so val[0] holds the high digits and val[1] the low
+    const uint8x16x2_t chars =
+        vld2q_u8(reinterpret_cast<const uint8_t*>(input + done));
+    uint8x16_t high, low;
+    if (!HexValuesNeon(chars.val[0], high) ||
+        !HexValuesNeon(chars.val[1], low)) {
+      break;
+    }
+    vst1q_u8(out + done / 2, vorrq_u8(vshlq_n_u8(high, 4), low));
+  }
+  return done;
+}
+#endif  // HEX_SIMD_NEON
+
+}  // namespace
+
+void DataConversion::BytesToHex(const uint8_t* input, size_t size,
+                                char* out) {
+  size_t done = 0;
+#if defined(HEX_SIMD_X86)
+  if (HAS_SSSE3) {
+    done = BytesToHexSsse3(input, size, out);
+  }
+#elif defined(HEX_SIMD_NEON)
+  done = BytesToHexNeon(input, size, out);
+#endif
+  BytesToHexScalar(input + done, size - done, out + 2 * done);
+}
+
+bool DataConversion::HexToBytes(const char* input, size_t size,
+                                uint8_t* out) {
+  if (size % 2 != 0) {
+    return false;
+  }
+
+  size_t done = 0;
+#if defined(HEX_SIMD_X86)
+  if (HAS_SSSE3) {
+    done = HexToBytesSsse3(input, size, out);
+  }
+#elif defined(HEX_SIMD_NEON)
+  done = HexToBytesNeon(input, size, out);
+#endif
+  return HexToBytesScalar(input + done, size - done, out + done / 2);
+}
+
 bool DataConversion::HexStringToUint64(const std::string& s, uint64_t* res) {
   try {
     *res = std::stoull(s, nullptr, 16);
@@ -33,11 +243,9 @@ bool DataConversion::HexStringToUint64(const std::string& s, uint64_t* res) {
 }
 
 bool DataConversion::HexStrToUint8Vec(const string& hex_input, bytes& out) {
-  try {
+  out.resize(hex_input.size() / 2);
+  if (!HexToBytes(hex_input.data(), hex_input.size(), out.data())) {
     out.clear();
-    boost::algorithm::unhex(hex_input.begin(), hex_input.end(),
-                            back_inserter(out));
-  } catch (exception& e) {
     LOG_GENERAL(WARNING, "Failed HexStrToUint8Vec conversion");
     return false;
   }
@@ -69,26 +277,19 @@ bool DataConversion::HexStrToStdArray64(const string& hex_input,
 }
 
 bool DataConversion::Uint8VecToHexStr(const bytes& hex_vec, string& str) {
-  try {
-    str = "";
-    boost::algorithm::hex(hex_vec.begin(), hex_vec.end(), back_inserter(str));
-  } catch (exception& e) {
-    LOG_GENERAL(WARNING, "Failed Uint8VecToHexStr conversion");
-    return false;
-  }
+  str.resize(2 * hex_vec.size());
+  BytesToHex(hex_vec.data(), hex_vec.size(), &str[0]);
   return true;
 }
 
 bool DataConversion::Uint8VecToHexStr(const bytes& hex_vec, unsigned int offset,
                                       unsigned int len, string& str) {
-  try {
-    str = "";
-    boost::algorithm::hex(hex_vec.begin() + offset,
-                          hex_vec.begin() + offset + len, back_inserter(str));
-  } catch (exception& e) {
+  if (offset + len > hex_vec.size() || offset + len < offset) {
     LOG_GENERAL(WARNING, "Failed Uint8VecToHexStr conversion");
     return false;
   }
+  str.resize(2 * len);
+  BytesToHex(hex_vec.data() + offset, len, &str[0]);
   return true;
 }
 
@@ -96,13 +297,8 @@ bool DataConversion::SerializableToHexStr(const Serializable& input,
                                           string& str) {
   bytes tmp;
   input.Serialize(tmp, 0);
-  try {
-    str = "";
-    boost::algorithm::hex(tmp.begin(), tmp.end(), back_inserter(str));
-  } catch (exception& e) {
-    LOG_GENERAL(WARNING, "Failed SerializableToHexStr conversion");
-    return false;
-  }
+  str.resize(2 * tmp.size());
+  BytesToHex(tmp.data(), tmp.size(), &str[0]);
   return true;
 }
 
@@ -37,6 +37,15 @@ class DataConversion {
   /// Converts alphanumeric hex string to byte vector.
   static bool HexStrToUint8Vec(const std::string& hex_input, bytes& out);
 
+  /// Writes the 2 * size uppercase hex digits of input to out, which must
+  /// have room for them. Does not allocate.
+  static void BytesToHex(const uint8_t* input, size_t size, char* out);
+
+  /// Writes the size / 2 bytes spelt by the hex digits in input to out.
+  /// Returns false, with out partly written, if size is odd or a character
+  /// is not a hex digit.
+  static bool HexToBytes(const char* input, size_t size, uint8_t* out);
+
   /// Converts alphanumeric hex string to 32-byte array.
   static bool HexStrToStdArray(const std::string& hex_input,
                                std::array<uint8_t, 32>& d);
@@ -56,14 +65,8 @@ class DataConversion {
   template <size_t SIZE>
   static bool charArrToHexStr(const std::array<uint8_t, SIZE>& hex_arr,
                               std::string& str) {
-    try {
-      str = "";
-      boost::algorithm::hex(hex_arr.begin(), hex_arr.end(),
-                            std::back_inserter(str));
-    } catch (std::exception& e) {
-      LOG_GENERAL(WARNING, "Failed charArrToHexStr conversion");
-      return false;
-    }
+    str.resize(2 * SIZE);
+    BytesToHex(hex_arr.data(), SIZE, &str[0]);
     return true;
   }
 
@@ -18,41 +18,137 @@
 #ifndef __DETACHEDFUNCTION_H__
 #define __DETACHEDFUNCTION_H__
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <functional>
+#include <limits>
+#include <mutex>
+#include <string>
 #include <thread>
+#include "common/Constants.h"
 #include "libUtils/Logger.h"
 
 /// Utility class for executing a function in one or more separate detached
-/// threads.
+/// threads. The threads are taken from a pool that grows when none is idle and
+/// shrinks again when they stay idle, so calls reuse threads instead of
+/// creating one each.
 class DetachedFunction {
  public:
+  /// Functions that run for the lifetime of the node, such as event loops, go
+  /// in BLOCKING, which is not bounded, so that they never hold up the
+  /// bounded DEFAULT lane
+  enum class Lane { DEFAULT, BLOCKING };
+
   /// Retry limit for launching the detached threads.
   const static int MaxAttempt = 3;
 
   /// Template constructor.
   template <class callable, class... arguments>
-  DetachedFunction(int num_threads, callable&& f, arguments&&... args) {
-    std::function<typename std::result_of<callable(arguments...)>::type()> task(
-        std::bind(std::forward<callable>(f), std::forward<arguments>(args)...));
+  DetachedFunction(int num_threads, callable&& f, arguments&&... args)
+      : DetachedFunction(Lane::DEFAULT, num_threads,
+                         std::forward<callable>(f),
+                         std::forward<arguments>(args)...) {}
 
-    bool attempt_flag = false;
+  template <class callable, class... arguments>
+  DetachedFunction(Lane lane, int num_threads, callable&& f,
+                   arguments&&... args) {
+    std::function<void()> task(
+        std::bind(std::forward<callable>(f), std::forward<arguments>(args)...));
 
+    Pool& pool = GetPool(lane);
     for (int i = 0; i < num_threads; i++) {
+      pool.Run(task);
+    }
+  }
+
+ private:
+  class Pool {
+   public:
+    Pool(const unsigned int maxThreads, const std::string& name)
+        : m_maxThreads(maxThreads), m_name(name) {}
+
+    /// Hands the task to an idle thread, or to a new thread if there is none
+    /// and the lane is not full. Otherwise the next thread to finish runs it.
+    void Run(const std::function<void()>& task) {
+      std::unique_lock<std::mutex> lock(m_mutex);
+      m_tasks.push_back(task);
+
+      if (m_tasks.size() <= m_idle) {
+        lock.unlock();
+        m_cv.notify_one();
+        return;
+      }
+
+      if (m_threads >= m_maxThreads) {
+        if (m_tasks.size() % 100 == 1) {
+          LOG_GENERAL(WARNING, m_name << " lane full with " << m_threads
+                                      << " threads, tasks waiting: "
+                                      << m_tasks.size());
+        }
+        return;
+      }
+
       for (int j = 0; j < MaxAttempt; j++) {
         try {
-          if (!attempt_flag) {
-            std::thread(task).detach();  // attempt to detach a non-thread
-            attempt_flag = true;
-          }
+          std::thread([this]() { Work(); }).detach();
+          ++m_threads;
+          return;
         } catch (const std::system_error& e) {
           LOG_GENERAL(WARNING,
                       j << " times tried. Caught system_error with code "
                         << e.code() << " meaning " << e.what() << '\n');
+          lock.unlock();
           std::this_thread::sleep_for(std::chrono::milliseconds(100));
+          lock.lock();
+        }
+      }
+    }
+
+   private:
+    void Work() {
+      const std::chrono::seconds idleTimeout(
+          DETACHED_FUNCTION_IDLE_TIMEOUT_IN_SECONDS);
+      std::unique_lock<std::mutex> lock(m_mutex);
+
+      while (true) {
+        if (m_tasks.empty()) {
+          ++m_idle;
+          const bool woken = m_cv.wait_for(
+              lock, idleTimeout, [this]() { return !m_tasks.empty(); });
+          --m_idle;
+          if (!woken) {
+            --m_threads;
+            return;
+          }
         }
+
+        std::function<void()> task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+
+        lock.unlock();
+        task();
+        lock.lock();
       }
-      attempt_flag = false;
     }
+
+    const unsigned int m_maxThreads;
+    const std::string m_name;
+    unsigned int m_threads = 0;
+    unsigned int m_idle = 0;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_cv;
+  };
+
+  /// The pools are never destroyed, as their detached threads may still be
+  /// running when the process exits
+  static Pool& GetPool(const Lane lane) {
+    static Pool* defaultPool =
+        new Pool(DETACHED_FUNCTION_MAX_THREADS, "DetachedFunction");
+    static Pool* blockingPool = new Pool(
+        std::numeric_limits<unsigned int>::max(), "DetachedFunction blocking");
+    return lane == Lane::BLOCKING ? *blockingPool : *defaultPool;
   }
 };
 
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __EPOCHARENA_H__
+#define __EPOCHARENA_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/// Monotonic memory for the containers rebuilt in every epoch. Allocations
+/// bump a pointer through chunks that are kept when the arena is reset, so
+/// after the first epochs the containers allocate nothing from the heap and
+/// stop fragmenting it. Freeing is a no-op; the memory is only reused after
+/// Reset, which the owner calls once everything allocated from the arena has
+/// been destroyed. Not thread-safe.
+class EpochArena {
+  struct Chunk {
+    std::unique_ptr<char[]> m_data;
+    size_t m_size;
+  };
+
+  const size_t m_chunkSize;
+  std::vector<Chunk> m_chunks;
+  /// Chunk being allocated from, and the bytes of it already used
+  size_t m_current = 0;
+  size_t m_offset = 0;
+  size_t m_bytesUsed = 0;
+
+ public:
+  static constexpr size_t DEFAULT_CHUNK_SIZE = 1 << 20;
+
+  explicit EpochArena(size_t chunkSize = DEFAULT_CHUNK_SIZE)
+      : m_chunkSize(chunkSize) {}
+
+  EpochArena(const EpochArena&) = delete;
+  EpochArena& operator=(const EpochArena&) = delete;
+
+  void* Allocate(size_t size, size_t alignment) {
+    for (; m_current < m_chunks.size(); m_current++, m_offset = 0) {
+      const Chunk& chunk = m_chunks[m_current];
+      const size_t start =
+          (reinterpret_cast<size_t>(chunk.m_data.get()) + m_offset +
+           alignment - 1) &
+          ~(alignment - 1);
+      const size_t end =
+          start - reinterpret_cast<size_t>(chunk.m_data.get()) + size;
+      if (end <= chunk.m_size) {
+        m_bytesUsed += end - m_offset;
+        m_offset = end;
+        return reinterpret_cast<void*>(start);
+      }
+    }
+
+    // Larger requests than a chunk get a chunk of their own
+    m_chunks.push_back(
+        {std::unique_ptr<char[]>(new char[std::max(m_chunkSize,
+                                                   size + alignment)]),
+         std::max(m_chunkSize, size + alignment)});
+    m_offset = 0;
+    return Allocate(size, alignment);
+  }
+
+  /// Makes all the memory available again, keeping the chunks
+  void Reset() {
+    m_current = 0;
+    m_offset = 0;
+    m_bytesUsed = 0;
+  }
+
+  /// Gives the chunks back to the heap
+  void Release() {
+    Reset();
+    m_chunks.clear();
+  }
+
+  size_t GetBytesUsed() const { return m_bytesUsed; }
+
+  size_t GetBytesReserved() const {
+    size_t reserved = 0;
+    for (const auto& chunk : m_chunks) {
+      reserved += chunk.m_size;
+    }
+    return reserved;
+  }
+};
+
+/// Allocator for standard containers that takes its memory from an
+/// EpochArena, or from the heap if it has none, so that the same container
+/// type serves both
+template <class T>
+class ArenaAllocator {
+  template <class U>
+  friend class ArenaAllocator;
+
+  EpochArena* m_arena;
+
+ public:
+  typedef T value_type;
+  // So that assigning a container moves it to the arena of the other
+  typedef std::true_type propagate_on_container_copy_assignment;
+  typedef std::true_type propagate_on_container_move_assignment;
+  typedef std::true_type propagate_on_container_swap;
+
+  explicit ArenaAllocator(EpochArena* arena = nullptr) : m_arena(arena) {}
+
+  template <class U>
+  ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.m_arena) {}
+
+  T* allocate(size_t n) {
+    if (m_arena == nullptr) {
+      return std::allocator<T>().allocate(n);
+    }
+    return static_cast<T*>(m_arena->Allocate(n * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T* p, size_t n) {
+    if (m_arena == nullptr) {
+      std::allocator<T>().deallocate(p, n);
+    }
+  }
+
+  template <class U>
+  bool operator==(const ArenaAllocator<U>& other) const {
+    return m_arena == other.m_arena;
+  }
+
+  template <class U>
+  bool operator!=(const ArenaAllocator<U>& other) const {
+    return m_arena != other.m_arena;
+  }
+};
+
+#endif  // __EPOCHARENA_H__
@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __FAIRJOBQUEUE_H__
+#define __FAIRJOBQUEUE_H__
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/// Thread-safe queue of jobs per key (e.g. requester address), taken in turn
+/// across the keys, so that a key with many jobs waiting does not hold up the
+/// others. Each key may have at most maxPerKey jobs waiting.
+///
+/// The queue runs nothing itself: every Add that succeeds is to be paired with
+/// one call to RunNext, typically a job added to a thread pool.
+class FairJobQueue {
+ public:
+  typedef std::function<void()> Job;
+
+ private:
+  const std::size_t m_maxPerKey;
+  std::mutex m_mutex;
+  std::unordered_map<std::string, std::deque<Job>> m_jobs;
+  /// Keys with jobs waiting, in the order of their next turn
+  std::deque<std::string> m_turns;
+  std::size_t m_queued = 0;
+
+ public:
+  explicit FairJobQueue(std::size_t maxPerKey) : m_maxPerKey(maxPerKey) {}
+
+  /// Returns false, dropping job, if key already has maxPerKey jobs waiting
+  bool Add(const std::string& key, Job job) {
+    std::lock_guard<std::mutex> g(m_mutex);
+    auto it = m_jobs.find(key);
+    if (it == m_jobs.end()) {
+      it = m_jobs.emplace(key, std::deque<Job>()).first;
+      m_turns.emplace_back(key);
+    } else if (it->second.size() >= m_maxPerKey) {
+      return false;
+    }
+    it->second.emplace_back(std::move(job));
+    m_queued++;
+    return true;
+  }
+
+  /// Runs the oldest job of the key whose turn it is, if any
+  void RunNext() {
+    Job job;
+    {
+      std::lock_guard<std::mutex> g(m_mutex);
+      if (m_turns.empty()) {
+        return;
+      }
+      const std::string key = std::move(m_turns.front());
+      m_turns.pop_front();
+
+      auto it = m_jobs.find(key);
+      job = std::move(it->second.front());
+      it->second.pop_front();
+      m_queued--;
+      if (it->second.empty()) {
+        m_jobs.erase(it);
+      } else {
+        m_turns.emplace_back(key);
+      }
+    }
+    job();
+  }
+
+  /// Jobs waiting, across all keys
+  std::size_t GetQueued() {
+    std::lock_guard<std::mutex> g(m_mutex);
+    return m_queued;
+  }
+
+  /// Keys with jobs waiting
+  std::size_t GetNumKeys() {
+    std::lock_guard<std::mutex> g(m_mutex);
+    return m_jobs.size();
+  }
+};
+
+#endif  // __FAIRJOBQUEUE_H__
@@ -0,0 +1,110 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __LRUCACHE_H__
+#define __LRUCACHE_H__
+
+#include <atomic>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+/// Thread-safe LRU cache holding at most capacity entries; a capacity of 0
+/// disables it. Keeps hit and miss counts for logging the hit rate.
+template <class Key, class Value, class Hash = std::hash<Key>>
+class LRUCache {
+  typedef std::list<std::pair<Key, Value>> List;
+
+  const unsigned int m_capacity;
+  std::mutex m_mutex;
+  List m_lru;
+  std::unordered_map<Key, typename List::iterator, Hash> m_index;
+  std::atomic<uint64_t> m_hits{0};
+  std::atomic<uint64_t> m_misses{0};
+
+ public:
+  explicit LRUCache(unsigned int capacity) : m_capacity(capacity) {}
+
+  /// Copies the entry into value and marks it most recently used
+  bool Get(const Key& key, Value& value) {
+    if (m_capacity == 0) {
+      return false;
+    }
+
+    {
+      std::lock_guard<std::mutex> g(m_mutex);
+      auto it = m_index.find(key);
+      if (it != m_index.end()) {
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        value = it->second->second;
+        m_hits++;
+        return true;
+      }
+    }
+
+    m_misses++;
+    return false;
+  }
+
+  void Put(const Key& key, const Value& value) {
+    if (m_capacity == 0) {
+      return;
+    }
+
+    std::lock_guard<std::mutex> g(m_mutex);
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+      it->second->second = value;
+      m_lru.splice(m_lru.begin(), m_lru, it->second);
+      return;
+    }
+
+    if (m_lru.size() >= m_capacity) {
+      m_index.erase(m_lru.back().first);
+      m_lru.pop_back();
+    }
+    m_lru.emplace_front(key, value);
+    m_index.emplace(key, m_lru.begin());
+  }
+
+  void Erase(const Key& key) {
+    std::lock_guard<std::mutex> g(m_mutex);
+    auto it = m_index.find(key);
+    if (it != m_index.end()) {
+      m_lru.erase(it->second);
+      m_index.erase(it);
+    }
+  }
+
+  void Clear() {
+    std::lock_guard<std::mutex> g(m_mutex);
+    m_lru.clear();
+    m_index.clear();
+  }
+
+  uint64_t GetHits() const { return m_hits; }
+  uint64_t GetMisses() const { return m_misses; }
+
+  void ResetStats() {
+    m_hits = 0;
+    m_misses = 0;
+  }
+};
+
+#endif  // __LRUCACHE_H__
@@ -20,6 +20,7 @@
 #include <pthread.h>
 #include <sys/syscall.h>
 #include <unistd.h>
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 using namespace std;
@@ -43,8 +44,53 @@ inline pid_t getCurrentPid() {
   return 0;
 #endif
 }
+/// Maps the level value kept in a Record back to its LEVELS
+const LEVELS& LevelOf(const int value) {
+  if (value == FATAL.value) {
+    return FATAL;
+  } else if (value == WARNING.value) {
+    return WARNING;
+  } else if (value == DEBUG.value) {
+    return DEBUG;
+  }
+  return INFO;
+}
 };  // namespace
 
+/// Lines logged by one thread, read by the writer. Only the owning thread
+/// pushes and only the writer pops, so two atomic indices are enough.
+class Logger::RecordBuffer {
+ public:
+  RecordBuffer() : m_records(ASYNC_BUFFER_SIZE) {}
+
+  bool Push(Record&& record) {
+    const uint64_t tail = m_tail.load(memory_order_relaxed);
+    if (tail - m_head.load(memory_order_acquire) == ASYNC_BUFFER_SIZE) {
+      return false;
+    }
+    m_records[tail % ASYNC_BUFFER_SIZE] = move(record);
+    m_tail.store(tail + 1, memory_order_release);
+    return true;
+  }
+
+  void Drain(vector<Record>& records) {
+    uint64_t head = m_head.load(memory_order_relaxed);
+    const uint64_t tail = m_tail.load(memory_order_acquire);
+    for (; head < tail; ++head) {
+      records.emplace_back(move(m_records[head % ASYNC_BUFFER_SIZE]));
+    }
+    m_head.store(head, memory_order_release);
+  }
+
+  /// Set when the owning thread exits, after its last Push
+  atomic<bool> m_closed{false};
+
+ private:
+  vector<Record> m_records;
+  atomic<uint64_t> m_head{0};
+  atomic<uint64_t> m_tail{0};
+};
+
 const streampos Logger::MAX_FILE_SIZE =
     1024 * 1024 * 100;  // 100MB per log file
 
@@ -59,7 +105,13 @@ Logger::Logger(const char* prefix, bool log_to_file, streampos max_file_size) {
   }
 }
 
-Logger::~Logger() { m_logFile.close(); }
+Logger::~Logger() {
+  m_stopWriter = true;
+  if (m_writerRunning) {
+    m_writer.join();
+  }
+  m_logFile.close();
+}
 
 void Logger::checkLog() {
   std::ifstream in(m_fileName.c_str(),
@@ -92,6 +144,9 @@ void Logger::newLog() {
     initializeLogging(logworker.get());
   } else {
     m_logFile.open(m_fileName.c_str(), ios_base::app);
+    std::ifstream in(m_fileName.c_str(),
+                     std::ifstream::ate | std::ifstream::binary);
+    m_fileSize = in.tellg();
   }
 }
 
@@ -127,142 +182,209 @@ void Logger::LogState(const char* msg) {
 void Logger::LogGeneral(LEVELS level, const char* msg,
                         const unsigned int linenum, const char* filename,
                         const char* function) {
-  if (IsG3Log()) {
-    auto cur = chrono::system_clock::now();
-    auto cur_time_t = chrono::system_clock::to_time_t(cur);
-    auto file_and_line =
-        std::string(std::string(filename) + ":" + std::to_string(linenum));
-    LOG(level) << "[" << PAD(GetPid(), TID_LEN, ' ') << "]["
-               << put_time(gmtime(&cur_time_t), "%y-%m-%dT%T.")
-               << PAD(get_ms(cur), 3, '0') << "]["
-               << LIMIT_RIGHT(file_and_line, Logger::MAX_FILEANDLINE_LEN)
-               << "][" << LIMIT(function, MAX_FUNCNAME_LEN) << "] " << msg;
-    return;
+  Enqueue(level, msg, linenum, filename, function);
+}
+
+void Logger::LogEpoch(LEVELS level, const char* msg, const char* epoch,
+                      const unsigned int linenum, const char* filename,
+                      const char* function) {
+  Enqueue(level, string("[Epoch ") + epoch + "] " + msg, linenum, filename,
+          function);
+}
+
+void Logger::LogPayload(LEVELS level, const char* msg, const bytes& payload,
+                        size_t max_bytes_to_display,
+                        const unsigned int linenum, const char* filename,
+                        const char* function) {
+  std::unique_ptr<char[]> payload_string;
+  GetPayloadS(payload, max_bytes_to_display, payload_string);
+
+  string line = string(msg) + " (Len=" + to_string(payload.size()) +
+                "): " + payload_string.get();
+  if (payload.size() > max_bytes_to_display) {
+    line += "...";
   }
+  Enqueue(level, move(line), linenum, filename, function);
+}
 
-  lock_guard<mutex> guard(m);
+Logger::RecordBuffer* Logger::GetBuffer() {
+  // The buffer stays with the writer after the thread exits, until drained
+  struct Holder {
+    shared_ptr<RecordBuffer> m_buffer;
+    ~Holder() {
+      if (m_buffer) {
+        m_buffer->m_closed = true;
+      }
+    }
+  };
+  static thread_local Holder holder;
 
-  if (m_logToFile) {
-    checkLog();
-    auto cur = chrono::system_clock::now();
-    auto cur_time_t = chrono::system_clock::to_time_t(cur);
-    auto file_and_line =
-        std::string(std::string(filename) + ":" + std::to_string(linenum));
-    m_logFile << "[" << PAD(GetPid(), TID_LEN, ' ') << "]["
-              << put_time(gmtime(&cur_time_t), "%y-%m-%dT%T.")
-              << PAD(get_ms(cur), 3, '0') << "]["
-              << LIMIT_RIGHT(file_and_line, Logger::MAX_FILEANDLINE_LEN) << "]["
-              << LIMIT(function, MAX_FUNCNAME_LEN) << "] " << msg << endl
-              << flush;
-  } else {
-    auto cur = chrono::system_clock::now();
-    auto cur_time_t = chrono::system_clock::to_time_t(cur);
-    auto file_and_line =
-        std::string(std::string(filename) + ":" + std::to_string(linenum));
-    cout << "[" << PAD(GetPid(), TID_LEN, ' ') << "]["
-         << put_time(gmtime(&cur_time_t), "%y-%m-%dT%T.")
-         << PAD(get_ms(cur), 3, '0') << "]["
-         << LIMIT_RIGHT(file_and_line, Logger::MAX_FILEANDLINE_LEN) << "]["
-         << LIMIT(function, MAX_FUNCNAME_LEN) << "] " << msg << endl
-         << flush;
+  if (!holder.m_buffer) {
+    holder.m_buffer = make_shared<RecordBuffer>();
+    lock_guard<mutex> g(m_buffersMutex);
+    m_buffers.emplace_back(holder.m_buffer);
   }
+  return holder.m_buffer.get();
 }
 
-void Logger::LogEpoch([[gnu::unused]] LEVELS level, const char* msg,
-                      const char* epoch, const unsigned int linenum,
-                      const char* filename, const char* function) {
-  lock_guard<mutex> guard(m);
+void Logger::Enqueue(LEVELS level, string&& msg, const unsigned int linenum,
+                     const char* filename, const char* function) {
+  if (!IsLevelEnabled(level)) {
+    return;
+  }
 
-  if (m_logToFile) {
-    checkLog();
-    auto cur = chrono::system_clock::now();
-    auto cur_time_t = chrono::system_clock::to_time_t(cur);
-    auto file_and_line =
-        std::string(std::string(filename) + ":" + std::to_string(linenum));
-    m_logFile << "[" << PAD(GetPid(), TID_LEN, ' ') << "]["
-              << put_time(gmtime(&cur_time_t), "%y-%m-%dT%T.")
-              << PAD(get_ms(cur), 3, '0') << "]["
-              << LIMIT_RIGHT(file_and_line, Logger::MAX_FILEANDLINE_LEN) << "]["
-              << LIMIT(function, MAX_FUNCNAME_LEN) << "] [Epoch " << epoch
-              << "] " << msg << endl
-              << flush;
-  } else {
-    auto cur = chrono::system_clock::now();
-    auto cur_time_t = chrono::system_clock::to_time_t(cur);
-    auto file_and_line =
-        std::string(std::string(filename) + ":" + std::to_string(linenum));
-    cout << "[" << PAD(GetPid(), TID_LEN, ' ') << "]["
-         << put_time(gmtime(&cur_time_t), "%y-%m-%dT%T.")
-         << PAD(get_ms(cur), 3, '0') << "]["
-         << LIMIT_RIGHT(file_and_line, Logger::MAX_FILEANDLINE_LEN) << "]["
-         << LIMIT(function, MAX_FUNCNAME_LEN) << "] [Epoch " << epoch << "] "
-         << msg << endl
-         << flush;
+  Record record;
+  FillRecord(record, level, linenum, filename, function);
+  record.m_seq = m_nextSeq.fetch_add(1, memory_order_relaxed);
+  record.m_msg = move(msg);
+
+  if (level.value == FATAL.value) {
+    // Written before returning, as the caller may not get much further
+    Flush();
+    lock_guard<mutex> guard(m);
+    Write(record);
+    return;
+  }
+
+  // Only the main logger is used from the logging macros
+  if (this != &GetLogger(NULL, true)) {
+    lock_guard<mutex> guard(m);
+    Write(record);
+    return;
+  }
+
+  call_once(m_writerStarted, [this]() {
+    m_writer = thread(&Logger::RunWriter, this);
+    m_writerRunning = true;
+  });
+
+  RecordBuffer* buffer = GetBuffer();
+  if (level.value < WARNING.value) {
+    if (!buffer->Push(move(record))) {
+      ++m_dropped;
+    }
+    return;
+  }
+
+  // Warnings are worth waiting for the writer to make room
+  while (!buffer->Push(move(record))) {
+    this_thread::yield();
   }
 }
 
-void Logger::LogPayload([[gnu::unused]] LEVELS level, const char* msg,
-                        const bytes& payload, size_t max_bytes_to_display,
+void Logger::FillRecord(Record& record, const LEVELS& level,
                         const unsigned int linenum, const char* filename,
                         const char* function) {
-  std::unique_ptr<char[]> payload_string;
-  GetPayloadS(payload, max_bytes_to_display, payload_string);
-  lock_guard<mutex> guard(m);
+  // Only the end of the file name and the start of the function name are
+  // displayed
+  const int skip = (int)strlen(filename) - (int)MAX_FILEANDLINE_LEN;
+  snprintf(record.m_fileAndLine, sizeof(record.m_fileAndLine), "%s:%u",
+           filename + max(skip, 0), linenum);
+  snprintf(record.m_function, sizeof(record.m_function), "%s", function);
+  record.m_level = level.value;
+  record.m_tid = GetPid();
+  record.m_time = chrono::system_clock::now();
+}
 
-  if (m_logToFile) {
-    checkLog();
-    auto cur = chrono::system_clock::now();
-    auto cur_time_t = chrono::system_clock::to_time_t(cur);
-    auto file_and_line =
-        std::string(std::string(filename) + ":" + std::to_string(linenum));
+void Logger::Write(const Record& record) {
+  const string fileAndLine(record.m_fileAndLine);
+  auto cur_time_t = chrono::system_clock::to_time_t(record.m_time);
+  struct tm cur_tm;
+  gmtime_r(&cur_time_t, &cur_tm);
+
+  ostringstream oss;
+  oss << "[" << PAD(record.m_tid, TID_LEN, ' ') << "]["
+      << put_time(&cur_tm, "%y-%m-%dT%T.") << PAD(get_ms(record.m_time), 3, '0')
+      << "][" << LIMIT_RIGHT(fileAndLine, Logger::MAX_FILEANDLINE_LEN) << "]["
+      << LIMIT(record.m_function, MAX_FUNCNAME_LEN) << "] " << record.m_msg;
 
-    if (payload.size() > max_bytes_to_display) {
-      m_logFile << "[" << PAD(GetPid(), TID_LEN, ' ') << "]["
-                << put_time(gmtime(&cur_time_t), "%y-%m-%dT%T.")
-                << PAD(get_ms(cur), 3, '0') << "]["
-                << LIMIT_RIGHT(file_and_line, Logger::MAX_FILEANDLINE_LEN)
-                << "][" << LIMIT(function, MAX_FUNCNAME_LEN) << "] " << msg
-                << " (Len=" << payload.size() << "): " << payload_string.get()
-                << "..." << endl
-                << flush;
-    } else {
-      m_logFile << "[" << PAD(GetPid(), TID_LEN, ' ') << "]["
-                << put_time(gmtime(&cur_time_t), "%y-%m-%dT%T.")
-                << PAD(get_ms(cur), 3, '0') << "]["
-                << LIMIT_RIGHT(file_and_line, Logger::MAX_FILEANDLINE_LEN)
-                << "][" << LIMIT(function, MAX_FUNCNAME_LEN) << "] " << msg
-                << " (Len=" << payload.size() << "): " << payload_string.get()
-                << endl
-                << flush;
+  if (IsG3Log()) {
+    LOG(LevelOf(record.m_level)) << oss.str();
+  } else if (m_logToFile) {
+    if (m_fileSize >= m_maxFileSize) {
+      m_logFile.close();
+      newLog();
     }
+    const string line = oss.str();
+    m_logFile << line << '\n';
+    m_fileSize += line.size() + 1;
   } else {
-    auto cur = chrono::system_clock::now();
-    auto cur_time_t = chrono::system_clock::to_time_t(cur);
-    auto file_and_line =
-        std::string(std::string(filename) + ":" + std::to_string(linenum));
+    cout << oss.str() << '\n';
+  }
+}
 
-    if (payload.size() > max_bytes_to_display) {
-      cout << "[" << PAD(GetPid(), TID_LEN, ' ') << "]["
-           << put_time(gmtime(&cur_time_t), "%y-%m-%dT%T.")
-           << PAD(get_ms(cur), 3, '0') << "]["
-           << LIMIT_RIGHT(file_and_line, Logger::MAX_FILEANDLINE_LEN) << "]["
-           << LIMIT(function, MAX_FUNCNAME_LEN) << "] " << msg
-           << " (Len=" << payload.size() << "): " << payload_string.get()
-           << "..." << endl
-           << flush;
-    } else {
-      cout << "[" << PAD(GetPid(), TID_LEN, ' ') << "]["
-           << put_time(gmtime(&cur_time_t), "%y-%m-%dT%T.")
-           << PAD(get_ms(cur), 3, '0') << "]["
-           << LIMIT_RIGHT(file_and_line, Logger::MAX_FILEANDLINE_LEN) << "]["
-           << LIMIT(function, MAX_FUNCNAME_LEN) << "] " << msg
-           << " (Len=" << payload.size() << "): " << payload_string.get()
-           << endl
-           << flush;
+void Logger::RunWriter() {
+  vector<Record> records;
+
+  while (true) {
+    // Read first, so that the last pass picks up everything logged before
+    // the stop
+    const bool stop = m_stopWriter;
+
+    records.clear();
+    {
+      lock_guard<mutex> g(m_buffersMutex);
+      for (auto it = m_buffers.begin(); it != m_buffers.end();) {
+        const bool closed = (*it)->m_closed;
+        (*it)->Drain(records);
+        it = closed ? m_buffers.erase(it) : it + 1;
+      }
+    }
+
+    // Interleave the threads in the order the lines were logged
+    sort(records.begin(), records.end(),
+         [](const Record& a, const Record& b) { return a.m_seq < b.m_seq; });
+
+    const uint64_t dropped = m_dropped.exchange(0);
+    if (dropped > 0) {
+      m_totalDropped += dropped;
+      Record record;
+      FillRecord(record, WARNING, __LINE__, __FILE__, __FUNCTION__);
+      record.m_seq = 0;
+      record.m_msg = "Dropped " + to_string(dropped) +
+                     " log lines, logging faster than they can be written";
+      records.emplace_back(move(record));
+    }
+
+    if (!records.empty()) {
+      lock_guard<mutex> guard(m);
+      for (const auto& record : records) {
+        Write(record);
+      }
+      if (m_logToFile && !IsG3Log()) {
+        m_logFile << flush;
+      } else if (!m_logToFile) {
+        cout << flush;
+      }
+    }
+
+    {
+      lock_guard<mutex> g(m_roundsMutex);
+      ++m_writerRounds;
+    }
+    m_roundsCv.notify_all();
+
+    if (stop) {
+      return;
+    }
+
+    if (records.empty()) {
+      this_thread::sleep_for(chrono::milliseconds(1));
     }
   }
 }
 
+void Logger::Flush() {
+  if (!m_writerRunning || m_stopWriter) {
+    return;
+  }
+  unique_lock<mutex> lock(m_roundsMutex);
+
+  // The pass under way may have gone past this thread's buffer already
+  const uint64_t target = m_writerRounds + 2;
+  m_roundsCv.wait(lock, [this, target]() { return m_writerRounds >= target; });
+}
+
 void Logger::LogEpochInfo(const char* msg, const unsigned int linenum,
                           const char* filename, const char* function,
                           const char* epoch) {
@@ -300,6 +422,7 @@ void Logger::LogEpochInfo(const char* msg, const unsigned int linenum,
 void Logger::DisplayLevelAbove(LEVELS level) {
   if (level != INFO && level != WARNING && level != FATAL) return;
 
+  m_minLevelValue = level.value;
   g3::log_levels::setHighest(level);
 }
 
@@ -22,12 +22,16 @@
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 #include <boost/multiprecision/cpp_int.hpp>
 #pragma GCC diagnostic pop
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <fstream>
 #include <iomanip>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 #include "common/BaseType.h"
 #include "g3log/g3log.hpp"
@@ -45,9 +49,53 @@
 
 #define PAD(n, len, ch) std::setw(len) << std::setfill(ch) << std::right << n
 
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_FATAL 3
+
+/// Log statements below this level are compiled out
+#ifndef LOG_MIN_LEVEL
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+/// Works out to a constant for the levels named directly, so that the compiler
+/// drops the statements below LOG_MIN_LEVEL
+#define LOG_LEVEL_OF(level)                               \
+  (&(level) == &DEBUG                                     \
+       ? LOG_LEVEL_DEBUG                                  \
+       : &(level) == &INFO                                \
+             ? LOG_LEVEL_INFO                             \
+             : &(level) == &WARNING                       \
+                   ? LOG_LEVEL_WARNING                    \
+                   : &(level) == &FATAL ? LOG_LEVEL_FATAL \
+                                        : Logger::LevelIndex(level))
+
+#define LOG_IS_ON(level)                   \
+  (LOG_LEVEL_OF(level) >= LOG_MIN_LEVEL && \
+   Logger::GetLogger(NULL, true).IsLevelEnabled(level))
+
 /// Utility logging class for outputting messages to stdout or file.
+/// LogGeneral, LogEpoch and LogPayload only copy the message into a buffer of
+/// the calling thread, without taking a lock; a writer thread formats the
+/// lines and writes them out. When a thread logs faster than the writer keeps
+/// up, its INFO and DEBUG lines are dropped and counted, while its warnings
+/// wait for room.
 class Logger {
  private:
+  /// A log line as captured by the thread logging it
+  struct Record {
+    uint64_t m_seq;
+    int m_level;
+    pid_t m_tid;
+    std::chrono::system_clock::time_point m_time;
+    char m_fileAndLine[64];
+    char m_function[32];
+    std::string m_msg;
+  };
+
+  class RecordBuffer;
+
   std::mutex m;
   bool m_logToFile;
   std::streampos m_maxFileSize;
@@ -59,13 +107,43 @@ class Logger {
   void checkLog();
   void newLog();
 
+  void Enqueue(LEVELS level, std::string&& msg, const unsigned int linenum,
+               const char* filename, const char* function);
+  RecordBuffer* GetBuffer();
+  static void FillRecord(Record& record, const LEVELS& level,
+                         const unsigned int linenum, const char* filename,
+                         const char* function);
+  /// Caller holds m
+  void Write(const Record& record);
+  void RunWriter();
+
   std::string m_fileNamePrefix;
   std::string m_fileName;
   std::ofstream m_logFile;
+  std::streampos m_fileSize{0};
   unsigned int m_seqNum;
   bool m_bRefactor;
 
+  std::once_flag m_writerStarted;
+  std::thread m_writer;
+  std::atomic<bool> m_writerRunning{false};
+  std::atomic<bool> m_stopWriter{false};
+  std::mutex m_buffersMutex;
+  std::vector<std::shared_ptr<RecordBuffer>> m_buffers;
+  /// Set by DisplayLevelAbove; lines below are dropped before formatting
+  std::atomic<int> m_minLevelValue{0};
+  std::atomic<uint64_t> m_nextSeq{0};
+  std::atomic<uint64_t> m_dropped{0};
+  std::atomic<uint64_t> m_totalDropped{0};
+  /// Passes of the writer over the buffers, for Flush to wait on
+  uint64_t m_writerRounds = 0;
+  std::mutex m_roundsMutex;
+  std::condition_variable m_roundsCv;
+
  public:
+  /// Lines each thread can have waiting for the writer
+  static const size_t ASYNC_BUFFER_SIZE = 1024;
+
   /// Limits the number of bytes of a payload to display.
   static const size_t MAX_BYTES_TO_DISPLAY = 30;
 
@@ -126,6 +204,29 @@ class Logger {
                   size_t max_bytes_to_display, const unsigned int linenum,
                   const char* filename, const char* function);
 
+  /// Blocks until the lines logged before the call are written
+  void Flush();
+
+  /// Lines dropped because the buffer of the logging thread was full
+  uint64_t GetDroppedCount() const { return m_totalDropped; }
+
+  /// Whether lines of this level are written at all, so that the macros can
+  /// skip formatting those that are not
+  bool IsLevelEnabled(const LEVELS& level) {
+    return level.value >= m_minLevelValue &&
+           (!IsG3Log() || g3::logLevel(level));
+  }
+
+  /// LOG_LEVEL_* of a level that is not one of the named ones
+  static int LevelIndex(const LEVELS& level) {
+    return level.value >= FATAL.value
+               ? LOG_LEVEL_FATAL
+               : level.value >= WARNING.value
+                     ? LOG_LEVEL_WARNING
+                     : level.value >= INFO.value ? LOG_LEVEL_INFO
+                                                 : LOG_LEVEL_DEBUG;
+  }
+
   /// Setup the display debug level
   ///     INFO: display all message
   ///     WARNING: display warning and fatal message
@@ -170,7 +271,11 @@ class ScopeMarker {
   Logger::GetStateLogger(fname_prefix, true)
 #define INIT_EPOCHINFO_LOGGER(fname_prefix) \
   Logger::GetEpochInfoLogger(fname_prefix, true)
+#if LOG_MIN_LEVEL > LOG_LEVEL_INFO
+#define LOG_MARKER()
+#else
 #define LOG_MARKER() ScopeMarker marker(__LINE__, __FILE__, __FUNCTION__)
+#endif
 #define LOG_STATE(msg)                                                \
   {                                                                   \
     std::ostringstream oss;                                           \
@@ -180,78 +285,30 @@ class ScopeMarker {
         << PAD(get_ms(cur), 3, '0') << " ]" << msg;                   \
     Logger::GetStateLogger(NULL, true).LogState(oss.str().c_str());   \
   }
-#define LOG_GENERAL(level, msg)                                                \
-  {                                                                            \
-    if (Logger::GetLogger(NULL, true).IsG3Log()) {                             \
-      auto cur = std::chrono::system_clock::now();                             \
-      auto cur_time_t = std::chrono::system_clock::to_time_t(cur);             \
-      auto file_and_line =                                                     \
-          std::string(std::string(__FILE__) + ":" + std::to_string(__LINE__)); \
-      LOG(level) << "[" << PAD(Logger::GetPid(), Logger::TID_LEN, ' ') << "][" \
-                 << std::put_time(gmtime(&cur_time_t), "%y-%m-%dT%T.")         \
-                 << PAD(get_ms(cur), 3, '0') << "]["                           \
-                 << LIMIT_RIGHT(file_and_line, Logger::MAX_FILEANDLINE_LEN)    \
-                 << "][" << LIMIT(__FUNCTION__, Logger::MAX_FUNCNAME_LEN)      \
-                 << "] " << msg;                                               \
-    } else {                                                                   \
-      std::ostringstream oss;                                                  \
-      oss << msg;                                                              \
-      Logger::GetLogger(NULL, true)                                            \
-          .LogGeneral(level, oss.str().c_str(), __LINE__, __FILE__,            \
-                      __FUNCTION__);                                           \
-    }                                                                          \
+#define LOG_GENERAL(level, msg)                                     \
+  {                                                                 \
+    if (LOG_IS_ON(level)) {                                         \
+      std::ostringstream oss;                                       \
+      oss << msg;                                                   \
+      Logger::GetLogger(NULL, true)                                 \
+          .LogGeneral(level, oss.str().c_str(), __LINE__, __FILE__, \
+                      __FUNCTION__);                                \
+    }                                                               \
   }
-#define LOG_EPOCH(level, epoch, msg)                                           \
-  {                                                                            \
-    if (Logger::GetLogger(NULL, true).IsG3Log()) {                             \
-      auto cur = std::chrono::system_clock::now();                             \
-      auto cur_time_t = std::chrono::system_clock::to_time_t(cur);             \
-      auto file_and_line =                                                     \
-          std::string(std::string(__FILE__) + ":" + std::to_string(__LINE__)); \
-      LOG(level) << "[" << PAD(Logger::GetPid(), Logger::TID_LEN, ' ') << "][" \
-                 << std::put_time(gmtime(&cur_time_t), "%y-%m-%dT%T.")         \
-                 << PAD(get_ms(cur), 3, '0') << "]["                           \
-                 << LIMIT_RIGHT(file_and_line, Logger::MAX_FILEANDLINE_LEN)    \
-                 << "][" << LIMIT(__FUNCTION__, Logger::MAX_FUNCNAME_LEN)      \
-                 << "] [Epoch " << std::to_string(epoch).c_str() << "] "       \
-                 << msg;                                                       \
-    } else {                                                                   \
-      std::ostringstream oss;                                                  \
-      oss << msg;                                                              \
-      Logger::GetLogger(NULL, true)                                            \
-          .LogEpoch(level, std::to_string(epoch).c_str(), oss.str().c_str(),   \
-                    __LINE__, __FILE__, __FUNCTION__);                         \
-    }                                                                          \
+#define LOG_EPOCH(level, epoch, msg)                                   \
+  {                                                                    \
+    if (LOG_IS_ON(level)) {                                            \
+      std::ostringstream oss;                                          \
+      oss << msg;                                                      \
+      Logger::GetLogger(NULL, true)                                    \
+          .LogEpoch(level, oss.str().c_str(),                          \
+                    std::to_string(epoch).c_str(), __LINE__, __FILE__, \
+                    __FUNCTION__);                                     \
+    }                                                                  \
   }
 #define LOG_PAYLOAD(level, msg, payload, max_bytes_to_display)                 \
   {                                                                            \
-    if (Logger::GetLogger(NULL, true).IsG3Log()) {                             \
-      std::unique_ptr<char[]> payload_string;                                  \
-      Logger::GetPayloadS(payload, max_bytes_to_display, payload_string);      \
-      auto cur = std::chrono::system_clock::now();                             \
-      auto cur_time_t = std::chrono::system_clock::to_time_t(cur);             \
-      auto file_and_line =                                                     \
-          std::string(std::string(__FILE__) + ":" + std::to_string(__LINE__)); \
-      if ((payload).size() > max_bytes_to_display) {                           \
-        LOG(level) << "[" << PAD(Logger::GetPid(), Logger::TID_LEN, ' ')       \
-                   << "]["                                                     \
-                   << std::put_time(gmtime(&cur_time_t), "%y-%m-%dT%T.")       \
-                   << PAD(get_ms(cur), 3, '0') << "]["                         \
-                   << LIMIT_RIGHT(file_and_line, Logger::MAX_FILEANDLINE_LEN)  \
-                   << "][" << LIMIT(__FUNCTION__, Logger::MAX_FUNCNAME_LEN)    \
-                   << "] " << msg << " (Len=" << (payload).size()              \
-                   << "): " << payload_string.get() << "...";                  \
-      } else {                                                                 \
-        LOG(level) << "[" << PAD(Logger::GetPid(), Logger::TID_LEN, ' ')       \
-                   << "]["                                                     \
-                   << std::put_time(gmtime(&cur_time_t), "%y-%m-%dT%T.")       \
-                   << PAD(get_ms(cur), 3, '0') << "]["                         \
-                   << LIMIT_RIGHT(file_and_line, Logger::MAX_FILEANDLINE_LEN)  \
-                   << "][" << LIMIT(__FUNCTION__, Logger::MAX_FUNCNAME_LEN)    \
-                   << "] " << msg << " (Len=" << (payload).size()              \
-                   << "): " << payload_string.get();                           \
-      }                                                                        \
-    } else {                                                                   \
+    if (LOG_IS_ON(level)) {                                                    \
       std::ostringstream oss;                                                  \
       oss << msg;                                                              \
       Logger::GetLogger(NULL, true)                                            \
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "MemoryStats.h"
+
+#include <unistd.h>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+#include "common/Constants.h"
+#include "libUtils/DetachedFunction.h"
+#include "libUtils/Logger.h"
+#include "libUtils/Metrics.h"
+
+using namespace std;
+
+void MemoryStats::Register(const string& name, const Estimator& estimator) {
+  {
+    lock_guard<mutex> g(m_mutex);
+    m_estimators[name] = estimator;
+  }
+
+  // The gauges read the last report, so that scraping never waits for the
+  // locks of a subsystem while holding the registry of Metrics
+  const string labels = "subsystem=\"" + name + "\"";
+  Metrics::GetInstance().SetGaugeFunction(
+      "zilliqa_memory_bytes", "Estimated bytes held, per subsystem",
+      [name]() {
+        return MemoryStats::GetInstance().GetLastUsage(name).m_bytes;
+      },
+      labels);
+  Metrics::GetInstance().SetGaugeFunction(
+      "zilliqa_memory_entries", "Entries held, per subsystem",
+      [name]() {
+        return MemoryStats::GetInstance().GetLastUsage(name).m_entries;
+      },
+      labels);
+}
+
+map<string, MemoryStats::Usage> MemoryStats::GetReport() {
+  map<string, Estimator> estimators;
+  {
+    lock_guard<mutex> g(m_mutex);
+    estimators = m_estimators;
+  }
+
+  map<string, Usage> report;
+  for (const auto& entry : estimators) {
+    report[entry.first] = entry.second();
+  }
+
+  lock_guard<mutex> g(m_mutex);
+  m_lastReport = report;
+  return report;
+}
+
+MemoryStats::Usage MemoryStats::GetLastUsage(const string& name) {
+  lock_guard<mutex> g(m_mutex);
+  auto it = m_lastReport.find(name);
+  return (it == m_lastReport.end()) ? Usage() : it->second;
+}
+
+uint64_t MemoryStats::GetResidentBytes() {
+  // The second field of statm is the resident set, in pages
+  ifstream statm("/proc/self/statm");
+  uint64_t sizePages = 0;
+  uint64_t residentPages = 0;
+  if (!(statm >> sizePages >> residentPages)) {
+    return 0;
+  }
+  return residentPages * sysconf(_SC_PAGESIZE);
+}
+
+void MemoryStats::StartPeriodicReport() {
+  // Nothing reads the reports otherwise
+  if (MEMORY_STATS_INTERVAL_IN_SECONDS == 0 ||
+      (!ENABLE_METRICS && !ENABLE_MEMORY_STATS_LOG)) {
+    return;
+  }
+
+  auto func = [this]() -> void {
+    while (true) {
+      this_thread::sleep_for(chrono::seconds(MEMORY_STATS_INTERVAL_IN_SECONDS));
+      const auto report = GetReport();
+      if (!ENABLE_MEMORY_STATS_LOG) {
+        continue;
+      }
+
+      uint64_t totalBytes = 0;
+      for (const auto& entry : report) {
+        totalBytes += entry.second.m_bytes;
+        LOG_GENERAL(INFO, "[MEMSTATS] " << entry.first << " entries="
+                                        << entry.second.m_entries
+                                        << " bytes=" << entry.second.m_bytes);
+      }
+      LOG_GENERAL(INFO, "[MEMSTATS] tracked bytes=" << totalBytes << " rss="
+                                                    << GetResidentBytes());
+    }
+  };
+
+  DetachedFunction(DetachedFunction::Lane::BLOCKING, 1, func);
+}
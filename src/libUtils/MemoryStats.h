@@ -0,0 +1,82 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __MEMORYSTATS_H__
+#define __MEMORYSTATS_H__
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/Singleton.h"
+
+/// Estimated memory of the major containers of the node, per subsystem, for
+/// finding which one grows when the RSS of the node does. Each subsystem
+/// registers a function returning its number of entries and an estimate of
+/// their bytes, which is only called for a report, so there is no cost to the
+/// containers in between. The last report is also exported as the gauges
+/// zilliqa_memory_bytes and zilliqa_memory_entries.
+class MemoryStats : public Singleton<MemoryStats> {
+ public:
+  struct Usage {
+    uint64_t m_entries = 0;
+    uint64_t m_bytes = 0;
+
+    Usage& operator+=(const Usage& r) {
+      m_entries += r.m_entries;
+      m_bytes += r.m_bytes;
+      return *this;
+    }
+  };
+
+  typedef std::function<Usage()> Estimator;
+
+  /// Bytes of the elements of a node-based container, counting two pointers
+  /// of overhead per node
+  template <class Container>
+  static uint64_t NodeBytes(const Container& container) {
+    return container.size() *
+           (sizeof(typename Container::value_type) + 2 * sizeof(void*));
+  }
+
+  /// Registers the estimator of a subsystem, replacing any under that name.
+  /// It may take the locks of the subsystem, and must stay valid for the
+  /// life of the process.
+  void Register(const std::string& name, const Estimator& estimator);
+
+  /// Calls all the estimators, and keeps the result as the last report
+  std::map<std::string, Usage> GetReport();
+
+  /// Resident set size of the process, or 0 if unknown
+  static uint64_t GetResidentBytes();
+
+  /// Takes a report every MEMORY_STATS_INTERVAL_IN_SECONDS for the gauges,
+  /// logging it if ENABLE_MEMORY_STATS_LOG
+  void StartPeriodicReport();
+
+ private:
+  std::mutex m_mutex;
+  std::map<std::string, Estimator> m_estimators;
+  std::map<std::string, Usage> m_lastReport;
+
+  Usage GetLastUsage(const std::string& name);
+};
+
+#endif  // __MEMORYSTATS_H__
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Metrics.h"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
+#include "libUtils/Logger.h"
+
+using namespace std;
+
+namespace {
+
+/// name{labels} or name{labels,extra}, leaving out empty braces
+void WriteSeries(ostream& os, const string& name, const string& labels,
+                 const string& extra = "") {
+  os << name;
+  if (!labels.empty() || !extra.empty()) {
+    os << '{' << labels << (labels.empty() || extra.empty() ? "" : ",")
+       << extra << '}';
+  }
+  os << ' ';
+}
+
+}  // namespace
+
+Metrics::Histogram::Histogram(const vector<double>& bounds)
+    : m_bounds([&bounds]() {
+        vector<double> sorted(bounds);
+        sort(sorted.begin(), sorted.end());
+        sorted.push_back(numeric_limits<double>::infinity());
+        return sorted;
+      }()),
+      m_counts(new atomic<uint64_t>[m_bounds.size()]) {
+  for (size_t i = 0; i < m_bounds.size(); i++) {
+    m_counts[i] = 0;
+  }
+}
+
+void Metrics::Histogram::Observe(double value) {
+  const size_t bucket =
+      lower_bound(m_bounds.begin(), m_bounds.end(), value) - m_bounds.begin();
+  m_counts[min(bucket, m_bounds.size() - 1)]++;
+  m_count++;
+
+  double sum = m_sum;
+  while (!m_sum.compare_exchange_weak(sum, sum + value)) {
+  }
+}
+
+const vector<double>& Metrics::GetDefaultBounds() {
+  static const vector<double> bounds{0.001, 0.005, 0.01, 0.05, 0.1, 0.5,
+                                     1,     2.5,   5,    10,   30,  60,
+                                     120};
+  return bounds;
+}
+
+Metrics::Family& Metrics::GetFamily(const string& name, const string& help,
+                                    Type type) {
+  auto it = m_families.find(name);
+  if (it == m_families.end()) {
+    it = m_families.emplace(name, Family()).first;
+    it->second.m_type = type;
+    it->second.m_help = help;
+  } else if (it->second.m_type != type) {
+    LOG_GENERAL(WARNING, "Metric " << name << " registered with two types");
+  }
+  return it->second;
+}
+
+Metrics::Counter& Metrics::GetCounter(const string& name, const string& help,
+                                      const string& labels) {
+  lock_guard<mutex> g(m_mutex);
+  auto& counter = GetFamily(name, help, Type::COUNTER).m_counters[labels];
+  if (!counter) {
+    counter.reset(new Counter());
+  }
+  return *counter;
+}
+
+Metrics::Gauge& Metrics::GetGauge(const string& name, const string& help,
+                                  const string& labels) {
+  lock_guard<mutex> g(m_mutex);
+  auto& gauge = GetFamily(name, help, Type::GAUGE).m_gauges[labels];
+  if (!gauge) {
+    gauge.reset(new Gauge());
+  }
+  return *gauge;
+}
+
+Metrics::Histogram& Metrics::GetHistogram(const string& name,
+                                          const string& help,
+                                          const string& labels,
+                                          const vector<double>& bounds) {
+  lock_guard<mutex> g(m_mutex);
+  auto& histogram =
+      GetFamily(name, help, Type::HISTOGRAM).m_histograms[labels];
+  if (!histogram) {
+    histogram.reset(new Histogram(bounds));
+  }
+  return *histogram;
+}
+
+void Metrics::SetGaugeFunction(const string& name, const string& help,
+                               const function<double()>& function,
+                               const string& labels) {
+  lock_guard<mutex> g(m_mutex);
+  GetFamily(name, help, Type::GAUGE).m_gaugeFunctions[labels] = function;
+}
+
+void Metrics::WriteText(ostream& os) const {
+  lock_guard<mutex> g(m_mutex);
+
+  for (const auto& nameFamily : m_families) {
+    const string& name = nameFamily.first;
+    const Family& family = nameFamily.second;
+
+    os << "# HELP " << name << ' ' << family.m_help << '\n';
+    os << "# TYPE " << name << ' '
+       << (family.m_type == Type::COUNTER
+               ? "counter"
+               : (family.m_type == Type::HISTOGRAM ? "histogram" : "gauge"))
+       << '\n';
+
+    for (const auto& counter : family.m_counters) {
+      WriteSeries(os, name, counter.first);
+      os << counter.second->Get() << '\n';
+    }
+    for (const auto& gauge : family.m_gauges) {
+      WriteSeries(os, name, gauge.first);
+      os << gauge.second->Get() << '\n';
+    }
+    for (const auto& gauge : family.m_gaugeFunctions) {
+      WriteSeries(os, name, gauge.first);
+      os << gauge.second() << '\n';
+    }
+    for (const auto& labelsHistogram : family.m_histograms) {
+      const string& labels = labelsHistogram.first;
+      const Histogram& histogram = *labelsHistogram.second;
+      const auto& bounds = histogram.GetBounds();
+
+      uint64_t cumulative = 0;
+      for (size_t i = 0; i < bounds.size(); i++) {
+        cumulative += histogram.GetBucketCount(i);
+        ostringstream le;
+        if (i + 1 == bounds.size()) {
+          le << "le=\"+Inf\"";
+        } else {
+          le << "le=\"" << bounds[i] << '"';
+        }
+        WriteSeries(os, name + "_bucket", labels, le.str());
+        os << cumulative << '\n';
+      }
+      WriteSeries(os, name + "_sum", labels);
+      os << histogram.GetSum() << '\n';
+      // The buckets, rather than the count, so that the +Inf bucket always
+      // matches it even while observations are recorded
+      WriteSeries(os, name + "_count", labels);
+      os << cumulative << '\n';
+    }
+  }
+}
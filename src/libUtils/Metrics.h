@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "common/Singleton.h"
+
+/// Registry of the counters, gauges and histograms of the node, written out
+/// in the Prometheus text format for scraping. A metric is looked up once by
+/// name and labels, e.g. "phase=\"execute\"", and then updated through the
+/// returned reference with atomic operations only.
+class Metrics : public Singleton<Metrics> {
+ public:
+  class Counter {
+    std::atomic<uint64_t> m_value{0};
+
+   public:
+    void Increment(uint64_t by = 1) { m_value += by; }
+    uint64_t Get() const { return m_value; }
+  };
+
+  class Gauge {
+    std::atomic<int64_t> m_value{0};
+
+   public:
+    void Set(int64_t value) { m_value = value; }
+    void Increment(int64_t by = 1) { m_value += by; }
+    void Decrement(int64_t by = 1) { m_value -= by; }
+    int64_t Get() const { return m_value; }
+  };
+
+  class Histogram {
+    /// Upper bounds of the buckets, the last one being +Inf
+    const std::vector<double> m_bounds;
+    std::unique_ptr<std::atomic<uint64_t>[]> m_counts;
+    std::atomic<uint64_t> m_count{0};
+    std::atomic<double> m_sum{0};
+
+   public:
+    explicit Histogram(const std::vector<double>& bounds);
+
+    void Observe(double value);
+
+    const std::vector<double>& GetBounds() const { return m_bounds; }
+    /// Observations in bucket i, not cumulative
+    uint64_t GetBucketCount(size_t i) const { return m_counts[i]; }
+    uint64_t GetCount() const { return m_count; }
+    double GetSum() const { return m_sum; }
+  };
+
+  /// Observes the seconds from its construction to its destruction
+  class Timer {
+    Histogram& m_histogram;
+    const std::chrono::steady_clock::time_point m_start;
+
+   public:
+    explicit Timer(Histogram& histogram)
+        : m_histogram(histogram), m_start(std::chrono::steady_clock::now()) {}
+
+    ~Timer() {
+      m_histogram.Observe(std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - m_start)
+                              .count());
+    }
+  };
+
+  /// Bounds in seconds, from 1 ms to 2 minutes
+  static const std::vector<double>& GetDefaultBounds();
+
+  Counter& GetCounter(const std::string& name, const std::string& help,
+                      const std::string& labels = "");
+
+  Gauge& GetGauge(const std::string& name, const std::string& help,
+                  const std::string& labels = "");
+
+  Histogram& GetHistogram(
+      const std::string& name, const std::string& help,
+      const std::string& labels = "",
+      const std::vector<double>& bounds = GetDefaultBounds());
+
+  /// A gauge read when scraped, for values kept elsewhere. The function must
+  /// stay valid for the life of the process.
+  void SetGaugeFunction(const std::string& name, const std::string& help,
+                        const std::function<double()>& function,
+                        const std::string& labels = "");
+
+  /// Writes all the metrics in the Prometheus text exposition format
+  void WriteText(std::ostream& os) const;
+
+ private:
+  enum class Type { COUNTER, GAUGE, HISTOGRAM };
+
+  struct Family {
+    Type m_type;
+    std::string m_help;
+    std::map<std::string, std::unique_ptr<Counter>> m_counters;
+    std::map<std::string, std::unique_ptr<Gauge>> m_gauges;
+    std::map<std::string, std::function<double()>> m_gaugeFunctions;
+    std::map<std::string, std::unique_ptr<Histogram>> m_histograms;
+  };
+
+  mutable std::mutex m_mutex;
+  std::map<std::string, Family> m_families;
+
+  Family& GetFamily(const std::string& name, const std::string& help,
+                    Type type);
+};
+
+#endif  // __METRICS_H__
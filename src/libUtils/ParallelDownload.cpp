@@ -0,0 +1,409 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <curl/curl.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+#include "ParallelDownload.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+
+namespace {
+const unsigned int CHUNK_RETRIES = 3;
+const long CONNECT_TIMEOUT_IN_SECONDS = 30;
+/// A connection slower than this for the time below is given up and retried
+const long LOW_SPEED_LIMIT_IN_BYTES = 1024;
+const long LOW_SPEED_TIME_IN_SECONDS = 60;
+
+struct ChunkWrite {
+  int fd;
+  uint64_t offset;
+  uint64_t end;
+};
+
+size_t WriteChunk(char* data, size_t size, size_t nmemb, void* userdata) {
+  ChunkWrite& chunk = *static_cast<ChunkWrite*>(userdata);
+  const size_t length = size * nmemb;
+  if (chunk.offset + length > chunk.end) {
+    // More than asked for, so the server ignored the range
+    return 0;
+  }
+
+  size_t written = 0;
+  while (written < length) {
+    const ssize_t n =
+        pwrite(chunk.fd, data + written, length - written, chunk.offset);
+    if (n <= 0) {
+      return 0;
+    }
+    written += n;
+    chunk.offset += n;
+  }
+  return length;
+}
+
+size_t WriteConsumer(char* data, size_t size, size_t nmemb, void* userdata) {
+  const auto& consumer = *static_cast<const ParallelDownload::Consumer*>(
+      userdata);
+  const size_t length = size * nmemb;
+  return consumer(data, length) ? length : 0;
+}
+
+CURL* NewHandle(const string& url) {
+  static const bool curlInitialized =
+      curl_global_init(CURL_GLOBAL_DEFAULT) == CURLE_OK;
+  if (!curlInitialized) {
+    return nullptr;
+  }
+
+  CURL* curl = curl_easy_init();
+  if (curl != nullptr) {
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, CONNECT_TIMEOUT_IN_SECONDS);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, LOW_SPEED_LIMIT_IN_BYTES);
+    curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, LOW_SPEED_TIME_IN_SECONDS);
+  }
+  return curl;
+}
+}  // namespace
+
+ParallelDownload::ParallelDownload(const string& url, const string& filename,
+                                   unsigned int numConnections,
+                                   uint64_t chunkSize)
+    : m_url(url),
+      m_filename(filename),
+      m_partFilename(filename + ".part"),
+      m_journalFilename(filename + ".journal"),
+      m_numConnections(max(numConnections, 1u)),
+      m_chunkSize(max<uint64_t>(chunkSize, 1)) {}
+
+bool ParallelDownload::GetSize(int64_t& size) {
+  CURL* curl = NewHandle(m_url);
+  if (curl == nullptr) {
+    LOG_GENERAL(WARNING, "curl initialization fail!");
+    return false;
+  }
+
+  curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+  const CURLcode res = curl_easy_perform(curl);
+  curl_off_t length = -1;
+  if (res == CURLE_OK) {
+    curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &length);
+  }
+  curl_easy_cleanup(curl);
+
+  if (res != CURLE_OK) {
+    LOG_GENERAL(WARNING, "Cannot get the size of " << m_url << ": "
+                                                    << curl_easy_strerror(res));
+    return false;
+  }
+
+  size = length;
+  return true;
+}
+
+bool ParallelDownload::OpenJournal() {
+  const uint64_t numChunks = (m_size + m_chunkSize - 1) / m_chunkSize;
+  m_done.assign(numChunks, false);
+  m_numDone = 0;
+
+  // Starts with the size of the file and of its chunks, then lists the
+  // chunks on disk; a journal for other sizes is of a previous file
+  const uint64_t header[2] = {m_size, m_chunkSize};
+  bool resumed = false;
+  m_journalFd = open(m_journalFilename.c_str(), O_RDWR | O_CREAT, 0644);
+  if (m_journalFd < 0) {
+    LOG_GENERAL(WARNING, "Cannot open " << m_journalFilename);
+    return false;
+  }
+
+  uint64_t existing[2] = {0, 0};
+  uint64_t numRecords = 0;
+  if (read(m_journalFd, existing, sizeof(existing)) == sizeof(existing) &&
+      existing[0] == header[0] && existing[1] == header[1]) {
+    uint64_t index = 0;
+    while (read(m_journalFd, &index, sizeof(index)) == sizeof(index)) {
+      numRecords++;
+      if (index < numChunks && !m_done[index]) {
+        m_done[index] = true;
+        m_numDone++;
+      }
+    }
+    resumed = true;
+  }
+
+  // A record cut short by a crash is dropped, so its chunk is fetched again
+  // and the records appended from here on stay aligned
+  const off_t journalSize = sizeof(header) + numRecords * sizeof(uint64_t);
+  if (ftruncate(m_journalFd, resumed ? journalSize : 0) != 0 ||
+      (!resumed &&
+       pwrite(m_journalFd, header, sizeof(header), 0) != sizeof(header)) ||
+      lseek(m_journalFd, journalSize, SEEK_SET) != journalSize) {
+    LOG_GENERAL(WARNING, "Cannot write " << m_journalFilename);
+    return false;
+  }
+
+  m_fd = open(m_partFilename.c_str(),
+              O_RDWR | O_CREAT | (resumed ? 0 : O_TRUNC), 0644);
+  if (m_fd < 0 || ftruncate(m_fd, m_size) != 0) {
+    LOG_GENERAL(WARNING, "Cannot open " << m_partFilename);
+    return false;
+  }
+
+  m_missing.clear();
+  for (uint64_t i = 0; i < numChunks; i++) {
+    if (!m_done[i]) {
+      m_missing.push_back(i);
+    }
+  }
+  m_nextMissing = 0;
+
+  if (resumed) {
+    LOG_GENERAL(INFO, "Resuming " << m_url << " with " << m_numDone << " / "
+                                  << numChunks << " chunks on disk");
+  }
+  return true;
+}
+
+bool ParallelDownload::FetchChunk(void* curl, uint64_t index) {
+  const uint64_t begin = index * m_chunkSize;
+  const uint64_t end = min(begin + m_chunkSize, m_size);
+  const string range = to_string(begin) + "-" + to_string(end - 1);
+
+  for (unsigned int attempt = 0; attempt < CHUNK_RETRIES && !m_failed;
+       attempt++) {
+    ChunkWrite chunk{m_fd, begin, end};
+    curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteChunk);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &chunk);
+    const CURLcode res = curl_easy_perform(curl);
+
+    long responseCode = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &responseCode);
+    // A single chunk covering the whole file may come back as a plain 200
+    const bool isWhole = (responseCode == 206) ||
+                         (responseCode == 200 && begin == 0 && end == m_size);
+    if (res == CURLE_OK && isWhole && chunk.offset == end) {
+      return true;
+    }
+
+    LOG_GENERAL(WARNING, "Chunk " << range << " of " << m_url
+                                   << " failed (attempt " << attempt + 1
+                                   << "): " << curl_easy_strerror(res)
+                                   << ", response " << responseCode);
+  }
+
+  return false;
+}
+
+void ParallelDownload::Fetch() {
+  CURL* curl = NewHandle(m_url);
+  if (curl == nullptr) {
+    LOG_GENERAL(WARNING, "curl initialization fail!");
+    m_failed = true;
+  }
+
+  while (!m_failed) {
+    const size_t next = m_nextMissing++;
+    if (next >= m_missing.size()) {
+      break;
+    }
+
+    const uint64_t index = m_missing[next];
+    if (!FetchChunk(curl, index)) {
+      m_failed = true;
+      break;
+    }
+
+    // On disk before the journal says so
+    if (fdatasync(m_fd) != 0 ||
+        write(m_journalFd, &index, sizeof(index)) != sizeof(index)) {
+      LOG_GENERAL(WARNING, "Cannot record chunk " << index << " of "
+                                                  << m_url);
+      m_failed = true;
+      break;
+    }
+
+    lock_guard<mutex> g(m_mutexDone);
+    m_done[index] = true;
+    m_numDone++;
+    m_cvDone.notify_all();
+  }
+
+  if (curl != nullptr) {
+    curl_easy_cleanup(curl);
+  }
+
+  lock_guard<mutex> g(m_mutexDone);
+  m_numFetching--;
+  m_cvDone.notify_all();
+}
+
+bool ParallelDownload::Consume(const Consumer& consumer) {
+  const uint64_t bufferSize = min<uint64_t>(m_chunkSize, 1 << 20);
+  vector<char> buffer(bufferSize);
+
+  for (uint64_t index = 0; index < m_done.size(); index++) {
+    {
+      unique_lock<mutex> lock(m_mutexDone);
+      m_cvDone.wait(lock, [this, index]() {
+        return m_done[index] || m_numFetching == 0;
+      });
+      if (!m_done[index]) {
+        return false;
+      }
+    }
+
+    const uint64_t end = min((index + 1) * m_chunkSize, m_size);
+    for (uint64_t offset = index * m_chunkSize; offset < end;) {
+      const ssize_t n =
+          pread(m_fd, buffer.data(), min(bufferSize, end - offset), offset);
+      if (n <= 0) {
+        LOG_GENERAL(WARNING, "Cannot read back " << m_partFilename);
+        return false;
+      }
+      if (!consumer(buffer.data(), n)) {
+        return false;
+      }
+      offset += n;
+    }
+  }
+
+  return true;
+}
+
+bool ParallelDownload::RunSingle(const Consumer& consumer) {
+  CURL* curl = NewHandle(m_url);
+  if (curl == nullptr) {
+    LOG_GENERAL(WARNING, "curl initialization fail!");
+    return false;
+  }
+
+  FILE* file = fopen(m_partFilename.c_str(), "wb");
+  if (file == nullptr) {
+    LOG_GENERAL(WARNING, "Cannot open " << m_partFilename);
+    curl_easy_cleanup(curl);
+    return false;
+  }
+
+  const Consumer write = [&consumer, file](const char* data, size_t size) {
+    return fwrite(data, 1, size, file) == size &&
+           (!consumer || consumer(data, size));
+  };
+  curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteConsumer);
+  curl_easy_setopt(curl, CURLOPT_WRITEDATA, &write);
+  const CURLcode res = curl_easy_perform(curl);
+  curl_easy_cleanup(curl);
+
+  if (fclose(file) != 0 || res != CURLE_OK) {
+    LOG_GENERAL(WARNING, "Download of " << m_url << " failed: "
+                                        << curl_easy_strerror(res));
+    return false;
+  }
+
+  return Finish();
+}
+
+bool ParallelDownload::Finish() {
+  if (rename(m_partFilename.c_str(), m_filename.c_str()) != 0) {
+    LOG_GENERAL(WARNING, "Cannot rename " << m_partFilename);
+    return false;
+  }
+  unlink(m_journalFilename.c_str());
+  return true;
+}
+
+bool ParallelDownload::Run(const Consumer& consumer) {
+  LOG_MARKER();
+
+  // Done by a previous run, whose consumer may have failed after
+  struct stat st;
+  if (stat(m_filename.c_str(), &st) == 0 &&
+      access(m_journalFilename.c_str(), F_OK) != 0) {
+    LOG_GENERAL(INFO, m_filename << " already downloaded");
+    if (!consumer) {
+      return true;
+    }
+    m_fd = open(m_filename.c_str(), O_RDONLY);
+    if (m_fd < 0) {
+      LOG_GENERAL(WARNING, "Cannot open " << m_filename);
+      return false;
+    }
+    m_size = st.st_size;
+    m_done.assign((m_size + m_chunkSize - 1) / m_chunkSize, true);
+    const bool consumed = Consume(consumer);
+    close(m_fd);
+    m_fd = -1;
+    return consumed;
+  }
+
+  int64_t size = -1;
+  if (!GetSize(size)) {
+    return false;
+  }
+  if (size < 0) {
+    LOG_GENERAL(INFO, "Size of " << m_url << " unknown, downloading it whole");
+    return RunSingle(consumer);
+  }
+  m_size = size;
+
+  bool ret = OpenJournal();
+  if (ret) {
+    m_numFetching = m_numConnections;
+    vector<thread> connections;
+    for (unsigned int i = 0; i < m_numConnections; i++) {
+      connections.emplace_back([this]() { Fetch(); });
+    }
+
+    if (consumer && !Consume(consumer)) {
+      m_failed = true;
+    }
+    for (auto& connection : connections) {
+      connection.join();
+    }
+    ret = !m_failed && m_numDone == m_done.size();
+  }
+
+  if (m_fd >= 0) {
+    ret = (fsync(m_fd) == 0) && ret;
+    close(m_fd);
+    m_fd = -1;
+  }
+  if (m_journalFd >= 0) {
+    close(m_journalFd);
+    m_journalFd = -1;
+  }
+
+  if (!ret) {
+    LOG_GENERAL(WARNING, "Download of " << m_url << " stopped with "
+                                        << m_numDone << " / " << m_done.size()
+                                        << " chunks on disk");
+    return false;
+  }
+
+  LOG_GENERAL(INFO, "Downloaded " << m_url << ", " << m_size << " bytes");
+  return Finish();
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __PARALLELDOWNLOAD_H__
+#define __PARALLELDOWNLOAD_H__
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/// Downloads a file over HTTP on several connections at once, each fetching
+/// chunks of it with range requests, and resumes after an interruption.
+///
+/// The chunks are written in place into filename + ".part". Each one is
+/// recorded in filename + ".journal" once it is on disk, so a later run only
+/// fetches the chunks the journal does not list. When all are done the part
+/// file is renamed to filename. Servers that do not tell the size of the
+/// file are read on one connection, from the start each run.
+class ParallelDownload {
+ public:
+  /// Takes the bytes of the file in order; returning false stops the download
+  typedef std::function<bool(const char* data, size_t size)> Consumer;
+
+  ParallelDownload(const std::string& url, const std::string& filename,
+                   unsigned int numConnections, uint64_t chunkSize);
+  ParallelDownload(const ParallelDownload&) = delete;
+  ParallelDownload& operator=(const ParallelDownload&) = delete;
+
+  /// Downloads the file, unless a previous run already did. If consumer is
+  /// set, it is given the whole file from its start as the download goes on,
+  /// such as for extracting it while the rest arrives.
+  bool Run(const Consumer& consumer = Consumer());
+
+ private:
+  bool GetSize(int64_t& size);
+  bool OpenJournal();
+  bool FetchChunk(void* curl, uint64_t index);
+  void Fetch();
+  bool Consume(const Consumer& consumer);
+  bool RunSingle(const Consumer& consumer);
+  bool Finish();
+
+  const std::string m_url;
+  const std::string m_filename;
+  const std::string m_partFilename;
+  const std::string m_journalFilename;
+  const unsigned int m_numConnections;
+  const uint64_t m_chunkSize;
+
+  uint64_t m_size = 0;
+  int m_fd = -1;
+  int m_journalFd = -1;
+
+  /// Chunks to fetch, taken in order by the connections
+  std::vector<uint64_t> m_missing;
+  std::atomic<size_t> m_nextMissing{0};
+  std::atomic<bool> m_failed{false};
+
+  std::vector<bool> m_done;
+  size_t m_numDone = 0;
+  /// Connections still fetching chunks
+  unsigned int m_numFetching = 0;
+  std::mutex m_mutexDone;
+  std::condition_variable m_cvDone;
+};
+
+#endif  // __PARALLELDOWNLOAD_H__
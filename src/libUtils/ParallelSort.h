@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __PARALLELSORT_H__
+#define __PARALLELSORT_H__
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <vector>
+
+#include "JoinableFunction.h"
+
+/// Ranges shorter than this are sorted on the calling thread only
+const size_t PARALLEL_SORT_MIN_SIZE = 1024;
+
+/// Sorts [first, last) as std::sort does, on up to numThreads threads: the
+/// range is cut into chunks that are sorted side by side, then merged pairwise
+/// in rounds. Like std::sort it is not stable, so comp should order elements
+/// fully where the result must not depend on the thread count.
+template <class RandomIt, class Compare>
+void ParallelSort(RandomIt first, RandomIt last, Compare comp,
+                  unsigned int numThreads) {
+  const size_t size = std::distance(first, last);
+  if (numThreads <= 1 || size < PARALLEL_SORT_MIN_SIZE) {
+    std::sort(first, last, comp);
+    return;
+  }
+
+  const size_t numChunks = std::min<size_t>(numThreads, size);
+  std::vector<RandomIt> bounds;
+  for (size_t i = 0; i <= numChunks; i++) {
+    bounds.emplace_back(first + size * i / numChunks);
+  }
+
+  {
+    std::atomic<size_t> next{0};
+    JoinableFunction sorters(numChunks, [&]() {
+      for (size_t i = next++; i < numChunks; i = next++) {
+        std::sort(bounds[i], bounds[i + 1], comp);
+      }
+    });
+  }
+
+  // Each round merges neighbouring pairs of sorted runs, halving their number
+  for (size_t width = 1; width < numChunks; width *= 2) {
+    const size_t numMerges = (numChunks + 2 * width - 1) / (2 * width);
+    std::atomic<size_t> next{0};
+    JoinableFunction mergers(numMerges, [&]() {
+      for (size_t i = next++; i < numMerges; i = next++) {
+        const size_t begin = i * 2 * width;
+        const size_t middle = std::min(begin + width, numChunks);
+        const size_t end = std::min(begin + 2 * width, numChunks);
+        std::inplace_merge(bounds[begin], bounds[middle], bounds[end], comp);
+      }
+    });
+  }
+}
+
+#endif  // __PARALLELSORT_H__
@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __RATELIMITER_H__
+#define __RATELIMITER_H__
+
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/// Thread-safe token buckets, one per key, each refilling at rate tokens per
+/// second up to a burst of one second's worth. Keys are forgotten once their
+/// bucket is full again, so that one-off keys (e.g. client addresses) do not
+/// pile up.
+class RateLimiter {
+  typedef std::chrono::steady_clock Clock;
+
+  struct Bucket {
+    double m_tokens;
+    Clock::time_point m_last;
+  };
+
+  const std::size_t m_maxKeys;
+  std::mutex m_mutex;
+  std::unordered_map<std::string, Bucket> m_buckets;
+
+  /// Drops the buckets that have refilled, called with m_mutex held
+  void Prune(const Clock::time_point& now, double rate) {
+    for (auto it = m_buckets.begin(); it != m_buckets.end();) {
+      const double elapsed =
+          std::chrono::duration<double>(now - it->second.m_last).count();
+      if (it->second.m_tokens + elapsed * rate >= rate) {
+        it = m_buckets.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+
+ public:
+  explicit RateLimiter(std::size_t maxKeys = 100000) : m_maxKeys(maxKeys) {}
+
+  /// Takes a token from the bucket of key, returns false if it is empty.
+  /// A rate of 0 means no limit.
+  bool TryAcquire(const std::string& key, double rate,
+                  const Clock::time_point& now = Clock::now()) {
+    if (rate <= 0) {
+      return true;
+    }
+
+    std::lock_guard<std::mutex> g(m_mutex);
+    auto it = m_buckets.find(key);
+    if (it == m_buckets.end()) {
+      if (m_buckets.size() >= m_maxKeys) {
+        Prune(now, rate);
+        if (m_buckets.size() >= m_maxKeys) {
+          return false;
+        }
+      }
+      m_buckets.emplace(key, Bucket{rate - 1, now});
+      return true;
+    }
+
+    Bucket& bucket = it->second;
+    const double elapsed =
+        std::chrono::duration<double>(now - bucket.m_last).count();
+    bucket.m_tokens = std::min(rate, bucket.m_tokens + elapsed * rate);
+    bucket.m_last = now;
+    if (bucket.m_tokens < 1) {
+      return false;
+    }
+    bucket.m_tokens -= 1;
+    return true;
+  }
+
+  std::size_t size() {
+    std::lock_guard<std::mutex> g(m_mutex);
+    return m_buckets.size();
+  }
+};
+
+#endif  // __RATELIMITER_H__
@@ -0,0 +1,243 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ReedSolomon.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+
+namespace {
+
+/// Log and exponent tables of GF(2^8) with the 0x11D generator polynomial
+struct GaloisField {
+  unsigned char m_exp[512];
+  unsigned char m_log[256];
+
+  GaloisField() {
+    unsigned int x = 1;
+    for (unsigned int i = 0; i < 255; i++) {
+      m_exp[i] = (unsigned char)x;
+      m_log[x] = (unsigned char)i;
+      x <<= 1;
+      if (x & 0x100) {
+        x ^= 0x11D;
+      }
+    }
+    // Doubled so that m_exp[log a + log b] never needs a modulo
+    for (unsigned int i = 255; i < 512; i++) {
+      m_exp[i] = m_exp[i - 255];
+    }
+    m_log[0] = 0;
+  }
+
+  unsigned char Mul(unsigned char a, unsigned char b) const {
+    if (a == 0 || b == 0) {
+      return 0;
+    }
+    return m_exp[m_log[a] + m_log[b]];
+  }
+
+  unsigned char Inv(unsigned char a) const { return m_exp[255 - m_log[a]]; }
+};
+
+const GaloisField& GetField() {
+  static const GaloisField field;
+  return field;
+}
+
+/// Coefficient of data shard col in parity shard row
+unsigned char CauchyCoefficient(unsigned int row, unsigned int col,
+                                unsigned int dataShards) {
+  // x = dataShards + row and y = col never collide, so x ^ y is never zero
+  return GetField().Inv((unsigned char)((dataShards + row) ^ col));
+}
+
+/// dst ^= coef * src over the field, byte by byte
+void MulAdd(unsigned char coef, const unsigned char* src, unsigned char* dst,
+            size_t len) {
+  if (coef == 0) {
+    return;
+  }
+
+  const GaloisField& gf = GetField();
+  unsigned char table[256];
+  for (unsigned int x = 0; x < 256; x++) {
+    table[x] = gf.Mul(coef, (unsigned char)x);
+  }
+
+  for (size_t i = 0; i < len; i++) {
+    dst[i] ^= table[src[i]];
+  }
+}
+
+/// Inverts the n x n matrix in place by Gauss-Jordan elimination
+bool InvertMatrix(vector<vector<unsigned char>>& matrix) {
+  const GaloisField& gf = GetField();
+  const unsigned int n = matrix.size();
+
+  vector<vector<unsigned char>> inverse(n, vector<unsigned char>(n, 0));
+  for (unsigned int i = 0; i < n; i++) {
+    inverse[i][i] = 1;
+  }
+
+  for (unsigned int col = 0; col < n; col++) {
+    unsigned int pivot = col;
+    while (pivot < n && matrix[pivot][col] == 0) {
+      pivot++;
+    }
+    if (pivot == n) {
+      return false;
+    }
+    swap(matrix[pivot], matrix[col]);
+    swap(inverse[pivot], inverse[col]);
+
+    const unsigned char scale = gf.Inv(matrix[col][col]);
+    for (unsigned int j = 0; j < n; j++) {
+      matrix[col][j] = gf.Mul(matrix[col][j], scale);
+      inverse[col][j] = gf.Mul(inverse[col][j], scale);
+    }
+
+    for (unsigned int row = 0; row < n; row++) {
+      const unsigned char factor = matrix[row][col];
+      if (row == col || factor == 0) {
+        continue;
+      }
+      for (unsigned int j = 0; j < n; j++) {
+        matrix[row][j] ^= gf.Mul(factor, matrix[col][j]);
+        inverse[row][j] ^= gf.Mul(factor, inverse[col][j]);
+      }
+    }
+  }
+
+  matrix.swap(inverse);
+  return true;
+}
+
+}  // anonymous namespace
+
+size_t ReedSolomon::GetShardSize(size_t dataLength, unsigned int dataShards) {
+  if (dataShards == 0) {
+    return 0;
+  }
+  return (dataLength + dataShards - 1) / dataShards;
+}
+
+bool ReedSolomon::Encode(const bytes& data, unsigned int dataShards,
+                         unsigned int parityShards, vector<bytes>& shards) {
+  if (dataShards == 0 || dataShards + parityShards > MAX_TOTAL_SHARDS) {
+    LOG_GENERAL(WARNING, "Invalid shard counts " << dataShards << "+"
+                                                 << parityShards);
+    return false;
+  }
+
+  const size_t shardSize = GetShardSize(data.size(), dataShards);
+  shards.assign(dataShards + parityShards, bytes(shardSize, 0));
+
+  for (unsigned int i = 0; i < dataShards; i++) {
+    const size_t begin = min(data.size(), i * shardSize);
+    const size_t end = min(data.size(), begin + shardSize);
+    copy(data.begin() + begin, data.begin() + end, shards[i].begin());
+  }
+
+  for (unsigned int row = 0; row < parityShards; row++) {
+    bytes& parity = shards[dataShards + row];
+    for (unsigned int col = 0; col < dataShards; col++) {
+      MulAdd(CauchyCoefficient(row, col, dataShards), shards[col].data(),
+             parity.data(), shardSize);
+    }
+  }
+
+  return true;
+}
+
+bool ReedSolomon::Decode(const map<unsigned int, bytes>& shards,
+                         unsigned int dataShards, unsigned int parityShards,
+                         size_t dataLength, bytes& data) {
+  if (dataShards == 0 || dataShards + parityShards > MAX_TOTAL_SHARDS) {
+    LOG_GENERAL(WARNING, "Invalid shard counts " << dataShards << "+"
+                                                 << parityShards);
+    return false;
+  }
+
+  const size_t shardSize = GetShardSize(dataLength, dataShards);
+
+  // Take the first dataShards usable shards, which are the data shards
+  // themselves whenever they have all arrived
+  vector<unsigned int> indexes;
+  vector<const bytes*> inputs;
+  for (const auto& shard : shards) {
+    if (indexes.size() == dataShards) {
+      break;
+    }
+    if (shard.first >= dataShards + parityShards ||
+        shard.second.size() != shardSize) {
+      continue;
+    }
+    indexes.emplace_back(shard.first);
+    inputs.emplace_back(&shard.second);
+  }
+
+  if (indexes.size() < dataShards) {
+    return false;
+  }
+
+  data.clear();
+  data.reserve(shardSize * dataShards);
+
+  if (indexes.back() < dataShards) {
+    for (const auto& input : inputs) {
+      data.insert(data.end(), input->begin(), input->end());
+    }
+    data.resize(dataLength);
+    return true;
+  }
+
+  // Rows of the encoding matrix for the shards at hand, then invert them
+  vector<vector<unsigned char>> matrix(dataShards,
+                                       vector<unsigned char>(dataShards, 0));
+  for (unsigned int i = 0; i < dataShards; i++) {
+    if (indexes[i] < dataShards) {
+      matrix[i][indexes[i]] = 1;
+    } else {
+      for (unsigned int col = 0; col < dataShards; col++) {
+        matrix[i][col] =
+            CauchyCoefficient(indexes[i] - dataShards, col, dataShards);
+      }
+    }
+  }
+
+  if (!InvertMatrix(matrix)) {
+    LOG_GENERAL(WARNING, "Shards do not form an invertible matrix");
+    return false;
+  }
+
+  data.resize(shardSize * dataShards, 0);
+  for (unsigned int row = 0; row < dataShards; row++) {
+    unsigned char* out = data.data() + row * shardSize;
+    if (indexes[row] == row) {
+      // Data shard already in place
+      copy(inputs[row]->begin(), inputs[row]->end(), out);
+      continue;
+    }
+    for (unsigned int j = 0; j < dataShards; j++) {
+      MulAdd(matrix[row][j], inputs[j]->data(), out, shardSize);
+    }
+  }
+
+  data.resize(dataLength);
+  return true;
+}
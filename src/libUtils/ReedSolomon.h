@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __REEDSOLOMON_H__
+#define __REEDSOLOMON_H__
+
+#include <map>
+#include <vector>
+
+#include "common/BaseType.h"
+
+/// Systematic Reed-Solomon erasure code over GF(2^8). Data is split into
+/// dataShards equally sized shards followed by parityShards parity shards
+/// built from a Cauchy matrix, and any dataShards of them rebuild the data.
+class ReedSolomon {
+ public:
+  /// Field size limits dataShards + parityShards
+  static const unsigned int MAX_TOTAL_SHARDS = 256;
+
+  /// Returns the size of each shard, the last data shard being zero-padded
+  static size_t GetShardSize(size_t dataLength, unsigned int dataShards);
+
+  /// Splits data into dataShards + parityShards shards.
+  static bool Encode(const bytes& data, unsigned int dataShards,
+                     unsigned int parityShards, std::vector<bytes>& shards);
+
+  /// Rebuilds dataLength bytes of data from shards keyed by shard index.
+  /// Needs at least dataShards shards of the size given by GetShardSize.
+  static bool Decode(const std::map<unsigned int, bytes>& shards,
+                     unsigned int dataShards, unsigned int parityShards,
+                     size_t dataLength, bytes& data);
+};
+
+#endif  // __REEDSOLOMON_H__
@@ -15,6 +15,8 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <array>
+
 #include "RootComputation.h"
 #include "libCrypto/Sha2.h"
 
@@ -41,6 +43,38 @@ inline const TxnHash& GetHash(const TransactionWithReceipt& item) {
 }
 };  // namespace
 
+/// Feeds the item hashes to SHA256 in batches copied into one buffer, as
+/// a call per 32-byte hash costs more than hashing it, and asBytes() would
+/// allocate a copy of each.
+class HashBatcher {
+ public:
+  explicit HashBatcher(SHA2<HASH_TYPE::HASH_VARIANT_256>& sha2)
+      : m_sha2(sha2) {}
+
+  ~HashBatcher() { Flush(); }
+
+  void Add(const TxnHash& hash) {
+    if (m_size == BATCH_SIZE) {
+      Flush();
+    }
+    copy(hash.data(), hash.data() + TxnHash::size, m_buffer[m_size++].data());
+  }
+
+  void Flush() {
+    if (m_size > 0) {
+      m_sha2.Update(m_buffer[0].data(), m_size * TxnHash::size);
+      m_size = 0;
+    }
+  }
+
+ private:
+  static constexpr unsigned int BATCH_SIZE = 64;
+
+  SHA2<HASH_TYPE::HASH_VARIANT_256>& m_sha2;
+  array<array<unsigned char, TxnHash::size>, BATCH_SIZE> m_buffer;
+  unsigned int m_size = 0;
+};
+
 template <typename... Container>
 TxnHash ConcatTranAndHash(const Container&... conts) {
   LOG_MARKER();
@@ -48,18 +82,21 @@ TxnHash ConcatTranAndHash(const Container&... conts) {
   SHA2<HASH_TYPE::HASH_VARIANT_256> sha2;
   bool hasValue = false;
 
-  (void)std::initializer_list<int>{(
-      [](const auto& list, decltype(sha2)& sha2, bool& hasValue) {
-        if (list.empty()) {
-          return;
-        }
-        hasValue = true;
-
-        for (auto& item : list) {
-          sha2.Update(GetHash(item).asBytes());
-        }
-      }(conts, sha2, hasValue),
-      0)...};
+  {
+    HashBatcher batcher(sha2);
+    (void)std::initializer_list<int>{(
+        [](const auto& list, HashBatcher& batcher, bool& hasValue) {
+          if (list.empty()) {
+            return;
+          }
+          hasValue = true;
+
+          for (auto& item : list) {
+            batcher.Add(GetHash(item));
+          }
+        }(conts, batcher, hasValue),
+        0)...};
+  }
 
   return hasValue ? TxnHash{sha2.Finalize()} : TxnHash();
 }
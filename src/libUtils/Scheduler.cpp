@@ -16,75 +16,206 @@
  */
 
 #include "Scheduler.h"
-#include "ReverseLock.h"
 
 using namespace std;
 
-Scheduler::Scheduler() {}
-
-Scheduler::~Scheduler() {}
-
-void Scheduler::ServiceQueue() {
-  unique_lock<mutex> lock(newTaskMutex);
-
-  while (true) {
-    try {
-      while (taskQueue.empty()) {
-        newTaskScheduled.wait(lock);
-      }
-
-      while (!taskQueue.empty()) {
-        std::chrono::time_point<std::chrono::system_clock> timeToWaitFor =
-            taskQueue.begin()->first;
-        if (newTaskScheduled.wait_until(lock, timeToWaitFor) ==
-            std::cv_status::timeout) {
-          break;
-        }
-      }
-
-      if (taskQueue.empty()) {
-        continue;
-      }
-
-      std::function<void(void)> f = taskQueue.begin()->second;
-      taskQueue.erase(taskQueue.begin());
-
-      {
-        ReverseLock<unique_lock<mutex>> rlock(lock);
-        f();
-      }
-    } catch (...) {
-      throw;
-    }
+// Wheel l holds the tasks due within WHEEL_SIZE^(l+1) ticks, in slots of
+// WHEEL_SIZE^l ticks each, indexed by the bits of the expiry for that wheel.
+// Each time the ticks of a wheel wrap, the next slot of the wheel above is
+// emptied into the wheels below, so a task moves down at most NUM_WHEELS - 1
+// times before it is due.
+
+Scheduler::Scheduler(const unsigned int numThreads)
+    : m_start(chrono::steady_clock::now()),
+      m_pool(max(numThreads, 1u), "Scheduler") {
+  m_thread = thread([this]() { Run(); });
+}
+
+Scheduler::~Scheduler() {
+  {
+    lock_guard<mutex> g(m_mutex);
+    m_stop = true;
   }
-  newTaskScheduled.notify_one();
+  m_cv.notify_one();
+  m_thread.join();
+}
+
+uint64_t Scheduler::NowTicks() const {
+  return chrono::duration_cast<chrono::milliseconds>(
+             chrono::steady_clock::now() - m_start)
+             .count() /
+         TICK_MS;
 }
 
-void Scheduler::ScheduleAt(std::function<void(void)> f,
-                           chrono::time_point<chrono::system_clock> t) {
+Scheduler::TaskHandle Scheduler::ScheduleAt(
+    std::function<void(void)> f, chrono::time_point<chrono::system_clock> t) {
+  const auto delta = chrono::duration_cast<chrono::milliseconds>(
+                         t - chrono::system_clock::now())
+                         .count();
+  return ScheduleAfter(move(f), delta);
+}
+
+Scheduler::TaskHandle Scheduler::ScheduleAfter(std::function<void(void)> f,
+                                               int64_t deltaMilliSeconds) {
+  // One tick more than the delay, as the current tick is partly over
+  const uint64_t delayTicks =
+      deltaMilliSeconds > 0 ? (deltaMilliSeconds + TICK_MS - 1) / TICK_MS : 0;
+  return Schedule(move(f), delayTicks + 1, 0);
+}
+
+Scheduler::TaskHandle Scheduler::SchedulePeriodically(
+    std::function<void(void)> f, int64_t deltaMilliSeconds) {
+  const uint64_t periodTicks =
+      max<int64_t>((deltaMilliSeconds + TICK_MS - 1) / TICK_MS, 1);
+  return Schedule(move(f), periodTicks + 1, periodTicks);
+}
+
+Scheduler::TaskHandle Scheduler::Schedule(std::function<void(void)>&& f,
+                                          uint64_t delayTicks,
+                                          uint64_t periodTicks) {
+  bool wasEmpty = false;
+  TaskHandle handle = 0;
   {
-    lock_guard<mutex> lock(newTaskMutex);
-    taskQueue.emplace(t, f);
+    lock_guard<mutex> g(m_mutex);
+    wasEmpty = m_tasks.empty();
+    if (wasEmpty) {
+      // The wheel stops turning while empty, so catch up first
+      m_currentTick = NowTicks();
+    }
+
+    handle = m_nextHandle++;
+    Slot task;
+    task.push_back({handle, NowTicks() + delayTicks, periodTicks, move(f)});
+    Place(task, task.begin());
   }
-  newTaskScheduled.notify_one();
+
+  if (wasEmpty) {
+    m_cv.notify_one();
+  }
+
+  return handle;
 }
 
-void Scheduler::ScheduleAfter(std::function<void(void)> f,
-                              int64_t deltaMilliSeconds) {
-  ScheduleAt(
-      f, chrono::system_clock::now() + chrono::milliseconds(deltaMilliSeconds));
+void Scheduler::Place(Slot& from, Slot::iterator it) {
+  const uint64_t expiry = it->m_expiry;
+  uint64_t placeAt = max(expiry, m_currentTick);
+
+  unsigned int wheel = 0;
+  while (wheel < NUM_WHEELS - 1 &&
+         placeAt - m_currentTick >= (1ull << (WHEEL_BITS * (wheel + 1)))) {
+    ++wheel;
+  }
+
+  // Beyond the top wheel, wait in its last slot and be placed again from there
+  const uint64_t range = 1ull << (WHEEL_BITS * NUM_WHEELS);
+  if (placeAt - m_currentTick >= range) {
+    placeAt = m_currentTick + range - 1;
+  }
+
+  Slot& slot =
+      m_wheels[wheel][(placeAt >> (WHEEL_BITS * wheel)) & (WHEEL_SIZE - 1)];
+  slot.splice(slot.end(), from, it);
+  m_tasks[it->m_handle] = {&slot, it};
 }
 
-static void SchedulePeriodicallyHelper(Scheduler* s,
-                                       std::function<void(void)> f,
-                                       int64_t deltaMilliSeconds) {
-  f();
-  s->ScheduleAfter(bind(&SchedulePeriodicallyHelper, s, f, deltaMilliSeconds),
-                   deltaMilliSeconds);
+void Scheduler::Tick(Slot& due) {
+  ++m_currentTick;
+
+  for (unsigned int wheel = NUM_WHEELS - 1; wheel > 0; --wheel) {
+    const unsigned int shift = WHEEL_BITS * wheel;
+    if ((m_currentTick & ((1ull << shift) - 1)) != 0) {
+      continue;
+    }
+
+    Slot& slot = m_wheels[wheel][(m_currentTick >> shift) & (WHEEL_SIZE - 1)];
+    while (!slot.empty()) {
+      Place(slot, slot.begin());
+    }
+  }
+
+  // Everything in the slot of the bottom wheel is due, including the tasks
+  // just moved down that were due now
+  Slot& slot = m_wheels[0][m_currentTick & (WHEEL_SIZE - 1)];
+  for (const auto& task : slot) {
+    m_tasks.erase(task.m_handle);
+    if (task.m_periodTicks > 0) {
+      m_running.insert(task.m_handle);
+    }
+  }
+  due.splice(due.end(), slot);
+}
+
+void Scheduler::Dispatch(Task&& task) {
+  if (task.m_periodTicks == 0) {
+    m_pool.AddJob(move(task.m_func));
+    return;
+  }
+
+  auto periodic = make_shared<Task>(move(task));
+  m_pool.AddJob([this, periodic]() {
+    periodic->m_func();
+
+    lock_guard<mutex> g(m_mutex);
+    if (m_running.erase(periodic->m_handle) == 0 || m_stop) {
+      return;
+    }
+
+    // Skip the periods missed while the wheel or the pool was behind
+    periodic->m_expiry += periodic->m_periodTicks;
+    if (periodic->m_expiry <= m_currentTick) {
+      periodic->m_expiry = m_currentTick + 1;
+    }
+
+    const bool wasEmpty = m_tasks.empty();
+    Slot task;
+    task.push_back(move(*periodic));
+    Place(task, task.begin());
+    if (wasEmpty) {
+      m_cv.notify_one();
+    }
+  });
+}
+
+bool Scheduler::Cancel(TaskHandle handle) {
+  lock_guard<mutex> g(m_mutex);
+
+  auto it = m_tasks.find(handle);
+  if (it != m_tasks.end()) {
+    it->second.m_slot->erase(it->second.m_it);
+    m_tasks.erase(it);
+    return true;
+  }
+
+  return m_running.erase(handle) > 0;
 }
 
-void Scheduler::SchedulePeriodically(std::function<void(void)> f,
-                                     int64_t deltaMilliSeconds) {
-  ScheduleAfter(bind(&SchedulePeriodicallyHelper, this, f, deltaMilliSeconds),
-                deltaMilliSeconds);
+size_t Scheduler::GetNumTasks() const {
+  lock_guard<mutex> g(m_mutex);
+  return m_tasks.size();
+}
+
+void Scheduler::Run() {
+  unique_lock<mutex> lock(m_mutex);
+
+  while (!m_stop) {
+    if (m_tasks.empty()) {
+      m_cv.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+      continue;
+    }
+
+    Slot due;
+    const uint64_t now = NowTicks();
+    while (m_currentTick < now && !m_tasks.empty()) {
+      Tick(due);
+    }
+
+    for (auto& task : due) {
+      Dispatch(move(task));
+    }
+
+    if (!m_tasks.empty()) {
+      m_cv.wait_until(lock, m_start + chrono::milliseconds(
+                                          (m_currentTick + 1) * TICK_MS));
+    }
+  }
 }
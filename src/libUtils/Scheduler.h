@@ -18,42 +18,108 @@
 #ifndef __SCHEDULER_H__
 #define __SCHEDULER_H__
 
+#include <array>
 #include <chrono>
 #include <condition_variable>
 #include <functional>
-#include <map>
+#include <list>
 #include <mutex>
 #include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
-// should be initialized this way
-// CScheduler::Function serviceLoop = boost::bind(&CScheduler::serviceQueue,
-// &scheduler);
-// threadGroup.create_thread(boost::bind(&TraceThread<CScheduler::Function>,
-// "scheduler", serviceLoop));
+#include "common/Constants.h"
+#include "common/Singleton.h"
+#include "libUtils/Logger.h"
+#include "libUtils/ThreadPool.h"
 
-/// [TODO] Currently unused
-class Scheduler {
+/// Runs functions after a delay, once or periodically, in place of threads
+/// that sleep until a timeout. One thread keeps the tasks in a hierarchical
+/// timer wheel, so scheduling and cancelling cost the same however many tasks
+/// are pending, and hands the due tasks to a thread pool to run.
+class Scheduler : public Singleton<Scheduler> {
  public:
-  Scheduler();
+  /// Names a scheduled task. 0 never names one, so can mark "none".
+  typedef uint64_t TaskHandle;
+
+  /// Resolution of the wheel; tasks never run early, at most this late
+  static constexpr unsigned int TICK_MS = 10;
+
+  explicit Scheduler(const unsigned int numThreads = SCHEDULER_NUM_THREADS);
   ~Scheduler();
 
-  void ScheduleAt(std::function<void(void)> f,
-                  std::chrono::time_point<std::chrono::system_clock> t =
-                      std::chrono::system_clock::now());
+  TaskHandle ScheduleAt(std::function<void(void)> f,
+                        std::chrono::time_point<std::chrono::system_clock> t =
+                            std::chrono::system_clock::now());
+
+  TaskHandle ScheduleAfter(std::function<void(void)> f,
+                           int64_t deltaMilliSeconds);
 
-  void ScheduleAfter(std::function<void(void)> f, int64_t deltaMilliSeconds);
+  /// Runs f every deltaMilliSeconds, counted from when it was due rather than
+  /// from when it finished, so that the period does not drift
+  TaskHandle SchedulePeriodically(std::function<void(void)> f,
+                                  int64_t deltaMilliSeconds);
 
-  void SchedulePeriodically(std::function<void(void)> f,
-                            int64_t deltaMilliSeconds);
+  /// Returns false if the task has already run or was cancelled. A periodic
+  /// task can be cancelled while it runs, including from itself, and is then
+  /// not run again.
+  bool Cancel(TaskHandle handle);
 
-  void ServiceQueue();
+  /// Number of tasks waiting to be due
+  size_t GetNumTasks() const;
 
  private:
-  std::multimap<std::chrono::time_point<std::chrono::system_clock>,
-                std::function<void(void)>>
-      taskQueue;
-  std::condition_variable newTaskScheduled;
-  mutable std::mutex newTaskMutex;
+  static constexpr unsigned int WHEEL_BITS = 6;
+  static constexpr unsigned int WHEEL_SIZE = 1 << WHEEL_BITS;
+  static constexpr unsigned int NUM_WHEELS = 4;
+
+  struct Task {
+    TaskHandle m_handle;
+    /// Tick at which the task is due
+    uint64_t m_expiry;
+    /// 0 if the task runs once
+    uint64_t m_periodTicks;
+    std::function<void(void)> m_func;
+  };
+
+  typedef std::list<Task> Slot;
+
+  /// Where a pending task lies; moving tasks between slots by splicing keeps
+  /// the iterator valid
+  struct Location {
+    Slot* m_slot;
+    Slot::iterator m_it;
+  };
+
+  uint64_t NowTicks() const;
+  TaskHandle Schedule(std::function<void(void)>&& f, uint64_t delayTicks,
+                      uint64_t periodTicks);
+  /// Puts a task from 'from' into the slot for its expiry. Caller holds
+  /// m_mutex.
+  void Place(Slot& from, Slot::iterator it);
+  /// Advances the wheel by one tick, moving the tasks that are due into due
+  void Tick(Slot& due);
+  void Dispatch(Task&& task);
+  void Run();
+
+  std::array<std::array<Slot, WHEEL_SIZE>, NUM_WHEELS> m_wheels;
+  std::unordered_map<TaskHandle, Location> m_tasks;
+  /// Periodic tasks being run, so that cancelling one stops it being placed
+  /// again
+  std::unordered_set<TaskHandle> m_running;
+  TaskHandle m_nextHandle = 1;
+  /// The last tick the wheel was advanced to
+  uint64_t m_currentTick = 0;
+  const std::chrono::steady_clock::time_point m_start;
+
+  bool m_stop = false;
+  mutable std::mutex m_mutex;
+  std::condition_variable m_cv;
+  std::thread m_thread;
+
+  /// Last, so that it is destroyed first and running tasks finish while the
+  /// members they use still exist
+  ThreadPool m_pool;
 };
 
 #endif  // __SCHEDULER_H__
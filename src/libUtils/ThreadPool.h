@@ -18,89 +18,120 @@
 #ifndef CONCURRENT_THREADPOOL_H
 #define CONCURRENT_THREADPOOL_H
 
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <functional>
+#include <future>
+#include <memory>
 #include <mutex>
+#include <string>
 #include <thread>
-
-/**
- *  Set to 1 to use vector instead of queue for jobs container to improve
- *  memory locality however changes job order from FIFO to LIFO.
- */
-#define CONTIGUOUS_JOBS_MEMORY 0
-#if CONTIGUOUS_JOBS_MEMORY
+#include <utility>
 #include <vector>
-#else
-#include <queue>
-#endif
+
+#include "libUtils/ThreadRoles.h"
 
 /**
- * Simple thread pool that creates `threadCount` threads upon its creation, and
- * pulls from a queue to get new jobs. This class requires a number of C++11
- * features be present in your compiler.
+ * Thread pool that creates `threadCount` threads upon its creation. Jobs added
+ * from outside the pool go to a shared queue, in FIFO order. Jobs added by a
+ * job go to the deque of the worker running it, which takes its newest job
+ * first. Idle workers take from the shared queue and then steal the oldest
+ * jobs of the other workers. High priority jobs go ahead of all others.
  */
 class ThreadPool {
  public:
   typedef std::function<void()> Job;
 
+  enum class Priority { NORMAL, HIGH };
+
+  /// Counters of the pool, for monitoring
+  struct Stats {
+    /// Jobs waiting for a worker
+    int64_t queued;
+    /// Jobs being run
+    int64_t running;
+    uint64_t completed;
+    /// Jobs taken from the deque of another worker
+    uint64_t stolen;
+    /// Mean time the completed jobs waited for a worker, and took to run
+    double meanWaitMicros;
+    double meanRunMicros;
+  };
+
   /// Constructor.
-#if CONTIGUOUS_JOBS_MEMORY
-  explicit ThreadPool(const unsigned int threadCount,
-                      const std::string& poolName,
-                      const unsigned int jobsReserveCount = 0)
-#else
   explicit ThreadPool(const unsigned int threadCount,
                       const std::string& poolName)
-#endif
-      : _jobsLeft(0),
+      : _workers(threadCount),
+        _queued(0),
+        _running(0),
+        _completed(0),
+        _stolen(0),
+        _waitMicros(0),
+        _runMicros(0),
         _bailout(false),
-        _poolName(poolName),
-        _jobAvailableVar(),
-        _jobsLeftMutex(),
-        _queueMutex() {
+        _poolName(poolName) {
     _threads.reserve(threadCount);
     for (unsigned int index = 0; index < threadCount; ++index) {
-      _threads.push_back(std::thread([this] { this->Task(); }));
+      _threads.push_back(std::thread([this, index] { this->Task(index); }));
     }
-
-#if CONTIGUOUS_JOBS_MEMORY
-    if (jobsReserveCount > 0) {
-      _queue.reserve(jobsReserveCount);
-    }
-#endif
   }
 
   /// Destructor (JoinAll on deconstruction).
   ~ThreadPool() { JoinAll(); }
 
-  /// Adds a new job to the pool. If there are no jobs in the queue, a thread is
-  /// woken up to take the job. If all threads are busy, the job is added to the
-  /// end of the queue.
-  void AddJob(const Job& job) {
-    std::lock(_queueMutex, _jobsLeftMutex);
-    std::lock_guard<std::mutex> lg1(_queueMutex, std::adopt_lock);
-    std::lock_guard<std::mutex> lg2(_jobsLeftMutex, std::adopt_lock);
-
-#if CONTIGUOUS_JOBS_MEMORY
-    _queue.push_back(job);
-#else
-    _queue.push(job);
-#endif
-    ++_jobsLeft;
+  /// Adds a new job to the pool, and wakes up a thread to take it if one is
+  /// idle.
+  void AddJob(const Job& job, const Priority priority = Priority::NORMAL) {
+    QueuedJob queuedJob{job, std::chrono::steady_clock::now()};
+    const auto& current = CurrentWorker();
+
+    if (priority == Priority::HIGH) {
+      std::lock_guard<std::mutex> lock(_queueMutex);
+      _highQueue.push_back(std::move(queuedJob));
+    } else if (current.first == this) {
+      Worker& worker = _workers[current.second];
+      std::lock_guard<std::mutex> lock(worker.mutex);
+      worker.jobs.push_back(std::move(queuedJob));
+    } else {
+      std::lock_guard<std::mutex> lock(_queueMutex);
+      _queue.push_back(std::move(queuedJob));
+    }
+
+    const int64_t queued = ++_queued;
+
+    // Pairs with the check of _queued by the idle threads before they wait
+    { std::lock_guard<std::mutex> lock(_jobAvailableMutex); }
     _jobAvailableVar.notify_one();
 
-    if (0 == _jobsLeft % 100) {
-      LOG_GENERAL(INFO, "PoolName: " << _poolName << " JobLeft: " << _jobsLeft);
+    if (0 == queued % 100) {
+      LOG_GENERAL(INFO, "PoolName: " << _poolName << " JobLeft: " << queued);
     }
   }
 
+  /// Adds a new job to the pool, whose result or exception is delivered
+  /// through the returned future.
+  template <class Callable>
+  auto Submit(Callable&& callable, const Priority priority = Priority::NORMAL)
+      -> std::future<decltype(callable())> {
+    using Result = decltype(callable());
+
+    auto task = std::make_shared<std::packaged_task<Result()>>(
+        std::forward<Callable>(callable));
+    std::future<Result> result = task->get_future();
+    AddJob([task]() { (*task)(); }, priority);
+
+    return result;
+  }
+
   /// Joins with all threads. Blocks until all threads have completed. The queue
   /// may be filled after this call, but the threads will be done. After
   /// invoking JoinAll, the pool can no longer be used.
   void JoinAll() {
     // scoped lock
     {
-      std::lock_guard<std::mutex> lock(_queueMutex);
+      std::lock_guard<std::mutex> lock(_jobAvailableMutex);
       if (_bailout) {
         return;
       }
@@ -124,69 +155,138 @@ class ThreadPool {
     }
   }
 
+  Stats GetStats() const {
+    const uint64_t completed = _completed;
+    return {_queued,
+            _running,
+            completed,
+            _stolen,
+            completed > 0 ? static_cast<double>(_waitMicros) / completed : 0,
+            completed > 0 ? static_cast<double>(_runMicros) / completed : 0};
+  }
+
+  const std::string& GetName() const { return _poolName; }
+
   /// Gets the vector of threads themselves, in order to set the affinity, or
   /// anything else you might want to do
   std::vector<std::thread>& GetThreads() { return _threads; }
 
  private:
-  /**
-   *  Take the next job in the queue and run it.
-   *  Notify the main thread that a job has completed.
-   */
-  void Task() {
-    while (true) {
-      Job job;
+  struct QueuedJob {
+    Job job;
+    std::chrono::steady_clock::time_point queuedAt;
+  };
 
-      // scoped lock
-      {
-        std::unique_lock<std::mutex> lock(_queueMutex);
+  /// Jobs added by the jobs of one worker. The worker takes from the back,
+  /// the others steal from the front, so the lock is rarely contended.
+  struct Worker {
+    std::mutex mutex;
+    std::deque<QueuedJob> jobs;
+  };
 
-        if (_bailout) {
-          return;
-        }
+  /// The pool and worker index of the calling thread, if it is a worker
+  static std::pair<const ThreadPool*, unsigned int>& CurrentWorker() {
+    static thread_local std::pair<const ThreadPool*, unsigned int> current{
+        nullptr, 0};
+    return current;
+  }
 
-        // Wait for a job if we don't have any.
-        _jobAvailableVar.wait(lock,
-                              [this] { return !_queue.empty() || _bailout; });
+  bool TakeJob(const unsigned int index, QueuedJob& job) {
+    {
+      std::lock_guard<std::mutex> lock(_queueMutex);
+      if (!_highQueue.empty()) {
+        job = std::move(_highQueue.front());
+        _highQueue.pop_front();
+        return true;
+      }
+    }
 
-        if (_bailout) {
-          return;
-        }
+    {
+      Worker& worker = _workers[index];
+      std::lock_guard<std::mutex> lock(worker.mutex);
+      if (!worker.jobs.empty()) {
+        job = std::move(worker.jobs.back());
+        worker.jobs.pop_back();
+        return true;
+      }
+    }
+
+    {
+      std::lock_guard<std::mutex> lock(_queueMutex);
+      if (!_queue.empty()) {
+        job = std::move(_queue.front());
+        _queue.pop_front();
+        return true;
+      }
+    }
 
-        // Get job from the queue
-#if CONTIGUOUS_JOBS_MEMORY
-        job = _queue.back();
-        _queue.pop_back();
-#else
-        job = _queue.front();
-        _queue.pop();
-#endif
+    for (unsigned int i = 1; i < _workers.size(); ++i) {
+      Worker& victim = _workers[(index + i) % _workers.size()];
+      std::lock_guard<std::mutex> lock(victim.mutex);
+      if (!victim.jobs.empty()) {
+        job = std::move(victim.jobs.front());
+        victim.jobs.pop_front();
+        ++_stolen;
+        return true;
       }
+    }
+
+    return false;
+  }
+
+  /**
+   *  Take the next job and run it, or wait for one if there is none.
+   */
+  void Task(const unsigned int index) {
+    CurrentWorker() = {this, index};
+    ThreadRoles::GetInstance().ApplyToCurrentThread(_poolName);
 
-      job();
+    while (!_bailout) {
+      QueuedJob job;
 
-      // scoped lock
-      {
-        std::lock_guard<std::mutex> lock(_jobsLeftMutex);
-        --_jobsLeft;
+      if (!TakeJob(index, job)) {
+        std::unique_lock<std::mutex> lock(_jobAvailableMutex);
+        _jobAvailableVar.wait(lock,
+                              [this] { return _queued > 0 || _bailout; });
+        continue;
       }
+
+      --_queued;
+      ++_running;
+
+      const auto startedAt = std::chrono::steady_clock::now();
+      job.job();
+      const auto finishedAt = std::chrono::steady_clock::now();
+
+      --_running;
+      ++_completed;
+      _waitMicros += std::chrono::duration_cast<std::chrono::microseconds>(
+                         startedAt - job.queuedAt)
+                         .count();
+      _runMicros += std::chrono::duration_cast<std::chrono::microseconds>(
+                        finishedAt - startedAt)
+                        .count();
     }
   }
 
   std::vector<std::thread> _threads;
-#if CONTIGUOUS_JOBS_MEMORY
-  std::vector<Job> _queue;
-#else
-  std::queue<Job> _queue;
-#endif
-
-  int _jobsLeft;
-  bool _bailout;
+  std::vector<Worker> _workers;
+  std::deque<QueuedJob> _highQueue;
+  std::deque<QueuedJob> _queue;
+
+  /// Added to after a job is queued, so can briefly be negative
+  std::atomic<int64_t> _queued;
+  std::atomic<int64_t> _running;
+  std::atomic<uint64_t> _completed;
+  std::atomic<uint64_t> _stolen;
+  std::atomic<uint64_t> _waitMicros;
+  std::atomic<uint64_t> _runMicros;
+
+  std::atomic<bool> _bailout;
   std::string _poolName;
   std::condition_variable _jobAvailableVar;
-  std::mutex _jobsLeftMutex;
+  std::mutex _jobAvailableMutex;
   std::mutex _queueMutex;
 };
 
-#undef CONTIGUOUS_JOBS_MEMORY
 #endif  // CONCURRENT_THREADPOOL_H
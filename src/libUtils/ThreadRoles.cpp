@@ -0,0 +1,172 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "ThreadRoles.h"
+
+#include <pthread.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <boost/algorithm/string.hpp>
+#include <boost/property_tree/xml_parser.hpp>
+
+#include "libUtils/Logger.h"
+
+using namespace std;
+
+namespace {
+
+/// Longest thread name Linux keeps, leaving out the terminating null
+const size_t MAX_THREAD_NAME_LEN = 15;
+
+#if defined(__linux__)
+const unsigned long MAX_CPUS = CPU_SETSIZE;
+#else
+const unsigned long MAX_CPUS = 1024;
+#endif
+
+bool ParseCpu(const string& value, unsigned int& cpu) {
+  try {
+    size_t end = 0;
+    const unsigned long parsed = stoul(value, &end);
+    if (end != value.size() || parsed >= MAX_CPUS) {
+      return false;
+    }
+    cpu = parsed;
+    return true;
+  } catch (const exception&) {
+    return false;
+  }
+}
+
+}  // namespace
+
+ThreadRoles::ThreadRoles() {
+  boost::property_tree::ptree pt;
+  try {
+    boost::property_tree::read_xml("constants.xml", pt);
+  } catch (const exception& e) {
+    LOG_GENERAL(WARNING, "Cannot read thread roles: " << e.what());
+    return;
+  }
+
+  const auto section = pt.get_child_optional("node.thread_roles");
+  if (section) {
+    Load(*section);
+  }
+}
+
+bool ThreadRoles::Load(const boost::property_tree::ptree& section) {
+  map<string, Role> roles;
+
+  for (const auto& child : section) {
+    if (child.first != "role") {
+      continue;
+    }
+
+    const auto name = child.second.get_optional<string>("name");
+    if (!name || name->empty()) {
+      LOG_GENERAL(WARNING, "Thread role without a name");
+      return false;
+    }
+
+    Role role;
+    const auto cpus = child.second.get_optional<string>("cpus");
+    if (cpus && !ParseCpuList(*cpus, role.m_cpus)) {
+      LOG_GENERAL(WARNING,
+                  "Bad CPU list " << *cpus << " of thread role " << *name);
+      return false;
+    }
+
+    const auto nice = child.second.get_optional<int>("nice");
+    if (nice) {
+      role.m_setNice = true;
+      role.m_nice = *nice;
+    }
+
+    roles[*name] = role;
+  }
+
+  m_roles.swap(roles);
+  return true;
+}
+
+void ThreadRoles::ApplyToCurrentThread(const string& role) const {
+#if defined(__linux__)
+  pthread_setname_np(pthread_self(),
+                     role.substr(0, MAX_THREAD_NAME_LEN).c_str());
+
+  const auto it = m_roles.find(role);
+  if (it == m_roles.end()) {
+    return;
+  }
+
+  if (!it->second.m_cpus.empty()) {
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (const auto cpu : it->second.m_cpus) {
+      CPU_SET(cpu, &cpuSet);
+    }
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) !=
+        0) {
+      LOG_GENERAL(WARNING, "Failed to set the CPUs of a " << role << " thread");
+    }
+  }
+
+  // On Linux the nice value of a thread id is that thread's alone
+  if (it->second.m_setNice &&
+      setpriority(PRIO_PROCESS, syscall(SYS_gettid), it->second.m_nice) != 0) {
+    LOG_GENERAL(WARNING, "Failed to set the nice value of a " << role
+                                                              << " thread");
+  }
+#else
+  (void)role;
+#endif
+}
+
+bool ThreadRoles::ParseCpuList(const string& list, vector<unsigned int>& cpus) {
+  vector<string> parts;
+  boost::algorithm::split(parts, list, boost::algorithm::is_any_of(","));
+
+  vector<unsigned int> result;
+  for (auto& part : parts) {
+    boost::algorithm::trim(part);
+    if (part.empty()) {
+      continue;
+    }
+
+    const auto dash = part.find('-');
+    unsigned int first = 0;
+    unsigned int last = 0;
+    if (dash == string::npos) {
+      if (!ParseCpu(part, first)) {
+        return false;
+      }
+      last = first;
+    } else if (!ParseCpu(part.substr(0, dash), first) ||
+               !ParseCpu(part.substr(dash + 1), last) || last < first) {
+      return false;
+    }
+
+    for (unsigned int cpu = first; cpu <= last; cpu++) {
+      result.push_back(cpu);
+    }
+  }
+
+  cpus.swap(result);
+  return true;
+}
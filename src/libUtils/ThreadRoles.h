@@ -0,0 +1,60 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __THREADROLES_H__
+#define __THREADROLES_H__
+
+#include <boost/property_tree/ptree.hpp>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "common/Singleton.h"
+
+/// CPU sets and nice values for the named roles of threads, from the
+/// thread_roles section of constants.xml, so that e.g. mining or RPC can be
+/// kept off the cores of the consensus path. Threads of a role that is not
+/// configured float freely. Thread pools take the role of their name.
+class ThreadRoles : public Singleton<ThreadRoles> {
+ public:
+  struct Role {
+    /// Empty to leave the affinity alone
+    std::vector<unsigned int> m_cpus;
+    bool m_setNice = false;
+    int m_nice = 0;
+  };
+
+  /// Reads the roles from constants.xml
+  ThreadRoles();
+
+  /// Replaces the roles with those of the role children of section. Returns
+  /// false, keeping none of them, if one is malformed.
+  bool Load(const boost::property_tree::ptree& section);
+
+  /// Names the calling thread after role, and applies the CPU set and nice
+  /// value of the role if it is configured
+  void ApplyToCurrentThread(const std::string& role) const;
+
+  /// Parses a list of CPUs and CPU ranges such as "0-3,8"
+  static bool ParseCpuList(const std::string& list,
+                           std::vector<unsigned int>& cpus);
+
+ private:
+  std::map<std::string, Role> m_roles;
+};
+
+#endif  // __THREADROLES_H__
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "Tracing.h"
+
+#include <unistd.h>
+#include <algorithm>
+#include <sstream>
+
+#include "common/Constants.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+
+Tracing::Tracing() : m_start(chrono::steady_clock::now()) {}
+
+bool Tracing::IsEnabled() { return ENABLE_EPOCH_TRACING; }
+
+uint64_t Tracing::NowUs() const {
+  return chrono::duration_cast<chrono::microseconds>(
+             chrono::steady_clock::now() - m_start)
+      .count();
+}
+
+Tracing::ThreadBuffer& Tracing::GetThreadBuffer() {
+  static thread_local shared_ptr<ThreadBuffer> buffer;
+
+  if (!buffer) {
+    buffer = make_shared<ThreadBuffer>();
+    buffer->m_tid = Logger::GetPid();
+    buffer->m_spans.reserve(EPOCH_TRACE_BUFFER_SIZE);
+
+    lock_guard<mutex> g(m_mutexBuffers);
+    m_buffers.emplace_back(buffer);
+  }
+
+  return *buffer;
+}
+
+void Tracing::Record(const Span& span) {
+  if (EPOCH_TRACE_BUFFER_SIZE == 0) {
+    return;
+  }
+
+  ThreadBuffer& buffer = GetThreadBuffer();
+  lock_guard<mutex> g(buffer.m_mutex);
+
+  if (buffer.m_spans.size() < EPOCH_TRACE_BUFFER_SIZE) {
+    buffer.m_spans.emplace_back(span);
+  } else {
+    buffer.m_spans[buffer.m_next] = span;
+    buffer.m_next = (buffer.m_next + 1) % EPOCH_TRACE_BUFFER_SIZE;
+  }
+}
+
+string Tracing::GetChromeTrace() {
+  vector<shared_ptr<ThreadBuffer>> buffers;
+  {
+    lock_guard<mutex> g(m_mutexBuffers);
+    buffers = m_buffers;
+  }
+
+  const pid_t pid = getpid();
+  ostringstream oss;
+  oss << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+  bool first = true;
+  for (const auto& buffer : buffers) {
+    vector<Span> spans;
+    size_t next = 0;
+    {
+      lock_guard<mutex> g(buffer->m_mutex);
+      spans = buffer->m_spans;
+      next = buffer->m_next;
+    }
+
+    // Oldest first, although the viewers do not mind the order
+    rotate(spans.begin(), spans.begin() + next, spans.end());
+
+    for (const auto& span : spans) {
+      oss << (first ? "" : ",") << "{\"name\":\"" << span.m_name
+          << "\",\"cat\":\"epoch\",\"ph\":\"X\",\"ts\":" << span.m_startUs
+          << ",\"dur\":" << span.m_durationUs << ",\"pid\":" << pid
+          << ",\"tid\":" << buffer->m_tid
+          << ",\"args\":{\"epoch\":" << span.m_epochNum << "}}";
+      first = false;
+    }
+  }
+
+  oss << "]}";
+  return oss.str();
+}
+
+void Tracing::Clear() {
+  lock_guard<mutex> g(m_mutexBuffers);
+  for (const auto& buffer : m_buffers) {
+    lock_guard<mutex> gb(buffer->m_mutex);
+    buffer->m_spans.clear();
+    buffer->m_next = 0;
+  }
+}
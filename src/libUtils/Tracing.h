@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TRACING_H__
+#define __TRACING_H__
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common/Singleton.h"
+
+/// Records timed spans of the epoch phases into a ring buffer per thread, so
+/// that the threads never contend when recording, and exports them on demand
+/// in the Chrome trace event format, which chrome://tracing and Perfetto
+/// open. Does nothing unless ENABLE_EPOCH_TRACING is set.
+class Tracing : public Singleton<Tracing> {
+ public:
+  struct Span {
+    /// A string literal, as spans outlive the scope that names them
+    const char* m_name;
+    uint64_t m_epochNum;
+    /// Microseconds since the tracing started
+    uint64_t m_startUs;
+    uint64_t m_durationUs;
+  };
+
+ private:
+  struct ThreadBuffer {
+    pid_t m_tid;
+    /// Only contended while the spans are exported
+    std::mutex m_mutex;
+    std::vector<Span> m_spans;
+    /// Where the next span goes once the buffer is full
+    size_t m_next = 0;
+  };
+
+  const std::chrono::steady_clock::time_point m_start;
+  std::mutex m_mutexBuffers;
+  /// Kept after their thread exits, so its spans can still be exported
+  std::vector<std::shared_ptr<ThreadBuffer>> m_buffers;
+
+  ThreadBuffer& GetThreadBuffer();
+
+ public:
+  Tracing();
+
+  static bool IsEnabled();
+
+  /// Microseconds since the tracing started
+  uint64_t NowUs() const;
+
+  void Record(const Span& span);
+
+  /// All the spans still buffered, as a Chrome trace JSON object
+  std::string GetChromeTrace();
+
+  /// Drops all the spans recorded so far
+  void Clear();
+};
+
+/// Records a span from its construction to its destruction
+class TraceSpan {
+  const char* m_name;
+  uint64_t m_epochNum;
+  uint64_t m_startUs;
+  bool m_enabled;
+
+ public:
+  TraceSpan(const char* name, uint64_t epochNum)
+      : m_name(name),
+        m_epochNum(epochNum),
+        m_startUs(0),
+        m_enabled(Tracing::IsEnabled()) {
+    if (m_enabled) {
+      m_startUs = Tracing::GetInstance().NowUs();
+    }
+  }
+
+  ~TraceSpan() {
+    if (m_enabled) {
+      Tracing& tracing = Tracing::GetInstance();
+      tracing.Record(
+          {m_name, m_epochNum, m_startUs, tracing.NowUs() - m_startUs});
+    }
+  }
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+#define TRACE_SPAN_CONCAT(a, b) a##b
+#define TRACE_SPAN_NAME(line) TRACE_SPAN_CONCAT(traceSpan, line)
+/// Traces the rest of the enclosing scope as phase name of epoch epochNum
+#define TRACE_SPAN(name, epochNum) \
+  TraceSpan TRACE_SPAN_NAME(__LINE__)(name, epochNum)
+
+#endif  // __TRACING_H__
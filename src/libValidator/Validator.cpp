@@ -15,6 +15,9 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <deque>
+#include <future>
+#include <thread>
 #include <vector>
 
 #include "Validator.h"
@@ -22,6 +25,7 @@
 #include "libMediator/Mediator.h"
 #include "libMessage/Messenger.h"
 #include "libUtils/BitVector.h"
+#include "libUtils/ThreadPool.h"
 
 using namespace std;
 using namespace boost::multiprecision;
@@ -40,18 +44,26 @@ bool Validator::VerifyTransaction(const Transaction& tran) const {
                                        tran.GetSenderPubKey());
 }
 
-bool Validator::CheckCreatedTransaction(const Transaction& tx,
-                                        TransactionReceipt& receipt) const {
-  if (LOOKUP_NODE_MODE) {
-    LOG_GENERAL(WARNING,
-                "Validator::CheckCreatedTransaction not expected to be "
-                "called from LookUp node.");
-    return true;
+bool Validator::VerifyTransactions(const vector<Transaction>& txns,
+                                   vector<bool>& valid) const {
+  vector<bytes> txnData(txns.size());
+  vector<Signature> signatures;
+  vector<PubKey> pubKeys;
+  signatures.reserve(txns.size());
+  pubKeys.reserve(txns.size());
+
+  for (unsigned int i = 0; i < txns.size(); i++) {
+    txns[i].SerializeCoreFields(txnData[i], 0);
+    signatures.emplace_back(txns[i].GetSignature());
+    pubKeys.emplace_back(txns[i].GetSenderPubKey());
   }
-  // LOG_MARKER();
 
-  // LOG_GENERAL(INFO, "Tran: " << tx.GetTranID());
+  return Schnorr::GetInstance().VerifyBatch(txnData, signatures, pubKeys,
+                                            valid,
+                                            TXN_VERIFICATION_NUM_THREADS);
+}
 
+bool Validator::CheckCreatedTransactionSender(const Transaction& tx) const {
   if (DataConversion::UnpackA(tx.GetVersion()) != CHAIN_ID) {
     LOG_GENERAL(WARNING, "CHAIN_ID incorrect");
     return false;
@@ -84,6 +96,26 @@ bool Validator::CheckCreatedTransaction(const Transaction& tx,
     return false;
   }
 
+  return true;
+}
+
+bool Validator::CheckCreatedTransaction(const Transaction& tx,
+                                        TransactionReceipt& receipt,
+                                        bool preChecked) const {
+  if (LOOKUP_NODE_MODE) {
+    LOG_GENERAL(WARNING,
+                "Validator::CheckCreatedTransaction not expected to be "
+                "called from LookUp node.");
+    return true;
+  }
+  // LOG_MARKER();
+
+  // LOG_GENERAL(INFO, "Tran: " << tx.GetTranID());
+
+  if (!preChecked && !CheckCreatedTransactionSender(tx)) {
+    return false;
+  }
+
   receipt.SetEpochNum(m_mediator.m_currentEpochNum);
 
   return AccountStore::GetInstance().UpdateAccountsTemp(
@@ -91,7 +123,54 @@ bool Validator::CheckCreatedTransaction(const Transaction& tx,
       m_mediator.m_ds->m_mode != DirectoryService::Mode::IDLE, tx, receipt);
 }
 
-bool Validator::CheckCreatedTransactionFromLookup(const Transaction& tx) {
+void Validator::CheckCreatedTransactions(const vector<Transaction>& txns,
+                                         vector<TransactionReceipt>& receipts,
+                                         vector<bool>& results,
+                                         const vector<bool>& preChecked) const {
+  receipts.assign(txns.size(), TransactionReceipt());
+  results.assign(txns.size(), false);
+
+  if (LOOKUP_NODE_MODE) {
+    LOG_GENERAL(WARNING,
+                "Validator::CheckCreatedTransactions not expected to be "
+                "called from LookUp node.");
+    results.assign(txns.size(), true);
+    return;
+  }
+
+  // The sender checks only read the permanent states, so txns failing them
+  // can be left out of the batch without changing the outcome of the others
+  vector<Transaction> batch;
+  vector<unsigned int> batchIndexes;
+  batch.reserve(txns.size());
+  batchIndexes.reserve(txns.size());
+  for (unsigned int i = 0; i < txns.size(); i++) {
+    if ((!preChecked.empty() && preChecked[i]) ||
+        CheckCreatedTransactionSender(txns[i])) {
+      batch.emplace_back(txns[i]);
+      batchIndexes.emplace_back(i);
+    }
+  }
+
+  vector<TransactionReceipt> batchReceipts(batch.size());
+  for (auto& receipt : batchReceipts) {
+    receipt.SetEpochNum(m_mediator.m_currentEpochNum);
+  }
+
+  vector<bool> batchResults;
+  AccountStore::GetInstance().UpdateAccountsTempBatch(
+      m_mediator.m_currentEpochNum, m_mediator.m_node->getNumShards(),
+      m_mediator.m_ds->m_mode != DirectoryService::Mode::IDLE, batch,
+      batchReceipts, batchResults, TXN_PROCESSING_NUM_THREADS);
+
+  for (unsigned int i = 0; i < batchIndexes.size(); i++) {
+    receipts[batchIndexes[i]] = batchReceipts[i];
+    results[batchIndexes[i]] = batchResults[i];
+  }
+}
+
+bool Validator::CheckCreatedTransactionFromLookup(const Transaction& tx,
+                                                  bool verifySignature) {
   if (LOOKUP_NODE_MODE) {
     LOG_GENERAL(WARNING,
                 "Validator::CheckCreatedTransactionFromLookup not expected "
@@ -164,7 +243,7 @@ bool Validator::CheckCreatedTransactionFromLookup(const Transaction& tx) {
     return false;
   }
 
-  if (!VerifyTransaction(tx)) {
+  if (verifySignature && !VerifyTransaction(tx)) {
     LOG_EPOCH(WARNING, m_mediator.m_currentEpochNum,
               "Signature incorrect: " << fromAddr << ". Transaction rejected: "
                                       << tx.GetTranID());
@@ -200,7 +279,7 @@ bool Validator::CheckBlockCosignature(const DirectoryBlock& block,
   unsigned int index = 0;
   unsigned int count = 0;
 
-  const vector<bool>& B2 = block.GetB2();
+  const BitVector& B2 = block.GetB2();
   if (commKeys.size() != B2.size()) {
     LOG_GENERAL(WARNING, "Mismatch: committee size = "
                              << commKeys.size()
@@ -210,9 +289,10 @@ bool Validator::CheckBlockCosignature(const DirectoryBlock& block,
 
   // Generate the aggregated key
   vector<PubKey> keys;
+  keys.reserve(commKeys.size());
   for (auto const& kv : commKeys) {
+    keys.emplace_back(get<PubKey>(kv));
     if (B2.at(index)) {
-      keys.emplace_back(get<PubKey>(kv));
       count++;
     }
     index++;
@@ -223,7 +303,7 @@ bool Validator::CheckBlockCosignature(const DirectoryBlock& block,
     return false;
   }
 
-  shared_ptr<PubKey> aggregatedKey = MultiSig::AggregatePubKeys(keys);
+  shared_ptr<PubKey> aggregatedKey = MultiSig::AggregatePubKeys(keys, B2);
   if (aggregatedKey == nullptr) {
     LOG_GENERAL(WARNING, "Aggregated key generation failed");
     return false;
@@ -231,7 +311,7 @@ bool Validator::CheckBlockCosignature(const DirectoryBlock& block,
 
   // Verify the collective signature
   bytes serializedHeader;
-  block.GetHeader().Serialize(serializedHeader, 0);
+  block.GetHeader().SerializeCached(serializedHeader, 0);
   block.GetCS1().Serialize(serializedHeader, serializedHeader.size());
   BitVector::SetBitVector(serializedHeader, serializedHeader.size(),
                           block.GetB1());
@@ -239,8 +319,10 @@ bool Validator::CheckBlockCosignature(const DirectoryBlock& block,
                                               serializedHeader.size(),
                                               block.GetCS2(), *aggregatedKey)) {
     LOG_GENERAL(WARNING, "Cosig verification failed");
-    for (auto& kv : keys) {
-      LOG_GENERAL(WARNING, kv);
+    for (unsigned int i = 0; i < keys.size(); i++) {
+      if (B2.at(i)) {
+        LOG_GENERAL(WARNING, keys.at(i));
+      }
     }
     return false;
   }
@@ -253,6 +335,23 @@ bool Validator::CheckDirBlocks(
                                 FallbackBlockWShardingStructure>>& dirBlocks,
     const DequeOfNode& initDsComm, const uint64_t& index_num,
     DequeOfNode& newDSComm) {
+  // The committees are cheap to follow ahead of the loop below, so that the
+  // cosignatures of a long sync are verified side by side
+  const unsigned int numThreads =
+      SYNC_COSIG_VERIF_THREADS > 0
+          ? SYNC_COSIG_VERIF_THREADS
+          : max(thread::hardware_concurrency(), (unsigned int)1);
+  const bool preVerified = numThreads > 1 && dirBlocks.size() > 1;
+  vector<bool> cosigValid;
+  if (preVerified) {
+    VerifyDirBlockCosignatures(dirBlocks, initDsComm, numThreads, cosigValid);
+  }
+  auto checkCosignature = [&](size_t i, const auto& block,
+                              const auto& commKeys) {
+    return preVerified ? cosigValid[i]
+                       : CheckBlockCosignature(block, commKeys);
+  };
+
   DequeOfNode mutable_ds_comm = initDsComm;
 
   bool ret = true;
@@ -265,7 +364,8 @@ bool Validator::CheckDirBlocks(
   BlockHash prevHash = get<BlockLinkIndex::BLOCKHASH>(
       m_mediator.m_blocklinkchain.GetLatestBlockLink());
 
-  for (const auto& dirBlock : dirBlocks) {
+  for (size_t i = 0; i < dirBlocks.size(); i++) {
+    const auto& dirBlock = dirBlocks[i];
     if (typeid(DSBlock) == dirBlock.type()) {
       const auto& dsblock = get<DSBlock>(dirBlock);
       if (dsblock.GetHeader().GetBlockNum() != prevdsblocknum + 1) {
@@ -276,7 +376,7 @@ bool Validator::CheckDirBlocks(
         break;
       }
 
-      if (!CheckBlockCosignature(dsblock, mutable_ds_comm)) {
+      if (!checkCosignature(i, dsblock, mutable_ds_comm)) {
         LOG_GENERAL(WARNING, "Co-sig verification of ds block "
                                  << prevdsblocknum + 1 << " failed");
         ret = false;
@@ -315,7 +415,7 @@ bool Validator::CheckDirBlocks(
         ret = false;
         break;
       }
-      if (!CheckBlockCosignature(vcblock, mutable_ds_comm)) {
+      if (!checkCosignature(i, vcblock, mutable_ds_comm)) {
         LOG_GENERAL(WARNING, "Co-sig verification of vc block in "
                                  << prevdsblocknum << " failed"
                                  << totalIndex + 1);
@@ -386,7 +486,8 @@ bool Validator::CheckDirBlocks(
 
       uint32_t shard_id = fallbackblock.GetHeader().GetShardId();
 
-      if (!CheckBlockCosignature(fallbackblock, shards.at(shard_id))) {
+      if (shard_id >= shards.size() ||
+          !checkCosignature(i, fallbackblock, shards.at(shard_id))) {
         LOG_GENERAL(WARNING, "Co-sig verification of fallbackblock in "
                                  << prevdsblocknum << " failed"
                                  << totalIndex + 1);
@@ -416,6 +517,260 @@ bool Validator::CheckDirBlocks(
   return ret;
 }
 
+void Validator::VerifyDirBlockCosignatures(
+    const vector<boost::variant<DSBlock, VCBlock,
+                                FallbackBlockWShardingStructure>>& dirBlocks,
+    const DequeOfNode& initDsComm, unsigned int numThreads,
+    vector<bool>& valid) {
+  LOG_MARKER();
+
+  valid.assign(dirBlocks.size(), false);
+
+  DequeOfNode mutable_ds_comm = initDsComm;
+
+  // Each check gets a copy of the committee at its block; a bounded number
+  // are pending at once so that the copies do not pile up
+  ThreadPool pool(numThreads, "VerifyDirBlockCosigs");
+  deque<pair<size_t, future<bool>>> pending;
+  const size_t maxPending = 4 * numThreads;
+  bool failed = false;
+
+  auto waitForOldest = [&]() {
+    auto& oldest = pending.front();
+    valid[oldest.first] = oldest.second.get();
+    failed = failed || !valid[oldest.first];
+    pending.pop_front();
+  };
+
+  for (size_t i = 0; i < dirBlocks.size() && !failed; i++) {
+    const auto& dirBlock = dirBlocks[i];
+    if (typeid(DSBlock) == dirBlock.type()) {
+      const auto& dsblock = get<DSBlock>(dirBlock);
+      pending.emplace_back(
+          i, pool.Submit([this, &dsblock, comm = mutable_ds_comm]() {
+            return CheckBlockCosignature(dsblock, comm);
+          }));
+      m_mediator.m_node->UpdateDSCommiteeComposition(mutable_ds_comm, dsblock);
+    } else if (typeid(VCBlock) == dirBlock.type()) {
+      const auto& vcblock = get<VCBlock>(dirBlock);
+      pending.emplace_back(
+          i, pool.Submit([this, &vcblock, comm = mutable_ds_comm]() {
+            return CheckBlockCosignature(vcblock, comm);
+          }));
+      m_mediator.m_node->UpdateRetrieveDSCommiteeCompositionAfterVC(
+          vcblock, mutable_ds_comm);
+    } else if (typeid(FallbackBlockWShardingStructure) == dirBlock.type()) {
+      const auto& fallbackwshardingstructure =
+          get<FallbackBlockWShardingStructure>(dirBlock);
+      const auto& fallbackblock = fallbackwshardingstructure.m_fallbackblock;
+      const DequeOfShard& shards = fallbackwshardingstructure.m_shards;
+
+      const uint32_t shard_id = fallbackblock.GetHeader().GetShardId();
+      if (shard_id >= shards.size()) {
+        break;
+      }
+
+      // The shards live in dirBlocks, which outlives the pool
+      pending.emplace_back(
+          i, pool.Submit([this, &fallbackblock, &shards, shard_id]() {
+            return CheckBlockCosignature(fallbackblock, shards.at(shard_id));
+          }));
+      m_mediator.m_node->UpdateDSCommitteeAfterFallback(
+          shard_id, fallbackblock.GetHeader().GetLeaderPubKey(),
+          fallbackblock.GetHeader().GetLeaderNetworkInfo(), mutable_ds_comm,
+          shards);
+    }
+
+    while (pending.size() > maxPending && !failed) {
+      waitForOldest();
+    }
+  }
+
+  while (!pending.empty()) {
+    waitForOldest();
+  }
+}
+
+bool Validator::VerifyDirBlocks(
+    const vector<boost::variant<DSBlock, VCBlock,
+                                FallbackBlockWShardingStructure>>& dirBlocks,
+    const DequeOfNode& initDsComm, unsigned int numThreads,
+    DequeOfNode& newDSComm, BlockLink& latestBlockLink) {
+  LOG_MARKER();
+
+  DequeOfNode mutable_ds_comm = initDsComm;
+
+  uint64_t prevdsblocknum =
+      m_mediator.m_dsBlockChain.GetLastBlock().GetHeader().GetBlockNum();
+  ShardingHash prevShardingHash =
+      m_mediator.m_dsBlockChain.GetLastBlock().GetHeader().GetShardingHash();
+  latestBlockLink = m_mediator.m_blocklinkchain.GetLatestBlockLink();
+  BlockHash prevHash = get<BlockLinkIndex::BLOCKHASH>(latestBlockLink);
+  uint64_t totalIndex = get<BlockLinkIndex::INDEX>(latestBlockLink) + 1;
+
+  // Each check gets a copy of the committee at its block; a bounded number
+  // are pending at once so that the copies do not pile up
+  ThreadPool pool(max(numThreads, 1u), "VerifyDirBlocks");
+  deque<pair<size_t, future<bool>>> pending;
+  const size_t maxPending = 4 * max(numThreads, 1u);
+  const size_t progressStep = max<size_t>(dirBlocks.size() / 20, 1);
+  size_t verified = 0;
+  bool ret = true;
+
+  auto waitForOldest = [&]() {
+    auto& oldest = pending.front();
+    if (!oldest.second.get()) {
+      LOG_GENERAL(WARNING,
+                  "Co-sig verification of dir block " << oldest.first
+                                                      << " failed");
+      ret = false;
+    }
+    pending.pop_front();
+    if (++verified % progressStep == 0) {
+      LOG_GENERAL(INFO, "Verified cosigs of " << verified << " / "
+                                              << dirBlocks.size()
+                                              << " dir blocks");
+    }
+  };
+
+  for (size_t i = 0; i < dirBlocks.size() && ret; i++) {
+    const auto& dirBlock = dirBlocks[i];
+    if (typeid(DSBlock) == dirBlock.type()) {
+      const auto& dsblock = get<DSBlock>(dirBlock);
+      if (dsblock.GetHeader().GetBlockNum() != prevdsblocknum + 1) {
+        LOG_GENERAL(WARNING, "DSblocks not in sequence "
+                                 << dsblock.GetHeader().GetBlockNum() << " "
+                                 << prevdsblocknum);
+        ret = false;
+        break;
+      }
+      if (prevHash != dsblock.GetHeader().GetPrevHash()) {
+        LOG_GENERAL(WARNING, "prevHash incorrect "
+                                 << prevHash << " "
+                                 << dsblock.GetHeader().GetPrevHash()
+                                 << "in DS block " << prevdsblocknum + 1);
+        ret = false;
+        break;
+      }
+
+      pending.emplace_back(
+          i, pool.Submit([this, &dsblock, comm = mutable_ds_comm]() {
+            return CheckBlockCosignature(dsblock, comm);
+          }));
+
+      prevdsblocknum++;
+      prevShardingHash = dsblock.GetHeader().GetShardingHash();
+      prevHash = dsblock.GetBlockHash();
+      latestBlockLink = make_tuple(BLOCKLINK_VERSION, totalIndex,
+                                   prevdsblocknum, BlockType::DS, prevHash);
+      m_mediator.m_node->UpdateDSCommiteeComposition(mutable_ds_comm, dsblock);
+    } else if (typeid(VCBlock) == dirBlock.type()) {
+      const auto& vcblock = get<VCBlock>(dirBlock);
+      if (vcblock.GetHeader().GetViewChangeDSEpochNo() != prevdsblocknum + 1) {
+        LOG_GENERAL(WARNING,
+                    "VC block ds epoch number does not match the number being "
+                    "processed "
+                        << prevdsblocknum << " "
+                        << vcblock.GetHeader().GetViewChangeDSEpochNo());
+        ret = false;
+        break;
+      }
+      if (prevHash != vcblock.GetHeader().GetPrevHash()) {
+        LOG_GENERAL(WARNING, "prevHash incorrect "
+                                 << prevHash << " "
+                                 << vcblock.GetHeader().GetPrevHash()
+                                 << "in VC block " << prevdsblocknum + 1);
+        ret = false;
+        break;
+      }
+
+      pending.emplace_back(
+          i, pool.Submit([this, &vcblock, comm = mutable_ds_comm]() {
+            return CheckBlockCosignature(vcblock, comm);
+          }));
+
+      m_mediator.m_node->UpdateRetrieveDSCommiteeCompositionAfterVC(
+          vcblock, mutable_ds_comm);
+      prevHash = vcblock.GetBlockHash();
+      latestBlockLink = make_tuple(BLOCKLINK_VERSION, totalIndex,
+                                   prevdsblocknum + 1, BlockType::VC, prevHash);
+    } else if (typeid(FallbackBlockWShardingStructure) == dirBlock.type()) {
+      const auto& fallbackwshardingstructure =
+          get<FallbackBlockWShardingStructure>(dirBlock);
+      const auto& fallbackblock = fallbackwshardingstructure.m_fallbackblock;
+      const DequeOfShard& shards = fallbackwshardingstructure.m_shards;
+
+      if (fallbackblock.GetHeader().GetFallbackDSEpochNo() !=
+          prevdsblocknum + 1) {
+        LOG_GENERAL(WARNING,
+                    "Fallback block ds epoch number does not match the number "
+                    "being processed "
+                        << prevdsblocknum << " "
+                        << fallbackblock.GetHeader().GetFallbackDSEpochNo());
+        ret = false;
+        break;
+      }
+      if (prevHash != fallbackblock.GetHeader().GetPrevHash()) {
+        LOG_GENERAL(WARNING, "prevHash incorrect "
+                                 << prevHash << " "
+                                 << fallbackblock.GetHeader().GetPrevHash()
+                                 << "in FB block " << prevdsblocknum + 1);
+        ret = false;
+        break;
+      }
+
+      ShardingHash shardinghash;
+      if (!Messenger::GetShardingStructureHash(SHARDINGSTRUCTURE_VERSION,
+                                               shards, shardinghash)) {
+        LOG_GENERAL(WARNING, "GetShardingStructureHash failed");
+        ret = false;
+        break;
+      }
+      if (shardinghash != prevShardingHash) {
+        LOG_GENERAL(WARNING, "ShardingHash does not match ");
+        ret = false;
+        break;
+      }
+
+      const uint32_t shard_id = fallbackblock.GetHeader().GetShardId();
+      if (shard_id >= shards.size()) {
+        LOG_GENERAL(WARNING, "Fallback block of unknown shard " << shard_id);
+        ret = false;
+        break;
+      }
+
+      // The shards live in dirBlocks, which outlives the pool
+      pending.emplace_back(
+          i, pool.Submit([this, &fallbackblock, &shards, shard_id]() {
+            return CheckBlockCosignature(fallbackblock, shards.at(shard_id));
+          }));
+
+      m_mediator.m_node->UpdateDSCommitteeAfterFallback(
+          shard_id, fallbackblock.GetHeader().GetLeaderPubKey(),
+          fallbackblock.GetHeader().GetLeaderNetworkInfo(), mutable_ds_comm,
+          shards);
+      prevHash = fallbackblock.GetBlockHash();
+      latestBlockLink = make_tuple(BLOCKLINK_VERSION, totalIndex,
+                                   prevdsblocknum + 1, BlockType::FB, prevHash);
+    } else {
+      LOG_GENERAL(WARNING, "dirBlock type unexpected ");
+      continue;
+    }
+
+    totalIndex++;
+    while (pending.size() > maxPending && ret) {
+      waitForOldest();
+    }
+  }
+
+  while (!pending.empty()) {
+    waitForOldest();
+  }
+
+  newDSComm = move(mutable_ds_comm);
+  return ret;
+}
+
 ValidatorBase::TxBlockValidationMsg Validator::CheckTxBlocks(
     const vector<TxBlock>& txBlocks, const DequeOfNode& dsComm,
     const BlockLink& latestBlockLink) {
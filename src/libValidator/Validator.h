@@ -38,10 +38,27 @@ class ValidatorBase {
   /// Verifies the transaction w.r.t given pubKey and signature
   virtual bool VerifyTransaction(const Transaction& tran) const = 0;
 
+  /// Verifies a batch of transaction signatures, flagging each one in valid
+  virtual bool VerifyTransactions(const std::vector<Transaction>& txns,
+                                  std::vector<bool>& valid) const = 0;
+
+  /// Set preChecked to true if the txn passed
+  /// CheckCreatedTransactionFromLookup against the current permanent states
   virtual bool CheckCreatedTransaction(const Transaction& tx,
-                                       TransactionReceipt& receipt) const = 0;
+                                       TransactionReceipt& receipt,
+                                       bool preChecked = false) const = 0;
+
+  /// Same as CheckCreatedTransaction on each txn in order, flagging each one
+  /// in results. preChecked is either empty or flags each txn.
+  virtual void CheckCreatedTransactions(
+      const std::vector<Transaction>& txns,
+      std::vector<TransactionReceipt>& receipts, std::vector<bool>& results,
+      const std::vector<bool>& preChecked = {}) const = 0;
 
-  virtual bool CheckCreatedTransactionFromLookup(const Transaction& tx) = 0;
+  /// Set verifySignature to false if the signature went through
+  /// VerifyTransactions already
+  virtual bool CheckCreatedTransactionFromLookup(
+      const Transaction& tx, bool verifySignature = true) = 0;
 
   virtual bool CheckDirBlocks(
       const std::vector<boost::variant<
@@ -51,19 +68,37 @@ class ValidatorBase {
   virtual TxBlockValidationMsg CheckTxBlocks(
       const std::vector<TxBlock>& txblocks, const DequeOfNode& dsComm,
       const BlockLink& latestBlockLink) = 0;
+  virtual bool VerifyDirBlocks(
+      const std::vector<boost::variant<
+          DSBlock, VCBlock, FallbackBlockWShardingStructure>>& dirBlocks,
+      const DequeOfNode& initDsComm, unsigned int numThreads,
+      DequeOfNode& newDSComm, BlockLink& latestBlockLink) = 0;
 };
 
 class Validator : public ValidatorBase {
+  /// Checks of CheckCreatedTransaction that read only the permanent states
+  bool CheckCreatedTransactionSender(const Transaction& tx) const;
+
  public:
   Validator(Mediator& mediator);
   ~Validator();
   std::string name() const override { return "Validator"; }
   bool VerifyTransaction(const Transaction& tran) const override;
 
+  bool VerifyTransactions(const std::vector<Transaction>& txns,
+                          std::vector<bool>& valid) const override;
+
   bool CheckCreatedTransaction(const Transaction& tx,
-                               TransactionReceipt& receipt) const override;
+                               TransactionReceipt& receipt,
+                               bool preChecked = false) const override;
 
-  bool CheckCreatedTransactionFromLookup(const Transaction& tx) override;
+  void CheckCreatedTransactions(
+      const std::vector<Transaction>& txns,
+      std::vector<TransactionReceipt>& receipts, std::vector<bool>& results,
+      const std::vector<bool>& preChecked = {}) const override;
+
+  bool CheckCreatedTransactionFromLookup(const Transaction& tx,
+                                         bool verifySignature = true) override;
 
   template <class Container, class DirectoryBlock>
   bool CheckBlockCosignature(const DirectoryBlock& block,
@@ -74,11 +109,32 @@ class Validator : public ValidatorBase {
           DSBlock, VCBlock, FallbackBlockWShardingStructure>>& dirBlocks,
       const DequeOfNode& initDsComm, const uint64_t& index_num,
       DequeOfNode& newDSComm) override;
+  /// Same checks as CheckDirBlocks, without storing or adding the blocks
+  /// anywhere, for verifying a history already stored. The links and the
+  /// committees are followed in order, while the cosignatures are verified
+  /// on numThreads threads. latestBlockLink is set to the link of the last
+  /// block.
+  bool VerifyDirBlocks(
+      const std::vector<boost::variant<
+          DSBlock, VCBlock, FallbackBlockWShardingStructure>>& dirBlocks,
+      const DequeOfNode& initDsComm, unsigned int numThreads,
+      DequeOfNode& newDSComm, BlockLink& latestBlockLink) override;
   // TxBlocks must be in increasing order or it will fail
   TxBlockValidationMsg CheckTxBlocks(const std::vector<TxBlock>& txBlocks,
                                      const DequeOfNode& dsComm,
                                      const BlockLink& latestBlockLink) override;
   Mediator& m_mediator;
+
+ private:
+  /// Verifies the cosignatures of dirBlocks on numThreads threads, setting
+  /// valid[i] for dirBlocks[i]. The committee of each block is followed from
+  /// initDsComm as CheckDirBlocks follows it, while the links are left to
+  /// CheckDirBlocks. No block after the first failure is verified.
+  void VerifyDirBlockCosignatures(
+      const std::vector<boost::variant<
+          DSBlock, VCBlock, FallbackBlockWShardingStructure>>& dirBlocks,
+      const DequeOfNode& initDsComm, unsigned int numThreads,
+      std::vector<bool>& valid);
 };
 
 #endif  // __VALIDATOR_H__
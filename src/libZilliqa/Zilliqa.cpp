@@ -23,19 +23,45 @@
 #include "common/Serializable.h"
 #include "depends/safeserver/safehttpserver.h"
 #include "depends/safeserver/safetcpsocketserver.h"
+#include "libConsensus/ConsensusStats.h"
 #include "libCrypto/Schnorr.h"
 #include "libCrypto/Sha2.h"
 #include "libData/AccountData/Address.h"
 #include "libNetwork/Guard.h"
+#include "libNetwork/MessageStats.h"
+#include "libNetwork/MetricsExporter.h"
+#include "libNetwork/P2PComm.h"
+#include "libNetwork/PeerSendQueue.h"
+#include "libProtoServer/ProtoRpcServer.h"
 #include "libServer/GetWorkServer.h"
+#include "libServer/RPCStats.h"
+#include "libServer/WebSocketServer.h"
 #include "libUtils/DataConversion.h"
 #include "libUtils/DetachedFunction.h"
 #include "libUtils/Logger.h"
+#include "libUtils/MemoryStats.h"
+#include "libUtils/Metrics.h"
+#include "libUtils/ThreadRoles.h"
 #include "libUtils/UpgradeManager.h"
 
 using namespace std;
 using namespace jsonrpc;
 
+namespace {
+
+const char* DISPATCH_CLASS_NAMES[NUM_DISPATCH_CLASSES] = {
+    "CONSENSUS", "BLOCK", "TXN", "SYNC", "SERVE"};
+
+/// Consensus messages and blocks come from the committees alone and a node
+/// that misses them stalls, so they are queued even past MSGQUEUE_SIZE. Txns
+/// and sync requests can come from anyone, and are dropped instead.
+bool IsDroppedWhenFull(DispatchClass dispatchClass) {
+  return dispatchClass == DISPATCH_TXN || dispatchClass == DISPATCH_SYNC ||
+         dispatchClass == DISPATCH_SERVE;
+}
+
+}  // namespace
+
 void Zilliqa::LogSelfNodeInfo(const PairOfKey& key, const Peer& peer) {
   bytes tmp1;
   bytes tmp2;
@@ -60,24 +86,74 @@ void Zilliqa::LogSelfNodeInfo(const PairOfKey& key, const Peer& peer) {
 
 /*static*/ std::string Zilliqa::FormatMessageName(unsigned char msgType,
                                                   unsigned char instruction) {
-  const std::string InvalidMessageType = "INVALID_MESSAGE";
-  if (msgType >= ARRAY_SIZE(MessageTypeStrings)) {
-    return InvalidMessageType;
-  }
+  return GetMessageName(msgType, instruction);
+}
 
-  if (NULL == MessageTypeInstructionStrings[msgType]) {
-    return InvalidMessageType;
+/*static*/ DispatchClass Zilliqa::GetDispatchClass(const bytes& message) {
+  if (message.size() <= MessageOffset::INST) {
+    return DISPATCH_SYNC;
   }
 
-  if (instruction >= MessageTypeInstructionSize[msgType]) {
-    return InvalidMessageType;
+  const unsigned char type = message.at(MessageOffset::TYPE);
+  const unsigned char ins = message.at(MessageOffset::INST);
+
+  switch (type) {
+    case MessageType::DIRECTORY:
+      switch (ins) {
+        case DSInstructionType::MICROBLOCKSUBMISSION:
+        case DSInstructionType::VCPUSHLATESTDSTXBLOCK:
+          return DISPATCH_BLOCK;
+        default:
+          return DISPATCH_CONSENSUS;
+      }
+    case MessageType::NODE:
+      switch (ins) {
+        case NodeInstructionType::MICROBLOCKCONSENSUS:
+        case NodeInstructionType::FALLBACKCONSENSUS:
+        case NodeInstructionType::PROPOSEGASPRICE:
+          return DISPATCH_CONSENSUS;
+        case NodeInstructionType::SUBMITTRANSACTION:
+        case NodeInstructionType::FORWARDTXNPACKET:
+          return DISPATCH_TXN;
+        case NodeInstructionType::DOREJOIN:
+        case NodeInstructionType::DSGUARDNODENETWORKINFOUPDATE:
+          return DISPATCH_SYNC;
+        default:
+          return DISPATCH_BLOCK;
+      }
+    case MessageType::CONSENSUSUSER:
+      return DISPATCH_CONSENSUS;
+    case MessageType::LOOKUP:
+      switch (ins) {
+        case LookupInstructionType::FORWARDTXN:
+          return DISPATCH_TXN;
+        case LookupInstructionType::GETDSBLOCKFROMSEED:
+        case LookupInstructionType::GETTXBLOCKFROMSEED:
+        case LookupInstructionType::GETSTATEFROMSEED:
+        case LookupInstructionType::GETMICROBLOCKFROMLOOKUP:
+        case LookupInstructionType::GETDIRBLOCKSFROMSEED:
+        case LookupInstructionType::GETSTATEDELTAFROMSEED:
+        case LookupInstructionType::GETSTATEDELTASFROMSEED:
+        case LookupInstructionType::GETMICROBLOCKTXNSFROMLOOKUP:
+          return DISPATCH_SERVE;
+        default:
+          return DISPATCH_SYNC;
+      }
+    default:
+      return DISPATCH_SYNC;
   }
+}
 
-  return MessageTypeStrings[msgType] + "_" +
-         MessageTypeInstructionStrings[msgType][instruction];
+/*static*/ const char* Zilliqa::GetDispatchClassName(
+    DispatchClass dispatchClass) {
+  return dispatchClass < NUM_DISPATCH_CLASSES
+             ? DISPATCH_CLASS_NAMES[dispatchClass]
+             : "UNKNOWN";
 }
 
-void Zilliqa::ProcessMessage(pair<bytes, Peer>* message) {
+void Zilliqa::ProcessMessage(
+    pair<bytes, Peer>* message,
+    const chrono::time_point<chrono::steady_clock>& tpQueued) {
   if (message->first.size() >= MessageOffset::BODY) {
     const unsigned char msg_type = message->first.at(MessageOffset::TYPE);
 
@@ -90,7 +166,7 @@ void Zilliqa::ProcessMessage(pair<bytes, Peer>* message) {
     if (msg_type < msg_handlers_count) {
       if (msg_handlers[msg_type] == NULL) {
         LOG_GENERAL(WARNING, "Message type NULL");
-        delete message;
+        P2PComm::ReleaseMessage(message);
         return;
       }
 
@@ -105,9 +181,27 @@ void Zilliqa::ProcessMessage(pair<bytes, Peer>* message) {
         tpStart = std::chrono::high_resolution_clock::now();
       }
 
+      std::chrono::time_point<std::chrono::steady_clock> tpHandlerStart;
+      if (ENABLE_MESSAGE_STATS) {
+        MessageStats::GetInstance().RecordReceived(message->first);
+        tpHandlerStart = std::chrono::steady_clock::now();
+      }
+
       bool result = msg_handlers[msg_type]->Execute(
           message->first, MessageOffset::INST, message->second);
 
+      if (ENABLE_MESSAGE_STATS) {
+        auto tpNow = std::chrono::steady_clock::now();
+        MessageStats::GetInstance().RecordProcessed(
+            message->first,
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                tpHandlerStart - tpQueued)
+                .count(),
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                tpNow - tpHandlerStart)
+                .count());
+      }
+
       if (ENABLE_CHECK_PERFORMANCE_LOG) {
         auto tpNow = std::chrono::high_resolution_clock::now();
         auto timeInMicro = static_cast<int64_t>(
@@ -126,7 +220,7 @@ void Zilliqa::ProcessMessage(pair<bytes, Peer>* message) {
     }
   }
 
-  delete message;
+  P2PComm::ReleaseMessage(message);
 }
 
 Zilliqa::Zilliqa(const PairOfKey& key, const Peer& peer, SyncType syncType,
@@ -135,31 +229,78 @@ Zilliqa::Zilliqa(const PairOfKey& key, const Peer& peer, SyncType syncType,
       m_ds(m_mediator),
       m_lookup(m_mediator, syncType),
       m_n(m_mediator, syncType, toRetrieveHistory),
-      m_msgQueue(MSGQUEUE_SIZE)
+      m_serveQueue(SERVE_MAX_QUEUED_PER_PEER),
+      m_dispatchPools{
+          {make_unique<ThreadPool>(DISPATCH_CONSENSUS_THREADS, "Consensus"),
+           make_unique<ThreadPool>(DISPATCH_BLOCK_THREADS, "Block"),
+           make_unique<ThreadPool>(DISPATCH_TXN_THREADS, "Txn"),
+           make_unique<ThreadPool>(DISPATCH_SYNC_THREADS, "Sync"),
+           make_unique<ThreadPool>(DISPATCH_SERVE_THREADS, "Serve")}}
 
 {
   LOG_MARKER();
 
-  // Launch the thread that reads messages from the queue
-  auto funcCheckMsgQueue = [this]() mutable -> void {
-    pair<bytes, Peer>* message = NULL;
-    while (true) {
-      while (m_msgQueue.pop(message)) {
-        // For now, we use a thread pool to handle this message
-        // Eventually processing will be single-threaded
-        m_queuePool.AddJob(
-            [this, message]() mutable -> void { ProcessMessage(message); });
-      }
-      std::this_thread::sleep_for(std::chrono::microseconds(1));
+  if (ENABLE_MESSAGE_STATS) {
+    MessageStats::GetInstance().StartPeriodicDump();
+  }
+
+  if (ENABLE_CONSENSUS_STATS) {
+    ConsensusStats::GetInstance().StartPeriodicDump();
+  }
+
+  for (unsigned int i = 0; i < NUM_DISPATCH_CLASSES; ++i) {
+    MemoryStats::GetInstance().Register(
+        string("msgqueue.") + DISPATCH_CLASS_NAMES[i], [this, i]() {
+          MemoryStats::Usage usage;
+          usage.m_entries =
+              max<int64_t>(m_dispatchPools[i]->GetStats().queued, 0);
+          usage.m_bytes = m_queuedBytes[i];
+          return usage;
+        });
+  }
+  MemoryStats::GetInstance().StartPeriodicReport();
+
+  if (ENABLE_METRICS) {
+    for (unsigned int i = 0; i < NUM_DISPATCH_CLASSES; ++i) {
+      const ThreadPool* pool = m_dispatchPools[i].get();
+      Metrics::GetInstance().SetGaugeFunction(
+          "zilliqa_msg_queue_depth", "Messages waiting for a thread, per class",
+          [pool]() { return pool->GetStats().queued; },
+          string("class=\"") + DISPATCH_CLASS_NAMES[i] + "\"");
     }
-  };
-  DetachedFunction(1, funcCheckMsgQueue);
+    for (unsigned int lane = 0; lane < NUM_SEND_LANES; ++lane) {
+      const auto sendLane = static_cast<SendLane>(lane);
+      Metrics::GetInstance().SetGaugeFunction(
+          "zilliqa_send_queue_depth", "Messages waiting to be sent, per lane",
+          [sendLane]() {
+            return PeerSendQueue::GetInstance().GetLaneDepth(sendLane);
+          },
+          string("lane=\"") + PeerSendQueue::GetLaneName(sendLane) + "\"");
+    }
+    MetricsExporter::GetInstance().Start(METRICS_IP_TO_BIND, METRICS_PORT);
+  }
 
   m_validator = make_shared<Validator>(m_mediator);
 
   if (LOOKUP_NODE_MODE) {
-    m_serverConnector = make_unique<SafeHttpServer>(RPC_PORT);
-
+    auto httpServer =
+        make_unique<SafeHttpServer>(RPC_PORT, "", "", RPC_CONNECTION_THREADS);
+    httpServer->SetRequestPools(
+        RPC_WORKER_THREADS, RPC_EXPENSIVE_WORKER_THREADS,
+        RPC_MAX_QUEUED_REQUESTS, Server::GetExpensiveMethods());
+    httpServer->SetConnectionTimeout(RPC_CONNECTION_TIMEOUT_IN_SECONDS);
+    httpServer->SetBatchThreads(RPC_BATCH_THREADS);
+    httpServer->SetAdmissionFilter(
+        [](const string& clientAddress, const vector<string>& methods) {
+          return RPCStats::GetInstance().Admit(clientAddress, methods);
+        });
+    httpServer->SetThreadInit(
+        []() { ThreadRoles::GetInstance().ApplyToCurrentThread("RPC"); });
+    httpServer->SetDirectHandler(
+        [this](const string& request, string& response) {
+          return m_server->HandleDirect(request, response);
+        });
+    m_serverConnector = move(httpServer);
   } else {
     m_serverConnector = make_unique<SafeTcpSocketServer>(IP_TO_BIND, RPC_PORT);
   }
@@ -167,6 +308,9 @@ Zilliqa::Zilliqa(const PairOfKey& key, const Peer& peer, SyncType syncType,
     LOG_GENERAL(FATAL, "m_serverConnector NULL");
   }
   m_server = make_unique<Server>(m_mediator, *m_serverConnector);
+  if (LOOKUP_NODE_MODE && ENABLE_PROTO_RPC) {
+    m_protoRpcServer = make_unique<ProtoRpcServer>(m_mediator);
+  }
 
   m_mediator.RegisterColleagues(&m_ds, &m_n, &m_lookup, m_validator.get());
 
@@ -180,6 +324,8 @@ Zilliqa::Zilliqa(const PairOfKey& key, const Peer& peer, SyncType syncType,
 
   if (ARCHIVAL_LOOKUP && !LOOKUP_NODE_MODE) {
     LOG_GENERAL(FATAL, "Archvial lookup is true but not lookup ");
+  } else if (LOOKUP_REPLICA && !ARCHIVAL_LOOKUP) {
+    LOG_GENERAL(FATAL, "Lookup replica is true but not archival lookup");
   } else if (ARCHIVAL_LOOKUP && LOOKUP_NODE_MODE) {
     m_server->StartCollectorThread();
   }
@@ -335,23 +481,112 @@ Zilliqa::Zilliqa(const PairOfKey& key, const Peer& peer, SyncType syncType,
           LOG_GENERAL(WARNING, "API Server couldn't start");
         }
       }
+      if (LOOKUP_NODE_MODE && ENABLE_WEBSOCKET) {
+        WebSocketServer::GetInstance().Start(WEBSOCKET_PORT);
+      }
+      if (m_protoRpcServer != nullptr) {
+        m_protoRpcServer->Start(PROTO_RPC_PORT);
+      }
     }
   };
   DetachedFunction(1, func);
 }
 
-Zilliqa::~Zilliqa() {
-  pair<bytes, Peer>* message = NULL;
-  while (m_msgQueue.pop(message)) {
-    delete message;
+Executable* Zilliqa::GetMessageHandler(unsigned char msgType) {
+  switch (msgType) {
+    case MessageType::DIRECTORY:
+      return &m_ds;
+    case MessageType::NODE:
+      return &m_n;
+    case MessageType::LOOKUP:
+      return &m_lookup;
+    default:
+      return nullptr;
   }
 }
 
 void Zilliqa::Dispatch(pair<bytes, Peer>* message) {
   // LOG_MARKER();
 
-  // Queue message
-  if (!m_msgQueue.bounded_push(message)) {
-    LOG_GENERAL(WARNING, "Input MsgQueue is full");
+  // Drop what the handler would reject anyway before it takes up a thread
+  if (message->first.size() >= MessageOffset::BODY) {
+    const Executable* handler =
+        GetMessageHandler(message->first.at(MessageOffset::TYPE));
+    if (handler != nullptr &&
+        !handler->PassesPreFilter(message->first, MessageOffset::INST)) {
+      static Metrics::Counter& filtered = Metrics::GetInstance().GetCounter(
+          "zilliqa_msg_prefiltered_total",
+          "Messages dropped at dispatch as stale or malformed");
+      filtered.Increment();
+
+      LOG_GENERAL(INFO, "Dropping stale "
+                            << FormatMessageName(
+                                   message->first.at(MessageOffset::TYPE),
+                                   message->first.at(MessageOffset::INST))
+                            << " from " << message->second);
+      P2PComm::ReleaseMessage(message);
+      return;
+    }
   }
+
+  const DispatchClass dispatchClass = GetDispatchClass(message->first);
+  ThreadPool& pool = *m_dispatchPools[dispatchClass];
+
+  if (pool.GetStats().queued >= MSGQUEUE_SIZE) {
+    if (IsDroppedWhenFull(dispatchClass)) {
+      static Metrics::Counter* dropped[NUM_DISPATCH_CLASSES] = {};
+      static once_flag droppedFlag;
+      call_once(droppedFlag, []() {
+        for (unsigned int i = 0; i < NUM_DISPATCH_CLASSES; ++i) {
+          dropped[i] = &Metrics::GetInstance().GetCounter(
+              "zilliqa_msg_dropped_total",
+              "Messages dropped as their queue was full, per class",
+              string("class=\"") + DISPATCH_CLASS_NAMES[i] + "\"");
+        }
+      });
+      dropped[dispatchClass]->Increment();
+
+      LOG_GENERAL(WARNING, GetDispatchClassName(dispatchClass)
+                               << " MsgQueue is full, dropping message from "
+                               << message->second);
+      P2PComm::ReleaseMessage(message);
+      return;
+    }
+
+    LOG_GENERAL(WARNING, GetDispatchClassName(dispatchClass)
+                             << " MsgQueue is over " << MSGQUEUE_SIZE);
+  }
+
+  const auto tpQueued = std::chrono::steady_clock::now();
+  const uint64_t size = message->first.size();
+  auto job = [this, message, tpQueued, dispatchClass, size]() mutable -> void {
+    m_queuedBytes[dispatchClass] -= size;
+    ProcessMessage(message, tpQueued);
+  };
+
+  if (dispatchClass == DISPATCH_SERVE) {
+    const string requester = message->second.GetPrintableIPAddress();
+    if (!m_serveLimiter.TryAcquire(requester,
+                                   SERVE_REQUESTS_PER_SECOND_PER_PEER) ||
+        !m_serveQueue.Add(requester, job)) {
+      static Metrics::Counter& throttled = Metrics::GetInstance().GetCounter(
+          "zilliqa_serve_throttled_total",
+          "Sync requests dropped as their requester was over its limit");
+      throttled.Increment();
+
+      LOG_GENERAL(INFO, "Throttling "
+                            << FormatMessageName(
+                                   message->first.at(MessageOffset::TYPE),
+                                   message->first.at(MessageOffset::INST))
+                            << " from " << message->second);
+      P2PComm::ReleaseMessage(message);
+      return;
+    }
+    m_queuedBytes[dispatchClass] += size;
+    pool.AddJob([this]() { m_serveQueue.RunNext(); });
+    return;
+  }
+
+  m_queuedBytes[dispatchClass] += size;
+  pool.AddJob(job);
 }
@@ -18,6 +18,10 @@
 #ifndef __ZILLIQA_H__
 #define __ZILLIQA_H__
 
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <vector>
 
 #include "libDirectoryService/DirectoryService.h"
@@ -26,8 +30,24 @@
 #include "libNetwork/Peer.h"
 #include "libNode/Node.h"
 #include "libServer/Server.h"
+#include "libUtils/FairJobQueue.h"
+#include "libUtils/RateLimiter.h"
 #include "libUtils/ThreadPool.h"
 
+class ProtoRpcServer;
+
+/// Classes of inbound messages. Each has a pool of its own, so that consensus
+/// does not wait behind txn packets and sync traffic.
+enum DispatchClass : unsigned char {
+  DISPATCH_CONSENSUS = 0x00,
+  DISPATCH_BLOCK = 0x01,
+  DISPATCH_TXN = 0x02,
+  DISPATCH_SYNC = 0x03,
+  /// Requests for chain data from nodes syncing off a lookup
+  DISPATCH_SERVE = 0x04,
+  NUM_DISPATCH_CLASSES = 0x05
+};
+
 /// Main Zilliqa class.
 class Zilliqa {
   Mediator m_mediator;
@@ -37,14 +57,32 @@ class Zilliqa {
   Node m_n;
   // ConsensusUser m_cu; // Note: This is just a test class to demo Consensus
   // usage
-  boost::lockfree::queue<std::pair<bytes, Peer>*> m_msgQueue;
 
   std::unique_ptr<Server> m_server;
   std::unique_ptr<jsonrpc::AbstractServerConnector> m_serverConnector;
+  std::unique_ptr<ProtoRpcServer> m_protoRpcServer;
+
+  /// Bytes of the messages waiting in each of m_dispatchPools
+  std::array<std::atomic<uint64_t>, NUM_DISPATCH_CLASSES> m_queuedBytes{};
+
+  /// DISPATCH_SERVE requests wait here per requester address and take turns
+  /// for the threads of their pool, so that a few nodes asking for a lot do
+  /// not hold up the rest of a sync storm
+  FairJobQueue m_serveQueue;
+  RateLimiter m_serveLimiter;
 
-  ThreadPool m_queuePool{MAXMESSAGE, "QueuePool"};
+  /// Last, so that they are joined before the handlers they call are gone
+  std::array<std::unique_ptr<ThreadPool>, NUM_DISPATCH_CLASSES>
+      m_dispatchPools;
 
-  void ProcessMessage(std::pair<bytes, Peer>* message);
+  /// tpQueued is when the message was handed to its pool, so that the wait
+  /// for a free thread shows up in MessageStats
+  void ProcessMessage(
+      std::pair<bytes, Peer>* message,
+      const std::chrono::time_point<std::chrono::steady_clock>& tpQueued);
+
+  /// The handler of a message type, or nullptr if there is none
+  Executable* GetMessageHandler(unsigned char msgType);
 
  public:
   /// Constructor.
@@ -52,9 +90,6 @@ class Zilliqa {
           SyncType syncType = SyncType::NO_SYNC,
           bool toRetrieveHistory = false);
 
-  /// Destructor.
-  ~Zilliqa();
-
   void LogSelfNodeInfo(const PairOfKey& key, const Peer& peer);
 
   /// Forwards an incoming message for processing by the appropriate subclass.
@@ -62,6 +97,10 @@ class Zilliqa {
 
   static std::string FormatMessageName(unsigned char msgType,
                                        unsigned char instruction);
+
+  static DispatchClass GetDispatchClass(const bytes& message);
+
+  static const char* GetDispatchClassName(DispatchClass dispatchClass);
 };
 
 #endif  // __ZILLIQA_H__
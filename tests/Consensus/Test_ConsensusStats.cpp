@@ -0,0 +1,109 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <sstream>
+
+#include "libConsensus/ConsensusStats.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE consensusstats
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(consensusstats)
+
+BOOST_AUTO_TEST_CASE(test_counters) {
+  INIT_STDOUT_LOGGER();
+
+  ConsensusStats& stats = ConsensusStats::GetInstance();
+  stats.Clear();
+
+  stats.RecordPhaseUs(true, ConsensusStats::RESPONSE, 1, 100);
+  stats.RecordPhaseUs(true, ConsensusStats::RESPONSE, 1, 300);
+  stats.RecordMissing(true, ConsensusStats::RESPONSE, 1, 4);
+  stats.RecordLate(true, ConsensusStats::RESPONSE, 1);
+
+  ConsensusStats::Snapshot snapshot;
+  BOOST_REQUIRE(stats.GetSnapshot(true, ConsensusStats::RESPONSE, 1, snapshot));
+  BOOST_CHECK_EQUAL(snapshot.m_count, 2);
+  BOOST_CHECK_EQUAL(snapshot.m_totalUs, 400);
+  BOOST_CHECK_EQUAL(snapshot.m_missing, 4);
+  BOOST_CHECK_EQUAL(snapshot.m_late, 1);
+  BOOST_CHECK_EQUAL(snapshot.m_hist[MessageStats::GetHistogramBucket(100)], 1);
+  BOOST_CHECK_EQUAL(snapshot.m_hist[MessageStats::GetHistogramBucket(300)], 1);
+
+  BOOST_CHECK_MESSAGE(
+      !stats.GetSnapshot(false, ConsensusStats::RESPONSE, 1, snapshot),
+      "Shard committee should not have DS counters!");
+  BOOST_CHECK_MESSAGE(
+      !stats.GetSnapshot(true, ConsensusStats::RESPONSE, 0, snapshot),
+      "Other subset should not have counters!");
+
+  // Subsets past the limit fold into the last one
+  stats.RecordPhaseUs(false, ConsensusStats::COMMIT,
+                      ConsensusStats::MAX_SUBSETS + 3, 10);
+  BOOST_CHECK(stats.GetSnapshot(false, ConsensusStats::COMMIT,
+                                ConsensusStats::MAX_SUBSETS - 1, snapshot));
+
+  stats.Clear();
+  BOOST_CHECK(!stats.GetSnapshot(true, ConsensusStats::RESPONSE, 1, snapshot));
+}
+
+BOOST_AUTO_TEST_CASE(test_csv) {
+  INIT_STDOUT_LOGGER();
+
+  ConsensusStats& stats = ConsensusStats::GetInstance();
+  stats.Clear();
+
+  stats.RecordPhaseUs(false, ConsensusStats::FINALCOMMIT, 0, 5);
+
+  ostringstream os;
+  stats.WriteCsv(os, 1234);
+  BOOST_CHECK_EQUAL(os.str().substr(0, os.str().find(';')),
+                    "1234,SHARD,FINALCOMMIT,0,1,5,0,0,0");
+
+  stats.Clear();
+}
+
+BOOST_AUTO_TEST_CASE(test_commit_latency) {
+  INIT_STDOUT_LOGGER();
+
+  ConsensusStats& stats = ConsensusStats::GetInstance();
+  stats.Clear();
+
+  PubKey fast = Schnorr::GetInstance().GenKeyPair().second;
+  PubKey slow = Schnorr::GetInstance().GenKeyPair().second;
+
+  BOOST_CHECK_EQUAL(stats.GetCommitLatency(fast), UINT64_MAX);
+
+  stats.RecordCommitLatency(fast, 800);
+  stats.RecordCommitLatency(slow, 8000);
+  BOOST_CHECK_EQUAL(stats.GetCommitLatency(fast), 800);
+
+  // A single slow round only moves the average by an eighth of the gap
+  stats.RecordCommitLatency(fast, 8800);
+  BOOST_CHECK_EQUAL(stats.GetCommitLatency(fast), 1800);
+  BOOST_CHECK(stats.GetCommitLatency(fast) < stats.GetCommitLatency(slow));
+
+  stats.Clear();
+  BOOST_CHECK_EQUAL(stats.GetCommitLatency(slow), UINT64_MAX);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
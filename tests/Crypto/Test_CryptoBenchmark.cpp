@@ -0,0 +1,353 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Timings of the Schnorr, multisignature and hashing operations on the
+// consensus path, at the committee sizes of a mainnet shard or DS committee.
+// Each result is printed as one CSV line or JSON object, so that runs before
+// and after a change can be compared by a script.
+//
+// Usage: Test_CryptoBenchmark [--case PREFIX] [--committee N]...
+//            [--millis N] [--format csv|json]
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "libCrypto/MultiSig.h"
+#include "libCrypto/Sha2.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+namespace po = boost::program_options;
+
+namespace {
+
+struct BenchConfig {
+  string m_case;
+  vector<unsigned int> m_committees{50, 200, 600, 1000};
+  unsigned int m_millis = 500;
+  bool m_json = false;
+};
+
+/// Keys, commits and responses of one committee signing one message
+struct Committee {
+  vector<PrivKey> m_privKeys;
+  vector<PubKey> m_pubKeys;
+  vector<CommitSecret> m_secrets;
+  vector<CommitPoint> m_points;
+  vector<Response> m_responses;
+  BitVector m_bitmap;
+  PubKey m_aggregatedKey;
+  Challenge m_challenge;
+  Signature m_signature;
+};
+
+const bytes& GetMessage() {
+  // About the size of a block header being cosigned
+  static const bytes message(256, 0x5a);
+  return message;
+}
+
+void PrintHeader(const BenchConfig& config) {
+  if (!config.m_json) {
+    cout << "case,n,iterations,ns_per_op,ops_per_sec" << endl;
+  }
+}
+
+/// Runs op once to warm up, then for at least config.m_millis, and prints
+/// the time per run. Returns false if op failed.
+bool Measure(const BenchConfig& config, const string& name, size_t n,
+             const function<bool()>& op) {
+  if (!config.m_case.empty() && name.compare(0, config.m_case.size(),
+                                             config.m_case) != 0) {
+    return true;
+  }
+
+  if (!op()) {
+    cerr << name << " (" << n << "): failed" << endl;
+    return false;
+  }
+
+  const auto minElapsed = chrono::milliseconds(config.m_millis);
+  uint64_t iterations = 0;
+  const auto start = chrono::steady_clock::now();
+  auto elapsed = chrono::steady_clock::duration::zero();
+  do {
+    if (!op()) {
+      cerr << name << " (" << n << "): failed" << endl;
+      return false;
+    }
+    iterations++;
+    elapsed = chrono::steady_clock::now() - start;
+  } while (elapsed < minElapsed);
+
+  const double nanos =
+      chrono::duration<double, nano>(elapsed).count() / iterations;
+  if (config.m_json) {
+    cout << "{\"case\":\"" << name << "\",\"n\":" << n
+         << ",\"iterations\":" << iterations << fixed << setprecision(1)
+         << ",\"ns_per_op\":" << nanos << ",\"ops_per_sec\":" << 1e9 / nanos
+         << "}" << endl;
+  } else {
+    cout << name << "," << n << "," << iterations << fixed << setprecision(1)
+         << "," << nanos << "," << 1e9 / nanos << endl;
+  }
+  return true;
+}
+
+bool MakeCommittee(unsigned int size, Committee& committee) {
+  Schnorr& schnorr = Schnorr::GetInstance();
+
+  for (unsigned int i = 0; i < size; i++) {
+    PairOfKey keyPair = schnorr.GenKeyPair();
+    committee.m_privKeys.emplace_back(keyPair.first);
+    committee.m_pubKeys.emplace_back(keyPair.second);
+  }
+
+  committee.m_secrets.resize(size);
+  for (const auto& secret : committee.m_secrets) {
+    committee.m_points.emplace_back(secret);
+  }
+
+  // A consensus round needs two thirds of the committee to commit
+  committee.m_bitmap = BitVector(size);
+  for (unsigned int i = 0; i < size; i++) {
+    committee.m_bitmap[i] = (i % 3 != 2);
+  }
+
+  auto aggregatedKey = MultiSig::AggregatePubKeys(committee.m_pubKeys);
+  auto aggregatedCommit = MultiSig::AggregateCommits(committee.m_points);
+  if (!aggregatedKey || !aggregatedCommit) {
+    return false;
+  }
+  committee.m_aggregatedKey = *aggregatedKey;
+  committee.m_challenge =
+      Challenge(*aggregatedCommit, *aggregatedKey, GetMessage());
+
+  for (unsigned int i = 0; i < size; i++) {
+    committee.m_responses.emplace_back(committee.m_secrets[i],
+                                       committee.m_challenge,
+                                       committee.m_privKeys[i]);
+  }
+
+  auto aggregatedResponse = MultiSig::AggregateResponses(committee.m_responses);
+  if (!aggregatedResponse) {
+    return false;
+  }
+  auto signature =
+      MultiSig::AggregateSign(committee.m_challenge, *aggregatedResponse);
+  if (!signature) {
+    return false;
+  }
+  committee.m_signature = *signature;
+
+  return true;
+}
+
+bool RunSchnorr(const BenchConfig& config) {
+  Schnorr& schnorr = Schnorr::GetInstance();
+  const PairOfKey keyPair = schnorr.GenKeyPair();
+  const bytes& message = GetMessage();
+
+  Signature signature;
+  if (!schnorr.Sign(message, keyPair.first, keyPair.second, signature)) {
+    cerr << "Schnorr::Sign failed" << endl;
+    return false;
+  }
+
+  return Measure(config, "schnorr.sign", message.size(),
+                 [&]() {
+                   Signature result;
+                   return schnorr.Sign(message, keyPair.first, keyPair.second,
+                                       result);
+                 }) &&
+         Measure(config, "schnorr.verify", message.size(), [&]() {
+           return schnorr.Verify(message, signature, keyPair.second);
+         });
+}
+
+bool RunSerialization(const BenchConfig& config, const Committee& committee) {
+  // Distinct keys, as a node decodes a whole committee in turn; keys seen
+  // before are served from the intern cache of PubKey, as on a running node
+  vector<bytes> serializedKeys;
+  for (const auto& pubKey : committee.m_pubKeys) {
+    serializedKeys.emplace_back();
+    pubKey.Serialize(serializedKeys.back(), 0);
+  }
+  bytes serializedSignature;
+  committee.m_signature.Serialize(serializedSignature, 0);
+
+  size_t next = 0;
+  const size_t numKeys = committee.m_pubKeys.size();
+
+  return Measure(config, "pubkey.serialize", PUB_KEY_SIZE,
+                 [&]() {
+                   bytes dst;
+                   const PubKey& key = committee.m_pubKeys[next++ % numKeys];
+                   return key.Serialize(dst, 0) > 0;
+                 }) &&
+         Measure(config, "pubkey.deserialize", PUB_KEY_SIZE,
+                 [&]() {
+                   PubKey key;
+                   return key.Deserialize(serializedKeys[next++ % numKeys],
+                                          0) == 0;
+                 }) &&
+         Measure(config, "signature.serialize",
+                 SIGNATURE_CHALLENGE_SIZE + SIGNATURE_RESPONSE_SIZE,
+                 [&]() {
+                   bytes dst;
+                   return committee.m_signature.Serialize(dst, 0) > 0;
+                 }) &&
+         Measure(config, "signature.deserialize",
+                 SIGNATURE_CHALLENGE_SIZE + SIGNATURE_RESPONSE_SIZE, [&]() {
+                   Signature signature;
+                   return signature.Deserialize(serializedSignature, 0) == 0;
+                 });
+}
+
+bool RunMultiSig(const BenchConfig& config, const Committee& committee) {
+  MultiSig& multisig = MultiSig::GetInstance();
+  const size_t n = committee.m_pubKeys.size();
+  const bytes& message = GetMessage();
+
+  return Measure(config, "multisig.aggregatepubkeys", n,
+                 [&]() {
+                   return MultiSig::AggregatePubKeys(committee.m_pubKeys) !=
+                          nullptr;
+                 }) &&
+         Measure(config, "multisig.aggregatepubkeys.bitmap", n,
+                 [&]() {
+                   return MultiSig::AggregatePubKeys(committee.m_pubKeys,
+                                                     committee.m_bitmap) !=
+                          nullptr;
+                 }) &&
+         Measure(config, "multisig.aggregatecommits", n,
+                 [&]() {
+                   return MultiSig::AggregateCommits(committee.m_points) !=
+                          nullptr;
+                 }) &&
+         Measure(config, "multisig.aggregateresponses", n,
+                 [&]() {
+                   return MultiSig::AggregateResponses(
+                              committee.m_responses) != nullptr;
+                 }) &&
+         Measure(config, "multisig.verifyresponse", n,
+                 [&]() {
+                   return MultiSig::VerifyResponse(
+                       committee.m_responses[0], committee.m_challenge,
+                       committee.m_pubKeys[0], committee.m_points[0]);
+                 }) &&
+         Measure(config, "multisig.verify", n, [&]() {
+           return multisig.MultiSigVerify(message, committee.m_signature,
+                                          committee.m_aggregatedKey);
+         });
+}
+
+bool RunSha256(const BenchConfig& config) {
+  // Hashes, transactions, block headers and whole messages
+  for (const size_t size : {32, 64, 256, 1024, 4096, 65536}) {
+    const bytes input(size, 0x5a);
+    unsigned char digest[32] = {};
+    if (!Measure(config, "sha256", size, [&]() {
+          SHA2<HASH_TYPE::HASH_VARIANT_256> sha2;
+          sha2.Update(input.data(), input.size());
+          sha2.Finalize(digest);
+          return true;
+        })) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  BenchConfig config;
+  string format = "csv";
+
+  po::options_description desc("Options");
+  desc.add_options()("help,h", "Print help messages")(
+      "case,c", po::value<string>(&config.m_case),
+      "Only run the cases whose names start with this")(
+      "committee,n",
+      po::value<vector<unsigned int>>(&config.m_committees)->multitoken(),
+      "Committee sizes for the multisignature cases")(
+      "millis,t", po::value<unsigned int>(&config.m_millis),
+      "Minimum run time of each case")(
+      "format,f", po::value<string>(&format), "Output format, csv or json");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("help")) {
+      cout << desc << endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (boost::program_options::error& e) {
+    cerr << "ERROR: " << e.what() << endl << endl << desc << endl;
+    return 1;
+  }
+
+  if (format != "csv" && format != "json") {
+    cerr << "ERROR: unknown format " << format << endl << endl
+         << desc << endl;
+    return 1;
+  }
+  config.m_json = (format == "json");
+
+  INIT_STDOUT_LOGGER();
+
+  PrintHeader(config);
+
+  if (!RunSchnorr(config) || !RunSha256(config)) {
+    return 1;
+  }
+
+  bool serializationDone = false;
+  for (const auto size : config.m_committees) {
+    if (size == 0) {
+      continue;
+    }
+
+    Committee committee;
+    if (!MakeCommittee(size, committee)) {
+      cerr << "Failed to set up a committee of " << size << endl;
+      return 1;
+    }
+
+    if (!serializationDone) {
+      if (!RunSerialization(config, committee)) {
+        return 1;
+      }
+      serializationDone = true;
+    }
+
+    if (!RunMultiSig(config, committee)) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -236,4 +236,163 @@ BOOST_AUTO_TEST_CASE(test_serialization) {
                       "Signature verification (wrong message) failed");
 }
 
+/**
+ * \brief test_aggregate_pubkeys_cached
+ *
+ * \details Test bitmap aggregation against aggregating the subset directly
+ */
+BOOST_AUTO_TEST_CASE(test_aggregate_pubkeys_cached) {
+  Schnorr& schnorr = Schnorr::GetInstance();
+
+  const unsigned int committee_size = 50;
+  vector<PubKey> committee;
+  for (unsigned int i = 0; i < committee_size; i++) {
+    committee.emplace_back(schnorr.GenKeyPair().second);
+  }
+
+  auto expected = [&committee](const BitVector& bitmap) {
+    vector<PubKey> subset;
+    for (unsigned int i = 0; i < bitmap.size(); i++) {
+      if (bitmap.at(i)) {
+        subset.emplace_back(committee.at(i));
+      }
+    }
+    return MultiSig::AggregatePubKeys(subset);
+  };
+
+  /// Fresh aggregation, then an exact cache hit
+  BitVector bitmap(committee_size);
+  for (unsigned int i = 0; i < 40; i++) {
+    bitmap.at(i) = true;
+  }
+  for (unsigned int round = 0; round < 2; round++) {
+    shared_ptr<PubKey> aggregated =
+        MultiSig::AggregatePubKeys(committee, bitmap);
+    BOOST_CHECK_MESSAGE(aggregated != nullptr, "AggregatePubKeys failed");
+    BOOST_CHECK_MESSAGE(*aggregated == *expected(bitmap),
+                        "Aggregated key mismatch in round " << round);
+  }
+
+  /// A few members leave and join, taking the incremental path
+  bitmap.at(3) = false;
+  bitmap.at(17) = false;
+  bitmap.at(45) = true;
+  shared_ptr<PubKey> aggregated = MultiSig::AggregatePubKeys(committee, bitmap);
+  BOOST_CHECK_MESSAGE(aggregated != nullptr, "AggregatePubKeys failed");
+  BOOST_CHECK_MESSAGE(*aggregated == *expected(bitmap),
+                      "Incrementally aggregated key mismatch");
+
+  /// A different committee of the same size must not reuse the cache
+  committee.at(0) = schnorr.GenKeyPair().second;
+  bitmap.at(0) = true;
+  aggregated = MultiSig::AggregatePubKeys(committee, bitmap);
+  BOOST_CHECK_MESSAGE(aggregated != nullptr, "AggregatePubKeys failed");
+  BOOST_CHECK_MESSAGE(*aggregated == *expected(bitmap),
+                      "Aggregated key for new committee mismatch");
+
+  /// Invalid bitmaps
+  BOOST_CHECK_MESSAGE(
+      MultiSig::AggregatePubKeys(committee,
+                                 BitVector(committee_size - 1, true)) ==
+          nullptr,
+      "Bitmap size mismatch not detected");
+  BOOST_CHECK_MESSAGE(
+      MultiSig::AggregatePubKeys(committee, BitVector(committee_size)) ==
+          nullptr,
+      "Empty bitmap not detected");
+}
+
+/**
+ * \brief test_accumulate
+ *
+ * \details Test running aggregation of commits and responses
+ */
+BOOST_AUTO_TEST_CASE(test_accumulate) {
+  const unsigned int nbsigners = 20;
+  vector<CommitPoint> points;
+  vector<Response> responses;
+  CommitPoint runningCommit;
+  Response runningResponse;
+
+  Challenge challenge;
+  challenge.m_initialized = true;
+  BN_set_word(challenge.m_c.get(), 12345);
+
+  for (unsigned int i = 0; i < nbsigners; i++) {
+    PairOfKey keypair = Schnorr::GetInstance().GenKeyPair();
+    CommitSecret secret;
+    points.emplace_back(secret);
+    responses.emplace_back(secret, challenge, keypair.first);
+
+    BOOST_CHECK_MESSAGE(
+        MultiSig::AccumulateCommit(runningCommit, points.back()),
+        "AccumulateCommit failed");
+    BOOST_CHECK_MESSAGE(
+        MultiSig::AccumulateResponse(runningResponse, responses.back()),
+        "AccumulateResponse failed");
+  }
+
+  BOOST_CHECK_MESSAGE(runningCommit == *MultiSig::AggregateCommits(points),
+                      "Running commit differs from AggregateCommits");
+  BOOST_CHECK_MESSAGE(
+      runningResponse == *MultiSig::AggregateResponses(responses),
+      "Running response differs from AggregateResponses");
+
+  /// Taking the last commit back out leaves the aggregate of the others
+  BOOST_CHECK_MESSAGE(
+      MultiSig::AccumulateCommit(runningCommit, points.back(), true),
+      "AccumulateCommit (subtract) failed");
+  points.pop_back();
+  BOOST_CHECK_MESSAGE(runningCommit == *MultiSig::AggregateCommits(points),
+                      "Commit subtraction mismatch");
+}
+
+/**
+ * \brief test_verify_responses
+ *
+ * \details Test the combined check of one signer's responses to several
+ * challenges over the same commit
+ */
+BOOST_AUTO_TEST_CASE(test_verify_responses) {
+  const unsigned int nbchallenges = 3;
+  PairOfKey keypair = Schnorr::GetInstance().GenKeyPair();
+  CommitSecret secret;
+  CommitPoint point(secret);
+
+  vector<Challenge> challenges;
+  vector<Response> responses;
+  for (unsigned int i = 0; i < nbchallenges; i++) {
+    Challenge challenge;
+    challenge.m_initialized = true;
+    BN_set_word(challenge.m_c.get(), 1000 + i);
+    challenges.emplace_back(challenge);
+    responses.emplace_back(secret, challenge, keypair.first);
+  }
+
+  BOOST_CHECK_MESSAGE(MultiSig::VerifyResponses(responses, challenges,
+                                                keypair.second, point),
+                      "Combined response check failed");
+
+  /// Errors that cancel out in a plain sum are still caught
+  vector<Response> offset(responses);
+  BN_add_word(offset.at(0).m_r.get(), 1);
+  BN_sub_word(offset.at(1).m_r.get(), 1);
+  BOOST_CHECK_MESSAGE(
+      !MultiSig::VerifyResponses(offset, challenges, keypair.second, point),
+      "Offset responses not detected");
+  BOOST_CHECK_MESSAGE(MultiSig::VerifyResponse(offset.at(2), challenges.at(2),
+                                               keypair.second, point),
+                      "Untouched response rejected");
+
+  PairOfKey other = Schnorr::GetInstance().GenKeyPair();
+  BOOST_CHECK_MESSAGE(
+      !MultiSig::VerifyResponses(responses, challenges, other.second, point),
+      "Wrong key not detected");
+
+  challenges.pop_back();
+  BOOST_CHECK_MESSAGE(
+      !MultiSig::VerifyResponses(responses, challenges, keypair.second, point),
+      "Count mismatch not detected");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
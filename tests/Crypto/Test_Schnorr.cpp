@@ -166,6 +166,117 @@ BOOST_AUTO_TEST_CASE(test_sign_verif) {
       "Signature verification (wrong message) failed");
 }
 
+/**
+ * \brief test_verify_batch
+ *
+ * \details Test batch verification and locating the bad signature
+ */
+BOOST_AUTO_TEST_CASE(test_verify_batch) {
+  Schnorr& schnorr = Schnorr::GetInstance();
+
+  const unsigned int batch_size = 8;
+  vector<bytes> messages;
+  vector<Signature> signatures;
+  vector<PubKey> pubkeys;
+
+  for (unsigned int i = 0; i < batch_size; i++) {
+    PairOfKey keypair = schnorr.GenKeyPair();
+    bytes message(256);
+    generate(message.begin(), message.end(), std::rand);
+
+    Signature signature;
+    BOOST_CHECK_MESSAGE(
+        schnorr.Sign(message, keypair.first, keypair.second, signature),
+        "Signing failed");
+
+    messages.emplace_back(message);
+    signatures.emplace_back(signature);
+    pubkeys.emplace_back(keypair.second);
+  }
+
+  vector<bool> results;
+  BOOST_CHECK_MESSAGE(
+      schnorr.VerifyBatch(messages, signatures, pubkeys, results) == true,
+      "Batch verification (all correct) failed");
+  BOOST_CHECK_MESSAGE(results == vector<bool>(batch_size, true),
+                      "Batch verification results (all correct) wrong");
+
+  /// Swap in a signature for a different message
+  const unsigned int bad_index = 5;
+  signatures.at(bad_index) = signatures.at(0);
+
+  BOOST_CHECK_MESSAGE(
+      schnorr.VerifyBatch(messages, signatures, pubkeys, results) == false,
+      "Batch verification (one wrong) failed");
+  for (unsigned int i = 0; i < batch_size; i++) {
+    BOOST_CHECK_MESSAGE(results.at(i) == (i != bad_index),
+                        "Batch verification result " << i << " wrong");
+  }
+
+  /// Same batch spread across several threads
+  BOOST_CHECK_MESSAGE(
+      schnorr.VerifyBatch(messages, signatures, pubkeys, results, 3) == false,
+      "Threaded batch verification (one wrong) failed");
+  for (unsigned int i = 0; i < batch_size; i++) {
+    BOOST_CHECK_MESSAGE(results.at(i) == (i != bad_index),
+                        "Threaded batch verification result " << i
+                                                              << " wrong");
+  }
+
+  /// Mismatched input sizes are rejected
+  pubkeys.pop_back();
+  BOOST_CHECK_MESSAGE(
+      schnorr.VerifyBatch(messages, signatures, pubkeys, results) == false,
+      "Batch verification (size mismatch) failed");
+}
+
+/**
+ * \brief test_verify_batch_chunks
+ *
+ * \details Test a batch verified in several chunks, with bad entries in each
+ */
+BOOST_AUTO_TEST_CASE(test_verify_batch_chunks) {
+  Schnorr& schnorr = Schnorr::GetInstance();
+
+  const unsigned int batch_size = 150;
+  vector<bytes> messages;
+  vector<Signature> signatures;
+  vector<PubKey> pubkeys;
+
+  for (unsigned int i = 0; i < batch_size; i++) {
+    PairOfKey keypair = schnorr.GenKeyPair();
+    bytes message(64);
+    generate(message.begin(), message.end(), std::rand);
+
+    Signature signature;
+    BOOST_CHECK_MESSAGE(
+        schnorr.Sign(message, keypair.first, keypair.second, signature),
+        "Signing failed");
+
+    messages.emplace_back(message);
+    signatures.emplace_back(signature);
+    pubkeys.emplace_back(keypair.second);
+  }
+
+  /// A wrong signature, an empty message and a wrong key, in different chunks
+  signatures.at(3) = signatures.at(4);
+  messages.at(70).clear();
+  pubkeys.at(149) = pubkeys.at(0);
+
+  for (const unsigned int numThreads : {1u, 4u}) {
+    vector<bool> results;
+    BOOST_CHECK_MESSAGE(schnorr.VerifyBatch(messages, signatures, pubkeys,
+                                            results, numThreads) == false,
+                        "Batch verification (three wrong) failed");
+    for (unsigned int i = 0; i < batch_size; i++) {
+      BOOST_CHECK_MESSAGE(results.at(i) == (i != 3 && i != 70 && i != 149),
+                          "Batch verification result " << i << " wrong with "
+                                                       << numThreads
+                                                       << " threads");
+    }
+  }
+}
+
 /**
  * \brief test_performance
  *
@@ -303,6 +414,47 @@ BOOST_AUTO_TEST_CASE(test_serialization) {
   BOOST_CHECK(!SignatureOutput.is_empty(false));
 }
 
+/**
+ * \brief test_pubkey_compare
+ *
+ * \details Test PubKey comparison and hashing on repeatedly decoded keys
+ */
+BOOST_AUTO_TEST_CASE(test_pubkey_compare) {
+  Schnorr& schnorr = Schnorr::GetInstance();
+
+  PubKey key1 = schnorr.GenKeyPair().second;
+  PubKey key2 = schnorr.GenKeyPair().second;
+
+  bytes key1_bytes, key2_bytes;
+  key1.Serialize(key1_bytes, 0);
+  key2.Serialize(key2_bytes, 0);
+
+  /// Decoding the same bytes again has to give an equal key with equal hash
+  PubKey decoded1(key1_bytes, 0);
+  PubKey decoded1Again(key1_bytes, 0);
+  BOOST_CHECK_MESSAGE(decoded1 == key1 && decoded1Again == key1,
+                      "Decoded PubKey differs from original");
+  BOOST_CHECK_MESSAGE(
+      std::hash<PubKey>()(decoded1) == std::hash<PubKey>()(decoded1Again),
+      "Decoded PubKey hashes differ");
+
+  /// Ordering follows the serialized bytes
+  BOOST_CHECK_MESSAGE((key1 < key2) == (key1_bytes < key2_bytes),
+                      "PubKey operator < does not match serialized order");
+  BOOST_CHECK_MESSAGE(!(key1 == key2), "Distinct PubKeys compare equal");
+
+  /// Changing one decoded key must not affect another decoded from the same
+  /// bytes
+  decoded1 = key2;
+  BOOST_CHECK_MESSAGE(decoded1 == key2 && decoded1Again == key1,
+                      "Decoded PubKeys are not independent");
+
+  /// The point at infinity sorts before any real key
+  PubKey empty;
+  BOOST_CHECK_MESSAGE(empty < key1 && !(key1 < empty),
+                      "Empty PubKey ordering failed");
+}
+
 /**
  * \brief test_error_deserialization_pubkey
  *
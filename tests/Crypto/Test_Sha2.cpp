@@ -18,6 +18,7 @@
  */
 
 #include <iomanip>
+#include <random>
 #include "libCrypto/Sha2.h"
 #include "libUtils/DataConversion.h"
 
@@ -107,4 +108,43 @@ BOOST_AUTO_TEST_CASE(SHA256_002_check_896bitsx3_updatewithoffset) {
   BOOST_CHECK_EQUAL(is_equal, true);
 }
 
+/**
+ * \brief SHA256_003_backends_agree
+ *
+ * \details Test that every backend the CPU supports hashes like OpenSSL,
+ * across block boundaries and for input fed in pieces of any size
+ */
+BOOST_AUTO_TEST_CASE(SHA256_003_backends_agree) {
+  mt19937 rng(3);
+
+  for (const auto backend : {Sha256Backend::SHA_NI, Sha256Backend::ARMV8}) {
+    if (!Sha256Backend::IsSupported(backend)) {
+      BOOST_TEST_MESSAGE(Sha256Backend::GetName(backend)
+                         << " not supported, skipped");
+      continue;
+    }
+
+    for (unsigned int size = 0; size < 300; size++) {
+      bytes input(size);
+      for (auto& b : input) {
+        b = rng();
+      }
+
+      SHA2<HASH_TYPE::HASH_VARIANT_256> reference(Sha256Backend::OPENSSL);
+      SHA2<HASH_TYPE::HASH_VARIANT_256> sha2(backend);
+      for (unsigned int pos = 0; pos < size;) {
+        const unsigned int piece =
+            min<unsigned int>(size - pos, rng() % 80 + 1);
+        reference.Update(input.data() + pos, piece);
+        sha2.Update(input.data() + pos, piece);
+        pos += piece;
+      }
+
+      BOOST_CHECK_MESSAGE(sha2.Finalize() == reference.Finalize(),
+                          Sha256Backend::GetName(backend)
+                              << " mismatch for " << size << " bytes");
+    }
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Throughput of each SHA-256 backend the CPU supports, at the input sizes
+// of transaction IDs, block headers and whole messages.
+//
+// Usage: Test_Sha2Benchmark [--megabytes N]
+
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "libCrypto/Sha2.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+namespace po = boost::program_options;
+
+namespace {
+
+/// Nanoseconds per hash of size bytes, over about megabytes of input
+double TimeHashes(Sha256Backend::Kind backend, size_t size,
+                  unsigned int megabytes) {
+  const bytes input(size, 0x5a);
+  const uint64_t numHashes =
+      max<uint64_t>((uint64_t)megabytes * 1024 * 1024 / max<size_t>(size, 1),
+                    1);
+  unsigned char digest[32] = {};
+
+  const auto start = chrono::steady_clock::now();
+  for (uint64_t i = 0; i < numHashes; i++) {
+    SHA2<HASH_TYPE::HASH_VARIANT_256> sha2(backend);
+    // Chain the hashes so that none can be left out
+    sha2.Update(digest, sizeof(digest));
+    sha2.Update(input.data(), input.size());
+    sha2.Finalize(digest);
+  }
+  const auto elapsed = chrono::steady_clock::now() - start;
+
+  return chrono::duration<double, nano>(elapsed).count() / numHashes;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  unsigned int megabytes = 256;
+
+  po::options_description desc("Options");
+  desc.add_options()("help,h", "Print help messages")(
+      "megabytes,m", po::value<unsigned int>(&megabytes),
+      "Input hashed per backend and size");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("help")) {
+      cout << desc << endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (boost::program_options::error& e) {
+    cerr << "ERROR: " << e.what() << endl << endl << desc << endl;
+    return 1;
+  }
+
+  INIT_STDOUT_LOGGER();
+
+  cout << "Default backend: "
+       << Sha256Backend::GetName(Sha256Backend::GetDefault()) << endl;
+  cout << setw(10) << "backend" << setw(10) << "bytes" << setw(14)
+       << "ns/hash" << setw(10) << "MB/s" << endl;
+
+  for (const auto backend : {Sha256Backend::OPENSSL, Sha256Backend::SHA_NI,
+                             Sha256Backend::ARMV8}) {
+    if (!Sha256Backend::IsSupported(backend)) {
+      cout << setw(10) << Sha256Backend::GetName(backend)
+           << "  not supported" << endl;
+      continue;
+    }
+
+    for (const size_t size : {0, 64, 256, 1024, 65536}) {
+      const double nanos = TimeHashes(backend, size, megabytes);
+      cout << setw(10) << Sha256Backend::GetName(backend) << setw(10)
+           << size + 32 << setw(14) << fixed << setprecision(1) << nanos
+           << setw(10) << setprecision(0) << (size + 32) * 1e3 / nanos
+           << endl;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "libData/AccountData/AccountSnapshot.h"
+
+#define BOOST_TEST_MODULE accountsnapshottest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+namespace {
+AccountSnapshot::Changes MakeChanges(const Address& address, uint64_t nonce) {
+  AccountSnapshot::Changes changes;
+  AccountSnapshotEntry& entry = changes[address];
+  entry.m_balance = nonce * 10;
+  entry.m_nonce = nonce;
+  entry.m_exists = true;
+  return changes;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(accountsnapshottest)
+
+BOOST_AUTO_TEST_CASE(Find_NewestVersionWins) {
+  const dev::h256 root(1);
+  const Address a(1), b(2), c(3);
+
+  auto v1 = AccountSnapshot::Rebase(root);
+  auto v2 = AccountSnapshot::Extend(v1, MakeChanges(a, 1));
+  auto v3 = AccountSnapshot::Extend(v2, MakeChanges(a, 2));
+  AccountSnapshot::Changes removed;
+  removed[b];
+  auto v4 = AccountSnapshot::Extend(v3, move(removed));
+
+  AccountSnapshotEntry entry;
+  BOOST_CHECK(!v1->Find(a, entry));
+  BOOST_CHECK(v2->Find(a, entry));
+  BOOST_CHECK_EQUAL(entry.m_nonce, 1);
+  BOOST_CHECK(v4->Find(a, entry));
+  BOOST_CHECK_EQUAL(entry.m_nonce, 2);
+  BOOST_CHECK(entry.m_balance == 20);
+
+  // Removed accounts are found, as not existing
+  BOOST_CHECK(v4->Find(b, entry));
+  BOOST_CHECK(!entry.m_exists);
+  BOOST_CHECK(!v3->Find(b, entry));
+
+  // Left to the trie at the root
+  BOOST_CHECK(!v4->Find(c, entry));
+  BOOST_CHECK(v4->GetRoot() == root);
+}
+
+BOOST_AUTO_TEST_CASE(Extend_MergesPastMaxDepth) {
+  const unsigned int maxDepth = AccountSnapshot::MAX_DEPTH;
+  auto snapshot = AccountSnapshot::Rebase(dev::h256(1));
+  auto first = snapshot;
+
+  for (uint64_t i = 0; i < maxDepth * 3; i++) {
+    snapshot =
+        AccountSnapshot::Extend(snapshot, MakeChanges(Address(i % 5), i));
+    BOOST_CHECK_LE(snapshot->GetDepth(), maxDepth);
+  }
+
+  const uint64_t last = maxDepth * 3 - 1;
+  for (uint64_t i = last - 4; i <= last; i++) {
+    AccountSnapshotEntry entry;
+    BOOST_CHECK(snapshot->Find(Address(i % 5), entry));
+    BOOST_CHECK_EQUAL(entry.m_nonce, i);
+  }
+
+  // Older versions are left as they were
+  AccountSnapshotEntry entry;
+  BOOST_CHECK(!first->Find(Address(0), entry));
+  BOOST_CHECK_EQUAL(first->GetDepth(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -25,6 +25,7 @@
 #include "libData/AccountData/AccountStore.h"
 #include "libData/AccountData/AccountStoreSC.h"
 #include "libData/AccountData/Address.h"
+#include "libMessage/Messenger.h"
 #include "libTestUtils/TestUtils.h"
 #include "libUtils/Logger.h"
 #include "libUtils/SysCommand.h"
@@ -419,6 +420,67 @@ BOOST_AUTO_TEST_CASE(temporaries) {
                     AccountStore::GetInstance().GetNonceTemp(++addr) == 0);
 }
 
+BOOST_AUTO_TEST_CASE(temporariesBatch) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+
+  AccountStore::GetInstance().Init();
+
+  std::vector<PairOfKey> senders;
+  std::vector<Address> senderAddrs;
+  for (unsigned int i = 0; i < 6; i++) {
+    senders.emplace_back(Schnorr::GetInstance().GenKeyPair());
+    senderAddrs.emplace_back(
+        Account::GetAddressFromPublicKey(senders.back().second));
+    AccountStore::GetInstance().AddAccount(senderAddrs.back(), {1000000, 0});
+  }
+
+  // Disjoint transfers, a chain through senders 2 -> 3 -> 4, a transfer to a
+  // new account and one the sender cannot afford
+  std::vector<Transaction> txns;
+  auto addTxn = [&txns](const PairOfKey& sender, const Address& toAddr,
+                        const boost::multiprecision::uint128_t& amount) {
+    txns.emplace_back(DataConversion::Pack(CHAIN_ID, 1), 1, toAddr, sender,
+                      amount, 1, NORMAL_TRAN_GAS, bytes(), bytes());
+  };
+  addTxn(senders[0], senderAddrs[1], 100);
+  addTxn(senders[2], senderAddrs[3], 200);
+  addTxn(senders[3], senderAddrs[4], 300);
+  addTxn(senders[4], Address().random(), 400);
+  addTxn(senders[5], senderAddrs[0], 2000000);
+
+  std::vector<bool> serialResults;
+  for (const auto& txn : txns) {
+    TransactionReceipt tr;
+    serialResults.emplace_back(AccountStore::GetInstance().UpdateAccountsTemp(
+        1, 1, false, txn, tr));
+  }
+  BOOST_CHECK_MESSAGE(AccountStore::GetInstance().SerializeDelta(),
+                      "SerializeDelta failed");
+  auto serialHash = AccountStore::GetInstance().GetStateDeltaHash();
+
+  AccountStore::GetInstance().InitTemp();
+
+  std::vector<TransactionReceipt> receipts;
+  std::vector<bool> results;
+  AccountStore::GetInstance().UpdateAccountsTempBatch(1, 1, false, txns,
+                                                      receipts, results, 4);
+  BOOST_CHECK_MESSAGE(AccountStore::GetInstance().SerializeDelta(),
+                      "SerializeDelta failed");
+
+  BOOST_CHECK_MESSAGE(results == serialResults,
+                      "Batch results differ from serial execution");
+  BOOST_CHECK_MESSAGE(!results.back(), "Unaffordable transfer succeeded");
+  BOOST_CHECK_MESSAGE(
+      AccountStore::GetInstance().GetStateDeltaHash() == serialHash,
+      "Batch state delta differs from serial execution");
+  BOOST_CHECK_EQUAL(1,
+                    AccountStore::GetInstance().GetNonceTemp(senderAddrs[3]));
+
+  AccountStore::GetInstance().InitTemp();
+}
+
 BOOST_AUTO_TEST_CASE(commit) {
   INIT_STDOUT_LOGGER();
 
@@ -684,6 +746,13 @@ BOOST_AUTO_TEST_CASE(stateDelta) {
       AccountStore::GetInstance().GetBalance(address1) == 21,
       "address1 in AccountStore has no balance after deserializing delta");
 
+  // The trie already holds every account changed by the delta
+  auto root = AccountStore::GetInstance().GetStateRootHash();
+  BOOST_CHECK_MESSAGE(root != dev::EmptyTrie, "StateRootHash is empty");
+  AccountStore::GetInstance().UpdateStateTrieAll();
+  BOOST_CHECK_MESSAGE(AccountStore::GetInstance().GetStateRootHash() == root,
+                      "State trie missed accounts of the delta");
+
   if (!SCILLA_ROOT.empty()) {
     CheckRFContract(false, contrAddr1, contrAddr2, codeHash1, codeHash2,
                     contrStateHash1, contrStateHash2, contrCode1, contrCode2,
@@ -691,6 +760,85 @@ BOOST_AUTO_TEST_CASE(stateDelta) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(stateDeltaEntries) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+
+  AccountStore::GetInstance().Init();
+
+  std::vector<Address> addresses;
+  for (unsigned int i = 0; i < 10; i++) {
+    addresses.emplace_back(Account::GetAddressFromPublicKey(
+        Schnorr::GetInstance().GenKeyPair().second));
+    AccountStore::GetInstance().AddAccountTemp(addresses.back(),
+                                               {i + 1, 0});
+  }
+
+  BOOST_CHECK_MESSAGE(AccountStore::GetInstance().SerializeDelta(),
+                      "SerializeDelta failed");
+  bytes rawdelta;
+  AccountStore::GetInstance().GetSerializedDelta(rawdelta);
+
+  // Entries are read back one at a time
+  std::unordered_map<Address, boost::multiprecision::int256_t> accountMap;
+  BOOST_CHECK(Messenger::StateDeltaToAddressMap(rawdelta, 0, accountMap));
+  BOOST_CHECK_EQUAL(addresses.size(), accountMap.size());
+  for (unsigned int i = 0; i < addresses.size(); i++) {
+    BOOST_CHECK_EQUAL(i + 1, accountMap[addresses[i]]);
+  }
+
+  // A delta cut short in its last entry is rejected
+  bytes truncated(rawdelta.begin(), rawdelta.end() - 1);
+  AccountStore::GetInstance().InitTemp();
+  BOOST_CHECK(!AccountStore::GetInstance().DeserializeDeltaTemp(truncated, 0));
+
+  AccountStore::GetInstance().InitTemp();
+  BOOST_CHECK(AccountStore::GetInstance().DeserializeDeltaTemp(rawdelta, 0));
+  BOOST_CHECK_EQUAL(10, AccountStore::GetInstance().GetAccountTemp(
+                            addresses.back())->GetBalance());
+  AccountStore::GetInstance().InitTemp();
+}
+
+BOOST_AUTO_TEST_CASE(stateChunks) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+
+  AccountStore::GetInstance().Init();
+
+  for (unsigned int i = 0; i < 50; i++) {
+    AccountStore::GetInstance().AddAccountTemp(
+        Account::GetAddressFromPublicKey(
+            Schnorr::GetInstance().GenKeyPair().second),
+        {i + 1, 0});
+  }
+  BOOST_CHECK(AccountStore::GetInstance().SerializeDelta());
+  bytes rawdelta;
+  AccountStore::GetInstance().GetSerializedDelta(rawdelta);
+  BOOST_CHECK(AccountStore::GetInstance().DeserializeDelta(rawdelta, 0));
+  AccountStore::GetInstance().InitTemp();
+
+  const unsigned int NUM_CHUNKS = 4;
+  std::vector<bytes> chunks(NUM_CHUNKS);
+  dev::h256 stateRoot;
+  for (unsigned int i = 0; i < NUM_CHUNKS; i++) {
+    BOOST_CHECK(AccountStore::GetInstance().SerializeChunk(
+        chunks[i], 0, i, NUM_CHUNKS, stateRoot));
+  }
+  BOOST_CHECK(!AccountStore::GetInstance().SerializeChunk(
+      chunks[0], 0, NUM_CHUNKS, NUM_CHUNKS, stateRoot));
+  BOOST_CHECK_EQUAL(stateRoot, AccountStore::GetInstance().GetStateRootHash());
+
+  // The chunks applied in any order add up to the whole state
+  AccountStore::GetInstance().Init();
+  for (unsigned int i = NUM_CHUNKS; i > 0; i--) {
+    BOOST_CHECK(AccountStore::GetInstance().DeserializeChunk(chunks[i - 1], 0));
+  }
+  BOOST_CHECK_EQUAL(stateRoot, AccountStore::GetInstance().GetStateRootHash());
+  BOOST_CHECK_EQUAL(50, AccountStore::GetInstance().GetNumOfAccounts());
+}
+
 BOOST_AUTO_TEST_CASE(commitRevertible) {
   INIT_STDOUT_LOGGER();
 
@@ -789,6 +937,45 @@ BOOST_AUTO_TEST_CASE(commitRevertible2) {
                       "StateRootHash didn't revert");
 }
 
+BOOST_AUTO_TEST_CASE(revertibleDeltas) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+
+  AccountStore::GetInstance().Init();
+
+  PubKey pubKey1 = Schnorr::GetInstance().GenKeyPair().second;
+  Address address1 = Account::GetAddressFromPublicKey(pubKey1);
+
+  Account account1(21, 211);
+  AccountStore::GetInstance().AddAccountTemp(address1, account1);
+  AccountStore::GetInstance().SerializeDelta();
+  AccountStore::GetInstance().CommitTemp();
+  AccountStore::GetInstance().InitTemp();
+  auto root1 = AccountStore::GetInstance().GetStateRootHash();
+
+  // Two deltas on the same account, the journal keeps it as before the first
+  AccountStore::GetInstance().InitRevertibles();
+  for (unsigned int i = 0; i < 2; i++) {
+    AccountStore::GetInstance().IncreaseBalanceTemp(address1, 1);
+    AccountStore::GetInstance().SerializeDelta();
+    bytes delta;
+    AccountStore::GetInstance().GetSerializedDelta(delta);
+    BOOST_CHECK_MESSAGE(
+        AccountStore::GetInstance().DeserializeDelta(delta, 0, true),
+        "DeserializeDelta failed");
+    AccountStore::GetInstance().InitTemp();
+  }
+  BOOST_CHECK_MESSAGE(AccountStore::GetInstance().GetBalance(address1) == 23,
+                      "address1 balance didn't change after the deltas");
+
+  AccountStore::GetInstance().RevertCommitTemp();
+  BOOST_CHECK_MESSAGE(AccountStore::GetInstance().GetBalance(address1) == 21,
+                      "address1 in AccountStore balance didn't revert");
+  BOOST_CHECK_MESSAGE(AccountStore::GetInstance().GetStateRootHash() == root1,
+                      "StateRootHash didn't revert");
+}
+
 BOOST_AUTO_TEST_CASE(DiskOperation) {
   INIT_STDOUT_LOGGER();
 
@@ -0,0 +1,108 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#define BOOST_TEST_MODULE addrnoncetxnqueuetest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "libData/AccountData/AddrNonceTxnQueue.h"
+#include "libTestUtils/TestUtils.h"
+#include "libUtils/Logger.h"
+
+using namespace boost::multiprecision;
+
+Transaction createTransaction(const uint128_t& gasPrice,
+                              const PubKey& senderPubKey,
+                              const uint64_t& nonce) {
+  return Transaction(
+      TestUtils::DistUint32(), nonce, Address().random(), senderPubKey,
+      TestUtils::DistUint128(), gasPrice, TestUtils::DistUint64(),
+      TestUtils::GenerateRandomCharVector(TestUtils::DistUint8()),
+      TestUtils::GenerateRandomCharVector(TestUtils::DistUint8()),
+      TestUtils::GenerateRandomSignature());
+}
+
+BOOST_AUTO_TEST_SUITE(addrnoncetxnqueuetest)
+
+BOOST_AUTO_TEST_CASE(test_ready_order) {
+  INIT_STDOUT_LOGGER();
+
+  TestUtils::Initialize();
+
+  AddrNonceTxnQueue queue;
+  Transaction t;
+
+  const PubKey keyA = TestUtils::GenerateRandomPubKey();
+  const PubKey keyB = TestUtils::GenerateRandomPubKey();
+  const Address addrA = Address().random();
+  const Address addrB = Address().random();
+
+  // Sender A is at nonce 1, so txns with nonces 3 and 4 have to wait
+  queue.Insert(addrA, createTransaction(10, keyA, 3), 2);
+  queue.Insert(addrA, createTransaction(10, keyA, 4), 2);
+  BOOST_CHECK(queue.Contains(addrA));
+  BOOST_CHECK(!queue.PopReady(t));
+
+  // A second txn at the same nonce only replaces one with a lower gas price
+  queue.Insert(addrA, createTransaction(5, keyA, 3), 2);
+  queue.Insert(addrA, createTransaction(20, keyA, 3), 2);
+
+  // Sender B is ready straight away, but with a lower gas price than A
+  queue.Insert(addrB, createTransaction(15, keyB, 7), 7);
+  queue.Refresh(addrA, 3);
+
+  BOOST_REQUIRE(queue.PopReady(t));
+  BOOST_CHECK_EQUAL(t.GetNonce(), 3);
+  BOOST_CHECK_EQUAL(t.GetGasPrice(), 20);
+
+  // A is not ready again until its nonce is reported to have advanced
+  BOOST_REQUIRE(queue.PopReady(t));
+  BOOST_CHECK_EQUAL(t.GetNonce(), 7);
+  BOOST_CHECK(!queue.Contains(addrB));
+  BOOST_CHECK(!queue.PopReady(t));
+
+  queue.Refresh(addrA, 4);
+  BOOST_REQUIRE(queue.PopReady(t));
+  BOOST_CHECK_EQUAL(t.GetNonce(), 4);
+  BOOST_CHECK(!queue.Contains(addrA));
+}
+
+BOOST_AUTO_TEST_CASE(test_for_each) {
+  INIT_STDOUT_LOGGER();
+
+  TestUtils::Initialize();
+
+  AddrNonceTxnQueue queue;
+
+  const PubKey key = TestUtils::GenerateRandomPubKey();
+  const Address addr = Address().random();
+  for (uint64_t nonce = 5; nonce < 10; nonce++) {
+    queue.Insert(addr, createTransaction(1, key, nonce), 1);
+  }
+
+  unsigned int count = 0;
+  queue.ForEach([&count](const Transaction&) { count++; });
+  BOOST_CHECK_EQUAL(count, 5);
+
+  queue.clear();
+  count = 0;
+  queue.ForEach([&count](const Transaction&) { count++; });
+  BOOST_CHECK_EQUAL(count, 0);
+  BOOST_CHECK(!queue.Contains(addr));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,128 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <set>
+#include <vector>
+
+#define BOOST_TEST_MODULE stripedmaptest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "libData/AccountData/AccountStoreBase.h"
+#include "libData/AccountData/StripedMap.h"
+#include "libUtils/JoinableFunction.h"
+#include "libUtils/Logger.h"
+
+/// Exposes the protected constructor of AccountStoreBase
+class StripedAccountStore
+    : public AccountStoreBase<StripedMap<Address, Account>> {};
+
+BOOST_AUTO_TEST_SUITE(stripedmaptest)
+
+BOOST_AUTO_TEST_CASE(test_map_interface) {
+  INIT_STDOUT_LOGGER();
+
+  StripedMap<Address, Account> accounts;
+  BOOST_CHECK(accounts.empty());
+  BOOST_CHECK(accounts.begin() == accounts.end());
+
+  std::set<Address> addresses;
+  for (unsigned int i = 0; i < 100; i++) {
+    addresses.emplace(Address().random());
+  }
+
+  for (const auto& address : addresses) {
+    BOOST_CHECK(accounts.insert({address, Account(1, 0)}).second);
+  }
+  BOOST_CHECK(!accounts.emplace(*addresses.begin(), 2, 0).second);
+  BOOST_CHECK_EQUAL(addresses.size(), accounts.size());
+
+  // Pointers survive inserts into the same stripe
+  Account* first = &accounts.find(*addresses.begin())->second;
+  for (unsigned int i = 0; i < 1000; i++) {
+    accounts[Address().random()] = Account(3, 0);
+  }
+  BOOST_CHECK_EQUAL(first, &accounts.find(*addresses.begin())->second);
+  BOOST_CHECK_EQUAL(1, first->GetBalance());
+
+  // Iteration visits every element once
+  std::set<Address> visited;
+  for (const auto& entry : accounts) {
+    BOOST_CHECK(visited.emplace(entry.first).second);
+  }
+  BOOST_CHECK_EQUAL(accounts.size(), visited.size());
+
+  for (const auto& address : addresses) {
+    BOOST_CHECK_EQUAL(1, accounts.erase(address));
+    BOOST_CHECK(accounts.find(address) == accounts.end());
+  }
+  BOOST_CHECK_EQUAL(visited.size() - addresses.size(), accounts.size());
+
+  accounts.clear();
+  BOOST_CHECK(accounts.empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_concurrent_updates) {
+  INIT_STDOUT_LOGGER();
+
+  const unsigned int NUM_THREADS = 8;
+  const unsigned int NUM_PER_THREAD = 500;
+
+  std::vector<std::vector<Address>> addresses(NUM_THREADS);
+  for (auto& threadAddresses : addresses) {
+    for (unsigned int i = 0; i < NUM_PER_THREAD; i++) {
+      threadAddresses.emplace_back(Address().random());
+    }
+  }
+
+  StripedAccountStore store;
+  store.Init();
+
+  std::atomic<unsigned int> next{0};
+  auto worker = [&]() -> void {
+    const auto& threadAddresses = addresses[next++];
+    for (const auto& address : threadAddresses) {
+      store.AddAccount(address, {10, 0});
+      store.IncreaseBalance(address, 5);
+      store.IncreaseNonce(address);
+    }
+  };
+
+  {
+    JoinableFunction joinableFunc(NUM_THREADS, worker);
+  }
+
+  BOOST_CHECK_EQUAL(NUM_THREADS * NUM_PER_THREAD, store.GetNumOfAccounts());
+  for (const auto& threadAddresses : addresses) {
+    for (const auto& address : threadAddresses) {
+      BOOST_CHECK_EQUAL(15, store.GetBalance(address));
+      BOOST_CHECK_EQUAL(1, store.GetNonce(address));
+    }
+  }
+
+  // Serializes like the other MAPs
+  bytes dst;
+  BOOST_CHECK(store.Serialize(dst, 0));
+  StripedAccountStore copy;
+  copy.Init();
+  BOOST_CHECK(copy.Deserialize(dst, 0));
+  BOOST_CHECK_EQUAL(store.GetNumOfAccounts(), copy.GetNumOfAccounts());
+  BOOST_CHECK_EQUAL(15, copy.GetBalance(addresses[0][0]));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -195,6 +195,47 @@ BOOST_AUTO_TEST_CASE(testOperators) {
   BOOST_CHECK_MESSAGE(tx1 < tx3, "Less-than operator failed");
 }
 
+BOOST_AUTO_TEST_CASE(testSerializedCoreInfo) {
+  INIT_STDOUT_LOGGER();
+  LOG_MARKER();
+
+  PairOfKey sender = Schnorr::GetInstance().GenKeyPair();
+  Address toAddr = Account::GetAddressFromPublicKey(
+      Schnorr::GetInstance().GenKeyPair().second);
+  Transaction tx1(DataConversion::Pack(CHAIN_ID, 1), 5, toAddr, sender, 100,
+                  PRECISION_MIN_VALUE, 88, {0x01, 0x02}, {0x03});
+  BOOST_CHECK_MESSAGE(!tx1.GetSerializedCoreInfo().empty(),
+                      "Core fields not kept after signing");
+
+  // A transaction without the kept bytes encodes the same core fields
+  Transaction plain(tx1.GetTranID(), tx1.GetCoreInfo(), tx1.GetSignature());
+  BOOST_CHECK(plain.GetSerializedCoreInfo().empty());
+  bytes plainCoreInfo;
+  BOOST_CHECK(plain.SerializeCoreFields(plainCoreInfo, 0));
+  BOOST_CHECK(plainCoreInfo == tx1.GetSerializedCoreInfo());
+
+  bytes message1, message2, plainMessage;
+  BOOST_CHECK(tx1.Serialize(message1, 0));
+  BOOST_CHECK(plain.Serialize(plainMessage, 0));
+  BOOST_CHECK(message1 == plainMessage);
+
+  Transaction tx2(message1, 0);
+  BOOST_CHECK(tx2 == tx1);
+  BOOST_CHECK(tx2.GetSerializedCoreInfo() == tx1.GetSerializedCoreInfo());
+  BOOST_CHECK(tx2.Serialize(message2, 0));
+  BOOST_CHECK(message2 == message1);
+
+  // Kept bytes are written at the offset like the encoded ones
+  bytes withOffset(3, 0xFF);
+  BOOST_CHECK(tx2.SerializeCoreFields(withOffset, 3));
+  BOOST_CHECK(bytes(withOffset.begin() + 3, withOffset.end()) ==
+              tx1.GetSerializedCoreInfo());
+
+  Transaction tx3;
+  tx3 = tx2;
+  BOOST_CHECK(tx3.GetSerializedCoreInfo() == tx1.GetSerializedCoreInfo());
+}
+
 // Coverage of MBnForwardedTxnEntry
 BOOST_AUTO_TEST_CASE(coveragembnforwardedtxnentry) {
   INIT_STDOUT_LOGGER();
@@ -22,6 +22,7 @@
 #define BOOST_TEST_DYN_LINK
 #include <boost/test/unit_test.hpp>
 
+#include "libData/AccountData/ReceiptEncoding.h"
 #include "libData/AccountData/TransactionReceipt.h"
 #include "libTestUtils/TestUtils.h"
 #include "libUtils/DataConversion.h"
@@ -65,7 +66,11 @@ BOOST_AUTO_TEST_CASE(transactionreceipt) {
 
   std::string tranReceiptStr = "{\"a\":1}";
   tr.SetString(tranReceiptStr);
-  BOOST_CHECK_EQUAL(true, tr.GetString().compare(tranReceiptStr) == 0);
+  std::string tranReceiptStr_1 = tr.GetString();
+  tranReceiptStr_1.erase(
+      remove_if(tranReceiptStr_1.begin(), tranReceiptStr_1.end(), isspace),
+      tranReceiptStr_1.end());
+  BOOST_CHECK_EQUAL(true, tranReceiptStr_1.compare(tranReceiptStr) == 0);
 
   LogEntry entry;
   tr.AddEntry(entry);
@@ -103,6 +108,53 @@ BOOST_AUTO_TEST_CASE(transactionreceipt) {
   BOOST_CHECK_EQUAL(true, tr_2.GetCumGas() == cumGas);
 }
 
+BOOST_AUTO_TEST_CASE(receiptencoding) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+
+  Json::Value param;
+  param["vname"] = "to";
+  param["type"] = "ByStr20";
+  param["value"] = "0x0123456789abcdef0123456789abcdef01234567";
+  Json::Value eventObj;
+  eventObj["_eventname"] = "Transfer";
+  eventObj["address"] = "0xABCDEF";
+  eventObj["params"].append(param);
+
+  Json::Value receiptObj;
+  receiptObj["success"] = true;
+  receiptObj["cumulative_gas"] = "18446744073709551615";
+  receiptObj["epoch_num"] = "007";
+  receiptObj["event_logs"].append(eventObj);
+  receiptObj["errors"]["1"].append(7);
+  receiptObj["other"] = -3;
+  receiptObj["real"] = 0.5;
+  receiptObj["none"] = Json::nullValue;
+
+  bytes encoded;
+  BOOST_CHECK(ReceiptEncoding::Encode(receiptObj, encoded));
+  BOOST_CHECK(encoded.at(0) == ReceiptEncoding::VERSION);
+
+  Json::Value decoded;
+  BOOST_CHECK(ReceiptEncoding::Decode(encoded, decoded));
+  BOOST_CHECK(decoded == receiptObj);
+
+  // The same json gives the same bytes, whatever order it was built in
+  Json::Value reordered;
+  for (const auto& name : receiptObj.getMemberNames()) {
+    reordered[name] = decoded[name];
+  }
+  bytes reencoded;
+  BOOST_CHECK(ReceiptEncoding::Encode(reordered, reencoded));
+  BOOST_CHECK(reencoded == encoded);
+
+  BOOST_CHECK(!ReceiptEncoding::Decode(bytes(encoded.begin(), encoded.end() - 1),
+                                      decoded));
+  encoded.at(0) = ReceiptEncoding::VERSION + 1;
+  BOOST_CHECK(!ReceiptEncoding::Decode(encoded, decoded));
+}
+
 BOOST_AUTO_TEST_CASE(transactionwithreceipt) {
   INIT_STDOUT_LOGGER();
 
@@ -118,9 +170,9 @@ BOOST_AUTO_TEST_CASE(transactionwithreceipt) {
   SHA2<HASH_TYPE::HASH_VARIANT_256> sha2;
 
   for (const auto& ts : transactionStrings) {
-    sha2.Update(DataConversion::StringToCharArray(ts.c_str()));
     tr = TransactionReceipt();
     tr.SetString(ts);
+    sha2.Update(tr.GetBytes());
     txrs.emplace_back(tran, tr);
   }
   TxnHash hash = TxnHash(sha2.Finalize());
@@ -173,4 +173,131 @@ BOOST_AUTO_TEST_CASE(txnpool) {
   BOOST_CHECK_EQUAL(false, tp.findOne(transactionTest));
 }
 
+BOOST_AUTO_TEST_CASE(txnpool_gas_order) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+
+  TestUtils::Initialize();
+
+  // Prices on both sides of 2^64, with ties broken by the lower hash
+  const uint128_t high = (uint128_t(1) << 64) + 5;
+  std::vector<Transaction> expected;
+  auto addExpected = [&expected](const uint128_t& gasPrice,
+                                 const TxnHash& tranID) {
+    expected.emplace_back(createTransaction(
+        gasPrice, tranID, TestUtils::GenerateRandomPubKey(), 1));
+  };
+
+  TxnHash lowHash, highHash;
+  lowHash.asArray()[0] = 1;
+  highHash.asArray()[0] = 2;
+  addExpected(high, lowHash);
+  addExpected(high, highHash);
+  addExpected(uint128_t(1) << 64, TxnHash().random());
+  addExpected(UINT64_MAX, TxnHash().random());
+  addExpected(6, TxnHash().random());
+
+  TxnPool tp;
+  uint128_t gasLimitTotal = 0;
+  for (auto it = expected.rbegin(); it != expected.rend(); it++) {
+    BOOST_CHECK_EQUAL(true, tp.insert(*it));
+    gasLimitTotal += it->GetGasLimit();
+  }
+  BOOST_CHECK_EQUAL(gasLimitTotal, tp.GasLimitTotal);
+
+  Transaction t;
+  for (const auto& e : expected) {
+    BOOST_CHECK_EQUAL(true, tp.findOne(t));
+    BOOST_CHECK_EQUAL(e.GetTranID(), t.GetTranID());
+    gasLimitTotal -= t.GetGasLimit();
+    BOOST_CHECK_EQUAL(gasLimitTotal, tp.GasLimitTotal);
+  }
+  BOOST_CHECK_EQUAL(false, tp.findOne(t));
+}
+
+BOOST_AUTO_TEST_CASE(txnpool_copy) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+
+  TestUtils::Initialize();
+
+  TxnPool tp;
+
+  std::vector<Transaction> transaction_v;
+  generateUniqueTransactionVector(transaction_v, TestUtils::Dist1to99() + 1);
+  for (auto& t : transaction_v) {
+    BOOST_CHECK_EQUAL(true, tp.insert(t));
+  }
+
+  // ============================================================
+  // A copy has its own indexes, so draining it leaves the original intact
+  // ============================================================
+  TxnPool copy = tp;
+  BOOST_CHECK_EQUAL(tp.size(), copy.size());
+
+  Transaction transactionTest;
+  uint size = copy.size();
+  for (uint i = 0; i < size; i++) {
+    BOOST_CHECK_EQUAL(true, copy.findOne(transactionTest));
+    BOOST_CHECK_EQUAL(true, tp.exist(transactionTest.GetTranID()));
+  }
+  BOOST_CHECK_EQUAL(false, copy.findOne(transactionTest));
+  BOOST_CHECK_EQUAL(transaction_v.size(), tp.size());
+
+  // ============================================================
+  // Moving keeps the indexes pointing at the moved transactions
+  // ============================================================
+  copy = std::move(tp);
+  for (uint i = 0; i < size; i++) {
+    BOOST_CHECK_EQUAL(true, copy.findOne(transactionTest));
+  }
+  BOOST_CHECK_EQUAL(false, copy.findOne(transactionTest));
+
+  // ============================================================
+  // Taking by hash removes the transaction from every index
+  // ============================================================
+  copy = TxnPool();
+  for (auto& t : transaction_v) {
+    BOOST_CHECK_EQUAL(true, copy.insert(t));
+  }
+  const TxnHash firstHash = transaction_v.front().GetTranID();
+  BOOST_CHECK_EQUAL(true, copy.take(firstHash, transactionTest));
+  BOOST_CHECK_EQUAL(true, transactionTest == transaction_v.front());
+  BOOST_CHECK_EQUAL(false, copy.take(firstHash, transactionTest));
+  for (uint i = 1; i < size; i++) {
+    BOOST_CHECK_EQUAL(true, copy.findOne(transactionTest));
+    BOOST_CHECK_EQUAL(false, transactionTest == transaction_v.front());
+  }
+  BOOST_CHECK_EQUAL(false, copy.findOne(transactionTest));
+}
+
+BOOST_AUTO_TEST_CASE(pooled_transaction) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+
+  TestUtils::Initialize();
+
+  // ============================================================
+  // The pooled form gives back every field of the transaction
+  // ============================================================
+  for (unsigned int i = 0; i < 10; i++) {
+    const Transaction t = generateUniqueTransaction();
+    const Transaction rebuilt = PooledTransaction(t).ToTransaction();
+
+    BOOST_CHECK_EQUAL(true, rebuilt == t);
+    BOOST_CHECK_EQUAL(t.GetVersion(), rebuilt.GetVersion());
+    BOOST_CHECK_EQUAL(t.GetNonce(), rebuilt.GetNonce());
+    BOOST_CHECK_EQUAL(t.GetToAddr(), rebuilt.GetToAddr());
+    BOOST_CHECK_EQUAL(t.GetSenderPubKey(), rebuilt.GetSenderPubKey());
+    BOOST_CHECK_EQUAL(t.GetAmount(), rebuilt.GetAmount());
+    BOOST_CHECK_EQUAL(t.GetGasPrice(), rebuilt.GetGasPrice());
+    BOOST_CHECK_EQUAL(t.GetGasLimit(), rebuilt.GetGasLimit());
+    BOOST_CHECK(t.GetCode() == rebuilt.GetCode());
+    BOOST_CHECK(t.GetData() == rebuilt.GetData());
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -16,7 +16,9 @@
  */
 
 #include <array>
+#include <atomic>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "libCrypto/Sha2.h"
@@ -233,4 +235,47 @@ BOOST_AUTO_TEST_CASE(TxBlockChain_test) {
   test_BlockChain(txbc, txb_0, txb_1, lastBlock, txb_empty);
 }
 
+BOOST_AUTO_TEST_CASE(BlockChain_ptr_test) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+
+  DSBlockChain dsbc;
+  BOOST_CHECK_MESSAGE(*dsbc.GetLastBlockPtr() == DSBlock(),
+                      "Dummy block not returned by an empty chain.\n");
+
+  const uint64_t numBlocks = BLOCKCHAIN_SIZE;
+  atomic<bool> stop(false);
+  atomic<bool> consistent(true);
+
+  // Readers must always see a whole block, and find the last one by number
+  thread reader([&dsbc, &stop, &consistent]() {
+    while (!stop) {
+      const auto lastBlock = dsbc.GetLastBlockPtr();
+      const uint64_t blockNum = lastBlock->GetHeader().GetBlockNum();
+      if (blockNum == INIT_BLOCK_NUMBER) {
+        continue;
+      }
+      if (dsbc.GetBlockCount() < blockNum + 1 ||
+          dsbc.GetBlockPtr(blockNum) != lastBlock) {
+        consistent = false;
+      }
+    }
+  });
+
+  for (uint64_t i = 0; i < numBlocks; i++) {
+    DSBlock block(TestUtils::createDSBlockHeader(i), CoSignatures());
+    BOOST_CHECK_MESSAGE(dsbc.AddBlock(block) == 1, "Unable to add block.\n");
+  }
+  stop = true;
+  reader.join();
+
+  BOOST_CHECK_MESSAGE(consistent, "Reader saw an inconsistent chain.\n");
+  BOOST_CHECK_MESSAGE(
+      dsbc.GetBlockPtr(numBlocks - 1) == dsbc.GetLastBlockPtr(),
+      "Last block not shared by GetBlockPtr and GetLastBlockPtr.\n");
+  BOOST_CHECK_MESSAGE(*dsbc.GetLastBlockPtr() == dsbc.GetLastBlock(),
+                      "GetLastBlock differs from GetLastBlockPtr.\n");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -421,4 +421,29 @@ BOOST_AUTO_TEST_CASE(TxBlock_test) {
       "expected: " << headerhashStr << " actual: " << dsblockheader2str);
 }
 
+BOOST_AUTO_TEST_CASE(BlockHeader_cached_hash_test) {
+  TxBlockHeader header;
+  const BlockHash hashBefore = header.GetMyHash();
+  BOOST_CHECK(header.GetMyHash() == hashBefore);
+
+  // A copy keeps the hash, and a change to the header drops it
+  TxBlockHeader copied = header;
+  BlockHash prevHash;
+  prevHash.asArray().at(0) = 1;
+  header.SetPrevHash(prevHash);
+  BOOST_CHECK(copied.GetMyHash() == hashBefore);
+  BOOST_CHECK(header.GetMyHash() != hashBefore);
+
+  bytes serialized;
+  BOOST_CHECK(header.Serialize(serialized, 0));
+  TxBlockHeader deserialized;
+  BOOST_CHECK(deserialized.GetMyHash() == hashBefore);
+  BOOST_CHECK(deserialized.Deserialize(serialized, 0));
+  BOOST_CHECK(deserialized.GetMyHash() == header.GetMyHash());
+
+  bytes cached{0x01, 0x02};
+  BOOST_CHECK(header.SerializeCached(cached, 2));
+  BOOST_CHECK(bytes(cached.begin() + 2, cached.end()) == serialized);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,86 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+
+#define BOOST_TEST_MODULE eventbloomtest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+#include "libData/AccountData/EventBloom.h"
+#include "libData/AccountData/TransactionReceipt.h"
+
+BOOST_AUTO_TEST_SUITE(eventbloomtest)
+
+namespace {
+Address MakeAddress(unsigned char last) {
+  Address addr;
+  addr[Address::size - 1] = last;
+  return addr;
+}
+
+LogEntry MakeLogEntry(const std::string& eventName, const Address& addr) {
+  Json::Value eventObj;
+  eventObj["_eventname"] = eventName;
+  eventObj["params"] = Json::arrayValue;
+  LogEntry entry;
+  BOOST_REQUIRE(entry.Install(eventObj, addr));
+  return entry;
+}
+}  // namespace
+
+BOOST_AUTO_TEST_CASE(test_bloom_membership) {
+  INIT_STDOUT_LOGGER();
+
+  EventBloom bloom;
+  BOOST_CHECK(bloom.Empty());
+
+  bloom.Add(MakeAddress(1), "Transfer");
+  BOOST_CHECK(!bloom.Empty());
+  BOOST_CHECK(bloom.MayContain(MakeAddress(1), ""));
+  BOOST_CHECK(bloom.MayContain(MakeAddress(1), "Transfer"));
+  // An empty bloom holds nothing, and with a single item the other probes
+  // only collide with negligible odds
+  BOOST_CHECK(!EventBloom().MayContain(MakeAddress(1), ""));
+  BOOST_CHECK(!bloom.MayContain(MakeAddress(2), ""));
+  BOOST_CHECK(!bloom.MayContain(MakeAddress(1), "Mint"));
+
+  EventBloom other;
+  other.Add(MakeAddress(2), "Mint");
+  bloom |= other;
+  BOOST_CHECK(bloom.MayContain(MakeAddress(1), "Transfer"));
+  BOOST_CHECK(bloom.MayContain(MakeAddress(2), "Mint"));
+}
+
+BOOST_AUTO_TEST_CASE(test_receipt_bloom) {
+  INIT_STDOUT_LOGGER();
+
+  TransactionReceipt receipt;
+  receipt.AddEntry(MakeLogEntry("Transfer", MakeAddress(1)));
+  receipt.update();
+  BOOST_CHECK(receipt.GetEventBloom().MayContain(MakeAddress(1), "Transfer"));
+
+  // Read back receipts rebuild the bloom from their event logs
+  TransactionReceipt readBack;
+  readBack.SetString(receipt.GetString());
+  BOOST_CHECK(readBack.GetEventBloom().GetBits() ==
+              receipt.GetEventBloom().GetBits());
+
+  receipt.clear();
+  BOOST_CHECK(receipt.GetEventBloom().Empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
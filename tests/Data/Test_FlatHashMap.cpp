@@ -0,0 +1,132 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include "depends/common/FixedHash.h"
+#include "libData/DataStructures/FlatHashMap.h"
+
+#define BOOST_TEST_MODULE flathashmaptest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+using Key = dev::h160;
+
+static Key RandomKey(mt19937_64& rng) {
+  Key key;
+  for (unsigned int i = 0; i < Key::size; i++) {
+    key[i] = rng();
+  }
+  return key;
+}
+
+BOOST_AUTO_TEST_SUITE(flathashmaptest)
+
+BOOST_AUTO_TEST_CASE(MatchesUnorderedMap) {
+  mt19937_64 rng(1);
+  vector<Key> keys;
+  for (unsigned int i = 0; i < 2000; i++) {
+    keys.emplace_back(RandomKey(rng));
+  }
+
+  FixedHashMap<Key, string> map;
+  unordered_map<Key, string> expected;
+
+  for (unsigned int i = 0; i < 100000; i++) {
+    const Key& key = keys[rng() % keys.size()];
+    switch (rng() % 4) {
+      case 0: {
+        const auto result = map.insert({key, to_string(i)});
+        const auto check = expected.insert({key, to_string(i)});
+        BOOST_CHECK_EQUAL(result.second, check.second);
+        BOOST_CHECK_EQUAL(result.first->second, check.first->second);
+        break;
+      }
+      case 1:
+        BOOST_CHECK_EQUAL(map.erase(key), expected.erase(key));
+        break;
+      case 2:
+        map[key] += "x";
+        expected[key] += "x";
+        break;
+      default:
+        BOOST_CHECK_EQUAL(map.count(key), expected.count(key));
+        break;
+    }
+  }
+
+  BOOST_CHECK_EQUAL(map.size(), expected.size());
+  size_t visited = 0;
+  for (const auto& entry : map) {
+    BOOST_CHECK_EQUAL(entry.second, expected.at(entry.first));
+    visited++;
+  }
+  BOOST_CHECK_EQUAL(visited, expected.size());
+
+  const FixedHashMap<Key, string> copy(map);
+  BOOST_CHECK_EQUAL(copy.size(), expected.size());
+  for (const auto& entry : expected) {
+    BOOST_CHECK_EQUAL(copy.at(entry.first), entry.second);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(ReferencesStayValid) {
+  mt19937_64 rng(2);
+  FixedHashMap<Key, unsigned int> map;
+
+  const Key first = RandomKey(rng);
+  unsigned int* value = &map[first];
+  *value = 1;
+
+  for (unsigned int i = 0; i < 10000; i++) {
+    map.emplace(RandomKey(rng), i);
+  }
+
+  BOOST_CHECK_EQUAL(value, &map.find(first)->second);
+  BOOST_CHECK_EQUAL(*value, 1);
+}
+
+BOOST_AUTO_TEST_CASE(EraseWhileIterating) {
+  mt19937_64 rng(3);
+  FixedHashMap<Key, unsigned int> map;
+  for (unsigned int i = 0; i < 1000; i++) {
+    map.emplace(RandomKey(rng), i);
+  }
+
+  for (auto it = map.begin(); it != map.end();) {
+    if (it->second % 2 == 1) {
+      it = map.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  BOOST_CHECK_EQUAL(map.size(), 500);
+  for (const auto& entry : map) {
+    BOOST_CHECK_EQUAL(entry.second % 2, 0);
+  }
+
+  map.clear();
+  BOOST_CHECK(map.empty());
+  BOOST_CHECK(map.begin() == map.end());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,329 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// End-to-end latency of deploying and calling a fungible token through
+// AccountStoreSC::UpdateAccounts, with a balances map of growing size. The
+// time of each transaction is split into the phases that ContractProfiler
+// observes: exporting the interpreter inputs, running the interpreter,
+// parsing its output and persisting the new states; what remains is the
+// account and trie work around them. Running the interpreter is split again
+// into the launch of a process, measured from an interpreter run that does
+// nothing, and the interpretation itself.
+//
+// Needs SCILLA_ROOT and the Scilla tests, as Test_Contract does. Prints CSV.
+//
+// Usage: Test_ScillaBenchmark [--mapsize N]... [--calls N] [--launches N]
+
+#include <openssl/rand.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "common/Constants.h"
+#include "libCrypto/Schnorr.h"
+#include "libData/AccountData/Account.h"
+#include "libData/AccountData/AccountStore.h"
+#include "libData/AccountData/ContractProfiler.h"
+#include "libData/AccountData/Transaction.h"
+#include "libData/AccountData/TransactionReceipt.h"
+#include "libUtils/DataConversion.h"
+#include "libUtils/Logger.h"
+#include "libUtils/Metrics.h"
+#include "libUtils/SysCommand.h"
+
+#include "ScillaTestUtil.h"
+
+using namespace std;
+using namespace boost::multiprecision;
+namespace po = boost::program_options;
+
+namespace {
+
+const char* PHASE_NAMES[ContractProfiler::NUM_PHASES] = {"export", "execute",
+                                                         "parse", "persist"};
+
+using Clock = chrono::steady_clock;
+
+/// The per-phase histograms that ContractProfiler::AddTime observes into
+class PhaseTimes {
+  std::array<Metrics::Histogram*, ContractProfiler::NUM_PHASES> m_histograms;
+
+ public:
+  PhaseTimes() {
+    for (unsigned int i = 0; i < ContractProfiler::NUM_PHASES; i++) {
+      m_histograms[i] = &Metrics::GetInstance().GetHistogram(
+          "zilliqa_scilla_seconds", "Time spent on contract calls, per phase",
+          string("phase=\"") + PHASE_NAMES[i] + "\"");
+    }
+  }
+
+  /// Microseconds spent so far in each phase
+  std::array<double, ContractProfiler::NUM_PHASES> Get() const {
+    std::array<double, ContractProfiler::NUM_PHASES> micros{};
+    for (unsigned int i = 0; i < ContractProfiler::NUM_PHASES; i++) {
+      micros[i] = m_histograms[i]->GetSum() * 1e6;
+    }
+    return micros;
+  }
+};
+
+/// Sums of the times of one kind of transaction
+struct Totals {
+  unsigned int m_ops = 0;
+  unsigned int m_failed = 0;
+  double m_totalUs = 0;
+  std::array<double, ContractProfiler::NUM_PHASES> m_phaseUs{};
+  uint64_t m_gas = 0;
+  vector<double> m_latenciesUs;
+};
+
+void PrintHeader() {
+  cout << "case,map_size,ops,failed,total_us,p50_us,p99_us,export_us,"
+          "launch_us,interpret_us,parse_us,persist_us,other_us,gas"
+       << endl;
+}
+
+void Report(const string& name, unsigned int mapSize, Totals& totals,
+            double launchUs) {
+  if (totals.m_ops == 0) {
+    return;
+  }
+
+  const double ops = totals.m_ops;
+  auto& latencies = totals.m_latenciesUs;
+  auto percentile = [&latencies](double p) {
+    const size_t rank = static_cast<size_t>(p * latencies.size());
+    const size_t index = min(latencies.size() - 1, rank);
+    nth_element(latencies.begin(), latencies.begin() + index, latencies.end());
+    return latencies[index];
+  };
+
+  double phasesUs = 0;
+  for (const auto us : totals.m_phaseUs) {
+    phasesUs += us;
+  }
+  const double executeUs = totals.m_phaseUs[ContractProfiler::EXECUTE] / ops;
+  // A deployment runs the checker and the runner, so launches twice
+  const double launchesUs =
+      min(executeUs, launchUs * (name == "create" ? 2 : 1));
+
+  cout << fixed << setprecision(1) << name << "," << mapSize << ","
+       << totals.m_ops << "," << totals.m_failed << ","
+       << totals.m_totalUs / ops << "," << percentile(0.5) << ","
+       << percentile(0.99) << ","
+       << totals.m_phaseUs[ContractProfiler::EXPORT] / ops << ","
+       << launchesUs << "," << executeUs - launchesUs << ","
+       << totals.m_phaseUs[ContractProfiler::PARSE] / ops << ","
+       << totals.m_phaseUs[ContractProfiler::PERSIST] / ops << ","
+       << max(0.0, (totals.m_totalUs - phasesUs) / ops) << ","
+       << totals.m_gas / totals.m_ops << endl;
+}
+
+/// Runs one transaction through the account store, adding its times
+void Run(const PhaseTimes& phaseTimes, uint64_t blockNum,
+         const Transaction& txn, Totals& totals) {
+  const auto phasesBefore = phaseTimes.Get();
+  TransactionReceipt receipt;
+
+  const auto start = Clock::now();
+  const bool ok = AccountStore::GetInstance().UpdateAccounts(
+      blockNum, 1, true, txn, receipt);
+  const double us =
+      chrono::duration<double, micro>(Clock::now() - start).count();
+
+  const auto phasesAfter = phaseTimes.Get();
+  for (unsigned int i = 0; i < ContractProfiler::NUM_PHASES; i++) {
+    totals.m_phaseUs[i] += phasesAfter[i] - phasesBefore[i];
+  }
+  totals.m_ops++;
+  totals.m_failed += ok ? 0 : 1;
+  totals.m_totalUs += us;
+  totals.m_latenciesUs.emplace_back(us);
+  totals.m_gas += receipt.GetCumGas();
+}
+
+/// Mean microseconds to start the interpreter and have it exit at once, on
+/// its usage message. Zero with the Scilla server, which keeps it running.
+double MeasureLaunch(unsigned int launches) {
+  if (ENABLE_SCILLA_SERVER || launches == 0) {
+    return 0;
+  }
+
+  const string cmd = SCILLA_ROOT + '/' + SCILLA_BINARY;
+  const auto start = Clock::now();
+  for (unsigned int i = 0; i < launches; i++) {
+    string output;
+    SysCommand::ExecuteCmd(SysCommand::WITH_OUTPUT, cmd, output);
+  }
+  return chrono::duration<double, micro>(Clock::now() - start).count() /
+         launches;
+}
+
+/// Deploys a fungible token whose balances map holds mapSize entries, then
+/// calls Transfer on it calls times
+bool RunFungibleToken(const PhaseTimes& phaseTimes, unsigned int mapSize,
+                      unsigned int calls, double launchUs) {
+  const PairOfKey owner = Schnorr::GetInstance().GenKeyPair();
+  const Address ownerAddr = Account::GetAddressFromPublicKey(owner.second);
+  uint64_t nonce = 0;
+
+  AccountStore::GetInstance().Init();
+  AccountStore::GetInstance().AddAccount(
+      ownerAddr, {numeric_limits<uint128_t>::max(), nonce});
+  const Address contrAddr = Account::GetAddressForContract(ownerAddr, nonce);
+
+  ScillaTestUtil::ScillaTest t2;
+  if (!ScillaTestUtil::GetScillaTest(t2, "fungible-token", 2)) {
+    cerr << "Unable to fetch test fungible-token_2" << endl;
+    return false;
+  }
+
+  for (auto& it : t2.init) {
+    if (it["vname"] == "owner") {
+      it["value"] = "0x" + ownerAddr.hex();
+    }
+  }
+  ScillaTestUtil::RemoveThisAddressFromInit(t2.init);
+  ScillaTestUtil::RemoveCreationBlockFromInit(t2.init);
+  const uint64_t bnum = ScillaTestUtil::GetBlockNumberFromJson(t2.blockchain);
+
+  const string initStr = JSONUtils::GetInstance().convertJsontoStr(t2.init);
+  const bytes initData(initStr.begin(), initStr.end());
+  Transaction create(DataConversion::Pack(CHAIN_ID, 1), nonce++, NullAddress,
+                     owner, 0, PRECISION_MIN_VALUE, 500000, t2.code,
+                     initData);
+  Totals createTotals;
+  Run(phaseTimes, bnum, create, createTotals);
+
+  Account* account = AccountStore::GetInstance().GetAccount(contrAddr);
+  if (account == nullptr) {
+    cerr << "Failed to deploy fungible-token" << endl;
+    return false;
+  }
+
+  // Fill the balances map, with the owner first so that it can transfer
+  for (auto& it : t2.state) {
+    if (it["vname"] != "balances") {
+      continue;
+    }
+    Json::Value ownerBal;
+    ownerBal["key"] = "0x" + ownerAddr.hex();
+    ownerBal["val"] = "88888888";
+    it["value"] = Json::arrayValue;
+    it["value"].append(ownerBal);
+    for (unsigned int i = 1; i < mapSize; i++) {
+      bytes hodler(ACC_ADDR_SIZE);
+      RAND_bytes(hodler.data(), ACC_ADDR_SIZE);
+      string hodlerStr;
+      DataConversion::Uint8VecToHexStr(hodler, hodlerStr);
+      Json::Value kvPair;
+      kvPair["key"] = "0x" + hodlerStr;
+      kvPair["val"] = "1";
+      it["value"].append(kvPair);
+    }
+  }
+
+  vector<Contract::StateEntry> stateEntries;
+  for (auto& s : t2.state) {
+    if (s["vname"].asString() == "_balance") {
+      continue;
+    }
+    const string value =
+        s["value"].isString()
+            ? s["value"].asString()
+            : JSONUtils::GetInstance().convertJsontoStr(s["value"]);
+    stateEntries.emplace_back(s["vname"].asString(), true,
+                              s["type"].asString(), value);
+  }
+  account->SetStorage(stateEntries);
+
+  bytes dataTransfer;
+  const uint64_t amount =
+      ScillaTestUtil::PrepareMessageData(t2.message, dataTransfer);
+
+  Totals callTotals;
+  for (unsigned int i = 0; i < calls; i++) {
+    Transaction call(DataConversion::Pack(CHAIN_ID, 1), nonce++, contrAddr,
+                     owner, amount, PRECISION_MIN_VALUE, 88888888, {},
+                     dataTransfer);
+    Run(phaseTimes, bnum, call, callTotals);
+  }
+
+  Report("create", mapSize, createTotals, launchUs);
+  Report("call", mapSize, callTotals, launchUs);
+
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  vector<unsigned int> mapSizes{1, 1000, 10000, 100000};
+  unsigned int calls = 20;
+  unsigned int launches = 20;
+
+  po::options_description desc("Options");
+  desc.add_options()("help,h", "Print help messages")(
+      "mapsize,m", po::value<vector<unsigned int>>(&mapSizes)->multitoken(),
+      "Entries of the balances map of the contract")(
+      "calls,c", po::value<unsigned int>(&calls),
+      "Transfer calls per map size")(
+      "launches,l", po::value<unsigned int>(&launches),
+      "Interpreter launches to measure the launch cost over");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("help")) {
+      cout << desc << endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (boost::program_options::error& e) {
+    cerr << "ERROR: " << e.what() << endl << endl << desc << endl;
+    return 1;
+  }
+
+  INIT_STDOUT_LOGGER();
+
+  if (SCILLA_ROOT.empty()) {
+    cerr << "SCILLA_ROOT not set to run Test_ScillaBenchmark" << endl;
+    return 1;
+  }
+
+  const PhaseTimes phaseTimes;
+  const double launchUs = MeasureLaunch(launches);
+  cerr << "Scilla server " << (ENABLE_SCILLA_SERVER ? "on" : "off")
+       << ", inline I/O " << (SCILLA_SERVER_INLINE_IO ? "on" : "off")
+       << ", launch " << fixed << setprecision(1) << launchUs << " us"
+       << endl;
+
+  PrintHeader();
+  for (const auto mapSize : mapSizes) {
+    if (!RunFungibleToken(phaseTimes, max(mapSize, 1u), calls, launchUs)) {
+      return 1;
+    }
+  }
+
+  return 0;
+}
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "libData/DataStructures/SeqLockRing.h"
+
+#define BOOST_TEST_MODULE seqlockringtest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+struct Entry {
+  uint64_t m_id;
+  uint64_t m_check;
+};
+
+BOOST_AUTO_TEST_SUITE(seqlockringtest)
+
+BOOST_AUTO_TEST_CASE(GetLatest_NewestFirst) {
+  SeqLockRing<uint64_t> ring(4);
+
+  vector<uint64_t> values;
+  ring.GetLatest(10, values);
+  BOOST_CHECK(values.empty());
+
+  for (uint64_t i = 1; i <= 6; i++) {
+    ring.Push(i);
+  }
+
+  values.clear();
+  ring.GetLatest(10, values);
+  BOOST_CHECK_EQUAL(values.size(), 4);
+  BOOST_CHECK_EQUAL(values[0], 6);
+  BOOST_CHECK_EQUAL(values[3], 3);
+
+  values.clear();
+  ring.GetLatest(2, values);
+  BOOST_CHECK_EQUAL(values.size(), 2);
+  BOOST_CHECK_EQUAL(values[1], 5);
+}
+
+BOOST_AUTO_TEST_CASE(PushAll_InOrder) {
+  SeqLockRing<uint64_t> ring(4);
+  ring.Push(1);
+  ring.PushAll({2, 3});
+
+  vector<uint64_t> values;
+  ring.GetLatest(10, values);
+  BOOST_CHECK_EQUAL(values.size(), 3);
+  BOOST_CHECK_EQUAL(values[0], 3);
+  BOOST_CHECK_EQUAL(values[2], 1);
+
+  // More than fit leaves only the last of them
+  ring.PushAll({4, 5, 6, 7, 8, 9});
+  values.clear();
+  ring.GetLatest(10, values);
+  BOOST_CHECK_EQUAL(values.size(), 4);
+  BOOST_CHECK_EQUAL(values[0], 9);
+  BOOST_CHECK_EQUAL(values[3], 6);
+}
+
+BOOST_AUTO_TEST_CASE(GetLatest_NoTornReads) {
+  SeqLockRing<Entry> ring(8);
+  atomic<bool> done{false};
+
+  thread writer([&]() {
+    for (uint64_t i = 0; i < 200000; i++) {
+      ring.Push({i, ~i});
+    }
+    done = true;
+  });
+
+  bool consistent = true;
+  while (!done) {
+    vector<Entry> entries;
+    ring.GetLatest(8, entries);
+    for (unsigned int i = 0; i < entries.size(); i++) {
+      consistent &= entries[i].m_check == ~entries[i].m_id;
+      if (i > 0) {
+        consistent &= entries[i].m_id < entries[i - 1].m_id;
+      }
+    }
+  }
+  writer.join();
+
+  BOOST_CHECK(consistent);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,204 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/algorithm/string.hpp>
+
+#include "common/Constants.h"
+#include "libCrypto/Schnorr.h"
+#include "libData/AccountData/Account.h"
+#include "libData/AccountData/AccountStore.h"
+#include "libData/AccountData/AddrNonceTxnQueue.h"
+#include "libData/AccountData/Address.h"
+#include "libData/AccountData/Transaction.h"
+#include "libData/AccountData/TransactionReceipt.h"
+#include "libData/AccountData/TxnPool.h"
+#include "libUtils/DataConversion.h"
+#include "libUtils/Logger.h"
+#include "libUtils/RootComputation.h"
+
+#define BOOST_TEST_MODULE txnpipelineperformance
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace boost::multiprecision;
+using namespace std;
+
+// Used when PREGENED_ACCOUNTS_FILE is not set
+const unsigned int NUM_GENERATED_ACCOUNTS = 100;
+const unsigned int NUM_TXNS_PER_ACCOUNT = 10;
+
+typedef chrono::high_resolution_clock Clock;
+
+double ElapsedMs(const Clock::time_point& start) {
+  return chrono::duration<double, milli>(Clock::now() - start).count();
+}
+
+/// Loads the "pubkey privkey" lines written for PREGENED_ACCOUNTS_FILE, or
+/// generates NUM_GENERATED_ACCOUNTS key pairs if there is no such file
+vector<PairOfKey> LoadAccounts() {
+  vector<PairOfKey> accounts;
+
+  ifstream keysFile(PREGENED_ACCOUNTS_FILE);
+  string line;
+  while (getline(keysFile, line) &&
+         (NUM_ACCOUNTS_PREGENERATE == 0 ||
+          accounts.size() < NUM_ACCOUNTS_PREGENERATE)) {
+    vector<string> keyPair;
+    boost::algorithm::split(keyPair, line, boost::algorithm::is_any_of(" "));
+    if (keyPair.size() < 2) {
+      continue;
+    }
+    try {
+      accounts.emplace_back(PrivKey::GetPrivKeyFromString(keyPair[1]),
+                            PubKey::GetPubKeyFromString(keyPair[0]));
+    } catch (const std::exception& e) {
+      LOG_GENERAL(WARNING, "Bad key pair in " << PREGENED_ACCOUNTS_FILE << ": "
+                                              << e.what());
+    }
+  }
+
+  if (accounts.empty()) {
+    for (unsigned int i = 0; i < NUM_GENERATED_ACCOUNTS; i++) {
+      accounts.emplace_back(Schnorr::GetInstance().GenKeyPair());
+    }
+  }
+
+  return accounts;
+}
+
+BOOST_AUTO_TEST_SUITE(TxnPipelinePerformance)
+
+BOOST_AUTO_TEST_CASE(PaymentPipeline) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+
+  const vector<PairOfKey> accounts = LoadAccounts();
+
+  AccountStore::GetInstance().Init();
+  for (const auto& account : accounts) {
+    AccountStore::GetInstance().AddAccount(
+        Account::GetAddressFromPublicKey(account.second), {1000000000, 0});
+  }
+  AccountStore::GetInstance().UpdateStateTrieAll();
+
+  // Same shape as gentxn output: each account pays the next one, with
+  // consecutive nonces
+  auto start = Clock::now();
+  vector<Transaction> txns;
+  txns.reserve(accounts.size() * NUM_TXNS_PER_ACCOUNT);
+  for (unsigned int i = 0; i < accounts.size(); i++) {
+    const Address toAddr = Account::GetAddressFromPublicKey(
+        accounts[(i + 1) % accounts.size()].second);
+    for (uint64_t nonce = 1; nonce <= NUM_TXNS_PER_ACCOUNT; nonce++) {
+      txns.emplace_back(DataConversion::Pack(CHAIN_ID, 1), nonce, toAddr,
+                        accounts[i], nonce, GAS_PRICE_MIN_VALUE,
+                        NORMAL_TRAN_GAS, bytes(), bytes());
+    }
+  }
+  const double generateMs = ElapsedMs(start);
+
+  start = Clock::now();
+  TxnPool pool;
+  for (const auto& t : txns) {
+    pool.insert(t);
+  }
+  const double insertMs = ElapsedMs(start);
+
+  // Same selection as ProcessTransactionWhenShardLeader, with the nonces
+  // tracked locally
+  start = Clock::now();
+  vector<Transaction> selected;
+  selected.reserve(txns.size());
+  AddrNonceTxnQueue addrNonceTxnQueue;
+  unordered_map<Address, uint64_t> nonces;
+  Transaction t;
+  while (true) {
+    if (addrNonceTxnQueue.PopReady(t)) {
+      const Address senderAddr = t.GetSenderAddr();
+      nonces[senderAddr] = t.GetNonce();
+      addrNonceTxnQueue.Refresh(senderAddr, t.GetNonce() + 1);
+      selected.emplace_back(t);
+    } else if (pool.findOne(t)) {
+      const Address senderAddr = t.GetSenderAddr();
+      const uint64_t expectedNonce = nonces[senderAddr] + 1;
+      if (t.GetNonce() > expectedNonce) {
+        addrNonceTxnQueue.Insert(senderAddr, t, expectedNonce);
+      } else if (t.GetNonce() == expectedNonce) {
+        nonces[senderAddr] = t.GetNonce();
+        if (addrNonceTxnQueue.Contains(senderAddr)) {
+          addrNonceTxnQueue.Refresh(senderAddr, t.GetNonce() + 1);
+        }
+        selected.emplace_back(t);
+      }
+    } else {
+      break;
+    }
+  }
+  const double selectMs = ElapsedMs(start);
+  BOOST_CHECK_EQUAL(txns.size(), selected.size());
+
+  start = Clock::now();
+  vector<TransactionWithReceipt> processed;
+  processed.reserve(selected.size());
+  for (const auto& txn : selected) {
+    TransactionReceipt tr;
+    tr.SetEpochNum(1);
+    BOOST_CHECK_MESSAGE(
+        AccountStore::GetInstance().UpdateAccountsTemp(1, 1, false, txn, tr),
+        "UpdateAccountsTemp failed for " << txn.GetTranID());
+    processed.emplace_back(txn, tr);
+  }
+  const double updateMs = ElapsedMs(start);
+
+  start = Clock::now();
+  const TxnHash txnRoot = ComputeRoot(processed);
+  const double rootMs = ElapsedMs(start);
+  BOOST_CHECK_MESSAGE(txnRoot != TxnHash(), "Empty txn root");
+
+  start = Clock::now();
+  BOOST_CHECK_MESSAGE(AccountStore::GetInstance().SerializeDelta(),
+                      "SerializeDelta failed");
+  const StateHash deltaHash = AccountStore::GetInstance().GetStateDeltaHash();
+  const double deltaMs = ElapsedMs(start);
+  BOOST_CHECK_MESSAGE(deltaHash != StateHash(), "Empty state delta");
+
+  const double pipelineMs = insertMs + selectMs + updateMs + rootMs + deltaMs;
+
+  LOG_GENERAL(INFO, accounts.size() << " accounts, " << txns.size() << " txns");
+  LOG_GENERAL(INFO, "Generate and sign:       " << generateMs << " ms");
+  LOG_GENERAL(INFO, "TxnPool insert:          " << insertMs << " ms");
+  LOG_GENERAL(INFO, "Selection:               " << selectMs << " ms");
+  LOG_GENERAL(INFO, "AccountStore update:     " << updateMs << " ms");
+  LOG_GENERAL(INFO, "ComputeRoot:             " << rootMs << " ms");
+  LOG_GENERAL(INFO, "State delta serialize:   " << deltaMs << " ms");
+  LOG_GENERAL(INFO, "Pipeline total:          " << pipelineMs << " ms");
+  if (pipelineMs > 0) {
+    LOG_GENERAL(INFO, "TPS:                     "
+                          << selected.size() * 1000 / pipelineMs);
+  }
+
+  AccountStore::GetInstance().InitTemp();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -81,7 +81,7 @@ BOOST_AUTO_TEST_CASE(test_coinbase_correctness) {
 
   dummyLookup.SetLookupNodes(lookupNodes);
 
-  vector<bool> b1, b2;
+  BitVector b1, b2;
 
   *mediator.m_DSCommittee = dummy_ds_comm;
   dummyDS.m_shards = dummy_shards;
@@ -92,14 +92,14 @@ BOOST_AUTO_TEST_CASE(test_coinbase_correctness) {
   for (uint i = 0; i < num_test_epoch; i++) {
     uint j = 0;
     for (const auto& shard : dummy_shards) {
-      b1 = GenerateRandomBooleanVector(shard.size());
+      b1 = BitVector(GenerateRandomBooleanVector(shard.size()));
 
-      b2 = GenerateRandomBooleanVector(shard.size());
+      b2 = BitVector(GenerateRandomBooleanVector(shard.size()));
       dummyDS.SaveCoinbaseCore(b1, b2, shard, j++, i + 1);
     }
 
-    b1 = GenerateRandomBooleanVector(dummy_ds_comm.size());
-    b2 = GenerateRandomBooleanVector(dummy_ds_comm.size());
+    b1 = BitVector(GenerateRandomBooleanVector(dummy_ds_comm.size()));
+    b2 = BitVector(GenerateRandomBooleanVector(dummy_ds_comm.size()));
 
     dummyDS.SaveCoinbaseCore(b1, b2, dummy_ds_comm,
                              CoinbaseReward::FINALBLOCK_REWARD, i + 1);
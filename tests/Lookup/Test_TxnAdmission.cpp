@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "libCrypto/Schnorr.h"
+#include "libData/AccountData/Transaction.h"
+#include "libLookup/TxnAdmission.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE txnadmissiontest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+Transaction MakeTxn(const PairOfKey& keyPair, uint64_t nonce) {
+  return Transaction(1, nonce, Address(), keyPair, 1, 1, 1);
+}
+
+BOOST_AUTO_TEST_SUITE(txnadmissiontest)
+
+BOOST_AUTO_TEST_CASE(duplicatesRefused) {
+  INIT_STDOUT_LOGGER();
+
+  mutex m;
+  vector<pair<TxnHash, uint32_t>> sunk;
+
+  const PairOfKey keyPair = Schnorr::GetInstance().GenKeyPair();
+  const Transaction good = MakeTxn(keyPair, 1);
+  const Transaction bad = MakeTxn(keyPair, 2);
+
+  {
+    TxnAdmission admission(
+        [&bad](const vector<Transaction>& txns, vector<bool>& valid) {
+          for (unsigned int i = 0; i < txns.size(); i++) {
+            valid[i] = txns[i].GetTranID() != bad.GetTranID();
+          }
+        },
+        [&](const Transaction& tx, uint32_t shardId) {
+          lock_guard<mutex> g(m);
+          sunk.emplace_back(tx.GetTranID(), shardId);
+        },
+        100, 100, 8);
+
+    BOOST_CHECK_EQUAL(admission.Admit(good, 3), TxnAdmission::QUEUED);
+    BOOST_CHECK_EQUAL(admission.Admit(bad, 3), TxnAdmission::QUEUED);
+    BOOST_CHECK_EQUAL(admission.Admit(good, 3), TxnAdmission::DUPLICATE);
+    BOOST_CHECK_EQUAL(admission.Admit(bad, 3), TxnAdmission::DUPLICATE);
+  }
+
+  // The destructor hands on what was queued
+  BOOST_REQUIRE_EQUAL(sunk.size(), 1u);
+  BOOST_CHECK(sunk[0].first == good.GetTranID());
+  BOOST_CHECK_EQUAL(sunk[0].second, 3u);
+}
+
+BOOST_AUTO_TEST_CASE(busyWhenFull) {
+  INIT_STDOUT_LOGGER();
+
+  mutex m;
+  condition_variable cv;
+  bool release = false;
+  unsigned int sunk = 0;
+
+  const PairOfKey keyPair = Schnorr::GetInstance().GenKeyPair();
+
+  TxnAdmission admission(
+      [&](const vector<Transaction>& txns, vector<bool>& valid) {
+        unique_lock<mutex> g(m);
+        cv.wait(g, [&release]() { return release; });
+        valid.assign(txns.size(), true);
+      },
+      [&](const Transaction&, uint32_t) {
+        lock_guard<mutex> g(m);
+        sunk++;
+      },
+      100, 1, 1);
+
+  // The first is taken by the checking thread, which then waits
+  BOOST_CHECK_EQUAL(admission.Admit(MakeTxn(keyPair, 1), 0),
+                    TxnAdmission::QUEUED);
+  unsigned int queued = 1;
+  for (uint64_t nonce = 2; nonce < 10; nonce++) {
+    if (admission.Admit(MakeTxn(keyPair, nonce), 0) == TxnAdmission::QUEUED) {
+      queued++;
+    }
+  }
+  BOOST_CHECK_LE(queued, 2u);
+
+  // A refused txn is forgotten, so that it may be submitted again
+  const Transaction retried = MakeTxn(keyPair, 9);
+  BOOST_CHECK(admission.Admit(retried, 0) != TxnAdmission::DUPLICATE);
+
+  {
+    lock_guard<mutex> g(m);
+    release = true;
+  }
+  cv.notify_all();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -48,6 +48,9 @@ BOOST_AUTO_TEST_CASE(RegisterColleagues) {
   Validator validator(*m);
 
   m->RegisterColleagues(&ds, &node, &lookup, &validator);
+
+  // The colleagues go out of scope here, and the epoch context reads them
+  m->RegisterColleagues(nullptr, nullptr, nullptr, nullptr);
 }
 
 BOOST_AUTO_TEST_CASE(UpdateDSBlockRand) {
@@ -120,6 +123,24 @@ BOOST_AUTO_TEST_CASE(GetNodeMode) {
       "Wrong mode. Expected " + EXPECTED_MODE + ". Result: " + mode);
 }
 
+BOOST_AUTO_TEST_CASE(PublishEpochContext) {
+  const auto before = m->GetEpochContext();
+  m->IncreaseEpochNum();
+  const auto after = m->GetEpochContext();
+
+  BOOST_CHECK_EQUAL(after->m_epochNum, before->m_epochNum + 1);
+  BOOST_CHECK_EQUAL(after->m_epochNum, m->m_currentEpochNum);
+  BOOST_CHECK(*after->m_dsCommittee == *m->m_DSCommittee);
+
+  // A context once read does not follow later changes
+  m->m_DSCommittee->pop_front();
+  BOOST_CHECK_EQUAL(after->m_dsCommittee->size(),
+                    m->m_DSCommittee->size() + 1);
+
+  m->PublishEpochContext();
+  BOOST_CHECK(*m->GetEpochContext()->m_dsCommittee == *m->m_DSCommittee);
+}
+
 BOOST_AUTO_TEST_CASE(GetShardSize) {
   DirectoryService ds(*m);
   ds.m_shards = TestUtils::GenerateDequeueOfShard(10);
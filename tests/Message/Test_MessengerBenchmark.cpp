@@ -0,0 +1,371 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Encode and decode throughput benchmark for the Messenger messages that
+// dominate a node's serialization time, built at mainnet-like sizes.
+//
+// Heap allocations are counted by replacing the global operator new, so the
+// numbers only make sense for this binary.
+//
+// Usage: Test_MessengerBenchmark [--case NAME|all] [--iterations N]
+//            [--committee N] [--shards N] [--shardsize N] [--txns N]
+//            [--statedelta KB]
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "libMessage/Messenger.h"
+#include "libTestUtils/TestUtils.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+namespace po = boost::program_options;
+
+namespace {
+atomic<uint64_t> g_allocations{0};
+}  // namespace
+
+void* operator new(size_t size) {
+  g_allocations++;
+  void* p = malloc(size);
+  if (p == nullptr) {
+    throw bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+namespace {
+
+struct BenchConfig {
+  string m_case = "all";
+  unsigned int m_iterations = 20;
+  unsigned int m_committee = 600;
+  unsigned int m_shards = 3;
+  unsigned int m_shardSize = 600;
+  unsigned int m_txns = 10000;
+  unsigned int m_stateDeltaKB = 1024;
+};
+
+struct Case {
+  string m_name;
+  function<bool(bytes&)> m_encode;
+  function<bool(const bytes&)> m_decode;
+};
+
+uint64_t NowUs() {
+  return chrono::duration_cast<chrono::microseconds>(
+             chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+// Runs the operation once to warm up, then iterations times
+bool Measure(const function<bool()>& op, unsigned int iterations,
+             double& usPerOp, double& allocsPerOp) {
+  if (!op()) {
+    return false;
+  }
+
+  const uint64_t allocStart = g_allocations;
+  const uint64_t start = NowUs();
+  for (unsigned int i = 0; i < iterations; i++) {
+    if (!op()) {
+      return false;
+    }
+  }
+  usPerOp = (double)(NowUs() - start) / iterations;
+  allocsPerOp = (double)(g_allocations - allocStart) / iterations;
+
+  return true;
+}
+
+bool RunCase(const Case& c, const BenchConfig& config) {
+  bytes message;
+  if (!c.m_encode(message)) {
+    cerr << c.m_name << ": encode failed" << endl;
+    return false;
+  }
+
+  double encodeUs = 0, encodeAllocs = 0, decodeUs = 0, decodeAllocs = 0;
+  if (!Measure(
+          [&c]() {
+            bytes dst;
+            return c.m_encode(dst);
+          },
+          config.m_iterations, encodeUs, encodeAllocs) ||
+      !Measure([&c, &message]() { return c.m_decode(message); },
+               config.m_iterations, decodeUs, decodeAllocs)) {
+    cerr << c.m_name << ": encode or decode failed" << endl;
+    return false;
+  }
+
+  const double mb = message.size() / (1024.0 * 1024.0);
+  cout << fixed << setprecision(2) << left << setw(14) << c.m_name << right
+       << " size " << setw(10) << message.size() << " bytes, encode "
+       << setw(10) << encodeUs << " us " << setw(8)
+       << (encodeUs > 0 ? mb * 1e6 / encodeUs : 0) << " MB/s " << setw(10)
+       << encodeAllocs << " allocs, decode " << setw(10) << decodeUs << " us "
+       << setw(8) << (decodeUs > 0 ? mb * 1e6 / decodeUs : 0) << " MB/s "
+       << setw(10) << decodeAllocs << " allocs" << endl;
+
+  return true;
+}
+
+vector<Transaction> GenerateTransactions(unsigned int count) {
+  const PairOfKey sender = TestUtils::GenerateRandomKeyPair();
+  const Address toAddr;
+
+  vector<Transaction> txns;
+  txns.reserve(count);
+  for (unsigned int i = 0; i < count; i++) {
+    txns.emplace_back(1, i + 1, toAddr, sender, TestUtils::DistUint32(), 2000,
+                      1);
+  }
+  return txns;
+}
+
+vector<Case> BuildCases(const BenchConfig& config) {
+  vector<Case> cases;
+
+  const PairOfKey key = TestUtils::GenerateRandomKeyPair();
+
+  // DS block with its sharding structure, as sent to the shards
+  {
+    auto dsBlock =
+        make_shared<DSBlock>(TestUtils::GenerateRandomDSBlockHeader(),
+                             CoSignatures(config.m_committee));
+    auto shards = make_shared<DequeOfShard>();
+    for (unsigned int i = 0; i < config.m_shards; i++) {
+      shards->emplace_back(TestUtils::GenerateRandomShard(config.m_shardSize));
+    }
+
+    cases.push_back(
+        {"dsblock",
+         [dsBlock, shards](bytes& dst) {
+           return Messenger::SetNodeVCDSBlocksMessage(
+               dst, 0, 0, *dsBlock, {}, SHARDINGSTRUCTURE_VERSION, *shards);
+         },
+         [](const bytes& src) {
+           uint32_t shardId = 0, shardingStructureVersion = 0;
+           DSBlock dsBlock;
+           vector<VCBlock> vcBlocks;
+           DequeOfShard shards;
+           return Messenger::GetNodeVCDSBlocksMessage(
+               src, 0, shardId, dsBlock, vcBlocks, shardingStructureVersion,
+               shards);
+         }});
+  }
+
+  auto stateDelta = make_shared<bytes>(
+      TestUtils::GenerateRandomCharVector(config.m_stateDeltaKB * 1024));
+
+  // Final block with a microblock info per shard and its state delta
+  {
+    vector<MicroBlockInfo> mbInfos;
+    for (unsigned int i = 0; i <= config.m_shards; i++) {
+      mbInfos.push_back({BlockHash::random(), TxnHash::random(), i});
+    }
+    auto txBlock =
+        make_shared<TxBlock>(TestUtils::GenerateRandomTxBlockHeader(), mbInfos,
+                             CoSignatures(config.m_committee));
+
+    cases.push_back({"finalblock",
+                     [txBlock, stateDelta](bytes& dst) {
+                       return Messenger::SetNodeFinalBlock(dst, 0, 1, 0,
+                                                           *txBlock,
+                                                           *stateDelta);
+                     },
+                     [](const bytes& src) {
+                       uint64_t dsBlockNumber = 0;
+                       uint32_t consensusID = 0;
+                       TxBlock txBlock;
+                       bytes stateDelta;
+                       return Messenger::GetNodeFinalBlock(
+                           src, 0, dsBlockNumber, consensusID, txBlock,
+                           stateDelta);
+                     }});
+  }
+
+  auto txns = make_shared<vector<Transaction>>(
+      GenerateTransactions(config.m_txns));
+
+  // Microblock listing every txn hash of a full shard
+  vector<TxnHash> tranHashes;
+  for (const auto& txn : *txns) {
+    tranHashes.emplace_back(txn.GetTranID());
+  }
+  auto microBlock =
+      make_shared<MicroBlock>(TestUtils::GenerateRandomMicroBlockHeader(),
+                              tranHashes, CoSignatures(config.m_shardSize));
+  cases.push_back({"microblock",
+                   [microBlock](bytes& dst) {
+                     return Messenger::SetMicroBlock(dst, 0, *microBlock);
+                   },
+                   [](const bytes& src) {
+                     MicroBlock microBlock;
+                     return Messenger::GetMicroBlock(src, 0, microBlock);
+                   }});
+
+  // Txn packet from a lookup; decoding checks every txn signature
+  cases.push_back(
+      {"txnpacket",
+       [txns, key](bytes& dst) {
+         vector<Transaction> txnsCurrent(*txns);
+         return Messenger::SetNodeForwardTxnBlock(dst, 0, 1, 1, 0, key,
+                                                  txnsCurrent, {});
+       },
+       [](const bytes& src) {
+         uint64_t epochNumber = 0, dsBlockNum = 0;
+         uint32_t shardId = 0;
+         PubKey lookupPubKey;
+         vector<Transaction> txns;
+         Signature signature;
+         return Messenger::GetNodeForwardTxnBlock(src, 0, epochNumber,
+                                                  dsBlockNum, shardId,
+                                                  lookupPubKey, txns,
+                                                  signature);
+       }});
+
+  cases.push_back({"statedelta",
+                   [stateDelta, key](bytes& dst) {
+                     return Messenger::SetLookupSetStateDeltaFromSeed(
+                         dst, 0, 1, key, *stateDelta);
+                   },
+                   [](const bytes& src) {
+                     uint64_t blockNum = 0;
+                     PubKey lookupPubKey;
+                     bytes stateDelta;
+                     return Messenger::GetLookupSetStateDeltaFromSeed(
+                         src, 0, blockNum, lookupPubKey, stateDelta);
+                   }});
+
+  // Microblock announcement from the shard leader
+  auto blockHash = make_shared<bytes>(BlockHash::random().asBytes());
+  cases.push_back(
+      {"announcement",
+       [microBlock, blockHash, key](bytes& dst) {
+         bytes messageToCosign;
+         return Messenger::SetNodeMicroBlockAnnouncement(
+             dst, 0, 1, 1, *blockHash, 0, key, *microBlock, messageToCosign);
+       },
+       [blockHash, key](const bytes& src) {
+         MicroBlock microBlock;
+         bytes messageToCosign;
+         return Messenger::GetNodeMicroBlockAnnouncement(
+             src, 0, 1, 1, *blockHash, 0, key.second, microBlock,
+             messageToCosign);
+       }});
+
+  // Backup commit, verified against a full DS committee
+  auto committee = make_shared<DequeOfNode>(
+      TestUtils::GenerateRandomDSCommittee(config.m_committee));
+  const uint16_t backupID = config.m_committee / 2;
+  committee->at(backupID).first = key.second;
+  auto commitPoint = make_shared<CommitPoint>(CommitSecret());
+  cases.push_back(
+      {"commit",
+       [blockHash, backupID, commitPoint, key](bytes& dst) {
+         return Messenger::SetConsensusCommit(dst, 0, 1, 1, *blockHash,
+                                              backupID, *commitPoint,
+                                              CommitPointHash(*commitPoint),
+                                              key);
+       },
+       [blockHash, committee](const bytes& src) {
+         uint16_t backupID = 0;
+         CommitPoint commitPoint;
+         CommitPointHash commitPointHash;
+         return Messenger::GetConsensusCommit(src, 0, 1, 1, *blockHash,
+                                              backupID, commitPoint,
+                                              commitPointHash, *committee);
+       }});
+
+  return cases;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  BenchConfig config;
+
+  po::options_description desc("Options");
+  desc.add_options()("help,h", "Print help messages")(
+      "case", po::value<string>(&config.m_case),
+      "dsblock, finalblock, microblock, txnpacket, statedelta, announcement, "
+      "commit or all (default)")(
+      "iterations,i", po::value<unsigned int>(&config.m_iterations),
+      "Timed runs of each encode and decode")(
+      "committee", po::value<unsigned int>(&config.m_committee),
+      "DS committee size")("shards", po::value<unsigned int>(&config.m_shards),
+                           "Number of shards")(
+      "shardsize", po::value<unsigned int>(&config.m_shardSize),
+      "Nodes per shard")("txns", po::value<unsigned int>(&config.m_txns),
+                         "Txns per microblock and txn packet")(
+      "statedelta", po::value<unsigned int>(&config.m_stateDeltaKB),
+      "State delta size in KB");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("help")) {
+      cout << desc << endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (boost::program_options::error& e) {
+    cerr << "ERROR: " << e.what() << endl << endl << desc << endl;
+    return 1;
+  }
+
+  if (config.m_iterations == 0 || config.m_committee == 0) {
+    cerr << "ERROR: iterations and committee must be positive" << endl;
+    return 1;
+  }
+
+  INIT_FILE_LOGGER("messengerbench");
+  TestUtils::Initialize();
+
+  bool found = false;
+  int result = 0;
+  for (const auto& c : BuildCases(config)) {
+    if (config.m_case != "all" && config.m_case != c.m_name) {
+      continue;
+    }
+    found = true;
+    if (!RunCase(c, config)) {
+      result = 2;
+    }
+  }
+
+  if (!found) {
+    cerr << "ERROR: unknown case " << config.m_case << endl;
+    return 1;
+  }
+
+  return result;
+}
@@ -72,6 +72,33 @@ BOOST_AUTO_TEST_CASE(test_SetAndGetConsensusCommit) {
   BOOST_CHECK(commitPointHash == commitPointHashDeserialized);
 }
 
+BOOST_AUTO_TEST_CASE(test_PeekConsensusBlockNumber) {
+  bytes dst;
+  unsigned int offset = TestUtils::Dist1to99();
+  uint64_t blockNumber = TestUtils::DistUint32();
+  bytes blockHash(TestUtils::Dist1to99(), TestUtils::DistUint8());
+  CommitPoint commitPoint = CommitPoint(CommitSecret());
+  PairOfKey backupKey;
+  backupKey.first = PrivKey();
+  backupKey.second = PubKey(backupKey.first);
+
+  BOOST_CHECK(Messenger::SetConsensusCommit(
+      dst, offset, TestUtils::DistUint32(), blockNumber, blockHash, 2,
+      commitPoint, CommitPointHash(commitPoint), backupKey));
+
+  uint64_t peekedBlockNumber = 0;
+  BOOST_CHECK(
+      Messenger::PeekConsensusBlockNumber(dst, offset, peekedBlockNumber));
+  BOOST_CHECK_EQUAL(peekedBlockNumber, blockNumber);
+
+  // Cut off before the block number, or no message at all
+  const bytes truncated(dst.begin(), dst.begin() + offset + 3);
+  BOOST_CHECK(!Messenger::PeekConsensusBlockNumber(truncated, offset,
+                                                   peekedBlockNumber));
+  BOOST_CHECK(!Messenger::PeekConsensusBlockNumber(dst, dst.size() + 1,
+                                                   peekedBlockNumber));
+}
+
 BOOST_AUTO_TEST_CASE(test_SetAndGetConsensusChallenge) {
   bytes dst;
   unsigned int offset = 0;
@@ -102,4 +102,32 @@ BOOST_AUTO_TEST_CASE(test_pop) {
   LOG_GENERAL(INFO, "Test Blacklist pop done!");
 }
 
+BOOST_AUTO_TEST_CASE(test_exclude_ipv6) {
+  INIT_STDOUT_LOGGER();
+
+  Blacklist& bl = Blacklist::GetInstance();
+  bl.Clear();
+
+  // Addresses differing only in the upper 64 bits must not collide
+  const boost::multiprecision::uint128_t ipv4 = 0x0100007F;
+  const boost::multiprecision::uint128_t ipv6 =
+      (boost::multiprecision::uint128_t(1) << 64) | ipv4;
+
+  bl.Add(ipv6);
+  BOOST_CHECK_MESSAGE(bl.Exist(ipv6), "IPv6 address should be blacklisted!");
+  BOOST_CHECK_MESSAGE(!bl.Exist(ipv4), "IPv4 address should not collide!");
+
+  bl.Exclude(ipv4);
+  bl.Add(ipv4);
+  BOOST_CHECK_MESSAGE(!bl.Exist(ipv4), "Excluded IP should not be added!");
+
+  bl.RemoveExclude(ipv4);
+  bl.Add(ipv4);
+  BOOST_CHECK_MESSAGE(bl.Exist(ipv4), "IP should be added once included!");
+  BOOST_CHECK(bl.SizeOfBlacklist() == 2);
+
+  bl.Clear();
+  LOG_GENERAL(INFO, "Test Blacklist exclusion done!");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
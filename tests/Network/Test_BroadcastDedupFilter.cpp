@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <thread>
+
+#include "libNetwork/BroadcastDedupFilter.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE broadcastdedupfilter
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+bytes MakeHash(unsigned int i) {
+  bytes hash(32, 0);
+  hash[0] = i & 0xFF;
+  hash[1] = (i >> 8) & 0xFF;
+  hash[2] = (i >> 16) & 0xFF;
+  return hash;
+}
+
+BOOST_AUTO_TEST_SUITE(broadcastdedupfilter)
+
+BOOST_AUTO_TEST_CASE(test_duplicate) {
+  INIT_STDOUT_LOGGER();
+
+  BroadcastDedupFilter filter(4, chrono::milliseconds(10000), 100);
+
+  BOOST_CHECK_MESSAGE(filter.Insert(MakeHash(1)), "New hash should insert!");
+  BOOST_CHECK_MESSAGE(!filter.Insert(MakeHash(1)),
+                      "Duplicate hash should be rejected!");
+  BOOST_CHECK(filter.Contains(MakeHash(1)));
+  BOOST_CHECK(!filter.Contains(MakeHash(2)));
+  BOOST_CHECK(filter.Size() == 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_expiry) {
+  INIT_STDOUT_LOGGER();
+
+  const chrono::milliseconds bucket(100);
+  BroadcastDedupFilter filter(3, bucket, 100);
+
+  filter.Insert(MakeHash(1));
+  this_thread::sleep_for(bucket);
+  filter.Insert(MakeHash(2));
+
+  BOOST_CHECK_MESSAGE(filter.Contains(MakeHash(1)),
+                      "Hash should be kept for the whole window!");
+
+  this_thread::sleep_for(bucket * 2);
+  BOOST_CHECK_MESSAGE(!filter.Contains(MakeHash(1)),
+                      "Hash should expire once its bucket is rolled out!");
+  BOOST_CHECK(filter.Contains(MakeHash(2)));
+
+  this_thread::sleep_for(bucket * 4);
+  BOOST_CHECK_MESSAGE(filter.Size() == 0,
+                      "All hashes should expire after the window!");
+}
+
+BOOST_AUTO_TEST_CASE(test_max_entries) {
+  INIT_STDOUT_LOGGER();
+
+  const unsigned int maxEntries = 1000;
+  BroadcastDedupFilter filter(4, chrono::milliseconds(10000), maxEntries);
+
+  for (unsigned int i = 0; i < maxEntries * 10; i++) {
+    filter.Insert(MakeHash(i));
+    BOOST_REQUIRE(filter.Size() <= maxEntries);
+  }
+
+  BOOST_CHECK_MESSAGE(filter.Contains(MakeHash(maxEntries * 10 - 1)),
+                      "The newest hash should be kept!");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
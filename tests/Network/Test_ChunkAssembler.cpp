@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "libNetwork/ChunkAssembler.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE chunkassembler
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static vector<Peer> MakePeers(unsigned int count) {
+  vector<Peer> peers;
+  for (unsigned int i = 0; i < count; i++) {
+    peers.emplace_back(0x0100007F, 30303 + i);
+  }
+  return peers;
+}
+
+static bytes MakeMessage(unsigned int size) {
+  bytes message;
+  for (unsigned int i = 0; i < size; i++) {
+    message.push_back((i * 31 + 7) % 256);
+  }
+  return message;
+}
+
+BOOST_AUTO_TEST_SUITE(chunkassembler)
+
+BOOST_AUTO_TEST_CASE(test_frame_roundtrip) {
+  INIT_STDOUT_LOGGER();
+
+  vector<ChunkFrame> frames;
+  BOOST_REQUIRE(
+      ChunkAssembler::Split(MakeMessage(10000), MakePeers(10), 50, frames));
+  BOOST_REQUIRE_EQUAL(frames.size(), 10);
+  BOOST_CHECK_EQUAL(frames[0].m_dataChunks, 6);
+  BOOST_CHECK_EQUAL(frames[0].m_parityChunks, 4);
+
+  bytes serialized;
+  frames[3].Serialize(serialized);
+
+  ChunkFrame frame;
+  BOOST_REQUIRE(frame.Deserialize(serialized, 0));
+  BOOST_CHECK(frame.m_hash == frames[3].m_hash);
+  BOOST_CHECK_EQUAL(frame.m_length, 10000);
+  BOOST_CHECK_EQUAL(frame.m_index, 3);
+  BOOST_CHECK(frame.m_relayPeers == MakePeers(10));
+  BOOST_CHECK(frame.m_chunk == frames[3].m_chunk);
+
+  serialized.resize(20);
+  BOOST_CHECK_MESSAGE(!frame.Deserialize(serialized, 0),
+                      "Truncated chunk should be rejected!");
+}
+
+BOOST_AUTO_TEST_CASE(test_assemble_from_any_chunks) {
+  INIT_STDOUT_LOGGER();
+
+  const bytes message = MakeMessage(100000);
+  vector<ChunkFrame> frames;
+  BOOST_REQUIRE(ChunkAssembler::Split(message, MakePeers(10), 50, frames));
+
+  ChunkAssembler assembler(4, chrono::seconds(60), 1024 * 1024);
+  ChunkAssembler::PendingMessage ready;
+
+  // Peers 0, 2, 5 and 7 never deliver their chunk
+  const vector<unsigned int> order = {9, 1, 8, 3, 6, 4};
+  for (unsigned int i = 0; i < order.size(); i++) {
+    const auto result = assembler.Add(frames[order[i]], ready);
+    if (i + 1 < order.size()) {
+      BOOST_CHECK_EQUAL(result, ChunkAssembler::CHUNK_STORED);
+      BOOST_CHECK_EQUAL(assembler.Add(frames[order[i]], ready),
+                        ChunkAssembler::CHUNK_DUPLICATE);
+    } else {
+      BOOST_REQUIRE_EQUAL(result, ChunkAssembler::CHUNK_COMPLETED);
+    }
+  }
+  BOOST_CHECK_EQUAL(assembler.Size(), 0);
+
+  bytes assembled;
+  BOOST_REQUIRE(
+      ChunkAssembler::Assemble(frames[0].m_hash, ready, assembled));
+  BOOST_CHECK_MESSAGE(assembled == message,
+                      "Assembled message differs from the original!");
+
+  // A tampered chunk must not pass for the original message
+  ready.m_chunks.begin()->second[0] ^= 0xFF;
+  BOOST_CHECK(!ChunkAssembler::Assemble(frames[0].m_hash, ready, assembled));
+}
+
+BOOST_AUTO_TEST_CASE(test_reject_and_evict) {
+  INIT_STDOUT_LOGGER();
+
+  ChunkAssembler assembler(2, chrono::seconds(60), 1024 * 1024);
+  ChunkAssembler::PendingMessage ready;
+
+  vector<ChunkFrame> frames;
+  BOOST_REQUIRE(
+      ChunkAssembler::Split(MakeMessage(10000), MakePeers(4), 50, frames));
+
+  ChunkFrame bad = frames[0];
+  bad.m_chunk.pop_back();
+  BOOST_CHECK_EQUAL(assembler.Add(bad, ready), ChunkAssembler::CHUNK_REJECTED);
+
+  bad = frames[0];
+  bad.m_length = 2 * 1024 * 1024;
+  BOOST_CHECK_EQUAL(assembler.Add(bad, ready), ChunkAssembler::CHUNK_REJECTED);
+
+  for (unsigned int size = 1000; size < 4000; size += 1000) {
+    BOOST_REQUIRE(
+        ChunkAssembler::Split(MakeMessage(size), MakePeers(4), 50, frames));
+    BOOST_CHECK_EQUAL(assembler.Add(frames[0], ready),
+                      ChunkAssembler::CHUNK_STORED);
+  }
+  BOOST_CHECK_MESSAGE(assembler.Size() == 2,
+                      "Oldest incomplete message should have been dropped!");
+
+  assembler.CleanupExpired();
+  BOOST_CHECK_EQUAL(assembler.Size(), 2);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
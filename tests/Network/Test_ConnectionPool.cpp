@@ -0,0 +1,111 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "common/Constants.h"
+#include "libNetwork/ConnectionPool.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE connectionpool
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(connectionpool)
+
+BOOST_AUTO_TEST_CASE(test_reuse_healthy_connection) {
+  INIT_STDOUT_LOGGER();
+
+  ConnectionPool& pool = ConnectionPool::GetInstance();
+  pool.Clear();
+
+  Peer peer(0x0100007F, 30303);
+  BOOST_CHECK_MESSAGE(pool.Acquire(peer) == -1,
+                      "Empty pool should not return a connection!");
+
+  int fds[2];
+  BOOST_REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+  pool.Release(peer, fds[0]);
+  BOOST_CHECK_MESSAGE(pool.SizeOfIdle(peer) == 1,
+                      "Released connection should be kept idle!");
+
+  BOOST_CHECK_MESSAGE(pool.Acquire(Peer(0x0100007F, 30304)) == -1,
+                      "Connection should not be shared across peers!");
+  BOOST_CHECK_MESSAGE(pool.Acquire(peer) == fds[0],
+                      "Healthy connection should be reused!");
+  BOOST_CHECK_MESSAGE(pool.SizeOfIdle(peer) == 0,
+                      "Acquired connection should leave the pool!");
+
+  pool.Discard(fds[0]);
+  close(fds[1]);
+}
+
+BOOST_AUTO_TEST_CASE(test_drop_closed_connection) {
+  INIT_STDOUT_LOGGER();
+
+  ConnectionPool& pool = ConnectionPool::GetInstance();
+  pool.Clear();
+
+  Peer peer(0x0100007F, 30303);
+
+  int fds[2];
+  BOOST_REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+  pool.Release(peer, fds[0]);
+  close(fds[1]);
+
+  BOOST_CHECK_MESSAGE(pool.Acquire(peer) == -1,
+                      "Connection closed by the peer should not be reused!");
+  BOOST_CHECK_MESSAGE(pool.SizeOfIdle(peer) == 0,
+                      "Connection closed by the peer should be dropped!");
+}
+
+BOOST_AUTO_TEST_CASE(test_max_idle_per_peer) {
+  INIT_STDOUT_LOGGER();
+
+  ConnectionPool& pool = ConnectionPool::GetInstance();
+  pool.Clear();
+
+  Peer peer(0x0100007F, 30303);
+  vector<int> remotes;
+
+  for (unsigned int i = 0; i < CONNECTION_POOL_MAX_IDLE_PER_PEER + 2; ++i) {
+    int fds[2];
+    BOOST_REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    pool.Release(peer, fds[0]);
+    remotes.emplace_back(fds[1]);
+  }
+
+  BOOST_CHECK_MESSAGE(
+      pool.SizeOfIdle(peer) == CONNECTION_POOL_MAX_IDLE_PER_PEER,
+      "Pool should not keep more than " << CONNECTION_POOL_MAX_IDLE_PER_PEER
+                                        << " idle connections per peer!");
+
+  pool.Clear();
+  BOOST_CHECK_MESSAGE(pool.SizeOfIdle(peer) == 0,
+                      "Cleared pool should not keep any connection!");
+
+  for (const auto& fd : remotes) {
+    close(fd);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <sstream>
+
+#include "common/Messages.h"
+#include "libNetwork/MessageStats.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE messagestats
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(messagestats)
+
+BOOST_AUTO_TEST_CASE(test_counters) {
+  INIT_STDOUT_LOGGER();
+
+  MessageStats& stats = MessageStats::GetInstance();
+  stats.Clear();
+
+  const bytes message = {MessageType::NODE, NodeInstructionType::FINALBLOCK,
+                         0x01, 0x02, 0x03};
+  stats.RecordReceived(message);
+  stats.RecordProcessed(message, 0, 100);
+  stats.RecordSent(message, 3);
+
+  MessageStats::Snapshot snapshot;
+  BOOST_REQUIRE(stats.GetSnapshot(MessageType::NODE,
+                                  NodeInstructionType::FINALBLOCK, snapshot));
+  BOOST_CHECK_EQUAL(snapshot.m_countIn, 1);
+  BOOST_CHECK_EQUAL(snapshot.m_bytesIn, message.size());
+  BOOST_CHECK_EQUAL(snapshot.m_countOut, 3);
+  BOOST_CHECK_EQUAL(snapshot.m_bytesOut, 3 * message.size());
+  BOOST_CHECK_EQUAL(snapshot.m_processed, 1);
+  BOOST_CHECK_EQUAL(snapshot.m_handlerUs, 100);
+  BOOST_CHECK_EQUAL(snapshot.m_queueWaitHist[0], 1);
+  BOOST_CHECK_EQUAL(
+      snapshot.m_handlerHist[MessageStats::GetHistogramBucket(100)], 1);
+
+  BOOST_CHECK_MESSAGE(
+      !stats.GetSnapshot(MessageType::NODE, NodeInstructionType::DSBLOCK,
+                         snapshot),
+      "Unseen message should not have counters!");
+
+  // Too short to carry an instruction
+  stats.RecordReceived({MessageType::NODE});
+  stats.Clear();
+  BOOST_CHECK(!stats.GetSnapshot(MessageType::NODE,
+                                 NodeInstructionType::FINALBLOCK, snapshot));
+}
+
+BOOST_AUTO_TEST_CASE(test_histogram_bucket) {
+  INIT_STDOUT_LOGGER();
+
+  BOOST_CHECK_EQUAL(MessageStats::GetHistogramBucket(0), 0);
+  BOOST_CHECK_EQUAL(MessageStats::GetHistogramBucket(1), 1);
+  BOOST_CHECK_EQUAL(MessageStats::GetHistogramBucket(2), 2);
+  BOOST_CHECK_EQUAL(MessageStats::GetHistogramBucket(3), 2);
+  BOOST_CHECK_EQUAL(MessageStats::GetHistogramBucket(1024), 11);
+  BOOST_CHECK_EQUAL(MessageStats::GetHistogramBucket(UINT64_MAX),
+                    MessageStats::NUM_HISTOGRAM_BUCKETS - 1);
+}
+
+BOOST_AUTO_TEST_CASE(test_csv) {
+  INIT_STDOUT_LOGGER();
+
+  MessageStats& stats = MessageStats::GetInstance();
+  stats.Clear();
+
+  stats.RecordReceived({MessageType::DIRECTORY,
+                        DSInstructionType::POWSUBMISSION, 0x00});
+  stats.RecordSent({MessageType::NODE, NodeInstructionType::DSBLOCK}, 2);
+
+  ostringstream os;
+  stats.WriteCsv(os, 12345);
+
+  const string csv = os.str();
+  BOOST_CHECK_EQUAL(count(csv.begin(), csv.end(), '\n'), 2);
+  BOOST_CHECK(csv.find("12345,DS_POWSUBMISSION,1,1,1,3,0,0,") !=
+              string::npos);
+  BOOST_CHECK(csv.find("12345,NODE_DSBLOCK,2,1,0,0,2,4,") != string::npos);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
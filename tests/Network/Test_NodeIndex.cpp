@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "libCrypto/Schnorr.h"
+#include "libNetwork/NodeIndex.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE nodeindex
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(nodeindex)
+
+BOOST_AUTO_TEST_CASE(test_follows_changes_in_place) {
+  INIT_STDOUT_LOGGER();
+
+  const PubKey first = Schnorr::GetInstance().GenKeyPair().second;
+  const PubKey second = Schnorr::GetInstance().GenKeyPair().second;
+  const PubKey outsider = Schnorr::GetInstance().GenKeyPair().second;
+
+  DequeOfNode nodes;
+  nodes.emplace_back(first, Peer(1, 5001));
+  NodeIndex index;
+  index.Rebuild(nodes);
+
+  BOOST_CHECK(index.Contains(nodes, first));
+  BOOST_CHECK(!index.Contains(nodes, outsider));
+
+  // Added in front without telling the index, which shifts first as well
+  nodes.emplace_front(second, Peer(2, 5002));
+  BOOST_CHECK(index.Contains(nodes, second));
+  BOOST_CHECK(index.Contains(nodes, first));
+  BOOST_CHECK(index.Contains(nodes, Peer(2, 1234)));
+  BOOST_CHECK(!index.Contains(nodes, Peer(3, 5001)));
+
+  nodes.pop_front();
+  BOOST_CHECK(!index.Contains(nodes, second));
+  BOOST_CHECK(!index.Contains(nodes, Peer(2, 5002)));
+  BOOST_CHECK(index.Contains(nodes, first));
+
+  nodes.clear();
+  BOOST_CHECK(!index.Contains(nodes, first));
+}
+
+BOOST_AUTO_TEST_CASE(test_shards) {
+  const PubKey member = Schnorr::GetInstance().GenKeyPair().second;
+  const PubKey outsider = Schnorr::GetInstance().GenKeyPair().second;
+
+  DequeOfShard shards(3);
+  shards[2].emplace_back(member, Peer(1, 5001), 0);
+  NodeIndex index;
+
+  BOOST_CHECK(index.Contains(shards, member));
+  BOOST_CHECK(!index.Contains(shards, outsider));
+
+  shards[2].clear();
+  shards[0].emplace_back(member, Peer(1, 5001), 0);
+  BOOST_CHECK(index.Contains(shards, member));
+
+  shards.pop_front();
+  BOOST_CHECK(!index.Contains(shards, member));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
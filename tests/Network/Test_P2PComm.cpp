@@ -44,7 +44,7 @@ void process_message(pair<bytes, Peer>* message) {
                                     << " MBps");
   }
 
-  delete message;
+  P2PComm::ReleaseMessage(message);
 }
 
 static bool comparePairSecond(
@@ -0,0 +1,467 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Throughput and latency benchmark for P2PComm over loopback.
+//
+// P2PComm is a singleton, so every node runs in its own process: the parent
+// forks one receiver per node before starting any thread and then drives the
+// selected send path. Receivers stamp each delivery against the send time
+// carried in the payload and report back over a pipe.
+//
+// Usage: Test_P2PCommBenchmark [--mode direct|broadcast|gossip|all]
+//            [--nodes N] [--payload BYTES] [--messages COUNT] [--rate MSG/S]
+//            [--port BASE] [--timeout SECONDS]
+
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "common/Serializable.h"
+#include "libCrypto/Schnorr.h"
+#include "libNetwork/P2PComm.h"
+#include "libUtils/DetachedFunction.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+namespace po = boost::program_options;
+
+namespace {
+
+const uint32_t LOOPBACK = 0x0100007F;
+const unsigned int STAMP_LEN = 2 * sizeof(uint64_t);
+const unsigned char READY = 'R';
+
+struct BenchConfig {
+  string m_mode = "all";
+  unsigned int m_nodes = 4;
+  unsigned int m_payload = 1024;
+  unsigned int m_messages = 1000;
+  unsigned int m_rate = 2000;
+  uint32_t m_port = 33133;
+  unsigned int m_timeout = 60;
+};
+
+struct Report {
+  uint64_t m_received = 0;
+  uint64_t m_bytes = 0;
+  uint64_t m_lastReceivedNs = 0;
+  uint64_t m_cpuUs = 0;
+  uint64_t m_numLatencies = 0;
+};
+
+// CLOCK_MONOTONIC is shared by all processes on the host, so a send time
+// taken in the parent can be compared with a receive time in a child
+uint64_t NowNs() {
+  return chrono::duration_cast<chrono::nanoseconds>(
+             chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+uint64_t CpuUs() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000ULL +
+         usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+bool WriteAll(int fd, const void* data, size_t len) {
+  const char* p = static_cast<const char*>(data);
+  while (len > 0) {
+    ssize_t n = write(fd, p, len);
+    if (n <= 0) {
+      return false;
+    }
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+bool ReadAll(int fd, void* data, size_t len) {
+  char* p = static_cast<char*>(data);
+  while (len > 0) {
+    ssize_t n = read(fd, p, len);
+    if (n <= 0) {
+      return false;
+    }
+    p += n;
+    len -= n;
+  }
+  return true;
+}
+
+bytes MakePayload(uint64_t seq, unsigned int size) {
+  bytes payload(max(size, STAMP_LEN), 0xAB);
+  Serializable::SetNumber<uint64_t>(payload, 0, seq, sizeof(uint64_t));
+  Serializable::SetNumber<uint64_t>(payload, sizeof(uint64_t), NowNs(),
+                                    sizeof(uint64_t));
+  return payload;
+}
+
+// Receiver side state, only used in the child processes
+atomic<uint64_t> g_received{0};
+atomic<uint64_t> g_receivedBytes{0};
+atomic<uint64_t> g_lastReceivedNs{0};
+mutex g_mutexLatencies;
+vector<uint64_t> g_latenciesNs;
+
+void OnMessage(pair<bytes, Peer>* message) {
+  const uint64_t now = NowNs();
+
+  if (message->first.size() >= STAMP_LEN) {
+    const uint64_t sentNs = Serializable::GetNumber<uint64_t>(
+        message->first, sizeof(uint64_t), sizeof(uint64_t));
+    {
+      lock_guard<mutex> g(g_mutexLatencies);
+      g_latenciesNs.emplace_back(now > sentNs ? now - sentNs : 0);
+    }
+    g_receivedBytes += message->first.size();
+    g_lastReceivedNs = now;
+    g_received++;
+  }
+
+  P2PComm::ReleaseMessage(message);
+}
+
+Peer NodePeer(const BenchConfig& config, unsigned int index) {
+  return Peer(LOOPBACK, config.m_port + index);
+}
+
+void InitializeGossip(const BenchConfig& config, unsigned int self,
+                      const vector<PairOfKey>& keys) {
+  VectorOfNode others;
+  vector<PubKey> fullNetworkKeys;
+  for (unsigned int i = 0; i <= config.m_nodes; i++) {
+    fullNetworkKeys.emplace_back(keys.at(i).second);
+    if (i != self) {
+      others.emplace_back(keys.at(i).second, NodePeer(config, i));
+    }
+  }
+  P2PComm::GetInstance().InitializeRumorManager(others, fullNetworkKeys);
+}
+
+void StartNode(const BenchConfig& config, unsigned int self,
+               const vector<PairOfKey>& keys, P2PComm::Dispatcher dispatcher) {
+  P2PComm& p2p = P2PComm::GetInstance();
+  p2p.SetSelfPeer(NodePeer(config, self));
+  p2p.SetSelfKey(keys.at(self));
+
+  const uint32_t port = config.m_port + self;
+  auto func = [&p2p, port, dispatcher]() mutable -> void {
+    p2p.StartMessagePump(port, dispatcher);
+  };
+  DetachedFunction(1, func);
+
+  // Short delay to prepare the listening socket
+  this_thread::sleep_for(chrono::seconds(1));
+
+  if (config.m_mode == "gossip") {
+    InitializeGossip(config, self, keys);
+  }
+}
+
+[[noreturn]] void RunReceiver(const BenchConfig& config, unsigned int self,
+                              const vector<PairOfKey>& keys, int reportFd) {
+  string logName = "p2pbench-" + to_string(config.m_port + self);
+  INIT_FILE_LOGGER(logName.c_str());
+
+  StartNode(config, self, keys, OnMessage);
+
+  const uint64_t cpuStart = CpuUs();
+  WriteAll(reportFd, &READY, sizeof(READY));
+
+  const auto deadline =
+      chrono::steady_clock::now() + chrono::seconds(config.m_timeout);
+  while (g_received < config.m_messages &&
+         chrono::steady_clock::now() < deadline) {
+    this_thread::sleep_for(chrono::milliseconds(10));
+  }
+
+  Report report;
+  report.m_received = g_received;
+  report.m_bytes = g_receivedBytes;
+  report.m_lastReceivedNs = g_lastReceivedNs;
+  report.m_cpuUs = CpuUs() - cpuStart;
+
+  lock_guard<mutex> g(g_mutexLatencies);
+  report.m_numLatencies = g_latenciesNs.size();
+  WriteAll(reportFd, &report, sizeof(report));
+  WriteAll(reportFd, g_latenciesNs.data(),
+           g_latenciesNs.size() * sizeof(uint64_t));
+  close(reportFd);
+
+  // Skip static destructors, the message pump threads are still running
+  _exit(0);
+}
+
+void SendAll(const BenchConfig& config) {
+  P2PComm& p2p = P2PComm::GetInstance();
+
+  vector<Peer> receivers;
+  for (unsigned int i = 1; i <= config.m_nodes; i++) {
+    receivers.emplace_back(NodePeer(config, i));
+  }
+
+  const auto interval =
+      (config.m_rate > 0) ? chrono::nanoseconds(1000000000ULL / config.m_rate)
+                          : chrono::nanoseconds(0);
+  auto next = chrono::steady_clock::now();
+
+  for (uint64_t seq = 0; seq < config.m_messages; seq++) {
+    if (config.m_rate > 0) {
+      this_thread::sleep_until(next);
+      next += interval;
+    }
+
+    bytes payload = MakePayload(seq, config.m_payload);
+
+    if (config.m_mode == "direct") {
+      p2p.SendMessage(receivers, payload);
+    } else if (config.m_mode == "broadcast") {
+      p2p.SendBroadcastMessage(receivers, payload);
+    } else {
+      p2p.SpreadRumor(payload);
+    }
+  }
+}
+
+uint64_t Percentile(const vector<uint64_t>& sorted, double p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t idx = static_cast<size_t>(p * (sorted.size() - 1));
+  return sorted.at(idx);
+}
+
+int RunMode(const BenchConfig& config) {
+  // Generate every node's key up front so that the receivers can verify
+  // signed gossip from one another
+  vector<PairOfKey> keys;
+  for (unsigned int i = 0; i <= config.m_nodes; i++) {
+    keys.emplace_back(Schnorr::GetInstance().GenKeyPair());
+  }
+
+  // Fork before any thread is started in this process
+  vector<pid_t> children;
+  vector<int> reportFds;
+  for (unsigned int i = 1; i <= config.m_nodes; i++) {
+    int fds[2];
+    if (pipe(fds) != 0) {
+      cerr << "pipe failed: " << strerror(errno) << endl;
+      return 1;
+    }
+
+    pid_t pid = fork();
+    if (pid < 0) {
+      cerr << "fork failed: " << strerror(errno) << endl;
+      return 1;
+    }
+
+    if (pid == 0) {
+      close(fds[0]);
+      for (const auto& fd : reportFds) {
+        close(fd);
+      }
+      RunReceiver(config, i, keys, fds[1]);
+    }
+
+    close(fds[1]);
+    children.emplace_back(pid);
+    reportFds.emplace_back(fds[0]);
+  }
+
+  INIT_FILE_LOGGER("p2pbench-sender");
+
+  // Only gossip expects anything back, but the pump also runs the send queue
+  StartNode(config, 0, keys, [](pair<bytes, Peer>* message) {
+    P2PComm::ReleaseMessage(message);
+  });
+
+  for (const auto& fd : reportFds) {
+    unsigned char ready = 0;
+    if (!ReadAll(fd, &ready, sizeof(ready)) || ready != READY) {
+      cerr << "Receiver failed to start" << endl;
+      return 1;
+    }
+  }
+
+  const uint64_t cpuStart = CpuUs();
+  const uint64_t startNs = NowNs();
+
+  SendAll(config);
+
+  Report total;
+  vector<uint64_t> latencies;
+  for (const auto& fd : reportFds) {
+    Report report;
+    if (!ReadAll(fd, &report, sizeof(report))) {
+      cerr << "Receiver report missing" << endl;
+      return 1;
+    }
+
+    vector<uint64_t> nodeLatencies(report.m_numLatencies);
+    if (!ReadAll(fd, nodeLatencies.data(),
+                 nodeLatencies.size() * sizeof(uint64_t))) {
+      cerr << "Receiver latencies missing" << endl;
+      return 1;
+    }
+    close(fd);
+
+    total.m_received += report.m_received;
+    total.m_bytes += report.m_bytes;
+    total.m_cpuUs += report.m_cpuUs;
+    total.m_lastReceivedNs =
+        max(total.m_lastReceivedNs, report.m_lastReceivedNs);
+    latencies.insert(latencies.end(), nodeLatencies.begin(),
+                     nodeLatencies.end());
+  }
+  total.m_cpuUs += CpuUs() - cpuStart;
+
+  for (const auto& pid : children) {
+    waitpid(pid, nullptr, 0);
+  }
+
+  sort(latencies.begin(), latencies.end());
+
+  const uint64_t expected = (uint64_t)config.m_messages * config.m_nodes;
+  const double elapsedSec =
+      (total.m_lastReceivedNs > startNs)
+          ? (total.m_lastReceivedNs - startNs) / 1e9
+          : 0;
+  const double mb = total.m_bytes / (1024.0 * 1024.0);
+
+  cout << fixed << setprecision(2) << config.m_mode << ": nodes "
+       << config.m_nodes << ", payload " << config.m_payload << " bytes"
+       << ", delivered " << total.m_received << "/" << expected << ", "
+       << (elapsedSec > 0 ? total.m_received / elapsedSec : 0) << " msg/s, "
+       << (elapsedSec > 0 ? mb / elapsedSec : 0) << " MB/s, p50 "
+       << Percentile(latencies, 0.50) / 1000.0 << " us, p99 "
+       << Percentile(latencies, 0.99) / 1000.0 << " us, "
+       << (mb > 0 ? total.m_cpuUs / 1000.0 / mb : 0) << " CPU ms/MB" << endl;
+
+  return (total.m_received == expected) ? 0 : 2;
+}
+
+// Each mode needs fresh processes, so "all" re-runs this binary per mode
+int RunAllModes(const char* self, int argc, char** argv) {
+  int result = 0;
+
+  for (const string mode : {"direct", "broadcast", "gossip"}) {
+    vector<string> args;
+    for (int i = 0; i < argc; i++) {
+      const string arg = argv[i];
+      if (arg == "--mode" || arg == "-m") {
+        i++;
+        continue;
+      }
+      if (arg.compare(0, 7, "--mode=") == 0) {
+        continue;
+      }
+      args.emplace_back(arg);
+    }
+    args.emplace_back("--mode");
+    args.emplace_back(mode);
+
+    vector<char*> cargs;
+    for (auto& arg : args) {
+      cargs.emplace_back(&arg[0]);
+    }
+    cargs.emplace_back(nullptr);
+
+    pid_t pid = fork();
+    if (pid == 0) {
+      execv(self, cargs.data());
+      _exit(127);
+    }
+
+    int status = 0;
+    waitpid(pid, &status, 0);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      result = 1;
+    }
+  }
+
+  return result;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  BenchConfig config;
+
+  po::options_description desc("Options");
+  desc.add_options()("help,h", "Print help messages")(
+      "mode,m", po::value<string>(&config.m_mode),
+      "direct, broadcast, gossip or all (default)")(
+      "nodes,n", po::value<unsigned int>(&config.m_nodes),
+      "Number of receiving nodes")(
+      "payload,p", po::value<unsigned int>(&config.m_payload),
+      "Payload size in bytes")(
+      "messages,c", po::value<unsigned int>(&config.m_messages),
+      "Number of messages to send")(
+      "rate,r", po::value<unsigned int>(&config.m_rate),
+      "Messages per second to send, 0 for as fast as possible")(
+      "port", po::value<uint32_t>(&config.m_port), "First listening port")(
+      "timeout,t", po::value<unsigned int>(&config.m_timeout),
+      "Seconds to wait for all deliveries");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("help")) {
+      cout << desc << endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (boost::program_options::error& e) {
+    cerr << "ERROR: " << e.what() << endl << endl << desc << endl;
+    return 1;
+  }
+
+  if (config.m_nodes == 0) {
+    cerr << "ERROR: at least one node is needed" << endl;
+    return 1;
+  }
+
+  // Broken pipes must show up as write errors, not kill the sender
+  signal(SIGPIPE, SIG_IGN);
+
+  if (config.m_mode == "all") {
+    return RunAllModes("/proc/self/exe", argc, argv);
+  }
+
+  if (config.m_mode != "direct" && config.m_mode != "broadcast" &&
+      config.m_mode != "gossip") {
+    cerr << "ERROR: unknown mode " << config.m_mode << endl;
+    return 1;
+  }
+
+  return RunMode(config);
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <memory>
+
+#include "common/Constants.h"
+#include "common/Messages.h"
+#include "libNetwork/P2PComm.h"
+#include "libNetwork/PeerSendQueue.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE peersendqueue
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+PeerSendItem MakeItem(unsigned char tag) {
+  return {make_shared<const bytes>(bytes{tag}), START_BYTE_NORMAL, {}};
+}
+
+BOOST_AUTO_TEST_SUITE(peersendqueue)
+
+BOOST_AUTO_TEST_CASE(test_priority_order) {
+  INIT_STDOUT_LOGGER();
+
+  PeerSendQueue& queue = PeerSendQueue::GetInstance();
+  queue.Clear();
+
+  Peer peer(0x0100007F, 30303);
+
+  BOOST_CHECK_MESSAGE(queue.Push(peer, SEND_LANE_GOSSIP, MakeItem(1)),
+                      "First message should start a drain!");
+  BOOST_CHECK_MESSAGE(!queue.Push(peer, SEND_LANE_TXN, MakeItem(2)),
+                      "Peer already being drained should not start another!");
+  BOOST_CHECK(!queue.Push(peer, SEND_LANE_CONSENSUS, MakeItem(3)));
+  BOOST_CHECK(!queue.Push(peer, SEND_LANE_CONSENSUS, MakeItem(4)));
+
+  BOOST_CHECK(queue.GetLaneDepth(SEND_LANE_CONSENSUS) == 2);
+
+  const vector<unsigned char> expected = {3, 4, 2, 1};
+  for (const auto& tag : expected) {
+    PeerSendItem item;
+    BOOST_REQUIRE(queue.Pop(peer, item));
+    const unsigned char got = item.m_message->at(0);
+    BOOST_CHECK_MESSAGE(got == tag, "Expected message " << (unsigned int)tag
+                                                        << ", got "
+                                                        << (unsigned int)got);
+  }
+
+  PeerSendItem item;
+  BOOST_CHECK_MESSAGE(!queue.Pop(peer, item), "Queue should be drained!");
+  BOOST_CHECK_MESSAGE(queue.Push(peer, SEND_LANE_BLOCK, MakeItem(5)),
+                      "Drained peer should need a new drain!");
+  queue.Clear();
+}
+
+BOOST_AUTO_TEST_CASE(test_drop_policy) {
+  INIT_STDOUT_LOGGER();
+
+  PeerSendQueue& queue = PeerSendQueue::GetInstance();
+  queue.Clear();
+
+  Peer peer(0x0100007F, 30303);
+
+  for (unsigned int i = 0; i < PEER_SEND_QUEUE_MAX_DEPTH; i++) {
+    queue.Push(peer, SEND_LANE_GOSSIP, MakeItem(0));
+  }
+
+  // A full queue makes room for urgent messages at the expense of gossip
+  queue.Push(peer, SEND_LANE_CONSENSUS, MakeItem(1));
+  BOOST_CHECK(queue.GetLaneDropped(SEND_LANE_GOSSIP) == 1);
+  BOOST_CHECK(queue.GetLaneDepth(SEND_LANE_CONSENSUS) == 1);
+  BOOST_CHECK(queue.GetLaneDepth(SEND_LANE_GOSSIP) ==
+              PEER_SEND_QUEUE_MAX_DEPTH - 1);
+
+  // ... but more gossip is simply dropped
+  queue.Push(peer, SEND_LANE_GOSSIP, MakeItem(2));
+  BOOST_CHECK(queue.GetLaneDropped(SEND_LANE_GOSSIP) == 2);
+  BOOST_CHECK(queue.GetLaneDepth(SEND_LANE_GOSSIP) ==
+              PEER_SEND_QUEUE_MAX_DEPTH - 1);
+
+  queue.Clear();
+}
+
+BOOST_AUTO_TEST_CASE(test_send_lane) {
+  INIT_STDOUT_LOGGER();
+
+  BOOST_CHECK(P2PComm::GetSendLane({MessageType::DIRECTORY,
+                                    DSInstructionType::FINALBLOCKCONSENSUS},
+                                   START_BYTE_NORMAL) == SEND_LANE_CONSENSUS);
+  BOOST_CHECK(P2PComm::GetSendLane({MessageType::NODE,
+                                    NodeInstructionType::FINALBLOCK},
+                                   START_BYTE_BROADCAST) == SEND_LANE_BLOCK);
+  BOOST_CHECK(P2PComm::GetSendLane({MessageType::NODE,
+                                    NodeInstructionType::FORWARDTXNPACKET},
+                                   START_BYTE_NORMAL) == SEND_LANE_TXN);
+  BOOST_CHECK(P2PComm::GetSendLane({MessageType::NODE,
+                                    NodeInstructionType::MICROBLOCKCONSENSUS},
+                                   START_BYTE_GOSSIP) == SEND_LANE_GOSSIP);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
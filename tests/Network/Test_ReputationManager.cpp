@@ -201,4 +201,44 @@ BOOST_AUTO_TEST_CASE(test_rep_underflow) {
   tearDown();
 }
 
+BOOST_AUTO_TEST_CASE(test_rep_after_awards) {
+  setup();
+  ReputationManager& rm = ReputationManager::GetInstance();
+
+  const int32_t penalty =
+      4 * ReputationManager::PenaltyType::PENALTY_INVALID_MESSAGE;
+  rm.PunishNode(node2, penalty);
+  rm.AwardAllNodes();
+  rm.AwardAllNodes();
+
+  int32_t result = rm.GetReputation(node2);
+  int32_t expected =
+      penalty + 2 * ReputationManager::ScoreType::AWARD_FOR_GOOD_NODES;
+  BOOST_CHECK_MESSAGE(result == expected, "Reputation after awards: "
+                                              << result
+                                              << ". Expected: " << expected);
+  tearDown();
+}
+
+BOOST_AUTO_TEST_CASE(test_new_node_not_awarded_for_past_rounds) {
+  setup();
+  ReputationManager& rm = ReputationManager::GetInstance();
+
+  rm.AwardAllNodes();
+  rm.AwardAllNodes();
+
+  boost::multiprecision::uint128_t node3;
+  BOOST_CHECK(IPConverter::ToNumericalIPFromStr("10.0.0.1", node3));
+  int32_t result = rm.GetReputation(node3);
+  BOOST_CHECK_MESSAGE(result == ReputationManager::ScoreType::GOOD,
+                      "Reputation of node added after awards: " << result);
+
+  rm.AwardAllNodes();
+  result = rm.GetReputation(node3);
+  BOOST_CHECK_MESSAGE(
+      result == ReputationManager::ScoreType::AWARD_FOR_GOOD_NODES,
+      "Reputation of node added after awards, awarded once: " << result);
+  tearDown();
+}
+
 BOOST_AUTO_TEST_SUITE_END()
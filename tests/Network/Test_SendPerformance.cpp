@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <thread>
+
+#include "libNetwork/P2PComm.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE sendperformance
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+static atomic<uint64_t> g_allocCount{0};
+static atomic<uint64_t> g_allocBytes{0};
+
+void* operator new(size_t size) {
+  g_allocCount++;
+  g_allocBytes += size;
+  void* p = malloc(size);
+  if (p == nullptr) {
+    throw bad_alloc();
+  }
+  return p;
+}
+
+void operator delete(void* p) noexcept { free(p); }
+
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+/// Exposes the framing path of SendJob so it can be driven over a socketpair
+class BenchSendJob : public SendJob {
+ public:
+  using SendJob::writeFrame;
+  void DoSend() {}
+};
+
+void RunSendBenchmark(const size_t payloadSize, const unsigned int numSends,
+                      const unsigned char startByte) {
+  int fds[2];
+  BOOST_REQUIRE(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+
+  const bytes payload(payloadSize, 0xAB);
+  const bytes hash(32, 0xCD);
+  const Peer peer(0x0100007F, 30303);
+
+  // Drain the other end so the writer never blocks on a full socket buffer
+  atomic<uint64_t> received{0};
+  thread reader([&fds, &received]() {
+    vector<unsigned char> buf(1 << 20);
+    ssize_t n;
+    while ((n = read(fds[1], buf.data(), buf.size())) > 0) {
+      received += n;
+    }
+  });
+
+  const uint64_t allocCountBefore = g_allocCount;
+  const uint64_t allocBytesBefore = g_allocBytes;
+  auto start = chrono::steady_clock::now();
+
+  for (unsigned int i = 0; i < numSends; ++i) {
+    BOOST_CHECK(
+        BenchSendJob::writeFrame(fds[0], peer, payload, startByte, hash));
+  }
+
+  auto elapsed = chrono::duration_cast<chrono::microseconds>(
+                     chrono::steady_clock::now() - start)
+                     .count();
+  const uint64_t allocCount = g_allocCount - allocCountBefore;
+  const uint64_t allocBytes = g_allocBytes - allocBytesBefore;
+
+  shutdown(fds[0], SHUT_WR);
+  reader.join();
+  close(fds[0]);
+  close(fds[1]);
+
+  const uint64_t totalBytes = (uint64_t)payloadSize * numSends;
+  LOG_GENERAL(INFO, "Payload " << payloadSize << " bytes x " << numSends
+                               << ": "
+                               << (elapsed > 0 ? totalBytes * 1000000 / elapsed
+                                               : 0)
+                               << " bytes/s, "
+                               << (double)allocCount / numSends
+                               << " allocations/send, "
+                               << (double)allocBytes / numSends
+                               << " bytes allocated/send");
+
+  BOOST_CHECK_MESSAGE(received >= totalBytes,
+                      "Reader received " << received << " of " << totalBytes
+                                         << " payload bytes");
+
+  // The body must go out from the caller's buffer, never through a copy
+  BOOST_CHECK_MESSAGE(allocBytes / numSends < payloadSize,
+                      "Send path allocated " << allocBytes / numSends
+                                             << " bytes per send for a "
+                                             << payloadSize
+                                             << " bytes payload");
+}
+
+BOOST_AUTO_TEST_SUITE(sendperformance)
+
+BOOST_AUTO_TEST_CASE(test_normal_small) {
+  INIT_STDOUT_LOGGER();
+  RunSendBenchmark(1024, 10000, START_BYTE_NORMAL);
+}
+
+BOOST_AUTO_TEST_CASE(test_normal_large) {
+  INIT_STDOUT_LOGGER();
+  RunSendBenchmark(1024 * 1024, 200, START_BYTE_NORMAL);
+}
+
+BOOST_AUTO_TEST_CASE(test_broadcast_final_block) {
+  INIT_STDOUT_LOGGER();
+  RunSendBenchmark(10 * 1024 * 1024, 20, START_BYTE_BROADCAST);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
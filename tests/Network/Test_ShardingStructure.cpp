@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "libNetwork/ShardingStructure.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE shardingstructure
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(shardingstructure)
+
+BOOST_AUTO_TEST_CASE(test_find) {
+  INIT_STDOUT_LOGGER();
+
+  DequeOfShard shards(3);
+  vector<PubKey> keys;
+  for (unsigned int i = 0; i < 10; i++) {
+    keys.emplace_back(Schnorr::GetInstance().GenKeyPair().second);
+    shards[i % 3].emplace_back(keys.back(), Peer(0x0100007F, 30303 + i), i);
+  }
+
+  const ShardingStructurePtr shardingStructure =
+      make_shared<ShardingStructure>(shards);
+  BOOST_CHECK_EQUAL(shardingStructure->GetNumShards(), 3);
+  BOOST_CHECK_EQUAL(shardingStructure->GetNumNodes(), 10);
+  BOOST_CHECK(shardingStructure->GetShards() == shards);
+
+  for (unsigned int i = 0; i < keys.size(); i++) {
+    ShardingStructure::Position position;
+    BOOST_REQUIRE(shardingStructure->Find(keys[i], position));
+    BOOST_CHECK_EQUAL(position.shardId, i % 3);
+    BOOST_CHECK_EQUAL(position.index, i / 3);
+  }
+
+  ShardingStructure::Position position;
+  BOOST_CHECK(!shardingStructure->Find(
+      Schnorr::GetInstance().GenKeyPair().second, position));
+}
+
+BOOST_AUTO_TEST_CASE(test_empty) {
+  INIT_STDOUT_LOGGER();
+
+  const ShardingStructure shardingStructure{DequeOfShard()};
+  BOOST_CHECK_EQUAL(shardingStructure.GetNumShards(), 0);
+  BOOST_CHECK_EQUAL(shardingStructure.GetNumNodes(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
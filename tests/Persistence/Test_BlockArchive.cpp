@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <map>
+#include <string>
+
+#include "libPersistence/BlockArchive.h"
+#include "libUtils/Logger.h"
+
+#include <boost/filesystem.hpp>
+
+#define BOOST_TEST_MODULE blockarchivetest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(blockarchivetest)
+
+BOOST_AUTO_TEST_CASE(testSealAndLookup) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+
+  const string path = "blockArchive";
+  boost::filesystem::remove_all(path);
+
+  map<dev::h256, bytes> first;
+  map<dev::h256, bytes> second;
+  for (unsigned int i = 0; i < 100; i++) {
+    first.emplace(dev::h256::random(), bytes(i, (uint8_t)i));
+    second.emplace(dev::h256::random(), bytes(i + 1, (uint8_t)(i + 1)));
+  }
+
+  {
+    BlockArchive archive;
+    BOOST_CHECK(archive.Open(path));
+    BOOST_CHECK(archive.Seal("0_0", first));
+    BOOST_CHECK(archive.Seal("1_1", second));
+    // Segments are immutable
+    BOOST_CHECK(!archive.Seal("0_0", second));
+    BOOST_CHECK_EQUAL(2, archive.GetNumSegments());
+  }
+
+  // Reopen from disk
+  BlockArchive archive;
+  BOOST_CHECK(archive.Open(path));
+  BOOST_CHECK_EQUAL(2, archive.GetNumSegments());
+
+  for (const auto& entries : {first, second}) {
+    for (const auto& entry : entries) {
+      bytes value;
+      BOOST_CHECK(archive.Lookup(entry.first, value));
+      BOOST_CHECK(value == entry.second);
+    }
+  }
+
+  bytes value;
+  BOOST_CHECK(!archive.Lookup(dev::h256::random(), value));
+
+  boost::filesystem::remove_all(path);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,58 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "libPersistence/ContractStorage.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE contractcodetest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace Contract;
+
+BOOST_AUTO_TEST_SUITE(contractcodetest)
+
+BOOST_AUTO_TEST_CASE(testCodeCache) {
+  INIT_STDOUT_LOGGER();
+
+  ContractStorage& cs = ContractStorage::GetContractStorage();
+  cs.Reset();
+
+  const dev::h160 address(1);
+  const bytes code1 = {'s', 'c', 'i', 'l', 'l', 'a', '1'};
+  const bytes code2 = {'s', 'c', 'i', 'l', 'l', 'a', '2'};
+
+  BOOST_CHECK(cs.PutContractCode(address, code1));
+  BOOST_CHECK(cs.GetContractCode(address) == code1);
+  // Served from the cache
+  BOOST_CHECK(cs.GetContractCode(address) == code1);
+
+  // A write replaces the cached code
+  BOOST_CHECK(cs.PutContractCode(address, code2));
+  BOOST_CHECK(cs.GetContractCode(address) == code2);
+
+  cs.PutContractCodeBatch({{address.hex(), string(code1.begin(), code1.end())}});
+  BOOST_CHECK(cs.GetContractCode(address) == code1);
+
+  BOOST_CHECK(cs.DeleteContractCode(address));
+  BOOST_CHECK(cs.GetContractCode(address).empty());
+
+  cs.LogCodeCacheStats();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
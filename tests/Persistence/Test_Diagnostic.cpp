@@ -114,6 +114,22 @@ BOOST_AUTO_TEST_CASE(testDiagnosticDataNodes) {
     BOOST_CHECK(diagnosticDataMap[i].dsCommittee == histDSCommittee.at(i));
   }
 
+  // Look-up by range, in order
+  uint64_t first = 0, last = 0;
+  BOOST_CHECK(
+      BlockStorage::GetBlockStorage().GetDiagnosticDataNodesRange(first, last));
+  BOOST_CHECK_EQUAL(first, 0u);
+  BOOST_CHECK_EQUAL(last, NUM_ENTRIES - 1);
+
+  vector<uint64_t> visited;
+  BlockStorage::GetBlockStorage().ForEachDiagnosticDataNodes(
+      3, 9, [&](uint64_t dsBlockNum, const DiagnosticDataNodes& entry) {
+        BOOST_CHECK(entry.shards == histShards.at(dsBlockNum));
+        visited.emplace_back(dsBlockNum);
+        return dsBlockNum < 6;
+      });
+  BOOST_CHECK(visited == vector<uint64_t>({3, 4, 5, 6}));
+
   // Test deletion of entries
   for (unsigned int i = 0; i < NUM_ENTRIES; i++) {
     // First, check the entry is still there
@@ -199,6 +215,23 @@ BOOST_AUTO_TEST_CASE(testDiagnosticDataCoinbase) {
     BOOST_CHECK(diagnosticDataMap[i] == histEntries.at(i));
   }
 
+  // Look-up by range, in order
+  uint64_t first = 0, last = 0;
+  BOOST_CHECK(BlockStorage::GetBlockStorage().GetDiagnosticDataCoinbaseRange(
+      first, last));
+  BOOST_CHECK_EQUAL(first, 0u);
+  BOOST_CHECK_EQUAL(last, NUM_ENTRIES - 1);
+
+  uint64_t next = 10;
+  BlockStorage::GetBlockStorage().ForEachDiagnosticDataCoinbase(
+      10, NUM_ENTRIES + 5,
+      [&](uint64_t dsBlockNum, const DiagnosticDataCoinbase& entry) {
+        BOOST_CHECK_EQUAL(dsBlockNum, next++);
+        BOOST_CHECK(entry == histEntries.at(dsBlockNum));
+        return true;
+      });
+  BOOST_CHECK_EQUAL(next, NUM_ENTRIES);
+
   // Test deletion of entries
   for (unsigned int i = 0; i < NUM_ENTRIES; i++) {
     // First, check the entry is still there
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "libPersistence/ContractStorage.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE statelayerstest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace Contract;
+
+BOOST_AUTO_TEST_SUITE(statelayerstest)
+
+BOOST_AUTO_TEST_CASE(testPushPopMerge) {
+  INIT_STDOUT_LOGGER();
+
+  StateLayers layers;
+  layers.Set("a", {1});
+  layers.Set("b", {2});
+
+  // Reverting a layer only drops what was changed on it
+  layers.Push();
+  layers.Set("a", {3});
+  layers.Set("c", {4});
+  BOOST_CHECK(*layers.Find("a") == bytes{3});
+  BOOST_CHECK(*layers.Find("b") == bytes{2});
+  layers.Pop();
+  BOOST_CHECK_EQUAL(1, layers.Depth());
+  BOOST_CHECK(*layers.Find("a") == bytes{1});
+  BOOST_CHECK(layers.Find("c") == nullptr);
+
+  // Merging keeps the changes
+  layers.Push();
+  layers.Set("a", {5});
+  layers.Merge();
+  BOOST_CHECK_EQUAL(1, layers.Depth());
+  BOOST_CHECK(*layers.Find("a") == bytes{5});
+
+  // The bottom layer is never popped
+  layers.Pop();
+  BOOST_CHECK(*layers.Find("b") == bytes{2});
+
+  layers.Clear();
+  BOOST_CHECK(layers.Find("a") == nullptr);
+  BOOST_CHECK_EQUAL(1, layers.Depth());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
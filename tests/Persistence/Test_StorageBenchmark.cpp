@@ -0,0 +1,463 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Benchmark of the storage paths that bound how fast a node commits a block:
+// the state trie, the LevelDB patterns of BlockStorage, the account store
+// flush and the contract state writes. Each case prints its throughput,
+// latency percentiles and the growth of the persistence directory, as one
+// CSV line or JSON object.
+//
+// Usage: Test_StorageBenchmark [--case PREFIX] [--keys N]... [--accounts N]...
+//            [--mapsize N]... [--rounds N] [--threads N] [--format csv|json]
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+#include <boost/program_options.hpp>
+
+#include "depends/common/FixedHash.h"
+#include "depends/common/SHA3.h"
+#include "depends/libDatabase/LevelDB.h"
+
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#include "depends/libDatabase/OverlayDB.h"
+#pragma GCC diagnostic pop
+
+#include "depends/libTrie/TrieDB.h"
+#include "libData/AccountData/AccountStore.h"
+#include "libPersistence/ContractStorage.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+using namespace dev;
+namespace po = boost::program_options;
+
+namespace {
+
+struct BenchConfig {
+  string m_case;
+  vector<unsigned int> m_keys{10000, 100000, 1000000};
+  vector<unsigned int> m_accounts{10000, 100000};
+  vector<unsigned int> m_mapSizes{1000, 10000};
+  unsigned int m_rounds = 5;
+  unsigned int m_threads = max(thread::hardware_concurrency(), 1u);
+  bool m_json = false;
+};
+
+/// Latencies of the operations of one case, in nanoseconds
+class Samples {
+  vector<uint64_t> m_nanos;
+  chrono::steady_clock::duration m_total{};
+
+ public:
+  void Reserve(size_t count) { m_nanos.reserve(count); }
+
+  template <class Op>
+  void Time(Op&& op) {
+    const auto start = chrono::steady_clock::now();
+    op();
+    const auto elapsed = chrono::steady_clock::now() - start;
+    m_nanos.emplace_back(
+        chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+    m_total += elapsed;
+  }
+
+  size_t Count() const { return m_nanos.size(); }
+
+  double TotalSeconds() const {
+    return chrono::duration<double>(m_total).count();
+  }
+
+  /// The latency below which the fraction p of the operations fall
+  double PercentileMicros(double p) {
+    if (m_nanos.empty()) {
+      return 0;
+    }
+    const size_t index =
+        min(m_nanos.size() - 1, static_cast<size_t>(p * m_nanos.size()));
+    nth_element(m_nanos.begin(), m_nanos.begin() + index, m_nanos.end());
+    return m_nanos[index] / 1e3;
+  }
+};
+
+bool Selected(const BenchConfig& config, const string& name) {
+  return config.m_case.empty() ||
+         name.compare(0, config.m_case.size(), config.m_case) == 0;
+}
+
+/// Bytes held under the persistence directory
+uint64_t PersistenceBytes() {
+  namespace fs = boost::filesystem;
+  uint64_t total = 0;
+  boost::system::error_code ec;
+  for (fs::recursive_directory_iterator it("./" + PERSISTENCE_PATH, ec), end;
+       !ec && it != end; it.increment(ec)) {
+    if (fs::is_regular_file(it->path(), ec)) {
+      total += fs::file_size(it->path(), ec);
+    }
+  }
+  return total;
+}
+
+/// Growth of the persistence directory since before, net of what LevelDB
+/// compacted away meanwhile, so it can be negative
+int64_t BytesSince(uint64_t before) {
+  return static_cast<int64_t>(PersistenceBytes()) -
+         static_cast<int64_t>(before);
+}
+
+void PrintHeader(const BenchConfig& config) {
+  if (!config.m_json) {
+    cout << "case,n,ops,ops_per_sec,p50_us,p90_us,p99_us,max_us,"
+            "bytes_written"
+         << endl;
+  }
+}
+
+void Report(const BenchConfig& config, const string& name, size_t n,
+            Samples& samples, int64_t bytesWritten) {
+  const double seconds = samples.TotalSeconds();
+  const double opsPerSec = seconds > 0 ? samples.Count() / seconds : 0;
+  const double p50 = samples.PercentileMicros(0.5);
+  const double p90 = samples.PercentileMicros(0.9);
+  const double p99 = samples.PercentileMicros(0.99);
+  const double pMax = samples.PercentileMicros(1.0);
+
+  cout << fixed << setprecision(1);
+  if (config.m_json) {
+    cout << "{\"case\":\"" << name << "\",\"n\":" << n
+         << ",\"ops\":" << samples.Count() << ",\"ops_per_sec\":" << opsPerSec
+         << ",\"p50_us\":" << p50 << ",\"p90_us\":" << p90
+         << ",\"p99_us\":" << p99 << ",\"max_us\":" << pMax
+         << ",\"bytes_written\":" << bytesWritten << "}" << endl;
+  } else {
+    cout << name << "," << n << "," << samples.Count() << "," << opsPerSec
+         << "," << p50 << "," << p90 << "," << p99 << "," << pMax << ","
+         << bytesWritten << endl;
+  }
+}
+
+h256 KeyOf(uint64_t i) { return sha3(to_string(i)); }
+
+/// About the size of an RLP encoded account
+bytes ValueOf(uint64_t i, size_t size = 70) {
+  bytes value(size, static_cast<unsigned char>(i));
+  const h256 hash = KeyOf(i);
+  copy(hash.begin(), hash.begin() + min<size_t>(size, h256::size),
+       value.begin());
+  return value;
+}
+
+/// Keys in a shuffled order, so that lookups do not follow insertion order
+vector<uint64_t> ShuffledIndexes(uint64_t count) {
+  vector<uint64_t> indexes(count);
+  for (uint64_t i = 0; i < count; i++) {
+    indexes[i] = i;
+  }
+  shuffle(indexes.begin(), indexes.end(), mt19937_64(count));
+  return indexes;
+}
+
+void RunTrie(const BenchConfig& config, unsigned int numKeys) {
+  if (!Selected(config, "trie.")) {
+    return;
+  }
+
+  {
+    OverlayDB db("benchTrie");
+    db.ResetDB();
+    GenericTrieDB<OverlayDB> trie(&db);
+    trie.init();
+
+    Samples insert;
+    insert.Reserve(numKeys);
+    for (uint64_t i = 0; i < numKeys; i++) {
+      const h256 key = KeyOf(i);
+      const bytes value = ValueOf(i);
+      insert.Time([&]() { trie.insert(key.ref(), value); });
+    }
+    Report(config, "trie.insert", numKeys, insert, 0);
+
+    const uint64_t before = PersistenceBytes();
+    Samples commit;
+    commit.Time([&]() {
+      db.commit();
+      db.waitCommitted();
+    });
+    Report(config, "trie.commit", numKeys, commit, BytesSince(before));
+
+    Samples lookup;
+    lookup.Reserve(numKeys);
+    for (const auto i : ShuffledIndexes(numKeys)) {
+      const h256 key = KeyOf(i);
+      lookup.Time([&]() { trie.at(key.ref()); });
+    }
+    Report(config, "trie.lookup", numKeys, lookup, 0);
+
+    db.ResetDB();
+  }
+
+  {
+    OverlayDB db("benchTrie");
+    db.ResetDB();
+    GenericTrieDB<OverlayDB> trie(&db);
+    trie.init();
+
+    vector<pair<bytes, bytes>> kvs;
+    kvs.reserve(numKeys);
+    for (uint64_t i = 0; i < numKeys; i++) {
+      kvs.emplace_back(KeyOf(i).asBytes(), ValueOf(i));
+    }
+
+    Samples insertBatch;
+    insertBatch.Time([&]() { trie.insertBatch(kvs, config.m_threads); });
+    Report(config, "trie.insertbatch", numKeys, insertBatch, 0);
+
+    db.ResetDB();
+  }
+}
+
+void RunLevelDB(const BenchConfig& config, unsigned int numKeys) {
+  if (!Selected(config, "leveldb.")) {
+    return;
+  }
+
+  LevelDB db("benchLevelDB");
+  db.ResetDB();
+
+  // Transaction bodies, keyed by their hash
+  uint64_t before = PersistenceBytes();
+  Samples putHash;
+  putHash.Reserve(numKeys);
+  for (uint64_t i = 0; i < numKeys; i++) {
+    const h256 key = KeyOf(i);
+    const bytes body = ValueOf(i, 300);
+    putHash.Time([&]() { db.Insert(key, body); });
+  }
+  Report(config, "leveldb.put.hash", numKeys, putHash, BytesSince(before));
+
+  Samples getHash;
+  getHash.Reserve(numKeys);
+  for (const auto i : ShuffledIndexes(numKeys)) {
+    const h256 key = KeyOf(i);
+    getHash.Time([&]() { db.Lookup(key); });
+  }
+  Report(config, "leveldb.get.hash", numKeys, getHash, 0);
+
+  // Blocks, keyed by their number and much fewer than the transactions
+  const unsigned int numBlocks = max(numKeys / 100, 1u);
+  before = PersistenceBytes();
+  Samples putBlock;
+  putBlock.Reserve(numBlocks);
+  for (uint64_t i = 0; i < numBlocks; i++) {
+    const bytes block = ValueOf(i, 16 * 1024);
+    putBlock.Time([&]() {
+      db.Insert(boost::multiprecision::uint256_t(i + numKeys), block);
+    });
+  }
+  Report(config, "leveldb.put.blocknum", numBlocks, putBlock,
+         BytesSince(before));
+
+  Samples getBlock;
+  getBlock.Reserve(numBlocks);
+  for (const auto i : ShuffledIndexes(numBlocks)) {
+    getBlock.Time([&]() {
+      db.Lookup(boost::multiprecision::uint256_t(i + numKeys));
+    });
+  }
+  Report(config, "leveldb.get.blocknum", numBlocks, getBlock, 0);
+
+  // The transaction bodies of a microblock, written in one batch
+  const unsigned int batchSize = 1000;
+  before = PersistenceBytes();
+  Samples batch;
+  for (uint64_t start = 0; start < numKeys; start += batchSize) {
+    ldb::WriteBatch writeBatch;
+    for (uint64_t i = start; i < min<uint64_t>(start + batchSize, numKeys);
+         i++) {
+      const h256 key = KeyOf(i + 2 * numKeys);
+      const bytes body = ValueOf(i, 300);
+      writeBatch.Put(ldb::Slice(reinterpret_cast<const char*>(key.data()),
+                                key.size),
+                     ldb::Slice(reinterpret_cast<const char*>(body.data()),
+                                body.size()));
+    }
+    batch.Time([&]() { db.BatchInsert(writeBatch); });
+  }
+  Report(config, "leveldb.batch", numKeys, batch, BytesSince(before));
+
+  db.ResetDB();
+}
+
+void RunAccountStore(const BenchConfig& config, unsigned int numAccounts) {
+  if (!Selected(config, "accountstore.")) {
+    return;
+  }
+
+  AccountStore& accountStore = AccountStore::GetInstance();
+  accountStore.Init();
+
+  vector<Address> addresses;
+  addresses.reserve(numAccounts);
+  for (uint64_t i = 0; i < numAccounts; i++) {
+    addresses.emplace_back(right160(KeyOf(i)));
+    accountStore.AddAccount(addresses.back(), Account(1000000, 0));
+  }
+
+  // The first flush writes the whole trie, later ones the accounts changed by
+  // a block, here a tenth of them
+  Samples updateTrie, moveToDisk;
+  int64_t written = 0;
+  for (unsigned int round = 0; round <= config.m_rounds; round++) {
+    if (round > 0) {
+      for (uint64_t i = round; i < numAccounts; i += 10) {
+        accountStore.IncreaseBalance(addresses[i], 1);
+      }
+    }
+
+    updateTrie.Time([&]() { accountStore.UpdateStateTrieAll(); });
+
+    const uint64_t before = PersistenceBytes();
+    moveToDisk.Time([&]() { accountStore.MoveUpdatesToDisk(); });
+    written += BytesSince(before);
+  }
+  Report(config, "accountstore.updatestatetrie", numAccounts, updateTrie, 0);
+  Report(config, "accountstore.movetodisk", numAccounts, moveToDisk, written);
+
+  accountStore.Init();
+}
+
+void RunContractStorage(const BenchConfig& config, unsigned int mapSize) {
+  if (!Selected(config, "contractstorage.")) {
+    return;
+  }
+
+  Contract::ContractStorage& storage =
+      Contract::ContractStorage::GetContractStorage();
+  storage.Reset();
+
+  // One contract holding a large map, like the balances of a token
+  const Address address = right160(KeyOf(mapSize));
+  vector<pair<Contract::Index, bytes>> entries;
+  entries.reserve(mapSize);
+  for (uint64_t i = 0; i < mapSize; i++) {
+    entries.emplace_back(
+        Contract::GetIndex(address, "balances." + to_string(i)),
+        ValueOf(i, 32));
+  }
+
+  h256 stateHash;
+  Samples putFull;
+  putFull.Time([&]() {
+    storage.PutContractState(address, entries, stateHash, false, false);
+  });
+  Report(config, "contractstorage.put.full", mapSize, putFull, 0);
+
+  // A block of transfers changes a hundredth of the map
+  Samples putUpdate;
+  for (unsigned int round = 1; round <= config.m_rounds; round++) {
+    vector<pair<Contract::Index, bytes>> changed;
+    for (uint64_t i = round; i < mapSize; i += 100) {
+      changed.emplace_back(entries[i].first, ValueOf(i + round, 32));
+    }
+    putUpdate.Time([&]() {
+      storage.PutContractState(address, changed, stateHash, false, true);
+    });
+  }
+  Report(config, "contractstorage.put.update", mapSize, putUpdate, 0);
+
+  const uint64_t before = PersistenceBytes();
+  Samples commit;
+  commit.Time([&]() { storage.CommitStateDB(); });
+  Report(config, "contractstorage.commit", mapSize, commit,
+         BytesSince(before));
+
+  storage.Reset();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  BenchConfig config;
+  string format = "csv";
+
+  po::options_description desc("Options");
+  desc.add_options()("help,h", "Print help messages")(
+      "case,c", po::value<string>(&config.m_case),
+      "Only run the cases whose names start with this")(
+      "keys,k", po::value<vector<unsigned int>>(&config.m_keys)->multitoken(),
+      "Key counts for the trie and LevelDB cases")(
+      "accounts,a",
+      po::value<vector<unsigned int>>(&config.m_accounts)->multitoken(),
+      "Account counts for the account store cases")(
+      "mapsize,m",
+      po::value<vector<unsigned int>>(&config.m_mapSizes)->multitoken(),
+      "Map sizes for the contract storage cases")(
+      "rounds,r", po::value<unsigned int>(&config.m_rounds),
+      "Blocks of updates applied after the initial write")(
+      "threads,t", po::value<unsigned int>(&config.m_threads),
+      "Threads for the batched trie insert")(
+      "format,f", po::value<string>(&format), "Output format, csv or json");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, desc), vm);
+    if (vm.count("help")) {
+      cout << desc << endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (boost::program_options::error& e) {
+    cerr << "ERROR: " << e.what() << endl << endl << desc << endl;
+    return 1;
+  }
+
+  if (format != "csv" && format != "json") {
+    cerr << "ERROR: unknown format " << format << endl << endl
+         << desc << endl;
+    return 1;
+  }
+  config.m_json = (format == "json");
+
+  INIT_STDOUT_LOGGER();
+
+  PrintHeader(config);
+
+  for (const auto numKeys : config.m_keys) {
+    RunTrie(config, numKeys);
+    RunLevelDB(config, numKeys);
+  }
+
+  for (const auto numAccounts : config.m_accounts) {
+    RunAccountStore(config, numAccounts);
+  }
+
+  for (const auto mapSize : config.m_mapSizes) {
+    RunContractStorage(config, mapSize);
+  }
+
+  return 0;
+}
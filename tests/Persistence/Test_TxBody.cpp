@@ -169,4 +169,120 @@ BOOST_AUTO_TEST_CASE(testRandomBlockAccesses) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(testEpochWrites) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+  if (LOOKUP_NODE_MODE) {
+    EpochWrites writes;
+    vector<TransactionWithReceipt> bodies;
+    for (int i = 5; i < 10; i++) {
+      bodies.emplace_back(constructDummyTxBody(i));
+      bytes serializedTxBody;
+      bodies.back().Serialize(serializedTxBody, 0);
+      writes.AddTxBody(bodies.back().GetTransaction().GetTranID(),
+                       serializedTxBody);
+    }
+
+    const bytes stateDelta{1, 2, 3};
+    writes.AddStateDelta(100, stateDelta);
+
+    BOOST_CHECK(BlockStorage::GetBlockStorage().PutEpochWrites(writes));
+
+    for (const auto& body : bodies) {
+      TxBodySharedPtr bodyRetrieved;
+      BOOST_CHECK(BlockStorage::GetBlockStorage().GetTxBody(
+          body.GetTransaction().GetTranID(), bodyRetrieved));
+      BOOST_CHECK(body.GetTransaction().GetTranID() ==
+                  bodyRetrieved->GetTransaction().GetTranID());
+    }
+
+    bytes stateDeltaRetrieved;
+    BOOST_CHECK(BlockStorage::GetBlockStorage().GetStateDelta(
+        100, stateDeltaRetrieved));
+    BOOST_CHECK(stateDelta == stateDeltaRetrieved);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testMicroBlockTxns) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+  if (LOOKUP_NODE_MODE) {
+    EpochWrites writes;
+    const bytes microBlock{7, 8, 9};
+    vector<bytes> txBodies;
+    for (int i = 10; i < 13; i++) {
+      txBodies.emplace_back();
+      constructDummyTxBody(i).Serialize(txBodies.back(), 0);
+    }
+    writes.AddMicroBlockTxns(300, 2, microBlock, txBodies);
+
+    BOOST_CHECK(BlockStorage::GetBlockStorage().PutEpochWrites(writes));
+
+    bytes record;
+    BOOST_CHECK(
+        BlockStorage::GetBlockStorage().GetMicroBlockTxns(300, 2, record));
+    BOOST_CHECK(
+        !BlockStorage::GetBlockStorage().GetMicroBlockTxns(300, 3, record));
+
+    bytes microBlockRetrieved;
+    vector<bytes> txBodiesRetrieved;
+    BOOST_CHECK(BlockStorage::UnpackMicroBlockTxns(record, microBlockRetrieved,
+                                                   txBodiesRetrieved));
+    BOOST_CHECK(microBlock == microBlockRetrieved);
+    BOOST_CHECK(txBodies == txBodiesRetrieved);
+
+    // A truncated record is refused rather than read past its end
+    record.pop_back();
+    BOOST_CHECK(!BlockStorage::UnpackMicroBlockTxns(
+        record, microBlockRetrieved, txBodiesRetrieved));
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testTxBodyMiss) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+  if (LOOKUP_NODE_MODE) {
+    TransactionWithReceipt body = constructDummyTxBody(10);
+    auto tx_hash = body.GetTransaction().GetTranID();
+
+    // The second miss is answered from the cache
+    TxBodySharedPtr bodyRetrieved;
+    BOOST_CHECK(!BlockStorage::GetBlockStorage().GetTxBody(tx_hash,
+                                                           bodyRetrieved));
+    BOOST_CHECK(!BlockStorage::GetBlockStorage().GetTxBody(tx_hash,
+                                                           bodyRetrieved));
+
+    // Storing the body replaces the recorded miss
+    bytes serializedTxBody;
+    body.Serialize(serializedTxBody, 0);
+    BlockStorage::GetBlockStorage().PutTxBody(tx_hash, serializedTxBody);
+    BOOST_CHECK(
+        BlockStorage::GetBlockStorage().GetTxBody(tx_hash, bodyRetrieved));
+    BOOST_CHECK(tx_hash == bodyRetrieved->GetTransaction().GetTranID());
+  }
+}
+
+BOOST_AUTO_TEST_CASE(testPruneStateDeltas) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+
+  const bytes stateDelta{4, 5, 6};
+  for (uint64_t i = 200; i < 210; i++) {
+    BlockStorage::GetBlockStorage().PutStateDelta(i, stateDelta);
+  }
+
+  BOOST_CHECK(BlockStorage::GetBlockStorage().PruneHistory(205, 0));
+
+  for (uint64_t i = 200; i < 210; i++) {
+    bytes stateDeltaRetrieved;
+    BOOST_CHECK_EQUAL(
+        i >= 205,
+        BlockStorage::GetBlockStorage().GetStateDelta(i, stateDeltaRetrieved));
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -326,4 +326,41 @@ BOOST_AUTO_TEST_CASE(testRetrieveAllTheTxBlocksInDB) {
   }
 }
 
+BOOST_AUTO_TEST_CASE(testRetrieveTxBlocksByRange) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+
+  BOOST_REQUIRE(
+      BlockStorage::GetBlockStorage().ResetDB(BlockStorage::DBTYPE::TX_BLOCK));
+
+  // Spans keys whose string order differs from their number order
+  for (int i = 5; i < 25; i++) {
+    writeBlock(i);
+  }
+
+  uint64_t lowest = 0, highest = 0;
+  BOOST_CHECK(
+      BlockStorage::GetBlockStorage().GetTxBlockNumRange(lowest, highest));
+  BOOST_CHECK_EQUAL(lowest, 5);
+  BOOST_CHECK_EQUAL(highest, 24);
+
+  std::list<TxBlockSharedPtr> blocks;
+  BOOST_CHECK(BlockStorage::GetBlockStorage().GetTxBlocks(8, 12, blocks));
+  BOOST_REQUIRE_EQUAL(blocks.size(), 5);
+  uint64_t blockNum = 8;
+  for (const auto& block : blocks) {
+    BOOST_CHECK_EQUAL(block->GetHeader().GetBlockNum(), blockNum++);
+  }
+
+  BOOST_CHECK(!BlockStorage::GetBlockStorage().GetTxBlocks(20, 25, blocks));
+
+  // Too few blocks to fill the window, so all of them
+  blocks.clear();
+  BOOST_CHECK(BlockStorage::GetBlockStorage().GetRecentTxBlocks(blocks));
+  BOOST_REQUIRE_EQUAL(blocks.size(), 20);
+  BOOST_CHECK_EQUAL(blocks.front()->GetHeader().GetBlockNum(), 5);
+  BOOST_CHECK_EQUAL(blocks.back()->GetHeader().GetBlockNum(), 24);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
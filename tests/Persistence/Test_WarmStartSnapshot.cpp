@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <fstream>
+#include <map>
+#include <string>
+
+#include "libPersistence/WarmStartSnapshot.h"
+#include "libUtils/Logger.h"
+
+#include <boost/filesystem.hpp>
+
+#define BOOST_TEST_MODULE warmstartsnapshottest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(warmstartsnapshottest)
+
+BOOST_AUTO_TEST_CASE(testWriteEveryIntervalAndRead) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+
+  const string filename = "warmStartSnapshot";
+  boost::filesystem::remove(filename);
+
+  WarmStartSnapshot snapshot(filename, 10, 5);
+  map<uint64_t, bytes> blocks;
+  BOOST_CHECK(!snapshot.Read(blocks));
+
+  for (uint64_t i = 0; i < 14; i++) {
+    snapshot.Add(i, bytes(i + 1, (uint8_t)i));
+  }
+  snapshot.WaitForWrites();
+
+  // Written after block 9, keeping the 10 newest blocks then
+  BOOST_CHECK(snapshot.Read(blocks));
+  BOOST_CHECK_EQUAL(10, blocks.size());
+  BOOST_CHECK_EQUAL(0, blocks.begin()->first);
+  BOOST_CHECK_EQUAL(9, blocks.rbegin()->first);
+  for (const auto& block : blocks) {
+    BOOST_CHECK(block.second == bytes(block.first + 1, (uint8_t)block.first));
+  }
+
+  BOOST_CHECK(snapshot.Write());
+  BOOST_CHECK(snapshot.Read(blocks));
+  BOOST_CHECK_EQUAL(4, blocks.begin()->first);
+  BOOST_CHECK_EQUAL(13, blocks.rbegin()->first);
+
+  // Only the newest consecutive blocks are written
+  snapshot.Remove(8);
+  BOOST_CHECK(snapshot.Write());
+  BOOST_CHECK(snapshot.Read(blocks));
+  BOOST_CHECK_EQUAL(5, blocks.size());
+  BOOST_CHECK_EQUAL(9, blocks.begin()->first);
+
+  snapshot.Clear();
+  BOOST_CHECK(!boost::filesystem::exists(filename));
+  BOOST_CHECK(!snapshot.Write());
+}
+
+BOOST_AUTO_TEST_CASE(testCorruptedSnapshot) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+
+  const string filename = "warmStartSnapshot";
+  boost::filesystem::remove(filename);
+
+  WarmStartSnapshot snapshot(filename, 10, 100);
+  map<uint64_t, bytes> blocks;
+  for (uint64_t i = 0; i < 3; i++) {
+    blocks.emplace(i, bytes(100, (uint8_t)i));
+  }
+  snapshot.Reset(move(blocks));
+  BOOST_CHECK(snapshot.Write());
+
+  const auto size = boost::filesystem::file_size(filename);
+  boost::filesystem::resize_file(filename, size - 1);
+  BOOST_CHECK(!snapshot.Read(blocks));
+
+  // Truncated inside a block, with a valid footer after it
+  BOOST_CHECK(snapshot.Write());
+  {
+    ifstream in(filename, ios::binary);
+    string data((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    data.erase(50, 10);
+    ofstream out(filename, ios::binary | ios::trunc);
+    out << data;
+  }
+  BOOST_CHECK(!snapshot.Read(blocks));
+
+  boost::filesystem::remove(filename);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,123 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <fstream>
+#include <future>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <boost/filesystem.hpp>
+
+#include "libUtils/AsyncFileWriter.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE asyncfilewriter
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+namespace {
+bytes ReadFile(const string& filename) {
+  ifstream file(filename, ios::binary);
+  return bytes((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
+
+void TestWrites(const bool useIoUring) {
+  // Fewer entries than files, so that the ring is reused within a batch
+  AsyncFileWriter writer(useIoUring, 2);
+  if (!useIoUring) {
+    BOOST_CHECK(!writer.UsesIoUring());
+  }
+
+  const unsigned int numFiles = 8;
+  vector<string> filenames;
+  vector<bytes> contents;
+  vector<future<bool>> results;
+  for (unsigned int i = 0; i < numFiles; i++) {
+    filenames.emplace_back("asyncFileWriter" + to_string(i));
+    // Includes an empty file, and one over many pages
+    contents.emplace_back(i * i * 10000, static_cast<uint8_t>(i));
+    {
+      ofstream stale(filenames.back(), ios::binary);
+      stale << string(1000000, 'x');
+    }
+
+    auto done = make_shared<promise<bool>>();
+    results.emplace_back(done->get_future());
+    writer.Write(filenames.back(), bytes(contents.back()),
+                 [done](bool ok) { done->set_value(ok); });
+  }
+
+  for (unsigned int i = 0; i < numFiles; i++) {
+    BOOST_REQUIRE(results[i].wait_for(chrono::seconds(10)) ==
+                  future_status::ready);
+    BOOST_CHECK(results[i].get());
+    BOOST_CHECK(ReadFile(filenames[i]) == contents[i]);
+    boost::filesystem::remove(filenames[i]);
+  }
+}
+}  // namespace
+
+BOOST_AUTO_TEST_SUITE(asyncfilewriter)
+
+BOOST_AUTO_TEST_CASE(test_writes_directly) {
+  INIT_STDOUT_LOGGER();
+
+  TestWrites(false);
+}
+
+BOOST_AUTO_TEST_CASE(test_writes_through_io_uring) {
+  INIT_STDOUT_LOGGER();
+
+  // Falls back to writing directly where io_uring is not allowed
+  TestWrites(true);
+}
+
+BOOST_AUTO_TEST_CASE(test_reports_failure) {
+  INIT_STDOUT_LOGGER();
+
+  AsyncFileWriter writer(true, 2);
+
+  promise<bool> done;
+  writer.Write("noSuchDirectory/asyncFileWriter", bytes(10),
+               [&done](bool ok) { done.set_value(ok); });
+  auto result = done.get_future();
+  BOOST_REQUIRE(result.wait_for(chrono::seconds(10)) == future_status::ready);
+  BOOST_CHECK(!result.get());
+}
+
+BOOST_AUTO_TEST_CASE(test_callbacks_run_before_destruction) {
+  INIT_STDOUT_LOGGER();
+
+  bool chainedOk = false;
+  {
+    AsyncFileWriter writer(true, 2);
+    // A callback that queues another write, which is still done
+    writer.Write("asyncFileWriter", bytes(10), [&](bool ok) {
+      BOOST_CHECK(ok);
+      writer.Write("asyncFileWriter", bytes(20),
+                   [&chainedOk](bool ok) { chainedOk = ok; });
+    });
+  }
+  BOOST_CHECK(chainedOk);
+  BOOST_CHECK_EQUAL(ReadFile("asyncFileWriter").size(), 20);
+  boost::filesystem::remove("asyncFileWriter");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <random>
+#include <vector>
+#include "libUtils/BitVector.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE bitvector
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(bitvector)
+
+vector<bool> RandomBits(mt19937& rng, size_t size) {
+  vector<bool> bits(size);
+  for (size_t i = 0; i < size; i++) {
+    bits[i] = rng() % 3 == 0;
+  }
+  return bits;
+}
+
+BOOST_AUTO_TEST_CASE(test_matches_vector_of_bool) {
+  INIT_STDOUT_LOGGER();
+
+  mt19937 rng(1);
+  for (const size_t size : {0, 1, 7, 8, 63, 64, 65, 600, 1024}) {
+    const vector<bool> bits = RandomBits(rng, size);
+    const BitVector packed(bits);
+
+    BOOST_CHECK_EQUAL(packed.size(), size);
+    BOOST_CHECK(packed.ToVector() == bits);
+    BOOST_CHECK_EQUAL(packed.Count(),
+                      (size_t)count(bits.begin(), bits.end(), true));
+
+    vector<size_t> set;
+    packed.ForEachSet([&set](size_t index) { set.push_back(index); });
+    vector<size_t> expected;
+    for (size_t i = 0; i < size; i++) {
+      if (bits[i]) {
+        expected.push_back(i);
+      }
+    }
+    BOOST_CHECK(set == expected);
+
+    // Same bytes as the bit by bit encoding of the vector
+    bytes fromPacked, fromBits;
+    BitVector::SetBitVector(fromPacked, 0, packed);
+    BOOST_CHECK_EQUAL(BitVector::SetBitVector(fromBits, 0, bits),
+                      fromPacked.size());
+    BOOST_CHECK(fromPacked == fromBits);
+    BOOST_CHECK(BitVector::GetBitVector(fromPacked, 0) == bits);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_bitwise_operations) {
+  INIT_STDOUT_LOGGER();
+
+  mt19937 rng(2);
+  const vector<bool> a = RandomBits(rng, 600), b = RandomBits(rng, 600);
+
+  BitVector both(a), either(a), different(a);
+  both &= BitVector(b);
+  either |= BitVector(b);
+  different ^= BitVector(b);
+
+  size_t numDifferent = 0;
+  for (size_t i = 0; i < a.size(); i++) {
+    BOOST_CHECK_EQUAL(both[i], a[i] && b[i]);
+    BOOST_CHECK_EQUAL(either[i], a[i] || b[i]);
+    BOOST_CHECK_EQUAL(different[i], a[i] != b[i]);
+    numDifferent += a[i] != b[i];
+  }
+  BOOST_CHECK_EQUAL(BitVector(a).CountDifferent(BitVector(b)), numDifferent);
+  BOOST_CHECK_EQUAL(different.Count(), numDifferent);
+}
+
+BOOST_AUTO_TEST_CASE(test_resize_and_fill) {
+  INIT_STDOUT_LOGGER();
+
+  BitVector bits(10);
+  bits.at(3) = true;
+  BOOST_CHECK(bits.at(3));
+  BOOST_CHECK_THROW(bits.at(10), out_of_range);
+
+  bits.resize(70, true);
+  BOOST_CHECK_EQUAL(bits.Count(), 61);
+  BOOST_CHECK(!bits[9] && bits[10] && bits[69]);
+
+  bits.resize(5);
+  BOOST_CHECK_EQUAL(bits.Count(), 1);
+  bits.resize(64);
+  BOOST_CHECK_EQUAL(bits.Count(), 1);
+
+  bits.Fill(true);
+  BOOST_CHECK_EQUAL(bits.Count(), 64);
+  BOOST_CHECK(bits == BitVector(64, true));
+  bits.Fill(false);
+  BOOST_CHECK(bits == BitVector(64));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
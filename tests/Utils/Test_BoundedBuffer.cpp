@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+
+#include "libUtils/BoundedBuffer.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE boundedbuffertest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(boundedbuffertest)
+
+BOOST_AUTO_TEST_CASE(test_drop_oldest_over_budget) {
+  INIT_STDOUT_LOGGER();
+
+  BoundedBuffer<string> buffer(10);
+
+  BOOST_CHECK_EQUAL(0, buffer.Push(1, "a", 4));
+  BOOST_CHECK_EQUAL(0, buffer.Push(2, "b", 4));
+  BOOST_CHECK_EQUAL(8, buffer.Bytes());
+
+  // Making room for c drops a, the oldest
+  BOOST_CHECK_EQUAL(1, buffer.Push(1, "c", 4));
+  BOOST_CHECK_EQUAL(2, buffer.Size());
+  BOOST_CHECK_EQUAL(8, buffer.Bytes());
+
+  // An entry over the whole budget is refused and leaves the others
+  BOOST_CHECK_EQUAL(1, buffer.Push(3, "d", 11));
+  BOOST_CHECK_EQUAL(2, buffer.Size());
+
+  const auto entries = buffer.Take(1);
+  BOOST_REQUIRE_EQUAL(1, entries.size());
+  BOOST_CHECK_EQUAL("c", entries.at(0));
+  BOOST_CHECK_EQUAL(4, buffer.Bytes());
+
+  const auto all = buffer.TakeAll();
+  BOOST_REQUIRE_EQUAL(1, all.size());
+  BOOST_CHECK_EQUAL(2, all.at(0).first);
+  BOOST_CHECK_EQUAL("b", all.at(0).second);
+  BOOST_CHECK(buffer.Empty());
+  BOOST_CHECK_EQUAL(0, buffer.Bytes());
+}
+
+BOOST_AUTO_TEST_CASE(test_erase_before) {
+  INIT_STDOUT_LOGGER();
+
+  BoundedBuffer<string> buffer(0);
+
+  for (uint64_t epoch = 1; epoch <= 5; epoch++) {
+    BOOST_CHECK_EQUAL(0, buffer.Push(epoch, to_string(epoch), 100));
+  }
+  BOOST_CHECK_EQUAL(500, buffer.Bytes());
+
+  buffer.EraseBefore(4);
+  BOOST_CHECK_EQUAL(2, buffer.Size());
+  BOOST_CHECK_EQUAL(200, buffer.Bytes());
+  BOOST_CHECK(buffer.Take(3).empty());
+  BOOST_CHECK_EQUAL(1, buffer.Take(4).size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
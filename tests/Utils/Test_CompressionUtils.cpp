@@ -0,0 +1,78 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "libUtils/CompressionUtils.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE compressionutils
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(compressionutils)
+
+BOOST_AUTO_TEST_CASE(test_roundtrip) {
+  INIT_STDOUT_LOGGER();
+
+  bytes original;
+  for (unsigned int i = 0; i < 100000; i++) {
+    original.push_back(i % 251);
+  }
+
+  bytes compressed;
+  BOOST_REQUIRE(CompressionUtils::Compress(original, compressed));
+  BOOST_CHECK_MESSAGE(compressed.size() < original.size(),
+                      "Repetitive data should compress, got "
+                          << compressed.size() << " bytes");
+
+  bytes decompressed;
+  BOOST_REQUIRE(CompressionUtils::Decompress(compressed.data(),
+                                             compressed.size(),
+                                             original.size(), decompressed));
+  BOOST_CHECK_MESSAGE(decompressed == original,
+                      "Decompressed data differs from the original!");
+}
+
+BOOST_AUTO_TEST_CASE(test_reject_invalid) {
+  INIT_STDOUT_LOGGER();
+
+  const bytes original(50000, 0x5A);
+
+  bytes compressed;
+  BOOST_REQUIRE(CompressionUtils::Compress(original, compressed));
+
+  bytes decompressed;
+  BOOST_CHECK_MESSAGE(
+      !CompressionUtils::Decompress(compressed.data(), compressed.size(),
+                                    original.size() - 1, decompressed),
+      "Data expanding beyond the limit should be rejected!");
+
+  BOOST_CHECK_MESSAGE(
+      !CompressionUtils::Decompress(compressed.data(), compressed.size() / 2,
+                                    original.size(), decompressed),
+      "Truncated data should be rejected!");
+
+  bytes corrupted(compressed);
+  corrupted.back() ^= 0xFF;
+  BOOST_CHECK_MESSAGE(
+      !CompressionUtils::Decompress(corrupted.data(), corrupted.size(),
+                                    original.size(), decompressed),
+      "Corrupted data should be rejected!");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "libUtils/DNSCache.h"
+#include "libUtils/IPConverter.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE dnscache
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+using namespace boost::multiprecision;
+
+bool WaitForResolution(const string& hostname, uint128_t& ip) {
+  for (unsigned int i = 0; i < 50; i++) {
+    if (DNSCache::GetInstance().Get(hostname, 30303, ip)) {
+      return true;
+    }
+    this_thread::sleep_for(chrono::milliseconds(100));
+  }
+  return false;
+}
+
+BOOST_AUTO_TEST_SUITE(dnscache)
+
+BOOST_AUTO_TEST_CASE(test_resolve_in_background) {
+  INIT_STDOUT_LOGGER();
+
+  DNSCache& cache = DNSCache::GetInstance();
+  cache.Clear();
+
+  uint128_t ip = 0;
+  BOOST_CHECK_MESSAGE(!cache.Get("localhost", 30303, ip),
+                      "Unknown hostname should not be served synchronously!");
+
+  BOOST_REQUIRE_MESSAGE(WaitForResolution("localhost", ip),
+                        "localhost was never resolved in the background!");
+  BOOST_CHECK_MESSAGE(IPConverter::ToStrFromNumericalIP(ip) == "127.0.0.1",
+                      "Expected: 127.0.0.1. Result: "
+                          << IPConverter::ToStrFromNumericalIP(ip));
+
+  uint128_t cached = 0;
+  BOOST_CHECK_MESSAGE(cache.Get("localhost", 30303, cached) && cached == ip,
+                      "Resolved hostname should be served from the cache!");
+}
+
+BOOST_AUTO_TEST_CASE(test_prefetch) {
+  INIT_STDOUT_LOGGER();
+
+  DNSCache& cache = DNSCache::GetInstance();
+  cache.Clear();
+
+  cache.Prefetch("localhost", 30303);
+
+  uint128_t ip = 0;
+  BOOST_CHECK_MESSAGE(WaitForResolution("localhost", ip),
+                      "Prefetched hostname was never resolved!");
+}
+
+BOOST_AUTO_TEST_CASE(test_unresolvable_hostname) {
+  INIT_STDOUT_LOGGER();
+
+  DNSCache& cache = DNSCache::GetInstance();
+  cache.Clear();
+
+  uint128_t ip = 0;
+  BOOST_CHECK_MESSAGE(!cache.Get("nonexistent.invalid", 30303, ip),
+                      "Unresolvable hostname should not be served!");
+
+  this_thread::sleep_for(chrono::milliseconds(500));
+  BOOST_CHECK_MESSAGE(!cache.Get("nonexistent.invalid", 30303, ip),
+                      "Failed resolution should not be cached!");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
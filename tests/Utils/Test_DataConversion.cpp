@@ -149,4 +149,44 @@ BOOST_AUTO_TEST_CASE(test_hexstr) {
   LOG_GENERAL(INFO, "Test HexString Conversion done!");
 }
 
+BOOST_AUTO_TEST_CASE(test_hex_bytes) {
+  LOG_GENERAL(INFO, "Test hex encode and decode start...");
+
+  // Long enough for the vector paths and their scalar remainder
+  bytes input;
+  for (unsigned int i = 0; i < 83; i++) {
+    input.emplace_back(i * 37 + 5);
+  }
+
+  std::string expected;
+  for (const auto& b : input) {
+    expected += "0123456789ABCDEF"[b >> 4];
+    expected += "0123456789ABCDEF"[b & 0x0F];
+  }
+
+  for (unsigned int size = 0; size <= input.size(); size++) {
+    std::string hex;
+    BOOST_REQUIRE(DataConversion::Uint8VecToHexStr(input, 0, size, hex));
+    BOOST_CHECK_EQUAL(hex, expected.substr(0, 2 * size));
+
+    bytes decoded;
+    BOOST_CHECK(DataConversion::HexStrToUint8Vec(
+        boost::to_lower_copy(hex), decoded));
+    BOOST_CHECK(decoded == bytes(input.begin(), input.begin() + size));
+  }
+
+  bytes decoded;
+  BOOST_CHECK(!DataConversion::HexStrToUint8Vec(expected + "A", decoded));
+  for (const char bad : {'g', 'G', '/', ':', '@', '`', ' ', 'x', '\x80'}) {
+    for (const size_t pos : {0, 31, 32, 70, 165}) {
+      std::string hex = expected;
+      hex[pos] = bad;
+      BOOST_CHECK_MESSAGE(!DataConversion::HexStrToUint8Vec(hex, decoded),
+                          "Accepted " << bad << " at " << pos);
+    }
+  }
+
+  LOG_GENERAL(INFO, "Test hex encode and decode done!");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
\ No newline at end of file
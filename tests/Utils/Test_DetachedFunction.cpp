@@ -15,8 +15,10 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#include <future>
 #include <memory>
 #include <mutex>
+#include <set>
 #include "libUtils/DetachedFunction.h"
 #include "libUtils/JoinableFunction.h"
 #include "libUtils/Logger.h"
@@ -64,4 +66,27 @@ BOOST_AUTO_TEST_CASE(testDetachedFunction) {
                             // before program terminates
 }
 
+BOOST_AUTO_TEST_CASE(testDetachedFunctionReusesThreads) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+
+  // Run one at a time, so that each finds the thread of the last one idle
+  for (const auto lane :
+       {DetachedFunction::Lane::DEFAULT, DetachedFunction::Lane::BLOCKING}) {
+    set<thread::id> ids;
+    for (int i = 0; i < 10; i++) {
+      auto ran = make_shared<promise<thread::id>>();
+      DetachedFunction(lane, 1,
+                       [ran]() { ran->set_value(this_thread::get_id()); });
+      auto id = ran->get_future();
+      BOOST_REQUIRE(id.wait_for(chrono::seconds(10)) == future_status::ready);
+      ids.insert(id.get());
+      // Let the thread get back to waiting before the next call
+      this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    BOOST_CHECK_EQUAL(ids.size(), 1);
+  }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "libUtils/EpochArena.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE epocharena
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(epocharena)
+
+BOOST_AUTO_TEST_CASE(test_alignment_and_chunks) {
+  INIT_STDOUT_LOGGER();
+
+  EpochArena arena(256);
+
+  void* c = arena.Allocate(1, 1);
+  void* d = arena.Allocate(sizeof(double), alignof(double));
+  BOOST_CHECK(c != nullptr);
+  BOOST_CHECK_EQUAL(reinterpret_cast<size_t>(d) % alignof(double), 0);
+
+  // Larger than a chunk, so it gets one of its own
+  void* big = arena.Allocate(1000, 16);
+  BOOST_CHECK_EQUAL(reinterpret_cast<size_t>(big) % 16, 0);
+  BOOST_CHECK_GE(arena.GetBytesReserved(), 256 + 1000);
+  BOOST_CHECK_GE(arena.GetBytesUsed(), 1 + sizeof(double) + 1000);
+
+  // The memory is handed out again from the start after a reset
+  const size_t reserved = arena.GetBytesReserved();
+  arena.Reset();
+  BOOST_CHECK_EQUAL(arena.GetBytesUsed(), 0);
+  BOOST_CHECK_EQUAL(arena.Allocate(1, 1), c);
+  BOOST_CHECK_EQUAL(arena.GetBytesReserved(), reserved);
+
+  arena.Release();
+  BOOST_CHECK_EQUAL(arena.GetBytesReserved(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_containers) {
+  INIT_STDOUT_LOGGER();
+
+  EpochArena arena;
+  typedef map<uint64_t, string, less<uint64_t>,
+              ArenaAllocator<pair<const uint64_t, string>>>
+      ArenaMap;
+  typedef unordered_map<uint64_t, uint64_t, hash<uint64_t>,
+                        equal_to<uint64_t>,
+                        ArenaAllocator<pair<const uint64_t, uint64_t>>>
+      ArenaHashMap;
+
+  for (unsigned int epoch = 0; epoch < 3; epoch++) {
+    {
+      ArenaMap m{ArenaMap::allocator_type(&arena)};
+      ArenaHashMap h{ArenaHashMap::allocator_type(&arena)};
+      vector<uint64_t, ArenaAllocator<uint64_t>> v{
+          ArenaAllocator<uint64_t>(&arena)};
+      for (uint64_t i = 0; i < 1000; i++) {
+        m.emplace(i, to_string(i));
+        h[i] = i * i;
+        v.push_back(i);
+      }
+
+      BOOST_CHECK_EQUAL(m.size(), 1000);
+      BOOST_CHECK_EQUAL(m.rbegin()->second, "999");
+      BOOST_CHECK_EQUAL(h[999], 999 * 999);
+      BOOST_CHECK_EQUAL(v[500], 500);
+      BOOST_CHECK_GT(arena.GetBytesUsed(), 1000 * sizeof(uint64_t));
+    }
+
+    // The same chunks serve every epoch
+    const size_t reserved = arena.GetBytesReserved();
+    arena.Reset();
+    if (epoch > 0) {
+      BOOST_CHECK_EQUAL(arena.GetBytesReserved(), reserved);
+    }
+  }
+
+  // Without an arena the allocator takes from the heap
+  ArenaMap heapMap;
+  heapMap.emplace(1, "one");
+  BOOST_CHECK_EQUAL(heapMap.at(1), "one");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+#include <vector>
+
+#include "libUtils/FairJobQueue.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE fairjobqueuetest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(fairjobqueuetest)
+
+BOOST_AUTO_TEST_CASE(test_keys_take_turns) {
+  INIT_STDOUT_LOGGER();
+
+  FairJobQueue queue(10);
+  vector<string> order;
+
+  // "a" queues three jobs before "b" and "c" queue theirs
+  for (unsigned int i = 0; i < 3; i++) {
+    BOOST_CHECK(queue.Add("a", [&order, i]() {
+      order.emplace_back("a" + to_string(i));
+    }));
+  }
+  BOOST_CHECK(queue.Add("b", [&order]() { order.emplace_back("b0"); }));
+  BOOST_CHECK(queue.Add("c", [&order]() { order.emplace_back("c0"); }));
+  BOOST_CHECK_EQUAL(queue.GetQueued(), 5u);
+  BOOST_CHECK_EQUAL(queue.GetNumKeys(), 3u);
+
+  for (unsigned int i = 0; i < 5; i++) {
+    queue.RunNext();
+  }
+
+  const vector<string> expected = {"a0", "b0", "c0", "a1", "a2"};
+  BOOST_CHECK(order == expected);
+  BOOST_CHECK_EQUAL(queue.GetQueued(), 0u);
+  BOOST_CHECK_EQUAL(queue.GetNumKeys(), 0u);
+
+  // Nothing left to run
+  queue.RunNext();
+  BOOST_CHECK_EQUAL(order.size(), 5u);
+}
+
+BOOST_AUTO_TEST_CASE(test_limit_per_key) {
+  INIT_STDOUT_LOGGER();
+
+  FairJobQueue queue(2);
+  unsigned int runs = 0;
+
+  BOOST_CHECK(queue.Add("a", [&runs]() { runs++; }));
+  BOOST_CHECK(queue.Add("a", [&runs]() { runs++; }));
+  BOOST_CHECK(!queue.Add("a", [&runs]() { runs++; }));
+  BOOST_CHECK(queue.Add("b", [&runs]() { runs++; }));
+
+  // A turn frees a place for the key
+  queue.RunNext();
+  BOOST_CHECK(queue.Add("a", [&runs]() { runs++; }));
+
+  while (queue.GetQueued() > 0) {
+    queue.RunNext();
+  }
+  BOOST_CHECK_EQUAL(runs, 4u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <string>
+
+#include "libUtils/LRUCache.h"
+#include "libUtils/Logger.h"
+
+#define BOOST_TEST_MODULE lrucachetest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(lrucachetest)
+
+BOOST_AUTO_TEST_CASE(test_evict_least_recently_used) {
+  INIT_STDOUT_LOGGER();
+
+  LRUCache<int, string> cache(2);
+  string value;
+
+  cache.Put(1, "one");
+  cache.Put(2, "two");
+  BOOST_CHECK(cache.Get(1, value));
+  BOOST_CHECK_EQUAL("one", value);
+
+  // 2 is now the least recently used
+  cache.Put(3, "three");
+  BOOST_CHECK(!cache.Get(2, value));
+  BOOST_CHECK(cache.Get(1, value));
+  BOOST_CHECK(cache.Get(3, value));
+  BOOST_CHECK_EQUAL("three", value);
+
+  cache.Put(3, "drei");
+  BOOST_CHECK(cache.Get(3, value));
+  BOOST_CHECK_EQUAL("drei", value);
+
+  cache.Erase(3);
+  BOOST_CHECK(!cache.Get(3, value));
+
+  BOOST_CHECK_EQUAL(4, cache.GetHits());
+  BOOST_CHECK_EQUAL(2, cache.GetMisses());
+
+  cache.ResetStats();
+  cache.Clear();
+  BOOST_CHECK(!cache.Get(1, value));
+  BOOST_CHECK_EQUAL(0, cache.GetHits());
+  BOOST_CHECK_EQUAL(1, cache.GetMisses());
+}
+
+BOOST_AUTO_TEST_CASE(test_zero_capacity) {
+  INIT_STDOUT_LOGGER();
+
+  LRUCache<int, string> cache(0);
+  string value;
+
+  cache.Put(1, "one");
+  BOOST_CHECK(!cache.Get(1, value));
+  BOOST_CHECK_EQUAL(0, cache.GetMisses());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -48,4 +48,34 @@ BOOST_AUTO_TEST_CASE(testLogger3) {
   JoinableFunction(1, test);
 }
 
+BOOST_AUTO_TEST_CASE(testLoggerFlush) {
+  INIT_STDOUT_LOGGER();
+
+  // Warnings wait for room rather than being dropped
+  auto warn = []() {
+    for (int i = 0; i < 2 * (int)Logger::ASYNC_BUFFER_SIZE; i++) {
+      LOG_GENERAL(WARNING, "Warning " << i);
+    }
+  };
+  JoinableFunction(4, warn);
+
+  Logger::GetLogger(NULL, true).Flush();
+  BOOST_CHECK_EQUAL(Logger::GetLogger(NULL, true).GetDroppedCount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(testLoggerSkipsFilteredLevels) {
+  INIT_STDOUT_LOGGER();
+
+  int evaluated = 0;
+  auto count = [&evaluated]() { return ++evaluated; };
+
+  LOG_DISPLAY_LEVEL_ABOVE(WARNING);
+  LOG_GENERAL(INFO, "Not shown " << count());
+  LOG_EPOCH(INFO, 1, "Not shown " << count());
+  LOG_GENERAL(WARNING, "Shown " << count());
+  LOG_DISPLAY_LEVEL_ABOVE(INFO);
+
+  BOOST_CHECK_EQUAL(evaluated, 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
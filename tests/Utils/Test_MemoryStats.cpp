@@ -0,0 +1,79 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include "common/BaseType.h"
+#include "libUtils/Logger.h"
+#include "libUtils/MemoryStats.h"
+#include "libUtils/Metrics.h"
+
+#define BOOST_TEST_MODULE memorystats
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(memorystats)
+
+bool HasMetricsLine(const string& line) {
+  ostringstream oss;
+  Metrics::GetInstance().WriteText(oss);
+  return oss.str().find(line + "\n") != string::npos;
+}
+
+BOOST_AUTO_TEST_CASE(test_report) {
+  INIT_STDOUT_LOGGER();
+
+  vector<bytes> buffer{bytes(100), bytes(28)};
+  MemoryStats::GetInstance().Register("test.buffer", [&buffer]() {
+    MemoryStats::Usage usage;
+    for (const auto& entry : buffer) {
+      usage.m_entries++;
+      usage.m_bytes += entry.size();
+    }
+    return usage;
+  });
+
+  // The gauges show the last report, none was taken yet
+  BOOST_CHECK(
+      HasMetricsLine("zilliqa_memory_bytes{subsystem=\"test.buffer\"} 0"));
+
+  auto report = MemoryStats::GetInstance().GetReport();
+  BOOST_REQUIRE(report.find("test.buffer") != report.end());
+  BOOST_CHECK_EQUAL(report["test.buffer"].m_entries, 2);
+  BOOST_CHECK_EQUAL(report["test.buffer"].m_bytes, 128);
+  BOOST_CHECK(
+      HasMetricsLine("zilliqa_memory_bytes{subsystem=\"test.buffer\"} 128"));
+  BOOST_CHECK(
+      HasMetricsLine("zilliqa_memory_entries{subsystem=\"test.buffer\"} 2"));
+
+  // Registering again replaces the estimator
+  MemoryStats::GetInstance().Register(
+      "test.buffer", []() { return MemoryStats::Usage(); });
+  report = MemoryStats::GetInstance().GetReport();
+  BOOST_CHECK_EQUAL(report["test.buffer"].m_bytes, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_resident_bytes) {
+  INIT_STDOUT_LOGGER();
+
+  BOOST_CHECK_GT(MemoryStats::GetResidentBytes(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,121 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "libUtils/Logger.h"
+#include "libUtils/Metrics.h"
+
+#define BOOST_TEST_MODULE metrics
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(metrics)
+
+string GetText() {
+  ostringstream oss;
+  Metrics::GetInstance().WriteText(oss);
+  return oss.str();
+}
+
+bool HasLine(const string& text, const string& line) {
+  return text.find(line + "\n") != string::npos;
+}
+
+BOOST_AUTO_TEST_CASE(test_counter_and_gauge) {
+  INIT_STDOUT_LOGGER();
+
+  auto& counter =
+      Metrics::GetInstance().GetCounter("test_requests", "Requests served");
+  counter.Increment();
+  counter.Increment(2);
+
+  // The same name and labels give the same metric
+  BOOST_CHECK_EQUAL(
+      &Metrics::GetInstance().GetCounter("test_requests", "Requests served"),
+      &counter);
+
+  auto& gauge = Metrics::GetInstance().GetGauge("test_depth", "Queue depth",
+                                                "queue=\"in\"");
+  gauge.Set(10);
+  gauge.Decrement(3);
+
+  unsigned int depth = 42;
+  Metrics::GetInstance().SetGaugeFunction(
+      "test_depth", "Queue depth", [&depth]() { return depth; },
+      "queue=\"out\"");
+
+  const string text = GetText();
+  BOOST_CHECK(HasLine(text, "# HELP test_requests Requests served"));
+  BOOST_CHECK(HasLine(text, "# TYPE test_requests counter"));
+  BOOST_CHECK(HasLine(text, "test_requests 3"));
+  BOOST_CHECK(HasLine(text, "# TYPE test_depth gauge"));
+  BOOST_CHECK(HasLine(text, "test_depth{queue=\"in\"} 7"));
+  BOOST_CHECK(HasLine(text, "test_depth{queue=\"out\"} 42"));
+}
+
+BOOST_AUTO_TEST_CASE(test_histogram) {
+  INIT_STDOUT_LOGGER();
+
+  auto& histogram = Metrics::GetInstance().GetHistogram(
+      "test_latency", "Latency", "op=\"put\"", {1, 0.1});
+  BOOST_REQUIRE_EQUAL(histogram.GetBounds().size(), 3);
+  BOOST_CHECK_EQUAL(histogram.GetBounds()[0], 0.1);
+
+  histogram.Observe(0.05);
+  histogram.Observe(0.1);
+  histogram.Observe(0.5);
+  histogram.Observe(5);
+
+  const string text = GetText();
+  BOOST_CHECK(HasLine(text, "# TYPE test_latency histogram"));
+  BOOST_CHECK(HasLine(text, "test_latency_bucket{op=\"put\",le=\"0.1\"} 2"));
+  BOOST_CHECK(HasLine(text, "test_latency_bucket{op=\"put\",le=\"1\"} 3"));
+  BOOST_CHECK(HasLine(text, "test_latency_bucket{op=\"put\",le=\"+Inf\"} 4"));
+  BOOST_CHECK(HasLine(text, "test_latency_sum{op=\"put\"} 5.65"));
+  BOOST_CHECK(HasLine(text, "test_latency_count{op=\"put\"} 4"));
+}
+
+BOOST_AUTO_TEST_CASE(test_concurrent_observe) {
+  INIT_STDOUT_LOGGER();
+
+  auto& histogram =
+      Metrics::GetInstance().GetHistogram("test_concurrent", "Concurrent");
+
+  const unsigned int NUM_THREADS = 4;
+  const unsigned int NUM_OBSERVATIONS = 10000;
+  vector<thread> threads;
+  for (unsigned int i = 0; i < NUM_THREADS; i++) {
+    threads.emplace_back([&histogram]() {
+      for (unsigned int j = 0; j < NUM_OBSERVATIONS; j++) {
+        histogram.Observe(1);
+      }
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  BOOST_CHECK_EQUAL(histogram.GetCount(), NUM_THREADS * NUM_OBSERVATIONS);
+  BOOST_CHECK_EQUAL(histogram.GetSum(), NUM_THREADS * NUM_OBSERVATIONS);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
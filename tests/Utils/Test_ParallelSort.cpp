@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "libUtils/ParallelSort.h"
+
+#define BOOST_TEST_MODULE parallelsort
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(parallelsort)
+
+BOOST_AUTO_TEST_CASE(test_matches_std_sort) {
+  mt19937 rng(1);
+  for (size_t size : {0, 1, 1000, 1024, 4097, 100000}) {
+    vector<uint32_t> values(size);
+    // Small range, so that there are plenty of equal elements
+    for (auto& value : values) {
+      value = rng() % 1000;
+    }
+    vector<uint32_t> expected = values;
+    sort(expected.begin(), expected.end());
+
+    for (unsigned int numThreads : {1, 2, 3, 8, 13}) {
+      vector<uint32_t> sorted = values;
+      ParallelSort(sorted.begin(), sorted.end(), less<uint32_t>(), numThreads);
+      BOOST_CHECK(sorted == expected);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_comparator) {
+  vector<pair<int, int>> values;
+  for (int i = 0; i < 5000; i++) {
+    values.emplace_back(i % 7, i);
+  }
+  // Descending on the first element, then ascending on the second
+  auto comp = [](const pair<int, int>& a, const pair<int, int>& b) {
+    return a.first != b.first ? a.first > b.first : a.second < b.second;
+  };
+  vector<pair<int, int>> expected = values;
+  sort(expected.begin(), expected.end(), comp);
+
+  ParallelSort(values.begin(), values.end(), comp, 4);
+  BOOST_CHECK(values == expected);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,85 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <chrono>
+#include <string>
+
+#include "libUtils/Logger.h"
+#include "libUtils/RateLimiter.h"
+
+#define BOOST_TEST_MODULE ratelimitertest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(ratelimitertest)
+
+BOOST_AUTO_TEST_CASE(test_burst_and_refill) {
+  INIT_STDOUT_LOGGER();
+
+  RateLimiter limiter;
+  const auto start = chrono::steady_clock::now();
+
+  for (unsigned int i = 0; i < 5; i++) {
+    BOOST_CHECK(limiter.TryAcquire("a", 5, start));
+  }
+  BOOST_CHECK(!limiter.TryAcquire("a", 5, start));
+
+  // Other keys have buckets of their own
+  BOOST_CHECK(limiter.TryAcquire("b", 5, start));
+
+  // 5 tokens per second, so one comes back every 200 ms
+  BOOST_CHECK(!limiter.TryAcquire("a", 5, start + chrono::milliseconds(100)));
+  BOOST_CHECK(limiter.TryAcquire("a", 5, start + chrono::milliseconds(300)));
+  BOOST_CHECK(!limiter.TryAcquire("a", 5, start + chrono::milliseconds(300)));
+
+  // Never more than a second's worth of tokens
+  const auto later = start + chrono::seconds(10);
+  for (unsigned int i = 0; i < 5; i++) {
+    BOOST_CHECK(limiter.TryAcquire("a", 5, later));
+  }
+  BOOST_CHECK(!limiter.TryAcquire("a", 5, later));
+}
+
+BOOST_AUTO_TEST_CASE(test_no_limit) {
+  INIT_STDOUT_LOGGER();
+
+  RateLimiter limiter;
+  for (unsigned int i = 0; i < 1000; i++) {
+    BOOST_CHECK(limiter.TryAcquire("a", 0));
+  }
+  BOOST_CHECK_EQUAL(limiter.size(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_prune_refilled_keys) {
+  INIT_STDOUT_LOGGER();
+
+  RateLimiter limiter(2);
+  const auto start = chrono::steady_clock::now();
+
+  BOOST_CHECK(limiter.TryAcquire("a", 1, start));
+  BOOST_CHECK(limiter.TryAcquire("b", 1, start));
+
+  // Neither bucket has refilled yet, so there is no room for another key
+  BOOST_CHECK(!limiter.TryAcquire("c", 1, start));
+
+  BOOST_CHECK(limiter.TryAcquire("c", 1, start + chrono::seconds(2)));
+  BOOST_CHECK_EQUAL(limiter.size(), 1);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "libUtils/Logger.h"
+#include "libUtils/ReedSolomon.h"
+
+#define BOOST_TEST_MODULE reedsolomon
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(reedsolomon)
+
+BOOST_AUTO_TEST_CASE(test_any_data_shards_rebuild) {
+  INIT_STDOUT_LOGGER();
+
+  const unsigned int dataShards = 6;
+  const unsigned int parityShards = 4;
+
+  bytes original;
+  for (unsigned int i = 0; i < 100003; i++) {
+    original.push_back((i * 7 + 3) % 256);
+  }
+
+  vector<bytes> shards;
+  BOOST_REQUIRE(
+      ReedSolomon::Encode(original, dataShards, parityShards, shards));
+  BOOST_REQUIRE_EQUAL(shards.size(), dataShards + parityShards);
+
+  // Drop a different window of parityShards shards each time
+  for (unsigned int lost = 0; lost < dataShards + parityShards; lost++) {
+    map<unsigned int, bytes> received;
+    for (unsigned int i = 0; i < shards.size(); i++) {
+      if ((i + shards.size() - lost) % shards.size() >= parityShards) {
+        received.emplace(i, shards[i]);
+      }
+    }
+
+    bytes decoded;
+    BOOST_REQUIRE(ReedSolomon::Decode(received, dataShards, parityShards,
+                                      original.size(), decoded));
+    BOOST_CHECK_MESSAGE(decoded == original,
+                        "Decoded data differs after losing shards from "
+                            << lost);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_not_enough_shards) {
+  INIT_STDOUT_LOGGER();
+
+  const bytes original(1000, 0x5A);
+
+  vector<bytes> shards;
+  BOOST_REQUIRE(ReedSolomon::Encode(original, 4, 2, shards));
+
+  map<unsigned int, bytes> received = {
+      {0, shards[0]}, {3, shards[3]}, {5, shards[5]}};
+
+  bytes decoded;
+  BOOST_CHECK_MESSAGE(
+      !ReedSolomon::Decode(received, 4, 2, original.size(), decoded),
+      "Decoding should fail with fewer shards than data shards!");
+
+  BOOST_CHECK_MESSAGE(!ReedSolomon::Encode(original, 200, 100, shards),
+                      "More than 256 shards should be rejected!");
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,122 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <future>
+#include <vector>
+#include "libUtils/Logger.h"
+#include "libUtils/Scheduler.h"
+
+#define BOOST_TEST_MODULE scheduler
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(scheduler)
+
+BOOST_AUTO_TEST_CASE(test_runs_in_order_and_not_early) {
+  INIT_STDOUT_LOGGER();
+
+  Scheduler scheduler(2);
+
+  // Delays that land on each wheel, scheduled out of order
+  const vector<int64_t> delays = {700, 5, 50, 0, 1300, 20};
+  const auto start = chrono::steady_clock::now();
+
+  mutex m;
+  vector<int64_t> order;
+  bool early = false;
+  vector<future<void>> results;
+  for (const auto delay : delays) {
+    auto done = make_shared<promise<void>>();
+    results.emplace_back(done->get_future());
+    scheduler.ScheduleAfter(
+        [&, delay, done]() {
+          const auto elapsed = chrono::duration_cast<chrono::milliseconds>(
+                                   chrono::steady_clock::now() - start)
+                                   .count();
+          {
+            lock_guard<mutex> g(m);
+            order.push_back(delay);
+            early = early || elapsed < delay;
+          }
+          done->set_value();
+        },
+        delay);
+  }
+
+  for (auto& result : results) {
+    BOOST_REQUIRE(result.wait_for(chrono::seconds(10)) ==
+                  future_status::ready);
+  }
+
+  BOOST_CHECK(order == vector<int64_t>({0, 5, 20, 50, 700, 1300}));
+  BOOST_CHECK(!early);
+  BOOST_CHECK_EQUAL(scheduler.GetNumTasks(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_cancel) {
+  INIT_STDOUT_LOGGER();
+
+  Scheduler scheduler(2);
+
+  atomic<bool> ran(false);
+  const auto handle = scheduler.ScheduleAfter([&ran]() { ran = true; }, 100);
+  BOOST_CHECK_EQUAL(scheduler.GetNumTasks(), 1);
+  BOOST_CHECK(scheduler.Cancel(handle));
+  BOOST_CHECK(!scheduler.Cancel(handle));
+  BOOST_CHECK_EQUAL(scheduler.GetNumTasks(), 0);
+
+  promise<void> later;
+  scheduler.ScheduleAfter([&later]() { later.set_value(); }, 200);
+  BOOST_REQUIRE(later.get_future().wait_for(chrono::seconds(10)) ==
+                future_status::ready);
+  BOOST_CHECK(!ran);
+}
+
+BOOST_AUTO_TEST_CASE(test_periodic_cancelled_by_itself) {
+  INIT_STDOUT_LOGGER();
+
+  Scheduler scheduler(2);
+
+  atomic<unsigned int> runs(0);
+  promise<void> done;
+  Scheduler::TaskHandle handle = 0;
+  mutex m;
+
+  {
+    lock_guard<mutex> g(m);
+    handle = scheduler.SchedulePeriodically(
+        [&]() {
+          if (++runs == 5) {
+            lock_guard<mutex> g(m);
+            BOOST_CHECK(scheduler.Cancel(handle));
+            done.set_value();
+          }
+        },
+        20);
+  }
+
+  BOOST_REQUIRE(done.get_future().wait_for(chrono::seconds(10)) ==
+                future_status::ready);
+  this_thread::sleep_for(chrono::milliseconds(100));
+  BOOST_CHECK_EQUAL(runs, 5);
+  BOOST_CHECK_EQUAL(scheduler.GetNumTasks(), 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <future>
+#include <vector>
+#include "libUtils/Logger.h"
+#include "libUtils/ThreadPool.h"
+
+#define BOOST_TEST_MODULE threadpool
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+
+BOOST_AUTO_TEST_SUITE(threadpool)
+
+BOOST_AUTO_TEST_CASE(test_submit_returns_results) {
+  INIT_STDOUT_LOGGER();
+
+  ThreadPool pool(4, "TestPool");
+
+  vector<future<int>> results;
+  for (int i = 0; i < 1000; ++i) {
+    results.emplace_back(pool.Submit([i]() { return i * i; }));
+  }
+
+  for (int i = 0; i < 1000; ++i) {
+    BOOST_CHECK_EQUAL(results[i].get(), i * i);
+  }
+
+  auto failed =
+      pool.Submit([]() -> int { throw runtime_error("job failed"); });
+  BOOST_CHECK_THROW(failed.get(), runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_jobs_added_by_jobs) {
+  INIT_STDOUT_LOGGER();
+
+  ThreadPool pool(4, "TestPool");
+  atomic<unsigned int> done(0);
+  promise<void> allDone;
+
+  // Each job adds its children to its own worker, for the others to steal
+  const unsigned int FANOUT = 8, TOTAL = 1 + FANOUT + FANOUT * FANOUT;
+  function<void(unsigned int)> job = [&](unsigned int depth) {
+    if (depth < 2) {
+      for (unsigned int i = 0; i < FANOUT; ++i) {
+        pool.AddJob([&job, depth]() { job(depth + 1); });
+      }
+    }
+    if (++done == TOTAL) {
+      allDone.set_value();
+    }
+  };
+  pool.AddJob([&job]() { job(0); });
+
+  BOOST_CHECK(allDone.get_future().wait_for(chrono::seconds(10)) ==
+              future_status::ready);
+  BOOST_CHECK_EQUAL(done, TOTAL);
+
+  while (pool.GetStats().completed < TOTAL) {
+    this_thread::yield();
+  }
+  const auto stats = pool.GetStats();
+  BOOST_CHECK_EQUAL(stats.completed, TOTAL);
+  BOOST_CHECK_EQUAL(stats.queued, 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_high_priority_first) {
+  INIT_STDOUT_LOGGER();
+
+  ThreadPool pool(1, "TestPool");
+
+  // Hold the only worker while the jobs queue up behind it
+  promise<void> release;
+  shared_future<void> released = release.get_future().share();
+  pool.AddJob([released]() { released.wait(); });
+
+  mutex m;
+  vector<int> order;
+  vector<future<void>> results;
+  for (int i = 0; i < 3; ++i) {
+    results.emplace_back(pool.Submit([&, i]() {
+      lock_guard<mutex> g(m);
+      order.push_back(i);
+    }));
+  }
+  results.emplace_back(pool.Submit(
+      [&]() {
+        lock_guard<mutex> g(m);
+        order.push_back(-1);
+      },
+      ThreadPool::Priority::HIGH));
+
+  release.set_value();
+  for (auto& result : results) {
+    result.get();
+  }
+
+  BOOST_CHECK(order == vector<int>({-1, 0, 1, 2}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,115 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <boost/property_tree/xml_parser.hpp>
+#include "libUtils/Logger.h"
+#include "libUtils/ThreadRoles.h"
+
+#define BOOST_TEST_MODULE threadroles
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+namespace pt = boost::property_tree;
+
+BOOST_AUTO_TEST_SUITE(threadroles)
+
+pt::ptree ParseSection(const string& xml) {
+  pt::ptree tree;
+  istringstream iss(xml);
+  pt::read_xml(iss, tree);
+  return tree.get_child("thread_roles");
+}
+
+BOOST_AUTO_TEST_CASE(test_parse_cpu_list) {
+  INIT_STDOUT_LOGGER();
+
+  vector<unsigned int> cpus;
+  BOOST_CHECK(ThreadRoles::ParseCpuList("0-3, 8,10-11", cpus));
+  BOOST_CHECK((cpus == vector<unsigned int>{0, 1, 2, 3, 8, 10, 11}));
+
+  BOOST_CHECK(ThreadRoles::ParseCpuList("", cpus));
+  BOOST_CHECK(cpus.empty());
+
+  for (const auto& bad : {"a", "1-", "-1", "3-1", "1.5", "1-2-3", "99999"}) {
+    BOOST_CHECK_MESSAGE(!ThreadRoles::ParseCpuList(bad, cpus), bad);
+  }
+}
+
+BOOST_AUTO_TEST_CASE(test_load) {
+  INIT_STDOUT_LOGGER();
+
+  ThreadRoles roles;
+  BOOST_CHECK(roles.Load(ParseSection(
+      "<thread_roles><role><name>A</name><cpus>0</cpus></role>"
+      "<role><name>B</name><nice>5</nice></role></thread_roles>")));
+
+  BOOST_CHECK(!roles.Load(ParseSection(
+      "<thread_roles><role><cpus>0</cpus></role></thread_roles>")));
+  BOOST_CHECK(!roles.Load(ParseSection(
+      "<thread_roles><role><name>A</name><cpus>x</cpus></role>"
+      "</thread_roles>")));
+}
+
+#if defined(__linux__)
+BOOST_AUTO_TEST_CASE(test_apply) {
+  INIT_STDOUT_LOGGER();
+
+  ThreadRoles roles;
+  BOOST_REQUIRE(roles.Load(ParseSection(
+      "<thread_roles><role><name>PinnedRole</name><cpus>0</cpus>"
+      "<nice>1</nice></role></thread_roles>")));
+
+  // In threads of their own, so that the test thread is left alone
+  thread([&roles]() {
+    roles.ApplyToCurrentThread("PinnedRole");
+
+    char name[16] = {};
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    BOOST_CHECK_EQUAL(string(name), "PinnedRole");
+
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    BOOST_REQUIRE_EQUAL(
+        pthread_getaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet), 0);
+    BOOST_CHECK_EQUAL(CPU_COUNT(&cpuSet), 1);
+    BOOST_CHECK(CPU_ISSET(0, &cpuSet));
+
+    BOOST_CHECK_EQUAL(getpriority(PRIO_PROCESS, syscall(SYS_gettid)), 1);
+  }).join();
+
+  // Only named, as the role is not configured
+  thread([&roles]() {
+    roles.ApplyToCurrentThread("A role with a long name");
+
+    char name[16] = {};
+    pthread_getname_np(pthread_self(), name, sizeof(name));
+    BOOST_CHECK_EQUAL(string(name), "A role with a l");
+    BOOST_CHECK_EQUAL(getpriority(PRIO_PROCESS, syscall(SYS_gettid)), 0);
+  }).join();
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
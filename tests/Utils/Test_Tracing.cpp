@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+#include "common/Constants.h"
+#include "libUtils/Logger.h"
+#include "libUtils/Tracing.h"
+
+#define BOOST_TEST_MODULE tracing
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+using namespace std;
+namespace pt = boost::property_tree;
+
+BOOST_AUTO_TEST_SUITE(tracing)
+
+pt::ptree ParseTrace() {
+  pt::ptree trace;
+  istringstream iss(Tracing::GetInstance().GetChromeTrace());
+  pt::read_json(iss, trace);
+  return trace;
+}
+
+BOOST_AUTO_TEST_CASE(test_chrome_trace) {
+  INIT_STDOUT_LOGGER();
+
+  Tracing& tracing = Tracing::GetInstance();
+  tracing.Clear();
+
+  vector<thread> threads;
+  for (unsigned int i = 0; i < 4; i++) {
+    threads.emplace_back([&tracing, i]() {
+      tracing.Record({"MicroBlock.Prepare", i, 100 * i, 10});
+      tracing.Record({"MicroBlock.Consensus", i, 100 * i + 20, 30});
+    });
+  }
+  for (auto& t : threads) {
+    t.join();
+  }
+
+  const pt::ptree trace = ParseTrace();
+  unsigned int numEvents = 0;
+  for (const auto& event : trace.get_child("traceEvents")) {
+    const pt::ptree& e = event.second;
+    BOOST_CHECK_EQUAL(e.get<string>("ph"), "X");
+    const uint64_t start = 100 * e.get<uint64_t>("args.epoch");
+    BOOST_CHECK_EQUAL(e.get<uint64_t>("ts"),
+                      e.get<uint64_t>("dur") == 10 ? start : start + 20);
+    numEvents++;
+  }
+  BOOST_CHECK_EQUAL(numEvents, 8);
+
+  tracing.Clear();
+  BOOST_CHECK(ParseTrace().get_child("traceEvents").empty());
+}
+
+BOOST_AUTO_TEST_CASE(test_ring_buffer) {
+  INIT_STDOUT_LOGGER();
+
+  Tracing& tracing = Tracing::GetInstance();
+  tracing.Clear();
+
+  // Only the newest spans of a thread are kept, oldest first
+  for (uint64_t i = 0; i < EPOCH_TRACE_BUFFER_SIZE + 10; i++) {
+    tracing.Record({"FinalBlock.Process", i, i, 1});
+  }
+
+  const pt::ptree events = ParseTrace().get_child("traceEvents");
+  BOOST_REQUIRE_EQUAL(events.size(), EPOCH_TRACE_BUFFER_SIZE);
+  BOOST_CHECK_EQUAL(events.begin()->second.get<uint64_t>("args.epoch"), 10);
+  BOOST_CHECK_EQUAL(events.rbegin()->second.get<uint64_t>("args.epoch"),
+                    EPOCH_TRACE_BUFFER_SIZE + 9);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -261,6 +261,8 @@ def run_start(numdsnodes):
 		shutil.copyfile('ds_whitelist.xml', LOCAL_RUN_FOLDER + testfolders_list[x] + '/ds_whitelist.xml')
 		shutil.copyfile('shard_whitelist.xml', LOCAL_RUN_FOLDER + testfolders_list[x] + '/shard_whitelist.xml')
 		shutil.copyfile('constants_local.xml', LOCAL_RUN_FOLDER + testfolders_list[x] + '/constants.xml')
+		if os.path.isfile('network_emulation.xml'):
+			shutil.copyfile('network_emulation.xml', LOCAL_RUN_FOLDER + testfolders_list[x] + '/network_emulation.xml')
 		shutil.copyfile('dsnodes.xml', LOCAL_RUN_FOLDER + testfolders_list[x] + '/dsnodes.xml')
 
 		if (x < numdsnodes):
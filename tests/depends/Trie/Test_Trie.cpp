@@ -684,4 +684,46 @@ BOOST_AUTO_TEST_CASE(triePerf) {
   //        it.\n";
 }
 
+BOOST_AUTO_TEST_CASE(trieInsertBatch) {
+  INIT_STDOUT_LOGGER();
+
+  LOG_MARKER();
+
+  MemoryDB serialDB;
+  GenericTrieDB<MemoryDB> serial(&serialDB);
+  serial.init();
+  MemoryDB batchDB;
+  GenericTrieDB<MemoryDB> batch(&batchDB);
+  batch.init();
+
+  // First batch starts from an empty root, the second updates half the keys
+  std::vector<bytes> keys;
+  for (unsigned int i = 0; i < 1000; ++i) {
+    keys.emplace_back(h160::random().asBytes());
+  }
+
+  for (unsigned int round = 0; round < 2; ++round) {
+    std::vector<std::pair<bytes, bytes>> kvs;
+    for (unsigned int i = round; i < keys.size(); i += round + 1) {
+      bytes value(i % 40 + 1, static_cast<byte>(round));
+      serial.insert(keys[i], value);
+      kvs.emplace_back(keys[i], value);
+    }
+    // Repeated key: the last value wins, as with insert
+    bytes value{0xff};
+    serial.insert(keys[round], value);
+    kvs.emplace_back(keys[round], value);
+
+    batch.insertBatch(kvs, 4);
+    BOOST_CHECK_EQUAL(serial.root(), batch.root());
+  }
+
+  for (const auto& key : keys) {
+    BOOST_CHECK_EQUAL(serial.at(key), batch.at(key));
+  }
+
+  // Every node under the new root made it into the db
+  BOOST_CHECK(batch.check(false));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
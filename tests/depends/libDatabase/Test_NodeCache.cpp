@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2019 Zilliqa
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#define BOOST_TEST_MODULE nodecachetest
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+
+#include "depends/common/FixedHash.h"
+#include "depends/libDatabase/NodeCache.h"
+#include "depends/libDatabase/OverlayDB.h"
+#include "libUtils/Logger.h"
+
+using namespace std;
+using namespace dev;
+
+BOOST_AUTO_TEST_SUITE(nodecachetest)
+
+BOOST_AUTO_TEST_CASE(test_lru_eviction) {
+  INIT_STDOUT_LOGGER();
+
+  // One entry per shard, so every shard holds only its latest node
+  NodeCache cache(NodeCache::NUM_SHARDS);
+  string value;
+
+  h256 first;
+  first[0] = 1;
+  h256 second;
+  second[0] = 1 + NodeCache::NUM_SHARDS;
+
+  cache.Put(first, "first");
+  BOOST_CHECK(cache.Get(first, value));
+  BOOST_CHECK_EQUAL("first", value);
+
+  cache.Put(second, "second");
+  BOOST_CHECK(!cache.Get(first, value));
+  BOOST_CHECK(cache.Get(second, value));
+  BOOST_CHECK_EQUAL("second", value);
+
+  BOOST_CHECK_EQUAL(2, cache.GetHits());
+  BOOST_CHECK_EQUAL(1, cache.GetMisses());
+  cache.ResetStats();
+  BOOST_CHECK_EQUAL(0, cache.GetHits());
+
+  cache.Clear();
+  BOOST_CHECK(!cache.Get(second, value));
+
+  NodeCache disabled(0);
+  disabled.Put(first, "first");
+  BOOST_CHECK(!disabled.Get(first, value));
+}
+
+BOOST_AUTO_TEST_CASE(test_lookup_through_cache) {
+  INIT_STDOUT_LOGGER();
+
+  OverlayDB db("nodecachetest");
+  db.ResetDB();
+
+  vector<h256> hashes;
+  for (unsigned int i = 0; i < 100; i++) {
+    h256 hash = h256::random();
+    db.insert(hash, bytesConstRef(hash.hex()));
+    hashes.emplace_back(hash);
+  }
+  db.commit();
+
+  // Committed nodes are served from the cache, then from LevelDB once it is
+  // cleared by RefreshDB
+  for (unsigned int round = 0; round < 2; round++) {
+    for (const auto& hash : hashes) {
+      BOOST_CHECK_EQUAL(hash.hex(), db.lookup(hash));
+      BOOST_CHECK(db.exists(hash));
+    }
+    db.RefreshDB();
+  }
+
+  db.ResetDB();
+}
+
+BOOST_AUTO_TEST_CASE(test_commit_in_background) {
+  INIT_STDOUT_LOGGER();
+
+  OverlayDB db("nodecachetest");
+  db.ResetDB();
+
+  vector<h256> hashes;
+  for (unsigned int i = 0; i < 100; i++) {
+    h256 hash = h256::random();
+    db.insert(hash, bytesConstRef(hash.hex()));
+    hashes.emplace_back(hash);
+  }
+  atomic<bool> written(false);
+  db.commit([&written]() { written = true; });
+
+  // Writes after the commit go to a fresh overlay, and every node can be read
+  // whether or not its batch is in yet
+  const h256 later = h256::random();
+  db.insert(later, bytesConstRef(later.hex()));
+  for (const auto& hash : hashes) {
+    BOOST_CHECK_EQUAL(hash.hex(), db.lookup(hash));
+  }
+  BOOST_CHECK_EQUAL(later.hex(), db.lookup(later));
+
+  db.waitCommitted();
+  BOOST_CHECK(written);
+
+  // Only the later node was left to the next commit
+  db.rollback();
+  BOOST_CHECK(!db.exists(later));
+  db.RefreshDB();
+  for (const auto& hash : hashes) {
+    BOOST_CHECK_EQUAL(hash.hex(), db.lookup(hash));
+  }
+
+  db.ResetDB();
+}
+
+BOOST_AUTO_TEST_SUITE_END()